@@ -0,0 +1,64 @@
+"""upload_content_index
+
+Revision ID: 1b7e5c9d3a20
+Revises: f3c1a8d5e927
+Create Date: 2025-11-16 18:40:12.284903
+
+Content-addressed deduplication for uploads:
+1. Add upload_contents - per-tenant index of stored content by SHA-256,
+   with the number of upload_objects rows that reference it
+2. Add upload_objects.dedup - the upload opted into deduplication; its
+   checksum is indexed when it completes
+3. Add upload_objects.content_id - the indexed content an object stores or
+   aliases; bytes are released when the last reference is deleted
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = '1b7e5c9d3a20'
+down_revision: Union[str, None] = 'f3c1a8d5e927'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add the upload content index"""
+
+    op.create_table(
+        'upload_contents',
+        sa.Column('id', postgresql.UUID(), server_default=sa.text('uuid_generate_v4()'), nullable=False),
+        sa.Column('tenant_id', postgresql.UUID(), nullable=False),
+        sa.Column('sha256', sa.String(64), nullable=False),
+        sa.Column('size', sa.BigInteger(), nullable=False),
+        sa.Column('object_key', sa.String(1024), nullable=False),
+        sa.Column('refcount', sa.Integer(), server_default='1', nullable=False),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), server_default=sa.text('NOW()'), nullable=False),
+        sa.PrimaryKeyConstraint('id'),
+        sa.ForeignKeyConstraint(['tenant_id'], ['tenants.id'], ondelete='CASCADE'),
+        sa.UniqueConstraint('tenant_id', 'sha256', name='upload_contents_tenant_sha256'),
+        sa.CheckConstraint('refcount >= 0', name='upload_contents_refcount_check'),
+    )
+
+    op.add_column('upload_objects', sa.Column('dedup', sa.Boolean(), server_default=sa.false(), nullable=False))
+    op.add_column('upload_objects', sa.Column('content_id', postgresql.UUID(), nullable=True))
+    op.create_foreign_key(
+        'upload_objects_content_id_fkey',
+        'upload_objects', 'upload_contents',
+        ['content_id'], ['id'],
+        ondelete='SET NULL'
+    )
+
+
+def downgrade() -> None:
+    """Remove the upload content index"""
+
+    op.drop_constraint('upload_objects_content_id_fkey', 'upload_objects', type_='foreignkey')
+    op.drop_column('upload_objects', 'content_id')
+    op.drop_column('upload_objects', 'dedup')
+    op.drop_table('upload_contents')
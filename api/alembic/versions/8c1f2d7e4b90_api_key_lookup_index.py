@@ -0,0 +1,88 @@
+"""api_key_lookup_index
+
+Revision ID: 8c1f2d7e4b90
+Revises: 3a3c88751a5c
+Create Date: 2025-11-16 10:12:41.208113
+
+Indexed API key lookup (Requirement A-14):
+1. Add api_keys.key_id - public lookup id embedded in keys ("sk_<key_id>_<secret>")
+2. Add api_keys.hash_scheme - 'argon2id' (legacy) or 'hmac-sha256' (peppered digest)
+3. Unique partial index on key_id so validation is a single index probe
+
+Existing rows keep hash_scheme='argon2id' and key_id NULL. The auth service
+rehashes each legacy key the first time it is presented and assigns it a
+derived key_id, after which it takes the indexed path. Once no rows with
+key_id IS NULL remain, set API_KEY_LEGACY_SCAN=0 on the auth service.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = '8c1f2d7e4b90'
+down_revision: Union[str, None] = '3a3c88751a5c'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add indexed key_id and hash scheme to api_keys"""
+
+    # 1. Public lookup id (NULL until a legacy key is rehashed)
+    op.add_column(
+        'api_keys',
+        sa.Column('key_id', sa.String(32), nullable=True)
+    )
+
+    # 2. Hash scheme marker; all existing rows are Argon2id
+    op.add_column(
+        'api_keys',
+        sa.Column('hash_scheme', sa.String(16), nullable=False, server_default='argon2id')
+    )
+
+    # key_prefix was never populated by the auth service; keep it as a display hint only
+    op.alter_column(
+        'api_keys',
+        'key_prefix',
+        nullable=True,
+        existing_type=sa.String(10)
+    )
+
+    # 3. Unique lookup index
+    op.create_index(
+        'uq_api_keys_key_id',
+        'api_keys',
+        ['key_id'],
+        unique=True,
+        postgresql_where=sa.text('key_id IS NOT NULL')
+    )
+
+    # Legacy scan only touches rows that have not been migrated yet
+    op.create_index(
+        'idx_api_keys_legacy',
+        'api_keys',
+        ['id'],
+        postgresql_where=sa.text("key_id IS NULL AND revoked_at IS NULL")
+    )
+
+
+def downgrade() -> None:
+    """Remove indexed key lookup"""
+
+    # WARNING: keys issued in the new format stop validating after downgrade
+    op.drop_index('idx_api_keys_legacy', table_name='api_keys')
+    op.drop_index('uq_api_keys_key_id', table_name='api_keys')
+
+    op.execute("UPDATE api_keys SET key_prefix = '' WHERE key_prefix IS NULL")
+    op.alter_column(
+        'api_keys',
+        'key_prefix',
+        nullable=False,
+        existing_type=sa.String(10)
+    )
+
+    op.drop_column('api_keys', 'hash_scheme')
+    op.drop_column('api_keys', 'key_id')
@@ -0,0 +1,51 @@
+"""tenant_shards
+
+Revision ID: a3d5f7c9e1b2
+Revises: f6b3d8e2a415
+Create Date: 2025-11-16 21:12:48.205731
+
+Tenant-sharded databases (common::ShardMap, common::ShardedDbPool):
+1. Add tenant_shards - explicit tenant placements overriding the consistent
+   hash: large tenants given their own shard, tenants moved by ShardMover,
+   tenants pinned before a shard is added. Only read on the directory (first)
+   shard of DB_SHARD_URLS; created on every shard so they share one schema
+2. moving refuses writes to the tenant while its rows are copied;
+   previous_shard names the shard still holding its old rows until the move
+   has deleted them
+
+No foreign key to tenants: the tenant's row lives on its own shard.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'a3d5f7c9e1b2'
+down_revision: Union[str, None] = 'f6b3d8e2a415'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add tenant shard placements"""
+
+    # 1-2. Placements
+    op.create_table(
+        'tenant_shards',
+        sa.Column('tenant_id', postgresql.UUID(as_uuid=True), primary_key=True),
+        sa.Column('shard', sa.String(64), nullable=False),
+        sa.Column('moving', sa.Boolean(), nullable=False, server_default=sa.text('false')),
+        sa.Column('previous_shard', sa.String(64), nullable=True),
+        sa.Column('updated_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+    )
+
+
+def downgrade() -> None:
+    """Remove tenant shard placements"""
+
+    op.drop_table('tenant_shards')
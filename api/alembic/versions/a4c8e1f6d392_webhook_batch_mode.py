@@ -0,0 +1,47 @@
+"""webhook_batch_mode
+
+Revision ID: a4c8e1f6d392
+Revises: d5b8e2f4a917
+Create Date: 2025-11-17 18:05:12.408135
+
+Opt-in batch delivery per webhook (RegisterWebhookRequest.batch):
+1. Add webhooks.batch_max_events - deliveries accumulated into one signed
+   JSON-array POST (0: one POST per delivery, the default)
+2. Add webhooks.batch_window_ms - longest a delivery waits for its batch
+   to fill
+
+The dispatcher reads both with each claimed delivery (primary-key lookup),
+so no index is needed.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'a4c8e1f6d392'
+down_revision: Union[str, None] = 'd5b8e2f4a917'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add webhook batch settings"""
+
+    op.add_column('webhooks', sa.Column('batch_max_events', sa.Integer(), server_default='0', nullable=False))
+    op.add_column('webhooks', sa.Column('batch_window_ms', sa.Integer(), server_default='0', nullable=False))
+    op.create_check_constraint(
+        'webhook_batch_check',
+        'webhooks',
+        'batch_max_events >= 0 AND batch_window_ms >= 0'
+    )
+
+
+def downgrade() -> None:
+    """Remove webhook batch settings"""
+
+    op.drop_constraint('webhook_batch_check', 'webhooks', type_='check')
+    op.drop_column('webhooks', 'batch_window_ms')
+    op.drop_column('webhooks', 'batch_max_events')
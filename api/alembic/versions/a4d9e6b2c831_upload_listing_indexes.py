@@ -0,0 +1,66 @@
+"""upload_listing_indexes
+
+Revision ID: a4d9e6b2c831
+Revises: e8b4c2a6f157
+Create Date: 2025-11-17 09:12:44.302915
+
+Indexes for UploadService.ListObjects and ListRecentObjects:
+1. Add idx_uploads_tenant_filename on (tenant_id, filename COLLATE "C", id)
+   over completed, undeleted objects. A page is one range scan from the
+   cursor, and under byte-wise collation a filename prefix is a contiguous
+   range of it
+2. Add idx_uploads_metadata, a GIN index (jsonb_path_ops) on the metadata
+   given at upload, for tag filters (metadata @> '{"k": "v"}')
+3. Add idx_uploads_tenant_recent on (tenant_id, completed_at DESC, id DESC),
+   read when the recent-objects cache loads a tenant
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'a4d9e6b2c831'
+down_revision: Union[str, None] = 'e8b4c2a6f157'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add the object listing indexes"""
+
+    # 1. Keyset listing by filename
+    op.create_index(
+        'idx_uploads_tenant_filename',
+        'upload_objects',
+        ['tenant_id', sa.text('filename COLLATE "C"'), 'id'],
+        postgresql_where=sa.text("status = 'completed' AND deleted_at IS NULL"),
+    )
+
+    # 2. Tag filters
+    op.create_index(
+        'idx_uploads_metadata',
+        'upload_objects',
+        ['metadata'],
+        postgresql_using='gin',
+        postgresql_ops={'metadata': 'jsonb_path_ops'},
+        postgresql_where=sa.text('deleted_at IS NULL'),
+    )
+
+    # 3. Newest completed objects
+    op.create_index(
+        'idx_uploads_tenant_recent',
+        'upload_objects',
+        ['tenant_id', sa.text('completed_at DESC'), sa.text('id DESC')],
+        postgresql_where=sa.text("status = 'completed' AND deleted_at IS NULL"),
+    )
+
+
+def downgrade() -> None:
+    """Remove the object listing indexes"""
+
+    op.drop_index('idx_uploads_tenant_recent', table_name='upload_objects')
+    op.drop_index('idx_uploads_metadata', table_name='upload_objects')
+    op.drop_index('idx_uploads_tenant_filename', table_name='upload_objects')
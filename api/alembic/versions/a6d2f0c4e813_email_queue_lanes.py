@@ -0,0 +1,86 @@
+"""email_queue_lanes
+
+Revision ID: a6d2f0c4e813
+Revises: 1b7e5c9d3a20
+Create Date: 2025-11-16 19:12:40.118305
+
+Email delivery lanes (common::EmailQueue):
+1. Add email_queue and email_suppression if an installation predates them
+   (the queue code has always used both; neither was in the baseline)
+2. Add email_queue.lane - 0=transactional, 1=bulk; existing rows are
+   transactional
+3. Add one partial index per lane over claimable rows (status 0=pending,
+   4=retry). EmailQueue spells these predicates out literally in its claim
+   statements so the planner can match them
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'a6d2f0c4e813'
+down_revision: Union[str, None] = '1b7e5c9d3a20'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add email queue lanes and their claim indexes"""
+
+    # 1. Queue and suppression list (status values: see EmailStatus in common/email_queue.h)
+    op.execute("""
+        CREATE TABLE IF NOT EXISTS email_queue (
+            id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+            tenant_id UUID NOT NULL REFERENCES tenants(id) ON DELETE CASCADE,
+            user_id UUID REFERENCES users(id) ON DELETE SET NULL,
+            to_address VARCHAR(255) NOT NULL,
+            subject VARCHAR(255) NOT NULL,
+            body_html TEXT NOT NULL,
+            body_text TEXT NOT NULL DEFAULT '',
+            template_id VARCHAR(100),
+            status INT NOT NULL DEFAULT 0,
+            priority INT NOT NULL DEFAULT 5,
+            retry_count INT NOT NULL DEFAULT 0,
+            bounce_type INT NOT NULL DEFAULT 0,
+            error_message TEXT,
+            created_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW(),
+            scheduled_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW(),
+            sent_at TIMESTAMP WITH TIME ZONE
+        )
+    """)
+    op.execute("""
+        CREATE TABLE IF NOT EXISTS email_suppression (
+            email_address VARCHAR(255) PRIMARY KEY,
+            reason TEXT,
+            created_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW()
+        )
+    """)
+
+    # 2. Lane
+    op.execute('ALTER TABLE email_queue ADD COLUMN IF NOT EXISTS lane INT NOT NULL DEFAULT 0')
+
+    # 3. Claim indexes
+    op.create_index(
+        'idx_email_queue_transactional',
+        'email_queue',
+        [sa.text('priority DESC'), 'scheduled_at'],
+        postgresql_where=sa.text('lane = 0 AND status IN (0, 4)')
+    )
+    op.create_index(
+        'idx_email_queue_bulk',
+        'email_queue',
+        ['tenant_id', 'scheduled_at'],
+        postgresql_where=sa.text('lane = 1 AND status IN (0, 4)')
+    )
+
+
+def downgrade() -> None:
+    """Remove email queue lanes"""
+
+    # The tables are left in place: they may predate this revision
+    op.drop_index('idx_email_queue_bulk', table_name='email_queue')
+    op.drop_index('idx_email_queue_transactional', table_name='email_queue')
+    op.drop_column('email_queue', 'lane')
@@ -0,0 +1,106 @@
+"""webhook_event_fanout
+
+Revision ID: b2e9c4a17d53
+Revises: 8c1f2d7e4b90
+Create Date: 2025-11-16 14:03:27.551904
+
+Topic-style webhook fan-out (NotificationService.PublishEvent):
+1. Add webhook_events - one row per published event, holding the payload once
+2. Add webhook_deliveries - delivery queue used by WebhookDelivery (retry, claim,
+   dispatch); rows from PublishEvent reference webhook_events via event_id and
+   leave payload NULL, rows from QueueDelivery carry their own payload
+3. Add webhooks.disabled_reason - set when a webhook is disabled after
+   consecutive delivery failures
+
+The subscription index load (active webhooks of one tenant) is served by the
+existing idx_webhooks_tenant.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'b2e9c4a17d53'
+down_revision: Union[str, None] = '8c1f2d7e4b90'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add webhook event and delivery tables"""
+
+    # 1. Events (payload stored once per publish)
+    op.create_table(
+        'webhook_events',
+        sa.Column('id', postgresql.UUID(as_uuid=True), primary_key=True,
+                  server_default=sa.text('uuid_generate_v4()')),
+        sa.Column('tenant_id', postgresql.UUID(as_uuid=True),
+                  sa.ForeignKey('tenants.id', ondelete='CASCADE'), nullable=False),
+        sa.Column('event_type', sa.String(100), nullable=False),
+        sa.Column('payload', sa.Text(), nullable=False),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+    )
+    op.create_index('idx_webhook_events_tenant', 'webhook_events', ['tenant_id', 'created_at'])
+
+    # 2. Delivery queue (status values: see WebhookStatus in common/webhook_delivery.h)
+    op.create_table(
+        'webhook_deliveries',
+        sa.Column('id', postgresql.UUID(as_uuid=True), primary_key=True,
+                  server_default=sa.text('uuid_generate_v4()')),
+        sa.Column('tenant_id', postgresql.UUID(as_uuid=True),
+                  sa.ForeignKey('tenants.id', ondelete='CASCADE'), nullable=False),
+        sa.Column('webhook_id', postgresql.UUID(as_uuid=True),
+                  sa.ForeignKey('webhooks.id', ondelete='CASCADE'), nullable=False),
+        sa.Column('event_id', postgresql.UUID(as_uuid=True),
+                  sa.ForeignKey('webhook_events.id', ondelete='CASCADE'), nullable=True),
+        sa.Column('event_type', sa.String(100), nullable=False),
+        sa.Column('payload', sa.Text(), nullable=True),
+        sa.Column('url', sa.String(2048), nullable=False),
+        sa.Column('signature', sa.String(128), nullable=False),
+        sa.Column('status', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('retry_count', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('http_status_code', sa.Integer(), nullable=True),
+        sa.Column('error_message', sa.Text(), nullable=True),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+        sa.Column('scheduled_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+        sa.Column('delivered_at', sa.TIMESTAMP(timezone=True), nullable=True),
+        sa.CheckConstraint('payload IS NOT NULL OR event_id IS NOT NULL',
+                           name='webhook_delivery_payload_check'),
+    )
+
+    # Claim query: status bound as a parameter, so not a partial index
+    op.create_index(
+        'idx_webhook_deliveries_due',
+        'webhook_deliveries',
+        ['status', 'scheduled_at']
+    )
+    op.create_index('idx_webhook_deliveries_event', 'webhook_deliveries', ['event_id'])
+    op.create_index('idx_webhook_deliveries_webhook', 'webhook_deliveries', ['webhook_id'])
+
+    # 3. Reason recorded by WebhookDelivery when auto-disabling
+    op.add_column(
+        'webhooks',
+        sa.Column('disabled_reason', sa.Text(), nullable=True)
+    )
+
+
+def downgrade() -> None:
+    """Remove webhook event and delivery tables"""
+
+    # WARNING: drops queued and historical webhook deliveries
+    op.drop_column('webhooks', 'disabled_reason')
+
+    op.drop_index('idx_webhook_deliveries_webhook', table_name='webhook_deliveries')
+    op.drop_index('idx_webhook_deliveries_event', table_name='webhook_deliveries')
+    op.drop_index('idx_webhook_deliveries_due', table_name='webhook_deliveries')
+    op.drop_table('webhook_deliveries')
+
+    op.drop_index('idx_webhook_events_tenant', table_name='webhook_events')
+    op.drop_table('webhook_events')
@@ -0,0 +1,45 @@
+"""api_key_scopes_array
+
+Revision ID: b8e2d4f6a913
+Revises: a3d5f7c9e1b2
+Create Date: 2025-11-16 21:48:05.417290
+
+API key scopes as an array (Requirement A-14):
+1. Convert api_keys.scopes from comma-separated TEXT to TEXT[], so the auth
+   service reads the granted scopes as-is and compiles them once per cache
+   fill instead of splitting a string per validation
+
+Empty strings become empty arrays; elements are kept exactly (no trimming),
+matching how the auth service split them.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'b8e2d4f6a913'
+down_revision: Union[str, None] = 'a3d5f7c9e1b2'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Store api_keys.scopes as TEXT[]"""
+
+    # 1. Rewrites the table; api_keys is small
+    op.execute(
+        "ALTER TABLE api_keys ALTER COLUMN scopes TYPE TEXT[] "
+        "USING CASE WHEN scopes = '' THEN '{}'::text[] ELSE string_to_array(scopes, ',') END"
+    )
+
+
+def downgrade() -> None:
+    """Store api_keys.scopes as comma-separated TEXT"""
+
+    # WARNING: scopes containing ',' are split into several on the next upgrade
+    op.execute(
+        "ALTER TABLE api_keys ALTER COLUMN scopes TYPE TEXT "
+        "USING array_to_string(scopes, ',')"
+    )
@@ -0,0 +1,71 @@
+"""plan_prices
+
+Revision ID: c4a9e7b2d305
+Revises: b8e2d4f6a913
+Create Date: 2025-11-16 22:05:37.816402
+
+Plan catalog (payment::PlanCatalog):
+1. Add plan_prices - one row per price tier. metric_name '' is a plan's
+   recurring per-seat price; any other value prices that usage metric.
+   pricing_model: 0 = per unit, 1 = graduated, 2 = volume. up_to is the last
+   unit of the tier (NULL on the last, unbounded tier); amounts are micros
+   (millionths of the currency unit)
+2. Seed the launch plans (starter, professional, enterprise) at the prices
+   the payment service previously hard-coded
+
+The payment service loads every active row into memory at start, every
+PLAN_CATALOG_REFRESH_MS, and when payment:plans_changed is published. Writers
+(e.g. the Stripe price sync) should replace a plan's rows in one transaction
+and publish afterwards.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'c4a9e7b2d305'
+down_revision: Union[str, None] = 'b8e2d4f6a913'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+LAUNCH_PLANS = (('starter', 29_000_000), ('professional', 99_000_000), ('enterprise', 299_000_000))
+
+
+def upgrade() -> None:
+    """Add plan prices"""
+
+    # 1. Price tiers
+    op.create_table(
+        'plan_prices',
+        sa.Column('plan_id', sa.String(50), nullable=False),
+        sa.Column('metric_name', sa.String(100), nullable=False, server_default=''),
+        sa.Column('tier', sa.SmallInteger(), nullable=False, server_default='0'),
+        sa.Column('pricing_model', sa.SmallInteger(), nullable=False, server_default='0'),
+        sa.Column('up_to', sa.BigInteger(), nullable=True),
+        sa.Column('unit_amount_micros', sa.BigInteger(), nullable=False),
+        sa.Column('flat_amount_micros', sa.BigInteger(), nullable=False, server_default='0'),
+        sa.Column('active', sa.Boolean(), nullable=False, server_default=sa.text('true')),
+        sa.Column('updated_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+        sa.PrimaryKeyConstraint('plan_id', 'metric_name', 'tier'),
+        sa.CheckConstraint('pricing_model BETWEEN 0 AND 2', name='plan_prices_model_check'),
+        sa.CheckConstraint('unit_amount_micros >= 0 AND flat_amount_micros >= 0',
+                           name='plan_prices_amounts_check'),
+    )
+
+    # 2. Launch plans
+    for plan_id, micros in LAUNCH_PLANS:
+        op.execute(
+            "INSERT INTO plan_prices (plan_id, unit_amount_micros) "
+            f"VALUES ('{plan_id}', {micros})"
+        )
+
+
+def downgrade() -> None:
+    """Remove plan prices"""
+
+    # The payment service falls back to its built-in launch plans
+    op.drop_table('plan_prices')
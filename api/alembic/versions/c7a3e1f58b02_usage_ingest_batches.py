@@ -0,0 +1,46 @@
+"""usage_ingest_batches
+
+Revision ID: c7a3e1f58b02
+Revises: b2e9c4a17d53
+Create Date: 2025-11-16 15:21:09.318402
+
+Write-behind RecordUsage (common/usage_aggregator.h):
+1. Add usage_ingest_batches - one row per flushed batch, inserted in the same
+   transaction as its usage_records rows. The batch id is the name of the
+   local WAL segment, so a segment replayed after a crash that happened
+   between commit and segment removal is recognised and not applied twice.
+
+Old rows carry no information once their segment is gone and can be pruned.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'c7a3e1f58b02'
+down_revision: Union[str, None] = 'b2e9c4a17d53'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add usage ingest batch ledger"""
+
+    op.create_table(
+        'usage_ingest_batches',
+        sa.Column('batch_id', sa.String(64), primary_key=True),
+        sa.Column('bucket_count', sa.Integer(), nullable=False),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+    )
+    op.create_index('idx_usage_ingest_batches_created', 'usage_ingest_batches', ['created_at'])
+
+
+def downgrade() -> None:
+    """Remove usage ingest batch ledger"""
+
+    op.drop_index('idx_usage_ingest_batches_created', table_name='usage_ingest_batches')
+    op.drop_table('usage_ingest_batches')
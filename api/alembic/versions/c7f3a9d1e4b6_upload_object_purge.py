@@ -0,0 +1,61 @@
+"""upload_object_purge
+
+Revision ID: c7f3a9d1e4b6
+Revises: a4d9e6b2c831
+Create Date: 2025-11-17 14:36:08.519247
+
+Deleted objects are purged in the background (ObjectReaper):
+1. Add upload_objects.purge_pending, set by DeleteObject/DeleteObjects on
+   rows whose S3 object must be deleted and whose bytes returned to the
+   quota (standalone objects, and the last reference to shared content)
+2. Add upload_objects.purge_claimed_at, the lease of the reaper replica
+   working on the row, and purged_at
+3. Add idx_uploads_purge_pending on (deleted_at) over pending rows, so a
+   claim reads the oldest tombstones without scanning purged ones
+
+Rows deleted before this revision already had their quota released and
+are left as they are.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'c7f3a9d1e4b6'
+down_revision: Union[str, None] = 'a4d9e6b2c831'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add the object purge columns and queue index"""
+
+    # 1. Purge queue flag
+    op.add_column(
+        'upload_objects',
+        sa.Column('purge_pending', sa.Boolean(), nullable=False, server_default=sa.false()),
+    )
+
+    # 2. Reaper lease and completion time
+    op.add_column('upload_objects', sa.Column('purge_claimed_at', sa.TIMESTAMP(timezone=True), nullable=True))
+    op.add_column('upload_objects', sa.Column('purged_at', sa.TIMESTAMP(timezone=True), nullable=True))
+
+    # 3. Oldest pending purges first
+    op.create_index(
+        'idx_uploads_purge_pending',
+        'upload_objects',
+        ['deleted_at'],
+        postgresql_where=sa.text('purge_pending'),
+    )
+
+
+def downgrade() -> None:
+    """Remove the object purge columns and queue index"""
+
+    op.drop_index('idx_uploads_purge_pending', table_name='upload_objects')
+    op.drop_column('upload_objects', 'purged_at')
+    op.drop_column('upload_objects', 'purge_claimed_at')
+    op.drop_column('upload_objects', 'purge_pending')
@@ -0,0 +1,240 @@
+"""partitioned_queues
+
+Revision ID: c9e4b1f7a260
+Revises: a6d2f0c4e813
+Create Date: 2025-11-16 19:48:05.730214
+
+Partitioned, auto-pruned delivery queues (common::EmailQueue,
+common::WebhookDelivery):
+1. Rebuild email_queue and webhook_deliveries as LIST partitions on status:
+   <queue>_active holds the claimable and in-flight rows (pending, sending,
+   failed, retry) and stays small; <queue>_done holds terminal rows and is
+   RANGE-partitioned by created_at into UTC days, plus a default partition
+   for rows older than the oldest day
+2. Move the claim indexes onto <queue>_active: the email lane indexes, and
+   (scheduled_at) over pending/retry for webhooks. The services claim from
+   <queue>_active directly; marking a row terminal moves it to <queue>_done
+3. Add queue_maintain_partitions(queue, retention_days, premake_days,
+   from_days) - creates the coming days' partitions and drops days older
+   than the retention (DROP rather than DELETE, so terminal rows never need
+   vacuuming). Run hourly by common::QueuePartitionMaintainer
+4. Copy existing rows into the new tables (single pass; run during a quiet
+   window on large installations)
+
+Primary keys are per partition: (id) on <queue>_active and (id, created_at)
+on <queue>_done, since a key on the parent would have to include status.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'c9e4b1f7a260'
+down_revision: Union[str, None] = 'a6d2f0c4e813'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+RETENTION_DAYS = 7
+PREMAKE_DAYS = 3
+
+# Status values: EmailStatus (common/email_queue.h), WebhookStatus (common/webhook_delivery.h)
+ACTIVE_STATUSES = '0, 1, 3, 4'
+TERMINAL_STATUSES = {
+    'email_queue': '2, 5, 6',           # sent, exhausted, bounced
+    'webhook_deliveries': '2, 5',       # delivered, exhausted
+}
+
+COLUMNS = {
+    'email_queue': """
+        id UUID NOT NULL DEFAULT uuid_generate_v4(),
+        tenant_id UUID NOT NULL REFERENCES tenants(id) ON DELETE CASCADE,
+        user_id UUID REFERENCES users(id) ON DELETE SET NULL,
+        to_address VARCHAR(255) NOT NULL,
+        subject VARCHAR(255) NOT NULL,
+        body_html TEXT NOT NULL,
+        body_text TEXT NOT NULL DEFAULT '',
+        template_id VARCHAR(100),
+        status INT NOT NULL DEFAULT 0,
+        lane INT NOT NULL DEFAULT 0,
+        priority INT NOT NULL DEFAULT 5,
+        retry_count INT NOT NULL DEFAULT 0,
+        bounce_type INT NOT NULL DEFAULT 0,
+        error_message TEXT,
+        created_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW(),
+        scheduled_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW(),
+        sent_at TIMESTAMP WITH TIME ZONE
+    """,
+    'webhook_deliveries': """
+        id UUID NOT NULL DEFAULT uuid_generate_v4(),
+        tenant_id UUID NOT NULL REFERENCES tenants(id) ON DELETE CASCADE,
+        webhook_id UUID NOT NULL REFERENCES webhooks(id) ON DELETE CASCADE,
+        event_id UUID REFERENCES webhook_events(id) ON DELETE CASCADE,
+        event_type VARCHAR(100) NOT NULL,
+        payload TEXT,
+        url VARCHAR(2048) NOT NULL,
+        signature VARCHAR(128) NOT NULL,
+        status INT NOT NULL DEFAULT 0,
+        retry_count INT NOT NULL DEFAULT 0,
+        http_status_code INT,
+        error_message TEXT,
+        created_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW(),
+        scheduled_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW(),
+        delivered_at TIMESTAMP WITH TIME ZONE,
+        CONSTRAINT webhook_delivery_payload_check CHECK (payload IS NOT NULL OR event_id IS NOT NULL)
+    """,
+}
+
+# Claim indexes, on the hot partition only
+ACTIVE_INDEXES = {
+    'email_queue': [
+        'CREATE INDEX idx_email_queue_transactional ON email_queue_active (priority DESC, scheduled_at) '
+        'WHERE lane = 0 AND status IN (0, 4)',
+        'CREATE INDEX idx_email_queue_bulk ON email_queue_active (tenant_id, scheduled_at) '
+        'WHERE lane = 1 AND status IN (0, 4)',
+    ],
+    'webhook_deliveries': [
+        'CREATE INDEX idx_webhook_deliveries_due ON webhook_deliveries_active (scheduled_at) '
+        'WHERE status IN (0, 4)',
+    ],
+}
+
+# Lookups served in every partition
+PARENT_INDEXES = {
+    'email_queue': [
+        'CREATE INDEX idx_email_queue_tenant_created ON email_queue (tenant_id, created_at)',
+    ],
+    'webhook_deliveries': [
+        'CREATE INDEX idx_webhook_deliveries_event ON webhook_deliveries (event_id)',
+        'CREATE INDEX idx_webhook_deliveries_webhook ON webhook_deliveries (webhook_id)',
+    ],
+}
+
+OLD_INDEXES = {
+    'email_queue': ['idx_email_queue_transactional', 'idx_email_queue_bulk'],
+    'webhook_deliveries': ['idx_webhook_deliveries_due', 'idx_webhook_deliveries_event',
+                           'idx_webhook_deliveries_webhook'],
+}
+
+
+def column_names(table: str) -> str:
+    names = []
+    for line in COLUMNS[table].strip().splitlines():
+        line = line.strip()
+        if line and not line.startswith('CONSTRAINT'):
+            names.append(line.split()[0])
+    return ', '.join(names)
+
+
+def upgrade() -> None:
+    """Partition the email and webhook delivery queues"""
+
+    # 3. Partition maintenance. A new day is built outside the partitioned
+    # table and attached, after moving any of its rows out of the default
+    # partition (left there if maintenance did not run for a while), since
+    # Postgres refuses a partition whose rows the default already holds.
+    op.execute("""
+        CREATE OR REPLACE FUNCTION queue_maintain_partitions(
+            p_queue TEXT, p_retention_days INT, p_premake_days INT, p_from_days INT DEFAULT 0)
+        RETURNS TABLE (created INT, dropped INT, purged BIGINT) AS $$
+        DECLARE
+            done TEXT := p_queue || '_done';
+            today DATE := (NOW() AT TIME ZONE 'UTC')::date;
+            cutoff DATE := (NOW() AT TIME ZONE 'UTC')::date - p_retention_days;
+            d DATE;
+            part TEXT;
+            day_start TIMESTAMPTZ;
+            day_end TIMESTAMPTZ;
+            child RECORD;
+        BEGIN
+            created := 0;
+            dropped := 0;
+            -- Serialize instances; fail fast rather than queue behind long transactions
+            PERFORM pg_advisory_xact_lock(hashtext('queue_maintain_partitions:' || p_queue));
+            PERFORM set_config('lock_timeout', '5s', true);
+
+            FOR d IN SELECT generate_series(today - p_from_days, today + p_premake_days, INTERVAL '1 day')::date LOOP
+                part := done || '_' || to_char(d, 'YYYYMMDD');
+                CONTINUE WHEN to_regclass(part) IS NOT NULL;
+                day_start := d::timestamp AT TIME ZONE 'UTC';
+                day_end := (d + 1)::timestamp AT TIME ZONE 'UTC';
+                EXECUTE format('CREATE TABLE %I (LIKE %I INCLUDING DEFAULTS INCLUDING CONSTRAINTS)', part, done);
+                EXECUTE format(
+                    'WITH moved AS (DELETE FROM %I WHERE created_at >= %L AND created_at < %L RETURNING *) '
+                    'INSERT INTO %I SELECT * FROM moved',
+                    done || '_default', day_start, day_end, part);
+                EXECUTE format('ALTER TABLE %I ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                               done, part, day_start, day_end);
+                created := created + 1;
+            END LOOP;
+
+            FOR child IN
+                SELECT c.relname FROM pg_inherits i JOIN pg_class c ON c.oid = i.inhrelid
+                WHERE i.inhparent = done::regclass AND c.relname ~ ('^' || done || '_[0-9]{8}$')
+            LOOP
+                IF to_date(right(child.relname, 8), 'YYYYMMDD') < cutoff THEN
+                    EXECUTE format('DROP TABLE %I', child.relname);
+                    dropped := dropped + 1;
+                END IF;
+            END LOOP;
+
+            EXECUTE format('DELETE FROM %I WHERE created_at < %L',
+                           done || '_default', cutoff::timestamp AT TIME ZONE 'UTC');
+            GET DIAGNOSTICS purged = ROW_COUNT;
+            RETURN NEXT;
+        END;
+        $$ LANGUAGE plpgsql
+    """)
+
+    for table in COLUMNS:
+        # 1. New layout beside the old table
+        for index in OLD_INDEXES[table]:
+            op.execute(f'DROP INDEX IF EXISTS {index}')
+        op.execute(f'ALTER TABLE {table} RENAME TO {table}_unpartitioned')
+        op.execute(f'CREATE TABLE {table} ({COLUMNS[table]}) PARTITION BY LIST (status)')
+        op.execute(f"""
+            CREATE TABLE {table}_active PARTITION OF {table} (PRIMARY KEY (id))
+            FOR VALUES IN ({ACTIVE_STATUSES})
+            WITH (autovacuum_vacuum_scale_factor = 0.01, autovacuum_vacuum_threshold = 1000)
+        """)
+        op.execute(f"""
+            CREATE TABLE {table}_done PARTITION OF {table} (PRIMARY KEY (id, created_at))
+            FOR VALUES IN ({TERMINAL_STATUSES[table]}) PARTITION BY RANGE (created_at)
+        """)
+        op.execute(f'CREATE TABLE {table}_done_default PARTITION OF {table}_done DEFAULT')
+
+        # 2. Indexes
+        for index in ACTIVE_INDEXES[table] + PARENT_INDEXES[table]:
+            op.execute(index)
+
+        # Days inside the retention window, then the existing rows
+        op.execute(f"SELECT * FROM queue_maintain_partitions('{table}', {RETENTION_DAYS}, "
+                   f"{PREMAKE_DAYS}, {RETENTION_DAYS})")
+
+        # 4. Copy (rows route to their partition)
+        columns = column_names(table)
+        op.execute(f'INSERT INTO {table} ({columns}) SELECT {columns} FROM {table}_unpartitioned')
+        op.execute(f'DROP TABLE {table}_unpartitioned')
+
+
+def downgrade() -> None:
+    """Restore unpartitioned delivery queues"""
+
+    for table in COLUMNS:
+        columns = column_names(table)
+        op.execute(f'ALTER TABLE {table} RENAME TO {table}_partitioned')
+        for index in OLD_INDEXES[table] + [index.split()[2] for index in PARENT_INDEXES[table]]:
+            op.execute(f'DROP INDEX IF EXISTS {index}')
+        op.execute(f'CREATE TABLE {table} ({COLUMNS[table]}, PRIMARY KEY (id))')
+        op.execute(f'INSERT INTO {table} ({columns}) SELECT {columns} FROM {table}_partitioned')
+        op.execute(f'DROP TABLE {table}_partitioned CASCADE')
+
+    op.execute('CREATE INDEX idx_email_queue_transactional ON email_queue (priority DESC, scheduled_at) '
+               'WHERE lane = 0 AND status IN (0, 4)')
+    op.execute('CREATE INDEX idx_email_queue_bulk ON email_queue (tenant_id, scheduled_at) '
+               'WHERE lane = 1 AND status IN (0, 4)')
+    op.execute('CREATE INDEX idx_webhook_deliveries_due ON webhook_deliveries (status, scheduled_at)')
+    op.execute('CREATE INDEX idx_webhook_deliveries_event ON webhook_deliveries (event_id)')
+    op.execute('CREATE INDEX idx_webhook_deliveries_webhook ON webhook_deliveries (webhook_id)')
+    op.execute('DROP FUNCTION IF EXISTS queue_maintain_partitions(TEXT, INT, INT, INT)')
@@ -0,0 +1,140 @@
+"""usage_rollups
+
+Revision ID: d4f8a2c61e37
+Revises: c7a3e1f58b02
+Create Date: 2025-11-16 16:42:51.207735
+
+Incremental usage rollups (PaymentService.GetUsageSummary, invoicing):
+1. Add usage_rollup_minute, usage_rollup_hour and usage_rollup_period -
+   summed quantity per (tenant, subscription, metric, bucket), maintained by
+   the UsageAggregator flush in the same transaction as usage_records
+2. Partition each by month (RANGE on bucket_start) and each month by tenant
+   (HASH on tenant_id, 8 ways), so a tenant's query touches one sub-partition
+   per month and old months can be detached or dropped wholesale
+3. Add usage_rollup_ensure_partitions(month) - creates a month's partitions;
+   called by the aggregator before writing into a month it has not seen
+4. Add usage_billing_period_start(anchor, ts) - start of the monthly billing
+   period containing ts for a subscription anchored at current_period_start
+5. Backfill the rollups from existing usage_records (single pass; run during
+   a quiet window on large installations)
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'd4f8a2c61e37'
+down_revision: Union[str, None] = 'c7a3e1f58b02'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+ROLLUP_TABLES = ('usage_rollup_minute', 'usage_rollup_hour', 'usage_rollup_period')
+TENANT_HASH_PARTITIONS = 8
+
+
+def upgrade() -> None:
+    """Add partitioned usage rollup tables"""
+
+    # 1-2. Rollup tables (bucket_start is the range partition key)
+    for table in ROLLUP_TABLES:
+        period_end = 'period_end TIMESTAMP WITH TIME ZONE NOT NULL,' if table == 'usage_rollup_period' else ''
+        op.execute(f"""
+            CREATE TABLE {table} (
+                tenant_id UUID NOT NULL REFERENCES tenants(id) ON DELETE CASCADE,
+                subscription_id UUID NOT NULL REFERENCES subscriptions(id) ON DELETE CASCADE,
+                metric_name VARCHAR(100) NOT NULL,
+                bucket_start TIMESTAMP WITH TIME ZONE NOT NULL,
+                {period_end}
+                quantity BIGINT NOT NULL,
+                PRIMARY KEY (tenant_id, subscription_id, metric_name, bucket_start)
+            ) PARTITION BY RANGE (bucket_start)
+        """)
+
+    # 3. Monthly partitions, sub-partitioned by tenant hash
+    op.execute(f"""
+        CREATE OR REPLACE FUNCTION usage_rollup_ensure_partitions(p_month DATE) RETURNS void AS $$
+        DECLARE
+            month_start TIMESTAMPTZ := date_trunc('month', p_month)::timestamp AT TIME ZONE 'UTC';
+            month_end TIMESTAMPTZ := (date_trunc('month', p_month) + INTERVAL '1 month')::timestamp AT TIME ZONE 'UTC';
+            parent TEXT;
+            part TEXT;
+        BEGIN
+            -- Serialize concurrent callers (several payment instances, same new month)
+            PERFORM pg_advisory_xact_lock(hashtext('usage_rollup_ensure_partitions'));
+            FOREACH parent IN ARRAY ARRAY{list(ROLLUP_TABLES)} LOOP
+                part := parent || '_' || to_char(p_month, 'YYYYMM');
+                CONTINUE WHEN to_regclass(part) IS NOT NULL;
+                EXECUTE format(
+                    'CREATE TABLE %I PARTITION OF %I FOR VALUES FROM (%L) TO (%L) PARTITION BY HASH (tenant_id)',
+                    part, parent, month_start, month_end);
+                FOR i IN 0..{TENANT_HASH_PARTITIONS - 1} LOOP
+                    EXECUTE format(
+                        'CREATE TABLE %I PARTITION OF %I FOR VALUES WITH (MODULUS {TENANT_HASH_PARTITIONS}, REMAINDER %s)',
+                        part || '_h' || i, part, i);
+                END LOOP;
+            END LOOP;
+        END;
+        $$ LANGUAGE plpgsql
+    """)
+
+    # 4. Monthly billing period containing ts (anchor = current_period_start)
+    op.execute("""
+        CREATE OR REPLACE FUNCTION usage_billing_period_start(anchor TIMESTAMPTZ, ts TIMESTAMPTZ)
+        RETURNS TIMESTAMPTZ AS $$
+            SELECT CASE
+                WHEN anchor + make_interval(months => m) > ts THEN anchor + make_interval(months => m - 1)
+                ELSE anchor + make_interval(months => m)
+            END
+            FROM (
+                SELECT (EXTRACT(YEAR FROM age(ts, anchor)) * 12 + EXTRACT(MONTH FROM age(ts, anchor)))::int AS m
+            ) months
+        $$ LANGUAGE sql STABLE
+    """)
+
+    # Partitions around now; the aggregator creates other months on demand
+    op.execute("""
+        SELECT usage_rollup_ensure_partitions(m::date)
+        FROM generate_series(date_trunc('month', NOW()) - INTERVAL '1 month',
+                             date_trunc('month', NOW()) + INTERVAL '2 months',
+                             INTERVAL '1 month') AS m
+    """)
+
+    # 5. Backfill from raw usage
+    op.execute("""
+        SELECT usage_rollup_ensure_partitions(m::date)
+        FROM generate_series(
+            (SELECT date_trunc('month', MIN(timestamp)) - INTERVAL '1 month' FROM usage_records),
+            date_trunc('month', NOW()),
+            INTERVAL '1 month') AS m
+    """)
+    op.execute("""
+        INSERT INTO usage_rollup_minute (tenant_id, subscription_id, metric_name, bucket_start, quantity)
+        SELECT tenant_id, subscription_id, metric_name, date_trunc('minute', timestamp), SUM(quantity)
+        FROM usage_records GROUP BY 1, 2, 3, 4
+    """)
+    op.execute("""
+        INSERT INTO usage_rollup_hour (tenant_id, subscription_id, metric_name, bucket_start, quantity)
+        SELECT tenant_id, subscription_id, metric_name, date_trunc('hour', bucket_start, 'UTC'), SUM(quantity)
+        FROM usage_rollup_minute GROUP BY 1, 2, 3, 4
+    """)
+    op.execute("""
+        INSERT INTO usage_rollup_period (tenant_id, subscription_id, metric_name, bucket_start, period_end, quantity)
+        SELECT r.tenant_id, r.subscription_id, r.metric_name, p.start, p.start + INTERVAL '1 month', SUM(r.quantity)
+        FROM usage_rollup_minute r
+        JOIN subscriptions s ON s.id = r.subscription_id
+        CROSS JOIN LATERAL (SELECT usage_billing_period_start(s.current_period_start, r.bucket_start) AS start) p
+        GROUP BY 1, 2, 3, 4, 5
+    """)
+
+
+def downgrade() -> None:
+    """Remove usage rollup tables"""
+
+    # Rollups are derived data; usage_records is untouched
+    for table in reversed(ROLLUP_TABLES):
+        op.execute(f'DROP TABLE IF EXISTS {table} CASCADE')
+    op.execute('DROP FUNCTION IF EXISTS usage_billing_period_start(TIMESTAMPTZ, TIMESTAMPTZ)')
+    op.execute('DROP FUNCTION IF EXISTS usage_rollup_ensure_partitions(DATE)')
@@ -0,0 +1,48 @@
+"""outbox_events
+
+Revision ID: d5b8e2f4a917
+Revises: c7f3a9d1e4b6
+Create Date: 2025-11-17 16:20:51.774310
+
+Transactional outbox (common::Outbox / OutboxRelay):
+1. Add outbox_events - domain events (subscription.created, upload.completed,
+   ...) inserted in the transaction of the change that raised them. The
+   notification service's relay deletes them in id order as it fans them
+   out to webhook_deliveries, so the table holds only the backlog and the
+   primary key is the only index it needs
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'd5b8e2f4a917'
+down_revision: Union[str, None] = 'c7f3a9d1e4b6'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add the outbox table"""
+
+    # 1. Events awaiting the relay
+    op.create_table(
+        'outbox_events',
+        sa.Column('id', sa.BigInteger(), primary_key=True, autoincrement=True),
+        sa.Column('tenant_id', postgresql.UUID(as_uuid=True),
+                  sa.ForeignKey('tenants.id', ondelete='CASCADE'), nullable=False),
+        sa.Column('event_type', sa.String(100), nullable=False),
+        sa.Column('payload', sa.Text(), nullable=False),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+    )
+
+
+def downgrade() -> None:
+    """Remove the outbox table"""
+
+    op.drop_table('outbox_events')
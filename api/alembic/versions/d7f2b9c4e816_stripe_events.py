@@ -0,0 +1,66 @@
+"""stripe_events
+
+Revision ID: d7f2b9c4e816
+Revises: c4a9e7b2d305
+Create Date: 2025-11-16 23:12:48.205133
+
+Stripe webhook ingestion (payment::StripeWebhookIngestor):
+1. Add stripe_events - raw deliveries keyed by Stripe's event id, so a
+   redelivered event is stored once. processed_at stays NULL until the
+   subscription transition it carries is applied; the payment service
+   reloads such rows at start
+2. Add subscriptions.status_event_at - created time of the Stripe event that
+   set the current status. Stripe does not deliver in order, so a status is
+   only replaced by an event at least as new
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'd7f2b9c4e816'
+down_revision: Union[str, None] = 'c4a9e7b2d305'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add Stripe event storage"""
+
+    # 1. Raw events
+    op.create_table(
+        'stripe_events',
+        sa.Column('event_id', sa.String(255), primary_key=True),
+        sa.Column('type', sa.String(100), nullable=False),
+        sa.Column('customer_id', sa.String(100), nullable=True),
+        sa.Column('stripe_created', sa.TIMESTAMP(timezone=True), nullable=False),
+        sa.Column('payload', postgresql.JSONB(), nullable=False),
+        sa.Column('received_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+        sa.Column('processed_at', sa.TIMESTAMP(timezone=True), nullable=True),
+    )
+    # Startup recovery scans only unprocessed rows
+    op.create_index(
+        'idx_stripe_events_pending', 'stripe_events', ['stripe_created', 'received_at'],
+        postgresql_where=sa.text('processed_at IS NULL'),
+    )
+    op.create_index('idx_stripe_events_customer', 'stripe_events', ['customer_id', 'stripe_created'])
+
+    # 2. Event time of the current status (NULL: never set by a webhook)
+    op.add_column(
+        'subscriptions',
+        sa.Column('status_event_at', sa.TIMESTAMP(timezone=True), nullable=True),
+    )
+
+
+def downgrade() -> None:
+    """Remove Stripe event storage"""
+
+    op.drop_column('subscriptions', 'status_event_at')
+    op.drop_index('idx_stripe_events_customer', table_name='stripe_events')
+    op.drop_index('idx_stripe_events_pending', table_name='stripe_events')
+    op.drop_table('stripe_events')
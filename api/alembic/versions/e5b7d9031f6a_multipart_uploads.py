@@ -0,0 +1,71 @@
+"""multipart_uploads
+
+Revision ID: e5b7d9031f6a
+Revises: d4f8a2c61e37
+Create Date: 2025-11-16 17:25:08.518204
+
+Multipart (resumable) uploads on upload_objects (UploadService
+InitiateMultipartUpload / PresignParts / CompleteMultipartUpload /
+ListUploadedParts):
+1. Add multipart_upload_id - S3 UploadId; NULL for single-PUT uploads
+2. Add part_size and part_count - fixed at initiation, every part but the
+   last is part_size bytes
+3. Add parts - {"<part number>": {"etag": ..., "size": ...}} as last listed
+   from S3, kept after completion when S3 no longer lists the parts
+4. Add etag - ETag of the assembled object
+5. Add a partial index on pending multipart uploads for abandoned-upload
+   cleanup
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'e5b7d9031f6a'
+down_revision: Union[str, None] = 'd4f8a2c61e37'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add multipart upload state to upload_objects"""
+
+    op.add_column('upload_objects', sa.Column('multipart_upload_id', sa.Text(), nullable=True))
+    op.add_column('upload_objects', sa.Column('part_size', sa.BigInteger(), nullable=True))
+    op.add_column('upload_objects', sa.Column('part_count', sa.Integer(), nullable=True))
+    op.add_column('upload_objects', sa.Column(
+        'parts',
+        postgresql.JSONB(),
+        nullable=False,
+        server_default=sa.text("'{}'::jsonb")
+    ))
+    op.add_column('upload_objects', sa.Column('etag', sa.Text(), nullable=True))
+
+    op.create_check_constraint(
+        'upload_multipart_layout',
+        'upload_objects',
+        'multipart_upload_id IS NULL OR (part_size > 0 AND part_count BETWEEN 1 AND 10000)'
+    )
+
+    op.create_index(
+        'idx_uploads_multipart_pending',
+        'upload_objects',
+        ['created_at'],
+        postgresql_where=sa.text("multipart_upload_id IS NOT NULL AND status = 'pending'")
+    )
+
+
+def downgrade() -> None:
+    """Remove multipart upload state"""
+
+    op.drop_index('idx_uploads_multipart_pending', table_name='upload_objects')
+    op.drop_constraint('upload_multipart_layout', 'upload_objects', type_='check')
+    op.drop_column('upload_objects', 'etag')
+    op.drop_column('upload_objects', 'parts')
+    op.drop_column('upload_objects', 'part_count')
+    op.drop_column('upload_objects', 'part_size')
+    op.drop_column('upload_objects', 'multipart_upload_id')
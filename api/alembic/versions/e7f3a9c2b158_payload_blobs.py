@@ -0,0 +1,84 @@
+"""payload_blobs
+
+Revision ID: e7f3a9c2b158
+Revises: a4c8e1f6d392
+Create Date: 2025-11-17 20:41:37.215804
+
+Compressed, deduplicated storage of queued bodies (common::PayloadCodec):
+1. Add payload_blobs - bodies of PAYLOAD_STORE_MIN_BYTES or more, deflated
+   and keyed by the SHA-256 of their content, so identical bodies (fan-out,
+   campaign sends) are stored once. Inserts touch last_used_at at most
+   hourly; QueuePartitionMaintainer deletes blobs untouched for longer than
+   the queue retention (plus two days, for a day partition's whole life)
+2. Add payload_dictionaries - preset deflate dictionaries trained per scope
+   (webhook event type, email template), keyed by the Adler-32 zlib writes
+   into each stream that uses one
+3. Add webhook_events.payload_hash, webhook_deliveries.payload_hash,
+   email_queue.body_html_hash and email_queue.body_text_hash - set when the
+   body is in payload_blobs, the text column then holding ''
+
+Blob data is stored EXTERNAL: it is compressed already, so TOAST should not
+try again.
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'e7f3a9c2b158'
+down_revision: Union[str, None] = 'a4c8e1f6d392'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+HASH_COLUMNS = [
+    ('webhook_events', 'payload_hash'),
+    ('webhook_deliveries', 'payload_hash'),
+    ('email_queue', 'body_html_hash'),
+    ('email_queue', 'body_text_hash'),
+]
+
+
+def upgrade() -> None:
+    """Add payload blob storage"""
+
+    # 1. Content-addressed bodies
+    op.create_table(
+        'payload_blobs',
+        sa.Column('hash', postgresql.BYTEA(), primary_key=True),
+        sa.Column('data', postgresql.BYTEA(), nullable=False),
+        sa.Column('last_used_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+    )
+    op.execute('ALTER TABLE payload_blobs ALTER COLUMN data SET STORAGE EXTERNAL')
+    op.create_index('idx_payload_blobs_last_used', 'payload_blobs', ['last_used_at'])
+
+    # 2. Trained dictionaries
+    op.create_table(
+        'payload_dictionaries',
+        sa.Column('id', sa.BigInteger(), primary_key=True, autoincrement=False),
+        sa.Column('scope', sa.String(200), nullable=False),
+        sa.Column('data', postgresql.BYTEA(), nullable=False),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), nullable=False,
+                  server_default=sa.text('NOW()')),
+    )
+
+    # 3. References from the queues (added to every partition)
+    for table, column in HASH_COLUMNS:
+        op.add_column(table, sa.Column(column, postgresql.BYTEA(), nullable=True))
+
+
+def downgrade() -> None:
+    """Remove payload blob storage
+
+    Bodies still in payload_blobs are lost; drain the queues first.
+    """
+
+    for table, column in reversed(HASH_COLUMNS):
+        op.drop_column(table, column)
+    op.drop_table('payload_dictionaries')
+    op.drop_index('idx_payload_blobs_last_used', table_name='payload_blobs')
+    op.drop_table('payload_blobs')
@@ -0,0 +1,58 @@
+"""keyset_list_indexes
+
+Revision ID: e8b4c2a6f157
+Revises: d7f2b9c4e816
+Create Date: 2025-11-16 23:41:05.618274
+
+Keyset pagination for NotificationService.ListNotifications and
+ListWebhookDeliveries:
+1. Add idx_notifications_tenant_keyset on (tenant_id, created_at DESC,
+   id DESC), including the listed columns, so a page is an index-only scan
+   starting at the cursor. It replaces idx_notifications_tenant
+2. Add idx_webhook_deliveries_tenant_keyset, the same on every
+   webhook_deliveries partition (merged newest first by the planner).
+   error_message is not included: B-tree entries are limited to about
+   2.7 kB, and the list does not return it
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'e8b4c2a6f157'
+down_revision: Union[str, None] = 'd7f2b9c4e816'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add covering keyset indexes for the list RPCs"""
+
+    # 1. Notifications; a (tenant_id) prefix lookup is served by it too
+    op.create_index(
+        'idx_notifications_tenant_keyset',
+        'notifications',
+        ['tenant_id', sa.text('created_at DESC'), sa.text('id DESC')],
+        postgresql_include=['channel', 'status', 'sent_at', 'delivered_at', 'retry_count'],
+    )
+    op.drop_index('idx_notifications_tenant', table_name='notifications')
+
+    # 2. Webhook deliveries (partitioned parent: created on each partition)
+    op.create_index(
+        'idx_webhook_deliveries_tenant_keyset',
+        'webhook_deliveries',
+        ['tenant_id', sa.text('created_at DESC'), sa.text('id DESC')],
+        postgresql_include=['webhook_id', 'event_type', 'status', 'retry_count', 'http_status_code',
+                            'delivered_at'],
+    )
+
+
+def downgrade() -> None:
+    """Remove the keyset indexes"""
+
+    op.drop_index('idx_webhook_deliveries_tenant_keyset', table_name='webhook_deliveries')
+    op.create_index('idx_notifications_tenant', 'notifications', ['tenant_id'])
+    op.drop_index('idx_notifications_tenant_keyset', table_name='notifications')
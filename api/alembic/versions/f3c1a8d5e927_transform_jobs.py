@@ -0,0 +1,66 @@
+"""transform_jobs
+
+Revision ID: f3c1a8d5e927
+Revises: e5b7d9031f6a
+Create Date: 2025-11-16 18:02:41.730115
+
+Server-side TransformObject jobs (UploadService transform engine):
+1. Add transform_jobs - one row per TransformObject call; status moves from
+   queued to completed or failed, output_object_id points at the derivative
+   upload_objects row
+2. Add a partial index on unfinished jobs for stuck-job sweeps
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'f3c1a8d5e927'
+down_revision: Union[str, None] = 'e5b7d9031f6a'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Create transform_jobs"""
+
+    op.create_table(
+        'transform_jobs',
+        sa.Column('id', postgresql.UUID(), server_default=sa.text('uuid_generate_v4()'), nullable=False),
+        sa.Column('tenant_id', postgresql.UUID(), nullable=False),
+        sa.Column('source_object_id', postgresql.UUID(), nullable=False),
+        sa.Column('profile_id', sa.String(64), nullable=False),
+        sa.Column('output_format', sa.String(16), nullable=True),
+        sa.Column('status', sa.String(20), server_default='queued', nullable=False),
+        sa.Column('output_object_id', postgresql.UUID(), nullable=True),
+        sa.Column('bytes_in', sa.BigInteger(), nullable=True),
+        sa.Column('bytes_out', sa.BigInteger(), nullable=True),
+        sa.Column('error', sa.Text(), nullable=True),
+        sa.Column('created_at', sa.TIMESTAMP(timezone=True), server_default=sa.text('NOW()'), nullable=False),
+        sa.Column('completed_at', sa.TIMESTAMP(timezone=True), nullable=True),
+        sa.PrimaryKeyConstraint('id'),
+        sa.ForeignKeyConstraint(['tenant_id'], ['tenants.id'], ondelete='CASCADE'),
+        sa.ForeignKeyConstraint(['source_object_id'], ['upload_objects.id'], ondelete='CASCADE'),
+        sa.ForeignKeyConstraint(['output_object_id'], ['upload_objects.id'], ondelete='SET NULL'),
+        sa.CheckConstraint("status IN ('queued', 'completed', 'failed')", name='transform_job_status_check'),
+    )
+
+    op.create_index('idx_transform_jobs_source', 'transform_jobs', ['source_object_id'])
+    op.create_index(
+        'idx_transform_jobs_unfinished',
+        'transform_jobs',
+        ['created_at'],
+        postgresql_where=sa.text("status = 'queued'")
+    )
+
+
+def downgrade() -> None:
+    """Drop transform_jobs"""
+
+    op.drop_index('idx_transform_jobs_unfinished', table_name='transform_jobs')
+    op.drop_index('idx_transform_jobs_source', table_name='transform_jobs')
+    op.drop_table('transform_jobs')
@@ -0,0 +1,55 @@
+"""backup_code_lookup_index
+
+Revision ID: f6b3d8e2a415
+Revises: e2a7c5d9b314
+Create Date: 2025-11-16 20:44:19.367052
+
+Indexed backup code check (auth service Login):
+1. Add backup_codes if an installation predates it (the auth service has
+   always written it; it was never in the baseline)
+2. Index (user_id, code_hash) over unused codes, so a submitted code is
+   hashed once and consumed with a single index probe instead of hashing
+   it against every unused code of the user
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision: str = 'f6b3d8e2a415'
+down_revision: Union[str, None] = 'e2a7c5d9b314'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    """Add the backup code lookup index"""
+
+    # 1. Backup codes (SHA-256 hex of the plain code)
+    op.execute("""
+        CREATE TABLE IF NOT EXISTS backup_codes (
+            id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+            user_id UUID NOT NULL REFERENCES users(id) ON DELETE CASCADE,
+            code_hash VARCHAR(64) NOT NULL,
+            used_at TIMESTAMP WITH TIME ZONE,
+            created_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT NOW()
+        )
+    """)
+
+    # 2. Lookup index
+    op.create_index(
+        'idx_backup_codes_user_hash',
+        'backup_codes',
+        ['user_id', 'code_hash'],
+        postgresql_where=sa.text('used_at IS NULL')
+    )
+
+
+def downgrade() -> None:
+    """Remove the backup code lookup index"""
+
+    # The table is left in place: it may predate this revision
+    op.drop_index('idx_backup_codes_user_hash', table_name='backup_codes')
@@ -2,6 +2,8 @@
 
 import grpc
 import os
+import threading
+from concurrent.futures import Future
 from typing import Optional, Dict, List
 import sys
 
@@ -13,6 +15,8 @@ from auth_pb2 import (
     LogoutRequest, LogoutResponse,
     RefreshTokenRequest, RefreshTokenResponse,
     ValidateTokenRequest, ValidateTokenResponse,
+    CredentialCheck, CredentialResult,
+    ValidateBatchRequest, ValidateBatchResponse,
     CreateApiKeyRequest, CreateApiKeyResponse,
     RevokeApiKeyRequest, RevokeApiKeyResponse
 )
@@ -80,6 +84,11 @@ class AuthClient:
         request = ValidateTokenRequest(access_token=access_token)
         return self.stub.ValidateToken(request)
 
+    def validate_batch(self, checks: List[CredentialCheck]) -> ValidateBatchResponse:
+        """Validate up to 256 access tokens / API keys in one call (results in order)."""
+        request = ValidateBatchRequest(checks=checks)
+        return self.stub.ValidateBatch(request)
+
     def create_api_key(
         self,
         name: str,
@@ -109,3 +118,75 @@ class AuthClient:
 
     def __exit__(self, exc_type, exc_val, exc_tb):
         self.close()
+
+
+class ValidationCoalescer:
+    """Coalesces concurrent credential checks into ValidateBatch calls.
+
+    The first check starts a window (1 ms by default); every check arriving
+    within it, or until max_batch is reached, is sent in the same RPC.
+    Identical credentials are deduplicated by the auth service.
+
+    Usage:
+        coalescer = ValidationCoalescer(auth_client)
+        result = coalescer.validate_token(token)           # CredentialResult
+        result = coalescer.validate_api_key(key, "read:upload")
+    """
+
+    MAX_BATCH = 256
+
+    def __init__(self, client: AuthClient, window_seconds: float = 0.001, max_batch: int = MAX_BATCH):
+        self.client = client
+        self.window_seconds = window_seconds
+        self.max_batch = min(max_batch, self.MAX_BATCH)
+        self._lock = threading.Lock()
+        self._pending: List[tuple] = []  # (CredentialCheck, Future)
+        self._timer: Optional[threading.Timer] = None
+
+    def validate_token(self, access_token: str) -> CredentialResult:
+        return self._submit(CredentialCheck(access_token=access_token)).result()
+
+    def validate_api_key(self, api_key: str, requested_scope: str = "") -> CredentialResult:
+        return self._submit(CredentialCheck(api_key=api_key, requested_scope=requested_scope)).result()
+
+    def _submit(self, check: CredentialCheck) -> Future:
+        future: Future = Future()
+        batch = None
+        with self._lock:
+            self._pending.append((check, future))
+            if len(self._pending) >= self.max_batch:
+                batch = self._take()
+            elif self._timer is None:
+                self._timer = threading.Timer(self.window_seconds, self._flush)
+                self._timer.daemon = True
+                self._timer.start()
+        if batch:
+            self._send(batch)
+        return future
+
+    def _take(self) -> List[tuple]:
+        # Caller holds _lock
+        batch, self._pending = self._pending, []
+        if self._timer is not None:
+            self._timer.cancel()
+            self._timer = None
+        return batch
+
+    def _flush(self):
+        with self._lock:
+            batch = self._take()
+        if batch:
+            self._send(batch)
+
+    def _send(self, batch: List[tuple]):
+        try:
+            response = self.client.validate_batch([check for check, _ in batch])
+            if len(response.results) != len(batch):
+                raise RuntimeError("ValidateBatch returned %d results for %d checks"
+                                   % (len(response.results), len(batch)))
+            for (_, future), result in zip(batch, response.results):
+                future.set_result(result)
+        except Exception as e:  # One failed RPC fails every waiter of the batch
+            for _, future in batch:
+                if not future.done():
+                    future.set_exception(e)
@@ -2,7 +2,7 @@
 
 import grpc
 import os
-from typing import List, Dict, Optional
+from typing import Iterator, List, Dict, Optional
 import sys
 
 sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'generated'))
@@ -10,8 +10,10 @@ sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'generated'))
 from notification_pb2 import (
     SendEmailRequest, SendSMSRequest, SendPushRequest,
     TriggerWebhookRequest, GetNotificationStatusRequest,
-    UpdatePreferencesRequest, RegisterWebhookRequest,
-    NotificationResponse, PreferencesResponse, WebhookResponse
+    ListNotificationsRequest, ListWebhookDeliveriesRequest,
+    UpdatePreferencesRequest, RegisterWebhookRequest, PublishEventRequest,
+    NotificationResponse, PreferencesResponse, WebhookResponse, PublishEventResponse,
+    WebhookDeliveryResponse
 )
 from notification_pb2_grpc import NotificationServiceStub
 
@@ -131,6 +133,21 @@ class NotificationClient:
         )
         return self.stub.TriggerWebhook(request, metadata=metadata)
 
+    def publish_event(
+        self,
+        tenant_id: str,
+        event_type: str,
+        payload: str,
+        metadata: List[tuple]
+    ) -> PublishEventResponse:
+        """Publish event to every webhook subscribed to event_type."""
+        request = PublishEventRequest(
+            tenant_id=tenant_id,
+            event_type=event_type,
+            payload=payload
+        )
+        return self.stub.PublishEvent(request, metadata=metadata)
+
     def get_notification_status(
         self,
         tenant_id: str,
@@ -144,6 +161,39 @@ class NotificationClient:
         )
         return self.stub.GetNotificationStatus(request, metadata=metadata)
 
+    def list_notifications(
+        self,
+        tenant_id: str,
+        metadata: List[tuple],
+        page_size: int = 0,
+        after_cursor: str = ""
+    ) -> Iterator[NotificationResponse]:
+        """Stream one page of notifications, newest first.
+
+        The next page starts after the last row's cursor.
+        """
+        request = ListNotificationsRequest(
+            tenant_id=tenant_id,
+            page_size=page_size,
+            after_cursor=after_cursor
+        )
+        return self.stub.ListNotifications(request, metadata=metadata)
+
+    def list_webhook_deliveries(
+        self,
+        tenant_id: str,
+        metadata: List[tuple],
+        page_size: int = 0,
+        after_cursor: str = ""
+    ) -> Iterator[WebhookDeliveryResponse]:
+        """Stream one page of webhook deliveries, newest first."""
+        request = ListWebhookDeliveriesRequest(
+            tenant_id=tenant_id,
+            page_size=page_size,
+            after_cursor=after_cursor
+        )
+        return self.stub.ListWebhookDeliveries(request, metadata=metadata)
+
     def update_preferences(
         self,
         tenant_id: str,
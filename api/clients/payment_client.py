@@ -2,7 +2,7 @@
 
 import grpc
 import os
-from typing import List, Optional
+from typing import Iterable, List, Optional
 import sys
 
 sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'generated'))
@@ -14,7 +14,8 @@ from payment_pb2 import (
     AddPaymentMethodRequest, PaymentMethodResponse,
     RemovePaymentMethodRequest, RemovePaymentMethodResponse,
     GetInvoiceRequest, InvoiceResponse,
-    RecordUsageRequest, RecordUsageResponse
+    RecordUsageRequest, RecordUsageResponse, StreamUsageResponse,
+    GetUsageSummaryRequest, GetUsageSummaryResponse
 )
 from payment_pb2_grpc import PaymentServiceStub
 
@@ -82,12 +83,14 @@ class PaymentClient:
         subscription_id: str,
         plan_id: Optional[str],
         quantity: Optional[int],
-        metadata: List[tuple]
+        metadata: List[tuple],
+        idempotency_key: str = ""
     ) -> SubscriptionResponse:
         """Update existing subscription."""
         request = UpdateSubscriptionRequest(
             tenant_id=tenant_id,
-            subscription_id=subscription_id
+            subscription_id=subscription_id,
+            idempotency_key=idempotency_key
         )
         if plan_id:
             request.plan_id = plan_id
@@ -101,13 +104,15 @@ class PaymentClient:
         tenant_id: str,
         subscription_id: str,
         immediate: bool,
-        metadata: List[tuple]
+        metadata: List[tuple],
+        idempotency_key: str = ""
     ) -> SubscriptionResponse:
         """Cancel subscription."""
         request = CancelSubscriptionRequest(
             tenant_id=tenant_id,
             subscription_id=subscription_id,
-            immediate=immediate
+            immediate=immediate,
+            idempotency_key=idempotency_key
         )
         return self.stub.CancelSubscription(request, metadata=metadata)
 
@@ -128,12 +133,14 @@ class PaymentClient:
         self,
         tenant_id: str,
         stripe_payment_method_id: str,
-        metadata: List[tuple]
+        metadata: List[tuple],
+        idempotency_key: str = ""
     ) -> PaymentMethodResponse:
         """Add payment method."""
         request = AddPaymentMethodRequest(
             tenant_id=tenant_id,
-            stripe_payment_method_id=stripe_payment_method_id
+            stripe_payment_method_id=stripe_payment_method_id,
+            idempotency_key=idempotency_key
         )
         return self.stub.AddPaymentMethod(request, metadata=metadata)
 
@@ -141,12 +148,14 @@ class PaymentClient:
         self,
         tenant_id: str,
         payment_method_id: str,
-        metadata: List[tuple]
+        metadata: List[tuple],
+        idempotency_key: str = ""
     ) -> RemovePaymentMethodResponse:
         """Remove payment method."""
         request = RemovePaymentMethodRequest(
             tenant_id=tenant_id,
-            payment_method_id=payment_method_id
+            payment_method_id=payment_method_id,
+            idempotency_key=idempotency_key
         )
         return self.stub.RemovePaymentMethod(request, metadata=metadata)
 
@@ -170,7 +179,8 @@ class PaymentClient:
         metric_name: str,
         quantity: int,
         timestamp: int,
-        metadata: List[tuple]
+        metadata: List[tuple],
+        idempotency_key: str = ""
     ) -> RecordUsageResponse:
         """Record usage for metered billing."""
         request = RecordUsageRequest(
@@ -178,10 +188,53 @@ class PaymentClient:
             subscription_id=subscription_id,
             metric_name=metric_name,
             quantity=quantity,
-            timestamp=timestamp
+            timestamp=timestamp,
+            idempotency_key=idempotency_key
         )
         return self.stub.RecordUsage(request, metadata=metadata)
 
+    def stream_usage(
+        self,
+        events: Iterable[dict],
+        metadata: List[tuple]
+    ) -> StreamUsageResponse:
+        """Record many usage events over one client stream.
+
+        Each event is a dict with subscription_id, metric_name, quantity and
+        optionally timestamp; events the service rejects are only counted.
+        """
+        requests = (
+            RecordUsageRequest(
+                subscription_id=event["subscription_id"],
+                metric_name=event["metric_name"],
+                quantity=event["quantity"],
+                timestamp=event.get("timestamp", 0)
+            )
+            for event in events
+        )
+        return self.stub.StreamUsage(requests, metadata=metadata)
+
+    def get_usage_summary(
+        self,
+        tenant_id: str,
+        subscription_id: str,
+        granularity: int,
+        start_time: int,
+        end_time: int,
+        metadata: List[tuple],
+        metric_name: str = ""
+    ) -> GetUsageSummaryResponse:
+        """Get aggregated usage per minute, hour or billing period."""
+        request = GetUsageSummaryRequest(
+            tenant_id=tenant_id,
+            subscription_id=subscription_id,
+            metric_name=metric_name,
+            granularity=granularity,
+            start_time=start_time,
+            end_time=end_time
+        )
+        return self.stub.GetUsageSummary(request, metadata=metadata)
+
     def close(self):
         """Close gRPC channel."""
         if self.channel:
@@ -2,7 +2,7 @@
 
 import grpc
 import os
-from typing import List
+from typing import Dict, Iterator, List, Optional, Tuple
 import sys
 
 sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'generated'))
@@ -12,7 +12,14 @@ from upload_pb2 import (
     CompleteUploadRequest, CompleteUploadResponse,
     TransformRequest, TransformResponse,
     DeleteObjectRequest, DeleteObjectResponse,
-    GetQuotaRequest, GetQuotaResponse
+    DeleteObjectsRequest, DeleteObjectsResponse,
+    GetQuotaRequest, GetQuotaResponse,
+    InitiateMultipartUploadRequest, InitiateMultipartUploadResponse,
+    PresignPartsRequest, PresignPartsResponse,
+    CompleteMultipartUploadRequest, CompleteMultipartUploadResponse,
+    ListUploadedPartsRequest, ListUploadedPartsResponse,
+    ListObjectsRequest, ListRecentObjectsRequest, ListRecentObjectsResponse,
+    ObjectInfo, UploadedPart
 )
 from upload_pb2_grpc import UploadServiceStub
 
@@ -56,13 +63,24 @@ class UploadClient:
         filename: str,
         content_length: int,
         content_type: str,
-        metadata: List[tuple]
+        metadata: List[tuple],
+        checksum_sha256: str = "",
+        deduplicate: bool = False,
+        tags: Optional[Dict[str, str]] = None
     ) -> PresignedUrlResponse:
-        """Generate presigned URL for file upload."""
+        """Generate presigned URL for file upload.
+
+        With deduplicate (requires checksum_sha256), content the tenant has
+        already stored comes back as deduplicated=True with no URL. tags are
+        stored as the object's metadata, which list_objects can filter on.
+        """
         request = PresignedUrlRequest(
             filename=filename,
             content_length=content_length,
-            content_type=content_type
+            content_type=content_type,
+            checksum_sha256=checksum_sha256,
+            metadata=tags or {},
+            deduplicate=deduplicate
         )
         return self.stub.GeneratePresignedUrl(request, metadata=metadata)
 
@@ -83,13 +101,20 @@ class UploadClient:
         self,
         object_id: str,
         profile_id: str,
-        metadata: List[tuple]
+        metadata: List[tuple],
+        output_format: Optional[str] = None
     ) -> TransformResponse:
-        """Transform uploaded object (resize, compress, etc)."""
+        """Queue a server-side transform of an uploaded object.
+
+        Profiles: "thumbnail" / "thumbnail-<N>" (PGM/PPM images) and "gzip".
+        The derivative is stored as a new object once the job completes.
+        """
         request = TransformRequest(
             object_id=object_id,
             profile_id=profile_id
         )
+        if output_format:
+            request.output_format = output_format
         return self.stub.TransformObject(request, metadata=metadata)
 
     def delete_object(
@@ -101,11 +126,108 @@ class UploadClient:
         request = DeleteObjectRequest(object_id=object_id)
         return self.stub.DeleteObject(request, metadata=metadata)
 
+    def delete_objects(
+        self,
+        object_ids: List[str],
+        metadata: List[tuple]
+    ) -> DeleteObjectsResponse:
+        """Delete many uploaded objects in one call."""
+        request = DeleteObjectsRequest(object_ids=object_ids)
+        return self.stub.DeleteObjects(request, metadata=metadata)
+
     def get_quota(self, metadata: List[tuple]) -> GetQuotaResponse:
         """Get storage quota for tenant."""
         request = GetQuotaRequest()
         return self.stub.GetQuota(request, metadata=metadata)
 
+    def initiate_multipart_upload(
+        self,
+        filename: str,
+        content_length: int,
+        content_type: str,
+        metadata: List[tuple],
+        part_size: int = 0,
+        checksum_sha256: str = "",
+        deduplicate: bool = False,
+        tags: Optional[Dict[str, str]] = None
+    ) -> InitiateMultipartUploadResponse:
+        """Start a multipart upload; part_size 0 lets the service choose."""
+        request = InitiateMultipartUploadRequest(
+            filename=filename,
+            content_length=content_length,
+            content_type=content_type,
+            part_size=part_size,
+            checksum_sha256=checksum_sha256,
+            deduplicate=deduplicate,
+            metadata=tags or {}
+        )
+        return self.stub.InitiateMultipartUpload(request, metadata=metadata)
+
+    def presign_parts(
+        self,
+        upload_id: str,
+        part_numbers: List[int],
+        metadata: List[tuple]
+    ) -> PresignPartsResponse:
+        """Get PUT URLs for up to 1000 parts in one call."""
+        request = PresignPartsRequest(
+            upload_id=upload_id,
+            part_numbers=part_numbers
+        )
+        return self.stub.PresignParts(request, metadata=metadata)
+
+    def complete_multipart_upload(
+        self,
+        upload_id: str,
+        parts: List[Tuple[int, str]],
+        metadata: List[tuple]
+    ) -> CompleteMultipartUploadResponse:
+        """Assemble the object from (part_number, etag) pairs; empty uses the parts stored in S3."""
+        request = CompleteMultipartUploadRequest(
+            upload_id=upload_id,
+            parts=[UploadedPart(part_number=n, etag=etag) for n, etag in parts]
+        )
+        return self.stub.CompleteMultipartUpload(request, metadata=metadata)
+
+    def list_uploaded_parts(
+        self,
+        upload_id: str,
+        metadata: List[tuple]
+    ) -> ListUploadedPartsResponse:
+        """List parts already stored, for resuming an interrupted upload."""
+        request = ListUploadedPartsRequest(upload_id=upload_id)
+        return self.stub.ListUploadedParts(request, metadata=metadata)
+
+    def list_objects(
+        self,
+        metadata: List[tuple],
+        prefix: str = "",
+        tags: Optional[Dict[str, str]] = None,
+        page_size: int = 0,
+        after_cursor: str = ""
+    ) -> Iterator[ObjectInfo]:
+        """Stream one page of completed objects, by filename.
+
+        tags must all be in an object's metadata. The next page starts after
+        the last object's cursor.
+        """
+        request = ListObjectsRequest(
+            prefix=prefix,
+            tags=tags or {},
+            page_size=page_size,
+            after_cursor=after_cursor
+        )
+        return self.stub.ListObjects(request, metadata=metadata)
+
+    def list_recent_objects(
+        self,
+        metadata: List[tuple],
+        limit: int = 0
+    ) -> ListRecentObjectsResponse:
+        """Most recently completed objects, newest first."""
+        request = ListRecentObjectsRequest(limit=limit)
+        return self.stub.ListRecentObjects(request, metadata=metadata)
+
     def close(self):
         """Close gRPC channel."""
         if self.channel:
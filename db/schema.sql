@@ -180,7 +180,7 @@ CREATE TABLE upload_objects (
     id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
     tenant_id UUID NOT NULL REFERENCES tenants(id) ON DELETE CASCADE,
     user_id UUID NOT NULL REFERENCES users(id) ON DELETE SET NULL,
-    object_key VARCHAR(1024) NOT NULL,  -- S3 object key: tenant_id/user_id/timestamp_filename
+    object_key VARCHAR(1024) NOT NULL,  -- S3 object key: tenant_id/user_id/<object id>_filename
     filename VARCHAR(255) NOT NULL,
     content_type VARCHAR(100) NOT NULL,
     size BIGINT NOT NULL,  -- Bytes
@@ -0,0 +1,97 @@
+-- Production-sized data for the performance regression harness
+-- (scripts/run-perf-tests.sh), on top of db/test_schema.sql
+--
+-- Volumes are psql variables, e.g.:
+--   psql -v users=1000000 -v api_keys=50000 -v queue_rows=10000000 -f db/seeds/perf/001_perf_volume.sql
+--
+-- Ids are derived from the row number, so rerunning the seed adds nothing.
+-- Users perf-user-<n>@loadtest.example.com share the password of the
+-- test@example.com fixture ("test_password_123").
+
+\set ON_ERROR_STOP on
+
+\if :{?tenants}
+\else
+\set tenants 1000
+\endif
+\if :{?users}
+\else
+\set users 1000000
+\endif
+\if :{?api_keys}
+\else
+\set api_keys 50000
+\endif
+\if :{?queue_rows}
+\else
+\set queue_rows 10000000
+\endif
+
+\echo Seeding :tenants tenants, :users users, :api_keys API keys, :queue_rows email_queue rows
+
+INSERT INTO tenants (id, name)
+SELECT md5('perf-tenant-' || n)::uuid, 'Perf Tenant ' || n
+FROM generate_series(1, :tenants) AS n
+ON CONFLICT DO NOTHING;
+
+-- User n belongs to tenant n % tenants + 1
+INSERT INTO users (id, tenant_id, email, password_hash)
+SELECT md5('perf-user-' || n)::uuid,
+       md5('perf-tenant-' || (n % :tenants + 1))::uuid,
+       'perf-user-' || n || '@loadtest.example.com',
+       (SELECT password_hash FROM users WHERE email = 'test@example.com')
+FROM generate_series(1, :users) AS n
+ON CONFLICT DO NOTHING;
+
+-- Current-scheme keys (looked up by key_id) spread over the users; their
+-- secrets are unknown, so they only add volume to the index probes
+INSERT INTO api_keys (id, user_id, tenant_id, key_id, key_prefix, key_hash, hash_scheme, name, scopes, expires_at)
+SELECT md5('perf-key-' || n)::uuid,
+       md5('perf-user-' || u)::uuid,
+       md5('perf-tenant-' || (u % :tenants + 1))::uuid,
+       md5('perf-key-id-' || n),
+       'sf_perf',
+       md5('perf-key-hash-' || n) || md5('perf-key-salt-' || n),
+       'hmac-sha256',
+       'Perf Key ' || n,
+       '{read,write}',
+       NOW() + INTERVAL '1 year'
+FROM (SELECT n, (n * 7919) % :users + 1 AS u FROM generate_series(1, :api_keys) AS n) AS keys
+ON CONFLICT DO NOTHING;
+
+-- email_queue is not part of the test schema; seeded when the stack has it.
+-- Mostly delivered history, 1% exhausted or bounced, 1% pending but
+-- scheduled a day out, so a running worker does not drain them.
+SELECT to_regclass('email_queue') IS NOT NULL AS has_email_queue \gset
+\if :has_email_queue
+SELECT EXISTS (SELECT 1 FROM email_queue WHERE id = md5('perf-email-' || :queue_rows)::uuid) AS queue_seeded \gset
+\if :queue_seeded
+\echo email_queue already seeded
+\else
+INSERT INTO email_queue
+    (id, tenant_id, user_id, to_address, subject, body_html, body_text, status, retry_count, priority,
+     created_at, scheduled_at, sent_at, lane)
+SELECT md5('perf-email-' || n)::uuid,
+       md5('perf-tenant-' || ((n % :users + 1) % :tenants + 1))::uuid,
+       md5('perf-user-' || (n % :users + 1))::uuid,
+       'perf-user-' || (n % :users + 1) || '@loadtest.example.com',
+       'Perf notification ' || n,
+       '<p>Perf notification ' || n || '</p>',
+       'Perf notification ' || n,
+       CASE WHEN n % 100 = 0 THEN 0 WHEN n % 100 = 1 THEN 5 WHEN n % 100 = 2 THEN 6 ELSE 2 END,
+       CASE WHEN n % 100 IN (1, 2) THEN 3 ELSE 0 END,
+       n % 3,
+       NOW() - make_interval(secs => n % 3600),
+       CASE WHEN n % 100 = 0 THEN NOW() + INTERVAL '1 day' ELSE NOW() - make_interval(secs => n % 3600) END,
+       CASE WHEN n % 100 >= 3 THEN NOW() END,
+       n % 2
+FROM generate_series(1, :queue_rows) AS n;
+ANALYZE email_queue;
+\endif
+\else
+\echo email_queue not in this schema, skipped
+\endif
+
+ANALYZE tenants;
+ANALYZE users;
+ANALYZE api_keys;
@@ -28,15 +28,33 @@ CREATE TABLE IF NOT EXISTS api_keys (
     id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
     user_id UUID NOT NULL REFERENCES users(id),
     tenant_id UUID NOT NULL REFERENCES tenants(id),
+    key_id VARCHAR(32),
+    key_prefix VARCHAR(10),
     key_hash TEXT NOT NULL,
+    hash_scheme VARCHAR(16) NOT NULL DEFAULT 'argon2id',
     name TEXT NOT NULL,
-    scopes TEXT,
+    scopes TEXT[],
     created_at TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP,
     expires_at TIMESTAMP WITH TIME ZONE,
     revoked_at TIMESTAMP WITH TIME ZONE,
     CONSTRAINT tenant_isolation CHECK (tenant_id IS NOT NULL)
 );
 
+CREATE UNIQUE INDEX IF NOT EXISTS uq_api_keys_key_id ON api_keys(key_id) WHERE key_id IS NOT NULL;
+
+-- Roles and assignments (minimal for testing)
+CREATE TABLE IF NOT EXISTS roles (
+    id UUID PRIMARY KEY DEFAULT uuid_generate_v4(),
+    tenant_id UUID REFERENCES tenants(id),  -- NULL for system roles
+    name VARCHAR(50) NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS user_roles (
+    user_id UUID NOT NULL REFERENCES users(id),
+    role_id UUID NOT NULL REFERENCES roles(id),
+    PRIMARY KEY (user_id, role_id)
+);
+
 -- Test Fixtures
 
 -- Test tenant
@@ -61,6 +79,17 @@ ON CONFLICT (email) DO NOTHING;
 UPDATE users SET deleted_at = CURRENT_TIMESTAMP
 WHERE email = 'deleted@example.com' AND deleted_at IS NULL;
 
+-- System roles; the Test Tenant 2 user is its admin
+INSERT INTO roles (id, tenant_id, name) VALUES
+    ('00000000-0000-0000-0000-000000000001', NULL, 'admin'),
+    ('00000000-0000-0000-0000-000000000002', NULL, 'user')
+ON CONFLICT (id) DO NOTHING;
+
+INSERT INTO user_roles (user_id, role_id) VALUES
+    ('10000000-0000-0000-0000-000000000001', '00000000-0000-0000-0000-000000000002'),
+    ('10000000-0000-0000-0000-000000000002', '00000000-0000-0000-0000-000000000001')
+ON CONFLICT DO NOTHING;
+
 -- Test API key (key: "sk_test_1234567890abcdef")
 INSERT INTO api_keys (id, user_id, tenant_id, key_hash, name, scopes, expires_at) VALUES
     ('20000000-0000-0000-0000-000000000001',
@@ -68,6 +97,6 @@ INSERT INTO api_keys (id, user_id, tenant_id, key_hash, name, scopes, expires_at
      '00000000-0000-0000-0000-000000000001',
      '$argon2id$v=19$m=65536,t=3,p=4$dGVzdGtleXNhbHQxMjM$dGVzdGhhc2gxMjM0NTY3ODkwYWJjZGVmMTIzNDU2',
      'Test API Key',
-     'read,write',
+     '{read,write}',
      CURRENT_TIMESTAMP + INTERVAL '1 year')
 ON CONFLICT (id) DO NOTHING;
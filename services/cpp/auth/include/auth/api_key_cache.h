@@ -0,0 +1,122 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-process cache of verified API keys (Requirement A-14)
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "auth/scope_set.h"
+
+namespace saasforge {
+namespace auth {
+
+/**
+ * Verified API key as returned by ValidateApiKey
+ */
+struct ApiKeyEntry {
+    std::string key_id;               // api_keys.id (revocation handle)
+    std::string user_id;
+    std::string tenant_id;
+    std::vector<std::string> scopes;  // As granted, echoed in responses
+    ScopeSet scope_set;               // Compiled from scopes, for checks
+    int64_t expires_at = 0;           // Unix seconds, 0 = never
+};
+
+/**
+ * Sharded, TTL-bounded cache of verified API keys
+ *
+ * Keyed by the peppered digest of the full presented key, so the plaintext
+ * key is never held in memory beyond the request. Entries live for at most
+ * the configured TTL (and never past the key's own expires_at). Revocations
+ * are propagated between replicas via REVOCATION_TOPIC; the TTL bounds
+ * staleness if an event is missed.
+ *
+ * Usage:
+ *   ApiKeyCache cache(std::chrono::seconds(60));
+ *   if (auto entry = cache.Get(digest)) { ... }
+ *   cache.Put(digest, entry);
+ *   cache.InvalidateByKeyId(key_id);  // on revocation
+ */
+class ApiKeyCache {
+public:
+    /// EventBus topic carrying revoked api_keys.id values
+    static constexpr const char* REVOCATION_TOPIC = "api_key:revoked";
+
+    explicit ApiKeyCache(
+        std::chrono::seconds ttl = std::chrono::seconds(60),
+        size_t max_entries = 100000,
+        size_t num_shards = 16
+    );
+
+    /**
+     * Look up a verified key
+     *
+     * @param digest Digest of the presented key
+     * @return Cached entry, or nullopt if absent or expired
+     */
+    std::optional<ApiKeyEntry> Get(const std::string& digest);
+
+    /**
+     * Invalidation generation; read before a DB lookup and pass to Put()
+     */
+    uint64_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+    /**
+     * Cache a verified key
+     *
+     * The entry is dropped if any invalidation happened since `generation`
+     * was read, so a revocation racing with a cache fill cannot be undone.
+     *
+     * @param digest Digest of the presented key
+     * @param entry Verified key data
+     * @param generation Value of Generation() taken before the lookup
+     */
+    void Put(const std::string& digest, const ApiKeyEntry& entry, uint64_t generation);
+
+    /**
+     * Drop every cached entry for an api_keys.id
+     *
+     * @param key_id Revoked key id
+     */
+    void InvalidateByKeyId(const std::string& key_id);
+
+    /**
+     * Drop all entries (e.g. after the revocation subscription reconnects)
+     */
+    void Clear();
+
+    size_t Size() const;
+
+private:
+    struct CachedEntry {
+        ApiKeyEntry entry;
+        std::chrono::steady_clock::time_point expires_at;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, CachedEntry> entries;       // digest -> entry
+        std::unordered_map<std::string, std::string> digest_by_id;  // key_id -> digest
+    };
+
+    Shard& ShardFor(const std::string& digest);
+    static void EvictOne(Shard& shard, std::chrono::steady_clock::time_point now);
+
+    std::atomic<uint64_t> generation_{0};
+    std::chrono::seconds ttl_;
+    size_t max_entries_per_shard_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace auth
+} // namespace saasforge
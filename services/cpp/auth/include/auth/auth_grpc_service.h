@@ -0,0 +1,93 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Sync and callback gRPC registrations for AuthServiceImpl
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "auth.grpc.pb.h"
+#include "auth/auth_service.h"
+#include "common/arena_allocator.h"
+#include "common/executor.h"
+#include "common/service_adapter.h"
+
+// Single list of AuthService RPCs; keep in sync with proto/auth.proto
+#define SAASFORGE_AUTH_RPCS(X) \
+    X(Login, LoginRequest, LoginResponse) \
+    X(Logout, LogoutRequest, LogoutResponse) \
+    X(RefreshToken, RefreshTokenRequest, RefreshTokenResponse) \
+    X(ValidateToken, ValidateTokenRequest, ValidateTokenResponse) \
+    X(CreateApiKey, CreateApiKeyRequest, CreateApiKeyResponse) \
+    X(RevokeApiKey, RevokeApiKeyRequest, RevokeApiKeyResponse) \
+    X(EnrollTOTP, EnrollTOTPRequest, EnrollTOTPResponse) \
+    X(VerifyTOTP, VerifyTOTPRequest, VerifyTOTPResponse) \
+    X(DisableTOTP, DisableTOTPRequest, DisableTOTPResponse) \
+    X(GenerateBackupCodes, GenerateBackupCodesRequest, GenerateBackupCodesResponse) \
+    X(SendOTP, SendOTPRequest, SendOTPResponse) \
+    X(VerifyOTP, VerifyOTPRequest, VerifyOTPResponse) \
+    X(InitiateOAuth, InitiateOAuthRequest, InitiateOAuthResponse) \
+    X(HandleOAuthCallback, OAuthCallbackRequest, OAuthCallbackResponse) \
+    X(ValidateApiKey, ValidateApiKeyRequest, ValidateApiKeyResponse) \
+    X(ValidateBatch, ValidateBatchRequest, ValidateBatchResponse) \
+    X(RevokeAllSessions, RevokeAllSessionsRequest, RevokeAllSessionsResponse) \
+    X(RevokeTenantSessions, RevokeTenantSessionsRequest, RevokeTenantSessionsResponse)
+
+namespace saasforge {
+namespace auth {
+
+/**
+ * RPCs callable before the caller has a tenant (sign-in, token and OTP
+ * flows, API key checks); the tenant context interceptor rejects every
+ * other AuthService call that carries no tenant or user
+ */
+inline std::vector<std::string> PublicMethods() {
+    const char* methods[] = {
+        "Login", "Logout", "RefreshToken", "ValidateToken", "SendOTP", "VerifyOTP",
+        "InitiateOAuth", "HandleOAuthCallback", "ValidateApiKey", "ValidateBatch",
+    };
+    std::vector<std::string> names;
+    for (const char* method : methods) {
+        names.push_back(std::string("/") + AuthService::service_full_name() + "/" + method);
+    }
+    return names;
+}
+
+/**
+ * Registers AuthServiceImpl on the synchronous API (handlers on gRPC threads)
+ */
+class AuthServiceSync final : public AuthService::Service {
+public:
+    explicit AuthServiceSync(std::shared_ptr<AuthServiceImpl> impl) : impl_(std::move(impl)) {}
+
+    SAASFORGE_AUTH_RPCS(SAASFORGE_SYNC_UNARY_METHOD)
+
+private:
+    std::shared_ptr<AuthServiceImpl> impl_;
+};
+
+/**
+ * Registers AuthServiceImpl on the callback API; handlers run on a bounded Executor
+ *
+ * Unary requests and responses are allocated on one protobuf arena per RPC.
+ */
+class AuthServiceCallback final : public AuthService::CallbackService {
+public:
+    AuthServiceCallback(std::shared_ptr<AuthServiceImpl> impl, std::shared_ptr<common::Executor> executor)
+        : impl_(std::move(impl)), executor_(std::move(executor)), arenas_(AuthService::service_full_name()) {
+        SAASFORGE_AUTH_RPCS(SAASFORGE_CALLBACK_ARENA_ALLOCATOR)
+    }
+
+    SAASFORGE_AUTH_RPCS(SAASFORGE_CALLBACK_UNARY_METHOD)
+
+private:
+    std::shared_ptr<AuthServiceImpl> impl_;
+    std::shared_ptr<common::Executor> executor_;
+    common::ArenaAllocators arenas_;
+};
+
+} // namespace auth
+} // namespace saasforge
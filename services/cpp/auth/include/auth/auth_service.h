@@ -3,135 +3,222 @@
 #include <grpcpp/grpcpp.h>
 #include <memory>
 #include "auth.grpc.pb.h"
+#include "common/jwt_signer.h"
 #include "common/jwt_validator.h"
 #include "common/redis_client.h"
+#include "common/event_bus.h"
 #include "common/db_pool.h"
+#include "common/rate_limiter.h"
+#include "common/password_hashing_pool.h"
+#include "auth/api_key_cache.h"
+#include "auth/oauth_client.h"
+#include "auth/refresh_tokens.h"
 
 namespace saasforge {
 namespace auth {
 
-class AuthServiceImpl final : public ::saasforge::auth::AuthService::Service {
+/**
+ * AuthService RPC handlers
+ *
+ * Handlers take grpc::ServerContextBase so the same implementation serves
+ * both the sync and the callback server (see auth_grpc_service.h).
+ */
+class AuthServiceImpl final {
 public:
     AuthServiceImpl(
         std::shared_ptr<common::RedisClient> redis_client,
         std::shared_ptr<common::DbPool> db_pool,
         const std::string& jwt_public_key,
-        const std::string& jwt_private_key
+        const std::string& jwt_private_key,
+        const std::string& api_key_pepper,   // Required: HMAC key of API key digests
+        bool allow_legacy_api_key_scan = false,
+        std::shared_ptr<common::PasswordHashingPool> password_hashing_pool = nullptr,
+        std::shared_ptr<OAuthClient> oauth_client = nullptr
     );
 
+    /**
+     * Startup self-test (see common::Warmup)
+     *
+     * Issues and validates an access token, and validates an API key that
+     * no one holds, so the JWT keys, the blacklist check and the API key
+     * lookup have all run once before the first request. The API key cache
+     * is keyed by digests of presented keys, so it cannot be filled ahead.
+     *
+     * @throws std::runtime_error if a self-test fails
+     */
+    void WarmUp();
+
+    /**
+     * Sign new tokens with a rotated key pair
+     *
+     * The validator switches first and still accepts tokens signed with
+     * the previous key, so tokens issued before the call stay valid.
+     *
+     * @throws std::invalid_argument if a key cannot be parsed; the
+     *         current keys then stay in use
+     */
+    void RotateJwtKeys(const std::string& jwt_public_key, const std::string& jwt_private_key);
+
     // RPC method implementations
     grpc::Status Login(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const LoginRequest* request,
         LoginResponse* response
-    ) override;
+    );
 
     grpc::Status Logout(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const LogoutRequest* request,
         LogoutResponse* response
-    ) override;
+    );
 
     grpc::Status RefreshToken(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const RefreshTokenRequest* request,
         RefreshTokenResponse* response
-    ) override;
+    );
 
     grpc::Status ValidateToken(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const ValidateTokenRequest* request,
         ValidateTokenResponse* response
-    ) override;
+    );
 
     grpc::Status CreateApiKey(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const CreateApiKeyRequest* request,
         CreateApiKeyResponse* response
-    ) override;
+    );
 
     grpc::Status RevokeApiKey(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const RevokeApiKeyRequest* request,
         RevokeApiKeyResponse* response
-    ) override;
+    );
 
     // 2FA / TOTP methods
     grpc::Status EnrollTOTP(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const EnrollTOTPRequest* request,
         EnrollTOTPResponse* response
-    ) override;
+    );
 
     grpc::Status VerifyTOTP(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const VerifyTOTPRequest* request,
         VerifyTOTPResponse* response
-    ) override;
+    );
 
     grpc::Status DisableTOTP(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const DisableTOTPRequest* request,
         DisableTOTPResponse* response
-    ) override;
+    );
 
     grpc::Status GenerateBackupCodes(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const GenerateBackupCodesRequest* request,
         GenerateBackupCodesResponse* response
-    ) override;
+    );
 
     // OTP methods
     grpc::Status SendOTP(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const SendOTPRequest* request,
         SendOTPResponse* response
-    ) override;
+    );
 
     grpc::Status VerifyOTP(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const VerifyOTPRequest* request,
         VerifyOTPResponse* response
-    ) override;
+    );
 
     // OAuth methods
     grpc::Status InitiateOAuth(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const InitiateOAuthRequest* request,
         InitiateOAuthResponse* response
-    ) override;
+    );
 
     grpc::Status HandleOAuthCallback(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const OAuthCallbackRequest* request,
         OAuthCallbackResponse* response
-    ) override;
+    );
 
     // API Key validation with scopes
     grpc::Status ValidateApiKey(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const ValidateApiKeyRequest* request,
         ValidateApiKeyResponse* response
-    ) override;
+    );
+
+    // Batch of ValidateToken / ValidateApiKey checks; duplicates verified once, cache misses share one connection
+    grpc::Status ValidateBatch(
+        grpc::ServerContextBase* context,
+        const ValidateBatchRequest* request,
+        ValidateBatchResponse* response
+    );
+
+    // Session management: "log out everywhere" and the admin tenant-wide revocation
+    grpc::Status RevokeAllSessions(
+        grpc::ServerContextBase* context,
+        const RevokeAllSessionsRequest* request,
+        RevokeAllSessionsResponse* response
+    );
+
+    grpc::Status RevokeTenantSessions(
+        grpc::ServerContextBase* context,
+        const RevokeTenantSessionsRequest* request,
+        RevokeTenantSessionsResponse* response
+    );
 
 private:
     std::shared_ptr<common::RedisClient> redis_client_;
+    std::shared_ptr<common::EventBus> event_bus_;   // Cache invalidations between replicas
     std::shared_ptr<common::DbPool> db_pool_;
     std::shared_ptr<common::JwtValidator> jwt_validator_;
-    std::string jwt_private_key_;
+    RefreshTokenStore refresh_tokens_;   // Shares jwt_validator_'s tenant revocations
+    common::JwtSigner jwt_signer_;
+    std::string api_key_pepper_;
+    bool allow_legacy_api_key_scan_;
+    std::shared_ptr<common::PasswordHashingPool> password_hashing_pool_;
+    std::shared_ptr<ApiKeyCache> api_key_cache_;
+    std::shared_ptr<OAuthClient> oauth_client_;   // Providers without credentials keep the development mock
+    std::unique_ptr<common::RateLimiter> login_rate_limiter_;
+    std::unique_ptr<common::RateLimiter> otp_rate_limiter_;
+    std::unique_ptr<common::RateLimiter> legacy_scan_rate_limiter_;   // Per caller (gRPC peer)
 
     // Helper methods
     std::string GenerateAccessToken(const std::string& user_id, const std::string& tenant_id,
-                                    const std::string& email, const std::vector<std::string>& roles);
-    std::string GenerateRefreshToken(const std::string& user_id);
+                                    const std::string& email, const std::vector<std::string>& roles,
+                                    const AccessTokenId& id);
+    // RefreshToken for "user_id:random" tokens issued before refresh-token families; migrates them
+    grpc::Status RefreshLegacyToken(const std::string& refresh_token, RefreshTokenResponse* response);
     bool VerifyPassword(const std::string& password, const std::string& hashed_password);
     std::string HashPassword(const std::string& password);
-
-    // Rate limiting helper
-    bool CheckRateLimit(const std::string& key, int max_attempts, int window_seconds);
-
-    // Scope validation helper (wildcard support for API keys)
-    bool ValidateScope(const std::vector<std::string>& granted_scopes, const std::string& requested_scope);
+    // Replace a hash weaker than the current PasswordHashPolicy, as background work after Login answers
+    void RehashPasswordLater(const std::string& user_id, const std::string& email, const std::string& password,
+                             const std::string& old_hash);
+
+    // Whether the user holds the admin role in the tenant (user_roles on the primary)
+    bool IsTenantAdmin(const std::string& user_id, const std::string& tenant_id);
+
+    // Rate limiting helper (fails open if Redis is unavailable)
+    bool CheckRateLimit(common::RateLimiter& limiter, const std::string& key);
+
+    // API key lookup: one index probe on key_id, legacy Argon2 keys rehashed on first use
+    // (only with allow_legacy_api_key_scan, rate limited per caller, misses cached)
+    static constexpr std::chrono::minutes LEGACY_SCAN_MISS_TTL{10};
+    std::optional<ApiKeyEntry> LookupApiKey(pqxx::work& txn, const std::string& api_key,
+                                            const std::string& caller);
+    std::optional<ApiKeyEntry> MigrateLegacyApiKey(pqxx::work& txn, const std::string& api_key,
+                                                   const std::string& legacy_key_id, const std::string& caller);
+    static ApiKeyEntry ApiKeyEntryFromRow(const pqxx::row& row);
+
+    // Record a user's accepted TOTP time step in Redis; false if it (or a later one) was used
+    bool ConsumeTotpStep(const std::string& user_id, uint64_t step);
 
     // OTP generation and storage
     std::string GenerateOTP();
@@ -0,0 +1,221 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description OAuth 2 / OpenID Connect client: cached discovery and JWKS, pooled provider connections
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <jwt-cpp/jwt.h>
+
+namespace saasforge {
+namespace auth {
+
+/**
+ * One identity provider
+ *
+ * OpenID Connect providers set discovery_url; their endpoints, issuer
+ * and keys come from the discovery document. Plain OAuth 2 providers
+ * (GitHub) set the endpoints and read the identity from userinfo_endpoint.
+ */
+struct OAuthProviderConfig {
+    std::string name;                       // "google", "github", "microsoft"
+    std::string client_id;
+    std::string client_secret;
+    std::string scopes;                     // Space separated
+    std::string discovery_url;              // Empty: plain OAuth 2
+    std::string authorization_endpoint;     // Plain OAuth 2 only
+    std::string token_endpoint;             // Plain OAuth 2 only
+    std::string userinfo_endpoint;          // Plain OAuth 2 only
+    std::string emails_endpoint;            // Plain OAuth 2 only; read when the user info has no email
+
+    bool Oidc() const { return !discovery_url.empty(); }
+};
+
+/**
+ * OAuth client options
+ *
+ * FromEnv() reads OAUTH_METADATA_REFRESH_S, OAUTH_UNKNOWN_KID_REFRESH_S,
+ * OAUTH_CONNECT_TIMEOUT_MS and OAUTH_REQUEST_TIMEOUT_MS, and configures
+ * google, github and microsoft from OAUTH_<PROVIDER>_CLIENT_ID and
+ * OAUTH_<PROVIDER>_CLIENT_SECRET. Providers without a client id are left
+ * out (the auth service then keeps its development mock for them).
+ * OAUTH_MICROSOFT_TENANT narrows Microsoft from "common" to one directory.
+ */
+struct OAuthClientOptions {
+    std::vector<OAuthProviderConfig> providers;
+    std::chrono::seconds metadata_refresh{3600};        // Background reload of discovery documents and keys
+    std::chrono::seconds unknown_kid_refresh{60};       // At most one key reload per provider this often
+    std::chrono::milliseconds connect_timeout{3000};
+    std::chrono::milliseconds request_timeout{5000};
+    std::chrono::seconds clock_leeway{60};              // For exp / iat / nbf of id tokens
+
+    static OAuthClientOptions FromEnv();
+};
+
+struct OAuthHttpResponse {
+    long status = 0;            // 0: transport failure
+    std::string body;
+    std::string error;
+};
+
+/**
+ * HTTP calls to providers
+ *
+ * Curl() keeps connections, DNS entries and TLS sessions in one shared
+ * cache, so after the first login (or WarmUp) a token exchange reuses the
+ * provider's open connection instead of a TCP and TLS handshake.
+ */
+struct OAuthHttp {
+    std::function<OAuthHttpResponse(const std::string& url, const std::vector<std::string>& headers)> get;
+    std::function<OAuthHttpResponse(const std::string& url, const std::string& form,
+                                    const std::vector<std::string>& headers)> post;
+
+    static OAuthHttp Curl(const OAuthClientOptions& options);
+};
+
+/**
+ * The user a provider vouched for
+ */
+struct OAuthIdentity {
+    std::string provider_user_id;   // OIDC "sub", GitHub user id
+    std::string email;
+    bool email_verified = false;    // Required to create an account from the email
+};
+
+struct OAuthClientStats {
+    uint64_t exchanges = 0;         // Codes exchanged for a verified identity
+    uint64_t rejected = 0;          // Codes or id tokens the provider or the checks refused
+    uint64_t metadata_loads = 0;    // Discovery documents and key sets fetched
+    uint64_t metadata_failures = 0;
+};
+
+/**
+ * OAuth / OIDC client for social login
+ *
+ * Discovery documents and parsed JWKS keys are cached per provider and
+ * reloaded every metadata_refresh by a background thread (failures keep
+ * the previous copy); an id token signed with a key id not in the cache
+ * reloads the keys at once, at most every unknown_kid_refresh. A login
+ * is then one token endpoint POST plus local id token verification
+ * (GitHub, which has no id token, adds its user API GET).
+ *
+ * Usage:
+ *   OAuthClient oauth(OAuthClientOptions::FromEnv());
+ *   std::string url = oauth.AuthorizationUrl("google", redirect_uri, state, nonce);
+ *   OAuthIdentity user = oauth.Exchange("google", code, redirect_uri, nonce);
+ */
+class OAuthClient {
+public:
+    /// @param http Empty: OAuthHttp::Curl(options)
+    explicit OAuthClient(OAuthClientOptions options, OAuthHttp http = {});
+    ~OAuthClient();
+
+    OAuthClient(const OAuthClient&) = delete;
+    OAuthClient& operator=(const OAuthClient&) = delete;
+
+    bool Configured(const std::string& provider) const;
+
+    /**
+     * Load every provider's discovery document and keys (see common::Warmup)
+     *
+     * Opens the provider connections as a side effect.
+     *
+     * @throws std::runtime_error naming the providers that failed; the
+     *         others are loaded and the failed ones are retried on use
+     */
+    void WarmUp();
+
+    /**
+     * Authorization URL to redirect the user to
+     *
+     * @param nonce Bound into the OIDC id token; checked by Exchange()
+     * @throws std::invalid_argument if the provider is not configured
+     * @throws std::runtime_error if its discovery document cannot be loaded
+     */
+    std::string AuthorizationUrl(const std::string& provider, const std::string& redirect_uri,
+                                 const std::string& state, const std::string& nonce);
+
+    /**
+     * Exchange an authorization code for the user's identity
+     *
+     * OIDC id tokens are checked for signature, issuer, audience (our
+     * client id), expiry and nonce.
+     *
+     * @throws std::invalid_argument if the provider is not configured, or
+     *         it refused the code, or the id token fails a check
+     * @throws std::runtime_error if the provider cannot be reached
+     */
+    OAuthIdentity Exchange(const std::string& provider, const std::string& code, const std::string& redirect_uri,
+                           const std::string& nonce);
+
+    /// Stop the refresh thread (idempotent)
+    void Shutdown();
+
+    OAuthClientStats GetStats() const;
+
+    static std::string FormEncode(const std::vector<std::pair<std::string, std::string>>& params);
+
+private:
+    using Verifier = jwt::verifier<jwt::default_clock, jwt::traits::kazuho_picojson>;
+
+    // Immutable once published; replaced whole on reload
+    struct Metadata {
+        std::string authorization_endpoint;
+        std::string token_endpoint;
+        std::string userinfo_endpoint;
+        std::string issuer;             // May hold "{tenantid}" (Microsoft multi-tenant)
+        std::string jwks_uri;
+        std::unordered_map<std::string, std::shared_ptr<const Verifier>> keys;   // By kid
+        std::chrono::steady_clock::time_point keys_loaded{};
+    };
+
+    struct Provider {
+        OAuthProviderConfig config;
+        std::mutex load_mutex;          // One reload at a time; readers never wait on it
+        std::shared_ptr<const Metadata> metadata;   // Guarded by metadata_mutex_
+    };
+
+    Provider& Find(const std::string& provider) const;
+    std::shared_ptr<const Metadata> Current(Provider& provider) const;
+    // Cached metadata, loaded first if none is
+    std::shared_ptr<const Metadata> Load(Provider& provider);
+    // Fetch the discovery document (OIDC) and keys; keep_discovery reuses the cached endpoints
+    std::shared_ptr<const Metadata> Reload(Provider& provider, bool keep_discovery);
+    std::unordered_map<std::string, std::shared_ptr<const Verifier>> FetchKeys(const Provider& provider,
+                                                                               const std::string& jwks_uri);
+    OAuthIdentity VerifyIdToken(Provider& provider, std::shared_ptr<const Metadata> metadata,
+                                const std::string& id_token, const std::string& nonce);
+    OAuthIdentity FetchUserInfo(const Provider& provider, const Metadata& metadata, const std::string& access_token);
+    void RefreshLoop();
+
+    OAuthClientOptions options_;
+    OAuthHttp http_;
+    std::unordered_map<std::string, std::unique_ptr<Provider>> providers_;
+    mutable std::mutex metadata_mutex_;
+
+    std::atomic<uint64_t> exchanges_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> metadata_loads_{0};
+    std::atomic<uint64_t> metadata_failures_{0};
+    uint64_t metrics_collector_ = 0;
+
+    std::mutex refresh_mutex_;
+    std::condition_variable refresh_cv_;
+    bool stopping_ = false;
+    std::thread refresh_thread_;
+};
+
+} // namespace auth
+} // namespace saasforge
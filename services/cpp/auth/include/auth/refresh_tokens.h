@@ -0,0 +1,147 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Refresh-token families in Redis: one-round-trip rotation, reuse detection and bulk revocation
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common/redis_client.h"
+#include "common/tenant_revocations.h"
+
+namespace saasforge {
+namespace auth {
+
+/**
+ * User claims cached with a family, so a refresh mints the access token
+ * without reading the users row
+ */
+struct RefreshClaims {
+    std::string tenant_id;
+    std::string email;
+    std::vector<std::string> roles;
+    int64_t checked_at = 0;   // Unix seconds the claims were last read from the database
+};
+
+/**
+ * Parts of a refresh token: "<user_id>:<family_id>:<secret>"
+ */
+struct RefreshTokenParts {
+    std::string user_id;
+    std::string family_id;
+    std::string secret;
+
+    /// nullopt for anything else, including the old "<user_id>:<secret>" tokens
+    static std::optional<RefreshTokenParts> Parse(std::string_view token);
+};
+
+/**
+ * Access token minted with a refresh token; blacklisted when its family is revoked
+ */
+struct AccessTokenId {
+    std::string jti;
+    int64_t exp = 0;   // Unix seconds
+};
+
+enum class RefreshResult {
+    ROTATED,   // Token was current; its successor is returned
+    MISSING,   // Unknown, expired or revoked family (including tenant-wide revocations)
+    REUSED     // A superseded token of the family: every family of the user was revoked
+};
+
+struct RefreshRotation {
+    RefreshResult result = RefreshResult::MISSING;
+    std::string token;        // Successor (ROTATED only)
+    RefreshClaims claims;     // Cached claims (ROTATED only)
+};
+
+struct TenantRevocation {
+    int64_t revoked_at = 0;       // Unix ms; sessions started up to then are revoked
+    int64_t affected_users = 0;   // Users of the tenant signed in within TTL_SECONDS
+};
+
+/**
+ * Refresh-token families: the auth service's session store
+ *
+ * Each login starts a family (one session): a Redis hash holding the
+ * SHA-256 of the family's current token, the user's claims and the jti of
+ * the access token last minted with it. Rotate() is a single Lua call that
+ * checks the presented token, swaps in the successor and returns the
+ * claims, so a refresh costs one round trip and no database read.
+ *
+ * Presenting a token the family has already moved past means it was
+ * copied: Rotate() then revokes every family of the user, logging out
+ * both the thief and the victim. All of a user's keys share the
+ * "{user_id}" hash tag, so the scripts run on one cluster node; each
+ * script gets every key it touches in KEYS.
+ *
+ * Indexes are sorted sets scored by expiry and trimmed lazily, on write:
+ * per user its families (RevokeAll(): "log out everywhere", a script
+ * listing them, one revoking them with their keys in KEYS and a pipelined
+ * blacklist write), per tenant the users that signed
+ * in within TTL_SECONDS. RevokeTenant() does not walk either: it records a
+ * TenantRevocations epoch, which access-token validation and Rotate()
+ * check in memory, and drops the tenant index. Families it covers are
+ * deleted when next presented, or expire.
+ *
+ * Keys:
+ *   refresh:{user_id}:<family_id>   hash: current, tenant_id, email, roles, checked_at,
+ *                                   issued_at (ms), jti, jti_exp
+ *   refresh:{user_id}:families      sorted set: family id -> expiry (Unix seconds)
+ *   sessions:tenant:{tenant_id}     sorted set: user id -> expiry of their newest family
+ *
+ * Usage:
+ *   RefreshTokenStore store(redis_client, revocations);
+ *   std::string token = store.Issue(user_id, claims, access);   // Login
+ *   auto rotation = store.Rotate(presented_token, access);      // RefreshToken
+ *   store.Revoke(presented_token);                              // Logout
+ *   store.RevokeAll(user_id);                                   // Log out everywhere
+ */
+class RefreshTokenStore {
+public:
+    /// Families expire this long after their last rotation
+    static constexpr int64_t TTL_SECONDS = 30 * 24 * 3600;
+
+    /// revocations may be null: RevokeTenant() then only affects this process
+    explicit RefreshTokenStore(std::shared_ptr<common::RedisClient> redis_client,
+                               std::shared_ptr<common::TenantRevocations> revocations = nullptr);
+
+    /// Start a family and return its first token
+    std::string Issue(const std::string& user_id, const RefreshClaims& claims, const AccessTokenId& access);
+
+    /// Rotate a token (see RefreshResult); malformed tokens are MISSING.
+    /// access is the token about to be minted from the returned claims.
+    RefreshRotation Rotate(std::string_view token, const AccessTokenId& access);
+
+    /// Replace the cached claims after re-reading them; no-op if the family is gone
+    void UpdateClaims(std::string_view token, const RefreshClaims& claims);
+
+    /// Whether the token is the current one of a live family
+    bool IsCurrent(std::string_view token);
+
+    /// End the token's family (Logout)
+    void Revoke(std::string_view token);
+
+    /// End every family of the user and blacklist their access tokens; returns the number of families
+    int64_t RevokeAll(const std::string& user_id);
+
+    /// End every session of the tenant started until now
+    TenantRevocation RevokeTenant(const std::string& tenant_id);
+
+private:
+    // Blacklist the still-valid tokens of a flat {jti, exp, ...} script reply, from index first
+    void BlacklistAccessTokens(const std::vector<std::optional<std::string>>& reply, size_t first);
+
+    std::shared_ptr<common::RedisClient> redis_client_;
+    std::shared_ptr<common::TenantRevocations> revocations_;
+};
+
+} // namespace auth
+} // namespace saasforge
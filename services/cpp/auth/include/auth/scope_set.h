@@ -0,0 +1,61 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description API key scopes compiled for constant-time checks (Requirement A-14)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace saasforge {
+namespace auth {
+
+/**
+ * A key's granted scopes, compiled once at creation or cache fill
+ *
+ * Exact scopes ("read:upload") are interned to process-wide ids and kept as
+ * a bitset, so checking one is a hash lookup plus a bit test. Wildcards
+ * ("payments:*", "*") are kept in a small byte trie, walked once per check.
+ *
+ * Semantics match the original string matcher: a trailing '*' grants every
+ * scope with that prefix, a '*' anywhere else is literal, and matching is
+ * case- and whitespace-sensitive.
+ *
+ * Usage:
+ *   ScopeSet scopes = ScopeSet::Compile({"read:*", "write:upload"});
+ *   if (scopes.Allows(requested_scope)) { ... }
+ */
+class ScopeSet {
+public:
+    /// Interned ids beyond this go to the trie, bounding each bitset to 512 bytes
+    static constexpr uint32_t MAX_INTERNED = 4096;
+
+    ScopeSet() = default;
+
+    static ScopeSet Compile(const std::vector<std::string>& scopes);
+
+    /// Whether the granted scopes cover the requested one (deny by default)
+    bool Allows(std::string_view requested_scope) const;
+
+    bool Empty() const { return bits_.empty() && nodes_.empty(); }
+
+private:
+    struct Node {
+        std::vector<std::pair<char, uint32_t>> children;  // Sorted by byte
+        bool prefix = false;   // A wildcard ends here: anything below matches
+        bool exact = false;    // An exact scope ends here (not interned)
+    };
+
+    void Insert(std::string_view scope, bool wildcard);
+    bool TestBit(uint32_t id) const;
+
+    std::vector<uint64_t> bits_;   // Indexed by interned id
+    std::vector<Node> nodes_;      // nodes_[0] is the root, when present
+};
+
+} // namespace auth
+} // namespace saasforge
@@ -0,0 +1,130 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-process cache of verified API keys implementation
+ */
+
+#include "auth/api_key_cache.h"
+#include <algorithm>
+#include <ctime>
+#include <functional>
+
+namespace saasforge {
+namespace auth {
+
+ApiKeyCache::ApiKeyCache(std::chrono::seconds ttl, size_t max_entries, size_t num_shards)
+    : ttl_(ttl) {
+    num_shards = std::max<size_t>(num_shards, 1);
+    max_entries_per_shard_ = std::max<size_t>(max_entries / num_shards, 1);
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+}
+
+std::optional<ApiKeyEntry> ApiKeyCache::Get(const std::string& digest) {
+    auto& shard = ShardFor(digest);
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(digest);
+    if (it == shard.entries.end()) {
+        return std::nullopt;
+    }
+    if (it->second.expires_at <= now) {
+        shard.digest_by_id.erase(it->second.entry.key_id);
+        shard.entries.erase(it);
+        return std::nullopt;
+    }
+    return it->second.entry;
+}
+
+void ApiKeyCache::Put(const std::string& digest, const ApiKeyEntry& entry, uint64_t generation) {
+    auto now = std::chrono::steady_clock::now();
+    auto expires_at = now + ttl_;
+
+    // Never cache past the key's own expiry
+    if (entry.expires_at > 0) {
+        auto remaining = std::chrono::seconds(entry.expires_at - static_cast<int64_t>(std::time(nullptr)));
+        if (remaining <= std::chrono::seconds::zero()) {
+            return;
+        }
+        expires_at = std::min(expires_at, now + remaining);
+    }
+
+    auto& shard = ShardFor(digest);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    if (generation != generation_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    if (shard.entries.find(digest) == shard.entries.end() &&
+        shard.entries.size() >= max_entries_per_shard_) {
+        EvictOne(shard, now);
+    }
+
+    shard.entries[digest] = CachedEntry{entry, expires_at};
+    shard.digest_by_id[entry.key_id] = digest;
+}
+
+void ApiKeyCache::InvalidateByKeyId(const std::string& key_id) {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+
+    // key_id does not determine the shard, so visit each one
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        auto it = shard->digest_by_id.find(key_id);
+        if (it != shard->digest_by_id.end()) {
+            shard->entries.erase(it->second);
+            shard->digest_by_id.erase(it);
+        }
+    }
+}
+
+void ApiKeyCache::Clear() {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->digest_by_id.clear();
+    }
+}
+
+size_t ApiKeyCache::Size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->entries.size();
+    }
+    return total;
+}
+
+ApiKeyCache::Shard& ApiKeyCache::ShardFor(const std::string& digest) {
+    return *shards_[std::hash<std::string>{}(digest) % shards_.size()];
+}
+
+void ApiKeyCache::EvictOne(Shard& shard, std::chrono::steady_clock::time_point now) {
+    // Sampled eviction: inspect a few entries, drop an expired one or the one
+    // closest to expiry. Avoids a full shard scan on every insert when full.
+    constexpr size_t EVICTION_SAMPLES = 8;
+
+    auto victim = shard.entries.begin();
+    size_t sampled = 0;
+    for (auto it = shard.entries.begin(); it != shard.entries.end() && sampled < EVICTION_SAMPLES; ++it, ++sampled) {
+        if (it->second.expires_at <= now) {
+            victim = it;
+            break;
+        }
+        if (it->second.expires_at < victim->second.expires_at) {
+            victim = it;
+        }
+    }
+    if (victim != shard.entries.end()) {
+        shard.digest_by_id.erase(victim->second.entry.key_id);
+        shard.entries.erase(victim);
+    }
+}
+
+} // namespace auth
+} // namespace saasforge
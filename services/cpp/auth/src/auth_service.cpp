@@ -1,32 +1,326 @@
 #include "auth/auth_service.h"
 #include "common/tenant_context.h"
 #include "common/password_hasher.h"
+#include "common/password_hashing_pool.h"
+#include "common/api_key_hasher.h"
+#include "common/codec.h"
+#include "common/executor.h"
+#include "common/metrics.h"
 #include "common/totp_helper.h"
+#include "common/statement_registry.h"
+#include "common/string_builder.h"
+#include "common/logger.h"
 #include <jwt-cpp/jwt.h>
 #include <iomanip>
 #include <sstream>
 #include <chrono>
+#include <optional>
 #include <random>
-#include <iostream>
+#include <unordered_map>
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
 
 namespace saasforge {
 namespace auth {
 
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+// Everything a login checks, in one round trip: the user, its TOTP secret
+// and the unused backup code whose hash is $2 ('' when no code was sent),
+// by idx_backup_codes_user_hash
+const common::PreparedStatement kLoginSelectUser(
+    "auth_login_select_user",
+    "SELECT u.id, u.tenant_id, u.email, u.password_hash, u.totp_secret, "
+    "(SELECT b.id FROM backup_codes b "
+    " WHERE b.user_id = u.id AND b.code_hash = $2 AND b.used_at IS NULL LIMIT 1) AS backup_code_id "
+    "FROM users u WHERE u.email = $1 AND u.deleted_at IS NULL");
+
+// Consumes a backup code found by kLoginSelectUser, unless another login
+// got there first (or the replica it was read from lagged)
+const common::PreparedStatement kUseBackupCode(
+    "auth_use_backup_code",
+    "UPDATE backup_codes SET used_at = NOW() "
+    "WHERE id = $1 AND used_at IS NULL "
+    "RETURNING 1");
+
+const common::PreparedStatement kRefreshSelectUser(
+    "auth_refresh_select_user",
+    "SELECT id, tenant_id, email FROM users WHERE id = $1 AND deleted_at IS NULL");
+
+const common::PreparedStatement kInsertApiKey(
+    "auth_insert_api_key",
+    "INSERT INTO api_keys (user_id, tenant_id, key_id, key_prefix, key_hash, hash_scheme, name, scopes, expires_at) "
+    "VALUES ($1, $2, $3, $4, $5, $6, $7, $8::text[], NOW() + INTERVAL '1 year') "
+    "RETURNING id, created_at");
+
+const common::PreparedStatement kRevokeApiKey(
+    "auth_revoke_api_key",
+    "UPDATE api_keys SET revoked_at = NOW() "
+    "WHERE id = $1 AND user_id = $2 AND tenant_id = $3 AND revoked_at IS NULL");
+
+// Secret and backup codes in one statement (one round trip, run without
+// BEGIN/COMMIT: a single statement is atomic); no row if the user is gone
+const common::PreparedStatement kEnrollTotp(
+    "auth_enroll_totp",
+    "WITH enrolled AS ("
+    "  UPDATE users SET totp_secret = $1, totp_enrolled_at = NOW() WHERE id = $2 "
+    "  RETURNING id, email"
+    "), codes AS ("
+    "  INSERT INTO backup_codes (user_id, code_hash) "
+    "  SELECT enrolled.id, code_hash FROM enrolled, unnest($3::text[]) AS t(code_hash) "
+    "  RETURNING 1"
+    ") "
+    "SELECT email FROM enrolled");
+
+// The DELETE sees only the codes from before the statement, not the new ones
+const common::PreparedStatement kReplaceBackupCodes(
+    "auth_replace_backup_codes",
+    "WITH removed AS ("
+    "  DELETE FROM backup_codes WHERE user_id = $1"
+    ") "
+    "INSERT INTO backup_codes (user_id, code_hash) "
+    "SELECT $1, code_hash FROM unnest($2::text[]) AS t(code_hash)");
+
+const common::PreparedStatement kSelectTotpSecret(
+    "auth_select_totp_secret",
+    "SELECT totp_secret FROM users WHERE id = $1");
+
+const common::PreparedStatement kSelectPasswordHash(
+    "auth_select_password_hash",
+    "SELECT password_hash FROM users WHERE id = $1");
+
+// Only if the hash is still the one verified: a password change meanwhile wins
+const common::PreparedStatement kRehashPassword(
+    "auth_rehash_password",
+    "UPDATE users SET password_hash = $1 WHERE id = $2 AND password_hash = $3");
+
+const common::PreparedStatement kClearTotpSecret(
+    "auth_clear_totp_secret",
+    "UPDATE users SET totp_secret = NULL, totp_enrolled_at = NULL WHERE id = $1");
+
+const common::PreparedStatement kDeleteBackupCodes(
+    "auth_delete_backup_codes",
+    "DELETE FROM backup_codes WHERE user_id = $1");
+
+const common::PreparedStatement kOauthSelectUser(
+    "auth_oauth_select_user",
+    "SELECT u.id, u.tenant_id, u.email FROM users u "
+    "JOIN oauth_accounts oa ON u.id = oa.user_id "
+    "WHERE oa.provider = $1 AND oa.provider_user_id = $2");
+
+const common::PreparedStatement kOauthInsertUser(
+    "auth_oauth_insert_user",
+    "INSERT INTO users (tenant_id, email, password_hash) "
+    "VALUES ($1, $2, NULL) RETURNING id");
+
+const common::PreparedStatement kOauthInsertAccount(
+    "auth_oauth_insert_account",
+    "INSERT INTO oauth_accounts (user_id, provider, provider_user_id) "
+    "VALUES ($1, $2, $3)");
+
+// The admin role (system-wide or the tenant's own) held by a live member of the tenant
+const common::PreparedStatement kSelectTenantAdmin(
+    "auth_select_tenant_admin",
+    "SELECT 1 FROM users u "
+    "JOIN user_roles ur ON ur.user_id = u.id "
+    "JOIN roles r ON r.id = ur.role_id "
+    "WHERE u.id = $1 AND u.tenant_id = $2 AND u.deleted_at IS NULL "
+    "AND r.name = 'admin' AND (r.tenant_id IS NULL OR r.tenant_id = u.tenant_id) "
+    "LIMIT 1");
+
+const common::PreparedStatement kLookupApiKey(
+    "auth_lookup_api_key",
+    "SELECT id, user_id, tenant_id, key_hash, scopes, "
+    "COALESCE(EXTRACT(EPOCH FROM expires_at)::bigint, 0) AS expires_at "
+    "FROM api_keys "
+    "WHERE key_id = $1 AND hash_scheme = $2 AND revoked_at IS NULL "
+    "AND (expires_at IS NULL OR expires_at > NOW())");
+
+const common::PreparedStatement kScanLegacyApiKeys(
+    "auth_scan_legacy_api_keys",
+    "SELECT id, user_id, tenant_id, key_hash, scopes, "
+    "COALESCE(EXTRACT(EPOCH FROM expires_at)::bigint, 0) AS expires_at "
+    "FROM api_keys "
+    "WHERE key_id IS NULL AND hash_scheme = $1 AND revoked_at IS NULL "
+    "AND (expires_at IS NULL OR expires_at > NOW())");
+
+const common::PreparedStatement kRehashLegacyApiKey(
+    "auth_rehash_legacy_api_key",
+    "UPDATE api_keys SET key_id = $1, key_hash = $2, hash_scheme = $3 WHERE id = $4");
+
+/// Array literal of the codes' hashes, for kEnrollTotp and kReplaceBackupCodes
+std::string HashBackupCodes(const std::vector<std::string>& codes) {
+    std::vector<std::string> hashes;
+    hashes.reserve(codes.size());
+    for (const auto& code : codes) {
+        hashes.push_back(common::TotpHelper::HashBackupCode(code));
+    }
+    return common::ToArrayLiteral(hashes);
+}
+
+// Claims cached in a refresh-token family are re-read from users after this long
+constexpr int64_t REFRESH_CLAIMS_MAX_AGE_SEC = 3600;
+
+int64_t UnixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// ValidateBatch request limit, so one call cannot hold a connection for long
+constexpr int MAX_VALIDATE_BATCH = 256;
+
+// Access tokens live 15 minutes
+constexpr int64_t ACCESS_TOKEN_TTL_SEC = 900;
+
+AccessTokenId NewAccessTokenId() {
+    return {common::RandomHex(16), UnixNow() + ACCESS_TOKEN_TTL_SEC};
+}
+
+/// Value of "oauth:state:<state>": "<provider>\n<nonce>\n<redirect_uri>", or the provider alone (mock)
+struct OAuthState {
+    std::string provider;
+    std::string nonce;
+    std::string redirect_uri;
+    bool mock = true;
+
+    static OAuthState Parse(const std::string& value) {
+        OAuthState state;
+        size_t first = value.find('\n');
+        state.provider = value.substr(0, first);
+        if (first != std::string::npos) {
+            size_t second = value.find('\n', first + 1);
+            if (second != std::string::npos) {
+                state.nonce = value.substr(first + 1, second - first - 1);
+                state.redirect_uri = value.substr(second + 1);
+                state.mock = false;
+            }
+        }
+        return state;
+    }
+};
+
+} // namespace
+
 AuthServiceImpl::AuthServiceImpl(
     std::shared_ptr<common::RedisClient> redis_client,
     std::shared_ptr<common::DbPool> db_pool,
     const std::string& jwt_public_key,
-    const std::string& jwt_private_key
+    const std::string& jwt_private_key,
+    const std::string& api_key_pepper,
+    bool allow_legacy_api_key_scan,
+    std::shared_ptr<common::PasswordHashingPool> password_hashing_pool,
+    std::shared_ptr<OAuthClient> oauth_client
 ) : redis_client_(redis_client),
     db_pool_(db_pool),
-    jwt_validator_(std::make_shared<common::JwtValidator>(jwt_public_key, redis_client)),
-    jwt_private_key_(jwt_private_key) {
-    std::cout << "AuthService initialized" << std::endl;
+    jwt_validator_(std::make_shared<common::JwtValidator>(
+        jwt_public_key, redis_client, common::JwtValidatorOptions::FromEnv())),
+    refresh_tokens_(redis_client, jwt_validator_->Revocations()),
+    jwt_signer_(jwt_private_key),
+    api_key_pepper_(api_key_pepper),
+    allow_legacy_api_key_scan_(allow_legacy_api_key_scan),
+    password_hashing_pool_(password_hashing_pool),
+    oauth_client_(oauth_client ? oauth_client : std::make_shared<OAuthClient>(OAuthClientOptions::FromEnv())) {
+    if (!password_hashing_pool_) {
+        password_hashing_pool_ = std::make_shared<common::PasswordHashingPool>();
+    }
+
+    // A known pepper would let anyone holding the digests brute-force keys offline
+    if (api_key_pepper_.empty()) {
+        throw std::invalid_argument("API_KEY_PEPPER is required");
+    }
+
+    // Revocations published by any replica evict the key from this replica's cache.
+    // Events may have been missed when the bus resets its group, so the cache is flushed then.
+    event_bus_ = std::make_shared<common::EventBus>(redis_client_, common::EventBusOptions::FromEnv());
+    api_key_cache_ = std::make_shared<ApiKeyCache>();
+    std::weak_ptr<ApiKeyCache> weak_cache = api_key_cache_;
+    event_bus_->Subscribe(
+        ApiKeyCache::REVOCATION_TOPIC,
+        [weak_cache](const std::string& key_id) {
+            if (auto cache = weak_cache.lock()) {
+                cache->InvalidateByKeyId(key_id);
+            }
+        },
+        [weak_cache]() {
+            if (auto cache = weak_cache.lock()) {
+                cache->Clear();
+            }
+        }
+    );
+
+    // Login brute-force protection: 10 attempts per email per 5 minutes, every attempt
+    // metered in Redis (a local allowance would grant it once per replica)
+    common::RateLimitPolicy login_policy;
+    login_policy.algorithm = common::RateLimitAlgorithm::SLIDING_WINDOW_LOG;
+    login_policy.limit = 10;
+    login_policy.window = std::chrono::minutes(5);
+    login_policy.local_allowance = 0;
+    login_rate_limiter_ = std::make_unique<common::RateLimiter>(redis_client_, "login", login_policy);
+
+    // 3 OTP requests per minute (Requirement A-7)
+    common::RateLimitPolicy otp_policy;
+    otp_policy.algorithm = common::RateLimitAlgorithm::SLIDING_WINDOW_LOG;
+    otp_policy.limit = 3;
+    otp_policy.window = std::chrono::seconds(60);
+    otp_policy.local_allowance = 0;
+    otp_rate_limiter_ = std::make_unique<common::RateLimiter>(redis_client_, "otp", otp_policy);
+
+    // Each legacy scan runs one Argon2 verify per unmigrated key: 5 per caller per minute
+    common::RateLimitPolicy legacy_scan_policy;
+    legacy_scan_policy.algorithm = common::RateLimitAlgorithm::SLIDING_WINDOW_LOG;
+    legacy_scan_policy.limit = 5;
+    legacy_scan_policy.window = std::chrono::seconds(60);
+    legacy_scan_rate_limiter_ =
+        std::make_unique<common::RateLimiter>(redis_client_, "api_key_legacy_scan", legacy_scan_policy);
+
+    common::LogInfo("AuthService initialized");
+}
+
+void AuthServiceImpl::WarmUp() {
+    std::string token = GenerateAccessToken(
+        "00000000-0000-0000-0000-000000000000", "00000000-0000-0000-0000-000000000000",
+        "warmup@saasforge.invalid", {}, NewAccessTokenId());
+    if (!jwt_validator_->Validate(token)) {
+        throw std::runtime_error("JWT self-test failed: an issued token did not validate");
+    }
+
+    ValidateApiKeyRequest request;
+    request.set_api_key("sk_" + std::string(common::ApiKeyHasher::KEY_ID_HEX_LENGTH, '0') + "_" +
+                        std::string(common::ApiKeyHasher::SECRET_HEX_LENGTH, '0'));
+    ValidateApiKeyResponse response;
+    grpc::Status status = ValidateApiKey(nullptr, &request, &response);
+    if (!status.ok()) {
+        throw std::runtime_error("API key self-test failed: " + status.error_message());
+    }
+}
+
+void AuthServiceImpl::RotateJwtKeys(const std::string& jwt_public_key, const std::string& jwt_private_key) {
+    // A mismatched pair would fail every token issued from here on; check it before switching
+    common::JwtSigner signer(jwt_private_key);
+    common::JwtValidatorOptions probe_options;
+    probe_options.cache_capacity = 0;
+    probe_options.blacklist_filter = false;
+    common::JwtValidator probe(jwt_public_key, nullptr, probe_options);
+    auto now = std::chrono::system_clock::now();
+    if (!probe.Validate(signer.Sign(jwt::create()
+            .set_issuer("saasforge")
+            .set_subject("key-rotation")
+            .set_issued_at(now)
+            .set_expires_at(now + std::chrono::minutes(1))
+            .set_id("key-rotation")
+            .set_payload_claim("tenant_id", jwt::claim(std::string()))
+            .set_payload_claim("email", jwt::claim(std::string()))))) {
+        throw std::invalid_argument("JWT public key does not match the private key");
+    }
+
+    jwt_validator_->RotatePublicKey(jwt_public_key);
+    jwt_signer_.Rotate(jwt_private_key);
+    common::LogInfo("JWT signing key rotated", {{"algorithm", common::JwtAlgorithmName(signer.Algorithm())}});
 }
 
 grpc::Status AuthServiceImpl::Login(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const LoginRequest* request,
     LoginResponse* response
 ) {
@@ -36,15 +330,26 @@ grpc::Status AuthServiceImpl::Login(
             return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Email and password required");
         }
 
-        // Query database for user
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        if (!CheckRateLimit(*login_rate_limiter_, request->email())) {
+            return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Too many login attempts. Please try again later.");
+        }
 
-        auto result = txn.exec_params(
-            "SELECT id, tenant_id, email, password_hash, totp_secret "
-            "FROM users WHERE email = $1 AND deleted_at IS NULL",
-            request->email()
-        );
+        // Query database for user, TOTP state and backup code: read-only, so a replica when
+        // configured. Keyed by email, so a TOTP or backup code change made through this
+        // service is read back from the primary. The connection is returned before the
+        // password is verified.
+        const std::string& totp_code = request->totp_code();
+        pqxx::result result;
+        {
+            auto conn_guard = db_pool_->AcquireReadConnection(__func__, request->email());
+            pqxx::read_transaction txn(*conn_guard);
+            result = common::ExecPrepared(
+                txn, kLoginSelectUser,
+                request->email(),
+                totp_code.empty() ? std::string() : common::TotpHelper::HashBackupCode(totp_code)
+            );
+            txn.commit();
+        }
 
         if (result.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid credentials");
@@ -54,6 +359,15 @@ grpc::Status AuthServiceImpl::Login(
         std::string user_id = row["id"].as<std::string>();
         std::string tenant_id = row["tenant_id"].as<std::string>();
         std::string email = row["email"].as<std::string>();
+        bool totp_enrolled = !row["totp_secret"].is_null();
+
+        // The TOTP code is checked here (no I/O), but its step is only recorded once the
+        // password is verified: otherwise a guessed code, without the password, would
+        // spend the user's current step and lock them out of it.
+        std::optional<uint64_t> totp_step;
+        if (totp_enrolled && !totp_code.empty()) {
+            totp_step = common::TotpHelper::VerifyCode(row["totp_secret"].as<std::string>(), totp_code);
+        }
 
         // SECURITY FIX: Handle OAuth-only users (NULL password_hash)
         // OAuth-only users must authenticate via OAuth flow, not password login
@@ -76,45 +390,35 @@ grpc::Status AuthServiceImpl::Login(
                 return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid credentials");
             }
         }
+        bool totp_step_fresh = totp_step && ConsumeTotpStep(user_id, *totp_step);
+        bool rehash = !password_hash.empty() && common::PasswordHasher::NeedsRehash(password_hash);
 
         // Handle 2FA if enabled
-        if (!row["totp_secret"].is_null()) {
-            std::string totp_secret = row["totp_secret"].as<std::string>();
-
-            if (!request->has_totp_code() || request->totp_code().empty()) {
+        if (totp_enrolled) {
+            if (totp_code.empty()) {
                 return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "TOTP code required");
             }
 
-            // Validate TOTP code
-            if (!common::TotpHelper::ValidateCode(totp_secret, request->totp_code())) {
-                // Check if it's a backup code
-                auto backup_result = txn.exec_params(
-                    "SELECT code_hash FROM backup_codes "
-                    "WHERE user_id = $1 AND used_at IS NULL",
-                    user_id
-                );
-
-                bool backup_valid = false;
-                std::string used_code_hash;
-
-                for (const auto& backup_row : backup_result) {
-                    std::string code_hash = backup_row["code_hash"].as<std::string>();
-                    if (common::TotpHelper::VerifyBackupCode(request->totp_code(), code_hash)) {
-                        backup_valid = true;
-                        used_code_hash = code_hash;
-                        break;
-                    }
+            // A step already used is refused before any backup code
+            if (totp_step && !totp_step_fresh) {
+                return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "TOTP code already used");
+            }
+            if (!totp_step) {
+                // A backup code: found by the query above, consumed on the primary by id
+                if (row["backup_code_id"].is_null()) {
+                    return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid TOTP code");
                 }
+                auto conn_guard = db_pool_->AcquireConnection(__func__);
+                pqxx::nontransaction txn(*conn_guard);
+                auto backup_result = common::ExecPrepared(
+                    txn, kUseBackupCode,
+                    row["backup_code_id"].as<std::string>()
+                );
 
-                if (backup_valid) {
-                    // Mark backup code as used
-                    txn.exec_params(
-                        "UPDATE backup_codes SET used_at = NOW() WHERE code_hash = $1",
-                        used_code_hash
-                    );
-                } else {
+                if (backup_result.empty()) {
                     return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid TOTP code");
                 }
+                db_pool_->RecordWrite(request->email());
             }
         }
 
@@ -122,28 +426,31 @@ grpc::Status AuthServiceImpl::Login(
         std::vector<std::string> roles;
 
         // Generate tokens
-        std::string access_token = GenerateAccessToken(user_id, tenant_id, email, roles);
-        std::string refresh_token = GenerateRefreshToken(user_id);
-
-        // Store refresh token in Redis (30 days TTL)
-        redis_client_->SetSession("refresh:" + user_id, refresh_token, 30 * 24 * 3600);
+        AccessTokenId access = NewAccessTokenId();
+        std::string access_token = GenerateAccessToken(user_id, tenant_id, email, roles, access);
+        // Start a refresh-token family carrying the claims (30 days TTL)
+        std::string refresh_token = refresh_tokens_.Issue(user_id, {tenant_id, email, roles, UnixNow()}, access);
 
         // Set response
         response->set_access_token(access_token);
         response->set_refresh_token(refresh_token);
         response->set_expires_in(900); // 15 minutes
 
-        txn.commit();
+        if (rehash) {
+            RehashPasswordLater(user_id, email, request->password(), password_hash);
+        }
 
         return grpc::Status::OK;
 
+    } catch (const common::PasswordHashingOverloaded& e) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, e.what());
     } catch (const std::exception& e) {
         return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Login failed: ") + e.what());
     }
 }
 
 grpc::Status AuthServiceImpl::Logout(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const LogoutRequest* request,
     LogoutResponse* response
 ) {
@@ -153,29 +460,32 @@ grpc::Status AuthServiceImpl::Logout(
             return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Refresh token required");
         }
 
-        // Extract user_id from refresh token (format: "user_id:random")
+        // End the token's family (format: "user_id:family_id:secret")
         std::string refresh_token = request->refresh_token();
-        size_t colon_pos = refresh_token.find(':');
-        if (colon_pos == std::string::npos) {
-            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid refresh token format");
+        if (RefreshTokenParts::Parse(refresh_token)) {
+            refresh_tokens_.Revoke(refresh_token);
+        } else {
+            // Token issued before families (format: "user_id:random")
+            size_t colon_pos = refresh_token.find(':');
+            if (colon_pos == std::string::npos) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid refresh token format");
+            }
+            std::string user_id = refresh_token.substr(0, colon_pos);
+            common::KeyBuilder<> refresh_key("refresh:", common::HashTag{user_id});
+            redis_client_->DeleteSession(refresh_key.View());
         }
 
-        std::string user_id = refresh_token.substr(0, colon_pos);
-
-        // Remove refresh token from Redis
-        redis_client_->DeleteSession("refresh:" + user_id);
-
         // CRITICAL SECURITY FIX: Blacklist access token to ensure instant logout
         // Extract Authorization header from metadata
-        auto metadata = context->client_metadata();
+        const auto& metadata = context->client_metadata();
         auto auth_header = metadata.find("authorization");
 
         if (auth_header != metadata.end()) {
-            std::string auth_value(auth_header->second.data(), auth_header->second.length());
+            std::string_view auth_value(auth_header->second.data(), auth_header->second.length());
 
             // Check if it starts with "Bearer "
-            if (auth_value.find("Bearer ") == 0) {
-                std::string access_token = auth_value.substr(7); // Skip "Bearer "
+            if (auth_value.substr(0, 7) == "Bearer ") {
+                std::string_view access_token = auth_value.substr(7); // Skip "Bearer "
 
                 // Validate and extract JTI from access token
                 auto claims = jwt_validator_->Validate(access_token);
@@ -187,12 +497,11 @@ grpc::Status AuthServiceImpl::Logout(
 
                     // Only blacklist if token is still valid (not already expired)
                     if (ttl.count() > 0) {
-                        // Add access token to Redis blacklist with TTL
-                        std::string blacklist_key = "blacklist:" + claims->jti;
-                        redis_client_->SetSession(blacklist_key, "logout", ttl.count());
+                        // Add access token to Redis blacklist with TTL (published to all validators)
+                        redis_client_->BlacklistToken(claims->jti, ttl.count());
+                        jwt_validator_->NoteBlacklisted(claims->jti);
 
-                        std::cout << "Access token blacklisted: jti=" << claims->jti
-                                  << ", ttl=" << ttl.count() << "s" << std::endl;
+                        common::LogInfo("Access token blacklisted", {{"jti", claims->jti}, {"ttl_s", ttl.count()}});
                     }
                 }
             }
@@ -207,7 +516,7 @@ grpc::Status AuthServiceImpl::Logout(
 }
 
 grpc::Status AuthServiceImpl::RefreshToken(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const RefreshTokenRequest* request,
     RefreshTokenResponse* response
 ) {
@@ -218,91 +527,111 @@ grpc::Status AuthServiceImpl::RefreshToken(
         }
 
         std::string refresh_token = request->refresh_token();
-
-        // Extract user_id from refresh token (format: "user_id:random")
-        size_t colon_pos = refresh_token.find(':');
-        if (colon_pos == std::string::npos) {
-            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid refresh token format");
+        auto parts = RefreshTokenParts::Parse(refresh_token);
+        if (!parts) {
+            return RefreshLegacyToken(refresh_token, response);
         }
 
-        std::string user_id = refresh_token.substr(0, colon_pos);
-
-        // CRITICAL SECURITY: Check if refresh token exists in Redis
-        std::string redis_key = "refresh:" + user_id;
-        auto stored_token = redis_client_->GetSession(redis_key);
-
-        if (!stored_token) {
-            // Token not found in Redis - either expired, revoked, or invalid
+        // CRITICAL SECURITY: Check, rotate and read the cached claims in one round trip.
+        // Only one concurrent refresh can win; a superseded token revokes every family.
+        AccessTokenId access = NewAccessTokenId();
+        auto rotation = refresh_tokens_.Rotate(refresh_token, access);
+        if (rotation.result == RefreshResult::MISSING) {
+            // Expired, revoked or never issued
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Refresh token invalid or expired");
         }
-
-        // CRITICAL SECURITY: Detect token reuse (potential security breach)
-        if (*stored_token != refresh_token) {
-            // Different refresh token stored - someone is reusing an old token!
-            // This indicates potential token theft. Revoke ALL sessions for this user.
-            std::cerr << "SECURITY ALERT: Refresh token reuse detected for user " << user_id << std::endl;
-
-            // Revoke all refresh tokens for this user
-            redis_client_->DeleteSession(redis_key);
-
-            // In production, also blacklist all active access tokens for this user
-            // and force re-authentication
-
+        if (rotation.result == RefreshResult::REUSED) {
+            // An old token of the family was presented - potential token theft
+            common::LogWarn("SECURITY ALERT: Refresh token reuse detected",
+                            {{"user_id", parts->user_id}, {"family_id", parts->family_id}});
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED,
                               "Token reuse detected. All sessions revoked. Please login again.");
         }
 
-        // Fetch user details from database
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        // Re-read the user once the cached claims are stale, so a deleted or
+        // changed account takes effect within REFRESH_CLAIMS_MAX_AGE_SEC
+        RefreshClaims& claims = rotation.claims;
+        if (UnixNow() - claims.checked_at >= REFRESH_CLAIMS_MAX_AGE_SEC) {
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
+            auto result = common::ExecPrepared(txn, kRefreshSelectUser, parts->user_id);
+            txn.commit();
+
+            if (result.empty()) {
+                // User not found or deleted - revoke every family
+                refresh_tokens_.RevokeAll(parts->user_id);
+                return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "User not found");
+            }
+            claims.tenant_id = result[0]["tenant_id"].as<std::string>();
+            claims.email = result[0]["email"].as<std::string>();
+            claims.checked_at = UnixNow();
+            refresh_tokens_.UpdateClaims(rotation.token, claims);
+        }
 
-        auto result = txn.exec_params(
-            "SELECT id, tenant_id, email FROM users WHERE id = $1 AND deleted_at IS NULL",
-            user_id
-        );
+        response->set_access_token(
+            GenerateAccessToken(parts->user_id, claims.tenant_id, claims.email, claims.roles, access));
+        response->set_refresh_token(rotation.token);
+        response->set_expires_in(900); // 15 minutes
 
-        if (result.empty()) {
-            // User not found or deleted - revoke token
-            redis_client_->DeleteSession(redis_key);
-            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "User not found");
-        }
+        common::LogDebug("Refresh token rotated", {{"user_id", parts->user_id}});
 
-        auto row = result[0];
-        std::string tenant_id = row["tenant_id"].as<std::string>();
-        std::string email = row["email"].as<std::string>();
+        return grpc::Status::OK;
 
-        // Extract roles (empty for now, could query user_roles table)
-        std::vector<std::string> roles;
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Token refresh failed: ") + e.what());
+    }
+}
 
-        // Generate new access token
-        std::string new_access_token = GenerateAccessToken(user_id, tenant_id, email, roles);
+grpc::Status AuthServiceImpl::RefreshLegacyToken(const std::string& refresh_token, RefreshTokenResponse* response) {
+    // Extract user_id from refresh token (format: "user_id:random")
+    size_t colon_pos = refresh_token.find(':');
+    if (colon_pos == std::string::npos) {
+        return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid refresh token format");
+    }
+
+    std::string user_id = refresh_token.substr(0, colon_pos);
 
-        // Generate new refresh token (token rotation for security)
-        std::string new_refresh_token = GenerateRefreshToken(user_id);
+    // Retire the legacy key before migrating: compare-and-set, so only one
+    // concurrent refresh can win. The placeholder makes a replay look like reuse.
+    common::KeyBuilder<> refresh_key("refresh:", common::HashTag{user_id});
+    std::string_view redis_key = refresh_key.View();
+    auto rotated = redis_client_->RotateSession(redis_key, refresh_token, "migrated", 24 * 3600);
 
-        // CRITICAL SECURITY: Rotate refresh token in Redis
-        // Delete old token and store new one (prevents token reuse)
+    if (rotated == common::RotateResult::MISSING) {
+        return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Refresh token invalid or expired");
+    }
+    if (rotated == common::RotateResult::MISMATCH) {
+        common::LogWarn("SECURITY ALERT: Refresh token reuse detected", {{"user_id", user_id}});
         redis_client_->DeleteSession(redis_key);
-        redis_client_->SetSession(redis_key, new_refresh_token, 30 * 24 * 3600); // 30 days TTL
+        refresh_tokens_.RevokeAll(user_id);
+        return grpc::Status(grpc::StatusCode::PERMISSION_DENIED,
+                          "Token reuse detected. All sessions revoked. Please login again.");
+    }
 
-        // Set response
-        response->set_access_token(new_access_token);
-        response->set_refresh_token(new_refresh_token);
-        response->set_expires_in(900); // 15 minutes
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+    auto result = common::ExecPrepared(txn, kRefreshSelectUser, user_id);
+    txn.commit();
 
-        txn.commit();
+    if (result.empty()) {
+        return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "User not found");
+    }
 
-        std::cout << "Refresh token rotated for user " << user_id << std::endl;
+    // Move the session onto a refresh-token family
+    RefreshClaims claims{result[0]["tenant_id"].as<std::string>(), result[0]["email"].as<std::string>(), {},
+                         UnixNow()};
+    AccessTokenId access = NewAccessTokenId();
+    response->set_access_token(GenerateAccessToken(user_id, claims.tenant_id, claims.email, claims.roles, access));
+    response->set_refresh_token(refresh_tokens_.Issue(user_id, claims, access));
+    response->set_expires_in(900); // 15 minutes
 
-        return grpc::Status::OK;
+    common::LogDebug("Legacy refresh token migrated", {{"user_id", user_id}});
 
-    } catch (const std::exception& e) {
-        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Token refresh failed: ") + e.what());
-    }
+    return grpc::Status::OK;
 }
 
 grpc::Status AuthServiceImpl::ValidateToken(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const ValidateTokenRequest* request,
     ValidateTokenResponse* response
 ) {
@@ -330,52 +659,40 @@ grpc::Status AuthServiceImpl::ValidateToken(
 }
 
 grpc::Status AuthServiceImpl::CreateApiKey(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const CreateApiKeyRequest* request,
     CreateApiKeyResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.user_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        // Generate API key
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 255);
-
-        std::stringstream ss;
-        ss << "sk_";
-        for (int i = 0; i < 32; i++) {
-            ss << std::hex << std::setw(2) << std::setfill('0') << dis(gen);
-        }
-        std::string api_key = ss.str();
+        // Generate API key: "sk_<key_id>_<secret>", secret stored as HMAC-SHA256(pepper, secret)
+        auto generated = common::ApiKeyHasher::Generate(api_key_pepper_);
 
         // Store in database
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        // Convert scopes repeated field to string
-        std::string scopes_str;
-        for (int i = 0; i < request->scopes_size(); i++) {
-            if (i > 0) scopes_str += ",";
-            scopes_str += request->scopes(i);
-        }
+        std::vector<std::string> scopes(request->scopes().begin(), request->scopes().end());
 
-        auto result = txn.exec_params(
-            "INSERT INTO api_keys (user_id, tenant_id, key_hash, name, scopes, expires_at) "
-            "VALUES ($1, $2, $3, $4, $5, NOW() + INTERVAL '1 year') "
-            "RETURNING id, created_at",
+        auto result = common::ExecPrepared(
+            txn, kInsertApiKey,
             tenant_ctx.user_id,
             tenant_ctx.tenant_id,
-            HashPassword(api_key),
+            generated.key_id,
+            common::ApiKeyHasher::DisplayPrefix(generated.api_key),
+            generated.key_hash,
+            common::ApiKeyHasher::SCHEME_HMAC_SHA256,
             request->name(),
-            scopes_str
+            common::ToArrayLiteral(scopes)
         );
 
-        response->set_api_key(api_key);
+        response->set_api_key(generated.api_key);
         response->set_key_id(result[0]["id"].as<std::string>());
 
         txn.commit();
@@ -388,23 +705,23 @@ grpc::Status AuthServiceImpl::CreateApiKey(
 }
 
 grpc::Status AuthServiceImpl::RevokeApiKey(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const RevokeApiKeyRequest* request,
     RevokeApiKeyResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.user_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "UPDATE api_keys SET revoked_at = NOW() "
-            "WHERE id = $1 AND user_id = $2 AND tenant_id = $3 AND revoked_at IS NULL",
+        auto result = common::ExecPrepared(
+            txn, kRevokeApiKey,
             request->key_id(),
             tenant_ctx.user_id,
             tenant_ctx.tenant_id
@@ -417,6 +734,13 @@ grpc::Status AuthServiceImpl::RevokeApiKey(
         response->set_success(true);
         txn.commit();
 
+        // Evict locally, then fan out to the other replicas
+        api_key_cache_->InvalidateByKeyId(request->key_id());
+        if (!event_bus_->Publish(ApiKeyCache::REVOCATION_TOPIC, request->key_id())) {
+            // Revocation is committed; other replicas converge within the cache TTL
+            common::LogError("API key revocation publish dropped", {{"key_id", request->key_id()}});
+        }
+
         return grpc::Status::OK;
 
     } catch (const std::exception& e) {
@@ -430,113 +754,109 @@ std::string AuthServiceImpl::GenerateAccessToken(
     const std::string& user_id,
     const std::string& tenant_id,
     const std::string& email,
-    const std::vector<std::string>& roles
+    const std::vector<std::string>& roles,
+    const AccessTokenId& id
 ) {
-    auto now = std::chrono::system_clock::now();
-    auto exp = now + std::chrono::minutes(15);
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 255);
-    std::stringstream jti_ss;
-    for (int i = 0; i < 16; i++) {
-        jti_ss << std::hex << std::setw(2) << std::setfill('0') << dis(gen);
-    }
-
-    auto token = jwt::create()
+    return jwt_signer_.Sign(jwt::create()
         .set_issuer("saasforge")
         .set_type("JWT")
         .set_subject(user_id)
-        .set_issued_at(now)
-        .set_expires_at(exp)
-        .set_id(jti_ss.str())
+        .set_issued_at(std::chrono::system_clock::now())
+        .set_expires_at(std::chrono::system_clock::from_time_t(id.exp))
+        .set_id(id.jti)
         .set_payload_claim("tenant_id", jwt::claim(tenant_id))
-        .set_payload_claim("email", jwt::claim(email))
-        .sign(jwt::algorithm::rs256("", jwt_private_key_, "", ""));
-
-    return token;
-}
-
-std::string AuthServiceImpl::GenerateRefreshToken(const std::string& user_id) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 255);
-
-    std::stringstream ss;
-    for (int i = 0; i < 32; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << dis(gen);
-    }
-
-    return user_id + ":" + ss.str();
+        .set_payload_claim("email", jwt::claim(email)));
 }
 
 bool AuthServiceImpl::VerifyPassword(const std::string& password, const std::string& hashed_password) {
-    // Use Argon2id for secure password verification
-    return common::PasswordHasher::VerifyPassword(password, hashed_password);
+    // Argon2id on the bounded hashing pool (throws PasswordHashingOverloaded when full)
+    return password_hashing_pool_->Verify(password, hashed_password);
 }
 
 std::string AuthServiceImpl::HashPassword(const std::string& password) {
     // Use Argon2id for secure password hashing
     // This replaces the insecure SHA-256 implementation
-    return common::PasswordHasher::HashPassword(password);
+    return password_hashing_pool_->Hash(password);
+}
+
+void AuthServiceImpl::RehashPasswordLater(const std::string& user_id, const std::string& email,
+                                          const std::string& password, const std::string& old_hash) {
+    static auto& rehashed = common::MetricsRegistry::Global().GetCounter(
+        "saasforge_password_rehash_total", "Stored password hashes upgraded to the current policy at login",
+        {{"outcome", "rehashed"}});
+    static auto& skipped = common::MetricsRegistry::Global().GetCounter(
+        "saasforge_password_rehash_total", "Stored password hashes upgraded to the current policy at login",
+        {{"outcome", "skipped"}});
+
+    // A BULK hash waits behind logins on the hashing pool; when the pool (or the
+    // background queue) is full this login is not upgraded and the next one tries again
+    auto db_pool = db_pool_;
+    auto hashing_pool = password_hashing_pool_;
+    bool queued = common::Executor::Background().TrySubmit(
+        [db_pool, hashing_pool, user_id, email, password = std::string(password), old_hash]() mutable {
+            try {
+                std::string new_hash = hashing_pool->Hash(password, nullptr, common::TaskPriority::BULK);
+
+                auto conn_guard = db_pool->AcquireConnection("RehashPassword");
+                pqxx::nontransaction txn(*conn_guard);
+                auto result = common::ExecPrepared(txn, kRehashPassword, new_hash, user_id, old_hash);
+                if (result.affected_rows() > 0) {
+                    db_pool->RecordWrite(email);
+                    rehashed.Increment();
+                } else {
+                    skipped.Increment();
+                }
+            } catch (const common::PasswordHashingOverloaded&) {
+                skipped.Increment();
+            } catch (const std::exception& e) {
+                common::LogWarn("Password rehash failed", {{"user_id", user_id}, {"error", e.what()}});
+            }
+            OPENSSL_cleanse(password.data(), password.size());
+        },
+        common::TaskPriority::BULK);
+    if (!queued) {
+        skipped.Increment();
+    }
 }
 
 // 2FA / TOTP Implementations
 
 grpc::Status AuthServiceImpl::EnrollTOTP(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const EnrollTOTPRequest* request,
     EnrollTOTPResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
         if (tenant_ctx.user_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        // Generate TOTP secret
+        // Generate TOTP secret and backup codes
         std::string secret = common::TotpHelper::GenerateSecret();
+        auto backup_codes = common::TotpHelper::GenerateBackupCodes(10);
 
-        // Get user email for QR code
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        // Store TOTP secret (encrypted in production) and backup codes
+        // (hashed), reading back the email for the QR code
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::nontransaction txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT email FROM users WHERE id = $1",
-            tenant_ctx.user_id
+        auto result = common::ExecPrepared(
+            txn, kEnrollTotp,
+            secret,
+            tenant_ctx.user_id,
+            HashBackupCodes(backup_codes)
         );
 
         if (result.empty()) {
             return grpc::Status(grpc::StatusCode::NOT_FOUND, "User not found");
         }
+        db_pool_->RecordWrite(tenant_ctx.email);
 
         std::string email = result[0]["email"].as<std::string>();
-
-        // Generate QR code URL
         std::string qr_url = common::TotpHelper::GenerateQrCodeUrl(secret, email);
 
-        // Generate backup codes
-        auto backup_codes = common::TotpHelper::GenerateBackupCodes(10);
-
-        // Store TOTP secret in database (encrypted in production)
-        txn.exec_params(
-            "UPDATE users SET totp_secret = $1, totp_enrolled_at = NOW() WHERE id = $2",
-            secret,
-            tenant_ctx.user_id
-        );
-
-        // Store backup codes (hashed)
-        for (const auto& code : backup_codes) {
-            std::string hash = common::TotpHelper::HashBackupCode(code);
-            txn.exec_params(
-                "INSERT INTO backup_codes (user_id, code_hash) VALUES ($1, $2)",
-                tenant_ctx.user_id,
-                hash
-            );
-        }
-
-        txn.commit();
-
         // Set response
         response->set_secret(secret);
         response->set_qr_code_url(qr_url);
@@ -552,22 +872,23 @@ grpc::Status AuthServiceImpl::EnrollTOTP(
 }
 
 grpc::Status AuthServiceImpl::VerifyTOTP(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const VerifyTOTPRequest* request,
     VerifyTOTPResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
         if (tenant_ctx.user_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Get TOTP secret from database
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT totp_secret FROM users WHERE id = $1",
+        auto result = common::ExecPrepared(
+            txn, kSelectTotpSecret,
             tenant_ctx.user_id
         );
 
@@ -579,11 +900,13 @@ grpc::Status AuthServiceImpl::VerifyTOTP(
 
         std::string secret = result[0]["totp_secret"].as<std::string>();
 
-        // Validate TOTP code
-        bool valid = common::TotpHelper::ValidateCode(secret, request->totp_code());
+        // Validate TOTP code; consuming the step keeps it from being replayed at login
+        auto totp_step = common::TotpHelper::VerifyCode(secret, request->totp_code());
+        bool valid = totp_step && ConsumeTotpStep(tenant_ctx.user_id, *totp_step);
 
         response->set_valid(valid);
-        response->set_message(valid ? "TOTP code valid" : "Invalid TOTP code");
+        response->set_message(valid ? "TOTP code valid"
+                              : totp_step ? "TOTP code already used" : "Invalid TOTP code");
 
         return grpc::Status::OK;
 
@@ -593,22 +916,23 @@ grpc::Status AuthServiceImpl::VerifyTOTP(
 }
 
 grpc::Status AuthServiceImpl::DisableTOTP(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const DisableTOTPRequest* request,
     DisableTOTPResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
         if (tenant_ctx.user_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Verify password before disabling 2FA
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT password_hash FROM users WHERE id = $1",
+        auto result = common::ExecPrepared(
+            txn, kSelectPasswordHash,
             tenant_ctx.user_id
         );
 
@@ -623,34 +947,38 @@ grpc::Status AuthServiceImpl::DisableTOTP(
         }
 
         // Disable TOTP
-        txn.exec_params(
-            "UPDATE users SET totp_secret = NULL, totp_enrolled_at = NULL WHERE id = $1",
+        common::ExecPrepared(
+            txn, kClearTotpSecret,
             tenant_ctx.user_id
         );
 
         // Delete backup codes
-        txn.exec_params(
-            "DELETE FROM backup_codes WHERE user_id = $1",
+        common::ExecPrepared(
+            txn, kDeleteBackupCodes,
             tenant_ctx.user_id
         );
 
         txn.commit();
+        db_pool_->RecordWrite(tenant_ctx.email);
 
         response->set_success(true);
         return grpc::Status::OK;
 
+    } catch (const common::PasswordHashingOverloaded& e) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, e.what());
     } catch (const std::exception& e) {
         return grpc::Status(grpc::StatusCode::INTERNAL, std::string("TOTP disable failed: ") + e.what());
     }
 }
 
 grpc::Status AuthServiceImpl::GenerateBackupCodes(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const GenerateBackupCodesRequest* request,
     GenerateBackupCodesResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
         if (tenant_ctx.user_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
@@ -658,26 +986,16 @@ grpc::Status AuthServiceImpl::GenerateBackupCodes(
         // Generate new backup codes
         auto backup_codes = common::TotpHelper::GenerateBackupCodes(10);
 
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::nontransaction txn(*conn_guard);
 
-        // Delete old backup codes
-        txn.exec_params(
-            "DELETE FROM backup_codes WHERE user_id = $1",
-            tenant_ctx.user_id
+        // Replace old backup codes with the new ones (hashed), in one statement
+        common::ExecPrepared(
+            txn, kReplaceBackupCodes,
+            tenant_ctx.user_id,
+            HashBackupCodes(backup_codes)
         );
-
-        // Store new backup codes (hashed)
-        for (const auto& code : backup_codes) {
-            std::string hash = common::TotpHelper::HashBackupCode(code);
-            txn.exec_params(
-                "INSERT INTO backup_codes (user_id, code_hash) VALUES ($1, $2)",
-                tenant_ctx.user_id,
-                hash
-            );
-        }
-
-        txn.commit();
+        db_pool_->RecordWrite(tenant_ctx.email);
 
         // Return plaintext codes to user (only time they can see them)
         for (const auto& code : backup_codes) {
@@ -694,14 +1012,13 @@ grpc::Status AuthServiceImpl::GenerateBackupCodes(
 // OTP Implementations
 
 grpc::Status AuthServiceImpl::SendOTP(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const SendOTPRequest* request,
     SendOTPResponse* response
 ) {
     try {
         // Rate limiting: 3 OTP requests per minute (Requirement A-7)
-        std::string rate_limit_key = "otp:rate:" + request->email();
-        if (!CheckRateLimit(rate_limit_key, 3, 60)) {
+        if (!CheckRateLimit(*otp_rate_limiter_, request->email())) {
             response->set_success(false);
             response->set_message("Too many OTP requests. Please try again later.");
             return grpc::Status::OK;
@@ -714,7 +1031,7 @@ grpc::Status AuthServiceImpl::SendOTP(
         StoreOTP(request->email(), otp, request->purpose(), 600);
 
         // TODO: Send OTP via email (mock for now)
-        std::cout << "OTP for " << request->email() << " (" << request->purpose() << "): " << otp << std::endl;
+        common::LogDebug("Mock: Sending OTP", {{"email", request->email()}, {"purpose", request->purpose()}});
 
         auto expires_at = std::chrono::system_clock::now() + std::chrono::seconds(600);
         auto expires_timestamp = std::chrono::duration_cast<std::chrono::seconds>(
@@ -733,7 +1050,7 @@ grpc::Status AuthServiceImpl::SendOTP(
 }
 
 grpc::Status AuthServiceImpl::VerifyOTP(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const VerifyOTPRequest* request,
     VerifyOTPResponse* response
 ) {
@@ -752,8 +1069,8 @@ grpc::Status AuthServiceImpl::VerifyOTP(
 
         if (valid) {
             // Delete OTP after successful verification
-            std::string otp_key = "otp:" + request->email() + ":" + request->purpose();
-            redis_client_->DeleteSession(otp_key);
+            common::KeyBuilder<> otp_key("otp:", common::HashTag{request->email()}, ":", request->purpose());
+            redis_client_->DeleteSession(otp_key.View());
         }
 
         response->set_valid(valid);
@@ -766,29 +1083,44 @@ grpc::Status AuthServiceImpl::VerifyOTP(
     }
 }
 
-// OAuth Implementations (Mock)
+// OAuth Implementations
+//
+// Providers with credentials (OAUTH_<PROVIDER>_CLIENT_ID) go through
+// OAuthClient; the others keep the development mock below.
 
 grpc::Status AuthServiceImpl::InitiateOAuth(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const InitiateOAuthRequest* request,
     InitiateOAuthResponse* response
 ) {
     try {
         // Generate CSRF state token
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 255);
+        std::string state = common::RandomHex(32);
+        common::KeyBuilder<> state_key("oauth:state:", state);
+
+        if (oauth_client_->Configured(request->provider())) {
+            std::string nonce = common::RandomHex(16);
+            std::string auth_url;
+            try {
+                auth_url = oauth_client_->AuthorizationUrl(request->provider(), request->redirect_uri(), state, nonce);
+            } catch (const std::invalid_argument& e) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+            } catch (const std::runtime_error& e) {
+                return grpc::Status(grpc::StatusCode::UNAVAILABLE, e.what());
+            }
 
-        std::stringstream state_ss;
-        for (int i = 0; i < 32; i++) {
-            state_ss << std::hex << std::setw(2) << std::setfill('0') << dis(gen);
+            // Store state in Redis with 10-minute TTL
+            redis_client_->SetSession(state_key.View(),
+                                      request->provider() + "\n" + nonce + "\n" + request->redirect_uri(), 600);
+            response->set_authorization_url(auth_url);
+            response->set_state(state);
+            return grpc::Status::OK;
         }
-        std::string state = state_ss.str();
 
         // Store state in Redis with 10-minute TTL
-        redis_client_->SetSession("oauth:state:" + state, request->provider(), 600);
+        redis_client_->SetSession(state_key.View(), request->provider(), 600);
 
-        // Mock authorization URL (in production, use actual OAuth URLs)
+        // Mock authorization URL for providers without credentials (development)
         std::string auth_url;
         if (request->provider() == "google") {
             auth_url = "https://accounts.google.com/o/oauth2/v2/auth?client_id=MOCK&redirect_uri=" +
@@ -814,78 +1146,103 @@ grpc::Status AuthServiceImpl::InitiateOAuth(
 }
 
 grpc::Status AuthServiceImpl::HandleOAuthCallback(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const OAuthCallbackRequest* request,
     OAuthCallbackResponse* response
 ) {
     try {
-        // Verify state parameter (CSRF protection - Requirement A-34)
-        std::string state_key = "oauth:state:" + request->state();
-        auto stored_provider = redis_client_->GetSession(state_key);
-
-        if (!stored_provider || *stored_provider != request->provider()) {
+        // Verify state parameter (CSRF protection - Requirement A-34). Consumed atomically, so of two
+        // callbacks racing with one state only one proceeds; a mismatched provider burns it too
+        common::KeyBuilder<> state_key("oauth:state:", request->state());
+        auto stored_state = redis_client_->TakeSession(state_key.View());
+        if (!stored_state) {
+            return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Invalid OAuth state parameter");
+        }
+        OAuthState state = OAuthState::Parse(*stored_state);
+        if (state.provider != request->provider()) {
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Invalid OAuth state parameter");
         }
 
-        // Delete state after verification
-        redis_client_->DeleteSession(state_key);
+        std::string email = "user@example.com";
+        std::string provider_user_id = "oauth_" + request->provider() + "_12345";
+        bool email_verified = true;   // Development mock
+        if (oauth_client_->Configured(request->provider())) {
+            if (state.mock) {
+                // Issued before the provider was configured
+                return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "OAuth state expired, restart the login");
+            }
 
-        // Mock OAuth token exchange (in production, call provider APIs)
-        std::string mock_email = "user@example.com";
-        std::string mock_provider_id = "oauth_" + request->provider() + "_12345";
+            // Token exchange before a database connection is taken, so none is held across the provider call
+            OAuthIdentity identity;
+            try {
+                identity = oauth_client_->Exchange(request->provider(), request->code(), state.redirect_uri, state.nonce);
+            } catch (const std::invalid_argument& e) {
+                return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, e.what());
+            } catch (const std::runtime_error& e) {
+                return grpc::Status(grpc::StatusCode::UNAVAILABLE, e.what());
+            }
+            if (identity.email.empty()) {
+                return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                    "OAuth provider did not share an email address");
+            }
+            email = identity.email;
+            provider_user_id = identity.provider_user_id;
+            email_verified = identity.email_verified;
+        }
 
         // Check if user exists with this OAuth provider
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT u.id, u.tenant_id, u.email FROM users u "
-            "JOIN oauth_accounts oa ON u.id = oa.user_id "
-            "WHERE oa.provider = $1 AND oa.provider_user_id = $2",
+        auto result = common::ExecPrepared(
+            txn, kOauthSelectUser,
             request->provider(),
-            mock_provider_id
+            provider_user_id
         );
 
         bool is_new_user = result.empty();
         std::string user_id, tenant_id;
 
         if (is_new_user) {
+            // An account is only created from an address the provider verified: anyone can put
+            // another person's address on a provider account, and it would then own that email here
+            if (!email_verified) {
+                return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                    "OAuth provider has not verified the email address");
+            }
+
             // Create new user (mock tenant_id)
             std::string mock_tenant_id = "tenant_" + request->provider();
 
-            auto user_result = txn.exec_params(
-                "INSERT INTO users (tenant_id, email, password_hash) "
-                "VALUES ($1, $2, NULL) RETURNING id",
+            auto user_result = common::ExecPrepared(
+                txn, kOauthInsertUser,
                 mock_tenant_id,
-                mock_email
+                email
             );
 
             user_id = user_result[0]["id"].as<std::string>();
             tenant_id = mock_tenant_id;
 
             // Link OAuth account
-            txn.exec_params(
-                "INSERT INTO oauth_accounts (user_id, provider, provider_user_id) "
-                "VALUES ($1, $2, $3)",
+            common::ExecPrepared(
+                txn, kOauthInsertAccount,
                 user_id,
                 request->provider(),
-                mock_provider_id
+                provider_user_id
             );
         } else {
             user_id = result[0]["id"].as<std::string>();
             tenant_id = result[0]["tenant_id"].as<std::string>();
-            mock_email = result[0]["email"].as<std::string>();
+            email = result[0]["email"].as<std::string>();
         }
 
         txn.commit();
 
         // Generate tokens
         std::vector<std::string> roles;
-        std::string access_token = GenerateAccessToken(user_id, tenant_id, mock_email, roles);
-        std::string refresh_token = GenerateRefreshToken(user_id);
-
-        // Store refresh token
-        redis_client_->SetSession("refresh:" + user_id, refresh_token, 30 * 24 * 3600);
+        AccessTokenId access = NewAccessTokenId();
+        std::string access_token = GenerateAccessToken(user_id, tenant_id, email, roles, access);
+        std::string refresh_token = refresh_tokens_.Issue(user_id, {tenant_id, email, roles, UnixNow()}, access);
 
         response->set_access_token(access_token);
         response->set_refresh_token(refresh_token);
@@ -904,121 +1261,340 @@ grpc::Status AuthServiceImpl::HandleOAuthCallback(
 // API Key Validation with Scopes
 
 grpc::Status AuthServiceImpl::ValidateApiKey(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const ValidateApiKeyRequest* request,
     ValidateApiKeyResponse* response
 ) {
     try {
-        // Query API key from database
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
-
-        // API keys are hashed, so we need to check all non-revoked keys
-        // In production, consider using a hash prefix index for performance
-        auto result = txn.exec_params(
-            "SELECT id, user_id, tenant_id, key_hash, scopes "
-            "FROM api_keys "
-            "WHERE revoked_at IS NULL AND (expires_at IS NULL OR expires_at > NOW())"
-        );
+        // Hot path: keys verified recently are served from memory (no DB round trip)
+        std::string cache_key = common::ApiKeyHasher::Digest(request->api_key(), api_key_pepper_);
+        auto record = api_key_cache_->Get(cache_key);
 
-        bool found = false;
-        std::string user_id, tenant_id, scopes_str;
+        if (!record) {
+            uint64_t generation = api_key_cache_->Generation();
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
 
-        for (const auto& row : result) {
-            std::string key_hash = row["key_hash"].as<std::string>();
+            record = LookupApiKey(txn, request->api_key(), context ? context->peer() : "");
+            txn.commit();
 
-            if (VerifyPassword(request->api_key(), key_hash)) {
-                found = true;
-                user_id = row["user_id"].as<std::string>();
-                tenant_id = row["tenant_id"].as<std::string>();
-                scopes_str = row["scopes"].as<std::string>();
-                break;
+            if (record) {
+                api_key_cache_->Put(cache_key, *record, generation);
             }
         }
 
-        if (!found) {
+        if (!record) {
             response->set_valid(false);
             response->set_message("Invalid API key");
             return grpc::Status::OK;
         }
 
-        // Parse scopes (comma-separated)
-        std::vector<std::string> scopes;
-        std::stringstream ss(scopes_str);
-        std::string scope;
-        while (std::getline(ss, scope, ',')) {
-            scopes.push_back(scope);
-        }
-
         // Validate requested scope (Requirement A-14)
-        bool scope_valid = ValidateScope(scopes, request->requested_scope());
-
-        if (!scope_valid) {
+        if (!record->scope_set.Allows(request->requested_scope())) {
             response->set_valid(false);
             response->set_message("API key does not have required scope: " + request->requested_scope());
             return grpc::Status::OK;
         }
 
         response->set_valid(true);
-        response->set_user_id(user_id);
-        response->set_tenant_id(tenant_id);
-        for (const auto& s : scopes) {
+        response->set_user_id(record->user_id);
+        response->set_tenant_id(record->tenant_id);
+        for (const auto& s : record->scopes) {
             response->add_scopes(s);
         }
         response->set_message("API key valid");
 
         return grpc::Status::OK;
 
+    } catch (const common::PasswordHashingOverloaded& e) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, e.what());
     } catch (const std::exception& e) {
         return grpc::Status(grpc::StatusCode::INTERNAL, std::string("API key validation failed: ") + e.what());
     }
 }
 
-// Helper Methods
+grpc::Status AuthServiceImpl::ValidateBatch(
+    grpc::ServerContextBase* context,
+    const ValidateBatchRequest* request,
+    ValidateBatchResponse* response
+) {
+    try {
+        if (request->checks_size() > MAX_VALIDATE_BATCH) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                              "At most " + std::to_string(MAX_VALIDATE_BATCH) + " checks per batch");
+        }
+
+        // Distinct credentials, each verified once; scopes are checked per entry afterwards
+        std::unordered_map<std::string, std::optional<common::TokenClaims>> tokens;
+        std::unordered_map<std::string, std::optional<ApiKeyEntry>> api_keys;
+        std::vector<std::pair<const std::string*, std::string>> misses;   // (api_key, digest)
+
+        for (const auto& check : request->checks()) {
+            if (check.has_access_token()) {
+                auto inserted = tokens.try_emplace(check.access_token());
+                if (inserted.second) {
+                    inserted.first->second = jwt_validator_->Validate(check.access_token());
+                }
+            } else if (check.has_api_key()) {
+                auto inserted = api_keys.try_emplace(check.api_key());
+                if (inserted.second) {
+                    std::string digest = common::ApiKeyHasher::Digest(check.api_key(), api_key_pepper_);
+                    inserted.first->second = api_key_cache_->Get(digest);
+                    if (!inserted.first->second) {
+                        misses.emplace_back(&inserted.first->first, std::move(digest));
+                    }
+                }
+            }
+        }
+
+        // Cache misses: one connection and transaction for the whole batch
+        if (!misses.empty()) {
+            uint64_t generation = api_key_cache_->Generation();
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
+            for (const auto& miss : misses) {
+                auto record = LookupApiKey(txn, *miss.first, context ? context->peer() : "");
+                if (record) {
+                    api_key_cache_->Put(miss.second, *record, generation);
+                }
+                api_keys[*miss.first] = std::move(record);
+            }
+            txn.commit();
+        }
+
+        for (const auto& check : request->checks()) {
+            CredentialResult* result = response->add_results();
+            if (check.has_access_token()) {
+                const auto& claims = tokens[check.access_token()];
+                if (!claims) {
+                    result->set_message("Invalid token");
+                    continue;
+                }
+                result->set_valid(true);
+                result->set_user_id(claims->user_id);
+                result->set_tenant_id(claims->tenant_id);
+                for (const auto& role : claims->roles) {
+                    result->add_roles(role);
+                }
+            } else if (check.has_api_key()) {
+                const auto& record = api_keys[check.api_key()];
+                if (!record) {
+                    result->set_message("Invalid API key");
+                    continue;
+                }
+                if (!record->scope_set.Allows(check.requested_scope())) {
+                    result->set_message("API key does not have required scope: " + check.requested_scope());
+                    continue;
+                }
+                result->set_valid(true);
+                result->set_user_id(record->user_id);
+                result->set_tenant_id(record->tenant_id);
+                for (const auto& scope : record->scopes) {
+                    result->add_scopes(scope);
+                }
+            } else {
+                result->set_message("No credential");
+            }
+        }
+
+        return grpc::Status::OK;
+
+    } catch (const common::PasswordHashingOverloaded& e) {
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, e.what());
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Batch validation failed: ") + e.what());
+    }
+}
 
-bool AuthServiceImpl::CheckRateLimit(const std::string& key, int max_attempts, int window_seconds) {
+grpc::Status AuthServiceImpl::RevokeAllSessions(
+    grpc::ServerContextBase* context,
+    const RevokeAllSessionsRequest* request,
+    RevokeAllSessionsResponse* response
+) {
     try {
-        // Increment counter in Redis
-        auto count_opt = redis_client_->GetSession(key);
-        int count = count_opt ? std::stoi(*count_opt) : 0;
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        if (tenant->user_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        // Every family of the user goes, and the access tokens last minted from them are blacklisted
+        int64_t revoked = refresh_tokens_.RevokeAll(tenant->user_id);
+        response->set_revoked_sessions(revoked);
 
-        if (count >= max_attempts) {
-            return false;
+        common::LogInfo("All sessions revoked", {{"user_id", tenant->user_id}, {"sessions", revoked}});
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Session revocation failed: ") + e.what());
+    }
+}
+
+grpc::Status AuthServiceImpl::RevokeTenantSessions(
+    grpc::ServerContextBase* context,
+    const RevokeTenantSessionsRequest* request,
+    RevokeTenantSessionsResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+        if (tenant_ctx.user_id.empty() || tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+        // Roles come from the database: tokens carry none, and x-user-roles is caller-controlled
+        if (!IsTenantAdmin(tenant_ctx.user_id, tenant_ctx.tenant_id)) {
+            return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Admin role required");
         }
 
-        // Increment and set TTL
-        count++;
-        redis_client_->SetSession(key, std::to_string(count), window_seconds);
+        // One epoch write, whatever the tenant's size: tokens and families are checked against it
+        TenantRevocation revocation = refresh_tokens_.RevokeTenant(tenant_ctx.tenant_id);
+        response->set_revoked_at(revocation.revoked_at);
+        response->set_affected_users(revocation.affected_users);
 
-        return true;
+        common::LogWarn("All tenant sessions revoked",
+                        {{"tenant_id", tenant_ctx.tenant_id}, {"by_user_id", tenant_ctx.user_id},
+                         {"users", revocation.affected_users}});
+        return grpc::Status::OK;
 
     } catch (const std::exception& e) {
-        std::cerr << "Rate limit check failed: " << e.what() << std::endl;
-        return true; // Fail open to avoid blocking legitimate requests
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Session revocation failed: ") + e.what());
     }
 }
 
-bool AuthServiceImpl::ValidateScope(
-    const std::vector<std::string>& granted_scopes,
-    const std::string& requested_scope
+// Helper Methods
+
+std::optional<ApiKeyEntry> AuthServiceImpl::LookupApiKey(
+    pqxx::work& txn,
+    const std::string& api_key,
+    const std::string& caller
 ) {
-    // Exact match
-    if (std::find(granted_scopes.begin(), granted_scopes.end(), requested_scope) != granted_scopes.end()) {
-        return true;
+    auto parsed = common::ApiKeyHasher::Parse(api_key);
+    if (!parsed) {
+        return std::nullopt;
+    }
+
+    // Legacy keys carry no key id; rehashed ones are found under a derived id
+    std::string key_id = parsed->legacy
+        ? common::ApiKeyHasher::LegacyKeyId(api_key, api_key_pepper_)
+        : parsed->key_id;
+
+    auto result = common::ExecPrepared(
+        txn, kLookupApiKey,
+        key_id,
+        common::ApiKeyHasher::SCHEME_HMAC_SHA256
+    );
+
+    if (!result.empty()) {
+        const auto& row = result[0];
+        if (!common::ApiKeyHasher::VerifyDigest(parsed->secret, api_key_pepper_, row["key_hash"].as<std::string>())) {
+            return std::nullopt;
+        }
+        return ApiKeyEntryFromRow(row);
+    }
+
+    if (parsed->legacy && allow_legacy_api_key_scan_) {
+        return MigrateLegacyApiKey(txn, api_key, key_id, caller);
     }
 
-    // Wildcard match (e.g., "read:*" matches "read:upload")
-    for (const auto& granted : granted_scopes) {
-        if (granted.back() == '*') {
-            std::string prefix = granted.substr(0, granted.length() - 1);
-            if (requested_scope.find(prefix) == 0) {
-                return true;
+    return std::nullopt;
+}
+
+std::optional<ApiKeyEntry> AuthServiceImpl::MigrateLegacyApiKey(
+    pqxx::work& txn,
+    const std::string& api_key,
+    const std::string& legacy_key_id,
+    const std::string& caller
+) {
+    // Only keys created before the key_id column existed are scanned here. Each
+    // match is rehashed in place, so the set shrinks as clients keep using keys
+    // during the migration window (API_KEY_LEGACY_SCAN=1) until it is empty.
+    //
+    // Any sk_ + 64 hex string looks legacy, so a scan costs one Argon2 verify per
+    // unmigrated key for a random guess: misses are remembered by the key's HMAC,
+    // and each caller gets a few scans per minute. Both fail closed.
+    common::KeyBuilder<> miss_key("api_key_legacy_miss:", legacy_key_id);
+    try {
+        if (redis_client_->Get(miss_key.View())) {
+            return std::nullopt;
+        }
+        if (!legacy_scan_rate_limiter_->Check(caller).allowed) {
+            common::LogWarn("Legacy API key scan rate limited", {{"caller", caller}});
+            return std::nullopt;
+        }
+    } catch (const std::exception& e) {
+        common::LogError("Legacy API key scan guard failed", {{"error", e.what()}});
+        return std::nullopt;
+    }
+
+    auto result = common::ExecPrepared(
+        txn, kScanLegacyApiKeys,
+        common::ApiKeyHasher::SCHEME_ARGON2ID
+    );
+
+    for (const auto& row : result) {
+        if (!VerifyPassword(api_key, row["key_hash"].as<std::string>())) {
+            continue;
+        }
+
+        common::ExecPrepared(
+            txn, kRehashLegacyApiKey,
+            legacy_key_id,
+            common::ApiKeyHasher::Digest(api_key, api_key_pepper_),
+            common::ApiKeyHasher::SCHEME_HMAC_SHA256,
+            row["id"].as<std::string>()
+        );
+
+        return ApiKeyEntryFromRow(row);
+    }
+
+    try {
+        redis_client_->SetWithTtl(miss_key.View(), "1", LEGACY_SCAN_MISS_TTL);
+    } catch (const std::exception& e) {
+        common::LogWarn("Failed to cache legacy API key miss", {{"error", e.what()}});
+    }
+    return std::nullopt;
+}
+
+ApiKeyEntry AuthServiceImpl::ApiKeyEntryFromRow(const pqxx::row& row) {
+    ApiKeyEntry entry;
+    entry.key_id = row["id"].as<std::string>();
+    entry.user_id = row["user_id"].as<std::string>();
+    entry.tenant_id = row["tenant_id"].as<std::string>();
+    entry.expires_at = row["expires_at"].as<int64_t>();
+
+    // scopes is text[]; compiled once per cache fill, not per request
+    if (!row["scopes"].is_null()) {
+        auto parser = row["scopes"].as_array();
+        for (auto item = parser.get_next(); item.first != pqxx::array_parser::juncture::done;
+             item = parser.get_next()) {
+            if (item.first == pqxx::array_parser::juncture::string_value) {
+                entry.scopes.push_back(std::move(item.second));
             }
         }
     }
+    entry.scope_set = ScopeSet::Compile(entry.scopes);
+    return entry;
+}
+
+bool AuthServiceImpl::IsTenantAdmin(const std::string& user_id, const std::string& tenant_id) {
+    // The primary: a role just taken away must not be read back from a lagging replica
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::nontransaction txn(*conn_guard);
+    return !common::ExecPrepared(txn, kSelectTenantAdmin, user_id, tenant_id).empty();
+}
+
+bool AuthServiceImpl::CheckRateLimit(common::RateLimiter& limiter, const std::string& key) {
+    try {
+        return limiter.Check(key).allowed;
+    } catch (const std::exception& e) {
+        common::LogError("Rate limit check failed", {{"error", e.what()}});
+        return true; // Fail open to avoid blocking legitimate requests
+    }
+}
 
-    // Deny by default (Requirement A-14)
-    return false;
+bool AuthServiceImpl::ConsumeTotpStep(const std::string& user_id, uint64_t step) {
+    common::KeyBuilder<> key("totp_step:", common::HashTag{user_id});
+    return redis_client_->SetIfGreater(key.View(), static_cast<int64_t>(step),
+                                       common::TotpHelper::ReplayWindowSeconds());
 }
 
 std::string AuthServiceImpl::GenerateOTP() {
@@ -1038,16 +1614,16 @@ void AuthServiceImpl::StoreOTP(
     const std::string& purpose,
     int ttl_seconds
 ) {
-    std::string key = "otp:" + email + ":" + purpose;
-    redis_client_->SetSession(key, otp, ttl_seconds);
+    common::KeyBuilder<> key("otp:", common::HashTag{email}, ":", purpose);
+    redis_client_->SetSession(key.View(), otp, ttl_seconds);
 }
 
 std::optional<std::string> AuthServiceImpl::GetStoredOTP(
     const std::string& email,
     const std::string& purpose
 ) {
-    std::string key = "otp:" + email + ":" + purpose;
-    return redis_client_->GetSession(key);
+    common::KeyBuilder<> key("otp:", common::HashTag{email}, ":", purpose);
+    return redis_client_->GetSession(key.View());
 }
 
 } // namespace auth
@@ -4,9 +4,21 @@
 #include <fstream>
 #include <grpcpp/grpcpp.h>
 #include "auth/auth_service.h"
+#include "auth/auth_grpc_service.h"
+#include "auth/oauth_client.h"
+#include "common/server_options.h"
 #include "common/mtls_credentials.h"
 #include "common/redis_client.h"
 #include "common/db_pool.h"
+#include "common/executor.h"
+#include "common/allocator_stats.h"
+#include "common/metrics_server.h"
+#include "common/password_hasher.h"
+#include "common/server_interceptors.h"
+#include "common/warmup.h"
+#include "common/graceful_shutdown.h"
+#include "common/logger.h"
+#include "common/tracing.h"
 
 using grpc::Server;
 using grpc::ServerBuilder;
@@ -28,17 +40,25 @@ void RunServer() {
     const char* db_url_env = std::getenv("DATABASE_URL");
     const char* jwt_public_key_path_env = std::getenv("JWT_PUBLIC_KEY_PATH");
     const char* jwt_private_key_path_env = std::getenv("JWT_PRIVATE_KEY_PATH");
+    const char* api_key_pepper_env = std::getenv("API_KEY_PEPPER");
+    const char* api_key_legacy_scan_env = std::getenv("API_KEY_LEGACY_SCAN");
+    const char* jwt_key_reload_env = std::getenv("JWT_KEY_RELOAD_SEC");
 
     std::string redis_url = redis_url_env ? redis_url_env : "tcp://127.0.0.1:6379";
     std::string db_url = db_url_env ? db_url_env : "postgresql://localhost/saasforge";
     std::string jwt_public_key_path = jwt_public_key_path_env ? jwt_public_key_path_env : "./certs/jwt-public.pem";
     std::string jwt_private_key_path = jwt_private_key_path_env ? jwt_private_key_path_env : "./certs/jwt-private.pem";
+    std::string api_key_pepper = api_key_pepper_env ? api_key_pepper_env : "";
+    // Legacy (Argon2-hashed) keys are rehashed on first use; opt-in for the migration window only
+    bool api_key_legacy_scan = api_key_legacy_scan_env && std::string(api_key_legacy_scan_env) == "1";
+    // Key files are re-read this often and rotated in when they change (0 = never)
+    std::chrono::seconds jwt_key_reload(jwt_key_reload_env ? std::stoi(jwt_key_reload_env) : 60);
 
     // Initialize Redis client
-    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url);
+    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url, saasforge::common::RedisOptions::FromEnv());
 
     // Initialize database pool
-    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, 10);
+    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, saasforge::common::DbPoolOptions::FromEnv());
 
     // Load JWT keys
     std::string jwt_public_key;
@@ -55,14 +75,29 @@ void RunServer() {
         jwt_private_key = "";
     }
 
+    // OAuth providers: discovery documents and keys cached, connections kept open between logins
+    auto oauth_client = std::make_shared<saasforge::auth::OAuthClient>(saasforge::auth::OAuthClientOptions::FromEnv());
+
+    // Argon2 parameters for new hashes (calibrated to PASSWORD_HASH_CALIBRATE_MS when set);
+    // before the hashing pool, which sizes itself from the policy's parallelism
+    saasforge::common::PasswordHasher::SetPolicy(saasforge::common::PasswordHashPolicy::FromEnv());
+    std::cout << "Password hash policy: " << saasforge::common::PasswordHasher::Policy().ToString() << std::endl;
+
     // Create auth service
-    saasforge::auth::AuthServiceImpl service(
+    auto service = std::make_shared<saasforge::auth::AuthServiceImpl>(
         redis_client,
         db_pool,
         jwt_public_key,
-        jwt_private_key
+        jwt_private_key,
+        api_key_pepper,
+        api_key_legacy_scan,
+        std::make_shared<saasforge::common::PasswordHashingPool>(
+            saasforge::common::PasswordHashingOptions::FromEnv()),
+        oauth_client
     );
 
+    // grpc.health.v1.Health: NOT_SERVING until warm-up completes (below)
+    grpc::EnableDefaultHealthCheckService(true);
     ServerBuilder builder;
 
     // Setup mTLS credentials
@@ -86,12 +121,98 @@ void RunServer() {
         builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     }
 
-    builder.RegisterService(&service);
+    // Threading model: sync, or callback API with a bounded executor (GRPC_SERVER_MODE)
+    auto server_options = saasforge::common::ServerOptions::FromEnv();
+    server_options.ApplyTo(builder);
+
+    // Tracing (traceparent in, OTLP out), per-method metrics, and the tenant context
+    // parsed once per RPC; calls outside PublicMethods() need a tenant or user
+    saasforge::common::TenantContextOptions tenant_options;
+    tenant_options.public_methods = saasforge::auth::PublicMethods();
+    saasforge::common::AddServerInterceptors(builder, std::move(tenant_options));
+
+    std::shared_ptr<saasforge::common::Executor> executor;
+    auto grpc_service = saasforge::common::MakeService<
+        saasforge::auth::AuthServiceSync,
+        saasforge::auth::AuthServiceCallback
+    >(server_options, service, executor);
+    builder.RegisterService(grpc_service.get());
+    std::cout << "Server mode: " << server_options.Describe() << std::endl;
 
     std::unique_ptr<Server> server(builder.BuildAndStart());
     std::cout << "Auth Service listening on " << server_address << std::endl;
 
-    server->Wait();
+    // Prometheus scrape endpoint (METRICS_PORT, 0 = disabled)
+    auto metrics_options = saasforge::common::MetricsServerOptions::FromEnv();
+    std::unique_ptr<saasforge::common::MetricsServer> metrics_server;
+    if (metrics_options.port != 0) {
+        saasforge::common::ExportAllocatorMetrics(saasforge::common::MetricsRegistry::Global());
+        metrics_server = std::make_unique<saasforge::common::MetricsServer>(
+            saasforge::common::MetricsRegistry::Global(), metrics_options);
+        std::cout << "Metrics available on :" << metrics_server->Port() << "/metrics" << std::endl;
+        if (!metrics_options.profiling.token.empty()) {
+            auto& profiler = saasforge::common::Profiler::Default();
+            std::cout << "Profiling available on :" << metrics_server->Port() << "/debug/pprof/ (cpu: "
+                      << (profiler.CpuAvailable() ? profiler.CpuBackend() : "none") << ", heap: "
+                      << (profiler.HeapAvailable() ? profiler.HeapBackend() : "none") << ")" << std::endl;
+        }
+    }
+
+    // JWT key reloader on the background executor, started once warm-up passes
+    uint64_t key_reloader = 0;
+
+    // SIGTERM (rolling deploy): drain in-flight RPCs, then flush and close in dependency order
+    saasforge::common::GracefulShutdown shutdown(saasforge::common::ShutdownOptions::FromEnv());
+    shutdown.Add("jwt-key-reload", [&key_reloader] { saasforge::common::Executor::Background().Cancel(key_reloader); });
+    shutdown.Add("executor", [&executor] {
+        if (executor) {
+            executor->Shutdown();
+        }
+    });
+    shutdown.Add("oauth", [&oauth_client] { oauth_client->Shutdown(); });
+    shutdown.Add("database", [&db_pool, &shutdown] { db_pool->Shutdown(shutdown.Options().close_timeout); });
+    shutdown.Add("metrics", [&metrics_server] {
+        if (metrics_server) {
+            metrics_server->Shutdown();
+        }
+    });
+    shutdown.Add("tracing", [] { saasforge::common::Tracer::Global().Shutdown(); });
+
+    // Connections open and caches primed before readiness probes see SERVING
+    saasforge::common::Warmup warmup(saasforge::common::WarmupOptions::FromEnv());
+    warmup.Add("database", saasforge::common::Warmup::PingDatabase(db_pool), true);
+    warmup.Add("redis", saasforge::common::Warmup::ConnectRedis(redis_client), true);
+    warmup.Add("auth", [&service] { service->WarmUp(); });
+    warmup.Add("oauth", [&oauth_client] { oauth_client->WarmUp(); });   // A provider outage only slows its first login
+    if (!warmup.Run(server->GetHealthCheckService())) {
+        throw std::runtime_error("Warm-up failed");
+    }
+
+    // Mounted secrets are updated in place: pick up a rotated key pair without a restart
+    if (jwt_key_reload.count() > 0) {
+        auto reload = std::chrono::duration_cast<std::chrono::milliseconds>(jwt_key_reload);
+        key_reloader = saasforge::common::Executor::Background().SchedulePeriodic(
+            reload,
+            [&, loaded_public = jwt_public_key, loaded_private = jwt_private_key]() mutable {
+                try {
+                    std::string public_key = ReadFile(jwt_public_key_path);
+                    std::string private_key = ReadFile(jwt_private_key_path);
+                    if (public_key != loaded_public || private_key != loaded_private) {
+                        service->RotateJwtKeys(public_key, private_key);
+                        loaded_public = std::move(public_key);
+                        loaded_private = std::move(private_key);
+                    }
+                } catch (const std::exception& e) {
+                    // Half-written secret updates land here too; the next pass retries
+                    saasforge::common::LogWarn("JWT key reload failed", {{"error", e.what()}});
+                }
+            },
+            reload);
+    }
+
+    shutdown.Wait();
+    shutdown.Run(server.get(), server->GetHealthCheckService());
+    saasforge::common::Logger::Global().Flush();
 }
 
 int main(int argc, char** argv) {
@@ -0,0 +1,598 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description OAuth 2 / OpenID Connect client: cached discovery and JWKS, pooled provider connections implementation
+ */
+
+#include "auth/oauth_client.h"
+#include "common/curl_pool.h"
+#include "common/env.h"
+#include "common/jwt_keys.h"
+#include "common/jwt_signer.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include <cctype>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <curl/curl.h>
+
+namespace saasforge {
+namespace auth {
+
+namespace {
+
+constexpr const char* USER_AGENT = "SaaSForge-Auth/1.0";
+
+std::string PercentEncode(const std::string& value) {
+    static constexpr char HEX[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size());
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded += static_cast<char>(c);
+        } else {
+            encoded += '%';
+            encoded += HEX[c >> 4];
+            encoded += HEX[c & 0xf];
+        }
+    }
+    return encoded;
+}
+
+// JSON field access; missing, null or mistyped fields read as empty
+
+const picojson::value& Field(const picojson::value& value, const char* name) {
+    static const picojson::value null;
+    if (!value.is<picojson::object>()) {
+        return null;
+    }
+    const auto& object = value.get<picojson::object>();
+    auto it = object.find(name);
+    return it == object.end() ? null : it->second;
+}
+
+std::string String(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<std::string>() ? field.get<std::string>() : "";
+}
+
+bool Bool(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    // Some providers send "true" as a string
+    return (field.is<bool>() && field.get<bool>()) || (field.is<std::string>() && field.get<std::string>() == "true");
+}
+
+/// Numeric or string id
+std::string Id(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    if (field.is<int64_t>()) {
+        return std::to_string(field.get<int64_t>());
+    }
+    return field.is<std::string>() ? field.get<std::string>() : "";
+}
+
+picojson::value ParseJson(const std::string& body) {
+    picojson::value value;
+    std::string error = picojson::parse(value, body);
+    if (!error.empty() || !value.is<picojson::object>()) {
+        return picojson::value();
+    }
+    return value;
+}
+
+/// Body of a provider's 200 response; a transport failure or server error is the provider being unavailable
+picojson::value Expect(const OAuthHttpResponse& response, const std::string& what) {
+    if (response.status == 0) {
+        throw std::runtime_error(what + " failed: " + response.error);
+    }
+    if (response.status != 200) {
+        throw std::runtime_error(what + " failed: HTTP " + std::to_string(response.status));
+    }
+    auto body = ParseJson(response.body);
+    if (body.is<picojson::null>()) {
+        throw std::runtime_error(what + " failed: invalid JSON");
+    }
+    return body;
+}
+
+size_t AppendBody(char* data, size_t size, size_t count, void* user) {
+    static_cast<OAuthHttpResponse*>(user)->body.append(data, size * count);
+    return size * count;
+}
+
+/// GET when form is null; calls are synchronous (one per login step)
+OAuthHttpResponse Perform(common::CurlPool& pool, const std::string& url, const std::string* form,
+                          const std::vector<std::string>& headers) {
+    OAuthHttpResponse response;
+    CURL* easy = pool.TakeEasy();
+    if (!easy) {
+        response.error = "curl_easy_init failed";
+        return response;
+    }
+
+    curl_slist* header_list = curl_slist_append(nullptr, "Expect:");  // No 100-continue round trip
+    for (const auto& header : headers) {
+        header_list = curl_slist_append(header_list, header.c_str());
+    }
+    char error[CURL_ERROR_SIZE] = {0};
+
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    if (form) {
+        curl_easy_setopt(easy, CURLOPT_POST, 1L);
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, form->data());
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(form->size()));
+    } else {
+        curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+    }
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, header_list);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, AppendBody);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, error);
+
+    CURLcode result = curl_easy_perform(easy);
+    if (result == CURLE_OK) {
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status);
+    } else {
+        response.status = 0;
+        response.error = error[0] ? error : curl_easy_strerror(result);
+    }
+
+    curl_slist_free_all(header_list);
+    pool.ReturnEasy(easy);
+    return response;
+}
+
+} // namespace
+
+OAuthClientOptions OAuthClientOptions::FromEnv() {
+    OAuthClientOptions options;
+    options.metadata_refresh =
+        std::chrono::seconds(common::EnvInt("OAUTH_METADATA_REFRESH_S", options.metadata_refresh.count()));
+    options.unknown_kid_refresh =
+        std::chrono::seconds(common::EnvInt("OAUTH_UNKNOWN_KID_REFRESH_S", options.unknown_kid_refresh.count()));
+    options.connect_timeout =
+        std::chrono::milliseconds(common::EnvInt("OAUTH_CONNECT_TIMEOUT_MS", options.connect_timeout.count()));
+    options.request_timeout =
+        std::chrono::milliseconds(common::EnvInt("OAUTH_REQUEST_TIMEOUT_MS", options.request_timeout.count()));
+
+    auto add = [&options](OAuthProviderConfig config, const char* id_var, const char* secret_var) {
+        config.client_id = common::EnvString(id_var);
+        config.client_secret = common::EnvString(secret_var);
+        if (!config.client_id.empty()) {
+            options.providers.push_back(std::move(config));
+        }
+    };
+
+    OAuthProviderConfig google;
+    google.name = "google";
+    google.scopes = "openid email profile";
+    google.discovery_url = "https://accounts.google.com/.well-known/openid-configuration";
+    add(std::move(google), "OAUTH_GOOGLE_CLIENT_ID", "OAUTH_GOOGLE_CLIENT_SECRET");
+
+    OAuthProviderConfig microsoft;
+    microsoft.name = "microsoft";
+    microsoft.scopes = "openid email profile";
+    microsoft.discovery_url = "https://login.microsoftonline.com/" +
+                              common::EnvString("OAUTH_MICROSOFT_TENANT", "common") +
+                              "/v2.0/.well-known/openid-configuration";
+    add(std::move(microsoft), "OAUTH_MICROSOFT_CLIENT_ID", "OAUTH_MICROSOFT_CLIENT_SECRET");
+
+    OAuthProviderConfig github;
+    github.name = "github";
+    github.scopes = "read:user user:email";
+    github.authorization_endpoint = "https://github.com/login/oauth/authorize";
+    github.token_endpoint = "https://github.com/login/oauth/access_token";
+    github.userinfo_endpoint = "https://api.github.com/user";
+    github.emails_endpoint = "https://api.github.com/user/emails";
+    add(std::move(github), "OAUTH_GITHUB_CLIENT_ID", "OAUTH_GITHUB_CLIENT_SECRET");
+
+    return options;
+}
+
+OAuthHttp OAuthHttp::Curl(const OAuthClientOptions& options) {
+    // GitHub's API refuses requests without a User-Agent
+    auto pool = std::make_shared<common::CurlPool>(
+        common::CurlPoolOptions{USER_AGENT, "https", options.connect_timeout, options.request_timeout});
+    OAuthHttp http;
+    http.get = [pool](const std::string& url, const std::vector<std::string>& headers) {
+        return Perform(*pool, url, nullptr, headers);
+    };
+    http.post = [pool](const std::string& url, const std::string& form, const std::vector<std::string>& headers) {
+        return Perform(*pool, url, &form, headers);
+    };
+    return http;
+}
+
+OAuthClient::OAuthClient(OAuthClientOptions options, OAuthHttp http)
+    : options_(std::move(options)), http_(std::move(http)) {
+    if (!http_.get || !http_.post) {
+        http_ = OAuthHttp::Curl(options_);
+    }
+
+    bool any_oidc = false;
+    for (const auto& config : options_.providers) {
+        auto provider = std::make_unique<Provider>();
+        provider->config = config;
+        any_oidc = any_oidc || config.Oidc();
+        providers_[config.name] = std::move(provider);
+    }
+
+    metrics_collector_ = common::MetricsRegistry::Global().AddCollector([this](common::MetricsWriter& writer) {
+        auto stats = GetStats();
+        writer.AddCounter("saasforge_auth_oauth_exchanges_total", "OAuth codes exchanged for a verified identity", {},
+                          static_cast<double>(stats.exchanges));
+        writer.AddCounter("saasforge_auth_oauth_rejected_total", "OAuth codes or id tokens rejected", {},
+                          static_cast<double>(stats.rejected));
+        writer.AddCounter("saasforge_auth_oauth_metadata_loads_total",
+                          "OAuth discovery documents and key sets fetched", {},
+                          static_cast<double>(stats.metadata_loads));
+        writer.AddCounter("saasforge_auth_oauth_metadata_failures_total",
+                          "OAuth discovery or key set fetches that failed", {},
+                          static_cast<double>(stats.metadata_failures));
+    });
+
+    // Plain OAuth 2 providers have nothing to refresh
+    if (any_oidc && options_.metadata_refresh.count() > 0) {
+        refresh_thread_ = std::thread(&OAuthClient::RefreshLoop, this);
+    }
+}
+
+OAuthClient::~OAuthClient() {
+    Shutdown();
+    common::MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+void OAuthClient::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex_);
+        stopping_ = true;
+    }
+    refresh_cv_.notify_all();
+    if (refresh_thread_.joinable()) {
+        refresh_thread_.join();
+    }
+}
+
+bool OAuthClient::Configured(const std::string& provider) const {
+    return providers_.count(provider) > 0;
+}
+
+OAuthClientStats OAuthClient::GetStats() const {
+    OAuthClientStats stats;
+    stats.exchanges = exchanges_.load();
+    stats.rejected = rejected_.load();
+    stats.metadata_loads = metadata_loads_.load();
+    stats.metadata_failures = metadata_failures_.load();
+    return stats;
+}
+
+std::string OAuthClient::FormEncode(const std::vector<std::pair<std::string, std::string>>& params) {
+    std::string encoded;
+    for (const auto& [name, value] : params) {
+        if (!encoded.empty()) {
+            encoded += '&';
+        }
+        encoded.append(PercentEncode(name)).append("=").append(PercentEncode(value));
+    }
+    return encoded;
+}
+
+void OAuthClient::WarmUp() {
+    std::string failed;
+    for (auto& [name, provider] : providers_) {
+        try {
+            std::lock_guard<std::mutex> lock(provider->load_mutex);
+            Reload(*provider, false);
+        } catch (const std::exception& e) {
+            common::LogWarn("OAuth provider metadata unavailable", {{"provider", name}, {"error", e.what()}});
+            failed += failed.empty() ? name : ", " + name;
+        }
+    }
+    if (!failed.empty()) {
+        throw std::runtime_error("OAuth provider metadata unavailable: " + failed);
+    }
+}
+
+std::string OAuthClient::AuthorizationUrl(const std::string& provider_name, const std::string& redirect_uri,
+                                          const std::string& state, const std::string& nonce) {
+    Provider& provider = Find(provider_name);
+    auto metadata = Load(provider);
+
+    std::vector<std::pair<std::string, std::string>> params = {
+        {"response_type", "code"},
+        {"client_id", provider.config.client_id},
+        {"redirect_uri", redirect_uri},
+        {"scope", provider.config.scopes},
+        {"state", state},
+    };
+    if (provider.config.Oidc()) {
+        params.emplace_back("nonce", nonce);
+    }
+
+    const std::string& endpoint = metadata->authorization_endpoint;
+    return endpoint + (endpoint.find('?') == std::string::npos ? "?" : "&") + FormEncode(params);
+}
+
+OAuthIdentity OAuthClient::Exchange(const std::string& provider_name, const std::string& code,
+                                    const std::string& redirect_uri, const std::string& nonce) {
+    Provider& provider = Find(provider_name);
+    auto metadata = Load(provider);
+
+    // The one round trip a login has to make
+    auto response = http_.post(metadata->token_endpoint,
+                               FormEncode({
+                                   {"grant_type", "authorization_code"},
+                                   {"code", code},
+                                   {"redirect_uri", redirect_uri},
+                                   {"client_id", provider.config.client_id},
+                                   {"client_secret", provider.config.client_secret},
+                               }),
+                               {"Accept: application/json", "Content-Type: application/x-www-form-urlencoded"});
+
+    // 400 is the provider refusing the code (invalid_grant); GitHub says so in a 200
+    auto body = ParseJson(response.body);
+    std::string error = String(body, "error");
+    if (response.status == 400 || (response.status == 200 && !error.empty())) {
+        rejected_++;
+        throw std::invalid_argument("Authorization code rejected: " + (error.empty() ? "HTTP 400" : error));
+    }
+    Expect(response, "Token exchange");
+
+    OAuthIdentity identity;
+    if (provider.config.Oidc()) {
+        std::string id_token = String(body, "id_token");
+        if (id_token.empty()) {
+            rejected_++;
+            throw std::invalid_argument("Token response has no id_token");
+        }
+        identity = VerifyIdToken(provider, metadata, id_token, nonce);
+    } else {
+        std::string access_token = String(body, "access_token");
+        if (access_token.empty()) {
+            rejected_++;
+            throw std::invalid_argument("Token response has no access_token");
+        }
+        identity = FetchUserInfo(provider, *metadata, access_token);
+    }
+
+    exchanges_++;
+    return identity;
+}
+
+OAuthClient::Provider& OAuthClient::Find(const std::string& provider) const {
+    auto it = providers_.find(provider);
+    if (it == providers_.end()) {
+        throw std::invalid_argument("OAuth provider not configured: " + provider);
+    }
+    return *it->second;
+}
+
+std::shared_ptr<const OAuthClient::Metadata> OAuthClient::Current(Provider& provider) const {
+    std::lock_guard<std::mutex> lock(metadata_mutex_);
+    return provider.metadata;
+}
+
+std::shared_ptr<const OAuthClient::Metadata> OAuthClient::Load(Provider& provider) {
+    if (auto metadata = Current(provider)) {
+        return metadata;
+    }
+    std::lock_guard<std::mutex> lock(provider.load_mutex);
+    if (auto metadata = Current(provider)) {
+        return metadata;   // Loaded by the caller we waited for
+    }
+    return Reload(provider, false);
+}
+
+std::shared_ptr<const OAuthClient::Metadata> OAuthClient::Reload(Provider& provider, bool keep_discovery) {
+    // Caller holds provider.load_mutex
+    const auto& config = provider.config;
+    auto current = Current(provider);
+    auto metadata = std::make_shared<Metadata>();
+
+    try {
+        if (keep_discovery && current) {
+            *metadata = *current;
+        } else if (config.Oidc()) {
+            auto document = Expect(http_.get(config.discovery_url, {"Accept: application/json"}),
+                                   "OAuth discovery for " + config.name);
+            metadata_loads_++;
+            metadata->authorization_endpoint = String(document, "authorization_endpoint");
+            metadata->token_endpoint = String(document, "token_endpoint");
+            metadata->userinfo_endpoint = String(document, "userinfo_endpoint");
+            metadata->issuer = String(document, "issuer");
+            metadata->jwks_uri = String(document, "jwks_uri");
+            if (metadata->authorization_endpoint.empty() || metadata->token_endpoint.empty() ||
+                metadata->issuer.empty() || metadata->jwks_uri.empty()) {
+                throw std::runtime_error("OAuth discovery for " + config.name + " is incomplete");
+            }
+        } else {
+            metadata->authorization_endpoint = config.authorization_endpoint;
+            metadata->token_endpoint = config.token_endpoint;
+            metadata->userinfo_endpoint = config.userinfo_endpoint;
+        }
+
+        if (config.Oidc()) {
+            metadata->keys = FetchKeys(provider, metadata->jwks_uri);
+            metadata->keys_loaded = std::chrono::steady_clock::now();
+        }
+    } catch (const std::exception&) {
+        metadata_failures_++;
+        throw;
+    }
+
+    std::shared_ptr<const Metadata> published = metadata;
+    std::lock_guard<std::mutex> lock(metadata_mutex_);
+    provider.metadata = published;
+    return published;
+}
+
+std::unordered_map<std::string, std::shared_ptr<const OAuthClient::Verifier>> OAuthClient::FetchKeys(
+    const Provider& provider, const std::string& jwks_uri) {
+    auto response = http_.get(jwks_uri, {"Accept: application/json"});
+    Expect(response, "OAuth keys for " + provider.config.name);
+    metadata_loads_++;
+
+    std::vector<common::JwtPublicKey> keys;
+    try {
+        keys = common::ParseJwtKeys(response.body);
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error("OAuth keys for " + provider.config.name + " unreadable: " + e.what());
+    }
+
+    // Parsed once per key set, not per login. Only the key's own algorithm
+    // is allowed, and the audience must be our client id.
+    std::unordered_map<std::string, std::shared_ptr<const Verifier>> verifiers;
+    for (const auto& key : keys) {
+        auto verifier = jwt::verify()
+                            .with_audience(provider.config.client_id)
+                            .leeway(static_cast<size_t>(options_.clock_leeway.count()));
+        switch (common::JwtAlgorithmForKey(key.pem)) {
+            case common::JwtAlgorithm::RS256:
+                verifier.allow_algorithm(jwt::algorithm::rs256{key.pem});
+                break;
+            case common::JwtAlgorithm::ES256:
+                verifier.allow_algorithm(jwt::algorithm::es256{key.pem});
+                break;
+            case common::JwtAlgorithm::EDDSA:
+                verifier.allow_algorithm(jwt::algorithm::ed25519{key.pem});
+                break;
+        }
+        verifiers.emplace(key.kid, std::make_shared<const Verifier>(std::move(verifier)));
+    }
+    if (verifiers.empty()) {
+        throw std::runtime_error("OAuth keys for " + provider.config.name + " hold no signature key");
+    }
+    return verifiers;
+}
+
+OAuthIdentity OAuthClient::VerifyIdToken(Provider& provider, std::shared_ptr<const Metadata> metadata,
+                                         const std::string& id_token, const std::string& nonce) {
+    auto reject = [this](const std::string& reason) {
+        rejected_++;
+        return std::invalid_argument("id token rejected: " + reason);
+    };
+
+    std::optional<jwt::decoded_jwt<jwt::traits::kazuho_picojson>> decoded;
+    try {
+        decoded.emplace(jwt::decode(id_token));
+    } catch (const std::exception& e) {
+        throw reject(std::string("malformed: ") + e.what());
+    }
+    if (!decoded->has_expires_at()) {
+        throw reject("no exp claim");
+    }
+    std::string kid = decoded->has_key_id() ? decoded->get_key_id() : "";
+
+    auto key = metadata->keys.find(kid);
+    if (key == metadata->keys.end()) {
+        // The provider rotated its keys since the last refresh; reload at once, rate-limited
+        std::lock_guard<std::mutex> lock(provider.load_mutex);
+        auto current = Current(provider);
+        if (current && current->keys_loaded == metadata->keys_loaded &&
+            std::chrono::steady_clock::now() - current->keys_loaded >= options_.unknown_kid_refresh) {
+            try {
+                current = Reload(provider, true);
+            } catch (const std::exception& e) {
+                throw std::runtime_error(std::string("OAuth key refresh failed: ") + e.what());
+            }
+        }
+        metadata = current ? current : metadata;
+        key = metadata->keys.find(kid);
+        if (key == metadata->keys.end()) {
+            throw reject("unknown key id '" + kid + "'");
+        }
+    }
+
+    try {
+        key->second->verify(*decoded);
+    } catch (const std::exception& e) {
+        throw reject(e.what());
+    }
+
+    picojson::value payload(decoded->get_payload_json());
+
+    // Multi-tenant issuers ("https://login.microsoftonline.com/{tenantid}/v2.0") are per directory
+    std::string issuer = metadata->issuer;
+    auto placeholder = issuer.find("{tenantid}");
+    if (placeholder != std::string::npos) {
+        std::string tid = String(payload, "tid");
+        if (tid.empty()) {
+            throw reject("no tid claim");
+        }
+        issuer.replace(placeholder, sizeof("{tenantid}") - 1, tid);
+    }
+    if (String(payload, "iss") != issuer) {
+        throw reject("issuer mismatch");
+    }
+    if (String(payload, "nonce") != nonce) {
+        throw reject("nonce mismatch");
+    }
+
+    OAuthIdentity identity;
+    identity.provider_user_id = String(payload, "sub");
+    identity.email = String(payload, "email");
+    identity.email_verified = Bool(payload, "email_verified");
+    if (identity.provider_user_id.empty()) {
+        throw reject("no sub claim");
+    }
+    return identity;
+}
+
+OAuthIdentity OAuthClient::FetchUserInfo(const Provider& provider, const Metadata& metadata,
+                                         const std::string& access_token) {
+    std::vector<std::string> headers = {"Authorization: Bearer " + access_token, "Accept: application/json"};
+    auto user = Expect(http_.get(metadata.userinfo_endpoint, headers), "OAuth user info for " + provider.config.name);
+
+    OAuthIdentity identity;
+    identity.provider_user_id = Id(user, "id");
+    if (identity.provider_user_id.empty()) {
+        rejected_++;
+        throw std::invalid_argument("OAuth user info has no id");
+    }
+
+    // GitHub shows only verified addresses as the public email; a private one costs another call
+    identity.email = String(user, "email");
+    identity.email_verified = !identity.email.empty();
+    if (identity.email.empty() && !provider.config.emails_endpoint.empty()) {
+        auto response = http_.get(provider.config.emails_endpoint, headers);
+        picojson::value emails;
+        if (response.status == 200 && picojson::parse(emails, response.body).empty() &&
+            emails.is<picojson::array>()) {
+            for (const auto& entry : emails.get<picojson::array>()) {
+                if (Bool(entry, "primary") && Bool(entry, "verified")) {
+                    identity.email = String(entry, "email");
+                    identity.email_verified = true;
+                    break;
+                }
+            }
+        }
+    }
+    return identity;
+}
+
+void OAuthClient::RefreshLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(refresh_mutex_);
+            if (refresh_cv_.wait_for(lock, options_.metadata_refresh, [this] { return stopping_; })) {
+                return;
+            }
+        }
+        for (auto& [name, provider] : providers_) {
+            if (!provider->config.Oidc()) {
+                continue;
+            }
+            try {
+                std::lock_guard<std::mutex> lock(provider->load_mutex);
+                Reload(*provider, false);
+            } catch (const std::exception& e) {
+                // The cached copy stays in use
+                common::LogWarn("OAuth metadata refresh failed", {{"provider", name}, {"error", e.what()}});
+            }
+        }
+    }
+}
+
+} // namespace auth
+} // namespace saasforge
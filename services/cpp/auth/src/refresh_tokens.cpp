@@ -0,0 +1,360 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Refresh-token families in Redis: one-round-trip rotation, reuse detection and bulk revocation implementation
+ */
+
+#include "auth/refresh_tokens.h"
+#include "common/codec.h"
+#include "common/sha256.h"
+#include "common/string_builder.h"
+#include <chrono>
+#include <cstdlib>
+
+namespace saasforge {
+namespace auth {
+
+namespace {
+
+constexpr size_t FAMILY_ID_BYTES = 8;
+constexpr size_t SECRET_BYTES = 32;
+// Bounds RevokeAll() against a client that keeps logging in meanwhile
+constexpr int REVOKE_ALL_ROUNDS = 3;
+
+// KEYS[1] = family hash, KEYS[2] = the user's family index
+// ARGV = family id, token digest, tenant_id, email, roles, checked_at, issued_at ms, jti, jti_exp,
+//        ttl seconds, now (Unix seconds)
+constexpr const char* ISSUE_LUA = R"(
+redis.call('HSET', KEYS[1], 'current', ARGV[2], 'tenant_id', ARGV[3], 'email', ARGV[4],
+           'roles', ARGV[5], 'checked_at', ARGV[6], 'issued_at', ARGV[7], 'jti', ARGV[8], 'jti_exp', ARGV[9])
+redis.call('EXPIRE', KEYS[1], ARGV[10])
+redis.call('ZREMRANGEBYSCORE', KEYS[2], '-inf', ARGV[11])
+redis.call('ZADD', KEYS[2], ARGV[11] + ARGV[10], ARGV[1])
+redis.call('EXPIRE', KEYS[2], ARGV[10])
+return 1
+)";
+
+// KEYS[1] = tenant index, ARGV = user id, ttl seconds, now (Unix seconds)
+constexpr const char* INDEX_USER_LUA = R"(
+redis.call('ZREMRANGEBYSCORE', KEYS[1], '-inf', ARGV[3])
+redis.call('ZADD', KEYS[1], ARGV[3] + ARGV[2], ARGV[1])
+redis.call('EXPIRE', KEYS[1], ARGV[2])
+return 1
+)";
+
+// KEYS[1] = family hash, KEYS[2] = the user's family index
+// ARGV = presented digest, successor digest, family id, jti, jti_exp, ttl seconds, now
+// Returns {'ok', tenant_id, email, roles, checked_at, issued_at}, {'missing'} or {'reused'};
+// a reuse changes nothing here: the caller then revokes every family (REVOKE_FAMILIES_LUA)
+constexpr const char* ROTATE_LUA = R"(
+local current = redis.call('HGET', KEYS[1], 'current')
+if not current then
+    return {'missing'}
+end
+if current ~= ARGV[1] then
+    return {'reused'}
+end
+redis.call('HSET', KEYS[1], 'current', ARGV[2], 'jti', ARGV[4], 'jti_exp', ARGV[5])
+redis.call('EXPIRE', KEYS[1], ARGV[6])
+redis.call('ZREMRANGEBYSCORE', KEYS[2], '-inf', ARGV[7])
+redis.call('ZADD', KEYS[2], ARGV[7] + ARGV[6], ARGV[3])
+redis.call('EXPIRE', KEYS[2], ARGV[6])
+local claims = redis.call('HMGET', KEYS[1], 'tenant_id', 'email', 'roles', 'checked_at', 'issued_at')
+return {'ok', claims[1], claims[2], claims[3], claims[4], claims[5]}
+)";
+
+// KEYS[1] = family hash, ARGV = tenant_id, email, roles, checked_at
+constexpr const char* UPDATE_CLAIMS_LUA = R"(
+if redis.call('EXISTS', KEYS[1]) == 0 then
+    return 0
+end
+redis.call('HSET', KEYS[1], 'tenant_id', ARGV[1], 'email', ARGV[2], 'roles', ARGV[3], 'checked_at', ARGV[4])
+return 1
+)";
+
+// KEYS[1] = family hash, ARGV[1] = token digest
+constexpr const char* IS_CURRENT_LUA = R"(
+if redis.call('HGET', KEYS[1], 'current') == ARGV[1] then
+    return 1
+end
+return 0
+)";
+
+// KEYS[1] = family hash, KEYS[2] = the user's family index, ARGV[1] = family id
+constexpr const char* REVOKE_LUA = R"(
+redis.call('DEL', KEYS[1])
+redis.call('ZREM', KEYS[2], ARGV[1])
+return 1
+)";
+
+// KEYS[1] = the user's family index
+constexpr const char* LIST_FAMILIES_LUA = R"(
+return redis.call('ZRANGE', KEYS[1], 0, -1)
+)";
+
+// KEYS[1] = the user's family index, KEYS[2..n] = family hashes, ARGV[1..n-1] = their family ids
+// Returns {families still indexed, jti, jti_exp, ...}; the index is dropped once empty
+constexpr const char* REVOKE_FAMILIES_LUA = R"(
+local revoked = {'0'}
+for i = 2, #KEYS do
+    local access = redis.call('HMGET', KEYS[i], 'jti', 'jti_exp')
+    if access[1] then
+        revoked[#revoked + 1] = access[1]
+        revoked[#revoked + 1] = access[2] or '0'
+    end
+    redis.call('DEL', KEYS[i])
+    redis.call('ZREM', KEYS[1], ARGV[i - 1])
+end
+local remaining = redis.call('ZCARD', KEYS[1])
+if remaining == 0 then
+    redis.call('DEL', KEYS[1])
+end
+revoked[1] = tostring(remaining)
+return revoked
+)";
+
+// KEYS[1] = tenant index, ARGV[1] = now (Unix seconds)
+// UNLINK frees a large index off the Redis main thread
+constexpr const char* DROP_TENANT_INDEX_LUA = R"(
+local users = redis.call('ZCOUNT', KEYS[1], ARGV[1], '+inf')
+redis.call('UNLINK', KEYS[1])
+return users
+)";
+
+int64_t UnixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool IsHex(std::string_view value, size_t length) {
+    if (value.size() != length) {
+        return false;
+    }
+    for (char c : value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string JoinRoles(const std::vector<std::string>& roles) {
+    std::string joined;
+    for (const auto& role : roles) {
+        if (!joined.empty()) {
+            joined += ',';
+        }
+        joined += role;
+    }
+    return joined;
+}
+
+std::vector<std::string> SplitRoles(std::string_view joined) {
+    std::vector<std::string> roles;
+    while (!joined.empty()) {
+        size_t comma = joined.find(',');
+        roles.emplace_back(joined.substr(0, comma));
+        joined = comma == std::string_view::npos ? std::string_view() : joined.substr(comma + 1);
+    }
+    return roles;
+}
+
+/// "refresh:{user_id}:" (keys of one user share a cluster slot)
+std::string FamilyPrefix(std::string_view user_id) {
+    common::KeyBuilder<> prefix("refresh:", common::HashTag{user_id}, ":");
+    return std::string(prefix.View());
+}
+
+std::string TenantIndexKey(std::string_view tenant_id) {
+    common::KeyBuilder<> key("sessions:tenant:", common::HashTag{tenant_id});
+    return std::string(key.View());
+}
+
+} // namespace
+
+std::optional<RefreshTokenParts> RefreshTokenParts::Parse(std::string_view token) {
+    size_t first = token.find(':');
+    if (first == std::string_view::npos || first == 0) {
+        return std::nullopt;
+    }
+    size_t second = token.find(':', first + 1);
+    if (second == std::string_view::npos) {
+        return std::nullopt;
+    }
+    std::string_view family_id = token.substr(first + 1, second - first - 1);
+    std::string_view secret = token.substr(second + 1);
+    if (!IsHex(family_id, 2 * FAMILY_ID_BYTES) || !IsHex(secret, 2 * SECRET_BYTES)) {
+        return std::nullopt;
+    }
+    return RefreshTokenParts{std::string(token.substr(0, first)), std::string(family_id), std::string(secret)};
+}
+
+RefreshTokenStore::RefreshTokenStore(std::shared_ptr<common::RedisClient> redis_client,
+                                     std::shared_ptr<common::TenantRevocations> revocations)
+    : redis_client_(std::move(redis_client)),
+      revocations_(std::move(revocations)) {
+    if (!revocations_) {
+        revocations_ = std::make_shared<common::TenantRevocations>(nullptr);
+    }
+}
+
+std::string RefreshTokenStore::Issue(const std::string& user_id, const RefreshClaims& claims,
+                                     const AccessTokenId& access) {
+    std::string family_id = common::RandomHex(FAMILY_ID_BYTES);
+    std::string secret = common::RandomHex(SECRET_BYTES);
+    std::string prefix = FamilyPrefix(user_id);
+    std::string family_key = prefix + family_id;
+    std::string families_key = prefix + "families";
+    std::string digest = common::Sha256::Hex(secret);
+    std::string roles = JoinRoles(claims.roles);
+    std::string checked_at = std::to_string(claims.checked_at);
+    std::string issued_at = std::to_string(common::TenantRevocations::NowMillis());
+    std::string jti_exp = std::to_string(access.exp);
+    std::string ttl = std::to_string(TTL_SECONDS);
+    std::string now = std::to_string(UnixNow());
+
+    redis_client_->EvalScript(ISSUE_LUA, {family_key, families_key},
+                              {family_id, digest, claims.tenant_id, claims.email, roles, checked_at,
+                               issued_at, access.jti, jti_exp, ttl, now});
+    if (!claims.tenant_id.empty()) {
+        // Another slot than the user's keys, hence a second call
+        redis_client_->EvalScript(INDEX_USER_LUA, {TenantIndexKey(claims.tenant_id)}, {user_id, ttl, now});
+    }
+    return user_id + ":" + family_id + ":" + secret;
+}
+
+RefreshRotation RefreshTokenStore::Rotate(std::string_view token, const AccessTokenId& access) {
+    RefreshRotation rotation;
+    auto parts = RefreshTokenParts::Parse(token);
+    if (!parts) {
+        return rotation;
+    }
+
+    std::string secret = common::RandomHex(SECRET_BYTES);
+    std::string prefix = FamilyPrefix(parts->user_id);
+    std::string family_key = prefix + parts->family_id;
+    std::string families_key = prefix + "families";
+    std::string presented = common::Sha256::Hex(parts->secret);
+    std::string successor = common::Sha256::Hex(secret);
+    std::string jti_exp = std::to_string(access.exp);
+    std::string ttl = std::to_string(TTL_SECONDS);
+    std::string now = std::to_string(UnixNow());
+
+    auto reply = redis_client_->EvalScriptStrings(ROTATE_LUA, {family_key, families_key},
+                                                  {presented, successor, parts->family_id, access.jti, jti_exp,
+                                                   ttl, now});
+    if (reply.empty() || !reply[0] || *reply[0] == "missing") {
+        return rotation;
+    }
+    if (*reply[0] == "reused") {
+        RevokeAll(parts->user_id);
+        rotation.result = RefreshResult::REUSED;
+        return rotation;
+    }
+
+    reply.resize(6);
+    rotation.claims.tenant_id = reply[1].value_or("");
+    int64_t issued_at = std::strtoll(reply[5].value_or("0").c_str(), nullptr, 10);
+    if (revocations_->IsRevoked(rotation.claims.tenant_id, issued_at)) {
+        // Started before a tenant-wide revocation: this is its first use since
+        Revoke(token);
+        rotation.claims = {};
+        return rotation;
+    }
+
+    rotation.result = RefreshResult::ROTATED;
+    rotation.token = parts->user_id + ":" + parts->family_id + ":" + secret;
+    rotation.claims.email = reply[2].value_or("");
+    rotation.claims.roles = SplitRoles(reply[3].value_or(""));
+    rotation.claims.checked_at = std::strtoll(reply[4].value_or("0").c_str(), nullptr, 10);
+    return rotation;
+}
+
+void RefreshTokenStore::UpdateClaims(std::string_view token, const RefreshClaims& claims) {
+    auto parts = RefreshTokenParts::Parse(token);
+    if (!parts) {
+        return;
+    }
+    std::string family_key = FamilyPrefix(parts->user_id) + parts->family_id;
+    std::string roles = JoinRoles(claims.roles);
+    std::string checked_at = std::to_string(claims.checked_at);
+    redis_client_->EvalScript(UPDATE_CLAIMS_LUA, {family_key}, {claims.tenant_id, claims.email, roles, checked_at});
+}
+
+bool RefreshTokenStore::IsCurrent(std::string_view token) {
+    auto parts = RefreshTokenParts::Parse(token);
+    if (!parts) {
+        return false;
+    }
+    std::string family_key = FamilyPrefix(parts->user_id) + parts->family_id;
+    std::string digest = common::Sha256::Hex(parts->secret);
+    return redis_client_->EvalScript(IS_CURRENT_LUA, {family_key}, {digest}) == 1;
+}
+
+void RefreshTokenStore::Revoke(std::string_view token) {
+    auto parts = RefreshTokenParts::Parse(token);
+    if (!parts) {
+        return;
+    }
+    std::string prefix = FamilyPrefix(parts->user_id);
+    std::string family_key = prefix + parts->family_id;
+    std::string families_key = prefix + "families";
+    redis_client_->EvalScript(REVOKE_LUA, {family_key, families_key}, {parts->family_id});
+}
+
+int64_t RefreshTokenStore::RevokeAll(const std::string& user_id) {
+    std::string prefix = FamilyPrefix(user_id);
+    std::string families_key = prefix + "families";
+    int64_t revoked = 0;
+    // Families issued between listing and revoking stay indexed: list again
+    for (int round = 0; round < REVOKE_ALL_ROUNDS; ++round) {
+        auto families = redis_client_->EvalScriptStrings(LIST_FAMILIES_LUA, {families_key}, {});
+        if (families.empty()) {
+            break;
+        }
+        std::vector<std::string> keys{families_key};
+        std::vector<std::string> family_ids;
+        for (const auto& family_id : families) {
+            if (family_id) {
+                keys.push_back(prefix + *family_id);
+                family_ids.push_back(*family_id);
+            }
+        }
+        auto reply = redis_client_->EvalScriptStringsVector(REVOKE_FAMILIES_LUA, keys, family_ids);
+        if (reply.empty() || !reply[0]) {
+            break;
+        }
+        revoked += static_cast<int64_t>(family_ids.size());
+        BlacklistAccessTokens(reply, 1);
+        if (*reply[0] == "0") {
+            break;
+        }
+    }
+    return revoked;
+}
+
+TenantRevocation RefreshTokenStore::RevokeTenant(const std::string& tenant_id) {
+    TenantRevocation revocation;
+    revocation.revoked_at = revocations_->Revoke(tenant_id);
+    std::string now = std::to_string(UnixNow());
+    revocation.affected_users = redis_client_->EvalScript(DROP_TENANT_INDEX_LUA, {TenantIndexKey(tenant_id)}, {now});
+    return revocation;
+}
+
+void RefreshTokenStore::BlacklistAccessTokens(const std::vector<std::optional<std::string>>& reply, size_t first) {
+    int64_t now = UnixNow();
+    std::vector<std::pair<std::string, int64_t>> tokens;
+    for (size_t i = first; i + 1 < reply.size(); i += 2) {
+        if (!reply[i] || reply[i]->empty() || !reply[i + 1]) {
+            continue;
+        }
+        int64_t ttl = std::strtoll(reply[i + 1]->c_str(), nullptr, 10) - now;
+        if (ttl > 0) {
+            tokens.emplace_back(*reply[i], ttl);
+        }
+    }
+    redis_client_->BlacklistTokens(tokens);
+}
+
+} // namespace auth
+} // namespace saasforge
@@ -0,0 +1,147 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description API key scopes compiled for constant-time checks implementation
+ */
+
+#include "auth/scope_set.h"
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace saasforge {
+namespace auth {
+
+namespace {
+
+/**
+ * Process-wide scope -> id table
+ *
+ * Only granted scopes are interned (requested ones are looked up), so it
+ * grows with the distinct scopes in use, not with traffic.
+ */
+class ScopeRegistry {
+public:
+    static ScopeRegistry& Instance() {
+        static ScopeRegistry registry;
+        return registry;
+    }
+
+    std::optional<uint32_t> Find(std::string_view scope) const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(std::string(scope));
+        if (it == ids_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    /// nullopt once MAX_INTERNED distinct scopes exist
+    std::optional<uint32_t> Intern(const std::string& scope) {
+        if (auto id = Find(scope)) {
+            return id;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(scope);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        if (ids_.size() >= ScopeSet::MAX_INTERNED) {
+            return std::nullopt;
+        }
+        uint32_t id = static_cast<uint32_t>(ids_.size());
+        ids_.emplace(scope, id);
+        return id;
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, uint32_t> ids_;
+};
+
+} // namespace
+
+ScopeSet ScopeSet::Compile(const std::vector<std::string>& scopes) {
+    ScopeSet set;
+    auto& registry = ScopeRegistry::Instance();
+
+    for (const auto& scope : scopes) {
+        if (!scope.empty() && scope.back() == '*') {
+            set.Insert(std::string_view(scope).substr(0, scope.size() - 1), true);
+            continue;
+        }
+        if (auto id = registry.Intern(scope)) {
+            size_t word = *id / 64;
+            if (set.bits_.size() <= word) {
+                set.bits_.resize(word + 1, 0);
+            }
+            set.bits_[word] |= uint64_t{1} << (*id % 64);
+        } else {
+            set.Insert(scope, false);
+        }
+    }
+    return set;
+}
+
+bool ScopeSet::Allows(std::string_view requested_scope) const {
+    // Exact match
+    if (!bits_.empty()) {
+        if (auto id = ScopeRegistry::Instance().Find(requested_scope); id && TestBit(*id)) {
+            return true;
+        }
+    }
+
+    // Wildcard match (e.g., "read:*" matches "read:upload")
+    if (nodes_.empty()) {
+        return false;
+    }
+    uint32_t node = 0;
+    for (char c : requested_scope) {
+        if (nodes_[node].prefix) {
+            return true;
+        }
+        const auto& children = nodes_[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+            [](const std::pair<char, uint32_t>& child, char value) { return child.first < value; });
+        if (it == children.end() || it->first != c) {
+            return false;   // Deny by default (Requirement A-14)
+        }
+        node = it->second;
+    }
+    return nodes_[node].prefix || nodes_[node].exact;
+}
+
+void ScopeSet::Insert(std::string_view scope, bool wildcard) {
+    if (nodes_.empty()) {
+        nodes_.emplace_back();
+    }
+    uint32_t node = 0;
+    for (char c : scope) {
+        auto& children = nodes_[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), c,
+            [](const std::pair<char, uint32_t>& child, char value) { return child.first < value; });
+        if (it != children.end() && it->first == c) {
+            node = it->second;
+            continue;
+        }
+        uint32_t next = static_cast<uint32_t>(nodes_.size());
+        children.insert(it, {c, next});
+        nodes_.emplace_back();   // Invalidates `children`; not used again
+        node = next;
+    }
+    if (wildcard) {
+        nodes_[node].prefix = true;
+    } else {
+        nodes_[node].exact = true;
+    }
+}
+
+bool ScopeSet::TestBit(uint32_t id) const {
+    size_t word = id / 64;
+    return word < bits_.size() && (bits_[word] >> (id % 64)) & 1;
+}
+
+} // namespace auth
+} // namespace saasforge
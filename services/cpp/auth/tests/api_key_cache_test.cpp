@@ -0,0 +1,97 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Unit tests for the verified API key cache (Requirement A-14)
+ */
+
+#include <gtest/gtest.h>
+#include <ctime>
+#include "auth/api_key_cache.h"
+
+namespace saasforge {
+namespace auth {
+namespace test {
+
+class ApiKeyCacheTest : public ::testing::Test {
+protected:
+    ApiKeyEntry MakeEntry(const std::string& key_id, int64_t expires_at = 0) {
+        ApiKeyEntry entry;
+        entry.key_id = key_id;
+        entry.user_id = "user-" + key_id;
+        entry.tenant_id = "tenant-1";
+        entry.scopes = {"read:*", "write:upload"};
+        entry.expires_at = expires_at;
+        return entry;
+    }
+};
+
+TEST_F(ApiKeyCacheTest, MissOnEmptyCache) {
+    ApiKeyCache cache;
+    EXPECT_FALSE(cache.Get("digest").has_value());
+}
+
+TEST_F(ApiKeyCacheTest, HitAfterPut) {
+    ApiKeyCache cache;
+    cache.Put("digest", MakeEntry("k1"), cache.Generation());
+
+    auto entry = cache.Get("digest");
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(entry->user_id, "user-k1");
+    EXPECT_EQ(entry->scopes.size(), 2u);
+}
+
+TEST_F(ApiKeyCacheTest, ZeroTtlNeverServes) {
+    ApiKeyCache cache(std::chrono::seconds(0));
+    cache.Put("digest", MakeEntry("k1"), cache.Generation());
+    EXPECT_FALSE(cache.Get("digest").has_value());
+}
+
+TEST_F(ApiKeyCacheTest, ExpiredKeyNotCached) {
+    ApiKeyCache cache;
+    cache.Put("digest", MakeEntry("k1", static_cast<int64_t>(std::time(nullptr)) - 10), cache.Generation());
+    EXPECT_FALSE(cache.Get("digest").has_value());
+}
+
+TEST_F(ApiKeyCacheTest, InvalidateByKeyIdEvicts) {
+    ApiKeyCache cache;
+    cache.Put("digest-1", MakeEntry("k1"), cache.Generation());
+    cache.Put("digest-2", MakeEntry("k2"), cache.Generation());
+
+    cache.InvalidateByKeyId("k1");
+
+    EXPECT_FALSE(cache.Get("digest-1").has_value());
+    EXPECT_TRUE(cache.Get("digest-2").has_value());
+}
+
+// A revocation that lands while a DB lookup is in flight must win
+TEST_F(ApiKeyCacheTest, PutAfterInvalidationIsDropped) {
+    ApiKeyCache cache;
+    uint64_t generation = cache.Generation();
+
+    cache.InvalidateByKeyId("k1");
+    cache.Put("digest", MakeEntry("k1"), generation);
+
+    EXPECT_FALSE(cache.Get("digest").has_value());
+}
+
+TEST_F(ApiKeyCacheTest, ClearDropsEverything) {
+    ApiKeyCache cache;
+    cache.Put("digest-1", MakeEntry("k1"), cache.Generation());
+    cache.Put("digest-2", MakeEntry("k2"), cache.Generation());
+
+    cache.Clear();
+
+    EXPECT_EQ(cache.Size(), 0u);
+}
+
+TEST_F(ApiKeyCacheTest, SizeBoundedByMaxEntries) {
+    ApiKeyCache cache(std::chrono::seconds(60), 8, 2);
+    for (int i = 0; i < 100; ++i) {
+        cache.Put("digest-" + std::to_string(i), MakeEntry("k" + std::to_string(i)), cache.Generation());
+    }
+    EXPECT_LE(cache.Size(), 8u);
+}
+
+} // namespace test
+} // namespace auth
+} // namespace saasforge
@@ -5,6 +5,7 @@
  */
 
 #include <gtest/gtest.h>
+#include "auth/scope_set.h"
 #include <vector>
 #include <string>
 
@@ -12,28 +13,12 @@ namespace saasforge {
 namespace auth {
 namespace test {
 
-// Helper function to validate scopes (mirrors implementation in auth_service.cpp)
+// Compiles the granted scopes the way a cache fill does, then checks one
 bool ValidateScope(
     const std::vector<std::string>& granted_scopes,
     const std::string& requested_scope
 ) {
-    // Exact match
-    if (std::find(granted_scopes.begin(), granted_scopes.end(), requested_scope) != granted_scopes.end()) {
-        return true;
-    }
-
-    // Wildcard match (e.g., "read:*" matches "read:upload")
-    for (const auto& granted : granted_scopes) {
-        if (!granted.empty() && granted.back() == '*') {
-            std::string prefix = granted.substr(0, granted.length() - 1);
-            if (requested_scope.find(prefix) == 0) {
-                return true;
-            }
-        }
-    }
-
-    // Deny by default (Requirement A-14)
-    return false;
+    return ScopeSet::Compile(granted_scopes).Allows(requested_scope);
 }
 
 class ApiKeyScopeTest : public ::testing::Test {
@@ -410,6 +395,38 @@ TEST_F(ApiKeyScopeTest, LimitedIntegrationApiKey) {
     EXPECT_FALSE(ValidateScope(granted, "delete:upload"));
 }
 
+// Test: Compiled Form
+
+TEST_F(ApiKeyScopeTest, CompiledSetIsReusable) {
+    ScopeSet scopes = ScopeSet::Compile({"read:upload", "payments:*"});
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(scopes.Allows("read:upload"));
+        EXPECT_TRUE(scopes.Allows("payments:refund"));
+        EXPECT_FALSE(scopes.Allows("payments"));
+        EXPECT_FALSE(scopes.Allows("read:uploads"));
+    }
+    EXPECT_TRUE(ScopeSet().Empty());
+    EXPECT_FALSE(ScopeSet().Allows("read:upload"));
+}
+
+TEST_F(ApiKeyScopeTest, ScopesBeyondInternLimitStillMatch) {
+    // Exhaust the process-wide intern table; later scopes fall back to the trie
+    std::vector<std::string> filler;
+    for (uint32_t i = 0; i <= ScopeSet::MAX_INTERNED; ++i) {
+        filler.push_back("filler:" + std::to_string(i));
+    }
+    ScopeSet::Compile(filler);
+
+    ScopeSet scopes = ScopeSet::Compile({"late:scope", "late:*:literal", "other:*"});
+    EXPECT_TRUE(scopes.Allows("late:scope"));
+    EXPECT_TRUE(scopes.Allows("late:*:literal"));
+    EXPECT_TRUE(scopes.Allows("other:thing"));
+    EXPECT_FALSE(scopes.Allows("late:scopes"));
+    EXPECT_FALSE(scopes.Allows("late:"));
+    EXPECT_FALSE(scopes.Allows("late:x:literal"));
+}
+
 } // namespace test
 } // namespace auth
 } // namespace saasforge
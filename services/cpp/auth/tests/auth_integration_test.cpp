@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "auth/auth_service.h"
+#include "auth/refresh_tokens.h"
+#include "common/jwt_validator.h"
 #include "common/redis_client.h"
 #include "common/db_pool.h"
 #include "common/password_hasher.h"
@@ -32,7 +34,8 @@ protected:
             redis_client_,
             db_pool_,
             jwt_public_key_,
-            jwt_private_key_
+            jwt_private_key_,
+            "test-api-key-pepper"
         );
 
         // Test tenant and user IDs from test_schema.sql fixtures
@@ -44,7 +47,8 @@ protected:
 
     void TearDown() override {
         // Cleanup Redis keys created during tests
-        redis_client_->DeleteSession("refresh:" + test_user_id_);
+        RefreshTokenStore(redis_client_).RevokeAll(test_user_id_);
+        redis_client_->DeleteSession("refresh:{" + test_user_id_ + "}");
     }
 
     std::string LoadTestKey(const std::string& filename) {
@@ -124,9 +128,8 @@ TEST_F(AuthIntegrationTest, LoginWithValidCredentialsReturnsTokens) {
     EXPECT_EQ(response.expires_in(), 900) << "Access token should expire in 15 minutes";
 
     // Verify refresh token stored in Redis
-    auto stored_token = redis_client_->GetSession("refresh:" + test_user_id_);
-    EXPECT_TRUE(stored_token.has_value()) << "Refresh token should be stored in Redis";
-    EXPECT_EQ(*stored_token, response.refresh_token());
+    EXPECT_TRUE(RefreshTokenStore(redis_client_).IsCurrent(response.refresh_token()))
+        << "Refresh token should be stored in Redis";
 }
 
 // Test: Login with invalid email fails
@@ -199,8 +202,8 @@ TEST_F(AuthIntegrationTest, LogoutRemovesRefreshToken) {
     std::string refresh_token = login_resp.refresh_token();
 
     // Verify token is in Redis
-    auto stored = redis_client_->GetSession("refresh:" + test_user_id_);
-    ASSERT_TRUE(stored.has_value());
+    RefreshTokenStore refresh_tokens(redis_client_);
+    ASSERT_TRUE(refresh_tokens.IsCurrent(refresh_token));
 
     // Act - Logout
     LogoutRequest logout_req;
@@ -215,8 +218,112 @@ TEST_F(AuthIntegrationTest, LogoutRemovesRefreshToken) {
     EXPECT_TRUE(logout_resp.success());
 
     // Verify token removed from Redis
-    auto after_logout = redis_client_->GetSession("refresh:" + test_user_id_);
-    EXPECT_FALSE(after_logout.has_value()) << "Refresh token should be removed from Redis";
+    EXPECT_FALSE(refresh_tokens.IsCurrent(refresh_token)) << "Refresh token should be removed from Redis";
+}
+
+// Test: RefreshToken rotates the token; replaying a rotated one revokes every session
+TEST_F(AuthIntegrationTest, RefreshTokenRotatesAndDetectsReuse) {
+    // Arrange - Two logins: two refresh-token families
+    LoginRequest login_req;
+    login_req.set_email(test_email_);
+    login_req.set_password(test_password_);
+    LoginResponse first_login;
+    LoginResponse second_login;
+    grpc::ServerContext first_ctx;
+    grpc::ServerContext second_ctx;
+    ASSERT_TRUE(service_->Login(&first_ctx, &login_req, &first_login).ok());
+    ASSERT_TRUE(service_->Login(&second_ctx, &login_req, &second_login).ok());
+
+    // Act - Rotate the first family
+    RefreshTokenRequest refresh_req;
+    refresh_req.set_refresh_token(first_login.refresh_token());
+    RefreshTokenResponse refresh_resp;
+    grpc::ServerContext refresh_ctx;
+    grpc::Status status = service_->RefreshToken(&refresh_ctx, &refresh_req, &refresh_resp);
+
+    // Assert - New pair issued, old token superseded
+    ASSERT_TRUE(status.ok()) << status.error_message();
+    EXPECT_FALSE(refresh_resp.access_token().empty());
+    EXPECT_NE(refresh_resp.refresh_token(), first_login.refresh_token());
+    RefreshTokenStore refresh_tokens(redis_client_);
+    EXPECT_TRUE(refresh_tokens.IsCurrent(refresh_resp.refresh_token()));
+    EXPECT_FALSE(refresh_tokens.IsCurrent(first_login.refresh_token()));
+
+    // Act - Replay the superseded token
+    RefreshTokenResponse replay_resp;
+    grpc::ServerContext replay_ctx;
+    status = service_->RefreshToken(&replay_ctx, &refresh_req, &replay_resp);
+
+    // Assert - Reuse detected; both families revoked
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::PERMISSION_DENIED);
+    EXPECT_FALSE(refresh_tokens.IsCurrent(refresh_resp.refresh_token()));
+    EXPECT_FALSE(refresh_tokens.IsCurrent(second_login.refresh_token()));
+}
+
+// Test: RevokeAllSessions ends every session of the caller and blacklists their access tokens
+TEST_F(AuthIntegrationTest, RevokeAllSessionsEndsEverySession) {
+    // Arrange - Sessions on two devices
+    LoginRequest login_req;
+    login_req.set_email(test_email_);
+    login_req.set_password(test_password_);
+    LoginResponse first_login;
+    LoginResponse second_login;
+    grpc::ServerContext first_ctx;
+    grpc::ServerContext second_ctx;
+    ASSERT_TRUE(service_->Login(&first_ctx, &login_req, &first_login).ok());
+    ASSERT_TRUE(service_->Login(&second_ctx, &login_req, &second_login).ok());
+
+    // Act
+    RevokeAllSessionsRequest revoke_req;
+    RevokeAllSessionsResponse revoke_resp;
+    grpc::ServerContext revoke_ctx;
+    revoke_ctx.AddInitialMetadata("x-tenant-id", test_tenant_id_);
+    revoke_ctx.AddInitialMetadata("x-user-id", test_user_id_);
+    grpc::Status status = service_->RevokeAllSessions(&revoke_ctx, &revoke_req, &revoke_resp);
+
+    // Assert - Both families gone, both access tokens blacklisted
+    ASSERT_TRUE(status.ok()) << status.error_message();
+    EXPECT_EQ(revoke_resp.revoked_sessions(), 2);
+    RefreshTokenStore refresh_tokens(redis_client_);
+    EXPECT_FALSE(refresh_tokens.IsCurrent(first_login.refresh_token()));
+    EXPECT_FALSE(refresh_tokens.IsCurrent(second_login.refresh_token()));
+    for (const auto* login : {&first_login, &second_login}) {
+        ValidateTokenRequest validate_req;
+        validate_req.set_access_token(login->access_token());
+        ValidateTokenResponse validate_resp;
+        grpc::ServerContext validate_ctx;
+        ASSERT_TRUE(service_->ValidateToken(&validate_ctx, &validate_req, &validate_resp).ok());
+        EXPECT_FALSE(validate_resp.valid()) << "Access token should be blacklisted";
+    }
+}
+
+// Test: RevokeTenantSessions requires the admin role
+TEST_F(AuthIntegrationTest, RevokeTenantSessionsRequiresAdmin) {
+    RevokeTenantSessionsRequest request;
+    RevokeTenantSessionsResponse response;
+    grpc::ServerContext context;
+    context.AddInitialMetadata("x-tenant-id", test_tenant_id_);
+    context.AddInitialMetadata("x-user-id", test_user_id_);
+    // The fixture user holds no admin role: a claimed one in metadata is not trusted
+    context.AddInitialMetadata("x-user-roles", "admin");
+
+    grpc::Status status = service_->RevokeTenantSessions(&context, &request, &response);
+
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::PERMISSION_DENIED);
+}
+
+// Test: RevokeTenantSessions succeeds for a user holding the admin role in the database
+TEST_F(AuthIntegrationTest, RevokeTenantSessionsAllowsTenantAdmin) {
+    RevokeTenantSessionsRequest request;
+    RevokeTenantSessionsResponse response;
+    grpc::ServerContext context;
+    context.AddInitialMetadata("x-tenant-id", "00000000-0000-0000-0000-000000000002");
+    context.AddInitialMetadata("x-user-id", "10000000-0000-0000-0000-000000000002");
+
+    grpc::Status status = service_->RevokeTenantSessions(&context, &request, &response);
+
+    EXPECT_TRUE(status.ok()) << status.error_message();
+    EXPECT_GT(response.revoked_at(), 0);
 }
 
 // Test: ValidateToken accepts valid JWT
@@ -262,6 +369,71 @@ TEST_F(AuthIntegrationTest, ValidateTokenRejectsInvalidJWT) {
     EXPECT_FALSE(validate_resp.valid()) << "Invalid token should be rejected";
 }
 
+// Test: a blacklisted jti is rejected, other tokens still pass the local filter
+TEST_F(AuthIntegrationTest, JwtValidatorRejectsBlacklistedToken) {
+    // Arrange
+    auto make_token = [this](const std::string& jti) {
+        auto now = std::chrono::system_clock::now();
+        return jwt::create()
+            .set_issuer("saasforge")
+            .set_subject(test_user_id_)
+            .set_id(jti)
+            .set_issued_at(now)
+            .set_expires_at(now + std::chrono::minutes(15))
+            .set_payload_claim("tenant_id", jwt::claim(test_tenant_id_))
+            .set_payload_claim("email", jwt::claim(test_email_))
+            .sign(jwt::algorithm::rs256("", jwt_private_key_, "", ""));
+    };
+    common::JwtValidator validator(jwt_public_key_, redis_client_);
+    std::string revoked = make_token("integration-blacklisted-jti");
+    std::string live = make_token("integration-live-jti");
+    ASSERT_TRUE(validator.Validate(revoked).has_value());
+
+    // Act - Blacklist as Logout does: Redis first, then this process's filter
+    redis_client_->BlacklistToken("integration-blacklisted-jti", 60);
+    validator.NoteBlacklisted("integration-blacklisted-jti");
+
+    // Assert - Cached claims do not bypass the blacklist
+    EXPECT_FALSE(validator.Validate(revoked).has_value()) << "Blacklisted token should be rejected";
+    EXPECT_TRUE(validator.IsBlacklisted("integration-blacklisted-jti"));
+    EXPECT_TRUE(validator.Validate(live).has_value()) << "Other tokens should still validate";
+    EXPECT_FALSE(validator.IsBlacklisted("integration-live-jti"));
+}
+
+// Test: ValidateBatch answers every check in order, duplicates included
+TEST_F(AuthIntegrationTest, ValidateBatchAnswersEachCheckInOrder) {
+    // Arrange
+    LoginRequest login_req;
+    login_req.set_email(test_email_);
+    login_req.set_password(test_password_);
+    LoginResponse login_resp;
+    grpc::ServerContext login_ctx;
+    ASSERT_TRUE(service_->Login(&login_ctx, &login_req, &login_resp).ok());
+
+    ValidateBatchRequest batch_req;
+    batch_req.add_checks()->set_access_token(login_resp.access_token());
+    batch_req.add_checks()->set_access_token("invalid.jwt.token");
+    batch_req.add_checks()->set_access_token(login_resp.access_token());
+    auto* api_key_check = batch_req.add_checks();
+    api_key_check->set_api_key("sk_invalid");
+    api_key_check->set_requested_scope("read:upload");
+    ValidateBatchResponse batch_resp;
+    grpc::ServerContext batch_ctx;
+
+    // Act
+    grpc::Status status = service_->ValidateBatch(&batch_ctx, &batch_req, &batch_resp);
+
+    // Assert
+    ASSERT_TRUE(status.ok()) << status.error_message();
+    ASSERT_EQ(batch_resp.results_size(), 4);
+    EXPECT_TRUE(batch_resp.results(0).valid());
+    EXPECT_EQ(batch_resp.results(0).user_id(), test_user_id_);
+    EXPECT_FALSE(batch_resp.results(1).valid());
+    EXPECT_TRUE(batch_resp.results(2).valid());
+    EXPECT_FALSE(batch_resp.results(3).valid());
+    EXPECT_EQ(batch_resp.results(3).message(), "Invalid API key");
+}
+
 // Test: CreateApiKey generates valid key and stores in database
 TEST_F(AuthIntegrationTest, CreateApiKeyGeneratesValidKey) {
     // Arrange - First login to get JWT
@@ -307,7 +479,7 @@ TEST_F(AuthIntegrationTest, CreateApiKeyGeneratesValidKey) {
 
     ASSERT_FALSE(result.empty()) << "API key should be stored in database";
     EXPECT_EQ(result[0]["name"].as<std::string>(), "Test Integration API Key");
-    EXPECT_EQ(result[0]["scopes"].as<std::string>(), "read,write");
+    EXPECT_EQ(result[0]["scopes"].as<std::string>(), "{read,write}");
 }
 
 // Test: RevokeApiKey soft-deletes key in database
@@ -0,0 +1,348 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the OAuth / OIDC client
+ */
+
+#include <gtest/gtest.h>
+#include "auth/oauth_client.h"
+#include "common/jwt_keys.h"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+using namespace saasforge::auth;
+
+namespace {
+
+const std::string DISCOVERY = "https://idp.test/.well-known/openid-configuration";
+const std::string JWKS = "https://idp.test/keys";
+const std::string TOKEN = "https://idp.test/token";
+
+struct KeyPair {
+    std::string private_key;
+    std::string public_key;
+};
+
+std::string ReadBio(BIO* bio) {
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    std::string out(data, static_cast<size_t>(len));
+    BIO_free(bio);
+    return out;
+}
+
+// Fresh keys per run (no key material checked in)
+KeyPair RsaKeys() {
+    EVP_PKEY* pkey = EVP_RSA_gen(2048);
+    KeyPair keys;
+    BIO* priv_bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(priv_bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    keys.private_key = ReadBio(priv_bio);
+    BIO* pub_bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PUBKEY(pub_bio, pkey);
+    keys.public_key = ReadBio(pub_bio);
+    EVP_PKEY_free(pkey);
+    return keys;
+}
+
+const KeyPair& Key1() {
+    static const KeyPair keys = RsaKeys();
+    return keys;
+}
+
+const KeyPair& Key2() {
+    static const KeyPair keys = RsaKeys();
+    return keys;
+}
+
+// Canned responses by URL, with a count of calls per URL
+struct FakeProvider {
+    std::mutex mutex;
+    std::map<std::string, OAuthHttpResponse> responses;
+    std::map<std::string, int> calls;
+    std::string last_form;
+    std::vector<std::string> last_headers;
+
+    FakeProvider(const std::string& issuer = "https://idp.test") {
+        responses[DISCOVERY] = {200,
+                                "{\"issuer\":\"" + issuer + "\",\"authorization_endpoint\":\"https://idp.test/auth\","
+                                "\"token_endpoint\":\"" + TOKEN + "\",\"jwks_uri\":\"" + JWKS + "\"}",
+                                ""};
+        SetKeys({Key1().public_key});
+    }
+
+    void SetKeys(const std::vector<std::string>& pems) {
+        std::lock_guard<std::mutex> lock(mutex);
+        responses[JWKS] = {200, saasforge::common::JwksFromKeys(pems), ""};
+    }
+
+    void SetIdToken(const std::string& id_token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        responses[TOKEN] = {200, "{\"access_token\":\"at\",\"token_type\":\"Bearer\",\"id_token\":\"" + id_token + "\"}", ""};
+    }
+
+    OAuthHttp Http() {
+        OAuthHttp http;
+        http.get = [this](const std::string& url, const std::vector<std::string>& headers) {
+            std::lock_guard<std::mutex> lock(mutex);
+            calls[url]++;
+            last_headers = headers;
+            auto it = responses.find(url);
+            return it == responses.end() ? OAuthHttpResponse{404, "", ""} : it->second;
+        };
+        http.post = [this](const std::string& url, const std::string& form, const std::vector<std::string>& headers) {
+            std::lock_guard<std::mutex> lock(mutex);
+            calls[url]++;
+            last_form = form;
+            auto it = responses.find(url);
+            return it == responses.end() ? OAuthHttpResponse{404, "", ""} : it->second;
+        };
+        return http;
+    }
+
+    int Calls(const std::string& url) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return calls[url];
+    }
+};
+
+OAuthClientOptions Options() {
+    OAuthProviderConfig config;
+    config.name = "idp";
+    config.client_id = "client-1";
+    config.client_secret = "secret";
+    config.scopes = "openid email";
+    config.discovery_url = DISCOVERY;
+
+    OAuthClientOptions options;
+    options.providers = {config};
+    options.metadata_refresh = std::chrono::seconds(0);   // No refresh thread
+    options.unknown_kid_refresh = std::chrono::seconds(0);
+    return options;
+}
+
+struct Claims {
+    std::string iss = "https://idp.test";
+    std::string aud = "client-1";
+    std::string nonce = "nonce-1";
+    std::chrono::seconds expires_in{300};
+    std::string tid;
+};
+
+std::string IdToken(const KeyPair& key, const Claims& claims = {}) {
+    auto now = std::chrono::system_clock::now();
+    auto token = jwt::create()
+                     .set_key_id(saasforge::common::JwtKeyId(key.public_key))
+                     .set_issuer(claims.iss)
+                     .set_audience(claims.aud)
+                     .set_subject("user-42")
+                     .set_issued_at(now)
+                     .set_expires_at(now + claims.expires_in)
+                     .set_payload_claim("nonce", jwt::claim(claims.nonce))
+                     .set_payload_claim("email", jwt::claim(std::string("a@example.com")))
+                     .set_payload_claim("email_verified", picojson::value(true));
+    if (!claims.tid.empty()) {
+        token.set_payload_claim("tid", jwt::claim(claims.tid));
+    }
+    return token.sign(jwt::algorithm::rs256("", key.private_key));
+}
+
+} // namespace
+
+// Test that the authorization URL carries the request, and discovery is fetched once
+TEST(OAuthClientTest, BuildsAuthorizationUrlFromCachedDiscovery) {
+    FakeProvider provider;
+    OAuthClient client(Options(), provider.Http());
+
+    std::string url = client.AuthorizationUrl("idp", "https://app.test/cb?x=1", "state-1", "nonce-1");
+    EXPECT_EQ(url.rfind("https://idp.test/auth?response_type=code&client_id=client-1&", 0), 0u);
+    EXPECT_NE(url.find("redirect_uri=https%3A%2F%2Fapp.test%2Fcb%3Fx%3D1"), std::string::npos);
+    EXPECT_NE(url.find("scope=openid%20email"), std::string::npos);
+    EXPECT_NE(url.find("state=state-1"), std::string::npos);
+    EXPECT_NE(url.find("nonce=nonce-1"), std::string::npos);
+
+    client.AuthorizationUrl("idp", "https://app.test/cb", "state-2", "nonce-2");
+    EXPECT_EQ(provider.Calls(DISCOVERY), 1);
+    EXPECT_EQ(provider.Calls(JWKS), 1);
+
+    EXPECT_FALSE(client.Configured("github"));
+    EXPECT_THROW(client.AuthorizationUrl("github", "https://app.test/cb", "s", "n"), std::invalid_argument);
+}
+
+// Test that after warm-up a login is one token endpoint POST
+TEST(OAuthClientTest, ExchangesCodeWithOneRoundTrip) {
+    FakeProvider provider;
+    OAuthClient client(Options(), provider.Http());
+    client.WarmUp();
+
+    provider.SetIdToken(IdToken(Key1()));
+    auto identity = client.Exchange("idp", "code-1", "https://app.test/cb", "nonce-1");
+    EXPECT_EQ(identity.provider_user_id, "user-42");
+    EXPECT_EQ(identity.email, "a@example.com");
+    EXPECT_TRUE(identity.email_verified);
+
+    EXPECT_EQ(provider.Calls(TOKEN), 1);
+    EXPECT_EQ(provider.Calls(DISCOVERY), 1);
+    EXPECT_EQ(provider.Calls(JWKS), 1);
+    EXPECT_EQ(provider.last_form,
+              "grant_type=authorization_code&code=code-1&redirect_uri=https%3A%2F%2Fapp.test%2Fcb"
+              "&client_id=client-1&client_secret=secret");
+    EXPECT_EQ(client.GetStats().exchanges, 1u);
+}
+
+// Test that id tokens failing a check are rejected
+TEST(OAuthClientTest, RejectsInvalidIdTokens) {
+    FakeProvider provider;
+    OAuthClient client(Options(), provider.Http());
+    auto exchange = [&](const std::string& id_token) {
+        provider.SetIdToken(id_token);
+        return client.Exchange("idp", "code", "https://app.test/cb", "nonce-1");
+    };
+
+    Claims wrong_nonce;
+    wrong_nonce.nonce = "nonce-2";
+    EXPECT_THROW(exchange(IdToken(Key1(), wrong_nonce)), std::invalid_argument);
+
+    Claims wrong_audience;
+    wrong_audience.aud = "someone-else";
+    EXPECT_THROW(exchange(IdToken(Key1(), wrong_audience)), std::invalid_argument);
+
+    Claims wrong_issuer;
+    wrong_issuer.iss = "https://evil.test";
+    EXPECT_THROW(exchange(IdToken(Key1(), wrong_issuer)), std::invalid_argument);
+
+    Claims expired;
+    expired.expires_in = std::chrono::seconds(-3600);
+    EXPECT_THROW(exchange(IdToken(Key1(), expired)), std::invalid_argument);
+
+    std::string tampered = IdToken(Key1());
+    tampered[tampered.size() - 5] = tampered[tampered.size() - 5] == 'A' ? 'B' : 'A';
+    EXPECT_THROW(exchange(tampered), std::invalid_argument);
+
+    EXPECT_THROW(exchange("not-a-jwt"), std::invalid_argument);
+    EXPECT_EQ(client.GetStats().rejected, 6u);
+    EXPECT_EQ(client.GetStats().exchanges, 0u);
+}
+
+// Test that a token signed with a rotated-in key reloads the keys, rate-limited
+TEST(OAuthClientTest, ReloadsKeysForUnknownKeyId) {
+    FakeProvider provider;
+    auto options = Options();
+    options.unknown_kid_refresh = std::chrono::seconds(3600);
+    OAuthClient client(options, provider.Http());
+    client.WarmUp();
+    EXPECT_EQ(provider.Calls(JWKS), 1);
+
+    // The first unknown kid after a load waits out the interval
+    provider.SetKeys({Key1().public_key, Key2().public_key});
+    provider.SetIdToken(IdToken(Key2()));
+    EXPECT_THROW(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1"), std::invalid_argument);
+    EXPECT_EQ(provider.Calls(JWKS), 1);
+
+    OAuthClient eager(Options(), provider.Http());   // unknown_kid_refresh 0
+    provider.SetKeys({Key1().public_key});
+    eager.WarmUp();
+    provider.SetKeys({Key1().public_key, Key2().public_key});
+    auto identity = eager.Exchange("idp", "code", "https://app.test/cb", "nonce-1");
+    EXPECT_EQ(identity.provider_user_id, "user-42");
+    EXPECT_EQ(provider.Calls(DISCOVERY), 2);        // One per client: the reload keeps the endpoints
+    EXPECT_EQ(provider.Calls(JWKS), 3);
+}
+
+// Test that refused codes and unreachable providers surface differently
+TEST(OAuthClientTest, DistinguishesRejectedCodeFromOutage) {
+    FakeProvider provider;
+    OAuthClient client(Options(), provider.Http());
+
+    provider.responses[TOKEN] = {400, "{\"error\":\"invalid_grant\"}", ""};
+    EXPECT_THROW(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1"), std::invalid_argument);
+
+    provider.responses[TOKEN] = {503, "", ""};
+    EXPECT_THROW(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1"), std::runtime_error);
+
+    provider.responses[TOKEN] = {0, "", "Connection refused"};
+    EXPECT_THROW(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1"), std::runtime_error);
+}
+
+// Test that a failed warm-up is retried on first use
+TEST(OAuthClientTest, LoadsMetadataOnUseAfterFailedWarmUp) {
+    FakeProvider provider;
+    auto discovery = provider.responses[DISCOVERY];
+    provider.responses[DISCOVERY] = {0, "", "timeout"};
+    OAuthClient client(Options(), provider.Http());
+    EXPECT_THROW(client.WarmUp(), std::runtime_error);
+    EXPECT_EQ(client.GetStats().metadata_failures, 1u);
+
+    provider.responses[DISCOVERY] = discovery;
+    provider.SetIdToken(IdToken(Key1()));
+    EXPECT_EQ(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1").provider_user_id, "user-42");
+}
+
+// Test that a multi-tenant issuer is matched against the token's directory
+TEST(OAuthClientTest, MatchesTenantTemplatedIssuer) {
+    FakeProvider provider("https://login.test/{tenantid}/v2.0");
+    OAuthClient client(Options(), provider.Http());
+
+    Claims claims;
+    claims.iss = "https://login.test/dir-1/v2.0";
+    claims.tid = "dir-1";
+    provider.SetIdToken(IdToken(Key1(), claims));
+    EXPECT_EQ(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1").provider_user_id, "user-42");
+
+    claims.tid = "dir-2";
+    provider.SetIdToken(IdToken(Key1(), claims));
+    EXPECT_THROW(client.Exchange("idp", "code", "https://app.test/cb", "nonce-1"), std::invalid_argument);
+}
+
+// Test that plain OAuth 2 providers read the identity from their user API
+TEST(OAuthClientTest, ReadsPlainOAuthIdentityFromUserInfo) {
+    OAuthProviderConfig config;
+    config.name = "github";
+    config.client_id = "gh-client";
+    config.client_secret = "gh-secret";
+    config.authorization_endpoint = "https://gh.test/authorize";
+    config.token_endpoint = "https://gh.test/token";
+    config.userinfo_endpoint = "https://api.gh.test/user";
+    config.emails_endpoint = "https://api.gh.test/user/emails";
+    OAuthClientOptions options;
+    options.providers = {config};
+
+    FakeProvider provider;
+    provider.responses["https://gh.test/token"] = {200, "{\"access_token\":\"gho_1\"}", ""};
+    provider.responses["https://api.gh.test/user"] = {200, "{\"id\":583231,\"email\":null}", ""};
+    provider.responses["https://api.gh.test/user/emails"] = {
+        200, "[{\"email\":\"old@example.com\",\"primary\":false,\"verified\":true},"
+             "{\"email\":\"me@example.com\",\"primary\":true,\"verified\":true}]", ""};
+    OAuthClient client(options, provider.Http());
+
+    EXPECT_EQ(client.AuthorizationUrl("github", "https://app.test/cb", "s", "n").find("nonce="), std::string::npos);
+    auto identity = client.Exchange("github", "code", "https://app.test/cb", "");
+    EXPECT_EQ(identity.provider_user_id, "583231");
+    EXPECT_EQ(identity.email, "me@example.com");
+    EXPECT_TRUE(identity.email_verified);
+    EXPECT_EQ(provider.last_headers.front(), "Authorization: Bearer gho_1");
+
+    // GitHub reports a refused code in a 200
+    provider.responses["https://gh.test/token"] = {200, "{\"error\":\"bad_verification_code\"}", ""};
+    EXPECT_THROW(client.Exchange("github", "code", "https://app.test/cb", ""), std::invalid_argument);
+}
+
+// Test that only providers with a client id are configured from the environment
+TEST(OAuthClientTest, ConfiguresProvidersFromEnv) {
+    setenv("OAUTH_GOOGLE_CLIENT_ID", "google-id", 1);
+    setenv("OAUTH_GOOGLE_CLIENT_SECRET", "google-secret", 1);
+    unsetenv("OAUTH_GITHUB_CLIENT_ID");
+    unsetenv("OAUTH_MICROSOFT_CLIENT_ID");
+    auto options = OAuthClientOptions::FromEnv();
+    unsetenv("OAUTH_GOOGLE_CLIENT_ID");
+    unsetenv("OAUTH_GOOGLE_CLIENT_SECRET");
+
+    ASSERT_EQ(options.providers.size(), 1u);
+    EXPECT_EQ(options.providers[0].name, "google");
+    EXPECT_EQ(options.providers[0].client_secret, "google-secret");
+    EXPECT_TRUE(options.providers[0].Oidc());
+}
@@ -0,0 +1,46 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Unit tests for refresh-token parsing (Requirement A-23)
+ */
+
+#include <gtest/gtest.h>
+#include "auth/refresh_tokens.h"
+
+namespace saasforge {
+namespace auth {
+namespace test {
+
+namespace {
+
+const std::string USER_ID = "10000000-0000-0000-0000-000000000001";
+const std::string FAMILY_ID = "0123456789abcdef";
+const std::string SECRET(64, 'a');
+
+} // namespace
+
+TEST(RefreshTokenPartsTest, ParsesFamilyTokens) {
+    auto parts = RefreshTokenParts::Parse(USER_ID + ":" + FAMILY_ID + ":" + SECRET);
+    ASSERT_TRUE(parts.has_value());
+    EXPECT_EQ(parts->user_id, USER_ID);
+    EXPECT_EQ(parts->family_id, FAMILY_ID);
+    EXPECT_EQ(parts->secret, SECRET);
+}
+
+TEST(RefreshTokenPartsTest, RejectsLegacyTokens) {
+    // "<user_id>:<secret>" tokens issued before families
+    EXPECT_FALSE(RefreshTokenParts::Parse(USER_ID + ":" + SECRET).has_value());
+}
+
+TEST(RefreshTokenPartsTest, RejectsMalformedTokens) {
+    EXPECT_FALSE(RefreshTokenParts::Parse("").has_value());
+    EXPECT_FALSE(RefreshTokenParts::Parse(":" + FAMILY_ID + ":" + SECRET).has_value());
+    EXPECT_FALSE(RefreshTokenParts::Parse(USER_ID + ":" + FAMILY_ID + "0:" + SECRET).has_value());
+    EXPECT_FALSE(RefreshTokenParts::Parse(USER_ID + ":" + FAMILY_ID + ":" + SECRET + "0").has_value());
+    EXPECT_FALSE(RefreshTokenParts::Parse(USER_ID + ":" + FAMILY_ID + ":" + std::string(64, 'A')).has_value());
+    EXPECT_FALSE(RefreshTokenParts::Parse(USER_ID + ":" + FAMILY_ID + ":" + SECRET + ":x").has_value());
+}
+
+} // namespace test
+} // namespace auth
+} // namespace saasforge
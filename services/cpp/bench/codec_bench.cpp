@@ -0,0 +1,95 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Benchmarks for hex, Base32 and Base64 encoding at token and payload sizes
+ */
+
+#include <benchmark/benchmark.h>
+#include "common/codec.h"
+#include <string>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// range(0) bytes of every value
+std::string Bytes(benchmark::State& state) {
+    std::string bytes(static_cast<size_t>(state.range(0)), '\0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<char>(i * 131);
+    }
+    return bytes;
+}
+
+} // namespace
+
+// 16: trace ids; 32: SHA-256 digests and refresh tokens; larger: bulk payloads
+static void BM_HexEncode(benchmark::State& state) {
+    std::string bytes = Bytes(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HexEncode(bytes));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_HexEncode)->Arg(16)->Arg(32)->Arg(1 << 10)->Arg(64 << 10);
+
+// Into a caller buffer, as the S3 signer appends its digests
+static void BM_HexEncodeInPlace(benchmark::State& state) {
+    std::string bytes = Bytes(state);
+    std::string out(HexEncodedLength(bytes.size()), '\0');
+    for (auto _ : state) {
+        HexEncode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), &out[0]);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_HexEncodeInPlace)->Arg(32)->Arg(1 << 10);
+
+static void BM_HexDecode(benchmark::State& state) {
+    std::string hex = HexEncode(Bytes(state));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HexDecode(hex));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_HexDecode)->Arg(32)->Arg(1 << 10)->Arg(64 << 10);
+
+// 20: TOTP secrets
+static void BM_Base32Encode(benchmark::State& state) {
+    std::string bytes = Bytes(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            Base32Encode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_Base32Encode)->Arg(20)->Arg(1 << 10);
+
+static void BM_Base32Decode(benchmark::State& state) {
+    std::string bytes = Bytes(state);
+    std::string base32 = Base32Encode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Base32Decode(base32));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_Base32Decode)->Arg(20)->Arg(1 << 10);
+
+// 16/32: Argon2 salts and hashes
+static void BM_Base64Encode(benchmark::State& state) {
+    std::string bytes = Bytes(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Base64Encode(bytes));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_Base64Encode)->Arg(32)->Arg(1 << 10)->Arg(64 << 10);
+
+static void BM_Base64Decode(benchmark::State& state) {
+    std::string base64 = Base64Encode(Bytes(state));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Base64Decode(base64));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_Base64Decode)->Arg(32)->Arg(1 << 10)->Arg(64 << 10);
@@ -0,0 +1,146 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Benchmarks for JWT validation (cold signature check and cached claims) and signing
+ */
+
+#include <benchmark/benchmark.h>
+#include "common/jwt_signer.h"
+#include "common/jwt_validator.h"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace saasforge::common;
+
+namespace {
+
+std::string ReadBio(BIO* bio) {
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    std::string out(data, static_cast<size_t>(len));
+    BIO_free(bio);
+    return out;
+}
+
+/// Key pairs shared by every case (generating one takes longer than the cases)
+struct KeyPair {
+    std::string public_key;
+    std::string private_key;
+
+    static const KeyPair& Get() { return For(JwtAlgorithm::RS256); }
+
+    static const KeyPair& For(JwtAlgorithm algorithm) {
+        static const KeyPair rsa = Generate(EVP_RSA_gen(2048));
+        static const KeyPair p256 = Generate(EVP_EC_gen("P-256"));
+        static const KeyPair ed25519 = Generate(EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519"));
+        switch (algorithm) {
+            case JwtAlgorithm::ES256: return p256;
+            case JwtAlgorithm::EDDSA: return ed25519;
+            default: return rsa;
+        }
+    }
+
+    static KeyPair Generate(EVP_PKEY* pkey) {
+        if (!pkey) {
+            throw std::runtime_error("Key generation failed");
+        }
+        KeyPair pair;
+        BIO* priv_bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PrivateKey(priv_bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+        pair.private_key = ReadBio(priv_bio);
+        BIO* pub_bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PUBKEY(pub_bio, pkey);
+        pair.public_key = ReadBio(pub_bio);
+        EVP_PKEY_free(pkey);
+        return pair;
+    }
+};
+
+JwtSigner::Builder AccessTokenClaims(int id) {
+    auto now = std::chrono::system_clock::now();
+    return jwt::create()
+        .set_issuer("saasforge")
+        .set_subject("user-" + std::to_string(id))
+        .set_id("jti-" + std::to_string(id))
+        .set_issued_at(now)
+        .set_expires_at(now + std::chrono::minutes(15))
+        .set_payload_claim("tenant_id", jwt::claim(std::string("tenant-1")))
+        .set_payload_claim("email", jwt::claim(std::string("user@example.com")));
+}
+
+std::string MakeToken(const KeyPair& keys, int id) {
+    return AccessTokenClaims(id).sign(jwt::algorithm::rs256("", keys.private_key, "", ""));
+}
+
+} // namespace
+
+// Signature check and claim decoding on every call (cache disabled)
+static void BM_JwtValidate_Uncached(benchmark::State& state) {
+    const auto& keys = KeyPair::Get();
+    JwtValidatorOptions options;
+    options.cache_capacity = 0;
+    JwtValidator validator(keys.public_key, nullptr, options);
+    std::string token = MakeToken(keys, 1);
+
+    for (auto _ : state) {
+        auto claims = validator.Validate(token);
+        benchmark::DoNotOptimize(claims);
+    }
+}
+BENCHMARK(BM_JwtValidate_Uncached);
+
+// Repeat presentations of a token served from the verified-claims cache
+static void BM_JwtValidate_Cached(benchmark::State& state) {
+    const auto& keys = KeyPair::Get();
+    JwtValidator validator(keys.public_key, nullptr);
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 64; ++i) {
+        tokens.push_back(MakeToken(keys, i));
+    }
+
+    size_t next = 0;
+    for (auto _ : state) {
+        auto claims = validator.Validate(tokens[next++ % tokens.size()]);
+        benchmark::DoNotOptimize(claims);
+    }
+}
+BENCHMARK(BM_JwtValidate_Cached)->ThreadRange(1, 8);
+
+// Token minting as it was: the PEM key parsed for every token
+static void BM_JwtSign_ParsePerToken(benchmark::State& state) {
+    const auto& keys = KeyPair::Get();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MakeToken(keys, 1));
+    }
+}
+BENCHMARK(BM_JwtSign_ParsePerToken);
+
+// Pre-parsed key, per algorithm (0 = RS256, 1 = ES256, 2 = EdDSA)
+static void BM_JwtSign(benchmark::State& state) {
+    auto algorithm = static_cast<JwtAlgorithm>(state.range(0));
+    JwtSigner signer(KeyPair::For(algorithm).private_key);
+    state.SetLabel(JwtAlgorithmName(algorithm));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(signer.Sign(AccessTokenClaims(1)));
+    }
+}
+BENCHMARK(BM_JwtSign)->DenseRange(0, 2);
+
+// Signature check per algorithm (cache disabled)
+static void BM_JwtVerify(benchmark::State& state) {
+    auto algorithm = static_cast<JwtAlgorithm>(state.range(0));
+    const auto& keys = KeyPair::For(algorithm);
+    JwtValidatorOptions options;
+    options.cache_capacity = 0;
+    JwtValidator validator(keys.public_key, nullptr, options);
+    std::string token = JwtSigner(keys.private_key).Sign(AccessTokenClaims(1));
+    state.SetLabel(JwtAlgorithmName(algorithm));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validator.Validate(token));
+    }
+}
+BENCHMARK(BM_JwtVerify)->DenseRange(0, 2);
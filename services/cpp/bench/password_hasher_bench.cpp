@@ -0,0 +1,22 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Benchmarks for Argon2id password verification
+ */
+
+#include <benchmark/benchmark.h>
+#include "common/password_hasher.h"
+#include <string>
+
+using namespace saasforge::common;
+
+// One login: 64 MB, 3 passes (see PasswordHasher); deliberately slow, so few iterations
+static void BM_PasswordHasher_Verify(benchmark::State& state) {
+    const std::string password = "correct horse battery staple";
+    const std::string hash = PasswordHasher::HashPassword(password);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PasswordHasher::VerifyPassword(password, hash));
+    }
+}
+BENCHMARK(BM_PasswordHasher_Verify)->Unit(benchmark::kMillisecond)->UseRealTime();
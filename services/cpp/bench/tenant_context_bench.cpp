@@ -0,0 +1,56 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Benchmarks for gateway header parsing (tenant, user and roles)
+ */
+
+#include <benchmark/benchmark.h>
+#include "common/tenant_context.h"
+#include <deque>
+#include <string>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Gateway headers with `roles` comma-separated roles; entries point into owned strings
+struct GatewayMetadata {
+    explicit GatewayMetadata(int roles) {
+        std::string role_list;
+        for (int i = 0; i < roles; ++i) {
+            role_list += (i ? ", role-" : "role-") + std::to_string(i);
+        }
+        Add("x-tenant-id", "8d0e7a4c-3f5b-4c21-9a6e-1b2c3d4e5f60");
+        Add("x-user-id", "2f9c1e7a-5b3d-4a8e-b6c0-7d1e2f3a4b5c");
+        Add("x-user-email", "user@example.com");
+        Add("x-user-roles", role_list);
+        // Unrelated headers every call carries
+        Add("user-agent", "grpc-c++/1.51.1 grpc-c/29.0.0 (linux; chttp2)");
+        Add("grpc-accept-encoding", "identity,deflate,gzip");
+        Add("traceparent", "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+    }
+
+    void Add(const std::string& key, const std::string& value) {
+        keys.push_back(key);
+        values.push_back(value);
+        metadata.emplace(grpc::string_ref(keys.back()), grpc::string_ref(values.back()));
+    }
+
+    std::deque<std::string> keys;
+    std::deque<std::string> values;
+    ServerMetadata metadata;
+};
+
+} // namespace
+
+// Header path of ExtractFromMetadataUnsafe (no JWT validator); range(0) is the role count.
+// A ServerContext's metadata can only be filled by a live RPC, so the parser
+// the interceptor and ExtractFromMetadataUnsafe share is called on it directly.
+static void BM_TenantContextParseHeaders(benchmark::State& state) {
+    GatewayMetadata headers(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        auto call = TenantContextInterceptor::Parse(headers.metadata, nullptr, true);
+        benchmark::DoNotOptimize(call);
+    }
+}
+BENCHMARK(BM_TenantContextParseHeaders)->Arg(0)->Arg(1)->Arg(4)->Arg(16);
@@ -0,0 +1,48 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Benchmarks for TOTP code validation
+ */
+
+#include <benchmark/benchmark.h>
+#include "common/totp_helper.h"
+#include <string>
+
+using namespace saasforge::common;
+
+namespace {
+
+// RFC 6238 SHA-1 test secret ("12345678901234567890")
+const std::string kSecret = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+
+// Code for T = 59 (RFC 6238 appendix B), checked at that time
+constexpr int64_t kTime = 59;
+const std::string kCode = "287082";
+
+} // namespace
+
+// Accepted at the current step; range(0) is the window
+static void BM_TotpValidate_Match(benchmark::State& state) {
+    int window = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TotpHelper::ValidateCodeAt(kSecret, kCode, kTime, window));
+    }
+}
+BENCHMARK(BM_TotpValidate_Match)->Arg(0)->Arg(1)->Arg(2);
+
+// Rejected: every step of the window is computed
+static void BM_TotpValidate_Mismatch(benchmark::State& state) {
+    int window = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TotpHelper::ValidateCodeAt(kSecret, "000000", kTime, window));
+    }
+}
+BENCHMARK(BM_TotpValidate_Mismatch)->Arg(0)->Arg(1)->Arg(2);
+
+// Wall-clock entry point used by the auth service
+static void BM_TotpValidate_Now(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TotpHelper::ValidateCode(kSecret, "000000"));
+    }
+}
+BENCHMARK(BM_TotpValidate_Now);
@@ -0,0 +1,46 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Benchmarks for webhook payload signing at several payload sizes
+ */
+
+#include <benchmark/benchmark.h>
+#include "common/webhook_signer.h"
+#include <string>
+
+using namespace saasforge::common;
+
+namespace {
+
+const std::string kSecret = "whsec_test_secret_key_12345";
+
+/// JSON-looking payload of range(0) bytes
+std::string Payload(benchmark::State& state) {
+    std::string payload = R"({"event":"subscription.created","data":")";
+    payload.resize(static_cast<size_t>(state.range(0)) - 2, 'x');
+    payload += "\"}";
+    return payload;
+}
+
+} // namespace
+
+// One-off signature: keys the HMAC on every call
+static void BM_WebhookSignPayload(benchmark::State& state) {
+    std::string payload = Payload(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(WebhookSigner::SignPayload(payload, kSecret));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_WebhookSignPayload)->RangeMultiplier(8)->Range(64, 256 << 10);
+
+// Fan-out path: keyed state cached per webhook
+static void BM_WebhookSigningKeySign(benchmark::State& state) {
+    std::string payload = Payload(state);
+    auto key = WebhookSigner::GetSigningKey("tenant-1", "webhook-1", kSecret);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(key->Sign(payload));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+BENCHMARK(BM_WebhookSigningKeySign)->RangeMultiplier(8)->Range(64, 256 << 10);
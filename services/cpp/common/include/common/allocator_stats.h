@@ -0,0 +1,53 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description malloc statistics of whichever allocator the process runs on
+ */
+
+#pragma once
+
+#include "common/metrics.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Allocator memory, as far as the allocator reports it
+ *
+ * Fields an allocator does not report are 0 (and not exported):
+ *   jemalloc  all of them (stats.*, arenas.narenas)
+ *   mimalloc  resident (process RSS) and mapped (committed)
+ *   tcmalloc  allocated, resident, mapped
+ *   glibc     allocated, mapped (mallinfo2)
+ */
+struct AllocatorStats {
+    std::string allocator;      // "jemalloc", "mimalloc", "tcmalloc" or "glibc"
+    size_t allocated = 0;       // Bytes in live allocations
+    size_t active = 0;          // Bytes in pages holding live allocations
+    size_t resident = 0;        // Bytes resident in RAM (what RSS is made of)
+    size_t mapped = 0;          // Bytes mapped (or committed) from the OS
+    size_t retained = 0;        // Bytes unmapped but kept as address space for reuse
+    size_t arenas = 0;
+};
+
+/**
+ * Current statistics
+ *
+ * The allocator is detected at run time (its entry points are weak
+ * symbols), so a preloaded jemalloc is reported as such.
+ */
+AllocatorStats ReadAllocatorStats();
+
+/**
+ * Export ReadAllocatorStats() on every scrape as saasforge_allocator_*_bytes
+ * and saasforge_allocator_arenas, labelled with the allocator
+ *
+ * @return Collector id (MetricsRegistry::RemoveCollector)
+ */
+uint64_t ExportAllocatorMetrics(MetricsRegistry& registry);
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,119 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Keyed API key format and HMAC-SHA256 digests (Requirement A-14)
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Parsed representation of a presented API key
+ */
+struct ParsedApiKey {
+    std::string key_id;   // Public lookup id (indexed column api_keys.key_id)
+    std::string secret;   // Secret part, only ever stored as a digest
+    bool legacy = false;  // True for pre-key-id keys ("sk_" + 64 hex)
+};
+
+/**
+ * API key issued by Generate(); api_key is returned to the caller once
+ */
+struct GeneratedApiKey {
+    std::string api_key;
+    std::string key_id;
+    std::string key_hash;
+};
+
+/**
+ * API key format and hashing
+ *
+ * Keys have the form "sk_<key_id>_<secret>" where key_id is 16 hex chars
+ * and secret is 64 hex chars (256 bits from the OpenSSL CSPRNG). The key_id
+ * is stored in an indexed column so validation is a single index probe; the
+ * secret is stored as HMAC-SHA256(pepper, secret). The secret already has
+ * full entropy, so a slow KDF such as Argon2 buys nothing here and turns
+ * every failed lookup into a CPU/memory sink.
+ *
+ * Legacy keys ("sk_" + 64 hex, Argon2id hashed) have no key_id. They are
+ * mapped to a deterministic LegacyKeyId() and rehashed on first successful
+ * validation, after which they take the same fast path as new keys.
+ *
+ * Usage:
+ *   auto key = ApiKeyHasher::Generate(pepper);
+ *   auto parsed = ApiKeyHasher::Parse(presented);
+ *   bool ok = ApiKeyHasher::VerifyDigest(parsed->secret, pepper, stored_hash);
+ */
+class ApiKeyHasher {
+public:
+    /// Hash scheme markers stored in api_keys.hash_scheme
+    static constexpr const char* SCHEME_HMAC_SHA256 = "hmac-sha256";
+    static constexpr const char* SCHEME_ARGON2ID = "argon2id";
+
+    static constexpr size_t KEY_ID_HEX_LENGTH = 16;
+    static constexpr size_t SECRET_HEX_LENGTH = 64;
+
+    /**
+     * Generate a new API key in the keyed format
+     *
+     * @param pepper Server-side HMAC pepper
+     * @return Plaintext key plus the key_id and digest to persist
+     */
+    static GeneratedApiKey Generate(const std::string& pepper);
+
+    /**
+     * Split a presented key into key_id and secret
+     *
+     * @param api_key Key as presented by the client
+     * @return Parsed key, or nullopt if the key is malformed
+     */
+    static std::optional<ParsedApiKey> Parse(const std::string& api_key);
+
+    /**
+     * Compute the stored digest for a key secret
+     *
+     * @param secret Secret part of the key (or full key for legacy keys)
+     * @param pepper Server-side HMAC pepper
+     * @return Hex-encoded HMAC-SHA256(pepper, secret)
+     */
+    static std::string Digest(const std::string& secret, const std::string& pepper);
+
+    /**
+     * Verify a secret against a stored digest in constant time
+     *
+     * @param secret Secret part of the presented key
+     * @param pepper Server-side HMAC pepper
+     * @param expected_digest Digest from api_keys.key_hash
+     * @return True if the digest matches
+     */
+    static bool VerifyDigest(
+        const std::string& secret,
+        const std::string& pepper,
+        const std::string& expected_digest
+    );
+
+    /**
+     * Derive the lookup id assigned to a legacy key when it is rehashed
+     *
+     * @param api_key Full legacy key
+     * @param pepper Server-side HMAC pepper
+     * @return Deterministic key_id ("l" + 15 hex chars)
+     */
+    static std::string LegacyKeyId(const std::string& api_key, const std::string& pepper);
+
+    /**
+     * Display prefix stored in api_keys.key_prefix (safe to log/show in UI)
+     */
+    static std::string DisplayPrefix(const std::string& api_key);
+
+private:
+    static bool IsHex(const std::string& value);
+};
+
+} // namespace common
+} // namespace saasforge
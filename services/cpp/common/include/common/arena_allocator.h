@@ -0,0 +1,173 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Protobuf arena message allocators for callback unary RPCs
+ */
+
+#pragma once
+
+#include <google/protobuf/arena.h>
+#include <grpcpp/support/message_allocator.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/metrics.h"
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Initial arena block, taken from and returned to a per-thread free list
+ *
+ * Sizes are powers of two from MIN_SIZE to MAX_SIZE; each thread keeps up
+ * to MAX_CACHED blocks per size, so steady-state RPCs allocate no arena
+ * memory at all. A block released on another thread than the one that
+ * took it simply joins that thread's list.
+ */
+class ArenaBlock {
+public:
+    static constexpr size_t MIN_SIZE = 512;
+    static constexpr size_t MAX_SIZE = 64 * 1024;
+    static constexpr size_t MAX_CACHED = 16;
+
+    /// Block of at least `size` bytes (clamped to MIN_SIZE..MAX_SIZE)
+    explicit ArenaBlock(size_t size);
+    ~ArenaBlock();
+
+    ArenaBlock(const ArenaBlock&) = delete;
+    ArenaBlock& operator=(const ArenaBlock&) = delete;
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    /// Arena options that start from this block and grow in same-sized steps
+    google::protobuf::ArenaOptions Options() const;
+
+    /// Size class a request for `size` bytes is rounded up to
+    static size_t RoundUp(size_t size);
+
+private:
+    char* data_;
+    size_t size_;
+};
+
+/**
+ * Running estimate of the arena space one method's RPCs use
+ *
+ * Exponentially weighted (1/8 per sample) so a burst of large requests
+ * grows the initial block quickly and it shrinks back as they stop.
+ * Concurrent updates may drop a sample; the estimate only sizes blocks.
+ */
+class ArenaSizeEstimate {
+public:
+    explicit ArenaSizeEstimate(size_t initial = ArenaBlock::MIN_SIZE) : bytes_(initial) {}
+
+    void Record(size_t used) {
+        size_t current = bytes_.load(std::memory_order_relaxed);
+        size_t next = used >= current ? current + (used - current) / 8 : current - (current - used) / 8;
+        bytes_.store(next, std::memory_order_relaxed);
+    }
+
+    size_t Bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    /// Initial block size for the next RPC
+    size_t BlockSize() const { return ArenaBlock::RoundUp(Bytes()); }
+
+private:
+    std::atomic<size_t> bytes_;
+};
+
+/**
+ * grpc::MessageAllocator placing each RPC's request and response on one arena
+ *
+ * Everything the handler adds to either message lives on that arena and is
+ * freed in one step when gRPC releases the call, instead of one free per
+ * string and sub-message. Register one per method with
+ * SetMessageAllocatorFor_<Method>; it must outlive the server.
+ *
+ * @param method "/package.Service/Method", for the arena size histogram
+ */
+template <typename Request, typename Response>
+class ArenaMessageAllocator final : public grpc::MessageAllocator<Request, Response> {
+public:
+    explicit ArenaMessageAllocator(const std::string& method);
+
+    grpc::MessageHolder<Request, Response>* AllocateMessages() override {
+        return new Holder(*this);
+    }
+
+    const ArenaSizeEstimate& Estimate() const { return estimate_; }
+
+private:
+    class Holder final : public grpc::MessageHolder<Request, Response> {
+    public:
+        explicit Holder(ArenaMessageAllocator& allocator)
+            : allocator_(allocator), block_(allocator.estimate_.BlockSize()), arena_(block_.Options()) {
+            this->set_request(google::protobuf::Arena::CreateMessage<Request>(&arena_));
+            this->set_response(google::protobuf::Arena::CreateMessage<Response>(&arena_));
+        }
+
+        void Release() override {
+            allocator_.Record(arena_.SpaceUsed());
+            delete this;
+        }
+
+    private:
+        ArenaMessageAllocator& allocator_;
+        ArenaBlock block_;                 // Declared first: the arena only borrows it
+        google::protobuf::Arena arena_;
+    };
+
+    void Record(size_t used) {
+        estimate_.Record(used);
+        used_bytes_->Record(used);
+    }
+
+    ArenaSizeEstimate estimate_;
+    Histogram* used_bytes_;
+};
+
+/// Histogram of arena bytes used per RPC, labelled like the metrics interceptor
+Histogram& ArenaUsedBytesHistogram(const std::string& method);
+
+template <typename Request, typename Response>
+ArenaMessageAllocator<Request, Response>::ArenaMessageAllocator(const std::string& method)
+    : used_bytes_(&ArenaUsedBytesHistogram(method)) {}
+
+/**
+ * Owns the arena allocators of one callback service
+ *
+ * Usage (in a CallbackService constructor):
+ *   SetMessageAllocatorFor_Login(arenas_.Make<LoginRequest, LoginResponse>("Login"));
+ */
+class ArenaAllocators {
+public:
+    /// @param service Full service name, e.g. AuthService::service_full_name()
+    explicit ArenaAllocators(std::string service) : service_(std::move(service)) {}
+
+    template <typename Request, typename Response>
+    ArenaMessageAllocator<Request, Response>* Make(const char* method) {
+        auto allocator = std::make_shared<ArenaMessageAllocator<Request, Response>>(
+            "/" + service_ + "/" + method);
+        allocators_.push_back(allocator);
+        return allocator.get();
+    }
+
+private:
+    std::string service_;
+    std::vector<std::shared_ptr<void>> allocators_;
+};
+
+} // namespace common
+} // namespace saasforge
+
+/**
+ * Expand a service's unary X-macro list with this in its CallbackService
+ * constructor to put every unary RPC's messages on an arena. Needs an
+ * ArenaAllocators member named arenas_.
+ */
+#define SAASFORGE_CALLBACK_ARENA_ALLOCATOR(Method, Request, Response)                \
+    this->SetMessageAllocatorFor_##Method(arenas_.Make<Request, Response>(#Method));
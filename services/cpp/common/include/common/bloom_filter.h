@@ -0,0 +1,63 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Fixed-size Bloom filter for local negative lookups
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Fixed-size Bloom filter
+ *
+ * MightContain() never returns false for an added item; it may return true
+ * for an item that was never added (false positive). Callers use it to skip
+ * a remote lookup when the answer is definitely "no" and fall back to the
+ * authoritative store otherwise.
+ *
+ * Not thread-safe; callers synchronise access.
+ *
+ * Usage:
+ *   BloomFilter filter(100000, 0.001);
+ *   filter.Add(jti);
+ *   if (!filter.MightContain(jti)) { ... definitely absent ... }
+ */
+class BloomFilter {
+public:
+    /**
+     * @param expected_items Number of items the filter is sized for
+     * @param false_positive_rate Target false positive rate at expected_items
+     */
+    BloomFilter(size_t expected_items, double false_positive_rate);
+
+    void Add(std::string_view item);
+    bool MightContain(std::string_view item) const;
+
+    /// Number of Add() calls since construction
+    size_t Count() const { return count_; }
+
+    /// True once more items were added than the filter was sized for
+    bool Saturated() const { return count_ > expected_items_; }
+
+    size_t BitCount() const { return num_bits_; }
+    size_t HashCount() const { return num_hashes_; }
+
+private:
+    static uint64_t Hash(std::string_view item, uint64_t seed);
+
+    size_t expected_items_;
+    size_t num_bits_;
+    size_t num_hashes_;
+    size_t count_ = 0;
+    std::vector<uint64_t> bits_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,81 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-RPC values set by server interceptors and read by handlers
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace grpc {
+class ServerContextBase;
+}
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Values of type T keyed by the RPC's ServerContext
+ *
+ * gRPC gives interceptors and handlers nothing to share per call except
+ * the ServerContext, so an interceptor stores what it computed here when
+ * the call starts and clears it when the call ends; handlers look it up
+ * by their context pointer. Sharded so concurrent RPCs rarely share a
+ * lock.
+ *
+ * Usage:
+ *   CallSlot<TraceContext>::Global().Set(info->server_context(), trace);
+ *   TraceContext trace = CallSlot<TraceContext>::Global().Get(context);
+ */
+template <typename T>
+class CallSlot {
+public:
+    static CallSlot& Global() {
+        // Never destroyed; calls may still be finishing at exit
+        static CallSlot* slot = new CallSlot();
+        return *slot;
+    }
+
+    void Set(const grpc::ServerContextBase* call, T value) {
+        Shard& shard = ShardFor(call);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.values[call] = std::move(value);
+    }
+
+    void Clear(const grpc::ServerContextBase* call) {
+        Shard& shard = ShardFor(call);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.values.erase(call);
+    }
+
+    /// Value for the call, or T{} if none was set
+    T Get(const grpc::ServerContextBase* call) {
+        Shard& shard = ShardFor(call);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.values.find(call);
+        return it == shard.values.end() ? T{} : it->second;
+    }
+
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<const grpc::ServerContextBase*, T> values;
+    };
+
+    Shard& ShardFor(const grpc::ServerContextBase* call) {
+        return shards_[std::hash<const void*>{}(call) % SHARDS];
+    }
+
+    std::array<Shard, SHARDS> shards_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,122 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Warm, round-robin gRPC client channels per target with keepalive
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <grpc/grpc_security.h>
+#include <grpcpp/grpcpp.h>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * ChannelPool options
+ *
+ * FromEnv() reads GRPC_CHANNEL_POOL_SIZE, GRPC_CLIENT_KEEPALIVE_TIME_MS,
+ * GRPC_CLIENT_KEEPALIVE_TIMEOUT_MS, GRPC_CLIENT_KEEPALIVE_WITHOUT_CALLS,
+ * GRPC_CLIENT_LB_POLICY and GRPC_CLIENT_TLS_SESSION_CACHE.
+ */
+struct ChannelPoolOptions {
+    size_t channels_per_target = 4;                     // HTTP/2 connections per target
+    std::chrono::milliseconds keepalive_time{30000};    // PING after this long without activity (0 = off)
+    std::chrono::milliseconds keepalive_timeout{10000}; // Connection dropped if the PING is not answered
+    bool keepalive_without_calls = true;                // Keep idle connections warm too
+    std::string lb_policy = "round_robin";              // Across the addresses a target resolves to
+    size_t tls_session_cache_size = 1024;               // TLS sessions kept for resumption (0 = off)
+
+    static ChannelPoolOptions FromEnv();
+};
+
+/**
+ * Pool statistics
+ */
+struct ChannelPoolStats {
+    size_t targets = 0;
+    size_t channels = 0;
+    size_t ready = 0;     // Channels currently READY
+};
+
+/**
+ * Long-lived client channels for service-to-service calls
+ *
+ * A channel is one HTTP/2 connection per backend address, and that
+ * connection carries at most the server's MAX_CONCURRENT_STREAMS calls at
+ * once; a high-fanout caller on a single channel queues behind that limit
+ * and pins all its load on one server thread's connection. The pool keeps
+ * channels_per_target channels to each target, each with its own
+ * subchannel pool (so they really are separate TCP connections), and hands
+ * them out round-robin. Within a channel the round_robin policy spreads
+ * calls over every address the target resolves to.
+ *
+ * Channels are created on first use and kept: credentials are built once
+ * by the caller (MtlsCredentials::CachedClientCredentials), the TLS
+ * handshake happens once per connection rather than once per client
+ * object, and keepalive PINGs stop idle connections being dropped by NATs
+ * and load balancers. Servers must allow PINGs that often
+ * (ServerOptions::min_ping_interval). All channels share one TLS session
+ * cache, so a reconnect after a network blip resumes the session with the
+ * server's ticket instead of paying for a full mTLS handshake.
+ *
+ * Usage:
+ *   auto pool = std::make_shared<ChannelPool>(
+ *       MtlsCredentials::CachedClientCredentials(ca, cert, key), ChannelPoolOptions::FromEnv());
+ *   warmup.Add("auth_channels", Warmup::ConnectChannels(pool, "auth-service:50051"), true);
+ *   auto stub = auth::AuthService::NewStub(pool->Get("auth-service:50051"));
+ */
+class ChannelPool {
+public:
+    explicit ChannelPool(std::shared_ptr<grpc::ChannelCredentials> credentials,
+                         const ChannelPoolOptions& options = {});
+
+    ~ChannelPool();
+
+    ChannelPool(const ChannelPool&) = delete;
+    ChannelPool& operator=(const ChannelPool&) = delete;
+
+    /// Next channel to `target` (round-robin); creates the target's channels on first use
+    std::shared_ptr<grpc::Channel> Get(const std::string& target);
+
+    /// Every channel to `target`, e.g. for one stub per channel
+    std::vector<std::shared_ptr<grpc::Channel>> Channels(const std::string& target);
+
+    /**
+     * Connect every channel to `target`
+     *
+     * @return False if one was not READY by `deadline`
+     */
+    bool Connect(const std::string& target, std::chrono::system_clock::time_point deadline);
+
+    ChannelPoolStats GetStats() const;
+
+    /// Arguments of the index-th channel to a target
+    static grpc::ChannelArguments Arguments(const ChannelPoolOptions& options, size_t index);
+
+private:
+    struct Target {
+        std::vector<std::shared_ptr<grpc::Channel>> channels;
+        std::atomic<size_t> next{0};
+    };
+
+    Target& Find(const std::string& target);
+
+    std::shared_ptr<grpc::ChannelCredentials> credentials_;
+    ChannelPoolOptions options_;
+    grpc_ssl_session_cache* session_cache_ = nullptr;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Target>> targets_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,108 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Hex, Base32 and Base64 encoding shared by every service
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Byte-to-text codecs (RFC 4648)
+ *
+ * Each encoding has a raw form writing into a caller-provided buffer of
+ * the *EncodedLength() size, for building keys and headers in place, and
+ * a std::string form. Decoders return nullopt on malformed input instead
+ * of throwing, since input usually comes from clients.
+ *
+ * Hex encoding runs 16 bytes at a time with SSE2 (always available on
+ * x86-64) or NEON (AArch64), hex decoding with SSE2. Base32 and Base64
+ * encode whole 5- and 3-byte groups and decode through lookup tables.
+ */
+
+// Hex: lowercase out, either case in
+
+constexpr size_t HexEncodedLength(size_t bytes) { return 2 * bytes; }
+
+void HexEncode(const unsigned char* data, size_t size, char* out);
+std::string HexEncode(const unsigned char* data, size_t size);
+std::string HexEncode(std::string_view bytes);
+
+/**
+ * Decode hex into `out` (hex.size() / 2 bytes)
+ *
+ * @return False on an odd length or a non-hex character; `out` is then
+ *         partially written
+ */
+bool HexDecode(std::string_view hex, unsigned char* out);
+std::optional<std::vector<uint8_t>> HexDecode(std::string_view hex);
+
+// Base32: RFC 4648 alphabet (A-Z, 2-7), as used by TOTP secrets
+
+size_t Base32EncodedLength(size_t bytes, bool padded = true);
+
+void Base32Encode(const unsigned char* data, size_t size, char* out, bool padded = true);
+std::string Base32Encode(const unsigned char* data, size_t size, bool padded = true);
+
+/**
+ * Decode Base32 in either case
+ *
+ * Whitespace, hyphens and '=' padding are skipped, so secrets typed in
+ * groups ("JBSW Y3DP") decode as well.
+ */
+std::optional<std::vector<uint8_t>> Base32Decode(std::string_view base32);
+
+// Base64: standard (+/) or URL-safe (-_) alphabet
+
+enum class Base64Alphabet {
+    STANDARD,
+    URL_SAFE
+};
+
+size_t Base64EncodedLength(size_t bytes, bool padded = true);
+
+void Base64Encode(const unsigned char* data, size_t size, char* out,
+                  Base64Alphabet alphabet = Base64Alphabet::STANDARD, bool padded = true);
+std::string Base64Encode(const unsigned char* data, size_t size,
+                         Base64Alphabet alphabet = Base64Alphabet::STANDARD, bool padded = true);
+std::string Base64Encode(std::string_view bytes,
+                         Base64Alphabet alphabet = Base64Alphabet::STANDARD, bool padded = true);
+
+/**
+ * Decode Base64, padded or not
+ *
+ * @return nullopt on a character outside the alphabet, misplaced padding
+ *         or a length no encoding produces
+ */
+std::optional<std::vector<uint8_t>> Base64Decode(
+    std::string_view base64, Base64Alphabet alphabet = Base64Alphabet::STANDARD);
+
+/**
+ * Fill `out` from the OpenSSL CSPRNG
+ *
+ * Small requests are served from a per-thread pool refilled 4 KiB at a
+ * time, so minting a token id costs a memcpy rather than a RAND_bytes
+ * call. The pool is discarded in a forked child.
+ *
+ * @throws std::runtime_error if the CSPRNG fails
+ */
+void RandomBytes(unsigned char* out, size_t size);
+
+/**
+ * Hex of `bytes` bytes from RandomBytes(), for tokens and ids
+ *
+ * @throws std::runtime_error if the CSPRNG fails
+ */
+std::string RandomHex(size_t bytes);
+
+} // namespace common
+} // namespace saasforge
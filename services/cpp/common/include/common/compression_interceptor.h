@@ -0,0 +1,112 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server interceptor compressing responses above a per-method size threshold
+ */
+
+#pragma once
+
+#include "common/metrics.h"
+#include <grpc/compression.h>
+#include <grpcpp/support/server_interceptor.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Compression for one method
+ */
+struct CompressionRule {
+    grpc_compression_algorithm algorithm = GRPC_COMPRESS_GZIP;
+    size_t min_bytes = 1024;        // Smaller responses go out uncompressed (0 = always compress)
+};
+
+/**
+ * Response compression policy
+ *
+ * FromEnv() reads GRPC_COMPRESSION_ALGORITHM (gzip, deflate or none),
+ * GRPC_COMPRESSION_MIN_BYTES, GRPC_COMPRESSION_SAMPLE_EVERY and
+ * GRPC_COMPRESSION_METHODS, a comma-separated list of per-method rules:
+ *
+ *   ListInvoices=gzip:512,GetDeliveryRecords=deflate,Login=none
+ *
+ * A rule names a method by its bare name or full path
+ * ("/saasforge.payment.PaymentService/ListInvoices"); the algorithm and
+ * the ":min_bytes" part are each optional and default to the global ones.
+ */
+struct CompressionOptions {
+    CompressionRule defaults;
+    std::unordered_map<std::string, CompressionRule> methods;
+    uint64_t sample_every = 100;    // Compressed responses per cost/ratio sample (0 = no samples)
+
+    static CompressionOptions FromEnv();
+
+    /// Rules from the GRPC_COMPRESSION_METHODS format; entries that do not parse are logged and skipped
+    static std::unordered_map<std::string, CompressionRule> ParseMethods(const std::string& spec,
+                                                                         const CompressionRule& defaults);
+
+    /// Rule for "/package.Service/Method": full path, then bare name, then defaults
+    CompressionRule RuleFor(const std::string& method) const;
+};
+
+/**
+ * Creates a CompressionInterceptor for every RPC
+ *
+ * A unary response's initial metadata, message and status go out in one
+ * batch, so when the metadata is about to be sent the serialized response
+ * is known: if it is at least min_bytes the call is switched to the
+ * method's algorithm (the same as ServerContext::set_compression_algorithm),
+ * otherwise it is sent as is. Small auth responses therefore cost nothing,
+ * while invoice and delivery listings shrink several times. Streaming
+ * responses send their metadata first, before any message exists, and are
+ * compressed only by a rule with min_bytes 0. A handler that sets an
+ * algorithm itself wins, and clients that do not accept the algorithm get
+ * identity encoding from gRPC.
+ *
+ * gRPC (1.51) implements gzip and deflate only; zstd is not available.
+ *
+ * Per method it exports:
+ *
+ *   saasforge_grpc_server_compression_total{decision}    counter (compressed, skipped)
+ *   saasforge_grpc_server_compression_ratio              histogram (sampled)
+ *   saasforge_grpc_server_compression_seconds            histogram (sampled)
+ *
+ * gRPC compresses inside the transport, out of the interceptor's sight, so
+ * every sample_every-th compressed response is also compressed here with
+ * the same zlib settings to measure its ratio and CPU time.
+ */
+class CompressionInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    struct MethodPolicy {
+        CompressionRule rule;
+        Counter* compressed = nullptr;
+        Counter* skipped = nullptr;
+        Histogram* ratio = nullptr;     // Uncompressed / compressed, in hundredths
+        Histogram* cpu = nullptr;
+        std::atomic<uint64_t> compressed_count{0};
+    };
+
+    explicit CompressionInterceptorFactory(CompressionOptions options,
+                                           MetricsRegistry& registry = MetricsRegistry::Global());
+
+    grpc::experimental::Interceptor* CreateServerInterceptor(grpc::experimental::ServerRpcInfo* info) override;
+
+    MethodPolicy& ForMethod(const char* method);
+
+    const CompressionOptions& Options() const { return options_; }
+
+private:
+    CompressionOptions options_;
+    MetricsRegistry& registry_;
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<MethodPolicy>> methods_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,79 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Pooled libcurl handles over one share of connections, DNS and TLS sessions
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * CurlPool options, set on every handle TakeEasy() returns
+ */
+struct CurlPoolOptions {
+    std::string user_agent;                          // Some APIs (GitHub) refuse requests without one
+    std::string protocols = "https";                 // CURLOPT_PROTOCOLS_STR
+    std::chrono::milliseconds connect_timeout{2000};
+    std::chrono::milliseconds request_timeout{10000};
+};
+
+/**
+ * Connections shared by the calls of one HTTP client
+ *
+ * The curl share holds the connection cache, DNS cache and TLS sessions;
+ * easy and multi handles are pooled so a call allocates neither. Handles
+ * from TakeEasy() are reset and carry the share, the options above, no
+ * redirects, HTTP/2 over TLS and TCP keepalive; the caller sets the URL,
+ * body, headers and callbacks, then hands the handle back.
+ *
+ * Thread-safe.
+ *
+ * Usage:
+ *   CurlPool pool(options);
+ *   CURL* easy = pool.TakeEasy();
+ *   curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+ *   curl_easy_perform(easy);
+ *   pool.ReturnEasy(easy);
+ */
+class CurlPool {
+public:
+    /// @throws std::runtime_error if the share handle cannot be created
+    explicit CurlPool(CurlPoolOptions options);
+    ~CurlPool();
+
+    CurlPool(const CurlPool&) = delete;
+    CurlPool& operator=(const CurlPool&) = delete;
+
+    /// A configured easy handle, or nullptr if curl_easy_init() fails
+    CURL* TakeEasy();
+    void ReturnEasy(CURL* easy);
+
+    /// A multi handle with HTTP/2 multiplexing enabled
+    /// @throws std::runtime_error if it cannot be created
+    CURLM* TakeMulti();
+    void ReturnMulti(CURLM* multi);
+
+private:
+    static void Lock(CURL*, curl_lock_data data, curl_lock_access, void* user);
+    static void Unlock(CURL*, curl_lock_data data, void* user);
+
+    void Configure(CURL* easy) const;
+
+    CurlPoolOptions options_;
+    CURLSH* share_ = nullptr;
+    std::mutex locks_[CURL_LOCK_DATA_LAST];
+    std::mutex pool_mutex_;
+    std::vector<CURL*> easy_handles_;
+    std::vector<CURLM*> multi_handles_;
+};
+
+} // namespace common
+} // namespace saasforge
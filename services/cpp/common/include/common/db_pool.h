@@ -1,22 +1,116 @@
 #pragma once
 
+#include "common/metrics.h"
+#include "common/resilience.h"
 #include <string>
 #include <memory>
 #include <pqxx/pqxx>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <shared_mutex>
 #include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace saasforge {
 namespace common {
 
+class ReplicaSet;
+
+/**
+ * DbPool sizing and maintenance options
+ *
+ * FromEnv() reads DB_POOL_MIN_SIZE, DB_POOL_MAX_SIZE,
+ * DB_POOL_ACQUIRE_TIMEOUT_MS, DB_POOL_IDLE_TIMEOUT_S,
+ * DB_POOL_HEALTH_CHECK_INTERVAL_S, DB_POOL_CANCEL_CHECK_MS,
+ * DB_REPLICA_URLS (comma-separated),
+ * DB_REPLICA_MAX_LAG_MS, DB_REPLICA_CHECK_INTERVAL_MS and
+ * DB_REPLICA_STICKY_MS, and the DB_BREAKER_* / DB_LIMIT_* settings of
+ * DependencyOptions::FromEnv("DB").
+ */
+struct DbPoolOptions {
+    size_t min_size = 2;              // Kept open (and topped up) by the maintenance thread
+    size_t max_size = 10;             // Upper bound; pool grows on demand up to this
+    std::chrono::milliseconds acquire_timeout{5000};
+    std::chrono::seconds idle_timeout{300};          // Idle connections above min_size are closed
+    std::chrono::seconds health_check_interval{30};  // Background liveness check period
+    // How often borrowed connections are checked for RPCs past their deadline
+    // or cancelled by the client; their running query is cancelled (0 = never)
+    std::chrono::milliseconds cancel_check_interval{100};
+    size_t stripes = 0;               // Idle-list shards (0 = hardware concurrency)
+    std::string name;                 // Metrics label pool=name (empty: unlabelled, the primary)
+
+    // Hot standbys for AcquireReadConnection() (see common/db_replicas.h)
+    std::vector<std::string> replica_urls;
+    std::chrono::milliseconds replica_max_lag{1000};        // Replicas lagging more are ejected
+    std::chrono::milliseconds replica_check_interval{500};  // Lag check period
+    std::chrono::milliseconds replica_sticky{5000};         // Read-your-writes window after RecordWrite()
+
+    // Circuit breaker and adaptive limit in front of AcquireConnection();
+    // zero limits are derived from max_size
+    DependencyOptions resilience;
+
+    static DbPoolOptions FromEnv();
+};
+
+/**
+ * Acquire wait-time histogram (fixed microsecond buckets)
+ */
+struct WaitHistogram {
+    static constexpr size_t NUM_BUCKETS = 10;
+
+    /// Upper bounds in microseconds; the last bucket is +Inf
+    static const std::array<int64_t, NUM_BUCKETS - 1>& BucketBoundsUs();
+
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    uint64_t count = 0;
+    int64_t sum_us = 0;
+};
+
+/**
+ * Point-in-time pool metrics
+ */
+struct DbPoolStats {
+    size_t total = 0;      // Open connections (idle + active)
+    size_t idle = 0;
+    size_t active = 0;
+    size_t waiting = 0;    // Callers blocked in GetConnection
+    uint64_t acquired = 0;
+    uint64_t timeouts = 0;
+    uint64_t created = 0;
+    uint64_t closed = 0;
+    uint64_t health_check_failures = 0;
+    uint64_t cancelled_deadline = 0;    // Queries cancelled: RPC deadline passed
+    uint64_t cancelled_abandoned = 0;   // Queries cancelled: client went away
+    WaitHistogram wait;                                      // All callers
+    std::unordered_map<std::string, WaitHistogram> callers;  // Per caller tag
+};
+
 class DbPool {
 public:
+    // Fixed-size pool (min = max = pool_size)
     DbPool(const std::string& connection_string, size_t pool_size = 10);
+    DbPool(const std::string& connection_string, const DbPoolOptions& options);
     ~DbPool();
 
-    // Get a connection from the pool (blocks if none available)
-    std::shared_ptr<pqxx::connection> GetConnection();
+    DbPool(const DbPool&) = delete;
+    DbPool& operator=(const DbPool&) = delete;
+
+    /**
+     * Get a connection from the pool
+     *
+     * Takes an idle connection, or opens a new one while below max_size,
+     * otherwise waits up to acquire_timeout (or the current RPC's
+     * deadline, see ResilienceScope, if that is sooner).
+     *
+     * @param caller Tag for per-caller wait metrics (e.g. __func__)
+     * @throws std::runtime_error on timeout or shutdown
+     */
+    std::shared_ptr<pqxx::connection> GetConnection(const char* caller = nullptr);
 
     // Return a connection to the pool
     void ReturnConnection(std::shared_ptr<pqxx::connection> conn);
@@ -24,12 +118,25 @@ public:
     // RAII wrapper for automatic connection return
     class ConnectionGuard {
     public:
-        ConnectionGuard(DbPool* pool, std::shared_ptr<pqxx::connection> conn)
-            : pool_(pool), conn_(conn) {}
+        ConnectionGuard(DbPool* pool, std::shared_ptr<pqxx::connection> conn,
+                        Dependency::Permit permit = {}, uint64_t watch = 0)
+            : pool_(pool), conn_(conn), permit_(std::move(permit)), watch_(watch) {}
 
         ~ConnectionGuard() {
             if (conn_ && pool_) {
-                pool_->ReturnConnection(conn_);
+                // libpq delivers a cancel asynchronously: a cancelled connection could
+                // still see it on its next statement, so it is closed instead of reused
+                if (watch_ && pool_->Unwatch(watch_)) {
+                    pool_->Drop(std::move(conn_));
+                    permit_.Success();
+                    return;
+                }
+                // Only a broken connection counts against the breaker, not a failed query
+                if (pool_->Recycle(std::move(conn_))) {
+                    permit_.Success();
+                } else {
+                    permit_.Failure();
+                }
             }
         }
 
@@ -42,27 +149,160 @@ public:
 
         // Allow moving
         ConnectionGuard(ConnectionGuard&& other) noexcept
-            : pool_(other.pool_), conn_(std::move(other.conn_)) {
+            : pool_(other.pool_), conn_(std::move(other.conn_)), permit_(std::move(other.permit_)),
+              watch_(other.watch_) {
             other.pool_ = nullptr;
+            other.watch_ = 0;
         }
 
     private:
         DbPool* pool_;
         std::shared_ptr<pqxx::connection> conn_;
+        Dependency::Permit permit_;
+        uint64_t watch_;           // Watchdog registration (0 = none)
     };
 
-    // Get a connection with RAII guard
-    ConnectionGuard AcquireConnection();
+    /**
+     * Get a connection with RAII guard
+     *
+     * Inside an RPC (see ResilienceScope) the query running on it is
+     * cancelled once the RPC's deadline passes or the client cancels, so
+     * abandoned work stops holding the connection; the handler sees
+     * pqxx::query_canceled (a pqxx::sql_error). A connection whose query
+     * was cancelled is closed on release rather than reused.
+     *
+     * @throws DependencyUnavailable without waiting while the pool's
+     *         breaker is open or its concurrency limit is reached
+     */
+    ConnectionGuard AcquireConnection(const char* caller = nullptr);
+
+    /**
+     * Get a connection for a read-only transaction
+     *
+     * A healthy replica when replica_urls is set, otherwise (or when every
+     * replica lags, is unreachable, or has not replayed the session's last
+     * write) the primary. Only for reads that tolerate replica_max_lag.
+     *
+     * @param caller Tag for per-caller wait metrics (e.g. __func__)
+     * @param session Read-your-writes key passed to RecordWrite() (e.g. tenant ID)
+     */
+    ConnectionGuard AcquireReadConnection(const char* caller = nullptr, const std::string& session = "");
+
+    /// After committing a write: `session`'s reads see it (no-op without replicas)
+    void RecordWrite(const std::string& session);
+
+    /// Replicas configured (they may all be ejected)
+    bool HasReplicas() const { return replicas_ != nullptr; }
+
+    // Metrics snapshot (counts, wait histograms)
+    DbPoolStats GetStats() const;
+
+    const DbPoolOptions& Options() const { return options_; }
+
+    /// Breaker and limit state ("postgres", or "postgres:<name>")
+    const Dependency& Resilience() const { return *dependency_; }
+
+    /**
+     * Stop handing out connections and close the pool
+     *
+     * New GetConnection() calls fail at once; connections still borrowed are
+     * waited for up to `timeout` and closed as they are returned. Idempotent;
+     * the destructor calls it with no timeout.
+     *
+     * @return False if connections were still borrowed at the deadline
+     */
+    bool Shutdown(std::chrono::milliseconds timeout);
 
 private:
-    std::string connection_string_;
-    std::queue<std::shared_ptr<pqxx::connection>> pool_;
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    size_t pool_size_;
-    bool shutdown_;
+    struct IdleConnection {
+        std::shared_ptr<pqxx::connection> conn;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    // Idle connections are sharded so concurrent acquire/return rarely contend
+    struct Stripe {
+        std::mutex mutex;
+        std::vector<IdleConnection> idle;  // LIFO: hot connections reused, cold ones age out
+    };
+
+    // Borrowed connection whose query is cancelled when its RPC is abandoned
+    struct Watched {
+        std::shared_ptr<pqxx::connection> conn;   // Kept alive while a cancel is in flight
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        const grpc::ServerContextBase* context = nullptr;
+        bool cancelled = false;
+    };
+
+    struct AtomicHistogram {
+        std::array<std::atomic<uint64_t>, WaitHistogram::NUM_BUCKETS> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<int64_t> sum_us{0};
+
+        void Record(int64_t wait_us);
+        WaitHistogram Snapshot() const;
+    };
+
+    bool Recycle(std::shared_ptr<pqxx::connection> conn);   // False if it was broken
+    std::shared_ptr<pqxx::connection> TryTakeIdle();
+    bool TryReserveSlot();
+    std::shared_ptr<pqxx::connection> CreateConnection();
+    void PushIdle(std::shared_ptr<pqxx::connection> conn);
+    void Discard();
+    void NotifyWaiters();
+    void RecordWait(const char* caller, std::chrono::steady_clock::duration wait);
+    size_t HomeStripe() const;
 
     void InitializePool();
+    void ExportMetrics(MetricsWriter& writer) const;
+    void MaintenanceLoop();
+    uint64_t Watch(std::shared_ptr<pqxx::connection> conn);
+    // Returns whether the watchdog cancelled the connection's query
+    bool Unwatch(uint64_t id);
+    // Close a borrowed connection and free its slot
+    void Drop(std::shared_ptr<pqxx::connection> conn);
+    void WatchdogLoop();
+    void RunMaintenance();
+    static bool IsHealthy(pqxx::connection& conn);
+
+    std::string connection_string_;
+    DbPoolOptions options_;
+    std::vector<std::unique_ptr<Stripe>> stripes_;
+    std::unique_ptr<ReplicaSet> replicas_;
+    std::unique_ptr<Dependency> dependency_;
+
+    std::atomic<size_t> total_{0};     // Open + being opened
+    std::atomic<size_t> idle_count_{0};
+    std::atomic<size_t> waiters_{0};
+    std::atomic<bool> shutdown_{false};
+    std::mutex shutdown_mutex_;          // Serialises joining the maintenance thread
+
+    // Slow path only: callers wait here when the pool is exhausted
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+
+    std::mutex maintenance_mutex_;
+    std::condition_variable maintenance_cv_;
+    std::thread maintenance_thread_;
+
+    std::mutex watch_mutex_;             // Not held while cancelling: that opens a connection
+    std::condition_variable watch_cv_;
+    std::unordered_map<uint64_t, Watched> watched_;
+    uint64_t next_watch_id_ = 1;
+    std::thread watchdog_thread_;
+
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> created_{0};
+    std::atomic<uint64_t> closed_{0};
+    std::atomic<uint64_t> health_check_failures_{0};
+    std::atomic<uint64_t> cancelled_deadline_{0};
+    std::atomic<uint64_t> cancelled_abandoned_{0};
+
+    AtomicHistogram wait_histogram_;
+    mutable std::shared_mutex callers_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<AtomicHistogram>> caller_histograms_;
+
+    uint64_t metrics_collector_ = 0;   // Exports GetStats() on each scrape
 };
 
 } // namespace common
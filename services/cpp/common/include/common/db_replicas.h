@@ -0,0 +1,143 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Read replica routing with lag-based ejection for DbPool
+ */
+
+#pragma once
+
+#include "common/executor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+class DbPool;
+struct DbPoolOptions;
+
+/// One lag check of a replica
+struct ReplicaSample {
+    uint64_t replay_lsn = 0;                  // pg_last_wal_replay_lsn()
+    std::chrono::milliseconds replay_age{0};  // NOW() - pg_last_xact_replay_timestamp()
+};
+
+/// Point-in-time state of a replica
+struct ReplicaStatus {
+    std::string name;
+    bool healthy = false;
+    std::chrono::milliseconds lag{0};
+    uint64_t replay_lsn = 0;
+};
+
+/**
+ * Hot standbys serving DbPool::AcquireReadConnection()
+ *
+ * Owned by the primary DbPool when DbPoolOptions::replica_urls is set. Each
+ * replica gets its own DbPool (same sizing, metrics labelled
+ * pool="replica-N"), opened by the monitor so an unreachable replica
+ * never delays startup.
+ *
+ * Every replica_check_interval the monitor reads the primary's WAL position,
+ * then each replica's replay position. A replica that has replayed up to the
+ * primary has no lag; otherwise its lag is the age of the last transaction
+ * it replayed. Replicas that are unreachable or lag more than
+ * replica_max_lag are ejected until a later check finds them caught up.
+ * With no healthy replica, reads go to the primary.
+ *
+ * Read-your-writes: after RecordWrite(session), reads for that session stay
+ * on the primary until the monitor has sampled the primary's WAL position
+ * past the write, and then only use replicas that replayed that position.
+ * The constraint is dropped after replica_sticky, which must exceed
+ * replica_max_lag.
+ */
+class ReplicaSet {
+public:
+    /// Current WAL position of the primary; throws when unreachable
+    using PrimaryProbe = std::function<uint64_t()>;
+    /// Sample replica `index`; throws when unreachable
+    using ReplicaProbe = std::function<ReplicaSample(size_t index)>;
+
+    /// Replicas from options.replica_urls, lag measured against `primary`
+    ReplicaSet(DbPool& primary, const DbPoolOptions& options);
+    /// Custom probes and no pools (tests)
+    ReplicaSet(size_t replicas, PrimaryProbe primary, ReplicaProbe replica, const DbPoolOptions& options);
+    ~ReplicaSet();
+
+    ReplicaSet(const ReplicaSet&) = delete;
+    ReplicaSet& operator=(const ReplicaSet&) = delete;
+
+    /**
+     * Replica to serve a read for `session`
+     *
+     * @param session Read-your-writes key (empty: any healthy replica)
+     * @return Replica index, or -1 to read from the primary
+     */
+    int Choose(const std::string& session);
+
+    /// Pool of replica `index`; null until it is connected
+    DbPool* Pool(int index);
+
+    /// Note a committed write by `session` (see class comment)
+    void RecordWrite(const std::string& session);
+
+    /// One monitor round (normally run periodically on Executor::Background())
+    void Check();
+
+    std::vector<ReplicaStatus> GetStatus() const;
+
+    /// Stop the monitor and close the replica pools (idempotent)
+    void Shutdown(std::chrono::milliseconds timeout);
+
+    /// "16/B374D848" -> 0x16B374D848 (0 if malformed)
+    static uint64_t ParseLsn(const std::string& lsn);
+
+private:
+    struct Replica {
+        std::string name;
+        bool healthy = false;
+        std::chrono::milliseconds lag{0};
+        uint64_t replay_lsn = 0;
+    };
+
+    void Start(size_t replicas);
+    void Monitor();
+    ReplicaSample ProbeReplica(size_t index);
+
+    std::vector<std::string> urls_;
+    std::unique_ptr<DbPoolOptions> replica_options_;
+    std::chrono::milliseconds max_lag_;
+    std::chrono::milliseconds check_interval_;
+    std::chrono::milliseconds sticky_;
+    PrimaryProbe probe_primary_;
+    ReplicaProbe probe_replica_;
+
+    mutable std::shared_mutex state_mutex_;
+    std::vector<std::unique_ptr<DbPool>> pools_;   // Opened by the monitor, kept until destruction
+    std::vector<Replica> replicas_;
+    uint64_t primary_lsn_ = 0;
+    std::chrono::steady_clock::time_point primary_sampled_at_{};
+
+    std::mutex writes_mutex_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> writes_;
+
+    std::atomic<uint64_t> next_{0};
+    std::atomic<uint64_t> replica_reads_{0};
+    std::atomic<uint64_t> primary_reads_{0};
+    std::atomic<uint64_t> ejections_{0};
+    uint64_t metrics_collector_ = 0;
+
+    std::atomic<bool> shutdown_{false};
+    uint64_t periodic_ = 0;   // Monitor on Executor::Background()
+};
+
+} // namespace common
+} // namespace saasforge
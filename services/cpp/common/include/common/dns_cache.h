@@ -0,0 +1,138 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Resolve-then-check DNS cache for webhook SSRF validation
+ */
+
+#pragma once
+
+#include "common/executor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * DnsCache options
+ *
+ * FromEnv() reads DNS_CACHE_POSITIVE_TTL_S, DNS_CACHE_NEGATIVE_TTL_S,
+ * DNS_CACHE_MAX_ENTRIES, DNS_RESOLVER_THREADS and DNS_RESOLVE_TIMEOUT_MS.
+ */
+struct DnsCacheOptions {
+    std::chrono::seconds positive_ttl{60};   // getaddrinfo() exposes no record TTL; bounded re-resolution instead
+    std::chrono::seconds negative_ttl{10};   // Failed and blocked lookups
+    size_t max_entries = 10000;
+    size_t resolver_threads = 4;             // Concurrent getaddrinfo() calls
+    std::chrono::milliseconds resolve_timeout{2000};  // Resolve() wait; the lookup itself keeps running
+
+    static DnsCacheOptions FromEnv();
+};
+
+enum class DnsStatus {
+    OK,        // Every address is public
+    BLOCKED,   // At least one address is private/loopback/link-local/reserved
+    FAILED     // NXDOMAIN, resolver error, timeout
+};
+
+struct DnsResult {
+    DnsStatus status = DnsStatus::FAILED;
+    std::vector<std::string> addresses;  // Numeric addresses (only set when OK)
+    std::string error;
+};
+
+/**
+ * Scheme, host and port of an http(s) URL
+ */
+struct UrlEndpoint {
+    std::string scheme;  // "http" or "https"
+    std::string host;    // Lowercase, IPv6 without brackets
+    int port = 0;        // Explicit or scheme default
+};
+
+/**
+ * Shared resolver for SSRF checks
+ *
+ * A literal host check cannot stop a public name that resolves to
+ * 10.0.0.5 or 169.254.169.254. DnsCache resolves the name and rejects it if
+ * any address is non-public, and callers then connect to exactly those
+ * addresses (WebhookDispatcher pins them with CURLOPT_RESOLVE), so a second
+ * lookup by the HTTP client cannot be rebound elsewhere.
+ *
+ * Lookups run on a small executor and are coalesced per host; results are
+ * cached for positive_ttl (negative_ttl for failures), so a webhook is
+ * resolved once per TTL rather than once per delivery.
+ *
+ * Usage:
+ *   DnsCache dns(DnsCacheOptions::FromEnv());
+ *   auto result = dns.Resolve("hooks.example.com");   // blocking
+ *   auto ready = dns.TryGet("hooks.example.com");     // never blocks
+ */
+class DnsCache {
+public:
+    explicit DnsCache(const DnsCacheOptions& options = {});
+    ~DnsCache();
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    /**
+     * Resolve a host, waiting up to resolve_timeout
+     */
+    DnsResult Resolve(const std::string& host);
+
+    /**
+     * Cached result if available; otherwise starts a lookup and returns nullopt
+     */
+    std::optional<DnsResult> TryGet(const std::string& host);
+
+    size_t Size() const;
+    uint64_t HitCount() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t MissCount() const { return misses_.load(std::memory_order_relaxed); }
+
+    /**
+     * Whether a numeric IPv4/IPv6 address is publicly routable
+     *
+     * Rejects RFC 1918, loopback, link-local, CGNAT, multicast, reserved and
+     * documentation ranges, IPv6 ULA, and IPv4-mapped/NAT64 forms of those.
+     */
+    static bool IsPublicAddress(const std::string& address);
+
+    /**
+     * Split an http(s) URL into scheme, host and port
+     *
+     * @return Endpoint, or nullopt if the URL is not http(s) or has no host
+     */
+    static std::optional<UrlEndpoint> ParseUrl(const std::string& url);
+
+private:
+    struct Entry {
+        uint64_t id = 0;  // Distinguishes a refreshed entry from the one a lookup was started for
+        std::shared_future<DnsResult> result;
+        std::chrono::steady_clock::time_point expires_at = std::chrono::steady_clock::time_point::max();
+    };
+
+    std::shared_future<DnsResult> Lookup(const std::string& host, bool* hit);
+    void EvictLocked(std::chrono::steady_clock::time_point now);
+    static DnsResult ResolveNow(const std::string& host);
+
+    DnsCacheOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t next_id_ = 0;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    Executor executor_;  // Declared last: joined before the map it writes to is destroyed
+};
+
+} // namespace common
+} // namespace saasforge
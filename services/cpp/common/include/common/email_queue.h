@@ -10,8 +10,15 @@
 #include <memory>
 #include <chrono>
 #include <optional>
+#include <mutex>
+#include <unordered_set>
 #include <vector>
 #include "db_pool.h"
+#include "payload_codec.h"
+#include "queue_notifier.h"
+#include "record_batch.h"
+#include "suppression_filter.h"
+#include "tenant_fair_scheduler.h"
 
 namespace saasforge {
 namespace common {
@@ -35,6 +42,17 @@ enum class EmailStatus {
     BOUNCED = 6      // Hard bounce (permanent failure)
 };
 
+/**
+ * Delivery lane
+ *
+ * Each lane has its own partial index and is claimed separately, so a
+ * campaign of a million bulk rows never sits in front of an OTP.
+ */
+enum class EmailLane {
+    TRANSACTIONAL = 0,  // OTPs, password resets, receipts: claimed first, by priority
+    BULK = 1            // Campaigns and digests: shared fairly across tenants, rate-capped
+};
+
 /**
  * Email bounce type (Requirement E-113)
  */
@@ -57,12 +75,59 @@ struct QueuedEmail {
     std::string body_text;
     std::string template_id;
     EmailStatus status;
+    EmailLane lane;
     int retry_count;
     int64_t created_at;
     int64_t scheduled_at;  // When to send/retry
     int64_t sent_at;
     BounceType bounce_type;
     std::string error_message;
+    std::string body_html_data{};   // Claimed bodies still encoded (bytea output) until
+    std::string body_text_data{};   // EmailQueue::DecodeBodies(); empty if inline
+};
+
+/**
+ * Claimed emails, column by column (EmailQueue::ClaimBatch)
+ */
+using EmailBatch = RecordBatch<QueuedEmail,
+    &QueuedEmail::id, &QueuedEmail::tenant_id, &QueuedEmail::user_id, &QueuedEmail::to_address,
+    &QueuedEmail::subject, &QueuedEmail::body_html, &QueuedEmail::body_text, &QueuedEmail::template_id,
+    &QueuedEmail::status, &QueuedEmail::lane, &QueuedEmail::retry_count, &QueuedEmail::created_at,
+    &QueuedEmail::scheduled_at, &QueuedEmail::sent_at, &QueuedEmail::bounce_type, &QueuedEmail::error_message,
+    &QueuedEmail::body_html_data, &QueuedEmail::body_text_data>;
+
+/**
+ * Outcome of one failed send, for EmailQueue::MarkFailedBatch()
+ */
+struct EmailFailure {
+    std::string email_id;
+    std::string error_message;
+    bool is_hard_bounce = false;
+    bool held = false;          // Retry the caller holds in memory (MarkFailedBatch)
+};
+
+/**
+ * One tenant's delivery outcomes over a window, for EmailQueue::GetBounceRates()
+ */
+struct TenantBounceRate {
+    std::string tenant_id;
+    int64_t sent = 0;
+    int64_t soft_bounced = 0;
+    int64_t hard_bounced = 0;
+    int64_t finished = 0;       // Sent, exhausted or hard-bounced
+    double rate = 0.0;          // hard_bounced / finished, as a percentage (0-100)
+};
+
+/**
+ * Dequeue tuning for EmailQueue
+ */
+struct EmailQueueOptions {
+    TenantFairSchedulerOptions fairness;                // Bulk lane share and per-tenant caps
+    int max_tenants = 256;                              // Bulk tenants considered per refresh
+    std::chrono::milliseconds tenant_refresh{1000};     // How long the list of bulk tenants is reused
+
+    /// fairness from EMAIL_QUEUE_TENANT_*, plus EMAIL_QUEUE_MAX_TENANTS, EMAIL_QUEUE_TENANT_REFRESH_MS
+    static EmailQueueOptions FromEnv();
 };
 
 /**
@@ -77,10 +142,41 @@ struct QueuedEmail {
  * - Hard bounce: Mark as BOUNCED, suppress future sends
  * - Soft bounce: Retry up to 3 times over 72 hours
  * - Alert when bounce rate exceeds 5%
+ * - Outcomes are counted per tenant per minute as they are recorded
+ *   (email_delivery_stats), so bounce rates read at most
+ *   MAX_BOUNCE_WINDOW_HOURS * 60 rows per tenant instead of the queue
+ * - With a SuppressionFilter, Enqueue() only queries email_suppression for
+ *   addresses the filter cannot rule out; every suppression is passed to
+ *   SuppressionFilter::Add(), which publishes it to other replicas' filters
+ *
+ * Dequeue order:
+ * - TRANSACTIONAL lane first, by priority then scheduled_at
+ * - Remaining capacity goes to the BULK lane, split across tenants by
+ *   deficit round-robin and capped per tenant (TenantFairScheduler)
+ * - Claims only read email_queue_active; sent, exhausted and bounced rows
+ *   live in daily partitions pruned by QueuePartitionMaintainer
+ * - Rows claimed by this instance and not yet marked are tracked, so a
+ *   worker shutting down hands them back with ReleaseClaimed() instead of
+ *   leaving them in SENDING
  */
 class EmailQueue {
 public:
-    explicit EmailQueue(std::shared_ptr<DbPool> db_pool);
+    /// NOTIFY channel Enqueue() signals; pass it to the QueueNotifier
+    static constexpr const char* NOTIFY_CHANNEL = "email_queue";
+
+    /**
+     * Bodies of PayloadCodecOptions::min_size bytes or more are stored
+     * deflated in payload_blobs, once per distinct content (PayloadCodec,
+     * options from the environment); claims return them still encoded.
+     *
+     * @param db_pool Connection pool
+     * @param notifier Optional listener; without it WaitForBatch() polls
+     * @param options Lane fairness and per-tenant caps
+     * @param suppressions Optional filter consulted before the suppression table
+     */
+    explicit EmailQueue(std::shared_ptr<DbPool> db_pool, std::shared_ptr<QueueNotifier> notifier = nullptr,
+                        const EmailQueueOptions& options = {},
+                        std::shared_ptr<SuppressionFilter> suppressions = nullptr);
 
     /**
      * Enqueue an email for delivery
@@ -92,7 +188,8 @@ public:
      * @param body_html HTML body
      * @param body_text Plain text body (fallback)
      * @param template_id Optional template ID
-     * @param priority Higher priority = sent sooner (0-10, default 5)
+     * @param priority Higher priority = sent sooner within the lane (0-10, default 5)
+     * @param lane BULK for campaigns; TRANSACTIONAL (default) is never held behind them
      * @return Email ID
      */
     std::string Enqueue(
@@ -103,17 +200,53 @@ public:
         const std::string& body_html,
         const std::string& body_text = "",
         const std::string& template_id = "",
-        int priority = 5
+        int priority = 5,
+        EmailLane lane = EmailLane::TRANSACTIONAL
     );
 
     /**
-     * Get next batch of emails ready to send
+     * Claim the next batch of emails ready to send
+     *
+     * Transactional emails fill the batch first; what is left is shared
+     * among tenants with due bulk emails. Bulk emails held back by a
+     * tenant's rate cap stay PENDING.
+     *
+     * Bodies kept in payload_blobs come back encoded in body_*_data (the
+     * body fields are then empty); the sender decodes them with
+     * DecodeBodies() only when the email is about to go out.
+     *
+     * @param batch_size Maximum emails to retrieve
+     * @return Claimed emails, in columns with their text in one buffer
+     */
+    EmailBatch ClaimBatch(int batch_size = 10);
+
+    /**
+     * ClaimBatch() as one QueuedEmail per row
      *
      * @param batch_size Maximum emails to retrieve
      * @return Vector of queued emails
      */
     std::vector<QueuedEmail> GetNextBatch(int batch_size = 10);
 
+    /**
+     * Decode a claimed email's body_*_data into its bodies (no-op when inline)
+     *
+     * @throws std::runtime_error if a stored body cannot be decoded
+     */
+    void DecodeBodies(QueuedEmail& email);
+
+    /**
+     * Get the next batch, blocking until emails are ready or max_wait elapses
+     *
+     * Wakes on Enqueue() notifications and, for retries scheduled in the
+     * future, at the earliest scheduled_at; there is no fixed-rate polling.
+     *
+     * @param batch_size Maximum emails to retrieve
+     * @param max_wait Maximum time to block
+     * @return Claimed emails (empty on timeout)
+     */
+    std::vector<QueuedEmail> WaitForBatch(int batch_size, std::chrono::milliseconds max_wait);
+
     /**
      * Mark email as successfully sent
      *
@@ -121,6 +254,14 @@ public:
      */
     void MarkSent(const std::string& email_id);
 
+    /**
+     * Mark a batch of emails as sent in one statement
+     *
+     * @param email_ids Email IDs
+     * @return Number of emails updated
+     */
+    size_t MarkSentBatch(const std::vector<std::string>& email_ids);
+
     /**
      * Mark email as failed and schedule retry if applicable
      *
@@ -130,6 +271,70 @@ public:
      */
     void MarkFailed(const std::string& email_id, const std::string& error_message, bool is_hard_bounce = false);
 
+    /**
+     * Record a batch of failed sends in one statement
+     *
+     * Each email is moved to RETRY (with the D-98 backoff computed in SQL),
+     * EXHAUSTED, or BOUNCED; hard-bounced addresses are suppressed in the
+     * same statement.
+     *
+     * A failure marked `held` is a retry the caller keeps in memory and
+     * re-sends itself (ReclaimHeldBatch); its scheduled_at is pushed
+     * hold_lease further out, so other workers leave it alone unless this
+     * process is gone by then.
+     *
+     * @param failures Failed sends
+     * @param hold_lease Extra delay for held retries
+     * @return Number of emails updated
+     */
+    size_t MarkFailedBatch(const std::vector<EmailFailure>& failures,
+                           std::chrono::seconds hold_lease = std::chrono::seconds(0));
+
+    /**
+     * Claim held retries that are due, by ID rather than an index scan
+     *
+     * An email is claimed only if it is still in RETRY with the
+     * retry_count the caller holds; otherwise another worker took it after
+     * the hold lease.
+     *
+     * @param held Emails held since MarkFailedBatch, retry_count already advanced
+     * @return IDs now in SENDING and owned by the caller
+     */
+    std::vector<std::string> ReclaimHeldBatch(const std::vector<QueuedEmail>& held);
+
+    /**
+     * Hand held retries back to the queue at their real backoff (shutdown)
+     *
+     * @param held Emails held since MarkFailedBatch
+     * @param hold_lease The lease they were marked with
+     * @return Number of emails released
+     */
+    size_t ReleaseHeldBatch(const std::vector<QueuedEmail>& held, std::chrono::seconds hold_lease);
+
+    /**
+     * Return claimed emails to the queue without counting an attempt
+     *
+     * Rows go back to PENDING (RETRY if they were already retried) and are
+     * claimable immediately.
+     *
+     * @param email_ids Emails currently in SENDING
+     * @return Number of emails released
+     */
+    size_t ReleaseBatch(const std::vector<std::string>& email_ids);
+
+    /**
+     * Release every email this instance claimed and has not marked yet
+     *
+     * Called on shutdown, after the workers stopped, so in-flight rows are
+     * picked up by another replica instead of waiting in SENDING.
+     *
+     * @return Number of emails released
+     */
+    size_t ReleaseClaimed();
+
+    /// Emails claimed by this instance and not yet marked sent, failed or released
+    size_t ClaimedCount() const;
+
     /**
      * Mark email as bounced (hard or soft)
      *
@@ -142,12 +347,27 @@ public:
     /**
      * Get bounce rate for monitoring
      *
+     * Hard bounces over finished sends (sent, exhausted or hard-bounced) in
+     * the window; emails still pending or retrying are not counted.
+     *
      * @param tenant_id Tenant ID (empty for global)
-     * @param hours Time window in hours (default 24)
+     * @param hours Time window in hours (default 24, at most MAX_BOUNCE_WINDOW_HOURS)
      * @return Bounce rate as percentage (0-100)
      */
     double GetBounceRate(const std::string& tenant_id = "", int hours = 24);
 
+    /**
+     * Bounce rates of every tenant with mail in the window, in one query
+     *
+     * For alert sweeps: one grouped read of the counters instead of a
+     * GetBounceRate() call per tenant.
+     *
+     * @param hours Time window in hours (default 24, at most MAX_BOUNCE_WINDOW_HOURS)
+     * @param min_emails Skip tenants with fewer finished sends than this
+     * @return One entry per tenant, unordered
+     */
+    std::vector<TenantBounceRate> GetBounceRates(int hours = 24, int64_t min_emails = 1);
+
     /**
      * Suppress email address (hard bounce)
      *
@@ -159,11 +379,21 @@ public:
     /**
      * Check if email address is suppressed
      *
+     * Answered from the SuppressionFilter when it rules the address out;
+     * possible matches are confirmed against the table.
+     *
      * @param email_address Email to check
      * @return True if suppressed
      */
     bool IsAddressSuppressed(const std::string& email_address);
 
+    /**
+     * Every suppressed address, for callers that cache the list in memory
+     *
+     * @return Suppressed email addresses
+     */
+    std::vector<std::string> ListSuppressedAddresses();
+
     /**
      * Get email status by ID
      *
@@ -186,6 +416,15 @@ public:
      */
     static int64_t GetRetryDelay(int retry_count);
 
+    /**
+     * Bounce rate as a percentage
+     *
+     * @param bounced Hard bounces
+     * @param total Finished sends
+     * @return 0-100; 0 when there were no sends
+     */
+    static double BounceRate(int64_t bounced, int64_t total);
+
     /**
      * Status enum to string
      */
@@ -196,8 +435,40 @@ public:
      */
     static EmailStatus StringToStatus(const std::string& status);
 
+    /// Maximum retries before an email is EXHAUSTED (Requirement D-98)
+    static constexpr int MAX_RETRIES = 3;
+
+    /// Longest GetBounceRate() window; email_delivery_stats keeps this many hours of minutes
+    static constexpr int MAX_BOUNCE_WINDOW_HOURS = 48;
+
 private:
     std::shared_ptr<DbPool> db_pool_;
+    std::shared_ptr<QueueNotifier> notifier_;
+    std::shared_ptr<SuppressionFilter> suppressions_;
+    EmailQueueOptions options_;
+    TenantFairScheduler scheduler_;
+    PayloadCodec payloads_;
+
+    // Tenants with due bulk emails, re-read every tenant_refresh
+    std::mutex tenants_mutex_;
+    std::vector<std::string> bulk_tenants_;
+    std::chrono::steady_clock::time_point bulk_tenants_read_{};
+    std::string bulk_cursor_;                      // Next refresh starts after this tenant (max_tenants reached)
+    std::chrono::milliseconds throttled_for_{0};   // Set when the last batch was held back by caps
+
+    // Claimed and not yet marked, for ReleaseClaimed()
+    mutable std::mutex claimed_mutex_;
+    std::unordered_set<std::string> claimed_;
+
+    std::vector<std::string> BulkTenants(pqxx::work& txn);
+    void Unclaim(const std::vector<std::string>& email_ids);
+
+    /**
+     * Time until the earliest pending/retry email is due, capped at `cap`
+     *
+     * @param transactional_only Ignore the bulk lane (its tenants are rate-capped)
+     */
+    std::chrono::milliseconds TimeUntilNextDue(std::chrono::milliseconds cap, bool transactional_only = false);
 
     /**
      * Check if email should be retried
@@ -0,0 +1,188 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Compiled email templates and their per-tenant cache
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include "common/string_builder.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * A template parsed once into literal and variable segments
+ *
+ * Syntax is the Mustache subset the email_templates table documents:
+ * {{name}} substitutes a variable (HTML-escaped in HTML templates),
+ * {{{name}}} substitutes it unescaped and {{! ...}} is a comment. Unknown
+ * variables render as nothing. Sections and partials are not supported;
+ * their tags are treated as variable names and so also render as nothing.
+ *
+ * Rendering walks the segment list appending into the caller's buffer:
+ * literals are copied straight from the source, variables are looked up
+ * by pre-built std::string keys, so nothing is allocated per variable.
+ */
+class CompiledTemplate {
+public:
+    CompiledTemplate() = default;
+
+    /**
+     * @param source Template text
+     * @param html Escape {{name}} substitutions for HTML
+     */
+    static CompiledTemplate Compile(std::string source, bool html);
+
+    /**
+     * Append the rendered template to out
+     *
+     * @param vars Map-like (std::unordered_map, google::protobuf::Map) from
+     *        variable name to value, searched with find(const std::string&)
+     */
+    template <typename Vars>
+    void Render(const Vars& vars, std::string& out) const {
+        for (const Segment& segment : segments_) {
+            if (segment.variable < 0) {
+                out.append(source_.data() + segment.offset, segment.length);
+                continue;
+            }
+            auto it = vars.find(variables_[static_cast<size_t>(segment.variable)]);
+            if (it == vars.end()) {
+                continue;
+            }
+            if (segment.escape) {
+                AppendHtmlEscaped(out, it->second);
+            } else {
+                out.append(it->second);
+            }
+        }
+    }
+
+    /// Distinct variable names, in order of first use
+    const std::vector<std::string>& Variables() const { return variables_; }
+
+    size_t SegmentCount() const { return segments_.size(); }
+
+private:
+    struct Segment {
+        uint32_t offset = 0;    // Literal text in source_
+        uint32_t length = 0;
+        int32_t variable = -1;  // Index into variables_; -1 for literals
+        bool escape = false;
+    };
+
+    std::string source_;
+    std::vector<Segment> segments_;
+    std::vector<std::string> variables_;
+};
+
+/**
+ * An email_templates row
+ */
+struct EmailTemplateSource {
+    std::string id;
+    std::string subject;
+    std::string body_html;
+    std::string body_text;
+    int64_t version = 0;    // updated_at in microseconds
+};
+
+/**
+ * Subject and bodies of one template version, ready to render
+ */
+struct EmailTemplate {
+    std::string id;
+    int64_t version = 0;
+    CompiledTemplate subject;     // Plain text: a header, not HTML
+    CompiledTemplate body_html;
+    CompiledTemplate body_text;
+
+    static std::shared_ptr<const EmailTemplate> Compile(EmailTemplateSource source);
+};
+
+/**
+ * EmailTemplateCache options
+ *
+ * FromEnv() reads EMAIL_TEMPLATE_TTL_S and EMAIL_TEMPLATE_CACHE_MAX.
+ */
+struct EmailTemplateOptions {
+    std::chrono::seconds ttl{300};   // Reload bound for edits made outside this instance
+    size_t max_entries = 10000;
+
+    static EmailTemplateOptions FromEnv();
+};
+
+/**
+ * Compiled email templates by (tenant, template id)
+ *
+ * A template is loaded and compiled on first use. After `ttl` the row is
+ * fetched again, and only recompiled if its version (updated_at) changed,
+ * so a campaign rendering the same template for every recipient pays for
+ * one query per ttl and one compile per edit. A tenant's own template
+ * shadows a system template (tenant_id NULL) with the same id or slug.
+ *
+ * Usage:
+ *   EmailTemplateCache templates(db_pool, EmailTemplateOptions::FromEnv());
+ *   auto compiled = templates.Get(tenant_id, "password-reset");
+ *   if (compiled) compiled->body_html.Render(request->template_vars(), html);
+ */
+class EmailTemplateCache {
+public:
+    /// Loads a template by id or slug; nullopt if the tenant has no such template
+    using Loader = std::function<std::optional<EmailTemplateSource>(const std::string& tenant_id,
+                                                                    const std::string& template_id)>;
+
+    EmailTemplateCache(std::shared_ptr<DbPool> db_pool, const EmailTemplateOptions& options = {});
+
+    /// Custom source (tests)
+    EmailTemplateCache(Loader loader, const EmailTemplateOptions& options = {});
+
+    EmailTemplateCache(const EmailTemplateCache&) = delete;
+    EmailTemplateCache& operator=(const EmailTemplateCache&) = delete;
+
+    /**
+     * Compiled template, or nullptr if it does not exist
+     *
+     * @throws std::runtime_error if the template is not cached and loading fails
+     */
+    std::shared_ptr<const EmailTemplate> Get(const std::string& tenant_id, const std::string& template_id);
+
+    /// Forget one template; the next Get() reloads it
+    void Invalidate(const std::string& tenant_id, const std::string& template_id);
+
+    /// Forget all of a tenant's templates
+    void InvalidateTenant(const std::string& tenant_id);
+
+    size_t Size() const;
+
+private:
+    struct Entry {
+        std::string tenant_id;
+        std::shared_ptr<const EmailTemplate> compiled;
+        std::chrono::steady_clock::time_point loaded_at;
+    };
+
+    static std::string Key(const std::string& tenant_id, const std::string& template_id);
+
+    Loader loader_;
+    EmailTemplateOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    // Bumped by every invalidation; a load that raced one is returned but not cached
+    uint64_t generation_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,149 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-endpoint webhook health scores and circuit state, shared across replicas
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "redis_client.h"
+
+namespace saasforge {
+namespace common {
+
+/**
+ * EndpointHealth options
+ *
+ * FromEnv() reads WEBHOOK_HEALTH_FAILURE_THRESHOLD,
+ * WEBHOOK_HEALTH_MIN_SUCCESS_PCT, WEBHOOK_HEALTH_OPEN_MS,
+ * WEBHOOK_HEALTH_MAX_OPEN_MS and WEBHOOK_HEALTH_PROBE_TIMEOUT_MS.
+ */
+struct EndpointHealthOptions {
+    double smoothing = 0.1;                         // EWMA weight of each attempt
+    uint32_t failure_threshold = 5;                 // Consecutive failures that open the circuit
+    double min_success_rate = 0.2;                  // ... or the success EWMA falling below this
+    uint32_t min_samples = 20;                      // Attempts before the EWMA can open it
+    std::chrono::milliseconds open_duration{30000};     // Deferral before the first probe
+    std::chrono::milliseconds max_open_duration{600000};  // Doubled per failed probe up to this
+    std::chrono::milliseconds probe_timeout{30000};     // A probe never reported is given up after this
+    size_t max_hosts = 10000;                       // Tracked endpoints; healthy ones are dropped beyond
+    int64_t retention_seconds = 24 * 3600;          // Shared entries kept past their open period
+
+    static EndpointHealthOptions FromEnv();
+};
+
+enum class EndpointState {
+    CLOSED = 0,      // Attempts flow
+    OPEN = 1,        // Deferred until open_until
+    HALF_OPEN = 2,   // One probe at a time decides
+};
+
+struct EndpointHealthSnapshot {
+    EndpointState state = EndpointState::CLOSED;
+    double success_rate = 1.0;          // EWMA, 1 = every attempt succeeded
+    double latency_ms = 0;              // EWMA of attempt duration
+    uint32_t consecutive_failures = 0;
+    int64_t open_until_ms = 0;          // Unix ms; 0 while closed
+    bool probing = false;               // HALF_OPEN probe in flight
+};
+
+/**
+ * Health table for webhook destinations, keyed by WebhookDispatcher::HostKey
+ *
+ * Every attempt updates an EWMA success rate and latency for its host.
+ * After failure_threshold consecutive failures (or a success rate below
+ * min_success_rate) the host's circuit opens: Allow() refuses it until
+ * open_until, so its deliveries are deferred without a connect/timeout
+ * cycle each. Then the circuit is half-open and a single probe goes out;
+ * a success closes it, a failure reopens it for twice as long (up to
+ * max_open_duration).
+ *
+ * Opening and closing write one field of a Redis hash and publish it, so
+ * every replica defers a dead host as soon as one has found it dead. The
+ * hash is reloaded on every (re)subscribe; per-attempt statistics stay
+ * local. Each replica probes on its own once the open period ends.
+ *
+ * Thread-safe. Times are Unix milliseconds so replicas agree on them.
+ *
+ * Usage:
+ *   EndpointHealth health(redis_client, EndpointHealthOptions::FromEnv());
+ *   if (health.Allow(host)) { ... health.RecordSuccess(host, latency); }
+ *   else { defer by health.RetryAfter(host); }
+ */
+class EndpointHealth {
+public:
+    static constexpr const char* CHANNEL = "webhook:endpoint_health";
+    static constexpr const char* KEY = "webhook:endpoint_health";
+
+    /// redis_client may be null (local only, e.g. tests)
+    explicit EndpointHealth(std::shared_ptr<RedisClient> redis_client,
+                            const EndpointHealthOptions& options = {});
+    ~EndpointHealth();
+
+    EndpointHealth(const EndpointHealth&) = delete;
+    EndpointHealth& operator=(const EndpointHealth&) = delete;
+
+    /**
+     * Whether an attempt to host may start now
+     *
+     * Always true while closed. When half-open, true for one caller only:
+     * it holds the probe until it records the outcome (or probe_timeout).
+     */
+    bool Allow(const std::string& host);
+
+    /**
+     * Time until host may be attempted; zero unless its circuit is open
+     *
+     * Does not claim the probe, so it is safe to check before Allow().
+     */
+    std::chrono::milliseconds RetryAfter(const std::string& host) const;
+
+    /// Record an attempt that reached the endpoint and got a healthy answer
+    void RecordSuccess(const std::string& host, std::chrono::milliseconds latency);
+
+    /// Record an attempt that failed to connect, timed out, or got 5xx/429
+    void RecordFailure(const std::string& host, std::chrono::milliseconds latency);
+
+    /// Current health of host, nullopt if it is not tracked
+    std::optional<EndpointHealthSnapshot> Get(const std::string& host) const;
+
+    /// Apply a shared transition (from pub/sub, or made by this process); open_until_ms 0 closes
+    void Note(const std::string& host, int64_t open_until_ms);
+
+    /// Number of tracked endpoints
+    size_t Size() const;
+
+    static int64_t NowMillis();
+
+private:
+    struct Entry {
+        EndpointHealthSnapshot health;
+        uint32_t samples = 0;     // Attempts since the circuit last closed
+        uint32_t reopened = 0;    // Failed probes in a row
+        int64_t probe_started_ms = 0;
+    };
+
+    // Entry for host, creating it if there is room; null when the table is full
+    Entry* Track(const std::string& host);
+    void Record(const std::string& host, bool success, std::chrono::milliseconds latency);
+    void Publish(const std::string& host, int64_t open_until_ms);
+    void Reload();
+
+    std::shared_ptr<RedisClient> redis_client_;
+    EndpointHealthOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t subscription_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
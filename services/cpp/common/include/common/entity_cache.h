@@ -0,0 +1,429 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Cache-aside for protobuf entities: sharded local LRU over Redis, single-flight fills
+ */
+
+#pragma once
+
+#include "common/event_bus.h"
+#include "common/redis_client.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * EntityCache options
+ *
+ * FromEnv() reads ENTITY_CACHE_CAPACITY, ENTITY_CACHE_LOCAL_TTL_MS,
+ * ENTITY_CACHE_TTL_S and ENTITY_CACHE_BETA.
+ */
+struct EntityCacheOptions {
+    size_t capacity = 10000;                      // Local entries per cache
+    std::chrono::milliseconds local_ttl{5000};    // Local entries re-read Redis after this
+    std::chrono::seconds ttl{60};                 // A loaded value is reloaded after this
+    double beta = 1.0;                            // Early refresh eagerness; 0 refreshes only on expiry
+
+    static EntityCacheOptions FromEnv();
+};
+
+/**
+ * The shared tier (Redis by default); an empty store leaves only the local one
+ */
+struct EntityCacheStore {
+    std::function<std::optional<std::string>(const std::string& key)> get;
+    std::function<void(const std::string& key, const std::string& value, std::chrono::milliseconds ttl)> set;
+    std::function<void(const std::vector<std::string>& keys)> erase;
+
+    static EntityCacheStore From(std::shared_ptr<RedisClient> redis);
+};
+
+struct EntityCacheStats {
+    size_t entries = 0;
+    uint64_t local_hits = 0;
+    uint64_t shared_hits = 0;       // Served from Redis
+    uint64_t loads = 0;             // Loader calls
+    uint64_t coalesced = 0;         // Misses that waited for a load already in flight
+    uint64_t early_refreshes = 0;   // Loads started before the value expired
+    uint64_t invalidations = 0;
+    uint64_t store_errors = 0;      // Redis reads or writes that failed (the loader serves instead)
+};
+
+/// How a key is spelled in Redis and on the invalidation topic
+template <typename K>
+struct EntityCacheKey;
+
+template <>
+struct EntityCacheKey<std::string> {
+    static std::string Format(const std::string& key) { return key; }
+};
+
+/// (tenant_id, id): entities are only ever looked up within their tenant
+template <>
+struct EntityCacheKey<std::pair<std::string, std::string>> {
+    static std::string Format(const std::pair<std::string, std::string>& key) {
+        return key.first + ':' + key.second;
+    }
+};
+
+/**
+ * What EntityCache shares across value types: the Redis tier, the
+ * invalidation topic, early refresh decisions and metrics
+ */
+class EntityCacheBase {
+public:
+    virtual ~EntityCacheBase();
+
+    EntityCacheBase(const EntityCacheBase&) = delete;
+    EntityCacheBase& operator=(const EntityCacheBase&) = delete;
+
+    const std::string& Name() const { return name_; }
+    const EntityCacheOptions& Options() const { return options_; }
+
+    /// Event bus topic carrying this cache's invalidations ("entity_cache:<name>")
+    std::string Topic() const { return "entity_cache:" + name_; }
+
+    EntityCacheStats GetStats() const;
+
+protected:
+    using Clock = std::chrono::steady_clock;
+    using WallClock = std::chrono::system_clock;
+
+    // A value in Redis, with what early refresh needs to know about it
+    struct Stored {
+        std::string payload;
+        WallClock::time_point fresh_until;
+        std::chrono::microseconds load_time{0};
+    };
+
+    EntityCacheBase(std::string name, EntityCacheStore store, std::shared_ptr<EventBus> event_bus,
+                    const EntityCacheOptions& options);
+
+    /// Subscribe to invalidations and export metrics; the derived constructor calls it last
+    void Attach();
+    /// Undo Attach(); the derived destructor calls it first
+    void Detach();
+
+    // Best effort: failures are counted in store_errors and read as misses
+    std::optional<Stored> ReadStore(const std::string& key);
+    void WriteStore(const std::string& key, const Stored& stored);
+    void EraseStore(const std::vector<std::string>& keys);
+
+    /// Tell every instance (this one included) to drop `key`
+    void Announce(const std::string& key);
+
+    /**
+     * Whether to reload a value before it expires (XFetch)
+     *
+     * True with a probability that grows as fresh_until approaches, faster
+     * for values that are slow to load: -load_time * beta * ln(rand) past
+     * now. Callers reach this at different moments, so one of them reloads
+     * first while the others still use the value.
+     */
+    bool RefreshEarly(WallClock::time_point fresh_until, std::chrono::microseconds load_time) const;
+
+    /// An early refresh threw; the current value keeps being served
+    void RefreshFailed(const std::exception_ptr& error);
+
+    virtual void DropLocal(const std::string& key) = 0;
+    virtual void DropAllLocal() = 0;
+    virtual size_t LocalSize() const = 0;
+
+    std::atomic<uint64_t> local_hits_{0};
+    std::atomic<uint64_t> shared_hits_{0};
+    std::atomic<uint64_t> loads_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> early_refreshes_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> store_errors_{0};
+
+private:
+    std::string StoreKey(const std::string& key) const { return "entity:" + name_ + ":" + key; }
+
+    std::string name_;
+    EntityCacheStore store_;
+    std::shared_ptr<EventBus> event_bus_;
+    EntityCacheOptions options_;
+    uint64_t subscription_ = 0;
+    uint64_t metrics_collector_ = 0;
+};
+
+/**
+ * Cache-aside for entities read far more often than they change
+ *
+ * Two tiers: a local LRU split into stripes, each with its own lock, and
+ * Redis holding the protobuf-serialized value for `ttl`, shared by every
+ * replica. A local entry re-reads Redis after local_ttl; Redis entries are
+ * reloaded after `ttl`. A miss in both calls the loader once per key
+ * however many callers are waiting (single flight); the others block on
+ * its result and see its exception if it throws. Values the loader reports
+ * missing (nullopt) are not cached.
+ *
+ * Expiry alone would send every replica to Postgres at the same moment,
+ * so hits refresh early with a small probability that grows as the value
+ * ages (RefreshEarly). One caller reloads while the rest keep being
+ * served; if that reload fails they all keep the current value until it
+ * actually expires.
+ *
+ * Writers call Invalidate() after committing. It drops the key locally
+ * and from Redis and publishes it on the event bus, so every replica's
+ * local tier drops it too (at least once; a lost subscription clears the
+ * whole tier). Fills that overlap an invalidation in this process are not
+ * stored. A fill on another replica that read the old row before the
+ * commit can still store it after the invalidation; `ttl` bounds that.
+ *
+ * V is a protobuf message; K is formatted by EntityCacheKey<K>.
+ *
+ * Usage:
+ *   EntityCache<std::pair<std::string, std::string>, SubscriptionResponse> cache(
+ *       "subscription", EntityCacheStore::From(redis), event_bus, EntityCacheOptions::FromEnv());
+ *   auto subscription = cache.Get({tenant_id, id}, [&]() -> std::optional<SubscriptionResponse> { ... });
+ *   cache.Invalidate({tenant_id, id});   // after the update commits
+ */
+template <typename K, typename V, typename KeyFormat = EntityCacheKey<K>>
+class EntityCache final : public EntityCacheBase {
+public:
+    EntityCache(std::string name, EntityCacheStore store, std::shared_ptr<EventBus> event_bus,
+                const EntityCacheOptions& options = {})
+        : EntityCacheBase(std::move(name), std::move(store), std::move(event_bus), options),
+          stripe_capacity_(std::max<size_t>(1, (options.capacity + NUM_STRIPES - 1) / NUM_STRIPES)),
+          stripes_(std::make_unique<Stripe[]>(NUM_STRIPES)) {
+        Attach();
+    }
+
+    ~EntityCache() override { Detach(); }
+
+    /**
+     * Cached value of a key, loading it on a miss
+     *
+     * @param load Returns the value (std::optional<V>), nullopt if it does not exist
+     * @return Null if the loader found nothing
+     * @throws Whatever the loader throws
+     */
+    template <typename Load>
+    std::shared_ptr<const V> Get(const K& key, Load&& load) {
+        std::string id = KeyFormat::Format(key);
+        Stripe& stripe = StripeFor(id);
+        std::shared_ptr<const V> cached;
+        std::promise<std::shared_ptr<const V>> promise;
+        uint64_t ticket = 0;
+        {
+            std::unique_lock<std::mutex> lock(stripe.mutex);
+            auto it = stripe.index.find(id);
+            if (it != stripe.index.end() && Clock::now() < it->second->local_until) {
+                stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+                ++local_hits_;
+                const Entry& entry = *it->second;
+                if (stripe.flights.count(id) || !RefreshEarly(entry.fresh_until, entry.load_time)) {
+                    return entry.value;
+                }
+                ++early_refreshes_;
+                cached = entry.value;
+            } else if (auto flight = stripe.flights.find(id); flight != stripe.flights.end()) {
+                ++coalesced_;
+                auto shared = flight->second;
+                lock.unlock();
+                return shared.get();
+            }
+            stripe.flights.emplace(id, promise.get_future().share());
+            ticket = stripe.generation;
+        }
+
+        std::shared_ptr<const V> value;
+        try {
+            // An early refresh goes to the loader: Redis holds the same aging value
+            value = Fill(stripe, id, !cached, ticket, load);
+        } catch (...) {
+            if (!cached) {
+                Land(stripe, id);
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+            RefreshFailed(std::current_exception());
+            value = cached;   // Still within its lifetime
+        }
+        Land(stripe, id);
+        promise.set_value(value);
+        return value;
+    }
+
+    /// Drop a key everywhere; call after the write that changed it has committed
+    void Invalidate(const K& key) { InvalidateMany({key}); }
+
+    /// Invalidate() for several keys, with one Redis round trip
+    void InvalidateMany(const std::vector<K>& keys) {
+        std::vector<std::string> ids;
+        ids.reserve(keys.size());
+        for (const auto& key : keys) {
+            ids.push_back(KeyFormat::Format(key));
+            DropLocal(ids.back());
+        }
+        invalidations_ += ids.size();
+        EraseStore(ids);
+        for (const auto& id : ids) {
+            Announce(id);
+        }
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const V> value;
+        Clock::time_point local_until;
+        WallClock::time_point fresh_until;
+        std::chrono::microseconds load_time{0};
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::list<Entry> lru;   // Most recently used first
+        std::unordered_map<std::string_view, typename std::list<Entry>::iterator> index;   // Views into lru keys
+        std::unordered_map<std::string, std::shared_future<std::shared_ptr<const V>>> flights;
+        uint64_t generation = 0;   // Bumped by invalidations; fills started before do not store
+    };
+
+    static constexpr size_t NUM_STRIPES = 16;
+
+    Stripe& StripeFor(std::string_view key) const {
+        return stripes_[std::hash<std::string_view>{}(key) % NUM_STRIPES];
+    }
+
+    template <typename Load>
+    std::shared_ptr<const V> Fill(Stripe& stripe, const std::string& id, bool read_store, uint64_t ticket,
+                                  Load& load) {
+        if (read_store) {
+            if (auto stored = ReadStore(id)) {
+                auto value = std::make_shared<V>();
+                if (!RefreshEarly(stored->fresh_until, stored->load_time) && value->ParseFromString(stored->payload)) {
+                    ++shared_hits_;
+                    Store(stripe, id, value, *stored, ticket);
+                    return value;
+                }
+                if (stored->fresh_until > WallClock::now()) {
+                    ++early_refreshes_;
+                }
+            }
+        }
+
+        ++loads_;
+        auto start = Clock::now();
+        std::optional<V> loaded = load();
+        if (!loaded) {
+            Remove(stripe, id);
+            return nullptr;
+        }
+        auto value = std::make_shared<const V>(std::move(*loaded));
+        Stored stored;
+        stored.fresh_until = WallClock::now() + Options().ttl;
+        stored.load_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        if (Store(stripe, id, value, stored, ticket)) {
+            stored.payload = value->SerializeAsString();
+            WriteStore(id, stored);
+        }
+        return value;
+    }
+
+    // Keep a value locally unless the key was invalidated since `ticket`
+    bool Store(Stripe& stripe, const std::string& id, std::shared_ptr<const V> value, const Stored& stored,
+               uint64_t ticket) {
+        auto remaining = std::chrono::duration_cast<Clock::duration>(stored.fresh_until - WallClock::now());
+        auto local_until = Clock::now() + std::min<Clock::duration>(Options().local_ttl, remaining);
+
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        if (stripe.generation != ticket) {
+            return false;
+        }
+        auto it = stripe.index.find(id);
+        if (it == stripe.index.end()) {
+            stripe.lru.push_front(Entry{id, nullptr, {}, {}, {}});
+            it = stripe.index.emplace(stripe.lru.front().key, stripe.lru.begin()).first;
+            if (stripe.lru.size() > stripe_capacity_) {
+                stripe.index.erase(stripe.lru.back().key);
+                stripe.lru.pop_back();
+            }
+        } else {
+            stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+        }
+        Entry& entry = *it->second;
+        entry.value = std::move(value);
+        entry.local_until = local_until;
+        entry.fresh_until = stored.fresh_until;
+        entry.load_time = stored.load_time;
+        return true;
+    }
+
+    // The loader found nothing: forget what this instance and Redis still hold
+    void Remove(Stripe& stripe, const std::string& id) {
+        bool held = false;
+        {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            auto it = stripe.index.find(id);
+            if (it != stripe.index.end()) {
+                auto entry = it->second;
+                stripe.index.erase(it);
+                stripe.lru.erase(entry);
+                held = true;
+            }
+        }
+        if (held) {
+            EraseStore({id});
+        }
+    }
+
+    void Land(Stripe& stripe, const std::string& id) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.flights.erase(id);
+    }
+
+    void DropLocal(const std::string& key) override {
+        Stripe& stripe = StripeFor(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        ++stripe.generation;
+        auto it = stripe.index.find(key);
+        if (it != stripe.index.end()) {
+            auto entry = it->second;
+            stripe.index.erase(it);
+            stripe.lru.erase(entry);
+        }
+    }
+
+    void DropAllLocal() override {
+        for (size_t i = 0; i < NUM_STRIPES; ++i) {
+            std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+            ++stripes_[i].generation;
+            stripes_[i].index.clear();
+            stripes_[i].lru.clear();
+        }
+    }
+
+    size_t LocalSize() const override {
+        size_t size = 0;
+        for (size_t i = 0; i < NUM_STRIPES; ++i) {
+            std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+            size += stripes_[i].lru.size();
+        }
+        return size;
+    }
+
+    size_t stripe_capacity_;
+    std::unique_ptr<Stripe[]> stripes_;
+};
+
+} // namespace common
+} // namespace saasforge
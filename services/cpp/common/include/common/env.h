@@ -0,0 +1,37 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Reading configuration from environment variables
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/*
+ * Used by the FromEnv() of every Options struct. An unset or empty
+ * variable, or one that does not parse completely, yields default_value,
+ * so a typo never turns into a zero limit.
+ */
+
+/// Non-negative integer
+long EnvInt(const char* name, long default_value);
+long EnvInt(const std::string& name, long default_value);   // Names built at run time
+
+/// Non-negative number
+double EnvDouble(const char* name, double default_value);
+
+/// Number in [0, 1]
+double EnvRatio(const char* name, double default_value);
+
+std::string EnvString(const char* name, const std::string& default_value = "");
+
+/// Comma-separated values, trimmed of blanks; empty items skipped
+std::vector<std::string> EnvList(const char* name, std::vector<std::string> default_value = {});
+
+} // namespace common
+} // namespace saasforge
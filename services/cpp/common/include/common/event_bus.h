@@ -0,0 +1,194 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Event bus between services on Redis Streams consumer groups
+ */
+
+#pragma once
+
+#include "common/redis_client.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * EventBus options
+ *
+ * FromEnv() reads EVENT_BUS_MAX_LEN, EVENT_BUS_BATCH,
+ * EVENT_BUS_MAX_BUFFERED, EVENT_BUS_PUBLISH_WAIT_MS, EVENT_BUS_BLOCK_MS and
+ * EVENT_BUS_CONSUMER.
+ */
+struct EventBusOptions {
+    size_t max_len = 10000;                        // Entries kept per topic (XADD MAXLEN ~)
+    size_t batch = 256;                            // Entries per XADD pipeline and per XREADGROUP
+    size_t max_buffered = 10000;                   // Unsent events before Publish() waits
+    std::chrono::milliseconds publish_wait{50};    // Publish() drops the event after waiting this long
+    std::chrono::milliseconds block{2000};         // XREADGROUP BLOCK; bounds how long Unsubscribe() takes
+    std::chrono::milliseconds retry{1000};         // Pause after a Redis error
+    std::string consumer;                          // This process in its groups; empty: <hostname>-<pid>
+
+    static EventBusOptions FromEnv();
+};
+
+/// Thrown by EventStreams::read_group when the stream or the group no longer exists
+struct StreamGroupMissing : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * The Redis stream commands the bus uses (RedisClient's Stream*)
+ */
+struct EventStreams {
+    using Entries = std::vector<std::pair<std::string, std::string>>;   // (stream key, payload)
+
+    std::function<void(const Entries& entries, size_t max_len)> append;
+    /// Create the group at the stream's end; false if it exists
+    std::function<bool(const std::string& key, const std::string& group)> create_group;
+    std::function<void(const std::string& key, const std::string& group)> destroy_group;
+    std::function<std::vector<StreamMessage>(const std::string& key, const std::string& group,
+                                             const std::string& consumer, const std::string& id, size_t count,
+                                             std::chrono::milliseconds block)> read_group;
+    std::function<void(const std::string& key, const std::string& group, const std::vector<std::string>& ids)>
+        ack;
+
+    static EventStreams From(std::shared_ptr<RedisClient> redis);
+};
+
+/**
+ * Events between services on Redis Streams
+ *
+ * Each topic is a stream ("events:<topic>") trimmed to about max_len
+ * entries. Publish() only buffers: a publisher thread sends up to `batch`
+ * buffered events per pipelined round trip. While Redis is unreachable
+ * events stay buffered, and once max_buffered are waiting Publish() blocks
+ * for at most publish_wait and then drops the event (returns false), so a
+ * Redis outage slows publishers down instead of growing memory.
+ *
+ * Subscribe() reads a topic through a consumer group on its own thread,
+ * up to `batch` entries per XREADGROUP, and acknowledges each batch with
+ * one XACK after the handler has seen it. By default the group is this
+ * subscription's own (named after `consumer`), so every process sees every
+ * event - what cache invalidations need - and the group is removed again
+ * on Unsubscribe(). A named group is shared: each event goes to one of its
+ * members, and the group outlives them.
+ *
+ * Delivery is at least once. Entries read but not acknowledged when the
+ * connection failed are read again (the consumer's pending entries come
+ * first after every error). If the group itself is lost (Redis restarted
+ * without persistence, or failed over before replicating it) it is created
+ * again at the end of the stream and on_reset runs, since events may have
+ * been missed; it also runs when the group could not be created at
+ * Subscribe() and was created later. Handlers must tolerate repeats.
+ *
+ * Usage:
+ *   auto bus = std::make_shared<EventBus>(redis_client, EventBusOptions::FromEnv());
+ *   bus->Subscribe(ApiKeyCache::REVOCATION_TOPIC,
+ *       [cache](const std::string& key_id) { cache->InvalidateByKeyId(key_id); },
+ *       [cache] { cache->Clear(); });
+ *   bus->Publish(ApiKeyCache::REVOCATION_TOPIC, key_id);
+ */
+class EventBus {
+public:
+    using Handler = std::function<void(const std::string& payload)>;
+
+    EventBus(std::shared_ptr<RedisClient> redis, const EventBusOptions& options = {});
+    /// Custom streams (tests)
+    EventBus(EventStreams streams, const EventBusOptions& options = {});
+    ~EventBus();
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    /**
+     * Queue an event for the topic's subscribers
+     *
+     * @return False if the buffer stayed full for publish_wait (the event is dropped) or after Shutdown()
+     */
+    bool Publish(const std::string& topic, std::string payload);
+
+    /**
+     * Read a topic on a background thread
+     *
+     * @param handler Called with each event's payload, on the subscription's thread
+     * @param on_reset Optional; called when events may have been missed
+     * @param group Empty: this process's own group (every process sees every event)
+     * @return Subscription id for Unsubscribe()
+     */
+    uint64_t Subscribe(const std::string& topic, Handler handler, std::function<void()> on_reset = nullptr,
+                       const std::string& group = {});
+
+    /// Stop a subscription and wait for its thread (at most `block`); the handler is not called again
+    void Unsubscribe(uint64_t subscription_id);
+
+    /**
+     * Wait until every buffered event has been sent
+     *
+     * @return False if some were still unsent after timeout
+     */
+    bool Flush(std::chrono::milliseconds timeout);
+
+    /// Send what is buffered (up to a second), then stop every thread (idempotent)
+    void Shutdown();
+
+    /// Events dropped by Publish() since start
+    uint64_t Dropped() const { return dropped_.load(); }
+
+    const EventBusOptions& Options() const { return options_; }
+
+    /// Stream of a topic
+    static std::string StreamKey(std::string_view topic);
+
+private:
+    struct Subscription {
+        uint64_t id = 0;
+        std::string key;
+        std::string group;
+        bool own_group = false;
+        std::shared_ptr<std::atomic<bool>> stop;
+        std::thread thread;
+    };
+
+    void PublishLoop();
+    void ReadLoop(std::string key, std::string group, bool created, Handler handler,
+                  std::function<void()> on_reset, std::shared_ptr<std::atomic<bool>> stop);
+    // Wait out options_.retry unless stopping
+    void Pause(const std::atomic<bool>& stop);
+    void EndSubscription(Subscription& subscription);
+
+    EventStreams streams_;
+    EventBusOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;           // Buffer changes, sends and shutdown
+    std::deque<std::pair<std::string, std::string>> buffer_;
+    size_t sending_ = 0;                   // Taken from the buffer, not yet sent
+    bool shutdown_ = false;
+    std::thread publisher_;
+
+    std::mutex subscriptions_mutex_;
+    uint64_t next_subscription_id_ = 1;
+    std::vector<Subscription> subscriptions_;
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> errors_{0};
+    uint64_t metrics_collector_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,161 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Bounded thread pool for offloading blocking DB/Redis work
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Scheduling class of an executor task
+ */
+enum class TaskPriority {
+    CRITICAL,   // Request handling: always taken ahead of queued bulk tasks
+    BULK        // Background work (refreshes, flushes, maintenance)
+};
+
+/**
+ * Fixed-size thread pool with a bounded queue
+ *
+ * Used by the callback-API gRPC services so that slow Postgres/Redis calls
+ * run on executor threads instead of gRPC's own threads. When the queue is
+ * full TrySubmit() returns false and the caller sheds load (the services
+ * answer RESOURCE_EXHAUSTED) instead of queueing without bound.
+ *
+ * BULK tasks wait behind CRITICAL ones and never occupy every worker (at
+ * most threads - 1 at once, when there is more than one), so background
+ * work sharing a pool cannot delay requests by more than a free worker.
+ * SchedulePeriodic() runs background loops as BULK tasks on the pool
+ * instead of a thread each; Background() is the process-wide pool for
+ * them.
+ *
+ * Usage:
+ *   Executor executor(16, 1024);
+ *   if (!executor.TrySubmit([] { ... })) { ... reject ... }
+ *
+ *   uint64_t refresh = Executor::Background().SchedulePeriodic(std::chrono::seconds(30), [this] { Refresh(); });
+ *   ...
+ *   Executor::Background().Cancel(refresh);   // Before this goes away
+ */
+class Executor {
+public:
+    /**
+     * @param num_threads Worker threads (0 = 2 x hardware concurrency)
+     * @param queue_capacity Maximum queued (not yet running) tasks
+     * @param pin_threads Pin worker i to core i % cores (Linux only)
+     */
+    Executor(size_t num_threads, size_t queue_capacity, bool pin_threads = false);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * Queue a task for execution
+     *
+     * The caller's trace context (common/tracing.h) is current while the
+     * task runs.
+     *
+     * @param task Work to run on an executor thread
+     * @param priority CRITICAL for request handling, BULK for background work
+     * @return False if the queue is full or the executor is shut down
+     */
+    bool TrySubmit(std::function<void()> task, TaskPriority priority = TaskPriority::CRITICAL);
+
+    /**
+     * Run task as BULK work every interval, the first time after initial_delay
+     *
+     * The interval is counted from the end of the previous run, so runs
+     * never overlap; a run that finds the queue full is retried an interval
+     * later. Exceptions are logged like any task's.
+     *
+     * @return Id for Cancel()
+     */
+    uint64_t SchedulePeriodic(std::chrono::milliseconds interval, std::function<void()> task,
+                              std::chrono::milliseconds initial_delay = std::chrono::milliseconds(0));
+
+    /**
+     * Stop a periodic task, waiting for a run in progress to finish
+     *
+     * Must not be called from the task itself. Unknown ids are ignored.
+     */
+    void Cancel(uint64_t id);
+
+    /**
+     * Cancel periodic tasks, stop accepting work, run everything already
+     * queued, join workers
+     */
+    void Shutdown();
+
+    /**
+     * Process-wide pool for background loops (BACKGROUND_EXECUTOR_THREADS,
+     * default 4), started on first use and never destroyed
+     */
+    static Executor& Background();
+
+    size_t ThreadCount() const { return workers_.size(); }
+    size_t QueueDepth() const;
+    size_t QueueCapacity() const { return queue_capacity_; }
+
+    /// Tasks rejected because the queue was full (for metrics)
+    uint64_t RejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+
+    /**
+     * Export queue depth, capacity, threads and rejections on every
+     * metrics scrape, labelled executor=name, until Shutdown()
+     */
+    void ExportMetrics(const std::string& name);
+
+    /// Periodic tasks scheduled and not cancelled
+    size_t PeriodicCount() const;
+
+private:
+    struct Periodic;
+
+    void WorkerLoop();
+    void TimerLoop();
+    // Queue a run of periodic (timer_mutex_ held)
+    void SubmitPeriodic(const std::shared_ptr<Periodic>& periodic);
+    static void PinToCore(std::thread& thread, size_t core);
+
+    size_t queue_capacity_;
+    size_t max_bulk_running_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> critical_;
+    std::deque<std::function<void()>> bulk_;
+    size_t bulk_running_ = 0;
+    std::vector<std::thread> workers_;
+    bool shutdown_ = false;
+
+    // Periodic tasks: one timer thread, started by the first SchedulePeriodic()
+    mutable std::mutex timer_mutex_;
+    std::condition_variable timer_cv_;
+    std::map<uint64_t, std::shared_ptr<Periodic>> periodic_;
+    uint64_t next_periodic_id_ = 1;
+    bool timer_shutdown_ = false;
+    std::thread timer_;
+
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> metrics_collector_{0};
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,106 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description SIGTERM-driven drain of a gRPC server for rolling deploys
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <grpcpp/health_check_service_interface.h>
+#include <grpcpp/server.h>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Shutdown options
+ *
+ * FromEnv() reads SHUTDOWN_DRAIN_DELAY_S, SHUTDOWN_GRACE_S and
+ * SHUTDOWN_CLOSE_TIMEOUT_S. The drain delay and grace
+ * (plus the cleanup steps) must fit in the pod's
+ * terminationGracePeriodSeconds, or the kubelet kills the process mid-drain.
+ */
+struct ShutdownOptions {
+    std::chrono::seconds drain_delay{5};   // NOT_SERVING before the listener closes, so endpoints drop the pod
+    std::chrono::seconds grace{15};        // In-flight RPCs still running by then are cancelled
+    std::chrono::seconds close_timeout{5}; // For cleanup steps waiting on borrowed resources (DbPool::Shutdown)
+
+    static ShutdownOptions FromEnv();
+};
+
+/**
+ * Orderly stop on SIGTERM (or SIGINT)
+ *
+ * Constructing it installs the signal handlers; Wait() replaces
+ * server->Wait() and returns once a signal arrives. Run() then:
+ * 1. Reports NOT_SERVING on the health service (LIVENESS_SERVICE stays
+ *    SERVING), and keeps accepting RPCs for `drain_delay` while readiness
+ *    probes and load balancers take the pod out of rotation
+ * 2. Calls server->Shutdown() with a `grace` deadline: the listener closes,
+ *    in-flight RPCs finish, and those still running at the deadline are
+ *    cancelled
+ * 3. Runs the cleanup steps in the order they were added - stop executors,
+ *    flush write-behind buffers, release claimed queue rows, close pools.
+ *    A step that throws is logged and the next one still runs.
+ *
+ * A second signal during the drain terminates the process at once.
+ * Only one instance may exist at a time.
+ *
+ * Usage:
+ *   std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+ *   GracefulShutdown shutdown(ShutdownOptions::FromEnv());   // before warm-up: a SIGTERM then is not lost
+ *   shutdown.Add("executor", [&] { executor->Shutdown(); });
+ *   shutdown.Add("database", [&] { db_pool->Shutdown(shutdown.Options().close_timeout); });
+ *   shutdown.Wait();
+ *   shutdown.Run(server.get(), server->GetHealthCheckService());
+ */
+class GracefulShutdown {
+public:
+    /// Throws on failure
+    using Step = std::function<void()>;
+
+    explicit GracefulShutdown(const ShutdownOptions& options = {});
+    ~GracefulShutdown();
+
+    GracefulShutdown(const GracefulShutdown&) = delete;
+    GracefulShutdown& operator=(const GracefulShutdown&) = delete;
+
+    void Add(std::string name, Step step);
+
+    /**
+     * Block until SIGTERM, SIGINT or RequestShutdown()
+     *
+     * @return The signal number (0 for RequestShutdown())
+     */
+    int Wait();
+
+    /// Wake Wait() as if a signal arrived (async-signal-safe)
+    static void RequestShutdown();
+
+    /**
+     * Drain the server and run the cleanup steps
+     *
+     * @param server Started server (may be null: steps only)
+     * @param health Default health service of the server (may be null)
+     * @return False if a cleanup step failed
+     */
+    bool Run(grpc::Server* server, grpc::HealthCheckServiceInterface* health);
+
+    const ShutdownOptions& Options() const { return options_; }
+
+private:
+    struct Entry {
+        std::string name;
+        Step step;
+    };
+
+    ShutdownOptions options_;
+    std::vector<Entry> steps_;
+};
+
+} // namespace common
+} // namespace saasforge
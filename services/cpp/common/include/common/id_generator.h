@@ -0,0 +1,60 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Time-ordered UUIDv7 / ULID identifiers for inserted rows
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Time-ordered 128-bit ids (UUIDv7, RFC 9562)
+ *
+ * Layout: 48-bit Unix milliseconds, version 7, a 12-bit counter, the
+ * variant, then 62 random bits. Ids sort by creation time, so rows keyed
+ * by them append at the right edge of the primary key index instead of
+ * landing on a random leaf as uuid_generate_v4() keys do; the leaf being
+ * written stays in the buffer cache and page splits stay rare.
+ *
+ * Each thread generates from its own state, without locks: its ids are
+ * strictly increasing. Within a millisecond the counter starts at a
+ * random value below 2048 and counts up; a thread that uses up the
+ * counter borrows the next millisecond. Ids of different threads in the
+ * same millisecond are ordered by their random bits only.
+ *
+ * The random bits come from a per-thread std::mt19937_64: ids are unique,
+ * not secret, and must not double as tokens.
+ *
+ * Usage:
+ *   std::string id = IdGenerator::NewUuid();          // upload_objects.id, email_queue.id, ...
+ *   std::string customer = IdGenerator::NewUlid("cus");   // "cus_01JC3W..."
+ */
+class IdGenerator {
+public:
+    using Bytes = std::array<uint8_t, 16>;
+
+    /// Next id of the calling thread
+    static Bytes Next();
+
+    /// Next() in the canonical form ("01932c07-a3b4-7f21-9c3e-5d0a4b6e7f18"), for uuid columns
+    static std::string NewUuid();
+
+    /// Next() as a ULID (26 characters of Crockford Base32), after "<prefix>_" when prefix is set
+    static std::string NewUlid(std::string_view prefix = {});
+
+    static std::string ToUuid(const Bytes& id);
+    static std::string ToUlid(const Bytes& id);
+
+    /// Unix milliseconds an id was generated at
+    static int64_t UnixMillis(const Bytes& id);
+};
+
+} // namespace common
+} // namespace saasforge
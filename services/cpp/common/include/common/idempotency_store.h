@@ -0,0 +1,143 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Idempotency keys with in-flight coalescing and cached responses
+ */
+
+#pragma once
+
+#include "common/redis_client.h"
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * IdempotencyStore options
+ *
+ * FromEnv() reads IDEMPOTENCY_TTL_S, IDEMPOTENCY_LEASE_MS and
+ * IDEMPOTENCY_WAIT_MS.
+ */
+struct IdempotencyOptions {
+    std::chrono::seconds ttl{86400};              // How long a completed response is replayed
+    std::chrono::milliseconds lease{30000};       // Claim expiry if the owner dies mid-request
+    std::chrono::milliseconds wait_timeout{5000}; // Wait for a request in flight on another instance
+    std::chrono::milliseconds poll_interval{50};
+
+    static IdempotencyOptions FromEnv();
+};
+
+/**
+ * Storage operations behind IdempotencyStore (Redis by default)
+ *
+ * Values are opaque strings; token identifies the claim owner.
+ */
+struct IdempotencyBackend {
+    /// SET key value NX PX lease; returns the existing value if the key was taken
+    std::function<std::optional<std::string>(const std::string& key, const std::string& value,
+                                             std::chrono::milliseconds lease)> claim;
+    /// Replace the claim with value if it still holds expected; false if the claim was lost
+    std::function<bool(const std::string& key, const std::string& expected, const std::string& value,
+                       std::chrono::milliseconds ttl)> complete;
+    /// Delete the key if it still holds expected
+    std::function<void(const std::string& key, const std::string& expected)> release;
+    std::function<std::optional<std::string>(const std::string& key)> get;
+
+    static IdempotencyBackend Redis(std::shared_ptr<RedisClient> redis);
+};
+
+/**
+ * Result of IdempotencyStore::Execute()
+ */
+struct IdempotencyOutcome {
+    enum class Kind {
+        EXECUTED,     // The handler ran in this call
+        REPLAYED,     // A stored (or coalesced) response was returned; body is set
+        CONFLICT,     // Key already used with a different request fingerprint
+        IN_PROGRESS   // Another instance still holds the key after wait_timeout
+    };
+
+    Kind kind = Kind::EXECUTED;
+    std::string body;
+};
+
+/**
+ * Runs a mutating request at most once per idempotency key
+ *
+ * The key is claimed in Redis with SET NX PX, a single round trip that also
+ * returns the current value when the key is taken. The first caller runs
+ * the handler and stores its serialized response for options.ttl; retries
+ * get that response back without touching the database. Concurrent
+ * duplicates within the process wait on the in-flight call instead of
+ * racing to Redis, and duplicates on other instances poll until the owner
+ * completes, up to wait_timeout.
+ *
+ * Only successful responses are stored: when the handler fails (returns
+ * nullopt or throws) the claim is released so the client can retry, and
+ * coalesced waiters run their own attempt.
+ *
+ * Usage:
+ *   auto outcome = store.Execute("payment:create:" + tenant + ":" + key,
+ *                                IdempotencyStore::Fingerprint(request.SerializeAsString()),
+ *                                [&]() -> std::optional<std::string> { ... });
+ */
+class IdempotencyStore {
+public:
+    /// Returns the serialized response to store, or nullopt if the request failed
+    using Handler = std::function<std::optional<std::string>()>;
+
+    IdempotencyStore(std::shared_ptr<RedisClient> redis, const IdempotencyOptions& options = {});
+
+    /// Custom backend (tests)
+    IdempotencyStore(IdempotencyBackend backend, const IdempotencyOptions& options = {});
+
+    IdempotencyStore(const IdempotencyStore&) = delete;
+    IdempotencyStore& operator=(const IdempotencyStore&) = delete;
+
+    /**
+     * Run handler unless key was already used
+     *
+     * @param key Scoped key (stored as "idempotency:<key>")
+     * @param fingerprint Digest of the request; reuse with a different one is a CONFLICT
+     * @param handler Performs the request
+     * @throws sw::redis::Error if Redis is unreachable; exceptions from handler propagate
+     */
+    IdempotencyOutcome Execute(const std::string& key, const std::string& fingerprint, const Handler& handler);
+
+    /// Hex SHA-256 of a serialized request
+    static std::string Fingerprint(std::string_view request);
+
+    /// Requests currently executing in this process
+    size_t InFlightCount() const;
+
+private:
+    struct InFlight {
+        std::string fingerprint;
+        std::shared_future<std::optional<std::string>> result;   // nullopt: attempt failed
+    };
+
+    // retry: the attempt this call coalesced onto (locally or remotely) failed
+    IdempotencyOutcome ExecuteOnce(const std::string& key, const std::string& fingerprint,
+                                   const Handler& handler, bool& retry);
+    IdempotencyOutcome ClaimAndRun(const std::string& key, const std::string& fingerprint,
+                                   const Handler& handler, bool& retry, std::optional<std::string>& stored);
+    IdempotencyOutcome Resolve(const std::string& key, const std::string& fingerprint,
+                               const std::string& value, bool& retry, std::optional<std::string>& stored);
+
+    IdempotencyBackend backend_;
+    IdempotencyOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, InFlight> in_flight_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,46 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description JWT key ids and key set documents (JWKS or PEM bundles)
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Key id of a PEM private or public key: its RFC 7638 JWK thumbprint
+ *
+ * Derived from the public key alone, so the signer and every validator
+ * agree on it without configuration.
+ *
+ * @throws std::invalid_argument for keys JwtAlgorithmForKey() rejects
+ */
+std::string JwtKeyId(const std::string& key_pem);
+
+/// Public JWKS document for PEM keys (private keys are reduced to their public part)
+std::string JwksFromKeys(const std::vector<std::string>& key_pems);
+
+struct JwtPublicKey {
+    std::string kid;   // From the document, else the thumbprint
+    std::string pem;
+};
+
+/**
+ * Verification keys from a key set document
+ *
+ * The document is either a JWKS ({"keys": [...]}) or one or more PEM
+ * public keys back to back. JWKS entries that are not signature keys or
+ * are of an unsupported type (only RSA, EC P-256 and OKP Ed25519 are
+ * used) are skipped.
+ *
+ * @throws std::invalid_argument if the document cannot be parsed
+ */
+std::vector<JwtPublicKey> ParseJwtKeys(const std::string& document);
+
+} // namespace common
+} // namespace saasforge
@@ -1,10 +1,21 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <jwt-cpp/jwt.h>
+#include "bloom_filter.h"
+#include "jwt_keys.h"
 #include "redis_client.h"
+#include "tenant_revocations.h"
 
 namespace saasforge {
 namespace common {
@@ -14,24 +25,130 @@ struct TokenClaims {
     std::string tenant_id;
     std::string email;
     std::vector<std::string> roles;
-    int64_t exp;
-    int64_t iat;
+    int64_t exp;  // Unix seconds
+    int64_t iat;  // Unix seconds
     std::string jti;
 };
 
+struct JwtValidatorOptions {
+    // Verified-claims cache (0 disables); entries live until the token's exp
+    size_t cache_capacity = 10000;
+    size_t cache_stripes = 16;
+
+    // Local blacklist filter kept in sync via RedisClient::BLACKLIST_CHANNEL
+    bool blacklist_filter = true;
+    size_t blacklist_filter_capacity = 100000;
+    double blacklist_filter_fp_rate = 0.001;
+
+    // Reject tokens minted before their tenant's sessions were revoked (see TenantRevocations)
+    bool tenant_revocations = true;
+
+    // Key set re-read in the background: an http(s) URL or a file path, holding a JWKS
+    // document or PEM public keys. Tokens pick their key by "kid". Empty: constructor key only.
+    std::string keys_source;
+    std::chrono::seconds keys_refresh{300};   // FromEnv() floors it at 30 s
+
+    // JWT_KEYS_SOURCE, JWT_KEYS_REFRESH_SEC
+    static JwtValidatorOptions FromEnv();
+};
+
 class JwtValidator {
 public:
-    JwtValidator(const std::string& public_key_pem, std::shared_ptr<RedisClient> redis_client);
+    // Each key accepts RS256, ES256 or EdDSA, whichever matches its type (throws std::invalid_argument otherwise).
+    // public_key_pem may be empty with a keys_source; the first fetch must then succeed (throws std::runtime_error).
+    JwtValidator(
+        const std::string& public_key_pem,
+        std::shared_ptr<RedisClient> redis_client,
+        JwtValidatorOptions options = {}
+    );
+    ~JwtValidator();
+
+    JwtValidator(const JwtValidator&) = delete;
+    JwtValidator& operator=(const JwtValidator&) = delete;
 
     // Validates JWT and returns claims if valid
-    std::optional<TokenClaims> Validate(const std::string& token);
+    std::optional<TokenClaims> Validate(std::string_view token);
 
-    // Check if token is blacklisted in Redis
+    // Check if token is blacklisted (local filter first, Redis on possible match)
     bool IsBlacklisted(const std::string& jti);
 
+    // Record a blacklist entry written by this process before pub/sub echoes it back
+    void NoteBlacklisted(const std::string& jti);
+
+    // Number of cached verified tokens (for metrics/tests)
+    size_t CacheSize() const;
+
+    // Switch to a new public key; tokens signed with the previous one stay valid until they expire
+    void RotatePublicKey(const std::string& public_key_pem);
+
+    // Re-read keys_source now; false if it could not be fetched or parsed (the key set is then unchanged)
+    bool RefreshKeys();
+
+    // Number of distinct keys tokens are checked against
+    size_t KeyCount() const;
+
+    // Tenant-wide revocations checked by Validate(); null when tenant_revocations is off
+    std::shared_ptr<TenantRevocations> Revocations() const { return revocations_; }
+
 private:
-    jwt::verifier<jwt::default_clock, jwt::traits::kazuho_picojson> verifier_;
+    using Verifier = jwt::verifier<jwt::default_clock, jwt::traits::kazuho_picojson>;
+
+    struct KeySet {
+        std::unordered_map<std::string, std::shared_ptr<const Verifier>> by_kid;   // Document kid and thumbprint
+        std::unordered_map<std::string, std::shared_ptr<const Verifier>> by_pem;   // Reused across rebuilds
+        std::vector<std::shared_ptr<const Verifier>> all;                          // Tokens without a kid
+    };
+
+    struct CacheStripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, TokenClaims> entries;  // SHA-256(token) -> claims
+    };
+
+    std::optional<TokenClaims> VerifyAndDecode(const std::string& token);
+    static std::shared_ptr<const Verifier> MakeVerifier(const std::string& public_key_pem);
+    void InstallKeys();   // Requires keys_update_mutex_
+    std::shared_ptr<const KeySet> CurrentKeys() const;
+    std::shared_ptr<const Verifier> VerifierFor(const jwt::decoded_jwt<jwt::traits::kazuho_picojson>& decoded);
+    static std::string FetchKeys(const std::string& source);
+    void KeysLoop();
+    static std::string TokenCacheKey(std::string_view token);
+    CacheStripe& StripeFor(const std::string& cache_key);
+    std::optional<TokenClaims> GetCached(const std::string& cache_key, int64_t now);
+    void PutCached(const std::string& cache_key, const TokenClaims& claims, int64_t now);
+    void EvictCached(const std::string& cache_key);
+
+    // Blacklist filter sync (runs on the Redis subscriber thread)
+    void RebuildBlacklistFilter();
+    bool AddToBlacklistFilter(const std::string& jti);  // Returns true if a rebuild is due
+
+    mutable std::mutex keys_mutex_;          // keys_ and the refresh thread state below
+    std::shared_ptr<const KeySet> keys_;
+    std::mutex keys_update_mutex_;           // Serializes rebuilds; guards the key lists
+    std::vector<JwtPublicKey> pinned_keys_;   // Constructor key, or the latest two RotatePublicKey() keys
+    std::vector<JwtPublicKey> source_keys_;   // From keys_source
+    std::string source_document_;             // Unchanged documents skip the rebuild
     std::shared_ptr<RedisClient> redis_client_;
+    JwtValidatorOptions options_;
+
+    std::vector<std::unique_ptr<CacheStripe>> cache_stripes_;
+    size_t max_entries_per_stripe_ = 0;
+
+    // Filter is only trusted after a full SCAN; until then every check goes to Redis
+    mutable std::shared_mutex blacklist_mutex_;
+    std::unique_ptr<BloomFilter> blacklist_filter_;
+    bool blacklist_synced_ = false;
+    bool blacklist_rebuilding_ = false;
+    std::vector<std::string> blacklist_pending_;  // Arrivals during a rebuild
+    uint64_t blacklist_subscription_ = 0;
+
+    std::shared_ptr<TenantRevocations> revocations_;
+
+    // Key set refresh (runs only with a keys_source)
+    std::thread keys_thread_;
+    std::condition_variable keys_cv_;
+    bool keys_stop_ = false;
+    bool keys_refresh_requested_ = false;   // A token named an unknown kid
+    std::chrono::steady_clock::time_point keys_refreshed_at_{};
 };
 
 } // namespace common
@@ -0,0 +1,198 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Leveled, structured logging with per-thread buffers and a background writer
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+enum class LogLevel { kDebug = 0, kInfo = 1, kWarn = 2, kError = 3 };
+
+/**
+ * Logger options
+ *
+ * FromEnv() reads LOG_LEVEL (debug|info|warn|error), LOG_FORMAT (json|text),
+ * LOG_RATE_LIMIT_PER_S and LOG_FLUSH_INTERVAL_MS.
+ */
+struct LoggerOptions {
+    LogLevel level = LogLevel::kInfo;
+    bool json = true;
+    uint32_t rate_limit_per_s = 20;                    // Per message text; 0 = unlimited
+    size_t ring_capacity = 4096;                       // Records buffered per thread (power of two)
+    std::chrono::milliseconds flush_interval{100};
+
+    static LoggerOptions FromEnv();
+};
+
+/**
+ * One key/value pair of a structured record
+ *
+ * Numbers and booleans are written bare, everything else as a string.
+ */
+class LogField {
+public:
+    template <typename T>
+    LogField(std::string_view key, const T& value) : key_(key) {
+        if constexpr (std::is_same_v<T, bool>) {
+            value_ = value ? "true" : "false";
+            quoted_ = false;
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            value_ = std::to_string(value);
+            quoted_ = false;
+        } else {
+            value_ = std::string(std::string_view(value));
+            quoted_ = true;
+        }
+    }
+
+    std::string_view Key() const { return key_; }
+    const std::string& Value() const { return value_; }
+    bool Quoted() const { return quoted_; }
+
+private:
+    std::string_view key_;
+    std::string value_;
+    bool quoted_ = true;
+};
+
+struct LoggerStats {
+    uint64_t written = 0;
+    uint64_t dropped = 0;       // Thread buffer was full
+    uint64_t suppressed = 0;    // Rate limited
+};
+
+/**
+ * Asynchronous structured logger
+ *
+ * Log() formats the record on the calling thread and pushes it into that
+ * thread's single-producer ring buffer: no lock and no syscall on the
+ * logging path. A background writer drains every ring each
+ * flush_interval (or sooner when a ring fills up or an error is logged)
+ * and writes all pending records with one write() call. When a ring is
+ * full the record is dropped and counted rather than blocking the caller.
+ *
+ * Each distinct message text may be logged rate_limit_per_s times per
+ * second; further records are counted and the next record that gets
+ * through carries "suppressed": N. Keep variable parts in fields, not in
+ * the message, so that repeats are recognised.
+ *
+ * Usage:
+ *   LogWarn("Tenant ID mismatch", {{"jwt_tenant", a}, {"header_tenant", b}});
+ *   LogInfo("Email queued", {{"email_id", id}});
+ */
+class Logger {
+public:
+    using Sink = std::function<void(std::string_view data)>;
+
+    /// Writes to stdout
+    explicit Logger(const LoggerOptions& options);
+
+    /// Custom output (tests)
+    Logger(const LoggerOptions& options, Sink sink);
+
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /// Process-wide logger configured from the environment
+    static Logger& Global();
+
+    bool Enabled(LogLevel level) const {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+
+    void SetLevel(LogLevel level) { level_.store(static_cast<int>(level), std::memory_order_relaxed); }
+
+    void Log(LogLevel level, std::string_view message, std::initializer_list<LogField> fields = {});
+
+    /// Write everything buffered so far, on the calling thread
+    void Flush();
+
+    /// Stop the writer after a final flush (idempotent)
+    void Shutdown();
+
+    LoggerStats GetStats() const;
+
+    static std::string_view LevelName(LogLevel level);
+
+private:
+    class Ring;
+
+    // Lock-free rate limit table; colliding messages share a slot
+    struct RateSlot {
+        std::atomic<int64_t> window{0};         // Second the counts belong to
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint32_t> suppressed{0};
+    };
+    static constexpr size_t RATE_SLOTS = 1024;
+
+    bool Admit(std::string_view message, uint32_t* suppressed);
+    std::string Format(LogLevel level, std::string_view message, std::initializer_list<LogField> fields,
+                       uint32_t suppressed) const;
+    Ring& ThreadRing();
+    void Drain();
+    void WriterLoop();
+
+    LoggerOptions options_;
+    Sink sink_;
+    const uint64_t id_;
+    std::atomic<int> level_;
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex drain_mutex_;                   // One consumer at a time
+    std::string buffer_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> wake_requested_{false};
+
+    std::array<RateSlot, RATE_SLOTS> rate_slots_;
+
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> suppressed_{0};
+    uint64_t dropped_reported_ = 0;            // Guarded by drain_mutex_
+
+    std::atomic<bool> shutdown_{false};
+    std::thread writer_;
+};
+
+inline void LogDebug(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    Logger::Global().Log(LogLevel::kDebug, message, fields);
+}
+
+inline void LogInfo(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    Logger::Global().Log(LogLevel::kInfo, message, fields);
+}
+
+inline void LogWarn(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    Logger::Global().Log(LogLevel::kWarn, message, fields);
+}
+
+inline void LogError(std::string_view message, std::initializer_list<LogField> fields = {}) {
+    Logger::Global().Log(LogLevel::kError, message, fields);
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,278 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Counters, gauges and histograms exported in the Prometheus text format
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+namespace metrics_detail {
+
+constexpr size_t SHARDS = 16;
+constexpr size_t HISTOGRAM_SHARDS = 8;   // Histograms are larger; fewer shards
+
+/// Small per-thread index, so concurrent writers land on different shards
+size_t ThreadShard();
+
+} // namespace metrics_detail
+
+/**
+ * Monotonic counter
+ *
+ * Increments go to one of SHARDS cache-line sized cells picked by the
+ * calling thread; Value() sums them.
+ */
+class Counter {
+public:
+    void Increment(uint64_t n = 1) {
+        cells_[metrics_detail::ThreadShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Cell, metrics_detail::SHARDS> cells_;
+};
+
+/**
+ * Value that goes up and down (in-flight requests, pool sizes)
+ */
+class Gauge {
+public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Histogram buckets exported to Prometheus
+ *
+ * Values are recorded as integers in a base unit (microseconds, bytes) and
+ * multiplied by unit on export, so latency is recorded in microseconds and
+ * exported in seconds. bounds are the exported "le" values.
+ */
+struct HistogramOptions {
+    std::vector<double> bounds;
+    double unit = 1.0;
+
+    /// 100us .. 10s, recorded in microseconds, exported in seconds
+    static HistogramOptions LatencySeconds();
+
+    /// 64 B .. 64 MiB
+    static HistogramOptions SizeBytes();
+};
+
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;   // Fine-grained, see Histogram
+    uint64_t count = 0;
+    uint64_t sum = 0;
+
+    /// Upper bound of the bucket holding quantile q (0..1); 0 when empty
+    uint64_t ValueAtQuantile(double q) const;
+};
+
+/**
+ * HDR-style log-linear histogram
+ *
+ * Each power of two is split into 8 linear sub-buckets, so any recorded
+ * value is known to within 12.5% from 0 to 2^40 without configuring
+ * bucket boundaries up front. Like Counter, each thread records into its
+ * own shard without contention; shards are merged on Snapshot().
+ *
+ * Export maps the fine buckets onto HistogramOptions::bounds. A fine bucket
+ * that straddles a bound is counted under the next bound, so exported
+ * quantiles err on the high side.
+ */
+class Histogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr size_t NUM_BUCKETS = (1u << SUB_BUCKET_BITS) * (MAX_EXPONENT - SUB_BUCKET_BITS + 2);
+
+    explicit Histogram(HistogramOptions options = HistogramOptions::LatencySeconds());
+
+    void Record(uint64_t value);
+
+    void RecordDuration(std::chrono::steady_clock::duration duration) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        Record(us > 0 ? static_cast<uint64_t>(us) : 0);
+    }
+
+    /**
+     * Records the time until it goes out of scope (also on exceptions)
+     */
+    class Timer {
+    public:
+        explicit Timer(Histogram& histogram)
+            : histogram_(&histogram), start_(std::chrono::steady_clock::now()) {}
+        ~Timer() {
+            if (histogram_) {
+                histogram_->RecordDuration(std::chrono::steady_clock::now() - start_);
+            }
+        }
+        Timer(Timer&& other) noexcept : histogram_(other.histogram_), start_(other.start_) {
+            other.histogram_ = nullptr;
+        }
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+        Timer& operator=(Timer&&) = delete;
+
+    private:
+        Histogram* histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    Timer StartTimer() { return Timer(*this); }
+
+    HistogramSnapshot Snapshot() const;
+    const HistogramOptions& Options() const { return options_; }
+
+    static size_t BucketIndex(uint64_t value);
+    /// Largest value that falls in bucket
+    static uint64_t BucketUpperBound(size_t bucket);
+
+private:
+    struct Shard {
+        std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets{};
+        alignas(64) std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    HistogramOptions options_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+/**
+ * Builds one scrape; passed to collectors
+ *
+ * Samples of the same metric name are grouped under one HELP/TYPE header
+ * whatever order they are written in.
+ */
+class MetricsWriter {
+public:
+    void AddCounter(const std::string& name, const std::string& help, const MetricLabels& labels, double value);
+    void AddGauge(const std::string& name, const std::string& help, const MetricLabels& labels, double value);
+
+    /**
+     * Histogram from pre-bucketed data
+     *
+     * @param bounds Upper bounds ("le"), ascending, without +Inf
+     * @param cumulative Observations <= each bound (same size as bounds)
+     */
+    void AddHistogram(const std::string& name, const std::string& help, const MetricLabels& labels,
+                      const std::vector<double>& bounds, const std::vector<uint64_t>& cumulative,
+                      uint64_t count, double sum);
+
+    void AddHistogram(const std::string& name, const std::string& help, const MetricLabels& labels,
+                      const HistogramSnapshot& snapshot, const HistogramOptions& options);
+
+    /// Prometheus text exposition format (version 0.0.4)
+    std::string Text() const;
+
+private:
+    struct Family {
+        std::string help;
+        const char* type;
+        std::string samples;
+    };
+
+    Family& GetFamily(const std::string& name, const std::string& help, const char* type);
+
+    std::map<std::string, Family> families_;
+};
+
+/**
+ * Process-wide set of metrics
+ *
+ * Get*() returns the metric registered under name and labels, creating it
+ * on first use; the reference stays valid for the life of the process.
+ * Lookups take a mutex, so hot paths look a metric up once and keep the
+ * reference (a function-local static, or a member).
+ *
+ * Components that already keep their own statistics register a collector
+ * instead, which is called on every scrape to write current values.
+ *
+ * Usage:
+ *   static Histogram& latency = MetricsRegistry::Global().GetHistogram(
+ *       "saasforge_redis_command_duration_seconds", "Redis round trip",
+ *       HistogramOptions::LatencySeconds(), {{"command", "get"}});
+ *   auto timer = latency.StartTimer();
+ */
+class MetricsRegistry {
+public:
+    using Collector = std::function<void(MetricsWriter& writer)>;
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    static MetricsRegistry& Global();
+
+    Counter& GetCounter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    Gauge& GetGauge(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+
+    /// options only apply when the histogram is created
+    Histogram& GetHistogram(const std::string& name, const std::string& help,
+                            const HistogramOptions& options, const MetricLabels& labels = {});
+
+    /**
+     * Register a collector
+     *
+     * @return Id for RemoveCollector(); owners remove it before they are
+     *         destroyed (RemoveCollector waits for a running scrape)
+     */
+    uint64_t AddCollector(Collector collector);
+    void RemoveCollector(uint64_t id);
+
+    /// Everything, in the Prometheus text format
+    std::string Render() const;
+
+private:
+    enum class Type { kCounter, kGauge, kHistogram };
+
+    struct Entry {
+        Type type;
+        std::string name;
+        std::string help;
+        MetricLabels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    Entry& GetEntry(Type type, const std::string& name, const std::string& help, const MetricLabels& labels,
+                    const HistogramOptions* options);
+
+    mutable std::mutex metrics_mutex_;
+    std::map<std::pair<std::string, MetricLabels>, Entry> metrics_;
+
+    mutable std::mutex collectors_mutex_;
+    std::map<uint64_t, Collector> collectors_;
+    uint64_t next_collector_id_ = 1;
+};
+
+} // namespace common
+} // namespace saasforge
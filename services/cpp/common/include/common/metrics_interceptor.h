@@ -0,0 +1,66 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server interceptor recording per-method latency, status codes and payload sizes
+ */
+
+#pragma once
+
+#include "common/metrics.h"
+#include <grpcpp/support/server_interceptor.h>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Creates a MetricsInterceptor for every RPC
+ *
+ * Per method ("/saasforge.auth.AuthService/Login" split into grpc_service
+ * and grpc_method labels) it exports:
+ *
+ *   saasforge_grpc_server_handled_total{grpc_code}        counter
+ *   saasforge_grpc_server_handling_seconds                histogram
+ *   saasforge_grpc_server_msg_received_bytes              histogram
+ *   saasforge_grpc_server_msg_sent_bytes                  histogram
+ *   saasforge_grpc_server_in_flight                       gauge
+ *
+ * Metrics for a method are looked up once and cached, so an RPC costs a
+ * shared lock and a handful of relaxed atomic adds. Installed by
+ * AddServerInterceptors() (common/server_interceptors.h).
+ */
+class MetricsInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    static constexpr int NUM_CODES = 17;   // grpc::StatusCode OK .. UNAUTHENTICATED
+
+    struct MethodMetrics {
+        MetricsRegistry* registry = nullptr;
+        MetricLabels labels;
+        Histogram* latency = nullptr;
+        Histogram* received_bytes = nullptr;
+        Histogram* sent_bytes = nullptr;
+        Gauge* in_flight = nullptr;
+        std::atomic<Counter*> handled[NUM_CODES] = {};
+        bool count_request_bytes = false;   // Request type is a generated protobuf message
+
+        /// Counter for a status code, registered on first use
+        Counter& Handled(int code);
+    };
+
+    explicit MetricsInterceptorFactory(MetricsRegistry& registry = MetricsRegistry::Global());
+
+    grpc::experimental::Interceptor* CreateServerInterceptor(grpc::experimental::ServerRpcInfo* info) override;
+
+    MethodMetrics& ForMethod(const char* method);
+
+private:
+    MetricsRegistry& registry_;
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<MethodMetrics>> methods_;
+};
+
+} // namespace common
+} // namespace saasforge
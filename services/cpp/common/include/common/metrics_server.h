@@ -0,0 +1,100 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Minimal HTTP endpoint serving /metrics for Prometheus scrapes
+ */
+
+#pragma once
+
+#include "common/metrics.h"
+#include "common/profiler.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Metrics endpoint options
+ *
+ * FromEnv() reads METRICS_PORT (0 = disabled) and METRICS_BIND_ADDRESS, and
+ * the profiling endpoints' options (see ProfilingOptions).
+ */
+struct MetricsServerOptions {
+    std::string bind_address = "0.0.0.0";
+    uint16_t port = 9464;
+    ProfilingOptions profiling;                 // Empty token: /debug/pprof/* are not served
+
+    static MetricsServerOptions FromEnv();
+};
+
+/**
+ * Serves GET /metrics (Prometheus text format) and GET /healthz
+ *
+ * One background thread accepts and answers connections one at a time;
+ * scrapes are rare and cheap, and keeping this off the gRPC server means
+ * metrics stay available when the RPC thread pool is saturated.
+ *
+ * With a profiling token configured it also serves, to requests carrying
+ * "Authorization: Bearer <token>":
+ *   GET /debug/pprof/profile?seconds=N   CPU profile (default 30 s, capped
+ *                                        at max_cpu_duration)
+ *   GET /debug/pprof/heap                heap snapshot
+ * A CPU profile is answered from its own thread, so scrapes are not held
+ * up while it runs; one runs at a time (409 otherwise). A profile kind the
+ * process cannot take answers 501. Without a token both paths are 404.
+ *
+ * Usage:
+ *   auto options = MetricsServerOptions::FromEnv();
+ *   std::unique_ptr<MetricsServer> metrics;
+ *   if (options.port != 0) {
+ *       metrics = std::make_unique<MetricsServer>(MetricsRegistry::Global(), options);
+ *   }
+ */
+class MetricsServer {
+public:
+    /**
+     * Bind and start serving
+     *
+     * Port 0 binds an ephemeral port (tests); see Port().
+     *
+     * @throws std::runtime_error if the address cannot be bound
+     */
+    MetricsServer(const MetricsRegistry& registry, const MetricsServerOptions& options,
+                  Profiler& profiler = Profiler::Default());
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /// Port actually bound
+    uint16_t Port() const { return port_; }
+
+    /// Stop accepting and join the thread (idempotent)
+    void Shutdown();
+
+private:
+    void AcceptLoop();
+    /// @return False if `fd` was handed to the profile thread, which closes it
+    bool Serve(int fd);
+    bool ServeProfile(int fd, const std::string& path, const std::string& query);
+    bool Authorized(const std::string& request) const;
+
+    const MetricsRegistry& registry_;
+    ProfilingOptions profiling_;
+    Profiler& profiler_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> shutdown_{false};
+    std::thread thread_;
+
+    std::mutex profile_mutex_;
+    std::thread profile_thread_;
+    std::atomic<bool> profile_running_{false};   // profile_thread_ is still answering
+};
+
+} // namespace common
+} // namespace saasforge
@@ -9,89 +9,43 @@
 
 #pragma once
 
+#include "common/stripe_api.h"
 #include <string>
 #include <vector>
 #include <optional>
 #include <cstdint>
-#include <map>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace saasforge {
 namespace common {
 
 /**
- * Subscription status (Requirement C-63)
- */
-enum class SubscriptionStatus {
-    TRIALING,      // In trial period
-    ACTIVE,        // Active and paid
-    PAST_DUE,      // Payment failed, in grace period
-    CANCELED,      // Canceled by user
-    UNPAID,        // Payment failed after retries
-    PAUSED         // Temporarily paused
-};
-
-/**
- * Payment intent status
- */
-enum class PaymentIntentStatus {
-    SUCCEEDED,
-    FAILED,
-    PROCESSING,
-    REQUIRES_ACTION  // SCA/3DS required
-};
-
-/**
- * Mock Stripe customer
- */
-struct StripeCustomer {
-    std::string id;              // cus_XXXXX
-    std::string email;
-    std::string tenant_id;
-    std::string default_payment_method;
-    int64_t created;
-};
-
-/**
- * Mock Stripe subscription
- */
-struct StripeSubscription {
-    std::string id;              // sub_XXXXX
-    std::string customer_id;
-    std::string plan_id;
-    SubscriptionStatus status;
-    int64_t current_period_start;
-    int64_t current_period_end;
-    int64_t trial_end;
-    bool cancel_at_period_end;
-    double amount;               // Monthly amount in dollars
-    int retry_count;             // Failed payment retry attempts
-};
-
-/**
- * Mock Stripe payment method
+ * MockStripeClient behaviour
+ *
+ * FromEnv() reads MOCK_STRIPE_SHARDS, MOCK_STRIPE_LATENCY_P50_MS,
+ * MOCK_STRIPE_LATENCY_P99_MS, MOCK_STRIPE_RATE_LIMIT_RATE and
+ * MOCK_STRIPE_DECLINE_RATE.
  */
-struct StripePaymentMethod {
-    std::string id;              // pm_XXXXX
-    std::string type;            // "card", "ach_debit", "sepa_debit"
-    std::string card_last4;
-    std::string card_brand;      // "visa", "mastercard", etc.
-    int exp_month;
-    int exp_year;
+struct MockStripeOptions {
+    size_t num_shards = 16;
+    std::chrono::microseconds latency_p50{0};   // 0: no injected latency
+    std::chrono::microseconds latency_p99{0};   // Below p50: fixed p50 latency
+    double rate_limit_rate = 0.0;               // Fraction of calls failing with StripeRateLimited
+    double decline_rate = 0.2;                  // Fraction of PayInvoice calls declined
+
+    static MockStripeOptions FromEnv();
 };
 
-/**
- * Mock Stripe invoice
- */
-struct StripeInvoice {
-    std::string id;              // in_XXXXX
-    std::string customer_id;
-    std::string subscription_id;
-    double amount_due;
-    double amount_paid;
-    std::string status;          // "draft", "open", "paid", "void"
-    int64_t created;
-    int64_t due_date;
-    std::vector<std::string> line_items;
+/// Calls made and failures injected since construction
+struct MockStripeStats {
+    uint64_t calls = 0;
+    uint64_t rate_limited = 0;
+    uint64_t declined = 0;
 };
 
 /**
@@ -99,27 +53,37 @@ struct StripeInvoice {
  *
  * Simulates Stripe API operations for development and testing.
  * Maintains in-memory state for subscriptions, customers, and payment methods.
+ *
+ * Safe to share between threads: each object type lives in a sharded hash
+ * map with one mutex per shard, and no call holds more than one shard lock
+ * at a time. Every API call first waits an injected latency (log-normal
+ * through p50 and p99, outside any lock) and may then fail with
+ * StripeRateLimited, so load tests see Stripe-like latency and contention.
+ *
+ * Usage:
+ *   MockStripeClient stripe("sk_test_mock", MockStripeOptions::FromEnv());
+ *   auto customer = stripe.CreateCustomer(email, tenant_id);
  */
-class MockStripeClient {
+class MockStripeClient : public StripeApi {
 public:
-    MockStripeClient(const std::string& api_key);
+    MockStripeClient(const std::string& api_key, const MockStripeOptions& options = {});
 
     // Customer operations
-    StripeCustomer CreateCustomer(const std::string& email, const std::string& tenant_id);
-    std::optional<StripeCustomer> GetCustomer(const std::string& customer_id);
+    StripeCustomer CreateCustomer(const std::string& email, const std::string& tenant_id) override;
+    std::optional<StripeCustomer> GetCustomer(const std::string& customer_id) override;
 
     // Subscription operations
     StripeSubscription CreateSubscription(
         const std::string& customer_id,
         const std::string& plan_id,
         int trial_days = 0
-    );
-    std::optional<StripeSubscription> GetSubscription(const std::string& subscription_id);
+    ) override;
+    std::optional<StripeSubscription> GetSubscription(const std::string& subscription_id) override;
     StripeSubscription UpdateSubscription(
         const std::string& subscription_id,
         const std::string& new_plan_id
-    );
-    void CancelSubscription(const std::string& subscription_id, bool cancel_immediately = false);
+    ) override;
+    void CancelSubscription(const std::string& subscription_id, bool cancel_immediately = false) override;
 
     // Payment method operations
     StripePaymentMethod CreatePaymentMethod(
@@ -127,16 +91,16 @@ public:
         const std::string& card_number = "",
         int exp_month = 0,
         int exp_year = 0
-    );
-    void AttachPaymentMethod(const std::string& payment_method_id, const std::string& customer_id);
-    void DetachPaymentMethod(const std::string& payment_method_id);
-    std::optional<StripePaymentMethod> GetPaymentMethod(const std::string& payment_method_id);
+    ) override;
+    void AttachPaymentMethod(const std::string& payment_method_id, const std::string& customer_id) override;
+    void DetachPaymentMethod(const std::string& payment_method_id) override;
+    std::optional<StripePaymentMethod> GetPaymentMethod(const std::string& payment_method_id) override;
 
     // Invoice operations
-    StripeInvoice CreateInvoice(const std::string& customer_id, const std::string& subscription_id);
-    std::optional<StripeInvoice> GetInvoice(const std::string& invoice_id);
-    void FinalizeInvoice(const std::string& invoice_id);
-    PaymentIntentStatus PayInvoice(const std::string& invoice_id);
+    StripeInvoice CreateInvoice(const std::string& customer_id, const std::string& subscription_id) override;
+    std::optional<StripeInvoice> GetInvoice(const std::string& invoice_id) override;
+    void FinalizeInvoice(const std::string& invoice_id) override;
+    PaymentIntentStatus PayInvoice(const std::string& invoice_id) override;
 
     // Payment retry logic (Requirement C-71)
     void RecordPaymentFailure(const std::string& subscription_id);
@@ -150,14 +114,47 @@ public:
     static std::string StatusToString(SubscriptionStatus status);
     static SubscriptionStatus StringToStatus(const std::string& status_str);
 
+    MockStripeStats GetStats() const;
+
 private:
+    /// Hash map split into independently locked shards
+    template <typename T>
+    class ShardedMap {
+    public:
+        explicit ShardedMap(size_t num_shards);
+
+        void Put(const std::string& id, T value);
+        std::optional<T> Get(const std::string& id) const;
+        bool Erase(const std::string& id);
+
+        /// Run update(value&) under the shard lock; false if absent
+        bool Update(const std::string& id, const std::function<void(T&)>& update);
+
+    private:
+        struct Shard {
+            mutable std::mutex mutex;
+            std::unordered_map<std::string, T> entries;
+        };
+        Shard& ShardFor(const std::string& id) const;
+
+        std::vector<std::unique_ptr<Shard>> shards_;
+    };
+
     std::string api_key_;
+    MockStripeOptions options_;
 
     // In-memory storage (in production, Stripe manages this)
-    std::map<std::string, StripeCustomer> customers_;
-    std::map<std::string, StripeSubscription> subscriptions_;
-    std::map<std::string, StripePaymentMethod> payment_methods_;
-    std::map<std::string, StripeInvoice> invoices_;
+    ShardedMap<StripeCustomer> customers_;
+    ShardedMap<StripeSubscription> subscriptions_;
+    ShardedMap<StripePaymentMethod> payment_methods_;
+    ShardedMap<StripeInvoice> invoices_;
+
+    std::atomic<uint64_t> calls_{0};
+    std::atomic<uint64_t> rate_limited_{0};
+    std::atomic<uint64_t> declined_{0};
+
+    /// Injected latency, then maybe StripeRateLimited; first thing in every API call
+    void SimulateApiCall();
 
     // ID generators
     std::string GenerateId(const std::string& prefix);
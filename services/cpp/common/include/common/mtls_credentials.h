@@ -8,22 +8,53 @@
 namespace saasforge {
 namespace common {
 
+/**
+ * mTLS credentials for servers and service-to-service channels
+ *
+ * Certificates are not read once: a file watcher re-reads the CA bundle
+ * and key/cert pair every MTLS_CERT_REFRESH_S and new handshakes use what
+ * it finds, so cert-manager rotating 24h certificates needs no restart.
+ * Established connections keep the certificate they were opened with.
+ * Replace key and cert atomically (a Kubernetes secret volume swaps a
+ * symlinked directory); a mismatched pair is skipped until both agree.
+ *
+ * Reconnects resume TLS sessions instead of repeating the full handshake:
+ * servers issue session tickets, and ChannelPool channels share a client
+ * session cache (GRPC_CLIENT_TLS_SESSION_CACHE).
+ */
 class MtlsCredentials {
 public:
-    // Create server credentials with mTLS
+    static constexpr long DEFAULT_REFRESH_S = 60;
+
+    // Create server credentials with mTLS (throws if a file cannot be read)
     static std::shared_ptr<grpc::ServerCredentials> CreateServerCredentials(
         const std::string& ca_cert_path,
         const std::string& server_cert_path,
         const std::string& server_key_path
     );
 
-    // Create client credentials with mTLS
+    // Create client credentials with mTLS (throws if a file cannot be read)
     static std::shared_ptr<grpc::ChannelCredentials> CreateClientCredentials(
         const std::string& ca_cert_path,
         const std::string& client_cert_path,
         const std::string& client_key_path
     );
 
+    /**
+     * CreateClientCredentials() memoized per path triple
+     *
+     * Every channel to every service shares one credentials object (and
+     * one file watcher), which follows certificate rotation by itself.
+     */
+    static std::shared_ptr<grpc::ChannelCredentials> CachedClientCredentials(
+        const std::string& ca_cert_path,
+        const std::string& client_cert_path,
+        const std::string& client_key_path
+    );
+
+    /// Seconds between checks of the certificate files (MTLS_CERT_REFRESH_S)
+    static unsigned int RefreshInterval();
+
 private:
     static std::string ReadFile(const std::string& path);
 };
@@ -0,0 +1,61 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Transactional outbox: domain events written with the change that caused them
+ */
+
+#pragma once
+
+#include <string>
+#include <google/protobuf/message.h>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Writes domain events into outbox_events
+ *
+ * Append() runs in the caller's transaction, so an event is committed
+ * together with the business change that raised it, or not at all: a
+ * crash between the two cannot lose or invent it, and the service needs
+ * no extra RPC to notify anyone. OutboxRelay (in the notification
+ * service) tails the table and fans events out to the delivery queues.
+ *
+ * Usage:
+ *   pqxx::work txn(*conn_guard);
+ *   ExecPrepared(txn, kCreateSubscription, ...);
+ *   Outbox::Append(txn, tenant_id, "subscription.created", *response);
+ *   txn.commit();
+ */
+class Outbox {
+public:
+    /// NOTIFY channel Append() signals on commit; pass it to the relay's QueueNotifier
+    static constexpr const char* NOTIFY_CHANNEL = "outbox_events";
+
+    /**
+     * Record an event in the caller's transaction
+     *
+     * @param txn Transaction making the change the event describes
+     * @param tenant_id Tenant whose subscribers receive it
+     * @param event_type Event type (e.g., "subscription.created")
+     * @param payload JSON payload
+     */
+    static void Append(
+        pqxx::transaction_base& txn,
+        const std::string& tenant_id,
+        const std::string& event_type,
+        const std::string& payload
+    );
+
+    /// Append() with the message as its JSON payload (proto field names)
+    static void Append(
+        pqxx::transaction_base& txn,
+        const std::string& tenant_id,
+        const std::string& event_type,
+        const google::protobuf::Message& payload
+    );
+};
+
+} // namespace common
+} // namespace saasforge
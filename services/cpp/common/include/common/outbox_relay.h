@@ -0,0 +1,91 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Relays outbox_events into the webhook delivery queue in batches
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "db_pool.h"
+#include "queue_notifier.h"
+#include "webhook_delivery.h"
+#include "webhook_subscriptions.h"
+
+namespace saasforge {
+namespace common {
+
+/**
+ * OutboxRelay options
+ *
+ * FromEnv() reads OUTBOX_RELAY_BATCH_SIZE and OUTBOX_RELAY_POLL_MS.
+ */
+struct OutboxRelayOptions {
+    size_t batch_size = 500;                        // Events claimed, and fanned out, per transaction
+    std::chrono::milliseconds poll_interval{1000};  // Longest idle wait (the only wakeup without a notifier)
+
+    static OutboxRelayOptions FromEnv();
+};
+
+/**
+ * Tails outbox_events (see Outbox) and fans events out to their webhooks
+ *
+ * Each batch is one transaction: the oldest events are deleted from the
+ * outbox with FOR UPDATE SKIP LOCKED, so relays on several replicas split
+ * the backlog, and their deliveries are inserted by a single multi-row
+ * statement (WebhookDelivery::QueueEvents) before the commit. An event is
+ * therefore relayed exactly once; if the relay dies mid-batch, the
+ * transaction rolls back and the events are claimed again.
+ *
+ * The relay sleeps on Outbox::NOTIFY_CHANNEL when given a notifier that
+ * listens on it, and keeps claiming without waiting while batches come
+ * back full.
+ */
+class OutboxRelay {
+public:
+    OutboxRelay(
+        std::shared_ptr<DbPool> db_pool,
+        std::shared_ptr<WebhookSubscriptionIndex> subscriptions,
+        std::shared_ptr<WebhookDelivery> webhook_delivery,
+        std::shared_ptr<QueueNotifier> notifier = nullptr,
+        const OutboxRelayOptions& options = {}
+    );
+    ~OutboxRelay();
+
+    OutboxRelay(const OutboxRelay&) = delete;
+    OutboxRelay& operator=(const OutboxRelay&) = delete;
+
+    /**
+     * Relay one batch
+     *
+     * @return Events claimed (a full batch means more may be waiting)
+     * @throws std::exception if the batch failed; its events stay in the outbox
+     */
+    size_t RunOnce();
+
+    /// Stop the relay thread after the batch in progress, within poll_interval (idempotent)
+    void Shutdown();
+
+private:
+    void Loop();
+
+    std::shared_ptr<DbPool> db_pool_;
+    std::shared_ptr<WebhookSubscriptionIndex> subscriptions_;
+    std::shared_ptr<WebhookDelivery> webhook_delivery_;
+    std::shared_ptr<QueueNotifier> notifier_;
+    OutboxRelayOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> shutdown_{false};
+    std::thread thread_;
+};
+
+} // namespace common
+} // namespace saasforge
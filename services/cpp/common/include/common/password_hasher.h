@@ -1,11 +1,69 @@
 #pragma once
 
 #include <string>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 
 namespace saasforge {
 namespace common {
 
+/**
+ * Argon2id cost parameters for new hashes
+ *
+ * Every hash carries its own parameters in its PHC string, so verification
+ * works for hashes made under any policy; the policy only decides how new
+ * hashes are made and which stored ones are upgraded (NeedsRehash()).
+ *
+ * FromEnv() reads PASSWORD_HASH_MEMORY_KB, PASSWORD_HASH_TIME_COST and
+ * PASSWORD_HASH_PARALLELISM. With PASSWORD_HASH_CALIBRATE_MS set it
+ * calibrates instead, starting from those values (see Calibrate()).
+ */
+struct PasswordHashPolicy {
+    uint32_t memory_cost_kb = 65536;   // 64 MB (OWASP recommendations for 2024)
+    uint32_t time_cost = 3;            // Iterations
+    uint32_t parallelism = 4;          // Lanes (and threads) per hash
+
+    /// OWASP floor: 19 MB, 2 iterations; Calibrate() never goes below it
+    static constexpr uint32_t MIN_MEMORY_COST_KB = 19456;
+    static constexpr uint32_t MIN_TIME_COST = 2;
+    static constexpr uint32_t MAX_TIME_COST = 10;
+
+    /// Argon2 work of one hash (memory x iterations), the measure hashes are ranked by
+    uint64_t Cost() const { return static_cast<uint64_t>(memory_cost_kb) * time_cost; }
+
+    /// "m=65536,t=3,p=4"
+    std::string ToString() const;
+
+    bool operator==(const PasswordHashPolicy& other) const {
+        return memory_cost_kb == other.memory_cost_kb && time_cost == other.time_cost &&
+               parallelism == other.parallelism;
+    }
+    bool operator!=(const PasswordHashPolicy& other) const { return !(*this == other); }
+
+    static PasswordHashPolicy FromEnv();
+
+    /// Time of one hash with the given parameters
+    using Measure = std::function<std::chrono::microseconds(const PasswordHashPolicy& policy)>;
+
+    /**
+     * Parameters whose hash takes about `budget` on this machine
+     *
+     * Parallelism is min(cores, start.parallelism). Memory is halved from
+     * start.memory_cost_kb (down to MIN_MEMORY_COST_KB) while even
+     * MIN_TIME_COST passes would exceed the budget; iterations then fill
+     * the budget, between MIN_TIME_COST and MAX_TIME_COST.
+     *
+     * @param budget Target latency of one hash
+     * @param start Upper bound for memory and parallelism
+     * @param cores Cores available (0 = hardware concurrency)
+     * @param measure Timing of one hash (default: run Argon2)
+     */
+    static PasswordHashPolicy Calibrate(std::chrono::milliseconds budget, const PasswordHashPolicy& start,
+                                        unsigned cores = 0, const Measure& measure = nullptr);
+};
+
 /**
  * Secure password hasher using Argon2id
  *
@@ -18,9 +76,22 @@ namespace common {
 class PasswordHasher {
 public:
     /**
-     * Hash a password using Argon2id
+     * Where Argon2 allocates its memory blocks
+     *
+     * HEAP mallocs (and, at 64 MB, mmaps) the blocks on every call.
+     * THREAD_ARENA reuses one buffer per calling thread; it is only meant for
+     * the fixed worker threads of PasswordHashingPool, since every thread
+     * that uses it keeps the largest memory cost it hashed with resident.
+     */
+    enum class Memory {
+        HEAP,
+        THREAD_ARENA
+    };
+
+    /**
+     * Hash a password using Argon2id under the current Policy()
      *
-     * Parameters (following OWASP recommendations):
+     * Parameters (default policy, following OWASP recommendations):
      * - Memory cost: 64 MB (65536 KB)
      * - Time cost: 3 iterations
      * - Parallelism: 4 threads
@@ -28,24 +99,49 @@ public:
      * - Hash length: 32 bytes
      *
      * @param password Plain text password to hash
+     * @param memory Allocation strategy for the Argon2 blocks
      * @return Argon2id hash in PHC string format: $argon2id$v=19$m=65536,t=3,p=4$salt$hash
      */
-    static std::string HashPassword(const std::string& password);
+    static std::string HashPassword(const std::string& password, Memory memory = Memory::HEAP);
+
+    /// Hash a password with explicit parameters
+    static std::string HashPassword(const std::string& password, const PasswordHashPolicy& policy,
+                                    Memory memory = Memory::HEAP);
 
     /**
      * Verify a password against an Argon2id hash
      *
      * @param password Plain text password to verify
      * @param hash Argon2id hash in PHC string format
+     * @param memory Allocation strategy for the Argon2 blocks
      * @return true if password matches, false otherwise
      */
-    static bool VerifyPassword(const std::string& password, const std::string& hash);
+    static bool VerifyPassword(const std::string& password, const std::string& hash, Memory memory = Memory::HEAP);
+
+    /**
+     * Whether a stored hash should be replaced by one under `policy`
+     *
+     * True when the hash costs less than the policy (PasswordHashPolicy::Cost())
+     * or is not an Argon2id v19 PHC string. Stronger hashes are kept, so
+     * replicas with different policies never rehash each other's hashes
+     * back and forth; lowering the policy only makes new hashes cheaper.
+     */
+    static bool NeedsRehash(const std::string& hash, const PasswordHashPolicy& policy);
+    static bool NeedsRehash(const std::string& hash) { return NeedsRehash(hash, Policy()); }
+
+    /// Parameters new hashes are made with (process-wide, default PasswordHashPolicy{})
+    static PasswordHashPolicy Policy();
+
+    /// Replace the policy, e.g. with PasswordHashPolicy::FromEnv() at startup
+    static void SetPolicy(const PasswordHashPolicy& policy);
+
+    /// Argon2 working memory per hash under Policy(), in bytes
+    static size_t MemoryPerHash() { return static_cast<size_t>(Policy().memory_cost_kb) * 1024; }
+
+    /// Argon2 lanes (and threads) per hash under Policy()
+    static uint32_t Parallelism() { return Policy().parallelism; }
 
 private:
-    // Argon2id parameters (OWASP recommendations for 2024)
-    static constexpr uint32_t MEMORY_COST_KB = 65536;  // 64 MB
-    static constexpr uint32_t TIME_COST = 3;           // 3 iterations
-    static constexpr uint32_t PARALLELISM = 4;         // 4 threads
     static constexpr uint32_t HASH_LENGTH = 32;        // 32 bytes output
     static constexpr uint32_t SALT_LENGTH = 16;        // 16 bytes salt
 };
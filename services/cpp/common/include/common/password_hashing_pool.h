@@ -0,0 +1,120 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Bounded worker pool for Argon2 password hashing
+ */
+
+#pragma once
+
+#include "common/executor.h"
+#include "common/metrics.h"
+#include "common/password_hasher.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Password hashing pool options
+ *
+ * FromEnv() reads PASSWORD_HASH_WORKERS and PASSWORD_HASH_QUEUE_CAPACITY.
+ */
+struct PasswordHashingOptions {
+    size_t workers = 0;          // Concurrent hashes (0 = cores / Argon2 parallelism, at least 1)
+    size_t queue_capacity = 64;  // Admitted but not yet running; beyond this callers fail fast
+
+    static PasswordHashingOptions FromEnv();
+};
+
+/**
+ * Thrown when the admission queue is full; services map it to RESOURCE_EXHAUSTED
+ */
+class PasswordHashingOverloaded : public std::runtime_error {
+public:
+    PasswordHashingOverloaded() : std::runtime_error("Password hashing capacity exhausted") {}
+};
+
+/**
+ * Per-call timing
+ */
+struct PasswordHashTiming {
+    std::chrono::microseconds queued{0};   // Waiting for a worker
+    std::chrono::microseconds hashing{0};  // Argon2 itself
+};
+
+/**
+ * Runs Argon2 on a fixed set of worker threads
+ *
+ * Argon2id needs 64 MB per call under the default policy. Running it
+ * inline on gRPC threads lets a login burst allocate gigabytes and starve
+ * every other RPC. The pool caps concurrent hashes at `workers`, each
+ * worker reuses one Argon2 arena (PasswordHasher::Memory::THREAD_ARENA),
+ * so peak memory is workers x the largest memory cost hashed and nothing
+ * is mmapped per call. Callers block until their hash completes; once
+ * queue_capacity requests are waiting, new callers get
+ * PasswordHashingOverloaded immediately.
+ *
+ * Usage:
+ *   PasswordHashingPool pool(PasswordHashingOptions::FromEnv());
+ *   PasswordHashTiming timing;
+ *   bool ok = pool.Verify(password, stored_hash, &timing);
+ */
+class PasswordHashingPool {
+public:
+    explicit PasswordHashingPool(const PasswordHashingOptions& options = {});
+    ~PasswordHashingPool();
+
+    PasswordHashingPool(const PasswordHashingPool&) = delete;
+    PasswordHashingPool& operator=(const PasswordHashingPool&) = delete;
+
+    /**
+     * Hash a password on a worker thread
+     *
+     * BULK is for hashes nobody waits on (rehash-on-login): they queue
+     * behind logins and, with more than one worker, never take the last.
+     *
+     * @throws PasswordHashingOverloaded if the admission queue is full
+     */
+    std::string Hash(const std::string& password, PasswordHashTiming* timing = nullptr,
+                     TaskPriority priority = TaskPriority::CRITICAL);
+
+    /**
+     * Verify a password on a worker thread
+     *
+     * @throws PasswordHashingOverloaded if the admission queue is full
+     */
+    bool Verify(const std::string& password, const std::string& hash, PasswordHashTiming* timing = nullptr);
+
+    /**
+     * Verify a password, running meanwhile on the calling thread as the hash runs
+     *
+     * For the caller's own round trips that do not depend on the outcome
+     * (they overlap the hash instead of following it). An exception from
+     * meanwhile is rethrown once the hash has finished.
+     *
+     * @throws PasswordHashingOverloaded if the admission queue is full (meanwhile is not run)
+     */
+    bool Verify(const std::string& password, const std::string& hash, const std::function<void()>& meanwhile,
+                PasswordHashTiming* timing = nullptr);
+
+    size_t Workers() const { return executor_.ThreadCount(); }
+    size_t QueueDepth() const { return executor_.QueueDepth(); }
+    uint64_t RejectedCount() const { return executor_.RejectedCount(); }
+    uint64_t CompletedCount() const { return completed_.load(std::memory_order_relaxed); }
+
+private:
+    template <typename Result, typename Fn>
+    Result Run(Fn fn, Histogram& duration, PasswordHashTiming* timing,
+               const std::function<void()>* meanwhile = nullptr, TaskPriority priority = TaskPriority::CRITICAL);
+
+    Executor executor_;
+    std::atomic<uint64_t> completed_{0};
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,187 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Compressed, content-addressed storage of queued payloads with per-scope dictionaries
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * PayloadCodec options
+ *
+ * FromEnv() reads PAYLOAD_STORE_MIN_BYTES, PAYLOAD_COMPRESSION_LEVEL and
+ * PAYLOAD_DICTIONARY_SAMPLES.
+ */
+struct PayloadCodecOptions {
+    size_t min_size = 1024;                 // Smaller payloads stay inline in their row
+    int level = 6;                          // zlib level, 1 (fast) .. 9 (small)
+    size_t dictionary_samples = 0;          // Payloads sampled per scope before a dictionary is trained; 0: off
+    size_t max_sampled_scopes = 256;        // Scopes sampled at once
+    std::chrono::seconds reload_interval{60};   // Unknown dictionaries trigger at most one reload per interval
+
+    static PayloadCodecOptions FromEnv();
+};
+
+/**
+ * A payload prepared for its row
+ *
+ * Inline payloads keep their text column; the others leave it '' and
+ * reference payload_blobs by hash. hash and data are bytea input literals
+ * ("\x<hex>") for $n::bytea parameters and ToArrayLiteral.
+ */
+struct StoredPayload {
+    std::string text;   // Column value: the payload, or '' when it is in payload_blobs
+    std::string hash;   // SHA-256 of the payload; empty when inline
+    std::string data;   // Encoded payload for payload_blobs; empty when inline
+
+    bool Inline() const { return hash.empty(); }
+};
+
+/**
+ * Distinct blobs of a batch of StoredPayloads, as bytea[] array literals
+ * for a payload_blobs insert (each hash once, so ON CONFLICT never meets
+ * a row twice in one statement)
+ */
+struct PayloadBlobs {
+    void Add(const StoredPayload& payload);
+    std::string Hashes() const;
+    std::string Data() const;
+    bool Empty() const { return hashes_.empty(); }
+
+private:
+    std::vector<std::string> hashes_;
+    std::vector<std::string> data_;
+};
+
+/**
+ * CTE for the queues' insert statements storing the blobs bound at
+ * `hashes` and `data` (PayloadBlobs::Hashes() and Data()). A body already
+ * stored is only touched, at most hourly, which is what keeps it from
+ * QueuePartitionMaintainer's blob purge.
+ */
+#define PAYLOAD_BLOBS_CTE(hashes, data) \
+    "stored_blobs AS (" \
+    "  INSERT INTO payload_blobs AS b (hash, data, last_used_at) " \
+    "  SELECT hash, data, NOW() FROM unnest(" hashes "::bytea[], " data "::bytea[]) AS t(hash, data) " \
+    "  ON CONFLICT (hash) DO UPDATE SET last_used_at = NOW() " \
+    "  WHERE b.last_used_at < NOW() - INTERVAL '1 hour' " \
+    "  RETURNING 1" \
+    ")"
+
+/**
+ * Encoding of large queued bodies (webhook payloads, email HTML/text)
+ *
+ * Bodies of min_size bytes or more are stored once in payload_blobs,
+ * keyed by the SHA-256 of their content, and deflated there: fan-out and
+ * campaign sends of the same body share one compressed row however many
+ * deliveries reference it, and the queue rows (rewritten on every claim,
+ * retry and completion) stay small, which is what bounds WAL volume.
+ *
+ * Encoded form: a zlib stream (first byte 0x78), or 0x00 followed by the
+ * raw bytes when deflate does not help. A stream may use a preset
+ * dictionary trained for its scope ("webhook:<event_type>",
+ * "email:<template_id>"); zlib records the dictionary's Adler-32 in the
+ * stream header, so Decode() finds it in payload_dictionaries by that id
+ * whichever replica trained it. With dictionary_samples set, the first
+ * that many payloads of a scope are sampled, a dictionary is trained from
+ * them and stored, and later payloads of the scope use it.
+ *
+ * Thread-safe. Dictionaries are loaded lazily, so constructing one needs
+ * no database round trip.
+ *
+ * Usage:
+ *   PayloadCodec codec(db_pool, PayloadCodecOptions::FromEnv());
+ *   StoredPayload stored = codec.Store(payload, "webhook:" + event_type);
+ *   ... ExecPrepared(txn, kInsert, stored.text, stored.hash, ...);
+ *   std::string payload = codec.DecodeBytea(row["payload_data"].c_str());
+ */
+class PayloadCodec {
+public:
+    static constexpr size_t MAX_DICTIONARY_SIZE = 32768;   // zlib's window
+
+    /// db_pool may be null (no stored dictionaries, e.g. tests)
+    explicit PayloadCodec(std::shared_ptr<DbPool> db_pool, const PayloadCodecOptions& options = {});
+
+    /// Prepare payload for its row; scope selects the dictionary
+    StoredPayload Store(std::string_view payload, const std::string& scope);
+
+    /// Encoded bytes of payload (deflated, with scope's dictionary if it has one)
+    std::string Encode(std::string_view payload, const std::string& scope);
+
+    /**
+     * Payload from its encoded bytes
+     *
+     * @throws std::runtime_error if the bytes are corrupt or name a dictionary that is not stored
+     */
+    std::string Decode(std::string_view encoded);
+
+    /// Decode() of a bytea column's text output ("\x<hex>")
+    std::string DecodeBytea(std::string_view bytea);
+
+    /// Use dictionary for scope's payloads from now on (also kept for decoding)
+    void AddDictionary(const std::string& scope, std::string dictionary);
+
+    /// Dictionaries known to this process
+    size_t Dictionaries() const;
+
+    /**
+     * Build a preset dictionary from sample payloads
+     *
+     * Keeps fragments that recur across samples, the most common last
+     * (deflate reaches the end of the dictionary with the shortest
+     * distances), up to max_size bytes.
+     *
+     * @return Empty if nothing recurs
+     */
+    static std::string TrainDictionary(const std::vector<std::string>& samples,
+                                       size_t max_size = MAX_DICTIONARY_SIZE);
+
+    /// Id zlib records for dictionary (its Adler-32)
+    static uint32_t DictionaryId(std::string_view dictionary);
+
+    /// bytea input literal of bytes ("\x<hex>")
+    static std::string ToBytea(std::string_view bytes);
+
+    /// Bytes of a bytea column's hex output
+    /// @throws std::runtime_error if text is not "\x" followed by hex digits
+    static std::string FromBytea(std::string_view text);
+
+private:
+    // Dictionary for scope, or null; loads the stored dictionaries on first use
+    std::shared_ptr<const std::string> ScopeDictionary(const std::string& scope);
+    // Dictionary with id, or null; an unknown id reloads at most once per reload_interval
+    std::shared_ptr<const std::string> FindDictionary(uint32_t id);
+    // Record payload as a training sample of scope; trains once enough are in
+    void Sample(std::string_view payload, const std::string& scope);
+    void TrainScope(const std::string& scope, std::vector<std::string> samples);
+    void LoadDictionaries();
+
+    std::shared_ptr<DbPool> db_pool_;
+    PayloadCodecOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, std::shared_ptr<const std::string>> by_id_;
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> by_scope_;
+    std::map<std::string, std::vector<std::string>> sampling_;   // Scope -> samples so far
+    std::optional<std::chrono::steady_clock::time_point> loaded_at_;   // Last load attempt
+    bool loaded_ = false;
+};
+
+} // namespace common
+} // namespace saasforge
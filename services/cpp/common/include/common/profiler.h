@@ -0,0 +1,115 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description On-demand CPU and heap profiles (gperftools, jemalloc) in pprof-readable formats
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Profiling endpoint options (served by MetricsServer)
+ *
+ * FromEnv() reads PROFILING_TOKEN (empty = endpoints disabled) and
+ * PROFILING_MAX_SECONDS.
+ */
+struct ProfilingOptions {
+    std::string token;                          // Bearer token required by /debug/pprof/*
+    std::chrono::seconds default_cpu_duration{30};
+    std::chrono::seconds max_cpu_duration{120};
+
+    static ProfilingOptions FromEnv();
+};
+
+/**
+ * Thrown when the profile kind is not available in this build / process;
+ * the endpoint answers 501
+ */
+class ProfilerUnavailable : public std::runtime_error {
+public:
+    explicit ProfilerUnavailable(const std::string& what) : std::runtime_error(what) {}
+};
+
+/**
+ * Thrown when a CPU profile is already being taken; the endpoint answers 409
+ */
+class ProfilerBusy : public std::runtime_error {
+public:
+    ProfilerBusy() : std::runtime_error("A CPU profile is already in progress") {}
+};
+
+/**
+ * Time-boxed CPU profiles and heap snapshots
+ *
+ * Nothing runs until a profile is requested: the CPU profiler's SIGPROF
+ * timer is only armed for the duration of CpuProfile(), and heap snapshots
+ * read the allocator's existing allocation sample. This is what makes it
+ * safe to leave compiled into release builds.
+ *
+ * Backends of Default():
+ *   CPU   gperftools libprofiler (ProfilerStart/ProfilerStop), legacy
+ *         CPU profile format; sampling rate from CPUPROFILE_FREQUENCY
+ *         (default 100 Hz)
+ *   Heap  jemalloc prof.dump (needs MALLOC_CONF=prof:true,lg_prof_sample:19,
+ *         ~512 KiB sampling), else tcmalloc's heap sample (needs
+ *         TCMALLOC_SAMPLE_PARAMETER=524288)
+ *
+ * Both formats are read by pprof directly, e.g.
+ *   pprof -http=: ./auth_service cpu.prof
+ *   pprof -proto ./auth_service heap.prof > heap.pb.gz
+ *
+ * A backend is available if its library is linked (SAASFORGE_GPERFTOOLS,
+ * SAASFORGE_ALLOCATOR in CMake) or, for the C entry points, preloaded
+ * (LD_PRELOAD): they are resolved as weak symbols.
+ */
+class Profiler {
+public:
+    /// Profile sources; an empty name marks the kind unavailable
+    struct Backend {
+        std::string cpu_name;
+        std::function<bool(const std::string& path)> start_cpu;   // Start writing samples to `path`
+        std::function<void()> stop_cpu;                           // Stop and flush `path`
+        std::string heap_name;
+        std::function<std::string()> heap_profile;
+    };
+
+    explicit Profiler(Backend backend);
+
+    /// Process-wide profiler over whatever is linked or preloaded
+    static Profiler& Default();
+
+    bool CpuAvailable() const { return !backend_.cpu_name.empty(); }
+    bool HeapAvailable() const { return !backend_.heap_name.empty(); }
+    const std::string& CpuBackend() const { return backend_.cpu_name; }
+    const std::string& HeapBackend() const { return backend_.heap_name; }
+
+    /**
+     * Profile all threads for `duration` and return the profile
+     *
+     * @param cancelled Polled while waiting; ends the profile early when it returns true
+     * @throws ProfilerUnavailable, ProfilerBusy, or std::runtime_error if the profiler fails
+     */
+    std::string CpuProfile(std::chrono::milliseconds duration, const std::function<bool()>& cancelled = {});
+
+    /**
+     * Snapshot of sampled live allocations
+     *
+     * @throws ProfilerUnavailable, or std::runtime_error if the allocator fails
+     */
+    std::string HeapProfile();
+
+private:
+    Backend backend_;
+    std::mutex cpu_mutex_;    // One CPU profile at a time (the profiler is process-wide)
+};
+
+} // namespace common
+} // namespace saasforge
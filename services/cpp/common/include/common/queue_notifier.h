@@ -0,0 +1,109 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description LISTEN/NOTIFY wakeups for database-backed work queues
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * QueueNotifier options
+ *
+ * FromEnv() reads QUEUE_NOTIFY_RECONNECT_DELAY_MS and
+ * QUEUE_NOTIFY_FALLBACK_POLL_MS.
+ */
+struct QueueNotifierOptions {
+    std::chrono::milliseconds reconnect_delay{1000};   // Backoff after the listener connection drops
+    std::chrono::milliseconds fallback_poll{30000};    // Max sleep between polls (lost NOTIFY safety net)
+
+    static QueueNotifierOptions FromEnv();
+};
+
+/**
+ * Wakes queue consumers when rows are enqueued
+ *
+ * Holds one dedicated (non-pooled) connection that LISTENs on the given
+ * channels; EmailQueue::Enqueue and WebhookDelivery::QueueDelivery emit
+ * pg_notify in the enqueue transaction, so consumers wake as soon as the
+ * row is committed instead of polling. Each channel has a generation
+ * counter: read it before polling, and WaitForChange() returns immediately
+ * if a notification arrived in between, so no wakeup is lost.
+ *
+ * If the listener connection drops, every channel is bumped after
+ * reconnecting (notifications sent while disconnected are gone).
+ *
+ * Usage:
+ *   auto notifier = std::make_shared<QueueNotifier>(db_url,
+ *       std::vector<std::string>{EmailQueue::NOTIFY_CHANNEL});
+ *   EmailQueue queue(db_pool, notifier);
+ *   auto batch = queue.WaitForBatch(10, std::chrono::seconds(30));
+ */
+class QueueNotifier {
+public:
+    QueueNotifier(
+        const std::string& connection_string,
+        const std::vector<std::string>& channels,
+        const QueueNotifierOptions& options = {}
+    );
+    ~QueueNotifier();
+
+    QueueNotifier(const QueueNotifier&) = delete;
+    QueueNotifier& operator=(const QueueNotifier&) = delete;
+
+    /**
+     * Current generation of a channel (incremented on every notification)
+     *
+     * @throws std::invalid_argument if the channel is not listened on
+     */
+    uint64_t Generation(const std::string& channel) const;
+
+    /**
+     * Block until the channel moves past `seen` or the timeout elapses
+     *
+     * @param channel Channel name
+     * @param seen Generation read before the caller last polled
+     * @param timeout Maximum wait
+     * @return True if a notification arrived
+     */
+    bool WaitForChange(const std::string& channel, uint64_t seen, std::chrono::milliseconds timeout);
+
+    /// Whether the listener connection is currently up
+    bool Connected() const { return connected_.load(); }
+
+    const QueueNotifierOptions& Options() const { return options_; }
+
+    void Shutdown();
+
+private:
+    void ListenLoop();
+    void Bump(const std::string& channel);
+    void BumpAll();
+
+    std::string connection_string_;
+    std::vector<std::string> channels_;
+    QueueNotifierOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<std::string, uint64_t> generations_;
+
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> shutdown_{false};
+    std::thread listener_thread_;
+};
+
+} // namespace common
+} // namespace saasforge
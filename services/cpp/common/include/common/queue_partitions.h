@@ -0,0 +1,104 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Background creation and pruning of the delivery queues' daily partitions
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include "common/executor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * QueuePartitionMaintainer options
+ *
+ * FromEnv() reads QUEUE_RETENTION_DAYS, QUEUE_PARTITION_PREMAKE_DAYS and
+ * QUEUE_MAINTENANCE_INTERVAL_S.
+ */
+struct QueuePartitionOptions {
+    int retention_days = 7;                 // Terminal rows kept this many UTC days
+    int premake_days = 3;                   // Daily partitions created ahead of today
+    std::chrono::seconds interval{3600};
+
+    static QueuePartitionOptions FromEnv();
+};
+
+/**
+ * Outcome of one maintenance pass over a queue
+ */
+struct PartitionMaintenance {
+    int created = 0;        // Daily partitions added
+    int dropped = 0;        // Daily partitions past retention
+    int64_t purged = 0;     // Rows past retention deleted from the default partition
+    int64_t blobs_purged = 0;   // payload_blobs rows no queue row can reference any more
+};
+
+/**
+ * Keeps a partitioned delivery queue's terminal rows bounded
+ *
+ * email_queue and webhook_deliveries are LIST-partitioned on status: a
+ * small <queue>_active partition that the claim statements read, and
+ * <queue>_done with one partition per UTC day (migration c9e4b1f7a260).
+ * This calls queue_maintain_partitions() for each queue on start and then
+ * every interval, so tomorrow's partition always exists and days older
+ * than the retention are dropped whole instead of deleted and vacuumed.
+ * The function serializes instances with an advisory lock; a pass that
+ * fails (e.g. its lock_timeout expires) is retried on the next interval.
+ * Each pass also deletes the payload_blobs (see PayloadCodec) untouched
+ * for longer than any queue row referencing them can live. Passes run on
+ * Executor::Background().
+ *
+ * Usage:
+ *   QueuePartitionMaintainer maintainer(db_pool, {"email_queue", "webhook_deliveries"},
+ *                                       QueuePartitionOptions::FromEnv());
+ */
+class QueuePartitionMaintainer {
+public:
+    /// One pass over one queue
+    using Step = std::function<PartitionMaintenance(const std::string& queue, const QueuePartitionOptions& options)>;
+
+    QueuePartitionMaintainer(std::shared_ptr<DbPool> db_pool, std::vector<std::string> queues,
+                             const QueuePartitionOptions& options = {});
+    /// Custom step (tests)
+    QueuePartitionMaintainer(Step step, std::vector<std::string> queues, const QueuePartitionOptions& options = {});
+    ~QueuePartitionMaintainer();
+
+    QueuePartitionMaintainer(const QueuePartitionMaintainer&) = delete;
+    QueuePartitionMaintainer& operator=(const QueuePartitionMaintainer&) = delete;
+
+    /**
+     * Maintain every queue now
+     *
+     * @return False if any queue's pass failed (logged)
+     */
+    bool RunOnce();
+
+    /// Stop the periodic passes, waiting for one in progress (idempotent)
+    void Shutdown();
+
+    /// Passes that failed since start
+    uint64_t Failures() const { return failures_.load(); }
+
+private:
+    Step step_;
+    std::vector<std::string> queues_;
+    QueuePartitionOptions options_;
+
+    std::mutex run_mutex_;      // One pass at a time
+    std::atomic<uint64_t> failures_{0};
+    uint64_t periodic_ = 0;     // Executor::Background() task
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,188 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Atomic per-tenant storage quota reservations with write-behind to Postgres
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include "common/redis_client.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * QuotaLedger options
+ *
+ * FromEnv() reads QUOTA_COUNTER_TTL_S, QUOTA_LOCAL_TTL_MS and
+ * QUOTA_FLUSH_INTERVAL_MS.
+ */
+struct QuotaLedgerOptions {
+    std::chrono::seconds counter_ttl{3600};          // Redis counter is reseeded from Postgres after this
+    std::chrono::milliseconds local_ttl{2000};       // How long a known headroom rejects locally
+    std::chrono::milliseconds flush_interval{1000};
+
+    static QuotaLedgerOptions FromEnv();
+};
+
+/**
+ * Bytes counted against a tenant and its limit
+ */
+struct QuotaUsage {
+    int64_t used = 0;
+    int64_t limit = 0;
+};
+
+/**
+ * Result of one counter reservation
+ */
+struct QuotaReservation {
+    bool granted = false;
+    int64_t headroom = 0;    // limit - used after the call
+};
+
+/**
+ * Storage behind QuotaLedger (Redis counters, Postgres quotas by default)
+ */
+struct QuotaLedgerBackend {
+    /// Add bytes to the counter if it stays within the limit; nullopt if the counter is not seeded
+    std::function<std::optional<QuotaReservation>(const std::string& tenant_id, int64_t bytes)> reserve;
+    /// Create the counter unless another instance already did
+    std::function<void(const std::string& tenant_id, const QuotaUsage& usage, std::chrono::seconds ttl)> seed;
+    /// Subtract bytes from the counter if it exists
+    std::function<void(const std::string& tenant_id, int64_t bytes)> release;
+    /// Current usage from Postgres: completed bytes plus recent pending uploads
+    std::function<QuotaUsage(const std::string& tenant_id)> load;
+    /// Add used_bytes deltas to the quotas table in one statement
+    std::function<void(const std::vector<std::pair<std::string, int64_t>>& deltas)> flush;
+
+    static QuotaLedgerBackend Default(std::shared_ptr<RedisClient> redis, std::shared_ptr<DbPool> db_pool);
+};
+
+struct QuotaLedgerStats {
+    uint64_t granted = 0;
+    uint64_t rejected = 0;          // By the counter
+    uint64_t rejected_locally = 0;  // From cached headroom, no network call
+    uint64_t seeded = 0;            // Counters loaded from Postgres
+    uint64_t fallbacks = 0;         // Redis unavailable: checked against Postgres directly
+    uint64_t failed_flushes = 0;
+    size_t pending_tenants = 0;     // Tenants with deltas not yet in quotas
+};
+
+/**
+ * Tenant storage quota with atomic reservations
+ *
+ * Reserve() is a single Lua call that adds the bytes to the tenant's Redis
+ * counter only if it stays within the limit, so concurrent uploads cannot
+ * overshoot and the check costs one round trip. The counter holds completed
+ * bytes plus reservations of uploads still in progress; it is seeded from
+ * Postgres on first use and expires after counter_ttl, which bounds how
+ * long an abandoned upload's reservation, or a changed limit, goes unseen.
+ *
+ * The headroom returned by each call is cached locally for local_ttl, and a
+ * request larger than the cached headroom is rejected without any network
+ * call. Release() drops the tenant's cached entry so freed space is usable
+ * at once.
+ *
+ * Bytes that finished uploading are recorded with Commit() and added to
+ * quotas.used_bytes by a background flush every flush_interval, one
+ * statement for all tenants. If Redis is unreachable, Reserve() falls back
+ * to a (non-atomic) check against Postgres.
+ *
+ * Usage:
+ *   QuotaLedger quota(redis, db_pool, QuotaLedgerOptions::FromEnv());
+ *   if (!quota.Reserve(tenant_id, size)) { ... RESOURCE_EXHAUSTED ... }
+ *   quota.Commit(tenant_id, size);   // upload completed
+ *   quota.Release(tenant_id, size);  // upload deleted or abandoned
+ */
+class QuotaLedger {
+public:
+    QuotaLedger(std::shared_ptr<RedisClient> redis, std::shared_ptr<DbPool> db_pool,
+                const QuotaLedgerOptions& options = {});
+
+    /// Custom backend (tests)
+    QuotaLedger(QuotaLedgerBackend backend, const QuotaLedgerOptions& options = {});
+
+    ~QuotaLedger();
+
+    QuotaLedger(const QuotaLedger&) = delete;
+    QuotaLedger& operator=(const QuotaLedger&) = delete;
+
+    /**
+     * Reserve bytes for an upload
+     *
+     * @return False if the tenant would exceed its limit
+     * @throws std::invalid_argument for non-positive bytes
+     * @throws std::exception if neither Redis nor Postgres can be reached
+     */
+    bool Reserve(const std::string& tenant_id, int64_t bytes);
+
+    /// Return reserved or stored bytes to the tenant's headroom (best effort)
+    void Release(const std::string& tenant_id, int64_t bytes);
+
+    /// Record a change in stored bytes for the next flush to quotas.used_bytes
+    void Commit(const std::string& tenant_id, int64_t bytes);
+
+    /**
+     * Flush committed deltas now
+     *
+     * @return True if nothing is left pending
+     */
+    bool Flush();
+
+    /// Stop the flush thread after a final flush (idempotent)
+    void Shutdown();
+
+    /// Called after each successful flush with the tenants whose used_bytes changed
+    void OnFlushed(std::function<void(const std::vector<std::string>& tenant_ids)> listener);
+
+    QuotaLedgerStats GetStats() const;
+
+private:
+    struct Headroom {
+        int64_t bytes = 0;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::optional<QuotaReservation> ReserveInCounter(const std::string& tenant_id, int64_t bytes);
+    void CacheHeadroom(const std::string& tenant_id, int64_t headroom);
+    void FlushLoop();
+
+    QuotaLedgerBackend backend_;
+    QuotaLedgerOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Headroom> headroom_;
+    std::unordered_map<std::string, int64_t> deltas_;   // Committed, not yet flushed
+
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    std::function<void(const std::vector<std::string>&)> on_flushed_;   // Guarded by flush_mutex_
+
+    std::atomic<uint64_t> granted_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> rejected_locally_{0};
+    std::atomic<uint64_t> seeded_{0};
+    std::atomic<uint64_t> fallbacks_{0};
+    std::atomic<uint64_t> failed_flushes_{0};
+
+    std::atomic<bool> shutdown_{false};
+    std::thread flush_thread_;
+};
+
+} // namespace common
+} // namespace saasforge
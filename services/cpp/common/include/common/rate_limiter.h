@@ -0,0 +1,141 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Redis-backed rate limiter (token bucket / sliding window log)
+ */
+
+#pragma once
+
+#include "common/redis_client.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace saasforge {
+namespace common {
+
+enum class RateLimitAlgorithm {
+    TOKEN_BUCKET,       // Smooth refill of `limit` tokens per window; allows bursts up to limit
+    SLIDING_WINDOW_LOG  // Exact: at most `limit` hits in any trailing window
+};
+
+/**
+ * Rate limit policy
+ */
+struct RateLimitPolicy {
+    RateLimitAlgorithm algorithm = RateLimitAlgorithm::SLIDING_WINDOW_LOG;
+    int64_t limit = 10;                      // Hits per window (token bucket: capacity)
+    std::chrono::milliseconds window{60000};  // Token bucket: time to refill from empty
+
+    // Local pre-filter. The first local_allowance hits per key per window are
+    // admitted in-process and charged to Redis with the next remote check, at
+    // window rollover or by the next flush, whichever comes first, so the
+    // global count lags by at most flush_interval. Keep it 0 for brute-force
+    // limits (login, OTP): those must meter every attempt.
+    int64_t local_allowance = 0;             // 0 = every hit goes to Redis
+    std::chrono::milliseconds flush_interval{1000};  // Background flush (0 = only Flush())
+    bool cache_denials = true;               // Deny locally until retry_after elapses
+    size_t max_local_keys = 100000;
+};
+
+/**
+ * Result of RateLimiter::Check()
+ */
+struct RateLimitDecision {
+    bool allowed = true;
+    int64_t remaining = 0;                 // Hits left (local decisions: local allowance left)
+    std::chrono::milliseconds retry_after{0};
+    bool local = false;                    // Decided without a Redis round trip
+};
+
+/**
+ * Rate limiter shared by all services
+ *
+ * Each remote check is a single Lua script call (EVALSHA) that reads Redis
+ * TIME, updates the bucket or log and returns the decision, so concurrent
+ * callers on any replica see a consistent count and the window is never
+ * reset by a hit.
+ *
+ * Usage:
+ *   RateLimitPolicy policy;
+ *   policy.limit = 3;
+ *   policy.window = std::chrono::seconds(60);
+ *   RateLimiter limiter(redis_client, "otp", policy);
+ *   if (!limiter.Check(email).allowed) { ... }
+ */
+class RateLimiter {
+public:
+    /**
+     * @param redis Redis client
+     * @param name Limiter name, part of the Redis key ("ratelimit:<name>:<key>")
+     * @param policy Limit, window and algorithm
+     */
+    RateLimiter(std::shared_ptr<RedisClient> redis, const std::string& name, const RateLimitPolicy& policy);
+    ~RateLimiter();
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /**
+     * Record one hit for key and decide whether it is allowed
+     *
+     * @throws sw::redis::Error if Redis is unreachable (callers choose fail-open/closed)
+     */
+    RateLimitDecision Check(const std::string& key);
+
+    /**
+     * Charge every locally admitted hit to Redis now
+     *
+     * Runs every flush_interval on a background thread when local_allowance > 0.
+     *
+     * @return Number of hits charged
+     * @throws sw::redis::Error if Redis is unreachable; the hits stay pending
+     */
+    int64_t Flush();
+
+    const RateLimitPolicy& Policy() const { return policy_; }
+
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+
+    struct LocalState {
+        std::chrono::steady_clock::time_point window_start;
+        std::chrono::steady_clock::time_point denied_until;
+        int64_t local_hits = 0;  // Admitted locally in the current window
+        int64_t pending = 0;     // Admitted locally, not yet charged to Redis
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, LocalState> states;
+    };
+
+    // hit = false only charges pending (Flush())
+    RateLimitDecision CheckRemote(const std::string& key, int64_t pending, bool hit = true);
+    void FlushLoop();
+    Shard& ShardFor(const std::string& key);
+    void EvictStale(Shard& shard, std::chrono::steady_clock::time_point now);
+    bool UsesLocalState() const { return policy_.local_allowance > 0 || policy_.cache_denials; }
+
+    std::shared_ptr<RedisClient> redis_;
+    std::string key_prefix_;
+    RateLimitPolicy policy_;
+
+    std::string instance_id_;                // Makes sliding-log members unique across replicas
+    std::atomic<uint64_t> next_member_{0};
+    std::array<Shard, NUM_SHARDS> shards_;
+
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    bool stopping_ = false;
+    std::thread flush_thread_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,323 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Column-oriented batches of queue records with an arena for their text
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+namespace record_batch_detail {
+
+template <typename T>
+struct MemberTraits;
+
+template <typename R, typename V>
+struct MemberTraits<V R::*> {
+    using Record = R;
+    using Value = V;
+};
+
+template <auto A, auto B>
+constexpr bool SameMember() {
+    if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+        return A == B;
+    } else {
+        return false;
+    }
+}
+
+} // namespace record_batch_detail
+
+/**
+ * A string column's value: a slice of its batch's text buffer
+ */
+struct TextRef {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+/**
+ * Rows of Record stored column by column
+ *
+ * Each member listed in Members gets one contiguous column: numbers and
+ * enums as themselves, strings as a TextRef into a single text buffer
+ * shared by the batch. A claim of N rows costs two allocations (columns
+ * and text, both sized up front by RowMapping::ReadAll) instead of one
+ * per string per row, and a loop over one field reads one dense array.
+ *
+ * Rows are read through Row views (Get<&Record::member>()); ToRecord()
+ * and ToVector() materialize records for code that keeps them. Members
+ * of Record not listed are left default-constructed there.
+ *
+ * string_views returned by Get() point into the batch and are invalidated
+ * by the next AddRow() or Set() of a string column, and by destruction.
+ *
+ * Usage:
+ *   using DeliveryBatch = RecordBatch<Delivery, &Delivery::id, &Delivery::url, &Delivery::retry_count>;
+ *   for (const auto& row : batch) {
+ *       if (row.Get<&Delivery::retry_count>() > 3) ...
+ *       pending.push_back(row.ToRecord());
+ *   }
+ */
+template <typename Record, auto... Members>
+class RecordBatch {
+    static_assert(sizeof...(Members) > 0, "a record batch needs at least one column");
+    static_assert((std::is_same_v<typename record_batch_detail::MemberTraits<decltype(Members)>::Record, Record> &&
+                   ...),
+                  "batched members belong to the record");
+
+    template <size_t I>
+    using Value = std::tuple_element_t<I, std::tuple<typename record_batch_detail::MemberTraits<decltype(Members)>::Value...>>;
+
+    template <size_t I>
+    using Stored = std::conditional_t<std::is_same_v<Value<I>, std::string>, TextRef, Value<I>>;
+
+    template <auto Member>
+    static constexpr size_t IndexOf() {
+        constexpr bool matches[] = {record_batch_detail::SameMember<Member, Members>()...};
+        for (size_t i = 0; i < sizeof...(Members); ++i) {
+            if (matches[i]) {
+                return i;
+            }
+        }
+        return sizeof...(Members);
+    }
+
+    template <auto Member>
+    static constexpr size_t Index() {
+        constexpr size_t index = IndexOf<Member>();
+        static_assert(index < sizeof...(Members), "member is not a column of this batch");
+        return index;
+    }
+
+public:
+    static constexpr size_t COLUMNS = sizeof...(Members);
+
+    /// One row of the batch; cheap to copy, valid while the batch is
+    class Row {
+    public:
+        Row(const RecordBatch* batch, size_t index) : batch_(batch), index_(index) {}
+
+        /// std::string_view for string members, the value otherwise
+        template <auto Member>
+        auto Get() const {
+            return batch_->template Get<Member>(index_);
+        }
+
+        Record ToRecord() const { return batch_->ToRecord(index_); }
+        size_t Index() const { return index_; }
+
+    private:
+        const RecordBatch* batch_;
+        size_t index_;
+    };
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Row;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Row;
+
+        Iterator(const RecordBatch* batch, size_t index) : batch_(batch), index_(index) {}
+
+        Row operator*() const { return Row(batch_, index_); }
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const RecordBatch* batch_;
+        size_t index_;
+    };
+
+    RecordBatch() = default;
+    RecordBatch(RecordBatch&&) noexcept = default;
+    RecordBatch& operator=(RecordBatch&&) noexcept = default;
+
+    RecordBatch(const RecordBatch& other) { *this = other; }
+    RecordBatch& operator=(const RecordBatch& other) {
+        if (this != &other) {
+            size_ = 0;
+            Reserve(other.size_, other.text_.size());
+            size_ = other.size_;
+            CopyColumns(other, std::index_sequence_for<decltype(Members)...>{});
+            text_ = other.text_;
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /// Bytes of text held for the batch's string columns
+    size_t TextBytes() const { return text_.size(); }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size_); }
+    Row operator[](size_t index) const { return Row(this, index); }
+
+    /// Room for `rows` rows and `text_bytes` of text without reallocating
+    void Reserve(size_t rows, size_t text_bytes = 0) {
+        if (rows > capacity_) {
+            Relocate(rows, std::index_sequence_for<decltype(Members)...>{});
+        }
+        text_.reserve(text_bytes);
+    }
+
+    /// Append a row with every column zero (empty strings); returns its index
+    size_t AddRow() {
+        if (size_ == capacity_) {
+            Reserve(capacity_ == 0 ? 16 : capacity_ * 2, text_.capacity());
+        }
+        ZeroRow(size_, std::index_sequence_for<decltype(Members)...>{});
+        return size_++;
+    }
+
+    /// Append record's batched members; returns the row's index
+    size_t Append(const Record& record) {
+        size_t index = AddRow();
+        (Set<Members>(index, record.*Members), ...);
+        return index;
+    }
+
+    template <auto Member>
+    auto Get(size_t index) const {
+        constexpr size_t I = Index<Member>();
+        const auto& stored = ColumnData<I>()[index];
+        if constexpr (std::is_same_v<Stored<I>, TextRef>) {
+            return std::string_view(text_.data() + stored.offset, stored.length);
+        } else {
+            return stored;
+        }
+    }
+
+    /**
+     * Set one row's member; a string is appended to the text buffer
+     *
+     * @throws std::length_error if the batch's text would pass 4 GiB
+     */
+    template <auto Member, typename V>
+    void Set(size_t index, const V& value) {
+        constexpr size_t I = Index<Member>();
+        auto& stored = ColumnData<I>()[index];
+        if constexpr (std::is_same_v<Stored<I>, TextRef>) {
+            std::string_view text(value);
+            if (text_.size() + text.size() > UINT32_MAX) {
+                throw std::length_error("Record batch text exceeds 4 GiB");
+            }
+            stored.offset = static_cast<uint32_t>(text_.size());
+            stored.length = static_cast<uint32_t>(text.size());
+            text_.append(text);
+        } else {
+            stored = static_cast<Value<I>>(value);
+        }
+    }
+
+    /// Row `index` as a record
+    Record ToRecord(size_t index) const {
+        Record record{};
+        (Assign<Members>(index, record), ...);
+        return record;
+    }
+
+    /// Every row as a record, for the std::vector APIs
+    std::vector<Record> ToVector() const {
+        std::vector<Record> records;
+        records.reserve(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            records.push_back(ToRecord(i));
+        }
+        return records;
+    }
+
+    /// Drop every row, keeping the allocations
+    void Clear() {
+        size_ = 0;
+        text_.clear();
+    }
+
+private:
+    static constexpr size_t ALIGN = 8;
+
+    template <size_t... I>
+    static constexpr bool FixedWidth(std::index_sequence<I...>) {
+        return ((std::is_trivially_copyable_v<Stored<I>> && alignof(Stored<I>) <= ALIGN) && ...);
+    }
+    static_assert(FixedWidth(std::index_sequence_for<decltype(Members)...>{}),
+                  "batched members are strings, numbers or enums");
+
+    static size_t ColumnBytes(size_t rows, size_t width) {
+        return (rows * width + ALIGN - 1) / ALIGN * ALIGN;
+    }
+
+    template <size_t I>
+    Stored<I>* ColumnData() const {
+        return reinterpret_cast<Stored<I>*>(columns_.get() + offsets_[I]);
+    }
+
+    template <size_t... I>
+    void Relocate(size_t capacity, std::index_sequence<I...>) {
+        std::array<size_t, COLUMNS> offsets{};
+        size_t bytes = 0;
+        ((offsets[I] = bytes, bytes += ColumnBytes(capacity, sizeof(Stored<I>))), ...);
+
+        std::unique_ptr<unsigned char[]> columns(new unsigned char[bytes]);
+        if (size_ > 0) {
+            (std::memcpy(columns.get() + offsets[I], columns_.get() + offsets_[I], size_ * sizeof(Stored<I>)), ...);
+        }
+        columns_ = std::move(columns);
+        offsets_ = offsets;
+        capacity_ = capacity;
+    }
+
+    template <size_t... I>
+    void ZeroRow(size_t index, std::index_sequence<I...>) {
+        ((ColumnData<I>()[index] = Stored<I>{}), ...);
+    }
+
+    template <size_t... I>
+    void CopyColumns(const RecordBatch& other, std::index_sequence<I...>) {
+        if (size_ > 0) {
+            (std::memcpy(ColumnData<I>(), other.template ColumnData<I>(), size_ * sizeof(Stored<I>)), ...);
+        }
+    }
+
+    template <auto Member>
+    void Assign(size_t index, Record& record) const {
+        if constexpr (std::is_same_v<Stored<Index<Member>()>, TextRef>) {
+            record.*Member = std::string(Get<Member>(index));
+        } else {
+            record.*Member = Get<Member>(index);
+        }
+    }
+
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    std::unique_ptr<unsigned char[]> columns_;    // Column I at offsets_[I], capacity_ entries each
+    std::array<size_t, COLUMNS> offsets_{};
+    std::string text_;
+};
+
+} // namespace common
+} // namespace saasforge
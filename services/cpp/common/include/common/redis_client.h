@@ -1,31 +1,411 @@
 #pragma once
 
+#include <array>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <optional>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <sw/redis++/redis++.h>
+#include "common/redis_client_cache.h"
+#include "common/resilience.h"
 
 namespace saasforge {
 namespace common {
 
+/**
+ * Redis deployment a RedisClient connects to
+ */
+enum class RedisMode {
+    STANDALONE,   // The connection string's node
+    CLUSTER,      // Redis Cluster; the connection string names a seed node
+    SENTINEL      // Master of a Sentinel-monitored group, followed across failovers
+};
+
+/**
+ * Redis connection pool options
+ *
+ * FromEnv() reads REDIS_MODE (standalone, cluster or sentinel),
+ * REDIS_SENTINELS (host:port, comma-separated), REDIS_SENTINEL_MASTER,
+ * REDIS_POOL_SIZE, REDIS_POOL_WAIT_TIMEOUT_MS, REDIS_CONNECT_TIMEOUT_MS,
+ * REDIS_SOCKET_TIMEOUT_MS, REDIS_CLIENT_CACHE_ENTRIES,
+ * REDIS_CLIENT_CACHE_MAX_AGE_MS, REDIS_CLIENT_CACHE_PREFIXES
+ * (comma-separated) and the REDIS_BREAKER_* / REDIS_LIMIT_* settings of
+ * DependencyOptions::FromEnv("REDIS").
+ *
+ * @throws std::invalid_argument on an unknown REDIS_MODE or a sentinel mode
+ *         without sentinels
+ */
+struct RedisOptions {
+    RedisMode mode = RedisMode::STANDALONE;
+    // SENTINEL: where to find the master; password, db and timeouts still
+    // come from the connection string
+    std::vector<std::pair<std::string, int>> sentinels;
+    std::string sentinel_master = "mymaster";
+
+
+    size_t pool_size = 8;                              // redis++ defaults to a single connection
+    std::chrono::milliseconds pool_wait_timeout{100};  // Wait for a free connection (0 = forever)
+    std::chrono::milliseconds connect_timeout{1000};
+    std::chrono::milliseconds socket_timeout{1000};
+
+    // Client-side cache of IsTokenBlacklisted() and GetSession() (see
+    // common/redis_client_cache.h); 0 entries disables it. Needs Redis 6+;
+    // always off in CLUSTER mode, where tracking is per node.
+    // Prefixes must not overlap (CLIENT TRACKING BCAST rejects them).
+    size_t client_cache_entries = 10000;
+    std::chrono::milliseconds client_cache_max_age{60000};
+    std::vector<std::string> client_cache_prefixes{"blacklist:", "session:"};
+
+    // Circuit breaker and adaptive limit in front of every command (cache
+    // hits bypass them); zero limits are derived from pool_size
+    DependencyOptions resilience;
+
+    static RedisOptions FromEnv();
+};
+
+/**
+ * Outcome of RotateSession()
+ */
+enum class RotateResult {
+    ROTATED,   // Stored value matched and was replaced
+    MISSING,   // No value stored (expired or revoked)
+    MISMATCH   // A different value is stored; nothing was changed
+};
+
+/**
+ * An entry read from a stream (see RedisClient::StreamReadGroup)
+ */
+struct StreamMessage {
+    std::string id;        // "<ms>-<seq>"
+    std::string payload;   // Its "p" field
+};
+
+/**
+ * Redis access for the services: token blacklist, sessions, counters, Lua
+ * scripts and pub/sub
+ *
+ * Works against a standalone node, a Sentinel-managed master or a cluster
+ * (RedisOptions::mode). On a cluster every command and script routes by its
+ * key, so keys used together must share a slot: build them with a HashTag
+ * (common/string_builder.h). GetMany() and DeleteMany() fall back to one
+ * command per key when their keys span slots.
+ *
+ * Commands pass through a Dependency ("redis"): while its breaker is open,
+ * its concurrency limit is reached, or the current RPC's deadline has
+ * passed, they throw DependencyUnavailable at once instead of waiting for
+ * a socket timeout.
+ */
 class RedisClient {
 public:
-    RedisClient(const std::string& connection_string);
+    /// Channel on which BlacklistToken() announces newly blacklisted JTIs
+    static constexpr const char* BLACKLIST_CHANNEL = "token:blacklisted";
+
+    RedisClient(const std::string& connection_string, const RedisOptions& options = {});
+    ~RedisClient();
+
+    RedisClient(const RedisClient&) = delete;
+    RedisClient& operator=(const RedisClient&) = delete;
 
     // Token blacklist operations
-    void BlacklistToken(const std::string& jti, int64_t ttl_seconds);
-    bool IsTokenBlacklisted(const std::string& jti);
+    void BlacklistToken(std::string_view jti, int64_t ttl_seconds);
+
+    /// BlacklistToken() for several (jti, ttl_seconds) pairs with one pipelined round trip
+    void BlacklistTokens(const std::vector<std::pair<std::string, int64_t>>& tokens);
+    bool IsTokenBlacklisted(std::string_view jti);
+    std::vector<std::string> ScanBlacklistedTokens();
+
+    // Session management (GetSession is served from the client-side cache when enabled)
+    void SetSession(std::string_view session_id, std::string_view data, int64_t ttl_seconds);
+    std::optional<std::string> GetSession(std::string_view session_id);
+    void DeleteSession(std::string_view session_id);
+    /// Read and delete in one step: of concurrent callers, only one gets the value
+    std::optional<std::string> TakeSession(std::string_view session_id);
+
+    /**
+     * Store several sessions with one pipelined round trip
+     *
+     * @param sessions (session_id, data) pairs
+     * @param ttl_seconds TTL applied to every session
+     */
+    void SetSessionMany(
+        const std::vector<std::pair<std::string, std::string>>& sessions,
+        int64_t ttl_seconds
+    );
+
+    /**
+     * Atomically replace a session value if it still holds the expected one
+     *
+     * Compare-and-set in a single Lua call, so two concurrent rotations of
+     * the same refresh token cannot both succeed.
+     *
+     * @param session_id Session id
+     * @param expected_data Value the caller last read
+     * @param new_data Replacement value
+     * @param ttl_seconds TTL for the replacement
+     */
+    RotateResult RotateSession(
+        std::string_view session_id,
+        std::string_view expected_data,
+        std::string_view new_data,
+        int64_t ttl_seconds
+    );
+
+    /**
+     * Fetch several raw keys with one MGET
+     *
+     * @return One entry per key, in order; nullopt for missing keys
+     */
+    std::vector<std::optional<std::string>> GetMany(const std::vector<std::string>& keys);
+
+    /**
+     * Delete several raw keys with one DEL
+     *
+     * @return Number of keys removed
+     */
+    int64_t DeleteMany(const std::vector<std::string>& keys);
 
-    // Session management
-    void SetSession(const std::string& session_id, const std::string& data, int64_t ttl_seconds);
-    std::optional<std::string> GetSession(const std::string& session_id);
-    void DeleteSession(const std::string& session_id);
+    /// Fetch one raw key (served from the client-side cache when its prefix is tracked)
+    std::optional<std::string> Get(std::string_view key);
+
+    /// Store one raw key expiring after ttl
+    void SetWithTtl(std::string_view key, std::string_view value, std::chrono::milliseconds ttl);
 
     // Rate limiting
-    int64_t IncrementCounter(const std::string& key, int64_t ttl_seconds);
+    int64_t IncrementCounter(std::string_view key, int64_t ttl_seconds);
+
+    /**
+     * INCR a counter and set its TTL on first increment, in one round trip
+     *
+     * Runs as a Lua script so the counter can never be left without a TTL.
+     *
+     * @return Counter value after the increment
+     */
+    int64_t IncrementWithTtl(std::string_view key, int64_t ttl_seconds);
+
+    /**
+     * Store an integer if the key is missing or holds a smaller one
+     *
+     * Compare-and-set in a single Lua call, so of two concurrent callers
+     * with the same value only one succeeds (e.g. consuming a TOTP step).
+     *
+     * @param ttl_seconds TTL set when the value is stored
+     * @return True if the value was stored
+     */
+    bool SetIfGreater(std::string_view key, int64_t value, int64_t ttl_seconds);
+
+    /**
+     * Run a Lua script with EVALSHA, loading it on first use or after NOSCRIPT
+     *
+     * @param script Script source (also the key its SHA1 is cached under)
+     * @param keys KEYS[] passed to the script
+     * @param args ARGV[] passed to the script
+     * @return Integer reply (EvalScript), array of integers (EvalScriptArray),
+     *         bulk string, nullopt for nil (EvalScriptString) or array of
+     *         bulk strings, nullopt for nil entries (EvalScriptStrings)
+     */
+    long long EvalScript(
+        std::string_view script,
+        std::initializer_list<sw::redis::StringView> keys,
+        std::initializer_list<sw::redis::StringView> args
+    );
+    std::vector<long long> EvalScriptArray(
+        std::string_view script,
+        std::initializer_list<sw::redis::StringView> keys,
+        std::initializer_list<sw::redis::StringView> args
+    );
+    std::optional<std::string> EvalScriptString(
+        std::string_view script,
+        std::initializer_list<sw::redis::StringView> keys,
+        std::initializer_list<sw::redis::StringView> args
+    );
+    std::vector<std::optional<std::string>> EvalScriptStrings(
+        std::string_view script,
+        std::initializer_list<sw::redis::StringView> keys,
+        std::initializer_list<sw::redis::StringView> args
+    );
+    /// EvalScriptStrings for scripts whose KEYS[] count is only known at run time
+    std::vector<std::optional<std::string>> EvalScriptStringsVector(
+        std::string_view script,
+        const std::vector<std::string>& keys,
+        const std::vector<std::string>& args
+    );
+
+    // Pub/sub (cross-replica cache invalidation)
+    int64_t Publish(std::string_view channel, std::string_view message);
+
+    /**
+     * Subscribe to a channel on a background thread
+     *
+     * The listener reconnects after connection errors. on_subscribed runs each
+     * time the subscription is (re)established, so callers can drop state that
+     * may have missed messages while disconnected.
+     *
+     * @param channel Channel name
+     * @param handler Called with each message payload
+     * @param on_subscribed Optional callback invoked on every (re)subscribe
+     * @return Subscription id for Unsubscribe()
+     */
+    uint64_t Subscribe(
+        const std::string& channel,
+        std::function<void(const std::string&)> handler,
+        std::function<void()> on_subscribed = nullptr
+    );
+
+    /**
+     * Stop a subscription and wait for its listener thread to exit
+     *
+     * After this returns the handler is never invoked again, so owners of
+     * the handler's captured state call it from their destructor.
+     */
+    void Unsubscribe(uint64_t subscription_id);
+
+    // Streams (EventBus); entries carry a single field "p"
+
+    /// Longest BLOCK of StreamReadGroup()
+    static constexpr std::chrono::milliseconds MAX_STREAM_BLOCK{5000};
+
+    /**
+     * Append (stream key, payload) entries with pipelined XADDs
+     *
+     * Each stream is trimmed to about max_len entries (MAXLEN ~). In
+     * CLUSTER mode each run of entries for the same stream gets its own pipeline.
+     */
+    void StreamAppend(const std::vector<std::pair<std::string, std::string>>& entries, size_t max_len);
+
+    /**
+     * XGROUP CREATE key group start_id MKSTREAM
+     *
+     * @return False if the group exists already
+     */
+    bool StreamCreateGroup(std::string_view key, std::string_view group, std::string_view start_id = "$");
+
+    void StreamDestroyGroup(std::string_view key, std::string_view group);
+
+    /**
+     * XREADGROUP on a connection reserved for blocking reads
+     *
+     * @param id ">" for entries never delivered to the group, "0" for the
+     *        consumer's own unacknowledged ones
+     * @param block Wait up to this long (at most MAX_STREAM_BLOCK) for new entries
+     * @throws sw::redis::ReplyError starting "NOGROUP" if the stream or the group is gone
+     */
+    std::vector<StreamMessage> StreamReadGroup(
+        std::string_view key,
+        std::string_view group,
+        std::string_view consumer,
+        std::string_view id,
+        size_t count,
+        std::chrono::milliseconds block
+    );
+
+    /// XACK of several ids in one command
+    int64_t StreamAck(std::string_view key, std::string_view group, const std::vector<std::string>& ids);
+
+    /**
+     * Open every pooled connection (PING on each) and load this client's Lua scripts
+     *
+     * In CLUSTER mode opens one connection per master and loads the scripts
+     * on each.
+     *
+     * redis++ connects lazily, so without this the first requests after a
+     * start pay for the connects and SCRIPT LOADs. Used by startup warm-up.
+     *
+     * @throws sw::redis::Error if Redis is unreachable
+     */
+    void Warm();
+
+    /// Client-side cache; null when client_cache_entries is 0 or in CLUSTER mode
+    const RedisClientCache* ClientCache() const { return cache_.get(); }
+
+    RedisMode Mode() const { return mode_; }
 
 private:
-    std::unique_ptr<sw::redis::Redis> redis_;
+    struct Subscription {
+        uint64_t id;
+        std::shared_ptr<std::atomic<bool>> stop;
+        std::thread thread;
+    };
+
+    void RunSubscriber(
+        std::string channel,
+        std::function<void(const std::string&)> handler,
+        std::function<void()> on_subscribed,
+        std::shared_ptr<std::atomic<bool>> stop
+    );
+
+    // Admit a round trip through dependency_ and charge it to the current TenantUsageScope
+    Dependency::Permit Admit();
+
+    // Runs command(client) on the cluster or the single-node client
+    template <typename Command>
+    auto Run(Command&& command);
+
+    // Non-transactional pipeline on a pooled connection (of key's node in a cluster)
+    sw::redis::Pipeline PipelineFor(std::string_view key);
+
+    // Single-node client (the current master in SENTINEL mode) with these options
+    std::unique_ptr<sw::redis::Redis> MakeNodeClient(
+        const sw::redis::ConnectionOptions& options,
+        const sw::redis::ConnectionPoolOptions& pool_options = {});
+
+    // Address of the node the tracking connection should use
+    std::pair<std::string, int> TrackedNode(const sw::redis::ConnectionOptions& options);
+
+    // GET through the client-side cache when it covers the key
+    std::optional<std::string> CachedGet(std::string_view key);
+    void InvalidateLocal(std::string_view key);
+
+    // Owns the RESP3 connection whose CLIENT TRACKING invalidates cache_
+    void RunTracker(std::vector<std::string> prefixes);
+
+    // Keys and Args: initializer lists of StringView or vectors of std::string
+    template <typename T, typename Keys, typename Args>
+    T RunScript(std::string_view script, const Keys& keys, const Args& args);
+    using ScriptDigest = std::array<char, 40>;   // Hex SHA1 returned by SCRIPT LOAD
+
+    ScriptDigest ScriptSha(std::string_view script, bool reload);
+
+    std::string connection_string_;
+    size_t pool_size_;
+    RedisMode mode_;
+    std::unique_ptr<Dependency> dependency_;             // "redis"
+    std::unique_ptr<sw::redis::Redis> redis_;            // STANDALONE and SENTINEL
+    std::unique_ptr<sw::redis::RedisCluster> cluster_;   // CLUSTER
+    std::shared_ptr<sw::redis::Sentinel> sentinel_;
+    std::vector<std::pair<std::string, int>> sentinels_;
+    std::string sentinel_master_;
+
+    // Script source -> SHA1 returned by SCRIPT LOAD; keys view into script_sources_
+    // so lookups need no copy of the script
+    std::mutex scripts_mutex_;
+    std::deque<std::string> script_sources_;
+    std::unordered_map<std::string_view, ScriptDigest> script_shas_;
+
+    // Blocking stream reads get their own pool, with a socket timeout above MAX_STREAM_BLOCK
+    std::mutex streams_mutex_;
+    std::unique_ptr<sw::redis::Redis> stream_redis_;
+    std::unique_ptr<sw::redis::RedisCluster> stream_cluster_;
+
+    // Subscriber connections use a socket timeout so listeners can observe shutdown
+    std::unique_ptr<sw::redis::Redis> subscriber_redis_;
+    std::unique_ptr<sw::redis::RedisCluster> subscriber_cluster_;
+    std::atomic<bool> stopping_{false};
+    std::mutex subscribers_mutex_;
+    uint64_t next_subscription_id_ = 1;
+    std::vector<Subscription> subscriptions_;
+
+    std::unique_ptr<RedisClientCache> cache_;
+    std::chrono::milliseconds connect_timeout_;
+    std::thread tracker_;
 };
 
 } // namespace common
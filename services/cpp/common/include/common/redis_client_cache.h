@@ -0,0 +1,136 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Local LRU of Redis values kept correct by server-assisted invalidation
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Point-in-time cache counters
+ */
+struct RedisClientCacheStats {
+    size_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;   // Keys invalidated (by Redis or local writes)
+    uint64_t flushes = 0;         // Whole cache dropped (tracking lost, FLUSHALL)
+};
+
+/**
+ * Process-local copy of Redis keys under a set of prefixes
+ *
+ * RedisClient fills it on reads and empties entries when Redis reports
+ * them modified: its tracking connection runs CLIENT TRACKING ON BCAST for
+ * the same prefixes, so every write, expiry or eviction of a matching key
+ * by any client sends an invalidation. Missing keys are cached too (the
+ * common case for token blacklist lookups); creating the key invalidates
+ * them like any other write.
+ *
+ * A read that races an invalidation must not store the value it fetched,
+ * which may predate the write. Callers take a Ticket() before the fetch
+ * and Put() drops the value if the key's stripe saw an invalidation since.
+ *
+ * The cache is disabled (empty, every Get() a miss) until the tracking
+ * connection is established and whenever it is lost, since invalidations
+ * would be missed meanwhile. Entries also expire with the key's TTL and
+ * after at most max_age.
+ */
+class RedisClientCache {
+public:
+    /**
+     * @param capacity Entries kept (least recently used evicted first)
+     * @param max_age Upper bound on an entry's lifetime
+     * @param prefixes Key prefixes served from the cache (the tracked prefixes)
+     */
+    RedisClientCache(size_t capacity, std::chrono::milliseconds max_age, std::vector<std::string> prefixes);
+    ~RedisClientCache();
+
+    RedisClientCache(const RedisClientCache&) = delete;
+    RedisClientCache& operator=(const RedisClientCache&) = delete;
+
+    /// Whether `key` is under one of the prefixes
+    bool Covers(std::string_view key) const;
+
+    /**
+     * Cached value of a key
+     *
+     * @return nullopt on a miss; otherwise the value, itself nullopt for a key
+     *         known to be missing
+     */
+    std::optional<std::optional<std::string>> Get(std::string_view key);
+
+    /// Taken before fetching `key` from Redis, passed to Put()
+    uint64_t Ticket(std::string_view key) const;
+
+    /**
+     * Store a fetched value unless `key` was invalidated since `ticket`
+     *
+     * @param ttl Remaining TTL reported with the value (negative: none)
+     */
+    void Put(std::string_view key, std::optional<std::string> value, std::chrono::milliseconds ttl,
+             uint64_t ticket);
+
+    /// Drop a key (invalidation, or a write by this process)
+    void Invalidate(std::string_view key);
+
+    /// Drop every entry; Put() of fetches already in flight is ignored
+    void Flush();
+
+    /// Serve and accept entries (tracking active) or not (disabling flushes)
+    void SetEnabled(bool enabled);
+    bool Enabled() const { return enabled_.load(); }
+
+    const std::vector<std::string>& Prefixes() const { return prefixes_; }
+
+    RedisClientCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::optional<std::string> value;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // Each stripe has its own LRU and invalidation generation
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::list<Entry> lru;   // Most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;   // Views into lru keys
+        uint64_t generation = 0;
+    };
+
+    static constexpr size_t NUM_STRIPES = 16;
+
+    Stripe& StripeFor(std::string_view key) const;
+
+    size_t stripe_capacity_;
+    std::chrono::milliseconds max_age_;
+    std::vector<std::string> prefixes_;
+    std::unique_ptr<Stripe[]> stripes_;
+    std::atomic<bool> enabled_{false};
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> invalidations_{0};
+    std::atomic<uint64_t> flushes_{0};
+    uint64_t metrics_collector_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,270 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Circuit breakers, adaptive concurrency limits and deadline propagation for Postgres and Redis
+ */
+
+#pragma once
+
+#include "common/metrics.h"
+#include <grpcpp/server_context.h>
+#include <grpcpp/support/status.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Circuit breaker options
+ */
+struct CircuitBreakerOptions {
+    uint32_t failure_threshold = 5;                  // Consecutive failures that open it (0 = never opens)
+    std::chrono::milliseconds open_duration{5000};   // Calls fail fast this long before a probe
+};
+
+/**
+ * Consecutive-failure circuit breaker
+ *
+ * CLOSED lets every call through. failure_threshold failures in a row open
+ * it: calls are refused without touching the dependency, so callers fail
+ * in microseconds instead of each waiting for a connect or socket timeout.
+ * After open_duration one probe is let through (HALF_OPEN); its success
+ * closes the breaker, its failure opens it for another open_duration.
+ */
+class CircuitBreaker {
+public:
+    enum class State { CLOSED = 0, OPEN = 1, HALF_OPEN = 2 };
+
+    explicit CircuitBreaker(CircuitBreakerOptions options = {});
+
+    /// False while open (or while the half-open probe is in flight)
+    bool Allow();
+
+    void RecordSuccess();
+    void RecordFailure();
+
+    State GetState() const { return state_.load(std::memory_order_acquire); }
+
+private:
+    CircuitBreakerOptions options_;
+    std::atomic<State> state_{State::CLOSED};
+    std::atomic<uint32_t> failures_{0};
+    std::mutex mutex_;                                   // Transitions out of CLOSED
+    std::chrono::steady_clock::time_point opened_at_;
+    bool probing_ = false;
+};
+
+/**
+ * Adaptive concurrency limit options
+ *
+ * Zero limits are filled in by ForCapacity() from the dependency's own
+ * capacity (pool size).
+ */
+struct AdaptiveLimitOptions {
+    bool enabled = true;
+    uint32_t initial_limit = 0;
+    uint32_t min_limit = 0;
+    uint32_t max_limit = 0;
+    double smoothing = 0.2;     // Weight of each new estimate
+
+    /// Limits from a pool of `capacity`: min = capacity, initial = 2x, max = 4x
+    AdaptiveLimitOptions ForCapacity(size_t capacity) const;
+};
+
+/**
+ * Vegas-style adaptive concurrency limit
+ *
+ * The limit caps calls outstanding against a dependency (waiting for a
+ * connection plus holding one). From each call's round-trip time it
+ * estimates the queue in front of the dependency,
+ * limit * (1 - rtt_noload / rtt), where rtt_noload is the lowest RTT seen
+ * recently: a short queue raises the limit, a long one (or a failed call)
+ * lowers it. When Postgres slows down RTTs rise, the limit falls to
+ * min_limit, and callers beyond it are shed at once instead of joining a
+ * queue whose every entry would time out. rtt_noload is re-measured every
+ * 30 * limit samples so it follows real changes in the dependency.
+ */
+class AdaptiveLimit {
+public:
+    explicit AdaptiveLimit(AdaptiveLimitOptions options);
+
+    /// Claim a slot; false when limit calls are already outstanding
+    bool TryAcquire();
+
+    /// Give the slot back; dropped = the call failed or timed out
+    void Release(std::chrono::steady_clock::duration rtt, bool dropped);
+
+    /// Give the slot back without a sample (the call never started)
+    void Cancel() { in_flight_.fetch_sub(1, std::memory_order_relaxed); }
+
+    uint32_t Limit() const { return limit_.load(std::memory_order_relaxed); }
+    uint32_t InFlight() const { return in_flight_.load(std::memory_order_relaxed); }
+
+private:
+    AdaptiveLimitOptions options_;
+    std::atomic<uint32_t> limit_;
+    std::atomic<uint32_t> in_flight_{0};
+
+    std::mutex mutex_;              // Estimate below
+    double estimate_;
+    int64_t rtt_noload_us_ = 0;     // 0 = not measured yet
+    uint64_t samples_since_probe_ = 0;
+};
+
+/**
+ * Per-dependency options
+ *
+ * FromEnv(prefix) reads <prefix>_BREAKER_FAILURES, <prefix>_BREAKER_OPEN_MS,
+ * <prefix>_ADAPTIVE_LIMIT (1/0), <prefix>_LIMIT_MIN, <prefix>_LIMIT_MAX and
+ * <prefix>_LIMIT_INITIAL, e.g. DB_BREAKER_FAILURES.
+ */
+struct DependencyOptions {
+    CircuitBreakerOptions breaker;
+    AdaptiveLimitOptions limit;
+
+    static DependencyOptions FromEnv(const std::string& prefix);
+};
+
+/**
+ * Thrown when a call to a dependency is refused without being attempted;
+ * ResilienceScope turns the handler's INTERNAL into UNAVAILABLE
+ */
+class DependencyUnavailable : public std::runtime_error {
+public:
+    DependencyUnavailable(const std::string& dependency, const std::string& reason)
+        : std::runtime_error(dependency + " unavailable: " + reason) {}
+};
+
+/**
+ * The RPC being handled on this thread: its deadline, its ServerContext,
+ * and whether a dependency shed it
+ *
+ * The service adapters (common/service_adapter.h) open one around every
+ * handler call with the ServerContext. Dependency::Admit() refuses calls
+ * whose deadline has passed; DbPool waits for a connection at most until
+ * the deadline, and cancels the query running on a borrowed connection
+ * once the deadline passes or the client goes away. Handlers turn every
+ * exception into INTERNAL, so Finish() reports a shed call as UNAVAILABLE,
+ * the code clients retry (elsewhere, or with backoff).
+ */
+class ResilienceScope {
+public:
+    explicit ResilienceScope(std::chrono::system_clock::time_point deadline);
+    explicit ResilienceScope(const grpc::ServerContextBase* context);
+    ~ResilienceScope();
+
+    ResilienceScope(const ResilienceScope&) = delete;
+    ResilienceScope& operator=(const ResilienceScope&) = delete;
+
+    /// `status`, or UNAVAILABLE if the call was shed and the handler failed
+    grpc::Status Finish(grpc::Status status) const;
+
+    /// Deadline of the current RPC; nullopt outside one or without a deadline
+    static std::optional<std::chrono::steady_clock::time_point> Deadline();
+
+    /// ServerContext of the current RPC (IsCancelled() is safe from any thread); null outside one
+    static const grpc::ServerContextBase* Context();
+
+    /// Earlier of `fallback` and the current RPC's deadline
+    static std::chrono::steady_clock::time_point DeadlineOr(std::chrono::steady_clock::time_point fallback);
+
+    /// Called by Dependency when it refuses a call on this thread
+    static void MarkShed(const std::string& reason);
+
+private:
+    ResilienceScope* previous_;
+    std::optional<std::chrono::steady_clock::time_point> deadline_;
+    const grpc::ServerContextBase* context_ = nullptr;
+    std::string shed_;
+};
+
+/**
+ * Circuit breaker plus adaptive limit in front of one dependency
+ *
+ * Usage:
+ *   auto permit = dependency.Admit();   // throws DependencyUnavailable
+ *   ... call the dependency ...
+ *   permit.Failure();                   // if it failed; success otherwise
+ *
+ * A permit neither marked nor released is recorded as a failure when it is
+ * destroyed by an exception and as a success otherwise.
+ *
+ * Exports, labelled dependency=<name>:
+ *
+ *   saasforge_dependency_rejected_total{reason}   counter (open, limit, deadline)
+ *   saasforge_dependency_failures_total           counter
+ *   saasforge_dependency_concurrency_limit        gauge
+ *   saasforge_dependency_in_flight                gauge
+ *   saasforge_dependency_breaker_state            gauge (0 closed, 1 open, 2 half-open)
+ */
+class Dependency {
+public:
+    class Permit {
+    public:
+        Permit() = default;
+        ~Permit();
+        Permit(Permit&& other) noexcept;
+        Permit& operator=(Permit&& other) noexcept;
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+
+        void Success() { Release(false); }
+        void Failure() { Release(true); }
+
+    private:
+        friend class Dependency;
+        Permit(Dependency* dependency, bool limited)
+            : dependency_(dependency), limited_(limited), started_(std::chrono::steady_clock::now()),
+              exceptions_(std::uncaught_exceptions()) {}
+
+        void Release(bool failed);
+
+        Dependency* dependency_ = nullptr;
+        bool limited_ = false;      // Holds an AdaptiveLimit slot
+        std::chrono::steady_clock::time_point started_;
+        int exceptions_ = 0;
+    };
+
+    Dependency(std::string name, DependencyOptions options, MetricsRegistry& registry = MetricsRegistry::Global());
+    ~Dependency();
+
+    Dependency(const Dependency&) = delete;
+    Dependency& operator=(const Dependency&) = delete;
+
+    /**
+     * Admit one call
+     *
+     * @throws DependencyUnavailable if the breaker is open, the limit is
+     *         reached or the current RPC's deadline has passed
+     */
+    Permit Admit();
+
+    const std::string& Name() const { return name_; }
+    CircuitBreaker::State BreakerState() const { return breaker_.GetState(); }
+    uint32_t Limit() const { return limit_.Limit(); }
+    uint32_t InFlight() const { return limit_.InFlight(); }
+
+private:
+    [[noreturn]] void Reject(const char* reason, Counter& counter);
+    void Done(std::chrono::steady_clock::duration rtt, bool failed, bool limited);
+
+    std::string name_;
+    DependencyOptions options_;
+    CircuitBreaker breaker_;
+    AdaptiveLimit limit_;
+    MetricsRegistry& registry_;
+    Counter& rejected_open_;
+    Counter& rejected_limit_;
+    Counter& rejected_deadline_;
+    Counter& failures_;
+    uint64_t collector_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,256 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Compile-time mapping between result columns and record structs
+ */
+
+#pragma once
+
+#include "common/record_batch.h"
+#include "common/statement_registry.h"
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * SQL text assembled at compile time
+ *
+ * A constexpr SqlText at namespace scope is constant-initialized with
+ * static storage, so its c_str() can back a PreparedStatement whatever
+ * the order of static initialization.
+ *
+ * Usage:
+ *   constexpr auto kClaimSql = SqlText("UPDATE ... RETURNING ") + kRow.SelectList();
+ *   const PreparedStatement kClaim("queue_claim", kClaimSql.c_str());
+ */
+template <size_t N>
+struct SqlText {
+    char text[N + 1] = {};
+
+    constexpr SqlText() = default;
+    constexpr SqlText(const char (&literal)[N + 1]) {
+        for (size_t i = 0; i < N; ++i) {
+            text[i] = literal[i];
+        }
+    }
+
+    constexpr const char* c_str() const { return text; }
+    static constexpr size_t size() { return N; }
+
+    /// Copy part in at pos; returns the position after it
+    template <size_t M>
+    constexpr size_t Put(size_t pos, const SqlText<M>& part) {
+        for (size_t i = 0; i < M; ++i) {
+            text[pos + i] = part.text[i];
+        }
+        return pos + M;
+    }
+
+    template <size_t M>
+    constexpr SqlText<N + M> operator+(const SqlText<M>& other) const {
+        SqlText<N + M> out;
+        out.Put(out.Put(0, *this), other);
+        return out;
+    }
+
+    template <size_t M>
+    constexpr SqlText<N + M - 1> operator+(const char (&literal)[M]) const {
+        return *this + SqlText<M - 1>(literal);
+    }
+};
+
+template <size_t N>
+SqlText(const char (&)[N]) -> SqlText<N - 1>;
+
+namespace row_mapping_detail {
+
+using record_batch_detail::MemberTraits;
+
+inline void ReadValue(const pqxx::field& field, std::string& out) {
+    ReadText(field, out);
+}
+
+// NULL reads as the zero value, as the queues' optional columns (sent_at, bounce_type, ...) expect
+template <typename T>
+void ReadValue(const pqxx::field& field, T& out) {
+    if constexpr (std::is_enum_v<T>) {
+        out = field.is_null() ? T{} : static_cast<T>(field.as<std::underlying_type_t<T>>());
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "mapped members are strings, numbers or enums");
+        out = field.is_null() ? T{} : field.as<T>();
+    }
+}
+
+} // namespace row_mapping_detail
+
+/**
+ * One result column bound to a record member; see Column()
+ */
+template <auto Member, size_t N>
+struct ColumnMapping {
+    using Record = typename row_mapping_detail::MemberTraits<decltype(Member)>::Record;
+    using Value = typename row_mapping_detail::MemberTraits<decltype(Member)>::Value;
+    static constexpr auto MEMBER = Member;
+    static constexpr size_t LENGTH = N;
+
+    SqlText<N> expression;      // Select-list entry, e.g. "d.id" or "EXTRACT(...)::bigint AS created_at"
+};
+
+/// Column read into Member, selected by expression
+template <auto Member, size_t N>
+constexpr ColumnMapping<Member, N - 1> Column(const char (&expression)[N]) {
+    return {SqlText<N - 1>(expression)};
+}
+
+/**
+ * A record's columns, declared once for the statements that return it
+ *
+ * SelectList() generates the SELECT/RETURNING list at compile time, and
+ * Read() fills a record from a row by ordinal: the i-th column goes to
+ * the i-th member, with no name lookups and strings copied once from the
+ * result buffer. Statements built from the mapping cannot drift from the
+ * struct; extra columns after the mapped ones are left to the caller.
+ *
+ * Usage:
+ *   constexpr auto kEmailRow = MapRow(
+ *       Column<&QueuedEmail::id>("id"),
+ *       Column<&QueuedEmail::created_at>("EXTRACT(EPOCH FROM created_at)::bigint AS created_at"));
+ *   constexpr auto kSelectSql = SqlText("SELECT ") + kEmailRow.SelectList() + " FROM email_queue";
+ *   ...
+ *   kEmailRow.ReadAll(result, emails);
+ */
+template <typename Record, typename... Columns>
+class RowMapping {
+    static_assert(sizeof...(Columns) > 0, "a row mapping needs at least one column");
+    static_assert((std::is_base_of_v<typename Columns::Record, Record> && ...),
+                  "mapped members belong to the record");
+
+public:
+    static constexpr size_t COLUMNS = sizeof...(Columns);
+
+    constexpr explicit RowMapping(Columns... columns) : columns_(columns...) {}
+
+    /// "expression, expression, ..." in column order
+    constexpr auto SelectList() const {
+        return Join(std::index_sequence_for<Columns...>{});
+    }
+
+    /// This mapping with more columns after its own (e.g. a claim's extras)
+    template <typename... More>
+    constexpr RowMapping<Record, Columns..., More...> With(More... more) const {
+        return std::apply(
+            [&](const Columns&... columns) { return RowMapping<Record, Columns..., More...>(columns..., more...); },
+            columns_);
+    }
+
+    /// Fill out in place from row (reusing its strings' capacity)
+    void Read(const pqxx::row& row, Record& out) const {
+        ReadColumns(row, out, std::index_sequence_for<Columns...>{});
+    }
+
+    /**
+     * Append every row of result to out
+     *
+     * @throws std::logic_error if result has fewer columns than mapped
+     */
+    void ReadAll(const pqxx::result& result, std::vector<Record>& out) const {
+        if (result.empty()) {
+            return;
+        }
+        if (static_cast<size_t>(result.columns()) < COLUMNS) {
+            throw std::logic_error("Result has fewer columns than its row mapping");
+        }
+        out.reserve(out.size() + result.size());
+        for (const auto& row : result) {
+            Read(row, out.emplace_back());
+        }
+    }
+
+    /**
+     * Append every row of result to a column batch
+     *
+     * The batch's columns and text buffer are sized for the whole result
+     * first, so filling it allocates at most twice.
+     *
+     * @throws std::logic_error if result has fewer columns than mapped
+     */
+    template <auto... Members>
+    void ReadAll(const pqxx::result& result, RecordBatch<Record, Members...>& out) const {
+        if (result.empty()) {
+            return;
+        }
+        if (static_cast<size_t>(result.columns()) < COLUMNS) {
+            throw std::logic_error("Result has fewer columns than its row mapping");
+        }
+        size_t text = 0;
+        for (const auto& row : result) {
+            text += TextSize(row, std::index_sequence_for<Columns...>{});
+        }
+        out.Reserve(out.size() + result.size(), out.TextBytes() + text);
+        for (const auto& row : result) {
+            ReadColumns(row, out, out.AddRow(), std::index_sequence_for<Columns...>{});
+        }
+    }
+
+private:
+    template <size_t... I>
+    constexpr auto Join(std::index_sequence<I...>) const {
+        constexpr size_t length = (Columns::LENGTH + ...) + 2 * (COLUMNS - 1);
+        constexpr SqlText<2> separator(", ");
+        SqlText<length> out;
+        size_t pos = 0;
+        ((pos = out.Put(I == 0 ? pos : out.Put(pos, separator), std::get<I>(columns_).expression)), ...);
+        return out;
+    }
+
+    template <size_t... I>
+    static void ReadColumns(const pqxx::row& row, Record& out, std::index_sequence<I...>) {
+        (row_mapping_detail::ReadValue(row[static_cast<pqxx::row::size_type>(I)], out.*(Columns::MEMBER)), ...);
+    }
+
+    template <typename Batch, size_t... I>
+    static void ReadColumns(const pqxx::row& row, Batch& out, size_t index, std::index_sequence<I...>) {
+        (ReadColumn<Columns>(row[static_cast<pqxx::row::size_type>(I)], out, index), ...);
+    }
+
+    template <typename ColumnType, typename Batch>
+    static void ReadColumn(const pqxx::field& field, Batch& out, size_t index) {
+        using Value = typename ColumnType::Value;
+        if constexpr (std::is_same_v<Value, std::string>) {
+            if (!field.is_null()) {
+                out.template Set<ColumnType::MEMBER>(index, std::string_view(field.c_str(), field.size()));
+            }
+        } else {
+            Value value;
+            row_mapping_detail::ReadValue(field, value);
+            out.template Set<ColumnType::MEMBER>(index, value);
+        }
+    }
+
+    template <size_t... I>
+    static size_t TextSize(const pqxx::row& row, std::index_sequence<I...>) {
+        return ((std::is_same_v<typename Columns::Value, std::string>
+                     ? row[static_cast<pqxx::row::size_type>(I)].size()
+                     : 0) +
+                ... + size_t{0});
+    }
+
+    std::tuple<Columns...> columns_;
+};
+
+/// Mapping of the columns' record (the first column's class)
+template <typename First, typename... Rest>
+constexpr RowMapping<typename First::Record, First, Rest...> MapRow(First first, Rest... rest) {
+    return RowMapping<typename First::Record, First, Rest...>(first, rest...);
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,130 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description S3 multipart upload calls, ranged object reads and batch deletes
+ */
+
+#pragma once
+
+#include "common/s3_presigner.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * One uploaded part of a multipart upload
+ */
+struct S3Part {
+    int32_t part_number = 0;
+    std::string etag;      // As returned by S3, including the surrounding quotes
+    int64_t size = 0;      // 0 when not known (client-reported parts)
+};
+
+/**
+ * A key DeleteObjects did not delete
+ */
+struct S3DeleteError {
+    std::string key;
+    std::string code;      // S3 error code, e.g. AccessDenied
+};
+
+/**
+ * Response of a single S3 HTTP call
+ */
+struct S3HttpResponse {
+    long status = 0;
+    std::string body;
+    std::string etag;      // ETag response header, if any
+};
+
+/**
+ * Issues S3 multipart upload calls, ranged reads and batch deletes
+ *
+ * Requests are authenticated with presigned URLs from S3Presigner, so no
+ * header signing is involved. Client uploads only use the control calls (a
+ * handful per upload): clients PUT parts directly to URLs from
+ * PresignPart(). GetRange() and UploadPart() are for server-side
+ * processing that streams an object through in bounded chunks.
+ *
+ * Usage:
+ *   S3MultipartClient s3(presigner);
+ *   std::string upload_id = s3.Create(key, "application/octet-stream");
+ *   std::string url = s3.PresignPart(key, upload_id, 1, 600);
+ *   std::string etag = s3.Complete(key, upload_id, parts);
+ *
+ * Thread-safe. Failures throw std::runtime_error carrying the S3 error code.
+ */
+class S3MultipartClient {
+public:
+    /// Performs one HTTP request; headers are "Name: value" lines
+    using Transport = std::function<S3HttpResponse(
+        const std::string& method,
+        const std::string& url,
+        const std::string& body,
+        const std::vector<std::string>& headers)>;
+
+    static constexpr int32_t MAX_PARTS = 10000;
+    static constexpr int64_t MIN_PART_SIZE = 5LL * 1024 * 1024;          // Except the last part
+    static constexpr int64_t MAX_PART_SIZE = 5LL * 1024 * 1024 * 1024;
+    static constexpr size_t MAX_DELETE_KEYS = 1000;                      // Per DeleteObjects request
+
+    /// libcurl transport with the given per-request timeout
+    explicit S3MultipartClient(std::shared_ptr<S3Presigner> presigner,
+                               std::chrono::milliseconds request_timeout = std::chrono::seconds(120));
+
+    /// Custom transport (tests)
+    S3MultipartClient(std::shared_ptr<S3Presigner> presigner, Transport transport);
+
+    /// CreateMultipartUpload; returns the S3 UploadId
+    std::string Create(const std::string& key, const std::string& content_type) const;
+
+    /// Presigned PUT URL for one part (no network call)
+    std::string PresignPart(const std::string& key, const std::string& upload_id,
+                            int32_t part_number, int64_t expires_in) const;
+
+    /// ListParts, following pagination; parts are in part-number order
+    std::vector<S3Part> ListParts(const std::string& key, const std::string& upload_id) const;
+
+    /// CompleteMultipartUpload; parts must be in ascending part-number order. Returns the object ETag
+    std::string Complete(const std::string& key, const std::string& upload_id,
+                         const std::vector<S3Part>& parts) const;
+
+    /// AbortMultipartUpload; frees stored parts
+    void Abort(const std::string& key, const std::string& upload_id) const;
+
+    /// UploadPart from memory; returns the part ETag
+    std::string UploadPart(const std::string& key, const std::string& upload_id,
+                           int32_t part_number, const std::string& data) const;
+
+    /// GET bytes [offset, offset + length) of an object; shorter at the end of the object
+    std::string GetRange(const std::string& key, int64_t offset, int64_t length) const;
+
+    /**
+     * DeleteObjects (quiet mode): up to MAX_DELETE_KEYS objects in one request
+     *
+     * Keys that do not exist count as deleted. Returns the keys S3 could not
+     * delete; throws if the request as a whole failed.
+     */
+    std::vector<S3DeleteError> DeleteObjects(const std::vector<std::string>& keys) const;
+
+    /// Part size for content_length: at least min_part_size and small enough to fit MAX_PARTS
+    static int64_t ChoosePartSize(int64_t content_length, int64_t min_part_size);
+
+    static Transport CurlTransport(std::chrono::milliseconds request_timeout);
+
+private:
+    S3HttpResponse Call(const std::string& method, const std::string& url,
+                        const std::string& body, const std::vector<std::string>& headers) const;
+
+    std::shared_ptr<S3Presigner> presigner_;
+    Transport transport_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,37 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Installs the server-wide gRPC interceptors on a ServerBuilder
+ */
+
+#pragma once
+
+#include "common/compression_interceptor.h"
+#include "common/metrics.h"
+#include "common/tenant_context.h"
+#include "common/tracing.h"
+
+namespace grpc {
+class ServerBuilder;
+}
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Install the server-wide interceptors on a builder (before BuildAndStart):
+ * tracing, then metrics, then response compression, then tenant context
+ *
+ * ServerBuilder keeps a single list of interceptor creators, so they are
+ * all registered here rather than one call each. Tenant context runs last
+ * so its rejections are still traced and counted.
+ */
+void AddServerInterceptors(
+    grpc::ServerBuilder& builder,
+    TenantContextOptions tenant_options = {},
+    CompressionOptions compression = CompressionOptions::FromEnv(),
+    Tracer& tracer = Tracer::Global(),
+    MetricsRegistry& registry = MetricsRegistry::Global());
+
+} // namespace common
+} // namespace saasforge
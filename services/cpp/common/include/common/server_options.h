@@ -0,0 +1,60 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server threading configuration shared by all services
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace grpc {
+class ServerBuilder;
+}
+
+namespace saasforge {
+namespace common {
+
+enum class ServerMode {
+    SYNC,      // grpc::Service, handlers run on gRPC's sync thread pool
+    CALLBACK   // grpc::CallbackService, handlers offloaded to a bounded Executor
+};
+
+/**
+ * Server threading options, read from the environment:
+ *
+ *   GRPC_SERVER_MODE         sync | callback          (default sync)
+ *   GRPC_NUM_CQS             completion queues        (sync mode, 0 = gRPC default)
+ *   GRPC_MIN_POLLERS         min pollers per CQ       (sync mode, 0 = gRPC default)
+ *   GRPC_MAX_POLLERS         max pollers per CQ       (sync mode, 0 = gRPC default)
+ *   GRPC_MAX_THREADS         resource quota thread cap (0 = unlimited)
+ *   EXECUTOR_THREADS         executor workers         (callback mode, 0 = 2 x cores)
+ *   EXECUTOR_QUEUE_CAPACITY  queued requests before RESOURCE_EXHAUSTED
+ *   EXECUTOR_PIN_THREADS     1 = pin executor workers to cores
+ *   GRPC_SERVER_MIN_PING_INTERVAL_MS  client keepalive PINGs accepted this often,
+ *                            also on idle connections (0 = gRPC default, 5 min)
+ */
+struct ServerOptions {
+    ServerMode mode = ServerMode::SYNC;
+    int num_cqs = 0;
+    int min_pollers = 0;
+    int max_pollers = 0;
+    int max_threads = 0;
+    size_t executor_threads = 0;
+    size_t executor_queue_capacity = 1024;
+    bool pin_executor_threads = false;
+    int min_ping_interval_ms = 10000;    // <= ChannelPoolOptions::keepalive_time, or clients get GOAWAY
+
+    static ServerOptions FromEnv();
+
+    /**
+     * Apply CQ/poller/thread settings to a builder (before BuildAndStart)
+     */
+    void ApplyTo(grpc::ServerBuilder& builder) const;
+
+    std::string Describe() const;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,479 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Sync and callback gRPC service adapters over one handler class
+ */
+
+#pragma once
+
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/server_callback.h>
+#include <grpcpp/support/sync_stream.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "common/executor.h"
+#include "common/resilience.h"
+#include "common/server_options.h"
+#include "common/tenant_context.h"
+#include "common/tenant_usage.h"
+#include "common/tracing_interceptor.h"
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Run a unary handler on the executor and finish the callback reactor
+ *
+ * The handler captures the request/response pointers; gRPC keeps them alive
+ * until Finish() is called. If the executor queue is full the RPC is
+ * rejected with RESOURCE_EXHAUSTED so clients back off instead of piling up.
+ * The RPC's server span is current while the task is submitted, so the
+ * executor carries it over to the handler. Calls the tenant context
+ * interceptor rejected are finished here without running the handler.
+ */
+template <typename Handler>
+grpc::ServerUnaryReactor* OffloadUnary(
+    Executor& executor,
+    grpc::CallbackServerContext* context,
+    Handler&& handler
+) {
+    auto* reactor = context->DefaultReactor();
+
+    grpc::Status rejection = TenantContextInterceptor::CallStatus(context);
+    if (!rejection.ok()) {
+        reactor->Finish(rejection);
+        return reactor;
+    }
+
+    ScopedTraceContext trace_scope(ServerTraceContext(context));
+    bool accepted = executor.TrySubmit([reactor, handler = std::forward<Handler>(handler)]() mutable {
+        grpc::Status status;
+        try {
+            status = handler();
+        } catch (const std::exception& e) {
+            status = grpc::Status(grpc::StatusCode::INTERNAL, std::string("Unhandled error: ") + e.what());
+        }
+        reactor->Finish(status);
+    });
+
+    if (!accepted) {
+        reactor->Finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Server overloaded, retry later"));
+    }
+
+    return reactor;
+}
+
+/// Messages handed to a client-streaming handler per call
+constexpr size_t CLIENT_STREAM_CHUNK_SIZE = 500;
+
+/**
+ * Drain a client stream on the sync API, calling handler(chunk) per chunk
+ *
+ * A non-OK status from the handler ends the RPC with that status.
+ */
+template <typename Request, typename Handler>
+grpc::Status ReadClientStream(grpc::ServerReader<Request>* reader, Handler&& handler) {
+    std::vector<Request> chunk;
+    chunk.reserve(CLIENT_STREAM_CHUNK_SIZE);
+
+    Request request;
+    while (reader->Read(&request)) {
+        chunk.push_back(std::move(request));
+        if (chunk.size() >= CLIENT_STREAM_CHUNK_SIZE) {
+            grpc::Status status = handler(chunk);
+            if (!status.ok()) {
+                return status;
+            }
+            chunk.clear();
+        }
+    }
+    return chunk.empty() ? grpc::Status::OK : handler(chunk);
+}
+
+/**
+ * Callback-API counterpart of ReadClientStream
+ *
+ * Reads on the gRPC thread until a chunk is full (or the client half-closes),
+ * then runs the handler on the executor and only resumes reading once it
+ * returns, so a slow handler applies flow control to the client instead of
+ * buffering the stream in memory.
+ */
+template <typename Request, typename Handler>
+class ChunkedReadReactor final : public grpc::ServerReadReactor<Request> {
+public:
+    ChunkedReadReactor(Executor& executor, TraceContext trace, Handler handler, grpc::Status rejection)
+        : executor_(executor), trace_(std::move(trace)), handler_(std::move(handler)) {
+        if (!rejection.ok()) {
+            this->Finish(rejection);
+            return;
+        }
+        chunk_.reserve(CLIENT_STREAM_CHUNK_SIZE);
+        this->StartRead(&request_);
+    }
+
+    void OnReadDone(bool ok) override {
+        if (ok) {
+            chunk_.push_back(std::move(request_));
+            if (chunk_.size() < CLIENT_STREAM_CHUNK_SIZE) {
+                this->StartRead(&request_);
+                return;
+            }
+        }
+        if (chunk_.empty()) {
+            this->Finish(grpc::Status::OK);
+            return;
+        }
+
+        bool last = !ok;
+        ScopedTraceContext trace_scope(trace_);
+        bool accepted = executor_.TrySubmit([this, last]() {
+            grpc::Status status;
+            try {
+                status = handler_(chunk_);
+            } catch (const std::exception& e) {
+                status = grpc::Status(grpc::StatusCode::INTERNAL, std::string("Unhandled error: ") + e.what());
+            }
+            chunk_.clear();
+            if (!status.ok() || last) {
+                this->Finish(status);
+            } else {
+                this->StartRead(&request_);
+            }
+        });
+
+        if (!accepted) {
+            this->Finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Server overloaded, retry later"));
+        }
+    }
+
+    void OnDone() override { delete this; }
+
+private:
+    Executor& executor_;
+    TraceContext trace_;
+    Handler handler_;
+    Request request_;
+    std::vector<Request> chunk_;
+};
+
+template <typename Request, typename Handler>
+grpc::ServerReadReactor<Request>* OffloadClientStream(
+    Executor& executor,
+    grpc::CallbackServerContext* context,
+    Handler&& handler
+) {
+    return new ChunkedReadReactor<Request, std::decay_t<Handler>>(
+        executor, ServerTraceContext(context), std::forward<Handler>(handler),
+        TenantContextInterceptor::CallStatus(context));
+}
+
+/**
+ * Sink for a server-streaming handler's responses
+ *
+ * Handlers produce responses in chunks and pass each chunk to Write(),
+ * which returns false once the client has gone away so the handler can
+ * stop early.
+ */
+template <typename Response>
+class StreamWriter {
+public:
+    virtual ~StreamWriter() = default;
+
+    /// Send the responses (moved from); false if the stream is broken
+    virtual bool Write(std::vector<Response>& responses) = 0;
+};
+
+/// Sync-API StreamWriter over grpc::ServerWriter
+template <typename Response>
+class SyncStreamWriter final : public StreamWriter<Response> {
+public:
+    explicit SyncStreamWriter(grpc::ServerWriter<Response>* writer) : writer_(writer) {}
+
+    bool Write(std::vector<Response>& responses) override {
+        for (const auto& response : responses) {
+            if (!writer_->Write(response)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    grpc::ServerWriter<Response>* writer_;
+};
+
+/// Responses a server-streaming handler may have queued before Write() blocks
+constexpr size_t SERVER_STREAM_MAX_PENDING = 2 * CLIENT_STREAM_CHUNK_SIZE;
+
+/**
+ * Callback-API server stream fed by a handler running on the executor
+ *
+ * Write() queues responses and starts the next gRPC write when none is in
+ * flight. Once SERVER_STREAM_MAX_PENDING responses are queued it waits for
+ * the client to catch up, so a slow reader applies flow control to the
+ * handler rather than growing the queue. The RPC finishes with the
+ * handler's status once every queued response is written.
+ */
+template <typename Response, typename Handler>
+class StreamingWriteReactor final : public grpc::ServerWriteReactor<Response>, public StreamWriter<Response> {
+public:
+    StreamingWriteReactor(Executor& executor, TraceContext trace, Handler handler, grpc::Status rejection)
+        : handler_(std::move(handler)) {
+        if (!rejection.ok()) {
+            this->Finish(rejection);
+            return;
+        }
+
+        ScopedTraceContext trace_scope(trace);
+        bool accepted = executor.TrySubmit([this]() {
+            grpc::Status status;
+            try {
+                status = handler_(static_cast<StreamWriter<Response>&>(*this));
+            } catch (const std::exception& e) {
+                status = grpc::Status(grpc::StatusCode::INTERNAL, std::string("Unhandled error: ") + e.what());
+            }
+            HandlerDone(std::move(status));
+        });
+
+        if (!accepted) {
+            this->Finish(grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Server overloaded, retry later"));
+        }
+    }
+
+    bool Write(std::vector<Response>& responses) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (broken_) {
+            return false;
+        }
+        for (auto& response : responses) {
+            pending_.push_back(std::move(response));
+        }
+        if (!writing_ && !pending_.empty()) {
+            writing_ = true;
+            const Response* next = &pending_.front();
+            lock.unlock();
+            this->StartWrite(next);
+            lock.lock();
+        }
+        drained_.wait(lock, [this]() { return broken_ || pending_.size() <= SERVER_STREAM_MAX_PENDING; });
+        return !broken_;
+    }
+
+    void OnWriteDone(bool ok) override {
+        const Response* next = nullptr;
+        bool finish = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.pop_front();
+            if (!ok) {
+                broken_ = true;
+                pending_.clear();
+            }
+            if (!pending_.empty()) {
+                next = &pending_.front();
+            } else {
+                writing_ = false;
+                finish = handler_done_;
+            }
+        }
+        drained_.notify_all();
+        if (next) {
+            this->StartWrite(next);
+        } else if (finish) {
+            this->Finish(status_);
+        }
+    }
+
+    void OnCancel() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            broken_ = true;
+        }
+        drained_.notify_all();
+    }
+
+    void OnDone() override { delete this; }
+
+private:
+    void HandlerDone(grpc::Status status) {
+        bool finish = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            status_ = std::move(status);
+            handler_done_ = true;
+            finish = !writing_;
+        }
+        if (finish) {
+            this->Finish(status_);
+        }
+    }
+
+    Handler handler_;
+    std::mutex mutex_;
+    std::condition_variable drained_;
+    std::deque<Response> pending_;   // Front is the write in flight; deque keeps it in place
+    bool writing_ = false;
+    bool broken_ = false;
+    bool handler_done_ = false;
+    grpc::Status status_;
+};
+
+template <typename Response, typename Handler>
+grpc::ServerWriteReactor<Response>* OffloadServerStream(
+    Executor& executor,
+    grpc::CallbackServerContext* context,
+    Handler&& handler
+) {
+    return new StreamingWriteReactor<Response, std::decay_t<Handler>>(
+        executor, ServerTraceContext(context), std::forward<Handler>(handler),
+        TenantContextInterceptor::CallStatus(context));
+}
+
+/**
+ * Build the grpc::Service to register for the configured server mode
+ *
+ * In callback mode an Executor sized from options is created and returned
+ * through `executor`; it must outlive the server.
+ *
+ * @param options Server threading options
+ * @param impl Shared handler implementation
+ * @param executor Receives the executor (callback mode only)
+ * @return Service to pass to ServerBuilder::RegisterService
+ */
+template <typename SyncService, typename CallbackService, typename Impl>
+std::unique_ptr<grpc::Service> MakeService(
+    const ServerOptions& options,
+    std::shared_ptr<Impl> impl,
+    std::shared_ptr<Executor>& executor
+) {
+    if (options.mode == ServerMode::CALLBACK) {
+        executor = std::make_shared<Executor>(
+            options.executor_threads,
+            options.executor_queue_capacity,
+            options.pin_executor_threads
+        );
+        executor->ExportMetrics("grpc");
+        return std::make_unique<CallbackService>(std::move(impl), executor);
+    }
+    return std::make_unique<SyncService>(std::move(impl));
+}
+
+} // namespace common
+} // namespace saasforge
+
+/**
+ * Per-method adapter bodies. Each service lists its RPCs once as an X-macro
+ * (X(Method, Request, Response)) and expands it with these to build both a
+ * grpc::Service and a grpc::CallbackService forwarding to the same impl_.
+ * The impl call runs in a ResilienceScope carrying the RPC's context and
+ * deadline, so a call a dependency shed ends as UNAVAILABLE rather than
+ * INTERNAL and DbPool can cancel queries the client no longer waits for,
+ * and in a TenantUsageScope charging its CPU, queries and Redis round
+ * trips to the RPC's tenant.
+ */
+#define SAASFORGE_SYNC_UNARY_METHOD(Method, Request, Response)                       \
+    ::grpc::Status Method(                                                            \
+        ::grpc::ServerContext* context, const Request* request, Response* response    \
+    ) override {                                                                      \
+        ::grpc::Status rejection =                                                    \
+            ::saasforge::common::TenantContextInterceptor::CallStatus(context);       \
+        if (!rejection.ok()) {                                                        \
+            return rejection;                                                         \
+        }                                                                             \
+        ::saasforge::common::ScopedTraceContext trace_scope(                          \
+            ::saasforge::common::ServerTraceContext(context));                        \
+        ::saasforge::common::ResilienceScope resilience(context);                     \
+        ::saasforge::common::TenantUsageScope usage(context);                         \
+        return resilience.Finish(impl_->Method(context, request, response));          \
+    }
+
+#define SAASFORGE_CALLBACK_UNARY_METHOD(Method, Request, Response)                   \
+    ::grpc::ServerUnaryReactor* Method(                                               \
+        ::grpc::CallbackServerContext* context, const Request* request,               \
+        Response* response                                                            \
+    ) override {                                                                      \
+        return ::saasforge::common::OffloadUnary(*executor_, context,                 \
+            [impl = impl_, context, request, response]() {                            \
+                ::saasforge::common::ResilienceScope resilience(context);             \
+                ::saasforge::common::TenantUsageScope usage(context);                 \
+                return resilience.Finish(impl->Method(context, request, response));   \
+            });                                                                       \
+    }
+
+/**
+ * Client-streaming RPCs (X(Method, Request, Response)): the impl method
+ * receives the stream in chunks and accumulates into the single response.
+ */
+#define SAASFORGE_SYNC_CLIENT_STREAM_METHOD(Method, Request, Response)               \
+    ::grpc::Status Method(                                                            \
+        ::grpc::ServerContext* context, ::grpc::ServerReader<Request>* reader,        \
+        Response* response                                                            \
+    ) override {                                                                      \
+        ::grpc::Status rejection =                                                    \
+            ::saasforge::common::TenantContextInterceptor::CallStatus(context);       \
+        if (!rejection.ok()) {                                                        \
+            return rejection;                                                         \
+        }                                                                             \
+        ::saasforge::common::ScopedTraceContext trace_scope(                          \
+            ::saasforge::common::ServerTraceContext(context));                        \
+        ::saasforge::common::ResilienceScope resilience(context);                     \
+        ::saasforge::common::TenantUsageScope usage(context);                         \
+        return resilience.Finish(::saasforge::common::ReadClientStream(reader,        \
+            [this, context, response](const std::vector<Request>& chunk) {            \
+                return impl_->Method(context, chunk, response);                       \
+            }));                                                                      \
+    }
+
+#define SAASFORGE_CALLBACK_CLIENT_STREAM_METHOD(Method, Request, Response)           \
+    ::grpc::ServerReadReactor<Request>* Method(                                       \
+        ::grpc::CallbackServerContext* context, Response* response                    \
+    ) override {                                                                      \
+        return ::saasforge::common::OffloadClientStream<Request>(*executor_, context, \
+            [impl = impl_, context, response](const std::vector<Request>& chunk) {    \
+                ::saasforge::common::ResilienceScope resilience(context);             \
+                ::saasforge::common::TenantUsageScope usage(context);                 \
+                return resilience.Finish(impl->Method(context, chunk, response));     \
+            });                                                                       \
+    }
+
+/**
+ * Server-streaming RPCs (X(Method, Request, Response)): the impl method
+ * receives a StreamWriter<Response> and writes responses in chunks.
+ */
+#define SAASFORGE_SYNC_SERVER_STREAM_METHOD(Method, Request, Response)               \
+    ::grpc::Status Method(                                                            \
+        ::grpc::ServerContext* context, const Request* request,                       \
+        ::grpc::ServerWriter<Response>* writer                                        \
+    ) override {                                                                      \
+        ::grpc::Status rejection =                                                    \
+            ::saasforge::common::TenantContextInterceptor::CallStatus(context);       \
+        if (!rejection.ok()) {                                                        \
+            return rejection;                                                         \
+        }                                                                             \
+        ::saasforge::common::ScopedTraceContext trace_scope(                          \
+            ::saasforge::common::ServerTraceContext(context));                        \
+        ::saasforge::common::SyncStreamWriter<Response> stream(writer);               \
+        ::saasforge::common::ResilienceScope resilience(context);                     \
+        ::saasforge::common::TenantUsageScope usage(context);                         \
+        return resilience.Finish(impl_->Method(context, request, stream));            \
+    }
+
+#define SAASFORGE_CALLBACK_SERVER_STREAM_METHOD(Method, Request, Response)           \
+    ::grpc::ServerWriteReactor<Response>* Method(                                     \
+        ::grpc::CallbackServerContext* context, const Request* request                \
+    ) override {                                                                      \
+        return ::saasforge::common::OffloadServerStream<Response>(*executor_, context, \
+            [impl = impl_, context, request](                                         \
+                ::saasforge::common::StreamWriter<Response>& writer) {                \
+                ::saasforge::common::ResilienceScope resilience(context);             \
+                ::saasforge::common::TenantUsageScope usage(context);                 \
+                return resilience.Finish(impl->Method(context, request, writer));     \
+            });                                                                       \
+    }
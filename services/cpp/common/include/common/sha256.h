@@ -0,0 +1,58 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Incremental SHA-256 for streamed content
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Incremental SHA-256 over data that arrives in pieces
+ *
+ * Backed by OpenSSL's EVP digest, which selects the compression function
+ * for the running CPU (SHA-NI where available, otherwise AVX2/AVX/SSSE3),
+ * so hashing an object while it streams costs far less than reading it.
+ * Not thread-safe; use one instance per stream.
+ *
+ * Usage:
+ *   Sha256 hash;
+ *   hash.Update(chunk.data(), chunk.size());
+ *   std::string hex = hash.HexDigest();
+ */
+class Sha256 {
+public:
+    /// @throws std::runtime_error if OpenSSL cannot create the digest context
+    Sha256();
+    ~Sha256();
+
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void Update(const void* data, size_t size);
+
+    /// Lowercase hex digest of everything so far; the hash restarts afterwards
+    std::string HexDigest();
+
+    /// One-shot lowercase hex digest
+    static std::string Hex(std::string_view data);
+
+    /**
+     * Lowercase a client-supplied hex digest
+     *
+     * @return Empty if value is not 64 hex characters
+     */
+    static std::string NormalizeHex(std::string_view value);
+
+private:
+    void* ctx_ = nullptr;  // EVP_MD_CTX*, kept opaque so OpenSSL headers stay out of this header
+};
+
+} // namespace common
+} // namespace saasforge
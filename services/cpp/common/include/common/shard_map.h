@@ -0,0 +1,154 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tenant to database shard placement: consistent hashing plus directory overrides
+ */
+
+#pragma once
+
+#include "common/executor.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * ShardMap options
+ *
+ * FromEnv() reads DB_SHARD_VIRTUAL_NODES, DB_SHARD_MAP_REFRESH_MS and
+ * DB_SHARD_MAP_STALE_AFTER_MS.
+ */
+struct ShardMapOptions {
+    size_t virtual_nodes = 256;                   // Ring points per shard
+    std::chrono::milliseconds refresh{5000};      // Override reload period
+    std::chrono::milliseconds stale_after{15000}; // No successful load for this long: writes refused
+
+    static ShardMapOptions FromEnv();
+};
+
+/**
+ * Where a tenant lives
+ */
+struct TenantPlacement {
+    std::string tenant_id;
+    std::string shard;
+    bool moving = false;    // Being moved by ShardMover: writes are refused
+};
+
+/**
+ * Thrown for writes to a tenant that is being moved between shards;
+ * services map it to UNAVAILABLE, so clients retry after the move
+ */
+class TenantMoving : public std::runtime_error {
+public:
+    explicit TenantMoving(const std::string& tenant_id)
+        : std::runtime_error("Tenant is moving between shards: " + tenant_id) {}
+};
+
+/**
+ * Maps tenant IDs to shard names
+ *
+ * By default a tenant goes to the shard owning its point on a consistent
+ * hash ring (virtual_nodes points per shard), so adding a shard remaps only
+ * about 1/N of the tenants. Explicit placements - large tenants given their
+ * own shard, tenants moved by ShardMover, tenants pinned before the shard
+ * list changed - come from the tenant_shards table on the directory shard
+ * and override the hash. They are reloaded every `refresh`.
+ *
+ * A placement change reaches every process within `stale_after`: one that
+ * has not loaded the overrides for that long is not Fresh(), and
+ * ShardedDbPool refuses its writes. ShardMover waits that long between the
+ * steps of a move.
+ *
+ * Until the overrides have been loaded once Locate() throws, since the hash
+ * alone could route an overridden tenant to the wrong shard. Without a
+ * loader there are no overrides and the map is ready at once.
+ *
+ * Usage:
+ *   ShardMap map({"shard-0", "shard-1"}, loader, ShardMapOptions::FromEnv());
+ *   auto placement = map.Locate(tenant_ctx.tenant_id);
+ */
+class ShardMap {
+public:
+    /// Every explicit placement (the whole tenant_shards table)
+    using Loader = std::function<std::vector<TenantPlacement>()>;
+
+    /**
+     * @param shards Shard names; their order does not affect placement
+     * @param loader Null: hash placement only
+     * @throws std::invalid_argument if `shards` is empty or has duplicates
+     */
+    ShardMap(std::vector<std::string> shards, Loader loader, const ShardMapOptions& options = {});
+    ~ShardMap();
+
+    ShardMap(const ShardMap&) = delete;
+    ShardMap& operator=(const ShardMap&) = delete;
+
+    /**
+     * Placement of a tenant
+     *
+     * @throws std::runtime_error if the overrides were never loaded
+     */
+    TenantPlacement Locate(const std::string& tenant_id) const;
+
+    /// Shard chosen by the hash ring, ignoring overrides
+    const std::string& HashShard(std::string_view tenant_id) const;
+
+    const std::vector<std::string>& Shards() const { return shards_; }
+
+    /**
+     * Reload the overrides now
+     *
+     * @return False if loading failed (logged); the previous overrides are kept
+     */
+    bool Refresh();
+
+    /// Whether the overrides have been loaded (always true without a loader)
+    bool Ready() const;
+
+    /// Whether the overrides were loaded within stale_after (always true without a loader)
+    bool Fresh() const;
+
+    /// Current explicit placements
+    std::vector<TenantPlacement> Overrides() const;
+
+    /// Loads that failed since start
+    uint64_t Failures() const { return failures_.load(); }
+
+    const ShardMapOptions& Options() const { return options_; }
+
+    /// Stop the periodic reload, waiting for one in progress (idempotent)
+    void Shutdown();
+
+    /// Stable 64-bit hash of a key (FNV-1a with a final avalanche)
+    static uint64_t Hash(std::string_view key);
+
+private:
+    std::vector<std::string> shards_;
+    std::vector<std::pair<uint64_t, uint32_t>> ring_;   // (point, shard index), sorted by point
+    Loader load_;
+    ShardMapOptions options_;
+
+    mutable std::shared_mutex overrides_mutex_;
+    std::unordered_map<std::string, TenantPlacement> overrides_;
+    bool loaded_ = false;
+    std::chrono::steady_clock::time_point loaded_at_{};
+
+    std::atomic<uint64_t> failures_{0};
+    uint64_t metrics_collector_ = 0;
+    uint64_t periodic_ = 0;   // Reload on Executor::Background()
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,100 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Online move of a tenant's rows between database shards
+ */
+
+#pragma once
+
+#include "common/sharded_db_pool.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * ShardMover options
+ */
+struct ShardMoveOptions {
+    size_t batch_rows = 1000;                 // Rows copied per INSERT
+    std::chrono::milliseconds settle{1000};   // Added to ShardMap stale_after when waiting for propagation
+};
+
+/**
+ * A table holding tenant rows
+ */
+struct TenantTable {
+    const char* name;
+    const char* filter;    // WHERE clause selecting the tenant's rows, $1 being the tenant ID
+    const char* prepare;   // Run on the target before each batch ($1: the rows as a JSON array), or null
+};
+
+/**
+ * Moves tenants between shards while the services keep running
+ *
+ * Placements are recorded in tenant_shards on the directory shard:
+ *   1. mark the tenant moving (shard = source) and wait until every process
+ *      has seen it: writes are refused, reads stay on the source
+ *   2. wait for in-flight inserts, then copy the tenant's rows from one
+ *      snapshot of the source into the target, in a single transaction
+ *   3. place the tenant on the target, still moving, and wait again: reads
+ *      move to the target
+ *   4. accept writes on the target, delete the rows left on the source
+ * Writes are refused for roughly two propagation waits plus the copy; the
+ * services answer them with UNAVAILABLE and clients retry.
+ *
+ * previous_shard records the source from step 3 until step 4 has deleted its
+ * rows, so running Move() again after a failure resumes where it stopped.
+ *
+ * Must run with the services' DB_SHARD_URLS and DB_SHARD_MAP_* settings:
+ * the waits are derived from their refresh and staleness bounds.
+ */
+class ShardMover {
+public:
+    explicit ShardMover(ShardedDbPool& pools, const ShardMoveOptions& options = {});
+
+    /**
+     * Move a tenant to `target` (or finish an interrupted move there)
+     *
+     * @return Rows copied
+     * @throws std::invalid_argument if `target` is not a configured shard
+     * @throws std::runtime_error if the tenant is being moved elsewhere, or on database errors
+     */
+    size_t Move(const std::string& tenant_id, const std::string& target);
+
+    /**
+     * Record the current shard of every tenant that has no placement
+     *
+     * Run before adding a shard to DB_SHARD_URLS: the hash ring then places
+     * about 1/N of the existing tenants elsewhere, the pinned placements keep
+     * them where their rows are.
+     *
+     * @return Tenants pinned
+     */
+    size_t PinAll();
+
+    /// Tenant-keyed tables in foreign key order (parents first)
+    static const std::vector<TenantTable>& Tables();
+
+private:
+    struct Placement {
+        std::string shard;
+        bool moving = false;
+        std::string previous_shard;
+    };
+
+    Placement Read(const std::string& tenant_id);
+    void Write(const std::string& tenant_id, const Placement& placement);
+    size_t Copy(const std::string& tenant_id, DbPool& source, DbPool& target);
+    void Purge(const std::string& tenant_id, DbPool& pool);
+    void WaitForPropagation(const char* step);
+    std::shared_ptr<DbPool> ShardPool(const std::string& name);
+
+    ShardedDbPool& pools_;
+    ShardMoveOptions options_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,131 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description One DbPool per database shard, chosen by the tenant of the request
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include "common/shard_map.h"
+#include "common/tenant_context.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * ShardedDbPool options
+ *
+ * FromEnv() reads DB_SHARD_URLS ("name=url,name=url"; the first shard is
+ * the directory holding tenant_shards), the DB_POOL_* settings applied to
+ * every shard (see DbPoolOptions) and the DB_SHARD_MAP_* settings (see
+ * ShardMapOptions). Without DB_SHARD_URLS there is one shard, "default",
+ * at `default_url`. DB_REPLICA_URLS only applies to a single shard.
+ */
+struct ShardedDbPoolOptions {
+    std::vector<std::pair<std::string, std::string>> shards;   // (name, connection string)
+    DbPoolOptions pool;
+    ShardMapOptions map;
+
+    static ShardedDbPoolOptions FromEnv(const std::string& default_url);
+};
+
+/**
+ * Connections to the shard that holds a tenant's rows
+ *
+ * Every tenant-keyed table lives on each shard; a tenant's rows are on the
+ * shard ShardMap places it on. Each shard has its own DbPool, metrics
+ * labelled pool=<shard> (unlabelled with a single shard, as before).
+ *
+ * Writes to a tenant that ShardMover is moving throw TenantMoving, and all
+ * writes throw while the shard map is not Fresh(), so no write can land on
+ * the shard a tenant is leaving. Reads are served throughout a move.
+ *
+ * With a single shard there is no directory lookup and everything goes to
+ * that shard's pool, so a deployment without DB_SHARD_URLS behaves exactly
+ * like a plain DbPool.
+ *
+ * Usage:
+ *   auto db = std::make_shared<ShardedDbPool>(ShardedDbPoolOptions::FromEnv(db_url));
+ *   auto conn_guard = db->AcquireConnection(tenant_ctx, __func__);
+ *   pqxx::work txn(*conn_guard);
+ *   ...
+ *   txn.commit();
+ *   db->RecordWrite(tenant_ctx);
+ */
+class ShardedDbPool {
+public:
+    /// Shard name used without DB_SHARD_URLS
+    static constexpr const char* DEFAULT_SHARD = "default";
+
+    /// @throws std::invalid_argument if no shard is configured or names repeat
+    explicit ShardedDbPool(const ShardedDbPoolOptions& options);
+    /// An existing pool as the only shard
+    explicit ShardedDbPool(std::shared_ptr<DbPool> pool);
+    ~ShardedDbPool();
+
+    ShardedDbPool(const ShardedDbPool&) = delete;
+    ShardedDbPool& operator=(const ShardedDbPool&) = delete;
+
+    /**
+     * Pool of the shard to read a tenant's rows from
+     *
+     * @throws std::runtime_error if the shard map is not loaded or names an unknown shard
+     */
+    std::shared_ptr<DbPool> ForRead(const std::string& tenant_id) const;
+
+    /**
+     * Pool of the shard to write a tenant's rows to
+     *
+     * @throws TenantMoving while the tenant is being moved
+     * @throws std::runtime_error if the shard map is stale or names an unknown shard
+     */
+    std::shared_ptr<DbPool> ForWrite(const std::string& tenant_id) const;
+
+    /// Read-write connection on the tenant's shard (see ForWrite)
+    DbPool::ConnectionGuard AcquireConnection(const TenantContext& tenant_ctx, const char* caller = nullptr);
+
+    /// Read-only connection on the tenant's shard, a replica if configured (see ForRead)
+    DbPool::ConnectionGuard AcquireReadConnection(const TenantContext& tenant_ctx, const char* caller = nullptr);
+
+    /// After committing a write: the tenant's reads see it (see DbPool::RecordWrite)
+    void RecordWrite(const TenantContext& tenant_ctx);
+
+    /// Shard holding tenant_shards and cross-tenant tables
+    std::shared_ptr<DbPool> Directory() const { return pools_.front().second; }
+
+    /// Pool of a shard by name; null if unknown
+    std::shared_ptr<DbPool> Shard(const std::string& name) const;
+
+    const ShardMap& Map() const { return *map_; }
+    ShardMap& Map() { return *map_; }
+
+    size_t ShardCount() const { return pools_.size(); }
+
+    /**
+     * Stop the shard map and close every pool
+     *
+     * @return False if connections were still borrowed at the deadline
+     */
+    bool Shutdown(std::chrono::milliseconds timeout);
+
+private:
+    std::shared_ptr<DbPool> Pool(const TenantPlacement& placement) const;
+
+    std::vector<std::pair<std::string, std::shared_ptr<DbPool>>> pools_;
+    std::unique_ptr<ShardMap> map_;
+
+    mutable std::atomic<uint64_t> refused_moving_{0};
+    mutable std::atomic<uint64_t> refused_stale_{0};
+    uint64_t metrics_collector_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
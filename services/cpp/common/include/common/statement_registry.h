@@ -0,0 +1,137 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Named SQL statements prepared once per pooled connection
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+#include "common/tenant_usage.h"
+#include "common/tracing.h"
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Process-wide registry of named SQL statements
+ *
+ * DbPool calls PrepareAll() on every connection it opens, so Postgres parses
+ * and plans each statement once per connection instead of once per query.
+ * Statements register themselves through PreparedStatement objects defined at
+ * namespace scope, i.e. before main() constructs the pool.
+ */
+class StatementRegistry {
+public:
+    struct Entry {
+        std::string name;
+        std::string sql;
+    };
+
+    static StatementRegistry& Global();
+
+    /**
+     * Register a statement
+     *
+     * Registering the same name twice with identical SQL is a no-op.
+     *
+     * @throws std::logic_error if the name is already bound to different SQL
+     */
+    void Add(const std::string& name, const std::string& sql);
+
+    /**
+     * Prepare every registered statement on a connection
+     *
+     * A statement that fails to prepare (e.g. its table is missing in this
+     * database) is logged and skipped; executing it later reports the error
+     * to the caller.
+     *
+     * @return Number of statements prepared
+     */
+    size_t PrepareAll(pqxx::connection& conn) const;
+
+    std::vector<Entry> Entries() const;
+    size_t Size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+/**
+ * Statically registered statement
+ *
+ * Usage (namespace scope in a .cpp):
+ *   const common::PreparedStatement kSelectUser(
+ *       "auth_select_user", "SELECT ... WHERE id = $1");
+ *   auto result = common::ExecPrepared(txn, kSelectUser, user_id);
+ */
+struct PreparedStatement {
+    PreparedStatement(const char* statement_name, const char* statement_sql)
+        : name(statement_name), sql(statement_sql) {
+        StatementRegistry::Global().Add(name, sql);
+    }
+
+    const char* const name;
+    const char* const sql;
+};
+
+/**
+ * Execute a registered statement inside a "db.query" span
+ *
+ * Same as txn.exec_prepared(statement.name, args...); the span carries the
+ * statement name (not the SQL or parameters) and records the error if the
+ * query throws. Inside a TenantUsageScope the query's time and rows are
+ * charged to its tenant.
+ */
+template <typename Transaction, typename... Args>
+pqxx::result ExecPrepared(Transaction& txn, const PreparedStatement& statement, Args&&... args) {
+    Span span("db.query", SpanKind::kClient);
+    span.SetAttribute("db.system", "postgresql");
+    span.SetAttribute("db.statement.name", statement.name);
+    bool accounted = TenantUsageScope::Current() != nullptr;
+    auto started = accounted ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    try {
+        pqxx::result result = txn.exec_prepared(statement.name, std::forward<Args>(args)...);
+        if (accounted) {
+            TenantUsage::ChargeDb(std::chrono::steady_clock::now() - started, static_cast<uint64_t>(result.size()));
+        }
+        return result;
+    } catch (const std::exception& e) {
+        if (accounted) {
+            TenantUsage::ChargeDb(std::chrono::steady_clock::now() - started, 0);
+        }
+        span.SetError(e.what());
+        throw;
+    }
+}
+
+/**
+ * Copy a text column straight into a record field (empty for NULL)
+ *
+ * Assigns from the result's buffer instead of through the temporary that
+ * as<std::string>() builds, and reuses the field's capacity.
+ */
+inline void ReadText(const pqxx::field& field, std::string& out) {
+    if (field.is_null()) {
+        out.clear();
+    } else {
+        out.assign(field.c_str(), field.size());
+    }
+}
+
+/**
+ * Postgres array literal for a batch parameter, e.g. {"a","b\\"c"}
+ *
+ * Every element is quoted, so the literal is valid for any element type;
+ * cast it in SQL ($1::uuid[], $2::int[], ...).
+ */
+std::string ToArrayLiteral(const std::vector<std::string>& values);
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,109 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Allocation-free helpers for building keys and payloads on hot paths
+ */
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Key part Redis Cluster hashes instead of the whole key
+ *
+ * Appended as "{value}". Keys sharing a tag map to one slot, so they can be
+ * pipelined or passed to one script on a cluster, e.g. every key of a user:
+ *   KeyBuilder<> key("refresh:", HashTag{user_id});
+ */
+struct HashTag {
+    std::string_view value;
+};
+
+/**
+ * Short string assembled in a stack buffer, e.g. a Redis key
+ *
+ * Parts are appended into an inline buffer of N bytes; only a result that
+ * does not fit moves to the heap. Integers are written in decimal. View()
+ * stays valid while the builder lives and is not appended to.
+ *
+ * Usage:
+ *   KeyBuilder<> key("blacklist:", jti);
+ *   redis_->get(key.View());
+ */
+template <size_t N = 128>
+class KeyBuilder {
+public:
+    KeyBuilder() = default;
+
+    template <typename... Parts>
+    explicit KeyBuilder(const Parts&... parts) {
+        (Append(parts), ...);
+    }
+
+    KeyBuilder(const KeyBuilder&) = delete;
+    KeyBuilder& operator=(const KeyBuilder&) = delete;
+
+    KeyBuilder& Append(std::string_view part) {
+        if (!on_heap_ && size_ + part.size() <= N) {
+            std::memcpy(inline_ + size_, part.data(), part.size());
+            size_ += part.size();
+            return *this;
+        }
+        if (!on_heap_) {
+            heap_.reserve(size_ + part.size());
+            heap_.assign(inline_, size_);
+            on_heap_ = true;
+        }
+        heap_.append(part);
+        return *this;
+    }
+
+    KeyBuilder& Append(HashTag tag) {
+        return Append("{").Append(tag.value).Append("}");
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+    KeyBuilder& Append(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        return Append(std::string_view(digits, static_cast<size_t>(result.ptr - digits)));
+    }
+
+    std::string_view View() const {
+        return on_heap_ ? std::string_view(heap_) : std::string_view(inline_, size_);
+    }
+
+    std::string ToString() const { return std::string(View()); }
+
+    size_t size() const { return View().size(); }
+
+private:
+    char inline_[N];
+    size_t size_ = 0;
+    bool on_heap_ = false;
+    std::string heap_;
+};
+
+/**
+ * Append value to out as a quoted JSON string, escaping as RFC 8259 requires
+ */
+void AppendJsonString(std::string& out, std::string_view value);
+
+/**
+ * Append value to out with & < > " ' replaced by HTML entities
+ *
+ * Scans 16 bytes at a time (SSE2 where available) and copies clean runs
+ * in one append, so typical text costs little more than a memcpy.
+ */
+void AppendHtmlEscaped(std::string& out, std::string_view value);
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,151 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Stripe operations shared by the mock and the HTTP client
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Subscription status (Requirement C-63)
+ */
+enum class SubscriptionStatus {
+    TRIALING,      // In trial period
+    ACTIVE,        // Active and paid
+    PAST_DUE,      // Payment failed, in grace period
+    CANCELED,      // Canceled by user
+    UNPAID,        // Payment failed after retries
+    PAUSED         // Temporarily paused
+};
+
+/**
+ * Payment intent status
+ */
+enum class PaymentIntentStatus {
+    SUCCEEDED,
+    FAILED,
+    PROCESSING,
+    REQUIRES_ACTION  // SCA/3DS required
+};
+
+/**
+ * Stripe customer
+ */
+struct StripeCustomer {
+    std::string id;              // cus_XXXXX
+    std::string email;
+    std::string tenant_id;
+    std::string default_payment_method;
+    int64_t created;
+};
+
+/**
+ * Stripe subscription
+ */
+struct StripeSubscription {
+    std::string id;              // sub_XXXXX
+    std::string customer_id;
+    std::string plan_id;
+    SubscriptionStatus status;
+    int64_t current_period_start;
+    int64_t current_period_end;
+    int64_t trial_end;
+    bool cancel_at_period_end;
+    double amount;               // Monthly amount in dollars
+    int retry_count;             // Failed payment retry attempts
+};
+
+/**
+ * Stripe payment method
+ */
+struct StripePaymentMethod {
+    std::string id;              // pm_XXXXX
+    std::string type;            // "card", "ach_debit", "sepa_debit"
+    std::string card_last4;
+    std::string card_brand;      // "visa", "mastercard", etc.
+    int exp_month;
+    int exp_year;
+    std::string customer_id;     // Set by AttachPaymentMethod
+};
+
+/**
+ * Stripe invoice
+ */
+struct StripeInvoice {
+    std::string id;              // in_XXXXX
+    std::string customer_id;
+    std::string subscription_id;
+    double amount_due;
+    double amount_paid;
+    std::string status;          // "draft", "open", "paid", "void"
+    int64_t created;
+    int64_t due_date;
+    std::vector<std::string> line_items;
+};
+
+/**
+ * Thrown when Stripe answers HTTP 429 (MockStripeClient: an injected one)
+ */
+class StripeRateLimited : public std::runtime_error {
+public:
+    StripeRateLimited() : std::runtime_error("Stripe rate limit exceeded (429)") {}
+};
+
+/**
+ * Stripe API operations
+ *
+ * Implemented by MockStripeClient (in-memory, for development and tests)
+ * and StripeClient (api.stripe.com), so callers can swap one for the other.
+ * Get* return nullopt when the object does not exist; the other calls throw
+ * std::runtime_error (StripeRateLimited for an exhausted 429).
+ */
+class StripeApi {
+public:
+    virtual ~StripeApi() = default;
+
+    // Customer operations
+    virtual StripeCustomer CreateCustomer(const std::string& email, const std::string& tenant_id) = 0;
+    virtual std::optional<StripeCustomer> GetCustomer(const std::string& customer_id) = 0;
+
+    // Subscription operations
+    virtual StripeSubscription CreateSubscription(
+        const std::string& customer_id,
+        const std::string& plan_id,
+        int trial_days = 0
+    ) = 0;
+    virtual std::optional<StripeSubscription> GetSubscription(const std::string& subscription_id) = 0;
+    virtual StripeSubscription UpdateSubscription(
+        const std::string& subscription_id,
+        const std::string& new_plan_id
+    ) = 0;
+    virtual void CancelSubscription(const std::string& subscription_id, bool cancel_immediately = false) = 0;
+
+    // Payment method operations
+    virtual StripePaymentMethod CreatePaymentMethod(
+        const std::string& type,
+        const std::string& card_number = "",
+        int exp_month = 0,
+        int exp_year = 0
+    ) = 0;
+    virtual void AttachPaymentMethod(const std::string& payment_method_id, const std::string& customer_id) = 0;
+    virtual void DetachPaymentMethod(const std::string& payment_method_id) = 0;
+    virtual std::optional<StripePaymentMethod> GetPaymentMethod(const std::string& payment_method_id) = 0;
+
+    // Invoice operations
+    virtual StripeInvoice CreateInvoice(const std::string& customer_id, const std::string& subscription_id) = 0;
+    virtual std::optional<StripeInvoice> GetInvoice(const std::string& invoice_id) = 0;
+    virtual void FinalizeInvoice(const std::string& invoice_id) = 0;
+    virtual PaymentIntentStatus PayInvoice(const std::string& invoice_id) = 0;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,325 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Asynchronous Stripe API client (libcurl multi, HTTP/2)
+ */
+
+#pragma once
+
+#include "common/stripe_api.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * One Stripe API request
+ */
+struct StripeHttpRequest {
+    std::string method = "GET";      // GET, POST or DELETE
+    std::string path;                // e.g. "/v1/customers/cus_123"
+    std::string body;                // application/x-www-form-urlencoded (POST)
+    std::string idempotency_key;     // POST: same key on every attempt
+    std::string account;             // Stripe-Account (Connect); empty: the platform account
+};
+
+/**
+ * Outcome of one Stripe API request
+ */
+struct StripeHttpResponse {
+    long status = 0;                            // HTTP status; 0 if no response was received
+    std::string body;
+    std::chrono::milliseconds retry_after{0};   // Retry-After header, if any
+    std::optional<bool> should_retry;           // Stripe-Should-Retry header, if any
+    std::string error;                          // Transport error when status is 0
+
+    bool Ok() const { return status >= 200 && status < 300; }
+};
+
+/**
+ * Stripe answered with an error (non-2xx status)
+ */
+class StripeApiError : public std::runtime_error {
+public:
+    StripeApiError(long status, const std::string& code, const std::string& message)
+        : std::runtime_error(message), status_(status), code_(code) {}
+
+    long Status() const { return status_; }
+    const std::string& Code() const { return code_; }   // Stripe error code, e.g. "card_declined"
+
+private:
+    long status_;
+    std::string code_;
+};
+
+/**
+ * Per-call settings for the asynchronous API
+ */
+struct StripeCallOptions {
+    // Propagated to Stripe as Idempotency-Key (suffixed per request when an
+    // operation makes several), e.g. the caller's RPC idempotency key, so a
+    // retried RPC cannot create a second object. Empty: generated per call.
+    std::string idempotency_key;
+    std::string account;             // Stripe-Account (Connect)
+};
+
+/**
+ * StripeClient options
+ *
+ * FromEnv() reads STRIPE_API_BASE, STRIPE_API_VERSION, STRIPE_MAX_CONNECTIONS,
+ * STRIPE_CONNECT_TIMEOUT_MS, STRIPE_REQUEST_TIMEOUT_MS, STRIPE_READ_RATE,
+ * STRIPE_WRITE_RATE, STRIPE_MAX_ATTEMPTS, STRIPE_RETRY_BUDGET_RATIO and
+ * STRIPE_RETRY_BUDGET_MIN_PER_SECOND.
+ */
+struct StripeClientOptions {
+    std::string api_base = "https://api.stripe.com";
+    std::string api_version = "2024-06-20";     // Stripe-Version; pins the response shapes parsed here
+    size_t max_connections = 4;                 // Per host; HTTP/2 multiplexes requests over each
+    std::chrono::milliseconds connect_timeout{3000};
+    std::chrono::milliseconds request_timeout{30000};
+
+    // Requests per second per account, with a burst of one second's worth.
+    // 0: Stripe's default limits for the key (live 100 + 100, test 25 + 25).
+    double read_rate = 0;
+    double write_rate = 0;
+
+    int max_attempts = 3;                               // Per request, counting the first
+    std::chrono::milliseconds initial_backoff{500};     // Doubled per retry, with jitter
+    std::chrono::milliseconds max_backoff{5000};        // Also caps Retry-After
+
+    // Retries across all requests may add at most `ratio` of the first-attempt
+    // traffic, plus `min_per_second`, so an outage cannot multiply load on Stripe
+    double retry_budget_ratio = 0.1;
+    double retry_budget_min_per_second = 5;
+
+    static StripeClientOptions FromEnv();
+};
+
+/**
+ * Client counters
+ */
+struct StripeClientStats {
+    uint64_t requests = 0;          // Attempts handed to the transport
+    uint64_t retries = 0;
+    uint64_t coalesced = 0;         // Get* calls that joined a request already in flight
+    uint64_t rate_limited = 0;      // Attempts delayed by the local rate limiter
+    uint64_t budget_exhausted = 0;  // Retryable failures returned because the retry budget was empty
+    size_t in_flight = 0;
+    size_t queued = 0;              // Waiting for a rate limit token or a backoff to elapse
+};
+
+/**
+ * Token bucket of retries shared by every request of a client
+ *
+ * Each first attempt deposits `ratio` tokens and time adds `min_per_second`;
+ * each retry withdraws one. Holds at most ten seconds' worth of the floor
+ * (and at least 10 tokens), so a long quiet spell cannot bank a retry storm.
+ */
+class RetryBudget {
+public:
+    RetryBudget(double ratio, double min_per_second);
+
+    void OnRequest();
+    bool TryRetry();
+
+private:
+    void RefillLocked(std::chrono::steady_clock::time_point now);
+
+    std::mutex mutex_;
+    double ratio_;
+    double min_per_second_;
+    double capacity_;
+    double balance_;
+    std::chrono::steady_clock::time_point refilled_at_;
+};
+
+/**
+ * Stripe API client
+ *
+ * Requests never occupy a thread while in flight: the libcurl transport
+ * drives every request from one thread over a multi handle, with
+ * keep-alive HTTP/2 connections (concurrent requests multiplex over one
+ * TLS connection). The blocking StripeApi methods wait on the asynchronous
+ * ones; RPC handlers that can continue later use the *Async calls or Send().
+ *
+ * Every attempt first takes a token from its account's read or write
+ * bucket (Stripe's limits are per account and per mode), so the client
+ * slows down before Stripe answers 429; attempts without a token wait in a
+ * queue rather than on the caller's thread. Connection errors, 409, 429 and
+ * 5xx are retried with exponential backoff (honouring Retry-After and
+ * Stripe-Should-Retry) while both max_attempts and the shared RetryBudget
+ * allow. POSTs carry one Idempotency-Key across all their attempts, so a
+ * retry can never apply a write twice.
+ *
+ * Concurrent GetCustomer/GetSubscription calls for the same id share one
+ * in-flight request.
+ *
+ * Usage:
+ *   StripeClient stripe(stripe_secret_key, StripeClientOptions::FromEnv());
+ *   auto customer = stripe.GetCustomerAsync(customer_id);  // shared_future
+ *   auto invoice = stripe.CreateInvoice(customer_id, subscription_id);
+ *
+ * Thread-safe.
+ */
+class StripeClient : public StripeApi {
+public:
+    /// Called exactly once per request, on any thread
+    using Completion = std::function<void(StripeHttpResponse)>;
+
+    /// Starts a request and returns without waiting for it
+    using Transport = std::function<void(const StripeHttpRequest& request, Completion done)>;
+
+    /**
+     * @param api_key Secret key (sk_live_/sk_test_/rk_...); selects the default rate limits
+     * @param transport Null: CurlTransport()
+     */
+    StripeClient(const std::string& api_key, const StripeClientOptions& options = {},
+                 Transport transport = nullptr);
+    ~StripeClient() override;
+
+    StripeClient(const StripeClient&) = delete;
+    StripeClient& operator=(const StripeClient&) = delete;
+
+    // StripeApi (blocking)
+    StripeCustomer CreateCustomer(const std::string& email, const std::string& tenant_id) override;
+    std::optional<StripeCustomer> GetCustomer(const std::string& customer_id) override;
+    StripeSubscription CreateSubscription(
+        const std::string& customer_id,
+        const std::string& plan_id,
+        int trial_days = 0
+    ) override;
+    std::optional<StripeSubscription> GetSubscription(const std::string& subscription_id) override;
+    StripeSubscription UpdateSubscription(
+        const std::string& subscription_id,
+        const std::string& new_plan_id
+    ) override;
+    void CancelSubscription(const std::string& subscription_id, bool cancel_immediately = false) override;
+    StripePaymentMethod CreatePaymentMethod(
+        const std::string& type,
+        const std::string& card_number = "",
+        int exp_month = 0,
+        int exp_year = 0
+    ) override;
+    void AttachPaymentMethod(const std::string& payment_method_id, const std::string& customer_id) override;
+    void DetachPaymentMethod(const std::string& payment_method_id) override;
+    std::optional<StripePaymentMethod> GetPaymentMethod(const std::string& payment_method_id) override;
+    StripeInvoice CreateInvoice(const std::string& customer_id, const std::string& subscription_id) override;
+    std::optional<StripeInvoice> GetInvoice(const std::string& invoice_id) override;
+    void FinalizeInvoice(const std::string& invoice_id) override;
+    PaymentIntentStatus PayInvoice(const std::string& invoice_id) override;
+
+    // Non-blocking
+
+    /// Coalesced: concurrent calls for one id (and account) share a request
+    std::shared_future<std::optional<StripeCustomer>> GetCustomerAsync(
+        const std::string& customer_id, const StripeCallOptions& call = {});
+    std::shared_future<std::optional<StripeSubscription>> GetSubscriptionAsync(
+        const std::string& subscription_id, const StripeCallOptions& call = {});
+
+    std::future<StripeCustomer> CreateCustomerAsync(
+        const std::string& email, const std::string& tenant_id, const StripeCallOptions& call = {});
+    std::future<StripeSubscription> CreateSubscriptionAsync(
+        const std::string& customer_id, const std::string& plan_id, int trial_days = 0,
+        const StripeCallOptions& call = {});
+    std::future<PaymentIntentStatus> PayInvoiceAsync(
+        const std::string& invoice_id, const StripeCallOptions& call = {});
+
+    /**
+     * Any API request, with rate limiting, retries and an idempotency key
+     * for POSTs (request.idempotency_key, or a generated one)
+     *
+     * @param done Final response; never called with an exception
+     */
+    void Send(StripeHttpRequest request, Completion done);
+
+    /**
+     * Fail queued requests and wait for in-flight ones (idempotent)
+     */
+    void Shutdown();
+
+    StripeClientStats GetStats() const;
+
+    /**
+     * libcurl transport: one thread, one multi handle, HTTP/2 with
+     * connection reuse; adds Authorization, Stripe-Version,
+     * Idempotency-Key and Stripe-Account headers
+     */
+    static Transport CurlTransport(const std::string& api_key, const StripeClientOptions& options);
+
+    /// application/x-www-form-urlencoded body (Stripe's bracket syntax in names is kept)
+    static std::string FormEncode(const std::vector<std::pair<std::string, std::string>>& params);
+
+private:
+    struct Call {
+        StripeHttpRequest request;
+        bool write = false;
+        int attempt = 0;
+        Completion done;
+    };
+
+    struct Bucket {
+        double read_tokens = 0;
+        double write_tokens = 0;
+        std::chrono::steady_clock::time_point refilled_at{};
+    };
+
+    template <typename T>
+    using InFlight = std::unordered_map<std::string, std::shared_future<std::optional<T>>>;
+
+    template <typename T, typename Parse>
+    std::shared_future<std::optional<T>> Coalesce(InFlight<T>& in_flight, StripeHttpRequest request,
+                                                   Parse parse);
+
+    /// Send() and wait for the response; throws StripeApiError / StripeRateLimited on failure
+    StripeHttpResponse Execute(StripeHttpRequest request, const std::string& not_found_message = "");
+
+    void Enqueue(std::shared_ptr<Call> call, std::chrono::steady_clock::time_point at);
+    void SchedulerLoop();
+    void OnResponse(const std::shared_ptr<Call>& call, StripeHttpResponse response);
+
+    /// Zero if a token was taken, else the wait until one is available
+    std::chrono::steady_clock::duration TakeTokenLocked(
+        const std::string& account, bool write, std::chrono::steady_clock::time_point now);
+
+    std::chrono::milliseconds Backoff(int attempt, std::chrono::milliseconds retry_after) const;
+
+    StripeClientOptions options_;
+    Transport transport_;
+    RetryBudget retry_budget_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::multimap<std::chrono::steady_clock::time_point, std::shared_ptr<Call>> queue_;
+    std::unordered_map<std::string, Bucket> buckets_;   // By account
+    size_t in_flight_ = 0;
+    bool shutdown_ = false;
+
+    std::mutex coalesce_mutex_;
+    InFlight<StripeCustomer> customer_lookups_;
+    InFlight<StripeSubscription> subscription_lookups_;
+
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> retries_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> rate_limited_{0};
+    std::atomic<uint64_t> budget_exhausted_{0};
+
+    std::thread scheduler_;
+};
+
+} // namespace common
+} // namespace saasforge
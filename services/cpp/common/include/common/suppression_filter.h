@@ -0,0 +1,154 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-memory Bloom filter over the email suppression list
+ */
+
+#pragma once
+
+#include "common/bloom_filter.h"
+#include "common/db_pool.h"
+#include "common/event_bus.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * SuppressionFilter options
+ *
+ * FromEnv() reads EMAIL_SUPPRESSION_FILTER_EXPECTED,
+ * EMAIL_SUPPRESSION_FILTER_REFRESH_S and EMAIL_SUPPRESSION_FILTER_REBUILD_S.
+ */
+struct SuppressionFilterOptions {
+    size_t expected_addresses = 1000000;        // ~1.8 MB at the default false positive rate
+    double false_positive_rate = 0.001;
+    std::chrono::seconds refresh{30};           // Incremental reload (catches additions the bus missed)
+    std::chrono::seconds rebuild{3600};         // Full reload: drops removed addresses, resizes
+    std::chrono::seconds lookback{60};          // Overlap of incremental reloads (in-flight inserts)
+
+    static SuppressionFilterOptions FromEnv();
+};
+
+/**
+ * Local negative cache of email_suppression
+ *
+ * EmailQueue::IsAddressSuppressed() asks the filter first and only queries
+ * the table when the filter reports a possible match, so enqueueing to an
+ * address that was never suppressed costs no database round trip.
+ *
+ * The list is loaded whole on start, then reloaded incrementally (rows
+ * whose created_at is past the last load, less `lookback`) every
+ * `refresh`. Every `rebuild` the filter is rebuilt from scratch, dropping
+ * addresses removed from the table and resizing if it outgrew
+ * expected_addresses.
+ *
+ * Add() - EmailQueue calls it after every committed suppression - also
+ * publishes the address on SUPPRESSED_TOPIC, and every replica's filter
+ * adds what it receives there, so no reload is needed for it. When the
+ * bus reports missed events the filter refreshes at once.
+ *
+ * Until the first load succeeds MightBeSuppressed() is always true, so
+ * callers fall back to the table. An address suppressed on another replica
+ * is missed until its event arrives (or for up to `refresh` if the event
+ * was lost).
+ *
+ * Usage:
+ *   auto event_bus = std::make_shared<EventBus>(redis_client, EventBusOptions::FromEnv());
+ *   auto suppressions = std::make_shared<SuppressionFilter>(db_pool, event_bus,
+ *       SuppressionFilterOptions::FromEnv());
+ *   EmailQueue queue(db_pool, notifier, EmailQueueOptions::FromEnv(), suppressions);
+ */
+class SuppressionFilter {
+public:
+    /// EventBus topic carrying suppressed addresses
+    static constexpr const char* SUPPRESSED_TOPIC = "email_suppression:added";
+
+    /// Addresses read by one load, and the cursor the next incremental load starts from
+    struct Batch {
+        std::vector<std::string> addresses;
+        std::string cursor;
+    };
+
+    /// Loads addresses suppressed since `cursor`, or every address if it is empty
+    using Loader = std::function<Batch(const std::string& cursor)>;
+
+    /// @param event_bus Null: this process's additions and the reloads only
+    SuppressionFilter(std::shared_ptr<DbPool> db_pool, std::shared_ptr<EventBus> event_bus,
+                      const SuppressionFilterOptions& options = {});
+    /// Custom loader (tests)
+    SuppressionFilter(Loader loader, std::shared_ptr<EventBus> event_bus,
+                      const SuppressionFilterOptions& options = {});
+    ~SuppressionFilter();
+
+    SuppressionFilter(const SuppressionFilter&) = delete;
+    SuppressionFilter& operator=(const SuppressionFilter&) = delete;
+
+    /// False only if the address is definitely not suppressed
+    bool MightBeSuppressed(const std::string& email_address) const;
+
+    /// Record an address suppressed by this process and publish it to the other replicas
+    void Add(const std::string& email_address);
+
+    /**
+     * Load what was suppressed since the last load (everything, if none)
+     *
+     * @return False if loading failed (logged); the filter is kept as is
+     */
+    bool Refresh();
+
+    /**
+     * Replace the filter with a full load
+     *
+     * @return False if loading failed (logged); the filter is kept as is
+     */
+    bool Rebuild();
+
+    /// Whether a load has succeeded
+    bool Ready() const;
+
+    /// Addresses in the filter (including repeats loaded by overlapping reloads)
+    size_t Count() const;
+
+    /// Loads that failed since start
+    uint64_t Failures() const { return failures_.load(); }
+
+    /// Stop the subscription and the reload thread (idempotent)
+    void Shutdown();
+
+private:
+    bool Load(bool full);
+    void ReloadLoop();
+    // Add to the filter (no-op before the first load)
+    void AddLocal(const std::string& email_address);
+
+    Loader load_;
+    std::shared_ptr<EventBus> event_bus_;
+    uint64_t subscription_ = 0;
+    SuppressionFilterOptions options_;
+
+    mutable std::shared_mutex filter_mutex_;
+    std::unique_ptr<BloomFilter> filter_;
+    std::string cursor_;
+
+    std::mutex load_mutex_;     // One load at a time
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool shutdown_ = false;
+    bool reset_ = false;        // The bus may have missed additions: refresh now
+    std::atomic<uint64_t> failures_{0};
+    std::thread thread_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <grpcpp/grpcpp.h>
+#include <map>
 #include <memory>
+#include <vector>
 
 namespace saasforge {
 namespace common {
@@ -18,23 +21,78 @@ struct TenantContext {
     bool validated;  // Indicates if tenant_id was validated against JWT
 };
 
+// Tenant context of one RPC plus the interceptor's verdict on it
+struct TenantCall {
+    TenantContext context{};
+    grpc::Status rejection;  // Non-OK: answer with this instead of running the handler
+};
+
+using ServerMetadata = std::multimap<grpc::string_ref, grpc::string_ref>;
+
+// Configuration for TenantContextInterceptorFactory
+struct TenantContextOptions {
+    // Full method names ("/saasforge.auth.AuthService/Login") callable without
+    // a tenant or user; every other /saasforge.* method requires one
+    std::vector<std::string> public_methods;
+
+    // Validates Bearer tokens when set; otherwise the gateway's x-tenant-id /
+    // x-user-* headers are trusted as before
+    std::shared_ptr<JwtValidator> jwt_validator;
+};
+
+// Parses and validates the tenant context once per RPC, when the initial
+// metadata arrives, and keeps it for the handlers (ForCall) and the service
+// adapters (CallStatus), which reject unauthenticated calls before any
+// handler runs.
 class TenantContextInterceptor : public grpc::experimental::Interceptor {
 public:
     explicit TenantContextInterceptor(grpc::experimental::ServerRpcInfo* info);
+    TenantContextInterceptor(grpc::experimental::ServerRpcInfo* info,
+                             std::shared_ptr<const TenantContextOptions> options);
+    ~TenantContextInterceptor() override;
 
     void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override;
 
+    // Tenant context of the RPC as parsed by the interceptor. Without an
+    // interceptor (handlers called directly, e.g. in tests) it is extracted
+    // from the context's metadata as ExtractFromMetadata does.
+    static std::shared_ptr<const TenantContext> ForCall(grpc::ServerContextBase* context);
+
+    // OK unless the interceptor rejected the RPC
+    static grpc::Status CallStatus(const grpc::ServerContextBase* context);
+
+    // Parse tenant context from request metadata without copying it; requires
+    // a tenant or user unless require_identity is false
+    static TenantCall Parse(const ServerMetadata& metadata, JwtValidator* jwt_validator, bool require_identity);
+
     // Extract and validate tenant context from JWT token in metadata
     static TenantContext ExtractFromMetadata(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         std::shared_ptr<JwtValidator> jwt_validator = nullptr
     );
 
     // Extract without validation (for backward compatibility, use with caution)
-    static TenantContext ExtractFromMetadataUnsafe(grpc::ServerContext* context);
+    static TenantContext ExtractFromMetadataUnsafe(grpc::ServerContextBase* context);
+
+private:
+    static std::string_view ExtractJwtFromMetadata(const ServerMetadata& metadata);
+    static TenantContext ParseHeaders(const ServerMetadata& metadata);
+
+    const grpc::ServerContextBase* context_;
+    std::string method_;
+    std::shared_ptr<const TenantContextOptions> options_;
+    bool stored_ = false;
+};
+
+// Creates a TenantContextInterceptor per RPC; installed by AddServerInterceptors()
+class TenantContextInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    explicit TenantContextInterceptorFactory(TenantContextOptions options = {});
+
+    grpc::experimental::Interceptor* CreateServerInterceptor(grpc::experimental::ServerRpcInfo* info) override;
 
 private:
-    static std::string ExtractJwtFromMetadata(grpc::ServerContext* context);
+    std::shared_ptr<const TenantContextOptions> options_;
 };
 
 } // namespace common
@@ -0,0 +1,92 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Deficit round-robin share of a batch across tenants, with per-tenant rate caps
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Fair-share configuration
+ */
+struct TenantFairSchedulerOptions {
+    int quantum = 20;                   // Items a tenant earns per round (equal weights)
+    double rate_per_second = 0;         // Per-tenant sustained cap, 0 = uncapped
+    double burst = 100;                 // Token bucket depth when capped
+
+    /// EMAIL_QUEUE_TENANT_QUANTUM, EMAIL_QUEUE_TENANT_RATE_PER_S, EMAIL_QUEUE_TENANT_BURST
+    static TenantFairSchedulerOptions FromEnv();
+};
+
+/**
+ * Splits a batch's capacity across the tenants that have work
+ *
+ * Deficit round-robin: each round every active tenant earns `quantum`
+ * credits and is granted up to its credit, so one tenant with a million
+ * queued rows gets the same share as one with ten. Rounds start after the
+ * tenant served last; a turn cut short by the batch filling up resumes,
+ * with its remaining credit, in the next Allocate().
+ *
+ * Grants are also drawn from a per-tenant token bucket when
+ * rate_per_second > 0; the cap is per scheduler (i.e. per worker process).
+ *
+ * Thread-safe.
+ */
+class TenantFairScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Allocation {
+        std::vector<std::pair<std::string, int>> quotas;   // Tenant → items to claim, all > 0
+        /// Set when rate caps held a tenant back: time until one has a token again
+        std::chrono::milliseconds throttled_for{0};
+    };
+
+    explicit TenantFairScheduler(TenantFairSchedulerOptions options = {});
+
+    /**
+     * Share up to `capacity` items among `tenants` (each with work queued)
+     *
+     * Tenants not listed have no backlog; their credit is dropped.
+     */
+    Allocation Allocate(const std::vector<std::string>& tenants, int capacity, Clock::time_point now = Clock::now());
+
+    /**
+     * Return `unused` of a tenant's grant: it had fewer items than granted
+     *
+     * The tenant's queue is empty, so (as in DRR) its remaining credit is
+     * dropped and the unused tokens go back to its bucket.
+     */
+    void Refund(const std::string& tenant, int unused);
+
+    const TenantFairSchedulerOptions& Options() const { return options_; }
+
+private:
+    struct Bucket {
+        double tokens = 0;
+        Clock::time_point refilled{};
+    };
+
+    TenantFairSchedulerOptions options_;
+    std::mutex mutex_;
+    std::map<std::string, Bucket> buckets_;     // Only when capped; full buckets are dropped
+    std::string last_served_;                   // Next round starts after this tenant
+    std::string resume_tenant_;                 // Turn interrupted by a full batch
+    int resume_credit_ = 0;
+
+    bool Capped() const { return options_.rate_per_second > 0; }
+    void Refill(Bucket& bucket, Clock::time_point now) const;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,81 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tenant-wide session revocation epochs, mirrored on every replica
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "redis_client.h"
+
+namespace saasforge {
+namespace common {
+
+/**
+ * "Every session of tenant T started before time X is revoked"
+ *
+ * Revoking a tenant writes one field of a Redis hash and publishes it, so
+ * it costs the same for 10 users as for 100k: nothing per session is
+ * touched. Each replica keeps the hash in memory (reloaded on every
+ * (re)subscribe) and checks access tokens (iat) and refresh-token families
+ * (start time) against it without a round trip.
+ *
+ * Entries are dropped lazily, on reload, once older than retention: by
+ * then every session they cover has expired or was rejected.
+ *
+ * Times are Unix milliseconds. Access tokens carry whole seconds, so
+ * tokens minted in the same second as a revocation are rejected too.
+ *
+ * Usage:
+ *   TenantRevocations revocations(redis_client);
+ *   revocations.Revoke(tenant_id);                        // Admin call, any replica
+ *   if (revocations.IsRevoked(tenant_id, issued_at_ms)) { ... }
+ */
+class TenantRevocations {
+public:
+    static constexpr const char* CHANNEL = "session:tenant_revoked";
+    static constexpr const char* KEY = "session:tenant_revocations";
+
+    /// redis_client may be null (local only, e.g. tests)
+    explicit TenantRevocations(std::shared_ptr<RedisClient> redis_client,
+                               int64_t retention_seconds = 30 * 24 * 3600);
+    ~TenantRevocations();
+
+    TenantRevocations(const TenantRevocations&) = delete;
+    TenantRevocations& operator=(const TenantRevocations&) = delete;
+
+    /// Revoke every session of the tenant started until now; returns the revocation time
+    int64_t Revoke(const std::string& tenant_id);
+
+    /// Whether a session of the tenant started at issued_at_ms is revoked
+    bool IsRevoked(std::string_view tenant_id, int64_t issued_at_ms) const;
+
+    /// Record a revocation (from pub/sub, or written by this process)
+    void Note(const std::string& tenant_id, int64_t revoked_at_ms);
+
+    /// Number of tenants with a live revocation
+    size_t Size() const;
+
+    static int64_t NowMillis();
+
+private:
+    void Reload();
+
+    std::shared_ptr<RedisClient> redis_client_;
+    int64_t retention_ms_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, int64_t> revoked_at_;
+    std::atomic<bool> empty_{true};   // Lets the request path skip the lock
+    uint64_t subscription_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,207 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-tenant CPU, database and Redis accounting in heavy-hitter sketches
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace grpc {
+class ServerContextBase;
+}
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Space-Saving heavy-hitter sketch (Metwally et al.)
+ *
+ * Tracks at most `capacity` keys. A new key arriving when the sketch is
+ * full replaces the smallest one and inherits its count as `error`, so
+ * every count is an overestimate by at most `error`, and any key whose
+ * true weight exceeds Total() / capacity is guaranteed to be tracked.
+ * Not thread-safe.
+ */
+class SpaceSaving {
+public:
+    struct Entry {
+        std::string key;
+        uint64_t count = 0;   // Upper bound of the key's weight
+        uint64_t error = 0;   // count - error is a lower bound
+    };
+
+    explicit SpaceSaving(size_t capacity);
+
+    // The index views keys in entries_: moving keeps them in place, copying would not
+    SpaceSaving(SpaceSaving&&) = default;
+    SpaceSaving& operator=(SpaceSaving&&) = default;
+    SpaceSaving(const SpaceSaving&) = delete;
+    SpaceSaving& operator=(const SpaceSaving&) = delete;
+
+    void Add(std::string_view key, uint64_t weight);
+
+    /// The n heaviest keys, heaviest first
+    std::vector<Entry> Top(size_t n) const;
+
+    /// Upper bound of a key's weight (the smallest count if it is not tracked and the sketch is full)
+    uint64_t Estimate(std::string_view key) const;
+
+    /// Sum of every weight added
+    uint64_t Total() const { return total_; }
+
+    size_t Size() const { return entries_.size(); }
+
+    void Clear();
+
+private:
+    size_t capacity_;
+    uint64_t total_ = 0;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string_view, size_t> index_;   // Views into entries_[i].key
+    std::set<std::pair<uint64_t, size_t>> by_count_;       // (count, entry index), smallest first
+};
+
+/// What is accounted per tenant
+enum class TenantResource {
+    CPU_MICROS = 0,    // Thread CPU time of the RPC's handler
+    DB_MICROS,         // Wall time of its queries (ExecPrepared)
+    DB_ROWS,           // Rows its queries returned
+    REDIS_OPS,         // RedisClient round trips (a pipelined batch is one)
+};
+
+constexpr size_t TENANT_RESOURCE_COUNT = 4;
+
+/// One scope's usage
+struct TenantUsageSample {
+    std::array<uint64_t, TENANT_RESOURCE_COUNT> values{};
+
+    uint64_t& operator[](TenantResource resource) { return values[static_cast<size_t>(resource)]; }
+    uint64_t operator[](TenantResource resource) const { return values[static_cast<size_t>(resource)]; }
+};
+
+/**
+ * TenantUsage options
+ *
+ * FromEnv() reads TENANT_USAGE_CAPACITY, TENANT_USAGE_TOP and
+ * TENANT_USAGE_WINDOW_S.
+ */
+struct TenantUsageOptions {
+    size_t capacity = 256;            // Tenants tracked per resource and window
+    size_t top = 10;                  // Tenants exported per resource
+    std::chrono::seconds window{60};
+
+    static TenantUsageOptions FromEnv();
+};
+
+/**
+ * Heaviest tenants per resource, over fixed windows
+ *
+ * Each resource has a SpaceSaving sketch for the window being filled and
+ * one for the last complete window; memory stays at 2 x capacity tenants
+ * per resource however many tenants there are. Top() and Estimate() read
+ * the last complete window, which is stable for `window` and is what
+ * admission control should compare against (Share() > what a tenant's
+ * plan allows, say).
+ *
+ * Global() exports, for the last complete window,
+ *   saasforge_tenant_cpu_seconds{tenant_id}     top `top` tenants
+ *   saasforge_tenant_db_seconds{tenant_id}
+ *   saasforge_tenant_db_rows{tenant_id}
+ *   saasforge_tenant_redis_ops{tenant_id}
+ * as gauges (the window's totals, not rates), so the series set stays
+ * bounded as tenants come and go.
+ *
+ * Usage arrives through TenantUsageScope; Record() takes one lock per scope.
+ */
+class TenantUsage {
+public:
+    /// Process-wide instance (options from the environment), exporting metrics
+    static TenantUsage& Global();
+
+    explicit TenantUsage(const TenantUsageOptions& options = {});
+
+    TenantUsage(const TenantUsage&) = delete;
+    TenantUsage& operator=(const TenantUsage&) = delete;
+
+    /// Add a tenant's usage to the current window (ignored for an empty tenant id)
+    void Record(std::string_view tenant_id, const TenantUsageSample& sample);
+
+    /// Heaviest tenants of the last complete window
+    std::vector<SpaceSaving::Entry> Top(TenantResource resource, size_t n) const;
+
+    /// Upper bound of a tenant's usage in the last complete window
+    uint64_t Estimate(TenantResource resource, std::string_view tenant_id) const;
+
+    /// Estimate() over the window's total (0 when nothing was used)
+    double Share(TenantResource resource, std::string_view tenant_id) const;
+
+    const TenantUsageOptions& Options() const { return options_; }
+
+    /// Charge the current TenantUsageScope of this thread, if any (DbPool, RedisClient)
+    static void ChargeDb(std::chrono::nanoseconds elapsed, uint64_t rows);
+    static void ChargeRedis(uint64_t ops = 1);
+
+private:
+    void ExportMetrics();
+    // Start a new window if the current one is over; mutex_ held
+    void Rotate(std::chrono::steady_clock::time_point now) const;
+
+    TenantUsageOptions options_;
+    mutable std::mutex mutex_;
+    mutable std::vector<SpaceSaving> current_;    // One per resource
+    mutable std::vector<SpaceSaving> previous_;
+    mutable std::chrono::steady_clock::time_point window_start_;
+};
+
+/**
+ * Accounts the work done on this thread to a tenant
+ *
+ * The service adapters (common/service_adapter.h) open one around every
+ * handler call, next to its ResilienceScope, with the RPC's tenant. The
+ * thread's CPU time between construction and destruction is charged, and
+ * so is every query and Redis round trip made meanwhile; the destructor
+ * records it all in one TenantUsage::Record(). A nested scope charges its
+ * own tenant, and its CPU time is not charged again to the enclosing one.
+ * Calls without a tenant (Login and other public methods) are not recorded.
+ */
+class TenantUsageScope {
+public:
+    /// Tenant of the RPC (TenantContextInterceptor::ForCall)
+    explicit TenantUsageScope(grpc::ServerContextBase* context, TenantUsage& usage = TenantUsage::Global());
+    explicit TenantUsageScope(std::string tenant_id, TenantUsage& usage = TenantUsage::Global());
+    ~TenantUsageScope();
+
+    TenantUsageScope(const TenantUsageScope&) = delete;
+    TenantUsageScope& operator=(const TenantUsageScope&) = delete;
+
+    /// Innermost scope of this thread; null outside one
+    static TenantUsageScope* Current();
+
+    /// Add to this scope's usage
+    void Charge(TenantResource resource, uint64_t amount) { sample_[resource] += amount; }
+
+    const std::string& TenantId() const { return tenant_id_; }
+
+private:
+    TenantUsage& usage_;
+    std::string tenant_id_;
+    TenantUsageScope* previous_;
+    TenantUsageSample sample_;
+    uint64_t cpu_start_;
+    uint64_t nested_cpu_ = 0;   // CPU charged by nested scopes
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,229 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Hierarchical timing wheel for in-memory retry scheduling
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Hierarchical timing wheel (hashed by due tick, cascading as in Linux timers)
+ *
+ * LEVELS wheels of SLOTS slots each: level 0 covers the next SLOTS ticks
+ * one slot per tick, level 1 the next SLOTS^2 ticks SLOTS ticks per slot,
+ * and so on. Schedule() is O(1) at any distance; Advance() visits one slot
+ * per elapsed tick (skipping ticks while the levels below the next
+ * cascade are empty) and moves a higher-level slot down only when the
+ * wheel below wraps, so each item is touched at most LEVELS times before
+ * it fires. With the default 1 ms resolution the four levels reach 4.6 hours;
+ * items further out are parked in the last level and re-placed as it turns.
+ *
+ * Items never fire early: a due time is rounded up to the next tick, the
+ * current time down. Not thread-safe; meant to be owned by one worker thread.
+ *
+ * Usage:
+ *   TimingWheel<Retry> wheel;
+ *   wheel.Schedule(retry, std::chrono::steady_clock::now() + std::chrono::seconds(5));
+ *   for (auto& due : wheel.Advance(std::chrono::steady_clock::now())) { ... }
+ */
+template <typename T>
+class TimingWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+
+    explicit TimingWheel(Clock::time_point start = Clock::now(),
+                         std::chrono::milliseconds resolution = std::chrono::milliseconds(1))
+        : start_(start), resolution_(resolution.count() > 0 ? resolution : std::chrono::milliseconds(1)) {}
+
+    /// Hold `item` until `due`; a due time already reached fires on the next Advance()
+    void Schedule(T item, Clock::time_point due) {
+        Place(Entry{TickAtOrAfter(due), std::move(item)});
+        ++size_;
+    }
+
+    /**
+     * Move the wheel to `now`
+     *
+     * @return Items due at or before `now`, in due order across ticks
+     */
+    std::vector<T> Advance(Clock::time_point now) {
+        std::vector<T> fired;
+        Take(ready_, fired);
+
+        // An empty wheel jumps straight to `now`: there is nothing to cascade
+        uint64_t target = TickAtOrBefore(now);
+        while (current_ < target && size_ > 0) {
+            // With the lowest levels empty nothing fires before the first
+            // non-empty level turns its next slot: skip straight to it
+            size_t level = 0;
+            while (level + 1 < LEVELS && counts_[level] == 0) {
+                ++level;
+            }
+            if (level > 0) {
+                uint64_t turn = ((current_ >> (level * SLOT_BITS)) + 1) << (level * SLOT_BITS);
+                current_ = std::max(current_, std::min(target, turn) - 1);
+            }
+
+            ++current_;
+            Cascade();
+            Take(ready_, fired);   // Cascaded items due on exactly this tick
+            auto& slot = slots_[0][current_ & (SLOTS - 1)];
+            counts_[0] -= slot.size();
+            Take(slot, fired);
+        }
+        current_ = std::max(current_, target);
+        return fired;
+    }
+
+    /**
+     * Earliest time Advance() can return something
+     *
+     * Exact for items within level 0; otherwise the next cascade of a
+     * non-empty slot, which is never later than the item it holds.
+     *
+     * @return nullopt when the wheel is empty
+     */
+    std::optional<Clock::time_point> NextDue() const {
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        if (!ready_.empty()) {
+            return TimeOf(current_);
+        }
+        std::optional<uint64_t> next;
+        for (size_t level = 0; level < LEVELS; ++level) {
+            size_t shift = level * SLOT_BITS;
+            uint64_t base = current_ >> shift;
+            for (uint64_t offset = 1; offset <= SLOTS; ++offset) {
+                if (!slots_[level][(base + offset) & (SLOTS - 1)].empty()) {
+                    uint64_t tick = (base + offset) << shift;
+                    if (!next || tick < *next) {
+                        next = tick;
+                    }
+                    break;
+                }
+            }
+        }
+        return TimeOf(*next);
+    }
+
+    /// Remove and return every item, due or not (shutdown)
+    std::vector<T> Drain() {
+        std::vector<T> items;
+        items.reserve(size_);
+        Take(ready_, items);
+        for (auto& level : slots_) {
+            for (auto& slot : level) {
+                Take(slot, items);
+            }
+        }
+        counts_.fill(0);
+        return items;
+    }
+
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+private:
+    struct Entry {
+        uint64_t due;   // Tick
+        T item;
+    };
+
+    uint64_t TickAtOrBefore(Clock::time_point time) const {
+        if (time <= start_) {
+            return 0;
+        }
+        return static_cast<uint64_t>((time - start_) / resolution_);
+    }
+
+    uint64_t TickAtOrAfter(Clock::time_point time) const {
+        if (time <= start_) {
+            return 0;
+        }
+        auto elapsed = time - start_;
+        auto ticks = static_cast<uint64_t>(elapsed / resolution_);
+        return elapsed % resolution_ == Clock::duration::zero() ? ticks : ticks + 1;
+    }
+
+    void Take(std::vector<Entry>& entries, std::vector<T>& out) {
+        for (auto& entry : entries) {
+            out.push_back(std::move(entry.item));
+        }
+        size_ -= entries.size();
+        entries.clear();
+    }
+
+    Clock::time_point TimeOf(uint64_t tick) const {
+        return start_ + std::chrono::duration_cast<Clock::duration>(resolution_ * tick);
+    }
+
+    void Place(Entry entry) {
+        if (entry.due <= current_) {
+            ready_.push_back(std::move(entry));
+            return;
+        }
+        // Lowest level whose span covers the distance; the slot is hashed by
+        // the due tick itself, so it is reached exactly when that level turns to it
+        uint64_t delta = entry.due - current_;
+        size_t level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t{1} << ((level + 1) * SLOT_BITS))) {
+            ++level;
+        }
+        uint64_t due = entry.due;
+        uint64_t span = uint64_t{1} << (LEVELS * SLOT_BITS);
+        if (delta >= span) {
+            due = current_ + span - 1;  // Beyond the last level: re-placed when its slot comes round
+        }
+        slots_[level][(due >> (level * SLOT_BITS)) & (SLOTS - 1)].push_back(std::move(entry));
+        ++counts_[level];
+    }
+
+    // On entering tick current_: each level whose lower neighbour wrapped
+    // empties its current slot into the levels below
+    void Cascade() {
+        for (size_t level = 1; level < LEVELS; ++level) {
+            uint64_t below = current_ >> ((level - 1) * SLOT_BITS);
+            if ((below & (SLOTS - 1)) != 0) {
+                break;
+            }
+            auto& slot = slots_[level][(current_ >> (level * SLOT_BITS)) & (SLOTS - 1)];
+            if (slot.empty()) {
+                continue;
+            }
+            std::vector<Entry> moved;
+            moved.swap(slot);
+            counts_[level] -= moved.size();
+            for (auto& entry : moved) {
+                Place(std::move(entry));
+            }
+        }
+    }
+
+    Clock::time_point start_;
+    std::chrono::milliseconds resolution_;
+    uint64_t current_ = 0;
+    size_t size_ = 0;
+    std::vector<Entry> ready_;
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> slots_;
+    std::array<size_t, LEVELS> counts_{};   // Entries per level
+};
+
+} // namespace common
+} // namespace saasforge
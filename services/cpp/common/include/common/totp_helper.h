@@ -63,6 +63,63 @@ public:
         int window = 1
     );
 
+    /**
+     * Validate TOTP code at a given time
+     *
+     * @param secret Base32-encoded secret
+     * @param code 6-digit TOTP code from user
+     * @param unix_time Seconds since the epoch
+     * @param window Number of 30-second intervals to check
+     * @return true if code is valid within window
+     * @throws std::invalid_argument if the secret is not Base32
+     */
+    static bool ValidateCodeAt(
+        const std::string& secret,
+        const std::string& code,
+        int64_t unix_time,
+        int window = 1
+    );
+
+    /**
+     * Validate TOTP code and report which time step it belongs to
+     *
+     * Callers that must reject reuse store the returned counter and refuse
+     * codes at or below it (see RedisClient::SetIfGreater).
+     *
+     * @param secret Base32-encoded secret
+     * @param code 6-digit TOTP code from user
+     * @param window Number of 30-second intervals to check (default: 1)
+     * @return Time counter (Unix time / 30) the code matched, nullopt if invalid
+     */
+    static std::optional<uint64_t> VerifyCode(
+        const std::string& secret,
+        const std::string& code,
+        int window = 1
+    );
+
+    /**
+     * VerifyCode() at a given time
+     *
+     * The secret is decoded and keyed into one HMAC context, which is reused
+     * for every counter in the window; codes are compared as integers.
+     *
+     * @throws std::invalid_argument if the secret is not Base32
+     */
+    static std::optional<uint64_t> VerifyCodeAt(
+        const std::string& secret,
+        const std::string& code,
+        int64_t unix_time,
+        int window = 1
+    );
+
+    /**
+     * How long a used counter must be remembered to reject its code
+     *
+     * @param window Window passed to VerifyCode()
+     * @return Seconds a code stays acceptable after its time step began
+     */
+    static int64_t ReplayWindowSeconds(int window = 1);
+
     /**
      * Generate a set of backup codes
      *
@@ -94,43 +151,15 @@ public:
     static bool VerifyBackupCode(const std::string& code, const std::string& hash);
 
 private:
-    /**
-     * Generate TOTP code for a specific time counter
-     *
-     * @param secret Base32-encoded secret
-     * @param time_counter Unix timestamp divided by time step (30s)
-     * @return 6-digit TOTP code
-     */
-    static std::string GenerateTotpCode(const std::string& secret, uint64_t time_counter);
-
     /**
      * Decode Base32 string to raw bytes
      *
      * @param base32 Base32-encoded string
      * @return Decoded byte vector
+     * @throws std::invalid_argument if the string is not Base32
      */
     static std::vector<uint8_t> DecodeBase32(const std::string& base32);
 
-    /**
-     * Encode raw bytes to Base32 string
-     *
-     * @param data Raw byte vector
-     * @return Base32-encoded string
-     */
-    static std::string EncodeBase32(const std::vector<uint8_t>& data);
-
-    /**
-     * Compute HMAC-SHA1
-     *
-     * @param key Secret key bytes
-     * @param message Message bytes
-     * @return HMAC-SHA1 digest (20 bytes)
-     */
-    static std::vector<uint8_t> HmacSha1(
-        const std::vector<uint8_t>& key,
-        const std::vector<uint8_t>& message
-    );
-
     /**
      * URL-encode a string
      *
@@ -144,6 +173,9 @@ private:
 
     // TOTP code length (6 digits)
     static constexpr int CODE_LENGTH = 6;
+
+    // 10^CODE_LENGTH
+    static constexpr uint32_t CODE_MODULUS = 1000000;
 };
 
 } // namespace common
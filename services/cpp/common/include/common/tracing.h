@@ -0,0 +1,302 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Request tracing with W3C traceparent propagation, tail sampling and batched OTLP export
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+using TraceId = std::array<uint8_t, 16>;
+using SpanId = std::array<uint8_t, 8>;
+
+/**
+ * Identity of a span as carried across process boundaries
+ */
+struct SpanContext {
+    TraceId trace_id{};
+    SpanId span_id{};
+    bool sampled = false;
+
+    /// Both ids non-zero
+    bool IsValid() const;
+
+    std::string TraceIdHex() const;
+    std::string SpanIdHex() const;
+
+    /// W3C traceparent header value, "00-<trace id>-<span id>-<flags>"
+    std::string ToTraceparent() const;
+
+    /// Parse a traceparent header; nullopt if malformed or all-zero
+    static std::optional<SpanContext> FromTraceparent(std::string_view header);
+};
+
+enum class SpanKind { kInternal = 1, kServer = 2, kClient = 3 };   // OTLP enum values
+
+/**
+ * A finished span, as handed to the exporter
+ */
+struct SpanData {
+    std::string name;
+    SpanKind kind = SpanKind::kInternal;
+    TraceId trace_id{};
+    SpanId span_id{};
+    SpanId parent_span_id{};                 // All zero for a root span
+    int64_t start_unix_nano = 0;
+    int64_t end_unix_nano = 0;
+    bool error = false;
+    std::string status_message;
+    std::vector<std::pair<std::string, std::string>> attributes;
+};
+
+/**
+ * Tracer options
+ *
+ * FromEnv() reads OTEL_EXPORTER_OTLP_ENDPOINT (unset = tracing off),
+ * OTEL_SERVICE_NAME, TRACE_SAMPLE_RATIO, TRACE_SLOW_MS,
+ * TRACE_MAX_SPANS_PER_TRACE, TRACE_QUEUE_CAPACITY and
+ * TRACE_FLUSH_INTERVAL_MS.
+ */
+struct TracerOptions {
+    std::string otlp_endpoint;                          // e.g. http://otel-collector:4318
+    std::string service_name = "saasforge";
+    double sample_ratio = 0.01;                         // Head sampling of new traces
+    std::chrono::milliseconds slow_threshold{250};      // Always keep slower traces (0 = off)
+    bool keep_errors = true;                            // Always keep traces with an error span
+    size_t max_spans_per_trace = 128;
+    size_t queue_capacity = 512;                        // Kept traces awaiting export
+    size_t batch_size = 64;                             // Traces per OTLP request
+    std::chrono::milliseconds flush_interval{1000};
+
+    static TracerOptions FromEnv();
+};
+
+struct TracerStats {
+    uint64_t traces_started = 0;
+    uint64_t traces_kept = 0;            // Head sampled, slow or failed
+    uint64_t traces_dropped = 0;         // Kept but the export queue was full
+    uint64_t spans_exported = 0;
+    uint64_t spans_dropped = 0;          // Over max_spans_per_trace
+    uint64_t export_failures = 0;
+};
+
+class Tracer;
+
+namespace tracing_detail {
+
+// Spans of one trace collected in this process until its root span ends
+struct TraceState {
+    Tracer* tracer = nullptr;
+    TraceId trace_id{};
+    bool sampled = false;
+
+    std::mutex mutex;
+    std::vector<SpanData> spans;
+    bool error = false;
+    bool finished = false;       // Root span ended
+    bool kept = false;           // Sampling decision, valid once finished
+};
+
+} // namespace tracing_detail
+
+/**
+ * Handle to the active span of a trace; empty when nothing is traced
+ *
+ * Copy it to carry a trace to another thread and install it there with a
+ * ScopedTraceContext. Executor does this for every task it runs.
+ */
+class TraceContext {
+public:
+    TraceContext() = default;
+
+    /// Context active on the calling thread
+    static TraceContext Current();
+
+    bool Active() const { return trace_ != nullptr; }
+
+    /// Ids for propagation (invalid when not active)
+    SpanContext GetSpanContext() const;
+
+private:
+    friend class Span;
+    friend class ScopedTraceContext;
+
+    TraceContext(std::shared_ptr<tracing_detail::TraceState> trace, const SpanId& span_id)
+        : trace_(std::move(trace)), span_id_(span_id) {}
+
+    std::shared_ptr<tracing_detail::TraceState> trace_;
+    SpanId span_id_{};
+};
+
+/**
+ * Makes a context current on this thread, restoring the previous one
+ */
+class ScopedTraceContext {
+public:
+    explicit ScopedTraceContext(TraceContext context);
+    ~ScopedTraceContext();
+
+    ScopedTraceContext(const ScopedTraceContext&) = delete;
+    ScopedTraceContext& operator=(const ScopedTraceContext&) = delete;
+
+private:
+    TraceContext previous_;
+};
+
+/**
+ * A timed operation within a trace
+ *
+ * Span("db.query") starts a child of the current span and makes itself
+ * current until it ends; with no active trace it records nothing, so
+ * untraced work (background loops, unsampled-and-fast requests' siblings)
+ * costs one thread-local read. Spans must end on the thread that started
+ * them, in reverse order (RAII scopes do this naturally).
+ *
+ * Every span of an active trace is recorded, sampled or not, because the
+ * decision to keep a trace is made when its root span ends: head-sampled
+ * traces, traces slower than slow_threshold and traces with an error are
+ * exported, the rest are discarded in memory.
+ *
+ * Usage:
+ *   Span span("argon2.verify");
+ *   span.SetAttribute("hash.algorithm", "argon2id");
+ *   if (failed) span.SetError("hash mismatch");
+ */
+class Span {
+public:
+    /// Not recording
+    Span() = default;
+
+    /// Child of the current span; records nothing if no trace is active
+    explicit Span(std::string_view name, SpanKind kind = SpanKind::kInternal);
+    ~Span();
+
+    Span(Span&& other) noexcept;
+    /// Ends this span first
+    Span& operator=(Span&& other) noexcept;
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    bool Recording() const { return trace_ != nullptr; }
+
+    void SetAttribute(std::string_view key, std::string_view value);
+    void SetAttribute(std::string_view key, int64_t value);
+
+    /// Mark the span failed; a failed span keeps its trace when keep_errors is set
+    void SetError(std::string_view message);
+
+    /// End now instead of at destruction (idempotent)
+    void End();
+
+    /// Context for children started on other threads
+    TraceContext Context() const;
+
+private:
+    friend class Tracer;
+
+    std::shared_ptr<tracing_detail::TraceState> trace_;
+    SpanData data_;
+    std::chrono::steady_clock::time_point start_;
+    bool root_ = false;
+    bool activated_ = false;
+    TraceContext previous_;
+};
+
+/**
+ * Creates traces and exports the ones worth keeping
+ *
+ * Kept traces are queued (bounded; a full queue drops the trace and counts
+ * it) and a background thread sends them in batches of batch_size traces
+ * every flush_interval as OTLP/HTTP JSON to <otlp_endpoint>/v1/traces, so
+ * request threads never wait on the collector.
+ */
+class Tracer {
+public:
+    using Exporter = std::function<void(const std::vector<SpanData>& spans)>;
+
+    /// Exports to options.otlp_endpoint; disabled when it is empty
+    explicit Tracer(const TracerOptions& options);
+
+    /// Custom exporter (tests); always enabled
+    Tracer(const TracerOptions& options, Exporter exporter);
+
+    ~Tracer();
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    /// Process-wide tracer configured from the environment
+    static Tracer& Global();
+
+    bool Enabled() const { return static_cast<bool>(exporter_); }
+
+    /**
+     * Start the root span of an incoming request
+     *
+     * Continues the caller's trace when traceparent is valid (its sampled
+     * flag is honoured), otherwise starts a new trace and head-samples it.
+     * The span is not made current: it usually ends on another thread than
+     * the one running the handler. Returns a non-recording span when
+     * tracing is disabled.
+     */
+    Span StartServerSpan(std::string_view name, std::string_view traceparent);
+
+    /// Export everything queued, on the calling thread
+    void Flush();
+
+    /// Stop the export thread after a final flush (idempotent)
+    void Shutdown();
+
+    TracerStats GetStats() const;
+
+    /// OTLP/JSON ExportTraceServiceRequest body
+    static std::string ToOtlpJson(const std::vector<SpanData>& spans, const std::string& service_name);
+
+private:
+    friend class Span;
+
+    bool HeadSample(const TraceId& trace_id) const;
+    void FinishTrace(tracing_detail::TraceState& trace, const SpanData& root, std::chrono::nanoseconds duration);
+    void Enqueue(std::vector<SpanData> spans);
+    void ExportLoop();
+    void ExportPending();
+
+    TracerOptions options_;
+    Exporter exporter_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::vector<SpanData>> queue_;
+    std::mutex export_mutex_;                  // One export at a time
+
+    std::atomic<uint64_t> traces_started_{0};
+    std::atomic<uint64_t> traces_kept_{0};
+    std::atomic<uint64_t> traces_dropped_{0};
+    std::atomic<uint64_t> spans_exported_{0};
+    std::atomic<uint64_t> spans_dropped_{0};
+    std::atomic<uint64_t> export_failures_{0};
+
+    bool shutdown_ = false;                    // Guarded by queue_mutex_
+    std::thread thread_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,44 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server interceptor starting a span per RPC from the incoming traceparent
+ */
+
+#pragma once
+
+#include "common/tracing.h"
+#include <grpcpp/support/server_interceptor.h>
+
+namespace grpc {
+class ServerContextBase;
+}
+
+namespace saasforge {
+namespace common {
+
+/**
+ * Creates a TracingInterceptor for every RPC while tracing is enabled
+ *
+ * The interceptor reads the W3C traceparent from the request metadata,
+ * starts the server span (continuing the caller's trace when present),
+ * and ends it with the RPC's status code. Handlers pick the span up with
+ * ServerTraceContext(context); the service adapters do this for every
+ * method, so spans started inside a handler become its children.
+ */
+class TracingInterceptorFactory : public grpc::experimental::ServerInterceptorFactoryInterface {
+public:
+    explicit TracingInterceptorFactory(Tracer& tracer = Tracer::Global());
+
+    grpc::experimental::Interceptor* CreateServerInterceptor(grpc::experimental::ServerRpcInfo* info) override;
+
+private:
+    Tracer& tracer_;
+};
+
+/**
+ * Server span of an RPC, empty if it is not traced
+ */
+TraceContext ServerTraceContext(const grpc::ServerContextBase* context);
+
+} // namespace common
+} // namespace saasforge
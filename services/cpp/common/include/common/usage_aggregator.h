@@ -0,0 +1,190 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Write-behind usage aggregation with a local write-ahead log
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * UsageAggregator options
+ *
+ * FromEnv() reads USAGE_FLUSH_INTERVAL_MS, USAGE_FLUSH_MAX_RECORDS,
+ * USAGE_WAL_DIR and USAGE_WAL_FSYNC.
+ */
+struct UsageAggregatorOptions {
+    std::chrono::milliseconds flush_interval{1000};
+    size_t flush_max_records = 10000;   // Events since the last flush that trigger an early one
+    std::string wal_dir;                // Empty: no WAL (buffered usage is lost on crash)
+    bool wal_fsync = true;              // fdatasync before Record() returns (group commit)
+
+    static UsageAggregatorOptions FromEnv();
+};
+
+/**
+ * One metered event
+ */
+struct UsageEvent {
+    std::string tenant_id;
+    std::string subscription_id;
+    std::string metric_name;
+    int64_t quantity = 0;
+    int64_t timestamp = 0;   // Unix seconds (0 = now)
+};
+
+/**
+ * Summed usage for (tenant, subscription, metric, minute)
+ */
+struct UsageBucket {
+    std::string tenant_id;
+    std::string subscription_id;
+    std::string metric_name;
+    int64_t minute = 0;      // Unix seconds, truncated to the minute
+    int64_t quantity = 0;
+};
+
+struct UsageAggregatorStats {
+    uint64_t recorded = 0;          // Events accepted
+    uint64_t flushed_batches = 0;
+    uint64_t flushed_buckets = 0;
+    uint64_t failed_flushes = 0;
+    size_t buffered_buckets = 0;    // In memory, not yet handed to the sink
+    size_t pending_batches = 0;     // Handed off, waiting for a successful write
+};
+
+/**
+ * Coalesces usage events in memory and writes them in batches
+ *
+ * Events are summed per (tenant, subscription, metric, minute), so a
+ * sidecar sending thousands of api_calls per second produces one row per
+ * minute rather than one per event. Every flush_interval, or after
+ * flush_max_records events, the buffer is swapped out and written by the
+ * sink. The default sink COPYs the batch into usage_records and, in the
+ * same transaction, adds it to the minute, hour and billing-period rollups
+ * (usage_rollup_*) that usage queries and invoicing read.
+ *
+ * Durability: Record() appends each event to the current WAL segment before
+ * returning (concurrent callers share one fdatasync). A flush closes the
+ * segment and deletes it only after the sink committed; a failed write is
+ * retried in order on the next flush. On startup, segments left by a
+ * previous process are replayed. The segment name is the batch id passed to
+ * the sink, which records it in the same transaction, so a segment replayed
+ * after its batch was already committed is not applied twice.
+ *
+ * Usage:
+ *   auto usage = std::make_shared<UsageAggregator>(db_pool, UsageAggregatorOptions::FromEnv());
+ *   usage->Record({tenant_id, subscription_id, "api_calls", 1, now});
+ */
+class UsageAggregator {
+public:
+    /// Writes one batch; must be idempotent per batch_id. Throws on failure.
+    using Sink = std::function<void(const std::string& batch_id, const std::vector<UsageBucket>& buckets)>;
+
+    UsageAggregator(std::shared_ptr<DbPool> db_pool, const UsageAggregatorOptions& options = {});
+
+    /// Custom sink (tests)
+    UsageAggregator(Sink sink, const UsageAggregatorOptions& options = {});
+
+    ~UsageAggregator();
+
+    UsageAggregator(const UsageAggregator&) = delete;
+    UsageAggregator& operator=(const UsageAggregator&) = delete;
+
+    /**
+     * Buffer an event (durable in the WAL when this returns)
+     *
+     * @throws std::invalid_argument for non-positive quantity, empty fields,
+     *         fields containing tabs/newlines, or metric names over 100 chars
+     * @throws std::runtime_error if the WAL cannot be written
+     */
+    void Record(const UsageEvent& event);
+
+    /// Buffer several events with one WAL write and sync
+    void Record(const std::vector<UsageEvent>& events);
+
+    /// The checks Record() applies; throws std::invalid_argument
+    static void Validate(const UsageEvent& event);
+
+    /**
+     * Flush now
+     *
+     * @return True if nothing is left pending
+     */
+    bool Flush();
+
+    /// Stop the flush thread after a final flush (idempotent)
+    void Shutdown();
+
+    UsageAggregatorStats GetStats() const;
+
+    /// Truncate a Unix timestamp to its minute (0 means now)
+    static int64_t MinuteOf(int64_t timestamp);
+
+private:
+    struct Batch {
+        std::string id;
+        std::string wal_path;   // Empty when the WAL is disabled
+        std::vector<UsageBucket> buckets;
+    };
+
+    void FlushLoop();
+    void Recover();
+    void OpenSegmentLocked();
+    void Accumulate(std::unordered_map<std::string, UsageBucket>& buckets, const UsageEvent& event, int64_t minute);
+    void SyncWal(uint64_t segment, uint64_t offset);
+    bool FlushPending();
+    std::string NewBatchId();
+
+    static void WriteToDatabase(DbPool& db_pool, const std::string& batch_id, const std::vector<UsageBucket>& buckets);
+
+    Sink sink_;
+    UsageAggregatorOptions options_;
+
+    // Buffer and current WAL segment
+    mutable std::mutex mutex_;
+    std::condition_variable flush_cv_;
+    std::condition_variable sync_cv_;
+    std::unordered_map<std::string, UsageBucket> buckets_;
+    size_t records_since_flush_ = 0;
+    std::string segment_id_;
+    std::string segment_path_;
+    int wal_fd_ = -1;
+    uint64_t segment_ = 0;          // Incremented on every rotation
+    uint64_t wal_offset_ = 0;
+    uint64_t synced_offset_ = 0;
+    bool syncing_ = false;
+    uint64_t next_sequence_ = 0;    // Orders ids created within one millisecond
+
+    // Batches handed off but not yet written; flushes are serialized
+    std::mutex flush_mutex_;
+    std::deque<Batch> pending_;
+
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> flushed_batches_{0};
+    std::atomic<uint64_t> flushed_buckets_{0};
+    std::atomic<uint64_t> failed_flushes_{0};
+    std::atomic<size_t> pending_count_{0};
+
+    std::atomic<bool> shutdown_{false};
+    std::thread flush_thread_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,107 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Startup warm-up gating the gRPC health status
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <grpcpp/health_check_service_interface.h>
+
+namespace saasforge {
+namespace common {
+
+class ChannelPool;
+class DbPool;
+class RedisClient;
+
+/**
+ * Warm-up options
+ *
+ * FromEnv() reads WARMUP_TIMEOUT_S and WARMUP_RETRY_MS.
+ */
+struct WarmupOptions {
+    std::chrono::seconds timeout{60};         // Required steps still failing by then fail the warm-up
+    std::chrono::milliseconds retry{1000};    // Between attempts of a failed required step
+
+    static WarmupOptions FromEnv();
+};
+
+/**
+ * Work done between BuildAndStart() and taking traffic
+ *
+ * Steps run concurrently, each on its own thread (they mostly wait on
+ * connects and round trips). A required step - reaching a dependency the
+ * service cannot work without - is retried until it succeeds or `timeout`
+ * passes; an optional one (priming a cache, a self-test) runs once and a
+ * failure is logged only, since the service works without it, just cold.
+ *
+ * Run() drives the default gRPC health service: the server ("") reports
+ * NOT_SERVING until every required step has succeeded, so readiness probes
+ * (grpc_health_probe -addr=:50051) keep a cold pod out of rotation.
+ * LIVENESS_SERVICE reports SERVING throughout, for liveness probes
+ * (grpc_health_probe -service=liveness) that must not restart a pod for
+ * being slow to warm up.
+ *
+ * Usage:
+ *   grpc::EnableDefaultHealthCheckService(true);   // before creating the ServerBuilder
+ *   ...
+ *   std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+ *   Warmup warmup(WarmupOptions::FromEnv());
+ *   warmup.Add("database", Warmup::PingDatabase(db_pool), true);
+ *   warmup.Add("redis", Warmup::ConnectRedis(redis_client), true);
+ *   warmup.Add("service", [&] { service->WarmUp(); });
+ *   if (!warmup.Run(server->GetHealthCheckService())) { ... }
+ */
+class Warmup {
+public:
+    /// Health service name that is SERVING as soon as the server is
+    static constexpr const char* LIVENESS_SERVICE = "liveness";
+
+    /// Per attempt of a ConnectChannels() step
+    static constexpr std::chrono::seconds CHANNEL_CONNECT_TIMEOUT{5};
+
+    /// Throws on failure
+    using Step = std::function<void()>;
+
+    explicit Warmup(const WarmupOptions& options = {});
+
+    void Add(std::string name, Step step, bool required = false);
+
+    /**
+     * Run every step and report SERVING if the required ones succeeded
+     *
+     * @param health Default health service of the server (may be null)
+     * @return False if a required step kept failing; the server stays NOT_SERVING
+     */
+    bool Run(grpc::HealthCheckServiceInterface* health);
+
+    /// SELECT 1 on a pooled connection (opened, with statements prepared, by the pool)
+    static Step PingDatabase(std::shared_ptr<DbPool> db_pool);
+
+    /// RedisClient::Warm(): every pooled connection open, scripts loaded
+    static Step ConnectRedis(std::shared_ptr<RedisClient> redis_client);
+
+    /// ChannelPool::Connect(): every pooled channel to `target` READY
+    static Step ConnectChannels(std::shared_ptr<ChannelPool> channels, std::string target);
+
+private:
+    struct Entry {
+        std::string name;
+        Step step;
+        bool required;
+    };
+
+    bool RunStep(const Entry& entry, std::chrono::steady_clock::time_point deadline) const;
+
+    WarmupOptions options_;
+    std::vector<Entry> steps_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -8,9 +8,16 @@
 
 #include <string>
 #include <memory>
+#include <chrono>
 #include <optional>
+#include <utility>
 #include <vector>
 #include "db_pool.h"
+#include "dns_cache.h"
+#include "payload_codec.h"
+#include "queue_notifier.h"
+#include "record_batch.h"
+#include "webhook_subscriptions.h"
 
 namespace saasforge {
 namespace common {
@@ -50,6 +57,51 @@ struct WebhookDeliveryRecord {
     int64_t scheduled_at;
     int64_t delivered_at;
     std::string error_message;
+    int batch_max_events = 0;   // Webhook's batch mode; below 2 it is sent alone
+    int batch_window_ms = 0;
+    std::string payload_data{}; // Claimed payload still encoded (bytea output) until DecodePayload(); empty if inline
+};
+
+/**
+ * Claimed deliveries, column by column (WebhookDelivery::ClaimBatch)
+ */
+using WebhookDeliveryBatch = RecordBatch<WebhookDeliveryRecord,
+    &WebhookDeliveryRecord::id, &WebhookDeliveryRecord::tenant_id, &WebhookDeliveryRecord::webhook_id,
+    &WebhookDeliveryRecord::event_type, &WebhookDeliveryRecord::payload, &WebhookDeliveryRecord::payload_data,
+    &WebhookDeliveryRecord::url, &WebhookDeliveryRecord::signature, &WebhookDeliveryRecord::status,
+    &WebhookDeliveryRecord::retry_count, &WebhookDeliveryRecord::http_status_code,
+    &WebhookDeliveryRecord::created_at, &WebhookDeliveryRecord::scheduled_at,
+    &WebhookDeliveryRecord::delivered_at, &WebhookDeliveryRecord::error_message,
+    &WebhookDeliveryRecord::batch_max_events, &WebhookDeliveryRecord::batch_window_ms>;
+
+/**
+ * Outcome of one delivery attempt, for the batch Mark*Batch() calls
+ */
+struct WebhookAttemptResult {
+    std::string delivery_id;
+    int http_status = 0;         // 0 for connection errors/timeouts
+    std::string error_message;
+    bool held = false;           // Failure whose retry the caller holds in memory (MarkFailedBatch)
+    std::string batch_id{};      // Shared by the members of one batch POST (MarkFailedBatch)
+};
+
+/**
+ * Result of QueueEvent(): the stored event and one delivery per subscriber
+ */
+struct QueuedWebhookEvent {
+    std::string event_id;
+    int64_t created_at = 0;
+    std::vector<std::pair<std::string, std::string>> deliveries;  // (delivery ID, webhook ID)
+};
+
+/**
+ * One event for QueueEvents(): a webhook_events row and a delivery per subscriber
+ */
+struct WebhookEventFanout {
+    std::string tenant_id;
+    std::string event_type;
+    std::string payload;
+    std::vector<WebhookSubscription> subscribers;
 };
 
 /**
@@ -67,7 +119,18 @@ struct WebhookDeliveryRecord {
  */
 class WebhookDelivery {
 public:
-    explicit WebhookDelivery(std::shared_ptr<DbPool> db_pool);
+    /// NOTIFY channel QueueDelivery()/QueueEvent() signal; pass it to the QueueNotifier
+    static constexpr const char* NOTIFY_CHANNEL = "webhook_deliveries";
+
+    /**
+     * Payloads of PayloadCodecOptions::min_size bytes or more are stored
+     * deflated in payload_blobs, once per distinct content (PayloadCodec,
+     * options from the environment); claims return them still encoded.
+     *
+     * @param db_pool Connection pool
+     * @param notifier Optional listener; without it WaitForBatch() polls
+     */
+    explicit WebhookDelivery(std::shared_ptr<DbPool> db_pool, std::shared_ptr<QueueNotifier> notifier = nullptr);
 
     /**
      * Queue a webhook for delivery
@@ -86,13 +149,84 @@ public:
     );
 
     /**
-     * Get next batch of webhooks ready to deliver
+     * Queue one event for every subscribed webhook in a single statement
+     *
+     * The payload is stored once (webhook_events) and referenced by the
+     * delivery rows. Subscribers that fail URL validation, or that are no
+     * longer active when the insert runs, get no delivery. Deliveries to
+     * batch-mode webhooks are left unsigned: WebhookDispatcher signs each
+     * batch once when it sends it.
+     *
+     * @param tenant_id Tenant ID for isolation
+     * @param event_type Event type (e.g., "subscription.created")
+     * @param payload JSON payload
+     * @param subscribers Webhooks registered for event_type (WebhookSubscriptionIndex)
+     * @return Event ID and the deliveries created
+     */
+    QueuedWebhookEvent QueueEvent(
+        const std::string& tenant_id,
+        const std::string& event_type,
+        const std::string& payload,
+        const std::vector<WebhookSubscription>& subscribers
+    );
+
+    /**
+     * Queue many events, for any tenants, in the caller's transaction
+     *
+     * The multi-row form of QueueEvent() used by OutboxRelay: one statement
+     * inserts every event and every delivery, and one NOTIFY covers them.
+     * Subscribers are filtered as in QueueEvent(); an event left with none
+     * is not stored.
+     *
+     * @param txn Transaction to insert in (committed by the caller)
+     * @param events Events with their subscribers (WebhookSubscriptionIndex)
+     * @return Number of deliveries created
+     */
+    size_t QueueEvents(pqxx::work& txn, const std::vector<WebhookEventFanout>& events);
+
+    /**
+     * Claim the next batch of webhooks ready to deliver
+     *
+     * Payloads kept in payload_blobs come back encoded in payload_data
+     * (payload is then empty): the sender decodes each one with
+     * DecodePayload() only when it is about to go out, so rows deferred or
+     * released again are never inflated.
+     *
+     * @param batch_size Maximum webhooks to retrieve
+     * @return Claimed deliveries, in columns with their text in one buffer
+     */
+    WebhookDeliveryBatch ClaimBatch(int batch_size = 10);
+
+    /**
+     * ClaimBatch() as one WebhookDeliveryRecord per row
      *
      * @param batch_size Maximum webhooks to retrieve
      * @return Vector of webhook deliveries
      */
     std::vector<WebhookDeliveryRecord> GetNextBatch(int batch_size = 10);
 
+    /**
+     * Decode a claimed delivery's payload_data into payload (no-op when inline)
+     *
+     * @throws std::runtime_error if the stored payload cannot be decoded
+     */
+    void DecodePayload(WebhookDeliveryRecord& delivery);
+
+    /**
+     * Get the next batch, blocking until deliveries are ready or max_wait elapses
+     *
+     * Wakes on QueueDelivery() notifications and, for retries scheduled in
+     * the future, at the earliest scheduled_at.
+     *
+     * @param batch_size Maximum webhooks to retrieve
+     * @param max_wait Maximum time to block
+     * @return Claimed deliveries (empty on timeout)
+     */
+    WebhookDeliveryBatch WaitForClaimBatch(int batch_size, std::chrono::milliseconds max_wait);
+
+    /// WaitForClaimBatch() as one WebhookDeliveryRecord per row
+    std::vector<WebhookDeliveryRecord> WaitForBatch(int batch_size, std::chrono::milliseconds max_wait);
+
     /**
      * Mark webhook as successfully delivered
      *
@@ -101,6 +235,16 @@ public:
      */
     void MarkDelivered(const std::string& delivery_id, int http_status);
 
+    /**
+     * Mark a batch of webhooks as delivered in one statement
+     *
+     * Also resets the consecutive failure count of each webhook involved.
+     *
+     * @param results Successful attempts
+     * @return Number of deliveries updated
+     */
+    size_t MarkDeliveredBatch(const std::vector<WebhookAttemptResult>& results);
+
     /**
      * Mark webhook as failed and schedule retry if applicable
      *
@@ -110,6 +254,59 @@ public:
      */
     void MarkFailed(const std::string& delivery_id, int http_status, const std::string& error_message);
 
+    /**
+     * Record a batch of failed attempts in one statement
+     *
+     * Each delivery is moved to RETRY (D-104 backoff computed in SQL) or
+     * EXHAUSTED; webhooks reaching 10 consecutive failures are disabled in
+     * the same statement. Results sharing a batch_id were one POST and
+     * count as one failure of their webhook.
+     *
+     * A result marked `held` is a retry the caller keeps in memory and
+     * re-sends itself (ReclaimHeldBatch) when its backoff ends; its
+     * scheduled_at is pushed hold_lease further out, so other pollers
+     * leave it alone unless this process is gone by then.
+     *
+     * @param results Failed attempts
+     * @param hold_lease Extra delay for held retries
+     * @return Number of deliveries updated
+     */
+    size_t MarkFailedBatch(const std::vector<WebhookAttemptResult>& results,
+                           std::chrono::seconds hold_lease = std::chrono::seconds(0));
+
+    /**
+     * Claim held retries that are due, by ID rather than an index scan
+     *
+     * A delivery is claimed only if it is still in RETRY with the
+     * retry_count the caller holds (the count MarkFailedBatch gave it);
+     * otherwise another poller took it after the hold lease.
+     *
+     * @param held Deliveries held since MarkFailedBatch, retry_count already advanced
+     * @return IDs now in SENDING and owned by the caller
+     */
+    std::vector<std::string> ReclaimHeldBatch(const std::vector<WebhookDeliveryRecord>& held);
+
+    /**
+     * Hand held retries back to the queue at their real backoff (shutdown)
+     *
+     * @param held Deliveries held since MarkFailedBatch
+     * @param hold_lease The lease they were marked with
+     * @return Number of deliveries released
+     */
+    size_t ReleaseHeldBatch(const std::vector<WebhookDeliveryRecord>& held, std::chrono::seconds hold_lease);
+
+    /**
+     * Return claimed deliveries to the queue without counting an attempt
+     *
+     * Used by WebhookDispatcher when a destination is saturated, so claimed
+     * rows are not held in memory behind a slow endpoint.
+     *
+     * @param delivery_ids Deliveries currently in SENDING
+     * @param delay Delay before they become claimable again
+     * @return Number of deliveries released
+     */
+    size_t ReleaseBatch(const std::vector<std::string>& delivery_ids, std::chrono::milliseconds delay);
+
     /**
      * Get webhook delivery status by ID
      *
@@ -150,6 +347,14 @@ public:
      */
     static int64_t GetRetryDelay(int retry_count);
 
+    /**
+     * Whether a failed attempt is retried: the same rule MarkFailedBatch applies in SQL
+     *
+     * @param retry_count Retries so far
+     * @param http_status Response status (0 for connection errors/timeouts)
+     */
+    static bool ShouldRetry(int retry_count, int http_status);
+
     /**
      * Validate webhook URL for SSRF protection
      *
@@ -165,6 +370,19 @@ public:
      */
     static bool ValidateUrl(const std::string& url);
 
+    /**
+     * Validate a webhook URL and the addresses its host resolves to
+     *
+     * Runs the literal checks above, then resolves the host through the
+     * cache and rejects it if any address is non-public (e.g. a public name
+     * pointing at 10.0.0.0/8 or the metadata endpoint).
+     *
+     * @param url Webhook URL to validate
+     * @param dns_cache Shared resolver
+     * @return True if URL is safe
+     */
+    static bool ValidateUrl(const std::string& url, DnsCache& dns_cache);
+
     /**
      * Status enum to string
      */
@@ -175,13 +393,25 @@ public:
      */
     static WebhookStatus StringToStatus(const std::string& status);
 
+    /// Maximum retries before a delivery is EXHAUSTED (Requirement D-104)
+    static constexpr int MAX_RETRIES = 5;
+
+    /// Consecutive failures after which a webhook is disabled
+    static constexpr int MAX_CONSECUTIVE_FAILURES = 10;
+
+    /// Batch mode limits (RegisterWebhookRequest.batch)
+    static constexpr int MAX_BATCH_EVENTS = 1000;
+    static constexpr int MAX_BATCH_WINDOW_MS = 10000;
+
 private:
     std::shared_ptr<DbPool> db_pool_;
+    std::shared_ptr<QueueNotifier> notifier_;
+    PayloadCodec payloads_;
 
     /**
-     * Check if webhook should be retried
+     * Time until the earliest pending/retry delivery is due, capped at `cap`
      */
-    bool ShouldRetry(int retry_count, int http_status);
+    std::chrono::milliseconds TimeUntilNextDue(std::chrono::milliseconds cap);
 };
 
 } // namespace common
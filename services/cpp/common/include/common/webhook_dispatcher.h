@@ -0,0 +1,242 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Concurrent HTTP webhook dispatcher (libcurl multi)
+ */
+
+#pragma once
+
+#include "common/dns_cache.h"
+#include "common/endpoint_health.h"
+#include "common/timing_wheel.h"
+#include "common/webhook_delivery.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * WebhookDispatcher options
+ *
+ * FromEnv() reads WEBHOOK_MAX_IN_FLIGHT, WEBHOOK_MAX_PER_HOST,
+ * WEBHOOK_MAX_PER_TENANT, WEBHOOK_CONNECT_TIMEOUT_MS,
+ * WEBHOOK_REQUEST_TIMEOUT_MS, WEBHOOK_DISPATCH_BATCH_SIZE,
+ * WEBHOOK_RETRY_HOLD_MAX_MS, WEBHOOK_RETRY_HOLD_LEASE_S,
+ * WEBHOOK_MAX_HELD_RETRIES and WEBHOOK_MAX_BATCHED.
+ */
+struct WebhookDispatcherOptions {
+    size_t max_in_flight = 256;     // Concurrent requests across all destinations
+    size_t max_per_host = 8;        // Concurrent requests (and connections) per scheme://host:port
+    size_t max_per_tenant = 32;     // Concurrent requests per tenant
+    std::chrono::milliseconds connect_timeout{3000};
+    std::chrono::milliseconds request_timeout{10000};   // Whole attempt: connect + TLS + response
+    int batch_size = 100;                                // Rows claimed per GetNextBatch
+    std::chrono::milliseconds tick{100};                 // Claim/flush cadence while busy
+    std::chrono::milliseconds idle_wait{5000};           // WaitForBatch block when nothing is in flight
+    std::chrono::milliseconds release_delay{1000};       // Requeue delay for saturated destinations
+    std::chrono::milliseconds hold_max{30000};           // Retries due within this wait in memory (0: none)
+    std::chrono::seconds hold_lease{60};                 // Held rows stay unclaimable this long past due
+    size_t max_held = 10000;                             // Held retries beyond this go back to the table
+    size_t max_batched = 10000;                          // Deliveries in open batches; beyond this all are sent
+
+    static WebhookDispatcherOptions FromEnv();
+};
+
+/**
+ * Dispatcher counters
+ */
+struct WebhookDispatcherStats {
+    size_t in_flight = 0;
+    size_t waiting = 0;       // Claimed, waiting for a host/tenant slot
+    uint64_t delivered = 0;
+    uint64_t failed = 0;
+    uint64_t released = 0;    // Handed back to the queue (destination saturated)
+    uint64_t deferred = 0;    // Handed back unattempted (destination circuit open)
+    size_t held = 0;          // Failed, waiting out a short backoff in memory
+    uint64_t resent = 0;      // Held retries re-sent without a queue scan
+    size_t batching = 0;      // Claimed, accumulating into a batch
+    uint64_t batches = 0;     // Batch POSTs sent
+};
+
+/**
+ * Performs webhook HTTP POSTs for WebhookDelivery
+ *
+ * A single thread drives a libcurl multi handle, so thousands of requests
+ * can be in flight without a thread each. Connections are kept alive and
+ * reused per destination, and HTTP/2 is negotiated over TLS where the
+ * endpoint supports it (requests to one host are then multiplexed).
+ *
+ * Isolation: each destination host and each tenant has an in-flight cap,
+ * and every attempt has a hard timeout. A slow endpoint can only occupy
+ * max_per_host slots; rows for it beyond what it can absorb are released
+ * back to the queue (ReleaseBatch) rather than held in memory, so
+ * deliveries to everyone else keep flowing.
+ *
+ * Health: every attempt is scored in EndpointHealth. Once a host's circuit
+ * opens (consecutive failures or a poor success rate), its claimed rows are
+ * deferred to the end of the open period with ReleaseBatch, unattempted, so
+ * a dead endpoint costs one claim per row per period instead of a connect
+ * timeout per delivery. When it ends a single probe goes out; the host's
+ * other rows wait for its outcome like rows of a saturated host.
+ *
+ * SSRF: each destination is resolved through DnsCache (resolve-then-check)
+ * before its first attempt, and libcurl is pinned to exactly the validated
+ * addresses (CURLOPT_RESOLVE), so it never does its own lookup and cannot be
+ * rebound to an internal address. Keep-alive reuse needs no lookup at all.
+ * Redirects are not followed, since a redirect target would be unchecked.
+ *
+ * Results are written back with MarkDeliveredBatch/MarkFailedBatch once
+ * per tick.
+ *
+ * Retries: a retryable failure whose backoff is at most hold_max (1, 5 and
+ * 30 seconds under D-104) is kept in a timing wheel on the dispatch thread
+ * and re-sent when due, claimed back by ID (ReclaimHeldBatch) instead of
+ * waiting for a queue scan to find it. Its MarkFailedBatch still records
+ * the retry, with scheduled_at hold_lease later, so the row is delivered
+ * by another poller if this process dies; longer backoffs are left to the
+ * table. Shutdown hands held rows back at their real backoff.
+ *
+ * Batch mode (per webhook, RegisterWebhookRequest.batch): claimed rows for
+ * the webhook accumulate until batch_max_events are waiting or the oldest
+ * has waited batch_window_ms, then go out as one POST whose body is a JSON
+ * array ([{"id", "event_type", "created_at", "payload"}, ...]) signed once.
+ * X-Webhook-Delivery names the first delivery and X-Webhook-Batch-Size the
+ * count. Every member row gets the POST's outcome; a failed batch is not
+ * held, its members are retried by the table and batched again when claimed.
+ *
+ * Usage:
+ *   auto delivery = std::make_shared<WebhookDelivery>(db_pool, notifier);
+ *   WebhookDispatcher dispatcher(delivery, WebhookDispatcherOptions::FromEnv());
+ *   // ... runs until Shutdown() or destruction
+ */
+class WebhookDispatcher {
+public:
+    /**
+     * @param delivery Queue to claim from and record results in
+     * @param options Concurrency and timeout settings
+     * @param dns_cache Shared resolver (created with FromEnv() if null)
+     * @param health Endpoint health table (local-only, created with FromEnv(), if null)
+     */
+    WebhookDispatcher(
+        std::shared_ptr<WebhookDelivery> delivery,
+        const WebhookDispatcherOptions& options = {},
+        std::shared_ptr<DnsCache> dns_cache = nullptr,
+        std::shared_ptr<EndpointHealth> health = nullptr
+    );
+    ~WebhookDispatcher();
+
+    WebhookDispatcher(const WebhookDispatcher&) = delete;
+    WebhookDispatcher& operator=(const WebhookDispatcher&) = delete;
+
+    /**
+     * Stop claiming, release waiting rows, finish in-flight attempts
+     */
+    void Shutdown();
+
+    WebhookDispatcherStats GetStats() const;
+
+    /**
+     * Connection-pool key for a URL: lowercase scheme://host:port
+     *
+     * @return Key, or empty string if the URL cannot be parsed
+     */
+    static std::string HostKey(const std::string& url);
+
+    /**
+     * Body of a batch POST: [{"id", "event_type", "created_at", "payload"}, ...]
+     *
+     * Payloads are JSON and embedded as-is.
+     */
+    static std::string BatchBody(const std::vector<WebhookDeliveryRecord>& records);
+
+private:
+    struct Attempt;
+
+    // A delivery ready to send: one row, or a sealed batch whose record
+    // carries the array payload and signature
+    struct Pending {
+        WebhookDeliveryRecord record;
+        std::string host;
+        std::vector<std::string> batch_ids;   // Member rows; empty for a single delivery
+    };
+
+    // Claimed rows of one batch-mode webhook, waiting for the batch to fill
+    struct OpenBatch {
+        std::vector<WebhookDeliveryRecord> records;
+        std::string host;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void DispatchLoop();
+    void Claim(bool idle);
+    void Admit();
+    bool Start(Pending pending, const DnsResult& dns);
+    void CollectCompleted();
+    void Flush(bool force);
+    void ReleaseWaiting(bool all);
+    void Fail(WebhookDeliveryRecord record, std::string host, int http_status, std::string error);
+    void Fail(Pending pending, int http_status, std::string error);
+    void ResendHeld();
+    void ReleaseHeld();
+    // Inflate a blob-stored payload right before it is signed or sent; false (logged) if it cannot be
+    bool Decode(WebhookDeliveryRecord& record);
+    void AddToBatch(WebhookDeliveryRecord record, std::string host);
+    void SealBatches(bool all);
+    Pending Seal(OpenBatch batch);
+    std::chrono::milliseconds UntilNextDue(std::chrono::milliseconds cap) const;
+
+    std::shared_ptr<WebhookDelivery> delivery_;
+    WebhookDispatcherOptions options_;
+    std::shared_ptr<DnsCache> dns_cache_;
+    std::shared_ptr<EndpointHealth> health_;
+
+    void* multi_ = nullptr;  // CURLM*, kept opaque so curl.h stays out of this header
+    std::vector<void*> idle_handles_;   // Reused CURL* easy handles
+
+    // Dispatch-thread state
+    std::deque<Pending> waiting_;
+    std::unordered_map<std::string, size_t> host_in_flight_;
+    std::unordered_map<std::string, size_t> tenant_in_flight_;
+    std::vector<WebhookAttemptResult> delivered_results_;
+    std::vector<WebhookAttemptResult> failed_results_;
+    std::vector<std::string> to_release_;
+    std::unordered_map<std::string, std::vector<std::string>> to_defer_;   // Host -> delivery IDs
+    std::chrono::steady_clock::time_point last_tick_;
+
+    // Failed attempts whose retry is waited out here; retry_count is the one MarkFailedBatch records
+    struct Held {
+        WebhookDeliveryRecord record;
+        std::string host;
+        std::chrono::steady_clock::time_point due;
+    };
+    std::vector<Held> to_hold_;   // Scheduled once their failures are written
+    TimingWheel<Held> held_;
+
+    std::unordered_map<std::string, OpenBatch> batching_;   // By webhook ID and URL
+    size_t batching_size_ = 0;
+
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> waiting_count_{0};
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> released_{0};
+    std::atomic<uint64_t> deferred_{0};
+    std::atomic<size_t> held_count_{0};
+    std::atomic<uint64_t> resent_{0};
+    std::atomic<size_t> batching_count_{0};
+    std::atomic<uint64_t> batches_{0};
+
+    std::atomic<bool> shutdown_{false};
+    std::thread dispatch_thread_;
+};
+
+} // namespace common
+} // namespace saasforge
@@ -6,11 +6,55 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace saasforge {
 namespace common {
 
+/**
+ * HMAC-SHA256 key with precomputed keyed state
+ *
+ * The constructor fetches the MAC implementation and absorbs the key once
+ * (the ipad/opad blocks); every Sign() duplicates that state, so per-call
+ * cost is only the payload itself. Sign() is const and safe to call from
+ * several threads at once.
+ */
+class WebhookSigningKey {
+public:
+    /**
+     * @throws std::runtime_error if OpenSSL cannot create the MAC context
+     */
+    explicit WebhookSigningKey(std::string_view secret);
+    ~WebhookSigningKey();
+
+    WebhookSigningKey(const WebhookSigningKey&) = delete;
+    WebhookSigningKey& operator=(const WebhookSigningKey&) = delete;
+
+    /**
+     * @return Hex-encoded HMAC-SHA256 of the payload
+     */
+    std::string Sign(std::string_view payload) const;
+
+    /**
+     * Sign a payload held in several buffers, as if they were concatenated
+     */
+    std::string Sign(const std::vector<std::string_view>& chunks) const;
+
+    /// Constant-time check that this key was built from `secret`
+    bool Matches(std::string_view secret) const;
+
+private:
+    template <typename Feed>
+    std::string SignWith(Feed feed) const;
+
+    void* ctx_ = nullptr;  // EVP_MAC_CTX*, kept opaque so OpenSSL headers stay out of this header
+    std::string secret_;
+};
+
 /**
  * Webhook payload signer for security and authenticity verification
  *
@@ -20,9 +64,16 @@ namespace common {
  * Usage:
  *   std::string signature = WebhookSigner::SignPayload(payload, secret);
  *   // Send in HTTP header: X-Webhook-Signature: sha256={signature}
+ *
+ *   // Fan-out: keyed state is cached per (tenant, webhook)
+ *   auto key = WebhookSigner::GetSigningKey(tenant_id, webhook_id, secret);
+ *   std::string signature = key->Sign(payload);
  */
 class WebhookSigner {
 public:
+    /// Cached keys before the cache is trimmed
+    static constexpr size_t MAX_CACHED_KEYS = 4096;
+
     /**
      * Sign webhook payload using HMAC-SHA256
      *
@@ -31,8 +82,8 @@ public:
      * @return Hex-encoded HMAC-SHA256 signature
      */
     static std::string SignPayload(
-        const std::string& payload,
-        const std::string& secret
+        std::string_view payload,
+        std::string_view secret
     );
 
     /**
@@ -44,11 +95,37 @@ public:
      * @return True if signature is valid
      */
     static bool VerifySignature(
-        const std::string& payload,
-        const std::string& signature,
-        const std::string& secret
+        std::string_view payload,
+        std::string_view signature,
+        std::string_view secret
     );
 
+    /**
+     * Keyed HMAC state for a webhook, built once and shared
+     *
+     * The cached key is rebuilt if `secret` no longer matches it, so a
+     * rotated secret takes effect on the next call.
+     *
+     * @param tenant_id Tenant ID
+     * @param webhook_id Webhook registration ID
+     * @param secret Current webhook secret
+     */
+    static std::shared_ptr<const WebhookSigningKey> GetSigningKey(
+        const std::string& tenant_id,
+        const std::string& webhook_id,
+        std::string_view secret
+    );
+
+    /**
+     * Drop the cached key for a webhook (e.g. when it is deleted)
+     */
+    static void InvalidateSigningKey(
+        const std::string& tenant_id,
+        const std::string& webhook_id
+    );
+
+    static size_t CachedKeyCount();
+
     /**
      * Get mock webhook secret for testing/development
      *
@@ -64,9 +141,8 @@ public:
         const std::string& webhook_id
     );
 
-private:
     /**
-     * Convert binary HMAC output to hex string
+     * Lowercase hex encoding of binary data
      */
     static std::string ToHex(const unsigned char* data, size_t length);
 };
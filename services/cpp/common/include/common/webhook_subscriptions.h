@@ -0,0 +1,127 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-memory per-tenant webhook subscription index for event fan-out
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+/**
+ * WebhookSubscriptionIndex options
+ *
+ * FromEnv() reads WEBHOOK_SUBSCRIPTION_TTL_S and
+ * WEBHOOK_SUBSCRIPTION_MAX_TENANTS.
+ */
+struct WebhookSubscriptionOptions {
+    std::chrono::seconds ttl{60};    // Reload bound for changes made by other instances
+    size_t max_tenants = 10000;
+
+    static WebhookSubscriptionOptions FromEnv();
+};
+
+/**
+ * An active webhook and the event types it is registered for
+ */
+struct WebhookSubscription {
+    std::string webhook_id;
+    std::string url;
+    std::vector<std::string> events;
+    int batch_max_events = 0;   // Batch mode (webhooks.batch_max_events); 0: one POST per event
+};
+
+/**
+ * Resolves the webhooks a tenant has registered for an event type
+ *
+ * A tenant's active webhooks are loaded with one query on first use and
+ * indexed by event type, so publishing an event costs a hash lookup rather
+ * than a scan of the webhooks table. RegisterWebhook() calls Add() after its
+ * commit, so new webhooks are visible immediately on this instance; other
+ * instances see them within `ttl`. Webhooks disabled since the load are
+ * still returned until then, which is harmless: WebhookDelivery::QueueEvent
+ * only inserts deliveries for webhooks that are active at insert time.
+ *
+ * Usage:
+ *   WebhookSubscriptionIndex index(db_pool, WebhookSubscriptionOptions::FromEnv());
+ *   auto subscribers = index.Subscribers(tenant_id, "subscription.created");
+ */
+class WebhookSubscriptionIndex {
+public:
+    /// Loads a tenant's active webhooks
+    using Loader = std::function<std::vector<WebhookSubscription>(const std::string& tenant_id)>;
+
+    WebhookSubscriptionIndex(
+        std::shared_ptr<DbPool> db_pool,
+        const WebhookSubscriptionOptions& options = {}
+    );
+
+    /// Custom source (tests)
+    WebhookSubscriptionIndex(Loader loader, const WebhookSubscriptionOptions& options = {});
+
+    WebhookSubscriptionIndex(const WebhookSubscriptionIndex&) = delete;
+    WebhookSubscriptionIndex& operator=(const WebhookSubscriptionIndex&) = delete;
+
+    /**
+     * Webhooks of the tenant subscribed to event_type
+     *
+     * @throws std::runtime_error if the tenant is not cached and loading fails
+     */
+    std::vector<WebhookSubscription> Subscribers(const std::string& tenant_id, const std::string& event_type);
+
+    /**
+     * Record a newly registered webhook (no-op if the tenant is not cached)
+     */
+    void Add(const std::string& tenant_id, const WebhookSubscription& subscription);
+
+    /**
+     * Forget a webhook (deleted or disabled)
+     */
+    void Remove(const std::string& tenant_id, const std::string& webhook_id);
+
+    /**
+     * Drop a tenant's entry; the next Subscribers() call reloads it
+     */
+    void InvalidateTenant(const std::string& tenant_id);
+
+    size_t TenantCount() const;
+
+    /**
+     * Split the webhooks.events column ("a.created, b.deleted") into event types
+     */
+    static std::vector<std::string> ParseEvents(std::string_view events);
+
+private:
+    struct TenantEntry {
+        std::unordered_map<std::string, std::vector<WebhookSubscription>> by_event;
+        std::chrono::steady_clock::time_point loaded_at;
+    };
+
+    static std::shared_ptr<TenantEntry> BuildEntry(const std::vector<WebhookSubscription>& subscriptions);
+    static void Index(TenantEntry& entry, const WebhookSubscription& subscription);
+    static void Unindex(TenantEntry& entry, const std::string& webhook_id);
+
+    Loader loader_;
+    WebhookSubscriptionOptions options_;
+
+    mutable std::mutex mutex_;
+    // Entries are immutable once published; Add()/Remove() swap in a modified copy
+    std::unordered_map<std::string, std::shared_ptr<const TenantEntry>> tenants_;
+    // Bumped by every mutation; a load that raced one is returned but not cached
+    uint64_t version_ = 0;
+};
+
+} // namespace common
+} // namespace saasforge
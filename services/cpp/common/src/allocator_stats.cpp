@@ -0,0 +1,99 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description malloc statistics of whichever allocator the process runs on implementation
+ */
+
+#include "common/allocator_stats.h"
+#include <malloc.h>
+
+// Statistics entry points of jemalloc, mimalloc and tcmalloc, weak so
+// whichever is linked or preloaded is found at run time
+extern "C" {
+int mallctl(const char* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen) __attribute__((weak));
+void mi_process_info(size_t* elapsed_msecs, size_t* user_msecs, size_t* system_msecs, size_t* current_rss,
+                     size_t* peak_rss, size_t* current_commit, size_t* peak_commit,
+                     size_t* page_faults) __attribute__((weak));
+int MallocExtension_GetNumericProperty(const char* property, size_t* value) __attribute__((weak));
+}
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+size_t JemallocStat(const char* name) {
+    size_t value = 0;
+    size_t length = sizeof(value);
+    return mallctl(name, &value, &length, nullptr, 0) == 0 ? value : 0;
+}
+
+size_t TcmallocProperty(const char* name) {
+    size_t value = 0;
+    return MallocExtension_GetNumericProperty(name, &value) ? value : 0;
+}
+
+} // namespace
+
+AllocatorStats ReadAllocatorStats() {
+    AllocatorStats stats;
+    if (mallctl) {
+        // stats.* are a snapshot refreshed by advancing the epoch
+        uint64_t epoch = 1;
+        size_t length = sizeof(epoch);
+        mallctl("epoch", &epoch, &length, &epoch, length);
+
+        stats.allocator = "jemalloc";
+        stats.allocated = JemallocStat("stats.allocated");
+        stats.active = JemallocStat("stats.active");
+        stats.resident = JemallocStat("stats.resident");
+        stats.mapped = JemallocStat("stats.mapped");
+        stats.retained = JemallocStat("stats.retained");
+
+        unsigned arenas = 0;
+        length = sizeof(arenas);
+        if (mallctl("arenas.narenas", &arenas, &length, nullptr, 0) == 0) {
+            stats.arenas = arenas;
+        }
+    } else if (mi_process_info) {
+        size_t elapsed, user, system, peak_rss, peak_commit, page_faults;
+        stats.allocator = "mimalloc";
+        mi_process_info(&elapsed, &user, &system, &stats.resident, &peak_rss, &stats.mapped, &peak_commit,
+                        &page_faults);
+    } else if (MallocExtension_GetNumericProperty) {
+        stats.allocator = "tcmalloc";
+        stats.allocated = TcmallocProperty("generic.current_allocated_bytes");
+        stats.mapped = TcmallocProperty("generic.heap_size");
+        size_t unmapped = TcmallocProperty("tcmalloc.pageheap_unmapped_bytes");
+        stats.resident = stats.mapped > unmapped ? stats.mapped - unmapped : 0;
+    } else {
+        // Walks every arena's free lists under its lock; fine at scrape rate
+        struct mallinfo2 info = ::mallinfo2();
+        stats.allocator = "glibc";
+        stats.allocated = info.uordblks + info.hblkhd;
+        stats.mapped = info.arena + info.hblkhd;
+    }
+    return stats;
+}
+
+uint64_t ExportAllocatorMetrics(MetricsRegistry& registry) {
+    return registry.AddCollector([](MetricsWriter& writer) {
+        AllocatorStats stats = ReadAllocatorStats();
+        MetricLabels labels = {{"allocator", stats.allocator}};
+        auto add = [&](const char* name, const char* help, size_t value) {
+            if (value != 0) {
+                writer.AddGauge(name, help, labels, static_cast<double>(value));
+            }
+        };
+        add("saasforge_allocator_allocated_bytes", "Bytes in live allocations", stats.allocated);
+        add("saasforge_allocator_active_bytes", "Bytes in pages holding live allocations", stats.active);
+        add("saasforge_allocator_resident_bytes", "Allocator bytes resident in RAM", stats.resident);
+        add("saasforge_allocator_mapped_bytes", "Bytes mapped from the OS by the allocator", stats.mapped);
+        add("saasforge_allocator_retained_bytes", "Address space kept by the allocator after unmapping",
+            stats.retained);
+        add("saasforge_allocator_arenas", "Allocator arenas", stats.arenas);
+    });
+}
+
+} // namespace common
+} // namespace saasforge
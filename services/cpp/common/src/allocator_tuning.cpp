@@ -0,0 +1,71 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Startup configuration of the allocator, compiled into each service executable
+ */
+
+/*
+ * Added by saasforge_allocator_tuning(<target> <arenas> <decay_ms>) in CMake,
+ * which defines SAASFORGE_ALLOCATOR_ARENAS (0 = allocator default) and
+ * SAASFORGE_ALLOCATOR_DECAY_MS. Settings from the environment win:
+ *   jemalloc  narenas, dirty/muzzy decay, background purging (MALLOC_CONF)
+ *   mimalloc  purge delay (MIMALLOC_PURGE_DELAY)
+ *   glibc     arena cap (MALLOC_ARENA_MAX, GLIBC_TUNABLES)
+ *   tcmalloc  defaults (TCMALLOC_RELEASE_RATE)
+ */
+
+#include <cstdlib>
+
+#define SAASFORGE_STRINGIFY_(x) #x
+#define SAASFORGE_STRINGIFY(x) SAASFORGE_STRINGIFY_(x)
+
+#if defined(SAASFORGE_ALLOCATOR_JEMALLOC)
+
+// Read by jemalloc when it initializes, before MALLOC_CONF; a background
+// thread purges on time so idle services give memory back too
+extern "C" {
+const char* malloc_conf =
+#if SAASFORGE_ALLOCATOR_ARENAS > 0
+    "narenas:" SAASFORGE_STRINGIFY(SAASFORGE_ALLOCATOR_ARENAS) ","
+#endif
+    "dirty_decay_ms:" SAASFORGE_STRINGIFY(SAASFORGE_ALLOCATOR_DECAY_MS) ","
+    "muzzy_decay_ms:" SAASFORGE_STRINGIFY(SAASFORGE_ALLOCATOR_DECAY_MS) ","
+    "background_thread:true";
+}
+
+#elif defined(SAASFORGE_ALLOCATOR_MIMALLOC)
+
+#include <mimalloc.h>
+
+namespace {
+
+// mimalloc has no arena count to cap (its heaps are per thread); only the purge delay applies
+const bool kTuned = [] {
+#if MI_MALLOC_VERSION >= 210 || (MI_MALLOC_VERSION >= 180 && MI_MALLOC_VERSION < 200)
+    mi_option_set_default(mi_option_purge_delay, SAASFORGE_ALLOCATOR_DECAY_MS);
+#else
+    mi_option_set_default(mi_option_reset_delay, SAASFORGE_ALLOCATOR_DECAY_MS);
+#endif
+    return true;
+}();
+
+} // namespace
+
+#elif !defined(SAASFORGE_ALLOCATOR_TCMALLOC)
+
+#include <malloc.h>
+
+namespace {
+
+// glibc creates up to 8 arenas per core, which is what fragments a
+// many-threaded service; it has no time-based purging to tune
+const bool kTuned = [] {
+    if (SAASFORGE_ALLOCATOR_ARENAS > 0 && !std::getenv("MALLOC_ARENA_MAX") && !std::getenv("GLIBC_TUNABLES")) {
+        ::mallopt(M_ARENA_MAX, SAASFORGE_ALLOCATOR_ARENAS);
+    }
+    return true;
+}();
+
+} // namespace
+
+#endif
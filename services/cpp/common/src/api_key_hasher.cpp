@@ -0,0 +1,119 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Keyed API key format and HMAC-SHA256 digests implementation
+ */
+
+#include "common/api_key_hasher.h"
+#include "common/codec.h"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr const char* KEY_PREFIX = "sk_";
+constexpr size_t KEY_PREFIX_LENGTH = 3;
+constexpr size_t DISPLAY_PREFIX_LENGTH = 10;  // api_keys.key_prefix is VARCHAR(10)
+
+} // namespace
+
+GeneratedApiKey ApiKeyHasher::Generate(const std::string& pepper) {
+    GeneratedApiKey key;
+    key.key_id = RandomHex(KEY_ID_HEX_LENGTH / 2);
+    std::string secret = RandomHex(SECRET_HEX_LENGTH / 2);
+
+    key.api_key = std::string(KEY_PREFIX) + key.key_id + "_" + secret;
+    key.key_hash = Digest(secret, pepper);
+    return key;
+}
+
+std::optional<ParsedApiKey> ApiKeyHasher::Parse(const std::string& api_key) {
+    if (api_key.compare(0, KEY_PREFIX_LENGTH, KEY_PREFIX) != 0) {
+        return std::nullopt;
+    }
+
+    std::string body = api_key.substr(KEY_PREFIX_LENGTH);
+
+    // Legacy format: "sk_" + 64 hex chars, no key id
+    if (body.length() == SECRET_HEX_LENGTH && IsHex(body)) {
+        ParsedApiKey parsed;
+        parsed.secret = api_key;
+        parsed.legacy = true;
+        return parsed;
+    }
+
+    // Keyed format: "sk_" + key_id + "_" + secret
+    if (body.length() != KEY_ID_HEX_LENGTH + 1 + SECRET_HEX_LENGTH ||
+        body[KEY_ID_HEX_LENGTH] != '_') {
+        return std::nullopt;
+    }
+
+    ParsedApiKey parsed;
+    parsed.key_id = body.substr(0, KEY_ID_HEX_LENGTH);
+    parsed.secret = body.substr(KEY_ID_HEX_LENGTH + 1);
+    if (!IsHex(parsed.key_id) || !IsHex(parsed.secret)) {
+        return std::nullopt;
+    }
+    return parsed;
+}
+
+std::string ApiKeyHasher::Digest(const std::string& secret, const std::string& pepper) {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int mac_len = 0;
+
+    if (!HMAC(
+            EVP_sha256(),
+            pepper.data(),
+            static_cast<int>(pepper.length()),
+            reinterpret_cast<const unsigned char*>(secret.data()),
+            secret.length(),
+            mac,
+            &mac_len)) {
+        throw std::runtime_error("API key digest failed");
+    }
+
+    return HexEncode(mac, mac_len);
+}
+
+bool ApiKeyHasher::VerifyDigest(
+    const std::string& secret,
+    const std::string& pepper,
+    const std::string& expected_digest
+) {
+    std::string actual = Digest(secret, pepper);
+    if (actual.length() != expected_digest.length()) {
+        return false;
+    }
+    return CRYPTO_memcmp(actual.data(), expected_digest.data(), actual.length()) == 0;
+}
+
+std::string ApiKeyHasher::LegacyKeyId(const std::string& api_key, const std::string& pepper) {
+    // Domain-separated from Digest() so the key_id never reveals the stored hash
+    return "l" + Digest("legacy-key-id:" + api_key, pepper).substr(0, KEY_ID_HEX_LENGTH - 1);
+}
+
+std::string ApiKeyHasher::DisplayPrefix(const std::string& api_key) {
+    return api_key.substr(0, DISPLAY_PREFIX_LENGTH);
+}
+
+bool ApiKeyHasher::IsHex(const std::string& value) {
+    if (value.empty()) {
+        return false;
+    }
+    for (char c : value) {
+        bool digit = c >= '0' && c <= '9';
+        bool lower = c >= 'a' && c <= 'f';
+        if (!digit && !lower) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace common
+} // namespace saasforge
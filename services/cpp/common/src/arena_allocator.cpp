@@ -0,0 +1,96 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-thread arena block cache and arena size metrics
+ */
+
+#include "common/arena_allocator.h"
+#include <algorithm>
+#include <array>
+#include <new>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr size_t NUM_SIZES = 8;   // 512 B .. 64 KiB
+static_assert(ArenaBlock::MIN_SIZE << (NUM_SIZES - 1) == ArenaBlock::MAX_SIZE, "size classes");
+
+size_t SizeIndex(size_t size) {
+    size_t index = 0;
+    while ((ArenaBlock::MIN_SIZE << index) < size) {
+        ++index;
+    }
+    return index;
+}
+
+struct BlockCache {
+    std::array<std::vector<char*>, NUM_SIZES> free;
+
+    ~BlockCache() {
+        for (auto& blocks : free) {
+            for (char* block : blocks) {
+                ::operator delete(block);
+            }
+        }
+    }
+};
+
+BlockCache& ThreadCache() {
+    thread_local BlockCache cache;
+    return cache;
+}
+
+} // namespace
+
+size_t ArenaBlock::RoundUp(size_t size) {
+    return MIN_SIZE << SizeIndex(std::min(std::max(size, MIN_SIZE), MAX_SIZE));
+}
+
+ArenaBlock::ArenaBlock(size_t size) : size_(RoundUp(size)) {
+    auto& blocks = ThreadCache().free[SizeIndex(size_)];
+    if (blocks.empty()) {
+        data_ = static_cast<char*>(::operator new(size_));
+    } else {
+        data_ = blocks.back();
+        blocks.pop_back();
+    }
+}
+
+ArenaBlock::~ArenaBlock() {
+    auto& blocks = ThreadCache().free[SizeIndex(size_)];
+    if (blocks.size() < MAX_CACHED) {
+        blocks.push_back(data_);
+    } else {
+        ::operator delete(data_);
+    }
+}
+
+google::protobuf::ArenaOptions ArenaBlock::Options() const {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = data_;
+    options.initial_block_size = size_;
+    // Overflow blocks start at the estimate too, instead of protobuf's 256 B
+    options.start_block_size = size_;
+    options.max_block_size = std::max(options.max_block_size, size_);
+    return options;
+}
+
+Histogram& ArenaUsedBytesHistogram(const std::string& method) {
+    // "/package.Service/Method"
+    std::string service = "unknown";
+    std::string rpc = method;
+    size_t slash = method.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        service = method.substr(1, slash - 1);
+        rpc = method.substr(slash + 1);
+    }
+    return MetricsRegistry::Global().GetHistogram("saasforge_grpc_server_arena_bytes",
+                                                  "Protobuf arena space used by an RPC's request and response",
+                                                  HistogramOptions::SizeBytes(),
+                                                  {{"grpc_service", service}, {"grpc_method", rpc}});
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,67 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Fixed-size Bloom filter implementation
+ */
+
+#include "common/bloom_filter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace saasforge {
+namespace common {
+
+BloomFilter::BloomFilter(size_t expected_items, double false_positive_rate)
+    : expected_items_(std::max<size_t>(expected_items, 1)) {
+    false_positive_rate = std::clamp(false_positive_rate, 1e-9, 0.5);
+
+    // Optimal sizing: m = -n ln(p) / (ln 2)^2, k = (m / n) ln 2
+    const double ln2 = std::log(2.0);
+    double bits = -static_cast<double>(expected_items_) * std::log(false_positive_rate) / (ln2 * ln2);
+    num_bits_ = std::max<size_t>(static_cast<size_t>(std::ceil(bits)), 64);
+    num_hashes_ = std::max<size_t>(
+        static_cast<size_t>(std::round(static_cast<double>(num_bits_) / expected_items_ * ln2)), 1);
+
+    bits_.assign((num_bits_ + 63) / 64, 0);
+}
+
+void BloomFilter::Add(std::string_view item) {
+    // Double hashing (Kirsch-Mitzenmacher): h_i = h1 + i * h2
+    uint64_t h1 = Hash(item, 0);
+    uint64_t h2 = Hash(item, h1) | 1;
+    for (size_t i = 0; i < num_hashes_; ++i) {
+        uint64_t bit = (h1 + i * h2) % num_bits_;
+        bits_[bit / 64] |= (uint64_t{1} << (bit % 64));
+    }
+    ++count_;
+}
+
+bool BloomFilter::MightContain(std::string_view item) const {
+    uint64_t h1 = Hash(item, 0);
+    uint64_t h2 = Hash(item, h1) | 1;
+    for (size_t i = 0; i < num_hashes_; ++i) {
+        uint64_t bit = (h1 + i * h2) % num_bits_;
+        if ((bits_[bit / 64] & (uint64_t{1} << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t BloomFilter::Hash(std::string_view item, uint64_t seed) {
+    // FNV-1a with a splitmix64 finaliser for better bit dispersion
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (unsigned char c : item) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,140 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Warm, round-robin gRPC client channels per target with keepalive implementation
+ */
+
+#include "common/channel_pool.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Distinguishes otherwise identical channels, so none is deduplicated
+constexpr const char* POOL_INDEX_ARG = "saasforge.channel_pool_index";
+
+} // namespace
+
+ChannelPoolOptions ChannelPoolOptions::FromEnv() {
+    ChannelPoolOptions options;
+    options.channels_per_target = static_cast<size_t>(
+        EnvInt("GRPC_CHANNEL_POOL_SIZE", static_cast<long>(options.channels_per_target)));
+    options.keepalive_time = std::chrono::milliseconds(
+        EnvInt("GRPC_CLIENT_KEEPALIVE_TIME_MS", static_cast<long>(options.keepalive_time.count())));
+    options.keepalive_timeout = std::chrono::milliseconds(
+        EnvInt("GRPC_CLIENT_KEEPALIVE_TIMEOUT_MS", static_cast<long>(options.keepalive_timeout.count())));
+    options.keepalive_without_calls = EnvInt("GRPC_CLIENT_KEEPALIVE_WITHOUT_CALLS", 1) == 1;
+    options.tls_session_cache_size = static_cast<size_t>(
+        EnvInt("GRPC_CLIENT_TLS_SESSION_CACHE", static_cast<long>(options.tls_session_cache_size)));
+    options.lb_policy = EnvString("GRPC_CLIENT_LB_POLICY", options.lb_policy);
+    return options;
+}
+
+ChannelPool::ChannelPool(std::shared_ptr<grpc::ChannelCredentials> credentials, const ChannelPoolOptions& options)
+    : credentials_(std::move(credentials)), options_(options) {
+    if (!credentials_) {
+        throw std::invalid_argument("ChannelPool requires credentials");
+    }
+    options_.channels_per_target = std::max<size_t>(options_.channels_per_target, 1);
+    if (options_.tls_session_cache_size > 0) {
+        session_cache_ = grpc_ssl_session_cache_create_lru(options_.tls_session_cache_size);
+    }
+}
+
+ChannelPool::~ChannelPool() {
+    // Channels hold their own reference to the cache
+    if (session_cache_) {
+        grpc_ssl_session_cache_destroy(session_cache_);
+    }
+}
+
+grpc::ChannelArguments ChannelPool::Arguments(const ChannelPoolOptions& options, size_t index) {
+    grpc::ChannelArguments arguments;
+    // Without a local pool, channels with equal arguments share one subchannel (one connection)
+    arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    arguments.SetInt(POOL_INDEX_ARG, static_cast<int>(index));
+    if (!options.lb_policy.empty()) {
+        arguments.SetLoadBalancingPolicyName(options.lb_policy);
+    }
+    if (options.keepalive_time.count() > 0) {
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, static_cast<int>(options.keepalive_time.count()));
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS, static_cast<int>(options.keepalive_timeout.count()));
+        arguments.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, options.keepalive_without_calls ? 1 : 0);
+        // Keep pinging an idle connection rather than stopping after two PINGs
+        arguments.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+    }
+    return arguments;
+}
+
+ChannelPool::Target& ChannelPool::Find(const std::string& target) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = targets_.find(target);
+        if (it != targets_.end()) {
+            return *it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto& entry = targets_[target];
+    if (!entry) {
+        entry = std::make_unique<Target>();
+        entry->channels.reserve(options_.channels_per_target);
+        for (size_t i = 0; i < options_.channels_per_target; ++i) {
+            auto arguments = Arguments(options_, i);
+            if (session_cache_) {
+                grpc_arg cache_arg = grpc_ssl_session_cache_create_channel_arg(session_cache_);
+                arguments.SetPointerWithVtable(cache_arg.key, cache_arg.value.pointer.p, cache_arg.value.pointer.vtable);
+            }
+            entry->channels.push_back(grpc::CreateCustomChannel(target, credentials_, arguments));
+        }
+        LogInfo("Channel pool target added", {{"target", target}, {"channels", options_.channels_per_target}});
+    }
+    return *entry;
+}
+
+std::shared_ptr<grpc::Channel> ChannelPool::Get(const std::string& target) {
+    auto& entry = Find(target);
+    size_t index = entry.next.fetch_add(1, std::memory_order_relaxed) % entry.channels.size();
+    return entry.channels[index];
+}
+
+std::vector<std::shared_ptr<grpc::Channel>> ChannelPool::Channels(const std::string& target) {
+    return Find(target).channels;
+}
+
+bool ChannelPool::Connect(const std::string& target, std::chrono::system_clock::time_point deadline) {
+    auto& entry = Find(target);
+    bool connected = true;
+    for (const auto& channel : entry.channels) {
+        if (!channel->WaitForConnected(deadline)) {
+            connected = false;
+        }
+    }
+    return connected;
+}
+
+ChannelPoolStats ChannelPool::GetStats() const {
+    ChannelPoolStats stats;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    stats.targets = targets_.size();
+    for (const auto& [target, entry] : targets_) {
+        stats.channels += entry->channels.size();
+        for (const auto& channel : entry->channels) {
+            if (channel->GetState(false) == GRPC_CHANNEL_READY) {
+                ++stats.ready;
+            }
+        }
+    }
+    return stats;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,407 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Hex, Base32 and Base64 encoding shared by every service implementation
+ */
+
+#include "common/codec.h"
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+constexpr char kBase32Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+constexpr char kBase64Standard[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kBase64UrlSafe[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr int8_t INVALID = -1;
+constexpr int8_t SKIP = -2;
+
+// Value of every byte in one alphabet, INVALID (or SKIP) for the rest
+struct DecodeTable {
+    std::array<int8_t, 256> values{};
+
+    constexpr DecodeTable(const char* alphabet, size_t size, bool either_case) {
+        for (auto& value : values) {
+            value = INVALID;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            auto c = static_cast<unsigned char>(alphabet[i]);
+            values[c] = static_cast<int8_t>(i);
+            if (either_case && c >= 'A' && c <= 'Z') {
+                values[c - 'A' + 'a'] = static_cast<int8_t>(i);
+            } else if (either_case && c >= 'a' && c <= 'z') {
+                values[c - 'a' + 'A'] = static_cast<int8_t>(i);
+            }
+        }
+    }
+
+    int8_t operator[](char c) const { return values[static_cast<unsigned char>(c)]; }
+};
+
+constexpr DecodeTable kHexValues(kHexDigits, 16, true);
+constexpr DecodeTable kBase64StandardValues(kBase64Standard, 64, false);
+constexpr DecodeTable kBase64UrlSafeValues(kBase64UrlSafe, 64, false);
+
+// Base32 also skips the separators people type into secrets
+struct Base32DecodeTable : DecodeTable {
+    constexpr Base32DecodeTable() : DecodeTable(kBase32Alphabet, 32, true) {
+        for (unsigned char c : {' ', '\n', '\r', '\t', '-', '='}) {
+            values[c] = SKIP;
+        }
+    }
+};
+
+constexpr Base32DecodeTable kBase32Values;
+
+#if defined(__SSE2__)
+// ASCII hex digit of each nibble: '0' + n, plus the gap to 'a' where n > 9
+inline __m128i HexDigits(__m128i nibbles) {
+    __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                        _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+// Nibble value of 16 characters; `valid` gets one bit per hex digit
+inline __m128i NibbleValues(__m128i chars, int& valid) {
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                     _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    __m128i folded = _mm_or_si128(chars, _mm_set1_epi8(0x20));   // 'A'-'F' -> 'a'-'f'
+    __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(folded, _mm_set1_epi8('f' + 1)));
+    valid = _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter));
+    return _mm_or_si128(_mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                        _mm_and_si128(is_letter, _mm_sub_epi8(folded, _mm_set1_epi8('a' - 10))));
+}
+
+// 16 nibbles (high first) as 8 bytes, one per 16-bit lane
+inline __m128i JoinNibbles(__m128i nibbles) {
+    __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4);
+    return _mm_or_si128(high, _mm_srli_epi16(nibbles, 8));
+}
+#endif
+
+} // namespace
+
+void HexEncode(const unsigned char* data, size_t size, char* out) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i mask = _mm_set1_epi8(0x0f);
+        __m128i high = HexDigits(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+        __m128i low = HexDigits(_mm_and_si128(bytes, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t*>(kHexDigits));
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t bytes = vld1q_u8(data + i);
+        uint8x16x2_t pairs;
+        pairs.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(bytes, 4));
+        pairs.val[1] = vqtbl1q_u8(digits, vandq_u8(bytes, vdupq_n_u8(0x0f)));
+        vst2q_u8(reinterpret_cast<uint8_t*>(out + 2 * i), pairs);   // Interleaves high, low
+    }
+#endif
+    for (; i < size; ++i) {
+        out[2 * i] = kHexDigits[data[i] >> 4];
+        out[2 * i + 1] = kHexDigits[data[i] & 0x0f];
+    }
+}
+
+std::string HexEncode(const unsigned char* data, size_t size) {
+    std::string out(HexEncodedLength(size), '\0');
+    HexEncode(data, size, &out[0]);
+    return out;
+}
+
+std::string HexEncode(std::string_view bytes) {
+    return HexEncode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size());
+}
+
+bool HexDecode(std::string_view hex, unsigned char* out) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    size_t size = hex.size() / 2;
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        int valid_first = 0;
+        int valid_second = 0;
+        __m128i first = NibbleValues(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex.data() + 2 * i)), valid_first);
+        __m128i second = NibbleValues(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex.data() + 2 * i + 16)), valid_second);
+        if ((valid_first & valid_second) != 0xffff) {
+            return false;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packus_epi16(JoinNibbles(first), JoinNibbles(second)));
+    }
+#endif
+    for (; i < size; ++i) {
+        int8_t high = kHexValues[hex[2 * i]];
+        int8_t low = kHexValues[hex[2 * i + 1]];
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i] = static_cast<unsigned char>((high << 4) | low);
+    }
+    return true;
+}
+
+std::optional<std::vector<uint8_t>> HexDecode(std::string_view hex) {
+    std::vector<uint8_t> out(hex.size() / 2);
+    if (!HexDecode(hex, out.data())) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+size_t Base32EncodedLength(size_t bytes, bool padded) {
+    return padded ? (bytes + 4) / 5 * 8 : (bytes * 8 + 4) / 5;
+}
+
+void Base32Encode(const unsigned char* data, size_t size, char* out, bool padded) {
+    size_t i = 0;
+    for (; i + 5 <= size; i += 5) {
+        uint64_t group = 0;
+        for (size_t j = 0; j < 5; ++j) {
+            group = (group << 8) | data[i + j];
+        }
+        for (int shift = 35; shift >= 0; shift -= 5) {
+            *out++ = kBase32Alphabet[(group >> shift) & 0x1f];
+        }
+    }
+    size_t rest = size - i;
+    if (rest == 0) {
+        return;
+    }
+    uint64_t group = 0;
+    for (size_t j = 0; j < 5; ++j) {
+        group = (group << 8) | (j < rest ? data[i + j] : 0);
+    }
+    size_t chars = (rest * 8 + 4) / 5;
+    for (size_t j = 0; j < 8; ++j) {
+        if (j < chars) {
+            *out++ = kBase32Alphabet[(group >> (35 - 5 * j)) & 0x1f];
+        } else if (padded) {
+            *out++ = '=';
+        }
+    }
+}
+
+std::string Base32Encode(const unsigned char* data, size_t size, bool padded) {
+    std::string out(Base32EncodedLength(size, padded), '\0');
+    Base32Encode(data, size, &out[0], padded);
+    return out;
+}
+
+std::optional<std::vector<uint8_t>> Base32Decode(std::string_view base32) {
+    std::vector<uint8_t> out;
+    out.reserve(base32.size() * 5 / 8);
+
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : base32) {
+        int8_t value = kBase32Values[c];
+        if (value == SKIP) {
+            continue;
+        }
+        if (value == INVALID) {
+            return std::nullopt;
+        }
+        // Only the bits not yet emitted (at most 12) are kept
+        buffer = ((buffer << 5) | static_cast<uint32_t>(value)) & 0xfff;
+        bits += 5;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(buffer >> bits));
+        }
+    }
+    return out;
+}
+
+size_t Base64EncodedLength(size_t bytes, bool padded) {
+    return padded ? (bytes + 2) / 3 * 4 : (bytes * 4 + 2) / 3;
+}
+
+void Base64Encode(const unsigned char* data, size_t size, char* out, Base64Alphabet alphabet, bool padded) {
+    const char* chars = alphabet == Base64Alphabet::URL_SAFE ? kBase64UrlSafe : kBase64Standard;
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t group = (static_cast<uint32_t>(data[i]) << 16) | (static_cast<uint32_t>(data[i + 1]) << 8) |
+                         data[i + 2];
+        out[0] = chars[group >> 18];
+        out[1] = chars[(group >> 12) & 0x3f];
+        out[2] = chars[(group >> 6) & 0x3f];
+        out[3] = chars[group & 0x3f];
+        out += 4;
+    }
+    size_t rest = size - i;
+    if (rest == 0) {
+        return;
+    }
+    uint32_t group = static_cast<uint32_t>(data[i]) << 16;
+    if (rest == 2) {
+        group |= static_cast<uint32_t>(data[i + 1]) << 8;
+    }
+    *out++ = chars[group >> 18];
+    *out++ = chars[(group >> 12) & 0x3f];
+    if (rest == 2) {
+        *out++ = chars[(group >> 6) & 0x3f];
+    } else if (padded) {
+        *out++ = '=';
+    }
+    if (padded) {
+        *out++ = '=';
+    }
+}
+
+std::string Base64Encode(const unsigned char* data, size_t size, Base64Alphabet alphabet, bool padded) {
+    std::string out(Base64EncodedLength(size, padded), '\0');
+    Base64Encode(data, size, &out[0], alphabet, padded);
+    return out;
+}
+
+std::string Base64Encode(std::string_view bytes, Base64Alphabet alphabet, bool padded) {
+    return Base64Encode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), alphabet, padded);
+}
+
+std::optional<std::vector<uint8_t>> Base64Decode(std::string_view base64, Base64Alphabet alphabet) {
+    const DecodeTable& values =
+        alphabet == Base64Alphabet::URL_SAFE ? kBase64UrlSafeValues : kBase64StandardValues;
+    if (base64.size() % 4 == 0) {
+        for (int pad = 0; pad < 2 && !base64.empty() && base64.back() == '='; ++pad) {
+            base64.remove_suffix(1);
+        }
+    }
+    if (base64.size() % 4 == 1) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> out(base64.size() * 3 / 4);
+    uint8_t* next = out.data();
+    size_t i = 0;
+    for (; i + 4 <= base64.size(); i += 4) {
+        int8_t a = values[base64[i]];
+        int8_t b = values[base64[i + 1]];
+        int8_t c = values[base64[i + 2]];
+        int8_t d = values[base64[i + 3]];
+        if ((a | b | c | d) < 0) {
+            return std::nullopt;
+        }
+        uint32_t group = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) |
+                         (static_cast<uint32_t>(c) << 6) | static_cast<uint32_t>(d);
+        next[0] = static_cast<uint8_t>(group >> 16);
+        next[1] = static_cast<uint8_t>(group >> 8);
+        next[2] = static_cast<uint8_t>(group);
+        next += 3;
+    }
+    size_t rest = base64.size() - i;
+    if (rest > 0) {
+        int8_t a = values[base64[i]];
+        int8_t b = values[base64[i + 1]];
+        int8_t c = rest == 3 ? values[base64[i + 2]] : 0;
+        if ((a | b | c) < 0) {
+            return std::nullopt;
+        }
+        uint32_t group = (static_cast<uint32_t>(a) << 18) | (static_cast<uint32_t>(b) << 12) |
+                         (static_cast<uint32_t>(c) << 6);
+        *next++ = static_cast<uint8_t>(group >> 16);
+        if (rest == 3) {
+            *next++ = static_cast<uint8_t>(group >> 8);
+        }
+    }
+    return out;
+}
+
+namespace {
+
+constexpr size_t RANDOM_POOL_SIZE = 4096;
+
+// Bumped in a forked child so it never hands out bytes the parent already has
+std::atomic<uint64_t> g_fork_generation{1};
+
+uint64_t ForkGeneration() {
+    static const bool registered = [] {
+        pthread_atfork(nullptr, nullptr, [] { g_fork_generation.fetch_add(1); });
+        return true;
+    }();
+    (void)registered;
+    return g_fork_generation.load(std::memory_order_relaxed);
+}
+
+struct RandomPool {
+    std::array<unsigned char, RANDOM_POOL_SIZE> bytes;
+    size_t used = RANDOM_POOL_SIZE;   // Starts empty
+    uint64_t generation = 0;
+};
+
+void FillRandom(unsigned char* out, size_t size) {
+    if (RAND_bytes(out, static_cast<int>(size)) != 1) {
+        throw std::runtime_error("Failed to generate random bytes");
+    }
+}
+
+} // namespace
+
+void RandomBytes(unsigned char* out, size_t size) {
+    if (size > RANDOM_POOL_SIZE / 4) {
+        FillRandom(out, size);
+        return;
+    }
+
+    thread_local RandomPool pool;
+    uint64_t generation = ForkGeneration();
+    if (pool.generation != generation) {
+        pool.used = RANDOM_POOL_SIZE;
+        pool.generation = generation;
+    }
+
+    while (size > 0) {
+        if (pool.used == RANDOM_POOL_SIZE) {
+            FillRandom(pool.bytes.data(), RANDOM_POOL_SIZE);
+            pool.used = 0;
+        }
+        size_t n = std::min(size, RANDOM_POOL_SIZE - pool.used);
+        std::memcpy(out, pool.bytes.data() + pool.used, n);
+        OPENSSL_cleanse(pool.bytes.data() + pool.used, n);   // Handed-out bytes do not linger
+        pool.used += n;
+        out += n;
+        size -= n;
+    }
+}
+
+std::string RandomHex(size_t bytes) {
+    unsigned char stack[64];
+    std::vector<unsigned char> heap;
+    unsigned char* buffer = stack;
+    if (bytes > sizeof(stack)) {
+        heap.resize(bytes);
+        buffer = heap.data();
+    }
+    RandomBytes(buffer, bytes);
+    return HexEncode(buffer, bytes);
+}
+
+} // namespace common
+} // namespace saasforge
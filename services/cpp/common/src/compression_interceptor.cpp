@@ -0,0 +1,281 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server interceptor compressing responses above a per-method size threshold implementation
+ */
+
+#include "common/compression_interceptor.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <grpcpp/grpcpp.h>
+#include <zlib.h>
+#include <time.h>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+using grpc::experimental::InterceptionHookPoints;
+
+/// "gzip", "deflate" or "none"; false for anything gRPC cannot send
+bool ParseAlgorithm(const std::string& name, grpc_compression_algorithm* algorithm) {
+    if (name == "none" || name == "identity") {
+        *algorithm = GRPC_COMPRESS_NONE;
+        return true;
+    }
+    if (name == "gzip") {
+        *algorithm = GRPC_COMPRESS_GZIP;
+        return true;
+    }
+    if (name == "deflate") {
+        *algorithm = GRPC_COMPRESS_DEFLATE;
+        return true;
+    }
+    return false;
+}
+
+std::string Trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+int64_t ThreadCpuMicros() {
+    struct timespec now {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Compress `buffer` as gRPC's zlib path would and record ratio and CPU time
+ */
+void Sample(CompressionInterceptorFactory::MethodPolicy& policy, const grpc::ByteBuffer& buffer) {
+    std::vector<grpc::Slice> slices;
+    if (!buffer.Dump(&slices).ok()) {
+        return;
+    }
+
+    int64_t started = ThreadCpuMicros();
+    z_stream stream {};
+    // gRPC: default level, 15 bit window (+16 for the gzip wrapper)
+    int window_bits = policy.rule.algorithm == GRPC_COMPRESS_GZIP ? 15 | 16 : 15;
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return;
+    }
+    unsigned char out[16 * 1024];
+    size_t compressed = 0;
+    bool ok = true;
+    for (size_t i = 0; i < slices.size() && ok; ++i) {
+        stream.next_in = const_cast<Bytef*>(slices[i].begin());
+        stream.avail_in = static_cast<uInt>(slices[i].size());
+        int flush = i + 1 == slices.size() ? Z_FINISH : Z_NO_FLUSH;
+        int result = Z_OK;
+        do {
+            stream.next_out = out;
+            stream.avail_out = sizeof(out);
+            result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) {
+                ok = false;
+                break;
+            }
+            compressed += sizeof(out) - stream.avail_out;
+        } while (stream.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+    }
+    deflateEnd(&stream);
+    int64_t cpu_micros = ThreadCpuMicros() - started;
+
+    if (ok && compressed > 0) {
+        policy.ratio->Record(static_cast<uint64_t>(
+            std::llround(100.0 * static_cast<double>(buffer.Length()) / static_cast<double>(compressed))));
+        policy.cpu->Record(static_cast<uint64_t>(cpu_micros));
+    }
+}
+
+class CompressionInterceptor : public grpc::experimental::Interceptor {
+public:
+    CompressionInterceptor(CompressionInterceptorFactory::MethodPolicy& policy, uint64_t sample_every)
+        : policy_(policy), sample_every_(sample_every) {}
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override {
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_INITIAL_METADATA)) {
+            Decide(methods);
+        }
+        methods->Proceed();
+    }
+
+private:
+    void Decide(grpc::experimental::InterceptorBatchMethods* methods) {
+        auto* metadata = methods->GetSendInitialMetadata();
+        if (!metadata || policy_.rule.algorithm == GRPC_COMPRESS_NONE ||
+            metadata->count(GRPC_COMPRESSION_REQUEST_ALGORITHM_MD_KEY) > 0) {
+            return;   // Disabled, or the handler chose an algorithm itself
+        }
+
+        // Unary: the response is in this batch. Streaming: no message yet
+        grpc::ByteBuffer* buffer = nullptr;
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_MESSAGE)) {
+            buffer = methods->GetSerializedSendMessage();
+        }
+        size_t size = buffer ? buffer->Length() : 0;
+        bool compress = buffer ? size >= policy_.rule.min_bytes : policy_.rule.min_bytes == 0;
+        if (!compress) {
+            policy_.skipped->Increment();
+            return;
+        }
+
+        const char* name = nullptr;
+        grpc_compression_algorithm_name(policy_.rule.algorithm, &name);
+        metadata->emplace(GRPC_COMPRESSION_REQUEST_ALGORITHM_MD_KEY, name);
+        policy_.compressed->Increment();
+
+        uint64_t count = policy_.compressed_count.fetch_add(1, std::memory_order_relaxed);
+        if (buffer && sample_every_ > 0 && count % sample_every_ == 0) {
+            Sample(policy_, *buffer);
+        }
+    }
+
+    CompressionInterceptorFactory::MethodPolicy& policy_;
+    uint64_t sample_every_;
+};
+
+} // namespace
+
+CompressionOptions CompressionOptions::FromEnv() {
+    CompressionOptions options;
+    std::string algorithm = EnvString("GRPC_COMPRESSION_ALGORITHM");
+    if (!algorithm.empty() && !ParseAlgorithm(algorithm, &options.defaults.algorithm)) {
+        LogError("Unsupported GRPC_COMPRESSION_ALGORITHM, using gzip", {{"algorithm", algorithm}});
+    }
+    options.defaults.min_bytes = static_cast<size_t>(
+        EnvInt("GRPC_COMPRESSION_MIN_BYTES", static_cast<long>(options.defaults.min_bytes)));
+    options.sample_every = static_cast<uint64_t>(
+        EnvInt("GRPC_COMPRESSION_SAMPLE_EVERY", static_cast<long>(options.sample_every)));
+    std::string methods = EnvString("GRPC_COMPRESSION_METHODS");
+    if (!methods.empty()) {
+        options.methods = ParseMethods(methods, options.defaults);
+    }
+    return options;
+}
+
+std::unordered_map<std::string, CompressionRule> CompressionOptions::ParseMethods(const std::string& spec,
+                                                                                  const CompressionRule& defaults) {
+    std::unordered_map<std::string, CompressionRule> rules;
+    std::stringstream entries(spec);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        entry = Trim(entry);
+        if (entry.empty()) {
+            continue;
+        }
+
+        // Method[=algorithm][:min_bytes]
+        CompressionRule rule = defaults;
+        std::string method = entry;
+        std::string value;
+        size_t equals = entry.find('=');
+        if (equals != std::string::npos) {
+            method = Trim(entry.substr(0, equals));
+            value = Trim(entry.substr(equals + 1));
+        }
+        std::string algorithm = value;
+        size_t colon = value.find(':');
+        bool ok = !method.empty();
+        if (colon != std::string::npos) {
+            algorithm = Trim(value.substr(0, colon));
+            std::string bytes = Trim(value.substr(colon + 1));
+            char* end = nullptr;
+            long parsed = std::strtol(bytes.c_str(), &end, 10);
+            ok = ok && !bytes.empty() && end && *end == '\0' && parsed >= 0;
+            rule.min_bytes = static_cast<size_t>(parsed);
+        }
+        if (!algorithm.empty()) {
+            ok = ok && ParseAlgorithm(algorithm, &rule.algorithm);
+        }
+        if (!ok) {
+            LogError("Ignoring GRPC_COMPRESSION_METHODS entry", {{"entry", entry}});
+            continue;
+        }
+        rules[method] = rule;
+    }
+    return rules;
+}
+
+CompressionRule CompressionOptions::RuleFor(const std::string& method) const {
+    auto it = methods.find(method);
+    if (it != methods.end()) {
+        return it->second;
+    }
+    size_t slash = method.rfind('/');
+    if (slash != std::string::npos) {
+        it = methods.find(method.substr(slash + 1));
+        if (it != methods.end()) {
+            return it->second;
+        }
+    }
+    return defaults;
+}
+
+CompressionInterceptorFactory::CompressionInterceptorFactory(CompressionOptions options, MetricsRegistry& registry)
+    : options_(std::move(options)), registry_(registry) {}
+
+grpc::experimental::Interceptor* CompressionInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    return new CompressionInterceptor(ForMethod(info->method()), options_.sample_every);
+}
+
+CompressionInterceptorFactory::MethodPolicy& CompressionInterceptorFactory::ForMethod(const char* method) {
+    std::string name = method ? method : "";
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = methods_.find(name);
+        if (it != methods_.end()) {
+            return *it->second;
+        }
+    }
+
+    // "/package.Service/Method"
+    std::string service = "unknown";
+    std::string rpc = name;
+    size_t slash = name.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        service = name.substr(1, slash - 1);
+        rpc = name.substr(slash + 1);
+    }
+    MetricLabels labels = {{"grpc_service", service}, {"grpc_method", rpc}};
+    MetricLabels compressed_labels = labels;
+    compressed_labels.emplace_back("decision", "compressed");
+    MetricLabels skipped_labels = labels;
+    skipped_labels.emplace_back("decision", "skipped");
+
+    HistogramOptions ratio_options;
+    ratio_options.bounds = {1, 1.5, 2, 3, 4, 6, 8, 12, 16, 32};
+    ratio_options.unit = 0.01;
+
+    auto policy = std::make_unique<MethodPolicy>();
+    policy->rule = options_.RuleFor(name);
+    policy->compressed = &registry_.GetCounter("saasforge_grpc_server_compression_total",
+                                               "Responses by compression decision", compressed_labels);
+    policy->skipped = &registry_.GetCounter("saasforge_grpc_server_compression_total",
+                                            "Responses by compression decision", skipped_labels);
+    policy->ratio = &registry_.GetHistogram("saasforge_grpc_server_compression_ratio",
+                                            "Uncompressed / compressed size of sampled responses",
+                                            ratio_options, labels);
+    policy->cpu = &registry_.GetHistogram("saasforge_grpc_server_compression_seconds",
+                                          "CPU time to compress sampled responses",
+                                          HistogramOptions::LatencySeconds(), labels);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto [it, inserted] = methods_.emplace(name, std::move(policy));
+    return *it->second;
+}
+
+} // namespace common
+} // namespace saasforge
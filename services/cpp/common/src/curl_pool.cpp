@@ -0,0 +1,116 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Pooled libcurl handles over one share of connections, DNS and TLS sessions implementation
+ */
+
+#include "common/curl_pool.h"
+#include <stdexcept>
+#include <utility>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+std::once_flag curl_init_once;
+
+} // namespace
+
+CurlPool::CurlPool(CurlPoolOptions options) : options_(std::move(options)) {
+    std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    share_ = curl_share_init();
+    if (!share_) {
+        throw std::runtime_error("Failed to create libcurl share handle");
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, Lock);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, Unlock);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+CurlPool::~CurlPool() {
+    for (CURL* easy : easy_handles_) {
+        curl_easy_cleanup(easy);
+    }
+    for (CURLM* multi : multi_handles_) {
+        curl_multi_cleanup(multi);
+    }
+    curl_share_cleanup(share_);
+}
+
+void CurlPool::Lock(CURL*, curl_lock_data data, curl_lock_access, void* user) {
+    static_cast<CurlPool*>(user)->locks_[data].lock();
+}
+
+void CurlPool::Unlock(CURL*, curl_lock_data data, void* user) {
+    static_cast<CurlPool*>(user)->locks_[data].unlock();
+}
+
+CURL* CurlPool::TakeEasy() {
+    CURL* easy = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!easy_handles_.empty()) {
+            easy = easy_handles_.back();
+            easy_handles_.pop_back();
+        }
+    }
+    if (easy) {
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+        if (!easy) {
+            return nullptr;
+        }
+    }
+    Configure(easy);
+    return easy;
+}
+
+void CurlPool::ReturnEasy(CURL* easy) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    easy_handles_.push_back(easy);
+}
+
+CURLM* CurlPool::TakeMulti() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!multi_handles_.empty()) {
+            CURLM* multi = multi_handles_.back();
+            multi_handles_.pop_back();
+            return multi;
+        }
+    }
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("Failed to create libcurl multi handle");
+    }
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX));
+    return multi;
+}
+
+void CurlPool::ReturnMulti(CURLM* multi) {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    multi_handles_.push_back(multi);
+}
+
+void CurlPool::Configure(CURL* easy) const {
+    curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+    if (!options_.user_agent.empty()) {
+        curl_easy_setopt(easy, CURLOPT_USERAGENT, options_.user_agent.c_str());
+    }
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 0L);
+    curl_easy_setopt(easy, CURLOPT_PROTOCOLS_STR, options_.protocols.c_str());
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(options_.connect_timeout.count()));
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(options_.request_timeout.count()));
+}
+
+} // namespace common
+} // namespace saasforge
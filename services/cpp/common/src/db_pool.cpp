@@ -1,103 +1,661 @@
 #include "common/db_pool.h"
+#include "common/db_replicas.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/tracing.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <future>
 #include <stdexcept>
-#include <iostream>
 
 namespace saasforge {
 namespace common {
 
+namespace {
+
+void WriteWaitHistogram(MetricsWriter& writer, const char* name, const char* help,
+                        const MetricLabels& labels, const WaitHistogram& histogram) {
+    const auto& bounds_us = WaitHistogram::BucketBoundsUs();
+    std::vector<double> bounds;
+    std::vector<uint64_t> cumulative;
+    uint64_t running = 0;
+    for (size_t i = 0; i < bounds_us.size(); ++i) {
+        running += histogram.buckets[i];
+        bounds.push_back(static_cast<double>(bounds_us[i]) * 1e-6);
+        cumulative.push_back(running);
+    }
+    writer.AddHistogram(name, help, labels, bounds, cumulative, histogram.count,
+                        static_cast<double>(histogram.sum_us) * 1e-6);
+}
+
+} // namespace
+
+DbPoolOptions DbPoolOptions::FromEnv() {
+    DbPoolOptions options;
+    options.min_size = static_cast<size_t>(EnvInt("DB_POOL_MIN_SIZE", static_cast<long>(options.min_size)));
+    options.max_size = static_cast<size_t>(EnvInt("DB_POOL_MAX_SIZE", static_cast<long>(options.max_size)));
+    options.acquire_timeout = std::chrono::milliseconds(
+        EnvInt("DB_POOL_ACQUIRE_TIMEOUT_MS", static_cast<long>(options.acquire_timeout.count())));
+    options.idle_timeout = std::chrono::seconds(
+        EnvInt("DB_POOL_IDLE_TIMEOUT_S", static_cast<long>(options.idle_timeout.count())));
+    options.health_check_interval = std::chrono::seconds(
+        EnvInt("DB_POOL_HEALTH_CHECK_INTERVAL_S", static_cast<long>(options.health_check_interval.count())));
+
+    options.replica_urls = EnvList("DB_REPLICA_URLS");
+    options.replica_max_lag = std::chrono::milliseconds(
+        EnvInt("DB_REPLICA_MAX_LAG_MS", static_cast<long>(options.replica_max_lag.count())));
+    options.replica_check_interval = std::chrono::milliseconds(
+        EnvInt("DB_REPLICA_CHECK_INTERVAL_MS", static_cast<long>(options.replica_check_interval.count())));
+    options.replica_sticky = std::chrono::milliseconds(
+        EnvInt("DB_REPLICA_STICKY_MS", static_cast<long>(options.replica_sticky.count())));
+    options.cancel_check_interval = std::chrono::milliseconds(
+        EnvInt("DB_POOL_CANCEL_CHECK_MS", static_cast<long>(options.cancel_check_interval.count())));
+    options.resilience = DependencyOptions::FromEnv("DB");
+    return options;
+}
+
+const std::array<int64_t, WaitHistogram::NUM_BUCKETS - 1>& WaitHistogram::BucketBoundsUs() {
+    static const std::array<int64_t, NUM_BUCKETS - 1> bounds = {
+        100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000
+    };
+    return bounds;
+}
+
+void DbPool::AtomicHistogram::Record(int64_t wait_us) {
+    const auto& bounds = WaitHistogram::BucketBoundsUs();
+    size_t bucket = std::upper_bound(bounds.begin(), bounds.end(), wait_us - 1) - bounds.begin();
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(wait_us, std::memory_order_relaxed);
+}
+
+WaitHistogram DbPool::AtomicHistogram::Snapshot() const {
+    WaitHistogram snapshot;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        snapshot.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count = count.load(std::memory_order_relaxed);
+    snapshot.sum_us = sum_us.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
 DbPool::DbPool(const std::string& connection_string, size_t pool_size)
+    : DbPool(connection_string, [pool_size] {
+          DbPoolOptions options;
+          options.min_size = pool_size;
+          options.max_size = pool_size;
+          return options;
+      }()) {
+}
+
+DbPool::DbPool(const std::string& connection_string, const DbPoolOptions& options)
     : connection_string_(connection_string),
-      pool_size_(pool_size),
-      shutdown_(false) {
+      options_(options) {
+    options_.max_size = std::max<size_t>(options_.max_size, 1);
+    options_.min_size = std::min(options_.min_size, options_.max_size);
+    options_.resilience.limit = options_.resilience.limit.ForCapacity(options_.max_size);
+    dependency_ = std::make_unique<Dependency>(
+        options_.name.empty() ? "postgres" : "postgres:" + options_.name, options_.resilience);
+
+    size_t stripes = options_.stripes > 0
+        ? options_.stripes
+        : std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    stripes = std::min(stripes, options_.max_size);
+    for (size_t i = 0; i < stripes; ++i) {
+        stripes_.push_back(std::make_unique<Stripe>());
+    }
+
     InitializePool();
+    maintenance_thread_ = std::thread(&DbPool::MaintenanceLoop, this);
+    if (options_.cancel_check_interval.count() > 0) {
+        watchdog_thread_ = std::thread(&DbPool::WatchdogLoop, this);
+    }
+    metrics_collector_ = MetricsRegistry::Global().AddCollector(
+        [this](MetricsWriter& writer) { ExportMetrics(writer); });
+
+    if (!options_.replica_urls.empty()) {
+        replicas_ = std::make_unique<ReplicaSet>(*this, options_);
+    }
 }
 
 DbPool::~DbPool() {
-    std::unique_lock<std::mutex> lock(mutex_);
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+    Shutdown(std::chrono::milliseconds(0));
+}
+
+bool DbPool::Shutdown(std::chrono::milliseconds timeout) {
+    // Replicas first: their monitor reads the primary's WAL position
+    if (replicas_) {
+        replicas_->Shutdown(timeout);
+    }
+
     shutdown_ = true;
-    cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mutex_);
+    }
+    maintenance_cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+    }
+    watch_cv_.notify_all();
+
+    {
+        std::lock_guard<std::mutex> lock(shutdown_mutex_);
+        if (maintenance_thread_.joinable()) {
+            maintenance_thread_.join();
+        }
+        if (watchdog_thread_.joinable()) {
+            watchdog_thread_.join();
+        }
+    }
+
+    // Close all idle connections; borrowed ones are discarded on return
+    size_t closed = 0;
+    for (auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe->mutex);
+        closed += stripe->idle.size();
+        stripe->idle.clear();
+    }
+    if (closed > 0) {
+        idle_count_ -= closed;
+        total_ -= closed;
+        closed_ += closed;
+    }
 
-    // Close all connections
-    while (!pool_.empty()) {
-        pool_.pop();
+    // Wake blocked callers (they fail), then wait for borrowed connections
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    wait_cv_.notify_all();
+    waiters_++;
+    bool drained = wait_cv_.wait_for(lock, timeout, [this] { return total_ == 0; });
+    waiters_--;
+
+    if (!drained) {
+        LogWarn("Database pool closed with connections still in use", {{"active", total_.load()}});
     }
+    return drained;
 }
 
 void DbPool::InitializePool() {
-    try {
-        for (size_t i = 0; i < pool_size_; ++i) {
-            auto conn = std::make_shared<pqxx::connection>(connection_string_);
-            if (!conn->is_open()) {
-                throw std::runtime_error("Failed to open database connection");
-            }
-            pool_.push(conn);
+    // Connect (and prepare every statement) on all connections at once, so
+    // startup takes one connection's round trips rather than min_size times as many
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<std::shared_ptr<pqxx::connection>>> connecting;
+    connecting.reserve(options_.min_size);
+    for (size_t i = 0; i < options_.min_size; ++i) {
+        connecting.push_back(std::async(std::launch::async, [this] { return CreateConnection(); }));
+    }
+
+    std::string error;
+    for (auto& connection : connecting) {
+        try {
+            auto conn = connection.get();
+            total_++;
+            PushIdle(std::move(conn));
+        } catch (const std::exception& e) {
+            error = e.what();
         }
-        std::cout << "Database connection pool initialized with " << pool_size_ << " connections" << std::endl;
-    } catch (const std::exception& e) {
-        throw std::runtime_error(std::string("Failed to initialize database pool: ") + e.what());
     }
+    if (!error.empty()) {
+        throw std::runtime_error("Failed to initialize database pool: " + error);
+    }
+    LogInfo("Database connection pool initialized", {
+        {"connections", options_.min_size},
+        {"max", options_.max_size},
+        {"duration_ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count()}
+    });
 }
 
-std::shared_ptr<pqxx::connection> DbPool::GetConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
+std::shared_ptr<pqxx::connection> DbPool::GetConnection(const char* caller) {
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = ResilienceScope::DeadlineOr(start + options_.acquire_timeout);
+
+    while (true) {
+        if (shutdown_) {
+            throw std::runtime_error("Database pool is shutting down");
+        }
+
+        // Fast path: idle connection from this thread's stripe (or any other)
+        if (auto conn = TryTakeIdle()) {
+            if (conn->is_open()) {
+                acquired_++;
+                RecordWait(caller, std::chrono::steady_clock::now() - start);
+                return conn;
+            }
+            // Dead connection: drop it; maintenance replaces it off the request path
+            Discard();
+            continue;
+        }
+
+        // Grow on demand while below max_size
+        if (TryReserveSlot()) {
+            try {
+                auto conn = CreateConnection();
+                acquired_++;
+                RecordWait(caller, std::chrono::steady_clock::now() - start);
+                return conn;
+            } catch (...) {
+                Discard();
+                throw;
+            }
+        }
+
+        // Exhausted: wait for a return, a freed slot, or the deadline
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        waiters_++;
+        bool ready = wait_cv_.wait_until(lock, deadline, [this] {
+            return shutdown_ || idle_count_ > 0 || total_ < options_.max_size;
+        });
+        waiters_--;
+
+        if (!ready) {
+            timeouts_++;
+            RecordWait(caller, std::chrono::steady_clock::now() - start);
+            ResilienceScope::MarkShed("Timed out waiting for database connection");
+            throw std::runtime_error("Timed out waiting for database connection");
+        }
+    }
+}
 
-    // Wait until a connection is available
-    cv_.wait(lock, [this] { return !pool_.empty() || shutdown_; });
+void DbPool::ReturnConnection(std::shared_ptr<pqxx::connection> conn) {
+    if (conn) {
+        Recycle(std::move(conn));
+    }
+}
 
+bool DbPool::Recycle(std::shared_ptr<pqxx::connection> conn) {
     if (shutdown_) {
-        throw std::runtime_error("Database pool is shutting down");
+        Discard(); // Don't return connections if shutting down
+        return true;
     }
 
-    if (pool_.empty()) {
-        throw std::runtime_error("No database connections available");
+    bool open = false;
+    try {
+        open = conn->is_open();
+    } catch (const std::exception& e) {
+        LogError("Failed to return connection to pool", {{"error", e.what()}});
     }
 
-    auto conn = pool_.front();
-    pool_.pop();
+    if (open) {
+        PushIdle(std::move(conn));
+    } else {
+        // Broken connection: free the slot; no reconnect on the caller's thread
+        Discard();
+    }
+    return open;
+}
 
-    // Verify connection is still alive, reconnect if needed
+DbPool::ConnectionGuard DbPool::AcquireConnection(const char* caller) {
+    Span span("db.acquire");
+    if (caller) {
+        span.SetAttribute("db.caller", caller);
+    }
     try {
-        if (!conn->is_open()) {
-            conn = std::make_shared<pqxx::connection>(connection_string_);
-        }
+        // A timed-out wait or failed connect unwinds the permit as a failure
+        auto permit = dependency_->Admit();
+        auto conn = GetConnection(caller);
+        uint64_t watch = Watch(conn);
+        return ConnectionGuard(this, std::move(conn), std::move(permit), watch);
     } catch (const std::exception& e) {
-        // Try to create a new connection
-        conn = std::make_shared<pqxx::connection>(connection_string_);
+        span.SetError(e.what());
+        throw;
+    }
+}
+
+DbPool::ConnectionGuard DbPool::AcquireReadConnection(const char* caller, const std::string& session) {
+    if (replicas_) {
+        int index = replicas_->Choose(session);
+        if (DbPool* replica = replicas_->Pool(index)) {
+            try {
+                return replica->AcquireConnection(caller);
+            } catch (const DependencyUnavailable&) {
+                // Replica shed or its breaker is open: straight to the primary
+            } catch (const std::exception& e) {
+                // Ejected by the next check if it persists; this read falls back to the primary
+                LogWarn("Replica connection failed", {{"replica", index}, {"error", e.what()}});
+            }
+        }
+    }
+    return AcquireConnection(caller);
+}
+
+void DbPool::RecordWrite(const std::string& session) {
+    if (replicas_) {
+        replicas_->RecordWrite(session);
+    }
+}
+
+void DbPool::ExportMetrics(MetricsWriter& writer) const {
+    DbPoolStats stats = GetStats();
+
+    // Replica pools are told apart by pool=<name>; the primary's series carry no pool label
+    auto labels = [this](MetricLabels extra = {}) {
+        if (!options_.name.empty()) {
+            extra.insert(extra.begin(), {"pool", options_.name});
+        }
+        return extra;
+    };
+
+    writer.AddGauge("saasforge_db_pool_connections", "Open database connections", labels({{"state", "idle"}}),
+                    static_cast<double>(stats.idle));
+    writer.AddGauge("saasforge_db_pool_connections", "Open database connections", labels({{"state", "active"}}),
+                    static_cast<double>(stats.active));
+    writer.AddGauge("saasforge_db_pool_max_connections", "Database pool size limit", labels(),
+                    static_cast<double>(options_.max_size));
+    writer.AddGauge("saasforge_db_pool_waiting", "Callers blocked waiting for a connection", labels(),
+                    static_cast<double>(stats.waiting));
+    writer.AddCounter("saasforge_db_pool_acquire_timeouts_total", "Acquires that timed out", labels(),
+                      static_cast<double>(stats.timeouts));
+    writer.AddCounter("saasforge_db_pool_connections_created_total", "Connections opened", labels(),
+                      static_cast<double>(stats.created));
+    writer.AddCounter("saasforge_db_pool_health_check_failures_total", "Failed liveness checks", labels(),
+                      static_cast<double>(stats.health_check_failures));
+    writer.AddCounter("saasforge_db_pool_queries_cancelled_total", "Queries cancelled for abandoned RPCs",
+                      labels({{"reason", "deadline"}}), static_cast<double>(stats.cancelled_deadline));
+    writer.AddCounter("saasforge_db_pool_queries_cancelled_total", "Queries cancelled for abandoned RPCs",
+                      labels({{"reason", "cancelled"}}), static_cast<double>(stats.cancelled_abandoned));
+    WriteWaitHistogram(writer, "saasforge_db_pool_acquire_seconds", "Time to acquire a database connection",
+                       labels(), stats.wait);
+    for (const auto& [caller, histogram] : stats.callers) {
+        WriteWaitHistogram(writer, "saasforge_db_pool_caller_acquire_seconds",
+                           "Time to acquire a database connection, per caller", labels({{"caller", caller}}),
+                           histogram);
     }
+}
+
+DbPoolStats DbPool::GetStats() const {
+    DbPoolStats stats;
+    stats.total = total_.load();
+    stats.idle = idle_count_.load();
+    stats.active = stats.total > stats.idle ? stats.total - stats.idle : 0;
+    stats.waiting = waiters_.load();
+    stats.acquired = acquired_.load();
+    stats.timeouts = timeouts_.load();
+    stats.created = created_.load();
+    stats.closed = closed_.load();
+    stats.health_check_failures = health_check_failures_.load();
+    stats.cancelled_deadline = cancelled_deadline_.load();
+    stats.cancelled_abandoned = cancelled_abandoned_.load();
+    stats.wait = wait_histogram_.Snapshot();
 
+    std::shared_lock<std::shared_mutex> lock(callers_mutex_);
+    for (const auto& [caller, histogram] : caller_histograms_) {
+        stats.callers.emplace(caller, histogram->Snapshot());
+    }
+    return stats;
+}
+
+std::shared_ptr<pqxx::connection> DbPool::TryTakeIdle() {
+    if (idle_count_ == 0) {
+        return nullptr;
+    }
+
+    // First pass never blocks: skip stripes another thread holds
+    size_t home = HomeStripe();
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < stripes_.size(); ++i) {
+            auto& stripe = *stripes_[(home + i) % stripes_.size()];
+            std::unique_lock<std::mutex> lock(stripe.mutex, std::defer_lock);
+            if (pass == 0) {
+                if (!lock.try_lock()) {
+                    continue;
+                }
+            } else {
+                lock.lock();
+            }
+            if (!stripe.idle.empty()) {
+                auto conn = std::move(stripe.idle.back().conn);
+                stripe.idle.pop_back();
+                idle_count_--;
+                return conn;
+            }
+        }
+        if (idle_count_ == 0) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+bool DbPool::TryReserveSlot() {
+    size_t current = total_.load();
+    while (current < options_.max_size) {
+        if (total_.compare_exchange_weak(current, current + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<pqxx::connection> DbPool::CreateConnection() {
+    auto conn = std::make_shared<pqxx::connection>(connection_string_);
+    if (!conn->is_open()) {
+        throw std::runtime_error("Failed to open database connection");
+    }
+    StatementRegistry::Global().PrepareAll(*conn);
+    created_++;
     return conn;
 }
 
-void DbPool::ReturnConnection(std::shared_ptr<pqxx::connection> conn) {
-    if (!conn) {
+void DbPool::PushIdle(std::shared_ptr<pqxx::connection> conn) {
+    {
+        auto& stripe = *stripes_[HomeStripe()];
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.idle.push_back({std::move(conn), std::chrono::steady_clock::now()});
+        idle_count_++;
+    }
+    NotifyWaiters();
+}
+
+void DbPool::Discard() {
+    total_--;
+    closed_++;
+    NotifyWaiters();
+}
+
+void DbPool::NotifyWaiters() {
+    // Waiters re-check the predicate under wait_mutex_, so taking it here
+    // guarantees the notification cannot slip in before they sleep
+    if (waiters_ > 0) {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+        }
+        wait_cv_.notify_one();
+    }
+}
+
+void DbPool::RecordWait(const char* caller, std::chrono::steady_clock::duration wait) {
+    int64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+    wait_histogram_.Record(wait_us);
+
+    if (!caller) {
         return;
     }
 
-    std::unique_lock<std::mutex> lock(mutex_);
+    {
+        std::shared_lock<std::shared_mutex> lock(callers_mutex_);
+        auto it = caller_histograms_.find(caller);
+        if (it != caller_histograms_.end()) {
+            it->second->Record(wait_us);
+            return;
+        }
+    }
 
-    if (shutdown_) {
-        return; // Don't return connections if shutting down
+    std::unique_lock<std::shared_mutex> lock(callers_mutex_);
+    auto& histogram = caller_histograms_[caller];
+    if (!histogram) {
+        histogram = std::make_unique<AtomicHistogram>();
     }
+    histogram->Record(wait_us);
+}
 
-    // Verify connection is still good before returning to pool
-    try {
-        if (conn->is_open()) {
-            pool_.push(conn);
-            cv_.notify_one();
-        } else {
-            // Connection is bad, create a new one
-            auto new_conn = std::make_shared<pqxx::connection>(connection_string_);
-            pool_.push(new_conn);
-            cv_.notify_one();
+size_t DbPool::HomeStripe() const {
+    thread_local const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return thread_hash % stripes_.size();
+}
+
+void DbPool::MaintenanceLoop() {
+    while (!shutdown_) {
+        {
+            std::unique_lock<std::mutex> lock(maintenance_mutex_);
+            maintenance_cv_.wait_for(lock, options_.health_check_interval, [this] { return shutdown_.load(); });
+        }
+        if (shutdown_) {
+            break;
+        }
+
+        try {
+            RunMaintenance();
+        } catch (const std::exception& e) {
+            LogError("Database pool maintenance failed", {{"error", e.what()}});
+        }
+    }
+}
+
+uint64_t DbPool::Watch(std::shared_ptr<pqxx::connection> conn) {
+    // Only RPCs can be abandoned; background work runs to completion
+    const grpc::ServerContextBase* context = ResilienceScope::Context();
+    auto deadline = ResilienceScope::Deadline();
+    if (options_.cancel_check_interval.count() == 0 || (!context && !deadline)) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    uint64_t id = next_watch_id_++;
+    watched_.emplace(id, Watched{std::move(conn), deadline, context, false});
+    if (watched_.size() == 1) {
+        watch_cv_.notify_one();
+    }
+    return id;
+}
+
+bool DbPool::Unwatch(uint64_t id) {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    auto it = watched_.find(id);
+    if (it == watched_.end()) {
+        return false;
+    }
+    bool cancelled = it->second.cancelled;
+    watched_.erase(it);
+    return cancelled;
+}
+
+void DbPool::Drop(std::shared_ptr<pqxx::connection> conn) {
+    // Closed once the watchdog's in-flight cancel, if any, lets go of it too
+    conn.reset();
+    Discard();
+}
+
+void DbPool::WatchdogLoop() {
+    std::unique_lock<std::mutex> lock(watch_mutex_);
+    while (!shutdown_) {
+        watch_cv_.wait(lock, [this] { return shutdown_ || !watched_.empty(); });
+        watch_cv_.wait_for(lock, options_.cancel_check_interval, [this] { return shutdown_.load(); });
+        if (shutdown_) {
+            break;
+        }
+
+        // Victims are marked under the lock, so Unwatch() tells their guards to drop
+        // them, and cancelled without it: each cancel opens a connection to the server
+        std::vector<std::shared_ptr<pqxx::connection>> victims;
+        auto now = std::chrono::steady_clock::now();
+        for (auto& [id, watched] : watched_) {
+            if (watched.cancelled) {
+                continue;
+            }
+            bool expired = watched.deadline && *watched.deadline <= now;
+            if (!expired && !(watched.context && watched.context->IsCancelled())) {
+                continue;
+            }
+            watched.cancelled = true;
+            (expired ? cancelled_deadline_ : cancelled_abandoned_)++;
+            victims.push_back(watched.conn);
+        }
+        if (victims.empty()) {
+            continue;
+        }
+
+        lock.unlock();
+        for (const auto& conn : victims) {
+            // The handler gets query_canceled and its guard closes the connection
+            try {
+                conn->cancel_query();
+            } catch (const std::exception& e) {
+                LogWarn("Failed to cancel abandoned query", {{"error", e.what()}});
+            }
+        }
+        victims.clear();
+        lock.lock();
+    }
+}
+
+void DbPool::RunMaintenance() {
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto& stripe_ptr : stripes_) {
+        auto& stripe = *stripe_ptr;
+
+        // Take the stripe's idle list out so checks don't hold the lock
+        std::vector<IdleConnection> checking;
+        {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            checking.swap(stripe.idle);
+            idle_count_ -= checking.size();
+        }
+
+        std::vector<IdleConnection> healthy;
+        for (auto& entry : checking) {
+            bool expired = now - entry.idle_since > options_.idle_timeout;
+            if (expired && total_ > options_.min_size) {
+                Discard(); // Reap idle connection above min_size
+                continue;
+            }
+            if (!IsHealthy(*entry.conn)) {
+                health_check_failures_++;
+                Discard();
+                continue;
+            }
+            healthy.push_back(std::move(entry));
+        }
+
+        {
+            // Oldest first, ahead of anything returned while we were checking
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stripe.idle.insert(stripe.idle.begin(),
+                std::make_move_iterator(healthy.begin()), std::make_move_iterator(healthy.end()));
+            idle_count_ += healthy.size();
+        }
+        if (!healthy.empty()) {
+            NotifyWaiters();
+        }
+    }
+
+    // Replace reaped/broken connections up to min_size
+    while (!shutdown_ && total_ < options_.min_size && TryReserveSlot()) {
+        try {
+            PushIdle(CreateConnection());
+        } catch (const std::exception& e) {
+            Discard();
+            LogError("Database pool reconnect failed", {{"error", e.what()}});
+            break;
         }
-    } catch (const std::exception& e) {
-        // Failed to reconnect, just reduce pool size
-        std::cerr << "Failed to return connection to pool: " << e.what() << std::endl;
     }
 }
 
-DbPool::ConnectionGuard DbPool::AcquireConnection() {
-    return ConnectionGuard(this, GetConnection());
+bool DbPool::IsHealthy(pqxx::connection& conn) {
+    try {
+        if (!conn.is_open()) {
+            return false;
+        }
+        pqxx::nontransaction txn(conn);
+        txn.exec("SELECT 1");
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
 }
 
 } // namespace common
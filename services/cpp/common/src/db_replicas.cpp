@@ -0,0 +1,293 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Read replica routing with lag-based ejection for DbPool implementation
+ */
+
+#include "common/db_replicas.h"
+#include "common/db_pool.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/statement_registry.h"
+#include <algorithm>
+#include <optional>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const PreparedStatement kPrimaryLsn(
+    "db_replicas_primary_lsn",
+    "SELECT pg_current_wal_lsn()::text");
+
+// A replica promoted to primary has no replay position: report its own
+const PreparedStatement kReplayPosition(
+    "db_replicas_replay_position",
+    "SELECT COALESCE(pg_last_wal_replay_lsn(), pg_current_wal_lsn())::text AS replay_lsn, "
+    "COALESCE((EXTRACT(EPOCH FROM NOW() - pg_last_xact_replay_timestamp()) * 1000)::bigint, 0) AS replay_age_ms");
+
+} // namespace
+
+ReplicaSet::ReplicaSet(DbPool& primary, const DbPoolOptions& options)
+    : urls_(options.replica_urls),
+      replica_options_(std::make_unique<DbPoolOptions>(options)),
+      max_lag_(options.replica_max_lag),
+      check_interval_(std::max(options.replica_check_interval, std::chrono::milliseconds(1))),
+      sticky_(std::max(options.replica_sticky, options.replica_max_lag)),
+      probe_primary_([&primary] {
+          auto conn_guard = primary.AcquireConnection("ReplicaSet::Check");
+          pqxx::read_transaction txn(*conn_guard);
+          std::string lsn;
+          ReadText(ExecPrepared(txn, kPrimaryLsn)[0][0], lsn);
+          return ParseLsn(lsn);
+      }),
+      probe_replica_([this](size_t index) { return ProbeReplica(index); }) {
+    replica_options_->replica_urls.clear();
+    Start(urls_.size());
+}
+
+ReplicaSet::ReplicaSet(size_t replicas, PrimaryProbe primary, ReplicaProbe replica, const DbPoolOptions& options)
+    : max_lag_(options.replica_max_lag),
+      check_interval_(std::max(options.replica_check_interval, std::chrono::milliseconds(1))),
+      sticky_(std::max(options.replica_sticky, options.replica_max_lag)),
+      probe_primary_(std::move(primary)),
+      probe_replica_(std::move(replica)) {
+    Start(replicas);
+}
+
+void ReplicaSet::Start(size_t replicas) {
+    pools_.resize(replicas);
+    replicas_.resize(replicas);
+    for (size_t i = 0; i < replicas; ++i) {
+        replicas_[i].name = "replica-" + std::to_string(i);
+    }
+
+    metrics_collector_ = MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        for (const auto& status : GetStatus()) {
+            writer.AddGauge("saasforge_db_replica_healthy", "Replica serving reads (1) or ejected (0)",
+                            {{"replica", status.name}}, status.healthy ? 1.0 : 0.0);
+            writer.AddGauge("saasforge_db_replica_lag_seconds", "Replication lag at the last check",
+                            {{"replica", status.name}}, static_cast<double>(status.lag.count()) / 1000.0);
+        }
+        writer.AddCounter("saasforge_db_reads_total", "Read connections acquired", {{"target", "replica"}},
+                          static_cast<double>(replica_reads_.load()));
+        writer.AddCounter("saasforge_db_reads_total", "Read connections acquired", {{"target", "primary"}},
+                          static_cast<double>(primary_reads_.load()));
+        writer.AddCounter("saasforge_db_replica_ejections_total", "Replicas taken out of rotation", {},
+                          static_cast<double>(ejections_.load()));
+    });
+
+    // The first check runs at once, so replicas serve reads as soon as they are reachable
+    periodic_ = Executor::Background().SchedulePeriodic(check_interval_, [this] { Monitor(); });
+}
+
+ReplicaSet::~ReplicaSet() {
+    Shutdown(std::chrono::milliseconds(0));
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+void ReplicaSet::Shutdown(std::chrono::milliseconds timeout) {
+    if (shutdown_.exchange(true)) {
+        return;
+    }
+    Executor::Background().Cancel(periodic_);
+
+    std::vector<DbPool*> pools;
+    {
+        std::unique_lock<std::shared_mutex> lock(state_mutex_);
+        for (auto& replica : replicas_) {
+            replica.healthy = false;
+        }
+        for (auto& pool : pools_) {
+            if (pool) {
+                pools.push_back(pool.get());
+            }
+        }
+    }
+    for (auto* pool : pools) {
+        pool->Shutdown(timeout);
+    }
+}
+
+int ReplicaSet::Choose(const std::string& session) {
+    auto now = std::chrono::steady_clock::now();
+    std::optional<std::chrono::steady_clock::time_point> written;
+    if (!session.empty()) {
+        std::lock_guard<std::mutex> lock(writes_mutex_);
+        auto it = writes_.find(session);
+        if (it != writes_.end() && now - it->second < sticky_) {
+            written = it->second;
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> lock(state_mutex_);
+    uint64_t needed = 0;
+    if (written) {
+        // The primary's position is only known to include the write once sampled after it
+        if (primary_sampled_at_ <= *written) {
+            ++primary_reads_;
+            return -1;
+        }
+        needed = primary_lsn_;
+    }
+
+    size_t count = replicas_.size();
+    size_t start = count > 0 ? static_cast<size_t>(next_++ % count) : 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t index = (start + i) % count;
+        const auto& replica = replicas_[index];
+        if (replica.healthy && replica.replay_lsn >= needed) {
+            ++replica_reads_;
+            return static_cast<int>(index);
+        }
+    }
+    ++primary_reads_;
+    return -1;
+}
+
+DbPool* ReplicaSet::Pool(int index) {
+    std::shared_lock<std::shared_mutex> lock(state_mutex_);
+    if (index < 0 || static_cast<size_t>(index) >= pools_.size()) {
+        return nullptr;
+    }
+    return pools_[index].get();
+}
+
+void ReplicaSet::RecordWrite(const std::string& session) {
+    if (session.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(writes_mutex_);
+    writes_[session] = std::chrono::steady_clock::now();
+}
+
+void ReplicaSet::Check() {
+    // Sampled before the primary is asked: a write recorded earlier is included
+    auto primary_sampled_at = std::chrono::steady_clock::now();
+    std::optional<uint64_t> primary_lsn;
+    try {
+        primary_lsn = probe_primary_();
+    } catch (const std::exception& e) {
+        LogWarn("Reading the primary WAL position failed", {{"error", e.what()}});
+    }
+
+    std::vector<Replica> sampled;
+    {
+        std::shared_lock<std::shared_mutex> lock(state_mutex_);
+        sampled = replicas_;
+    }
+
+    for (size_t i = 0; i < sampled.size(); ++i) {
+        auto& replica = sampled[i];
+        bool was_healthy = replica.healthy;
+        try {
+            ReplicaSample sample = probe_replica_(i);
+            replica.replay_lsn = sample.replay_lsn;
+            replica.lag = primary_lsn && sample.replay_lsn >= *primary_lsn
+                ? std::chrono::milliseconds(0) : sample.replay_age;
+            // Without the primary's position, only a replica known to be caught up stays in
+            replica.healthy = (primary_lsn || was_healthy) && replica.lag <= max_lag_;
+        } catch (const std::exception& e) {
+            replica.healthy = false;
+            if (was_healthy) {
+                LogWarn("Replica unreachable", {{"replica", replica.name}, {"error", e.what()}});
+            }
+        }
+
+        if (was_healthy && !replica.healthy) {
+            ++ejections_;
+            LogWarn("Replica ejected", {{"replica", replica.name}, {"lag_ms", replica.lag.count()}});
+        } else if (!was_healthy && replica.healthy) {
+            LogInfo("Replica serving reads", {{"replica", replica.name}, {"lag_ms", replica.lag.count()}});
+        }
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(state_mutex_);
+        for (size_t i = 0; i < sampled.size(); ++i) {
+            replicas_[i].healthy = sampled[i].healthy;
+            replicas_[i].lag = sampled[i].lag;
+            replicas_[i].replay_lsn = sampled[i].replay_lsn;
+        }
+        if (primary_lsn) {
+            primary_lsn_ = *primary_lsn;
+            primary_sampled_at_ = primary_sampled_at;
+        }
+    }
+
+    // Sessions past the window no longer constrain reads
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(writes_mutex_);
+    for (auto it = writes_.begin(); it != writes_.end();) {
+        it = now - it->second >= sticky_ ? writes_.erase(it) : std::next(it);
+    }
+}
+
+std::vector<ReplicaStatus> ReplicaSet::GetStatus() const {
+    std::shared_lock<std::shared_mutex> lock(state_mutex_);
+    std::vector<ReplicaStatus> status;
+    status.reserve(replicas_.size());
+    for (const auto& replica : replicas_) {
+        status.push_back({replica.name, replica.healthy, replica.lag, replica.replay_lsn});
+    }
+    return status;
+}
+
+uint64_t ReplicaSet::ParseLsn(const std::string& lsn) {
+    auto slash = lsn.find('/');
+    if (slash == std::string::npos || slash == 0 || slash + 1 == lsn.size()) {
+        return 0;
+    }
+    try {
+        size_t hi_end = 0;
+        size_t lo_end = 0;
+        uint64_t hi = std::stoull(lsn.substr(0, slash), &hi_end, 16);
+        uint64_t lo = std::stoull(lsn.substr(slash + 1), &lo_end, 16);
+        if (hi_end != slash || lo_end != lsn.size() - slash - 1 || hi > 0xFFFFFFFFull || lo > 0xFFFFFFFFull) {
+            return 0;
+        }
+        return (hi << 32) | lo;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+ReplicaSample ReplicaSet::ProbeReplica(size_t index) {
+    DbPool* pool = Pool(static_cast<int>(index));
+    if (!pool) {
+        // Connecting prepares every statement: no lock held meanwhile
+        auto created = std::make_unique<DbPool>(urls_[index], [&] {
+            DbPoolOptions options = *replica_options_;
+            options.name = "replica-" + std::to_string(index);
+            return options;
+        }());
+        std::unique_lock<std::shared_mutex> lock(state_mutex_);
+        pools_[index] = std::move(created);
+        pool = pools_[index].get();
+    }
+
+    auto conn_guard = pool->AcquireConnection("ReplicaSet::Check");
+    pqxx::read_transaction txn(*conn_guard);
+    auto result = ExecPrepared(txn, kReplayPosition);
+
+    ReplicaSample sample;
+    std::string lsn;
+    ReadText(result[0]["replay_lsn"], lsn);
+    sample.replay_lsn = ParseLsn(lsn);
+    sample.replay_age = std::chrono::milliseconds(result[0]["replay_age_ms"].as<int64_t>());
+    return sample;
+}
+
+void ReplicaSet::Monitor() {
+    try {
+        Check();
+    } catch (const std::exception& e) {
+        LogError("Replica check failed", {{"error", e.what()}});
+    }
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,359 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Resolve-then-check DNS cache implementation
+ */
+
+#include "common/dns_cache.h"
+#include "common/env.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+std::string ToLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+// Lookup key: lowercase, IPv6 literals without brackets
+std::string NormalizeHost(const std::string& host) {
+    std::string normalized = ToLower(host);
+    if (normalized.size() >= 2 && normalized.front() == '[' && normalized.back() == ']') {
+        normalized = normalized.substr(1, normalized.size() - 2);
+    }
+    return normalized;
+}
+
+struct Ipv4Range {
+    uint32_t base;
+    int prefix;
+};
+
+// Non-public IPv4 ranges (IANA special-purpose registry)
+constexpr std::array<Ipv4Range, 15> kBlockedIpv4 = {{
+    {0x00000000, 8},   // 0.0.0.0/8 "this network"
+    {0x0A000000, 8},   // 10.0.0.0/8 private
+    {0x64400000, 10},  // 100.64.0.0/10 CGNAT
+    {0x7F000000, 8},   // 127.0.0.0/8 loopback
+    {0xA9FE0000, 16},  // 169.254.0.0/16 link-local (cloud metadata)
+    {0xAC100000, 12},  // 172.16.0.0/12 private
+    {0xC0000000, 24},  // 192.0.0.0/24 IETF protocol assignments
+    {0xC0000200, 24},  // 192.0.2.0/24 TEST-NET-1
+    {0xC0586300, 24},  // 192.88.99.0/24 6to4 relay anycast
+    {0xC0A80000, 16},  // 192.168.0.0/16 private
+    {0xC6120000, 15},  // 198.18.0.0/15 benchmarking
+    {0xC6336400, 24},  // 198.51.100.0/24 TEST-NET-2
+    {0xCB007100, 24},  // 203.0.113.0/24 TEST-NET-3
+    {0xE0000000, 4},   // 224.0.0.0/4 multicast
+    {0xF0000000, 4},   // 240.0.0.0/4 reserved + broadcast
+}};
+
+bool IsPublicIpv4(uint32_t address) {
+    for (const auto& range : kBlockedIpv4) {
+        uint32_t mask = range.prefix == 0 ? 0 : ~uint32_t{0} << (32 - range.prefix);
+        if ((address & mask) == range.base) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t Ipv4At(const unsigned char* bytes) {
+    return (uint32_t{bytes[0]} << 24) | (uint32_t{bytes[1]} << 16) | (uint32_t{bytes[2]} << 8) | bytes[3];
+}
+
+bool IsPublicIpv6(const unsigned char* b) {
+    static const unsigned char kZero[12] = {0};
+    static const unsigned char kMapped[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    static const unsigned char kNat64[12] = {0x00, 0x64, 0xff, 0x9b, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    // ::/96 (incl. :: and ::1), ::ffff:0:0/96 and 64:ff9b::/96 embed IPv4
+    if (std::memcmp(b, kZero, 12) == 0) {
+        uint32_t v4 = Ipv4At(b + 12);
+        return v4 > 1 && IsPublicIpv4(v4);
+    }
+    if (std::memcmp(b, kMapped, 12) == 0 || std::memcmp(b, kNat64, 12) == 0) {
+        return IsPublicIpv4(Ipv4At(b + 12));
+    }
+    if ((b[0] & 0xfe) == 0xfc) {
+        return false;  // fc00::/7 unique local
+    }
+    if (b[0] == 0xfe && (b[1] & 0x80) == 0x80) {
+        return false;  // fe80::/10 link-local, fec0::/10 site-local
+    }
+    if (b[0] == 0xff) {
+        return false;  // ff00::/8 multicast
+    }
+    if (b[0] == 0x20 && b[1] == 0x01 && b[2] == 0x0d && b[3] == 0xb8) {
+        return false;  // 2001:db8::/32 documentation
+    }
+    if (b[0] == 0x20 && b[1] == 0x01 && b[2] == 0x00 && b[3] == 0x00) {
+        return false;  // 2001::/32 Teredo (tunnels to arbitrary IPv4)
+    }
+    if (b[0] == 0x20 && b[1] == 0x02) {
+        return IsPublicIpv4(Ipv4At(b + 2));  // 2002::/16 6to4
+    }
+    return true;
+}
+
+} // namespace
+
+DnsCacheOptions DnsCacheOptions::FromEnv() {
+    DnsCacheOptions options;
+    options.positive_ttl = std::chrono::seconds(
+        EnvInt("DNS_CACHE_POSITIVE_TTL_S", static_cast<long>(options.positive_ttl.count())));
+    options.negative_ttl = std::chrono::seconds(
+        EnvInt("DNS_CACHE_NEGATIVE_TTL_S", static_cast<long>(options.negative_ttl.count())));
+    options.max_entries = static_cast<size_t>(
+        EnvInt("DNS_CACHE_MAX_ENTRIES", static_cast<long>(options.max_entries)));
+    options.resolver_threads = static_cast<size_t>(
+        EnvInt("DNS_RESOLVER_THREADS", static_cast<long>(options.resolver_threads)));
+    options.resolve_timeout = std::chrono::milliseconds(
+        EnvInt("DNS_RESOLVE_TIMEOUT_MS", static_cast<long>(options.resolve_timeout.count())));
+    return options;
+}
+
+DnsCache::DnsCache(const DnsCacheOptions& options)
+    : options_(options),
+      executor_(std::max<size_t>(options.resolver_threads, 1), std::max<size_t>(options.max_entries, 1)) {
+    options_.max_entries = std::max<size_t>(options_.max_entries, 1);
+}
+
+DnsCache::~DnsCache() {
+    executor_.Shutdown();
+}
+
+DnsResult DnsCache::Resolve(const std::string& host) {
+    bool hit = false;
+    auto future = Lookup(NormalizeHost(host), &hit);
+    (hit ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+
+    if (future.wait_for(options_.resolve_timeout) != std::future_status::ready) {
+        DnsResult result;
+        result.error = "DNS resolution timed out for " + host;
+        return result;
+    }
+    return future.get();
+}
+
+std::optional<DnsResult> DnsCache::TryGet(const std::string& host) {
+    bool hit = false;
+    auto future = Lookup(NormalizeHost(host), &hit);
+    (hit ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+
+    if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return std::nullopt;
+    }
+    return future.get();
+}
+
+size_t DnsCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::shared_future<DnsResult> DnsCache::Lookup(const std::string& host, bool* hit) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // In-flight entries never expire, so concurrent callers share one lookup
+    auto it = entries_.find(host);
+    if (it != entries_.end() && it->second.expires_at > now) {
+        *hit = true;
+        return it->second.result;
+    }
+    *hit = false;
+    if (it != entries_.end()) {
+        entries_.erase(it);
+    }
+    if (entries_.size() >= options_.max_entries) {
+        EvictLocked(now);
+    }
+
+    auto promise = std::make_shared<std::promise<DnsResult>>();
+    std::shared_future<DnsResult> future = promise->get_future().share();
+    uint64_t id = ++next_id_;
+    entries_[host] = Entry{id, future};
+
+    bool submitted = executor_.TrySubmit([this, host, id, promise] {
+        DnsResult result = ResolveNow(host);
+        auto ttl = result.status == DnsStatus::OK ? options_.positive_ttl : options_.negative_ttl;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto entry = entries_.find(host);
+            if (entry != entries_.end() && entry->second.id == id) {
+                entry->second.expires_at = std::chrono::steady_clock::now() + ttl;
+            }
+        }
+        promise->set_value(std::move(result));
+    });
+
+    if (!submitted) {
+        // Not cached: the next caller retries once the resolver has capacity
+        entries_.erase(host);
+        DnsResult result;
+        result.error = "DNS resolver overloaded";
+        promise->set_value(std::move(result));
+    }
+    return future;
+}
+
+void DnsCache::EvictLocked(std::chrono::steady_clock::time_point now) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = it->second.expires_at <= now ? entries_.erase(it) : std::next(it);
+    }
+    // Still full of live entries: drop any completed one (in-flight ones have waiters)
+    if (entries_.size() >= options_.max_entries) {
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second.expires_at != std::chrono::steady_clock::time_point::max()) {
+                entries_.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+DnsResult DnsCache::ResolveNow(const std::string& host) {
+    DnsResult result;
+    if (host.empty()) {
+        result.error = "Empty host";
+        return result;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* info = nullptr;
+    int rc = getaddrinfo(host.c_str(), nullptr, &hints, &info);
+    if (rc != 0) {
+        result.error = "DNS lookup failed for " + host + ": " + gai_strerror(rc);
+        return result;
+    }
+
+    std::vector<std::string> addresses;
+    for (addrinfo* ai = info; ai; ai = ai->ai_next) {
+        char buffer[INET6_ADDRSTRLEN] = {0};
+        const void* src = nullptr;
+        if (ai->ai_family == AF_INET) {
+            src = &reinterpret_cast<sockaddr_in*>(ai->ai_addr)->sin_addr;
+        } else if (ai->ai_family == AF_INET6) {
+            src = &reinterpret_cast<sockaddr_in6*>(ai->ai_addr)->sin6_addr;
+        } else {
+            continue;
+        }
+        if (inet_ntop(ai->ai_family, src, buffer, sizeof(buffer)) &&
+            std::find(addresses.begin(), addresses.end(), buffer) == addresses.end()) {
+            addresses.emplace_back(buffer);
+        }
+    }
+    freeaddrinfo(info);
+
+    if (addresses.empty()) {
+        result.error = "No addresses for " + host;
+        return result;
+    }
+
+    // One private answer blocks the name: the client could pick any of them
+    for (const auto& address : addresses) {
+        if (!IsPublicAddress(address)) {
+            result.status = DnsStatus::BLOCKED;
+            result.error = host + " resolves to non-public address " + address;
+            return result;
+        }
+    }
+
+    result.status = DnsStatus::OK;
+    result.addresses = std::move(addresses);
+    return result;
+}
+
+bool DnsCache::IsPublicAddress(const std::string& address) {
+    std::string normalized = NormalizeHost(address);
+
+    in_addr v4{};
+    if (inet_pton(AF_INET, normalized.c_str(), &v4) == 1) {
+        return IsPublicIpv4(ntohl(v4.s_addr));
+    }
+
+    in6_addr v6{};
+    if (inet_pton(AF_INET6, normalized.c_str(), &v6) == 1) {
+        return IsPublicIpv6(v6.s6_addr);
+    }
+
+    return false;
+}
+
+std::optional<UrlEndpoint> DnsCache::ParseUrl(const std::string& url) {
+    auto scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) {
+        return std::nullopt;
+    }
+
+    UrlEndpoint endpoint;
+    endpoint.scheme = ToLower(url.substr(0, scheme_end));
+    if (endpoint.scheme != "http" && endpoint.scheme != "https") {
+        return std::nullopt;
+    }
+
+    std::string rest = url.substr(scheme_end + 3);
+    std::string authority = rest.substr(0, rest.find_first_of("/?#"));
+    auto at = authority.rfind('@');
+    if (at != std::string::npos) {
+        authority = authority.substr(at + 1);
+    }
+
+    std::string port;
+    if (!authority.empty() && authority[0] == '[') {
+        auto close = authority.find(']');
+        if (close == std::string::npos) {
+            return std::nullopt;
+        }
+        endpoint.host = authority.substr(1, close - 1);
+        std::string after = authority.substr(close + 1);
+        if (!after.empty()) {
+            if (after[0] != ':') {
+                return std::nullopt;
+            }
+            port = after.substr(1);
+        }
+    } else {
+        auto colon = authority.rfind(':');
+        endpoint.host = authority.substr(0, colon);
+        if (colon != std::string::npos) {
+            port = authority.substr(colon + 1);
+        }
+    }
+
+    if (endpoint.host.empty()) {
+        return std::nullopt;
+    }
+    endpoint.host = ToLower(endpoint.host);
+
+    if (port.empty()) {
+        endpoint.port = endpoint.scheme == "https" ? 443 : 80;
+    } else {
+        if (port.size() > 5 || !std::all_of(port.begin(), port.end(), ::isdigit)) {
+            return std::nullopt;
+        }
+        endpoint.port = std::stoi(port);
+        if (endpoint.port < 1 || endpoint.port > 65535) {
+            return std::nullopt;
+        }
+    }
+    return endpoint;
+}
+
+} // namespace common
+} // namespace saasforge
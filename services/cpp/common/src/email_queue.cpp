@@ -5,16 +5,345 @@
  */
 
 #include "common/email_queue.h"
-#include <iostream>
+#include "common/id_generator.h"
+#include "common/row_mapping.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
 #include <sstream>
+#include <thread>
+#include <utility>
 #include <pqxx/pqxx>
 
 namespace saasforge {
 namespace common {
 
-EmailQueue::EmailQueue(std::shared_ptr<DbPool> db_pool)
-    : db_pool_(db_pool) {
-    std::cout << "EmailQueue initialized" << std::endl;
+namespace {
+
+// Claims read and lock email_queue_active, the hot partition holding only
+// claimable and in-flight rows; terminal rows move to email_queue_done
+// (dropped a day at a time by QueuePartitionMaintainer). The statements
+// spell out lane and status values rather than binding them: Postgres only
+// prunes partitions at plan time, and only uses a partial index, when the
+// predicate is a constant (migrations a6d2f0c4e813, c9e4b1f7a260).
+static_assert(static_cast<int>(EmailLane::TRANSACTIONAL) == 0 && static_cast<int>(EmailLane::BULK) == 1,
+              "lane literals in the email_queue statements");
+static_assert(static_cast<int>(EmailStatus::PENDING) == 0 && static_cast<int>(EmailStatus::SENDING) == 1 &&
+              static_cast<int>(EmailStatus::FAILED) == 3 && static_cast<int>(EmailStatus::RETRY) == 4,
+              "status literals in the email_queue statements (and email_queue_active's partition bound)");
+
+// Columns of a returned email, in QueuedEmail's terms. Blob-stored bodies
+// come back still encoded (payload_blobs primary key).
+constexpr auto kEmailRow = MapRow(
+    Column<&QueuedEmail::id>("id"),
+    Column<&QueuedEmail::tenant_id>("tenant_id"),
+    Column<&QueuedEmail::user_id>("user_id"),
+    Column<&QueuedEmail::to_address>("to_address"),
+    Column<&QueuedEmail::subject>("subject"),
+    Column<&QueuedEmail::body_html>("body_html"),
+    Column<&QueuedEmail::body_text>("body_text"),
+    Column<&QueuedEmail::body_html_data>(
+        "(SELECT b.data FROM payload_blobs b WHERE b.hash = body_html_hash) AS body_html_data"),
+    Column<&QueuedEmail::body_text_data>(
+        "(SELECT b.data FROM payload_blobs b WHERE b.hash = body_text_hash) AS body_text_data"),
+    Column<&QueuedEmail::template_id>("template_id"),
+    Column<&QueuedEmail::status>("status"),
+    Column<&QueuedEmail::lane>("lane"),
+    Column<&QueuedEmail::retry_count>("retry_count"),
+    Column<&QueuedEmail::created_at>("EXTRACT(EPOCH FROM created_at)::bigint AS created_at"),
+    Column<&QueuedEmail::scheduled_at>("EXTRACT(EPOCH FROM scheduled_at)::bigint AS scheduled_at"),
+    Column<&QueuedEmail::sent_at>("EXTRACT(EPOCH FROM sent_at)::bigint AS sent_at"),
+    Column<&QueuedEmail::bounce_type>("bounce_type"),
+    Column<&QueuedEmail::error_message>("error_message"));
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+// pg_notify is delivered on commit, waking QueueNotifier listeners. Large
+// bodies go to payload_blobs ($13/$14, see PayloadCodec): the row keeps ''
+// and their hashes ($11/$12, '' when inline). The id ($16) comes from
+// IdGenerator, so new rows append to the primary key index.
+const PreparedStatement kEnqueue(
+    "email_queue_enqueue",
+    "WITH " PAYLOAD_BLOBS_CTE("$13", "$14") ", inserted AS ("
+    "  INSERT INTO email_queue "
+    "  (id, tenant_id, user_id, to_address, subject, body_html, body_text, body_html_hash, body_text_hash, "
+    "  template_id, status, retry_count, priority, created_at, scheduled_at, lane) "
+    "  VALUES ($16, $1, $2, $3, $4, $5, $6, NULLIF($11, '')::bytea, NULLIF($12, '')::bytea, "
+    "  NULLIF($7, ''), $8, 0, $9, NOW(), NOW(), $10) "
+    "  RETURNING id"
+    ") "
+    "SELECT id, pg_notify($15, id::text) FROM inserted");
+
+const PreparedStatement kReleaseBatch(
+    "email_queue_release_batch",
+    "UPDATE email_queue_active SET status = CASE WHEN retry_count = 0 THEN $1 ELSE $2 END "
+    "WHERE id = ANY($3::uuid[]) AND status = 1");
+
+const PreparedStatement kNextDue(
+    "email_queue_next_due",
+    "SELECT (EXTRACT(EPOCH FROM (MIN(scheduled_at) - NOW())) * 1000)::bigint AS due_in_ms "
+    "FROM email_queue_active WHERE status IN (0, 4)");
+
+const PreparedStatement kNextDueTransactional(
+    "email_queue_next_due_transactional",
+    "SELECT (EXTRACT(EPOCH FROM (MIN(scheduled_at) - NOW())) * 1000)::bigint AS due_in_ms "
+    "FROM email_queue_active WHERE lane = 0 AND status IN (0, 4)");
+
+// idx_email_queue_transactional
+constexpr auto kClaimTransactionalSql =
+    SqlText("UPDATE email_queue_active SET status = $1 "
+            "WHERE id IN ("
+            "  SELECT id FROM email_queue_active "
+            "  WHERE lane = 0 AND status IN (0, 4) "
+            "  AND scheduled_at <= NOW() "
+            "  ORDER BY priority DESC, scheduled_at ASC "
+            "  LIMIT $2 "
+            "  FOR UPDATE SKIP LOCKED"
+            ") "
+            "RETURNING ") + kEmailRow.SelectList();
+const PreparedStatement kClaimTransactional("email_queue_claim_transactional", kClaimTransactionalSql.c_str());
+
+// Distinct tenants with due bulk rows in ($1, $2], by skip scan over
+// idx_email_queue_bulk: one index probe per tenant, however many rows each has
+const PreparedStatement kBulkTenants(
+    "email_queue_bulk_tenants",
+    "WITH RECURSIVE tenants AS ("
+    "  (SELECT tenant_id FROM email_queue_active "
+    "   WHERE lane = 1 AND status IN (0, 4) AND tenant_id > $1::uuid AND tenant_id <= $2::uuid "
+    "   AND scheduled_at <= NOW() "
+    "   ORDER BY tenant_id LIMIT 1) "
+    "  UNION ALL "
+    "  SELECT (SELECT e.tenant_id FROM email_queue_active e "
+    "          WHERE e.lane = 1 AND e.status IN (0, 4) AND e.tenant_id > t.tenant_id AND e.tenant_id <= $2::uuid "
+    "          AND e.scheduled_at <= NOW() "
+    "          ORDER BY e.tenant_id LIMIT 1) "
+    "  FROM tenants t WHERE t.tenant_id IS NOT NULL"
+    ") "
+    "SELECT tenant_id FROM tenants WHERE tenant_id IS NOT NULL LIMIT $3");
+
+// Each tenant's oldest due bulk rows, up to its quota from the scheduler
+constexpr auto kClaimBulkSql =
+    SqlText("UPDATE email_queue_active SET status = $1 "
+            "WHERE id IN ("
+            "  SELECT claimable.id FROM unnest($2::uuid[], $3::int[]) AS quota(tenant_id, amount) "
+            "  CROSS JOIN LATERAL ("
+            "    SELECT id FROM email_queue_active "
+            "    WHERE lane = 1 AND status IN (0, 4) AND tenant_id = quota.tenant_id "
+            "    AND scheduled_at <= NOW() "
+            "    ORDER BY scheduled_at ASC "
+            "    LIMIT quota.amount "
+            "    FOR UPDATE SKIP LOCKED"
+            "  ) claimable"
+            ") "
+            "RETURNING ") + kEmailRow.SelectList();
+const PreparedStatement kClaimBulk("email_queue_claim_bulk", kClaimBulkSql.c_str());
+
+// Delivery outcomes are counted per tenant per minute in email_delivery_stats,
+// in the statement that records them. The table is a ring of
+// BOUNCE_WINDOW_SLOTS minutes per tenant (migration e2a7c5d9b314): a slot
+// still holding an older minute is reset before it is added to, so the
+// table never needs pruning and reads see at most that many rows a tenant.
+static_assert(EmailQueue::MAX_BOUNCE_WINDOW_HOURS * 60 == 2880, "slot count in the delivery stats statements");
+
+#define DELIVERY_STATS_BUCKET \
+    "(EXTRACT(EPOCH FROM date_trunc('minute', NOW()))::bigint / 60 % 2880)::int, date_trunc('minute', NOW())"
+
+#define DELIVERY_STATS_ON_CONFLICT \
+    "ON CONFLICT (tenant_id, slot) DO UPDATE SET " \
+    "sent = CASE WHEN s.bucket_start = EXCLUDED.bucket_start THEN s.sent ELSE 0 END + EXCLUDED.sent, " \
+    "soft_bounced = CASE WHEN s.bucket_start = EXCLUDED.bucket_start THEN s.soft_bounced ELSE 0 END " \
+    "  + EXCLUDED.soft_bounced, " \
+    "hard_bounced = CASE WHEN s.bucket_start = EXCLUDED.bucket_start THEN s.hard_bounced ELSE 0 END " \
+    "  + EXCLUDED.hard_bounced, " \
+    "finished = CASE WHEN s.bucket_start = EXCLUDED.bucket_start THEN s.finished ELSE 0 END + EXCLUDED.finished, " \
+    "bucket_start = EXCLUDED.bucket_start"
+
+// The active-status predicate confines the lookup to email_queue_active;
+// the new status moves each row into its day of email_queue_done
+const PreparedStatement kMarkSentBatch(
+    "email_queue_mark_sent_batch",
+    "WITH sent AS ("
+    "  UPDATE email_queue SET status = $1, sent_at = NOW() "
+    "  WHERE id = ANY($2::uuid[]) AND status IN (0, 1, 3, 4) "
+    "  RETURNING tenant_id"
+    "), counted AS ("
+    "  INSERT INTO email_delivery_stats AS s "
+    "  (tenant_id, slot, bucket_start, sent, soft_bounced, hard_bounced, finished) "
+    "  SELECT tenant_id, " DELIVERY_STATS_BUCKET ", COUNT(*), 0, 0, COUNT(*) "
+    "  FROM sent GROUP BY tenant_id "
+    "  " DELIVERY_STATS_ON_CONFLICT " "
+    "  RETURNING 1"
+    ") "
+    "SELECT COUNT(*) AS updated FROM sent");
+
+// One round trip per batch: the new state and retry delay are computed from
+// each row's current retry_count, and hard bounces are suppressed in a CTE.
+// $9 holds the delay (seconds) for retry 1..MAX_RETRIES. Retries the caller
+// holds in memory ($10) are scheduled $11 seconds later. One row per
+// suppressed address (a single row with a NULL address if none), each
+// carrying the updated count.
+const PreparedStatement kMarkFailedBatch(
+    "email_queue_mark_failed_batch",
+    "WITH input AS ("
+    "  SELECT * FROM unnest($1::uuid[], $2::text[], $3::boolean[], $10::boolean[]) "
+    "  AS t(id, error_message, hard_bounce, held)"
+    "), updated AS ("
+    "  UPDATE email_queue q SET "
+    "    status = CASE WHEN i.hard_bounce THEN $4 WHEN q.retry_count < $5 THEN $6 ELSE $7 END, "
+    "    bounce_type = CASE WHEN i.hard_bounce THEN $8 ELSE q.bounce_type END, "
+    "    retry_count = CASE WHEN NOT i.hard_bounce AND q.retry_count < $5 "
+    "      THEN q.retry_count + 1 ELSE q.retry_count END, "
+    "    scheduled_at = CASE WHEN NOT i.hard_bounce AND q.retry_count < $5 "
+    "      THEN NOW() + make_interval(secs => ($9::int[])[q.retry_count + 1] "
+    "        + CASE WHEN i.held THEN $11::int ELSE 0 END) ELSE q.scheduled_at END, "
+    "    error_message = i.error_message "
+    "  FROM input i WHERE q.id = i.id AND q.status IN (0, 1, 3, 4) "
+    "  RETURNING q.tenant_id, q.to_address, q.status, i.hard_bounce, i.error_message"
+    "), counted AS ("
+    "  INSERT INTO email_delivery_stats AS s "
+    "  (tenant_id, slot, bucket_start, sent, soft_bounced, hard_bounced, finished) "
+    "  SELECT tenant_id, " DELIVERY_STATS_BUCKET ", 0, 0, "
+    "  COUNT(*) FILTER (WHERE hard_bounce), COUNT(*) FILTER (WHERE status IN ($4, $7)) "
+    "  FROM updated GROUP BY tenant_id HAVING bool_or(status IN ($4, $7)) "
+    "  " DELIVERY_STATS_ON_CONFLICT " "
+    "  RETURNING 1"
+    "), suppressed AS ("
+    "  INSERT INTO email_suppression (email_address, reason, created_at) "
+    "  SELECT DISTINCT ON (to_address) to_address, error_message, NOW() "
+    "  FROM updated WHERE hard_bounce "
+    "  ON CONFLICT (email_address) DO UPDATE SET reason = EXCLUDED.reason, created_at = NOW() "
+    "  RETURNING email_address"
+    ") "
+    "SELECT (SELECT COUNT(*) FROM updated) AS updated, s.email_address "
+    "FROM (SELECT 1) one LEFT JOIN suppressed s ON TRUE");
+
+// Held retries (see EmailWorker): re-claimed by primary key when due, and
+// only while still the retry this process recorded
+const PreparedStatement kReclaimHeldBatch(
+    "email_queue_reclaim_held_batch",
+    "UPDATE email_queue_active q SET status = $3 "
+    "FROM unnest($1::uuid[], $2::int[]) AS t(id, retry_count) "
+    "WHERE q.id = t.id AND q.status = 4 AND q.retry_count = t.retry_count "
+    "RETURNING q.id");
+
+const PreparedStatement kReleaseHeldBatch(
+    "email_queue_release_held_batch",
+    "UPDATE email_queue_active q SET scheduled_at = q.scheduled_at - make_interval(secs => $3) "
+    "FROM unnest($1::uuid[], $2::int[]) AS t(id, retry_count) "
+    "WHERE q.id = t.id AND q.status = 4 AND q.retry_count = t.retry_count");
+
+const PreparedStatement kMarkBounced(
+    "email_queue_mark_bounced",
+    "UPDATE email_queue SET status = $1, bounce_type = $2, error_message = $3 "
+    "WHERE id = $4");
+
+// Run before kMarkBounced, while the row still has its previous status: a
+// bounce reported after the send finished counts as a bounce but not as a
+// second outcome, and a repeated hard bounce is not counted again.
+// $2/$3 are 1 for a soft/hard bounce.
+const PreparedStatement kCountBounce(
+    "email_queue_count_bounce",
+    "INSERT INTO email_delivery_stats AS s "
+    "(tenant_id, slot, bucket_start, sent, soft_bounced, hard_bounced, finished) "
+    "SELECT tenant_id, " DELIVERY_STATS_BUCKET ", 0, $2::int, "
+    "CASE WHEN status <> 6 THEN $3::int ELSE 0 END, "
+    "CASE WHEN $3::int = 1 AND status NOT IN (2, 5, 6) THEN 1 ELSE 0 END "
+    "FROM email_queue WHERE id = $1 "
+    DELIVERY_STATS_ON_CONFLICT);
+
+#undef DELIVERY_STATS_BUCKET
+#undef DELIVERY_STATS_ON_CONFLICT
+
+const PreparedStatement kSelectAddress(
+    "email_queue_select_address",
+    "SELECT to_address FROM email_queue WHERE id = $1");
+
+const PreparedStatement kMarkSoftBounce(
+    "email_queue_mark_soft_bounce",
+    "UPDATE email_queue SET bounce_type = $1, error_message = $2 WHERE id = $3");
+
+// Other replicas' filters learn of the address from SuppressionFilter::Add()
+const PreparedStatement kSuppress(
+    "email_queue_suppress",
+    "INSERT INTO email_suppression (email_address, reason, created_at) "
+    "VALUES ($1, $2, NOW()) "
+    "ON CONFLICT (email_address) DO UPDATE SET reason = $2, created_at = NOW()");
+
+const PreparedStatement kCheckSuppressed(
+    "email_queue_check_suppressed",
+    "SELECT 1 FROM email_suppression WHERE email_address = $1");
+
+const PreparedStatement kListSuppressed(
+    "email_queue_list_suppressed",
+    "SELECT email_address FROM email_suppression");
+
+constexpr auto kSelectEmailSql =
+    SqlText("SELECT ") + kEmailRow.SelectList() + " FROM email_queue WHERE id = $1";
+const PreparedStatement kSelectEmail("email_queue_select_email", kSelectEmailSql.c_str());
+
+// Windows are whole minutes ending with the current one
+const PreparedStatement kBounceRate(
+    "email_queue_bounce_rate",
+    "SELECT COALESCE(SUM(hard_bounced), 0) AS bounced, COALESCE(SUM(finished), 0) AS total "
+    "FROM email_delivery_stats "
+    "WHERE bucket_start > date_trunc('minute', NOW()) - make_interval(hours => $1)");
+
+const PreparedStatement kTenantBounceRate(
+    "email_queue_tenant_bounce_rate",
+    "SELECT COALESCE(SUM(hard_bounced), 0) AS bounced, COALESCE(SUM(finished), 0) AS total "
+    "FROM email_delivery_stats "
+    "WHERE tenant_id = $2 "
+    "AND bucket_start > date_trunc('minute', NOW()) - make_interval(hours => $1)");
+
+const PreparedStatement kTenantBounceRates(
+    "email_queue_tenant_bounce_rates",
+    "SELECT tenant_id, SUM(sent) AS sent, SUM(soft_bounced) AS soft_bounced, "
+    "SUM(hard_bounced) AS hard_bounced, SUM(finished) AS finished "
+    "FROM email_delivery_stats "
+    "WHERE bucket_start > date_trunc('minute', NOW()) - make_interval(hours => $1) "
+    "GROUP BY tenant_id HAVING SUM(finished) >= $2");
+
+constexpr std::chrono::milliseconds MIN_POLL_INTERVAL{10};
+constexpr std::chrono::milliseconds POLL_INTERVAL_WITHOUT_NOTIFY{1000};
+
+constexpr const char* MIN_UUID = "00000000-0000-0000-0000-000000000000";
+constexpr const char* MAX_UUID = "ffffffff-ffff-ffff-ffff-ffffffffffff";
+
+// (ids, retry counts) of held emails, for the *HeldBatch statements
+std::pair<std::string, std::string> HeldArrays(const std::vector<QueuedEmail>& held) {
+    std::vector<std::string> ids;
+    std::vector<std::string> retry_counts;
+    ids.reserve(held.size());
+    retry_counts.reserve(held.size());
+    for (const auto& email : held) {
+        ids.push_back(email.id);
+        retry_counts.push_back(std::to_string(email.retry_count));
+    }
+    return {ToArrayLiteral(ids), ToArrayLiteral(retry_counts)};
+}
+
+} // namespace
+
+EmailQueueOptions EmailQueueOptions::FromEnv() {
+    EmailQueueOptions options;
+    options.fairness = TenantFairSchedulerOptions::FromEnv();
+    options.max_tenants = static_cast<int>(
+        std::max(1L, EnvInt("EMAIL_QUEUE_MAX_TENANTS", options.max_tenants)));
+    options.tenant_refresh = std::chrono::milliseconds(
+        EnvInt("EMAIL_QUEUE_TENANT_REFRESH_MS", static_cast<long>(options.tenant_refresh.count())));
+    return options;
+}
+
+EmailQueue::EmailQueue(std::shared_ptr<DbPool> db_pool, std::shared_ptr<QueueNotifier> notifier,
+                       const EmailQueueOptions& options, std::shared_ptr<SuppressionFilter> suppressions)
+    : db_pool_(db_pool), notifier_(notifier), suppressions_(suppressions), options_(options),
+      scheduler_(options.fairness), payloads_(db_pool, PayloadCodecOptions::FromEnv()) {
+    LogInfo("EmailQueue initialized", {
+        {"tenant_quantum", options_.fairness.quantum},
+        {"tenant_rate_per_s", options_.fairness.rate_per_second}
+    });
 }
 
 std::string EmailQueue::Enqueue(
@@ -25,205 +354,328 @@ std::string EmailQueue::Enqueue(
     const std::string& body_html,
     const std::string& body_text,
     const std::string& template_id,
-    int priority
+    int priority,
+    EmailLane lane
 ) {
     // Check if address is suppressed (hard bounce)
     if (IsAddressSuppressed(to_address)) {
         throw std::runtime_error("Email address is suppressed due to hard bounce");
     }
 
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    pqxx::result result;
-    if (template_id.empty()) {
-        result = txn.exec_params(
-            "INSERT INTO email_queue "
-            "(tenant_id, user_id, to_address, subject, body_html, body_text, template_id, "
-            "status, retry_count, priority, created_at, scheduled_at) "
-            "VALUES ($1, $2, $3, $4, $5, $6, NULL, $7, 0, $8, NOW(), NOW()) "
-            "RETURNING id",
-            tenant_id,
-            user_id,
-            to_address,
-            subject,
-            body_html,
-            body_text,
-            static_cast<int>(EmailStatus::PENDING),
-            priority
-        );
-    } else {
-        result = txn.exec_params(
-            "INSERT INTO email_queue "
-            "(tenant_id, user_id, to_address, subject, body_html, body_text, template_id, "
-            "status, retry_count, priority, created_at, scheduled_at) "
-            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, 0, $9, NOW(), NOW()) "
-            "RETURNING id",
-            tenant_id,
-            user_id,
-            to_address,
-            subject,
-            body_html,
-            body_text,
-            template_id,
-            static_cast<int>(EmailStatus::PENDING),
-            priority
-        );
-    }
+    // One dictionary scope per template: its renders share most of their markup
+    std::string scope = template_id.empty() ? "email" : "email:" + template_id;
+    auto html = payloads_.Store(body_html, scope);
+    auto text = payloads_.Store(body_text, scope);
+    PayloadBlobs blobs;
+    blobs.Add(html);
+    blobs.Add(text);
+
+    auto result = ExecPrepared(
+        txn, kEnqueue,
+        tenant_id,
+        user_id,
+        to_address,
+        subject,
+        html.text,
+        text.text,
+        template_id,
+        static_cast<int>(EmailStatus::PENDING),
+        priority,
+        static_cast<int>(lane),
+        html.hash,
+        text.hash,
+        blobs.Hashes(),
+        blobs.Data(),
+        NOTIFY_CHANNEL,
+        IdGenerator::NewUuid()
+    );
 
     std::string email_id = result[0]["id"].c_str();
     txn.commit();
 
-    std::cout << "Email queued: " << email_id << " to " << to_address << std::endl;
+    LogDebug("Email queued", {{"email_id", email_id}, {"to", to_address}});
 
     return email_id;
 }
 
-std::vector<QueuedEmail> EmailQueue::GetNextBatch(int batch_size) {
-    auto conn_guard = db_pool_->AcquireConnection();
+EmailBatch EmailQueue::ClaimBatch(int batch_size) {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    // Get emails that are:
-    // 1. PENDING or RETRY status
-    // 2. scheduled_at <= NOW()
-    // 3. Ordered by priority DESC, scheduled_at ASC
-    // 4. Lock for processing (FOR UPDATE SKIP LOCKED)
-    auto result = txn.exec_params(
-        "UPDATE email_queue SET status = $1 "
-        "WHERE id IN ("
-        "  SELECT id FROM email_queue "
-        "  WHERE (status = $2 OR status = $3) "
-        "  AND scheduled_at <= NOW() "
-        "  ORDER BY priority DESC, scheduled_at ASC "
-        "  LIMIT $4 "
-        "  FOR UPDATE SKIP LOCKED"
-        ") "
-        "RETURNING id, tenant_id, user_id, to_address, subject, body_html, body_text, "
-        "template_id, status, retry_count, "
-        "EXTRACT(EPOCH FROM created_at)::bigint as created_at, "
-        "EXTRACT(EPOCH FROM scheduled_at)::bigint as scheduled_at, "
-        "EXTRACT(EPOCH FROM sent_at)::bigint as sent_at, "
-        "bounce_type, error_message",
+    // Transactional lane first: PENDING or RETRY, due, by priority DESC,
+    // scheduled_at ASC, locked for processing (FOR UPDATE SKIP LOCKED)
+    auto result = ExecPrepared(
+        txn, kClaimTransactional,
         static_cast<int>(EmailStatus::SENDING),
-        static_cast<int>(EmailStatus::PENDING),
-        static_cast<int>(EmailStatus::RETRY),
         batch_size
     );
 
-    std::vector<QueuedEmail> emails;
-    for (const auto& row : result) {
-        QueuedEmail email;
-        email.id = row["id"].as<std::string>();
-        email.tenant_id = row["tenant_id"].as<std::string>();
-        email.user_id = row["user_id"].as<std::string>();
-        email.to_address = row["to_address"].as<std::string>();
-        email.subject = row["subject"].as<std::string>();
-        email.body_html = row["body_html"].as<std::string>();
-        email.body_text = row["body_text"].is_null() ? "" : row["body_text"].as<std::string>();
-        email.template_id = row["template_id"].is_null() ? "" : row["template_id"].as<std::string>();
-        email.status = static_cast<EmailStatus>(row["status"].as<int>());
-        email.retry_count = row["retry_count"].as<int>();
-        email.created_at = row["created_at"].as<int64_t>();
-        email.scheduled_at = row["scheduled_at"].as<int64_t>();
-        email.sent_at = row["sent_at"].is_null() ? 0 : row["sent_at"].as<int64_t>();
-        email.bounce_type = static_cast<BounceType>(row["bounce_type"].is_null() ? 0 : row["bounce_type"].as<int>());
-        email.error_message = row["error_message"].is_null() ? "" : row["error_message"].as<std::string>();
-
-        emails.push_back(email);
+    EmailBatch emails;
+    kEmailRow.ReadAll(result, emails);
+
+    // Whatever is left is shared among tenants with due bulk mail
+    int remaining = batch_size - static_cast<int>(emails.size());
+    std::chrono::milliseconds throttled_for{0};
+    if (remaining > 0) {
+        auto tenants = BulkTenants(txn);
+        auto allocation = scheduler_.Allocate(tenants, remaining);
+        throttled_for = allocation.throttled_for;
+
+        if (!allocation.quotas.empty()) {
+            std::vector<std::string> tenant_ids;
+            std::vector<std::string> quotas;
+            tenant_ids.reserve(allocation.quotas.size());
+            quotas.reserve(allocation.quotas.size());
+            for (const auto& [tenant_id, quota] : allocation.quotas) {
+                tenant_ids.push_back(tenant_id);
+                quotas.push_back(std::to_string(quota));
+            }
+
+            auto bulk = ExecPrepared(
+                txn, kClaimBulk,
+                static_cast<int>(EmailStatus::SENDING),
+                ToArrayLiteral(tenant_ids),
+                ToArrayLiteral(quotas)
+            );
+
+            size_t first_bulk = emails.size();
+            kEmailRow.ReadAll(bulk, emails);
+            std::map<std::string, int, std::less<>> claimed;
+            for (size_t i = first_bulk; i < emails.size(); ++i) {
+                auto tenant_id = emails.Get<&QueuedEmail::tenant_id>(i);
+                auto it = claimed.find(tenant_id);
+                if (it == claimed.end()) {
+                    it = claimed.emplace(std::string(tenant_id), 0).first;
+                }
+                ++it->second;
+            }
+
+            // A tenant short of its quota ran dry (or its rows are locked by
+            // another worker): hand the credit back and stop asking for it
+            std::lock_guard<std::mutex> lock(tenants_mutex_);
+            for (const auto& [tenant_id, quota] : allocation.quotas) {
+                int got = claimed[tenant_id];
+                if (got < quota) {
+                    scheduler_.Refund(tenant_id, quota - got);
+                    bulk_tenants_.erase(
+                        std::remove(bulk_tenants_.begin(), bulk_tenants_.end(), tenant_id), bulk_tenants_.end());
+                }
+            }
+        }
     }
 
     txn.commit();
 
-    std::cout << "Retrieved " << emails.size() << " emails from queue" << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(tenants_mutex_);
+        throttled_for_ = throttled_for;
+    }
+    {
+        std::lock_guard<std::mutex> lock(claimed_mutex_);
+        for (const auto& email : emails) {
+            claimed_.emplace(email.Get<&QueuedEmail::id>());
+        }
+    }
+
+    LogDebug("Retrieved emails from queue", {{"count", emails.size()}, {"remaining", remaining}});
 
     return emails;
 }
 
+std::vector<QueuedEmail> EmailQueue::GetNextBatch(int batch_size) {
+    return ClaimBatch(batch_size).ToVector();
+}
+
+std::vector<std::string> EmailQueue::BulkTenants(pqxx::work& txn) {
+    std::lock_guard<std::mutex> lock(tenants_mutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (bulk_tenants_read_ != std::chrono::steady_clock::time_point{} &&
+        now - bulk_tenants_read_ < options_.tenant_refresh) {
+        return bulk_tenants_;
+    }
+
+    // Up to max_tenants, continuing after the previous refresh's last tenant
+    // and wrapping around, so every backlogged tenant is eventually seen
+    std::vector<std::string> tenants;
+    auto read = [&](const std::string& after, const std::string& through) {
+        auto result = ExecPrepared(
+            txn, kBulkTenants, after, through,
+            options_.max_tenants - static_cast<int>(tenants.size()));
+        for (const auto& row : result) {
+            ReadText(row[0], tenants.emplace_back());
+        }
+    };
+    std::string cursor = bulk_cursor_.empty() ? MIN_UUID : bulk_cursor_;
+    read(cursor, MAX_UUID);
+    if (static_cast<int>(tenants.size()) < options_.max_tenants && cursor != MIN_UUID) {
+        read(MIN_UUID, cursor);
+    }
+
+    bulk_cursor_ = static_cast<int>(tenants.size()) < options_.max_tenants ? "" : tenants.back();
+    bulk_tenants_ = tenants;
+    bulk_tenants_read_ = now;
+    return tenants;
+}
+
+std::vector<QueuedEmail> EmailQueue::WaitForBatch(int batch_size, std::chrono::milliseconds max_wait) {
+    auto deadline = std::chrono::steady_clock::now() + max_wait;
+
+    while (true) {
+        // Read before polling so a NOTIFY racing with the poll still wakes us
+        uint64_t seen = notifier_ ? notifier_->Generation(NOTIFY_CHANNEL) : 0;
+
+        auto emails = GetNextBatch(batch_size);
+        auto now = std::chrono::steady_clock::now();
+        if (!emails.empty() || now >= deadline) {
+            return emails;
+        }
+
+        std::chrono::milliseconds throttled_for;
+        {
+            std::lock_guard<std::mutex> lock(tenants_mutex_);
+            throttled_for = throttled_for_;
+        }
+
+        // Sleep until the earliest scheduled retry, a NOTIFY, or the deadline.
+        // Bulk rows held back by rate caps are due but not claimable: wait for
+        // the next token instead of spinning on them.
+        auto cap = notifier_ ? notifier_->Options().fallback_poll : POLL_INTERVAL_WITHOUT_NOTIFY;
+        auto next_due = throttled_for.count() > 0
+            ? TimeUntilNextDue(std::min(cap, throttled_for), true)
+            : TimeUntilNextDue(cap);
+        auto wait = std::min(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now), next_due);
+
+        if (notifier_) {
+            notifier_->WaitForChange(NOTIFY_CHANNEL, seen, wait);
+        } else {
+            std::this_thread::sleep_for(wait);
+        }
+    }
+}
+
+std::chrono::milliseconds EmailQueue::TimeUntilNextDue(std::chrono::milliseconds cap, bool transactional_only) {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = transactional_only
+        ? ExecPrepared(txn, kNextDueTransactional)
+        : ExecPrepared(txn, kNextDue);
+    txn.commit();
+
+    if (result.empty() || result[0]["due_in_ms"].is_null()) {
+        return cap;
+    }
+
+    // Due rows still held by another worker: back off briefly instead of spinning
+    auto due = std::chrono::milliseconds(result[0]["due_in_ms"].as<int64_t>());
+    return std::min(cap, std::max(due, MIN_POLL_INTERVAL));
+}
+
 void EmailQueue::MarkSent(const std::string& email_id) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    MarkSentBatch({email_id});
+}
+
+size_t EmailQueue::MarkSentBatch(const std::vector<std::string>& email_ids) {
+    if (email_ids.empty()) {
+        return 0;
+    }
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    txn.exec_params(
-        "UPDATE email_queue SET status = $1, sent_at = NOW() WHERE id = $2",
+    auto result = ExecPrepared(
+        txn, kMarkSentBatch,
         static_cast<int>(EmailStatus::SENT),
-        email_id
+        ToArrayLiteral(email_ids)
     );
 
     txn.commit();
+    Unclaim(email_ids);
 
-    std::cout << "Email marked as sent: " << email_id << std::endl;
+    size_t updated = result[0]["updated"].as<size_t>();
+    LogDebug("Emails marked as sent", {{"count", updated}});
+
+    return updated;
 }
 
 void EmailQueue::MarkFailed(const std::string& email_id, const std::string& error_message, bool is_hard_bounce) {
-    auto conn_guard = db_pool_->AcquireConnection();
-    pqxx::work txn(*conn_guard);
-
-    // Get current retry count
-    auto result = txn.exec_params(
-        "SELECT retry_count, to_address FROM email_queue WHERE id = $1",
-        email_id
-    );
-
-    if (result.empty()) {
+    if (MarkFailedBatch({{email_id, error_message, is_hard_bounce}}) == 0) {
         throw std::runtime_error("Email not found: " + email_id);
     }
+}
 
-    int retry_count = result[0]["retry_count"].as<int>();
-    std::string to_address = result[0]["to_address"].as<std::string>();
+size_t EmailQueue::MarkFailedBatch(const std::vector<EmailFailure>& failures, std::chrono::seconds hold_lease) {
+    if (failures.empty()) {
+        return 0;
+    }
 
-    if (is_hard_bounce) {
-        // Hard bounce - mark as BOUNCED and suppress address
-        txn.exec_params(
-            "UPDATE email_queue SET status = $1, bounce_type = $2, error_message = $3 "
-            "WHERE id = $4",
-            static_cast<int>(EmailStatus::BOUNCED),
-            static_cast<int>(BounceType::HARD),
-            error_message,
-            email_id
-        );
+    std::vector<std::string> ids;
+    std::vector<std::string> errors;
+    std::vector<std::string> hard_bounces;
+    std::vector<std::string> held;
+    ids.reserve(failures.size());
+    errors.reserve(failures.size());
+    hard_bounces.reserve(failures.size());
+    held.reserve(failures.size());
+    for (const auto& failure : failures) {
+        ids.push_back(failure.email_id);
+        errors.push_back(failure.error_message);
+        hard_bounces.push_back(failure.is_hard_bounce ? "t" : "f");
+        held.push_back(failure.held ? "t" : "f");
+    }
 
-        // Suppress the address for future sends
-        SuppressAddress(to_address, error_message);
+    // Backoff schedule indexed by the new retry count (1-based, as in SQL)
+    std::vector<std::string> delays;
+    for (int retry = 1; retry <= MAX_RETRIES; ++retry) {
+        delays.push_back(std::to_string(GetRetryDelay(retry)));
+    }
 
-        std::cout << "Email marked as hard bounced: " << email_id << " (address suppressed)" << std::endl;
-    } else if (ShouldRetry(retry_count, is_hard_bounce)) {
-        // Schedule retry with exponential backoff
-        int new_retry_count = retry_count + 1;
-        int64_t delay_seconds = GetRetryDelay(new_retry_count);
-
-        txn.exec_params(
-            "UPDATE email_queue SET status = $1, retry_count = $2, error_message = $3, "
-            "scheduled_at = NOW() + INTERVAL '$4 seconds' "
-            "WHERE id = $5",
-            static_cast<int>(EmailStatus::RETRY),
-            new_retry_count,
-            error_message,
-            delay_seconds,
-            email_id
-        );
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
 
-        std::cout << "Email scheduled for retry " << new_retry_count << " in " << delay_seconds << "s: " << email_id << std::endl;
-    } else {
-        // Max retries exhausted
-        txn.exec_params(
-            "UPDATE email_queue SET status = $1, error_message = $2 WHERE id = $3",
-            static_cast<int>(EmailStatus::EXHAUSTED),
-            error_message,
-            email_id
-        );
+    auto result = ExecPrepared(
+        txn, kMarkFailedBatch,
+        ToArrayLiteral(ids),
+        ToArrayLiteral(errors),
+        ToArrayLiteral(hard_bounces),
+        static_cast<int>(EmailStatus::BOUNCED),
+        MAX_RETRIES,
+        static_cast<int>(EmailStatus::RETRY),
+        static_cast<int>(EmailStatus::EXHAUSTED),
+        static_cast<int>(BounceType::HARD),
+        ToArrayLiteral(delays),
+        ToArrayLiteral(held),
+        static_cast<int>(hold_lease.count())
+    );
 
-        std::cout << "Email max retries exhausted: " << email_id << std::endl;
+    txn.commit();
+    Unclaim(ids);
+
+    size_t updated = result[0]["updated"].as<size_t>();
+    size_t suppressed = 0;
+    for (const auto& row : result) {
+        if (row["email_address"].is_null()) {
+            continue;
+        }
+        ++suppressed;
+        if (suppressions_) {
+            suppressions_->Add(row["email_address"].as<std::string>());
+        }
     }
+    LogInfo("Email failures recorded", {{"count", updated}, {"suppressed", suppressed}});
 
-    txn.commit();
+    return updated;
 }
 
 void EmailQueue::MarkBounced(const std::string& email_id, BounceType bounce_type, const std::string& error_message) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    auto result = txn.exec_params(
-        "SELECT to_address FROM email_queue WHERE id = $1",
+    auto result = ExecPrepared(
+        txn, kSelectAddress,
         email_id
     );
 
@@ -233,10 +685,17 @@ void EmailQueue::MarkBounced(const std::string& email_id, BounceType bounce_type
 
     std::string to_address = result[0]["to_address"].as<std::string>();
 
+    ExecPrepared(
+        txn, kCountBounce,
+        email_id,
+        bounce_type == BounceType::SOFT ? 1 : 0,
+        bounce_type == BounceType::HARD ? 1 : 0
+    );
+
     if (bounce_type == BounceType::HARD) {
         // Hard bounce - suppress address
-        txn.exec_params(
-            "UPDATE email_queue SET status = $1, bounce_type = $2, error_message = $3 WHERE id = $4",
+        ExecPrepared(
+            txn, kMarkBounced,
             static_cast<int>(EmailStatus::BOUNCED),
             static_cast<int>(BounceType::HARD),
             error_message,
@@ -245,102 +704,223 @@ void EmailQueue::MarkBounced(const std::string& email_id, BounceType bounce_type
 
         SuppressAddress(to_address, error_message);
 
-        std::cout << "Hard bounce recorded and address suppressed: " << to_address << std::endl;
+        LogInfo("Hard bounce recorded and address suppressed", {{"to", to_address}});
     } else {
         // Soft bounce - mark as failed for retry
-        txn.exec_params(
-            "UPDATE email_queue SET bounce_type = $1, error_message = $2 WHERE id = $3",
+        ExecPrepared(
+            txn, kMarkSoftBounce,
             static_cast<int>(BounceType::SOFT),
             error_message,
             email_id
         );
 
-        std::cout << "Soft bounce recorded: " << email_id << std::endl;
+        LogInfo("Soft bounce recorded", {{"email_id", email_id}});
     }
 
     txn.commit();
+    Unclaim({email_id});
 }
 
-double EmailQueue::GetBounceRate(const std::string& tenant_id, int hours) {
-    auto conn_guard = db_pool_->AcquireConnection();
+size_t EmailQueue::ReleaseBatch(const std::vector<std::string>& email_ids) {
+    if (email_ids.empty()) {
+        return 0;
+    }
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    std::string query;
-    if (tenant_id.empty()) {
-        query = "SELECT "
-                "COUNT(*) FILTER (WHERE status = " + std::to_string(static_cast<int>(EmailStatus::BOUNCED)) + ") as bounced, "
-                "COUNT(*) as total "
-                "FROM email_queue "
-                "WHERE created_at >= NOW() - INTERVAL '" + std::to_string(hours) + " hours'";
-    } else {
-        query = "SELECT "
-                "COUNT(*) FILTER (WHERE status = " + std::to_string(static_cast<int>(EmailStatus::BOUNCED)) + ") as bounced, "
-                "COUNT(*) as total "
-                "FROM email_queue "
-                "WHERE tenant_id = '" + txn.esc(tenant_id) + "' "
-                "AND created_at >= NOW() - INTERVAL '" + std::to_string(hours) + " hours'";
+    auto result = ExecPrepared(
+        txn, kReleaseBatch,
+        static_cast<int>(EmailStatus::PENDING),
+        static_cast<int>(EmailStatus::RETRY),
+        ToArrayLiteral(email_ids)
+    );
+
+    txn.commit();
+    Unclaim(email_ids);
+
+    return result.affected_rows();
+}
+
+std::vector<std::string> EmailQueue::ReclaimHeldBatch(const std::vector<QueuedEmail>& held) {
+    if (held.empty()) {
+        return {};
     }
+    auto [ids, retry_counts] = HeldArrays(held);
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = ExecPrepared(
+        txn, kReclaimHeldBatch,
+        ids,
+        retry_counts,
+        static_cast<int>(EmailStatus::SENDING)
+    );
+
+    txn.commit();
 
-    auto result = txn.exec(query);
+    std::vector<std::string> reclaimed;
+    reclaimed.reserve(result.size());
+    for (const auto& row : result) {
+        reclaimed.push_back(row["id"].as<std::string>());
+    }
+    {
+        std::lock_guard<std::mutex> lock(claimed_mutex_);
+        claimed_.insert(reclaimed.begin(), reclaimed.end());
+    }
+    return reclaimed;
+}
+
+size_t EmailQueue::ReleaseHeldBatch(const std::vector<QueuedEmail>& held, std::chrono::seconds hold_lease) {
+    if (held.empty()) {
+        return 0;
+    }
+    auto [ids, retry_counts] = HeldArrays(held);
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = ExecPrepared(
+        txn, kReleaseHeldBatch,
+        ids,
+        retry_counts,
+        static_cast<int>(hold_lease.count())
+    );
+
+    txn.commit();
+
+    return result.affected_rows();
+}
+
+size_t EmailQueue::ReleaseClaimed() {
+    std::vector<std::string> email_ids;
+    {
+        std::lock_guard<std::mutex> lock(claimed_mutex_);
+        email_ids.assign(claimed_.begin(), claimed_.end());
+    }
+
+    size_t released = ReleaseBatch(email_ids);
+    if (!email_ids.empty()) {
+        LogInfo("Released claimed emails", {{"claimed", email_ids.size()}, {"released", released}});
+    }
+    return released;
+}
+
+size_t EmailQueue::ClaimedCount() const {
+    std::lock_guard<std::mutex> lock(claimed_mutex_);
+    return claimed_.size();
+}
+
+void EmailQueue::Unclaim(const std::vector<std::string>& email_ids) {
+    std::lock_guard<std::mutex> lock(claimed_mutex_);
+    for (const auto& email_id : email_ids) {
+        claimed_.erase(email_id);
+    }
+}
+
+double EmailQueue::GetBounceRate(const std::string& tenant_id, int hours) {
+    hours = std::clamp(hours, 1, MAX_BOUNCE_WINDOW_HOURS);
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = tenant_id.empty()
+        ? ExecPrepared(txn, kBounceRate, hours)
+        : ExecPrepared(txn, kTenantBounceRate, hours, tenant_id);
 
     if (result.empty()) {
         return 0.0;
     }
 
     auto row = result[0];
-    int64_t bounced = row["bounced"].as<int64_t>();
-    int64_t total = row["total"].as<int64_t>();
+    return BounceRate(row["bounced"].as<int64_t>(), row["total"].as<int64_t>());
+}
 
-    if (total == 0) {
-        return 0.0;
-    }
+std::vector<TenantBounceRate> EmailQueue::GetBounceRates(int hours, int64_t min_emails) {
+    hours = std::clamp(hours, 1, MAX_BOUNCE_WINDOW_HOURS);
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
 
-    double rate = (static_cast<double>(bounced) / static_cast<double>(total)) * 100.0;
+    auto result = ExecPrepared(txn, kTenantBounceRates, hours, std::max<int64_t>(min_emails, 0));
+
+    std::vector<TenantBounceRate> rates;
+    rates.reserve(result.size());
+    for (const auto& row : result) {
+        auto& rate = rates.emplace_back();
+        ReadText(row["tenant_id"], rate.tenant_id);
+        rate.sent = row["sent"].as<int64_t>();
+        rate.soft_bounced = row["soft_bounced"].as<int64_t>();
+        rate.hard_bounced = row["hard_bounced"].as<int64_t>();
+        rate.finished = row["finished"].as<int64_t>();
+        rate.rate = BounceRate(rate.hard_bounced, rate.finished);
+    }
+    return rates;
+}
 
-    return rate;
+double EmailQueue::BounceRate(int64_t bounced, int64_t total) {
+    if (total <= 0) {
+        return 0.0;
+    }
+    return std::min(100.0, (static_cast<double>(bounced) / static_cast<double>(total)) * 100.0);
 }
 
 void EmailQueue::SuppressAddress(const std::string& email_address, const std::string& reason) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    txn.exec_params(
-        "INSERT INTO email_suppression (email_address, reason, created_at) "
-        "VALUES ($1, $2, NOW()) "
-        "ON CONFLICT (email_address) DO UPDATE SET reason = $2, created_at = NOW()",
+    ExecPrepared(
+        txn, kSuppress,
         email_address,
         reason
     );
 
     txn.commit();
 
-    std::cout << "Email address suppressed: " << email_address << std::endl;
+    if (suppressions_) {
+        suppressions_->Add(email_address);
+    }
+
+    LogInfo("Email address suppressed", {{"to", email_address}});
 }
 
 bool EmailQueue::IsAddressSuppressed(const std::string& email_address) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    if (suppressions_ && !suppressions_->MightBeSuppressed(email_address)) {
+        return false;
+    }
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    auto result = txn.exec_params(
-        "SELECT 1 FROM email_suppression WHERE email_address = $1",
+    auto result = ExecPrepared(
+        txn, kCheckSuppressed,
         email_address
     );
 
     return !result.empty();
 }
 
+std::vector<std::string> EmailQueue::ListSuppressedAddresses() {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::read_transaction txn(*conn_guard);
+
+    auto result = ExecPrepared(txn, kListSuppressed);
+
+    std::vector<std::string> addresses;
+    addresses.reserve(result.size());
+    for (const auto& row : result) {
+        ReadText(row[0], addresses.emplace_back());
+    }
+    return addresses;
+}
+
 std::optional<QueuedEmail> EmailQueue::GetStatus(const std::string& email_id) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    auto result = txn.exec_params(
-        "SELECT id, tenant_id, user_id, to_address, subject, body_html, body_text, "
-        "template_id, status, retry_count, "
-        "EXTRACT(EPOCH FROM created_at)::bigint as created_at, "
-        "EXTRACT(EPOCH FROM scheduled_at)::bigint as scheduled_at, "
-        "EXTRACT(EPOCH FROM sent_at)::bigint as sent_at, "
-        "bounce_type, error_message "
-        "FROM email_queue WHERE id = $1",
+    auto result = ExecPrepared(
+        txn, kSelectEmail,
         email_id
     );
 
@@ -348,27 +928,23 @@ std::optional<QueuedEmail> EmailQueue::GetStatus(const std::string& email_id) {
         return std::nullopt;
     }
 
-    auto row = result[0];
     QueuedEmail email;
-    email.id = row["id"].as<std::string>();
-    email.tenant_id = row["tenant_id"].as<std::string>();
-    email.user_id = row["user_id"].as<std::string>();
-    email.to_address = row["to_address"].as<std::string>();
-    email.subject = row["subject"].as<std::string>();
-    email.body_html = row["body_html"].as<std::string>();
-    email.body_text = row["body_text"].is_null() ? "" : row["body_text"].as<std::string>();
-    email.template_id = row["template_id"].is_null() ? "" : row["template_id"].as<std::string>();
-    email.status = static_cast<EmailStatus>(row["status"].as<int>());
-    email.retry_count = row["retry_count"].as<int>();
-    email.created_at = row["created_at"].as<int64_t>();
-    email.scheduled_at = row["scheduled_at"].as<int64_t>();
-    email.sent_at = row["sent_at"].is_null() ? 0 : row["sent_at"].as<int64_t>();
-    email.bounce_type = static_cast<BounceType>(row["bounce_type"].is_null() ? 0 : row["bounce_type"].as<int>());
-    email.error_message = row["error_message"].is_null() ? "" : row["error_message"].as<std::string>();
-
+    kEmailRow.Read(result[0], email);
+    DecodeBodies(email);
     return email;
 }
 
+void EmailQueue::DecodeBodies(QueuedEmail& email) {
+    if (!email.body_html_data.empty()) {
+        email.body_html = payloads_.DecodeBytea(email.body_html_data);
+        email.body_html_data.clear();
+    }
+    if (!email.body_text_data.empty()) {
+        email.body_text = payloads_.DecodeBytea(email.body_text_data);
+        email.body_text_data.clear();
+    }
+}
+
 int64_t EmailQueue::GetRetryDelay(int retry_count) {
     // Retry schedule (Requirement D-98): 1s, 5s, 30s
     switch (retry_count) {
@@ -416,7 +992,7 @@ bool EmailQueue::ShouldRetry(int retry_count, bool is_hard_bounce) {
     }
 
     // Max 3 retries (Requirement D-98)
-    return retry_count < 3;
+    return retry_count < MAX_RETRIES;
 }
 
 } // namespace common
@@ -0,0 +1,210 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Email template compilation and the per-tenant template cache
+ */
+
+#include "common/email_template.h"
+#include "common/env.h"
+#include "common/statement_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry).
+// A tenant's own template sorts before a system template (tenant_id NULL).
+const PreparedStatement kSelectEmailTemplate(
+    "email_template_select",
+    "SELECT id, subject, body_html, body_text, "
+    "(EXTRACT(EPOCH FROM updated_at) * 1000000)::bigint AS version "
+    "FROM email_templates "
+    "WHERE (id::text = $2 OR slug = $2) AND (tenant_id = $1 OR tenant_id IS NULL) "
+    "ORDER BY tenant_id NULLS LAST LIMIT 1");
+
+std::string_view Trim(std::string_view value) {
+    size_t begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+CompiledTemplate CompiledTemplate::Compile(std::string source, bool html) {
+    CompiledTemplate compiled;
+    compiled.source_ = std::move(source);
+    std::string_view text(compiled.source_);
+
+    auto add_literal = [&compiled](size_t begin, size_t end) {
+        if (end > begin) {
+            compiled.segments_.push_back({static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin), -1, false});
+        }
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t open = text.find("{{", pos);
+        if (open == std::string_view::npos) {
+            break;
+        }
+        bool triple = text.compare(open, 3, "{{{") == 0;
+        std::string_view close_tag = triple ? "}}}" : "}}";
+        size_t name_begin = open + (triple ? 3 : 2);
+        size_t close = text.find(close_tag, name_begin);
+        if (close == std::string_view::npos) {
+            break;  // Unterminated tag: the rest is literal text
+        }
+        add_literal(pos, open);
+        pos = close + close_tag.size();
+
+        std::string_view name = Trim(text.substr(name_begin, close - name_begin));
+        bool escape = html && !triple;
+        if (!name.empty() && name.front() == '&') {  // {{& name}}, Mustache's other unescaped form
+            name = Trim(name.substr(1));
+            escape = false;
+        }
+        if (name.empty() || name.front() == '!') {
+            continue;
+        }
+
+        auto it = std::find(compiled.variables_.begin(), compiled.variables_.end(), name);
+        if (it == compiled.variables_.end()) {
+            it = compiled.variables_.emplace(compiled.variables_.end(), name);
+        }
+        Segment segment;
+        segment.variable = static_cast<int32_t>(it - compiled.variables_.begin());
+        segment.escape = escape;
+        compiled.segments_.push_back(segment);
+    }
+    add_literal(pos, text.size());
+    return compiled;
+}
+
+std::shared_ptr<const EmailTemplate> EmailTemplate::Compile(EmailTemplateSource source) {
+    auto compiled = std::make_shared<EmailTemplate>();
+    compiled->id = std::move(source.id);
+    compiled->version = source.version;
+    compiled->subject = CompiledTemplate::Compile(std::move(source.subject), false);
+    compiled->body_html = CompiledTemplate::Compile(std::move(source.body_html), true);
+    compiled->body_text = CompiledTemplate::Compile(std::move(source.body_text), false);
+    return compiled;
+}
+
+EmailTemplateOptions EmailTemplateOptions::FromEnv() {
+    EmailTemplateOptions options;
+    options.ttl = std::chrono::seconds(
+        EnvInt("EMAIL_TEMPLATE_TTL_S", static_cast<long>(options.ttl.count())));
+    options.max_entries = static_cast<size_t>(
+        EnvInt("EMAIL_TEMPLATE_CACHE_MAX", static_cast<long>(options.max_entries)));
+    return options;
+}
+
+EmailTemplateCache::EmailTemplateCache(std::shared_ptr<DbPool> db_pool, const EmailTemplateOptions& options)
+    : EmailTemplateCache(
+        [db_pool](const std::string& tenant_id, const std::string& template_id) -> std::optional<EmailTemplateSource> {
+            auto conn_guard = db_pool->AcquireConnection("EmailTemplateCache::Load");
+            pqxx::read_transaction txn(*conn_guard);
+
+            auto result = ExecPrepared(txn, kSelectEmailTemplate, tenant_id, template_id);
+            if (result.empty()) {
+                return std::nullopt;
+            }
+
+            const auto& row = result[0];
+            EmailTemplateSource source;
+            ReadText(row["id"], source.id);
+            ReadText(row["subject"], source.subject);
+            ReadText(row["body_html"], source.body_html);
+            ReadText(row["body_text"], source.body_text);
+            source.version = row["version"].as<int64_t>();
+            return source;
+        },
+        options) {}
+
+EmailTemplateCache::EmailTemplateCache(Loader loader, const EmailTemplateOptions& options)
+    : loader_(std::move(loader)), options_(options) {}
+
+std::shared_ptr<const EmailTemplate> EmailTemplateCache::Get(const std::string& tenant_id,
+                                                             const std::string& template_id) {
+    auto now = std::chrono::steady_clock::now();
+    std::string key = Key(tenant_id, template_id);
+    std::shared_ptr<const EmailTemplate> cached;
+    uint64_t generation = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            if (now - it->second.loaded_at < options_.ttl) {
+                return it->second.compiled;
+            }
+            cached = it->second.compiled;
+        }
+        generation = generation_;
+    }
+
+    // Query outside the lock; concurrent cold loads of one template are rare and idempotent
+    auto source = loader_(tenant_id, template_id);
+    std::shared_ptr<const EmailTemplate> compiled;
+    if (source) {
+        bool unchanged = cached && cached->id == source->id && cached->version == source->version;
+        compiled = unchanged ? cached : EmailTemplate::Compile(std::move(*source));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_) {
+        return compiled;
+    }
+    if (!compiled) {
+        entries_.erase(key);
+        return nullptr;
+    }
+    if (entries_.size() >= options_.max_entries && entries_.find(key) == entries_.end()) {
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            it = (now - it->second.loaded_at >= options_.ttl) ? entries_.erase(it) : std::next(it);
+        }
+        if (entries_.size() >= options_.max_entries && !entries_.empty()) {
+            entries_.erase(entries_.begin());
+        }
+    }
+    entries_[key] = Entry{tenant_id, compiled, now};
+    return compiled;
+}
+
+void EmailTemplateCache::Invalidate(const std::string& tenant_id, const std::string& template_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    entries_.erase(Key(tenant_id, template_id));
+}
+
+void EmailTemplateCache::InvalidateTenant(const std::string& tenant_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = it->second.tenant_id == tenant_id ? entries_.erase(it) : std::next(it);
+    }
+}
+
+size_t EmailTemplateCache::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::string EmailTemplateCache::Key(const std::string& tenant_id, const std::string& template_id) {
+    // Tenant ids are UUIDs, so the first ':' ends the tenant part
+    std::string key;
+    key.reserve(tenant_id.size() + 1 + template_id.size());
+    key.append(tenant_id).append(1, ':').append(template_id);
+    return key;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,303 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-endpoint webhook health scores and circuit state, shared across replicas implementation
+ */
+
+#include "common/endpoint_health.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// KEYS[1] = health hash, ARGV = host, open_until ms (0: closed), channel
+constexpr const char* TRANSITION_LUA = R"(
+if ARGV[2] == '0' then
+    redis.call('HDEL', KEYS[1], ARGV[1])
+else
+    redis.call('HSET', KEYS[1], ARGV[1], ARGV[2])
+end
+redis.call('PUBLISH', ARGV[3], ARGV[1] .. ' ' .. ARGV[2])
+return 1
+)";
+
+// KEYS[1] = health hash, ARGV[1] = cutoff ms
+// Drops entries whose open period ended before the cutoff; returns the others as {host, open_until, ...}
+constexpr const char* LOAD_LUA = R"(
+local entries = redis.call('HGETALL', KEYS[1])
+local live = {}
+for i = 1, #entries, 2 do
+    if tonumber(entries[i + 1]) < tonumber(ARGV[1]) then
+        redis.call('HDEL', KEYS[1], entries[i])
+    else
+        live[#live + 1] = entries[i]
+        live[#live + 1] = entries[i + 1]
+    end
+end
+return live
+)";
+
+} // namespace
+
+EndpointHealthOptions EndpointHealthOptions::FromEnv() {
+    EndpointHealthOptions options;
+    options.failure_threshold = static_cast<uint32_t>(
+        EnvInt("WEBHOOK_HEALTH_FAILURE_THRESHOLD", static_cast<long>(options.failure_threshold)));
+    options.min_success_rate = static_cast<double>(
+        EnvInt("WEBHOOK_HEALTH_MIN_SUCCESS_PCT", static_cast<long>(options.min_success_rate * 100))) / 100;
+    options.open_duration = std::chrono::milliseconds(
+        EnvInt("WEBHOOK_HEALTH_OPEN_MS", static_cast<long>(options.open_duration.count())));
+    options.max_open_duration = std::chrono::milliseconds(
+        EnvInt("WEBHOOK_HEALTH_MAX_OPEN_MS", static_cast<long>(options.max_open_duration.count())));
+    options.probe_timeout = std::chrono::milliseconds(
+        EnvInt("WEBHOOK_HEALTH_PROBE_TIMEOUT_MS", static_cast<long>(options.probe_timeout.count())));
+    return options;
+}
+
+EndpointHealth::EndpointHealth(std::shared_ptr<RedisClient> redis_client, const EndpointHealthOptions& options)
+    : redis_client_(std::move(redis_client)), options_(options) {
+    options_.failure_threshold = std::max<uint32_t>(options_.failure_threshold, 1);
+    options_.smoothing = std::clamp(options_.smoothing, 0.0, 1.0);
+    options_.max_open_duration = std::max(options_.max_open_duration, options_.open_duration);
+    if (!redis_client_) {
+        return;
+    }
+
+    Reload();
+
+    // Each (re)subscribe reloads the hash, since messages may have been missed
+    subscription_ = redis_client_->Subscribe(
+        CHANNEL,
+        [this](const std::string& message) {
+            size_t space = message.rfind(' ');
+            if (space == std::string::npos || space == 0) {
+                return;
+            }
+            Note(message.substr(0, space), std::strtoll(message.c_str() + space + 1, nullptr, 10));
+        },
+        [this]() { Reload(); }
+    );
+}
+
+EndpointHealth::~EndpointHealth() {
+    if (subscription_ != 0) {
+        redis_client_->Unsubscribe(subscription_);
+    }
+}
+
+bool EndpointHealth::Allow(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(host);
+    if (it == entries_.end()) {
+        return true;
+    }
+    auto& health = it->second.health;
+    int64_t now = NowMillis();
+    if (health.state == EndpointState::OPEN && now >= health.open_until_ms) {
+        health.state = EndpointState::HALF_OPEN;
+        health.probing = false;
+    }
+
+    switch (health.state) {
+        case EndpointState::CLOSED:
+            return true;
+        case EndpointState::OPEN:
+            return false;
+        case EndpointState::HALF_OPEN:
+            if (health.probing && now - it->second.probe_started_ms < options_.probe_timeout.count()) {
+                return false;
+            }
+            health.probing = true;
+            it->second.probe_started_ms = now;
+            return true;
+    }
+    return true;
+}
+
+std::chrono::milliseconds EndpointHealth::RetryAfter(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(host);
+    if (it == entries_.end() || it->second.health.state != EndpointState::OPEN) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(std::max<int64_t>(it->second.health.open_until_ms - NowMillis(), 0));
+}
+
+void EndpointHealth::RecordSuccess(const std::string& host, std::chrono::milliseconds latency) {
+    Record(host, true, latency);
+}
+
+void EndpointHealth::RecordFailure(const std::string& host, std::chrono::milliseconds latency) {
+    Record(host, false, latency);
+}
+
+std::optional<EndpointHealthSnapshot> EndpointHealth::Get(const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(host);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    auto health = it->second.health;
+    if (health.state == EndpointState::OPEN && NowMillis() >= health.open_until_ms) {
+        health.state = EndpointState::HALF_OPEN;
+        health.probing = false;
+    }
+    return health;
+}
+
+void EndpointHealth::Note(const std::string& host, int64_t open_until_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_until_ms <= 0) {
+        auto it = entries_.find(host);
+        if (it == entries_.end() || it->second.health.state == EndpointState::CLOSED) {
+            return;
+        }
+        auto& entry = it->second;
+        entry.health.state = EndpointState::CLOSED;
+        entry.health.open_until_ms = 0;
+        entry.health.probing = false;
+        entry.health.consecutive_failures = 0;
+        entry.samples = 0;
+        entry.reopened = 0;
+        return;
+    }
+
+    Entry* entry = Track(host);
+    if (!entry || open_until_ms <= entry->health.open_until_ms) {
+        return;
+    }
+    entry->health.state = EndpointState::OPEN;
+    entry->health.open_until_ms = open_until_ms;
+    entry->health.probing = false;
+}
+
+size_t EndpointHealth::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+int64_t EndpointHealth::NowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+EndpointHealth::Entry* EndpointHealth::Track(const std::string& host) {
+    auto it = entries_.find(host);
+    if (it != entries_.end()) {
+        return &it->second;
+    }
+    if (entries_.size() >= options_.max_hosts) {
+        // Healthy endpoints lose only their statistics; open circuits are kept
+        for (auto e = entries_.begin(); e != entries_.end();) {
+            e = e->second.health.state == EndpointState::CLOSED ? entries_.erase(e) : std::next(e);
+        }
+        if (entries_.size() >= options_.max_hosts) {
+            return nullptr;
+        }
+    }
+    return &entries_[host];
+}
+
+void EndpointHealth::Record(const std::string& host, bool success, std::chrono::milliseconds latency) {
+    std::optional<int64_t> transition;   // Shared once the lock is released
+    uint32_t failures = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry* entry = Track(host);
+        if (!entry) {
+            return;
+        }
+        auto& health = entry->health;
+        double alpha = options_.smoothing;
+        double ms = static_cast<double>(latency.count());
+        health.success_rate += alpha * ((success ? 1.0 : 0.0) - health.success_rate);
+        health.latency_ms = entry->samples == 0 && health.latency_ms == 0
+            ? ms : health.latency_ms + alpha * (ms - health.latency_ms);
+        ++entry->samples;
+
+        int64_t now = NowMillis();
+        if (health.state == EndpointState::OPEN && now >= health.open_until_ms) {
+            health.state = EndpointState::HALF_OPEN;
+        }
+
+        if (success) {
+            health.consecutive_failures = 0;
+            if (health.state != EndpointState::CLOSED) {
+                // The probe (or an attempt that raced the opening) got through
+                health.state = EndpointState::CLOSED;
+                health.open_until_ms = 0;
+                health.probing = false;
+                entry->samples = 0;
+                entry->reopened = 0;
+                transition = 0;
+            }
+        } else {
+            ++health.consecutive_failures;
+            bool open = false;
+            if (health.state == EndpointState::HALF_OPEN) {
+                ++entry->reopened;
+                open = true;
+            } else if (health.state == EndpointState::CLOSED) {
+                open = health.consecutive_failures >= options_.failure_threshold ||
+                       (entry->samples >= options_.min_samples && health.success_rate < options_.min_success_rate);
+            }
+            if (open) {
+                auto duration = options_.open_duration * (int64_t{1} << std::min<uint32_t>(entry->reopened, 20));
+                duration = std::min(duration, options_.max_open_duration);
+                health.state = EndpointState::OPEN;
+                health.open_until_ms = now + duration.count();
+                health.probing = false;
+                transition = health.open_until_ms;
+                failures = health.consecutive_failures;
+            }
+        }
+    }
+
+    if (transition) {
+        if (*transition != 0) {
+            LogWarn("Webhook endpoint circuit opened", {{"host", host},
+                                                       {"consecutive_failures", failures},
+                                                       {"open_until_ms", *transition}});
+        } else {
+            LogInfo("Webhook endpoint circuit closed", {{"host", host}});
+        }
+        Publish(host, *transition);
+    }
+}
+
+void EndpointHealth::Publish(const std::string& host, int64_t open_until_ms) {
+    if (!redis_client_) {
+        return;
+    }
+    try {
+        std::string open_until = std::to_string(open_until_ms);
+        redis_client_->EvalScript(TRANSITION_LUA, {KEY}, {host, open_until, CHANNEL});
+    } catch (const std::exception& e) {
+        // Other replicas find the endpoint dead on their own
+        LogWarn("Failed to share webhook endpoint health", {{"host", host}, {"error", e.what()}});
+    }
+}
+
+void EndpointHealth::Reload() {
+    try {
+        std::string cutoff = std::to_string(NowMillis() - options_.retention_seconds * 1000);
+        auto entries = redis_client_->EvalScriptStrings(LOAD_LUA, {KEY}, {cutoff});
+        for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+            if (entries[i] && entries[i + 1]) {
+                Note(*entries[i], std::strtoll(entries[i + 1]->c_str(), nullptr, 10));
+            }
+        }
+    } catch (const std::exception& e) {
+        // Keep what we have; the next (re)subscribe retries
+        LogWarn("Failed to load webhook endpoint health", {{"error", e.what()}});
+    }
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,223 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Cache-aside for protobuf entities: sharded local LRU over Redis, single-flight fills implementation
+ */
+
+#include "common/entity_cache.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <random>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Redis value: format byte, fresh_until (Unix ms) and load time (µs), big-endian, then the payload
+constexpr unsigned char STORED_FORMAT = 1;
+constexpr size_t STORED_HEADER = 1 + 8 + 4;
+
+void PutBigEndian(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t GetBigEndian(std::string_view in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+} // namespace
+
+EntityCacheOptions EntityCacheOptions::FromEnv() {
+    EntityCacheOptions options;
+    options.capacity = static_cast<size_t>(EnvInt("ENTITY_CACHE_CAPACITY", static_cast<long>(options.capacity)));
+    options.local_ttl = std::chrono::milliseconds(
+        EnvInt("ENTITY_CACHE_LOCAL_TTL_MS", static_cast<long>(options.local_ttl.count())));
+    options.ttl = std::chrono::seconds(
+        std::max(1L, EnvInt("ENTITY_CACHE_TTL_S", static_cast<long>(options.ttl.count()))));
+    options.beta = EnvDouble("ENTITY_CACHE_BETA", options.beta);
+    return options;
+}
+
+EntityCacheStore EntityCacheStore::From(std::shared_ptr<RedisClient> redis) {
+    EntityCacheStore store;
+    if (!redis) {
+        return store;
+    }
+    store.get = [redis](const std::string& key) { return redis->Get(key); };
+    store.set = [redis](const std::string& key, const std::string& value, std::chrono::milliseconds ttl) {
+        redis->SetWithTtl(key, value, ttl);
+    };
+    store.erase = [redis](const std::vector<std::string>& keys) { redis->DeleteMany(keys); };
+    return store;
+}
+
+EntityCacheBase::EntityCacheBase(std::string name, EntityCacheStore store, std::shared_ptr<EventBus> event_bus,
+                                 const EntityCacheOptions& options)
+    : name_(std::move(name)), store_(std::move(store)), event_bus_(std::move(event_bus)), options_(options) {
+    if (options_.ttl.count() <= 0) {
+        options_.ttl = std::chrono::seconds(60);
+    }
+}
+
+EntityCacheBase::~EntityCacheBase() = default;
+
+void EntityCacheBase::Attach() {
+    if (event_bus_) {
+        subscription_ = event_bus_->Subscribe(
+            Topic(),
+            [this](const std::string& key) { DropLocal(key); },
+            [this] { DropAllLocal(); });
+    }
+    metrics_collector_ = MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        auto stats = GetStats();
+        MetricLabels labels = {{"cache", name_}};
+        writer.AddGauge("saasforge_entity_cache_entries", "Entities held in the local tier", labels,
+                        static_cast<double>(stats.entries));
+        const char* lookups_help = "Entity cache lookups by the tier that answered";
+        writer.AddCounter("saasforge_entity_cache_lookups_total", lookups_help,
+                          {{"cache", name_}, {"result", "local"}}, static_cast<double>(stats.local_hits));
+        writer.AddCounter("saasforge_entity_cache_lookups_total", lookups_help,
+                          {{"cache", name_}, {"result", "redis"}}, static_cast<double>(stats.shared_hits));
+        writer.AddCounter("saasforge_entity_cache_lookups_total", lookups_help,
+                          {{"cache", name_}, {"result", "load"}}, static_cast<double>(stats.loads));
+        writer.AddCounter("saasforge_entity_cache_lookups_total", lookups_help,
+                          {{"cache", name_}, {"result", "coalesced"}}, static_cast<double>(stats.coalesced));
+        writer.AddCounter("saasforge_entity_cache_early_refreshes_total", "Loads started before the value expired",
+                          labels, static_cast<double>(stats.early_refreshes));
+        writer.AddCounter("saasforge_entity_cache_invalidations_total", "Entities invalidated by writes", labels,
+                          static_cast<double>(stats.invalidations));
+        writer.AddCounter("saasforge_entity_cache_store_errors_total", "Failed Redis reads and writes", labels,
+                          static_cast<double>(stats.store_errors));
+    });
+}
+
+void EntityCacheBase::Detach() {
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+    if (event_bus_ && subscription_ != 0) {
+        event_bus_->Unsubscribe(subscription_);
+        subscription_ = 0;
+    }
+}
+
+std::optional<EntityCacheBase::Stored> EntityCacheBase::ReadStore(const std::string& key) {
+    if (!store_.get) {
+        return std::nullopt;
+    }
+    std::optional<std::string> value;
+    try {
+        value = store_.get(StoreKey(key));
+    } catch (const std::exception&) {
+        ++store_errors_;   // Counted, not logged: during an outage every miss would log
+        return std::nullopt;
+    }
+    if (!value || value->size() < STORED_HEADER || static_cast<unsigned char>((*value)[0]) != STORED_FORMAT) {
+        return std::nullopt;
+    }
+    std::string_view view(*value);
+    Stored stored;
+    stored.fresh_until = WallClock::time_point(
+        std::chrono::milliseconds(static_cast<int64_t>(GetBigEndian(view.substr(1), 8))));
+    stored.load_time = std::chrono::microseconds(GetBigEndian(view.substr(9), 4));
+    stored.payload.assign(view.substr(STORED_HEADER));
+    return stored;
+}
+
+void EntityCacheBase::WriteStore(const std::string& key, const Stored& stored) {
+    if (!store_.set) {
+        return;
+    }
+    auto ttl = std::chrono::duration_cast<std::chrono::milliseconds>(stored.fresh_until - WallClock::now());
+    if (ttl.count() <= 0) {
+        return;
+    }
+    auto fresh_until_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        stored.fresh_until.time_since_epoch()).count();
+    auto load_time = std::min<int64_t>(stored.load_time.count(), std::numeric_limits<uint32_t>::max());
+
+    std::string value;
+    value.reserve(STORED_HEADER + stored.payload.size());
+    value.push_back(static_cast<char>(STORED_FORMAT));
+    PutBigEndian(value, static_cast<uint64_t>(fresh_until_ms), 8);
+    PutBigEndian(value, static_cast<uint64_t>(load_time), 4);
+    value.append(stored.payload);
+    try {
+        store_.set(StoreKey(key), value, ttl);
+    } catch (const std::exception&) {
+        ++store_errors_;
+    }
+}
+
+void EntityCacheBase::EraseStore(const std::vector<std::string>& keys) {
+    if (!store_.erase || keys.empty()) {
+        return;
+    }
+    std::vector<std::string> store_keys;
+    store_keys.reserve(keys.size());
+    for (const auto& key : keys) {
+        store_keys.push_back(StoreKey(key));
+    }
+    try {
+        store_.erase(store_keys);
+    } catch (const std::exception& e) {
+        // Other replicas may serve the old value from Redis until it expires
+        ++store_errors_;
+        LogWarn("Entity cache invalidation not stored", {{"cache", name_}, {"error", e.what()}});
+    }
+}
+
+void EntityCacheBase::Announce(const std::string& key) {
+    if (event_bus_ && !event_bus_->Publish(Topic(), key)) {
+        LogWarn("Entity cache invalidation not published", {{"cache", name_}});
+    }
+}
+
+bool EntityCacheBase::RefreshEarly(WallClock::time_point fresh_until, std::chrono::microseconds load_time) const {
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(fresh_until - WallClock::now());
+    if (remaining.count() <= 0) {
+        return true;
+    }
+    if (options_.beta <= 0.0 || load_time.count() <= 0) {
+        return false;
+    }
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    double draw = std::uniform_real_distribution<double>(std::numeric_limits<double>::min(), 1.0)(rng);
+    double ahead = -std::log(draw) * options_.beta * static_cast<double>(load_time.count());
+    return ahead >= static_cast<double>(remaining.count());
+}
+
+void EntityCacheBase::RefreshFailed(const std::exception_ptr& error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        LogWarn("Entity cache refresh failed", {{"cache", name_}, {"error", e.what()}});
+    } catch (...) {
+        LogWarn("Entity cache refresh failed", {{"cache", name_}});
+    }
+}
+
+EntityCacheStats EntityCacheBase::GetStats() const {
+    EntityCacheStats stats;
+    stats.entries = LocalSize();
+    stats.local_hits = local_hits_.load();
+    stats.shared_hits = shared_hits_.load();
+    stats.loads = loads_.load();
+    stats.coalesced = coalesced_.load();
+    stats.early_refreshes = early_refreshes_.load();
+    stats.invalidations = invalidations_.load();
+    stats.store_errors = store_errors_.load();
+    return stats;
+}
+
+} // namespace common
+} // namespace saasforge
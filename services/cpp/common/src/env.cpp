@@ -0,0 +1,67 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Reading configuration from environment variables implementation
+ */
+
+#include "common/env.h"
+#include <cstdlib>
+#include <sstream>
+
+namespace saasforge {
+namespace common {
+
+long EnvInt(const char* name, long default_value) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return default_value;
+    }
+    char* end = nullptr;
+    long parsed = std::strtol(value, &end, 10);
+    return (end && *end == '\0' && parsed >= 0) ? parsed : default_value;
+}
+
+long EnvInt(const std::string& name, long default_value) {
+    return EnvInt(name.c_str(), default_value);
+}
+
+double EnvDouble(const char* name, double default_value) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return default_value;
+    }
+    char* end = nullptr;
+    double parsed = std::strtod(value, &end);
+    return (end && *end == '\0' && parsed >= 0.0) ? parsed : default_value;
+}
+
+double EnvRatio(const char* name, double default_value) {
+    double parsed = EnvDouble(name, default_value);
+    return parsed <= 1.0 ? parsed : default_value;
+}
+
+std::string EnvString(const char* name, const std::string& default_value) {
+    const char* value = std::getenv(name);
+    return (value && *value) ? value : default_value;
+}
+
+std::vector<std::string> EnvList(const char* name, std::vector<std::string> default_value) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) {
+        return default_value;
+    }
+    std::vector<std::string> items;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+} // namespace common
+} // namespace saasforge
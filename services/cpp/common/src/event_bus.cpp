@@ -0,0 +1,381 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Event bus between services on Redis Streams consumer groups implementation
+ */
+
+#include "common/event_bus.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr std::chrono::milliseconds SHUTDOWN_FLUSH{1000};
+constexpr std::chrono::milliseconds PAUSE_SLICE{50};
+
+std::string DefaultConsumer() {
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) != 0 || !host[0]) {
+        return EnvString("HOSTNAME", "host") + "-" + std::to_string(getpid());
+    }
+    return std::string(host) + "-" + std::to_string(getpid());
+}
+
+} // namespace
+
+EventBusOptions EventBusOptions::FromEnv() {
+    EventBusOptions options;
+    options.max_len = static_cast<size_t>(EnvInt("EVENT_BUS_MAX_LEN", static_cast<long>(options.max_len)));
+    options.batch = static_cast<size_t>(EnvInt("EVENT_BUS_BATCH", static_cast<long>(options.batch)));
+    options.max_buffered = static_cast<size_t>(
+        EnvInt("EVENT_BUS_MAX_BUFFERED", static_cast<long>(options.max_buffered)));
+    options.publish_wait = std::chrono::milliseconds(
+        EnvInt("EVENT_BUS_PUBLISH_WAIT_MS", static_cast<long>(options.publish_wait.count())));
+    options.block = std::chrono::milliseconds(
+        EnvInt("EVENT_BUS_BLOCK_MS", static_cast<long>(options.block.count())));
+    options.consumer = EnvString("EVENT_BUS_CONSUMER", options.consumer);
+    return options;
+}
+
+EventStreams EventStreams::From(std::shared_ptr<RedisClient> redis) {
+    EventStreams streams;
+    streams.append = [redis](const Entries& entries, size_t max_len) {
+        redis->StreamAppend(entries, max_len);
+    };
+    streams.create_group = [redis](const std::string& key, const std::string& group) {
+        return redis->StreamCreateGroup(key, group);
+    };
+    streams.destroy_group = [redis](const std::string& key, const std::string& group) {
+        redis->StreamDestroyGroup(key, group);
+    };
+    streams.read_group = [redis](const std::string& key, const std::string& group, const std::string& consumer,
+                                 const std::string& id, size_t count, std::chrono::milliseconds block) {
+        try {
+            return redis->StreamReadGroup(key, group, consumer, id, count, block);
+        } catch (const sw::redis::ReplyError& e) {
+            if (std::string_view(e.what()).rfind("NOGROUP", 0) == 0) {
+                throw StreamGroupMissing(e.what());
+            }
+            throw;
+        }
+    };
+    streams.ack = [redis](const std::string& key, const std::string& group, const std::vector<std::string>& ids) {
+        redis->StreamAck(key, group, ids);
+    };
+    return streams;
+}
+
+EventBus::EventBus(std::shared_ptr<RedisClient> redis, const EventBusOptions& options)
+    : EventBus(EventStreams::From(std::move(redis)), options) {}
+
+EventBus::EventBus(EventStreams streams, const EventBusOptions& options)
+    : streams_(std::move(streams)), options_(options) {
+    options_.max_len = std::max<size_t>(options_.max_len, 1);
+    options_.batch = std::max<size_t>(options_.batch, 1);
+    options_.max_buffered = std::max(options_.max_buffered, options_.batch);
+    options_.publish_wait = std::max(options_.publish_wait, std::chrono::milliseconds(0));
+    options_.block = std::clamp(options_.block, std::chrono::milliseconds(1), RedisClient::MAX_STREAM_BLOCK);
+    if (options_.retry.count() <= 0) {
+        options_.retry = std::chrono::milliseconds(1000);
+    }
+    if (options_.consumer.empty()) {
+        options_.consumer = DefaultConsumer();
+    }
+
+    metrics_collector_ = MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        size_t buffered = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffered = buffer_.size() + sending_;
+        }
+        writer.AddGauge("saasforge_event_bus_buffered", "Published events not yet sent to Redis", {},
+                        static_cast<double>(buffered));
+        writer.AddCounter("saasforge_event_bus_published_total", "Events sent to Redis", {},
+                          static_cast<double>(published_.load()));
+        writer.AddCounter("saasforge_event_bus_dropped_total", "Events dropped on a full publish buffer", {},
+                          static_cast<double>(dropped_.load()));
+        writer.AddCounter("saasforge_event_bus_received_total", "Events handed to subscribers", {},
+                          static_cast<double>(received_.load()));
+        writer.AddCounter("saasforge_event_bus_errors_total", "Failed stream commands", {},
+                          static_cast<double>(errors_.load()));
+    });
+
+    publisher_ = std::thread([this] { PublishLoop(); });
+}
+
+EventBus::~EventBus() {
+    Shutdown();
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+std::string EventBus::StreamKey(std::string_view topic) {
+    std::string key = "events:";
+    key.append(topic);
+    return key;
+}
+
+bool EventBus::Publish(const std::string& topic, std::string payload) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (buffer_.size() >= options_.max_buffered) {
+        cv_.wait_for(lock, options_.publish_wait,
+                     [this] { return shutdown_ || buffer_.size() < options_.max_buffered; });
+    }
+    if (shutdown_) {
+        return false;
+    }
+    if (buffer_.size() >= options_.max_buffered) {
+        lock.unlock();
+        if (dropped_.fetch_add(1) == 0) {
+            LogWarn("Event bus buffer full, dropping events", {{"topic", topic}});
+        }
+        return false;
+    }
+    buffer_.emplace_back(StreamKey(topic), std::move(payload));
+    lock.unlock();
+    cv_.notify_all();
+    return true;
+}
+
+void EventBus::PublishLoop() {
+    EventStreams::Entries entries;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return shutdown_ || !buffer_.empty(); });
+            if (shutdown_) {
+                return;
+            }
+            size_t count = std::min(buffer_.size(), options_.batch);
+            entries.clear();
+            entries.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                entries.push_back(std::move(buffer_.front()));
+                buffer_.pop_front();
+            }
+            sending_ = count;
+        }
+        // Publishers blocked on a full buffer can go on
+        cv_.notify_all();
+
+        bool sent = true;
+        try {
+            streams_.append(entries, options_.max_len);
+            published_.fetch_add(entries.size());
+        } catch (const std::exception& e) {
+            sent = false;
+            errors_.fetch_add(1);
+            LogWarn("Publishing events failed", {{"error", e.what()}, {"events", std::to_string(entries.size())}});
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!sent) {
+            // Back in front, in order; XADD is not idempotent, so a batch that
+            // reached Redis before the error is published twice
+            for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+                buffer_.push_front(std::move(*it));
+            }
+        }
+        sending_ = 0;
+        cv_.notify_all();
+        if (!sent) {
+            cv_.wait_for(lock, options_.retry, [this] { return shutdown_; });
+        }
+    }
+}
+
+bool EventBus::Flush(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [this] { return shutdown_ || (buffer_.empty() && sending_ == 0); }) &&
+           buffer_.empty() && sending_ == 0;
+}
+
+uint64_t EventBus::Subscribe(const std::string& topic, Handler handler, std::function<void()> on_reset,
+                             const std::string& group) {
+    std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+    {
+        std::lock_guard<std::mutex> state_lock(mutex_);
+        if (shutdown_) {
+            throw std::runtime_error("EventBus is shut down");
+        }
+    }
+
+    Subscription subscription;
+    subscription.id = next_subscription_id_++;
+    subscription.key = StreamKey(topic);
+    subscription.own_group = group.empty();
+    // Subscriptions of one process to the same topic each see every event
+    subscription.group = subscription.own_group
+        ? options_.consumer + "#" + std::to_string(subscription.id)
+        : group;
+    subscription.stop = std::make_shared<std::atomic<bool>>(false);
+
+    // Created here, at the stream's end, so the next Publish() is seen; the
+    // reader thread keeps trying if Redis is down
+    bool created = false;
+    try {
+        streams_.create_group(subscription.key, subscription.group);
+        created = true;
+    } catch (const std::exception& e) {
+        errors_.fetch_add(1);
+        LogWarn("Creating event group failed, retrying", {
+            {"stream", subscription.key}, {"group", subscription.group}, {"error", e.what()}
+        });
+    }
+
+    subscription.thread = std::thread(&EventBus::ReadLoop, this, subscription.key, subscription.group, created,
+                                      std::move(handler), std::move(on_reset), subscription.stop);
+    uint64_t id = subscription.id;
+    subscriptions_.push_back(std::move(subscription));
+    return id;
+}
+
+void EventBus::ReadLoop(std::string key, std::string group, bool created, Handler handler,
+                        std::function<void()> on_reset, std::shared_ptr<std::atomic<bool>> stop) {
+    // "0": this consumer's unacknowledged entries; ">": new ones
+    std::string id = "0";
+    std::vector<std::string> ids;
+    while (!stop->load()) {
+        if (!created) {
+            try {
+                streams_.create_group(key, group);
+                created = true;
+                id = "0";
+            } catch (const std::exception& e) {
+                errors_.fetch_add(1);
+                LogWarn("Creating event group failed", {{"stream", key}, {"group", group}, {"error", e.what()}});
+                Pause(*stop);
+                continue;
+            }
+            if (on_reset) {
+                try {
+                    on_reset();
+                } catch (const std::exception& e) {
+                    LogError("Event bus reset handler failed", {{"stream", key}, {"error", e.what()}});
+                }
+            }
+        }
+
+        std::vector<StreamMessage> messages;
+        try {
+            messages = streams_.read_group(key, group, options_.consumer, id, options_.batch, options_.block);
+        } catch (const StreamGroupMissing&) {
+            LogWarn("Event group lost, creating it again", {{"stream", key}, {"group", group}});
+            created = false;
+            continue;
+        } catch (const std::exception& e) {
+            errors_.fetch_add(1);
+            LogWarn("Reading events failed", {{"stream", key}, {"group", group}, {"error", e.what()}});
+            id = "0";
+            Pause(*stop);
+            continue;
+        }
+        if (messages.empty()) {
+            // Pending entries are done (or the block timed out on new ones)
+            id = ">";
+            continue;
+        }
+
+        ids.clear();
+        ids.reserve(messages.size());
+        for (const auto& message : messages) {
+            if (stop->load()) {
+                return;
+            }
+            try {
+                handler(message.payload);
+            } catch (const std::exception& e) {
+                LogError("Event handler failed", {{"stream", key}, {"event_id", message.id}, {"error", e.what()}});
+            }
+            ids.push_back(message.id);
+        }
+        received_.fetch_add(messages.size());
+
+        try {
+            streams_.ack(key, group, ids);
+        } catch (const std::exception& e) {
+            errors_.fetch_add(1);
+            LogWarn("Acknowledging events failed", {{"stream", key}, {"group", group}, {"error", e.what()}});
+            id = "0";
+            Pause(*stop);
+        }
+    }
+}
+
+void EventBus::Pause(const std::atomic<bool>& stop) {
+    auto deadline = std::chrono::steady_clock::now() + options_.retry;
+    while (!stop.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::min(PAUSE_SLICE, options_.retry));
+    }
+}
+
+void EventBus::EndSubscription(Subscription& subscription) {
+    subscription.stop->store(true);
+    if (subscription.thread.joinable()) {
+        subscription.thread.join();
+    }
+    if (!subscription.own_group) {
+        return;
+    }
+    try {
+        streams_.destroy_group(subscription.key, subscription.group);
+    } catch (const std::exception& e) {
+        LogWarn("Removing event group failed", {
+            {"stream", subscription.key}, {"group", subscription.group}, {"error", e.what()}
+        });
+    }
+}
+
+void EventBus::Unsubscribe(uint64_t subscription_id) {
+    Subscription subscription;
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        auto it = std::find_if(subscriptions_.begin(), subscriptions_.end(),
+                               [subscription_id](const Subscription& s) { return s.id == subscription_id; });
+        if (it == subscriptions_.end()) {
+            return;
+        }
+        subscription = std::move(*it);
+        subscriptions_.erase(it);
+    }
+    EndSubscription(subscription);
+}
+
+void EventBus::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_) {
+            return;
+        }
+    }
+    Flush(SHUTDOWN_FLUSH);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    if (publisher_.joinable()) {
+        publisher_.join();
+    }
+
+    std::vector<Subscription> subscriptions;
+    {
+        std::lock_guard<std::mutex> lock(subscriptions_mutex_);
+        subscriptions.swap(subscriptions_);
+    }
+    for (auto& subscription : subscriptions) {
+        subscription.stop->store(true);
+    }
+    for (auto& subscription : subscriptions) {
+        EndSubscription(subscription);
+    }
+}
+
+} // namespace common
+} // namespace saasforge
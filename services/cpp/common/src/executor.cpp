@@ -0,0 +1,295 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Bounded thread pool implementation
+ */
+
+#include "common/executor.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/tracing.h"
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace saasforge {
+namespace common {
+
+// Guarded by timer_mutex_
+struct Executor::Periodic {
+    std::chrono::milliseconds interval;
+    std::function<void()> task;
+    std::chrono::steady_clock::time_point next_run;
+    bool pending = false;       // Queued or running
+    bool cancelled = false;
+};
+
+Executor::Executor(size_t num_threads, size_t queue_capacity, bool pin_threads)
+    : queue_capacity_(std::max<size_t>(queue_capacity, 1)) {
+    size_t cores = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    if (num_threads == 0) {
+        num_threads = cores * 2;
+    }
+    max_bulk_running_ = num_threads > 1 ? num_threads - 1 : 1;
+
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(&Executor::WorkerLoop, this);
+        if (pin_threads) {
+            PinToCore(workers_.back(), i % cores);
+        }
+    }
+}
+
+Executor::~Executor() {
+    Shutdown();
+}
+
+bool Executor::TrySubmit(std::function<void()> task, TaskPriority priority) {
+    // Spans started by the task belong to the submitter's trace
+    TraceContext trace = TraceContext::Current();
+    if (trace.Active()) {
+        task = [trace = std::move(trace), task = std::move(task)]() {
+            ScopedTraceContext trace_scope(trace);
+            task();
+        };
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_ || critical_.size() + bulk_.size() >= queue_capacity_) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        (priority == TaskPriority::BULK ? bulk_ : critical_).push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+uint64_t Executor::SchedulePeriodic(std::chrono::milliseconds interval, std::function<void()> task,
+                                    std::chrono::milliseconds initial_delay) {
+    auto periodic = std::make_shared<Periodic>();
+    periodic->interval = std::max(interval, std::chrono::milliseconds(1));
+    periodic->task = std::move(task);
+    periodic->next_run = std::chrono::steady_clock::now() + initial_delay;
+
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        if (timer_shutdown_) {
+            return 0;
+        }
+        id = next_periodic_id_++;
+        periodic_[id] = periodic;
+        if (!timer_.joinable()) {
+            timer_ = std::thread(&Executor::TimerLoop, this);
+        }
+    }
+    timer_cv_.notify_all();
+    return id;
+}
+
+void Executor::Cancel(uint64_t id) {
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+    auto it = periodic_.find(id);
+    if (it == periodic_.end()) {
+        return;
+    }
+    auto periodic = it->second;
+    periodic_.erase(it);
+    periodic->cancelled = true;
+    // A queued run sees cancelled and returns; a running one is waited for
+    timer_cv_.wait(lock, [&periodic] { return !periodic->pending; });
+}
+
+size_t Executor::PeriodicCount() const {
+    std::lock_guard<std::mutex> lock(timer_mutex_);
+    return periodic_.size();
+}
+
+void Executor::TimerLoop() {
+    std::unique_lock<std::mutex> lock(timer_mutex_);
+    while (!timer_shutdown_) {
+        auto now = std::chrono::steady_clock::now();
+        auto wake = std::chrono::steady_clock::time_point::max();
+        for (auto& [id, periodic] : periodic_) {
+            if (periodic->pending) {
+                continue;   // Rescheduled when the run finishes
+            }
+            if (periodic->next_run <= now) {
+                SubmitPeriodic(periodic);
+            }
+            if (!periodic->pending) {
+                wake = std::min(wake, periodic->next_run);
+            }
+        }
+        if (wake == std::chrono::steady_clock::time_point::max()) {
+            timer_cv_.wait(lock);
+        } else {
+            timer_cv_.wait_until(lock, wake);
+        }
+    }
+}
+
+void Executor::SubmitPeriodic(const std::shared_ptr<Periodic>& periodic) {
+    periodic->pending = true;
+    bool queued = TrySubmit([this, periodic] {
+        bool run;
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex_);
+            run = !periodic->cancelled;
+        }
+        if (run) {
+            try {
+                periodic->task();
+            } catch (const std::exception& e) {
+                LogError("Periodic task failed", {{"error", e.what()}});
+            } catch (...) {
+                LogError("Periodic task failed with unknown exception");
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex_);
+            periodic->pending = false;
+            periodic->next_run = std::chrono::steady_clock::now() + periodic->interval;
+        }
+        timer_cv_.notify_all();
+    }, TaskPriority::BULK);
+
+    if (!queued) {
+        // Full (counted in RejectedCount()) or shutting down: try again next interval
+        periodic->pending = false;
+        periodic->next_run = std::chrono::steady_clock::now() + periodic->interval;
+    }
+}
+
+void Executor::Shutdown() {
+    // First, so a scrape never reads an executor that is going away
+    if (uint64_t collector = metrics_collector_.exchange(0)) {
+        MetricsRegistry::Global().RemoveCollector(collector);
+    }
+    {
+        // Runs already queued see cancelled and return while the workers drain
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        timer_shutdown_ = true;
+        for (auto& [id, periodic] : periodic_) {
+            periodic->cancelled = true;
+        }
+        periodic_.clear();
+    }
+    timer_cv_.notify_all();
+    if (timer_.joinable() && timer_.get_id() != std::this_thread::get_id()) {
+        timer_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void Executor::ExportMetrics(const std::string& name) {
+    uint64_t collector = MetricsRegistry::Global().AddCollector([this, name](MetricsWriter& writer) {
+        MetricLabels labels = {{"executor", name}};
+        writer.AddGauge("saasforge_executor_queue_depth", "Tasks waiting for a worker", labels,
+                        static_cast<double>(QueueDepth()));
+        writer.AddGauge("saasforge_executor_queue_capacity", "Queued tasks allowed before rejecting", labels,
+                        static_cast<double>(queue_capacity_));
+        writer.AddGauge("saasforge_executor_threads", "Worker threads", labels, static_cast<double>(ThreadCount()));
+        writer.AddCounter("saasforge_executor_rejected_total", "Tasks rejected because the queue was full", labels,
+                          static_cast<double>(RejectedCount()));
+        writer.AddGauge("saasforge_executor_periodic_tasks", "Periodic tasks scheduled", labels,
+                        static_cast<double>(PeriodicCount()));
+    });
+    if (uint64_t previous = metrics_collector_.exchange(collector)) {
+        MetricsRegistry::Global().RemoveCollector(previous);
+    }
+}
+
+size_t Executor::QueueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return critical_.size() + bulk_.size();
+}
+
+Executor& Executor::Background() {
+    // Leaked, like the other process-wide registries: loops may still be
+    // cancelled from destructors running during static destruction
+    static Executor* executor = [] {
+        auto* instance = new Executor(static_cast<size_t>(std::max(1L, EnvInt("BACKGROUND_EXECUTOR_THREADS", 4))),
+                                      1024);
+        instance->ExportMetrics("background");
+        return instance;
+    }();
+    return *executor;
+}
+
+void Executor::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        bool bulk = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] {
+                return !critical_.empty() || (!bulk_.empty() && bulk_running_ < max_bulk_running_) ||
+                       (shutdown_ && bulk_.empty());
+            });
+            if (!critical_.empty()) {
+                task = std::move(critical_.front());
+                critical_.pop_front();
+            } else if (!bulk_.empty()) {
+                task = std::move(bulk_.front());
+                bulk_.pop_front();
+                bulk = true;
+                ++bulk_running_;
+            } else {
+                return; // Shut down and drained
+            }
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LogError("Executor task failed", {{"error", e.what()}});
+        } catch (...) {
+            LogError("Executor task failed with unknown exception");
+        }
+
+        if (bulk) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --bulk_running_;
+            }
+            cv_.notify_one();   // The next bulk task may be waiting for this slot
+        }
+    }
+}
+
+void Executor::PinToCore(std::thread& thread, size_t core) {
+#ifdef __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuset) != 0) {
+        LogWarn("Failed to pin executor thread to core", {{"core", core}});
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,158 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description SIGTERM-driven drain of a gRPC server for rolling deploys implementation
+ */
+
+#include "common/graceful_shutdown.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/warmup.h"
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Self-pipe: the handler only writes a byte, Wait() reads it
+int g_pipe[2] = {-1, -1};
+std::atomic<bool> g_signalled{false};
+
+void HandleSignal(int signal) {
+    if (g_signalled.exchange(true)) {
+        // Second signal: stop draining and die with the default action
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+        return;
+    }
+    int saved_errno = errno;
+    char byte = static_cast<char>(signal);
+    ssize_t written = write(g_pipe[1], &byte, 1);
+    (void)written;
+    errno = saved_errno;
+}
+
+void InstallHandler(int signal, void (*handler)(int)) {
+    struct sigaction action {};
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(signal, &action, nullptr);
+}
+
+long ElapsedMs(std::chrono::steady_clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+
+} // namespace
+
+ShutdownOptions ShutdownOptions::FromEnv() {
+    ShutdownOptions options;
+    options.drain_delay = std::chrono::seconds(
+        EnvInt("SHUTDOWN_DRAIN_DELAY_S", static_cast<long>(options.drain_delay.count())));
+    options.grace = std::chrono::seconds(
+        EnvInt("SHUTDOWN_GRACE_S", static_cast<long>(options.grace.count())));
+    options.close_timeout = std::chrono::seconds(
+        EnvInt("SHUTDOWN_CLOSE_TIMEOUT_S", static_cast<long>(options.close_timeout.count())));
+    return options;
+}
+
+GracefulShutdown::GracefulShutdown(const ShutdownOptions& options) : options_(options) {
+    if (g_pipe[0] != -1) {
+        throw std::logic_error("GracefulShutdown already exists");
+    }
+    if (pipe(g_pipe) != 0) {
+        throw std::runtime_error("Failed to create shutdown pipe");
+    }
+    fcntl(g_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(g_pipe[1], F_SETFD, FD_CLOEXEC);
+    fcntl(g_pipe[1], F_SETFL, O_NONBLOCK);
+
+    g_signalled = false;
+    InstallHandler(SIGTERM, HandleSignal);
+    InstallHandler(SIGINT, HandleSignal);
+}
+
+GracefulShutdown::~GracefulShutdown() {
+    InstallHandler(SIGTERM, SIG_DFL);
+    InstallHandler(SIGINT, SIG_DFL);
+    close(g_pipe[0]);
+    close(g_pipe[1]);
+    g_pipe[0] = g_pipe[1] = -1;
+}
+
+void GracefulShutdown::Add(std::string name, Step step) {
+    steps_.push_back({std::move(name), std::move(step)});
+}
+
+int GracefulShutdown::Wait() {
+    char byte = 0;
+    while (true) {
+        ssize_t n = read(g_pipe[0], &byte, 1);
+        if (n == 1) {
+            break;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        throw std::runtime_error("Failed to wait for a shutdown signal");
+    }
+
+    int signal = static_cast<unsigned char>(byte);
+    LogInfo("Shutdown requested", {{"signal", signal}});
+    return signal;
+}
+
+void GracefulShutdown::RequestShutdown() {
+    if (g_signalled.exchange(true)) {
+        return;
+    }
+    char byte = 0;
+    ssize_t written = write(g_pipe[1], &byte, 1);
+    (void)written;
+}
+
+bool GracefulShutdown::Run(grpc::Server* server, grpc::HealthCheckServiceInterface* health) {
+    auto start = std::chrono::steady_clock::now();
+
+    // Readiness probes fail from here on; liveness must not restart the pod mid-drain
+    if (health) {
+        health->SetServingStatus(false);
+        health->SetServingStatus(Warmup::LIVENESS_SERVICE, true);
+    }
+    if (options_.drain_delay.count() > 0) {
+        std::this_thread::sleep_for(options_.drain_delay);
+    }
+
+    if (server) {
+        auto deadline = std::chrono::system_clock::now() + options_.grace;
+        server->Shutdown(deadline);
+        LogInfo("Server drained", {{"duration_ms", ElapsedMs(start)}});
+    }
+
+    bool ok = true;
+    for (const auto& entry : steps_) {
+        auto step_start = std::chrono::steady_clock::now();
+        try {
+            entry.step();
+            LogInfo("Shutdown step done", {{"step", entry.name}, {"duration_ms", ElapsedMs(step_start)}});
+        } catch (const std::exception& e) {
+            ok = false;
+            LogError("Shutdown step failed", {{"step", entry.name}, {"error", e.what()}});
+        }
+    }
+
+    LogInfo("Shutdown complete", {{"ok", ok}, {"duration_ms", ElapsedMs(start)}});
+    return ok;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,123 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Time-ordered UUIDv7 / ULID identifiers for inserted rows implementation
+ */
+
+#include "common/id_generator.h"
+#include <chrono>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr uint32_t COUNTER_MAX = 0xfff;     // 12 bits (rand_a)
+constexpr uint32_t COUNTER_START = 0x7ff;   // Random start leaves at least 2048 ids per millisecond
+
+struct GeneratorState {
+    std::mt19937_64 random{std::random_device{}() ^
+                           static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()))};
+    int64_t last_ms = -1;
+    uint32_t counter = 0;
+};
+
+int64_t NowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+IdGenerator::Bytes IdGenerator::Next() {
+    thread_local GeneratorState state;
+
+    // A clock stepped back keeps the last millisecond, so ids never decrease
+    int64_t now = NowMillis();
+    if (now > state.last_ms) {
+        state.last_ms = now;
+        state.counter = static_cast<uint32_t>(state.random() & COUNTER_START);
+    } else if (++state.counter > COUNTER_MAX) {
+        ++state.last_ms;
+        state.counter = static_cast<uint32_t>(state.random() & COUNTER_START);
+    }
+
+    uint64_t ms = static_cast<uint64_t>(state.last_ms);
+    uint64_t tail = state.random();
+
+    Bytes id;
+    for (int i = 0; i < 6; ++i) {
+        id[i] = static_cast<uint8_t>(ms >> (40 - 8 * i));
+    }
+    id[6] = static_cast<uint8_t>(0x70 | (state.counter >> 8));
+    id[7] = static_cast<uint8_t>(state.counter);
+    id[8] = static_cast<uint8_t>(0x80 | ((tail >> 56) & 0x3f));
+    for (int i = 9; i < 16; ++i) {
+        id[i] = static_cast<uint8_t>(tail >> (8 * (15 - i)));
+    }
+    return id;
+}
+
+std::string IdGenerator::NewUuid() {
+    return ToUuid(Next());
+}
+
+std::string IdGenerator::NewUlid(std::string_view prefix) {
+    if (prefix.empty()) {
+        return ToUlid(Next());
+    }
+    std::string id;
+    id.reserve(prefix.size() + 27);
+    id.append(prefix).push_back('_');
+    id.append(ToUlid(Next()));
+    return id;
+}
+
+std::string IdGenerator::ToUuid(const Bytes& id) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    std::string out(36, '-');
+    size_t pos = 0;
+    for (size_t i = 0; i < id.size(); ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            ++pos;
+        }
+        out[pos++] = HEX[id[i] >> 4];
+        out[pos++] = HEX[id[i] & 0xf];
+    }
+    return out;
+}
+
+std::string IdGenerator::ToUlid(const Bytes& id) {
+    static constexpr char CROCKFORD[] = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+    uint64_t high = 0;
+    uint64_t low = 0;
+    for (int i = 0; i < 8; ++i) {
+        high = (high << 8) | id[i];
+        low = (low << 8) | id[8 + i];
+    }
+
+    // 128 bits as 26 five-bit digits, most significant first (the first holds 3 bits)
+    std::string out(26, '0');
+    for (int i = 25; i >= 0; --i) {
+        out[i] = CROCKFORD[low & 0x1f];
+        low = (low >> 5) | (high << 59);
+        high >>= 5;
+    }
+    return out;
+}
+
+int64_t IdGenerator::UnixMillis(const Bytes& id) {
+    uint64_t ms = 0;
+    for (int i = 0; i < 6; ++i) {
+        ms = (ms << 8) | id[i];
+    }
+    return static_cast<int64_t>(ms);
+}
+
+} // namespace common
+} // namespace saasforge
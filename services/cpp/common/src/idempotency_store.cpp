@@ -0,0 +1,289 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Idempotency store implementation
+ */
+
+#include "common/idempotency_store.h"
+#include "common/codec.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <cstdlib>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <openssl/evp.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr const char* KEY_PREFIX = "idempotency:";
+
+// Stored values: "P|<token>|<fingerprint>" while in flight,
+// "D|<fingerprint>|<serialized response>" once completed
+constexpr char PENDING = 'P';
+constexpr char DONE = 'D';
+
+// SET NX PX, returning the current value in the same round trip when taken
+const std::string CLAIM_LUA = R"(
+if redis.call('SET', KEYS[1], ARGV[1], 'NX', 'PX', ARGV[2]) then
+    return false
+end
+return redis.call('GET', KEYS[1])
+)";
+
+const std::string COMPLETE_LUA = R"(
+if redis.call('GET', KEYS[1]) == ARGV[1] then
+    redis.call('SET', KEYS[1], ARGV[2], 'PX', ARGV[3])
+    return 1
+end
+return 0
+)";
+
+const std::string RELEASE_LUA = R"(
+if redis.call('GET', KEYS[1]) == ARGV[1] then
+    return redis.call('DEL', KEYS[1])
+end
+return 0
+)";
+
+std::string NewToken() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    static const char* digits = "0123456789abcdef";
+    uint64_t value = rng();
+    std::string token(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        token[i] = digits[value & 0xf];
+        value >>= 4;
+    }
+    return token;
+}
+
+struct StoredValue {
+    char kind = 0;
+    std::string fingerprint;
+    std::string body;   // DONE only
+};
+
+std::optional<StoredValue> Parse(const std::string& value) {
+    if (value.size() < 2 || (value[0] != PENDING && value[0] != DONE) || value[1] != '|') {
+        return std::nullopt;
+    }
+    size_t sep = value.find('|', 2);
+    if (sep == std::string::npos) {
+        return std::nullopt;
+    }
+
+    StoredValue parsed;
+    parsed.kind = value[0];
+    if (parsed.kind == PENDING) {
+        parsed.fingerprint = value.substr(sep + 1);
+    } else {
+        parsed.fingerprint = value.substr(2, sep - 2);
+        parsed.body = value.substr(sep + 1);
+    }
+    return parsed;
+}
+
+} // namespace
+
+IdempotencyOptions IdempotencyOptions::FromEnv() {
+    IdempotencyOptions options;
+    options.ttl = std::chrono::seconds(EnvInt("IDEMPOTENCY_TTL_S", static_cast<long>(options.ttl.count())));
+    options.lease = std::chrono::milliseconds(
+        EnvInt("IDEMPOTENCY_LEASE_MS", static_cast<long>(options.lease.count())));
+    options.wait_timeout = std::chrono::milliseconds(
+        EnvInt("IDEMPOTENCY_WAIT_MS", static_cast<long>(options.wait_timeout.count())));
+    return options;
+}
+
+IdempotencyBackend IdempotencyBackend::Redis(std::shared_ptr<RedisClient> redis) {
+    IdempotencyBackend backend;
+    backend.claim = [redis](const std::string& key, const std::string& value, std::chrono::milliseconds lease) {
+        return redis->EvalScriptString(CLAIM_LUA, {key}, {value, std::to_string(lease.count())});
+    };
+    backend.complete = [redis](const std::string& key, const std::string& expected, const std::string& value,
+                               std::chrono::milliseconds ttl) {
+        std::string ttl_ms = std::to_string(ttl.count());
+        return redis->EvalScript(COMPLETE_LUA, {key}, {expected, value, ttl_ms}) == 1;
+    };
+    backend.release = [redis](const std::string& key, const std::string& expected) {
+        redis->EvalScript(RELEASE_LUA, {key}, {expected});
+    };
+    backend.get = [redis](const std::string& key) {
+        return redis->GetMany({key})[0];
+    };
+    return backend;
+}
+
+IdempotencyStore::IdempotencyStore(std::shared_ptr<RedisClient> redis, const IdempotencyOptions& options)
+    : IdempotencyStore(IdempotencyBackend::Redis(std::move(redis)), options) {}
+
+IdempotencyStore::IdempotencyStore(IdempotencyBackend backend, const IdempotencyOptions& options)
+    : backend_(std::move(backend)), options_(options) {
+    if (options_.poll_interval.count() <= 0) {
+        options_.poll_interval = std::chrono::milliseconds(1);
+    }
+}
+
+IdempotencyOutcome IdempotencyStore::Execute(
+    const std::string& key,
+    const std::string& fingerprint,
+    const Handler& handler
+) {
+    const std::string full_key = KEY_PREFIX + key;
+    for (;;) {
+        bool retry = false;
+        auto outcome = ExecuteOnce(full_key, fingerprint, handler, retry);
+        if (!retry) {
+            return outcome;
+        }
+    }
+}
+
+IdempotencyOutcome IdempotencyStore::ExecuteOnce(
+    const std::string& key,
+    const std::string& fingerprint,
+    const Handler& handler,
+    bool& retry
+) {
+    std::promise<std::optional<std::string>> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = in_flight_.find(key);
+        if (it != in_flight_.end()) {
+            if (it->second.fingerprint != fingerprint) {
+                return {IdempotencyOutcome::Kind::CONFLICT, ""};
+            }
+            auto result = it->second.result;
+            lock.unlock();
+
+            // Rethrows if the owner's attempt threw
+            auto body = result.get();
+            if (body) {
+                return {IdempotencyOutcome::Kind::REPLAYED, *body};
+            }
+            retry = true;
+            return {};
+        }
+        in_flight_.emplace(key, InFlight{fingerprint, promise.get_future().share()});
+    }
+
+    std::optional<std::string> stored;
+    IdempotencyOutcome outcome;
+    std::exception_ptr error;
+    try {
+        outcome = ClaimAndRun(key, fingerprint, handler, retry, stored);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(key);
+    }
+    if (error) {
+        promise.set_exception(error);
+        std::rethrow_exception(error);
+    }
+    promise.set_value(stored);
+    return outcome;
+}
+
+IdempotencyOutcome IdempotencyStore::ClaimAndRun(
+    const std::string& key,
+    const std::string& fingerprint,
+    const Handler& handler,
+    bool& retry,
+    std::optional<std::string>& stored
+) {
+    const std::string claim = std::string(1, PENDING) + "|" + NewToken() + "|" + fingerprint;
+
+    auto existing = backend_.claim(key, claim, options_.lease);
+    if (existing) {
+        return Resolve(key, fingerprint, *existing, retry, stored);
+    }
+
+    std::optional<std::string> body;
+    try {
+        body = handler();
+    } catch (...) {
+        try {
+            backend_.release(key, claim);
+        } catch (const std::exception& e) {
+            LogError("Idempotency release failed", {{"key", key}, {"error", e.what()}});
+        }
+        throw;
+    }
+
+    // The request has taken effect either way; storage failures only lose the replay
+    try {
+        if (!body) {
+            backend_.release(key, claim);
+        } else if (!backend_.complete(key, claim, std::string(1, DONE) + "|" + fingerprint + "|" + *body,
+                                      options_.ttl)) {
+            LogWarn("Idempotency claim expired before the request completed", {{"key", key}});
+        }
+    } catch (const std::exception& e) {
+        LogError("Idempotency store failed", {{"key", key}, {"error", e.what()}});
+    }
+
+    stored = std::move(body);
+    return {IdempotencyOutcome::Kind::EXECUTED, ""};
+}
+
+IdempotencyOutcome IdempotencyStore::Resolve(
+    const std::string& key,
+    const std::string& fingerprint,
+    const std::string& value,
+    bool& retry,
+    std::optional<std::string>& stored
+) {
+    auto deadline = std::chrono::steady_clock::now() + options_.wait_timeout;
+    std::optional<std::string> current = value;
+
+    for (;;) {
+        if (!current) {
+            // Owner failed and released the claim, or its lease expired
+            retry = true;
+            return {};
+        }
+
+        auto parsed = Parse(*current);
+        if (!parsed || parsed->fingerprint != fingerprint) {
+            return {IdempotencyOutcome::Kind::CONFLICT, ""};
+        }
+        if (parsed->kind == DONE) {
+            stored = parsed->body;
+            return {IdempotencyOutcome::Kind::REPLAYED, std::move(parsed->body)};
+        }
+
+        // In flight on another instance
+        if (std::chrono::steady_clock::now() + options_.poll_interval > deadline) {
+            return {IdempotencyOutcome::Kind::IN_PROGRESS, ""};
+        }
+        std::this_thread::sleep_for(options_.poll_interval);
+        current = backend_.get(key);
+    }
+}
+
+std::string IdempotencyStore::Fingerprint(std::string_view request) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (EVP_Digest(request.data(), request.size(), digest, &length, EVP_sha256(), nullptr) != 1) {
+        throw std::runtime_error("SHA-256 digest failed");
+    }
+
+    return HexEncode(digest, length);
+}
+
+size_t IdempotencyStore::InFlightCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_flight_.size();
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,219 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description JWT key ids and key set documents (JWKS or PEM bundles) implementation
+ */
+
+#include "common/jwt_keys.h"
+#include "common/codec.h"
+#include "common/jwt_signer.h"
+#include "common/logger.h"
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/sha.h>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr std::string_view PEM_BEGIN = "-----BEGIN PUBLIC KEY-----";
+constexpr std::string_view PEM_END = "-----END PUBLIC KEY-----";
+
+/// Public members of a JWK, base64url without padding
+struct Jwk {
+    std::string kty;
+    std::string crv;
+    std::string n, e;   // RSA
+    std::string x, y;   // EC (x, y) and OKP (x)
+};
+
+std::string Base64Url(const unsigned char* data, size_t size) {
+    return Base64Encode(data, size, Base64Alphabet::URL_SAFE, false);
+}
+
+std::string BignumParam(EVP_PKEY* key, const char* name, int pad_to = 0) {
+    BIGNUM* value = nullptr;
+    if (EVP_PKEY_get_bn_param(key, name, &value) != 1) {
+        throw std::invalid_argument(std::string("JWT key has no ") + name + " parameter");
+    }
+    std::vector<unsigned char> bytes(pad_to > 0 ? pad_to : BN_num_bytes(value));
+    BN_bn2binpad(value, bytes.data(), static_cast<int>(bytes.size()));
+    BN_free(value);
+    return Base64Url(bytes.data(), bytes.size());
+}
+
+Jwk ToJwk(const std::string& key_pem) {
+    JwtAlgorithm algorithm = JwtAlgorithmForKey(key_pem);
+    auto key = key_pem.find("PRIVATE KEY") != std::string::npos
+        ? jwt::helper::load_private_key_from_string(key_pem)
+        : jwt::helper::load_public_key_from_string(key_pem);
+
+    Jwk jwk;
+    switch (algorithm) {
+        case JwtAlgorithm::RS256:
+            jwk.kty = "RSA";
+            jwk.n = BignumParam(key.get(), OSSL_PKEY_PARAM_RSA_N);
+            jwk.e = BignumParam(key.get(), OSSL_PKEY_PARAM_RSA_E);
+            break;
+        case JwtAlgorithm::ES256:
+            jwk.kty = "EC";
+            jwk.crv = "P-256";
+            jwk.x = BignumParam(key.get(), OSSL_PKEY_PARAM_EC_PUB_X, 32);
+            jwk.y = BignumParam(key.get(), OSSL_PKEY_PARAM_EC_PUB_Y, 32);
+            break;
+        case JwtAlgorithm::EDDSA: {
+            jwk.kty = "OKP";
+            jwk.crv = "Ed25519";
+            unsigned char raw[32];
+            size_t size = sizeof(raw);
+            if (EVP_PKEY_get_raw_public_key(key.get(), raw, &size) != 1) {
+                throw std::invalid_argument("Unreadable Ed25519 public key");
+            }
+            jwk.x = Base64Url(raw, size);
+            break;
+        }
+    }
+    return jwk;
+}
+
+/// RFC 7638: required members only, in lexicographic order, no whitespace
+std::string Thumbprint(const Jwk& jwk) {
+    std::string canonical;
+    if (jwk.kty == "RSA") {
+        canonical = "{\"e\":\"" + jwk.e + "\",\"kty\":\"RSA\",\"n\":\"" + jwk.n + "\"}";
+    } else if (jwk.kty == "EC") {
+        canonical = "{\"crv\":\"" + jwk.crv + "\",\"kty\":\"EC\",\"x\":\"" + jwk.x + "\",\"y\":\"" + jwk.y + "\"}";
+    } else {
+        canonical = "{\"crv\":\"" + jwk.crv + "\",\"kty\":\"OKP\",\"x\":\"" + jwk.x + "\"}";
+    }
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(canonical.data()), canonical.size(), digest);
+    return Base64Url(digest, sizeof(digest));
+}
+
+std::string Ed25519Pem(const std::string& x) {
+    auto raw = Base64Decode(x, Base64Alphabet::URL_SAFE);
+    if (!raw || raw->size() != 32) {
+        throw std::invalid_argument("Invalid Ed25519 JWK");
+    }
+    EVP_PKEY* key = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, raw->data(), raw->size());
+    if (!key) {
+        throw std::invalid_argument("Invalid Ed25519 JWK");
+    }
+    BIO* bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PUBKEY(bio, key);
+    EVP_PKEY_free(key);
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    std::string pem(data, static_cast<size_t>(len));
+    BIO_free(bio);
+    return pem;
+}
+
+std::string JwkPem(const jwt::jwk<jwt::traits::kazuho_picojson>& jwk) {
+    std::string kty = jwk.get_key_type();
+    if (kty == "RSA") {
+        return jwt::helper::create_public_key_from_rsa_components(
+            jwk.get_jwk_claim("n").as_string(), jwk.get_jwk_claim("e").as_string());
+    }
+    if (kty == "EC" && jwk.get_curve() == "P-256") {
+        return jwt::helper::create_public_key_from_ec_components(
+            "P-256", jwk.get_jwk_claim("x").as_string(), jwk.get_jwk_claim("y").as_string());
+    }
+    if (kty == "OKP" && jwk.get_curve() == "Ed25519") {
+        return Ed25519Pem(jwk.get_jwk_claim("x").as_string());
+    }
+    return "";
+}
+
+std::vector<JwtPublicKey> ParseJwks(const std::string& document) {
+    jwt::jwks<jwt::traits::kazuho_picojson> jwks;
+    try {
+        jwks = jwt::parse_jwks(document);
+    } catch (const std::exception& e) {
+        throw std::invalid_argument(std::string("Invalid JWKS document: ") + e.what());
+    }
+
+    std::vector<JwtPublicKey> keys;
+    for (const auto& jwk : jwks) {
+        std::string kid = jwk.has_key_id() ? jwk.get_key_id() : "";
+        if (jwk.has_use() && jwk.get_use() != "sig") {
+            continue;
+        }
+        try {
+            std::string pem = JwkPem(jwk);
+            if (pem.empty()) {
+                LogWarn("Skipping JWK of an unsupported type", {{"kid", kid}, {"kty", jwk.get_key_type()}});
+                continue;
+            }
+            keys.push_back({kid.empty() ? JwtKeyId(pem) : kid, std::move(pem)});
+        } catch (const std::exception& e) {
+            LogWarn("Skipping unreadable JWK", {{"kid", kid}, {"error", e.what()}});
+        }
+    }
+    return keys;
+}
+
+std::vector<JwtPublicKey> ParsePemBundle(const std::string& document) {
+    std::vector<JwtPublicKey> keys;
+    size_t begin = document.find(PEM_BEGIN);
+    while (begin != std::string::npos) {
+        size_t end = document.find(PEM_END, begin);
+        if (end == std::string::npos) {
+            throw std::invalid_argument("Truncated PEM public key");
+        }
+        end += PEM_END.size();
+        std::string pem = document.substr(begin, end - begin) + "\n";
+        keys.push_back({JwtKeyId(pem), pem});
+        begin = document.find(PEM_BEGIN, end);
+    }
+    if (keys.empty()) {
+        throw std::invalid_argument("No PEM public keys in the key set document");
+    }
+    return keys;
+}
+
+} // namespace
+
+std::string JwtKeyId(const std::string& key_pem) {
+    return Thumbprint(ToJwk(key_pem));
+}
+
+std::string JwksFromKeys(const std::vector<std::string>& key_pems) {
+    std::string out = "{\"keys\":[";
+    for (size_t i = 0; i < key_pems.size(); ++i) {
+        Jwk jwk = ToJwk(key_pems[i]);
+        out += i == 0 ? "{" : ",{";
+        out += "\"kty\":\"" + jwk.kty + "\",\"use\":\"sig\",\"alg\":\"" +
+               JwtAlgorithmName(JwtAlgorithmForKey(key_pems[i])) + "\",\"kid\":\"" + Thumbprint(jwk) + "\"";
+        if (!jwk.crv.empty()) {
+            out += ",\"crv\":\"" + jwk.crv + "\"";
+        }
+        if (jwk.kty == "RSA") {
+            out += ",\"n\":\"" + jwk.n + "\",\"e\":\"" + jwk.e + "\"";
+        } else {
+            out += ",\"x\":\"" + jwk.x + "\"";
+            if (!jwk.y.empty()) {
+                out += ",\"y\":\"" + jwk.y + "\"";
+            }
+        }
+        out += "}";
+    }
+    out += "]}";
+    return out;
+}
+
+std::vector<JwtPublicKey> ParseJwtKeys(const std::string& document) {
+    size_t start = document.find_first_not_of(" \t\r\n");
+    if (start != std::string::npos && document[start] == '{') {
+        return ParseJwks(document);
+    }
+    return ParsePemBundle(document);
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,102 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Pre-parsed JWT signing key, swappable on key rotation implementation
+ */
+
+#include "common/jwt_signer.h"
+#include "common/jwt_keys.h"
+#include <openssl/evp.h>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+const char* JwtAlgorithmName(JwtAlgorithm algorithm) {
+    switch (algorithm) {
+        case JwtAlgorithm::RS256: return "RS256";
+        case JwtAlgorithm::ES256: return "ES256";
+        case JwtAlgorithm::EDDSA: return "EdDSA";
+    }
+    return "unknown";
+}
+
+JwtAlgorithm JwtAlgorithmForKey(const std::string& key_pem) {
+    jwt::helper::evp_pkey_handle key;
+    try {
+        key = key_pem.find("PRIVATE KEY") != std::string::npos
+            ? jwt::helper::load_private_key_from_string(key_pem)
+            : jwt::helper::load_public_key_from_string(key_pem);
+    } catch (const std::exception& e) {
+        throw std::invalid_argument(std::string("Unreadable JWT key: ") + e.what());
+    }
+    if (!key) {
+        throw std::invalid_argument("Unreadable JWT key");
+    }
+
+    switch (EVP_PKEY_base_id(key.get())) {
+        case EVP_PKEY_RSA:
+            return JwtAlgorithm::RS256;
+        case EVP_PKEY_EC:
+            if (EVP_PKEY_bits(key.get()) != 256) {
+                throw std::invalid_argument("JWT EC keys must be P-256 (ES256)");
+            }
+            return JwtAlgorithm::ES256;
+        case EVP_PKEY_ED25519:
+            return JwtAlgorithm::EDDSA;
+        default:
+            throw std::invalid_argument("Unsupported JWT key type (use RSA, P-256 or Ed25519)");
+    }
+}
+
+JwtSigner::JwtSigner(const std::string& private_key_pem)
+    : key_(Load(private_key_pem)) {}
+
+void JwtSigner::Rotate(const std::string& private_key_pem) {
+    auto key = Load(private_key_pem);   // Parse outside the lock
+    std::lock_guard<std::mutex> lock(mutex_);
+    key_ = std::move(key);
+}
+
+std::string JwtSigner::Sign(Builder builder) const {
+    auto key = Current();
+    builder.set_key_id(key->kid);
+    return std::visit([&builder](const auto& signer) { return builder.sign(signer); }, key->signer);
+}
+
+JwtAlgorithm JwtSigner::Algorithm() const {
+    return Current()->algorithm;
+}
+
+std::string JwtSigner::KeyId() const {
+    return Current()->kid;
+}
+
+std::shared_ptr<const JwtSigner::Key> JwtSigner::Load(const std::string& private_key_pem) {
+    if (private_key_pem.find("PRIVATE KEY") == std::string::npos) {
+        throw std::invalid_argument("JWT signing key is not a PEM private key");
+    }
+
+    JwtAlgorithm algorithm = JwtAlgorithmForKey(private_key_pem);
+    std::string kid = JwtKeyId(private_key_pem);
+    switch (algorithm) {
+        case JwtAlgorithm::RS256:
+            return std::make_shared<const Key>(Key{algorithm, kid,
+                jwt::algorithm::rs256("", private_key_pem, "", "")});
+        case JwtAlgorithm::ES256:
+            return std::make_shared<const Key>(Key{algorithm, kid,
+                jwt::algorithm::es256("", private_key_pem, "", "")});
+        case JwtAlgorithm::EDDSA:
+            return std::make_shared<const Key>(Key{algorithm, kid,
+                jwt::algorithm::ed25519("", private_key_pem, "", "")});
+    }
+    throw std::invalid_argument("Unsupported JWT key type");
+}
+
+std::shared_ptr<const JwtSigner::Key> JwtSigner::Current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return key_;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -1,22 +1,346 @@
 #include "common/jwt_validator.h"
+#include "common/env.h"
+#include "common/jwt_signer.h"
+#include "common/logger.h"
+#include <curl/curl.h>
+#include <openssl/sha.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
 
 namespace saasforge {
 namespace common {
 
-JwtValidator::JwtValidator(const std::string& public_key_pem, std::shared_ptr<RedisClient> redis_client)
-    : verifier_(jwt::verify()
-        .allow_algorithm(jwt::algorithm::rs256{public_key_pem})
-        .with_issuer("saasforge")),
-      redis_client_(redis_client) {
+namespace {
+
+constexpr long KEYS_FETCH_TIMEOUT_MS = 5000;
+
+// Floor between refreshes triggered by unknown kids, so forged tokens cannot hammer the source
+constexpr auto UNKNOWN_KID_REFRESH_INTERVAL = std::chrono::seconds(10);
+
+// Floor for JWT_KEYS_REFRESH_SEC: the scheduled refresh must not turn into a fetch loop
+constexpr auto MIN_KEYS_REFRESH = std::chrono::seconds(30);
+
+size_t AppendBody(char* data, size_t size, size_t count, void* out) {
+    static_cast<std::string*>(out)->append(data, size * count);
+    return size * count;
+}
+
+} // namespace
+
+JwtValidatorOptions JwtValidatorOptions::FromEnv() {
+    JwtValidatorOptions options;
+    options.keys_source = EnvString("JWT_KEYS_SOURCE", options.keys_source);
+    options.keys_refresh = std::max<std::chrono::seconds>(
+        std::chrono::seconds(EnvInt("JWT_KEYS_REFRESH_SEC", options.keys_refresh.count())), MIN_KEYS_REFRESH);
+    return options;
+}
+
+JwtValidator::JwtValidator(
+    const std::string& public_key_pem,
+    std::shared_ptr<RedisClient> redis_client,
+    JwtValidatorOptions options
+) : redis_client_(redis_client),
+    options_(options) {
+    if (!public_key_pem.empty() || options_.keys_source.empty()) {
+        pinned_keys_.push_back({JwtKeyId(public_key_pem), public_key_pem});
+    }
+    {
+        std::lock_guard<std::mutex> lock(keys_update_mutex_);
+        InstallKeys();
+    }
+    if (!options_.keys_source.empty()) {
+        if (!RefreshKeys() && pinned_keys_.empty()) {
+            throw std::runtime_error("No JWT verification keys from " + options_.keys_source);
+        }
+        keys_thread_ = std::thread(&JwtValidator::KeysLoop, this);
+    }
+
+    if (options_.cache_capacity > 0) {
+        size_t stripes = std::max<size_t>(options_.cache_stripes, 1);
+        max_entries_per_stripe_ = std::max<size_t>(options_.cache_capacity / stripes, 1);
+        cache_stripes_.reserve(stripes);
+        for (size_t i = 0; i < stripes; ++i) {
+            cache_stripes_.push_back(std::make_unique<CacheStripe>());
+        }
+    }
+
+    if (redis_client_ && options_.blacklist_filter) {
+        blacklist_filter_ = std::make_unique<BloomFilter>(
+            options_.blacklist_filter_capacity, options_.blacklist_filter_fp_rate);
+
+        // Each (re)subscribe resyncs from a full SCAN, since messages may have been missed
+        blacklist_subscription_ = redis_client_->Subscribe(
+            RedisClient::BLACKLIST_CHANNEL,
+            [this](const std::string& jti) {
+                // Rebuilds only happen here, on the subscriber thread, never on a request path
+                if (AddToBlacklistFilter(jti)) {
+                    RebuildBlacklistFilter();
+                }
+            },
+            [this]() { RebuildBlacklistFilter(); }
+        );
+    }
+
+    if (options_.tenant_revocations) {
+        revocations_ = std::make_shared<TenantRevocations>(redis_client_);
+    }
+}
+
+JwtValidator::~JwtValidator() {
+    if (keys_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(keys_mutex_);
+            keys_stop_ = true;
+        }
+        keys_cv_.notify_all();
+        keys_thread_.join();
+    }
+    if (blacklist_subscription_ != 0) {
+        redis_client_->Unsubscribe(blacklist_subscription_);
+    }
+}
+
+std::optional<TokenClaims> JwtValidator::Validate(std::string_view token) {
+    try {
+        int64_t now = static_cast<int64_t>(std::time(nullptr));
+        std::string cache_key;
+        std::optional<TokenClaims> claims;
+
+        if (!cache_stripes_.empty()) {
+            cache_key = TokenCacheKey(token);
+            claims = GetCached(cache_key, now);
+        }
+
+        if (!claims) {
+            claims = VerifyAndDecode(std::string(token));   // jwt-cpp wants a std::string; cache hits skip it
+            if (!claims) {
+                return std::nullopt;
+            }
+            if (!cache_stripes_.empty()) {
+                PutCached(cache_key, *claims, now);
+            }
+        }
+
+        // Blacklist is checked on every call; cached claims never bypass revocation
+        if (IsBlacklisted(claims->jti)) {
+            if (!cache_stripes_.empty()) {
+                EvictCached(cache_key);
+            }
+            return std::nullopt;
+        }
+
+        // A tenant-wide revocation covers every token minted up to it
+        if (revocations_ && revocations_->IsRevoked(claims->tenant_id, claims->iat * 1000)) {
+            if (!cache_stripes_.empty()) {
+                EvictCached(cache_key);
+            }
+            return std::nullopt;
+        }
+
+        return claims;
+
+    } catch (const std::exception& e) {
+        // Invalid token
+        return std::nullopt;
+    }
+}
+
+std::shared_ptr<const JwtValidator::Verifier> JwtValidator::MakeVerifier(const std::string& public_key_pem) {
+    // Only the key's own algorithm is allowed, so a token cannot pick a weaker one
+    auto verifier = jwt::verify().with_issuer("saasforge");
+    switch (JwtAlgorithmForKey(public_key_pem)) {
+        case JwtAlgorithm::RS256:
+            verifier.allow_algorithm(jwt::algorithm::rs256{public_key_pem});
+            break;
+        case JwtAlgorithm::ES256:
+            verifier.allow_algorithm(jwt::algorithm::es256{public_key_pem});
+            break;
+        case JwtAlgorithm::EDDSA:
+            verifier.allow_algorithm(jwt::algorithm::ed25519{public_key_pem});
+            break;
+    }
+    return std::make_shared<const Verifier>(std::move(verifier));
+}
+
+void JwtValidator::InstallKeys() {
+    // Keys are parsed here, outside keys_mutex_, so validation never waits on a rebuild
+    auto old = CurrentKeys();
+    auto keys = std::make_shared<KeySet>();
+    for (const auto* source : {&pinned_keys_, &source_keys_}) {
+        for (const auto& key : *source) {
+            auto& verifier = keys->by_pem[key.pem];
+            if (!verifier) {
+                if (old) {
+                    auto reused = old->by_pem.find(key.pem);
+                    if (reused != old->by_pem.end()) {
+                        verifier = reused->second;
+                    }
+                }
+                if (!verifier) {
+                    verifier = MakeVerifier(key.pem);
+                }
+                keys->all.push_back(verifier);
+                keys->by_kid.emplace(JwtKeyId(key.pem), verifier);
+            }
+            keys->by_kid.emplace(key.kid, verifier);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(keys_mutex_);
+    keys_ = std::move(keys);
+}
+
+void JwtValidator::RotatePublicKey(const std::string& public_key_pem) {
+    JwtPublicKey key{JwtKeyId(public_key_pem), public_key_pem};   // Throws before anything changes
+    std::lock_guard<std::mutex> lock(keys_update_mutex_);
+    if (!pinned_keys_.empty() && pinned_keys_.front().pem == public_key_pem) {
+        return;
+    }
+    pinned_keys_.insert(pinned_keys_.begin(), std::move(key));
+    pinned_keys_.resize(std::min<size_t>(pinned_keys_.size(), 2));
+    InstallKeys();
+    LogInfo("JWT verification key rotated", {{"kid", pinned_keys_.front().kid}});
+}
+
+bool JwtValidator::RefreshKeys() {
+    std::lock_guard<std::mutex> update_lock(keys_update_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(keys_mutex_);
+        keys_refreshed_at_ = std::chrono::steady_clock::now();
+    }
+
+    std::vector<JwtPublicKey> previous = source_keys_;
+    try {
+        std::string document = FetchKeys(options_.keys_source);
+        if (document == source_document_) {
+            return true;
+        }
+        source_keys_ = ParseJwtKeys(document);
+        InstallKeys();   // Throws on a bad key before swapping: the whole document is rejected
+        source_document_ = std::move(document);
+    } catch (const std::exception& e) {
+        source_keys_ = std::move(previous);
+        LogError("Loading JWT verification keys failed", {{"source", options_.keys_source}, {"error", e.what()}});
+        return false;
+    }
+
+    LogInfo("JWT verification keys loaded", {{"source", options_.keys_source}, {"keys", source_keys_.size()}});
+    return true;
+}
+
+size_t JwtValidator::KeyCount() const {
+    return CurrentKeys()->all.size();
+}
+
+std::shared_ptr<const JwtValidator::KeySet> JwtValidator::CurrentKeys() const {
+    std::lock_guard<std::mutex> lock(keys_mutex_);
+    return keys_;
+}
+
+std::shared_ptr<const JwtValidator::Verifier> JwtValidator::VerifierFor(
+    const jwt::decoded_jwt<jwt::traits::kazuho_picojson>& decoded) {
+    auto keys = CurrentKeys();
+    auto it = keys->by_kid.find(decoded.get_key_id());
+    if (it != keys->by_kid.end()) {
+        return it->second;
+    }
+
+    // Published before the signer switched to it, normally; if not, fetch early
+    if (!options_.keys_source.empty()) {
+        std::lock_guard<std::mutex> lock(keys_mutex_);
+        if (std::chrono::steady_clock::now() - keys_refreshed_at_ >= UNKNOWN_KID_REFRESH_INTERVAL) {
+            keys_refresh_requested_ = true;
+            keys_cv_.notify_all();
+        }
+    }
+    return nullptr;
+}
+
+std::string JwtValidator::FetchKeys(const std::string& source) {
+    if (source.rfind("http://", 0) != 0 && source.rfind("https://", 0) != 0) {
+        std::ifstream file(source);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open " + source);
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    static std::once_flag curl_init_once;
+    std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> easy(curl_easy_init(), &curl_easy_cleanup);
+    if (!easy) {
+        throw std::runtime_error("curl_easy_init failed");
+    }
+
+    std::string body;
+    char error[CURL_ERROR_SIZE] = {};
+    curl_easy_setopt(easy.get(), CURLOPT_URL, source.c_str());
+    curl_easy_setopt(easy.get(), CURLOPT_WRITEFUNCTION, AppendBody);
+    curl_easy_setopt(easy.get(), CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(easy.get(), CURLOPT_ERRORBUFFER, error);
+    curl_easy_setopt(easy.get(), CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy.get(), CURLOPT_TIMEOUT_MS, KEYS_FETCH_TIMEOUT_MS);
+
+    CURLcode result = curl_easy_perform(easy.get());
+    long status = 0;
+    curl_easy_getinfo(easy.get(), CURLINFO_RESPONSE_CODE, &status);
+    if (result != CURLE_OK) {
+        throw std::runtime_error(error[0] ? error : curl_easy_strerror(result));
+    }
+    if (status != 200) {
+        throw std::runtime_error("HTTP " + std::to_string(status));
+    }
+    return body;
 }
 
-std::optional<TokenClaims> JwtValidator::Validate(const std::string& token) {
+void JwtValidator::KeysLoop() {
+    std::unique_lock<std::mutex> lock(keys_mutex_);
+    while (!keys_stop_) {
+        keys_cv_.wait_for(lock, options_.keys_refresh, [this] { return keys_stop_ || keys_refresh_requested_; });
+        if (keys_stop_) {
+            break;
+        }
+        keys_refresh_requested_ = false;
+        lock.unlock();
+        RefreshKeys();
+        lock.lock();
+    }
+}
+
+std::optional<TokenClaims> JwtValidator::VerifyAndDecode(const std::string& token) {
     try {
         auto decoded = jwt::decode(token);
 
-        // Verify signature and claims
-        verifier_.verify(decoded);
+        // Verify signature and claims against the key the token names
+        if (decoded.has_key_id()) {
+            auto verifier = VerifierFor(decoded);
+            if (!verifier) {
+                return std::nullopt;
+            }
+            verifier->verify(decoded);
+        } else {
+            // Minted before tokens carried a kid: any current key may have signed it
+            auto keys = CurrentKeys();
+            bool verified = false;
+            for (const auto& verifier : keys->all) {
+                std::error_code ec;
+                verifier->verify(decoded, ec);
+                if (!ec) {
+                    verified = true;
+                    break;
+                }
+            }
+            if (!verified) {
+                return std::nullopt;
+            }
+        }
 
         // Extract claims
         TokenClaims claims;
@@ -24,8 +348,10 @@ std::optional<TokenClaims> JwtValidator::Validate(const std::string& token) {
         claims.tenant_id = decoded.get_payload_claim("tenant_id").as_string();
         claims.email = decoded.get_payload_claim("email").as_string();
         claims.jti = decoded.get_id();
-        claims.exp = decoded.get_expires_at().time_since_epoch().count();
-        claims.iat = decoded.get_issued_at().time_since_epoch().count();
+        claims.exp = std::chrono::duration_cast<std::chrono::seconds>(
+            decoded.get_expires_at().time_since_epoch()).count();
+        claims.iat = std::chrono::duration_cast<std::chrono::seconds>(
+            decoded.get_issued_at().time_since_epoch()).count();
 
         // Extract roles array if present (optional field)
         try {
@@ -45,11 +371,6 @@ std::optional<TokenClaims> JwtValidator::Validate(const std::string& token) {
             // Roles claim is optional, ignore parse errors
         }
 
-        // Check blacklist
-        if (IsBlacklisted(claims.jti)) {
-            return std::nullopt;
-        }
-
         return claims;
 
     } catch (const std::exception& e) {
@@ -62,8 +383,140 @@ bool JwtValidator::IsBlacklisted(const std::string& jti) {
     if (!redis_client_) {
         return false; // If no Redis client, skip blacklist check
     }
+
+    if (blacklist_filter_) {
+        std::shared_lock<std::shared_mutex> lock(blacklist_mutex_);
+        if (blacklist_synced_ && !blacklist_filter_->MightContain(jti)) {
+            return false; // Definitely not blacklisted
+        }
+    }
+
+    // Possible match (or filter not synced yet): Redis is authoritative
     return redis_client_->IsTokenBlacklisted(jti);
 }
 
+void JwtValidator::NoteBlacklisted(const std::string& jti) {
+    if (blacklist_filter_) {
+        AddToBlacklistFilter(jti);
+    }
+}
+
+size_t JwtValidator::CacheSize() const {
+    size_t total = 0;
+    for (const auto& stripe : cache_stripes_) {
+        std::lock_guard<std::mutex> lock(stripe->mutex);
+        total += stripe->entries.size();
+    }
+    return total;
+}
+
+std::string JwtValidator::TokenCacheKey(std::string_view token) {
+    // Cryptographic digest: a collision must never map one token to another's claims
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(token.data()), token.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+JwtValidator::CacheStripe& JwtValidator::StripeFor(const std::string& cache_key) {
+    // Key is already uniformly distributed
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefix) && i < cache_key.size(); ++i) {
+        prefix = (prefix << 8) | static_cast<unsigned char>(cache_key[i]);
+    }
+    return *cache_stripes_[prefix % cache_stripes_.size()];
+}
+
+std::optional<TokenClaims> JwtValidator::GetCached(const std::string& cache_key, int64_t now) {
+    auto& stripe = StripeFor(cache_key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+
+    auto it = stripe.entries.find(cache_key);
+    if (it == stripe.entries.end()) {
+        return std::nullopt;
+    }
+    if (it->second.exp <= now) {
+        stripe.entries.erase(it);
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void JwtValidator::PutCached(const std::string& cache_key, const TokenClaims& claims, int64_t now) {
+    if (claims.exp <= now) {
+        return;
+    }
+
+    auto& stripe = StripeFor(cache_key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+
+    if (stripe.entries.size() >= max_entries_per_stripe_) {
+        // Drop expired entries first; if none, drop an arbitrary one
+        for (auto it = stripe.entries.begin(); it != stripe.entries.end();) {
+            it = it->second.exp <= now ? stripe.entries.erase(it) : std::next(it);
+        }
+        if (stripe.entries.size() >= max_entries_per_stripe_) {
+            stripe.entries.erase(stripe.entries.begin());
+        }
+    }
+
+    stripe.entries[cache_key] = claims;
+}
+
+void JwtValidator::EvictCached(const std::string& cache_key) {
+    auto& stripe = StripeFor(cache_key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.entries.erase(cache_key);
+}
+
+void JwtValidator::RebuildBlacklistFilter() {
+    {
+        std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+        if (blacklist_rebuilding_) {
+            return; // A rebuild in progress already covers new arrivals
+        }
+        blacklist_rebuilding_ = true;
+        blacklist_pending_.clear();
+    }
+
+    std::vector<std::string> jtis;
+    try {
+        jtis = redis_client_->ScanBlacklistedTokens();
+    } catch (const std::exception& e) {
+        // Stay unsynced: every check falls back to Redis until the next resubscribe
+        LogError("Blacklist filter rebuild failed", {{"error", e.what()}});
+        std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+        blacklist_rebuilding_ = false;
+        blacklist_synced_ = false;
+        return;
+    }
+
+    size_t capacity = std::max(options_.blacklist_filter_capacity, jtis.size() * 2);
+    auto filter = std::make_unique<BloomFilter>(capacity, options_.blacklist_filter_fp_rate);
+    for (const auto& jti : jtis) {
+        filter->Add(jti);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+    for (const auto& jti : blacklist_pending_) {
+        filter->Add(jti);
+    }
+    blacklist_pending_.clear();
+    blacklist_filter_ = std::move(filter);
+    blacklist_rebuilding_ = false;
+    blacklist_synced_ = true;
+}
+
+bool JwtValidator::AddToBlacklistFilter(const std::string& jti) {
+    std::unique_lock<std::shared_mutex> lock(blacklist_mutex_);
+    blacklist_filter_->Add(jti);
+    if (blacklist_rebuilding_) {
+        blacklist_pending_.push_back(jti);
+    }
+
+    // Entries are never removed, so expired JTIs accumulate; a rebuild from
+    // the live keys in Redis restores the target false positive rate.
+    return blacklist_synced_ && blacklist_filter_->Saturated();
+}
+
 } // namespace common
 } // namespace saasforge
@@ -0,0 +1,383 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Leveled, structured logging with per-thread buffers and a background writer
+ */
+
+#include "common/logger.h"
+#include "common/env.h"
+#include "common/string_builder.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iterator>
+#include <unistd.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+std::atomic<uint64_t> next_logger_id{1};
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+void WriteStdout(std::string_view data) {
+    while (!data.empty()) {
+        ssize_t written = ::write(STDOUT_FILENO, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // Nowhere left to report it
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+}
+
+void AppendText(std::string& out, std::string_view value) {
+    bool plain = !value.empty() && std::none_of(value.begin(), value.end(), [](char c) {
+        return c == ' ' || c == '"' || c == '=' || static_cast<unsigned char>(c) < 0x20;
+    });
+    if (plain) {
+        out.append(value);
+    } else {
+        AppendJsonString(out, value);
+    }
+}
+
+void AppendTimestamp(std::string& out) {
+    auto now = std::chrono::system_clock::now();
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    char buffer[32];
+    size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    out.append(buffer, length);
+    char fraction[8];
+    std::snprintf(fraction, sizeof(fraction), ".%03dZ", static_cast<int>(millis));
+    out.append(fraction);
+}
+
+} // namespace
+
+/**
+ * Bounded single-producer/single-consumer queue of formatted records
+ *
+ * The owning thread pushes; Logger::Drain() (serialized by drain_mutex_)
+ * pops. closed is set when the owning thread exits, after which the ring
+ * is removed once empty.
+ */
+class Logger::Ring {
+public:
+    explicit Ring(size_t capacity) : slots_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2))),
+                                     mask_(slots_.size() - 1) {}
+
+    bool Push(std::string&& record) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+            return false;
+        }
+        slots_[head & mask_] = std::move(record);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t DrainInto(std::string& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        for (size_t i = tail; i != head; ++i) {
+            out += slots_[i & mask_];
+        }
+        tail_.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    size_t Size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const { return slots_.size(); }
+
+    std::atomic<bool> closed{false};
+
+private:
+    std::vector<std::string> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+LoggerOptions LoggerOptions::FromEnv() {
+    LoggerOptions options;
+
+    std::string level = EnvString("LOG_LEVEL");
+    std::transform(level.begin(), level.end(), level.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (level == "debug") {
+        options.level = LogLevel::kDebug;
+    } else if (level == "warn" || level == "warning") {
+        options.level = LogLevel::kWarn;
+    } else if (level == "error") {
+        options.level = LogLevel::kError;
+    }
+
+    options.json = EnvString("LOG_FORMAT") != "text";
+    options.rate_limit_per_s = static_cast<uint32_t>(
+        EnvInt("LOG_RATE_LIMIT_PER_S", static_cast<long>(options.rate_limit_per_s)));
+    options.flush_interval = std::chrono::milliseconds(
+        std::max<long>(EnvInt("LOG_FLUSH_INTERVAL_MS", static_cast<long>(options.flush_interval.count())), 1));
+    return options;
+}
+
+Logger::Logger(const LoggerOptions& options) : Logger(options, WriteStdout) {}
+
+Logger::Logger(const LoggerOptions& options, Sink sink)
+    : options_(options),
+      sink_(std::move(sink)),
+      id_(next_logger_id.fetch_add(1, std::memory_order_relaxed)),
+      level_(static_cast<int>(options.level)) {
+    writer_ = std::thread(&Logger::WriterLoop, this);
+}
+
+Logger::~Logger() {
+    Shutdown();
+}
+
+Logger& Logger::Global() {
+    // Never destroyed, so objects logging from their own destructors at exit stay safe
+    static Logger* logger = [] {
+        auto* instance = new Logger(LoggerOptions::FromEnv());
+        std::atexit([] { Logger::Global().Flush(); });
+        return instance;
+    }();
+    return *logger;
+}
+
+std::string_view Logger::LevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::kDebug: return "debug";
+        case LogLevel::kInfo: return "info";
+        case LogLevel::kWarn: return "warn";
+        case LogLevel::kError: return "error";
+    }
+    return "info";
+}
+
+void Logger::Log(LogLevel level, std::string_view message, std::initializer_list<LogField> fields) {
+    if (!Enabled(level)) {
+        return;
+    }
+
+    uint32_t suppressed = 0;
+    if (!Admit(message, &suppressed)) {
+        return;
+    }
+
+    std::string record = Format(level, message, fields, suppressed);
+
+    if (shutdown_.load(std::memory_order_acquire)) {
+        // No writer any more: write through
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        sink_(record);
+        written_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Ring& ring = ThreadRing();
+    bool pushed = ring.Push(std::move(record));
+    if (!pushed) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!pushed || level == LogLevel::kError || ring.Size() >= ring.Capacity() / 2) {
+        wake_requested_.store(true, std::memory_order_release);
+        wake_cv_.notify_one();
+    }
+}
+
+bool Logger::Admit(std::string_view message, uint32_t* suppressed) {
+    if (options_.rate_limit_per_s == 0) {
+        return true;
+    }
+
+    RateSlot& slot = rate_slots_[std::hash<std::string_view>{}(message) % RATE_SLOTS];
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    int64_t window = slot.window.load(std::memory_order_relaxed);
+    if (window != now && slot.window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+        slot.count.store(0, std::memory_order_relaxed);
+    }
+
+    if (slot.count.fetch_add(1, std::memory_order_relaxed) >= options_.rate_limit_per_s) {
+        slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    *suppressed = slot.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+std::string Logger::Format(LogLevel level, std::string_view message, std::initializer_list<LogField> fields,
+                           uint32_t suppressed) const {
+    std::string out;
+    out.reserve(96 + message.size() + fields.size() * 32);
+
+    if (options_.json) {
+        out += "{\"ts\":\"";
+        AppendTimestamp(out);
+        out += "\",\"level\":\"";
+        out += LevelName(level);
+        out += "\",\"msg\":";
+        AppendJsonString(out, message);
+        for (const auto& field : fields) {
+            out.push_back(',');
+            AppendJsonString(out, field.Key());
+            out.push_back(':');
+            if (field.Quoted()) {
+                AppendJsonString(out, field.Value());
+            } else {
+                out += field.Value();
+            }
+        }
+        if (suppressed > 0) {
+            out += ",\"suppressed\":";
+            out += std::to_string(suppressed);
+        }
+        out += "}\n";
+        return out;
+    }
+
+    AppendTimestamp(out);
+    out.push_back(' ');
+    std::string_view name = LevelName(level);
+    std::transform(name.begin(), name.end(), std::back_inserter(out), [](unsigned char c) { return std::toupper(c); });
+    out.push_back(' ');
+    out.append(message);
+    for (const auto& field : fields) {
+        out.push_back(' ');
+        out.append(field.Key());
+        out.push_back('=');
+        AppendText(out, field.Value());
+    }
+    if (suppressed > 0) {
+        out += " suppressed=" + std::to_string(suppressed);
+    }
+    out.push_back('\n');
+    return out;
+}
+
+Logger::Ring& Logger::ThreadRing() {
+    // One ring per (thread, logger); rings outlive their thread until drained
+    struct Holder {
+        std::vector<std::pair<uint64_t, std::shared_ptr<Ring>>> rings;
+        ~Holder() {
+            for (auto& entry : rings) {
+                entry.second->closed.store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local Holder holder;
+
+    for (auto& entry : holder.rings) {
+        if (entry.first == id_) {
+            return *entry.second;
+        }
+    }
+
+    auto ring = std::make_shared<Ring>(options_.ring_capacity);
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+    holder.rings.emplace_back(id_, ring);
+    return *ring;
+}
+
+void Logger::Flush() {
+    Drain();
+}
+
+void Logger::Drain() {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    uint64_t records = 0;
+    for (const auto& ring : rings) {
+        records += ring->DrainInto(buffer_);
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != dropped_reported_) {
+        buffer_ += Format(LogLevel::kWarn, "Log records dropped, thread buffer full",
+                          {{"count", dropped - dropped_reported_}}, 0);
+        dropped_reported_ = dropped;
+        ++records;
+    }
+
+    if (!buffer_.empty()) {
+        sink_(buffer_);
+        buffer_.clear();
+        written_.fetch_add(records, std::memory_order_relaxed);
+    }
+
+    // Rings of exited threads are gone once empty
+    std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring>& ring) {
+        return ring->closed.load(std::memory_order_acquire) && ring->Size() == 0;
+    }), rings_.end());
+}
+
+void Logger::WriterLoop() {
+    while (!shutdown_.load(std::memory_order_acquire)) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait_for(lock, options_.flush_interval, [this] {
+                return shutdown_.load(std::memory_order_acquire) ||
+                       wake_requested_.load(std::memory_order_acquire);
+            });
+            wake_requested_.store(false, std::memory_order_relaxed);
+        }
+        Drain();
+    }
+}
+
+void Logger::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        if (shutdown_.exchange(true)) {
+            return;
+        }
+    }
+    wake_cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    Drain();
+}
+
+LoggerStats Logger::GetStats() const {
+    LoggerStats stats;
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.suppressed = suppressed_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace common
+} // namespace saasforge
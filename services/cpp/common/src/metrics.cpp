@@ -0,0 +1,324 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Counters, gauges and histograms exported in the Prometheus text format
+ */
+
+#include "common/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace metrics_detail {
+
+size_t ThreadShard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return shard;
+}
+
+} // namespace metrics_detail
+
+namespace {
+
+std::string FormatValue(double value) {
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.12g", value);
+    return buffer;
+}
+
+void AppendEscaped(std::string& out, const std::string& value, bool quote) {
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '"':
+                out += quote ? "\\\"" : "\"";
+                break;
+            default: out.push_back(c);
+        }
+    }
+}
+
+void AppendSample(std::string& out, const std::string& name, const MetricLabels& labels,
+                  const char* extra_key, const std::string& extra_value, const std::string& value) {
+    out += name;
+    if (!labels.empty() || extra_key) {
+        out.push_back('{');
+        bool first = true;
+        for (const auto& [key, label_value] : labels) {
+            if (!first) {
+                out.push_back(',');
+            }
+            first = false;
+            out += key;
+            out += "=\"";
+            AppendEscaped(out, label_value, true);
+            out.push_back('"');
+        }
+        if (extra_key) {
+            if (!first) {
+                out.push_back(',');
+            }
+            out += extra_key;
+            out += "=\"";
+            out += extra_value;
+            out.push_back('"');
+        }
+        out.push_back('}');
+    }
+    out.push_back(' ');
+    out += value;
+    out.push_back('\n');
+}
+
+} // namespace
+
+uint64_t Counter::Value() const {
+    uint64_t total = 0;
+    for (const auto& cell : cells_) {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+HistogramOptions HistogramOptions::LatencySeconds() {
+    HistogramOptions options;
+    options.bounds = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                      0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+    options.unit = 1e-6;
+    return options;
+}
+
+HistogramOptions HistogramOptions::SizeBytes() {
+    HistogramOptions options;
+    for (double bound = 64; bound <= 64.0 * 1024 * 1024; bound *= 4) {
+        options.bounds.push_back(bound);
+    }
+    return options;
+}
+
+uint64_t HistogramSnapshot::ValueAtQuantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return Histogram::BucketUpperBound(i);
+        }
+    }
+    return Histogram::BucketUpperBound(buckets.size() - 1);
+}
+
+Histogram::Histogram(HistogramOptions options)
+    : options_(std::move(options)),
+      shards_(new Shard[metrics_detail::HISTOGRAM_SHARDS]) {}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+    constexpr uint64_t sub_buckets = 1u << SUB_BUCKET_BITS;
+    if (value < sub_buckets) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT) {
+        return NUM_BUCKETS - 1;
+    }
+    uint64_t sub = (value >> (exponent - SUB_BUCKET_BITS)) & (sub_buckets - 1);
+    return static_cast<size_t>(((exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub);
+}
+
+uint64_t Histogram::BucketUpperBound(size_t bucket) {
+    constexpr uint64_t sub_buckets = 1u << SUB_BUCKET_BITS;
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    int exponent = static_cast<int>(bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    uint64_t width = uint64_t{1} << (exponent - SUB_BUCKET_BITS);
+    uint64_t lower = (sub_buckets + (bucket & (sub_buckets - 1))) * width;
+    return lower + width - 1;
+}
+
+void Histogram::Record(uint64_t value) {
+    Shard& shard = shards_[metrics_detail::ThreadShard() % metrics_detail::HISTOGRAM_SHARDS];
+    shard.buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.buckets.assign(NUM_BUCKETS, 0);
+    for (size_t s = 0; s < metrics_detail::HISTOGRAM_SHARDS; ++s) {
+        const Shard& shard = shards_[s];
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    // Count from the buckets so the exported series stay consistent mid-update
+    for (uint64_t bucket : snapshot.buckets) {
+        snapshot.count += bucket;
+    }
+    return snapshot;
+}
+
+MetricsWriter::Family& MetricsWriter::GetFamily(const std::string& name, const std::string& help, const char* type) {
+    auto [it, inserted] = families_.try_emplace(name);
+    if (inserted) {
+        it->second.help = help;
+        it->second.type = type;
+    }
+    return it->second;
+}
+
+void MetricsWriter::AddCounter(const std::string& name, const std::string& help,
+                               const MetricLabels& labels, double value) {
+    AppendSample(GetFamily(name, help, "counter").samples, name, labels, nullptr, "", FormatValue(value));
+}
+
+void MetricsWriter::AddGauge(const std::string& name, const std::string& help,
+                             const MetricLabels& labels, double value) {
+    AppendSample(GetFamily(name, help, "gauge").samples, name, labels, nullptr, "", FormatValue(value));
+}
+
+void MetricsWriter::AddHistogram(const std::string& name, const std::string& help, const MetricLabels& labels,
+                                 const std::vector<double>& bounds, const std::vector<uint64_t>& cumulative,
+                                 uint64_t count, double sum) {
+    std::string& out = GetFamily(name, help, "histogram").samples;
+    for (size_t i = 0; i < bounds.size() && i < cumulative.size(); ++i) {
+        AppendSample(out, name + "_bucket", labels, "le", FormatValue(bounds[i]), FormatValue(cumulative[i]));
+    }
+    AppendSample(out, name + "_bucket", labels, "le", "+Inf", FormatValue(count));
+    AppendSample(out, name + "_sum", labels, nullptr, "", FormatValue(sum));
+    AppendSample(out, name + "_count", labels, nullptr, "", FormatValue(count));
+}
+
+void MetricsWriter::AddHistogram(const std::string& name, const std::string& help, const MetricLabels& labels,
+                                 const HistogramSnapshot& snapshot, const HistogramOptions& options) {
+    std::vector<uint64_t> cumulative;
+    cumulative.reserve(options.bounds.size());
+    uint64_t running = 0;
+    size_t bucket = 0;
+    for (double bound : options.bounds) {
+        // Largest raw value at or below the bound; tolerate 0.0001 / 1e-6 = 99.999...
+        double raw = std::floor(bound / options.unit + 1e-6);
+        while (bucket < snapshot.buckets.size() &&
+               static_cast<double>(Histogram::BucketUpperBound(bucket)) <= raw) {
+            running += snapshot.buckets[bucket++];
+        }
+        cumulative.push_back(running);
+    }
+    AddHistogram(name, help, labels, options.bounds, cumulative, snapshot.count,
+                 static_cast<double>(snapshot.sum) * options.unit);
+}
+
+std::string MetricsWriter::Text() const {
+    std::string out;
+    for (const auto& [name, family] : families_) {
+        out += "# HELP " + name + " ";
+        AppendEscaped(out, family.help, false);
+        out += "\n# TYPE " + name + " " + family.type + "\n";
+        out += family.samples;
+    }
+    return out;
+}
+
+MetricsRegistry& MetricsRegistry::Global() {
+    // Leaked: metrics are recorded from threads that may outlive static destruction
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::GetEntry(Type type, const std::string& name, const std::string& help,
+                                                  const MetricLabels& labels, const HistogramOptions* options) {
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    auto [it, inserted] = metrics_.try_emplace({name, labels});
+    Entry& entry = it->second;
+    if (inserted) {
+        entry.type = type;
+        entry.name = name;
+        entry.help = help;
+        entry.labels = labels;
+        switch (type) {
+            case Type::kCounter: entry.counter = std::make_unique<Counter>(); break;
+            case Type::kGauge: entry.gauge = std::make_unique<Gauge>(); break;
+            case Type::kHistogram: entry.histogram = std::make_unique<Histogram>(*options); break;
+        }
+    } else if (entry.type != type) {
+        throw std::invalid_argument("Metric " + name + " is already registered with another type");
+    }
+    return entry;
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    return *GetEntry(Type::kCounter, name, help, labels, nullptr).counter;
+}
+
+Gauge& MetricsRegistry::GetGauge(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    return *GetEntry(Type::kGauge, name, help, labels, nullptr).gauge;
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name, const std::string& help,
+                                         const HistogramOptions& options, const MetricLabels& labels) {
+    return *GetEntry(Type::kHistogram, name, help, labels, &options).histogram;
+}
+
+uint64_t MetricsRegistry::AddCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(collectors_mutex_);
+    uint64_t id = next_collector_id_++;
+    collectors_.emplace(id, std::move(collector));
+    return id;
+}
+
+void MetricsRegistry::RemoveCollector(uint64_t id) {
+    std::lock_guard<std::mutex> lock(collectors_mutex_);
+    collectors_.erase(id);
+}
+
+std::string MetricsRegistry::Render() const {
+    MetricsWriter writer;
+    {
+        std::lock_guard<std::mutex> lock(collectors_mutex_);
+        for (const auto& [id, collector] : collectors_) {
+            try {
+                collector(writer);
+            } catch (const std::exception&) {
+                // A failing component must not take the whole scrape down
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(metrics_mutex_);
+    for (const auto& [key, entry] : metrics_) {
+        switch (entry.type) {
+            case Type::kCounter:
+                writer.AddCounter(entry.name, entry.help, entry.labels, static_cast<double>(entry.counter->Value()));
+                break;
+            case Type::kGauge:
+                writer.AddGauge(entry.name, entry.help, entry.labels, static_cast<double>(entry.gauge->Value()));
+                break;
+            case Type::kHistogram:
+                writer.AddHistogram(entry.name, entry.help, entry.labels, entry.histogram->Snapshot(),
+                                    entry.histogram->Options());
+                break;
+        }
+    }
+    return writer.Text();
+}
+
+} // namespace common
+} // namespace saasforge
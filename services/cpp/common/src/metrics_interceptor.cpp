@@ -0,0 +1,146 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server interceptor recording per-method latency, status codes and payload sizes
+ */
+
+#include "common/metrics_interceptor.h"
+#include <chrono>
+#include <cstring>
+#include <google/protobuf/message_lite.h>
+#include <grpcpp/grpcpp.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+using grpc::experimental::InterceptionHookPoints;
+
+// Our own services are generated protobuf code; anything else (health
+// checks, reflection) may use other message types
+constexpr const char* PROTOBUF_METHOD_PREFIX = "/saasforge.";
+
+const char* CodeName(int code) {
+    static const char* const names[MetricsInterceptorFactory::NUM_CODES] = {
+        "OK", "CANCELLED", "UNKNOWN", "INVALID_ARGUMENT", "DEADLINE_EXCEEDED", "NOT_FOUND",
+        "ALREADY_EXISTS", "PERMISSION_DENIED", "RESOURCE_EXHAUSTED", "FAILED_PRECONDITION",
+        "ABORTED", "OUT_OF_RANGE", "UNIMPLEMENTED", "INTERNAL", "UNAVAILABLE", "DATA_LOSS",
+        "UNAUTHENTICATED"
+    };
+    return names[code];
+}
+
+class MetricsInterceptor : public grpc::experimental::Interceptor {
+public:
+    explicit MetricsInterceptor(MetricsInterceptorFactory::MethodMetrics& metrics)
+        : metrics_(metrics), start_(std::chrono::steady_clock::now()) {
+        metrics_.in_flight->Add(1);
+    }
+
+    ~MetricsInterceptor() override {
+        // Destroyed without sending a status: the client went away
+        if (!finished_) {
+            Finish(grpc::StatusCode::CANCELLED);
+        }
+    }
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override {
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_MESSAGE) &&
+            metrics_.count_request_bytes) {
+            if (auto* message = static_cast<const google::protobuf::MessageLite*>(methods->GetRecvMessage())) {
+                metrics_.received_bytes->Record(message->ByteSizeLong());
+            }
+        }
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_MESSAGE)) {
+            // Serializes now rather than later; the buffer is what gets sent
+            if (auto* buffer = methods->GetSerializedSendMessage()) {
+                metrics_.sent_bytes->Record(buffer->Length());
+            }
+        }
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_STATUS)) {
+            Finish(methods->GetSendStatus().error_code());
+        }
+        methods->Proceed();
+    }
+
+private:
+    void Finish(grpc::StatusCode code) {
+        finished_ = true;
+        metrics_.latency->RecordDuration(std::chrono::steady_clock::now() - start_);
+        metrics_.Handled(static_cast<int>(code)).Increment();
+        metrics_.in_flight->Add(-1);
+    }
+
+    MetricsInterceptorFactory::MethodMetrics& metrics_;
+    std::chrono::steady_clock::time_point start_;
+    bool finished_ = false;
+};
+
+} // namespace
+
+Counter& MetricsInterceptorFactory::MethodMetrics::Handled(int code) {
+    if (code < 0 || code >= NUM_CODES) {
+        code = static_cast<int>(grpc::StatusCode::UNKNOWN);
+    }
+    Counter* counter = handled[code].load(std::memory_order_acquire);
+    if (!counter) {
+        MetricLabels code_labels = labels;
+        code_labels.emplace_back("grpc_code", CodeName(code));
+        // Racing threads get the same counter back from the registry
+        counter = &registry->GetCounter("saasforge_grpc_server_handled_total",
+                                        "RPCs completed on the server, by status code", code_labels);
+        handled[code].store(counter, std::memory_order_release);
+    }
+    return *counter;
+}
+
+MetricsInterceptorFactory::MetricsInterceptorFactory(MetricsRegistry& registry) : registry_(registry) {}
+
+grpc::experimental::Interceptor* MetricsInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    return new MetricsInterceptor(ForMethod(info->method()));
+}
+
+MetricsInterceptorFactory::MethodMetrics& MetricsInterceptorFactory::ForMethod(const char* method) {
+    std::string name = method ? method : "";
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = methods_.find(name);
+        if (it != methods_.end()) {
+            return *it->second;
+        }
+    }
+
+    // "/package.Service/Method"
+    std::string service = "unknown";
+    std::string rpc = name;
+    size_t slash = name.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        service = name.substr(1, slash - 1);
+        rpc = name.substr(slash + 1);
+    }
+
+    auto metrics = std::make_unique<MethodMetrics>();
+    metrics->registry = &registry_;
+    metrics->labels = {{"grpc_service", service}, {"grpc_method", rpc}};
+    metrics->count_request_bytes = name.compare(0, std::strlen(PROTOBUF_METHOD_PREFIX), PROTOBUF_METHOD_PREFIX) == 0;
+    metrics->latency = &registry_.GetHistogram("saasforge_grpc_server_handling_seconds",
+                                               "Time from receiving an RPC to sending its status",
+                                               HistogramOptions::LatencySeconds(), metrics->labels);
+    metrics->received_bytes = &registry_.GetHistogram("saasforge_grpc_server_msg_received_bytes",
+                                                      "Size of request messages",
+                                                      HistogramOptions::SizeBytes(), metrics->labels);
+    metrics->sent_bytes = &registry_.GetHistogram("saasforge_grpc_server_msg_sent_bytes",
+                                                  "Size of response messages",
+                                                  HistogramOptions::SizeBytes(), metrics->labels);
+    metrics->in_flight = &registry_.GetGauge("saasforge_grpc_server_in_flight",
+                                             "RPCs currently being handled", metrics->labels);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto [it, inserted] = methods_.emplace(name, std::move(metrics));
+    return *it->second;
+}
+
+} // namespace common
+} // namespace saasforge
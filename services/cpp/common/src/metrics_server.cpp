@@ -0,0 +1,290 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Minimal HTTP endpoint serving /metrics for Prometheus scrapes
+ */
+
+#include "common/metrics_server.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <netinet/in.h>
+#include <openssl/crypto.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr int ACCEPT_POLL_MS = 200;            // Shutdown latency
+constexpr int CLIENT_TIMEOUT_MS = 2000;
+constexpr size_t MAX_REQUEST_BYTES = 8192;
+
+bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string Response(const char* status, const char* content_type, const std::string& body,
+                     const std::string& headers = "") {
+    return std::string("HTTP/1.1 ") + status + "\r\n"
+           "Content-Type: " + content_type + "\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n" + headers +
+           "Connection: close\r\n\r\n" + body;
+}
+
+/// Value of `name` in an a=1&b=2 query string, if present
+bool QueryParam(const std::string& query, const std::string& name, std::string& value) {
+    size_t start = 0;
+    while (start <= query.size()) {
+        size_t end = std::min(query.find('&', start), query.size());
+        std::string pair = query.substr(start, end - start);
+        size_t equals = pair.find('=');
+        if (pair.substr(0, equals) == name) {
+            value = equals == std::string::npos ? "" : pair.substr(equals + 1);
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+/// Answer with the profile `take` returns, or the status its failure maps to
+void SendProfile(int fd, const std::string& filename, const std::function<std::string()>& take) {
+    std::string response;
+    try {
+        response = Response("200 OK", "application/octet-stream", take(),
+                            "Content-Disposition: attachment; filename=\"" + filename + "\"\r\n");
+    } catch (const ProfilerUnavailable& e) {
+        response = Response("501 Not Implemented", "text/plain", std::string(e.what()) + "\n");
+    } catch (const ProfilerBusy& e) {
+        response = Response("409 Conflict", "text/plain", std::string(e.what()) + "\n");
+    } catch (const std::exception& e) {
+        LogError("Profile failed", {{"profile", filename}, {"error", e.what()}});
+        response = Response("500 Internal Server Error", "text/plain", "Profile failed\n");
+    }
+    SendAll(fd, response);
+}
+
+} // namespace
+
+MetricsServerOptions MetricsServerOptions::FromEnv() {
+    MetricsServerOptions options;
+    long port = EnvInt("METRICS_PORT", options.port);
+    options.port = port <= 65535 ? static_cast<uint16_t>(port) : options.port;
+    options.bind_address = EnvString("METRICS_BIND_ADDRESS", options.bind_address);
+    options.profiling = ProfilingOptions::FromEnv();
+    return options;
+}
+
+MetricsServer::MetricsServer(const MetricsRegistry& registry, const MetricsServerOptions& options,
+                             Profiler& profiler)
+    : registry_(registry), profiling_(options.profiling), profiler_(profiler) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (::inet_pton(AF_INET, options.bind_address.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid metrics bind address: " + options.bind_address);
+    }
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("Metrics socket failed: ") + std::strerror(errno));
+    }
+    int reuse = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, 16) != 0) {
+        std::string error = std::strerror(errno);
+        ::close(listen_fd_);
+        throw std::runtime_error("Metrics endpoint bind failed on port " + std::to_string(options.port) + ": " + error);
+    }
+
+    socklen_t length = sizeof(addr);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &length);
+    port_ = ntohs(addr.sin_port);
+
+    thread_ = std::thread(&MetricsServer::AcceptLoop, this);
+}
+
+MetricsServer::~MetricsServer() {
+    Shutdown();
+}
+
+void MetricsServer::Shutdown() {
+    if (shutdown_.exchange(true)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    {
+        // A running CPU profile sees shutdown_ and returns what it has
+        std::lock_guard<std::mutex> lock(profile_mutex_);
+        if (profile_thread_.joinable()) {
+            profile_thread_.join();
+        }
+    }
+    ::close(listen_fd_);
+}
+
+void MetricsServer::AcceptLoop() {
+    while (!shutdown_.load()) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, ACCEPT_POLL_MS);
+        if (ready <= 0) {
+            continue;
+        }
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        bool done = true;
+        try {
+            done = Serve(fd);
+        } catch (const std::exception& e) {
+            LogError("Metrics request failed", {{"error", e.what()}});
+        }
+        if (done) {
+            ::close(fd);
+        }
+    }
+}
+
+bool MetricsServer::Serve(int fd) {
+    timeval timeout{CLIENT_TIMEOUT_MS / 1000, (CLIENT_TIMEOUT_MS % 1000) * 1000};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line and Authorization matter; read until the end of the headers
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    size_t line_end = request.find("\r\n");
+    std::string line = request.substr(0, line_end);
+    size_t method_end = line.find(' ');
+    size_t path_end = method_end == std::string::npos ? std::string::npos : line.find(' ', method_end + 1);
+    if (path_end == std::string::npos) {
+        SendAll(fd, Response("400 Bad Request", "text/plain", "Bad request\n"));
+        return true;
+    }
+    std::string method = line.substr(0, method_end);
+    std::string path = line.substr(method_end + 1, path_end - method_end - 1);
+    size_t query_start = path.find('?');
+    std::string query = query_start == std::string::npos ? "" : path.substr(query_start + 1);
+    path = path.substr(0, query_start);
+
+    if (method != "GET") {
+        SendAll(fd, Response("405 Method Not Allowed", "text/plain", "Method not allowed\n"));
+    } else if (path == "/metrics") {
+        SendAll(fd, Response("200 OK", "text/plain; version=0.0.4; charset=utf-8", registry_.Render()));
+    } else if (path == "/healthz") {
+        SendAll(fd, Response("200 OK", "text/plain", "ok\n"));
+    } else if ((path == "/debug/pprof/profile" || path == "/debug/pprof/heap") && !profiling_.token.empty()) {
+        if (!Authorized(request)) {
+            LogWarn("Unauthorized profiling request", {{"path", path}});
+            SendAll(fd, Response("401 Unauthorized", "text/plain", "Unauthorized\n",
+                                 "WWW-Authenticate: Bearer\r\n"));
+            return true;
+        }
+        return ServeProfile(fd, path, query);
+    } else {
+        SendAll(fd, Response("404 Not Found", "text/plain", "Not found\n"));
+    }
+    return true;
+}
+
+bool MetricsServer::Authorized(const std::string& request) const {
+    const std::string expected = "Bearer " + profiling_.token;
+    size_t line_start = request.find("\r\n");
+    while (line_start != std::string::npos) {
+        line_start += 2;
+        size_t line_end = request.find("\r\n", line_start);
+        std::string line = request.substr(line_start, line_end - line_start);
+        size_t colon = line.find(':');
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (colon != std::string::npos && name == "authorization") {
+            size_t value_start = std::min(line.find_first_not_of(' ', colon + 1), line.size());
+            std::string value = line.substr(value_start);
+            return value.size() == expected.size() &&
+                   CRYPTO_memcmp(value.data(), expected.data(), expected.size()) == 0;
+        }
+        line_start = line_end;
+    }
+    return false;
+}
+
+bool MetricsServer::ServeProfile(int fd, const std::string& path, const std::string& query) {
+    if (path == "/debug/pprof/heap") {
+        SendProfile(fd, "heap.prof", [this] { return profiler_.HeapProfile(); });
+        return true;
+    }
+
+    std::chrono::seconds duration = profiling_.default_cpu_duration;
+    std::string seconds;
+    if (QueryParam(query, "seconds", seconds)) {
+        char* end = nullptr;
+        long parsed = std::strtol(seconds.c_str(), &end, 10);
+        if (seconds.empty() || *end != '\0' || parsed <= 0) {
+            SendAll(fd, Response("400 Bad Request", "text/plain", "seconds must be a positive integer\n"));
+            return true;
+        }
+        duration = std::chrono::seconds(std::min<long>(parsed, profiling_.max_cpu_duration.count()));
+    }
+    if (!profiler_.CpuAvailable()) {
+        SendProfile(fd, "cpu.prof", [this] { return profiler_.CpuProfile(std::chrono::seconds(0)); });
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(profile_mutex_);
+    if (profile_running_.load()) {
+        SendAll(fd, Response("409 Conflict", "text/plain", "A CPU profile is already in progress\n"));
+        return true;
+    }
+    if (profile_thread_.joinable()) {
+        profile_thread_.join();
+    }
+    profile_running_ = true;
+    profile_thread_ = std::thread([this, fd, duration] {
+        SendProfile(fd, "cpu.prof", [this, duration] {
+            return profiler_.CpuProfile(duration, [this] { return shutdown_.load(); });
+        });
+        ::close(fd);
+        profile_running_ = false;
+    });
+    return false;
+}
+
+} // namespace common
+} // namespace saasforge
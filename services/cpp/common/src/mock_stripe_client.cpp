@@ -5,39 +5,147 @@
  */
 
 #include "common/mock_stripe_client.h"
+#include "common/env.h"
+#include "common/id_generator.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <random>
-#include <sstream>
-#include <iomanip>
+#include <thread>
 #include <chrono>
-#include <iostream>
 
 namespace saasforge {
 namespace common {
 
-MockStripeClient::MockStripeClient(const std::string& api_key)
-    : api_key_(api_key) {
+namespace {
+
+std::mt19937_64& Random() {
+    thread_local std::mt19937_64 generator(std::random_device{}() ^
+        static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+    return generator;
+}
+
+bool Chance(double rate) {
+    return rate > 0.0 && std::uniform_real_distribution<>(0.0, 1.0)(Random()) < rate;
+}
+
+constexpr double Z_P99 = 2.3263478740408408;   // Standard normal 99th percentile
+
+} // namespace
+
+MockStripeOptions MockStripeOptions::FromEnv() {
+    MockStripeOptions options;
+    options.num_shards = static_cast<size_t>(std::max(1L,
+        EnvInt("MOCK_STRIPE_SHARDS", static_cast<long>(options.num_shards))));
+    options.latency_p50 = std::chrono::milliseconds(EnvInt("MOCK_STRIPE_LATENCY_P50_MS", 0));
+    options.latency_p99 = std::chrono::milliseconds(EnvInt("MOCK_STRIPE_LATENCY_P99_MS", 0));
+    options.rate_limit_rate = EnvRatio("MOCK_STRIPE_RATE_LIMIT_RATE", options.rate_limit_rate);
+    options.decline_rate = EnvRatio("MOCK_STRIPE_DECLINE_RATE", options.decline_rate);
+    return options;
+}
+
+template <typename T>
+MockStripeClient::ShardedMap<T>::ShardedMap(size_t num_shards) {
+    shards_.resize(std::max<size_t>(num_shards, 1));
+    for (auto& shard : shards_) {
+        shard = std::make_unique<Shard>();
+    }
+}
+
+template <typename T>
+typename MockStripeClient::ShardedMap<T>::Shard& MockStripeClient::ShardedMap<T>::ShardFor(const std::string& id) const {
+    return *shards_[std::hash<std::string>{}(id) % shards_.size()];
+}
+
+template <typename T>
+void MockStripeClient::ShardedMap<T>::Put(const std::string& id, T value) {
+    auto& shard = ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries[id] = std::move(value);
+}
+
+template <typename T>
+std::optional<T> MockStripeClient::ShardedMap<T>::Get(const std::string& id) const {
+    auto& shard = ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(id);
+    if (it != shard.entries.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+template <typename T>
+bool MockStripeClient::ShardedMap<T>::Erase(const std::string& id) {
+    auto& shard = ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.entries.erase(id) > 0;
+}
+
+template <typename T>
+bool MockStripeClient::ShardedMap<T>::Update(const std::string& id, const std::function<void(T&)>& update) {
+    auto& shard = ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(id);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    update(it->second);
+    return true;
+}
+
+MockStripeClient::MockStripeClient(const std::string& api_key, const MockStripeOptions& options)
+    : api_key_(api_key),
+      options_(options),
+      customers_(options.num_shards),
+      subscriptions_(options.num_shards),
+      payment_methods_(options.num_shards),
+      invoices_(options.num_shards) {
+}
+
+void MockStripeClient::SimulateApiCall() {
+    ++calls_;
+
+    if (options_.latency_p50.count() > 0) {
+        double p50 = static_cast<double>(options_.latency_p50.count());
+        double p99 = std::max(p50, static_cast<double>(options_.latency_p99.count()));
+        // Log-normal through p50 and p99; the tail is capped so one call cannot stall a test
+        double sigma = std::log(p99 / p50) / Z_P99;
+        double delay = p50 * std::exp(sigma * std::normal_distribution<>(0.0, 1.0)(Random()));
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            static_cast<int64_t>(std::min(delay, 10.0 * p99))));
+    }
+
+    if (Chance(options_.rate_limit_rate)) {
+        ++rate_limited_;
+        throw StripeRateLimited();
+    }
+}
+
+MockStripeStats MockStripeClient::GetStats() const {
+    return {calls_.load(), rate_limited_.load(), declined_.load()};
 }
 
 // Customer operations
 
 StripeCustomer MockStripeClient::CreateCustomer(const std::string& email, const std::string& tenant_id) {
+    SimulateApiCall();
+
     StripeCustomer customer;
     customer.id = GenerateId("cus");
     customer.email = email;
     customer.tenant_id = tenant_id;
     customer.created = GetCurrentTimestamp();
 
-    customers_[customer.id] = customer;
+    customers_.Put(customer.id, customer);
 
     return customer;
 }
 
 std::optional<StripeCustomer> MockStripeClient::GetCustomer(const std::string& customer_id) {
-    auto it = customers_.find(customer_id);
-    if (it != customers_.end()) {
-        return it->second;
-    }
-    return std::nullopt;
+    SimulateApiCall();
+    return customers_.Get(customer_id);
 }
 
 // Subscription operations
@@ -47,6 +155,8 @@ StripeSubscription MockStripeClient::CreateSubscription(
     const std::string& plan_id,
     int trial_days
 ) {
+    SimulateApiCall();
+
     StripeSubscription subscription;
     subscription.id = GenerateId("sub");
     subscription.customer_id = customer_id;
@@ -76,61 +186,66 @@ StripeSubscription MockStripeClient::CreateSubscription(
         subscription.amount = 0.0;
     }
 
-    subscriptions_[subscription.id] = subscription;
+    subscriptions_.Put(subscription.id, subscription);
 
     return subscription;
 }
 
 std::optional<StripeSubscription> MockStripeClient::GetSubscription(const std::string& subscription_id) {
-    auto it = subscriptions_.find(subscription_id);
-    if (it != subscriptions_.end()) {
-        return it->second;
-    }
-    return std::nullopt;
+    SimulateApiCall();
+    return subscriptions_.Get(subscription_id);
 }
 
 StripeSubscription MockStripeClient::UpdateSubscription(
     const std::string& subscription_id,
     const std::string& new_plan_id
 ) {
-    auto it = subscriptions_.find(subscription_id);
-    if (it == subscriptions_.end()) {
+    SimulateApiCall();
+
+    StripeSubscription updated;
+    std::string old_plan;
+    bool found = subscriptions_.Update(subscription_id, [&](StripeSubscription& subscription) {
+        old_plan = subscription.plan_id;
+        subscription.plan_id = new_plan_id;
+
+        // Update amount (Requirement C-74: proration will be calculated separately)
+        if (new_plan_id == "free") {
+            subscription.amount = 0.0;
+        } else if (new_plan_id == "pro") {
+            subscription.amount = 29.0;
+        } else if (new_plan_id == "enterprise") {
+            subscription.amount = 99.0;
+        }
+        updated = subscription;
+    });
+    if (!found) {
         throw std::runtime_error("Subscription not found");
     }
 
-    auto& subscription = it->second;
-    std::string old_plan = subscription.plan_id;
-    subscription.plan_id = new_plan_id;
+    LogInfo("Subscription plan updated", {{"subscription_id", subscription_id}, {"from", old_plan},
+                                         {"to", new_plan_id}});
 
-    // Update amount (Requirement C-74: proration will be calculated separately)
-    if (new_plan_id == "free") {
-        subscription.amount = 0.0;
-    } else if (new_plan_id == "pro") {
-        subscription.amount = 29.0;
-    } else if (new_plan_id == "enterprise") {
-        subscription.amount = 99.0;
-    }
-
-    std::cout << "Subscription " << subscription_id << " updated from "
-              << old_plan << " to " << new_plan_id << std::endl;
-
-    return subscription;
+    return updated;
 }
 
 void MockStripeClient::CancelSubscription(const std::string& subscription_id, bool cancel_immediately) {
-    auto it = subscriptions_.find(subscription_id);
-    if (it == subscriptions_.end()) {
+    SimulateApiCall();
+
+    bool found = subscriptions_.Update(subscription_id, [&](StripeSubscription& subscription) {
+        if (cancel_immediately) {
+            subscription.status = SubscriptionStatus::CANCELED;
+        } else {
+            subscription.cancel_at_period_end = true;
+        }
+    });
+    if (!found) {
         throw std::runtime_error("Subscription not found");
     }
 
-    auto& subscription = it->second;
-
     if (cancel_immediately) {
-        subscription.status = SubscriptionStatus::CANCELED;
-        std::cout << "Subscription " << subscription_id << " canceled immediately" << std::endl;
+        LogInfo("Subscription canceled immediately", {{"subscription_id", subscription_id}});
     } else {
-        subscription.cancel_at_period_end = true;
-        std::cout << "Subscription " << subscription_id << " will cancel at period end" << std::endl;
+        LogInfo("Subscription will cancel at period end", {{"subscription_id", subscription_id}});
     }
 }
 
@@ -142,6 +257,8 @@ StripePaymentMethod MockStripeClient::CreatePaymentMethod(
     int exp_month,
     int exp_year
 ) {
+    SimulateApiCall();
+
     StripePaymentMethod pm;
     pm.id = GenerateId("pm");
     pm.type = type;
@@ -153,44 +270,60 @@ StripePaymentMethod MockStripeClient::CreatePaymentMethod(
         pm.exp_year = exp_year;
     }
 
-    payment_methods_[pm.id] = pm;
+    payment_methods_.Put(pm.id, pm);
 
     return pm;
 }
 
 void MockStripeClient::AttachPaymentMethod(const std::string& payment_method_id, const std::string& customer_id) {
-    auto pm_it = payment_methods_.find(payment_method_id);
-    if (pm_it == payment_methods_.end()) {
+    SimulateApiCall();
+
+    if (!payment_methods_.Get(payment_method_id)) {
         throw std::runtime_error("Payment method not found");
     }
 
-    auto cust_it = customers_.find(customer_id);
-    if (cust_it == customers_.end()) {
+    bool found = customers_.Update(customer_id, [&](StripeCustomer& customer) {
+        customer.default_payment_method = payment_method_id;
+    });
+    if (!found) {
         throw std::runtime_error("Customer not found");
     }
 
-    cust_it->second.default_payment_method = payment_method_id;
-    std::cout << "Payment method " << payment_method_id << " attached to customer " << customer_id << std::endl;
+    // One shard lock at a time; a concurrent detach wins (the customer's default is cleared below)
+    bool attached = payment_methods_.Update(payment_method_id, [&](StripePaymentMethod& pm) {
+        pm.customer_id = customer_id;
+    });
+    if (!attached) {
+        customers_.Update(customer_id, [&](StripeCustomer& customer) {
+            if (customer.default_payment_method == payment_method_id) {
+                customer.default_payment_method.clear();
+            }
+        });
+        throw std::runtime_error("Payment method not found");
+    }
+    LogInfo("Payment method attached", {{"payment_method_id", payment_method_id}, {"customer_id", customer_id}});
 }
 
 void MockStripeClient::DetachPaymentMethod(const std::string& payment_method_id) {
+    SimulateApiCall();
+
+    auto pm = payment_methods_.Get(payment_method_id);
+    payment_methods_.Erase(payment_method_id);
+
     // Remove from customer default payment method
-    for (auto& [customer_id, customer] : customers_) {
-        if (customer.default_payment_method == payment_method_id) {
-            customer.default_payment_method.clear();
-        }
+    if (pm && !pm->customer_id.empty()) {
+        customers_.Update(pm->customer_id, [&](StripeCustomer& customer) {
+            if (customer.default_payment_method == payment_method_id) {
+                customer.default_payment_method.clear();
+            }
+        });
     }
-
-    payment_methods_.erase(payment_method_id);
-    std::cout << "Payment method " << payment_method_id << " detached" << std::endl;
+    LogInfo("Payment method detached", {{"payment_method_id", payment_method_id}});
 }
 
 std::optional<StripePaymentMethod> MockStripeClient::GetPaymentMethod(const std::string& payment_method_id) {
-    auto it = payment_methods_.find(payment_method_id);
-    if (it != payment_methods_.end()) {
-        return it->second;
-    }
-    return std::nullopt;
+    SimulateApiCall();
+    return payment_methods_.Get(payment_method_id);
 }
 
 // Invoice operations
@@ -199,7 +332,9 @@ StripeInvoice MockStripeClient::CreateInvoice(
     const std::string& customer_id,
     const std::string& subscription_id
 ) {
-    auto sub_opt = GetSubscription(subscription_id);
+    SimulateApiCall();
+
+    auto sub_opt = subscriptions_.Get(subscription_id);
     if (!sub_opt) {
         throw std::runtime_error("Subscription not found");
     }
@@ -217,87 +352,100 @@ StripeInvoice MockStripeClient::CreateInvoice(
     // Add line items (mock)
     invoice.line_items.push_back("Subscription to " + sub_opt->plan_id + " plan");
 
-    invoices_[invoice.id] = invoice;
+    invoices_.Put(invoice.id, invoice);
 
     return invoice;
 }
 
 std::optional<StripeInvoice> MockStripeClient::GetInvoice(const std::string& invoice_id) {
-    auto it = invoices_.find(invoice_id);
-    if (it != invoices_.end()) {
-        return it->second;
-    }
-    return std::nullopt;
+    SimulateApiCall();
+    return invoices_.Get(invoice_id);
 }
 
 void MockStripeClient::FinalizeInvoice(const std::string& invoice_id) {
-    auto it = invoices_.find(invoice_id);
-    if (it == invoices_.end()) {
+    SimulateApiCall();
+
+    bool found = invoices_.Update(invoice_id, [](StripeInvoice& invoice) {
+        invoice.status = "open";
+    });
+    if (!found) {
         throw std::runtime_error("Invoice not found");
     }
 
-    it->second.status = "open";
-    std::cout << "Invoice " << invoice_id << " finalized" << std::endl;
+    LogInfo("Invoice finalized", {{"invoice_id", invoice_id}});
 }
 
 PaymentIntentStatus MockStripeClient::PayInvoice(const std::string& invoice_id) {
-    auto it = invoices_.find(invoice_id);
-    if (it == invoices_.end()) {
+    SimulateApiCall();
+
+    // Mock payment processing (card declined at decline_rate)
+    bool declined = Chance(options_.decline_rate);
+
+    bool found = invoices_.Update(invoice_id, [&](StripeInvoice& invoice) {
+        if (!declined) {
+            // Payment succeeded
+            invoice.status = "paid";
+            invoice.amount_paid = invoice.amount_due;
+        }
+    });
+    if (!found) {
         throw std::runtime_error("Invoice not found");
     }
 
-    // Mock payment processing (80% success rate)
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-
-    PaymentIntentStatus status;
-    if (dis(gen) < 0.8) {
-        // Payment succeeded
-        it->second.status = "paid";
-        it->second.amount_paid = it->second.amount_due;
-        status = PaymentIntentStatus::SUCCEEDED;
-    } else {
+    if (declined) {
         // Payment failed
-        status = PaymentIntentStatus::FAILED;
+        ++declined_;
+        return PaymentIntentStatus::FAILED;
     }
-
-    return status;
+    return PaymentIntentStatus::SUCCEEDED;
 }
 
 // Payment retry logic (Requirement C-71)
 
 void MockStripeClient::RecordPaymentFailure(const std::string& subscription_id) {
-    auto it = subscriptions_.find(subscription_id);
-    if (it == subscriptions_.end()) {
-        return;
-    }
-
-    auto& subscription = it->second;
-    subscription.retry_count++;
+    SimulateApiCall();
+
+    int retry_count = 0;
+    SubscriptionStatus old_status = SubscriptionStatus::ACTIVE;
+    SubscriptionStatus new_status = SubscriptionStatus::ACTIVE;
+    bool found = subscriptions_.Update(subscription_id, [&](StripeSubscription& subscription) {
+        retry_count = ++subscription.retry_count;
+        old_status = subscription.status;
+
+        // Transition to PAST_DUE after first failure
+        if (retry_count == 1) {
+            subscription.status = SubscriptionStatus::PAST_DUE;
+        }
 
-    // Transition to PAST_DUE after first failure
-    if (subscription.retry_count == 1) {
-        TransitionSubscriptionState(subscription_id, SubscriptionStatus::PAST_DUE);
+        // Transition to UNPAID after 3 failures
+        if (retry_count >= 3) {
+            subscription.status = SubscriptionStatus::UNPAID;
+        }
+        new_status = subscription.status;
+    });
+    if (!found) {
+        return;
     }
 
-    // Transition to UNPAID after 3 failures
-    if (subscription.retry_count >= 3) {
-        TransitionSubscriptionState(subscription_id, SubscriptionStatus::UNPAID);
+    if (new_status != old_status) {
+        LogInfo("Subscription status changed", {{"subscription_id", subscription_id},
+                                                {"from", StatusToString(old_status)},
+                                                {"to", StatusToString(new_status)}});
     }
-
-    std::cout << "Payment failure recorded for subscription " << subscription_id
-              << " (retry count: " << subscription.retry_count << ")" << std::endl;
+    LogInfo("Payment failure recorded", {{"subscription_id", subscription_id},
+                                         {"retry_count", retry_count}});
 }
 
 bool MockStripeClient::ShouldRetryPayment(const std::string& subscription_id) {
-    auto it = subscriptions_.find(subscription_id);
-    if (it == subscriptions_.end()) {
+    SimulateApiCall();
+
+    auto subscription = subscriptions_.Get(subscription_id);
+    if (!subscription) {
         return false;
     }
 
     // Retry up to 3 times (Day 1, 3, 7)
-    return it->second.retry_count < 3;
+    return subscription->retry_count < 3;
 }
 
 void MockStripeClient::SchedulePaymentRetry(const std::string& subscription_id, int retry_count) {
@@ -311,8 +459,7 @@ void MockStripeClient::SchedulePaymentRetry(const std::string& subscription_id,
         days_until_retry = 7;
     }
 
-    std::cout << "Payment retry scheduled for subscription " << subscription_id
-              << " in " << days_until_retry << " days" << std::endl;
+    LogInfo("Payment retry scheduled", {{"subscription_id", subscription_id}, {"days", days_until_retry}});
 }
 
 // Subscription state transitions (Requirement C-64)
@@ -321,17 +468,20 @@ void MockStripeClient::TransitionSubscriptionState(
     const std::string& subscription_id,
     SubscriptionStatus new_status
 ) {
-    auto it = subscriptions_.find(subscription_id);
-    if (it == subscriptions_.end()) {
+    SimulateApiCall();
+
+    SubscriptionStatus old_status = new_status;
+    bool found = subscriptions_.Update(subscription_id, [&](StripeSubscription& subscription) {
+        old_status = subscription.status;
+        subscription.status = new_status;
+    });
+    if (!found) {
         return;
     }
 
-    SubscriptionStatus old_status = it->second.status;
-    it->second.status = new_status;
-
-    std::cout << "Subscription " << subscription_id << " transitioned from "
-              << StatusToString(old_status) << " to "
-              << StatusToString(new_status) << std::endl;
+    LogInfo("Subscription status changed", {{"subscription_id", subscription_id},
+                                            {"from", StatusToString(old_status)},
+                                            {"to", StatusToString(new_status)}});
 }
 
 // Helper methods
@@ -359,17 +509,7 @@ SubscriptionStatus MockStripeClient::StringToStatus(const std::string& status_st
 }
 
 std::string MockStripeClient::GenerateId(const std::string& prefix) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 255);
-
-    std::stringstream ss;
-    ss << prefix << "_";
-    for (int i = 0; i < 24; i++) {
-        ss << std::hex << std::setw(1) << (dis(gen) % 16);
-    }
-
-    return ss.str();
+    return IdGenerator::NewUlid(prefix);
 }
 
 int64_t MockStripeClient::GetCurrentTimestamp() {
@@ -1,11 +1,33 @@
 #include "common/mtls_credentials.h"
+#include "common/env.h"
+#include <grpcpp/security/tls_certificate_provider.h>
+#include <grpcpp/security/tls_credentials_options.h>
+#include <algorithm>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 
 namespace saasforge {
 namespace common {
 
+namespace {
+
+// Watches the three files; the key/cert pair and the CA bundle are swapped in
+// for new handshakes as soon as a change is seen
+std::shared_ptr<grpc::experimental::FileWatcherCertificateProvider> WatchFiles(
+    const std::string& ca_cert_path, const std::string& cert_path, const std::string& key_path) {
+    return std::make_shared<grpc::experimental::FileWatcherCertificateProvider>(
+        key_path, cert_path, ca_cert_path, MtlsCredentials::RefreshInterval());
+}
+
+} // namespace
+
+unsigned int MtlsCredentials::RefreshInterval() {
+    return static_cast<unsigned int>(std::max<long>(EnvInt("MTLS_CERT_REFRESH_S", DEFAULT_REFRESH_S), 1));
+}
+
 std::string MtlsCredentials::ReadFile(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -21,23 +43,20 @@ std::shared_ptr<grpc::ServerCredentials> MtlsCredentials::CreateServerCredential
     const std::string& server_cert_path,
     const std::string& server_key_path
 ) {
-    std::string ca_cert = ReadFile(ca_cert_path);
-    std::string server_cert = ReadFile(server_cert_path);
-    std::string server_key = ReadFile(server_key_path);
-
-    grpc::SslServerCredentialsOptions ssl_opts;
-    ssl_opts.pem_root_certs = ca_cert;
+    // The watcher only logs unreadable files; fail here so callers can fall back
+    ReadFile(ca_cert_path);
+    ReadFile(server_cert_path);
+    ReadFile(server_key_path);
 
-    grpc::SslServerCredentialsOptions::PemKeyCertPair key_cert_pair;
-    key_cert_pair.private_key = server_key;
-    key_cert_pair.cert_chain = server_cert;
-    ssl_opts.pem_key_cert_pairs.push_back(key_cert_pair);
+    grpc::experimental::TlsServerCredentialsOptions tls_opts(
+        WatchFiles(ca_cert_path, server_cert_path, server_key_path));
+    tls_opts.watch_root_certs();
+    tls_opts.watch_identity_key_cert_pairs();
 
     // Require and verify client certificates
-    ssl_opts.client_certificate_request =
-        GRPC_SSL_REQUEST_AND_REQUIRE_CLIENT_CERTIFICATE_AND_VERIFY;
+    tls_opts.set_cert_request_type(GRPC_SSL_REQUEST_AND_REQUIRE_CLIENT_CERTIFICATE_AND_VERIFY);
 
-    return grpc::SslServerCredentials(ssl_opts);
+    return grpc::experimental::TlsServerCredentials(tls_opts);
 }
 
 std::shared_ptr<grpc::ChannelCredentials> MtlsCredentials::CreateClientCredentials(
@@ -45,16 +64,38 @@ std::shared_ptr<grpc::ChannelCredentials> MtlsCredentials::CreateClientCredentia
     const std::string& client_cert_path,
     const std::string& client_key_path
 ) {
-    std::string ca_cert = ReadFile(ca_cert_path);
-    std::string client_cert = ReadFile(client_cert_path);
-    std::string client_key = ReadFile(client_key_path);
+    ReadFile(ca_cert_path);
+    ReadFile(client_cert_path);
+    ReadFile(client_key_path);
 
-    grpc::SslCredentialsOptions ssl_opts;
-    ssl_opts.pem_root_certs = ca_cert;
-    ssl_opts.pem_cert_chain = client_cert;
-    ssl_opts.pem_private_key = client_key;
+    grpc::experimental::TlsChannelCredentialsOptions tls_opts;
+    tls_opts.set_certificate_provider(WatchFiles(ca_cert_path, client_cert_path, client_key_path));
+    tls_opts.watch_root_certs();
+    tls_opts.watch_identity_key_cert_pairs();
+
+    return grpc::experimental::TlsCredentials(tls_opts);
+}
+
+std::shared_ptr<grpc::ChannelCredentials> MtlsCredentials::CachedClientCredentials(
+    const std::string& ca_cert_path,
+    const std::string& client_cert_path,
+    const std::string& client_key_path
+) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<grpc::ChannelCredentials>> cache;
+
+    std::string key = ca_cert_path + '\0' + client_cert_path + '\0' + client_key_path;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        return it->second;
+    }
 
-    return grpc::SslCredentials(ssl_opts);
+    // Throws (and caches nothing) if a file is missing
+    auto credentials = CreateClientCredentials(ca_cert_path, client_cert_path, client_key_path);
+    cache.emplace(std::move(key), credentials);
+    return credentials;
 }
 
 } // namespace common
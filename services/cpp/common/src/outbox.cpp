@@ -0,0 +1,55 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Transactional outbox: domain events written with the change that caused them implementation
+ */
+
+#include "common/outbox.h"
+#include "common/statement_registry.h"
+#include <stdexcept>
+#include <google/protobuf/util/json_util.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry).
+// pg_notify is delivered on commit; Postgres folds duplicates within one
+// transaction, so a change raising several events wakes the relay once
+const PreparedStatement kAppendEvent(
+    "outbox_append_event",
+    "WITH appended AS ("
+    "  INSERT INTO outbox_events (tenant_id, event_type, payload) VALUES ($1, $2, $3) "
+    "  RETURNING id"
+    ") "
+    "SELECT pg_notify($4, '') FROM appended");
+
+} // namespace
+
+void Outbox::Append(
+    pqxx::transaction_base& txn,
+    const std::string& tenant_id,
+    const std::string& event_type,
+    const std::string& payload
+) {
+    ExecPrepared(txn, kAppendEvent, tenant_id, event_type, payload, NOTIFY_CHANNEL);
+}
+
+void Outbox::Append(
+    pqxx::transaction_base& txn,
+    const std::string& tenant_id,
+    const std::string& event_type,
+    const google::protobuf::Message& payload
+) {
+    google::protobuf::util::JsonPrintOptions options;
+    options.preserve_proto_field_names = true;
+    std::string json;
+    if (!google::protobuf::util::MessageToJsonString(payload, &json, options).ok()) {
+        throw std::runtime_error("Outbox payload for " + event_type + " is not JSON-serializable");
+    }
+    Append(txn, tenant_id, event_type, json);
+}
+
+} // namespace common
+} // namespace saasforge
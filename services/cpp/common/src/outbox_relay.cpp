@@ -0,0 +1,133 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Relays outbox_events into the webhook delivery queue in batches implementation
+ */
+
+#include "common/outbox_relay.h"
+#include "common/outbox.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/statement_registry.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry).
+// Rows are deleted as they are claimed; the transaction that fans them out
+// commits the delete, so the outbox holds only events not yet relayed
+const PreparedStatement kClaimOutboxEvents(
+    "outbox_claim_events",
+    "DELETE FROM outbox_events "
+    "WHERE id IN (SELECT id FROM outbox_events ORDER BY id LIMIT $1 FOR UPDATE SKIP LOCKED) "
+    "RETURNING id, tenant_id, event_type, payload");
+
+Counter& RelayedEvents() {
+    static Counter& counter = MetricsRegistry::Global().GetCounter(
+        "saasforge_outbox_events_relayed_total", "Outbox events fanned out to the delivery queues");
+    return counter;
+}
+
+} // namespace
+
+OutboxRelayOptions OutboxRelayOptions::FromEnv() {
+    OutboxRelayOptions options;
+    options.batch_size = static_cast<size_t>(
+        std::max(1L, EnvInt("OUTBOX_RELAY_BATCH_SIZE", static_cast<long>(options.batch_size))));
+    options.poll_interval = std::chrono::milliseconds(
+        EnvInt("OUTBOX_RELAY_POLL_MS", static_cast<long>(options.poll_interval.count())));
+    return options;
+}
+
+OutboxRelay::OutboxRelay(
+    std::shared_ptr<DbPool> db_pool,
+    std::shared_ptr<WebhookSubscriptionIndex> subscriptions,
+    std::shared_ptr<WebhookDelivery> webhook_delivery,
+    std::shared_ptr<QueueNotifier> notifier,
+    const OutboxRelayOptions& options
+) : db_pool_(std::move(db_pool)),
+    subscriptions_(std::move(subscriptions)),
+    webhook_delivery_(std::move(webhook_delivery)),
+    notifier_(std::move(notifier)),
+    options_(options) {
+    options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+    thread_ = std::thread(&OutboxRelay::Loop, this);
+}
+
+OutboxRelay::~OutboxRelay() {
+    Shutdown();
+}
+
+void OutboxRelay::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_.exchange(true)) {
+            return;
+        }
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+size_t OutboxRelay::RunOnce() {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto claimed = ExecPrepared(txn, kClaimOutboxEvents, static_cast<long long>(options_.batch_size));
+    if (claimed.empty()) {
+        return 0;
+    }
+
+    // Subscribers come from the in-memory index; a cold tenant costs one load
+    std::vector<WebhookEventFanout> events;
+    events.reserve(claimed.size());
+    for (const auto& row : claimed) {
+        auto& event = events.emplace_back();
+        event.tenant_id = row["tenant_id"].as<std::string>();
+        event.event_type = row["event_type"].as<std::string>();
+        event.payload = row["payload"].as<std::string>();
+        event.subscribers = subscriptions_->Subscribers(event.tenant_id, event.event_type);
+    }
+
+    size_t deliveries = webhook_delivery_->QueueEvents(txn, events);
+    txn.commit();
+
+    RelayedEvents().Increment(claimed.size());
+    LogDebug("Outbox events relayed", {{"events", claimed.size()}, {"deliveries", deliveries}});
+    return claimed.size();
+}
+
+void OutboxRelay::Loop() {
+    while (!shutdown_.load()) {
+        // Read before claiming, so an event committed meanwhile is not slept through
+        uint64_t seen = notifier_ ? notifier_->Generation(Outbox::NOTIFY_CHANNEL) : 0;
+
+        size_t claimed = 0;
+        try {
+            claimed = RunOnce();
+        } catch (const std::exception& e) {
+            LogError("Outbox relay failed", {{"error", e.what()}});
+        }
+        if (claimed >= options_.batch_size || shutdown_.load()) {
+            continue;  // Backlog: keep draining
+        }
+
+        if (notifier_) {
+            notifier_->WaitForChange(Outbox::NOTIFY_CHANNEL, seen, options_.poll_interval);
+        } else {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, options_.poll_interval, [this] { return shutdown_.load(); });
+        }
+    }
+}
+
+} // namespace common
+} // namespace saasforge
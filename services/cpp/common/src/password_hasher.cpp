@@ -1,89 +1,257 @@
 #include "common/password_hasher.h"
+#include "common/codec.h"
+#include "common/env.h"
 #include <argon2.h>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <random>
+#include <mutex>
+#include <optional>
 #include <sstream>
-#include <iomanip>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace saasforge {
 namespace common {
 
-std::string PasswordHasher::HashPassword(const std::string& password) {
-    // Generate random salt
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<unsigned char> dis(0, 255);
+namespace {
+
+constexpr size_t ARENA_ALIGNMENT = 64;
+
+std::mutex g_policy_mutex;
+PasswordHashPolicy g_policy;
+
+// One Argon2 block buffer per thread, reused across calls. Argon2 wipes the
+// blocks before calling the deallocator, so nothing sensitive is retained.
+struct Argon2Arena {
+    uint8_t* memory = nullptr;
+    size_t size = 0;
 
-    std::vector<unsigned char> salt(SALT_LENGTH);
-    for (size_t i = 0; i < SALT_LENGTH; i++) {
-        salt[i] = dis(gen);
+    ~Argon2Arena() { std::free(memory); }
+};
+
+thread_local Argon2Arena t_arena;
+
+int ArenaAllocate(uint8_t** memory, size_t bytes) {
+    if (t_arena.size < bytes) {
+        std::free(t_arena.memory);
+        size_t rounded = (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+        t_arena.memory = static_cast<uint8_t*>(std::aligned_alloc(ARENA_ALIGNMENT, rounded));
+        t_arena.size = t_arena.memory ? rounded : 0;
     }
+    *memory = t_arena.memory;
+    return *memory ? ARGON2_OK : ARGON2_MEMORY_ALLOCATION_ERROR;
+}
 
-    // Allocate buffer for hash output
-    std::vector<unsigned char> hash(HASH_LENGTH);
-
-    // Hash password using Argon2id
-    int result = argon2id_hash_raw(
-        TIME_COST,                          // t_cost (iterations)
-        MEMORY_COST_KB,                     // m_cost (memory in KB)
-        PARALLELISM,                        // parallelism (threads)
-        password.c_str(),                   // password
-        password.length(),                  // password length
-        salt.data(),                        // salt
-        SALT_LENGTH,                        // salt length
-        hash.data(),                        // output hash
-        HASH_LENGTH                         // hash length
-    );
+void ArenaDeallocate(uint8_t* /*memory*/, size_t /*bytes*/) {
+    // Kept for the next hash on this thread
+}
 
-    if (result != ARGON2_OK) {
-        throw std::runtime_error(std::string("Argon2 hashing failed: ") +
-                                 argon2_error_message(result));
+struct EncodedHash {
+    uint32_t memory_cost_kb = 0;
+    uint32_t time_cost = 0;
+    uint32_t parallelism = 0;
+    std::vector<uint8_t> salt;
+    std::vector<uint8_t> hash;
+};
+
+// Parses "$argon2id$v=19$m=<m>,t=<t>,p=<p>$<salt>$<hash>"
+std::optional<EncodedHash> ParseEncodedHash(const std::string& encoded) {
+    std::vector<std::string> parts;
+    std::stringstream ss(encoded);
+    std::string part;
+    while (std::getline(ss, part, '$')) {
+        parts.push_back(part);
+    }
+    if (parts.size() != 6 || !parts[0].empty() || parts[1] != "argon2id" || parts[2] != "v=19") {
+        return std::nullopt;
     }
 
-    // Encode to PHC string format (includes parameters, salt, and hash)
-    // Format: $argon2id$v=19$m=65536,t=3,p=4$salt$hash
-    size_t encoded_len = argon2_encodedlen(
-        TIME_COST,
-        MEMORY_COST_KB,
-        PARALLELISM,
-        SALT_LENGTH,
-        HASH_LENGTH,
-        Argon2_id
-    );
-
-    std::vector<char> encoded(encoded_len);
-
-    result = argon2id_hash_encoded(
-        TIME_COST,
-        MEMORY_COST_KB,
-        PARALLELISM,
-        password.c_str(),
-        password.length(),
-        salt.data(),
-        SALT_LENGTH,
-        HASH_LENGTH,
-        encoded.data(),
-        encoded_len
-    );
+    EncodedHash result;
+    int consumed = 0;
+    if (std::sscanf(parts[3].c_str(), "m=%u,t=%u,p=%u%n",
+                    &result.memory_cost_kb, &result.time_cost, &result.parallelism, &consumed) != 3 ||
+        static_cast<size_t>(consumed) != parts[3].size()) {
+        return std::nullopt;
+    }
+
+    // Argon2 PHC strings use standard base64 without padding
+    auto salt = Base64Decode(parts[4]);
+    auto hash = Base64Decode(parts[5]);
+    if (!salt || !hash || salt->empty() || hash->empty()) {
+        return std::nullopt;
+    }
+    result.salt = std::move(*salt);
+    result.hash = std::move(*hash);
+    return result;
+}
 
+int Argon2id(
+    const std::string& password,
+    uint32_t time_cost,
+    uint32_t memory_cost_kb,
+    uint32_t parallelism,
+    std::vector<uint8_t>& salt,
+    std::vector<uint8_t>& out,
+    PasswordHasher::Memory memory
+) {
+    argon2_context ctx{};
+    ctx.out = out.data();
+    ctx.outlen = static_cast<uint32_t>(out.size());
+    // Not modified: ARGON2_FLAG_CLEAR_PASSWORD is not set
+    ctx.pwd = reinterpret_cast<uint8_t*>(const_cast<char*>(password.data()));
+    ctx.pwdlen = static_cast<uint32_t>(password.size());
+    ctx.salt = salt.data();
+    ctx.saltlen = static_cast<uint32_t>(salt.size());
+    ctx.t_cost = time_cost;
+    ctx.m_cost = memory_cost_kb;
+    ctx.lanes = parallelism;
+    ctx.threads = parallelism;
+    ctx.version = ARGON2_VERSION_13;
+    ctx.flags = ARGON2_DEFAULT_FLAGS;
+    if (memory == PasswordHasher::Memory::THREAD_ARENA) {
+        ctx.allocate_cbk = ArenaAllocate;
+        ctx.free_cbk = ArenaDeallocate;
+    }
+    return argon2id_ctx(&ctx);
+}
+
+// Fastest of a few runs: the first pays for page faults, later ones for noise
+std::chrono::microseconds TimeHash(const PasswordHashPolicy& policy) {
+    constexpr int RUNS = 3;
+    auto fastest = std::chrono::microseconds::max();
+    for (int i = 0; i < RUNS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        PasswordHasher::HashPassword("calibration-password", policy);
+        fastest = std::min(fastest, std::chrono::duration_cast<std::chrono::microseconds>(
+                                        std::chrono::steady_clock::now() - start));
+    }
+    return fastest;
+}
+
+} // namespace
+
+std::string PasswordHashPolicy::ToString() const {
+    return "m=" + std::to_string(memory_cost_kb) + ",t=" + std::to_string(time_cost) +
+           ",p=" + std::to_string(parallelism);
+}
+
+PasswordHashPolicy PasswordHashPolicy::FromEnv() {
+    PasswordHashPolicy policy;
+    policy.memory_cost_kb = static_cast<uint32_t>(EnvInt("PASSWORD_HASH_MEMORY_KB", policy.memory_cost_kb));
+    policy.time_cost = std::max<uint32_t>(
+        1, static_cast<uint32_t>(EnvInt("PASSWORD_HASH_TIME_COST", policy.time_cost)));
+    policy.parallelism = std::max<uint32_t>(
+        1, static_cast<uint32_t>(EnvInt("PASSWORD_HASH_PARALLELISM", policy.parallelism)));
+    // Argon2 needs 8 KB per lane
+    policy.memory_cost_kb = std::max(policy.memory_cost_kb, 8 * policy.parallelism);
+
+    long calibrate_ms = EnvInt("PASSWORD_HASH_CALIBRATE_MS", 0);
+    if (calibrate_ms > 0) {
+        return Calibrate(std::chrono::milliseconds(calibrate_ms), policy);
+    }
+    return policy;
+}
+
+PasswordHashPolicy PasswordHashPolicy::Calibrate(std::chrono::milliseconds budget, const PasswordHashPolicy& start,
+                                                 unsigned cores, const Measure& measure) {
+    if (cores == 0) {
+        cores = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    PasswordHashPolicy policy = start;
+    policy.parallelism = std::max<uint32_t>(1, std::min<uint32_t>(start.parallelism, cores));
+    policy.memory_cost_kb = std::max(start.memory_cost_kb, MIN_MEMORY_COST_KB);
+
+    auto timed = measure ? measure : Measure(TimeHash);
+    auto budget_us = std::chrono::duration_cast<std::chrono::microseconds>(budget);
+
+    // One pass at the current memory; halve memory while the minimum passes do not fit
+    std::chrono::microseconds per_pass;
+    while (true) {
+        PasswordHashPolicy probe = policy;
+        probe.time_cost = 1;
+        per_pass = std::max(timed(probe), std::chrono::microseconds(1));
+
+        uint32_t smaller = std::max(policy.memory_cost_kb / 2, MIN_MEMORY_COST_KB);
+        if (per_pass * MIN_TIME_COST <= budget_us || smaller == policy.memory_cost_kb) {
+            break;
+        }
+        policy.memory_cost_kb = smaller;
+    }
+
+    auto passes = static_cast<uint64_t>(budget_us.count() / per_pass.count());
+    policy.time_cost = static_cast<uint32_t>(std::clamp<uint64_t>(passes, MIN_TIME_COST, MAX_TIME_COST));
+    return policy;
+}
+
+PasswordHashPolicy PasswordHasher::Policy() {
+    std::lock_guard<std::mutex> lock(g_policy_mutex);
+    return g_policy;
+}
+
+void PasswordHasher::SetPolicy(const PasswordHashPolicy& policy) {
+    std::lock_guard<std::mutex> lock(g_policy_mutex);
+    g_policy = policy;
+}
+
+bool PasswordHasher::NeedsRehash(const std::string& hash, const PasswordHashPolicy& policy) {
+    auto parsed = ParseEncodedHash(hash);
+    if (!parsed) {
+        return true;
+    }
+    PasswordHashPolicy stored{parsed->memory_cost_kb, parsed->time_cost, parsed->parallelism};
+    return stored.Cost() < policy.Cost();
+}
+
+std::string PasswordHasher::HashPassword(const std::string& password, Memory memory) {
+    return HashPassword(password, Policy(), memory);
+}
+
+std::string PasswordHasher::HashPassword(const std::string& password, const PasswordHashPolicy& policy,
+                                         Memory memory) {
+    // Generate random salt
+    std::vector<uint8_t> salt(SALT_LENGTH);
+    if (RAND_bytes(salt.data(), static_cast<int>(salt.size())) != 1) {
+        throw std::runtime_error("Failed to generate password salt");
+    }
+
+    // Single Argon2id pass; the PHC string is encoded from the raw output
+    std::vector<uint8_t> hash(HASH_LENGTH);
+    int result = Argon2id(password, policy.time_cost, policy.memory_cost_kb, policy.parallelism, salt, hash, memory);
     if (result != ARGON2_OK) {
-        throw std::runtime_error(std::string("Argon2 encoding failed: ") +
+        throw std::runtime_error(std::string("Argon2 hashing failed: ") +
                                  argon2_error_message(result));
     }
 
-    return std::string(encoded.data());
+    // Encode to PHC string format (includes parameters, salt, and hash)
+    // Format: $argon2id$v=19$m=65536,t=3,p=4$salt$hash
+    std::ostringstream encoded;
+    encoded << "$argon2id$v=" << ARGON2_VERSION_13
+            << "$" << policy.ToString()
+            << "$" << Base64Encode(salt.data(), salt.size(), Base64Alphabet::STANDARD, false)
+            << "$" << Base64Encode(hash.data(), hash.size(), Base64Alphabet::STANDARD, false);
+    return encoded.str();
 }
 
-bool PasswordHasher::VerifyPassword(const std::string& password, const std::string& hash) {
-    // Verify password against Argon2id hash
-    int result = argon2id_verify(
-        hash.c_str(),
-        password.c_str(),
-        password.length()
-    );
+bool PasswordHasher::VerifyPassword(const std::string& password, const std::string& hash, Memory memory) {
+    auto parsed = ParseEncodedHash(hash);
+    if (!parsed) {
+        // Not produced by HashPassword(); let libargon2 decode it
+        return argon2id_verify(hash.c_str(), password.c_str(), password.length()) == ARGON2_OK;
+    }
 
-    return result == ARGON2_OK;
+    std::vector<uint8_t> computed(parsed->hash.size());
+    int result = Argon2id(password, parsed->time_cost, parsed->memory_cost_kb, parsed->parallelism,
+                          parsed->salt, computed, memory);
+    if (result != ARGON2_OK) {
+        return false;
+    }
+    return CRYPTO_memcmp(computed.data(), parsed->hash.data(), computed.size()) == 0;
 }
 
 } // namespace common
@@ -0,0 +1,146 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Bounded worker pool for Argon2 password hashing implementation
+ */
+
+#include "common/password_hashing_pool.h"
+#include "common/env.h"
+#include "common/metrics.h"
+#include "common/tracing.h"
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+size_t ResolveWorkers(size_t workers) {
+    if (workers > 0) {
+        return workers;
+    }
+    // Each hash already runs PasswordHasher::Parallelism() threads internally
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, cores / PasswordHasher::Parallelism());
+}
+
+Histogram& Argon2Duration(const char* operation) {
+    return MetricsRegistry::Global().GetHistogram(
+        "saasforge_argon2_duration_seconds", "Argon2 time per password hash or verification",
+        HistogramOptions::LatencySeconds(), {{"operation", operation}});
+}
+
+Histogram& Argon2QueueWait() {
+    static Histogram& histogram = MetricsRegistry::Global().GetHistogram(
+        "saasforge_argon2_queue_wait_seconds", "Time a password hash waited for a worker",
+        HistogramOptions::LatencySeconds());
+    return histogram;
+}
+
+} // namespace
+
+PasswordHashingOptions PasswordHashingOptions::FromEnv() {
+    PasswordHashingOptions options;
+    options.workers = static_cast<size_t>(EnvInt("PASSWORD_HASH_WORKERS", static_cast<long>(options.workers)));
+    options.queue_capacity = static_cast<size_t>(
+        EnvInt("PASSWORD_HASH_QUEUE_CAPACITY", static_cast<long>(options.queue_capacity)));
+    return options;
+}
+
+PasswordHashingPool::PasswordHashingPool(const PasswordHashingOptions& options)
+    : executor_(ResolveWorkers(options.workers), options.queue_capacity) {
+    executor_.ExportMetrics("password_hashing");
+}
+
+PasswordHashingPool::~PasswordHashingPool() {
+    executor_.Shutdown();
+}
+
+std::string PasswordHashingPool::Hash(const std::string& password, PasswordHashTiming* timing,
+                                      TaskPriority priority) {
+    static Histogram& duration = Argon2Duration("hash");
+    Span span("argon2.hash");   // Queue wait included
+    return Run<std::string>([&password]() {
+        return PasswordHasher::HashPassword(password, PasswordHasher::Memory::THREAD_ARENA);
+    }, duration, timing, nullptr, priority);
+}
+
+bool PasswordHashingPool::Verify(const std::string& password, const std::string& hash, PasswordHashTiming* timing) {
+    return Verify(password, hash, std::function<void()>(), timing);
+}
+
+bool PasswordHashingPool::Verify(const std::string& password, const std::string& hash,
+                                 const std::function<void()>& meanwhile, PasswordHashTiming* timing) {
+    static Histogram& duration = Argon2Duration("verify");
+    Span span("argon2.verify");
+    return Run<bool>([&password, &hash]() {
+        return PasswordHasher::VerifyPassword(password, hash, PasswordHasher::Memory::THREAD_ARENA);
+    }, duration, timing, &meanwhile);
+}
+
+template <typename Result, typename Fn>
+Result PasswordHashingPool::Run(Fn fn, Histogram& duration, PasswordHashTiming* timing,
+                                const std::function<void()>* meanwhile, TaskPriority priority) {
+    using Clock = std::chrono::steady_clock;
+
+    struct Times {
+        Clock::time_point started;
+        Clock::time_point finished;
+    };
+
+    // The caller blocks on the future, so references captured by fn stay valid
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto future = promise->get_future();
+    auto times = std::make_shared<Times>();
+    auto submitted = Clock::now();
+
+    bool admitted = executor_.TrySubmit([this, promise, times, fn, submitted, &duration]() {
+        times->started = Clock::now();
+        Argon2QueueWait().RecordDuration(times->started - submitted);
+        // Counted before the caller is released, so it sees its own call in CompletedCount()
+        try {
+            Result value = fn();
+            times->finished = Clock::now();
+            duration.RecordDuration(times->finished - times->started);
+            completed_.fetch_add(1, std::memory_order_relaxed);
+            promise->set_value(std::move(value));
+        } catch (...) {
+            times->finished = Clock::now();
+            completed_.fetch_add(1, std::memory_order_relaxed);
+            promise->set_exception(std::current_exception());
+        }
+    }, priority);
+    if (!admitted) {
+        throw PasswordHashingOverloaded();
+    }
+
+    // Whatever meanwhile throws waits for the hash: fn's references must outlive it
+    std::exception_ptr meanwhile_error;
+    if (meanwhile && *meanwhile) {
+        try {
+            (*meanwhile)();
+        } catch (...) {
+            meanwhile_error = std::current_exception();
+        }
+    }
+
+    // set_value() happens-before get(), so times is safe to read afterwards
+    future.wait();
+    if (meanwhile_error) {
+        std::rethrow_exception(meanwhile_error);
+    }
+    Result result = future.get();
+    if (timing) {
+        timing->queued = std::chrono::duration_cast<std::chrono::microseconds>(times->started - submitted);
+        timing->hashing = std::chrono::duration_cast<std::chrono::microseconds>(times->finished - times->started);
+    }
+    return result;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,437 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Compressed, content-addressed storage of queued payloads implementation
+ */
+
+#include "common/payload_codec.h"
+#include "common/codec.h"
+#include "common/sha256.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <zlib.h>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <stdexcept>
+#include <string_view>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+// Oldest first, so each scope ends up with its newest dictionary
+const PreparedStatement kSelectDictionaries(
+    "payload_select_dictionaries",
+    "SELECT id, scope, data FROM payload_dictionaries ORDER BY created_at, id");
+
+const PreparedStatement kInsertDictionary(
+    "payload_insert_dictionary",
+    "INSERT INTO payload_dictionaries (id, scope, data, created_at) "
+    "VALUES ($1, $2, $3::bytea, NOW()) ON CONFLICT (id) DO NOTHING RETURNING id");
+
+constexpr unsigned char RAW_MARKER = 0x00;          // Never the first byte of a zlib stream (0x78)
+constexpr size_t MAX_DECODED_SIZE = 64 * 1024 * 1024;
+constexpr size_t MAX_SAMPLE_SIZE = 16 * 1024;       // Leading bytes of a payload kept for training
+
+// Content-defined fragments for training: boundaries depend on the bytes
+// around them, not their offset, so text shifted by a differing value
+// still splits into the same fragments (gear hash, as in FastCDC)
+constexpr size_t MIN_FRAGMENT = 8;
+constexpr size_t MAX_FRAGMENT = 256;
+constexpr uint64_t FRAGMENT_MASK = 31;              // ~32-byte fragments
+
+const std::array<uint64_t, 256>& GearTable() {
+    static const std::array<uint64_t, 256> table = [] {
+        std::array<uint64_t, 256> values{};
+        uint64_t state = 0x9e3779b97f4a7c15ULL;
+        for (auto& value : values) {
+            // splitmix64
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            value = z ^ (z >> 31);
+        }
+        return values;
+    }();
+    return table;
+}
+
+template <typename Fn>
+void ForEachFragment(std::string_view data, Fn&& fn) {
+    const auto& gear = GearTable();
+    size_t start = 0;
+    uint64_t hash = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        hash = (hash << 1) + gear[static_cast<unsigned char>(data[i])];
+        size_t length = i + 1 - start;
+        if ((length >= MIN_FRAGMENT && (hash & FRAGMENT_MASK) == 0) || length >= MAX_FRAGMENT) {
+            fn(data.substr(start, length));
+            start = i + 1;
+            hash = 0;
+        }
+    }
+}
+
+const unsigned char* Bytes(std::string_view data) {
+    return reinterpret_cast<const unsigned char*>(data.data());
+}
+
+} // namespace
+
+PayloadCodecOptions PayloadCodecOptions::FromEnv() {
+    PayloadCodecOptions options;
+    options.min_size = static_cast<size_t>(
+        EnvInt("PAYLOAD_STORE_MIN_BYTES", static_cast<long>(options.min_size)));
+    options.level = static_cast<int>(
+        std::clamp(EnvInt("PAYLOAD_COMPRESSION_LEVEL", options.level), 1L, 9L));
+    options.dictionary_samples = static_cast<size_t>(
+        EnvInt("PAYLOAD_DICTIONARY_SAMPLES", static_cast<long>(options.dictionary_samples)));
+    return options;
+}
+
+void PayloadBlobs::Add(const StoredPayload& payload) {
+    if (payload.Inline() || std::find(hashes_.begin(), hashes_.end(), payload.hash) != hashes_.end()) {
+        return;
+    }
+    hashes_.push_back(payload.hash);
+    data_.push_back(payload.data);
+}
+
+std::string PayloadBlobs::Hashes() const {
+    return ToArrayLiteral(hashes_);
+}
+
+std::string PayloadBlobs::Data() const {
+    return ToArrayLiteral(data_);
+}
+
+PayloadCodec::PayloadCodec(std::shared_ptr<DbPool> db_pool, const PayloadCodecOptions& options)
+    : db_pool_(std::move(db_pool)), options_(options) {
+    options_.level = std::clamp(options_.level, 1, 9);
+}
+
+StoredPayload PayloadCodec::Store(std::string_view payload, const std::string& scope) {
+    StoredPayload stored;
+    if (payload.size() < options_.min_size) {
+        stored.text.assign(payload);
+        return stored;
+    }
+    stored.hash = "\\x" + Sha256::Hex(payload);
+    stored.data = ToBytea(Encode(payload, scope));
+    Sample(payload, scope);
+    return stored;
+}
+
+std::string PayloadCodec::Encode(std::string_view payload, const std::string& scope) {
+    auto dictionary = ScopeDictionary(scope);
+
+    z_stream stream{};
+    if (deflateInit(&stream, options_.level) != Z_OK) {
+        throw std::runtime_error("Failed to initialize deflate");
+    }
+    if (dictionary && deflateSetDictionary(&stream, Bytes(*dictionary),
+                                           static_cast<uInt>(dictionary->size())) != Z_OK) {
+        deflateEnd(&stream);
+        throw std::runtime_error("Failed to set deflate dictionary");
+    }
+
+    std::string encoded(deflateBound(&stream, static_cast<uLong>(payload.size())), '\0');
+    stream.next_in = const_cast<Bytef*>(Bytes(payload));
+    stream.avail_in = static_cast<uInt>(payload.size());
+    stream.next_out = reinterpret_cast<Bytef*>(encoded.data());
+    stream.avail_out = static_cast<uInt>(encoded.size());
+    int result = deflate(&stream, Z_FINISH);
+    size_t size = stream.total_out;
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("deflate failed");
+    }
+
+    if (size >= payload.size() + 1) {
+        // Incompressible: stored as is behind the marker
+        std::string raw;
+        raw.reserve(payload.size() + 1);
+        raw += static_cast<char>(RAW_MARKER);
+        raw.append(payload);
+        return raw;
+    }
+    encoded.resize(size);
+    return encoded;
+}
+
+std::string PayloadCodec::Decode(std::string_view encoded) {
+    if (encoded.empty()) {
+        throw std::runtime_error("Empty encoded payload");
+    }
+    if (static_cast<unsigned char>(encoded[0]) == RAW_MARKER) {
+        return std::string(encoded.substr(1));
+    }
+
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK) {
+        throw std::runtime_error("Failed to initialize inflate");
+    }
+    stream.next_in = const_cast<Bytef*>(Bytes(encoded));
+    stream.avail_in = static_cast<uInt>(encoded.size());
+
+    std::string decoded(std::max<size_t>(encoded.size() * 4, 1024), '\0');
+    int result = Z_OK;
+    while (true) {
+        if (stream.total_out == decoded.size()) {
+            if (decoded.size() >= MAX_DECODED_SIZE) {
+                result = Z_BUF_ERROR;
+                break;
+            }
+            decoded.resize(std::min(decoded.size() * 2, MAX_DECODED_SIZE));
+        }
+        stream.next_out = reinterpret_cast<Bytef*>(decoded.data() + stream.total_out);
+        stream.avail_out = static_cast<uInt>(decoded.size() - stream.total_out);
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result == Z_NEED_DICT) {
+            auto dictionary = FindDictionary(static_cast<uint32_t>(stream.adler));
+            if (!dictionary) {
+                uint32_t id = static_cast<uint32_t>(stream.adler);
+                inflateEnd(&stream);
+                throw std::runtime_error("Unknown payload dictionary " + std::to_string(id));
+            }
+            result = inflateSetDictionary(&stream, Bytes(*dictionary), static_cast<uInt>(dictionary->size()));
+        }
+        if (result == Z_STREAM_END || (result != Z_OK && result != Z_BUF_ERROR)) {
+            break;
+        }
+        if (result == Z_BUF_ERROR && stream.avail_in == 0) {
+            break;   // Truncated
+        }
+    }
+    size_t size = stream.total_out;
+    inflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("Corrupt encoded payload");
+    }
+    decoded.resize(size);
+    return decoded;
+}
+
+std::string PayloadCodec::DecodeBytea(std::string_view bytea) {
+    return Decode(FromBytea(bytea));
+}
+
+void PayloadCodec::AddDictionary(const std::string& scope, std::string dictionary) {
+    auto shared = std::make_shared<const std::string>(std::move(dictionary));
+    std::lock_guard<std::mutex> lock(mutex_);
+    by_id_[DictionaryId(*shared)] = shared;
+    by_scope_[scope] = shared;
+}
+
+size_t PayloadCodec::Dictionaries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return by_id_.size();
+}
+
+std::string PayloadCodec::TrainDictionary(const std::vector<std::string>& samples, size_t max_size) {
+    max_size = std::min(max_size, MAX_DICTIONARY_SIZE);
+
+    // Samples each fragment appears in (counted once per sample)
+    struct Count {
+        size_t samples = 0;
+        size_t last = 0;    // 1 + index of the sample that last counted it
+    };
+    std::unordered_map<std::string_view, Count> counts;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        ForEachFragment(samples[i], [&](std::string_view fragment) {
+            auto& count = counts[fragment];
+            if (count.last != i + 1) {
+                ++count.samples;
+                count.last = i + 1;
+            }
+        });
+    }
+
+    std::vector<std::pair<std::string_view, size_t>> recurring;
+    for (const auto& [fragment, count] : counts) {
+        if (count.samples >= 2) {
+            recurring.emplace_back(fragment, count.samples);
+        }
+    }
+    // Most bytes saved first, until the dictionary is full
+    std::sort(recurring.begin(), recurring.end(), [](const auto& a, const auto& b) {
+        size_t saved_a = a.first.size() * a.second;
+        size_t saved_b = b.first.size() * b.second;
+        return saved_a != saved_b ? saved_a > saved_b : a.first < b.first;
+    });
+    size_t size = 0;
+    size_t kept = 0;
+    for (; kept < recurring.size() && size + recurring[kept].first.size() <= max_size; ++kept) {
+        size += recurring[kept].first.size();
+    }
+    recurring.resize(kept);
+
+    // Least common first: the most common then sit nearest the data
+    std::sort(recurring.begin(), recurring.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second < b.second : a.first < b.first;
+    });
+    std::string dictionary;
+    dictionary.reserve(size);
+    for (const auto& entry : recurring) {
+        dictionary.append(entry.first);
+    }
+    return dictionary;
+}
+
+uint32_t PayloadCodec::DictionaryId(std::string_view dictionary) {
+    uLong adler = adler32(0L, Z_NULL, 0);
+    return static_cast<uint32_t>(adler32(adler, Bytes(dictionary), static_cast<uInt>(dictionary.size())));
+}
+
+std::string PayloadCodec::ToBytea(std::string_view bytes) {
+    std::string literal(2 + HexEncodedLength(bytes.size()), '\0');
+    literal[0] = '\\';
+    literal[1] = 'x';
+    HexEncode(Bytes(bytes), bytes.size(), literal.data() + 2);
+    return literal;
+}
+
+std::string PayloadCodec::FromBytea(std::string_view text) {
+    if (text.size() < 2 || text[0] != '\\' || text[1] != 'x') {
+        throw std::runtime_error("Expected hex bytea output");
+    }
+    std::string bytes((text.size() - 2) / 2, '\0');
+    if (!HexDecode(text.substr(2), reinterpret_cast<unsigned char*>(bytes.data()))) {
+        throw std::runtime_error("Malformed hex bytea output");
+    }
+    return bytes;
+}
+
+std::shared_ptr<const std::string> PayloadCodec::ScopeDictionary(const std::string& scope) {
+    bool load = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = std::chrono::steady_clock::now();
+        if (!loaded_ && db_pool_ && (!loaded_at_ || now - *loaded_at_ >= options_.reload_interval)) {
+            loaded_at_ = now;
+            load = true;
+        } else {
+            auto it = by_scope_.find(scope);
+            return it == by_scope_.end() ? nullptr : it->second;
+        }
+    }
+    if (load) {
+        LoadDictionaries();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = by_scope_.find(scope);
+    return it == by_scope_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const std::string> PayloadCodec::FindDictionary(uint32_t id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = by_id_.find(id);
+        if (it != by_id_.end()) {
+            return it->second;
+        }
+        // Another replica trained it since we last looked
+        auto now = std::chrono::steady_clock::now();
+        if (!db_pool_ || (loaded_at_ && now - *loaded_at_ < options_.reload_interval)) {
+            return nullptr;
+        }
+        loaded_at_ = now;
+    }
+    LoadDictionaries();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = by_id_.find(id);
+    return it == by_id_.end() ? nullptr : it->second;
+}
+
+void PayloadCodec::Sample(std::string_view payload, const std::string& scope) {
+    if (options_.dictionary_samples == 0) {
+        return;
+    }
+    std::vector<std::string> samples;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (by_scope_.count(scope) > 0) {
+            return;
+        }
+        auto it = sampling_.find(scope);
+        if (it == sampling_.end()) {
+            if (sampling_.size() >= options_.max_sampled_scopes) {
+                return;
+            }
+            it = sampling_.emplace(scope, std::vector<std::string>{}).first;
+        }
+        it->second.emplace_back(payload.substr(0, MAX_SAMPLE_SIZE));
+        if (it->second.size() < options_.dictionary_samples) {
+            return;
+        }
+        samples = std::move(it->second);
+        sampling_.erase(it);
+        by_scope_[scope] = nullptr;   // Not sampled again, whatever training yields
+    }
+    TrainScope(scope, std::move(samples));
+}
+
+void PayloadCodec::TrainScope(const std::string& scope, std::vector<std::string> samples) {
+    std::string dictionary = TrainDictionary(samples);
+    if (dictionary.empty()) {
+        LogDebug("No payload dictionary trained", {{"scope", scope}, {"samples", samples.size()}});
+        return;
+    }
+    uint32_t id = DictionaryId(dictionary);
+
+    if (db_pool_) {
+        // Stored before use, so every replica can decode what this one writes
+        try {
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
+            auto result = ExecPrepared(txn, kInsertDictionary, static_cast<int64_t>(id), scope, ToBytea(dictionary));
+            txn.commit();
+            if (result.empty()) {
+                // Adler-32 collision with a stored dictionary: readers would pick that one
+                LogWarn("Payload dictionary id already taken", {{"scope", scope},
+                                                                 {"dictionary_id", static_cast<int64_t>(id)}});
+                return;
+            }
+        } catch (const std::exception& e) {
+            LogWarn("Failed to store payload dictionary", {{"scope", scope}, {"error", e.what()}});
+            return;
+        }
+    }
+    LogInfo("Payload dictionary trained", {{"scope", scope}, {"dictionary_id", static_cast<int64_t>(id)},
+                                           {"size", dictionary.size()}, {"samples", samples.size()}});
+    AddDictionary(scope, std::move(dictionary));
+}
+
+void PayloadCodec::LoadDictionaries() {
+    std::vector<std::pair<std::string, std::string>> loaded;   // (scope, dictionary), oldest first
+    try {
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
+        auto result = ExecPrepared(txn, kSelectDictionaries);
+        txn.commit();
+        for (const auto& row : result) {
+            loaded.emplace_back(row["scope"].c_str(), FromBytea(row["data"].c_str()));
+        }
+    } catch (const std::exception& e) {
+        // Payloads are still stored, without dictionaries; retried after reload_interval
+        LogWarn("Failed to load payload dictionaries", {{"error", e.what()}});
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [scope, data] : loaded) {
+        auto shared = std::make_shared<const std::string>(std::move(data));
+        by_id_[DictionaryId(*shared)] = shared;
+        by_scope_[scope] = shared;
+        sampling_.erase(scope);
+    }
+    loaded_ = true;
+}
+
+} // namespace common
+} // namespace saasforge
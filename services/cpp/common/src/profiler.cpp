@@ -0,0 +1,167 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description On-demand CPU and heap profiles implementation
+ */
+
+#include "common/profiler.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+#ifdef SAASFORGE_ALLOCATOR_TCMALLOC
+#include <gperftools/malloc_extension.h>
+#endif
+
+// C entry points of gperftools' CPU profiler and jemalloc, weak so the
+// build does not need either: null unless linked or preloaded
+extern "C" {
+int ProfilerStart(const char* fname) __attribute__((weak));
+void ProfilerStop() __attribute__((weak));
+int mallctl(const char* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen) __attribute__((weak));
+}
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr auto CANCEL_POLL = std::chrono::milliseconds(100);
+
+/// Fresh file for a profile to be written to
+std::string TempPath(const char* kind) {
+    std::string path = EnvString("TMPDIR", "/tmp") + "/saasforge-" + kind + "-XXXXXX";
+    int fd = ::mkstemp(path.data());
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Cannot create profile file: ") + std::strerror(errno));
+    }
+    ::close(fd);
+    return path;
+}
+
+std::string ReadAndRemove(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    ::unlink(path.c_str());
+    return contents.str();
+}
+
+std::string JemallocHeapProfile() {
+    bool enabled = false;
+    size_t length = sizeof(enabled);
+    if (mallctl("opt.prof", &enabled, &length, nullptr, 0) != 0 || !enabled) {
+        throw ProfilerUnavailable(
+            "jemalloc heap profiling is off; start the service with MALLOC_CONF=prof:true,lg_prof_sample:19");
+    }
+    std::string path = TempPath("heap");
+    const char* file = path.c_str();
+    if (mallctl("prof.dump", nullptr, nullptr, &file, sizeof(file)) != 0) {
+        ::unlink(path.c_str());
+        throw std::runtime_error("jemalloc prof.dump failed");
+    }
+    return ReadAndRemove(path);
+}
+
+#ifdef SAASFORGE_ALLOCATOR_TCMALLOC
+std::string TcmallocHeapProfile() {
+    if (EnvInt("TCMALLOC_SAMPLE_PARAMETER", 0) <= 0) {
+        throw ProfilerUnavailable(
+            "tcmalloc heap sampling is off; start the service with TCMALLOC_SAMPLE_PARAMETER=524288");
+    }
+    std::string profile;
+    MallocExtension::instance()->GetHeapSample(&profile);
+    return profile;
+}
+#endif
+
+Profiler::Backend DefaultBackend() {
+    Profiler::Backend backend;
+    if (ProfilerStart && ProfilerStop) {
+        backend.cpu_name = "gperftools";
+        backend.start_cpu = [](const std::string& path) { return ProfilerStart(path.c_str()) != 0; };
+        backend.stop_cpu = [] { ProfilerStop(); };
+    }
+    // A linked or preloaded jemalloc is the allocator in use, even in a tcmalloc build
+    if (mallctl) {
+        backend.heap_name = "jemalloc";
+        backend.heap_profile = JemallocHeapProfile;
+    }
+#ifdef SAASFORGE_ALLOCATOR_TCMALLOC
+    else {
+        backend.heap_name = "tcmalloc";
+        backend.heap_profile = TcmallocHeapProfile;
+    }
+#endif
+    return backend;
+}
+
+} // namespace
+
+ProfilingOptions ProfilingOptions::FromEnv() {
+    ProfilingOptions options;
+    options.token = EnvString("PROFILING_TOKEN", options.token);
+    options.max_cpu_duration = std::chrono::seconds(std::max(1L,
+        EnvInt("PROFILING_MAX_SECONDS", static_cast<long>(options.max_cpu_duration.count()))));
+    options.default_cpu_duration = std::min(options.default_cpu_duration, options.max_cpu_duration);
+    return options;
+}
+
+Profiler::Profiler(Backend backend) : backend_(std::move(backend)) {}
+
+Profiler& Profiler::Default() {
+    static Profiler profiler(DefaultBackend());
+    return profiler;
+}
+
+std::string Profiler::CpuProfile(std::chrono::milliseconds duration, const std::function<bool()>& cancelled) {
+    if (!CpuAvailable()) {
+        throw ProfilerUnavailable("CPU profiling needs gperftools (link libprofiler or preload it)");
+    }
+    std::unique_lock<std::mutex> lock(cpu_mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        throw ProfilerBusy();
+    }
+
+    std::string path = TempPath("cpu");
+    if (!backend_.start_cpu(path)) {
+        ::unlink(path.c_str());
+        // gperftools refuses while a profile it started itself (CPUPROFILE) is running
+        throw std::runtime_error("CPU profiler failed to start (is CPUPROFILE set?)");
+    }
+    LogInfo("CPU profile started", {{"backend", backend_.cpu_name}, {"duration_ms", duration.count()}});
+
+    auto started = std::chrono::steady_clock::now();
+    auto deadline = started + duration;
+    while (std::chrono::steady_clock::now() < deadline && !(cancelled && cancelled())) {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            CANCEL_POLL, deadline - std::chrono::steady_clock::now()));
+    }
+    backend_.stop_cpu();
+
+    std::string profile = ReadAndRemove(path);
+    LogInfo("CPU profile finished", {
+        {"duration_ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count()},
+        {"bytes", profile.size()}
+    });
+    return profile;
+}
+
+std::string Profiler::HeapProfile() {
+    if (!HeapAvailable()) {
+        throw ProfilerUnavailable("Heap profiling needs jemalloc or tcmalloc (SAASFORGE_ALLOCATOR)");
+    }
+    std::string profile = backend_.heap_profile();
+    LogInfo("Heap profile taken", {{"backend", backend_.heap_name}, {"bytes", profile.size()}});
+    return profile;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,151 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description LISTEN/NOTIFY wakeups implementation
+ */
+
+#include "common/queue_notifier.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// await_notification() returns as soon as a NOTIFY arrives; the slice only
+// bounds how long Shutdown() waits for the listener thread
+constexpr long WAIT_SLICE_US = 250000;
+
+class ChannelReceiver : public pqxx::notification_receiver {
+public:
+    ChannelReceiver(pqxx::connection& conn, const std::string& channel, std::function<void()> on_notify)
+        : pqxx::notification_receiver(conn, channel), on_notify_(std::move(on_notify)) {}
+
+    void operator()(const std::string& payload, int backend_pid) override {
+        on_notify_();
+    }
+
+private:
+    std::function<void()> on_notify_;
+};
+
+} // namespace
+
+QueueNotifierOptions QueueNotifierOptions::FromEnv() {
+    QueueNotifierOptions options;
+    options.reconnect_delay = std::chrono::milliseconds(
+        EnvInt("QUEUE_NOTIFY_RECONNECT_DELAY_MS", static_cast<long>(options.reconnect_delay.count())));
+    options.fallback_poll = std::chrono::milliseconds(
+        EnvInt("QUEUE_NOTIFY_FALLBACK_POLL_MS", static_cast<long>(options.fallback_poll.count())));
+    return options;
+}
+
+QueueNotifier::QueueNotifier(
+    const std::string& connection_string,
+    const std::vector<std::string>& channels,
+    const QueueNotifierOptions& options
+) : connection_string_(connection_string), channels_(channels), options_(options) {
+    if (channels_.empty()) {
+        throw std::invalid_argument("QueueNotifier requires at least one channel");
+    }
+    for (const auto& channel : channels_) {
+        generations_[channel] = 0;
+    }
+    listener_thread_ = std::thread(&QueueNotifier::ListenLoop, this);
+}
+
+QueueNotifier::~QueueNotifier() {
+    Shutdown();
+}
+
+void QueueNotifier::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_.exchange(true)) {
+            return;
+        }
+    }
+    cv_.notify_all();
+    if (listener_thread_.joinable()) {
+        listener_thread_.join();
+    }
+}
+
+uint64_t QueueNotifier::Generation(const std::string& channel) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = generations_.find(channel);
+    if (it == generations_.end()) {
+        throw std::invalid_argument("QueueNotifier is not listening on channel: " + channel);
+    }
+    return it->second;
+}
+
+bool QueueNotifier::WaitForChange(const std::string& channel, uint64_t seen, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = generations_.find(channel);
+    if (it == generations_.end()) {
+        throw std::invalid_argument("QueueNotifier is not listening on channel: " + channel);
+    }
+    // Map nodes are stable, so the reference survives the unlocked wait
+    const uint64_t& generation = it->second;
+    return cv_.wait_for(lock, timeout, [&] {
+        return generation != seen || shutdown_.load();
+    }) && generation != seen;
+}
+
+void QueueNotifier::Bump(const std::string& channel) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generations_[channel];
+    }
+    cv_.notify_all();
+}
+
+void QueueNotifier::BumpAll() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : generations_) {
+            ++entry.second;
+        }
+    }
+    cv_.notify_all();
+}
+
+void QueueNotifier::ListenLoop() {
+    while (!shutdown_.load()) {
+        try {
+            pqxx::connection conn(connection_string_);
+
+            std::vector<std::unique_ptr<ChannelReceiver>> receivers;
+            for (const auto& channel : channels_) {
+                receivers.push_back(std::make_unique<ChannelReceiver>(
+                    conn, channel, [this, channel] { Bump(channel); }));
+            }
+
+            connected_.store(true);
+            LogInfo("QueueNotifier listening", {{"channels", channels_.size()}});
+
+            // Rows committed before LISTEN took effect never produce a wakeup
+            BumpAll();
+
+            while (!shutdown_.load()) {
+                conn.await_notification(0, WAIT_SLICE_US);
+            }
+        } catch (const std::exception& e) {
+            LogError("QueueNotifier connection error", {{"error", e.what()}});
+        }
+
+        connected_.store(false);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, options_.reconnect_delay, [this] { return shutdown_.load(); });
+    }
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,110 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Queue partition maintenance implementation
+ */
+
+#include "common/queue_partitions.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <algorithm>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const PreparedStatement kMaintainPartitions(
+    "queue_maintain_partitions",
+    "SELECT created, dropped, purged FROM queue_maintain_partitions($1, $2, $3)");
+
+// Blobs no insert has touched since every row that could reference them
+// was dropped (see PAYLOAD_BLOBS_CTE): retention plus a day partition's life
+const PreparedStatement kPurgePayloadBlobs(
+    "queue_purge_payload_blobs",
+    "DELETE FROM payload_blobs WHERE last_used_at < NOW() - make_interval(days => $1 + 2)");
+
+} // namespace
+
+QueuePartitionOptions QueuePartitionOptions::FromEnv() {
+    QueuePartitionOptions options;
+    options.retention_days = static_cast<int>(
+        std::max(1L, EnvInt("QUEUE_RETENTION_DAYS", options.retention_days)));
+    options.premake_days = static_cast<int>(
+        std::max(1L, EnvInt("QUEUE_PARTITION_PREMAKE_DAYS", options.premake_days)));
+    options.interval = std::chrono::seconds(
+        EnvInt("QUEUE_MAINTENANCE_INTERVAL_S", static_cast<long>(options.interval.count())));
+    return options;
+}
+
+QueuePartitionMaintainer::QueuePartitionMaintainer(std::shared_ptr<DbPool> db_pool, std::vector<std::string> queues,
+                                                   const QueuePartitionOptions& options)
+    : QueuePartitionMaintainer(
+          [db_pool](const std::string& queue, const QueuePartitionOptions& options) {
+              auto conn_guard = db_pool->AcquireConnection("QueuePartitionMaintainer::RunOnce");
+              pqxx::work txn(*conn_guard);
+              auto result = ExecPrepared(txn, kMaintainPartitions, queue, options.retention_days,
+                                         options.premake_days);
+              auto blobs = ExecPrepared(txn, kPurgePayloadBlobs, options.retention_days);
+              txn.commit();
+
+              PartitionMaintenance maintenance;
+              maintenance.created = result[0][0].as<int>();
+              maintenance.dropped = result[0][1].as<int>();
+              maintenance.purged = result[0][2].as<int64_t>();
+              maintenance.blobs_purged = static_cast<int64_t>(blobs.affected_rows());
+              return maintenance;
+          },
+          std::move(queues), options) {}
+
+QueuePartitionMaintainer::QueuePartitionMaintainer(Step step, std::vector<std::string> queues,
+                                                   const QueuePartitionOptions& options)
+    : step_(std::move(step)), queues_(std::move(queues)), options_(options) {
+    if (options_.interval.count() <= 0) {
+        options_.interval = std::chrono::seconds(1);
+    }
+    // First pass at start: a process that was down past premake_days would
+    // otherwise write into the default partition until the next interval
+    periodic_ = Executor::Background().SchedulePeriodic(
+        std::chrono::duration_cast<std::chrono::milliseconds>(options_.interval), [this] { RunOnce(); });
+}
+
+QueuePartitionMaintainer::~QueuePartitionMaintainer() {
+    Shutdown();
+}
+
+void QueuePartitionMaintainer::Shutdown() {
+    Executor::Background().Cancel(periodic_);
+}
+
+bool QueuePartitionMaintainer::RunOnce() {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+
+    bool ok = true;
+    for (const auto& queue : queues_) {
+        try {
+            auto maintenance = step_(queue, options_);
+            if (maintenance.created > 0 || maintenance.dropped > 0 || maintenance.purged > 0 ||
+                maintenance.blobs_purged > 0) {
+                LogInfo("Queue partitions maintained", {
+                    {"queue", queue},
+                    {"created", maintenance.created},
+                    {"dropped", maintenance.dropped},
+                    {"purged", maintenance.purged},
+                    {"blobs_purged", maintenance.blobs_purged}
+                });
+            }
+        } catch (const std::exception& e) {
+            ok = false;
+            ++failures_;
+            LogError("Queue partition maintenance failed", {{"queue", queue}, {"error", e.what()}});
+        }
+    }
+    return ok;
+}
+
+} // namespace common
+} // namespace saasforge
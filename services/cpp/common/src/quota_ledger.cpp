@@ -0,0 +1,349 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Quota ledger implementation
+ */
+
+#include "common/quota_ledger.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/string_builder.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr const char* KEY_PREFIX = "quota:";
+constexpr size_t MAX_HEADROOM_ENTRIES = 100000;
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+// Pending uploads older than a day are treated as abandoned
+const PreparedStatement kLoadQuotaUsage(
+    "quota_load_usage",
+    "SELECT COALESCE(q.used_bytes, 0) + COALESCE(("
+    "    SELECT SUM(o.size) FROM upload_objects o "
+    "    WHERE o.tenant_id = $1 AND o.status = 'pending' AND o.deleted_at IS NULL "
+    "      AND o.created_at > NOW() - INTERVAL '1 day'), 0) AS used_bytes, "
+    "  COALESCE(q.limit_bytes, 10737418240) AS limit_bytes "
+    "FROM (SELECT $1::uuid AS tenant_id) AS t "
+    "LEFT JOIN quotas q ON q.tenant_id = t.tenant_id");
+
+// One row per tenant; the insert leg never goes negative (quota_used_positive)
+const PreparedStatement kFlushQuotaDeltas(
+    "quota_flush_deltas",
+    "INSERT INTO quotas AS q (tenant_id, used_bytes) "
+    "SELECT t, GREATEST(d, 0) FROM unnest($1::uuid[], $2::bigint[]) AS u(t, d) "
+    "ON CONFLICT (tenant_id) DO UPDATE SET "
+    "  used_bytes = GREATEST(q.used_bytes + ("
+    "      SELECT d FROM unnest($1::uuid[], $2::bigint[]) AS u(t, d) WHERE u.t = EXCLUDED.tenant_id), 0), "
+    "  updated_at = NOW()");
+
+// Returns {1, headroom} when granted, {0, headroom} when over the limit,
+// {-1, 0} when the counter has not been seeded
+const std::string RESERVE_LUA = R"(
+local v = redis.call('HMGET', KEYS[1], 'used', 'limit')
+if not v[2] then
+    return {-1, 0}
+end
+local used = tonumber(v[1])
+local limit = tonumber(v[2])
+local bytes = tonumber(ARGV[1])
+if used + bytes > limit then
+    return {0, limit - used}
+end
+used = redis.call('HINCRBY', KEYS[1], 'used', bytes)
+return {1, limit - used}
+)";
+
+const std::string SEED_LUA = R"(
+if redis.call('EXISTS', KEYS[1]) == 1 then
+    return 0
+end
+redis.call('HSET', KEYS[1], 'used', ARGV[1], 'limit', ARGV[2])
+redis.call('EXPIRE', KEYS[1], ARGV[3])
+return 1
+)";
+
+const std::string RELEASE_LUA = R"(
+if redis.call('EXISTS', KEYS[1]) == 0 then
+    return 0
+end
+if redis.call('HINCRBY', KEYS[1], 'used', -tonumber(ARGV[1])) < 0 then
+    redis.call('HSET', KEYS[1], 'used', 0)
+end
+return 1
+)";
+
+} // namespace
+
+QuotaLedgerOptions QuotaLedgerOptions::FromEnv() {
+    QuotaLedgerOptions options;
+    options.counter_ttl = std::chrono::seconds(
+        EnvInt("QUOTA_COUNTER_TTL_S", static_cast<long>(options.counter_ttl.count())));
+    options.local_ttl = std::chrono::milliseconds(
+        EnvInt("QUOTA_LOCAL_TTL_MS", static_cast<long>(options.local_ttl.count())));
+    options.flush_interval = std::chrono::milliseconds(
+        EnvInt("QUOTA_FLUSH_INTERVAL_MS", static_cast<long>(options.flush_interval.count())));
+    return options;
+}
+
+QuotaLedgerBackend QuotaLedgerBackend::Default(std::shared_ptr<RedisClient> redis, std::shared_ptr<DbPool> db_pool) {
+    QuotaLedgerBackend backend;
+    backend.reserve = [redis](const std::string& tenant_id, int64_t bytes) -> std::optional<QuotaReservation> {
+        KeyBuilder<> key(KEY_PREFIX, tenant_id);
+        KeyBuilder<24> bytes_arg(bytes);
+        auto reply = redis->EvalScriptArray(RESERVE_LUA, {key.View()}, {bytes_arg.View()});
+        if (reply.size() != 2) {
+            throw std::runtime_error("Unexpected quota reserve reply");
+        }
+        if (reply[0] < 0) {
+            return std::nullopt;
+        }
+        return QuotaReservation{reply[0] == 1, reply[1]};
+    };
+    backend.seed = [redis](const std::string& tenant_id, const QuotaUsage& usage, std::chrono::seconds ttl) {
+        KeyBuilder<> key(KEY_PREFIX, tenant_id);
+        KeyBuilder<24> used(usage.used), limit(usage.limit), ttl_arg(std::max<int64_t>(ttl.count(), 1));
+        redis->EvalScript(SEED_LUA, {key.View()}, {used.View(), limit.View(), ttl_arg.View()});
+    };
+    backend.release = [redis](const std::string& tenant_id, int64_t bytes) {
+        KeyBuilder<> key(KEY_PREFIX, tenant_id);
+        KeyBuilder<24> bytes_arg(bytes);
+        redis->EvalScript(RELEASE_LUA, {key.View()}, {bytes_arg.View()});
+    };
+    backend.load = [db_pool](const std::string& tenant_id) {
+        auto conn_guard = db_pool->AcquireConnection("QuotaLedger::Load");
+        pqxx::read_transaction txn(*conn_guard);
+        auto result = ExecPrepared(txn, kLoadQuotaUsage, tenant_id);
+        txn.commit();
+        return QuotaUsage{result[0]["used_bytes"].as<int64_t>(), result[0]["limit_bytes"].as<int64_t>()};
+    };
+    backend.flush = [db_pool](const std::vector<std::pair<std::string, int64_t>>& deltas) {
+        std::vector<std::string> tenants, values;
+        tenants.reserve(deltas.size());
+        values.reserve(deltas.size());
+        for (const auto& delta : deltas) {
+            tenants.push_back(delta.first);
+            values.push_back(std::to_string(delta.second));
+        }
+
+        // One statement, committed on its own: hot tenants' rows are locked only while it runs
+        auto conn_guard = db_pool->AcquireConnection("QuotaLedger::Flush");
+        pqxx::nontransaction txn(*conn_guard);
+        ExecPrepared(txn, kFlushQuotaDeltas, ToArrayLiteral(tenants), ToArrayLiteral(values));
+    };
+    return backend;
+}
+
+QuotaLedger::QuotaLedger(std::shared_ptr<RedisClient> redis, std::shared_ptr<DbPool> db_pool,
+                         const QuotaLedgerOptions& options)
+    : QuotaLedger(QuotaLedgerBackend::Default(std::move(redis), std::move(db_pool)), options) {}
+
+QuotaLedger::QuotaLedger(QuotaLedgerBackend backend, const QuotaLedgerOptions& options)
+    : backend_(std::move(backend)), options_(options) {
+    if (options_.flush_interval.count() <= 0) {
+        options_.flush_interval = std::chrono::milliseconds(1);
+    }
+    flush_thread_ = std::thread(&QuotaLedger::FlushLoop, this);
+}
+
+QuotaLedger::~QuotaLedger() {
+    Shutdown();
+}
+
+void QuotaLedger::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_.exchange(true)) {
+            return;
+        }
+    }
+    flush_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
+    }
+
+    if (!Flush()) {
+        LogError("Quota usage not written at shutdown", {{"tenants", GetStats().pending_tenants}});
+    }
+}
+
+bool QuotaLedger::Reserve(const std::string& tenant_id, int64_t bytes) {
+    if (bytes <= 0) {
+        throw std::invalid_argument("Reservation must be positive");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = headroom_.find(tenant_id);
+        if (it != headroom_.end()) {
+            if (std::chrono::steady_clock::now() >= it->second.expires) {
+                headroom_.erase(it);
+            } else if (it->second.bytes < bytes) {
+                ++rejected_locally_;
+                return false;
+            }
+        }
+    }
+
+    std::optional<QuotaReservation> reservation;
+    try {
+        reservation = ReserveInCounter(tenant_id, bytes);
+    } catch (const std::exception& e) {
+        // Redis down: fall back to the pre-ledger check against Postgres (not atomic)
+        ++fallbacks_;
+        LogWarn("Quota counter unavailable", {{"tenant_id", tenant_id}, {"error", e.what()}});
+        QuotaUsage usage = backend_.load(tenant_id);
+        bool granted = usage.used + bytes <= usage.limit;
+        reservation = QuotaReservation{granted, usage.limit - usage.used - (granted ? bytes : 0)};
+    }
+
+    ++(reservation->granted ? granted_ : rejected_);
+    CacheHeadroom(tenant_id, reservation->headroom);
+    return reservation->granted;
+}
+
+std::optional<QuotaReservation> QuotaLedger::ReserveInCounter(const std::string& tenant_id, int64_t bytes) {
+    auto reservation = backend_.reserve(tenant_id, bytes);
+    if (reservation) {
+        return reservation;
+    }
+
+    // First use (or counter expired): seed from Postgres plus deltas this
+    // instance has not flushed yet. Seeding is NX, so racing instances agree.
+    QuotaUsage usage = backend_.load(tenant_id);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = deltas_.find(tenant_id);
+        if (it != deltas_.end()) {
+            usage.used = std::max<int64_t>(usage.used + it->second, 0);
+        }
+    }
+    backend_.seed(tenant_id, usage, options_.counter_ttl);
+    ++seeded_;
+
+    reservation = backend_.reserve(tenant_id, bytes);
+    if (!reservation) {
+        throw std::runtime_error("Quota counter missing after seeding");
+    }
+    return reservation;
+}
+
+void QuotaLedger::CacheHeadroom(const std::string& tenant_id, int64_t headroom) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (headroom_.size() >= MAX_HEADROOM_ENTRIES && headroom_.find(tenant_id) == headroom_.end()) {
+        headroom_.clear();
+    }
+    headroom_[tenant_id] = Headroom{headroom, std::chrono::steady_clock::now() + options_.local_ttl};
+}
+
+void QuotaLedger::Release(const std::string& tenant_id, int64_t bytes) {
+    if (bytes <= 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        headroom_.erase(tenant_id);
+    }
+    try {
+        backend_.release(tenant_id, bytes);
+    } catch (const std::exception& e) {
+        // The counter is reseeded from Postgres within counter_ttl
+        LogError("Quota release failed", {{"tenant_id", tenant_id}, {"error", e.what()}});
+    }
+}
+
+void QuotaLedger::Commit(const std::string& tenant_id, int64_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    deltas_[tenant_id] += bytes;
+}
+
+bool QuotaLedger::Flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+
+    std::unordered_map<std::string, int64_t> taken;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        taken.swap(deltas_);
+    }
+
+    std::vector<std::pair<std::string, int64_t>> deltas;
+    deltas.reserve(taken.size());
+    for (const auto& delta : taken) {
+        if (delta.second != 0) {
+            deltas.emplace_back(delta.first, delta.second);
+        }
+    }
+    if (deltas.empty()) {
+        return true;
+    }
+    // Consistent row order across instances avoids deadlocks between flushes
+    std::sort(deltas.begin(), deltas.end());
+
+    try {
+        backend_.flush(deltas);
+    } catch (const std::exception& e) {
+        ++failed_flushes_;
+        LogError("Quota flush failed", {{"tenants", deltas.size()}, {"error", e.what()}});
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& delta : deltas) {
+            deltas_[delta.first] += delta.second;
+        }
+        return false;
+    }
+
+    if (on_flushed_) {
+        std::vector<std::string> tenant_ids;
+        tenant_ids.reserve(deltas.size());
+        for (const auto& delta : deltas) {
+            tenant_ids.push_back(delta.first);
+        }
+        on_flushed_(tenant_ids);
+    }
+    return true;
+}
+
+void QuotaLedger::OnFlushed(std::function<void(const std::vector<std::string>& tenant_ids)> listener) {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    on_flushed_ = std::move(listener);
+}
+
+void QuotaLedger::FlushLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            flush_cv_.wait_for(lock, options_.flush_interval, [this] { return shutdown_.load(); });
+        }
+        if (shutdown_.load()) {
+            return;  // Shutdown() does the final flush
+        }
+        Flush();
+    }
+}
+
+QuotaLedgerStats QuotaLedger::GetStats() const {
+    QuotaLedgerStats stats;
+    stats.granted = granted_.load();
+    stats.rejected = rejected_.load();
+    stats.rejected_locally = rejected_locally_.load();
+    stats.seeded = seeded_.load();
+    stats.fallbacks = fallbacks_.load();
+    stats.failed_flushes = failed_flushes_.load();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.pending_tenants = deltas_.size();
+    return stats;
+}
+
+} // namespace common
+} // namespace saasforge
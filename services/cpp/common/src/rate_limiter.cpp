@@ -0,0 +1,285 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Redis-backed rate limiter implementation
+ */
+
+#include "common/rate_limiter.h"
+#include "common/logger.h"
+#include "common/string_builder.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// KEYS[1] = log (sorted set), ARGV = limit, window ms, pending hits, member id, hit (0 = only charge pending)
+// Returns {allowed, remaining, retry_after_ms}
+constexpr const char* SLIDING_WINDOW_LOG_LUA = R"(
+local t = redis.call('TIME')
+local now = tonumber(t[1]) * 1000 + math.floor(tonumber(t[2]) / 1000)
+local limit = tonumber(ARGV[1])
+local window = tonumber(ARGV[2])
+local pending = tonumber(ARGV[3])
+
+redis.call('ZREMRANGEBYSCORE', KEYS[1], '-inf', now - window)
+for i = 1, pending do
+    redis.call('ZADD', KEYS[1], now, ARGV[4] .. ':' .. i)
+end
+
+local count = redis.call('ZCARD', KEYS[1])
+redis.call('PEXPIRE', KEYS[1], window)
+if ARGV[5] == '0' then
+    return {1, math.max(0, limit - count), 0}
+end
+if count < limit then
+    redis.call('ZADD', KEYS[1], now, ARGV[4])
+    return {1, limit - count - 1, 0}
+end
+
+local oldest = redis.call('ZRANGE', KEYS[1], 0, 0, 'WITHSCORES')
+local retry = window
+if oldest[2] then
+    retry = math.max(1, tonumber(oldest[2]) + window - now)
+end
+return {0, 0, retry}
+)";
+
+// KEYS[1] = bucket (hash), ARGV = capacity, window ms (full refill), pending hits, hit (0 = only charge pending)
+// Returns {allowed, remaining, retry_after_ms}
+constexpr const char* TOKEN_BUCKET_LUA = R"(
+local t = redis.call('TIME')
+local now = tonumber(t[1]) * 1000 + math.floor(tonumber(t[2]) / 1000)
+local capacity = tonumber(ARGV[1])
+local window = tonumber(ARGV[2])
+local pending = tonumber(ARGV[3])
+local rate = capacity / window
+
+local state = redis.call('HMGET', KEYS[1], 'tokens', 'ts')
+local tokens = tonumber(state[1]) or capacity
+local ts = tonumber(state[2]) or now
+tokens = math.min(capacity, tokens + math.max(0, now - ts) * rate)
+tokens = math.max(0, tokens - pending)
+
+local allowed = 0
+local retry = 0
+if ARGV[4] == '0' then
+    allowed = 1
+elseif tokens >= 1 then
+    tokens = tokens - 1
+    allowed = 1
+else
+    retry = math.ceil((1 - tokens) / rate)
+end
+
+redis.call('HSET', KEYS[1], 'tokens', tostring(tokens), 'ts', now)
+redis.call('PEXPIRE', KEYS[1], window)
+return {allowed, math.floor(tokens), retry}
+)";
+
+std::string RandomInstanceId() {
+    std::random_device rd;
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(8) << rd() << std::setw(8) << rd();
+    return ss.str();
+}
+
+} // namespace
+
+RateLimiter::RateLimiter(
+    std::shared_ptr<RedisClient> redis,
+    const std::string& name,
+    const RateLimitPolicy& policy
+) : redis_(redis),
+    key_prefix_("ratelimit:" + name + ":"),
+    policy_(policy),
+    instance_id_(RandomInstanceId()) {
+    if (policy_.limit <= 0 || policy_.window.count() <= 0) {
+        throw std::invalid_argument("Rate limit policy needs a positive limit and window");
+    }
+    policy_.local_allowance = std::min(policy_.local_allowance, policy_.limit);
+    if (policy_.local_allowance > 0 && policy_.flush_interval.count() > 0) {
+        flush_thread_ = std::thread(&RateLimiter::FlushLoop, this);
+    }
+}
+
+RateLimiter::~RateLimiter() {
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        stopping_ = true;
+    }
+    flush_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
+    }
+}
+
+RateLimitDecision RateLimiter::Check(const std::string& key) {
+    if (!UsesLocalState()) {
+        return CheckRemote(key, 0);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto& shard = ShardFor(key);
+    int64_t pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.states.find(key);
+        if (it == shard.states.end()) {
+            if (shard.states.size() >= policy_.max_local_keys / NUM_SHARDS) {
+                EvictStale(shard, now);
+            }
+            it = shard.states.emplace(key, LocalState{now, now, 0, 0}).first;
+        }
+        auto& state = it->second;
+
+        if (state.denied_until > now) {
+            RateLimitDecision decision;
+            decision.allowed = false;
+            decision.retry_after = std::chrono::duration_cast<std::chrono::milliseconds>(state.denied_until - now);
+            decision.local = true;
+            return decision;
+        }
+
+        // At rollover the previous window's local hits go to Redis with this one
+        bool rolled_over = now - state.window_start >= policy_.window;
+        if (rolled_over) {
+            state.window_start = now;
+            state.local_hits = 0;
+        }
+
+        if (state.local_hits < policy_.local_allowance && !(rolled_over && state.pending > 0)) {
+            state.local_hits++;
+            state.pending++;
+            RateLimitDecision decision;
+            decision.remaining = policy_.local_allowance - state.local_hits;
+            decision.local = true;
+            return decision;
+        }
+
+        pending = state.pending;
+        state.pending = 0;
+    }
+
+    RateLimitDecision decision;
+    try {
+        decision = CheckRemote(key, pending);
+    } catch (...) {
+        // Keep locally admitted hits so they are charged on the next check
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.states[key].pending += pending;
+        throw;
+    }
+
+    if (!decision.allowed && policy_.cache_denials && decision.retry_after.count() > 0) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.states[key].denied_until = now + decision.retry_after;
+    }
+    return decision;
+}
+
+int64_t RateLimiter::Flush() {
+    if (policy_.local_allowance == 0) {
+        return 0;
+    }
+
+    std::vector<std::pair<std::string, int64_t>> charges;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto& [key, state] : shard.states) {
+            if (state.pending > 0) {
+                charges.emplace_back(key, state.pending);
+                state.pending = 0;
+            }
+        }
+    }
+
+    int64_t charged = 0;
+    for (size_t i = 0; i < charges.size(); ++i) {
+        try {
+            CheckRemote(charges[i].first, charges[i].second, false);
+            charged += charges[i].second;
+        } catch (...) {
+            // Put back what was not charged; the next check or flush retries it
+            for (size_t j = i; j < charges.size(); ++j) {
+                auto& shard = ShardFor(charges[j].first);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.states[charges[j].first].pending += charges[j].second;
+            }
+            throw;
+        }
+    }
+    return charged;
+}
+
+void RateLimiter::FlushLoop() {
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    while (!flush_cv_.wait_for(lock, policy_.flush_interval, [this] { return stopping_; })) {
+        lock.unlock();
+        try {
+            Flush();
+        } catch (const std::exception& e) {
+            LogWarn("Failed to flush locally admitted rate limit hits", {{"limiter", key_prefix_}, {"error", e.what()}});
+        }
+        lock.lock();
+    }
+}
+
+RateLimitDecision RateLimiter::CheckRemote(const std::string& key, int64_t pending, bool hit) {
+    KeyBuilder<> redis_key(key_prefix_, key);
+    KeyBuilder<24> limit(policy_.limit);
+    KeyBuilder<24> window(policy_.window.count());
+    KeyBuilder<24> pending_arg(pending);
+    std::string_view hit_arg = hit ? "1" : "0";
+
+    std::vector<long long> reply;
+    if (policy_.algorithm == RateLimitAlgorithm::TOKEN_BUCKET) {
+        reply = redis_->EvalScriptArray(TOKEN_BUCKET_LUA, {redis_key.View()},
+                                        {limit.View(), window.View(), pending_arg.View(), hit_arg});
+    } else {
+        KeyBuilder<> member(instance_id_, ":", next_member_++);
+        reply = redis_->EvalScriptArray(SLIDING_WINDOW_LOG_LUA, {redis_key.View()},
+                                        {limit.View(), window.View(), pending_arg.View(), member.View(), hit_arg});
+    }
+
+    if (reply.size() != 3) {
+        throw std::runtime_error("Unexpected rate limit script reply");
+    }
+
+    RateLimitDecision decision;
+    decision.allowed = reply[0] == 1;
+    decision.remaining = reply[1];
+    decision.retry_after = std::chrono::milliseconds(reply[2]);
+    return decision;
+}
+
+RateLimiter::Shard& RateLimiter::ShardFor(const std::string& key) {
+    return shards_[std::hash<std::string>{}(key) % NUM_SHARDS];
+}
+
+void RateLimiter::EvictStale(Shard& shard, std::chrono::steady_clock::time_point now) {
+    for (auto it = shard.states.begin(); it != shard.states.end();) {
+        const auto& state = it->second;
+        bool window_over = now - state.window_start >= policy_.window;
+        if (window_over && state.denied_until <= now && state.pending == 0) {
+            it = shard.states.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Every key is active: drop the shard rather than grow without bound.
+    // Losing pending hits under-counts by at most local_allowance per key.
+    if (shard.states.size() >= policy_.max_local_keys / NUM_SHARDS) {
+        shard.states.clear();
+    }
+}
+
+} // namespace common
+} // namespace saasforge
@@ -1,44 +1,1009 @@
 #include "common/redis_client.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/string_builder.h"
+#include "common/tenant_usage.h"
+#include "common/tracing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <hiredis/hiredis.h>
+#include <poll.h>
 
 namespace saasforge {
 namespace common {
 
-RedisClient::RedisClient(const std::string& connection_string) {
-    redis_ = std::make_unique<sw::redis::Redis>(connection_string);
+namespace {
+constexpr auto SUBSCRIBER_POLL_TIMEOUT = std::chrono::seconds(1);
+constexpr auto SUBSCRIBER_RECONNECT_DELAY = std::chrono::seconds(1);
+constexpr int TRACKER_POLL_TIMEOUT_MS = 1000;
+constexpr auto STREAM_SOCKET_MARGIN = std::chrono::seconds(1);   // Beyond the longest BLOCK
+
+// Call sites keep the returned reference in a function-local static
+Histogram& CommandLatency(const char* operation) {
+    return MetricsRegistry::Global().GetHistogram(
+        "saasforge_redis_command_duration_seconds", "Redis round-trip time, per operation",
+        HistogramOptions::LatencySeconds(), {{"operation", operation}});
 }
 
-void RedisClient::BlacklistToken(const std::string& jti, int64_t ttl_seconds) {
-    std::string key = "blacklist:" + jti;
-    redis_->setex(key, ttl_seconds, R"({"reason":"logout"})");
+// KEYS[1] = counter, ARGV[1] = ttl seconds
+constexpr const char* INCREMENT_WITH_TTL_LUA = R"(
+local count = redis.call('INCR', KEYS[1])
+if count == 1 then
+    redis.call('EXPIRE', KEYS[1], ARGV[1])
+end
+return count
+)";
+
+// KEYS[1] = session key, ARGV = expected, new value, ttl seconds
+// Returns 1 = rotated, 0 = missing, -1 = mismatch
+constexpr const char* ROTATE_SESSION_LUA = R"(
+local current = redis.call('GET', KEYS[1])
+if not current then
+    return 0
+end
+if current ~= ARGV[1] then
+    return -1
+end
+redis.call('SET', KEYS[1], ARGV[2], 'EX', ARGV[3])
+return 1
+)";
+
+// KEYS[1] = session key; GETDEL, which needs Redis 6.2
+constexpr const char* TAKE_SESSION_LUA = R"(
+local current = redis.call('GET', KEYS[1])
+if current then
+    redis.call('DEL', KEYS[1])
+end
+return current
+)";
+
+// KEYS[1] = key, ARGV = value, ttl seconds
+// Returns 1 = stored, 0 = key already holds a value >= ARGV[1]
+constexpr const char* SET_IF_GREATER_LUA = R"(
+local current = tonumber(redis.call('GET', KEYS[1]))
+if current and current >= tonumber(ARGV[1]) then
+    return 0
+end
+redis.call('SET', KEYS[1], ARGV[1], 'EX', ARGV[2])
+return 1
+)";
+
+struct ContextDeleter {
+    void operator()(redisContext* context) const { redisFree(context); }
+};
+using ContextPtr = std::unique_ptr<redisContext, ContextDeleter>;
+
+struct ReplyDeleter {
+    void operator()(redisReply* reply) const { freeReplyObject(reply); }
+};
+using ReplyPtr = std::unique_ptr<redisReply, ReplyDeleter>;
+
+timeval ToTimeval(std::chrono::milliseconds duration) {
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(duration.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((duration.count() % 1000) * 1000);
+    return tv;
 }
 
-bool RedisClient::IsTokenBlacklisted(const std::string& jti) {
-    std::string key = "blacklist:" + jti;
-    auto value = redis_->get(key);
-    return value.has_value();
+// Synchronous command on the tracking connection; throws on error replies
+ReplyPtr TrackerCommand(redisContext* context, const std::vector<std::string>& args) {
+    std::vector<const char*> argv;
+    std::vector<size_t> lengths;
+    argv.reserve(args.size());
+    lengths.reserve(args.size());
+    for (const auto& arg : args) {
+        argv.push_back(arg.data());
+        lengths.push_back(arg.size());
+    }
+    ReplyPtr reply(static_cast<redisReply*>(
+        redisCommandArgv(context, static_cast<int>(argv.size()), argv.data(), lengths.data())));
+    if (!reply) {
+        throw sw::redis::Error(std::string(args.front()) + " failed: " + context->errstr);
+    }
+    if (reply->type == REDIS_REPLY_ERROR) {
+        throw sw::redis::ReplyError(std::string(args.front()) + " failed: " + std::string(reply->str, reply->len));
+    }
+    return reply;
 }
 
-void RedisClient::SetSession(const std::string& session_id, const std::string& data, int64_t ttl_seconds) {
-    std::string key = "session:" + session_id;
-    redis_->setex(key, ttl_seconds, data);
+// Part of a key Redis Cluster hashes: the first non-empty {tag}, else the whole key
+std::string_view SlotKey(std::string_view key) {
+    size_t open = key.find('{');
+    if (open != std::string_view::npos) {
+        size_t close = key.find('}', open + 1);
+        if (close != std::string_view::npos && close > open + 1) {
+            return key.substr(open + 1, close - open - 1);
+        }
+    }
+    return key;
 }
 
-std::optional<std::string> RedisClient::GetSession(const std::string& session_id) {
-    std::string key = "session:" + session_id;
-    return redis_->get(key);
+// Whether a multi-key command on these keys can run on one cluster node
+bool SameSlot(const std::vector<std::string>& keys) {
+    return std::all_of(keys.begin(), keys.end(), [&keys](const std::string& key) {
+        return SlotKey(key) == SlotKey(keys.front());
+    });
 }
 
-void RedisClient::DeleteSession(const std::string& session_id) {
-    std::string key = "session:" + session_id;
-    redis_->del(key);
+RedisMode ParseMode(std::string_view value) {
+    if (value == "standalone") {
+        return RedisMode::STANDALONE;
+    }
+    if (value == "cluster") {
+        return RedisMode::CLUSTER;
+    }
+    if (value == "sentinel") {
+        return RedisMode::SENTINEL;
+    }
+    throw std::invalid_argument("Unknown REDIS_MODE: " + std::string(value));
+}
+
+std::pair<std::string, int> ParseSentinel(const std::string& node) {
+    size_t colon = node.rfind(':');
+    if (colon == std::string::npos) {
+        return {node, 26379};
+    }
+    char* end = nullptr;
+    long port = std::strtol(node.c_str() + colon + 1, &end, 10);
+    if (colon == 0 || !end || *end != '\0' || port <= 0 || port > 65535) {
+        throw std::invalid_argument("Invalid REDIS_SENTINELS entry: " + node);
+    }
+    return {node.substr(0, colon), static_cast<int>(port)};
+}
+
+bool ReplyIs(const redisReply* reply, std::string_view text) {
+    return reply && (reply->type == REDIS_REPLY_STRING || reply->type == REDIS_REPLY_STATUS) &&
+           std::string_view(reply->str, reply->len) == text;
+}
+
+} // namespace
+
+RedisOptions RedisOptions::FromEnv() {
+    RedisOptions options;
+    if (std::string mode = EnvString("REDIS_MODE"); !mode.empty()) {
+        options.mode = ParseMode(mode);
+    }
+    for (const auto& node : EnvList("REDIS_SENTINELS", {})) {
+        options.sentinels.push_back(ParseSentinel(node));
+    }
+    options.sentinel_master = EnvString("REDIS_SENTINEL_MASTER", options.sentinel_master);
+    if (options.mode == RedisMode::SENTINEL && options.sentinels.empty()) {
+        throw std::invalid_argument("REDIS_MODE=sentinel requires REDIS_SENTINELS");
+    }
+    options.pool_size = static_cast<size_t>(EnvInt("REDIS_POOL_SIZE", static_cast<long>(options.pool_size)));
+    options.pool_wait_timeout = std::chrono::milliseconds(
+        EnvInt("REDIS_POOL_WAIT_TIMEOUT_MS", static_cast<long>(options.pool_wait_timeout.count())));
+    options.connect_timeout = std::chrono::milliseconds(
+        EnvInt("REDIS_CONNECT_TIMEOUT_MS", static_cast<long>(options.connect_timeout.count())));
+    options.socket_timeout = std::chrono::milliseconds(
+        EnvInt("REDIS_SOCKET_TIMEOUT_MS", static_cast<long>(options.socket_timeout.count())));
+    options.client_cache_entries = static_cast<size_t>(
+        EnvInt("REDIS_CLIENT_CACHE_ENTRIES", static_cast<long>(options.client_cache_entries)));
+    options.client_cache_max_age = std::chrono::milliseconds(
+        EnvInt("REDIS_CLIENT_CACHE_MAX_AGE_MS", static_cast<long>(options.client_cache_max_age.count())));
+    options.client_cache_prefixes = EnvList("REDIS_CLIENT_CACHE_PREFIXES", options.client_cache_prefixes);
+    options.resilience = DependencyOptions::FromEnv("REDIS");
+    if (options.pool_size == 0) {
+        options.pool_size = 1;
+    }
+    return options;
+}
+
+RedisClient::RedisClient(const std::string& connection_string, const RedisOptions& options)
+    : connection_string_(connection_string), pool_size_(options.pool_size), mode_(options.mode),
+      dependency_(std::make_unique<Dependency>(
+          "redis", DependencyOptions{options.resilience.breaker,
+                                     options.resilience.limit.ForCapacity(options.pool_size)})),
+      sentinels_(options.sentinels), sentinel_master_(options.sentinel_master),
+      connect_timeout_(options.connect_timeout) {
+    sw::redis::ConnectionOptions connection_options(connection_string);
+    connection_options.connect_timeout = options.connect_timeout;
+    connection_options.socket_timeout = options.socket_timeout;
+
+    sw::redis::ConnectionPoolOptions pool_options;
+    pool_options.size = options.pool_size;
+    pool_options.wait_timeout = options.pool_wait_timeout;
+
+    if (mode_ == RedisMode::SENTINEL) {
+        if (sentinels_.empty()) {
+            throw std::invalid_argument("Sentinel mode requires at least one sentinel");
+        }
+        sw::redis::SentinelOptions sentinel_options;
+        sentinel_options.nodes = sentinels_;
+        sentinel_options.connect_timeout = options.connect_timeout;
+        sentinel_options.socket_timeout = options.socket_timeout;
+        sentinel_ = std::make_shared<sw::redis::Sentinel>(sentinel_options);
+    }
+    if (mode_ == RedisMode::CLUSTER) {
+        // One pool of pool_size connections per master
+        cluster_ = std::make_unique<sw::redis::RedisCluster>(connection_options, pool_options);
+    } else {
+        redis_ = MakeNodeClient(connection_options, pool_options);
+    }
+
+    if (options.client_cache_entries > 0 && !options.client_cache_prefixes.empty() &&
+        options.client_cache_max_age.count() > 0) {
+        if (mode_ == RedisMode::CLUSTER) {
+            LogInfo("Redis client-side cache disabled in cluster mode");
+        } else {
+            cache_ = std::make_unique<RedisClientCache>(
+                options.client_cache_entries, options.client_cache_max_age, options.client_cache_prefixes);
+            tracker_ = std::thread(&RedisClient::RunTracker, this, options.client_cache_prefixes);
+        }
+    }
+}
+
+RedisClient::~RedisClient() {
+    stopping_ = true;
+    if (tracker_.joinable()) {
+        tracker_.join();
+    }
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    for (auto& subscription : subscriptions_) {
+        if (subscription.thread.joinable()) {
+            subscription.thread.join();
+        }
+    }
+}
+
+Dependency::Permit RedisClient::Admit() {
+    auto permit = dependency_->Admit();
+    TenantUsage::ChargeRedis();
+    return permit;
+}
+
+template <typename Command>
+auto RedisClient::Run(Command&& command) {
+    if (cluster_) {
+        return command(*cluster_);
+    }
+    return command(*redis_);
+}
+
+sw::redis::Pipeline RedisClient::PipelineFor(std::string_view key) {
+    // new_connection = false borrows a pooled connection instead of opening one
+    if (cluster_) {
+        return cluster_->pipeline(key, false);
+    }
+    return redis_->pipeline(false);
+}
+
+std::unique_ptr<sw::redis::Redis> RedisClient::MakeNodeClient(
+    const sw::redis::ConnectionOptions& options,
+    const sw::redis::ConnectionPoolOptions& pool_options
+) {
+    if (sentinel_) {
+        // Host and port are ignored: connections go to the master the sentinels report
+        return std::make_unique<sw::redis::Redis>(
+            sentinel_, sentinel_master_, sw::redis::Role::MASTER, options, pool_options);
+    }
+    return std::make_unique<sw::redis::Redis>(options, pool_options);
+}
+
+void RedisClient::BlacklistToken(std::string_view jti, int64_t ttl_seconds) {
+    static Histogram& latency = CommandLatency("blacklist_token");
+    auto timer = latency.StartTimer();
+    Span span("redis.blacklist_token", SpanKind::kClient);
+    auto permit = Admit();
+    KeyBuilder<> key("blacklist:", jti);
+    auto pipe = PipelineFor(key.View());
+    pipe.setex(key.View(), ttl_seconds, R"({"reason":"logout"})")
+        .publish(BLACKLIST_CHANNEL, jti);
+    pipe.exec();
+    InvalidateLocal(key.View());
+}
+
+void RedisClient::BlacklistTokens(const std::vector<std::pair<std::string, int64_t>>& tokens) {
+    if (tokens.empty()) {
+        return;
+    }
+    static Histogram& latency = CommandLatency("blacklist_tokens");
+    auto timer = latency.StartTimer();
+    Span span("redis.blacklist_tokens", SpanKind::kClient);
+    auto permit = Admit();
+    if (cluster_) {
+        // JTIs hash to different nodes: one pipeline each
+        for (const auto& token : tokens) {
+            KeyBuilder<> key("blacklist:", token.first);
+            auto pipe = PipelineFor(key.View());
+            pipe.setex(key.View(), token.second, R"({"reason":"revoked"})")
+                .publish(BLACKLIST_CHANNEL, token.first);
+            pipe.exec();
+        }
+    } else {
+        auto pipe = PipelineFor({});
+        for (const auto& token : tokens) {
+            KeyBuilder<> key("blacklist:", token.first);
+            pipe.setex(key.View(), token.second, R"({"reason":"revoked"})")
+                .publish(BLACKLIST_CHANNEL, token.first);
+        }
+        pipe.exec();
+    }
+    for (const auto& token : tokens) {
+        KeyBuilder<> key("blacklist:", token.first);
+        InvalidateLocal(key.View());
+    }
+}
+
+bool RedisClient::IsTokenBlacklisted(std::string_view jti) {
+    static Histogram& latency = CommandLatency("is_token_blacklisted");
+    auto timer = latency.StartTimer();
+    Span span("redis.is_token_blacklisted", SpanKind::kClient);
+    KeyBuilder<> key("blacklist:", jti);
+    return CachedGet(key.View()).has_value();
+}
+
+std::vector<std::string> RedisClient::ScanBlacklistedTokens() {
+    static Histogram& latency = CommandLatency("scan_blacklist");
+    auto timer = latency.StartTimer();
+    Span span("redis.scan_blacklist", SpanKind::kClient);
+    auto permit = Admit();
+    const std::string prefix = "blacklist:";
+    std::vector<std::string> keys;
+    auto scan_node = [&](sw::redis::Redis& node) {
+        long long cursor = 0;
+        do {
+            cursor = node.scan(cursor, prefix + "*", 1000, std::back_inserter(keys));
+        } while (cursor != 0);
+    };
+    if (cluster_) {
+        // SCAN only covers the node it runs on
+        cluster_->for_each(scan_node);
+    } else {
+        scan_node(*redis_);
+    }
+
+    std::vector<std::string> jtis;
+    jtis.reserve(keys.size());
+    for (const auto& key : keys) {
+        jtis.push_back(key.substr(prefix.length()));
+    }
+    return jtis;
+}
+
+void RedisClient::SetSession(std::string_view session_id, std::string_view data, int64_t ttl_seconds) {
+    static Histogram& latency = CommandLatency("set_session");
+    auto timer = latency.StartTimer();
+    Span span("redis.set_session", SpanKind::kClient);
+    auto permit = Admit();
+    KeyBuilder<> key("session:", session_id);
+    Run([&](auto& redis) { redis.setex(key.View(), ttl_seconds, data); });
+    InvalidateLocal(key.View());
+}
+
+std::optional<std::string> RedisClient::GetSession(std::string_view session_id) {
+    static Histogram& latency = CommandLatency("get_session");
+    auto timer = latency.StartTimer();
+    Span span("redis.get_session", SpanKind::kClient);
+    KeyBuilder<> key("session:", session_id);
+    return CachedGet(key.View());
+}
+
+void RedisClient::DeleteSession(std::string_view session_id) {
+    static Histogram& latency = CommandLatency("delete_session");
+    auto timer = latency.StartTimer();
+    Span span("redis.delete_session", SpanKind::kClient);
+    auto permit = Admit();
+    KeyBuilder<> key("session:", session_id);
+    Run([&](auto& redis) { return redis.del(key.View()); });
+    InvalidateLocal(key.View());
+}
+
+std::optional<std::string> RedisClient::TakeSession(std::string_view session_id) {
+    KeyBuilder<> key("session:", session_id);
+    auto value = EvalScriptString(TAKE_SESSION_LUA, {key.View()}, {});
+    InvalidateLocal(key.View());
+    return value;
+}
+
+void RedisClient::SetSessionMany(
+    const std::vector<std::pair<std::string, std::string>>& sessions,
+    int64_t ttl_seconds
+) {
+    if (sessions.empty()) {
+        return;
+    }
+    static Histogram& latency = CommandLatency("set_session_many");
+    auto timer = latency.StartTimer();
+    Span span("redis.set_session_many", SpanKind::kClient);
+    auto permit = Admit();
+    if (cluster_) {
+        // Sessions of different users live on different nodes: one SETEX each
+        for (const auto& session : sessions) {
+            KeyBuilder<> key("session:", session.first);
+            cluster_->setex(key.View(), ttl_seconds, session.second);
+        }
+    } else {
+        auto pipe = PipelineFor({});
+        for (const auto& session : sessions) {
+            KeyBuilder<> key("session:", session.first);
+            pipe.setex(key.View(), ttl_seconds, session.second);
+        }
+        pipe.exec();
+    }
+    for (const auto& session : sessions) {
+        KeyBuilder<> key("session:", session.first);
+        InvalidateLocal(key.View());
+    }
+}
+
+RotateResult RedisClient::RotateSession(
+    std::string_view session_id,
+    std::string_view expected_data,
+    std::string_view new_data,
+    int64_t ttl_seconds
+) {
+    KeyBuilder<> key("session:", session_id);
+    KeyBuilder<24> ttl(ttl_seconds);
+    long long result = EvalScript(ROTATE_SESSION_LUA, {key.View()}, {expected_data, new_data, ttl.View()});
+    if (result == 1) {
+        InvalidateLocal(key.View());
+        return RotateResult::ROTATED;
+    }
+    return result == 0 ? RotateResult::MISSING : RotateResult::MISMATCH;
+}
+
+std::vector<std::optional<std::string>> RedisClient::GetMany(const std::vector<std::string>& keys) {
+    std::vector<std::optional<std::string>> values;
+    if (keys.empty()) {
+        return values;
+    }
+    values.reserve(keys.size());
+    static Histogram& latency = CommandLatency("get_many");
+    auto timer = latency.StartTimer();
+    Span span("redis.get_many", SpanKind::kClient);
+    auto permit = Admit();
+    if (cluster_ && !SameSlot(keys)) {
+        // MGET across slots fails with CROSSSLOT
+        for (const auto& key : keys) {
+            values.push_back(cluster_->get(key));
+        }
+        return values;
+    }
+    Run([&](auto& redis) { redis.mget(keys.begin(), keys.end(), std::back_inserter(values)); });
+    return values;
+}
+
+int64_t RedisClient::DeleteMany(const std::vector<std::string>& keys) {
+    if (keys.empty()) {
+        return 0;
+    }
+    static Histogram& latency = CommandLatency("delete_many");
+    auto timer = latency.StartTimer();
+    Span span("redis.delete_many", SpanKind::kClient);
+    auto permit = Admit();
+    int64_t deleted = 0;
+    if (cluster_ && !SameSlot(keys)) {
+        // DEL across slots fails with CROSSSLOT
+        for (const auto& key : keys) {
+            deleted += cluster_->del(key);
+        }
+    } else {
+        deleted = Run([&](auto& redis) { return redis.del(keys.begin(), keys.end()); });
+    }
+    for (const auto& key : keys) {
+        InvalidateLocal(key);
+    }
+    return deleted;
 }
 
-int64_t RedisClient::IncrementCounter(const std::string& key, int64_t ttl_seconds) {
-    auto count = redis_->incr(key);
-    if (count == 1) {
-        redis_->expire(key, ttl_seconds);
+std::optional<std::string> RedisClient::Get(std::string_view key) {
+    static Histogram& latency = CommandLatency("get");
+    auto timer = latency.StartTimer();
+    Span span("redis.get", SpanKind::kClient);
+    return CachedGet(key);
+}
+
+void RedisClient::SetWithTtl(std::string_view key, std::string_view value, std::chrono::milliseconds ttl) {
+    static Histogram& latency = CommandLatency("set");
+    auto timer = latency.StartTimer();
+    Span span("redis.set", SpanKind::kClient);
+    auto permit = Admit();
+    Run([&](auto& redis) { redis.set(key, value, ttl); });
+    InvalidateLocal(key);
+}
+
+std::optional<std::string> RedisClient::CachedGet(std::string_view key) {
+    if (!cache_ || !cache_->Enabled() || !cache_->Covers(key)) {
+        auto permit = Admit();
+        return Run([&](auto& redis) { return redis.get(key); });
+    }
+    if (auto cached = cache_->Get(key)) {
+        return *cached;   // Served even while Redis is shed
+    }
+    auto permit = Admit();
+    // The ticket predates the read, so an invalidation racing it discards the value
+    uint64_t ticket = cache_->Ticket(key);
+    auto pipe = PipelineFor(key);
+    auto replies = pipe.get(key).pttl(key).exec();
+    auto value = replies.get<sw::redis::OptionalString>(0);
+    auto ttl = std::chrono::milliseconds(replies.get<long long>(1));
+    cache_->Put(key, value, ttl, ticket);
+    return value;
+}
+
+void RedisClient::InvalidateLocal(std::string_view key) {
+    // Redis sends the invalidation too, but only after this call has returned:
+    // without this a read right after a write could still see the old value
+    if (cache_ && cache_->Covers(key)) {
+        cache_->Invalidate(key);
+    }
+}
+
+int64_t RedisClient::IncrementCounter(std::string_view key, int64_t ttl_seconds) {
+    return IncrementWithTtl(key, ttl_seconds);
+}
+
+int64_t RedisClient::IncrementWithTtl(std::string_view key, int64_t ttl_seconds) {
+    KeyBuilder<24> ttl(ttl_seconds);
+    return EvalScript(INCREMENT_WITH_TTL_LUA, {key}, {ttl.View()});
+}
+
+bool RedisClient::SetIfGreater(std::string_view key, int64_t value, int64_t ttl_seconds) {
+    KeyBuilder<24> value_arg(value);
+    KeyBuilder<24> ttl(ttl_seconds);
+    return EvalScript(SET_IF_GREATER_LUA, {key}, {value_arg.View(), ttl.View()}) == 1;
+}
+
+long long RedisClient::EvalScript(
+    std::string_view script,
+    std::initializer_list<sw::redis::StringView> keys,
+    std::initializer_list<sw::redis::StringView> args
+) {
+    return RunScript<long long>(script, keys, args);
+}
+
+std::vector<long long> RedisClient::EvalScriptArray(
+    std::string_view script,
+    std::initializer_list<sw::redis::StringView> keys,
+    std::initializer_list<sw::redis::StringView> args
+) {
+    return RunScript<std::vector<long long>>(script, keys, args);
+}
+
+std::optional<std::string> RedisClient::EvalScriptString(
+    std::string_view script,
+    std::initializer_list<sw::redis::StringView> keys,
+    std::initializer_list<sw::redis::StringView> args
+) {
+    return RunScript<sw::redis::OptionalString>(script, keys, args);
+}
+
+std::vector<std::optional<std::string>> RedisClient::EvalScriptStrings(
+    std::string_view script,
+    std::initializer_list<sw::redis::StringView> keys,
+    std::initializer_list<sw::redis::StringView> args
+) {
+    return RunScript<std::vector<sw::redis::OptionalString>>(script, keys, args);
+}
+
+std::vector<std::optional<std::string>> RedisClient::EvalScriptStringsVector(
+    std::string_view script,
+    const std::vector<std::string>& keys,
+    const std::vector<std::string>& args
+) {
+    return RunScript<std::vector<sw::redis::OptionalString>>(script, keys, args);
+}
+
+template <typename T, typename Keys, typename Args>
+T RedisClient::RunScript(std::string_view script, const Keys& keys, const Args& args) {
+    static Histogram& latency = CommandLatency("script");
+    auto timer = latency.StartTimer();
+    Span span("redis.script", SpanKind::kClient);
+    auto permit = Admit();
+    auto evalsha = [&](const ScriptDigest& sha) {
+        // In a cluster EVALSHA routes by its first key
+        return Run([&](auto& redis) {
+            return redis.template evalsha<T>(sw::redis::StringView(sha.data(), sha.size()),
+                                             keys.begin(), keys.end(), args.begin(), args.end());
+        });
+    };
+    try {
+        return evalsha(ScriptSha(script, false));
+    } catch (const sw::redis::ReplyError& e) {
+        // Script cache flushed (restart/failover): reload and retry once
+        if (std::string(e.what()).find("NOSCRIPT") == std::string::npos) {
+            throw;
+        }
+    }
+    return evalsha(ScriptSha(script, true));
+}
+
+RedisClient::ScriptDigest RedisClient::ScriptSha(std::string_view script, bool reload) {
+    {
+        std::lock_guard<std::mutex> lock(scripts_mutex_);
+        auto it = script_shas_.find(script);
+        if (it != script_shas_.end() && !reload) {
+            return it->second;
+        }
+    }
+
+    // Always 40 hex digits; anything else fails EVALSHA with NOSCRIPT
+    std::string loaded;
+    if (cluster_) {
+        // Scripts run on their keys' node: load on every master
+        cluster_->for_each([&](sw::redis::Redis& node) { loaded = node.script_load(script); });
+    } else {
+        loaded = redis_->script_load(script);
+    }
+    ScriptDigest sha{};
+    std::copy_n(loaded.begin(), std::min(loaded.size(), sha.size()), sha.begin());
+
+    std::lock_guard<std::mutex> lock(scripts_mutex_);
+    auto it = script_shas_.find(script);
+    if (it == script_shas_.end()) {
+        script_sources_.emplace_back(script);
+        script_shas_.emplace(script_sources_.back(), sha);
+    } else {
+        it->second = sha;
+    }
+    return sha;
+}
+
+int64_t RedisClient::Publish(std::string_view channel, std::string_view message) {
+    static Histogram& latency = CommandLatency("publish");
+    auto timer = latency.StartTimer();
+    Span span("redis.publish", SpanKind::kClient);
+    auto permit = Admit();
+    return Run([&](auto& redis) { return redis.publish(channel, message); });
+}
+
+uint64_t RedisClient::Subscribe(
+    const std::string& channel,
+    std::function<void(const std::string&)> handler,
+    std::function<void()> on_subscribed
+) {
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    if (!subscriber_redis_ && !subscriber_cluster_) {
+        sw::redis::ConnectionOptions options(connection_string_);
+        options.socket_timeout = SUBSCRIBER_POLL_TIMEOUT;
+        if (mode_ == RedisMode::CLUSTER) {
+            // Messages are broadcast to every node, so any node's subscription sees them
+            subscriber_cluster_ = std::make_unique<sw::redis::RedisCluster>(options);
+        } else {
+            subscriber_redis_ = MakeNodeClient(options);
+        }
+    }
+
+    Subscription subscription;
+    subscription.id = next_subscription_id_++;
+    subscription.stop = std::make_shared<std::atomic<bool>>(false);
+    subscription.thread = std::thread(
+        &RedisClient::RunSubscriber, this, channel, std::move(handler), std::move(on_subscribed),
+        subscription.stop);
+
+    uint64_t id = subscription.id;
+    subscriptions_.push_back(std::move(subscription));
+    return id;
+}
+
+void RedisClient::Unsubscribe(uint64_t subscription_id) {
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mutex_);
+        auto it = std::find_if(subscriptions_.begin(), subscriptions_.end(),
+            [subscription_id](const Subscription& s) { return s.id == subscription_id; });
+        if (it == subscriptions_.end()) {
+            return;
+        }
+        it->stop->store(true);
+        thread = std::move(it->thread);
+        subscriptions_.erase(it);
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void RedisClient::StreamAppend(const std::vector<std::pair<std::string, std::string>>& entries, size_t max_len) {
+    if (entries.empty()) {
+        return;
+    }
+    static Histogram& latency = CommandLatency("stream_append");
+    auto timer = latency.StartTimer();
+    Span span("redis.stream_append", SpanKind::kClient);
+    auto permit = Admit();
+
+    auto add = [max_len](sw::redis::Pipeline& pipe, const std::pair<std::string, std::string>& entry) {
+        std::pair<sw::redis::StringView, sw::redis::StringView> field("p", entry.second);
+        pipe.xadd(entry.first, "*", &field, &field + 1, static_cast<long long>(max_len), true);
+    };
+    if (cluster_) {
+        // Streams hash to different nodes: one pipeline per run of entries for the same stream
+        for (size_t begin = 0; begin < entries.size();) {
+            size_t end = begin;
+            auto pipe = PipelineFor(entries[begin].first);
+            while (end < entries.size() && entries[end].first == entries[begin].first) {
+                add(pipe, entries[end++]);
+            }
+            pipe.exec();
+            begin = end;
+        }
+    } else {
+        auto pipe = PipelineFor({});
+        for (const auto& entry : entries) {
+            add(pipe, entry);
+        }
+        pipe.exec();
+    }
+}
+
+bool RedisClient::StreamCreateGroup(std::string_view key, std::string_view group, std::string_view start_id) {
+    auto permit = Admit();
+    try {
+        Run([&](auto& redis) { redis.xgroup_create(key, group, start_id, true); });
+    } catch (const sw::redis::ReplyError& e) {
+        if (std::string_view(e.what()).rfind("BUSYGROUP", 0) == 0) {
+            return false;
+        }
+        throw;
+    }
+    return true;
+}
+
+void RedisClient::StreamDestroyGroup(std::string_view key, std::string_view group) {
+    auto permit = Admit();
+    Run([&](auto& redis) { return redis.xgroup_destroy(key, group); });
+}
+
+std::vector<StreamMessage> RedisClient::StreamReadGroup(
+    std::string_view key,
+    std::string_view group,
+    std::string_view consumer,
+    std::string_view id,
+    size_t count,
+    std::chrono::milliseconds block
+) {
+    {
+        std::lock_guard<std::mutex> lock(streams_mutex_);
+        if (!stream_redis_ && !stream_cluster_) {
+            sw::redis::ConnectionOptions options(connection_string_);
+            options.connect_timeout = connect_timeout_;
+            options.socket_timeout = MAX_STREAM_BLOCK + STREAM_SOCKET_MARGIN;
+            sw::redis::ConnectionPoolOptions pool_options;
+            pool_options.size = pool_size_;
+            if (mode_ == RedisMode::CLUSTER) {
+                stream_cluster_ = std::make_unique<sw::redis::RedisCluster>(options, pool_options);
+            } else {
+                stream_redis_ = MakeNodeClient(options, pool_options);
+            }
+        }
+    }
+
+    // Not admitted through the dependency: a read blocks for as long as the bus is idle
+    using Attributes = std::vector<std::pair<std::string, std::string>>;
+    using Entries = std::vector<std::pair<std::string, std::optional<Attributes>>>;
+    std::unordered_map<std::string, Entries> streams;
+    auto read = [&](auto& redis) {
+        redis.xreadgroup(group, consumer, key, id, std::min(block, MAX_STREAM_BLOCK),
+                         static_cast<long long>(count), std::inserter(streams, streams.end()));
+    };
+    if (stream_cluster_) {
+        read(*stream_cluster_);
+    } else {
+        read(*stream_redis_);
+    }
+
+    std::vector<StreamMessage> messages;
+    for (auto& [stream, entries] : streams) {
+        messages.reserve(entries.size());
+        for (auto& [entry_id, attributes] : entries) {
+            auto& message = messages.emplace_back();
+            message.id = std::move(entry_id);
+            // A pending entry trimmed from the stream comes back without fields
+            if (attributes) {
+                for (auto& [field, value] : *attributes) {
+                    if (field == "p") {
+                        message.payload = std::move(value);
+                    }
+                }
+            }
+        }
+    }
+    return messages;
+}
+
+int64_t RedisClient::StreamAck(std::string_view key, std::string_view group, const std::vector<std::string>& ids) {
+    if (ids.empty()) {
+        return 0;
+    }
+    static Histogram& latency = CommandLatency("stream_ack");
+    auto timer = latency.StartTimer();
+    auto permit = Admit();
+    return Run([&](auto& redis) { return redis.xack(key, group, ids.begin(), ids.end()); });
+}
+
+void RedisClient::Warm() {
+    if (cluster_) {
+        // Node pools connect lazily too: a PING opens one connection per master
+        cluster_->for_each([](sw::redis::Redis& node) { node.ping(); });
+    } else {
+        // A non-transactional pipeline holds a pooled connection until it is
+        // destroyed, so pool_size_ of them alive at once open the whole pool;
+        // they connect concurrently, one thread each
+        std::mutex mutex;
+        std::condition_variable all_connected;
+        size_t arrived = 0;
+        std::string error;
+
+        std::vector<std::thread> threads;
+        threads.reserve(pool_size_);
+        for (size_t i = 0; i < pool_size_; ++i) {
+            threads.emplace_back([&] {
+                std::optional<sw::redis::Pipeline> pipe;
+                std::string failure;
+                try {
+                    pipe.emplace(redis_->pipeline(false));
+                    pipe->ping().exec();
+                } catch (const std::exception& e) {
+                    failure = e.what();
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!failure.empty()) {
+                    error = failure;
+                }
+                if (++arrived == pool_size_) {
+                    all_connected.notify_all();
+                }
+                all_connected.wait(lock, [&] { return arrived == pool_size_; });
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (!error.empty()) {
+            throw sw::redis::Error("Redis warm-up failed: " + error);
+        }
+    }
+
+    for (const char* script : {INCREMENT_WITH_TTL_LUA, ROTATE_SESSION_LUA, SET_IF_GREATER_LUA}) {
+        ScriptSha(script, false);
+    }
+}
+
+std::pair<std::string, int> RedisClient::TrackedNode(const sw::redis::ConnectionOptions& options) {
+    if (!sentinel_) {
+        return {options.host, options.port};
+    }
+    // After a failover the old master drops its clients, so the tracker
+    // reconnects here and follows the new one
+    std::string error = "no sentinel reachable";
+    for (const auto& [host, port] : sentinels_) {
+        ContextPtr context(redisConnectWithTimeout(host.c_str(), port, ToTimeval(connect_timeout_)));
+        if (!context || context->err) {
+            continue;
+        }
+        try {
+            auto reply = TrackerCommand(context.get(), {"SENTINEL", "get-master-addr-by-name", sentinel_master_});
+            if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 2) {
+                return {std::string(reply->element[0]->str, reply->element[0]->len),
+                        std::stoi(std::string(reply->element[1]->str, reply->element[1]->len))};
+            }
+            error = "unknown master " + sentinel_master_;
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    }
+    throw sw::redis::Error("Sentinel master lookup failed: " + error);
+}
+
+void RedisClient::RunTracker(std::vector<std::string> prefixes) {
+    sw::redis::ConnectionOptions options(connection_string_);
+
+    while (!stopping_.load()) {
+        try {
+            ContextPtr context;
+            if (options.type == sw::redis::ConnectionType::UNIX && !sentinel_) {
+                context.reset(redisConnectUnixWithTimeout(options.path.c_str(), ToTimeval(connect_timeout_)));
+            } else {
+                auto [host, port] = TrackedNode(options);
+                context.reset(redisConnectWithTimeout(host.c_str(), port, ToTimeval(connect_timeout_)));
+            }
+            if (!context || context->err) {
+                throw sw::redis::Error(std::string("connect failed: ") +
+                                       (context ? context->errstr : "out of memory"));
+            }
+
+            // Invalidation pushes need RESP3 (a RESP2 connection would have to REDIRECT)
+            std::vector<std::string> hello{"HELLO", "3"};
+            if (!options.password.empty()) {
+                hello.insert(hello.end(), {"AUTH", options.user.empty() ? "default" : options.user, options.password});
+            }
+            try {
+                TrackerCommand(context.get(), hello);
+            } catch (const sw::redis::ReplyError& e) {
+                if (std::string(e.what()).find("unknown command") == std::string::npos) {
+                    throw;
+                }
+                LogWarn("Redis client-side cache disabled: RESP3 needs Redis 6+", {{"error", e.what()}});
+                return;
+            }
+
+            std::vector<std::string> tracking{"CLIENT", "TRACKING", "ON", "BCAST"};
+            for (const auto& prefix : prefixes) {
+                tracking.insert(tracking.end(), {"PREFIX", prefix});
+            }
+            TrackerCommand(context.get(), tracking);
+            cache_->SetEnabled(true);
+            LogInfo("Redis client-side cache tracking enabled", {{"prefixes", std::to_string(prefixes.size())}});
+
+            while (!stopping_.load()) {
+                void* raw = nullptr;
+                if (redisGetReplyFromReader(context.get(), &raw) != REDIS_OK) {
+                    throw sw::redis::Error(std::string("tracking read failed: ") + context->errstr);
+                }
+                if (!raw) {
+                    // Nothing buffered: wait for the socket so shutdown stays responsive
+                    pollfd fd{context->fd, POLLIN, 0};
+                    int ready = poll(&fd, 1, TRACKER_POLL_TIMEOUT_MS);
+                    if (ready > 0 && redisBufferRead(context.get()) != REDIS_OK) {
+                        throw sw::redis::Error(std::string("tracking connection lost: ") + context->errstr);
+                    }
+                    continue;
+                }
+
+                // > invalidate [key...] | > invalidate nil (FLUSHALL/FLUSHDB)
+                ReplyPtr reply(static_cast<redisReply*>(raw));
+                if (reply->type != REDIS_REPLY_PUSH || reply->elements < 2 ||
+                    !ReplyIs(reply->element[0], "invalidate")) {
+                    continue;
+                }
+                const redisReply* keys = reply->element[1];
+                if (keys->type == REDIS_REPLY_ARRAY) {
+                    for (size_t i = 0; i < keys->elements; ++i) {
+                        cache_->Invalidate(std::string_view(keys->element[i]->str, keys->element[i]->len));
+                    }
+                } else {
+                    cache_->Flush();
+                }
+            }
+        } catch (const std::exception& e) {
+            // Invalidations sent while disconnected are lost: stop serving until tracking is back
+            cache_->SetEnabled(false);
+            LogError("Redis client-side cache tracking failed", {{"error", e.what()}});
+            std::this_thread::sleep_for(SUBSCRIBER_RECONNECT_DELAY);
+        }
+    }
+    cache_->SetEnabled(false);
+}
+
+void RedisClient::RunSubscriber(
+    std::string channel,
+    std::function<void(const std::string&)> handler,
+    std::function<void()> on_subscribed,
+    std::shared_ptr<std::atomic<bool>> stop
+) {
+    auto should_stop = [this, &stop]() { return stopping_.load() || stop->load(); };
+
+    while (!should_stop()) {
+        try {
+            auto subscriber = subscriber_cluster_ ? subscriber_cluster_->subscriber()
+                                                  : subscriber_redis_->subscriber();
+            subscriber.on_message([&handler](std::string, std::string message) {
+                handler(message);
+            });
+            subscriber.subscribe(channel);
+            if (on_subscribed) {
+                on_subscribed();
+            }
+
+            while (!should_stop()) {
+                try {
+                    subscriber.consume();
+                } catch (const sw::redis::TimeoutError&) {
+                    // Poll timeout: re-check for shutdown
+                }
+            }
+        } catch (const std::exception& e) {
+            LogError("Redis subscriber failed", {{"channel", channel}, {"error", e.what()}});
+            std::this_thread::sleep_for(SUBSCRIBER_RECONNECT_DELAY);
+        }
     }
-    return count;
 }
 
 } // namespace common
@@ -0,0 +1,163 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Local LRU of Redis values kept correct by server-assisted invalidation implementation
+ */
+
+#include "common/redis_client_cache.h"
+#include "common/metrics.h"
+#include <algorithm>
+#include <functional>
+
+namespace saasforge {
+namespace common {
+
+RedisClientCache::RedisClientCache(size_t capacity, std::chrono::milliseconds max_age,
+                                   std::vector<std::string> prefixes)
+    : stripe_capacity_(std::max<size_t>(1, (capacity + NUM_STRIPES - 1) / NUM_STRIPES)),
+      max_age_(max_age),
+      prefixes_(std::move(prefixes)),
+      stripes_(std::make_unique<Stripe[]>(NUM_STRIPES)) {
+    metrics_collector_ = MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        auto stats = GetStats();
+        writer.AddGauge("saasforge_redis_client_cache_entries", "Keys held in the Redis client-side cache", {},
+                        static_cast<double>(stats.entries));
+        writer.AddCounter("saasforge_redis_client_cache_lookups_total", "Redis client-side cache lookups",
+                          {{"result", "hit"}}, static_cast<double>(stats.hits));
+        writer.AddCounter("saasforge_redis_client_cache_lookups_total", "Redis client-side cache lookups",
+                          {{"result", "miss"}}, static_cast<double>(stats.misses));
+        writer.AddCounter("saasforge_redis_client_cache_invalidations_total", "Keys invalidated", {},
+                          static_cast<double>(stats.invalidations));
+        writer.AddCounter("saasforge_redis_client_cache_flushes_total", "Whole-cache flushes", {},
+                          static_cast<double>(stats.flushes));
+    });
+}
+
+RedisClientCache::~RedisClientCache() {
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+RedisClientCache::Stripe& RedisClientCache::StripeFor(std::string_view key) const {
+    return stripes_[std::hash<std::string_view>{}(key) % NUM_STRIPES];
+}
+
+bool RedisClientCache::Covers(std::string_view key) const {
+    for (const auto& prefix : prefixes_) {
+        if (key.substr(0, prefix.size()) == prefix) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<std::optional<std::string>> RedisClientCache::Get(std::string_view key) {
+    if (!enabled_.load(std::memory_order_acquire)) {
+        ++misses_;
+        return std::nullopt;
+    }
+    Stripe& stripe = StripeFor(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.index.find(key);
+    if (it == stripe.index.end()) {
+        ++misses_;
+        return std::nullopt;
+    }
+    if (std::chrono::steady_clock::now() >= it->second->expires) {
+        auto entry = it->second;
+        stripe.index.erase(it);
+        stripe.lru.erase(entry);
+        ++misses_;
+        return std::nullopt;
+    }
+    stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+    ++hits_;
+    return it->second->value;
+}
+
+uint64_t RedisClientCache::Ticket(std::string_view key) const {
+    Stripe& stripe = StripeFor(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    return stripe.generation;
+}
+
+void RedisClientCache::Put(std::string_view key, std::optional<std::string> value, std::chrono::milliseconds ttl,
+                           uint64_t ticket) {
+    if (!enabled_.load(std::memory_order_acquire)) {
+        return;
+    }
+    auto lifetime = ttl.count() >= 0 ? std::min(ttl, max_age_) : max_age_;
+    if (lifetime.count() <= 0) {
+        return;
+    }
+    auto expires = std::chrono::steady_clock::now() + lifetime;
+
+    Stripe& stripe = StripeFor(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (stripe.generation != ticket) {
+        return;   // Invalidated while the value was being fetched
+    }
+    auto it = stripe.index.find(key);
+    if (it != stripe.index.end()) {
+        it->second->value = std::move(value);
+        it->second->expires = expires;
+        stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+        return;
+    }
+    stripe.lru.push_front({std::string(key), std::move(value), expires});
+    stripe.index.emplace(stripe.lru.front().key, stripe.lru.begin());
+    if (stripe.lru.size() > stripe_capacity_) {
+        stripe.index.erase(stripe.lru.back().key);
+        stripe.lru.pop_back();
+    }
+}
+
+void RedisClientCache::Invalidate(std::string_view key) {
+    Stripe& stripe = StripeFor(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    ++stripe.generation;
+    auto it = stripe.index.find(key);
+    if (it != stripe.index.end()) {
+        auto entry = it->second;
+        stripe.index.erase(it);
+        stripe.lru.erase(entry);
+    }
+    ++invalidations_;
+}
+
+void RedisClientCache::Flush() {
+    for (size_t i = 0; i < NUM_STRIPES; ++i) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        ++stripes_[i].generation;
+        stripes_[i].index.clear();
+        stripes_[i].lru.clear();
+    }
+    ++flushes_;
+}
+
+void RedisClientCache::SetEnabled(bool enabled) {
+    if (!enabled) {
+        // Stop serving first: nothing is read from a cache that is being emptied
+        enabled_.store(false, std::memory_order_release);
+        Flush();
+        return;
+    }
+    // Fetches started while disabled may predate writes whose invalidation was missed
+    Flush();
+    enabled_.store(true, std::memory_order_release);
+}
+
+RedisClientCacheStats RedisClientCache::GetStats() const {
+    RedisClientCacheStats stats;
+    for (size_t i = 0; i < NUM_STRIPES; ++i) {
+        std::lock_guard<std::mutex> lock(stripes_[i].mutex);
+        stats.entries += stripes_[i].lru.size();
+    }
+    stats.hits = hits_.load();
+    stats.misses = misses_.load();
+    stats.invalidations = invalidations_.load();
+    stats.flushes = flushes_.load();
+    return stats;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,330 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Circuit breakers, adaptive concurrency limits and deadline propagation for Postgres and Redis implementation
+ */
+
+#include "common/resilience.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+thread_local ResilienceScope* current_scope = nullptr;
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// CircuitBreaker
+// ---------------------------------------------------------------------------
+
+CircuitBreaker::CircuitBreaker(CircuitBreakerOptions options) : options_(options) {}
+
+bool CircuitBreaker::Allow() {
+    if (state_.load(std::memory_order_acquire) == State::CLOSED) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    State state = state_.load(std::memory_order_relaxed);
+    if (state == State::CLOSED) {
+        return true;
+    }
+    if (state == State::OPEN && std::chrono::steady_clock::now() - opened_at_ >= options_.open_duration) {
+        state_.store(State::HALF_OPEN, std::memory_order_release);
+        probing_ = true;
+        return true;
+    }
+    return false;   // Open, or the half-open probe has not finished yet
+}
+
+void CircuitBreaker::RecordSuccess() {
+    if (state_.load(std::memory_order_acquire) == State::CLOSED) {
+        if (failures_.load(std::memory_order_relaxed) != 0) {
+            failures_.store(0, std::memory_order_relaxed);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    failures_.store(0, std::memory_order_relaxed);
+    probing_ = false;
+    state_.store(State::CLOSED, std::memory_order_release);
+}
+
+void CircuitBreaker::RecordFailure() {
+    if (options_.failure_threshold == 0) {
+        return;
+    }
+    State state = state_.load(std::memory_order_acquire);
+    if (state == State::CLOSED &&
+        failures_.fetch_add(1, std::memory_order_relaxed) + 1 < options_.failure_threshold) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_.load(std::memory_order_relaxed) == State::OPEN) {
+        return;   // A call admitted before it opened; keep the original open time
+    }
+    opened_at_ = std::chrono::steady_clock::now();
+    probing_ = false;
+    failures_.store(0, std::memory_order_relaxed);
+    state_.store(State::OPEN, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------------
+// AdaptiveLimit
+// ---------------------------------------------------------------------------
+
+AdaptiveLimitOptions AdaptiveLimitOptions::ForCapacity(size_t capacity) const {
+    AdaptiveLimitOptions filled = *this;
+    uint32_t base = static_cast<uint32_t>(std::max<size_t>(capacity, 1));
+    if (filled.min_limit == 0) {
+        filled.min_limit = base;
+    }
+    if (filled.max_limit == 0) {
+        filled.max_limit = std::max(base * 4, filled.min_limit);
+    }
+    if (filled.initial_limit == 0) {
+        filled.initial_limit = base * 2;
+    }
+    filled.max_limit = std::max(filled.max_limit, filled.min_limit);
+    filled.initial_limit = std::clamp(filled.initial_limit, filled.min_limit, filled.max_limit);
+    return filled;
+}
+
+AdaptiveLimit::AdaptiveLimit(AdaptiveLimitOptions options)
+    : options_(options.ForCapacity(options.min_limit)), limit_(options_.initial_limit),
+      estimate_(static_cast<double>(options_.initial_limit)) {
+    options_.smoothing = std::clamp(options_.smoothing, 0.01, 1.0);
+}
+
+bool AdaptiveLimit::TryAcquire() {
+    uint32_t current = in_flight_.load(std::memory_order_relaxed);
+    while (true) {
+        if (current >= limit_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (in_flight_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+void AdaptiveLimit::Release(std::chrono::steady_clock::duration rtt, bool dropped) {
+    uint32_t in_flight = in_flight_.fetch_sub(1, std::memory_order_relaxed);
+    int64_t rtt_us = std::max<int64_t>(
+        1, std::chrono::duration_cast<std::chrono::microseconds>(rtt).count());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    double limit = estimate_;
+    if (!dropped) {
+        if (++samples_since_probe_ >= static_cast<uint64_t>(30.0 * limit)) {
+            rtt_noload_us_ = 0;   // Forget the old minimum: the dependency may have changed
+            samples_since_probe_ = 0;
+        }
+        if (rtt_noload_us_ == 0 || rtt_us < rtt_noload_us_) {
+            rtt_noload_us_ = rtt_us;
+        }
+    }
+
+    double log_limit = std::max(1.0, std::log10(limit));
+    double next = limit;
+    if (dropped) {
+        next = limit - log_limit;
+    } else if (static_cast<double>(in_flight) * 2 < limit) {
+        return;   // Application-limited: the RTT says nothing about a higher limit
+    } else {
+        double queue = limit * (1.0 - static_cast<double>(rtt_noload_us_) / static_cast<double>(rtt_us));
+        if (queue <= log_limit) {
+            next = limit + 6 * log_limit;
+        } else if (queue < 3 * log_limit) {
+            next = limit + log_limit;
+        } else if (queue > 6 * log_limit) {
+            next = limit - log_limit;
+        }
+    }
+    next = std::clamp(next, static_cast<double>(options_.min_limit), static_cast<double>(options_.max_limit));
+    estimate_ = (1.0 - options_.smoothing) * limit + options_.smoothing * next;
+    limit_.store(static_cast<uint32_t>(std::lround(estimate_)), std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// DependencyOptions
+// ---------------------------------------------------------------------------
+
+DependencyOptions DependencyOptions::FromEnv(const std::string& prefix) {
+    DependencyOptions options;
+    options.breaker.failure_threshold = static_cast<uint32_t>(
+        EnvInt(prefix + "_BREAKER_FAILURES", options.breaker.failure_threshold));
+    options.breaker.open_duration = std::chrono::milliseconds(
+        EnvInt(prefix + "_BREAKER_OPEN_MS", static_cast<long>(options.breaker.open_duration.count())));
+    options.limit.enabled = EnvInt(prefix + "_ADAPTIVE_LIMIT", 1) != 0;
+    options.limit.min_limit = static_cast<uint32_t>(EnvInt(prefix + "_LIMIT_MIN", 0));
+    options.limit.max_limit = static_cast<uint32_t>(EnvInt(prefix + "_LIMIT_MAX", 0));
+    options.limit.initial_limit = static_cast<uint32_t>(EnvInt(prefix + "_LIMIT_INITIAL", 0));
+    return options;
+}
+
+// ---------------------------------------------------------------------------
+// ResilienceScope
+// ---------------------------------------------------------------------------
+
+ResilienceScope::ResilienceScope(std::chrono::system_clock::time_point deadline) : previous_(current_scope) {
+    // gRPC reports "no deadline" as time_point::max(); anything a year out is the same
+    auto now = std::chrono::system_clock::now();
+    if (deadline != std::chrono::system_clock::time_point::max() && deadline - now < std::chrono::hours(24 * 365)) {
+        deadline_ = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline - now);
+    } else if (previous_) {
+        deadline_ = previous_->deadline_;
+    }
+    if (previous_) {
+        context_ = previous_->context_;
+    }
+    current_scope = this;
+}
+
+ResilienceScope::ResilienceScope(const grpc::ServerContextBase* context) : ResilienceScope(context->deadline()) {
+    context_ = context;
+}
+
+ResilienceScope::~ResilienceScope() {
+    current_scope = previous_;
+}
+
+grpc::Status ResilienceScope::Finish(grpc::Status status) const {
+    if (shed_.empty() || status.error_code() != grpc::StatusCode::INTERNAL) {
+        return status;
+    }
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE, shed_);
+}
+
+std::optional<std::chrono::steady_clock::time_point> ResilienceScope::Deadline() {
+    return current_scope ? current_scope->deadline_ : std::nullopt;
+}
+
+const grpc::ServerContextBase* ResilienceScope::Context() {
+    return current_scope ? current_scope->context_ : nullptr;
+}
+
+std::chrono::steady_clock::time_point ResilienceScope::DeadlineOr(std::chrono::steady_clock::time_point fallback) {
+    auto deadline = Deadline();
+    return deadline ? std::min(*deadline, fallback) : fallback;
+}
+
+void ResilienceScope::MarkShed(const std::string& reason) {
+    if (current_scope) {
+        current_scope->shed_ = reason;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Dependency
+// ---------------------------------------------------------------------------
+
+Dependency::Permit::~Permit() {
+    if (dependency_) {
+        Release(std::uncaught_exceptions() > exceptions_);
+    }
+}
+
+Dependency::Permit::Permit(Permit&& other) noexcept
+    : dependency_(other.dependency_), limited_(other.limited_), started_(other.started_),
+      exceptions_(other.exceptions_) {
+    other.dependency_ = nullptr;
+}
+
+Dependency::Permit& Dependency::Permit::operator=(Permit&& other) noexcept {
+    if (this != &other) {
+        if (dependency_) {
+            Release(false);
+        }
+        dependency_ = other.dependency_;
+        limited_ = other.limited_;
+        started_ = other.started_;
+        exceptions_ = other.exceptions_;
+        other.dependency_ = nullptr;
+    }
+    return *this;
+}
+
+void Dependency::Permit::Release(bool failed) {
+    if (!dependency_) {
+        return;
+    }
+    dependency_->Done(std::chrono::steady_clock::now() - started_, failed, limited_);
+    dependency_ = nullptr;
+}
+
+Dependency::Dependency(std::string name, DependencyOptions options, MetricsRegistry& registry)
+    : name_(std::move(name)), options_(options), breaker_(options.breaker), limit_(options.limit),
+      registry_(registry),
+      rejected_open_(registry.GetCounter("saasforge_dependency_rejected_total",
+                                         "Calls refused without reaching the dependency",
+                                         {{"dependency", name_}, {"reason", "open"}})),
+      rejected_limit_(registry.GetCounter("saasforge_dependency_rejected_total",
+                                          "Calls refused without reaching the dependency",
+                                          {{"dependency", name_}, {"reason", "limit"}})),
+      rejected_deadline_(registry.GetCounter("saasforge_dependency_rejected_total",
+                                             "Calls refused without reaching the dependency",
+                                             {{"dependency", name_}, {"reason", "deadline"}})),
+      failures_(registry.GetCounter("saasforge_dependency_failures_total",
+                                    "Calls to the dependency that failed", {{"dependency", name_}})) {
+    collector_ = registry_.AddCollector([this](MetricsWriter& writer) {
+        MetricLabels labels = {{"dependency", name_}};
+        writer.AddGauge("saasforge_dependency_concurrency_limit", "Adaptive concurrency limit", labels,
+                        static_cast<double>(limit_.Limit()));
+        writer.AddGauge("saasforge_dependency_in_flight", "Calls outstanding against the dependency", labels,
+                        static_cast<double>(limit_.InFlight()));
+        writer.AddGauge("saasforge_dependency_breaker_state",
+                        "Circuit breaker state (0 closed, 1 open, 2 half-open)", labels,
+                        static_cast<double>(breaker_.GetState()));
+    });
+}
+
+Dependency::~Dependency() {
+    registry_.RemoveCollector(collector_);
+}
+
+Dependency::Permit Dependency::Admit() {
+    auto deadline = ResilienceScope::Deadline();
+    if (deadline && *deadline <= std::chrono::steady_clock::now()) {
+        Reject("deadline", rejected_deadline_);
+    }
+    bool limited = options_.limit.enabled;
+    if (limited && !limit_.TryAcquire()) {
+        Reject("limit", rejected_limit_);
+    }
+    if (!breaker_.Allow()) {
+        if (limited) {
+            limit_.Cancel();
+        }
+        Reject("open", rejected_open_);
+    }
+    return Permit(this, limited);
+}
+
+void Dependency::Reject(const char* reason, Counter& counter) {
+    counter.Increment();
+    DependencyUnavailable error(name_, reason);
+    ResilienceScope::MarkShed(error.what());
+    throw error;
+}
+
+void Dependency::Done(std::chrono::steady_clock::duration rtt, bool failed, bool limited) {
+    if (limited) {
+        limit_.Release(rtt, failed);
+    }
+    if (failed) {
+        failures_.Increment();
+        breaker_.RecordFailure();
+    } else {
+        breaker_.RecordSuccess();
+    }
+}
+
+} // namespace common
+} // namespace saasforge
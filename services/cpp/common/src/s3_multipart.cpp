@@ -0,0 +1,376 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description S3 multipart upload client implementation
+ */
+
+#include "common/s3_multipart.h"
+#include "common/codec.h"
+#include <algorithm>
+#include <curl/curl.h>
+#include <openssl/evp.h>
+#include <mutex>
+#include <stdexcept>
+#include <strings.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr int64_t CONTROL_URL_EXPIRES_S = 60;
+constexpr int64_t MIB = 1024 * 1024;
+constexpr const char* USER_AGENT = "SaaSForge-Upload/1.0";
+
+std::once_flag curl_init_once;
+
+size_t AppendBody(char* data, size_t size, size_t count, void* user) {
+    static_cast<std::string*>(user)->append(data, size * count);
+    return size * count;
+}
+
+// Keeps the ETag header value
+size_t CaptureEtag(char* data, size_t size, size_t count, void* user) {
+    size_t length = size * count;
+    std::string line(data, length);
+    if (line.size() > 5 && strncasecmp(line.c_str(), "etag:", 5) == 0) {
+        size_t start = line.find_first_not_of(" \t", 5);
+        size_t end = line.find_last_not_of(" \t\r\n");
+        if (start != std::string::npos && end != std::string::npos && end >= start) {
+            *static_cast<std::string*>(user) = line.substr(start, end - start + 1);
+        }
+    }
+    return length;
+}
+
+std::string XmlUnescape(const std::string& value) {
+    if (value.find('&') == std::string::npos) {
+        return value;
+    }
+    static const std::pair<const char*, char> entities[] = {
+        {"&quot;", '"'}, {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&apos;", '\''}, {"&#34;", '"'}};
+
+    std::string out;
+    out.reserve(value.size());
+    for (size_t i = 0; i < value.size();) {
+        bool replaced = false;
+        if (value[i] == '&') {
+            for (const auto& entity : entities) {
+                size_t length = std::char_traits<char>::length(entity.first);
+                if (value.compare(i, length, entity.first) == 0) {
+                    out.push_back(entity.second);
+                    i += length;
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (!replaced) {
+            out.push_back(value[i++]);
+        }
+    }
+    return out;
+}
+
+void AppendXmlEscaped(std::string& out, const std::string& value) {
+    for (char c : value) {
+        switch (c) {
+            case '"': out.append("&quot;"); break;
+            case '&': out.append("&amp;"); break;
+            case '<': out.append("&lt;"); break;
+            case '>': out.append("&gt;"); break;
+            default: out.push_back(c);
+        }
+    }
+}
+
+// Text of the first <tag>...</tag> in xml[from, to); empty if absent
+std::string XmlTag(const std::string& xml, const std::string& tag, size_t from = 0,
+                   size_t to = std::string::npos) {
+    const std::string open = "<" + tag + ">";
+    const std::string close = "</" + tag + ">";
+    size_t start = xml.find(open, from);
+    if (start == std::string::npos || start >= to) {
+        return "";
+    }
+    start += open.size();
+    size_t end = xml.find(close, start);
+    if (end == std::string::npos || end > to) {
+        return "";
+    }
+    return XmlUnescape(xml.substr(start, end - start));
+}
+
+std::string ErrorMessage(const std::string& operation, const S3HttpResponse& response) {
+    std::string message = "S3 " + operation + " failed";
+    std::string code = XmlTag(response.body, "Code");
+    if (!code.empty()) {
+        message += ": " + code;
+        std::string detail = XmlTag(response.body, "Message");
+        if (!detail.empty()) {
+            message += " (" + detail + ")";
+        }
+    } else {
+        message += ": HTTP " + std::to_string(response.status);
+    }
+    return message;
+}
+
+} // namespace
+
+S3MultipartClient::S3MultipartClient(std::shared_ptr<S3Presigner> presigner,
+                                     std::chrono::milliseconds request_timeout)
+    : S3MultipartClient(std::move(presigner), CurlTransport(request_timeout)) {}
+
+S3MultipartClient::S3MultipartClient(std::shared_ptr<S3Presigner> presigner, Transport transport)
+    : presigner_(std::move(presigner)), transport_(std::move(transport)) {
+    if (!presigner_) {
+        throw std::invalid_argument("S3MultipartClient requires a presigner");
+    }
+}
+
+S3MultipartClient::Transport S3MultipartClient::CurlTransport(std::chrono::milliseconds request_timeout) {
+    return [request_timeout](const std::string& method, const std::string& url,
+                             const std::string& body, const std::vector<std::string>& extra_headers) {
+        std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+        CURL* easy = curl_easy_init();
+        if (!easy) {
+            throw std::runtime_error("curl_easy_init failed");
+        }
+
+        curl_slist* headers = curl_slist_append(nullptr, "Expect:");
+        for (const auto& header : extra_headers) {
+            headers = curl_slist_append(headers, header.c_str());
+        }
+
+        S3HttpResponse response;
+        char error[CURL_ERROR_SIZE] = {0};
+        curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+        if (method == "POST" || method == "PUT") {
+            curl_easy_setopt(easy, CURLOPT_POST, 1L);
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDS, body.data());
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+            if (method == "PUT") {
+                curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "PUT");
+            }
+        } else if (method != "GET") {
+            curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, method.c_str());
+        }
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(easy, CURLOPT_USERAGENT, USER_AGENT);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, AppendBody);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response.body);
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, CaptureEtag);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, &response.etag);
+        curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, error);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_PROTOCOLS_STR, "http,https");
+        curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, 5000L);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(request_timeout.count()));
+
+        CURLcode code = curl_easy_perform(easy);
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status);
+        curl_slist_free_all(headers);
+        curl_easy_cleanup(easy);
+
+        if (code != CURLE_OK) {
+            throw std::runtime_error(std::string("S3 request failed: ") + (error[0] ? error : curl_easy_strerror(code)));
+        }
+        return response;
+    };
+}
+
+S3HttpResponse S3MultipartClient::Call(const std::string& method, const std::string& url,
+                                       const std::string& body, const std::vector<std::string>& headers) const {
+    return transport_(method, url, body, headers);
+}
+
+std::string S3MultipartClient::Create(const std::string& key, const std::string& content_type) const {
+    std::string url = presigner_->Presign("POST", key, CONTROL_URL_EXPIRES_S, {{"uploads", ""}});
+    std::vector<std::string> headers;
+    if (!content_type.empty()) {
+        headers.push_back("Content-Type: " + content_type);
+    }
+    auto response = Call("POST", url, "", headers);
+    if (response.status != 200) {
+        throw std::runtime_error(ErrorMessage("CreateMultipartUpload", response));
+    }
+
+    std::string upload_id = XmlTag(response.body, "UploadId");
+    if (upload_id.empty()) {
+        throw std::runtime_error("S3 CreateMultipartUpload returned no UploadId");
+    }
+    return upload_id;
+}
+
+std::string S3MultipartClient::PresignPart(const std::string& key, const std::string& upload_id,
+                                           int32_t part_number, int64_t expires_in) const {
+    return presigner_->Presign("PUT", key, expires_in,
+                               {{"partNumber", std::to_string(part_number)}, {"uploadId", upload_id}});
+}
+
+std::vector<S3Part> S3MultipartClient::ListParts(const std::string& key, const std::string& upload_id) const {
+    std::vector<S3Part> parts;
+    std::string marker;
+
+    for (;;) {
+        S3Presigner::QueryParams query{{"uploadId", upload_id}};
+        if (!marker.empty()) {
+            query.emplace_back("part-number-marker", marker);
+        }
+
+        auto response = Call("GET", presigner_->Presign("GET", key, CONTROL_URL_EXPIRES_S, query), "", {});
+        if (response.status != 200) {
+            throw std::runtime_error(ErrorMessage("ListParts", response));
+        }
+
+        const std::string& xml = response.body;
+        for (size_t pos = xml.find("<Part>"); pos != std::string::npos; pos = xml.find("<Part>", pos)) {
+            size_t end = xml.find("</Part>", pos);
+            if (end == std::string::npos) {
+                break;
+            }
+
+            S3Part part;
+            part.part_number = static_cast<int32_t>(std::stol(XmlTag(xml, "PartNumber", pos, end)));
+            part.etag = XmlTag(xml, "ETag", pos, end);
+            std::string size = XmlTag(xml, "Size", pos, end);
+            part.size = size.empty() ? 0 : std::stoll(size);
+            parts.push_back(std::move(part));
+            pos = end;
+        }
+
+        if (XmlTag(xml, "IsTruncated") != "true") {
+            break;
+        }
+        marker = XmlTag(xml, "NextPartNumberMarker");
+        if (marker.empty()) {
+            break;
+        }
+    }
+    return parts;
+}
+
+std::string S3MultipartClient::Complete(const std::string& key, const std::string& upload_id,
+                                        const std::vector<S3Part>& parts) const {
+    std::string body;
+    body.reserve(64 + parts.size() * 96);
+    body.append("<CompleteMultipartUpload>");
+    for (const auto& part : parts) {
+        body.append("<Part><PartNumber>").append(std::to_string(part.part_number)).append("</PartNumber><ETag>");
+        AppendXmlEscaped(body, part.etag);
+        body.append("</ETag></Part>");
+    }
+    body.append("</CompleteMultipartUpload>");
+
+    std::string url = presigner_->Presign("POST", key, CONTROL_URL_EXPIRES_S, {{"uploadId", upload_id}});
+    auto response = Call("POST", url, body, {"Content-Type: application/xml"});
+
+    // S3 can report a failure with 200 once it has started streaming the response
+    if (response.status != 200 || response.body.find("<Error>") != std::string::npos) {
+        throw std::runtime_error(ErrorMessage("CompleteMultipartUpload", response));
+    }
+    return XmlTag(response.body, "ETag");
+}
+
+void S3MultipartClient::Abort(const std::string& key, const std::string& upload_id) const {
+    std::string url = presigner_->Presign("DELETE", key, CONTROL_URL_EXPIRES_S, {{"uploadId", upload_id}});
+    auto response = Call("DELETE", url, "", {});
+    // 404: already aborted or completed
+    if (response.status != 204 && response.status != 200 && response.status != 404) {
+        throw std::runtime_error(ErrorMessage("AbortMultipartUpload", response));
+    }
+}
+
+std::string S3MultipartClient::UploadPart(const std::string& key, const std::string& upload_id,
+                                          int32_t part_number, const std::string& data) const {
+    auto response = Call("PUT", PresignPart(key, upload_id, part_number, CONTROL_URL_EXPIRES_S), data, {});
+    if (response.status != 200) {
+        throw std::runtime_error(ErrorMessage("UploadPart", response));
+    }
+    if (response.etag.empty()) {
+        throw std::runtime_error("S3 UploadPart returned no ETag");
+    }
+    return response.etag;
+}
+
+std::string S3MultipartClient::GetRange(const std::string& key, int64_t offset, int64_t length) const {
+    if (offset < 0 || length <= 0) {
+        throw std::invalid_argument("Invalid byte range");
+    }
+    std::string range = "Range: bytes=" + std::to_string(offset) + "-" + std::to_string(offset + length - 1);
+    auto response = Call("GET", presigner_->Presign("GET", key, CONTROL_URL_EXPIRES_S), "", {range});
+
+    // 206 for the range; 200 only if S3 ignored it (then the slice is ours to take)
+    if (response.status == 200) {
+        if (static_cast<int64_t>(response.body.size()) <= offset) {
+            return "";
+        }
+        return response.body.substr(static_cast<size_t>(offset), static_cast<size_t>(length));
+    }
+    if (response.status == 416) {
+        return "";  // Offset past the end
+    }
+    if (response.status != 206) {
+        throw std::runtime_error(ErrorMessage("GetObject", response));
+    }
+    return std::move(response.body);
+}
+
+std::vector<S3DeleteError> S3MultipartClient::DeleteObjects(const std::vector<std::string>& keys) const {
+    if (keys.size() > MAX_DELETE_KEYS) {
+        throw std::invalid_argument("DeleteObjects takes at most 1000 keys");
+    }
+    if (keys.empty()) {
+        return {};
+    }
+
+    std::string body;
+    body.reserve(48 + keys.size() * 96);
+    body.append("<Delete><Quiet>true</Quiet>");
+    for (const auto& key : keys) {
+        body.append("<Object><Key>");
+        AppendXmlEscaped(body, key);
+        body.append("</Key></Object>");
+    }
+    body.append("</Delete>");
+
+    // Required by S3 for this call
+    unsigned char md5[EVP_MAX_MD_SIZE];
+    unsigned int md5_size = 0;
+    EVP_Digest(body.data(), body.size(), md5, &md5_size, EVP_md5(), nullptr);
+
+    std::string url = presigner_->PresignBucket("POST", CONTROL_URL_EXPIRES_S, {{"delete", ""}});
+    auto response = Call("POST", url, body,
+                         {"Content-Type: application/xml", "Content-MD5: " + Base64Encode(md5, md5_size)});
+    if (response.status != 200 || response.body.find("<DeleteResult") == std::string::npos) {
+        throw std::runtime_error(ErrorMessage("DeleteObjects", response));
+    }
+
+    // Quiet mode lists only the failures
+    std::vector<S3DeleteError> errors;
+    const std::string& xml = response.body;
+    for (size_t pos = xml.find("<Error>"); pos != std::string::npos; pos = xml.find("<Error>", pos)) {
+        size_t end = xml.find("</Error>", pos);
+        if (end == std::string::npos) {
+            break;
+        }
+        errors.push_back({XmlTag(xml, "Key", pos, end), XmlTag(xml, "Code", pos, end)});
+        pos = end;
+    }
+    return errors;
+}
+
+int64_t S3MultipartClient::ChoosePartSize(int64_t content_length, int64_t min_part_size) {
+    int64_t part_size = std::max(min_part_size, MIN_PART_SIZE);
+    int64_t needed = (content_length + MAX_PARTS - 1) / MAX_PARTS;
+    if (needed > part_size) {
+        // Round up to whole MiB
+        part_size = (needed + MIB - 1) / MIB * MIB;
+    }
+    return std::min(part_size, MAX_PART_SIZE);
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,264 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description S3 SigV4 presigner implementation
+ */
+
+#include "common/s3_presigner.h"
+#include "common/codec.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr const char* ALGORITHM = "AWS4-HMAC-SHA256";
+constexpr const char* SERVICE = "s3";
+constexpr int64_t MAX_EXPIRES = 604800;   // SigV4 limit: 7 days
+
+std::string EnvOr(const char* primary, const char* fallback, const std::string& default_value) {
+    return EnvString(primary, fallback ? EnvString(fallback, default_value) : default_value);
+}
+
+void AppendHex(std::string& out, const unsigned char* data, size_t length) {
+    size_t offset = out.size();
+    out.resize(offset + HexEncodedLength(length));
+    HexEncode(data, length, &out[offset]);
+}
+
+void Hmac(const unsigned char* key, size_t key_length, std::string_view data, unsigned char out[32]) {
+    unsigned int length = 0;
+    if (!HMAC(EVP_sha256(), key, static_cast<int>(key_length),
+              reinterpret_cast<const unsigned char*>(data.data()), data.size(), out, &length)) {
+        throw std::runtime_error("HMAC-SHA256 failed");
+    }
+}
+
+void AppendDigits(std::string& out, int value, int width) {
+    char buffer[8];
+    for (int i = width - 1; i >= 0; --i) {
+        buffer[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    out.append(buffer, static_cast<size_t>(width));
+}
+
+void AppendParam(std::string& out, std::string_view name, std::string_view value) {
+    if (!out.empty() && out.back() != '?') {
+        out.push_back('&');
+    }
+    S3Presigner::UriEncode(out, name, true);
+    out.push_back('=');
+    S3Presigner::UriEncode(out, value, true);
+}
+
+} // namespace
+
+S3PresignerOptions S3PresignerOptions::FromEnv() {
+    S3PresignerOptions options;
+    options.bucket = EnvOr("S3_BUCKET", nullptr, "saasforge-uploads");
+    options.region = EnvOr("S3_REGION", nullptr, options.region);
+    options.access_key_id = EnvOr("S3_ACCESS_KEY_ID", "AWS_ACCESS_KEY_ID", "");
+    options.secret_access_key = EnvOr("S3_SECRET_ACCESS_KEY", "AWS_SECRET_ACCESS_KEY", "");
+    options.session_token = EnvOr("AWS_SESSION_TOKEN", nullptr, "");
+    options.endpoint = EnvOr("S3_ENDPOINT_URL", "S3_ENDPOINT", "");
+    // Custom endpoints (LocalStack, MinIO) rarely resolve bucket subdomains
+    std::string path_style = EnvOr("S3_FORCE_PATH_STYLE", nullptr, options.endpoint.empty() ? "0" : "1");
+    options.path_style = path_style == "1" || path_style == "true";
+    return options;
+}
+
+S3Presigner::S3Presigner(const S3PresignerOptions& options) : options_(options) {
+    if (options_.bucket.empty()) {
+        throw std::invalid_argument("S3 bucket required");
+    }
+
+    std::string endpoint = options_.endpoint.empty()
+        ? "https://s3." + options_.region + ".amazonaws.com"
+        : options_.endpoint;
+    while (!endpoint.empty() && endpoint.back() == '/') {
+        endpoint.pop_back();
+    }
+
+    size_t scheme_end = endpoint.find("://");
+    if (scheme_end == std::string::npos) {
+        scheme_ = "https://";
+        host_ = endpoint;
+    } else {
+        scheme_ = endpoint.substr(0, scheme_end + 3);
+        host_ = endpoint.substr(scheme_end + 3);
+    }
+
+    if (options_.path_style) {
+        path_prefix_ = "/";
+        UriEncode(path_prefix_, options_.bucket, true);
+    } else {
+        host_ = options_.bucket + "." + host_;
+    }
+    credential_tail_ = "/" + options_.region + "/" + SERVICE + "/aws4_request";
+
+    if (options_.access_key_id.empty() || options_.secret_access_key.empty()) {
+        LogWarn("S3Presigner: no credentials configured, presigned URLs will be rejected");
+    }
+}
+
+void S3Presigner::UriEncode(std::string& out, std::string_view value, bool encode_slash) {
+    for (unsigned char c : value) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+            c == '-' || c == '_' || c == '.' || c == '~' || (c == '/' && !encode_slash)) {
+            out.push_back(static_cast<char>(c));
+        } else {
+            out.push_back('%');
+            out.push_back("0123456789ABCDEF"[c >> 4]);
+            out.push_back("0123456789ABCDEF"[c & 0xf]);
+        }
+    }
+}
+
+S3Presigner::SigningKey S3Presigner::KeyFor(const std::string& date) const {
+    {
+        std::lock_guard<std::mutex> lock(key_mutex_);
+        if (cached_key_.date == date) {
+            return cached_key_;
+        }
+    }
+
+    SigningKey derived;
+    derived.date = date;
+    std::string secret = "AWS4" + options_.secret_access_key;
+    unsigned char date_key[32], region_key[32], service_key[32];
+    Hmac(reinterpret_cast<const unsigned char*>(secret.data()), secret.size(), date, date_key);
+    Hmac(date_key, sizeof(date_key), options_.region, region_key);
+    Hmac(region_key, sizeof(region_key), SERVICE, service_key);
+    Hmac(service_key, sizeof(service_key), "aws4_request", derived.key);
+
+    std::lock_guard<std::mutex> lock(key_mutex_);
+    cached_key_ = derived;
+    return derived;
+}
+
+std::string S3Presigner::Presign(
+    std::string_view method,
+    std::string_view key,
+    int64_t expires_in,
+    const QueryParams& query,
+    int64_t now
+) const {
+    if (key.empty()) {
+        throw std::invalid_argument("Object key required");
+    }
+
+    std::string path = path_prefix_;
+    path.reserve(path_prefix_.size() + key.size() * 3 + 1);
+    path.push_back('/');
+    UriEncode(path, key, false);
+    return Sign(method, path, expires_in, query, now);
+}
+
+std::string S3Presigner::PresignBucket(
+    std::string_view method,
+    int64_t expires_in,
+    const QueryParams& query,
+    int64_t now
+) const {
+    return Sign(method, path_prefix_ + "/", expires_in, query, now);
+}
+
+std::string S3Presigner::Sign(
+    std::string_view method,
+    const std::string& path,
+    int64_t expires_in,
+    const QueryParams& query,
+    int64_t now
+) const {
+    if (expires_in < 1 || expires_in > MAX_EXPIRES) {
+        throw std::invalid_argument("Presigned URL expiry must be between 1 second and 7 days");
+    }
+    if (now == 0) {
+        now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::time_t t = static_cast<std::time_t>(now);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+
+    std::string date;
+    date.reserve(8);
+    AppendDigits(date, tm.tm_year + 1900, 4);
+    AppendDigits(date, tm.tm_mon + 1, 2);
+    AppendDigits(date, tm.tm_mday, 2);
+
+    std::string amz_date = date;
+    amz_date.push_back('T');
+    AppendDigits(amz_date, tm.tm_hour, 2);
+    AppendDigits(amz_date, tm.tm_min, 2);
+    AppendDigits(amz_date, tm.tm_sec, 2);
+    amz_date.push_back('Z');
+
+    // Canonical query: all parameters sorted by name (values are unencoded here)
+    std::string credential = options_.access_key_id + "/" + date + credential_tail_;
+    std::vector<std::pair<std::string_view, std::string_view>> params;
+    params.reserve(query.size() + 6);
+    std::string expires = std::to_string(expires_in);
+    params.emplace_back("X-Amz-Algorithm", ALGORITHM);
+    params.emplace_back("X-Amz-Credential", credential);
+    params.emplace_back("X-Amz-Date", amz_date);
+    params.emplace_back("X-Amz-Expires", expires);
+    if (!options_.session_token.empty()) {
+        params.emplace_back("X-Amz-Security-Token", options_.session_token);
+    }
+    params.emplace_back("X-Amz-SignedHeaders", "host");
+    for (const auto& param : query) {
+        params.emplace_back(param.first, param.second);
+    }
+    std::sort(params.begin(), params.end());
+
+    std::string canonical_query;
+    canonical_query.reserve(512);
+    for (const auto& param : params) {
+        AppendParam(canonical_query, param.first, param.second);
+    }
+
+    std::string canonical_request;
+    canonical_request.reserve(method.size() + path.size() + canonical_query.size() + host_.size() + 48);
+    canonical_request.append(method).push_back('\n');
+    canonical_request.append(path).push_back('\n');
+    canonical_request.append(canonical_query).push_back('\n');
+    canonical_request.append("host:").append(host_).append("\n\nhost\nUNSIGNED-PAYLOAD");
+
+    unsigned char request_hash[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(canonical_request.data()), canonical_request.size(), request_hash);
+
+    std::string string_to_sign;
+    string_to_sign.reserve(160);
+    string_to_sign.append(ALGORITHM).push_back('\n');
+    string_to_sign.append(amz_date).push_back('\n');
+    string_to_sign.append(date).append(credential_tail_).push_back('\n');
+    AppendHex(string_to_sign, request_hash, sizeof(request_hash));
+
+    SigningKey signing_key = KeyFor(date);
+    unsigned char signature[32];
+    Hmac(signing_key.key, sizeof(signing_key.key), string_to_sign, signature);
+
+    std::string url;
+    url.reserve(scheme_.size() + host_.size() + path.size() + canonical_query.size() + 96);
+    url.append(scheme_).append(host_).append(path).push_back('?');
+    url.append(canonical_query).append("&X-Amz-Signature=");
+    AppendHex(url, signature, sizeof(signature));
+    return url;
+}
+
+} // namespace common
+} // namespace saasforge
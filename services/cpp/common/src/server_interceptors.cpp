@@ -0,0 +1,32 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Installs the server-wide gRPC interceptors on a ServerBuilder
+ */
+
+#include "common/server_interceptors.h"
+#include "common/metrics_interceptor.h"
+#include "common/tracing_interceptor.h"
+#include <grpcpp/grpcpp.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+
+void AddServerInterceptors(grpc::ServerBuilder& builder,
+                           TenantContextOptions tenant_options,
+                           CompressionOptions compression,
+                           Tracer& tracer,
+                           MetricsRegistry& registry) {
+    std::vector<std::unique_ptr<grpc::experimental::ServerInterceptorFactoryInterface>> creators;
+    creators.push_back(std::make_unique<TracingInterceptorFactory>(tracer));
+    creators.push_back(std::make_unique<MetricsInterceptorFactory>(registry));
+    creators.push_back(std::make_unique<CompressionInterceptorFactory>(std::move(compression), registry));
+    creators.push_back(std::make_unique<TenantContextInterceptorFactory>(std::move(tenant_options)));
+    builder.experimental().SetInterceptorCreators(std::move(creators));
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,80 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server threading configuration implementation
+ */
+
+#include "common/server_options.h"
+#include "common/env.h"
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/resource_quota.h>
+#include <cstdlib>
+#include <sstream>
+
+namespace saasforge {
+namespace common {
+
+ServerOptions ServerOptions::FromEnv() {
+    ServerOptions options;
+
+    if (EnvString("GRPC_SERVER_MODE") == "callback") {
+        options.mode = ServerMode::CALLBACK;
+    }
+
+    options.num_cqs = static_cast<int>(EnvInt("GRPC_NUM_CQS", options.num_cqs));
+    options.min_pollers = static_cast<int>(EnvInt("GRPC_MIN_POLLERS", options.min_pollers));
+    options.max_pollers = static_cast<int>(EnvInt("GRPC_MAX_POLLERS", options.max_pollers));
+    options.max_threads = static_cast<int>(EnvInt("GRPC_MAX_THREADS", options.max_threads));
+    options.executor_threads = static_cast<size_t>(EnvInt("EXECUTOR_THREADS", 0));
+    options.executor_queue_capacity = static_cast<size_t>(
+        EnvInt("EXECUTOR_QUEUE_CAPACITY", static_cast<long>(options.executor_queue_capacity)));
+    options.pin_executor_threads = EnvInt("EXECUTOR_PIN_THREADS", 0) == 1;
+    options.min_ping_interval_ms = static_cast<int>(
+        EnvInt("GRPC_SERVER_MIN_PING_INTERVAL_MS", options.min_ping_interval_ms));
+
+    return options;
+}
+
+void ServerOptions::ApplyTo(grpc::ServerBuilder& builder) const {
+    if (mode == ServerMode::SYNC) {
+        if (num_cqs > 0) {
+            builder.SetSyncServerOption(grpc::ServerBuilder::SyncServerOption::NUM_CQS, num_cqs);
+        }
+        if (min_pollers > 0) {
+            builder.SetSyncServerOption(grpc::ServerBuilder::SyncServerOption::MIN_POLLERS, min_pollers);
+        }
+        if (max_pollers > 0) {
+            builder.SetSyncServerOption(grpc::ServerBuilder::SyncServerOption::MAX_POLLERS, max_pollers);
+        }
+    }
+
+    if (max_threads > 0) {
+        grpc::ResourceQuota quota("saasforge-server");
+        quota.SetMaxThreads(max_threads);
+        builder.SetResourceQuota(quota);
+    }
+
+    // Pooled client channels keep idle connections warm with PINGs
+    if (min_ping_interval_ms > 0) {
+        builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS, 1);
+        builder.AddChannelArgument(GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS, min_ping_interval_ms);
+    }
+}
+
+std::string ServerOptions::Describe() const {
+    std::ostringstream out;
+    if (mode == ServerMode::CALLBACK) {
+        out << "callback (executor threads=" << executor_threads
+            << ", queue=" << executor_queue_capacity
+            << (pin_executor_threads ? ", pinned" : "") << ")";
+    } else {
+        out << "sync (cqs=" << num_cqs << ", pollers=" << min_pollers << "-" << max_pollers << ")";
+    }
+    if (max_threads > 0) {
+        out << ", max threads=" << max_threads;
+    }
+    return out.str();
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,76 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Incremental SHA-256 for streamed content
+ */
+
+#include "common/sha256.h"
+#include "common/codec.h"
+#include <openssl/evp.h>
+#include <cctype>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr size_t HEX_DIGEST_LENGTH = 64;
+
+EVP_MD_CTX* Ctx(void* ctx) {
+    return static_cast<EVP_MD_CTX*>(ctx);
+}
+
+} // namespace
+
+Sha256::Sha256() : ctx_(EVP_MD_CTX_new()) {
+    if (!ctx_ || EVP_DigestInit_ex(Ctx(ctx_), EVP_sha256(), nullptr) != 1) {
+        EVP_MD_CTX_free(Ctx(ctx_));
+        throw std::runtime_error("Failed to initialize SHA-256");
+    }
+}
+
+Sha256::~Sha256() {
+    EVP_MD_CTX_free(Ctx(ctx_));
+}
+
+void Sha256::Update(const void* data, size_t size) {
+    if (size > 0 && EVP_DigestUpdate(Ctx(ctx_), data, size) != 1) {
+        throw std::runtime_error("SHA-256 update failed");
+    }
+}
+
+std::string Sha256::HexDigest() {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    if (EVP_DigestFinal_ex(Ctx(ctx_), digest, &length) != 1 ||
+        EVP_DigestInit_ex(Ctx(ctx_), EVP_sha256(), nullptr) != 1) {
+        throw std::runtime_error("SHA-256 finalization failed");
+    }
+
+    return HexEncode(digest, length);
+}
+
+std::string Sha256::Hex(std::string_view data) {
+    Sha256 hash;
+    hash.Update(data.data(), data.size());
+    return hash.HexDigest();
+}
+
+std::string Sha256::NormalizeHex(std::string_view value) {
+    if (value.size() != HEX_DIGEST_LENGTH) {
+        return "";
+    }
+    std::string out;
+    out.reserve(HEX_DIGEST_LENGTH);
+    for (char c : value) {
+        if (!std::isxdigit(static_cast<unsigned char>(c))) {
+            return "";
+        }
+        out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    return out;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,190 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tenant to database shard placement: consistent hashing plus directory overrides implementation
+ */
+
+#include "common/shard_map.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+namespace saasforge {
+namespace common {
+
+ShardMapOptions ShardMapOptions::FromEnv() {
+    ShardMapOptions options;
+    options.virtual_nodes = static_cast<size_t>(std::max(1L,
+        EnvInt("DB_SHARD_VIRTUAL_NODES", static_cast<long>(options.virtual_nodes))));
+    options.refresh = std::chrono::milliseconds(
+        EnvInt("DB_SHARD_MAP_REFRESH_MS", static_cast<long>(options.refresh.count())));
+    options.stale_after = std::chrono::milliseconds(
+        EnvInt("DB_SHARD_MAP_STALE_AFTER_MS", static_cast<long>(options.stale_after.count())));
+    return options;
+}
+
+ShardMap::ShardMap(std::vector<std::string> shards, Loader loader, const ShardMapOptions& options)
+    : shards_(std::move(shards)), load_(std::move(loader)), options_(options) {
+    if (shards_.empty()) {
+        throw std::invalid_argument("ShardMap needs at least one shard");
+    }
+    std::unordered_set<std::string> seen;
+    for (const auto& shard : shards_) {
+        if (shard.empty() || !seen.insert(shard).second) {
+            throw std::invalid_argument("Empty or duplicate shard name: '" + shard + "'");
+        }
+    }
+    options_.virtual_nodes = std::max<size_t>(options_.virtual_nodes, 1);
+    if (options_.refresh.count() <= 0) {
+        options_.refresh = std::chrono::milliseconds(1000);
+    }
+    options_.stale_after = std::max(options_.stale_after, 2 * options_.refresh);
+
+    // Points depend on the shard name only, so reordering the list moves nothing
+    ring_.reserve(shards_.size() * options_.virtual_nodes);
+    for (uint32_t i = 0; i < shards_.size(); ++i) {
+        for (size_t node = 0; node < options_.virtual_nodes; ++node) {
+            ring_.emplace_back(Hash(shards_[i] + "#" + std::to_string(node)), i);
+        }
+    }
+    std::sort(ring_.begin(), ring_.end());
+
+    metrics_collector_ = MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        size_t overrides = 0;
+        size_t moving = 0;
+        {
+            std::shared_lock<std::shared_mutex> lock(overrides_mutex_);
+            overrides = overrides_.size();
+            for (const auto& [tenant_id, placement] : overrides_) {
+                moving += placement.moving;
+            }
+        }
+        writer.AddGauge("saasforge_db_shard_overrides", "Tenants placed explicitly (tenant_shards)", {},
+                        static_cast<double>(overrides));
+        writer.AddGauge("saasforge_db_shard_moving_tenants", "Tenants being moved between shards", {},
+                        static_cast<double>(moving));
+        writer.AddCounter("saasforge_db_shard_map_load_failures_total", "Failed shard override loads", {},
+                          static_cast<double>(failures_.load()));
+    });
+
+    if (!load_) {
+        loaded_ = true;
+        return;
+    }
+    // Synchronous first load: requests are not routed on the hash alone
+    Refresh();
+    periodic_ = Executor::Background().SchedulePeriodic(
+        std::chrono::duration_cast<std::chrono::milliseconds>(options_.refresh), [this] { Refresh(); },
+        std::chrono::duration_cast<std::chrono::milliseconds>(options_.refresh));
+}
+
+ShardMap::~ShardMap() {
+    Shutdown();
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+void ShardMap::Shutdown() {
+    Executor::Background().Cancel(periodic_);
+}
+
+TenantPlacement ShardMap::Locate(const std::string& tenant_id) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(overrides_mutex_);
+        if (!loaded_) {
+            throw std::runtime_error("Shard overrides not loaded");
+        }
+        auto it = overrides_.find(tenant_id);
+        if (it != overrides_.end()) {
+            return it->second;
+        }
+    }
+    return {tenant_id, HashShard(tenant_id), false};
+}
+
+const std::string& ShardMap::HashShard(std::string_view tenant_id) const {
+    uint64_t point = Hash(tenant_id);
+    auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(point, uint32_t{0}));
+    if (it == ring_.end()) {
+        it = ring_.begin();
+    }
+    return shards_[it->second];
+}
+
+bool ShardMap::Refresh() {
+    // Taken before loading: the rows read are at least this recent
+    auto started = std::chrono::steady_clock::now();
+    std::vector<TenantPlacement> placements;
+    try {
+        placements = load_();
+    } catch (const std::exception& e) {
+        ++failures_;
+        LogError("Loading shard overrides failed", {{"error", e.what()}});
+        return false;
+    }
+
+    std::unordered_map<std::string, TenantPlacement> overrides;
+    overrides.reserve(placements.size());
+    for (auto& placement : placements) {
+        if (std::find(shards_.begin(), shards_.end(), placement.shard) == shards_.end()) {
+            // Kept: routing it by hash instead would read and write the wrong database
+            LogError("Tenant placed on an unknown shard", {
+                {"tenant_id", placement.tenant_id}, {"shard", placement.shard}
+            });
+        }
+        std::string tenant_id = placement.tenant_id;
+        overrides[std::move(tenant_id)] = std::move(placement);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(overrides_mutex_);
+    if (!loaded_) {
+        LogInfo("Shard overrides loaded", {{"shards", shards_.size()}, {"overrides", overrides.size()}});
+    }
+    overrides_ = std::move(overrides);
+    loaded_ = true;
+    loaded_at_ = started;
+    return true;
+}
+
+bool ShardMap::Ready() const {
+    std::shared_lock<std::shared_mutex> lock(overrides_mutex_);
+    return loaded_;
+}
+
+bool ShardMap::Fresh() const {
+    if (!load_) {
+        return true;
+    }
+    std::shared_lock<std::shared_mutex> lock(overrides_mutex_);
+    return loaded_ && std::chrono::steady_clock::now() - loaded_at_ < options_.stale_after;
+}
+
+std::vector<TenantPlacement> ShardMap::Overrides() const {
+    std::shared_lock<std::shared_mutex> lock(overrides_mutex_);
+    std::vector<TenantPlacement> placements;
+    placements.reserve(overrides_.size());
+    for (const auto& [tenant_id, placement] : overrides_) {
+        placements.push_back(placement);
+    }
+    return placements;
+}
+
+uint64_t ShardMap::Hash(std::string_view key) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // FNV-1a alone clusters keys that differ in the last characters (ring points)
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,298 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Online move of a tenant's rows between database shards implementation
+ */
+
+#include "common/shard_mover.h"
+#include "common/logger.h"
+#include "common/statement_registry.h"
+#include <stdexcept>
+#include <thread>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry);
+// the placement statements only run on the directory shard
+const PreparedStatement kReadPlacement(
+    "shard_mover_read_placement",
+    "SELECT shard, moving, previous_shard FROM tenant_shards WHERE tenant_id = $1::uuid");
+
+const PreparedStatement kWritePlacement(
+    "shard_mover_write_placement",
+    "INSERT INTO tenant_shards (tenant_id, shard, moving, previous_shard) "
+    "VALUES ($1::uuid, $2, $3, NULLIF($4, '')) "
+    "ON CONFLICT (tenant_id) DO UPDATE SET shard = EXCLUDED.shard, moving = EXCLUDED.moving, "
+    "previous_shard = EXCLUDED.previous_shard, updated_at = NOW()");
+
+const PreparedStatement kPinTenants(
+    "shard_mover_pin_tenants",
+    "INSERT INTO tenant_shards (tenant_id, shard) "
+    "SELECT id, $2 FROM unnest($1::uuid[]) AS id "
+    "ON CONFLICT (tenant_id) DO NOTHING");
+
+const PreparedStatement kListTenants(
+    "shard_mover_list_tenants",
+    "SELECT id::text FROM tenants");
+
+// Waits for transactions that insert rows of the tenant: they hold a
+// KEY SHARE lock on its tenants row until they commit
+const PreparedStatement kFenceInserts(
+    "shard_mover_fence_inserts",
+    "SELECT 1 FROM tenants WHERE id = $1::uuid FOR UPDATE");
+
+const char* const kByTenant = "tenant_id = $1::uuid";
+const char* const kByUser = "user_id IN (SELECT id FROM users WHERE tenant_id = $1::uuid)";
+
+// Old months may have no partition on the target yet
+const char* const kRollupPartitions =
+    "SELECT usage_rollup_ensure_partitions(month) FROM ("
+    "SELECT DISTINCT date_trunc('month', (r->>'bucket_start')::timestamptz AT TIME ZONE 'UTC')::date AS month "
+    "FROM jsonb_array_elements($1::jsonb) r) months";
+
+std::string Replace(std::string text, const std::string& from, const std::string& to) {
+    for (size_t pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+    return text;
+}
+
+} // namespace
+
+ShardMover::ShardMover(ShardedDbPool& pools, const ShardMoveOptions& options)
+    : pools_(pools), options_(options) {
+    if (options_.batch_rows == 0) {
+        options_.batch_rows = 1;
+    }
+}
+
+const std::vector<TenantTable>& ShardMover::Tables() {
+    // email_templates and roles also hold system rows (tenant_id NULL), present on every shard
+    static const std::vector<TenantTable> tables = {
+        {"tenants", "id = $1::uuid", nullptr},
+        {"users", kByTenant, nullptr},
+        {"roles", kByTenant, nullptr},
+        {"user_roles", kByUser, nullptr},
+        {"sessions", kByTenant, nullptr},
+        {"api_keys", kByTenant, nullptr},
+        {"oauth_accounts", kByTenant, nullptr},
+        {"backup_codes", kByUser, nullptr},
+        {"quotas", kByTenant, nullptr},
+        {"upload_objects", kByTenant, nullptr},
+        {"transform_jobs", kByTenant, nullptr},
+        {"payment_methods", kByTenant, nullptr},
+        {"subscriptions", kByTenant, nullptr},
+        {"invoices", kByTenant, nullptr},
+        {"usage_records", kByTenant, nullptr},
+        {"usage_rollup_minute", kByTenant, kRollupPartitions},
+        {"usage_rollup_hour", kByTenant, kRollupPartitions},
+        {"usage_rollup_period", kByTenant, kRollupPartitions},
+        {"notifications", kByTenant, nullptr},
+        {"notification_preferences", kByTenant, nullptr},
+        {"webhooks", kByTenant, nullptr},
+        {"webhook_events", kByTenant, nullptr},
+        {"webhook_deliveries", kByTenant, nullptr},
+        {"email_templates", kByTenant, nullptr},
+        {"email_queue", kByTenant, nullptr},
+        {"email_delivery_stats", kByTenant, nullptr},
+        {"audit_log", kByTenant, nullptr},
+    };
+    return tables;
+}
+
+std::shared_ptr<DbPool> ShardMover::ShardPool(const std::string& name) {
+    auto pool = pools_.Shard(name);
+    if (!pool) {
+        throw std::invalid_argument("Unknown shard: " + name);
+    }
+    return pool;
+}
+
+size_t ShardMover::Move(const std::string& tenant_id, const std::string& target) {
+    auto target_pool = ShardPool(target);
+    Placement placement = Read(tenant_id);
+
+    size_t copied = 0;
+    std::string source;
+    if (placement.moving && !placement.previous_shard.empty()) {
+        // Interrupted after step 3: the copy on placement.shard is complete
+        if (placement.shard != target) {
+            throw std::runtime_error("Tenant " + tenant_id + " is being moved to " + placement.shard);
+        }
+        source = placement.previous_shard;
+    } else {
+        if (!placement.moving && !placement.previous_shard.empty()) {
+            // Interrupted in step 4: only the old rows are left to delete
+            Purge(tenant_id, *ShardPool(placement.previous_shard));
+            placement.previous_shard.clear();
+            Write(tenant_id, placement);
+        }
+        source = placement.shard;
+        if (source == target) {
+            if (placement.moving) {
+                placement.moving = false;
+                Write(tenant_id, placement);
+            }
+            LogInfo("Tenant already on shard", {{"tenant_id", tenant_id}, {"shard", target}});
+            return 0;
+        }
+        auto source_pool = ShardPool(source);
+        LogInfo("Moving tenant", {{"tenant_id", tenant_id}, {"from", source}, {"to", target}});
+
+        // 1. Refuse writes
+        Write(tenant_id, {source, true, ""});
+        WaitForPropagation("writes refused");
+
+        // 2. Copy
+        copied = Copy(tenant_id, *source_pool, *target_pool);
+
+        // 3. Read from the target
+        Write(tenant_id, {target, true, source});
+        WaitForPropagation("reads moved");
+    }
+
+    // 4. Accept writes on the target, drop the source's rows
+    Write(tenant_id, {target, false, source});
+    Purge(tenant_id, *ShardPool(source));
+    Write(tenant_id, {target, false, ""});
+
+    LogInfo("Tenant moved", {{"tenant_id", tenant_id}, {"from", source}, {"to", target}, {"rows", copied}});
+    return copied;
+}
+
+size_t ShardMover::PinAll() {
+    size_t pinned = 0;
+    for (const auto& shard : pools_.Map().Shards()) {
+        std::vector<std::string> tenant_ids;
+        {
+            auto conn_guard = ShardPool(shard)->AcquireConnection("ShardMover::PinAll");
+            pqxx::read_transaction txn(*conn_guard);
+            auto result = ExecPrepared(txn, kListTenants);
+            tenant_ids.reserve(result.size());
+            for (const auto& row : result) {
+                ReadText(row[0], tenant_ids.emplace_back());
+            }
+        }
+
+        auto conn_guard = pools_.Directory()->AcquireConnection("ShardMover::PinAll");
+        pqxx::work txn(*conn_guard);
+        auto result = ExecPrepared(txn, kPinTenants, ToArrayLiteral(tenant_ids), shard);
+        txn.commit();
+
+        pinned += static_cast<size_t>(result.affected_rows());
+        LogInfo("Pinned tenants", {{"shard", shard}, {"tenants", tenant_ids.size()},
+                                   {"pinned", result.affected_rows()}});
+    }
+    return pinned;
+}
+
+ShardMover::Placement ShardMover::Read(const std::string& tenant_id) {
+    auto conn_guard = pools_.Directory()->AcquireConnection("ShardMover::Read");
+    pqxx::read_transaction txn(*conn_guard);
+    auto result = ExecPrepared(txn, kReadPlacement, tenant_id);
+
+    Placement placement;
+    if (result.empty()) {
+        placement.shard = pools_.Map().HashShard(tenant_id);
+        return placement;
+    }
+    ReadText(result[0][0], placement.shard);
+    placement.moving = result[0][1].as<bool>();
+    ReadText(result[0][2], placement.previous_shard);
+    return placement;
+}
+
+void ShardMover::Write(const std::string& tenant_id, const Placement& placement) {
+    auto conn_guard = pools_.Directory()->AcquireConnection("ShardMover::Write");
+    pqxx::work txn(*conn_guard);
+    ExecPrepared(txn, kWritePlacement, tenant_id, placement.shard, placement.moving, placement.previous_shard);
+    txn.commit();
+    pools_.Map().Refresh();
+}
+
+size_t ShardMover::Copy(const std::string& tenant_id, DbPool& source, DbPool& target) {
+    auto source_guard = source.AcquireConnection("ShardMover::Copy");
+    {
+        pqxx::work fence(*source_guard);
+        ExecPrepared(fence, kFenceInserts, tenant_id);
+        fence.commit();
+    }
+
+    // One snapshot of the source, taken after the fence
+    pqxx::read_transaction read(*source_guard);
+    read.exec("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ");
+    auto target_guard = target.AcquireConnection("ShardMover::Copy");
+    pqxx::work write(*target_guard);
+
+    // Rows left by an earlier, interrupted attempt
+    const auto& tables = Tables();
+    for (auto it = tables.rbegin(); it != tables.rend(); ++it) {
+        write.exec_params(std::string("DELETE FROM ") + it->name + " WHERE " + it->filter, tenant_id);
+    }
+
+    // Cursor queries take no parameters: the tenant ID is quoted into them
+    const std::string quoted = read.quote(tenant_id);
+    size_t copied = 0;
+    for (const auto& table : tables) {
+        read.exec(std::string("DECLARE shard_move NO SCROLL CURSOR FOR SELECT to_jsonb(t)::text FROM ") +
+                  table.name + " t WHERE " + Replace(table.filter, "$1", quoted));
+        const std::string fetch = "FETCH " + std::to_string(options_.batch_rows) + " FROM shard_move";
+        const std::string insert = std::string("INSERT INTO ") + table.name +
+                                   " SELECT * FROM jsonb_populate_recordset(NULL::" + table.name + ", $1::jsonb)";
+
+        size_t table_rows = 0;
+        while (true) {
+            auto rows = read.exec(fetch);
+            if (rows.empty()) {
+                break;
+            }
+            std::string batch = "[";
+            for (const auto& row : rows) {
+                if (batch.size() > 1) {
+                    batch += ',';
+                }
+                batch.append(row[0].c_str(), row[0].size());
+            }
+            batch += ']';
+
+            if (table.prepare) {
+                write.exec_params(table.prepare, batch);
+            }
+            write.exec_params(insert, batch);
+            table_rows += rows.size();
+        }
+        read.exec("CLOSE shard_move");
+
+        if (table_rows > 0) {
+            LogDebug("Copied tenant rows", {{"tenant_id", tenant_id}, {"table", table.name}, {"rows", table_rows}});
+        }
+        copied += table_rows;
+    }
+
+    write.commit();
+    read.commit();
+    return copied;
+}
+
+void ShardMover::Purge(const std::string& tenant_id, DbPool& pool) {
+    auto conn_guard = pool.AcquireConnection("ShardMover::Purge");
+    pqxx::work txn(*conn_guard);
+    const auto& tables = Tables();
+    for (auto it = tables.rbegin(); it != tables.rend(); ++it) {
+        txn.exec_params(std::string("DELETE FROM ") + it->name + " WHERE " + it->filter, tenant_id);
+    }
+    txn.commit();
+}
+
+void ShardMover::WaitForPropagation(const char* step) {
+    auto wait = pools_.Map().Options().stale_after + options_.settle;
+    LogInfo("Waiting for the shard map to propagate", {{"step", step}, {"wait_ms", wait.count()}});
+    std::this_thread::sleep_for(wait);
+}
+
+} // namespace common
+} // namespace saasforge
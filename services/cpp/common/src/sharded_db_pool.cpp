@@ -0,0 +1,182 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description One DbPool per database shard, chosen by the tenant of the request implementation
+ */
+
+#include "common/sharded_db_pool.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/statement_registry.h"
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry);
+// only run on the directory shard
+const PreparedStatement kLoadPlacements(
+    "sharded_db_pool_load_placements",
+    "SELECT tenant_id::text, shard, moving FROM tenant_shards");
+
+std::string Trim(const std::string& value) {
+    size_t start = value.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        return "";
+    }
+    return value.substr(start, value.find_last_not_of(" \t") - start + 1);
+}
+
+} // namespace
+
+ShardedDbPoolOptions ShardedDbPoolOptions::FromEnv(const std::string& default_url) {
+    ShardedDbPoolOptions options;
+    options.pool = DbPoolOptions::FromEnv();
+    options.map = ShardMapOptions::FromEnv();
+
+    for (const auto& entry : EnvList("DB_SHARD_URLS")) {
+        // Split at the first '=': connection strings may contain more
+        size_t eq = entry.find('=');
+        if (eq != std::string::npos) {
+            options.shards.emplace_back(Trim(entry.substr(0, eq)), Trim(entry.substr(eq + 1)));
+        } else {
+            LogWarn("Ignoring DB_SHARD_URLS entry without a name", {{"entry", entry}});
+        }
+    }
+    if (options.shards.empty()) {
+        options.shards.emplace_back(ShardedDbPool::DEFAULT_SHARD, default_url);
+    }
+    return options;
+}
+
+ShardedDbPool::ShardedDbPool(const ShardedDbPoolOptions& options) {
+    if (options.shards.empty()) {
+        throw std::invalid_argument("ShardedDbPool needs at least one shard");
+    }
+    // Checked before any pool is opened (ShardMap checks them again)
+    std::vector<std::string> names;
+    std::unordered_set<std::string> seen;
+    for (const auto& [name, url] : options.shards) {
+        if (name.empty() || !seen.insert(name).second) {
+            throw std::invalid_argument("Empty or duplicate shard name: '" + name + "'");
+        }
+        names.push_back(name);
+    }
+
+    bool sharded = options.shards.size() > 1;
+    DbPoolOptions pool_options = options.pool;
+    if (sharded && !pool_options.replica_urls.empty()) {
+        LogWarn("DB_REPLICA_URLS is ignored with more than one shard", {{"shards", options.shards.size()}});
+        pool_options.replica_urls.clear();
+    }
+    for (const auto& [name, url] : options.shards) {
+        pool_options.name = sharded ? name : "";
+        pools_.emplace_back(name, std::make_shared<DbPool>(url, pool_options));
+    }
+
+    ShardMap::Loader loader;
+    if (sharded) {
+        loader = [directory = Directory()] {
+            auto conn_guard = directory->AcquireConnection("ShardMap::Refresh");
+            pqxx::read_transaction txn(*conn_guard);
+            auto result = ExecPrepared(txn, kLoadPlacements);
+
+            std::vector<TenantPlacement> placements;
+            placements.reserve(result.size());
+            for (const auto& row : result) {
+                auto& placement = placements.emplace_back();
+                ReadText(row[0], placement.tenant_id);
+                ReadText(row[1], placement.shard);
+                placement.moving = row[2].as<bool>();
+            }
+            return placements;
+        };
+    }
+    map_ = std::make_unique<ShardMap>(std::move(names), std::move(loader), options.map);
+
+    metrics_collector_ = MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        writer.AddCounter("saasforge_db_shard_writes_refused_total", "Writes refused by shard routing",
+                          {{"reason", "moving"}}, static_cast<double>(refused_moving_.load()));
+        writer.AddCounter("saasforge_db_shard_writes_refused_total", "Writes refused by shard routing",
+                          {{"reason", "stale"}}, static_cast<double>(refused_stale_.load()));
+    });
+}
+
+ShardedDbPool::ShardedDbPool(std::shared_ptr<DbPool> pool)
+    : map_(std::make_unique<ShardMap>(std::vector<std::string>{DEFAULT_SHARD}, nullptr)) {
+    pools_.emplace_back(DEFAULT_SHARD, std::move(pool));
+}
+
+ShardedDbPool::~ShardedDbPool() {
+    MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+    map_->Shutdown();
+}
+
+std::shared_ptr<DbPool> ShardedDbPool::Pool(const TenantPlacement& placement) const {
+    auto pool = Shard(placement.shard);
+    if (!pool) {
+        throw std::runtime_error("Tenant " + placement.tenant_id + " placed on unknown shard " + placement.shard);
+    }
+    return pool;
+}
+
+std::shared_ptr<DbPool> ShardedDbPool::ForRead(const std::string& tenant_id) const {
+    if (pools_.size() == 1) {
+        return pools_.front().second;
+    }
+    return Pool(map_->Locate(tenant_id));
+}
+
+std::shared_ptr<DbPool> ShardedDbPool::ForWrite(const std::string& tenant_id) const {
+    if (pools_.size() == 1) {
+        return pools_.front().second;
+    }
+    if (!map_->Fresh()) {
+        ++refused_stale_;
+        throw std::runtime_error("Shard map is stale; refusing writes");
+    }
+    TenantPlacement placement = map_->Locate(tenant_id);
+    if (placement.moving) {
+        ++refused_moving_;
+        throw TenantMoving(tenant_id);
+    }
+    return Pool(placement);
+}
+
+DbPool::ConnectionGuard ShardedDbPool::AcquireConnection(const TenantContext& tenant_ctx, const char* caller) {
+    return ForWrite(tenant_ctx.tenant_id)->AcquireConnection(caller);
+}
+
+DbPool::ConnectionGuard ShardedDbPool::AcquireReadConnection(const TenantContext& tenant_ctx, const char* caller) {
+    return ForRead(tenant_ctx.tenant_id)->AcquireReadConnection(caller, tenant_ctx.tenant_id);
+}
+
+void ShardedDbPool::RecordWrite(const TenantContext& tenant_ctx) {
+    ForRead(tenant_ctx.tenant_id)->RecordWrite(tenant_ctx.tenant_id);
+}
+
+std::shared_ptr<DbPool> ShardedDbPool::Shard(const std::string& name) const {
+    for (const auto& [shard, pool] : pools_) {
+        if (shard == name) {
+            return pool;
+        }
+    }
+    return nullptr;
+}
+
+bool ShardedDbPool::Shutdown(std::chrono::milliseconds timeout) {
+    map_->Shutdown();
+    bool drained = true;
+    for (const auto& [name, pool] : pools_) {
+        drained = pool->Shutdown(timeout) && drained;
+    }
+    return drained;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,77 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Named SQL statements prepared once per pooled connection implementation
+ */
+
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+StatementRegistry& StatementRegistry::Global() {
+    static StatementRegistry registry;
+    return registry;
+}
+
+void StatementRegistry::Add(const std::string& name, const std::string& sql) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+        if (entry.name == name) {
+            if (entry.sql != sql) {
+                throw std::logic_error("Prepared statement '" + name + "' registered with different SQL");
+            }
+            return;
+        }
+    }
+    entries_.push_back({name, sql});
+}
+
+size_t StatementRegistry::PrepareAll(pqxx::connection& conn) const {
+    std::vector<Entry> entries = Entries();
+
+    size_t prepared = 0;
+    for (const auto& entry : entries) {
+        try {
+            conn.prepare(entry.name, entry.sql);
+            prepared++;
+        } catch (const std::exception& e) {
+            LogError("Failed to prepare statement", {{"statement", entry.name}, {"error", e.what()}});
+        }
+    }
+    return prepared;
+}
+
+std::vector<StatementRegistry::Entry> StatementRegistry::Entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+}
+
+size_t StatementRegistry::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+std::string ToArrayLiteral(const std::vector<std::string>& values) {
+    std::string out = "{";
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += '"';
+        for (char c : values[i]) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+    out += '}';
+    return out;
+}
+
+} // namespace common
+} // namespace saasforge
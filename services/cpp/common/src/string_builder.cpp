@@ -0,0 +1,95 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Allocation-free helpers for building keys and payloads on hot paths
+ */
+
+#include "common/string_builder.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+bool IsHtmlSpecial(char c) {
+    return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'';
+}
+
+/// Index of the first character AppendHtmlEscaped must replace, or size
+size_t FindHtmlSpecial(const char* data, size_t size) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i apos = _mm_set1_epi8('\'');
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, gt), _mm_cmpeq_epi8(chunk, quot)),
+                         _mm_cmpeq_epi8(chunk, apos)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        if (IsHtmlSpecial(data[i])) {
+            return i;
+        }
+    }
+    return size;
+}
+
+} // namespace
+
+void AppendJsonString(std::string& out, std::string_view value) {
+    static const char* hex = "0123456789abcdef";
+    out.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out += "\\u00";
+                    out.push_back(hex[(c >> 4) & 0x0f]);
+                    out.push_back(hex[c & 0x0f]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+void AppendHtmlEscaped(std::string& out, std::string_view value) {
+    while (!value.empty()) {
+        size_t special = FindHtmlSpecial(value.data(), value.size());
+        out.append(value.data(), special);
+        if (special == value.size()) {
+            return;
+        }
+        switch (value[special]) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += "&#39;"; break;
+        }
+        value.remove_prefix(special + 1);
+    }
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,1034 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Asynchronous Stripe API client implementation
+ */
+
+#include "common/stripe_client.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <strings.h>
+#include <curl/curl.h>
+
+#ifndef PICOJSON_USE_INT64
+#define PICOJSON_USE_INT64
+#endif
+#include <picojson/picojson.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr const char* USER_AGENT = "SaaSForge-Payments/1.0";
+
+// Stripe's default per-account limits, per second, for each of reads and writes
+constexpr double LIVE_RATE = 100;
+constexpr double TEST_RATE = 25;
+
+// Idle buckets are dropped past this many accounts, so Connect fan-out stays bounded
+constexpr size_t MAX_BUCKETS = 10000;
+
+std::once_flag curl_init_once;
+
+std::mt19937_64& Random() {
+    thread_local std::mt19937_64 generator(std::random_device{}() ^
+        static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+    return generator;
+}
+
+std::string NewIdempotencyKey() {
+    static constexpr char HEX[] = "0123456789abcdef";
+    std::string key = "sf-";
+    for (int word = 0; word < 2; ++word) {
+        uint64_t bits = Random()();
+        for (int i = 0; i < 16; ++i, bits >>= 4) {
+            key += HEX[bits & 0xf];
+        }
+    }
+    return key;
+}
+
+std::string PercentEncode(const std::string& value, bool keep_brackets) {
+    static constexpr char HEX[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size());
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' ||
+            (keep_brackets && (c == '[' || c == ']'))) {
+            encoded += static_cast<char>(c);
+        } else {
+            encoded += '%';
+            encoded += HEX[c >> 4];
+            encoded += HEX[c & 0xf];
+        }
+    }
+    return encoded;
+}
+
+StripeHttpRequest Get(const std::string& path, const std::string& account = "") {
+    StripeHttpRequest request;
+    request.path = path;
+    request.account = account;
+    return request;
+}
+
+StripeHttpRequest Post(const std::string& path, const std::vector<std::pair<std::string, std::string>>& params,
+                       const StripeCallOptions& call = {}) {
+    StripeHttpRequest request;
+    request.method = "POST";
+    request.path = path;
+    request.body = StripeClient::FormEncode(params);
+    request.idempotency_key = call.idempotency_key;
+    request.account = call.account;
+    return request;
+}
+
+// JSON field access; missing, null or mistyped fields read as empty / 0
+
+const picojson::value& Field(const picojson::value& value, const char* name) {
+    static const picojson::value null;
+    if (!value.is<picojson::object>()) {
+        return null;
+    }
+    const auto& object = value.get<picojson::object>();
+    auto it = object.find(name);
+    return it == object.end() ? null : it->second;
+}
+
+std::string String(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<std::string>() ? field.get<std::string>() : "";
+}
+
+int64_t Int(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<int64_t>() ? field.get<int64_t>() : 0;
+}
+
+bool Bool(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<bool>() && field.get<bool>();
+}
+
+/// Expandable field: an id, or the expanded object
+std::string IdOf(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<std::string>() ? field.get<std::string>() : String(field, "id");
+}
+
+const picojson::value& First(const picojson::value& list) {
+    static const picojson::value null;
+    const auto& data = Field(list, "data");
+    if (!data.is<picojson::array>() || data.get<picojson::array>().empty()) {
+        return null;
+    }
+    return data.get<picojson::array>().front();
+}
+
+std::exception_ptr ErrorFrom(const StripeHttpResponse& response, const std::string& not_found_message) {
+    if (response.status == 0) {
+        return std::make_exception_ptr(StripeApiError(0, "", "Stripe request failed: " + response.error));
+    }
+    if (response.status == 429) {
+        return std::make_exception_ptr(StripeRateLimited());
+    }
+
+    picojson::value body;
+    picojson::parse(body, response.body);
+    const auto& error = Field(body, "error");
+    std::string code = String(error, "code");
+    std::string message = String(error, "message");
+
+    if (response.status == 404 && !not_found_message.empty()) {
+        message = not_found_message;
+    } else if (message.empty()) {
+        message = "Stripe API error (HTTP " + std::to_string(response.status) + ")";
+    }
+    return std::make_exception_ptr(StripeApiError(response.status, code, message));
+}
+
+/// Parsed body of a successful response; throws the mapped error otherwise
+picojson::value Body(const StripeHttpResponse& response, const std::string& not_found_message = "") {
+    if (!response.Ok()) {
+        std::rethrow_exception(ErrorFrom(response, not_found_message));
+    }
+    picojson::value body;
+    std::string error = picojson::parse(body, response.body);
+    if (!error.empty() || !body.is<picojson::object>()) {
+        throw StripeApiError(response.status, "", "Invalid Stripe response");
+    }
+    return body;
+}
+
+SubscriptionStatus ParseStatus(const std::string& status) {
+    if (status == "trialing") return SubscriptionStatus::TRIALING;
+    if (status == "past_due" || status == "incomplete") return SubscriptionStatus::PAST_DUE;
+    if (status == "canceled" || status == "incomplete_expired") return SubscriptionStatus::CANCELED;
+    if (status == "unpaid") return SubscriptionStatus::UNPAID;
+    if (status == "paused") return SubscriptionStatus::PAUSED;
+    return SubscriptionStatus::ACTIVE;
+}
+
+StripeCustomer ParseCustomer(const picojson::value& body) {
+    StripeCustomer customer;
+    customer.id = String(body, "id");
+    customer.email = String(body, "email");
+    customer.tenant_id = String(Field(body, "metadata"), "tenant_id");
+    customer.default_payment_method = IdOf(Field(body, "invoice_settings"), "default_payment_method");
+    customer.created = Int(body, "created");
+    return customer;
+}
+
+StripeSubscription ParseSubscription(const picojson::value& body) {
+    const auto& item = First(Field(body, "items"));
+    const auto& price = Field(item, "price");
+
+    StripeSubscription subscription;
+    subscription.id = String(body, "id");
+    subscription.customer_id = IdOf(body, "customer");
+    subscription.plan_id = String(Field(body, "metadata"), "plan_id");
+    if (subscription.plan_id.empty()) {
+        subscription.plan_id = String(price, "id");
+    }
+    subscription.status = ParseStatus(String(body, "status"));
+    subscription.current_period_start = Int(body, "current_period_start");
+    subscription.current_period_end = Int(body, "current_period_end");
+    subscription.trial_end = Int(body, "trial_end");
+    subscription.cancel_at_period_end = Bool(body, "cancel_at_period_end");
+    subscription.amount = static_cast<double>(Int(price, "unit_amount") * std::max<int64_t>(Int(item, "quantity"), 1)) / 100.0;
+    subscription.retry_count = 0;   // Stripe tracks attempts on the invoice
+    return subscription;
+}
+
+StripePaymentMethod ParsePaymentMethod(const picojson::value& body) {
+    const auto& card = Field(body, "card");
+
+    StripePaymentMethod pm;
+    pm.id = String(body, "id");
+    pm.type = String(body, "type");
+    pm.card_last4 = String(card, "last4");
+    pm.card_brand = String(card, "brand");
+    pm.exp_month = static_cast<int>(Int(card, "exp_month"));
+    pm.exp_year = static_cast<int>(Int(card, "exp_year"));
+    pm.customer_id = IdOf(body, "customer");
+    return pm;
+}
+
+StripeInvoice ParseInvoice(const picojson::value& body) {
+    StripeInvoice invoice;
+    invoice.id = String(body, "id");
+    invoice.customer_id = IdOf(body, "customer");
+    invoice.subscription_id = IdOf(body, "subscription");
+    invoice.amount_due = static_cast<double>(Int(body, "amount_due")) / 100.0;
+    invoice.amount_paid = static_cast<double>(Int(body, "amount_paid")) / 100.0;
+    invoice.status = String(body, "status");
+    invoice.created = Int(body, "created");
+    invoice.due_date = Int(body, "due_date");
+    const auto& lines = Field(Field(body, "lines"), "data");
+    if (lines.is<picojson::array>()) {
+        for (const auto& line : lines.get<picojson::array>()) {
+            std::string description = String(line, "description");
+            if (!description.empty()) {
+                invoice.line_items.push_back(std::move(description));
+            }
+        }
+    }
+    return invoice;
+}
+
+/// Get*: nullopt for a missing (or deleted) object
+template <typename T, typename Parse>
+std::optional<T> ParseOptional(const StripeHttpResponse& response, Parse parse) {
+    if (response.status == 404) {
+        return std::nullopt;
+    }
+    auto body = Body(response);
+    if (Bool(body, "deleted")) {
+        return std::nullopt;
+    }
+    return parse(body);
+}
+
+template <typename T, typename Parse>
+std::future<T> SendAsync(StripeClient& client, StripeHttpRequest request, Parse parse) {
+    auto promise = std::make_shared<std::promise<T>>();
+    auto future = promise->get_future();
+    client.Send(std::move(request), [promise, parse](StripeHttpResponse response) {
+        try {
+            promise->set_value(parse(response));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+bool Retryable(const StripeHttpResponse& response) {
+    if (response.should_retry) {
+        return *response.should_retry;
+    }
+    // 409: concurrent request with the same idempotency key or a lock timeout
+    return response.status == 0 || response.status == 409 || response.status == 429 || response.status >= 500;
+}
+
+/**
+ * Transport state: one thread driving one libcurl multi handle
+ *
+ * Connections stay in the multi handle's cache between requests, and
+ * requests to api.stripe.com multiplex over HTTP/2.
+ */
+class StripeCurlEngine {
+public:
+    StripeCurlEngine(const std::string& api_key, const StripeClientOptions& options)
+        : api_key_(api_key), options_(options) {
+        std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+        multi_ = curl_multi_init();
+        if (!multi_) {
+            throw std::runtime_error("Failed to create libcurl multi handle");
+        }
+        long connections = static_cast<long>(std::max<size_t>(options_.max_connections, 1));
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX));
+        curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, connections);
+        curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS, connections);
+        thread_ = std::thread(&StripeCurlEngine::Loop, this);
+    }
+
+    ~StripeCurlEngine() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        curl_multi_wakeup(multi_);
+        thread_.join();
+
+        for (CURL* easy : idle_handles_) {
+            curl_easy_cleanup(easy);
+        }
+        curl_multi_cleanup(multi_);
+    }
+
+    void Start(const StripeHttpRequest& request, StripeClient::Completion done) {
+        auto transfer = std::make_unique<Transfer>();
+        transfer->request = request;
+        transfer->done = std::move(done);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!stop_) {
+                submitted_.push_back(std::move(transfer));
+            }
+        }
+        if (transfer) {
+            transfer->response.error = "Stripe transport stopped";
+            transfer->done(std::move(transfer->response));
+            return;
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+private:
+    struct Transfer {
+        StripeHttpRequest request;
+        StripeClient::Completion done;
+        StripeHttpResponse response;
+        std::string url;
+        curl_slist* headers = nullptr;
+        char error[CURL_ERROR_SIZE] = {0};
+    };
+
+    static size_t AppendBody(char* data, size_t size, size_t count, void* user) {
+        static_cast<Transfer*>(user)->response.body.append(data, size * count);
+        return size * count;
+    }
+
+    // Retry-After (seconds form, as Stripe sends it) and Stripe-Should-Retry
+    static size_t CaptureHeader(char* data, size_t size, size_t count, void* user) {
+        size_t length = size * count;
+        auto& response = static_cast<Transfer*>(user)->response;
+        auto value_of = [&](const char* name) -> std::optional<std::string> {
+            size_t name_length = std::strlen(name);
+            if (length <= name_length || strncasecmp(data, name, name_length) != 0) {
+                return std::nullopt;
+            }
+            std::string value(data + name_length, length - name_length);
+            value.erase(0, value.find_first_not_of(" \t"));
+            value.erase(value.find_last_not_of(" \t\r\n") + 1);
+            return value;
+        };
+        if (auto retry_after = value_of("retry-after:")) {
+            long seconds = std::strtol(retry_after->c_str(), nullptr, 10);
+            if (seconds > 0) {
+                response.retry_after = std::chrono::seconds(seconds);
+            }
+        } else if (auto should_retry = value_of("stripe-should-retry:")) {
+            response.should_retry = *should_retry == "true";
+        }
+        return length;
+    }
+
+    void Loop() {
+        while (true) {
+            std::vector<std::unique_ptr<Transfer>> submitted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stop_) {
+                    break;
+                }
+                submitted.swap(submitted_);
+            }
+            for (auto& transfer : submitted) {
+                Add(std::move(transfer));
+            }
+
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+            Collect();
+            curl_multi_poll(multi_, nullptr, 0, 1000, nullptr);
+        }
+
+        // Stopping: whatever is left completes with an error
+        std::vector<std::unique_ptr<Transfer>> abandoned;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            abandoned.swap(submitted_);
+        }
+        for (auto& [easy, transfer] : active_) {
+            curl_multi_remove_handle(multi_, easy);
+            curl_slist_free_all(transfer->headers);
+            curl_easy_cleanup(easy);
+            abandoned.push_back(std::move(transfer));
+        }
+        active_.clear();
+        for (auto& transfer : abandoned) {
+            transfer->response = StripeHttpResponse{};
+            transfer->response.error = "Stripe transport stopped";
+            transfer->done(std::move(transfer->response));
+        }
+    }
+
+    void Add(std::unique_ptr<Transfer> transfer) {
+        CURL* easy = nullptr;
+        if (!idle_handles_.empty()) {
+            easy = idle_handles_.back();
+            idle_handles_.pop_back();
+            curl_easy_reset(easy);
+        } else {
+            easy = curl_easy_init();
+        }
+        if (!easy) {
+            transfer->response.error = "curl_easy_init failed";
+            transfer->done(std::move(transfer->response));
+            return;
+        }
+
+        const auto& request = transfer->request;
+        transfer->url = options_.api_base + request.path;
+        auto& headers = transfer->headers;
+        headers = curl_slist_append(headers, ("Authorization: Bearer " + api_key_).c_str());
+        headers = curl_slist_append(headers, "Expect:");  // No 100-continue round trip
+        if (!options_.api_version.empty()) {
+            headers = curl_slist_append(headers, ("Stripe-Version: " + options_.api_version).c_str());
+        }
+        if (!request.idempotency_key.empty()) {
+            headers = curl_slist_append(headers, ("Idempotency-Key: " + request.idempotency_key).c_str());
+        }
+        if (!request.account.empty()) {
+            headers = curl_slist_append(headers, ("Stripe-Account: " + request.account).c_str());
+        }
+
+        curl_easy_setopt(easy, CURLOPT_URL, transfer->url.c_str());
+        if (request.method == "POST") {
+            headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
+            curl_easy_setopt(easy, CURLOPT_POST, 1L);
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request.body.data());
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request.body.size()));
+        } else if (request.method != "GET") {
+            curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+        }
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(easy, CURLOPT_USERAGENT, USER_AGENT);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, AppendBody);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer.get());
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, CaptureHeader);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, transfer.get());
+        curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer->error);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 0L);
+        curl_easy_setopt(easy, CURLOPT_PROTOCOLS_STR, "http,https");
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(options_.connect_timeout.count()));
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(options_.request_timeout.count()));
+
+        if (curl_multi_add_handle(multi_, easy) != CURLM_OK) {
+            curl_slist_free_all(headers);
+            curl_easy_cleanup(easy);
+            transfer->response.error = "Failed to start HTTP request";
+            transfer->done(std::move(transfer->response));
+            return;
+        }
+        active_.emplace(easy, std::move(transfer));
+    }
+
+    void Collect() {
+        int remaining = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi_, &remaining)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL* easy = message->easy_handle;
+            CURLcode code = message->data.result;
+            auto it = active_.find(easy);
+            if (it == active_.end()) {
+                continue;
+            }
+            std::unique_ptr<Transfer> transfer = std::move(it->second);
+            active_.erase(it);
+
+            if (code == CURLE_OK) {
+                curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &transfer->response.status);
+            } else {
+                // Connection errors and timeouts: status 0 (retryable)
+                transfer->response.status = 0;
+                transfer->response.error = transfer->error[0] ? transfer->error : curl_easy_strerror(code);
+            }
+
+            curl_multi_remove_handle(multi_, easy);
+            curl_slist_free_all(transfer->headers);
+            if (idle_handles_.size() < std::max<size_t>(options_.max_connections, 1) * 16) {
+                idle_handles_.push_back(easy);
+            } else {
+                curl_easy_cleanup(easy);
+            }
+
+            transfer->done(std::move(transfer->response));
+        }
+    }
+
+    std::string api_key_;
+    StripeClientOptions options_;
+    CURLM* multi_ = nullptr;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Transfer>> submitted_;
+    bool stop_ = false;
+
+    // Engine-thread state
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> active_;
+    std::vector<CURL*> idle_handles_;
+
+    std::thread thread_;
+};
+
+} // namespace
+
+StripeClientOptions StripeClientOptions::FromEnv() {
+    StripeClientOptions options;
+    options.api_base = EnvString("STRIPE_API_BASE", options.api_base);
+    options.api_version = EnvString("STRIPE_API_VERSION", options.api_version);
+    options.max_connections = static_cast<size_t>(
+        EnvInt("STRIPE_MAX_CONNECTIONS", static_cast<long>(options.max_connections)));
+    options.connect_timeout = std::chrono::milliseconds(
+        EnvInt("STRIPE_CONNECT_TIMEOUT_MS", static_cast<long>(options.connect_timeout.count())));
+    options.request_timeout = std::chrono::milliseconds(
+        EnvInt("STRIPE_REQUEST_TIMEOUT_MS", static_cast<long>(options.request_timeout.count())));
+    options.read_rate = EnvDouble("STRIPE_READ_RATE", options.read_rate);
+    options.write_rate = EnvDouble("STRIPE_WRITE_RATE", options.write_rate);
+    options.max_attempts = static_cast<int>(EnvInt("STRIPE_MAX_ATTEMPTS", options.max_attempts));
+    options.retry_budget_ratio = EnvDouble("STRIPE_RETRY_BUDGET_RATIO", options.retry_budget_ratio);
+    options.retry_budget_min_per_second = EnvDouble("STRIPE_RETRY_BUDGET_MIN_PER_SECOND",
+                                                    options.retry_budget_min_per_second);
+    return options;
+}
+
+RetryBudget::RetryBudget(double ratio, double min_per_second)
+    : ratio_(std::max(ratio, 0.0)),
+      min_per_second_(std::max(min_per_second, 0.0)),
+      capacity_(std::max(10.0, min_per_second_ * 10.0)),
+      balance_(capacity_),
+      refilled_at_(std::chrono::steady_clock::now()) {
+}
+
+void RetryBudget::OnRequest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RefillLocked(std::chrono::steady_clock::now());
+    balance_ = std::min(capacity_, balance_ + ratio_);
+}
+
+bool RetryBudget::TryRetry() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RefillLocked(std::chrono::steady_clock::now());
+    if (balance_ < 1.0) {
+        return false;
+    }
+    balance_ -= 1.0;
+    return true;
+}
+
+void RetryBudget::RefillLocked(std::chrono::steady_clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - refilled_at_).count();
+    balance_ = std::min(capacity_, balance_ + elapsed * min_per_second_);
+    refilled_at_ = now;
+}
+
+StripeClient::StripeClient(const std::string& api_key, const StripeClientOptions& options, Transport transport)
+    : options_(options),
+      transport_(std::move(transport)),
+      retry_budget_(options.retry_budget_ratio, options.retry_budget_min_per_second) {
+    bool test_mode = api_key.find("_test_") != std::string::npos;
+    if (options_.read_rate <= 0) {
+        options_.read_rate = test_mode ? TEST_RATE : LIVE_RATE;
+    }
+    if (options_.write_rate <= 0) {
+        options_.write_rate = test_mode ? TEST_RATE : LIVE_RATE;
+    }
+    options_.max_attempts = std::max(options_.max_attempts, 1);
+    if (!transport_) {
+        transport_ = CurlTransport(api_key, options_);
+    }
+
+    scheduler_ = std::thread(&StripeClient::SchedulerLoop, this);
+
+    LogInfo("StripeClient started", {{"read_rate", options_.read_rate},
+                                    {"write_rate", options_.write_rate},
+                                    {"max_attempts", options_.max_attempts}});
+}
+
+StripeClient::~StripeClient() {
+    Shutdown();
+}
+
+void StripeClient::Shutdown() {
+    std::vector<std::shared_ptr<Call>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+        for (auto& [at, call] : queue_) {
+            dropped.push_back(std::move(call));
+        }
+        queue_.clear();
+    }
+    cv_.notify_all();
+    if (scheduler_.joinable()) {
+        scheduler_.join();
+    }
+
+    for (auto& call : dropped) {
+        StripeHttpResponse response;
+        response.error = "StripeClient shut down";
+        call->done(std::move(response));
+    }
+
+    // Completions may still run on the transport thread; they use this object
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+StripeClientStats StripeClient::GetStats() const {
+    StripeClientStats stats;
+    stats.requests = requests_.load();
+    stats.retries = retries_.load();
+    stats.coalesced = coalesced_.load();
+    stats.rate_limited = rate_limited_.load();
+    stats.budget_exhausted = budget_exhausted_.load();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.in_flight = in_flight_;
+    stats.queued = queue_.size();
+    return stats;
+}
+
+void StripeClient::Send(StripeHttpRequest request, Completion done) {
+    auto call = std::make_shared<Call>();
+    call->write = request.method != "GET";
+    if (request.method == "POST" && request.idempotency_key.empty()) {
+        request.idempotency_key = NewIdempotencyKey();
+    }
+    call->request = std::move(request);
+    call->done = std::move(done);
+    Enqueue(std::move(call), std::chrono::steady_clock::now());
+}
+
+void StripeClient::Enqueue(std::shared_ptr<Call> call, std::chrono::steady_clock::time_point at) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!shutdown_) {
+            queue_.emplace(at, std::move(call));
+        }
+    }
+    if (call) {
+        StripeHttpResponse response;
+        response.error = "StripeClient shut down";
+        call->done(std::move(response));
+        return;
+    }
+    cv_.notify_all();
+}
+
+void StripeClient::SchedulerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!shutdown_) {
+        if (queue_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        auto first = queue_.begin();
+        if (first->first > now) {
+            auto due = first->first;   // The node may be erased while waiting
+            cv_.wait_until(lock, due);
+            continue;
+        }
+        std::shared_ptr<Call> call = std::move(first->second);
+        queue_.erase(first);
+
+        // Out of tokens for this account: wait in the queue, not on the caller's thread
+        auto wait = TakeTokenLocked(call->request.account, call->write, now);
+        if (wait.count() > 0) {
+            ++rate_limited_;
+            queue_.emplace(now + wait, std::move(call));
+            continue;
+        }
+
+        ++in_flight_;
+        lock.unlock();
+
+        ++requests_;
+        if (call->attempt == 0) {
+            retry_budget_.OnRequest();
+        }
+        try {
+            transport_(call->request, [this, call](StripeHttpResponse response) {
+                OnResponse(call, std::move(response));
+            });
+        } catch (const std::exception& e) {
+            StripeHttpResponse response;
+            response.error = e.what();
+            OnResponse(call, std::move(response));
+        }
+
+        lock.lock();
+    }
+}
+
+void StripeClient::OnResponse(const std::shared_ptr<Call>& call, StripeHttpResponse response) {
+    if (Retryable(response)) {
+        bool attempts_left = call->attempt + 1 < options_.max_attempts;
+        if (attempts_left && retry_budget_.TryRetry()) {
+            ++call->attempt;
+            auto at = std::chrono::steady_clock::now() + Backoff(call->attempt, response.retry_after);
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!shutdown_) {
+                ++retries_;
+                queue_.emplace(at, call);
+                --in_flight_;
+                lock.unlock();
+                cv_.notify_all();
+                return;
+            }
+        } else if (attempts_left) {
+            ++budget_exhausted_;
+        }
+    }
+
+    call->done(std::move(response));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --in_flight_;
+    }
+    cv_.notify_all();
+}
+
+std::chrono::steady_clock::duration StripeClient::TakeTokenLocked(
+    const std::string& account, bool write, std::chrono::steady_clock::time_point now) {
+    if (buckets_.size() >= MAX_BUCKETS && buckets_.find(account) == buckets_.end()) {
+        for (auto it = buckets_.begin(); it != buckets_.end();) {
+            bool idle = now - it->second.refilled_at > std::chrono::seconds(1);
+            it = idle ? buckets_.erase(it) : std::next(it);
+        }
+    }
+
+    auto [it, created] = buckets_.try_emplace(account);
+    Bucket& bucket = it->second;
+    if (created) {
+        bucket.read_tokens = options_.read_rate;
+        bucket.write_tokens = options_.write_rate;
+    } else {
+        double elapsed = std::chrono::duration<double>(now - bucket.refilled_at).count();
+        bucket.read_tokens = std::min(options_.read_rate, bucket.read_tokens + elapsed * options_.read_rate);
+        bucket.write_tokens = std::min(options_.write_rate, bucket.write_tokens + elapsed * options_.write_rate);
+    }
+    bucket.refilled_at = now;
+
+    double& tokens = write ? bucket.write_tokens : bucket.read_tokens;
+    double rate = write ? options_.write_rate : options_.read_rate;
+    if (tokens >= 1.0) {
+        tokens -= 1.0;
+        return std::chrono::steady_clock::duration::zero();
+    }
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>((1.0 - tokens) / rate)) + std::chrono::microseconds(1);
+}
+
+std::chrono::milliseconds StripeClient::Backoff(int attempt, std::chrono::milliseconds retry_after) const {
+    // Exponential with jitter in [delay/2, delay], so retries from many callers spread out
+    double delay = static_cast<double>(options_.initial_backoff.count()) * std::pow(2.0, attempt - 1);
+    delay = std::min(delay, static_cast<double>(options_.max_backoff.count()));
+    delay *= std::uniform_real_distribution<>(0.5, 1.0)(Random());
+    auto backoff = std::chrono::milliseconds(static_cast<int64_t>(delay));
+    return std::max(backoff, std::min(retry_after, options_.max_backoff));
+}
+
+StripeHttpResponse StripeClient::Execute(StripeHttpRequest request, const std::string& not_found_message) {
+    return SendAsync<StripeHttpResponse>(*this, std::move(request), [not_found_message](const StripeHttpResponse& response) {
+        if (!response.Ok()) {
+            std::rethrow_exception(ErrorFrom(response, not_found_message));
+        }
+        return response;
+    }).get();
+}
+
+template <typename T, typename Parse>
+std::shared_future<std::optional<T>> StripeClient::Coalesce(InFlight<T>& in_flight, StripeHttpRequest request,
+                                                             Parse parse) {
+    std::string key = request.account + '\n' + request.path;
+    auto promise = std::make_shared<std::promise<std::optional<T>>>();
+    std::shared_future<std::optional<T>> future = promise->get_future().share();
+    {
+        std::lock_guard<std::mutex> lock(coalesce_mutex_);
+        auto it = in_flight.find(key);
+        if (it != in_flight.end()) {
+            ++coalesced_;
+            return it->second;
+        }
+        in_flight.emplace(key, future);
+    }
+
+    Send(std::move(request), [this, &in_flight, key, promise, parse](StripeHttpResponse response) {
+        {
+            // Removed before completing, so later callers see a fresh read
+            std::lock_guard<std::mutex> lock(coalesce_mutex_);
+            in_flight.erase(key);
+        }
+        try {
+            promise->set_value(ParseOptional<T>(response, parse));
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+// Customers
+
+std::shared_future<std::optional<StripeCustomer>> StripeClient::GetCustomerAsync(
+    const std::string& customer_id, const StripeCallOptions& call) {
+    return Coalesce(customer_lookups_, Get("/v1/customers/" + PercentEncode(customer_id, false), call.account),
+                    ParseCustomer);
+}
+
+std::future<StripeCustomer> StripeClient::CreateCustomerAsync(
+    const std::string& email, const std::string& tenant_id, const StripeCallOptions& call) {
+    return SendAsync<StripeCustomer>(*this,
+        Post("/v1/customers", {{"email", email}, {"metadata[tenant_id]", tenant_id}}, call),
+        [](const StripeHttpResponse& response) { return ParseCustomer(Body(response)); });
+}
+
+StripeCustomer StripeClient::CreateCustomer(const std::string& email, const std::string& tenant_id) {
+    return CreateCustomerAsync(email, tenant_id).get();
+}
+
+std::optional<StripeCustomer> StripeClient::GetCustomer(const std::string& customer_id) {
+    return GetCustomerAsync(customer_id).get();
+}
+
+// Subscriptions
+
+std::shared_future<std::optional<StripeSubscription>> StripeClient::GetSubscriptionAsync(
+    const std::string& subscription_id, const StripeCallOptions& call) {
+    return Coalesce(subscription_lookups_,
+                    Get("/v1/subscriptions/" + PercentEncode(subscription_id, false), call.account),
+                    ParseSubscription);
+}
+
+std::future<StripeSubscription> StripeClient::CreateSubscriptionAsync(
+    const std::string& customer_id, const std::string& plan_id, int trial_days, const StripeCallOptions& call) {
+    // plan_id is the Stripe price id; kept in metadata so it reads back unchanged
+    std::vector<std::pair<std::string, std::string>> params = {
+        {"customer", customer_id},
+        {"items[0][price]", plan_id},
+        {"metadata[plan_id]", plan_id},
+    };
+    if (trial_days > 0) {
+        params.emplace_back("trial_period_days", std::to_string(trial_days));
+    }
+    return SendAsync<StripeSubscription>(*this, Post("/v1/subscriptions", params, call),
+        [](const StripeHttpResponse& response) { return ParseSubscription(Body(response)); });
+}
+
+StripeSubscription StripeClient::CreateSubscription(
+    const std::string& customer_id,
+    const std::string& plan_id,
+    int trial_days
+) {
+    return CreateSubscriptionAsync(customer_id, plan_id, trial_days).get();
+}
+
+std::optional<StripeSubscription> StripeClient::GetSubscription(const std::string& subscription_id) {
+    return GetSubscriptionAsync(subscription_id).get();
+}
+
+StripeSubscription StripeClient::UpdateSubscription(
+    const std::string& subscription_id,
+    const std::string& new_plan_id
+) {
+    std::string path = "/v1/subscriptions/" + PercentEncode(subscription_id, false);
+
+    // The price is swapped on the existing item, which only the full object names
+    auto current = Body(Execute(Get(path), "Subscription not found"));
+    std::string item_id = String(First(Field(current, "items")), "id");
+    if (item_id.empty()) {
+        throw StripeApiError(200, "", "Subscription has no items");
+    }
+
+    auto response = Execute(Post(path, {
+        {"items[0][id]", item_id},
+        {"items[0][price]", new_plan_id},
+        {"metadata[plan_id]", new_plan_id},
+        {"proration_behavior", "create_prorations"},   // Requirement C-74
+    }), "Subscription not found");
+    return ParseSubscription(Body(response));
+}
+
+void StripeClient::CancelSubscription(const std::string& subscription_id, bool cancel_immediately) {
+    std::string path = "/v1/subscriptions/" + PercentEncode(subscription_id, false);
+    if (cancel_immediately) {
+        StripeHttpRequest request = Get(path);
+        request.method = "DELETE";
+        Execute(std::move(request), "Subscription not found");
+    } else {
+        Execute(Post(path, {{"cancel_at_period_end", "true"}}), "Subscription not found");
+    }
+}
+
+// Payment methods
+
+StripePaymentMethod StripeClient::CreatePaymentMethod(
+    const std::string& type,
+    const std::string& card_number,
+    int exp_month,
+    int exp_year
+) {
+    std::vector<std::pair<std::string, std::string>> params = {{"type", type}};
+    if (type == "card" && !card_number.empty()) {
+        params.emplace_back("card[number]", card_number);
+        params.emplace_back("card[exp_month]", std::to_string(exp_month));
+        params.emplace_back("card[exp_year]", std::to_string(exp_year));
+    }
+    return ParsePaymentMethod(Body(Execute(Post("/v1/payment_methods", params))));
+}
+
+void StripeClient::AttachPaymentMethod(const std::string& payment_method_id, const std::string& customer_id) {
+    Execute(Post("/v1/payment_methods/" + PercentEncode(payment_method_id, false) + "/attach",
+                 {{"customer", customer_id}}),
+            "Payment method not found");
+    Execute(Post("/v1/customers/" + PercentEncode(customer_id, false),
+                 {{"invoice_settings[default_payment_method]", payment_method_id}}),
+            "Customer not found");
+}
+
+void StripeClient::DetachPaymentMethod(const std::string& payment_method_id) {
+    try {
+        Execute(Post("/v1/payment_methods/" + PercentEncode(payment_method_id, false) + "/detach", {}));
+    } catch (const StripeApiError& e) {
+        if (e.Status() != 404) {   // Already gone: nothing to detach
+            throw;
+        }
+    }
+}
+
+std::optional<StripePaymentMethod> StripeClient::GetPaymentMethod(const std::string& payment_method_id) {
+    return SendAsync<std::optional<StripePaymentMethod>>(*this,
+        Get("/v1/payment_methods/" + PercentEncode(payment_method_id, false)),
+        [](const StripeHttpResponse& response) {
+            return ParseOptional<StripePaymentMethod>(response, ParsePaymentMethod);
+        }).get();
+}
+
+// Invoices
+
+StripeInvoice StripeClient::CreateInvoice(const std::string& customer_id, const std::string& subscription_id) {
+    return ParseInvoice(Body(Execute(Post("/v1/invoices", {{"customer", customer_id}, {"subscription", subscription_id}}))));
+}
+
+std::optional<StripeInvoice> StripeClient::GetInvoice(const std::string& invoice_id) {
+    return SendAsync<std::optional<StripeInvoice>>(*this,
+        Get("/v1/invoices/" + PercentEncode(invoice_id, false)),
+        [](const StripeHttpResponse& response) {
+            return ParseOptional<StripeInvoice>(response, ParseInvoice);
+        }).get();
+}
+
+void StripeClient::FinalizeInvoice(const std::string& invoice_id) {
+    Execute(Post("/v1/invoices/" + PercentEncode(invoice_id, false) + "/finalize", {}), "Invoice not found");
+}
+
+std::future<PaymentIntentStatus> StripeClient::PayInvoiceAsync(
+    const std::string& invoice_id, const StripeCallOptions& call) {
+    return SendAsync<PaymentIntentStatus>(*this,
+        Post("/v1/invoices/" + PercentEncode(invoice_id, false) + "/pay", {}, call),
+        [](const StripeHttpResponse& response) {
+            // 402: the charge was attempted and did not go through
+            if (response.status == 402) {
+                picojson::value body;
+                picojson::parse(body, response.body);
+                std::string code = String(Field(body, "error"), "code");
+                return code == "invoice_payment_intent_requires_action"
+                    ? PaymentIntentStatus::REQUIRES_ACTION
+                    : PaymentIntentStatus::FAILED;
+            }
+            auto invoice = ParseInvoice(Body(response, "Invoice not found"));
+            return invoice.status == "paid" ? PaymentIntentStatus::SUCCEEDED : PaymentIntentStatus::PROCESSING;
+        });
+}
+
+PaymentIntentStatus StripeClient::PayInvoice(const std::string& invoice_id) {
+    return PayInvoiceAsync(invoice_id).get();
+}
+
+// Helpers
+
+StripeClient::Transport StripeClient::CurlTransport(const std::string& api_key, const StripeClientOptions& options) {
+    auto engine = std::make_shared<StripeCurlEngine>(api_key, options);
+    return [engine](const StripeHttpRequest& request, Completion done) {
+        engine->Start(request, std::move(done));
+    };
+}
+
+std::string StripeClient::FormEncode(const std::vector<std::pair<std::string, std::string>>& params) {
+    std::string body;
+    for (const auto& [name, value] : params) {
+        if (!body.empty()) {
+            body += '&';
+        }
+        body += PercentEncode(name, true);
+        body += '=';
+        body += PercentEncode(value, false);
+    }
+    return body;
+}
+
+} // namespace common
+} // namespace saasforge
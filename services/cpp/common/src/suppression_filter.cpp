@@ -0,0 +1,242 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-memory Bloom filter over the email suppression list implementation
+ */
+
+#include "common/suppression_filter.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const PreparedStatement kLoadCursor(
+    "suppression_filter_cursor",
+    "SELECT NOW()::text");
+
+const PreparedStatement kLoadAll(
+    "suppression_filter_load_all",
+    "SELECT email_address FROM email_suppression");
+
+// created_at is the inserting transaction's start, so a row committed after
+// the previous load can be older than its cursor: reread `lookback` before it
+const PreparedStatement kLoadSince(
+    "suppression_filter_load_since",
+    "SELECT email_address FROM email_suppression "
+    "WHERE created_at >= $1::timestamptz - make_interval(secs => $2)");
+
+} // namespace
+
+SuppressionFilterOptions SuppressionFilterOptions::FromEnv() {
+    SuppressionFilterOptions options;
+    options.expected_addresses = static_cast<size_t>(std::max(1L,
+        EnvInt("EMAIL_SUPPRESSION_FILTER_EXPECTED", static_cast<long>(options.expected_addresses))));
+    options.refresh = std::chrono::seconds(
+        EnvInt("EMAIL_SUPPRESSION_FILTER_REFRESH_S", static_cast<long>(options.refresh.count())));
+    options.rebuild = std::chrono::seconds(
+        EnvInt("EMAIL_SUPPRESSION_FILTER_REBUILD_S", static_cast<long>(options.rebuild.count())));
+    return options;
+}
+
+SuppressionFilter::SuppressionFilter(std::shared_ptr<DbPool> db_pool, std::shared_ptr<EventBus> event_bus,
+                                     const SuppressionFilterOptions& options)
+    : SuppressionFilter(
+          [db_pool, lookback = static_cast<int>(options.lookback.count())](const std::string& cursor) {
+              auto conn_guard = db_pool->AcquireConnection("SuppressionFilter::Load");
+              pqxx::read_transaction txn(*conn_guard);
+
+              Batch batch;
+              ReadText(ExecPrepared(txn, kLoadCursor)[0][0], batch.cursor);
+              auto result = cursor.empty()
+                  ? ExecPrepared(txn, kLoadAll)
+                  : ExecPrepared(txn, kLoadSince, cursor, lookback);
+
+              batch.addresses.reserve(result.size());
+              for (const auto& row : result) {
+                  ReadText(row[0], batch.addresses.emplace_back());
+              }
+              return batch;
+          },
+          std::move(event_bus), options) {}
+
+SuppressionFilter::SuppressionFilter(Loader loader, std::shared_ptr<EventBus> event_bus,
+                                     const SuppressionFilterOptions& options)
+    : load_(std::move(loader)), event_bus_(std::move(event_bus)), options_(options) {
+    if (options_.refresh.count() <= 0) {
+        options_.refresh = std::chrono::seconds(1);
+    }
+    options_.rebuild = std::max(options_.rebuild, options_.refresh);
+    thread_ = std::thread(&SuppressionFilter::ReloadLoop, this);
+
+    // Subscribed before the first load completes: an address suppressed
+    // meanwhile is either in the load or received here
+    if (event_bus_) {
+        subscription_ = event_bus_->Subscribe(
+            SUPPRESSED_TOPIC,
+            [this](const std::string& email_address) { AddLocal(email_address); },
+            [this]() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    reset_ = true;
+                }
+                cv_.notify_all();
+            });
+    }
+}
+
+SuppressionFilter::~SuppressionFilter() {
+    Shutdown();
+}
+
+void SuppressionFilter::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    if (subscription_ != 0) {
+        event_bus_->Unsubscribe(subscription_);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool SuppressionFilter::MightBeSuppressed(const std::string& email_address) const {
+    std::shared_lock<std::shared_mutex> lock(filter_mutex_);
+    return !filter_ || filter_->MightContain(email_address);
+}
+
+void SuppressionFilter::Add(const std::string& email_address) {
+    AddLocal(email_address);
+    if (event_bus_ && !event_bus_->Publish(SUPPRESSED_TOPIC, email_address)) {
+        // Other replicas pick it up on their next refresh
+        LogWarn("Publishing email suppression dropped");
+    }
+}
+
+void SuppressionFilter::AddLocal(const std::string& email_address) {
+    std::unique_lock<std::shared_mutex> lock(filter_mutex_);
+    if (filter_) {
+        filter_->Add(email_address);
+    }
+}
+
+bool SuppressionFilter::Ready() const {
+    std::shared_lock<std::shared_mutex> lock(filter_mutex_);
+    return filter_ != nullptr;
+}
+
+size_t SuppressionFilter::Count() const {
+    std::shared_lock<std::shared_mutex> lock(filter_mutex_);
+    return filter_ ? filter_->Count() : 0;
+}
+
+bool SuppressionFilter::Refresh() {
+    return Load(false);
+}
+
+bool SuppressionFilter::Rebuild() {
+    return Load(true);
+}
+
+bool SuppressionFilter::Load(bool full) {
+    std::lock_guard<std::mutex> load_lock(load_mutex_);
+
+    std::string cursor;
+    if (!full) {
+        std::shared_lock<std::shared_mutex> lock(filter_mutex_);
+        if (filter_) {
+            cursor = cursor_;
+        }
+    }
+
+    Batch batch;
+    try {
+        batch = load_(cursor);
+    } catch (const std::exception& e) {
+        ++failures_;
+        LogError("Loading email suppression list failed", {{"full", cursor.empty()}, {"error", e.what()}});
+        return false;
+    }
+
+    if (!cursor.empty()) {
+        std::unique_lock<std::shared_mutex> lock(filter_mutex_);
+        for (const auto& address : batch.addresses) {
+            filter_->Add(address);
+        }
+        cursor_ = std::move(batch.cursor);
+        return true;
+    }
+
+    // Sized with headroom so additions do not saturate it before the next rebuild
+    auto filter = std::make_unique<BloomFilter>(
+        std::max(options_.expected_addresses, batch.addresses.size() * 2), options_.false_positive_rate);
+    for (const auto& address : batch.addresses) {
+        filter->Add(address);
+    }
+
+    LogInfo("Email suppression filter loaded", {
+        {"addresses", batch.addresses.size()},
+        {"bits", filter->BitCount()}
+    });
+
+    std::unique_lock<std::shared_mutex> lock(filter_mutex_);
+    filter_ = std::move(filter);
+    cursor_ = std::move(batch.cursor);
+    return true;
+}
+
+void SuppressionFilter::ReloadLoop() {
+    Load(true);
+    auto last_refresh = std::chrono::steady_clock::now();
+    auto last_rebuild = last_refresh;
+
+    while (true) {
+        bool reset;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (cv_.wait_for(lock, std::chrono::milliseconds(options_.refresh),
+                             [this] { return shutdown_ || reset_; }) && shutdown_) {
+                return;
+            }
+            reset = reset_;
+            reset_ = false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        bool saturated;
+        {
+            std::shared_lock<std::shared_mutex> lock(filter_mutex_);
+            saturated = filter_ && filter_->Saturated();
+        }
+
+        if (Ready() && (saturated || now - last_rebuild >= options_.rebuild)) {
+            last_refresh = now;
+            if (Rebuild()) {
+                last_rebuild = now;
+            }
+        } else if (reset || now - last_refresh >= options_.refresh) {
+            bool was_ready = Ready();
+            last_refresh = now;
+            if (Refresh() && !was_ready) {
+                last_rebuild = now;
+            }
+        }
+    }
+}
+
+} // namespace common
+} // namespace saasforge
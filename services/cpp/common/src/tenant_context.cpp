@@ -1,177 +1,190 @@
 #include "common/tenant_context.h"
+#include "common/call_slot.h"
 #include "common/jwt_validator.h"
-#include <iostream>
+#include "common/logger.h"
 #include <string_view>
 #include <algorithm>
+#include <cctype>
+#include <utility>
 
 namespace saasforge {
 namespace common {
 
-TenantContextInterceptor::TenantContextInterceptor(grpc::experimental::ServerRpcInfo* info) {
-    // Initialize interceptor with RPC info
+namespace {
+
+using TenantSlot = CallSlot<std::shared_ptr<const TenantCall>>;
+
+std::string_view Header(const ServerMetadata& metadata, std::string_view key) {
+    auto it = metadata.find(grpc::string_ref(key.data(), key.size()));
+    if (it == metadata.end()) {
+        return {};
+    }
+    return std::string_view(it->second.data(), it->second.size());
 }
 
-void TenantContextInterceptor::Intercept(grpc::experimental::InterceptorBatchMethods* methods) {
-    // This interceptor runs on every RPC call
-    // It validates tenant context from metadata
+std::string_view Trim(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) value.remove_prefix(1);
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) value.remove_suffix(1);
+    return value;
+}
 
-    if (methods->QueryInterceptionHookPoint(
-            grpc::experimental::InterceptionHookPoints::PRE_SEND_INITIAL_METADATA)) {
-        // Add any response metadata if needed
+} // namespace
+
+TenantContextInterceptor::TenantContextInterceptor(grpc::experimental::ServerRpcInfo* info)
+    : TenantContextInterceptor(info, std::make_shared<const TenantContextOptions>()) {}
+
+TenantContextInterceptor::TenantContextInterceptor(grpc::experimental::ServerRpcInfo* info,
+                                                   std::shared_ptr<const TenantContextOptions> options)
+    : context_(info->server_context()),
+      method_(info->method() ? info->method() : ""),
+      options_(std::move(options)) {}
+
+TenantContextInterceptor::~TenantContextInterceptor() {
+    if (stored_) {
+        TenantSlot::Global().Clear(context_);
     }
+}
 
+void TenantContextInterceptor::Intercept(grpc::experimental::InterceptorBatchMethods* methods) {
+    // Parse once, when the client's metadata arrives and before the handler runs
     if (methods->QueryInterceptionHookPoint(
             grpc::experimental::InterceptionHookPoints::POST_RECV_INITIAL_METADATA)) {
-        // Validate tenant context from incoming metadata
-        // Note: Actual validation is done in ExtractFromMetadata by each service
+        auto* metadata = methods->GetRecvInitialMetadata();
+        if (metadata && context_) {
+            const auto& public_methods = options_->public_methods;
+            bool is_public = std::find(public_methods.begin(), public_methods.end(), method_) != public_methods.end();
+            // Health checks, reflection and the like are not ours to guard
+            bool require_identity = !is_public && method_.rfind("/saasforge.", 0) == 0;
+
+            auto call = std::make_shared<TenantCall>(
+                Parse(*metadata, options_->jwt_validator.get(), require_identity));
+            if (!call->rejection.ok()) {
+                LogWarn("Rejecting unauthenticated call", {{"method", method_},
+                                                           {"reason", call->rejection.error_message()}});
+            }
+            TenantSlot::Global().Set(context_, std::move(call));
+            stored_ = true;
+        }
     }
 
     // Continue with the next interceptor in the chain
     methods->Proceed();
 }
 
-std::string TenantContextInterceptor::ExtractJwtFromMetadata(grpc::ServerContext* context) {
-    auto metadata = context->client_metadata();
-
-    // Try to extract JWT from Authorization header
-    auto auth_header = metadata.find("authorization");
-    if (auth_header != metadata.end()) {
-        std::string auth_value(auth_header->second.data(), auth_header->second.size());
-
-        // Remove "Bearer " prefix if present
-        const std::string bearer_prefix = "Bearer ";
-        if (auth_value.size() > bearer_prefix.size() &&
-            auth_value.substr(0, bearer_prefix.size()) == bearer_prefix) {
-            return auth_value.substr(bearer_prefix.size());
-        }
-
-        return auth_value;
+std::shared_ptr<const TenantContext> TenantContextInterceptor::ForCall(grpc::ServerContextBase* context) {
+    if (auto call = TenantSlot::Global().Get(context)) {
+        // Shares ownership with the slot entry; no copy of the context
+        return std::shared_ptr<const TenantContext>(call, &call->context);
     }
+    return std::make_shared<const TenantContext>(ExtractFromMetadataUnsafe(context));
+}
 
-    return "";
+grpc::Status TenantContextInterceptor::CallStatus(const grpc::ServerContextBase* context) {
+    auto call = TenantSlot::Global().Get(context);
+    return call ? call->rejection : grpc::Status::OK;
 }
 
-TenantContext TenantContextInterceptor::ExtractFromMetadata(
-    grpc::ServerContext* context,
-    std::shared_ptr<JwtValidator> jwt_validator
-) {
-    TenantContext tenant_ctx;
-    tenant_ctx.validated = false;
+TenantCall TenantContextInterceptor::Parse(const ServerMetadata& metadata,
+                                           JwtValidator* jwt_validator,
+                                           bool require_identity) {
+    TenantCall call;
+    std::string_view jwt_token = jwt_validator ? ExtractJwtFromMetadata(metadata) : std::string_view();
+
+    if (!jwt_token.empty()) {
+        auto claims = jwt_validator->Validate(jwt_token);
+        if (!claims) {
+            call.context.validated = false;
+            call.rejection = grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid or expired token");
+            return call;
+        }
 
-    auto metadata = context->client_metadata();
+        // CRITICAL SECURITY CHECK: Verify requested tenant_id matches JWT claim
+        std::string_view requested_tenant_id = Header(metadata, "x-tenant-id");
+        if (!requested_tenant_id.empty() && claims->tenant_id != requested_tenant_id) {
+            LogWarn("SECURITY: Tenant ID mismatch", {{"jwt_tenant", claims->tenant_id},
+                                                    {"requested_tenant", std::string(requested_tenant_id)}});
+            call.context.validated = false;
+            call.rejection = grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Tenant does not match token");
+            return call;
+        }
 
-    // Extract requested tenant_id from metadata
-    auto tenant_id_header = metadata.find("x-tenant-id");
-    std::string requested_tenant_id;
-    if (tenant_id_header != metadata.end()) {
-        requested_tenant_id = std::string(tenant_id_header->second.data(),
-                                          tenant_id_header->second.size());
+        // Validation passed - populate context from JWT claims
+        call.context.tenant_id = std::move(claims->tenant_id);
+        call.context.user_id = std::move(claims->user_id);
+        call.context.email = std::move(claims->email);
+        call.context.roles = std::move(claims->roles);
+        call.context.validated = true;
+        return call;
     }
 
-    // If JWT validator provided, validate token and check tenant_id
-    if (jwt_validator) {
-        std::string jwt_token = ExtractJwtFromMetadata(context);
-
-        if (!jwt_token.empty()) {
-            auto claims = jwt_validator->Validate(jwt_token);
-
-            if (claims) {
-                // CRITICAL SECURITY CHECK: Verify requested tenant_id matches JWT claim
-                if (!requested_tenant_id.empty() &&
-                    claims->tenant_id != requested_tenant_id) {
-                    // SECURITY VIOLATION: Client requested different tenant than they're authenticated for
-                    std::cerr << "SECURITY: Tenant ID mismatch - JWT: " << claims->tenant_id
-                              << ", Requested: " << requested_tenant_id << std::endl;
-
-                    // Return empty context to indicate validation failure
-                    tenant_ctx.validated = false;
-                    return tenant_ctx;
-                }
-
-                // Validation passed - populate context from JWT claims
-                tenant_ctx.tenant_id = claims->tenant_id;
-                tenant_ctx.user_id = claims->user_id;
-                tenant_ctx.email = claims->email;
-                tenant_ctx.roles = claims->roles;
-                tenant_ctx.validated = true;
-
-                return tenant_ctx;
-            } else {
-                // JWT validation failed
-                std::cerr << "SECURITY: JWT validation failed" << std::endl;
-                tenant_ctx.validated = false;
-                return tenant_ctx;
-            }
-        }
+    // No token (or no validator): trust the gateway's headers
+    call.context = ParseHeaders(metadata);
+    if (require_identity && call.context.tenant_id.empty() && call.context.user_id.empty()) {
+        call.rejection = grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
     }
+    return call;
+}
 
-    // If no JWT validator provided, fall back to unsafe extraction
-    // This should only be used for services that don't require authentication
-    std::cerr << "WARNING: Extracting tenant context without JWT validation" << std::endl;
-    return ExtractFromMetadataUnsafe(context);
+std::string_view TenantContextInterceptor::ExtractJwtFromMetadata(const ServerMetadata& metadata) {
+    // Remove "Bearer " prefix if present
+    std::string_view auth_value = Header(metadata, "authorization");
+    constexpr std::string_view bearer_prefix = "Bearer ";
+    if (auth_value.size() > bearer_prefix.size() &&
+        auth_value.substr(0, bearer_prefix.size()) == bearer_prefix) {
+        auth_value.remove_prefix(bearer_prefix.size());
+    }
+    return auth_value;
 }
 
-TenantContext TenantContextInterceptor::ExtractFromMetadataUnsafe(grpc::ServerContext* context) {
+TenantContext TenantContextInterceptor::ParseHeaders(const ServerMetadata& metadata) {
     TenantContext tenant_ctx;
     tenant_ctx.validated = false;  // Mark as unvalidated
 
-    auto metadata = context->client_metadata();
-
-    // Extract tenant ID
-    auto tenant_id = metadata.find("x-tenant-id");
-    if (tenant_id != metadata.end()) {
-        tenant_ctx.tenant_id = std::string(tenant_id->second.data(), tenant_id->second.size());
-    }
-
-    // Extract user ID
-    auto user_id = metadata.find("x-user-id");
-    if (user_id != metadata.end()) {
-        tenant_ctx.user_id = std::string(user_id->second.data(), user_id->second.size());
-    }
-
-    // Extract email
-    auto email = metadata.find("x-user-email");
-    if (email != metadata.end()) {
-        tenant_ctx.email = std::string(email->second.data(), email->second.size());
+    tenant_ctx.tenant_id = std::string(Header(metadata, "x-tenant-id"));
+    tenant_ctx.user_id = std::string(Header(metadata, "x-user-id"));
+    tenant_ctx.email = std::string(Header(metadata, "x-user-email"));
+
+    // Parse comma-separated roles
+    std::string_view roles = Header(metadata, "x-user-roles");
+    while (!roles.empty()) {
+        size_t end = roles.find(',');
+        auto role = Trim(roles.substr(0, end));
+        if (!role.empty()) {
+            tenant_ctx.roles.emplace_back(role);
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        roles.remove_prefix(end + 1);
     }
 
-    // Extract roles (comma-separated list)
-    auto roles = metadata.find("x-user-roles");
-    if (roles != metadata.end()) {
-        std::string roles_str(roles->second.data(), roles->second.size());
-
-        // Parse comma-separated roles
-        std::string_view roles_view(roles_str);
-        size_t start = 0;
-        size_t end = roles_view.find(',');
-
-        while (end != std::string_view::npos) {
-            auto role = roles_view.substr(start, end - start);
-            // Trim whitespace
-            while (!role.empty() && std::isspace(role.front())) role.remove_prefix(1);
-            while (!role.empty() && std::isspace(role.back())) role.remove_suffix(1);
-
-            if (!role.empty()) {
-                tenant_ctx.roles.push_back(std::string(role));
-            }
+    return tenant_ctx;
+}
 
-            start = end + 1;
-            end = roles_view.find(',', start);
-        }
+TenantContext TenantContextInterceptor::ExtractFromMetadata(
+    grpc::ServerContextBase* context,
+    std::shared_ptr<JwtValidator> jwt_validator
+) {
+    // Same rules as the interceptor, minus the rejection: an invalid token
+    // yields an empty, unvalidated context
+    return Parse(context->client_metadata(), jwt_validator.get(), false).context;
+}
 
-        // Add last role
-        if (start < roles_view.length()) {
-            auto role = roles_view.substr(start);
-            while (!role.empty() && std::isspace(role.front())) role.remove_prefix(1);
-            while (!role.empty() && std::isspace(role.back())) role.remove_suffix(1);
+TenantContext TenantContextInterceptor::ExtractFromMetadataUnsafe(grpc::ServerContextBase* context) {
+    return ParseHeaders(context->client_metadata());
+}
 
-            if (!role.empty()) {
-                tenant_ctx.roles.push_back(std::string(role));
-            }
-        }
+TenantContextInterceptorFactory::TenantContextInterceptorFactory(TenantContextOptions options)
+    : options_(std::make_shared<const TenantContextOptions>(std::move(options))) {
+    if (!options_->jwt_validator) {
+        // Logged once per server instead of on every call
+        LogWarn("Tenant context is taken from gateway headers without JWT validation");
     }
+}
 
-    return tenant_ctx;
+grpc::experimental::Interceptor* TenantContextInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    return new TenantContextInterceptor(info, options_);
 }
 
 } // namespace common
@@ -0,0 +1,164 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Deficit round-robin tenant scheduler implementation
+ */
+
+#include "common/tenant_fair_scheduler.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace saasforge {
+namespace common {
+
+TenantFairSchedulerOptions TenantFairSchedulerOptions::FromEnv() {
+    TenantFairSchedulerOptions options;
+    options.quantum = static_cast<int>(
+        std::max(1L, EnvInt("EMAIL_QUEUE_TENANT_QUANTUM", options.quantum)));
+    options.rate_per_second = static_cast<double>(
+        EnvInt("EMAIL_QUEUE_TENANT_RATE_PER_S", static_cast<long>(options.rate_per_second)));
+    options.burst = static_cast<double>(
+        std::max(1L, EnvInt("EMAIL_QUEUE_TENANT_BURST", static_cast<long>(options.burst))));
+    return options;
+}
+
+TenantFairScheduler::TenantFairScheduler(TenantFairSchedulerOptions options)
+    : options_(options) {
+    options_.quantum = std::max(1, options_.quantum);
+    options_.burst = std::max(1.0, options_.burst);
+}
+
+void TenantFairScheduler::Refill(Bucket& bucket, Clock::time_point now) const {
+    double elapsed = std::chrono::duration<double>(now - bucket.refilled).count();
+    if (elapsed > 0) {
+        bucket.tokens = std::min(options_.burst, bucket.tokens + elapsed * options_.rate_per_second);
+        bucket.refilled = now;
+    }
+}
+
+TenantFairScheduler::Allocation TenantFairScheduler::Allocate(
+    const std::vector<std::string>& tenants, int capacity, Clock::time_point now) {
+    Allocation allocation;
+    std::vector<std::string> order(tenants);
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end()), order.end());
+    if (order.empty() || capacity <= 0) {
+        return allocation;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Buckets of idle tenants are only worth keeping until they refill
+    std::vector<Bucket*> buckets(order.size(), nullptr);
+    if (Capped()) {
+        for (auto it = buckets_.begin(); it != buckets_.end();) {
+            if (!std::binary_search(order.begin(), order.end(), it->first)) {
+                Refill(it->second, now);
+                if (it->second.tokens >= options_.burst) {
+                    it = buckets_.erase(it);
+                    continue;
+                }
+            }
+            ++it;
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            auto [it, inserted] = buckets_.try_emplace(order[i], Bucket{options_.burst, now});
+            if (!inserted) {
+                Refill(it->second, now);
+            }
+            buckets[i] = &it->second;
+        }
+    }
+
+    // Resume an interrupted turn, otherwise start after the tenant served last
+    size_t start;
+    int carry = 0;
+    auto resume = std::lower_bound(order.begin(), order.end(), resume_tenant_);
+    if (!resume_tenant_.empty() && resume != order.end() && *resume == resume_tenant_) {
+        start = static_cast<size_t>(resume - order.begin());
+        carry = resume_credit_;
+    } else {
+        start = static_cast<size_t>(std::upper_bound(order.begin(), order.end(), last_served_) - order.begin());
+        if (start == order.size()) {
+            start = 0;
+        }
+    }
+    resume_tenant_.clear();
+    resume_credit_ = 0;
+
+    std::vector<int> granted(order.size(), 0);
+    int remaining = capacity;
+    bool throttled = false;
+    for (bool first = true, progress = true; remaining > 0 && progress;) {
+        progress = false;
+        for (size_t k = 0; k < order.size() && remaining > 0; ++k) {
+            size_t i = (start + k) % order.size();
+            int credit = first && carry > 0 ? carry : options_.quantum;
+            first = false;
+
+            int allowed = credit;
+            if (buckets[i]) {
+                int tokens = static_cast<int>(std::min<double>(buckets[i]->tokens, credit));
+                if (tokens < credit) {
+                    throttled = true;
+                }
+                allowed = tokens;
+            }
+            if (allowed <= 0) {
+                continue;
+            }
+
+            int grant = std::min(allowed, remaining);
+            granted[i] += grant;
+            remaining -= grant;
+            if (buckets[i]) {
+                buckets[i]->tokens -= grant;
+            }
+            last_served_ = order[i];
+            progress = true;
+
+            if (remaining == 0 && grant < allowed) {
+                resume_tenant_ = order[i];
+                resume_credit_ = allowed - grant;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (granted[i] > 0) {
+            allocation.quotas.emplace_back(order[i], granted[i]);
+        }
+    }
+
+    // Capacity left over because of the caps: report when the next token lands
+    if (throttled && remaining > 0) {
+        double wait_s = 0;
+        for (Bucket* bucket : buckets) {
+            if (bucket->tokens < 1) {
+                double until = (1 - bucket->tokens) / options_.rate_per_second;
+                wait_s = wait_s == 0 ? until : std::min(wait_s, until);
+            }
+        }
+        allocation.throttled_for = std::chrono::milliseconds(
+            std::max<int64_t>(1, static_cast<int64_t>(std::ceil(wait_s * 1000))));
+    }
+
+    return allocation;
+}
+
+void TenantFairScheduler::Refund(const std::string& tenant, int unused) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (resume_tenant_ == tenant) {
+        resume_tenant_.clear();
+        resume_credit_ = 0;
+    }
+    auto it = buckets_.find(tenant);
+    if (it != buckets_.end() && unused > 0) {
+        it->second.tokens = std::min(options_.burst, it->second.tokens + unused);
+    }
+}
+
+} // namespace common
+} // namespace saasforge
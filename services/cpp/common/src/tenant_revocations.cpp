@@ -0,0 +1,133 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tenant-wide session revocation epochs, mirrored on every replica implementation
+ */
+
+#include "common/tenant_revocations.h"
+#include "common/logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// KEYS[1] = revocation hash, ARGV = tenant_id, revoked_at ms, channel
+constexpr const char* REVOKE_LUA = R"(
+redis.call('HSET', KEYS[1], ARGV[1], ARGV[2])
+redis.call('PUBLISH', ARGV[3], ARGV[1] .. ' ' .. ARGV[2])
+return 1
+)";
+
+// KEYS[1] = revocation hash, ARGV[1] = cutoff ms
+// Drops entries older than the cutoff; returns the others as {tenant_id, revoked_at, ...}
+constexpr const char* LOAD_LUA = R"(
+local entries = redis.call('HGETALL', KEYS[1])
+local live = {}
+for i = 1, #entries, 2 do
+    if tonumber(entries[i + 1]) < tonumber(ARGV[1]) then
+        redis.call('HDEL', KEYS[1], entries[i])
+    else
+        live[#live + 1] = entries[i]
+        live[#live + 1] = entries[i + 1]
+    end
+end
+return live
+)";
+
+} // namespace
+
+TenantRevocations::TenantRevocations(std::shared_ptr<RedisClient> redis_client, int64_t retention_seconds)
+    : redis_client_(std::move(redis_client)),
+      retention_ms_(retention_seconds * 1000) {
+    if (!redis_client_) {
+        return;
+    }
+
+    // Load now so the process starts enforcing before the subscriber connects
+    Reload();
+
+    // Each (re)subscribe reloads the hash, since messages may have been missed
+    subscription_ = redis_client_->Subscribe(
+        CHANNEL,
+        [this](const std::string& message) {
+            size_t space = message.rfind(' ');
+            if (space == std::string::npos || space == 0) {
+                return;
+            }
+            Note(message.substr(0, space), std::strtoll(message.c_str() + space + 1, nullptr, 10));
+        },
+        [this]() { Reload(); }
+    );
+}
+
+TenantRevocations::~TenantRevocations() {
+    if (subscription_ != 0) {
+        redis_client_->Unsubscribe(subscription_);
+    }
+}
+
+int64_t TenantRevocations::Revoke(const std::string& tenant_id) {
+    int64_t now = NowMillis();
+    if (redis_client_) {
+        std::string revoked_at = std::to_string(now);
+        redis_client_->EvalScript(REVOKE_LUA, {KEY}, {tenant_id, revoked_at, CHANNEL});
+    }
+    Note(tenant_id, now);
+    return now;
+}
+
+bool TenantRevocations::IsRevoked(std::string_view tenant_id, int64_t issued_at_ms) const {
+    if (empty_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = revoked_at_.find(std::string(tenant_id));
+    return it != revoked_at_.end() && issued_at_ms <= it->second;
+}
+
+void TenantRevocations::Note(const std::string& tenant_id, int64_t revoked_at_ms) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    int64_t& revoked_at = revoked_at_[tenant_id];
+    if (revoked_at_ms > revoked_at) {
+        revoked_at = revoked_at_ms;
+    }
+    empty_.store(false, std::memory_order_release);
+}
+
+size_t TenantRevocations::Size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return revoked_at_.size();
+}
+
+int64_t TenantRevocations::NowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void TenantRevocations::Reload() {
+    try {
+        std::string cutoff = std::to_string(NowMillis() - retention_ms_);
+        auto entries = redis_client_->EvalScriptStrings(LOAD_LUA, {KEY}, {cutoff});
+
+        std::unordered_map<std::string, int64_t> loaded;
+        for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+            if (entries[i] && entries[i + 1]) {
+                loaded[*entries[i]] = std::strtoll(entries[i + 1]->c_str(), nullptr, 10);
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        revoked_at_ = std::move(loaded);
+        empty_.store(revoked_at_.empty(), std::memory_order_release);
+    } catch (const std::exception& e) {
+        // Keep what we have; the next (re)subscribe retries
+        LogWarn("Failed to load tenant session revocations", {{"error", e.what()}});
+    }
+}
+
+} // namespace common
+} // namespace saasforge
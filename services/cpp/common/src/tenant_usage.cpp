@@ -0,0 +1,241 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-tenant CPU, database and Redis accounting in heavy-hitter sketches implementation
+ */
+
+#include "common/tenant_usage.h"
+#include "common/env.h"
+#include "common/metrics.h"
+#include "common/tenant_context.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+thread_local TenantUsageScope* current_scope = nullptr;
+
+struct ResourceMetric {
+    const char* name;
+    const char* help;
+    double scale;   // Exported value per unit
+};
+
+constexpr ResourceMetric RESOURCE_METRICS[TENANT_RESOURCE_COUNT] = {
+    {"saasforge_tenant_cpu_seconds", "Handler CPU time of the heaviest tenants in the last window", 1e-6},
+    {"saasforge_tenant_db_seconds", "Query time of the heaviest tenants in the last window", 1e-6},
+    {"saasforge_tenant_db_rows", "Rows returned to the heaviest tenants in the last window", 1.0},
+    {"saasforge_tenant_redis_ops", "Redis round trips of the heaviest tenants in the last window", 1.0},
+};
+
+uint64_t ThreadCpuMicros() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+} // namespace
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {
+    // Never reallocated, so index_ can view the keys in place
+    entries_.reserve(capacity_);
+    index_.reserve(capacity_);
+}
+
+void SpaceSaving::Add(std::string_view key, uint64_t weight) {
+    total_ += weight;
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        Entry& entry = entries_[it->second];
+        by_count_.erase({entry.count, it->second});
+        entry.count += weight;
+        by_count_.emplace(entry.count, it->second);
+        return;
+    }
+
+    if (entries_.size() < capacity_) {
+        size_t slot = entries_.size();
+        Entry& entry = entries_.emplace_back();
+        entry.key.assign(key);
+        entry.count = weight;
+        index_.emplace(entry.key, slot);
+        by_count_.emplace(entry.count, slot);
+        return;
+    }
+
+    // Evict the smallest; the newcomer may have had up to its count already
+    size_t slot = by_count_.begin()->second;
+    Entry& entry = entries_[slot];
+    by_count_.erase(by_count_.begin());
+    index_.erase(entry.key);
+    entry.key.assign(key);
+    entry.error = entry.count;
+    entry.count += weight;
+    index_.emplace(entry.key, slot);
+    by_count_.emplace(entry.count, slot);
+}
+
+std::vector<SpaceSaving::Entry> SpaceSaving::Top(size_t n) const {
+    std::vector<Entry> top;
+    top.reserve(std::min(n, entries_.size()));
+    for (auto it = by_count_.rbegin(); it != by_count_.rend() && top.size() < n; ++it) {
+        top.push_back(entries_[it->second]);
+    }
+    return top;
+}
+
+uint64_t SpaceSaving::Estimate(std::string_view key) const {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        return entries_[it->second].count;
+    }
+    return entries_.size() < capacity_ || by_count_.empty() ? 0 : by_count_.begin()->first;
+}
+
+void SpaceSaving::Clear() {
+    total_ = 0;
+    index_.clear();
+    by_count_.clear();
+    entries_.clear();
+}
+
+TenantUsageOptions TenantUsageOptions::FromEnv() {
+    TenantUsageOptions options;
+    options.capacity = static_cast<size_t>(std::max(1L,
+        EnvInt("TENANT_USAGE_CAPACITY", static_cast<long>(options.capacity))));
+    options.top = static_cast<size_t>(EnvInt("TENANT_USAGE_TOP", static_cast<long>(options.top)));
+    options.window = std::chrono::seconds(
+        std::max(1L, EnvInt("TENANT_USAGE_WINDOW_S", static_cast<long>(options.window.count()))));
+    return options;
+}
+
+TenantUsage& TenantUsage::Global() {
+    // Leaked, like the other process-wide registries: scopes may still close during static destruction
+    static TenantUsage* usage = [] {
+        auto* instance = new TenantUsage(TenantUsageOptions::FromEnv());
+        instance->ExportMetrics();
+        return instance;
+    }();
+    return *usage;
+}
+
+TenantUsage::TenantUsage(const TenantUsageOptions& options)
+    : options_(options), window_start_(std::chrono::steady_clock::now()) {
+    options_.capacity = std::max<size_t>(options_.capacity, 1);
+    options_.top = std::min(options_.top, options_.capacity);
+    if (options_.window.count() <= 0) {
+        options_.window = std::chrono::seconds(60);
+    }
+    current_.reserve(TENANT_RESOURCE_COUNT);
+    previous_.reserve(TENANT_RESOURCE_COUNT);
+    for (size_t i = 0; i < TENANT_RESOURCE_COUNT; ++i) {
+        current_.emplace_back(options_.capacity);
+        previous_.emplace_back(options_.capacity);
+    }
+}
+
+void TenantUsage::ExportMetrics() {
+    MetricsRegistry::Global().AddCollector([this](MetricsWriter& writer) {
+        for (size_t i = 0; i < TENANT_RESOURCE_COUNT; ++i) {
+            const auto& metric = RESOURCE_METRICS[i];
+            for (const auto& entry : Top(static_cast<TenantResource>(i), options_.top)) {
+                writer.AddGauge(metric.name, metric.help, {{"tenant_id", entry.key}},
+                                static_cast<double>(entry.count) * metric.scale);
+            }
+        }
+    });
+}
+
+void TenantUsage::Rotate(std::chrono::steady_clock::time_point now) const {
+    if (now - window_start_ < options_.window) {
+        return;
+    }
+    bool skipped = now - window_start_ >= 2 * options_.window;   // Idle for a whole window
+    for (size_t i = 0; i < TENANT_RESOURCE_COUNT; ++i) {
+        std::swap(previous_[i], current_[i]);
+        current_[i].Clear();
+        if (skipped) {
+            previous_[i].Clear();
+        }
+    }
+    auto windows = (now - window_start_) / options_.window;
+    window_start_ += windows * options_.window;
+}
+
+void TenantUsage::Record(std::string_view tenant_id, const TenantUsageSample& sample) {
+    if (tenant_id.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Rotate(std::chrono::steady_clock::now());
+    for (size_t i = 0; i < TENANT_RESOURCE_COUNT; ++i) {
+        if (sample.values[i] != 0) {
+            current_[i].Add(tenant_id, sample.values[i]);
+        }
+    }
+}
+
+std::vector<SpaceSaving::Entry> TenantUsage::Top(TenantResource resource, size_t n) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Rotate(std::chrono::steady_clock::now());
+    return previous_[static_cast<size_t>(resource)].Top(n);
+}
+
+uint64_t TenantUsage::Estimate(TenantResource resource, std::string_view tenant_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Rotate(std::chrono::steady_clock::now());
+    return previous_[static_cast<size_t>(resource)].Estimate(tenant_id);
+}
+
+double TenantUsage::Share(TenantResource resource, std::string_view tenant_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Rotate(std::chrono::steady_clock::now());
+    const auto& sketch = previous_[static_cast<size_t>(resource)];
+    if (sketch.Total() == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(sketch.Estimate(tenant_id)) / static_cast<double>(sketch.Total());
+}
+
+void TenantUsage::ChargeDb(std::chrono::nanoseconds elapsed, uint64_t rows) {
+    if (auto* scope = current_scope) {
+        scope->Charge(TenantResource::DB_MICROS,
+                      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        scope->Charge(TenantResource::DB_ROWS, rows);
+    }
+}
+
+void TenantUsage::ChargeRedis(uint64_t ops) {
+    if (auto* scope = current_scope) {
+        scope->Charge(TenantResource::REDIS_OPS, ops);
+    }
+}
+
+TenantUsageScope::TenantUsageScope(grpc::ServerContextBase* context, TenantUsage& usage)
+    : TenantUsageScope(context ? TenantContextInterceptor::ForCall(context)->tenant_id : std::string(), usage) {}
+
+TenantUsageScope::TenantUsageScope(std::string tenant_id, TenantUsage& usage)
+    : usage_(usage), tenant_id_(std::move(tenant_id)), previous_(current_scope), cpu_start_(ThreadCpuMicros()) {
+    current_scope = this;
+}
+
+TenantUsageScope::~TenantUsageScope() {
+    current_scope = previous_;
+    uint64_t cpu = ThreadCpuMicros() - cpu_start_;
+    if (previous_) {
+        previous_->nested_cpu_ += cpu;
+    }
+    sample_[TenantResource::CPU_MICROS] += cpu - std::min(cpu, nested_cpu_);
+    usage_.Record(tenant_id_, sample_);
+}
+
+TenantUsageScope* TenantUsageScope::Current() {
+    return current_scope;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -5,19 +5,90 @@
  */
 
 #include "common/totp_helper.h"
-#include <openssl/hmac.h>
-#include <openssl/sha.h>
+#include "common/codec.h"
+#include "common/sha256.h"
+#include "common/tracing.h"
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <array>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
-#include <cmath>
 #include <stdexcept>
 
 namespace saasforge {
 namespace common {
 
+namespace {
+
+// EVP_MAC_fetch() walks the provider registry; do it once per process
+EVP_MAC* HmacAlgorithm() {
+    static EVP_MAC* mac = EVP_MAC_fetch(nullptr, OSSL_MAC_NAME_HMAC, nullptr);
+    return mac;
+}
+
+/// HMAC-SHA1 keyed once; each Truncated() call reuses the precomputed pads
+class TotpKey {
+public:
+    explicit TotpKey(const std::vector<uint8_t>& key) {
+        EVP_MAC* mac = HmacAlgorithm();
+        ctx_ = mac ? EVP_MAC_CTX_new(mac) : nullptr;
+        if (!ctx_) {
+            throw std::runtime_error("Failed to create HMAC context");
+        }
+
+        char digest[] = "SHA1";
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+            OSSL_PARAM_construct_end()
+        };
+        // A null key would mean "keep the previous key"; pass a valid pointer for empty secrets
+        static const unsigned char kEmptyKey = 0;
+        if (EVP_MAC_init(ctx_, key.empty() ? &kEmptyKey : key.data(), key.size(), params) != 1) {
+            EVP_MAC_CTX_free(ctx_);
+            throw std::runtime_error("Failed to initialize HMAC key");
+        }
+    }
+
+    ~TotpKey() {
+        EVP_MAC_CTX_free(ctx_);
+    }
+
+    TotpKey(const TotpKey&) = delete;
+    TotpKey& operator=(const TotpKey&) = delete;
+
+    /// RFC 4226 dynamic truncation of HMAC(key, counter), before the modulus
+    uint32_t Truncated(uint64_t counter) {
+        // 8-byte big-endian counter
+        unsigned char message[8];
+        for (int i = 7; i >= 0; --i) {
+            message[i] = static_cast<unsigned char>(counter & 0xFF);
+            counter >>= 8;
+        }
+
+        unsigned char hmac[EVP_MAX_MD_SIZE];
+        size_t hmac_len = 0;
+        if (EVP_MAC_init(ctx_, nullptr, 0, nullptr) != 1 ||
+            EVP_MAC_update(ctx_, message, sizeof(message)) != 1 ||
+            EVP_MAC_final(ctx_, hmac, &hmac_len, sizeof(hmac)) != 1 || hmac_len < 20) {
+            throw std::runtime_error("HMAC-SHA1 failed");
+        }
+
+        int offset = hmac[19] & 0x0F;
+        return (static_cast<uint32_t>(hmac[offset] & 0x7F) << 24)
+             | (static_cast<uint32_t>(hmac[offset + 1]) << 16)
+             | (static_cast<uint32_t>(hmac[offset + 2]) << 8)
+             | static_cast<uint32_t>(hmac[offset + 3]);
+    }
+
+private:
+    EVP_MAC_CTX* ctx_ = nullptr;
+};
+
+} // namespace
+
 std::string TotpHelper::GenerateSecret() {
     // Generate 20 random bytes (160 bits) for TOTP secret
     std::vector<uint8_t> random_bytes(20);
@@ -25,7 +96,7 @@ std::string TotpHelper::GenerateSecret() {
         throw std::runtime_error("Failed to generate random bytes for TOTP secret");
     }
 
-    return EncodeBase32(random_bytes);
+    return Base32Encode(random_bytes.data(), random_bytes.size());
 }
 
 std::string TotpHelper::GenerateQrCodeUrl(
@@ -49,33 +120,69 @@ bool TotpHelper::ValidateCode(
     const std::string& code,
     int window
 ) {
+    return VerifyCode(secret, code, window).has_value();
+}
+
+bool TotpHelper::ValidateCodeAt(
+    const std::string& secret,
+    const std::string& code,
+    int64_t unix_time,
+    int window
+) {
+    return VerifyCodeAt(secret, code, unix_time, window).has_value();
+}
+
+std::optional<uint64_t> TotpHelper::VerifyCode(
+    const std::string& secret,
+    const std::string& code,
+    int window
+) {
+    auto unix_time = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    return VerifyCodeAt(secret, code, unix_time, window);
+}
+
+std::optional<uint64_t> TotpHelper::VerifyCodeAt(
+    const std::string& secret,
+    const std::string& code,
+    int64_t unix_time,
+    int window
+) {
+    static_assert(CODE_MODULUS == 1000000 && CODE_LENGTH == 6, "CODE_MODULUS is 10^CODE_LENGTH");
+
+    Span span("totp.validate");
     if (code.length() != CODE_LENGTH) {
-        return false;
+        return std::nullopt;
     }
 
-    // Verify code contains only digits
-    if (!std::all_of(code.begin(), code.end(), ::isdigit)) {
-        return false;
+    // Digits only, compared as an integer
+    uint32_t submitted = 0;
+    for (char c : code) {
+        if (c < '0' || c > '9') {
+            return std::nullopt;
+        }
+        submitted = submitted * 10 + static_cast<uint32_t>(c - '0');
     }
 
-    // Get current time counter (Unix timestamp / 30)
-    auto now = std::chrono::system_clock::now();
-    auto unix_time = std::chrono::duration_cast<std::chrono::seconds>(
-        now.time_since_epoch()
-    ).count();
-    uint64_t current_counter = unix_time / TIME_STEP;
+    TotpKey key(DecodeBase32(secret));
 
     // Check code against current time ± window
+    uint64_t current_counter = static_cast<uint64_t>(unix_time / TIME_STEP);
     for (int i = -window; i <= window; ++i) {
-        uint64_t test_counter = current_counter + i;
-        std::string expected_code = GenerateTotpCode(secret, test_counter);
-
-        if (code == expected_code) {
-            return true;
+        uint64_t counter = current_counter + i;
+        if (key.Truncated(counter) % CODE_MODULUS == submitted) {
+            return counter;
         }
     }
 
-    return false;
+    return std::nullopt;
+}
+
+int64_t TotpHelper::ReplayWindowSeconds(int window) {
+    // A step's code is accepted from window steps before it begins until
+    // window steps after it ends
+    return static_cast<int64_t>(2 * std::max(window, 0) + 1) * TIME_STEP;
 }
 
 std::vector<std::string> TotpHelper::GenerateBackupCodes(int count) {
@@ -108,18 +215,7 @@ std::vector<std::string> TotpHelper::GenerateBackupCodes(int count) {
 }
 
 std::string TotpHelper::HashBackupCode(const std::string& code) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(reinterpret_cast<const unsigned char*>(code.c_str()),
-           code.length(),
-           hash);
-
-    std::stringstream ss;
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        ss << std::hex << std::setw(2) << std::setfill('0')
-           << static_cast<int>(hash[i]);
-    }
-
-    return ss.str();
+    return Sha256::Hex(code);
 }
 
 bool TotpHelper::VerifyBackupCode(const std::string& code, const std::string& hash) {
@@ -128,108 +224,12 @@ bool TotpHelper::VerifyBackupCode(const std::string& code, const std::string& ha
 
 // Private methods
 
-std::string TotpHelper::GenerateTotpCode(const std::string& secret, uint64_t time_counter) {
-    // Decode Base32 secret to bytes
-    auto key = DecodeBase32(secret);
-
-    // Convert time counter to 8-byte big-endian array
-    std::vector<uint8_t> message(8);
-    for (int i = 7; i >= 0; --i) {
-        message[i] = time_counter & 0xFF;
-        time_counter >>= 8;
-    }
-
-    // Compute HMAC-SHA1
-    auto hmac = HmacSha1(key, message);
-
-    // Dynamic truncation (RFC 4226)
-    int offset = hmac[19] & 0x0F;
-    uint32_t code = ((hmac[offset] & 0x7F) << 24)
-                  | ((hmac[offset + 1] & 0xFF) << 16)
-                  | ((hmac[offset + 2] & 0xFF) << 8)
-                  | (hmac[offset + 3] & 0xFF);
-
-    // Generate 6-digit code
-    code = code % static_cast<uint32_t>(std::pow(10, CODE_LENGTH));
-
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(CODE_LENGTH) << code;
-    return ss.str();
-}
-
 std::vector<uint8_t> TotpHelper::DecodeBase32(const std::string& base32) {
-    static const std::string base32_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
-    std::vector<uint8_t> result;
-
-    int buffer = 0;
-    int bits_left = 0;
-
-    for (char c : base32) {
-        if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '-') {
-            continue;  // Skip whitespace and hyphens
-        }
-
-        // Find character in base32 alphabet
-        size_t value = base32_chars.find(std::toupper(c));
-        if (value == std::string::npos) {
-            throw std::invalid_argument("Invalid Base32 character: " + std::string(1, c));
-        }
-
-        buffer = (buffer << 5) | value;
-        bits_left += 5;
-
-        if (bits_left >= 8) {
-            result.push_back((buffer >> (bits_left - 8)) & 0xFF);
-            bits_left -= 8;
-        }
-    }
-
-    return result;
-}
-
-std::string TotpHelper::EncodeBase32(const std::vector<uint8_t>& data) {
-    static const std::string base32_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
-    std::string result;
-
-    int buffer = 0;
-    int bits_left = 0;
-
-    for (uint8_t byte : data) {
-        buffer = (buffer << 8) | byte;
-        bits_left += 8;
-
-        while (bits_left >= 5) {
-            result += base32_chars[(buffer >> (bits_left - 5)) & 0x1F];
-            bits_left -= 5;
-        }
+    auto bytes = Base32Decode(base32);
+    if (!bytes) {
+        throw std::invalid_argument("Invalid Base32 secret");
     }
-
-    // Handle remaining bits
-    if (bits_left > 0) {
-        result += base32_chars[(buffer << (5 - bits_left)) & 0x1F];
-    }
-
-    // Add padding (optional for TOTP, but standard Base32 includes it)
-    while (result.length() % 8 != 0) {
-        result += '=';
-    }
-
-    return result;
-}
-
-std::vector<uint8_t> TotpHelper::HmacSha1(
-    const std::vector<uint8_t>& key,
-    const std::vector<uint8_t>& message
-) {
-    unsigned char result[EVP_MAX_MD_SIZE];
-    unsigned int result_len = 0;
-
-    HMAC(EVP_sha1(),
-         key.data(), key.size(),
-         message.data(), message.size(),
-         result, &result_len);
-
-    return std::vector<uint8_t>(result, result + result_len);
+    return std::move(*bytes);
 }
 
 std::string TotpHelper::UrlEncode(const std::string& str) {
@@ -0,0 +1,575 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Request tracing with W3C traceparent propagation, tail sampling and batched OTLP export
+ */
+
+#include "common/tracing.h"
+#include "common/codec.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/string_builder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <curl/curl.h>
+#include <random>
+#include <stdexcept>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr long EXPORT_TIMEOUT_MS = 5000;
+
+// Current span of this thread
+thread_local TraceContext current_context;
+
+std::mt19937_64& Random() {
+    thread_local std::mt19937_64 generator(std::random_device{}() ^
+        static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
+    return generator;
+}
+
+template <size_t N>
+void RandomId(std::array<uint8_t, N>& id) {
+    do {
+        for (size_t i = 0; i < N; i += 8) {
+            uint64_t bits = Random()();
+            std::memcpy(id.data() + i, &bits, std::min<size_t>(8, N - i));
+        }
+    } while (std::all_of(id.begin(), id.end(), [](uint8_t b) { return b == 0; }));
+}
+
+template <size_t N>
+std::string ToHex(const std::array<uint8_t, N>& id) {
+    return HexEncode(id.data(), N);
+}
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;   // Upper case is invalid in traceparent
+}
+
+template <size_t N>
+bool FromHex(std::string_view text, std::array<uint8_t, N>& id) {
+    if (text.size() != N * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < N; ++i) {
+        int high = HexDigit(text[2 * i]);
+        int low = HexDigit(text[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        id[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+template <size_t N>
+bool IsZero(const std::array<uint8_t, N>& id) {
+    return std::all_of(id.begin(), id.end(), [](uint8_t b) { return b == 0; });
+}
+
+int64_t UnixNanos(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void AppendAttribute(std::string& out, std::string_view key, std::string_view value) {
+    out += "{\"key\":";
+    AppendJsonString(out, key);
+    out += ",\"value\":{\"stringValue\":";
+    AppendJsonString(out, value);
+    out += "}}";
+}
+
+size_t DiscardBody(char*, size_t size, size_t count, void*) {
+    return size * count;
+}
+
+// POSTs each batch to <endpoint>/v1/traces, reusing one connection
+class OtlpHttpExporter {
+public:
+    OtlpHttpExporter(std::string endpoint, std::string service_name)
+        : url_(std::move(endpoint)), service_name_(std::move(service_name)) {
+        while (!url_.empty() && url_.back() == '/') {
+            url_.pop_back();
+        }
+        url_ += "/v1/traces";
+        static std::once_flag curl_init_once;
+        std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    }
+
+    ~OtlpHttpExporter() {
+        if (easy_) {
+            curl_easy_cleanup(easy_);
+        }
+    }
+
+    // Only ever called from the tracer's export path, one batch at a time
+    void operator()(const std::vector<SpanData>& spans) {
+        std::string body = Tracer::ToOtlpJson(spans, service_name_);
+
+        if (!easy_) {
+            easy_ = curl_easy_init();
+            if (!easy_) {
+                throw std::runtime_error("curl_easy_init failed");
+            }
+        } else {
+            curl_easy_reset(easy_);
+        }
+
+        curl_slist* headers = nullptr;
+        headers = curl_slist_append(headers, "Content-Type: application/json");
+        headers = curl_slist_append(headers, "Expect:");
+        char error[CURL_ERROR_SIZE] = {0};
+
+        curl_easy_setopt(easy_, CURLOPT_URL, url_.c_str());
+        curl_easy_setopt(easy_, CURLOPT_POST, 1L);
+        curl_easy_setopt(easy_, CURLOPT_POSTFIELDS, body.data());
+        curl_easy_setopt(easy_, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+        curl_easy_setopt(easy_, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(easy_, CURLOPT_WRITEFUNCTION, DiscardBody);
+        curl_easy_setopt(easy_, CURLOPT_ERRORBUFFER, error);
+        curl_easy_setopt(easy_, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy_, CURLOPT_TIMEOUT_MS, EXPORT_TIMEOUT_MS);
+        curl_easy_setopt(easy_, CURLOPT_TCP_KEEPALIVE, 1L);
+
+        CURLcode result = curl_easy_perform(easy_);
+        long status = 0;
+        curl_easy_getinfo(easy_, CURLINFO_RESPONSE_CODE, &status);
+        curl_slist_free_all(headers);
+
+        if (result != CURLE_OK) {
+            throw std::runtime_error(std::string("OTLP export failed: ") +
+                                     (error[0] ? error : curl_easy_strerror(result)));
+        }
+        if (status < 200 || status >= 300) {
+            throw std::runtime_error("OTLP export rejected with HTTP " + std::to_string(status));
+        }
+    }
+
+private:
+    std::string url_;
+    std::string service_name_;
+    CURL* easy_ = nullptr;
+};
+
+Tracer::Exporter MakeOtlpExporter(const TracerOptions& options) {
+    if (options.otlp_endpoint.empty()) {
+        return {};
+    }
+    auto exporter = std::make_shared<OtlpHttpExporter>(options.otlp_endpoint, options.service_name);
+    return [exporter](const std::vector<SpanData>& spans) { (*exporter)(spans); };
+}
+
+} // namespace
+
+bool SpanContext::IsValid() const {
+    return !IsZero(trace_id) && !IsZero(span_id);
+}
+
+std::string SpanContext::TraceIdHex() const {
+    return ToHex(trace_id);
+}
+
+std::string SpanContext::SpanIdHex() const {
+    return ToHex(span_id);
+}
+
+std::string SpanContext::ToTraceparent() const {
+    return "00-" + ToHex(trace_id) + "-" + ToHex(span_id) + (sampled ? "-01" : "-00");
+}
+
+std::optional<SpanContext> SpanContext::FromTraceparent(std::string_view header) {
+    // version(2) - trace id(32) - parent id(16) - flags(2); later versions may append fields
+    if (header.size() < 55 || header[2] != '-' || header[35] != '-' || header[52] != '-') {
+        return std::nullopt;
+    }
+    std::array<uint8_t, 1> version{};
+    std::array<uint8_t, 1> flags{};
+    SpanContext context;
+    if (!FromHex(header.substr(0, 2), version) || version[0] == 0xff ||
+        !FromHex(header.substr(3, 32), context.trace_id) ||
+        !FromHex(header.substr(36, 16), context.span_id) ||
+        !FromHex(header.substr(53, 2), flags)) {
+        return std::nullopt;
+    }
+    if ((version[0] == 0 && header.size() != 55) || (header.size() > 55 && header[55] != '-')) {
+        return std::nullopt;
+    }
+    if (!context.IsValid()) {
+        return std::nullopt;
+    }
+    context.sampled = (flags[0] & 0x01) != 0;
+    return context;
+}
+
+TraceContext TraceContext::Current() {
+    return current_context;
+}
+
+SpanContext TraceContext::GetSpanContext() const {
+    SpanContext context;
+    if (trace_) {
+        context.trace_id = trace_->trace_id;
+        context.span_id = span_id_;
+        context.sampled = trace_->sampled;
+    }
+    return context;
+}
+
+ScopedTraceContext::ScopedTraceContext(TraceContext context) : previous_(std::move(current_context)) {
+    current_context = std::move(context);
+}
+
+ScopedTraceContext::~ScopedTraceContext() {
+    current_context = std::move(previous_);
+}
+
+Span::Span(std::string_view name, SpanKind kind) {
+    if (!current_context.trace_) {
+        return;
+    }
+    trace_ = current_context.trace_;
+    data_.name = std::string(name);
+    data_.kind = kind;
+    data_.trace_id = trace_->trace_id;
+    data_.parent_span_id = current_context.span_id_;
+    RandomId(data_.span_id);
+    data_.start_unix_nano = UnixNanos(std::chrono::system_clock::now());
+    start_ = std::chrono::steady_clock::now();
+
+    previous_ = std::move(current_context);
+    current_context = TraceContext(trace_, data_.span_id);
+    activated_ = true;
+}
+
+Span::~Span() {
+    End();
+}
+
+Span::Span(Span&& other) noexcept
+    : trace_(std::move(other.trace_)),
+      data_(std::move(other.data_)),
+      start_(other.start_),
+      root_(other.root_),
+      activated_(other.activated_),
+      previous_(std::move(other.previous_)) {
+    other.trace_.reset();
+    other.activated_ = false;
+}
+
+Span& Span::operator=(Span&& other) noexcept {
+    if (this != &other) {
+        End();
+        trace_ = std::move(other.trace_);
+        data_ = std::move(other.data_);
+        start_ = other.start_;
+        root_ = other.root_;
+        activated_ = other.activated_;
+        previous_ = std::move(other.previous_);
+        other.trace_.reset();
+        other.activated_ = false;
+    }
+    return *this;
+}
+
+void Span::SetAttribute(std::string_view key, std::string_view value) {
+    if (trace_) {
+        data_.attributes.emplace_back(std::string(key), std::string(value));
+    }
+}
+
+void Span::SetAttribute(std::string_view key, int64_t value) {
+    if (trace_) {
+        data_.attributes.emplace_back(std::string(key), std::to_string(value));
+    }
+}
+
+void Span::SetError(std::string_view message) {
+    if (trace_) {
+        data_.error = true;
+        data_.status_message = std::string(message);
+    }
+}
+
+TraceContext Span::Context() const {
+    return trace_ ? TraceContext(trace_, data_.span_id) : TraceContext();
+}
+
+void Span::End() {
+    if (!trace_) {
+        return;
+    }
+    auto duration = std::chrono::steady_clock::now() - start_;
+    data_.end_unix_nano = data_.start_unix_nano +
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+    if (activated_) {
+        current_context = std::move(previous_);
+        activated_ = false;
+    }
+
+    std::shared_ptr<tracing_detail::TraceState> trace = std::move(trace_);
+    trace_.reset();
+    Tracer& tracer = *trace->tracer;
+
+    if (root_) {
+        tracer.FinishTrace(*trace, data_, std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(trace->mutex);
+    trace->error = trace->error || data_.error;
+    if (trace->finished) {
+        // Outlived its root (e.g. work still running after the RPC completed)
+        bool kept = trace->kept;
+        lock.unlock();
+        if (kept) {
+            tracer.Enqueue({std::move(data_)});
+        }
+        return;
+    }
+    if (trace->spans.size() >= tracer.options_.max_spans_per_trace) {
+        tracer.spans_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    trace->spans.push_back(std::move(data_));
+}
+
+TracerOptions TracerOptions::FromEnv() {
+    TracerOptions options;
+    options.otlp_endpoint = EnvString("OTEL_EXPORTER_OTLP_ENDPOINT", options.otlp_endpoint);
+    options.service_name = EnvString("OTEL_SERVICE_NAME", options.service_name);
+    options.sample_ratio = EnvRatio("TRACE_SAMPLE_RATIO", options.sample_ratio);
+    options.slow_threshold = std::chrono::milliseconds(
+        EnvInt("TRACE_SLOW_MS", static_cast<long>(options.slow_threshold.count())));
+    options.max_spans_per_trace = static_cast<size_t>(
+        EnvInt("TRACE_MAX_SPANS_PER_TRACE", static_cast<long>(options.max_spans_per_trace)));
+    options.queue_capacity = static_cast<size_t>(
+        std::max<long>(EnvInt("TRACE_QUEUE_CAPACITY", static_cast<long>(options.queue_capacity)), 1));
+    options.flush_interval = std::chrono::milliseconds(
+        std::max<long>(EnvInt("TRACE_FLUSH_INTERVAL_MS", static_cast<long>(options.flush_interval.count())), 1));
+    return options;
+}
+
+Tracer::Tracer(const TracerOptions& options) : Tracer(options, MakeOtlpExporter(options)) {}
+
+Tracer::Tracer(const TracerOptions& options, Exporter exporter)
+    : options_(options), exporter_(std::move(exporter)) {
+    if (exporter_) {
+        thread_ = std::thread(&Tracer::ExportLoop, this);
+    }
+}
+
+Tracer::~Tracer() {
+    Shutdown();
+}
+
+Tracer& Tracer::Global() {
+    // Never destroyed, like Logger::Global(); flushed at exit
+    static Tracer* tracer = [] {
+        auto* instance = new Tracer(TracerOptions::FromEnv());
+        std::atexit([] { Tracer::Global().Shutdown(); });
+        return instance;
+    }();
+    return *tracer;
+}
+
+bool Tracer::HeadSample(const TraceId& trace_id) const {
+    if (options_.sample_ratio >= 1.0) {
+        return true;
+    }
+    // Random trace ids make the low 8 bytes uniform; deterministic per trace
+    uint64_t value = 0;
+    for (size_t i = 8; i < 16; ++i) {
+        value = (value << 8) | trace_id[i];
+    }
+    return static_cast<double>(value) < options_.sample_ratio * 18446744073709551616.0;
+}
+
+Span Tracer::StartServerSpan(std::string_view name, std::string_view traceparent) {
+    Span span;
+    if (!Enabled()) {
+        return span;
+    }
+
+    auto trace = std::make_shared<tracing_detail::TraceState>();
+    trace->tracer = this;
+    auto parent = SpanContext::FromTraceparent(traceparent);
+    if (parent) {
+        trace->trace_id = parent->trace_id;
+        trace->sampled = parent->sampled;
+        span.data_.parent_span_id = parent->span_id;
+    } else {
+        RandomId(trace->trace_id);
+        trace->sampled = HeadSample(trace->trace_id);
+    }
+    traces_started_.fetch_add(1, std::memory_order_relaxed);
+
+    span.trace_ = std::move(trace);
+    span.root_ = true;
+    span.data_.name = std::string(name);
+    span.data_.kind = SpanKind::kServer;
+    span.data_.trace_id = span.trace_->trace_id;
+    RandomId(span.data_.span_id);
+    span.data_.start_unix_nano = UnixNanos(std::chrono::system_clock::now());
+    span.start_ = std::chrono::steady_clock::now();
+    return span;
+}
+
+void Tracer::FinishTrace(tracing_detail::TraceState& trace, const SpanData& root, std::chrono::nanoseconds duration) {
+    std::vector<SpanData> spans;
+    {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.error = trace.error || root.error;
+        bool slow = options_.slow_threshold.count() > 0 && duration >= options_.slow_threshold;
+        trace.kept = trace.sampled || slow || (options_.keep_errors && trace.error);
+        trace.finished = true;
+        if (!trace.kept) {
+            trace.spans.clear();
+            return;
+        }
+        spans = std::move(trace.spans);
+        trace.spans.clear();
+    }
+    spans.push_back(root);
+    traces_kept_.fetch_add(1, std::memory_order_relaxed);
+    Enqueue(std::move(spans));
+}
+
+void Tracer::Enqueue(std::vector<SpanData> spans) {
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        // After shutdown nothing drains the queue
+        if (shutdown_ || queue_.size() >= options_.queue_capacity) {
+            traces_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        queue_.push_back(std::move(spans));
+        notify = queue_.size() >= options_.batch_size;
+    }
+    if (notify) {
+        queue_cv_.notify_one();
+    }
+}
+
+void Tracer::ExportLoop() {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while (!shutdown_) {
+        queue_cv_.wait_for(lock, options_.flush_interval, [this] {
+            return shutdown_ || queue_.size() >= options_.batch_size;
+        });
+        lock.unlock();
+        ExportPending();
+        lock.lock();
+    }
+}
+
+void Tracer::Flush() {
+    ExportPending();
+}
+
+void Tracer::ExportPending() {
+    std::lock_guard<std::mutex> export_lock(export_mutex_);
+    while (true) {
+        std::vector<SpanData> batch;
+        size_t traces = 0;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            for (; traces < options_.batch_size && !queue_.empty(); ++traces) {
+                auto& spans = queue_.front();
+                std::move(spans.begin(), spans.end(), std::back_inserter(batch));
+                queue_.pop_front();
+            }
+        }
+        if (traces == 0) {
+            return;
+        }
+
+        try {
+            exporter_(batch);
+            spans_exported_.fetch_add(batch.size(), std::memory_order_relaxed);
+        } catch (const std::exception& e) {
+            export_failures_.fetch_add(1, std::memory_order_relaxed);
+            LogWarn("Trace export failed", {{"spans", batch.size()}, {"error", e.what()}});
+        }
+    }
+}
+
+void Tracer::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+    }
+    queue_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (exporter_) {
+        ExportPending();
+    }
+}
+
+TracerStats Tracer::GetStats() const {
+    TracerStats stats;
+    stats.traces_started = traces_started_.load(std::memory_order_relaxed);
+    stats.traces_kept = traces_kept_.load(std::memory_order_relaxed);
+    stats.traces_dropped = traces_dropped_.load(std::memory_order_relaxed);
+    stats.spans_exported = spans_exported_.load(std::memory_order_relaxed);
+    stats.spans_dropped = spans_dropped_.load(std::memory_order_relaxed);
+    stats.export_failures = export_failures_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::string Tracer::ToOtlpJson(const std::vector<SpanData>& spans, const std::string& service_name) {
+    std::string out;
+    out.reserve(256 + spans.size() * 320);
+    out += "{\"resourceSpans\":[{\"resource\":{\"attributes\":[";
+    AppendAttribute(out, "service.name", service_name);
+    out += "]},\"scopeSpans\":[{\"scope\":{\"name\":\"saasforge\"},\"spans\":[";
+
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const SpanData& span = spans[i];
+        if (i > 0) {
+            out.push_back(',');
+        }
+        out += "{\"traceId\":\"" + ToHex(span.trace_id) + "\",\"spanId\":\"" + ToHex(span.span_id) + "\"";
+        if (!IsZero(span.parent_span_id)) {
+            out += ",\"parentSpanId\":\"" + ToHex(span.parent_span_id) + "\"";
+        }
+        out += ",\"name\":";
+        AppendJsonString(out, span.name);
+        out += ",\"kind\":" + std::to_string(static_cast<int>(span.kind));
+        // 64-bit integers are strings in OTLP/JSON
+        out += ",\"startTimeUnixNano\":\"" + std::to_string(span.start_unix_nano) + "\"";
+        out += ",\"endTimeUnixNano\":\"" + std::to_string(span.end_unix_nano) + "\"";
+        out += ",\"attributes\":[";
+        for (size_t a = 0; a < span.attributes.size(); ++a) {
+            if (a > 0) {
+                out.push_back(',');
+            }
+            AppendAttribute(out, span.attributes[a].first, span.attributes[a].second);
+        }
+        out += "],\"status\":{";
+        if (span.error) {
+            out += "\"code\":2,\"message\":";
+            AppendJsonString(out, span.status_message);
+        }
+        out += "}}";
+    }
+    out += "]}]}]}";
+    return out;
+}
+
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,122 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description gRPC server interceptor starting a span per RPC from the incoming traceparent
+ */
+
+#include "common/tracing_interceptor.h"
+#include "common/call_slot.h"
+#include <grpcpp/grpcpp.h>
+#include <string>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+using grpc::experimental::InterceptionHookPoints;
+
+// Status codes that mean the server failed, as opposed to rejecting the request
+bool IsServerError(grpc::StatusCode code) {
+    switch (code) {
+        case grpc::StatusCode::UNKNOWN:
+        case grpc::StatusCode::DEADLINE_EXCEEDED:
+        case grpc::StatusCode::UNIMPLEMENTED:
+        case grpc::StatusCode::INTERNAL:
+        case grpc::StatusCode::UNAVAILABLE:
+        case grpc::StatusCode::DATA_LOSS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+class TracingInterceptor : public grpc::experimental::Interceptor {
+public:
+    TracingInterceptor(Tracer& tracer, grpc::experimental::ServerRpcInfo* info)
+        : tracer_(tracer), method_(info->method() ? info->method() : ""), context_(info->server_context()) {}
+
+    ~TracingInterceptor() override {
+        // Destroyed without sending a status: the client went away
+        if (span_.Recording()) {
+            span_.SetError("cancelled");
+            Finish(grpc::StatusCode::CANCELLED);
+        }
+    }
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* methods) override {
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_INITIAL_METADATA)) {
+            Start(methods->GetRecvInitialMetadata());
+        }
+        if (methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_STATUS)) {
+            grpc::Status status = methods->GetSendStatus();
+            if (IsServerError(status.error_code())) {
+                span_.SetError(status.error_message());
+            }
+            Finish(status.error_code());
+        }
+        methods->Proceed();
+    }
+
+private:
+    void Start(std::multimap<grpc::string_ref, grpc::string_ref>* metadata) {
+        std::string_view traceparent;
+        if (metadata) {
+            auto it = metadata->find("traceparent");
+            if (it != metadata->end()) {
+                traceparent = std::string_view(it->second.data(), it->second.size());
+            }
+        }
+
+        // "/saasforge.auth.AuthService/Login" -> "saasforge.auth.AuthService/Login"
+        std::string_view name(method_);
+        if (!name.empty() && name.front() == '/') {
+            name.remove_prefix(1);
+        }
+        span_ = tracer_.StartServerSpan(name, traceparent);
+        size_t slash = name.rfind('/');
+        span_.SetAttribute("rpc.system", "grpc");
+        if (slash != std::string_view::npos) {
+            span_.SetAttribute("rpc.service", name.substr(0, slash));
+            span_.SetAttribute("rpc.method", name.substr(slash + 1));
+        }
+        if (span_.Recording() && context_) {
+            CallSlot<TraceContext>::Global().Set(context_, span_.Context());
+        }
+    }
+
+    void Finish(grpc::StatusCode code) {
+        if (!span_.Recording()) {
+            return;
+        }
+        if (context_) {
+            CallSlot<TraceContext>::Global().Clear(context_);
+        }
+        span_.SetAttribute("rpc.grpc.status_code", static_cast<int64_t>(code));
+        span_.End();
+    }
+
+    Tracer& tracer_;
+    std::string method_;
+    const grpc::ServerContextBase* context_;
+    Span span_;   // Not recording until Start()
+};
+
+} // namespace
+
+TracingInterceptorFactory::TracingInterceptorFactory(Tracer& tracer) : tracer_(tracer) {}
+
+grpc::experimental::Interceptor* TracingInterceptorFactory::CreateServerInterceptor(
+    grpc::experimental::ServerRpcInfo* info) {
+    if (!tracer_.Enabled()) {
+        return nullptr;   // No interceptor at all for this RPC
+    }
+    return new TracingInterceptor(tracer_, info);
+}
+
+TraceContext ServerTraceContext(const grpc::ServerContextBase* context) {
+    return context ? CallSlot<TraceContext>::Global().Get(context) : TraceContext();
+}
+
+} // namespace common
+} // namespace saasforge
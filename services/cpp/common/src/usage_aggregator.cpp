@@ -0,0 +1,648 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Write-behind usage aggregation implementation
+ */
+
+#include "common/usage_aggregator.h"
+#include "common/statement_registry.h"
+#include "common/id_generator.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+// Marks a batch as applied; a replayed WAL segment finds its id and is skipped
+const PreparedStatement kClaimUsageBatch(
+    "usage_claim_batch",
+    "INSERT INTO usage_ingest_batches (batch_id, bucket_count) VALUES ($1, $2) "
+    "ON CONFLICT (batch_id) DO NOTHING RETURNING batch_id");
+
+// Session-local staging table for COPY (temp tables cannot be referenced by
+// statements prepared at connect time, so these run unprepared). Record ids
+// come from IdGenerator, so usage_records inserts append to its index.
+constexpr const char* kCreateStage =
+    "CREATE TEMP TABLE IF NOT EXISTS usage_ingest_stage ("
+    "  id UUID, tenant_id UUID, subscription_id UUID, metric_name TEXT, quantity BIGINT, minute TIMESTAMPTZ"
+    ") ON COMMIT DELETE ROWS";
+
+// Creates the monthly partitions (and their tenant-hash sub-partitions) of
+// the rollup tables; a no-op when they exist
+const PreparedStatement kEnsureRollupPartitions(
+    "usage_ensure_rollup_partitions",
+    "SELECT usage_rollup_ensure_partitions($1::date)");
+
+// Ownership is re-checked at write time: rows for subscriptions deleted (or
+// not owned by the tenant) since they were buffered are dropped rather than
+// failing the batch forever. The rollups are fed from the rows actually
+// inserted, so they always agree with usage_records.
+constexpr const char* kApplyStage =
+    "WITH inserted AS ("
+    "  INSERT INTO usage_records (id, tenant_id, subscription_id, metric_name, quantity, timestamp) "
+    "  SELECT st.id, st.tenant_id, st.subscription_id, st.metric_name, st.quantity, st.minute "
+    "  FROM usage_ingest_stage st "
+    "  JOIN subscriptions s ON s.id = st.subscription_id AND s.tenant_id = st.tenant_id "
+    "  RETURNING tenant_id, subscription_id, metric_name, quantity, timestamp"
+    "), minute_rollup AS ("
+    "  INSERT INTO usage_rollup_minute (tenant_id, subscription_id, metric_name, bucket_start, quantity) "
+    "  SELECT tenant_id, subscription_id, metric_name, timestamp, SUM(quantity) "
+    "  FROM inserted GROUP BY 1, 2, 3, 4 "
+    "  ON CONFLICT (tenant_id, subscription_id, metric_name, bucket_start) "
+    "  DO UPDATE SET quantity = usage_rollup_minute.quantity + EXCLUDED.quantity"
+    "), hour_rollup AS ("
+    "  INSERT INTO usage_rollup_hour (tenant_id, subscription_id, metric_name, bucket_start, quantity) "
+    "  SELECT tenant_id, subscription_id, metric_name, date_trunc('hour', timestamp, 'UTC'), SUM(quantity) "
+    "  FROM inserted GROUP BY 1, 2, 3, 4 "
+    "  ON CONFLICT (tenant_id, subscription_id, metric_name, bucket_start) "
+    "  DO UPDATE SET quantity = usage_rollup_hour.quantity + EXCLUDED.quantity"
+    "), period_rollup AS ("
+    "  INSERT INTO usage_rollup_period (tenant_id, subscription_id, metric_name, bucket_start, period_end, quantity) "
+    "  SELECT i.tenant_id, i.subscription_id, i.metric_name, p.start, p.start + INTERVAL '1 month', SUM(i.quantity) "
+    "  FROM inserted i "
+    "  JOIN subscriptions s ON s.id = i.subscription_id "
+    "  CROSS JOIN LATERAL (SELECT usage_billing_period_start(s.current_period_start, i.timestamp) AS start) p "
+    "  GROUP BY 1, 2, 3, 4, 5 "
+    "  ON CONFLICT (tenant_id, subscription_id, metric_name, bucket_start) "
+    "  DO UPDATE SET quantity = usage_rollup_period.quantity + EXCLUDED.quantity"
+    ") "
+    "SELECT COUNT(*) AS written FROM inserted";
+
+constexpr const char* WAL_PREFIX = "usage-";
+constexpr size_t MAX_METRIC_NAME_LENGTH = 100;  // usage_records.metric_name
+constexpr const char* WAL_SUFFIX = ".wal";
+
+bool ValidField(const std::string& value) {
+    return !value.empty() && value.find_first_of("\t\n\r") == std::string::npos;
+}
+
+std::string BucketKey(const std::string& tenant_id, const std::string& subscription_id,
+                      const std::string& metric_name, int64_t minute) {
+    std::string key;
+    key.reserve(tenant_id.size() + subscription_id.size() + metric_name.size() + 24);
+    key.append(tenant_id).push_back('\0');
+    key.append(subscription_id).push_back('\0');
+    key.append(metric_name).push_back('\0');
+    key.append(std::to_string(minute));
+    return key;
+}
+
+void AppendWalLine(std::string& out, const UsageEvent& event, int64_t minute) {
+    out.append(event.tenant_id).push_back('\t');
+    out.append(event.subscription_id).push_back('\t');
+    out.append(event.metric_name).push_back('\t');
+    out.append(std::to_string(minute)).push_back('\t');
+    out.append(std::to_string(event.quantity)).push_back('\n');
+}
+
+std::string FormatTimestamp(int64_t seconds) {
+    std::time_t t = static_cast<std::time_t>(seconds);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S+00", &tm);
+    return buffer;
+}
+
+bool WriteAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Months (year * 12 + month - 1, UTC) whose rollup partitions this process created or found
+std::mutex ensured_months_mutex;
+std::set<int64_t> ensured_months;
+
+int64_t MonthIndex(int64_t seconds) {
+    std::time_t t = static_cast<std::time_t>(seconds);
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    return static_cast<int64_t>(tm.tm_year + 1900) * 12 + tm.tm_mon;
+}
+
+/**
+ * Make sure the rollup partitions a batch writes into exist
+ *
+ * A bucket lands in its own month (minute/hour rollups) and possibly the
+ * previous one (billing periods start up to a month earlier). Runs in its
+ * own transaction so the DDL lock is not held across the batch insert.
+ */
+void EnsureRollupPartitions(DbPool& db_pool, const std::vector<UsageBucket>& buckets) {
+    std::set<int64_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(ensured_months_mutex);
+        for (const auto& bucket : buckets) {
+            int64_t month = MonthIndex(bucket.minute);
+            for (int64_t m : {month - 1, month}) {
+                if (ensured_months.count(m) == 0) {
+                    missing.insert(m);
+                }
+            }
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    auto conn_guard = db_pool.AcquireConnection("UsageAggregator::EnsureRollupPartitions");
+    pqxx::work txn(*conn_guard);
+    for (int64_t month : missing) {
+        char date[16];
+        std::snprintf(date, sizeof(date), "%04d-%02d-01",
+                      static_cast<int>(month / 12), static_cast<int>(month % 12 + 1));
+        ExecPrepared(txn, kEnsureRollupPartitions, std::string(date));
+    }
+    txn.commit();
+
+    std::lock_guard<std::mutex> lock(ensured_months_mutex);
+    ensured_months.insert(missing.begin(), missing.end());
+}
+
+std::vector<UsageBucket> Values(std::unordered_map<std::string, UsageBucket>& buckets) {
+    std::vector<UsageBucket> values;
+    values.reserve(buckets.size());
+    for (auto& entry : buckets) {
+        values.push_back(std::move(entry.second));
+    }
+    return values;
+}
+
+} // namespace
+
+UsageAggregatorOptions UsageAggregatorOptions::FromEnv() {
+    UsageAggregatorOptions options;
+    options.flush_interval = std::chrono::milliseconds(
+        EnvInt("USAGE_FLUSH_INTERVAL_MS", static_cast<long>(options.flush_interval.count())));
+    options.flush_max_records = static_cast<size_t>(
+        EnvInt("USAGE_FLUSH_MAX_RECORDS", static_cast<long>(options.flush_max_records)));
+    options.wal_dir = EnvString("USAGE_WAL_DIR", options.wal_dir);
+    options.wal_fsync = EnvInt("USAGE_WAL_FSYNC", options.wal_fsync ? 1 : 0) != 0;
+    return options;
+}
+
+UsageAggregator::UsageAggregator(std::shared_ptr<DbPool> db_pool, const UsageAggregatorOptions& options)
+    : UsageAggregator(
+          [db_pool](const std::string& batch_id, const std::vector<UsageBucket>& buckets) {
+              WriteToDatabase(*db_pool, batch_id, buckets);
+          },
+          options) {}
+
+UsageAggregator::UsageAggregator(Sink sink, const UsageAggregatorOptions& options)
+    : sink_(std::move(sink)), options_(options) {
+    if (options_.flush_max_records == 0) {
+        options_.flush_max_records = 1;
+    }
+
+    Recover();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        OpenSegmentLocked();
+        if (!options_.wal_dir.empty() && wal_fd_ < 0) {
+            throw std::runtime_error("Failed to open usage WAL in " + options_.wal_dir + ": " + std::strerror(errno));
+        }
+    }
+
+    if (options_.wal_dir.empty()) {
+        LogWarn("UsageAggregator: USAGE_WAL_DIR not set, buffered usage is lost on crash");
+    }
+    LogInfo("UsageAggregator initialized", {{"flush_interval_ms", options_.flush_interval.count()},
+                                           {"flush_max_records", options_.flush_max_records},
+                                           {"recovered_batches", pending_.size()}});
+
+    flush_thread_ = std::thread(&UsageAggregator::FlushLoop, this);
+}
+
+UsageAggregator::~UsageAggregator() {
+    Shutdown();
+}
+
+void UsageAggregator::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_.exchange(true)) {
+            return;
+        }
+    }
+    flush_cv_.notify_all();
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
+    }
+
+    try {
+        if (!Flush()) {
+            LogError("Usage batches not written at shutdown", {{"batches", pending_count_.load()},
+                                                                  {"kept_in_wal", !options_.wal_dir.empty()}});
+        }
+    } catch (const std::exception& e) {
+        LogError("UsageAggregator final flush failed", {{"error", e.what()}});
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wal_fd_ >= 0) {
+        ::close(wal_fd_);
+        wal_fd_ = -1;
+        if (wal_offset_ == 0) {
+            ::unlink(segment_path_.c_str());
+        }
+    }
+}
+
+void UsageAggregator::Validate(const UsageEvent& event) {
+    if (event.quantity <= 0) {
+        throw std::invalid_argument("Usage quantity must be positive");
+    }
+    if (!ValidField(event.tenant_id) || !ValidField(event.subscription_id) || !ValidField(event.metric_name)) {
+        throw std::invalid_argument("Usage event has an empty or invalid field");
+    }
+    // Rejected here: once buffered, a row the table refuses would fail its whole batch
+    if (event.metric_name.size() > MAX_METRIC_NAME_LENGTH) {
+        throw std::invalid_argument("Usage metric name too long");
+    }
+}
+
+void UsageAggregator::Record(const UsageEvent& event) {
+    Record(std::vector<UsageEvent>{event});
+}
+
+void UsageAggregator::Record(const std::vector<UsageEvent>& events) {
+    if (events.empty()) {
+        return;
+    }
+
+    std::vector<int64_t> minutes;
+    minutes.reserve(events.size());
+    std::string lines;
+    for (const auto& event : events) {
+        Validate(event);
+        minutes.push_back(MinuteOf(event.timestamp));
+        if (!options_.wal_dir.empty()) {
+            AppendWalLine(lines, event, minutes.back());
+        }
+    }
+
+    uint64_t segment = 0;
+    uint64_t offset = 0;
+    bool flush_now = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!options_.wal_dir.empty()) {
+            if (wal_fd_ < 0) {
+                OpenSegmentLocked();
+            }
+            if (wal_fd_ < 0) {
+                throw std::runtime_error("Usage WAL unavailable");
+            }
+            if (!WriteAll(wal_fd_, lines.data(), lines.size())) {
+                int error = errno;
+                // Drop a partial append so replay cannot see events we reject
+                if (::ftruncate(wal_fd_, static_cast<off_t>(wal_offset_)) != 0 ||
+                    ::lseek(wal_fd_, static_cast<off_t>(wal_offset_), SEEK_SET) < 0) {
+                    ::close(wal_fd_);
+                    wal_fd_ = -1;
+                }
+                throw std::runtime_error(std::string("Usage WAL write failed: ") + std::strerror(error));
+            }
+            wal_offset_ += lines.size();
+        }
+
+        for (size_t i = 0; i < events.size(); ++i) {
+            Accumulate(buckets_, events[i], minutes[i]);
+        }
+        records_since_flush_ += events.size();
+        flush_now = records_since_flush_ >= options_.flush_max_records;
+        segment = segment_;
+        offset = wal_offset_;
+    }
+    recorded_ += events.size();
+
+    if (flush_now) {
+        flush_cv_.notify_all();
+    }
+    if (!options_.wal_dir.empty() && options_.wal_fsync) {
+        SyncWal(segment, offset);
+    }
+}
+
+void UsageAggregator::SyncWal(uint64_t segment, uint64_t offset) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (segment == segment_ && synced_offset_ < offset) {
+        if (syncing_) {
+            // Another caller's fdatasync may cover our bytes
+            sync_cv_.wait(lock);
+            continue;
+        }
+
+        syncing_ = true;
+        int fd = wal_fd_;
+        uint64_t target = wal_offset_;
+        lock.unlock();
+        int rc = fd >= 0 ? ::fdatasync(fd) : -1;
+        int error = errno;
+        lock.lock();
+        syncing_ = false;
+        sync_cv_.notify_all();
+
+        if (rc != 0) {
+            throw std::runtime_error(std::string("Usage WAL sync failed: ") + std::strerror(error));
+        }
+        if (segment == segment_) {
+            synced_offset_ = std::max(synced_offset_, target);
+        }
+    }
+    // A rotated segment was synced by the flush that closed it
+}
+
+bool UsageAggregator::Flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!buckets_.empty()) {
+            sync_cv_.wait(lock, [this] { return !syncing_; });
+
+            Batch batch;
+            batch.id = segment_id_;
+            batch.wal_path = segment_path_;
+            batch.buckets = Values(buckets_);
+            buckets_.clear();
+            records_since_flush_ = 0;
+
+            if (wal_fd_ >= 0) {
+                if (::fdatasync(wal_fd_) != 0) {
+                    LogError("Usage WAL sync failed at rotation", {{"error", std::strerror(errno)}});
+                }
+                ::close(wal_fd_);
+                wal_fd_ = -1;
+            }
+
+            ++segment_;
+            wal_offset_ = 0;
+            synced_offset_ = 0;
+            OpenSegmentLocked();
+            sync_cv_.notify_all();
+
+            pending_.push_back(std::move(batch));
+            pending_count_ = pending_.size();
+        }
+    }
+
+    return FlushPending();
+}
+
+bool UsageAggregator::FlushPending() {
+    // Caller holds flush_mutex_; batches are written in order
+    while (!pending_.empty()) {
+        Batch& batch = pending_.front();
+        try {
+            sink_(batch.id, batch.buckets);
+        } catch (const std::exception& e) {
+            ++failed_flushes_;
+            LogError("Usage flush failed, retrying", {{"batch_id", batch.id}, {"buckets", batch.buckets.size()},
+                                                     {"error", e.what()}});
+            return false;
+        }
+
+        if (!batch.wal_path.empty() && ::unlink(batch.wal_path.c_str()) != 0 && errno != ENOENT) {
+            LogError("Failed to remove usage WAL segment", {{"path", batch.wal_path}, {"error", std::strerror(errno)}});
+        }
+        ++flushed_batches_;
+        flushed_buckets_ += batch.buckets.size();
+        pending_.pop_front();
+        pending_count_ = pending_.size();
+    }
+    return true;
+}
+
+void UsageAggregator::FlushLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            flush_cv_.wait_for(lock, options_.flush_interval, [this] {
+                return shutdown_.load() || records_since_flush_ >= options_.flush_max_records;
+            });
+        }
+        if (shutdown_.load()) {
+            return;  // Shutdown() does the final flush
+        }
+
+        try {
+            Flush();
+        } catch (const std::exception& e) {
+            LogError("Usage flush error", {{"error", e.what()}});
+        }
+    }
+}
+
+void UsageAggregator::Recover() {
+    if (options_.wal_dir.empty()) {
+        return;
+    }
+    if (::mkdir(options_.wal_dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create usage WAL dir " + options_.wal_dir + ": " + std::strerror(errno));
+    }
+
+    DIR* dir = ::opendir(options_.wal_dir.c_str());
+    if (!dir) {
+        throw std::runtime_error("Failed to open usage WAL dir " + options_.wal_dir + ": " + std::strerror(errno));
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        size_t prefix = std::strlen(WAL_PREFIX);
+        size_t suffix = std::strlen(WAL_SUFFIX);
+        if (name.size() > prefix + suffix && name.compare(0, prefix, WAL_PREFIX) == 0 &&
+            name.compare(name.size() - suffix, suffix, WAL_SUFFIX) == 0) {
+            names.push_back(name);
+        }
+    }
+    ::closedir(dir);
+
+    // Ids start with a millisecond timestamp, so name order is write order
+    std::sort(names.begin(), names.end());
+
+    for (const auto& name : names) {
+        std::string path = options_.wal_dir + "/" + name;
+        std::ifstream in(path);
+        std::unordered_map<std::string, UsageBucket> buckets;
+        std::string line;
+        size_t skipped = 0;
+
+        // A torn final line (crash mid-append) has no newline; getline still
+        // returns it, so require all five fields to parse
+        while (std::getline(in, line)) {
+            std::stringstream fields(line);
+            UsageEvent event;
+            std::string minute;
+            std::string quantity;
+            if (!std::getline(fields, event.tenant_id, '\t') ||
+                !std::getline(fields, event.subscription_id, '\t') ||
+                !std::getline(fields, event.metric_name, '\t') ||
+                !std::getline(fields, minute, '\t') ||
+                !std::getline(fields, quantity, '\t')) {
+                ++skipped;
+                continue;
+            }
+            char* end = nullptr;
+            event.quantity = std::strtoll(quantity.c_str(), &end, 10);
+            if (!end || *end != '\0' || event.quantity <= 0 || in.eof()) {
+                ++skipped;
+                continue;
+            }
+            Accumulate(buckets, event, std::strtoll(minute.c_str(), nullptr, 10));
+        }
+
+        if (skipped > 0) {
+            LogWarn("Usage WAL segment has malformed lines", {{"segment", name}, {"skipped", skipped}});
+        }
+        if (buckets.empty()) {
+            ::unlink(path.c_str());
+            continue;
+        }
+
+        Batch batch;
+        batch.id = name.substr(0, name.size() - std::strlen(WAL_SUFFIX));
+        batch.wal_path = path;
+        batch.buckets = Values(buckets);
+        pending_.push_back(std::move(batch));
+    }
+    pending_count_ = pending_.size();
+}
+
+void UsageAggregator::OpenSegmentLocked() {
+    segment_id_ = NewBatchId();
+    if (options_.wal_dir.empty()) {
+        segment_path_.clear();
+        return;
+    }
+    segment_path_ = options_.wal_dir + "/" + segment_id_ + WAL_SUFFIX;
+    wal_fd_ = ::open(segment_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (wal_fd_ < 0) {
+        LogError("Failed to open usage WAL segment", {{"path", segment_path_}, {"error", std::strerror(errno)}});
+    }
+}
+
+void UsageAggregator::Accumulate(
+    std::unordered_map<std::string, UsageBucket>& buckets,
+    const UsageEvent& event,
+    int64_t minute
+) {
+    auto [it, inserted] = buckets.try_emplace(
+        BucketKey(event.tenant_id, event.subscription_id, event.metric_name, minute));
+    if (inserted) {
+        it->second.tenant_id = event.tenant_id;
+        it->second.subscription_id = event.subscription_id;
+        it->second.metric_name = event.metric_name;
+        it->second.minute = minute;
+    }
+    it->second.quantity += event.quantity;
+}
+
+std::string UsageAggregator::NewBatchId() {
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // Random suffix keeps ids unique across instances sharing a database
+    std::ostringstream id;
+    id << WAL_PREFIX << std::setw(13) << std::setfill('0') << now_ms << '-'
+       << std::setw(6) << std::setfill('0') << (next_sequence_++ % 1000000) << '-'
+       << std::hex << std::setw(16) << std::setfill('0') << rng();
+    return id.str();
+}
+
+int64_t UsageAggregator::MinuteOf(int64_t timestamp) {
+    if (timestamp <= 0) {
+        timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    return timestamp - timestamp % 60;
+}
+
+UsageAggregatorStats UsageAggregator::GetStats() const {
+    UsageAggregatorStats stats;
+    stats.recorded = recorded_.load();
+    stats.flushed_batches = flushed_batches_.load();
+    stats.flushed_buckets = flushed_buckets_.load();
+    stats.failed_flushes = failed_flushes_.load();
+    stats.pending_batches = pending_count_.load();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.buffered_buckets = buckets_.size();
+    }
+    return stats;
+}
+
+void UsageAggregator::WriteToDatabase(
+    DbPool& db_pool,
+    const std::string& batch_id,
+    const std::vector<UsageBucket>& buckets
+) {
+    EnsureRollupPartitions(db_pool, buckets);
+
+    auto conn_guard = db_pool.AcquireConnection("UsageAggregator::Flush");
+    pqxx::work txn(*conn_guard);
+
+    auto claimed = ExecPrepared(txn, kClaimUsageBatch, batch_id, static_cast<int64_t>(buckets.size()));
+    if (claimed.empty()) {
+        // Committed before a crash; the WAL segment outlived it
+        txn.commit();
+        LogInfo("Usage batch already applied, skipping", {{"batch_id", batch_id}});
+        return;
+    }
+
+    txn.exec(kCreateStage);
+    {
+        pqxx::stream_to stream(
+            txn, "usage_ingest_stage",
+            std::vector<std::string>{"id", "tenant_id", "subscription_id", "metric_name", "quantity", "minute"});
+        for (const auto& bucket : buckets) {
+            stream << std::make_tuple(
+                IdGenerator::NewUuid(), bucket.tenant_id, bucket.subscription_id, bucket.metric_name,
+                bucket.quantity, FormatTimestamp(bucket.minute));
+        }
+        stream.complete();
+    }
+
+    auto applied = txn.exec(kApplyStage);
+    txn.commit();
+
+    size_t written = applied[0]["written"].as<size_t>();
+    if (written < buckets.size()) {
+        LogWarn("Usage buckets dropped for missing or foreign subscriptions",
+                {{"batch_id", batch_id}, {"buckets", buckets.size() - written}});
+    }
+}
+
+} // namespace common
+} // namespace saasforge
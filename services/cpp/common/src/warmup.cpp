@@ -0,0 +1,120 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Startup warm-up gating the gRPC health status implementation
+ */
+
+#include "common/warmup.h"
+#include "common/channel_pool.h"
+#include "common/db_pool.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/redis_client.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+long ElapsedMs(std::chrono::steady_clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+
+} // namespace
+
+WarmupOptions WarmupOptions::FromEnv() {
+    WarmupOptions options;
+    options.timeout = std::chrono::seconds(
+        EnvInt("WARMUP_TIMEOUT_S", static_cast<long>(options.timeout.count())));
+    options.retry = std::chrono::milliseconds(std::max(1L,
+        EnvInt("WARMUP_RETRY_MS", static_cast<long>(options.retry.count()))));
+    return options;
+}
+
+Warmup::Warmup(const WarmupOptions& options) : options_(options) {}
+
+void Warmup::Add(std::string name, Step step, bool required) {
+    steps_.push_back({std::move(name), std::move(step), required});
+}
+
+bool Warmup::Run(grpc::HealthCheckServiceInterface* health) {
+    if (health) {
+        health->SetServingStatus(false);
+        health->SetServingStatus(LIVENESS_SERVICE, true);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + options_.timeout;
+    std::atomic<bool> ready{true};
+    std::vector<std::thread> threads;
+    threads.reserve(steps_.size());
+    for (const auto& entry : steps_) {
+        threads.emplace_back([this, &entry, deadline, &ready] {
+            if (!RunStep(entry, deadline) && entry.required) {
+                ready = false;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (!ready) {
+        LogError("Warm-up failed, not serving", {{"duration_ms", ElapsedMs(start)}});
+        return false;
+    }
+    if (health) {
+        health->SetServingStatus(true);
+    }
+    LogInfo("Warm-up complete, serving", {{"steps", steps_.size()}, {"duration_ms", ElapsedMs(start)}});
+    return true;
+}
+
+bool Warmup::RunStep(const Entry& entry, std::chrono::steady_clock::time_point deadline) const {
+    auto start = std::chrono::steady_clock::now();
+    for (int attempt = 1;; ++attempt) {
+        try {
+            entry.step();
+            LogInfo("Warm-up step done", {{"step", entry.name}, {"attempts", attempt},
+                                          {"duration_ms", ElapsedMs(start)}});
+            return true;
+        } catch (const std::exception& e) {
+            bool retry = entry.required && std::chrono::steady_clock::now() + options_.retry < deadline;
+            LogWarn("Warm-up step failed", {{"step", entry.name}, {"attempt", attempt},
+                                            {"retrying", retry}, {"error", e.what()}});
+            if (!retry) {
+                return false;
+            }
+        }
+        std::this_thread::sleep_for(options_.retry);
+    }
+}
+
+Warmup::Step Warmup::PingDatabase(std::shared_ptr<DbPool> db_pool) {
+    return [db_pool] {
+        auto conn_guard = db_pool->AcquireConnection("Warmup");
+        pqxx::nontransaction txn(*conn_guard);
+        txn.exec("SELECT 1");
+    };
+}
+
+Warmup::Step Warmup::ConnectRedis(std::shared_ptr<RedisClient> redis_client) {
+    return [redis_client] { redis_client->Warm(); };
+}
+
+Warmup::Step Warmup::ConnectChannels(std::shared_ptr<ChannelPool> channels, std::string target) {
+    return [channels, target] {
+        if (!channels->Connect(target, std::chrono::system_clock::now() + CHANNEL_CONNECT_TIMEOUT)) {
+            throw std::runtime_error("Channels to " + target + " not connected");
+        }
+    };
+}
+
+} // namespace common
+} // namespace saasforge
@@ -6,16 +6,266 @@
 
 #include "common/webhook_delivery.h"
 #include "common/webhook_signer.h"
-#include <iostream>
+#include "common/id_generator.h"
+#include "common/row_mapping.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include <algorithm>
 #include <sstream>
+#include <thread>
 #include <pqxx/pqxx>
 
 namespace saasforge {
 namespace common {
 
-WebhookDelivery::WebhookDelivery(std::shared_ptr<DbPool> db_pool)
-    : db_pool_(db_pool) {
-    std::cout << "WebhookDelivery initialized" << std::endl;
+namespace {
+
+// Claims read and lock webhook_deliveries_active, the hot partition holding
+// only claimable and in-flight rows; delivered and exhausted rows move to
+// webhook_deliveries_done (dropped a day at a time by
+// QueuePartitionMaintainer). Status values in those statements are literals
+// so partitions are pruned, and the partial index matched, at plan time
+// (migration c9e4b1f7a260).
+static_assert(static_cast<int>(WebhookStatus::PENDING) == 0 && static_cast<int>(WebhookStatus::SENDING) == 1 &&
+              static_cast<int>(WebhookStatus::FAILED) == 3 && static_cast<int>(WebhookStatus::RETRY) == 4,
+              "status literals in the webhook_deliveries statements (and webhook_deliveries_active's partition bound)");
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const PreparedStatement kSelectWebhook(
+    "webhook_select_webhook",
+    "SELECT url, status FROM webhooks WHERE id = $1 AND tenant_id = $2");
+
+// pg_notify is delivered on commit, waking QueueNotifier listeners. Large
+// payloads go to payload_blobs ($10/$11, see PayloadCodec): the row keeps
+// '' and their hash ($9, '' when inline). Row ids ($12 here, and the id
+// arrays below) come from IdGenerator, so inserts append to the indexes.
+const PreparedStatement kInsertDelivery(
+    "webhook_insert_delivery",
+    "WITH " PAYLOAD_BLOBS_CTE("$10", "$11") ", inserted AS ("
+    "  INSERT INTO webhook_deliveries "
+    "  (id, tenant_id, webhook_id, event_type, payload, payload_hash, url, signature, status, retry_count, "
+    "  created_at, scheduled_at) "
+    "  VALUES ($12, $1, $2, $3, $4, NULLIF($9, '')::bytea, $5, $6, $7, 0, NOW(), NOW()) "
+    "  RETURNING id"
+    ") "
+    "SELECT id, pg_notify($8, id::text) FROM inserted");
+
+// Fan-out: the payload is stored once in webhook_events and the delivery
+// rows reference it. Only webhooks still active (with an unchanged URL) get
+// a row; a single NOTIFY covers the whole event. The LEFT JOIN keeps one row
+// (with NULL delivery) when nothing was inserted so the event id is returned.
+// The payload is stored as in kInsertDelivery ($9-$11); $12 is the event's
+// id and $13 one delivery id per webhook.
+const PreparedStatement kInsertEventDeliveries(
+    "webhook_insert_event_deliveries",
+    "WITH " PAYLOAD_BLOBS_CTE("$10", "$11") ", event AS ("
+    "  INSERT INTO webhook_events (id, tenant_id, event_type, payload, payload_hash, created_at) "
+    "  VALUES ($12, $1, $2, $3, NULLIF($9, '')::bytea, NOW()) "
+    "  RETURNING id, EXTRACT(EPOCH FROM created_at)::bigint AS created_at"
+    "), input AS ("
+    "  SELECT * FROM unnest($4::uuid[], $5::text[], $6::text[], $13::uuid[]) AS t(webhook_id, url, signature, id)"
+    "), inserted AS ("
+    "  INSERT INTO webhook_deliveries "
+    "  (id, tenant_id, webhook_id, event_id, event_type, url, signature, status, retry_count, created_at, "
+    "  scheduled_at) "
+    "  SELECT i.id, $1, w.id, e.id, $2, w.url, i.signature, $7, 0, NOW(), NOW() "
+    "  FROM input i "
+    "  JOIN webhooks w ON w.id = i.webhook_id AND w.tenant_id = $1 AND w.status = 'active' AND w.url = i.url "
+    "  CROSS JOIN event e "
+    "  RETURNING id, webhook_id"
+    ") "
+    "SELECT e.id AS event_id, e.created_at, d.id AS delivery_id, d.webhook_id, "
+    "(SELECT pg_notify($8, id::text) FROM event) AS notified "
+    "FROM event e LEFT JOIN inserted d ON TRUE");
+
+// Multi-event fan-out (QueueEvents): $1-$4 are the events, $5-$8 the
+// deliveries, matched on the event's position n. $11 holds the payload
+// hashes, $12/$13 the distinct blobs (see kInsertDelivery), $14 the event
+// ids and $15 the delivery ids.
+const PreparedStatement kInsertEventsDeliveries(
+    "webhook_insert_events_deliveries",
+    "WITH " PAYLOAD_BLOBS_CTE("$12", "$13") ", input AS ("
+    "  SELECT * "
+    "  FROM unnest($1::int[], $2::uuid[], $3::text[], $4::text[], $11::text[], $14::uuid[]) "
+    "    AS t(n, tenant_id, event_type, payload, payload_hash, event_id)"
+    "), events AS ("
+    "  INSERT INTO webhook_events (id, tenant_id, event_type, payload, payload_hash, created_at) "
+    "  SELECT event_id, tenant_id, event_type, payload, NULLIF(payload_hash, '')::bytea, NOW() FROM input"
+    "), inserted AS ("
+    "  INSERT INTO webhook_deliveries "
+    "  (id, tenant_id, webhook_id, event_id, event_type, url, signature, status, retry_count, created_at, "
+    "  scheduled_at) "
+    "  SELECT d.id, i.tenant_id, w.id, i.event_id, i.event_type, w.url, d.signature, $9, 0, NOW(), NOW() "
+    "  FROM unnest($5::int[], $6::uuid[], $7::text[], $8::text[], $15::uuid[]) "
+    "    AS d(n, webhook_id, url, signature, id) "
+    "  JOIN input i ON i.n = d.n "
+    "  JOIN webhooks w ON w.id = d.webhook_id AND w.tenant_id = i.tenant_id AND w.status = 'active' "
+    "  AND w.url = d.url "
+    "  RETURNING id"
+    ") "
+    "SELECT (SELECT count(*) FROM inserted) AS deliveries, pg_notify($10, '') AS notified");
+
+const PreparedStatement kReleaseBatch(
+    "webhook_release_batch",
+    "UPDATE webhook_deliveries_active SET "
+    "status = CASE WHEN retry_count = 0 THEN $1 ELSE $2 END, "
+    "scheduled_at = NOW() + make_interval(secs => $3) "
+    "WHERE id = ANY($4::uuid[]) AND status = $5");
+
+const PreparedStatement kNextDue(
+    "webhook_next_due",
+    "SELECT (EXTRACT(EPOCH FROM (MIN(scheduled_at) - NOW())) * 1000)::bigint AS due_in_ms "
+    "FROM webhook_deliveries_active WHERE status IN (0, 4)");
+
+// The webhook's batch settings come along with each row (webhooks primary
+// key), as does a blob-stored payload, still encoded (payload_blobs primary key)
+// Columns of a returned delivery, in WebhookDeliveryRecord's terms, for
+// statements over webhook_deliveries d and its webhook w. Event fan-out rows
+// leave their payload on webhook_events; blob-stored payloads come back
+// still encoded (payload_blobs primary key).
+constexpr auto kDeliveryRow = MapRow(
+    Column<&WebhookDeliveryRecord::id>("d.id"),
+    Column<&WebhookDeliveryRecord::tenant_id>("d.tenant_id"),
+    Column<&WebhookDeliveryRecord::webhook_id>("d.webhook_id"),
+    Column<&WebhookDeliveryRecord::event_type>("d.event_type"),
+    Column<&WebhookDeliveryRecord::payload>(
+        "COALESCE(d.payload, (SELECT e.payload FROM webhook_events e WHERE e.id = d.event_id)) AS payload"),
+    Column<&WebhookDeliveryRecord::payload_data>(
+        "(SELECT b.data FROM payload_blobs b WHERE b.hash = COALESCE(d.payload_hash, "
+        "  (SELECT e.payload_hash FROM webhook_events e WHERE e.id = d.event_id))) AS payload_data"),
+    Column<&WebhookDeliveryRecord::url>("d.url"),
+    Column<&WebhookDeliveryRecord::signature>("d.signature"),
+    Column<&WebhookDeliveryRecord::status>("d.status"),
+    Column<&WebhookDeliveryRecord::retry_count>("d.retry_count"),
+    Column<&WebhookDeliveryRecord::http_status_code>("d.http_status_code"),
+    Column<&WebhookDeliveryRecord::created_at>("EXTRACT(EPOCH FROM d.created_at)::bigint AS created_at"),
+    Column<&WebhookDeliveryRecord::scheduled_at>("EXTRACT(EPOCH FROM d.scheduled_at)::bigint AS scheduled_at"),
+    Column<&WebhookDeliveryRecord::delivered_at>("EXTRACT(EPOCH FROM d.delivered_at)::bigint AS delivered_at"),
+    Column<&WebhookDeliveryRecord::error_message>("d.error_message"),
+    Column<&WebhookDeliveryRecord::batch_max_events>("w.batch_max_events"),
+    Column<&WebhookDeliveryRecord::batch_window_ms>("w.batch_window_ms"));
+
+constexpr auto kClaimBatchSql =
+    SqlText("UPDATE webhook_deliveries_active d SET status = $1 "
+            "FROM webhooks w "
+            "WHERE w.id = d.webhook_id AND d.id IN ("
+            "  SELECT id FROM webhook_deliveries_active "
+            "  WHERE status IN (0, 4) "
+            "  AND scheduled_at <= NOW() "
+            "  ORDER BY scheduled_at ASC "
+            "  LIMIT $2 "
+            "  FOR UPDATE SKIP LOCKED"
+            ") "
+            "RETURNING ") + kDeliveryRow.SelectList();
+const PreparedStatement kClaimBatch("webhook_claim_batch", kClaimBatchSql.c_str());
+
+// Successful deliveries also reset their webhook's consecutive failure count
+const PreparedStatement kMarkDeliveredBatch(
+    "webhook_mark_delivered_batch",
+    "WITH input AS ("
+    "  SELECT * FROM unnest($1::uuid[], $2::int[]) AS t(id, http_status)"
+    "), delivered AS ("
+    "  UPDATE webhook_deliveries d SET status = $3, http_status_code = i.http_status, delivered_at = NOW() "
+    "  FROM input i WHERE d.id = i.id AND d.status IN (0, 1, 3, 4) "
+    "  RETURNING d.webhook_id"
+    "), reset AS ("
+    "  UPDATE webhooks SET failure_count = 0, last_triggered_at = NOW() "
+    "  WHERE id IN (SELECT webhook_id FROM delivered) "
+    "  RETURNING 1"
+    ") "
+    "SELECT COUNT(*) AS updated FROM delivered");
+
+// One round trip per batch: retry/exhaust decision and backoff are computed
+// from each row's retry_count (4xx other than 429 is not retried), failure
+// counts are bumped per webhook, and webhooks crossing $8 consecutive
+// failures are disabled. $7 holds the delay (seconds) for retry 1..MAX_RETRIES;
+// retries the caller holds in memory ($9) are scheduled $10 seconds later.
+// Members of one batch POST ($11, '' for single deliveries) are one failure.
+const PreparedStatement kMarkFailedBatch(
+    "webhook_mark_failed_batch",
+    "WITH input AS ("
+    "  SELECT *, (http_status < 400 OR http_status >= 500 OR http_status = 429) AS retryable "
+    "  FROM unnest($1::uuid[], $2::int[], $3::text[], $9::boolean[], $11::text[]) "
+    "    AS t(id, http_status, error_message, held, batch_id)"
+    "), updated AS ("
+    "  UPDATE webhook_deliveries d SET "
+    "    status = CASE WHEN i.retryable AND d.retry_count < $6 THEN $4 ELSE $5 END, "
+    "    retry_count = CASE WHEN i.retryable AND d.retry_count < $6 "
+    "      THEN d.retry_count + 1 ELSE d.retry_count END, "
+    "    scheduled_at = CASE WHEN i.retryable AND d.retry_count < $6 "
+    "      THEN NOW() + make_interval(secs => ($7::int[])[d.retry_count + 1] "
+    "        + CASE WHEN i.held THEN $10::int ELSE 0 END) ELSE d.scheduled_at END, "
+    "    http_status_code = i.http_status, "
+    "    error_message = i.error_message "
+    "  FROM input i WHERE d.id = i.id AND d.status IN (0, 1, 3, 4) "
+    "  RETURNING d.webhook_id, COALESCE(NULLIF(i.batch_id, ''), d.id::text) AS attempt"
+    "), failures AS ("
+    "  SELECT webhook_id, COUNT(DISTINCT attempt) AS n FROM updated GROUP BY webhook_id"
+    "), counted AS ("
+    "  UPDATE webhooks w SET "
+    "    failure_count = w.failure_count + f.n, "
+    "    status = CASE WHEN w.failure_count + f.n >= $8 THEN 'disabled' ELSE w.status END, "
+    "    disabled_reason = CASE WHEN w.failure_count + f.n >= $8 AND w.status <> 'disabled' "
+    "      THEN 'Too many consecutive failures (' || (w.failure_count + f.n) || ')' "
+    "      ELSE w.disabled_reason END "
+    "  FROM failures f WHERE w.id = f.webhook_id "
+    "  RETURNING w.id, w.failure_count >= $8 AND w.failure_count - f.n < $8 AS newly_disabled"
+    ") "
+    "SELECT (SELECT COUNT(*) FROM updated) AS updated, "
+    "(SELECT COUNT(*) FROM counted WHERE newly_disabled) AS disabled");
+
+// Held retries (see WebhookDispatcher): re-claimed by primary key when due,
+// and only while still the retry this process recorded, so a row another
+// poller picked up after the hold lease is left to it
+const PreparedStatement kReclaimHeldBatch(
+    "webhook_reclaim_held_batch",
+    "UPDATE webhook_deliveries_active d SET status = $3 "
+    "FROM unnest($1::uuid[], $2::int[]) AS t(id, retry_count) "
+    "WHERE d.id = t.id AND d.status = 4 AND d.retry_count = t.retry_count "
+    "RETURNING d.id");
+
+const PreparedStatement kReleaseHeldBatch(
+    "webhook_release_held_batch",
+    "UPDATE webhook_deliveries_active d SET scheduled_at = d.scheduled_at - make_interval(secs => $3) "
+    "FROM unnest($1::uuid[], $2::int[]) AS t(id, retry_count) "
+    "WHERE d.id = t.id AND d.status = 4 AND d.retry_count = t.retry_count");
+
+// The webhook may be gone: its batch settings then read as 0
+constexpr auto kSelectDeliverySql =
+    SqlText("SELECT ") + kDeliveryRow.SelectList() + " "
+    "FROM webhook_deliveries d LEFT JOIN webhooks w ON w.id = d.webhook_id "
+    "WHERE d.id = $1";
+const PreparedStatement kSelectDelivery("webhook_select_delivery", kSelectDeliverySql.c_str());
+
+const PreparedStatement kSelectFailureCount(
+    "webhook_select_failure_count",
+    "SELECT failure_count FROM webhooks WHERE id = $1");
+
+const PreparedStatement kDisable(
+    "webhook_disable",
+    "UPDATE webhooks SET status = 'disabled', disabled_reason = $1 WHERE id = $2");
+
+constexpr std::chrono::milliseconds MIN_POLL_INTERVAL{10};
+constexpr std::chrono::milliseconds POLL_INTERVAL_WITHOUT_NOTIFY{1000};
+
+// (ids, retry counts) of held deliveries, for the *HeldBatch statements
+std::pair<std::string, std::string> HeldArrays(const std::vector<WebhookDeliveryRecord>& held) {
+    std::vector<std::string> ids;
+    std::vector<std::string> retry_counts;
+    ids.reserve(held.size());
+    retry_counts.reserve(held.size());
+    for (const auto& delivery : held) {
+        ids.push_back(delivery.id);
+        retry_counts.push_back(std::to_string(delivery.retry_count));
+    }
+    return {ToArrayLiteral(ids), ToArrayLiteral(retry_counts)};
+}
+
+} // namespace
+
+WebhookDelivery::WebhookDelivery(std::shared_ptr<DbPool> db_pool, std::shared_ptr<QueueNotifier> notifier)
+    : db_pool_(db_pool), notifier_(notifier), payloads_(db_pool, PayloadCodecOptions::FromEnv()) {
+    LogInfo("WebhookDelivery initialized");
 }
 
 std::string WebhookDelivery::QueueDelivery(
@@ -24,12 +274,12 @@ std::string WebhookDelivery::QueueDelivery(
     const std::string& event_type,
     const std::string& payload
 ) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
     // Get webhook URL and verify it's active
-    auto webhook_result = txn.exec_params(
-        "SELECT url, status FROM webhooks WHERE id = $1 AND tenant_id = $2",
+    auto webhook_result = ExecPrepared(
+        txn, kSelectWebhook,
         webhook_id,
         tenant_id
     );
@@ -52,203 +302,446 @@ std::string WebhookDelivery::QueueDelivery(
 
     // Generate HMAC-SHA256 signature for webhook payload (Requirement D-103)
     std::string webhook_secret = WebhookSigner::GetMockWebhookSecret(tenant_id, webhook_id);
-    std::string signature = WebhookSigner::SignPayload(payload, webhook_secret);
+    std::string signature = WebhookSigner::GetSigningKey(tenant_id, webhook_id, webhook_secret)->Sign(payload);
+
+    auto stored = payloads_.Store(payload, "webhook:" + event_type);
+    PayloadBlobs blobs;
+    blobs.Add(stored);
 
     // Queue the delivery with signature
-    auto result = txn.exec_params(
-        "INSERT INTO webhook_deliveries "
-        "(tenant_id, webhook_id, event_type, payload, url, signature, status, retry_count, created_at, scheduled_at) "
-        "VALUES ($1, $2, $3, $4, $5, $6, $7, 0, NOW(), NOW()) "
-        "RETURNING id",
+    auto result = ExecPrepared(
+        txn, kInsertDelivery,
         tenant_id,
         webhook_id,
         event_type,
-        payload,
+        stored.text,
         url,
         signature,
-        static_cast<int>(WebhookStatus::PENDING)
+        static_cast<int>(WebhookStatus::PENDING),
+        NOTIFY_CHANNEL,
+        stored.hash,
+        blobs.Hashes(),
+        blobs.Data(),
+        IdGenerator::NewUuid()
     );
 
     std::string delivery_id = result[0]["id"].as<std::string>();
     txn.commit();
 
-    std::cout << "Webhook delivery queued: " << delivery_id << " to " << url << std::endl;
+    LogDebug("Webhook delivery queued", {{"delivery_id", delivery_id}, {"url", url}});
 
     return delivery_id;
 }
 
-std::vector<WebhookDeliveryRecord> WebhookDelivery::GetNextBatch(int batch_size) {
-    auto conn_guard = db_pool_->AcquireConnection();
+QueuedWebhookEvent WebhookDelivery::QueueEvent(
+    const std::string& tenant_id,
+    const std::string& event_type,
+    const std::string& payload,
+    const std::vector<WebhookSubscription>& subscribers
+) {
+    std::vector<std::string> webhook_ids;
+    std::vector<std::string> urls;
+    std::vector<std::string> signatures;
+    std::vector<std::string> delivery_ids;
+    webhook_ids.reserve(subscribers.size());
+    urls.reserve(subscribers.size());
+    signatures.reserve(subscribers.size());
+    delivery_ids.reserve(subscribers.size());
+
+    for (const auto& subscriber : subscribers) {
+        // Validate URL for SSRF protection
+        if (!ValidateUrl(subscriber.url)) {
+            LogWarn("Skipping webhook with invalid URL (SSRF protection)", {{"webhook_id", subscriber.webhook_id}});
+            continue;
+        }
+
+        webhook_ids.push_back(subscriber.webhook_id);
+        urls.push_back(subscriber.url);
+        delivery_ids.push_back(IdGenerator::NewUuid());
+        if (subscriber.batch_max_events > 1) {
+            signatures.emplace_back();  // Signed per batch by the dispatcher
+            continue;
+        }
+
+        // Generate HMAC-SHA256 signature for webhook payload (Requirement D-103)
+        std::string webhook_secret = WebhookSigner::GetMockWebhookSecret(tenant_id, subscriber.webhook_id);
+        signatures.push_back(
+            WebhookSigner::GetSigningKey(tenant_id, subscriber.webhook_id, webhook_secret)->Sign(payload));
+    }
+
+    QueuedWebhookEvent queued;
+    if (webhook_ids.empty()) {
+        return queued;
+    }
+
+    auto stored = payloads_.Store(payload, "webhook:" + event_type);
+    PayloadBlobs blobs;
+    blobs.Add(stored);
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    // Get deliveries that are:
+    auto result = ExecPrepared(
+        txn, kInsertEventDeliveries,
+        tenant_id,
+        event_type,
+        stored.text,
+        ToArrayLiteral(webhook_ids),
+        ToArrayLiteral(urls),
+        ToArrayLiteral(signatures),
+        static_cast<int>(WebhookStatus::PENDING),
+        NOTIFY_CHANNEL,
+        stored.hash,
+        blobs.Hashes(),
+        blobs.Data(),
+        IdGenerator::NewUuid(),
+        ToArrayLiteral(delivery_ids)
+    );
+
+    queued.deliveries.reserve(result.size());
+    for (const auto& row : result) {
+        ReadText(row["event_id"], queued.event_id);
+        queued.created_at = row["created_at"].as<int64_t>();
+        if (!row["delivery_id"].is_null()) {
+            auto& delivery = queued.deliveries.emplace_back();
+            ReadText(row["delivery_id"], delivery.first);
+            ReadText(row["webhook_id"], delivery.second);
+        }
+    }
+    txn.commit();
+
+    LogDebug("Webhook event queued", {{"event_id", queued.event_id}, {"event_type", event_type},
+                                      {"webhooks", queued.deliveries.size()}});
+
+    return queued;
+}
+
+size_t WebhookDelivery::QueueEvents(pqxx::work& txn, const std::vector<WebhookEventFanout>& events) {
+    std::vector<std::string> event_ns, tenant_ids, event_types, payloads, payload_hashes, event_ids;
+    std::vector<std::string> delivery_ns, webhook_ids, urls, signatures, delivery_ids;
+    PayloadBlobs blobs;
+
+    for (const auto& event : events) {
+        std::string n = std::to_string(event_ns.size());
+        size_t subscribed = webhook_ids.size();
+        for (const auto& subscriber : event.subscribers) {
+            if (!ValidateUrl(subscriber.url)) {
+                LogWarn("Skipping webhook with invalid URL (SSRF protection)", {{"webhook_id", subscriber.webhook_id}});
+                continue;
+            }
+            delivery_ns.push_back(n);
+            webhook_ids.push_back(subscriber.webhook_id);
+            urls.push_back(subscriber.url);
+            delivery_ids.push_back(IdGenerator::NewUuid());
+            if (subscriber.batch_max_events > 1) {
+                signatures.emplace_back();  // Signed per batch by the dispatcher
+                continue;
+            }
+            std::string webhook_secret = WebhookSigner::GetMockWebhookSecret(event.tenant_id, subscriber.webhook_id);
+            signatures.push_back(
+                WebhookSigner::GetSigningKey(event.tenant_id, subscriber.webhook_id, webhook_secret)->Sign(event.payload));
+        }
+        if (webhook_ids.size() == subscribed) {
+            continue;  // Nobody to deliver to
+        }
+        event_ns.push_back(std::move(n));
+        tenant_ids.push_back(event.tenant_id);
+        event_types.push_back(event.event_type);
+        auto stored = payloads_.Store(event.payload, "webhook:" + event.event_type);
+        blobs.Add(stored);
+        payloads.push_back(std::move(stored.text));
+        payload_hashes.push_back(std::move(stored.hash));
+        event_ids.push_back(IdGenerator::NewUuid());
+    }
+
+    if (event_ns.empty()) {
+        return 0;
+    }
+
+    auto result = ExecPrepared(
+        txn, kInsertEventsDeliveries,
+        ToArrayLiteral(event_ns),
+        ToArrayLiteral(tenant_ids),
+        ToArrayLiteral(event_types),
+        ToArrayLiteral(payloads),
+        ToArrayLiteral(delivery_ns),
+        ToArrayLiteral(webhook_ids),
+        ToArrayLiteral(urls),
+        ToArrayLiteral(signatures),
+        static_cast<int>(WebhookStatus::PENDING),
+        NOTIFY_CHANNEL,
+        ToArrayLiteral(payload_hashes),
+        blobs.Hashes(),
+        blobs.Data(),
+        ToArrayLiteral(event_ids),
+        ToArrayLiteral(delivery_ids)
+    );
+
+    size_t deliveries = result[0]["deliveries"].as<size_t>();
+    LogDebug("Webhook events queued", {{"events", event_ns.size()}, {"webhooks", deliveries}});
+    return deliveries;
+}
+
+WebhookDeliveryBatch WebhookDelivery::ClaimBatch(int batch_size) {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    // Get deliveries (from the hot partition only) that are:
     // 1. PENDING or RETRY status
     // 2. scheduled_at <= NOW()
     // 3. Ordered by scheduled_at ASC
     // 4. Lock for processing (FOR UPDATE SKIP LOCKED)
-    auto result = txn.exec_params(
-        "UPDATE webhook_deliveries SET status = $1 "
-        "WHERE id IN ("
-        "  SELECT id FROM webhook_deliveries "
-        "  WHERE (status = $2 OR status = $3) "
-        "  AND scheduled_at <= NOW() "
-        "  ORDER BY scheduled_at ASC "
-        "  LIMIT $4 "
-        "  FOR UPDATE SKIP LOCKED"
-        ") "
-        "RETURNING id, tenant_id, webhook_id, event_type, payload, url, signature, status, retry_count, "
-        "http_status_code, "
-        "EXTRACT(EPOCH FROM created_at)::bigint as created_at, "
-        "EXTRACT(EPOCH FROM scheduled_at)::bigint as scheduled_at, "
-        "EXTRACT(EPOCH FROM delivered_at)::bigint as delivered_at, "
-        "error_message",
+    auto result = ExecPrepared(
+        txn, kClaimBatch,
         static_cast<int>(WebhookStatus::SENDING),
-        static_cast<int>(WebhookStatus::PENDING),
-        static_cast<int>(WebhookStatus::RETRY),
         batch_size
     );
 
-    std::vector<WebhookDeliveryRecord> deliveries;
-    for (const auto& row : result) {
-        WebhookDeliveryRecord delivery;
-        delivery.id = row["id"].as<std::string>();
-        delivery.tenant_id = row["tenant_id"].as<std::string>();
-        delivery.webhook_id = row["webhook_id"].as<std::string>();
-        delivery.event_type = row["event_type"].as<std::string>();
-        delivery.payload = row["payload"].as<std::string>();
-        delivery.url = row["url"].as<std::string>();
-        delivery.signature = row["signature"].as<std::string>();
-        delivery.status = static_cast<WebhookStatus>(row["status"].as<int>());
-        delivery.retry_count = row["retry_count"].as<int>();
-        delivery.http_status_code = row["http_status_code"].is_null() ? 0 : row["http_status_code"].as<int>();
-        delivery.created_at = row["created_at"].as<int64_t>();
-        delivery.scheduled_at = row["scheduled_at"].as<int64_t>();
-        delivery.delivered_at = row["delivered_at"].is_null() ? 0 : row["delivered_at"].as<int64_t>();
-        delivery.error_message = row["error_message"].is_null() ? "" : row["error_message"].as<std::string>();
-
-        deliveries.push_back(delivery);
-    }
+    WebhookDeliveryBatch deliveries;
+    kDeliveryRow.ReadAll(result, deliveries);
 
     txn.commit();
 
-    std::cout << "Retrieved " << deliveries.size() << " webhook deliveries from queue" << std::endl;
+    LogDebug("Retrieved webhook deliveries from queue", {{"count", deliveries.size()}});
 
     return deliveries;
 }
 
-void WebhookDelivery::MarkDelivered(const std::string& delivery_id, int http_status) {
-    auto conn_guard = db_pool_->AcquireConnection();
+std::vector<WebhookDeliveryRecord> WebhookDelivery::GetNextBatch(int batch_size) {
+    return ClaimBatch(batch_size).ToVector();
+}
+
+void WebhookDelivery::DecodePayload(WebhookDeliveryRecord& delivery) {
+    if (delivery.payload_data.empty()) {
+        return;
+    }
+    delivery.payload = payloads_.DecodeBytea(delivery.payload_data);
+    delivery.payload_data.clear();
+}
+
+WebhookDeliveryBatch WebhookDelivery::WaitForClaimBatch(int batch_size, std::chrono::milliseconds max_wait) {
+    auto deadline = std::chrono::steady_clock::now() + max_wait;
+
+    while (true) {
+        // Read before polling so a NOTIFY racing with the poll still wakes us
+        uint64_t seen = notifier_ ? notifier_->Generation(NOTIFY_CHANNEL) : 0;
+
+        auto deliveries = ClaimBatch(batch_size);
+        auto now = std::chrono::steady_clock::now();
+        if (!deliveries.empty() || now >= deadline) {
+            return deliveries;
+        }
+
+        // Sleep until the earliest scheduled retry, a NOTIFY, or the deadline
+        auto wait = std::min(
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now),
+            TimeUntilNextDue(notifier_ ? notifier_->Options().fallback_poll : POLL_INTERVAL_WITHOUT_NOTIFY)
+        );
+
+        if (notifier_) {
+            notifier_->WaitForChange(NOTIFY_CHANNEL, seen, wait);
+        } else {
+            std::this_thread::sleep_for(wait);
+        }
+    }
+}
+
+std::vector<WebhookDeliveryRecord> WebhookDelivery::WaitForBatch(int batch_size, std::chrono::milliseconds max_wait) {
+    return WaitForClaimBatch(batch_size, max_wait).ToVector();
+}
+
+std::chrono::milliseconds WebhookDelivery::TimeUntilNextDue(std::chrono::milliseconds cap) {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    // Get webhook_id to reset failure count
-    auto result = txn.exec_params(
-        "SELECT webhook_id FROM webhook_deliveries WHERE id = $1",
-        delivery_id
-    );
+    auto result = ExecPrepared(txn, kNextDue);
+    txn.commit();
 
-    if (result.empty()) {
+    if (result.empty() || result[0]["due_in_ms"].is_null()) {
+        return cap;
+    }
+
+    // Due rows still held by another worker: back off briefly instead of spinning
+    auto due = std::chrono::milliseconds(result[0]["due_in_ms"].as<int64_t>());
+    return std::min(cap, std::max(due, MIN_POLL_INTERVAL));
+}
+
+void WebhookDelivery::MarkDelivered(const std::string& delivery_id, int http_status) {
+    if (MarkDeliveredBatch({{delivery_id, http_status, ""}}) == 0) {
         throw std::runtime_error("Delivery not found: " + delivery_id);
     }
+}
 
-    std::string webhook_id = result[0]["webhook_id"].as<std::string>();
+size_t WebhookDelivery::MarkDeliveredBatch(const std::vector<WebhookAttemptResult>& results) {
+    if (results.empty()) {
+        return 0;
+    }
 
-    // Mark delivery as successful
-    txn.exec_params(
-        "UPDATE webhook_deliveries SET status = $1, http_status_code = $2, delivered_at = NOW() "
-        "WHERE id = $3",
-        static_cast<int>(WebhookStatus::DELIVERED),
-        http_status,
-        delivery_id
-    );
+    std::vector<std::string> ids;
+    std::vector<std::string> statuses;
+    ids.reserve(results.size());
+    statuses.reserve(results.size());
+    for (const auto& result : results) {
+        ids.push_back(result.delivery_id);
+        statuses.push_back(std::to_string(result.http_status));
+    }
 
-    // Reset webhook failure count on success
-    txn.exec_params(
-        "UPDATE webhooks SET failure_count = 0, last_triggered_at = NOW() WHERE id = $1",
-        webhook_id
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = ExecPrepared(
+        txn, kMarkDeliveredBatch,
+        ToArrayLiteral(ids),
+        ToArrayLiteral(statuses),
+        static_cast<int>(WebhookStatus::DELIVERED)
     );
 
     txn.commit();
 
-    std::cout << "Webhook delivered successfully: " << delivery_id << " (HTTP " << http_status << ")" << std::endl;
+    size_t updated = result[0]["updated"].as<size_t>();
+    LogDebug("Webhooks delivered", {{"count", updated}});
+
+    return updated;
 }
 
 void WebhookDelivery::MarkFailed(const std::string& delivery_id, int http_status, const std::string& error_message) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    if (MarkFailedBatch({{delivery_id, http_status, error_message}}) == 0) {
+        throw std::runtime_error("Delivery not found: " + delivery_id);
+    }
+}
+
+size_t WebhookDelivery::MarkFailedBatch(const std::vector<WebhookAttemptResult>& results,
+                                        std::chrono::seconds hold_lease) {
+    if (results.empty()) {
+        return 0;
+    }
+
+    std::vector<std::string> ids;
+    std::vector<std::string> statuses;
+    std::vector<std::string> errors;
+    std::vector<std::string> held;
+    std::vector<std::string> batch_ids;
+    ids.reserve(results.size());
+    statuses.reserve(results.size());
+    errors.reserve(results.size());
+    held.reserve(results.size());
+    batch_ids.reserve(results.size());
+    for (const auto& result : results) {
+        ids.push_back(result.delivery_id);
+        statuses.push_back(std::to_string(result.http_status));
+        errors.push_back(result.error_message);
+        held.push_back(result.held ? "t" : "f");
+        batch_ids.push_back(result.batch_id);
+    }
+
+    // Backoff schedule indexed by the new retry count (1-based, as in SQL)
+    std::vector<std::string> delays;
+    for (int retry = 1; retry <= MAX_RETRIES; ++retry) {
+        delays.push_back(std::to_string(GetRetryDelay(retry)));
+    }
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    // Get current retry count and webhook_id
-    auto result = txn.exec_params(
-        "SELECT retry_count, webhook_id FROM webhook_deliveries WHERE id = $1",
-        delivery_id
+    auto result = ExecPrepared(
+        txn, kMarkFailedBatch,
+        ToArrayLiteral(ids),
+        ToArrayLiteral(statuses),
+        ToArrayLiteral(errors),
+        static_cast<int>(WebhookStatus::RETRY),
+        static_cast<int>(WebhookStatus::EXHAUSTED),
+        MAX_RETRIES,
+        ToArrayLiteral(delays),
+        MAX_CONSECUTIVE_FAILURES,
+        ToArrayLiteral(held),
+        static_cast<int>(hold_lease.count()),
+        ToArrayLiteral(batch_ids)
     );
 
-    if (result.empty()) {
-        throw std::runtime_error("Delivery not found: " + delivery_id);
+    txn.commit();
+
+    size_t updated = result[0]["updated"].as<size_t>();
+    LogInfo("Webhook failures recorded", {{"count", updated}, {"disabled", result[0]["disabled"].as<size_t>()}});
+
+    return updated;
+}
+
+size_t WebhookDelivery::ReleaseBatch(const std::vector<std::string>& delivery_ids, std::chrono::milliseconds delay) {
+    if (delivery_ids.empty()) {
+        return 0;
     }
 
-    int retry_count = result[0]["retry_count"].as<int>();
-    std::string webhook_id = result[0]["webhook_id"].as<std::string>();
-
-    if (ShouldRetry(retry_count, http_status)) {
-        // Schedule retry with exponential backoff
-        int new_retry_count = retry_count + 1;
-        int64_t delay_seconds = GetRetryDelay(new_retry_count);
-
-        txn.exec_params(
-            "UPDATE webhook_deliveries SET status = $1, retry_count = $2, http_status_code = $3, "
-            "error_message = $4, scheduled_at = NOW() + INTERVAL '$5 seconds' "
-            "WHERE id = $6",
-            static_cast<int>(WebhookStatus::RETRY),
-            new_retry_count,
-            http_status,
-            error_message,
-            delay_seconds,
-            delivery_id
-        );
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
 
-        std::cout << "Webhook scheduled for retry " << new_retry_count << " in " << delay_seconds << "s: "
-                  << delivery_id << std::endl;
-    } else {
-        // Max retries exhausted
-        txn.exec_params(
-            "UPDATE webhook_deliveries SET status = $1, http_status_code = $2, error_message = $3 "
-            "WHERE id = $4",
-            static_cast<int>(WebhookStatus::EXHAUSTED),
-            http_status,
-            error_message,
-            delivery_id
-        );
+    auto result = ExecPrepared(
+        txn, kReleaseBatch,
+        static_cast<int>(WebhookStatus::PENDING),
+        static_cast<int>(WebhookStatus::RETRY),
+        static_cast<double>(delay.count()) / 1000.0,
+        ToArrayLiteral(delivery_ids),
+        static_cast<int>(WebhookStatus::SENDING)
+    );
+
+    txn.commit();
+
+    return result.affected_rows();
+}
 
-        std::cout << "Webhook max retries exhausted: " << delivery_id << std::endl;
+std::vector<std::string> WebhookDelivery::ReclaimHeldBatch(const std::vector<WebhookDeliveryRecord>& held) {
+    if (held.empty()) {
+        return {};
     }
+    auto [ids, retry_counts] = HeldArrays(held);
 
-    // Increment webhook failure count
-    txn.exec_params(
-        "UPDATE webhooks SET failure_count = failure_count + 1 WHERE id = $1",
-        webhook_id
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = ExecPrepared(
+        txn, kReclaimHeldBatch,
+        ids,
+        retry_counts,
+        static_cast<int>(WebhookStatus::SENDING)
     );
 
-    // Check if we should disable the webhook (10+ consecutive failures)
-    int consecutive_failures = GetConsecutiveFailures(webhook_id);
-    if (consecutive_failures >= 10) {
-        DisableWebhook(webhook_id, "Too many consecutive failures (" + std::to_string(consecutive_failures) + ")");
+    txn.commit();
+
+    std::vector<std::string> reclaimed;
+    reclaimed.reserve(result.size());
+    for (const auto& row : result) {
+        reclaimed.push_back(row["id"].as<std::string>());
     }
+    return reclaimed;
+}
+
+size_t WebhookDelivery::ReleaseHeldBatch(const std::vector<WebhookDeliveryRecord>& held,
+                                         std::chrono::seconds hold_lease) {
+    if (held.empty()) {
+        return 0;
+    }
+    auto [ids, retry_counts] = HeldArrays(held);
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+
+    auto result = ExecPrepared(
+        txn, kReleaseHeldBatch,
+        ids,
+        retry_counts,
+        static_cast<int>(hold_lease.count())
+    );
 
     txn.commit();
+
+    return result.affected_rows();
 }
 
 std::optional<WebhookDeliveryRecord> WebhookDelivery::GetStatus(const std::string& delivery_id) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    auto result = txn.exec_params(
-        "SELECT id, tenant_id, webhook_id, event_type, payload, url, signature, status, retry_count, "
-        "http_status_code, "
-        "EXTRACT(EPOCH FROM created_at)::bigint as created_at, "
-        "EXTRACT(EPOCH FROM scheduled_at)::bigint as scheduled_at, "
-        "EXTRACT(EPOCH FROM delivered_at)::bigint as delivered_at, "
-        "error_message "
-        "FROM webhook_deliveries WHERE id = $1",
+    auto result = ExecPrepared(
+        txn, kSelectDelivery,
         delivery_id
     );
 
@@ -256,32 +749,19 @@ std::optional<WebhookDeliveryRecord> WebhookDelivery::GetStatus(const std::strin
         return std::nullopt;
     }
 
-    auto row = result[0];
     WebhookDeliveryRecord delivery;
-    delivery.id = row["id"].as<std::string>();
-    delivery.tenant_id = row["tenant_id"].as<std::string>();
-    delivery.webhook_id = row["webhook_id"].as<std::string>();
-    delivery.event_type = row["event_type"].as<std::string>();
-    delivery.payload = row["payload"].as<std::string>();
-    delivery.url = row["url"].as<std::string>();
-    delivery.signature = row["signature"].as<std::string>();
-    delivery.status = static_cast<WebhookStatus>(row["status"].as<int>());
-    delivery.retry_count = row["retry_count"].as<int>();
-    delivery.http_status_code = row["http_status_code"].is_null() ? 0 : row["http_status_code"].as<int>();
-    delivery.created_at = row["created_at"].as<int64_t>();
-    delivery.scheduled_at = row["scheduled_at"].as<int64_t>();
-    delivery.delivered_at = row["delivered_at"].is_null() ? 0 : row["delivered_at"].as<int64_t>();
-    delivery.error_message = row["error_message"].is_null() ? "" : row["error_message"].as<std::string>();
+    kDeliveryRow.Read(result[0], delivery);
+    DecodePayload(delivery);
 
     return delivery;
 }
 
 int WebhookDelivery::GetConsecutiveFailures(const std::string& webhook_id) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    auto result = txn.exec_params(
-        "SELECT failure_count FROM webhooks WHERE id = $1",
+    auto result = ExecPrepared(
+        txn, kSelectFailureCount,
         webhook_id
     );
 
@@ -293,18 +773,18 @@ int WebhookDelivery::GetConsecutiveFailures(const std::string& webhook_id) {
 }
 
 void WebhookDelivery::DisableWebhook(const std::string& webhook_id, const std::string& reason) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    txn.exec_params(
-        "UPDATE webhooks SET status = 'disabled', disabled_reason = $1 WHERE id = $2",
+    ExecPrepared(
+        txn, kDisable,
         reason,
         webhook_id
     );
 
     txn.commit();
 
-    std::cout << "Webhook disabled: " << webhook_id << " (" << reason << ")" << std::endl;
+    LogWarn("Webhook disabled", {{"webhook_id", webhook_id}, {"reason", reason}});
 }
 
 int64_t WebhookDelivery::GetRetryDelay(int retry_count) {
@@ -398,6 +878,24 @@ bool WebhookDelivery::ValidateUrl(const std::string& url) {
     return true;
 }
 
+bool WebhookDelivery::ValidateUrl(const std::string& url, DnsCache& dns_cache) {
+    if (!ValidateUrl(url)) {
+        return false;
+    }
+
+    auto endpoint = DnsCache::ParseUrl(url);
+    if (!endpoint) {
+        return false;
+    }
+
+    auto result = dns_cache.Resolve(endpoint->host);
+    if (result.status != DnsStatus::OK) {
+        LogWarn("Webhook URL rejected", {{"error", result.error}});
+        return false;
+    }
+    return true;
+}
+
 std::string WebhookDelivery::StatusToString(WebhookStatus status) {
     switch (status) {
         case WebhookStatus::PENDING: return "pending";
@@ -427,7 +925,7 @@ bool WebhookDelivery::ShouldRetry(int retry_count, int http_status) {
     }
 
     // Max 5 retries (Requirement D-104)
-    return retry_count < 5;
+    return retry_count < MAX_RETRIES;
 }
 
 } // namespace common
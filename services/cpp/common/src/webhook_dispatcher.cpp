@@ -0,0 +1,723 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Concurrent HTTP webhook dispatcher implementation
+ */
+
+#include "common/webhook_dispatcher.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/string_builder.h"
+#include "common/webhook_signer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <curl/curl.h>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+constexpr const char* USER_AGENT = "SaaSForge-Webhooks/1.0";
+constexpr const char* UNDECODABLE_PAYLOAD = "Stored payload could not be decoded";
+
+// Dispatch loop sleep while only DNS lookups are outstanding
+constexpr std::chrono::milliseconds DNS_WAIT{5};
+
+// Webhook responses are not used; only the status code matters
+size_t DiscardBody(char* data, size_t size, size_t nmemb, void* userdata) {
+    return size * nmemb;
+}
+
+void Decrement(std::unordered_map<std::string, size_t>& counts, const std::string& key) {
+    auto it = counts.find(key);
+    if (it != counts.end() && --it->second == 0) {
+        counts.erase(it);
+    }
+}
+
+size_t CountOf(const std::unordered_map<std::string, size_t>& counts, const std::string& key) {
+    auto it = counts.find(key);
+    return it == counts.end() ? 0 : it->second;
+}
+
+std::once_flag curl_init_once;
+
+} // namespace
+
+struct WebhookDispatcher::Attempt {
+    WebhookDeliveryRecord record;
+    std::string host;
+    std::vector<std::string> batch_ids;
+    curl_slist* headers = nullptr;
+    curl_slist* resolve = nullptr;
+    char error[CURL_ERROR_SIZE] = {0};
+};
+
+WebhookDispatcherOptions WebhookDispatcherOptions::FromEnv() {
+    WebhookDispatcherOptions options;
+    options.max_in_flight = static_cast<size_t>(
+        EnvInt("WEBHOOK_MAX_IN_FLIGHT", static_cast<long>(options.max_in_flight)));
+    options.max_per_host = static_cast<size_t>(
+        EnvInt("WEBHOOK_MAX_PER_HOST", static_cast<long>(options.max_per_host)));
+    options.max_per_tenant = static_cast<size_t>(
+        EnvInt("WEBHOOK_MAX_PER_TENANT", static_cast<long>(options.max_per_tenant)));
+    options.connect_timeout = std::chrono::milliseconds(
+        EnvInt("WEBHOOK_CONNECT_TIMEOUT_MS", static_cast<long>(options.connect_timeout.count())));
+    options.request_timeout = std::chrono::milliseconds(
+        EnvInt("WEBHOOK_REQUEST_TIMEOUT_MS", static_cast<long>(options.request_timeout.count())));
+    options.batch_size = static_cast<int>(EnvInt("WEBHOOK_DISPATCH_BATCH_SIZE", options.batch_size));
+    options.hold_max = std::chrono::milliseconds(
+        EnvInt("WEBHOOK_RETRY_HOLD_MAX_MS", static_cast<long>(options.hold_max.count())));
+    options.hold_lease = std::chrono::seconds(
+        EnvInt("WEBHOOK_RETRY_HOLD_LEASE_S", static_cast<long>(options.hold_lease.count())));
+    options.max_held = static_cast<size_t>(
+        EnvInt("WEBHOOK_MAX_HELD_RETRIES", static_cast<long>(options.max_held)));
+    options.max_batched = static_cast<size_t>(
+        EnvInt("WEBHOOK_MAX_BATCHED", static_cast<long>(options.max_batched)));
+    return options;
+}
+
+WebhookDispatcher::WebhookDispatcher(
+    std::shared_ptr<WebhookDelivery> delivery,
+    const WebhookDispatcherOptions& options,
+    std::shared_ptr<DnsCache> dns_cache,
+    std::shared_ptr<EndpointHealth> health
+) : delivery_(delivery), options_(options), dns_cache_(dns_cache), health_(health) {
+    if (!delivery_) {
+        throw std::invalid_argument("WebhookDispatcher requires a WebhookDelivery");
+    }
+    if (!dns_cache_) {
+        dns_cache_ = std::make_shared<DnsCache>(DnsCacheOptions::FromEnv());
+    }
+    if (!health_) {
+        health_ = std::make_shared<EndpointHealth>(nullptr, EndpointHealthOptions::FromEnv());
+    }
+    options_.max_in_flight = std::max<size_t>(options_.max_in_flight, 1);
+    options_.max_per_host = std::max<size_t>(options_.max_per_host, 1);
+    options_.max_per_tenant = std::max<size_t>(options_.max_per_tenant, 1);
+    options_.batch_size = std::max(options_.batch_size, 1);
+
+    std::call_once(curl_init_once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("Failed to create libcurl multi handle");
+    }
+    // Multiplex over HTTP/2 where negotiated; otherwise at most max_per_host
+    // keep-alive connections per destination, reused across attempts
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, static_cast<long>(CURLPIPE_MULTIPLEX));
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options_.max_per_host));
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(options_.max_in_flight));
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(options_.max_in_flight));
+    multi_ = multi;
+
+    dispatch_thread_ = std::thread(&WebhookDispatcher::DispatchLoop, this);
+
+    LogInfo("WebhookDispatcher started", {{"max_in_flight", options_.max_in_flight},
+                                         {"max_per_host", options_.max_per_host},
+                                         {"max_per_tenant", options_.max_per_tenant}});
+}
+
+WebhookDispatcher::~WebhookDispatcher() {
+    Shutdown();
+
+    for (void* easy : idle_handles_) {
+        curl_easy_cleanup(static_cast<CURL*>(easy));
+    }
+    curl_multi_cleanup(static_cast<CURLM*>(multi_));
+}
+
+void WebhookDispatcher::Shutdown() {
+    if (shutdown_.exchange(true)) {
+        return;
+    }
+    curl_multi_wakeup(static_cast<CURLM*>(multi_));
+    if (dispatch_thread_.joinable()) {
+        dispatch_thread_.join();
+    }
+}
+
+WebhookDispatcherStats WebhookDispatcher::GetStats() const {
+    WebhookDispatcherStats stats;
+    stats.in_flight = in_flight_.load();
+    stats.waiting = waiting_count_.load();
+    stats.delivered = delivered_.load();
+    stats.failed = failed_.load();
+    stats.released = released_.load();
+    stats.deferred = deferred_.load();
+    stats.held = held_count_.load();
+    stats.resent = resent_.load();
+    stats.batching = batching_count_.load();
+    stats.batches = batches_.load();
+    return stats;
+}
+
+std::string WebhookDispatcher::HostKey(const std::string& url) {
+    auto endpoint = DnsCache::ParseUrl(url);
+    if (!endpoint) {
+        return "";
+    }
+    bool ipv6 = endpoint->host.find(':') != std::string::npos;
+    std::string host = ipv6 ? "[" + endpoint->host + "]" : endpoint->host;
+    return endpoint->scheme + "://" + host + ":" + std::to_string(endpoint->port);
+}
+
+std::string WebhookDispatcher::BatchBody(const std::vector<WebhookDeliveryRecord>& records) {
+    size_t size = 2;
+    for (const auto& record : records) {
+        size += record.payload.size() + record.id.size() + record.event_type.size() + 64;
+    }
+    std::string body;
+    body.reserve(size);
+    body += '[';
+    for (const auto& record : records) {
+        body += body.size() > 1 ? ",{\"id\":" : "{\"id\":";
+        AppendJsonString(body, record.id);
+        body += ",\"event_type\":";
+        AppendJsonString(body, record.event_type);
+        body += ",\"created_at\":";
+        body += std::to_string(record.created_at);
+        body += ",\"payload\":";
+        body += record.payload.empty() ? std::string_view("null") : std::string_view(record.payload);
+        body += '}';
+    }
+    body += ']';
+    return body;
+}
+
+void WebhookDispatcher::DispatchLoop() {
+    last_tick_ = std::chrono::steady_clock::now() - options_.tick;
+
+    while (true) {
+        bool stopping = shutdown_.load();
+        if (stopping && in_flight_.load() == 0) {
+            break;
+        }
+
+        try {
+            auto now = std::chrono::steady_clock::now();
+            bool idle = in_flight_.load() == 0;
+            bool tick_due = now - last_tick_ >= options_.tick;
+
+            // Results are written back before blocking for new work
+            if (tick_due || idle || stopping) {
+                Flush(stopping);
+                last_tick_ = now;
+            }
+
+            if (stopping) {
+                SealBatches(true);
+                ReleaseWaiting(true);
+            } else {
+                ResendHeld();
+                if (tick_due || (idle && waiting_.empty())) {
+                    Claim(idle && waiting_.empty());
+                }
+                SealBatches(batching_size_ >= options_.max_batched);
+            }
+
+            Admit();
+            ReleaseWaiting(false);
+            waiting_count_.store(waiting_.size());
+            held_count_.store(held_.Size() + to_hold_.size());
+            batching_count_.store(batching_size_);
+
+            int running = 0;
+            curl_multi_perform(static_cast<CURLM*>(multi_), &running);
+            CollectCompleted();
+
+            if (in_flight_.load() > 0) {
+                curl_multi_poll(static_cast<CURLM*>(multi_), nullptr, 0,
+                                static_cast<int>(UntilNextDue(options_.tick).count()), nullptr);
+            } else if (!waiting_.empty()) {
+                std::this_thread::sleep_for(DNS_WAIT);
+            }
+        } catch (const std::exception& e) {
+            LogError("WebhookDispatcher error", {{"error", e.what()}});
+            std::this_thread::sleep_for(options_.tick);
+        }
+    }
+
+    try {
+        // Shutdown can end the loop before its release pass ran
+        SealBatches(true);
+        ReleaseWaiting(true);
+        Flush(true);
+        ReleaseHeld();
+    } catch (const std::exception& e) {
+        LogError("WebhookDispatcher final flush failed", {{"error", e.what()}});
+    }
+}
+
+void WebhookDispatcher::Claim(bool idle) {
+    size_t in_flight = in_flight_.load();
+    if (in_flight + waiting_.size() >= options_.max_in_flight) {
+        return;
+    }
+    int want = static_cast<int>(std::min<size_t>(
+        static_cast<size_t>(options_.batch_size),
+        options_.max_in_flight - in_flight - waiting_.size()));
+
+    // Nothing to drive: block on the queue (NOTIFY wakeup) instead of spinning,
+    // but no longer than the next held retry or batch deadline
+    auto batch = idle ? delivery_->WaitForClaimBatch(want, UntilNextDue(options_.idle_wait))
+                      : delivery_->ClaimBatch(want);
+
+    // Rows are routed from the batch's columns; only those kept become records
+    for (const auto& row : batch) {
+        std::string host = HostKey(std::string(row.Get<&WebhookDeliveryRecord::url>()));
+        if (host.empty()) {
+            failed_results_.push_back({std::string(row.Get<&WebhookDeliveryRecord::id>()), 0, "Invalid webhook URL"});
+            ++failed_;
+            continue;
+        }
+        auto record = row.ToRecord();
+        if (record.batch_max_events > 1) {
+            AddToBatch(std::move(record), std::move(host));
+            continue;
+        }
+        if (record.signature.empty()) {
+            // Queued while the webhook was in batch mode
+            if (!Decode(record)) {
+                failed_results_.push_back({record.id, 0, UNDECODABLE_PAYLOAD});
+                ++failed_;
+                continue;
+            }
+            std::string secret = WebhookSigner::GetMockWebhookSecret(record.tenant_id, record.webhook_id);
+            record.signature = WebhookSigner::GetSigningKey(record.tenant_id, record.webhook_id, secret)
+                ->Sign(record.payload);
+        }
+        waiting_.push_back({std::move(record), std::move(host), {}});
+    }
+}
+
+void WebhookDispatcher::Admit() {
+    size_t pending = waiting_.size();
+    for (size_t i = 0; i < pending && in_flight_.load() < options_.max_in_flight; ++i) {
+        auto entry = std::move(waiting_.front());
+        waiting_.pop_front();
+
+        if (CountOf(host_in_flight_, entry.host) >= options_.max_per_host ||
+            CountOf(tenant_in_flight_, entry.record.tenant_id) >= options_.max_per_tenant) {
+            waiting_.push_back(std::move(entry));
+            continue;
+        }
+
+        // A known-dead endpoint is not attempted (nor resolved) until its circuit half-opens
+        if (health_->RetryAfter(entry.host).count() > 0) {
+            auto& deferred = to_defer_[entry.host];
+            if (entry.batch_ids.empty()) {
+                deferred.push_back(std::move(entry.record.id));
+                ++deferred_;
+            } else {
+                deferred_ += entry.batch_ids.size();
+                std::move(entry.batch_ids.begin(), entry.batch_ids.end(), std::back_inserter(deferred));
+            }
+            continue;
+        }
+
+        // Resolve-then-check; a lookup in progress leaves the row waiting
+        auto endpoint = DnsCache::ParseUrl(entry.record.url);
+        auto dns = dns_cache_->TryGet(endpoint->host);
+        if (!dns) {
+            waiting_.push_back(std::move(entry));
+            continue;
+        }
+        if (dns->status != DnsStatus::OK) {
+            Fail(std::move(entry), 0, dns->error);
+            continue;
+        }
+
+        // Half-open: only the probe goes; the rest wait for its outcome
+        if (!health_->Allow(entry.host)) {
+            waiting_.push_back(std::move(entry));
+            continue;
+        }
+
+        // Deferred or released rows never get this far, so they are never inflated
+        if (!Decode(entry.record)) {
+            Fail(std::move(entry), 0, UNDECODABLE_PAYLOAD);
+            continue;
+        }
+
+        std::vector<std::string> ids = entry.batch_ids.empty() ? std::vector<std::string>{entry.record.id}
+                                                                : entry.batch_ids;
+        if (!Start(std::move(entry), *dns)) {
+            for (auto& id : ids) {
+                failed_results_.push_back({std::move(id), 0, "Failed to start HTTP request"});
+            }
+            failed_ += ids.size();
+        }
+    }
+}
+
+bool WebhookDispatcher::Start(Pending pending, const DnsResult& dns) {
+    CURL* easy = nullptr;
+    if (!idle_handles_.empty()) {
+        easy = static_cast<CURL*>(idle_handles_.back());
+        idle_handles_.pop_back();
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+    }
+    if (!easy) {
+        return false;
+    }
+
+    auto attempt = std::make_unique<Attempt>();
+    attempt->record = std::move(pending.record);
+    attempt->host = std::move(pending.host);
+    attempt->batch_ids = std::move(pending.batch_ids);
+
+    const auto& r = attempt->record;
+    attempt->headers = curl_slist_append(attempt->headers, "Content-Type: application/json");
+    attempt->headers = curl_slist_append(attempt->headers, ("X-Webhook-Signature: sha256=" + r.signature).c_str());
+    attempt->headers = curl_slist_append(attempt->headers, ("X-Webhook-Event: " + r.event_type).c_str());
+    attempt->headers = curl_slist_append(attempt->headers, ("X-Webhook-Delivery: " + r.id).c_str());
+    if (!attempt->batch_ids.empty()) {
+        attempt->headers = curl_slist_append(
+            attempt->headers, ("X-Webhook-Batch-Size: " + std::to_string(attempt->batch_ids.size())).c_str());
+    }
+    attempt->headers = curl_slist_append(attempt->headers, "Expect:");  // No 100-continue round trip
+
+    // Pin the connection to the validated addresses ("host:port:addr,addr")
+    auto endpoint = DnsCache::ParseUrl(r.url);
+    std::string pinned = endpoint->host + ":" + std::to_string(endpoint->port) + ":";
+    for (size_t i = 0; i < dns.addresses.size(); ++i) {
+        const auto& address = dns.addresses[i];
+        pinned += (i > 0 ? "," : "");
+        pinned += address.find(':') != std::string::npos ? "[" + address + "]" : address;
+    }
+    attempt->resolve = curl_slist_append(attempt->resolve, pinned.c_str());
+
+    curl_easy_setopt(easy, CURLOPT_URL, r.url.c_str());
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, r.payload.data());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(r.payload.size()));
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, attempt->headers);
+    curl_easy_setopt(easy, CURLOPT_RESOLVE, attempt->resolve);
+    curl_easy_setopt(easy, CURLOPT_USERAGENT, USER_AGENT);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, DiscardBody);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, attempt->error);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 0L);
+    curl_easy_setopt(easy, CURLOPT_PROTOCOLS_STR, "http,https");
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(options_.connect_timeout.count()));
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(options_.request_timeout.count()));
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, attempt.get());
+
+    if (curl_multi_add_handle(static_cast<CURLM*>(multi_), easy) != CURLM_OK) {
+        curl_slist_free_all(attempt->headers);
+        curl_slist_free_all(attempt->resolve);
+        curl_easy_cleanup(easy);
+        return false;
+    }
+
+    ++host_in_flight_[attempt->host];
+    ++tenant_in_flight_[attempt->record.tenant_id];
+    ++in_flight_;
+    if (!attempt->batch_ids.empty()) {
+        ++batches_;
+    }
+    attempt.release();  // Reclaimed in CollectCompleted()
+    return true;
+}
+
+void WebhookDispatcher::CollectCompleted() {
+    int remaining = 0;
+    while (CURLMsg* msg = curl_multi_info_read(static_cast<CURLM*>(multi_), &remaining)) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        CURL* easy = msg->easy_handle;
+        CURLcode code = msg->data.result;
+
+        char* priv = nullptr;
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+        std::unique_ptr<Attempt> attempt(reinterpret_cast<Attempt*>(priv));
+
+        long http_status = 0;
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &http_status);
+        curl_off_t total_us = 0;
+        curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total_us);
+
+        curl_multi_remove_handle(static_cast<CURLM*>(multi_), easy);
+        curl_slist_free_all(attempt->headers);
+        curl_slist_free_all(attempt->resolve);
+        if (idle_handles_.size() < options_.max_in_flight) {
+            idle_handles_.push_back(easy);
+        } else {
+            curl_easy_cleanup(easy);
+        }
+
+        Decrement(host_in_flight_, attempt->host);
+        Decrement(tenant_in_flight_, attempt->record.tenant_id);
+        --in_flight_;
+
+        // Any answer short of 5xx/429 means the endpoint is up, even if it rejected this delivery
+        auto latency = std::chrono::milliseconds(total_us / 1000);
+        if (code == CURLE_OK && http_status < 500 && http_status != 429) {
+            health_->RecordSuccess(attempt->host, latency);
+        } else {
+            health_->RecordFailure(attempt->host, latency);
+        }
+
+        Pending done{std::move(attempt->record), std::move(attempt->host), std::move(attempt->batch_ids)};
+        if (code == CURLE_OK && http_status >= 200 && http_status < 300) {
+            if (done.batch_ids.empty()) {
+                delivered_results_.push_back({done.record.id, static_cast<int>(http_status), ""});
+                ++delivered_;
+            } else {
+                for (auto& id : done.batch_ids) {
+                    delivered_results_.push_back({std::move(id), static_cast<int>(http_status), ""});
+                }
+                delivered_ += done.batch_ids.size();
+            }
+        } else if (code == CURLE_OK) {
+            Fail(std::move(done), static_cast<int>(http_status), "HTTP " + std::to_string(http_status));
+        } else {
+            // Connection errors and timeouts are recorded as status 0 (retryable)
+            std::string error = attempt->error[0] ? attempt->error : curl_easy_strerror(code);
+            Fail(std::move(done), 0, std::move(error));
+        }
+    }
+}
+
+void WebhookDispatcher::Flush(bool force) {
+    // Each list is cleared only once written, so a DB error retries next tick
+    if (!delivered_results_.empty()) {
+        delivery_->MarkDeliveredBatch(delivered_results_);
+        delivered_results_.clear();
+    }
+    if (!failed_results_.empty()) {
+        delivery_->MarkFailedBatch(failed_results_, options_.hold_lease);
+        failed_results_.clear();
+        // Only now is each held retry recorded, and kept from other pollers
+        for (auto& held : to_hold_) {
+            auto due = held.due;
+            held_.Schedule(std::move(held), due);
+        }
+        to_hold_.clear();
+    }
+    if (!to_release_.empty()) {
+        delivery_->ReleaseBatch(to_release_, force ? std::chrono::milliseconds(0) : options_.release_delay);
+        released_ += to_release_.size();
+        to_release_.clear();
+    }
+    // Per host, so each group becomes claimable when its circuit half-opens
+    for (auto it = to_defer_.begin(); it != to_defer_.end();) {
+        auto delay = std::max(health_->RetryAfter(it->first), options_.release_delay);
+        delivery_->ReleaseBatch(it->second, delay);
+        it = to_defer_.erase(it);
+    }
+}
+
+void WebhookDispatcher::ReleaseWaiting(bool all) {
+    if (waiting_.empty()) {
+        return;
+    }
+
+    // Keep at most one round of work per saturated host/tenant locally; the
+    // rest goes back to the queue so it cannot crowd out other destinations
+    std::unordered_map<std::string, size_t> host_waiting;
+    std::unordered_map<std::string, size_t> tenant_waiting;
+    std::deque<Pending> kept;
+
+    for (auto& entry : waiting_) {
+        size_t& host_count = host_waiting[entry.host];
+        size_t& tenant_count = tenant_waiting[entry.record.tenant_id];
+        if (all || host_count >= options_.max_per_host || tenant_count >= options_.max_per_tenant) {
+            if (entry.batch_ids.empty()) {
+                to_release_.push_back(std::move(entry.record.id));
+            } else {
+                std::move(entry.batch_ids.begin(), entry.batch_ids.end(), std::back_inserter(to_release_));
+            }
+            continue;
+        }
+        ++host_count;
+        ++tenant_count;
+        kept.push_back(std::move(entry));
+    }
+
+    waiting_.swap(kept);
+}
+
+void WebhookDispatcher::Fail(WebhookDeliveryRecord record, std::string host, int http_status, std::string error) {
+    ++failed_;
+    WebhookAttemptResult result{record.id, http_status, std::move(error)};
+
+    // A short backoff is waited out here; the table only sees it if we die
+    auto delay = std::chrono::seconds(WebhookDelivery::GetRetryDelay(record.retry_count + 1));
+    if (!shutdown_.load() && WebhookDelivery::ShouldRetry(record.retry_count, http_status) &&
+        delay <= options_.hold_max && held_.Size() + to_hold_.size() < options_.max_held) {
+        result.held = true;
+        ++record.retry_count;
+        to_hold_.push_back({std::move(record), std::move(host), std::chrono::steady_clock::now() + delay});
+    }
+    failed_results_.push_back(std::move(result));
+}
+
+void WebhookDispatcher::Fail(Pending pending, int http_status, std::string error) {
+    if (pending.batch_ids.empty()) {
+        Fail(std::move(pending.record), std::move(pending.host), http_status, std::move(error));
+        return;
+    }
+    // Members share the POST's outcome but are retried by the table, one
+    // failure against the webhook for the whole batch
+    std::string batch_id = pending.record.id;
+    for (auto& id : pending.batch_ids) {
+        WebhookAttemptResult result{std::move(id), http_status, error};
+        result.batch_id = batch_id;
+        failed_results_.push_back(std::move(result));
+    }
+    failed_ += pending.batch_ids.size();
+}
+
+void WebhookDispatcher::ResendHeld() {
+    if (held_.Empty()) {
+        return;
+    }
+    auto due = held_.Advance(std::chrono::steady_clock::now());
+    if (due.empty()) {
+        return;
+    }
+
+    std::vector<WebhookDeliveryRecord> records;
+    records.reserve(due.size());
+    for (auto& held : due) {
+        records.push_back(std::move(held.record));
+    }
+
+    std::vector<std::string> reclaimed;
+    try {
+        reclaimed = delivery_->ReclaimHeldBatch(records);
+    } catch (const std::exception& e) {
+        // Still held in the table; try again shortly
+        LogError("Reclaiming held webhook retries failed", {{"deliveries", records.size()}, {"error", e.what()}});
+        auto retry_at = std::chrono::steady_clock::now() + options_.release_delay;
+        for (size_t i = 0; i < due.size(); ++i) {
+            due[i].record = std::move(records[i]);
+            held_.Schedule(std::move(due[i]), retry_at);
+        }
+        return;
+    }
+
+    // A delivery not reclaimed was taken by another poller after the lease
+    std::unordered_set<std::string> owned(std::make_move_iterator(reclaimed.begin()),
+                                          std::make_move_iterator(reclaimed.end()));
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (owned.count(records[i].id)) {
+            waiting_.push_back({std::move(records[i]), std::move(due[i].host), {}});
+        }
+    }
+    resent_ += owned.size();
+}
+
+void WebhookDispatcher::ReleaseHeld() {
+    auto held = held_.Drain();
+    if (held.empty()) {
+        return;
+    }
+    std::vector<WebhookDeliveryRecord> records;
+    records.reserve(held.size());
+    for (auto& entry : held) {
+        records.push_back(std::move(entry.record));
+    }
+    size_t released = delivery_->ReleaseHeldBatch(records, options_.hold_lease);
+    LogInfo("Released held webhook retries", {{"held", records.size()}, {"released", released}});
+}
+
+bool WebhookDispatcher::Decode(WebhookDeliveryRecord& record) {
+    if (record.payload_data.empty()) {
+        return true;
+    }
+    try {
+        delivery_->DecodePayload(record);
+        return true;
+    } catch (const std::exception& e) {
+        LogWarn("Failed to decode webhook payload", {{"delivery_id", record.id}, {"error", e.what()}});
+        return false;
+    }
+}
+
+void WebhookDispatcher::AddToBatch(WebhookDeliveryRecord record, std::string host) {
+    auto& batch = batching_[record.webhook_id + " " + record.url];
+    if (batch.records.empty()) {
+        batch.host = std::move(host);
+        batch.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(record.batch_window_ms);
+    }
+    size_t max_events = static_cast<size_t>(std::min(record.batch_max_events, WebhookDelivery::MAX_BATCH_EVENTS));
+    batch.records.push_back(std::move(record));
+    ++batching_size_;
+    if (batch.records.size() >= max_events) {
+        batch.deadline = std::chrono::steady_clock::now();  // Full: sealed this pass
+    }
+}
+
+void WebhookDispatcher::SealBatches(bool all) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = batching_.begin(); it != batching_.end();) {
+        if (!all && it->second.deadline > now) {
+            ++it;
+            continue;
+        }
+        auto& batch = it->second;
+        batching_size_ -= batch.records.size();
+        // Members that cannot be decoded fail on their own
+        auto undecodable = std::stable_partition(batch.records.begin(), batch.records.end(),
+                                                 [this](auto& record) { return Decode(record); });
+        for (auto member = undecodable; member != batch.records.end(); ++member) {
+            Fail(std::move(*member), batch.host, 0, UNDECODABLE_PAYLOAD);
+        }
+        batch.records.erase(undecodable, batch.records.end());
+        if (!batch.records.empty()) {
+            waiting_.push_back(Seal(std::move(batch)));
+        }
+        it = batching_.erase(it);
+    }
+}
+
+WebhookDispatcher::Pending WebhookDispatcher::Seal(OpenBatch batch) {
+    Pending pending;
+    pending.host = std::move(batch.host);
+    pending.batch_ids.reserve(batch.records.size());
+
+    for (const auto& record : batch.records) {
+        pending.batch_ids.push_back(record.id);
+    }
+    std::string body = BatchBody(batch.records);
+
+    // The first member stands for the batch (URL, tenant, X-Webhook-Delivery)
+    auto& lead = batch.records.front();
+    std::string secret = WebhookSigner::GetMockWebhookSecret(lead.tenant_id, lead.webhook_id);
+    lead.signature = WebhookSigner::GetSigningKey(lead.tenant_id, lead.webhook_id, secret)->Sign(body);
+    lead.payload = std::move(body);
+    lead.event_type = "batch";
+    pending.record = std::move(lead);
+    return pending;
+}
+
+std::chrono::milliseconds WebhookDispatcher::UntilNextDue(std::chrono::milliseconds cap) const {
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& [key, batch] : batching_) {
+        auto until = std::chrono::duration_cast<std::chrono::milliseconds>(batch.deadline - now);
+        cap = std::clamp(until + std::chrono::milliseconds(1), std::chrono::milliseconds(0), cap);
+    }
+    auto next = held_.NextDue();
+    if (!next) {
+        return cap;
+    }
+    auto until = std::chrono::duration_cast<std::chrono::milliseconds>(*next - now);
+    return std::clamp(until + std::chrono::milliseconds(1), std::chrono::milliseconds(0), cap);
+}
+
+} // namespace common
+} // namespace saasforge
@@ -5,18 +5,116 @@
  */
 
 #include "common/webhook_signer.h"
+#include "common/codec.h"
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
 #include <openssl/hmac.h>
-#include <openssl/sha.h>
-#include <sstream>
-#include <iomanip>
-#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace saasforge {
 namespace common {
 
+namespace {
+
+// EVP_MAC_fetch() walks the provider registry; do it once per process
+EVP_MAC* HmacAlgorithm() {
+    static EVP_MAC* mac = EVP_MAC_fetch(nullptr, OSSL_MAC_NAME_HMAC, nullptr);
+    return mac;
+}
+
+struct KeyCache {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const WebhookSigningKey>> keys;
+};
+
+KeyCache& Cache() {
+    static KeyCache cache;
+    return cache;
+}
+
+std::string CacheKey(const std::string& tenant_id, const std::string& webhook_id) {
+    std::string key;
+    key.reserve(tenant_id.size() + webhook_id.size() + 1);
+    key.append(tenant_id).push_back('\0');
+    key.append(webhook_id);
+    return key;
+}
+
+} // namespace
+
+WebhookSigningKey::WebhookSigningKey(std::string_view secret) : secret_(secret) {
+    EVP_MAC* mac = HmacAlgorithm();
+    EVP_MAC_CTX* ctx = mac ? EVP_MAC_CTX_new(mac) : nullptr;
+    if (!ctx) {
+        throw std::runtime_error("Failed to create HMAC context");
+    }
+
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+    if (EVP_MAC_init(ctx, reinterpret_cast<const unsigned char*>(secret_.data()),
+                     secret_.size(), params) != 1) {
+        EVP_MAC_CTX_free(ctx);
+        throw std::runtime_error("Failed to initialize HMAC key");
+    }
+    ctx_ = ctx;
+}
+
+WebhookSigningKey::~WebhookSigningKey() {
+    EVP_MAC_CTX_free(static_cast<EVP_MAC_CTX*>(ctx_));
+}
+
+template <typename Feed>
+std::string WebhookSigningKey::SignWith(Feed feed) const {
+    // The keyed template is never updated, so concurrent dups are safe
+    EVP_MAC_CTX* ctx = EVP_MAC_CTX_dup(static_cast<const EVP_MAC_CTX*>(ctx_));
+    if (!ctx) {
+        throw std::runtime_error("Failed to duplicate HMAC context");
+    }
+
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    size_t mac_len = 0;
+    bool ok = feed(ctx) && EVP_MAC_final(ctx, mac, &mac_len, sizeof(mac)) == 1;
+    EVP_MAC_CTX_free(ctx);
+
+    if (!ok) {
+        throw std::runtime_error("HMAC-SHA256 signing failed");
+    }
+    return WebhookSigner::ToHex(mac, mac_len);
+}
+
+std::string WebhookSigningKey::Sign(std::string_view payload) const {
+    return SignWith([payload](EVP_MAC_CTX* ctx) {
+        return EVP_MAC_update(ctx, reinterpret_cast<const unsigned char*>(payload.data()),
+                              payload.size()) == 1;
+    });
+}
+
+std::string WebhookSigningKey::Sign(const std::vector<std::string_view>& chunks) const {
+    return SignWith([&chunks](EVP_MAC_CTX* ctx) {
+        for (const auto& chunk : chunks) {
+            if (EVP_MAC_update(ctx, reinterpret_cast<const unsigned char*>(chunk.data()),
+                               chunk.size()) != 1) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+bool WebhookSigningKey::Matches(std::string_view secret) const {
+    return secret.size() == secret_.size() &&
+           CRYPTO_memcmp(secret.data(), secret_.data(), secret.size()) == 0;
+}
+
 std::string WebhookSigner::SignPayload(
-    const std::string& payload,
-    const std::string& secret
+    std::string_view payload,
+    std::string_view secret
 ) {
     // Use HMAC-SHA256 to sign the payload
     unsigned char hmac_result[EVP_MAX_MD_SIZE];
@@ -24,10 +122,10 @@ std::string WebhookSigner::SignPayload(
 
     HMAC(
         EVP_sha256(),
-        secret.c_str(),
-        secret.length(),
-        reinterpret_cast<const unsigned char*>(payload.c_str()),
-        payload.length(),
+        secret.data(),
+        static_cast<int>(secret.size()),
+        reinterpret_cast<const unsigned char*>(payload.data()),
+        payload.size(),
         hmac_result,
         &hmac_len
     );
@@ -37,9 +135,9 @@ std::string WebhookSigner::SignPayload(
 }
 
 bool WebhookSigner::VerifySignature(
-    const std::string& payload,
-    const std::string& signature,
-    const std::string& secret
+    std::string_view payload,
+    std::string_view signature,
+    std::string_view secret
 ) {
     // Generate expected signature
     std::string expected_signature = SignPayload(payload, secret);
@@ -51,12 +149,56 @@ bool WebhookSigner::VerifySignature(
 
     // Use OpenSSL's constant-time comparison
     return CRYPTO_memcmp(
-        signature.c_str(),
-        expected_signature.c_str(),
+        signature.data(),
+        expected_signature.data(),
         signature.length()
     ) == 0;
 }
 
+std::shared_ptr<const WebhookSigningKey> WebhookSigner::GetSigningKey(
+    const std::string& tenant_id,
+    const std::string& webhook_id,
+    std::string_view secret
+) {
+    std::string key = CacheKey(tenant_id, webhook_id);
+    KeyCache& cache = Cache();
+
+    {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.keys.find(key);
+        if (it != cache.keys.end() && it->second->Matches(secret)) {
+            return it->second;
+        }
+    }
+
+    // Build outside the lock; a concurrent builder for the same webhook just
+    // produces an equivalent key
+    auto signing_key = std::make_shared<const WebhookSigningKey>(secret);
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.keys.size() >= MAX_CACHED_KEYS && cache.keys.find(key) == cache.keys.end()) {
+        // Rebuilding a key is cheap; keep the cache bounded without LRU bookkeeping
+        cache.keys.erase(cache.keys.begin());
+    }
+    cache.keys[key] = signing_key;
+    return signing_key;
+}
+
+void WebhookSigner::InvalidateSigningKey(
+    const std::string& tenant_id,
+    const std::string& webhook_id
+) {
+    KeyCache& cache = Cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.keys.erase(CacheKey(tenant_id, webhook_id));
+}
+
+size_t WebhookSigner::CachedKeyCount() {
+    KeyCache& cache = Cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    return cache.keys.size();
+}
+
 std::string WebhookSigner::GetMockWebhookSecret(
     const std::string& tenant_id,
     const std::string& webhook_id
@@ -70,14 +212,7 @@ std::string WebhookSigner::GetMockWebhookSecret(
 }
 
 std::string WebhookSigner::ToHex(const unsigned char* data, size_t length) {
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-
-    for (size_t i = 0; i < length; ++i) {
-        oss << std::setw(2) << static_cast<unsigned>(data[i]);
-    }
-
-    return oss.str();
+    return HexEncode(data, length);
 }
 
 } // namespace common
@@ -0,0 +1,199 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-memory webhook subscription index implementation
+ */
+
+#include "common/webhook_subscriptions.h"
+#include "common/env.h"
+#include "common/statement_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace common {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const PreparedStatement kSelectTenantWebhooks(
+    "webhook_select_tenant_webhooks",
+    "SELECT id, url, events, batch_max_events FROM webhooks "
+    "WHERE tenant_id = $1 AND status = 'active' AND deleted_at IS NULL");
+
+std::string_view Trim(std::string_view value) {
+    size_t begin = value.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+WebhookSubscriptionOptions WebhookSubscriptionOptions::FromEnv() {
+    WebhookSubscriptionOptions options;
+    options.ttl = std::chrono::seconds(
+        EnvInt("WEBHOOK_SUBSCRIPTION_TTL_S", static_cast<long>(options.ttl.count())));
+    options.max_tenants = static_cast<size_t>(
+        EnvInt("WEBHOOK_SUBSCRIPTION_MAX_TENANTS", static_cast<long>(options.max_tenants)));
+    return options;
+}
+
+WebhookSubscriptionIndex::WebhookSubscriptionIndex(
+    std::shared_ptr<DbPool> db_pool,
+    const WebhookSubscriptionOptions& options
+) : WebhookSubscriptionIndex(
+        [db_pool](const std::string& tenant_id) {
+            auto conn_guard = db_pool->AcquireConnection("WebhookSubscriptionIndex::Load");
+            pqxx::read_transaction txn(*conn_guard);
+
+            auto result = ExecPrepared(txn, kSelectTenantWebhooks, tenant_id);
+
+            std::vector<WebhookSubscription> subscriptions;
+            subscriptions.reserve(result.size());
+            for (const auto& row : result) {
+                WebhookSubscription subscription;
+                subscription.webhook_id = row["id"].as<std::string>();
+                subscription.url = row["url"].as<std::string>();
+                subscription.events = ParseEvents(std::string_view(row["events"].c_str(), row["events"].size()));
+                subscription.batch_max_events = row["batch_max_events"].as<int>();
+                subscriptions.push_back(std::move(subscription));
+            }
+            return subscriptions;
+        },
+        options) {}
+
+WebhookSubscriptionIndex::WebhookSubscriptionIndex(Loader loader, const WebhookSubscriptionOptions& options)
+    : loader_(std::move(loader)), options_(options) {}
+
+std::vector<WebhookSubscription> WebhookSubscriptionIndex::Subscribers(
+    const std::string& tenant_id,
+    const std::string& event_type
+) {
+    auto now = std::chrono::steady_clock::now();
+    std::shared_ptr<const TenantEntry> entry;
+    uint64_t version = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tenants_.find(tenant_id);
+        if (it != tenants_.end() && now - it->second->loaded_at < options_.ttl) {
+            entry = it->second;
+        }
+        version = version_;
+    }
+
+    if (!entry) {
+        // Query outside the lock; concurrent cold loads of one tenant are rare and idempotent
+        auto loaded = BuildEntry(loader_(tenant_id));
+        loaded->loaded_at = now;
+        entry = loaded;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (version == version_) {
+            if (tenants_.size() >= options_.max_tenants && tenants_.find(tenant_id) == tenants_.end()) {
+                for (auto it = tenants_.begin(); it != tenants_.end();) {
+                    it = (now - it->second->loaded_at >= options_.ttl) ? tenants_.erase(it) : std::next(it);
+                }
+                if (tenants_.size() >= options_.max_tenants) {
+                    tenants_.erase(tenants_.begin());
+                }
+            }
+            tenants_[tenant_id] = entry;
+        }
+    }
+
+    auto it = entry->by_event.find(event_type);
+    if (it == entry->by_event.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+void WebhookSubscriptionIndex::Add(const std::string& tenant_id, const WebhookSubscription& subscription) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+
+    auto it = tenants_.find(tenant_id);
+    if (it == tenants_.end()) {
+        return;  // Loaded from the database (which already has the row) on first use
+    }
+    auto updated = std::make_shared<TenantEntry>(*it->second);
+    Unindex(*updated, subscription.webhook_id);
+    Index(*updated, subscription);
+    it->second = updated;
+}
+
+void WebhookSubscriptionIndex::Remove(const std::string& tenant_id, const std::string& webhook_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+
+    auto it = tenants_.find(tenant_id);
+    if (it == tenants_.end()) {
+        return;
+    }
+    auto updated = std::make_shared<TenantEntry>(*it->second);
+    Unindex(*updated, webhook_id);
+    it->second = updated;
+}
+
+void WebhookSubscriptionIndex::InvalidateTenant(const std::string& tenant_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+    tenants_.erase(tenant_id);
+}
+
+size_t WebhookSubscriptionIndex::TenantCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tenants_.size();
+}
+
+std::vector<std::string> WebhookSubscriptionIndex::ParseEvents(std::string_view events) {
+    std::vector<std::string> parsed;
+    while (!events.empty()) {
+        size_t comma = events.find(',');
+        std::string_view event = Trim(events.substr(0, comma));
+        if (!event.empty() && std::find(parsed.begin(), parsed.end(), event) == parsed.end()) {
+            parsed.emplace_back(event);
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        events.remove_prefix(comma + 1);
+    }
+    return parsed;
+}
+
+std::shared_ptr<WebhookSubscriptionIndex::TenantEntry> WebhookSubscriptionIndex::BuildEntry(
+    const std::vector<WebhookSubscription>& subscriptions
+) {
+    auto entry = std::make_shared<TenantEntry>();
+    for (const auto& subscription : subscriptions) {
+        Index(*entry, subscription);
+    }
+    return entry;
+}
+
+void WebhookSubscriptionIndex::Index(TenantEntry& entry, const WebhookSubscription& subscription) {
+    for (const auto& event : subscription.events) {
+        entry.by_event[event].push_back(subscription);
+    }
+}
+
+void WebhookSubscriptionIndex::Unindex(TenantEntry& entry, const std::string& webhook_id) {
+    for (auto it = entry.by_event.begin(); it != entry.by_event.end();) {
+        auto& subscribers = it->second;
+        subscribers.erase(
+            std::remove_if(subscribers.begin(), subscribers.end(),
+                           [&](const WebhookSubscription& s) { return s.webhook_id == webhook_id; }),
+            subscribers.end());
+        it = subscribers.empty() ? entry.by_event.erase(it) : std::next(it);
+    }
+}
+
+} // namespace common
+} // namespace saasforge
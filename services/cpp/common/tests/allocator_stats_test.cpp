@@ -0,0 +1,44 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for allocator statistics
+ */
+
+#include <gtest/gtest.h>
+#include "common/allocator_stats.h"
+#include <cstring>
+#include <memory>
+
+using namespace saasforge::common;
+
+TEST(AllocatorStatsTest, ReportsTheAllocatorInUse) {
+    AllocatorStats stats = ReadAllocatorStats();
+    EXPECT_FALSE(stats.allocator.empty());
+    EXPECT_GT(stats.mapped, 0u);
+}
+
+TEST(AllocatorStatsTest, AllocatedFollowsLiveAllocations) {
+    if (ReadAllocatorStats().allocated == 0) {
+        GTEST_SKIP() << "Allocator does not report allocated bytes";
+    }
+    size_t before = ReadAllocatorStats().allocated;
+    constexpr size_t size = 64 << 20;   // An Argon2 buffer
+    auto buffer = std::make_unique<char[]>(size);
+    std::memset(buffer.get(), 1, size);
+    EXPECT_GE(ReadAllocatorStats().allocated, before + size);
+
+    buffer.reset();
+    EXPECT_LT(ReadAllocatorStats().allocated, before + size);
+}
+
+TEST(AllocatorStatsTest, ExportsGaugesOnScrape) {
+    MetricsRegistry registry;
+    uint64_t collector = ExportAllocatorMetrics(registry);
+    std::string allocator = ReadAllocatorStats().allocator;
+
+    std::string text = registry.Render();
+    EXPECT_NE(text.find("saasforge_allocator_mapped_bytes{allocator=\"" + allocator + "\"} "), std::string::npos);
+
+    registry.RemoveCollector(collector);
+    EXPECT_EQ(registry.Render().find("saasforge_allocator_"), std::string::npos);
+}
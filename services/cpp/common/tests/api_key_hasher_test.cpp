@@ -0,0 +1,111 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for keyed API key format and HMAC digests (Requirement A-14)
+ */
+
+#include <gtest/gtest.h>
+#include "common/api_key_hasher.h"
+
+using namespace saasforge::common;
+
+class ApiKeyHasherTest : public ::testing::Test {
+protected:
+    const std::string pepper = "test_pepper_value";
+    const std::string legacy_key = "sk_" + std::string(64, 'a');
+};
+
+// Test that generated keys have the sk_<key_id>_<secret> shape
+TEST_F(ApiKeyHasherTest, GeneratedKeyFormat) {
+    auto key = ApiKeyHasher::Generate(pepper);
+
+    EXPECT_EQ(key.api_key.find("sk_"), 0u);
+    EXPECT_EQ(key.api_key.length(), 3 + 16 + 1 + 64);
+    EXPECT_EQ(key.key_id.length(), ApiKeyHasher::KEY_ID_HEX_LENGTH);
+    EXPECT_EQ(key.key_hash.length(), 64u);  // SHA-256 hex
+    EXPECT_EQ(key.api_key.substr(3, 16), key.key_id);
+}
+
+// Test that two generated keys never collide
+TEST_F(ApiKeyHasherTest, GeneratedKeysAreUnique) {
+    auto key1 = ApiKeyHasher::Generate(pepper);
+    auto key2 = ApiKeyHasher::Generate(pepper);
+
+    EXPECT_NE(key1.api_key, key2.api_key);
+    EXPECT_NE(key1.key_id, key2.key_id);
+}
+
+// Test parse round-trip and digest verification
+TEST_F(ApiKeyHasherTest, ParseAndVerifyGeneratedKey) {
+    auto key = ApiKeyHasher::Generate(pepper);
+    auto parsed = ApiKeyHasher::Parse(key.api_key);
+
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_FALSE(parsed->legacy);
+    EXPECT_EQ(parsed->key_id, key.key_id);
+    EXPECT_TRUE(ApiKeyHasher::VerifyDigest(parsed->secret, pepper, key.key_hash));
+}
+
+// Test that the pepper is part of the digest
+TEST_F(ApiKeyHasherTest, WrongPepperFailsVerification) {
+    auto key = ApiKeyHasher::Generate(pepper);
+    auto parsed = ApiKeyHasher::Parse(key.api_key);
+
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_FALSE(ApiKeyHasher::VerifyDigest(parsed->secret, "other_pepper", key.key_hash));
+}
+
+// Test that a tampered secret fails verification
+TEST_F(ApiKeyHasherTest, TamperedSecretFailsVerification) {
+    auto key = ApiKeyHasher::Generate(pepper);
+    std::string tampered = key.api_key;
+    tampered.back() = tampered.back() == '0' ? '1' : '0';
+
+    auto parsed = ApiKeyHasher::Parse(tampered);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_FALSE(ApiKeyHasher::VerifyDigest(parsed->secret, pepper, key.key_hash));
+}
+
+// Test that digests of different length are rejected without comparing
+TEST_F(ApiKeyHasherTest, MalformedStoredDigestRejected) {
+    EXPECT_FALSE(ApiKeyHasher::VerifyDigest("secret", pepper, ""));
+    EXPECT_FALSE(ApiKeyHasher::VerifyDigest("secret", pepper, "abc"));
+}
+
+// Test that legacy keys are recognised for the migration path
+TEST_F(ApiKeyHasherTest, ParseLegacyKey) {
+    auto parsed = ApiKeyHasher::Parse(legacy_key);
+
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(parsed->legacy);
+    EXPECT_TRUE(parsed->key_id.empty());
+    EXPECT_EQ(parsed->secret, legacy_key);
+}
+
+// Test that malformed keys are rejected before touching the database
+TEST_F(ApiKeyHasherTest, ParseRejectsMalformedKeys) {
+    EXPECT_FALSE(ApiKeyHasher::Parse("").has_value());
+    EXPECT_FALSE(ApiKeyHasher::Parse("sk_").has_value());
+    EXPECT_FALSE(ApiKeyHasher::Parse("pk_" + std::string(64, 'a')).has_value());
+    EXPECT_FALSE(ApiKeyHasher::Parse("sk_" + std::string(16, 'a') + "-" + std::string(64, 'b')).has_value());
+    EXPECT_FALSE(ApiKeyHasher::Parse("sk_" + std::string(16, 'g') + "_" + std::string(64, 'b')).has_value());
+    EXPECT_FALSE(ApiKeyHasher::Parse("sk_" + std::string(16, 'a') + "_" + std::string(63, 'b')).has_value());
+}
+
+// Test that legacy key ids are deterministic and cannot collide with new ids
+TEST_F(ApiKeyHasherTest, LegacyKeyIdIsDeterministic) {
+    std::string id1 = ApiKeyHasher::LegacyKeyId(legacy_key, pepper);
+    std::string id2 = ApiKeyHasher::LegacyKeyId(legacy_key, pepper);
+
+    EXPECT_EQ(id1, id2);
+    EXPECT_EQ(id1.length(), ApiKeyHasher::KEY_ID_HEX_LENGTH);
+    EXPECT_EQ(id1[0], 'l');  // Not a hex digit, so disjoint from generated ids
+    EXPECT_NE(id1, ApiKeyHasher::LegacyKeyId("sk_" + std::string(64, 'b'), pepper));
+}
+
+// Test display prefix fits api_keys.key_prefix VARCHAR(10)
+TEST_F(ApiKeyHasherTest, DisplayPrefixLength) {
+    auto key = ApiKeyHasher::Generate(pepper);
+    EXPECT_EQ(ApiKeyHasher::DisplayPrefix(key.api_key).length(), 10u);
+    EXPECT_EQ(ApiKeyHasher::DisplayPrefix(key.api_key), key.api_key.substr(0, 10));
+}
@@ -0,0 +1,63 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for arena block sizing, reuse and the arena message allocator
+ */
+
+#include <gtest/gtest.h>
+#include "common/arena_allocator.h"
+#include <google/protobuf/struct.pb.h>
+#include <google/protobuf/wrappers.pb.h>
+#include <string>
+
+using namespace saasforge::common;
+
+TEST(ArenaAllocatorTest, RoundsBlocksToSizeClasses) {
+    EXPECT_EQ(ArenaBlock::RoundUp(0), ArenaBlock::MIN_SIZE);
+    EXPECT_EQ(ArenaBlock::RoundUp(513), 1024u);
+    EXPECT_EQ(ArenaBlock::RoundUp(4096), 4096u);
+    EXPECT_EQ(ArenaBlock::RoundUp(10 * 1024 * 1024), ArenaBlock::MAX_SIZE);
+}
+
+TEST(ArenaAllocatorTest, ReusesReleasedBlocksOnTheSameThread) {
+    char* first = nullptr;
+    {
+        ArenaBlock block(2000);
+        EXPECT_EQ(block.size(), 2048u);
+        first = block.data();
+    }
+    ArenaBlock again(1500);
+    EXPECT_EQ(again.data(), first);
+}
+
+TEST(ArenaAllocatorTest, EstimateFollowsObservedSizes) {
+    ArenaSizeEstimate estimate;
+    for (int i = 0; i < 64; ++i) {
+        estimate.Record(6000);
+    }
+    EXPECT_EQ(estimate.BlockSize(), 8192u);
+
+    for (int i = 0; i < 64; ++i) {
+        estimate.Record(100);
+    }
+    EXPECT_EQ(estimate.BlockSize(), ArenaBlock::MIN_SIZE);
+}
+
+TEST(ArenaAllocatorTest, PlacesRequestAndResponseOnOneArena) {
+    ArenaMessageAllocator<google::protobuf::StringValue, google::protobuf::Struct> allocator(
+        "/saasforge.test.TestService/Echo");
+
+    auto* holder = allocator.AllocateMessages();
+    ASSERT_NE(holder->request()->GetArena(), nullptr);
+    EXPECT_EQ(holder->request()->GetArena(), holder->response()->GetArena());
+
+    holder->request()->set_value("echo");
+    auto* list = (*holder->response()->mutable_fields())["echo"].mutable_list_value();
+    for (int i = 0; i < 500; ++i) {
+        list->add_values()->set_string_value(holder->request()->value());
+    }
+    holder->Release();
+
+    // One RPC moves the estimate 1/8 of the way towards what it used
+    EXPECT_GT(allocator.Estimate().Bytes(), ArenaBlock::MIN_SIZE);
+}
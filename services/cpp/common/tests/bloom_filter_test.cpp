@@ -0,0 +1,57 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the Bloom filter used by local blacklist checks
+ */
+
+#include <gtest/gtest.h>
+#include "common/bloom_filter.h"
+#include <string>
+
+using namespace saasforge::common;
+
+// Test that added items are always reported (no false negatives)
+TEST(BloomFilterTest, NoFalseNegatives) {
+    BloomFilter filter(1000, 0.01);
+    for (int i = 0; i < 1000; ++i) {
+        filter.Add("jti-" + std::to_string(i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(filter.MightContain("jti-" + std::to_string(i)));
+    }
+}
+
+// Test that the false positive rate stays near the target at capacity
+TEST(BloomFilterTest, FalsePositiveRateNearTarget) {
+    BloomFilter filter(10000, 0.01);
+    for (int i = 0; i < 10000; ++i) {
+        filter.Add("present-" + std::to_string(i));
+    }
+
+    int false_positives = 0;
+    const int probes = 20000;
+    for (int i = 0; i < probes; ++i) {
+        if (filter.MightContain("absent-" + std::to_string(i))) {
+            ++false_positives;
+        }
+    }
+    EXPECT_LT(static_cast<double>(false_positives) / probes, 0.03);
+}
+
+// Test that an empty filter reports nothing
+TEST(BloomFilterTest, EmptyFilterContainsNothing) {
+    BloomFilter filter(100, 0.001);
+    EXPECT_FALSE(filter.MightContain("anything"));
+    EXPECT_EQ(filter.Count(), 0u);
+}
+
+// Test saturation tracking used to trigger rebuilds
+TEST(BloomFilterTest, SaturatedAfterExpectedItems) {
+    BloomFilter filter(10, 0.01);
+    for (int i = 0; i < 10; ++i) {
+        filter.Add(std::to_string(i));
+    }
+    EXPECT_FALSE(filter.Saturated());
+    filter.Add("one-more");
+    EXPECT_TRUE(filter.Saturated());
+}
@@ -0,0 +1,129 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the client channel pool
+ */
+
+#include <gtest/gtest.h>
+#include "common/channel_pool.h"
+#include "common/server_options.h"
+#include "common/warmup.h"
+#include <grpcpp/generic/async_generic_service.h>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+ChannelPoolOptions SmallPool(size_t channels) {
+    ChannelPoolOptions options;
+    options.channels_per_target = channels;
+    return options;
+}
+
+/// Unimplemented generic service: enough for channels to reach READY
+struct LocalServer {
+    grpc::CallbackGenericService service;
+    std::unique_ptr<grpc::Server> server;
+    std::string address;
+
+    LocalServer() {
+        grpc::ServerBuilder builder;
+        builder.RegisterCallbackGenericService(&service);
+        int port = 0;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+        ServerOptions().ApplyTo(builder);
+        server = builder.BuildAndStart();
+        if (!server) {
+            throw std::runtime_error("test server did not start");
+        }
+        address = "127.0.0.1:" + std::to_string(port);
+    }
+    ~LocalServer() { server->Shutdown(); }
+};
+
+} // namespace
+
+TEST(ChannelPoolTest, RoundRobinsOverDistinctChannels) {
+    ChannelPool pool(grpc::InsecureChannelCredentials(), SmallPool(3));
+
+    std::vector<std::shared_ptr<grpc::Channel>> handed_out;
+    for (int i = 0; i < 6; ++i) {
+        handed_out.push_back(pool.Get("localhost:1"));
+    }
+    std::set<grpc::Channel*> distinct;
+    for (const auto& channel : handed_out) {
+        distinct.insert(channel.get());
+    }
+    EXPECT_EQ(distinct.size(), 3u);
+    EXPECT_EQ(handed_out[0], handed_out[3]);
+    EXPECT_EQ(handed_out[1], handed_out[4]);
+}
+
+TEST(ChannelPoolTest, KeepsChannelsPerTarget) {
+    ChannelPool pool(grpc::InsecureChannelCredentials(), SmallPool(2));
+
+    auto first = pool.Channels("localhost:1");
+    auto second = pool.Channels("localhost:2");
+    ASSERT_EQ(first.size(), 2u);
+    EXPECT_NE(first[0], second[0]);
+    EXPECT_EQ(pool.Channels("localhost:1"), first);
+
+    auto stats = pool.GetStats();
+    EXPECT_EQ(stats.targets, 2u);
+    EXPECT_EQ(stats.channels, 4u);
+    EXPECT_EQ(stats.ready, 0u);
+}
+
+TEST(ChannelPoolTest, RejectsNullCredentials) {
+    EXPECT_THROW(ChannelPool(nullptr), std::invalid_argument);
+}
+
+TEST(ChannelPoolTest, ArgumentsKeepConnectionsSeparateAndAlive) {
+    ChannelPoolOptions options;
+    options.keepalive_time = std::chrono::milliseconds(15000);
+    auto arguments = ChannelPool::Arguments(options, 2);
+
+    std::map<std::string, int> ints;
+    std::map<std::string, std::string> strings;
+    grpc_channel_args args = arguments.c_channel_args();
+    for (size_t i = 0; i < args.num_args; ++i) {
+        if (args.args[i].type == GRPC_ARG_INTEGER) {
+            ints[args.args[i].key] = args.args[i].value.integer;
+        } else if (args.args[i].type == GRPC_ARG_STRING) {
+            strings[args.args[i].key] = args.args[i].value.string;
+        }
+    }
+    EXPECT_EQ(ints[GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL], 1);
+    EXPECT_EQ(ints[GRPC_ARG_KEEPALIVE_TIME_MS], 15000);
+    EXPECT_EQ(ints[GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS], 1);
+    EXPECT_EQ(strings[GRPC_ARG_LB_POLICY_NAME], "round_robin");
+
+    options.keepalive_time = std::chrono::milliseconds(0);
+    auto without_keepalive = ChannelPool::Arguments(options, 0);
+    args = without_keepalive.c_channel_args();
+    for (size_t i = 0; i < args.num_args; ++i) {
+        EXPECT_STRNE(args.args[i].key, GRPC_ARG_KEEPALIVE_TIME_MS);
+    }
+}
+
+TEST(ChannelPoolTest, ConnectsEveryChannel) {
+    LocalServer server;
+    auto pool = std::make_shared<ChannelPool>(grpc::InsecureChannelCredentials(), SmallPool(3));
+
+    ASSERT_TRUE(pool->Connect(server.address, std::chrono::system_clock::now() + std::chrono::seconds(5)));
+    EXPECT_EQ(pool->GetStats().ready, 3u);
+
+    Warmup warmup;
+    warmup.Add("channels", Warmup::ConnectChannels(pool, server.address), true);
+    EXPECT_TRUE(warmup.Run(nullptr));
+}
+
+TEST(ChannelPoolTest, ConnectFailsByDeadline) {
+    ChannelPool pool(grpc::InsecureChannelCredentials(), SmallPool(2));
+
+    // Port 1 on loopback: refused
+    EXPECT_FALSE(pool.Connect("127.0.0.1:1", std::chrono::system_clock::now() + std::chrono::milliseconds(200)));
+}
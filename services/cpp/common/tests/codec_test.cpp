@@ -0,0 +1,161 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the hex, Base32 and Base64 codecs
+ */
+
+#include <gtest/gtest.h>
+#include "common/codec.h"
+#include <random>
+#include <set>
+
+using namespace saasforge::common;
+
+namespace {
+
+std::string Text(const std::optional<std::vector<uint8_t>>& bytes) {
+    return bytes ? std::string(bytes->begin(), bytes->end()) : "<invalid>";
+}
+
+std::string Base32(std::string_view bytes, bool padded = true) {
+    return Base32Encode(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), padded);
+}
+
+// Every length up to a few SIMD blocks, so the vector loops and the scalar tails both run
+std::vector<std::string> RandomInputs() {
+    std::mt19937 rng(42);
+    std::vector<std::string> inputs;
+    for (size_t size = 0; size <= 80; ++size) {
+        std::string input(size, '\0');
+        for (auto& c : input) {
+            c = static_cast<char>(rng());
+        }
+        inputs.push_back(input);
+    }
+    return inputs;
+}
+
+} // namespace
+
+TEST(CodecTest, HexMatchesKnownVectors) {
+    EXPECT_EQ(HexEncode(""), "");
+    EXPECT_EQ(HexEncode("foobar"), "666f6f626172");
+    EXPECT_EQ(HexEncode(std::string("\x00\xff\x10\x9a", 4)), "00ff109a");
+
+    EXPECT_EQ(Text(HexDecode("666f6f626172")), "foobar");
+    EXPECT_EQ(Text(HexDecode("666F6F626172")), "foobar");
+}
+
+TEST(CodecTest, HexRoundTripsEveryLength) {
+    for (const auto& input : RandomInputs()) {
+        std::string hex = HexEncode(input);
+        ASSERT_EQ(hex.size(), HexEncodedLength(input.size()));
+        for (size_t i = 0; i < input.size(); ++i) {
+            char expected[3];
+            std::snprintf(expected, sizeof(expected), "%02x", static_cast<unsigned char>(input[i]));
+            ASSERT_EQ(hex.substr(2 * i, 2), expected) << "size " << input.size() << " byte " << i;
+        }
+        EXPECT_EQ(Text(HexDecode(hex)), input);
+    }
+}
+
+TEST(CodecTest, HexRejectsMalformedInput) {
+    EXPECT_FALSE(HexDecode("abc").has_value());
+    EXPECT_FALSE(HexDecode("zz").has_value());
+
+    // Bad character at every position of a block the vector path decodes
+    std::string hex = HexEncode(std::string(40, 'x'));
+    for (size_t i = 0; i < hex.size(); ++i) {
+        for (char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\xc3'}) {
+            std::string corrupted = hex;
+            corrupted[i] = bad;
+            EXPECT_FALSE(HexDecode(corrupted).has_value()) << "position " << i << " char " << bad;
+        }
+    }
+}
+
+TEST(CodecTest, Base32MatchesRfc4648Vectors) {
+    EXPECT_EQ(Base32(""), "");
+    EXPECT_EQ(Base32("f"), "MY======");
+    EXPECT_EQ(Base32("fo"), "MZXQ====");
+    EXPECT_EQ(Base32("foo"), "MZXW6===");
+    EXPECT_EQ(Base32("foob"), "MZXW6YQ=");
+    EXPECT_EQ(Base32("fooba"), "MZXW6YTB");
+    EXPECT_EQ(Base32("foobar"), "MZXW6YTBOI======");
+    EXPECT_EQ(Base32("foobar", false), "MZXW6YTBOI");
+    EXPECT_EQ(Base32EncodedLength(6, false), 10u);
+}
+
+TEST(CodecTest, Base32DecodesLeniently) {
+    EXPECT_EQ(Text(Base32Decode("MZXW6YTBOI======")), "foobar");
+    EXPECT_EQ(Text(Base32Decode("mzxw6ytboi")), "foobar");
+    EXPECT_EQ(Text(Base32Decode("MZXW 6YTB-OI")), "foobar");
+    EXPECT_FALSE(Base32Decode("MZXW1").has_value());
+    EXPECT_FALSE(Base32Decode("MZXW!").has_value());
+
+    for (const auto& input : RandomInputs()) {
+        EXPECT_EQ(Text(Base32Decode(Base32(input))), input);
+        EXPECT_EQ(Text(Base32Decode(Base32(input, false))), input);
+    }
+}
+
+TEST(CodecTest, Base64MatchesRfc4648Vectors) {
+    EXPECT_EQ(Base64Encode(""), "");
+    EXPECT_EQ(Base64Encode("f"), "Zg==");
+    EXPECT_EQ(Base64Encode("fo"), "Zm8=");
+    EXPECT_EQ(Base64Encode("foo"), "Zm9v");
+    EXPECT_EQ(Base64Encode("foob"), "Zm9vYg==");
+    EXPECT_EQ(Base64Encode("fooba"), "Zm9vYmE=");
+    EXPECT_EQ(Base64Encode("foobar"), "Zm9vYmFy");
+    EXPECT_EQ(Base64Encode("foob", Base64Alphabet::STANDARD, false), "Zm9vYg");
+}
+
+TEST(CodecTest, Base64AlphabetsDifferInTwoCharacters) {
+    std::string bytes("\xfb\xff\xbf", 3);
+    EXPECT_EQ(Base64Encode(bytes), "+/+/");
+    EXPECT_EQ(Base64Encode(bytes, Base64Alphabet::URL_SAFE), "-_-_");
+    EXPECT_EQ(Text(Base64Decode("-_-_", Base64Alphabet::URL_SAFE)), bytes);
+    EXPECT_FALSE(Base64Decode("-_-_").has_value());
+    EXPECT_FALSE(Base64Decode("+/+/", Base64Alphabet::URL_SAFE).has_value());
+}
+
+TEST(CodecTest, Base64DecodesPaddedAndUnpadded) {
+    EXPECT_EQ(Text(Base64Decode("Zm9vYg==")), "foob");
+    EXPECT_EQ(Text(Base64Decode("Zm9vYg")), "foob");
+    EXPECT_EQ(Text(Base64Decode("Zm9vYmE=")), "fooba");
+    EXPECT_EQ(Text(Base64Decode("Zm9vYmE")), "fooba");
+
+    EXPECT_FALSE(Base64Decode("Zm9vY").has_value());     // 1 mod 4
+    EXPECT_FALSE(Base64Decode("Zm=vYg==").has_value());  // Padding inside
+    EXPECT_FALSE(Base64Decode("Zg===").has_value());
+    EXPECT_FALSE(Base64Decode("Zm9v!mFy").has_value());
+
+    for (const auto& input : RandomInputs()) {
+        for (auto alphabet : {Base64Alphabet::STANDARD, Base64Alphabet::URL_SAFE}) {
+            for (bool padded : {true, false}) {
+                std::string encoded = Base64Encode(input, alphabet, padded);
+                ASSERT_EQ(encoded.size(), Base64EncodedLength(input.size(), padded));
+                EXPECT_EQ(Text(Base64Decode(encoded, alphabet)), input);
+            }
+        }
+    }
+}
+
+TEST(CodecTest, RandomHexHasTheRequestedLength) {
+    std::string first = RandomHex(32);
+    EXPECT_EQ(first.size(), 64u);
+    EXPECT_TRUE(HexDecode(first).has_value());
+    EXPECT_NE(first, RandomHex(32));
+    EXPECT_EQ(RandomHex(0), "");
+}
+
+TEST(CodecTest, RandomBytesNeverRepeatsAcrossPoolRefills) {
+    // 32-byte draws across several 4 KiB refills, plus one larger than the pool serves
+    std::set<std::string> seen;
+    for (int i = 0; i < 1000; ++i) {
+        unsigned char bytes[32];
+        RandomBytes(bytes, sizeof(bytes));
+        EXPECT_TRUE(seen.insert(std::string(reinterpret_cast<char*>(bytes), sizeof(bytes))).second);
+    }
+    EXPECT_EQ(RandomHex(4096).size(), 8192u);
+}
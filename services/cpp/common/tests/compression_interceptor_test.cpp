@@ -0,0 +1,284 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the response compression interceptor
+ */
+
+#include <gtest/gtest.h>
+#include "common/compression_interceptor.h"
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/grpcpp.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Reads one request holding the response size and answers with that many bytes
+class SizedReply : public grpc::ServerGenericBidiReactor {
+public:
+    SizedReply() { StartRead(&request_); }
+
+    void OnReadDone(bool ok) override {
+        if (!ok) {
+            Finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "no request"));
+            return;
+        }
+        std::vector<grpc::Slice> slices;
+        request_.Dump(&slices);
+        std::string size;
+        for (const auto& slice : slices) {
+            size.append(reinterpret_cast<const char*>(slice.begin()), slice.size());
+        }
+        // Repetitive text, as listings of similar records are
+        std::string body;
+        while (body.size() < std::stoul(size)) {
+            body += "invoice:paid:EUR:";
+        }
+        body.resize(std::stoul(size));
+        grpc::Slice slice(body);
+        response_ = grpc::ByteBuffer(&slice, 1);
+        StartWriteAndFinish(&response_, grpc::WriteOptions(), grpc::Status::OK);
+    }
+
+    void OnDone() override { delete this; }
+
+private:
+    grpc::ByteBuffer request_;
+    grpc::ByteBuffer response_;
+};
+
+class SizedService : public grpc::CallbackGenericService {
+    grpc::ServerGenericBidiReactor* CreateReactor(grpc::GenericCallbackServerContext*) override {
+        return new SizedReply();
+    }
+};
+
+/**
+ * Relays one TCP connection to `port`, counting the bytes coming back
+ *
+ * The client's decompression hides the response encoding (grpc-encoding
+ * is consumed by the transport), so the wire size is what shows it.
+ */
+class CountingProxy {
+public:
+    explicit CountingProxy(int port) : target_port_(port) {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = Loopback(0);
+        socklen_t length = sizeof(address);
+        if (bind(listener_, reinterpret_cast<sockaddr*>(&address), length) != 0 || listen(listener_, 1) != 0 ||
+            getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            throw std::runtime_error("proxy did not start");
+        }
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread([this] { Relay(); });
+    }
+    ~CountingProxy() {
+        stop_ = true;
+        shutdown(listener_, SHUT_RDWR);
+        thread_.join();
+        close(listener_);
+    }
+
+    int Port() const { return port_; }
+    uint64_t BytesFromServer() const { return from_server_.load(); }
+
+private:
+    static sockaddr_in Loopback(int port) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    void Relay() {
+        int client = accept(listener_, nullptr, nullptr);
+        if (client < 0) {
+            return;
+        }
+        int server = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = Loopback(target_port_);
+        if (connect(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            pollfd fds[2] = {{client, POLLIN, 0}, {server, POLLIN, 0}};
+            char buffer[16 * 1024];
+            while (!stop_) {
+                if (poll(fds, 2, 50) <= 0) {
+                    continue;
+                }
+                bool open = true;
+                for (int i = 0; i < 2 && open; ++i) {
+                    if (!(fds[i].revents & (POLLIN | POLLHUP))) {
+                        continue;
+                    }
+                    ssize_t n = read(fds[i].fd, buffer, sizeof(buffer));
+                    open = n > 0 && write(fds[1 - i].fd, buffer, static_cast<size_t>(n)) == n;
+                    if (open && i == 1) {
+                        from_server_ += static_cast<uint64_t>(n);
+                    }
+                }
+                if (!open) {
+                    break;
+                }
+            }
+        }
+        close(server);
+        close(client);
+    }
+
+    int target_port_;
+    int port_ = 0;
+    int listener_ = -1;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> from_server_{0};
+    std::thread thread_;
+};
+
+struct LocalServer {
+    MetricsRegistry registry;
+    SizedService service;
+    std::unique_ptr<grpc::Server> server;
+    std::unique_ptr<CountingProxy> proxy;
+    std::shared_ptr<grpc::Channel> channel;
+
+    explicit LocalServer(CompressionOptions options) {
+        grpc::ServerBuilder builder;
+        builder.RegisterCallbackGenericService(&service);
+        int port = 0;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+        std::vector<std::unique_ptr<grpc::experimental::ServerInterceptorFactoryInterface>> creators;
+        creators.push_back(std::make_unique<CompressionInterceptorFactory>(std::move(options), registry));
+        builder.experimental().SetInterceptorCreators(std::move(creators));
+        server = builder.BuildAndStart();
+        if (!server) {
+            throw std::runtime_error("test server did not start");
+        }
+        proxy = std::make_unique<CountingProxy>(port);
+        channel = grpc::CreateChannel("127.0.0.1:" + std::to_string(proxy->Port()),
+                                      grpc::InsecureChannelCredentials());
+    }
+    ~LocalServer() {
+        channel.reset();
+        server->Shutdown();
+    }
+
+    /// Bytes on the wire for the response to `method`
+    uint64_t Call(const std::string& method, size_t response_bytes) {
+        uint64_t before = proxy->BytesFromServer();
+        grpc::GenericStub stub(channel);
+        grpc::ClientContext context;
+        std::string size = std::to_string(response_bytes);
+        grpc::Slice payload(size);
+        grpc::ByteBuffer request(&payload, 1);
+        grpc::ByteBuffer response;
+
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        bool done = false;
+        grpc::Status status;
+        stub.UnaryCall(&context, method, grpc::StubOptions(), &request, &response, [&](grpc::Status s) {
+            std::lock_guard<std::mutex> lock(mutex);
+            status = std::move(s);
+            done = true;
+            done_cv.notify_one();
+        });
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&] { return done; });
+
+        EXPECT_TRUE(status.ok()) << status.error_message();
+        EXPECT_EQ(response.Length(), response_bytes);
+        return proxy->BytesFromServer() - before;
+    }
+
+    bool Compressed(const std::string& method, size_t response_bytes) {
+        return Call(method, response_bytes) < response_bytes / 2;
+    }
+
+    uint64_t Decisions(const std::string& method, const std::string& decision) {
+        return registry
+            .GetCounter("saasforge_grpc_server_compression_total", "",
+                        {{"grpc_service", "test.Svc"}, {"grpc_method", method}, {"decision", decision}})
+            .Value();
+    }
+};
+
+CompressionOptions Threshold(size_t min_bytes) {
+    CompressionOptions options;
+    options.defaults.min_bytes = min_bytes;
+    options.sample_every = 1;
+    return options;
+}
+
+} // namespace
+
+TEST(CompressionInterceptorTest, CompressesOnlyAboveThreshold) {
+    LocalServer server(Threshold(1024));
+
+    EXPECT_TRUE(server.Compressed("/test.Svc/List", 64 * 1024));
+    EXPECT_GT(server.Call("/test.Svc/List", 1000), 1000u);
+
+    EXPECT_EQ(server.Decisions("List", "compressed"), 1u);
+    EXPECT_EQ(server.Decisions("List", "skipped"), 1u);
+}
+
+TEST(CompressionInterceptorTest, AppliesPerMethodRules) {
+    CompressionOptions options = Threshold(1024);
+    options.methods = CompressionOptions::ParseMethods("Login=none,/test.Svc/Records=deflate:16", options.defaults);
+    LocalServer server(std::move(options));
+
+    EXPECT_FALSE(server.Compressed("/test.Svc/Login", 64 * 1024));
+    EXPECT_TRUE(server.Compressed("/test.Svc/Records", 800));
+    EXPECT_TRUE(server.Compressed("/test.Svc/Other", 4096));
+    EXPECT_FALSE(server.Compressed("/test.Svc/Other", 800));
+}
+
+TEST(CompressionInterceptorTest, SamplesRatioAndCpu) {
+    LocalServer server(Threshold(0));
+
+    server.Call("/test.Svc/List", 256 * 1024);
+
+    MetricLabels labels = {{"grpc_service", "test.Svc"}, {"grpc_method", "List"}};
+    auto& ratio = server.registry.GetHistogram("saasforge_grpc_server_compression_ratio", "",
+                                               HistogramOptions::SizeBytes(), labels);
+    auto& cpu = server.registry.GetHistogram("saasforge_grpc_server_compression_seconds", "",
+                                             HistogramOptions::LatencySeconds(), labels);
+    EXPECT_EQ(ratio.Snapshot().count, 1u);
+    EXPECT_EQ(cpu.Snapshot().count, 1u);
+    // Repeated text compresses far better than 4:1 (ratio in hundredths)
+    EXPECT_GT(ratio.Snapshot().sum, 400u);
+}
+
+TEST(CompressionInterceptorTest, ParsesMethodRules) {
+    CompressionRule defaults;
+    auto rules = CompressionOptions::ParseMethods(
+        " ListInvoices=gzip:512 , Login=none,Records=:0,Report,Bad=zstd,Worse=gzip:x,=gzip", defaults);
+
+    ASSERT_EQ(rules.size(), 4u);
+    EXPECT_EQ(rules["ListInvoices"].algorithm, GRPC_COMPRESS_GZIP);
+    EXPECT_EQ(rules["ListInvoices"].min_bytes, 512u);
+    EXPECT_EQ(rules["Login"].algorithm, GRPC_COMPRESS_NONE);
+    EXPECT_EQ(rules["Records"].algorithm, defaults.algorithm);
+    EXPECT_EQ(rules["Records"].min_bytes, 0u);
+    EXPECT_EQ(rules["Report"].min_bytes, defaults.min_bytes);
+    EXPECT_EQ(rules.count("Bad"), 0u);
+}
+
+TEST(CompressionInterceptorTest, RuleForPrefersFullPath) {
+    CompressionOptions options;
+    options.methods["List"].min_bytes = 10;
+    options.methods["/a.Svc/List"].min_bytes = 20;
+
+    EXPECT_EQ(options.RuleFor("/a.Svc/List").min_bytes, 20u);
+    EXPECT_EQ(options.RuleFor("/b.Svc/List").min_bytes, 10u);
+    EXPECT_EQ(options.RuleFor("/b.Svc/Get").min_bytes, options.defaults.min_bytes);
+}
@@ -0,0 +1,197 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for read replica routing and lag-based ejection
+ */
+
+#include <gtest/gtest.h>
+#include "common/db_replicas.h"
+#include "common/db_pool.h"
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Primary WAL position and replica replay positions served to the probes
+struct FakeCluster {
+    std::mutex mutex;
+    uint64_t primary_lsn = 100;
+    bool primary_down = false;
+    std::vector<ReplicaSample> replicas;
+    std::vector<bool> down;
+    std::atomic<int> checks{0};
+
+    explicit FakeCluster(size_t count) : replicas(count), down(count, false) {
+        for (auto& replica : replicas) {
+            replica.replay_lsn = 100;
+        }
+    }
+
+    ReplicaSet::PrimaryProbe Primary() {
+        return [this] {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++checks;
+            if (primary_down) {
+                throw std::runtime_error("connection refused");
+            }
+            return primary_lsn;
+        };
+    }
+
+    ReplicaSet::ReplicaProbe Replica() {
+        return [this](size_t index) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (down[index]) {
+                throw std::runtime_error("connection refused");
+            }
+            return replicas[index];
+        };
+    }
+
+    void Set(size_t index, uint64_t replay_lsn, std::chrono::milliseconds replay_age) {
+        std::lock_guard<std::mutex> lock(mutex);
+        replicas[index].replay_lsn = replay_lsn;
+        replicas[index].replay_age = replay_age;
+    }
+};
+
+DbPoolOptions TestOptions() {
+    DbPoolOptions options;
+    options.replica_max_lag = std::chrono::milliseconds(1000);
+    options.replica_check_interval = std::chrono::hours(1);   // Checks are run by the tests
+    options.replica_sticky = std::chrono::milliseconds(5000);
+    return options;
+}
+
+/// Wait for the monitor's first check, so the tests' own checks do not race it
+void WaitForFirstCheck(ReplicaSet& replicas, FakeCluster& cluster) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (cluster.checks == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    replicas.Check();
+}
+
+std::set<int> Chosen(ReplicaSet& replicas, const std::string& session = "") {
+    std::set<int> chosen;
+    for (int i = 0; i < 10; ++i) {
+        chosen.insert(replicas.Choose(session));
+    }
+    return chosen;
+}
+
+} // namespace
+
+TEST(ReplicaSetTest, ParsesLsn) {
+    EXPECT_EQ(ReplicaSet::ParseLsn("16/B374D848"), 0x16B374D848ull);
+    EXPECT_EQ(ReplicaSet::ParseLsn("0/0"), 0u);
+    EXPECT_EQ(ReplicaSet::ParseLsn("FFFFFFFF/FFFFFFFF"), 0xFFFFFFFFFFFFFFFFull);
+    EXPECT_EQ(ReplicaSet::ParseLsn(""), 0u);
+    EXPECT_EQ(ReplicaSet::ParseLsn("16B374D848"), 0u);
+    EXPECT_EQ(ReplicaSet::ParseLsn("16/"), 0u);
+    EXPECT_EQ(ReplicaSet::ParseLsn("16/XYZ"), 0u);
+    EXPECT_EQ(ReplicaSet::ParseLsn("100000000/0"), 0u);
+}
+
+TEST(ReplicaSetTest, SpreadsReadsOverHealthyReplicas) {
+    FakeCluster cluster(2);
+    ReplicaSet replicas(2, cluster.Primary(), cluster.Replica(), TestOptions());
+    WaitForFirstCheck(replicas, cluster);
+
+    EXPECT_EQ(Chosen(replicas), (std::set<int>{0, 1}));
+    for (const auto& status : replicas.GetStatus()) {
+        EXPECT_TRUE(status.healthy);
+        EXPECT_EQ(status.lag.count(), 0);
+    }
+}
+
+TEST(ReplicaSetTest, EjectsLaggingReplicas) {
+    FakeCluster cluster(2);
+    ReplicaSet replicas(2, cluster.Primary(), cluster.Replica(), TestOptions());
+    WaitForFirstCheck(replicas, cluster);
+
+    // Behind the primary: lag is the age of the last replayed transaction
+    cluster.Set(1, 90, std::chrono::milliseconds(200));
+    replicas.Check();
+    EXPECT_EQ(Chosen(replicas), (std::set<int>{0, 1}));
+
+    cluster.Set(1, 90, std::chrono::milliseconds(5000));
+    replicas.Check();
+    EXPECT_EQ(Chosen(replicas), (std::set<int>{0}));
+    EXPECT_EQ(replicas.GetStatus()[1].lag.count(), 5000);
+
+    // Caught up: back in rotation, however old its last transaction
+    cluster.Set(1, 100, std::chrono::milliseconds(60000));
+    replicas.Check();
+    EXPECT_EQ(Chosen(replicas), (std::set<int>{0, 1}));
+}
+
+TEST(ReplicaSetTest, EjectsUnreachableReplicas) {
+    FakeCluster cluster(2);
+    ReplicaSet replicas(2, cluster.Primary(), cluster.Replica(), TestOptions());
+    WaitForFirstCheck(replicas, cluster);
+
+    {
+        std::lock_guard<std::mutex> lock(cluster.mutex);
+        cluster.down = {true, true};
+    }
+    replicas.Check();
+    EXPECT_EQ(Chosen(replicas), (std::set<int>{-1}));
+}
+
+TEST(ReplicaSetTest, ReadsTheSessionsWritesFromTheReplica) {
+    FakeCluster cluster(2);
+    ReplicaSet replicas(2, cluster.Primary(), cluster.Replica(), TestOptions());
+    WaitForFirstCheck(replicas, cluster);
+
+    // Until the primary's position is read past the write, only the primary has it
+    replicas.RecordWrite("tenant-a");
+    EXPECT_EQ(Chosen(replicas, "tenant-a"), (std::set<int>{-1}));
+    EXPECT_EQ(Chosen(replicas, "tenant-b"), (std::set<int>{0, 1}));
+
+    {
+        std::lock_guard<std::mutex> lock(cluster.mutex);
+        cluster.primary_lsn = 200;
+    }
+    cluster.Set(0, 200, std::chrono::milliseconds(0));
+    cluster.Set(1, 150, std::chrono::milliseconds(20));
+    replicas.Check();
+
+    // Both replicas are healthy, but only replica 0 replayed the write
+    EXPECT_EQ(Chosen(replicas, "tenant-a"), (std::set<int>{0}));
+    EXPECT_EQ(Chosen(replicas, "tenant-b"), (std::set<int>{0, 1}));
+}
+
+TEST(ReplicaSetTest, StickinessExpires) {
+    FakeCluster cluster(1);
+    DbPoolOptions options = TestOptions();
+    options.replica_max_lag = std::chrono::milliseconds(20);
+    options.replica_sticky = std::chrono::milliseconds(20);
+    ReplicaSet replicas(1, cluster.Primary(), cluster.Replica(), options);
+    WaitForFirstCheck(replicas, cluster);
+
+    replicas.RecordWrite("tenant-a");
+    EXPECT_EQ(replicas.Choose("tenant-a"), -1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(replicas.Choose("tenant-a"), 0);
+}
+
+TEST(ReplicaSetTest, KeepsCaughtUpReplicasWhenThePrimaryIsUnreachable) {
+    FakeCluster cluster(2);
+    ReplicaSet replicas(2, cluster.Primary(), cluster.Replica(), TestOptions());
+    WaitForFirstCheck(replicas, cluster);
+
+    {
+        std::lock_guard<std::mutex> lock(cluster.mutex);
+        cluster.primary_down = true;
+    }
+    cluster.Set(1, 90, std::chrono::milliseconds(5000));
+    replicas.Check();
+    EXPECT_EQ(Chosen(replicas), (std::set<int>{0}));
+}
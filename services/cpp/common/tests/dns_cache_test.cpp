@@ -0,0 +1,148 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the SSRF DNS cache
+ */
+
+#include <gtest/gtest.h>
+#include "common/dns_cache.h"
+#include "common/webhook_delivery.h"
+#include <chrono>
+#include <thread>
+
+using namespace saasforge::common;
+
+// Test that RFC 1918, loopback and link-local IPv4 are rejected
+TEST(DnsCacheTest, PrivateIpv4IsNotPublic) {
+    EXPECT_FALSE(DnsCache::IsPublicAddress("10.0.0.1"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("172.16.0.1"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("172.31.255.255"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("192.168.1.1"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("127.0.0.1"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("169.254.169.254"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("0.0.0.0"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("100.64.0.1"));     // CGNAT
+    EXPECT_FALSE(DnsCache::IsPublicAddress("224.0.0.1"));      // Multicast
+    EXPECT_FALSE(DnsCache::IsPublicAddress("255.255.255.255"));
+}
+
+// Test that ordinary public IPv4 is allowed, including range neighbours
+TEST(DnsCacheTest, PublicIpv4IsPublic) {
+    EXPECT_TRUE(DnsCache::IsPublicAddress("8.8.8.8"));
+    EXPECT_TRUE(DnsCache::IsPublicAddress("172.15.255.255"));
+    EXPECT_TRUE(DnsCache::IsPublicAddress("172.32.0.1"));
+    EXPECT_TRUE(DnsCache::IsPublicAddress("100.128.0.1"));
+}
+
+// Test IPv6 special ranges and IPv4-embedding forms
+TEST(DnsCacheTest, Ipv6Classification) {
+    EXPECT_FALSE(DnsCache::IsPublicAddress("::1"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("::"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("fd00::1"));          // ULA
+    EXPECT_FALSE(DnsCache::IsPublicAddress("fe80::1"));          // Link-local
+    EXPECT_FALSE(DnsCache::IsPublicAddress("ff02::1"));          // Multicast
+    EXPECT_FALSE(DnsCache::IsPublicAddress("::ffff:10.0.0.1"));  // IPv4-mapped private
+    EXPECT_FALSE(DnsCache::IsPublicAddress("::ffff:169.254.169.254"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("64:ff9b::7f00:1"));  // NAT64 loopback
+    EXPECT_FALSE(DnsCache::IsPublicAddress("2002:c0a8:0101::1")); // 6to4 of 192.168.1.1
+    EXPECT_FALSE(DnsCache::IsPublicAddress("[::1]"));
+    EXPECT_TRUE(DnsCache::IsPublicAddress("2606:4700:4700::1111"));
+    EXPECT_TRUE(DnsCache::IsPublicAddress("::ffff:8.8.8.8"));
+}
+
+// Test that non-numeric input is never treated as public
+TEST(DnsCacheTest, NonAddressIsNotPublic) {
+    EXPECT_FALSE(DnsCache::IsPublicAddress(""));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("example.com"));
+    EXPECT_FALSE(DnsCache::IsPublicAddress("0177.0.0.1"));
+}
+
+// Test URL splitting into scheme, host and port
+TEST(DnsCacheTest, ParseUrl) {
+    auto endpoint = DnsCache::ParseUrl("HTTPS://user:pw@Hooks.Example.com:8443/path?q=1");
+    ASSERT_TRUE(endpoint.has_value());
+    EXPECT_EQ(endpoint->scheme, "https");
+    EXPECT_EQ(endpoint->host, "hooks.example.com");
+    EXPECT_EQ(endpoint->port, 8443);
+
+    auto v6 = DnsCache::ParseUrl("http://[2001:db8::1]/hook");
+    ASSERT_TRUE(v6.has_value());
+    EXPECT_EQ(v6->host, "2001:db8::1");
+    EXPECT_EQ(v6->port, 80);
+
+    EXPECT_FALSE(DnsCache::ParseUrl("ftp://example.com").has_value());
+    EXPECT_FALSE(DnsCache::ParseUrl("https://example.com:99999/").has_value());
+    EXPECT_FALSE(DnsCache::ParseUrl("https://example.com:abc/").has_value());
+    EXPECT_FALSE(DnsCache::ParseUrl("https:///path").has_value());
+}
+
+// Test resolve-then-check on names and literals that need no network
+TEST(DnsCacheTest, ResolveClassifiesAddresses) {
+    DnsCache dns;
+
+    EXPECT_EQ(dns.Resolve("localhost").status, DnsStatus::BLOCKED);
+    EXPECT_EQ(dns.Resolve("10.1.2.3").status, DnsStatus::BLOCKED);
+
+    auto result = dns.Resolve("8.8.8.8");
+    EXPECT_EQ(result.status, DnsStatus::OK);
+    ASSERT_EQ(result.addresses.size(), 1u);
+    EXPECT_EQ(result.addresses[0], "8.8.8.8");
+}
+
+// Test that repeated lookups are served from the cache
+TEST(DnsCacheTest, CachesResults) {
+    DnsCache dns;
+
+    dns.Resolve("8.8.4.4");
+    dns.Resolve("8.8.4.4");
+    dns.Resolve("8.8.4.4");
+
+    EXPECT_EQ(dns.MissCount(), 1u);
+    EXPECT_EQ(dns.HitCount(), 2u);
+    EXPECT_EQ(dns.Size(), 1u);
+}
+
+// Test that expired entries are resolved again
+TEST(DnsCacheTest, ExpiresEntries) {
+    DnsCacheOptions options;
+    options.positive_ttl = std::chrono::seconds(0);
+    DnsCache dns(options);
+
+    dns.Resolve("1.1.1.1");
+    dns.Resolve("1.1.1.1");
+    EXPECT_EQ(dns.MissCount(), 2u);
+}
+
+// Test that TryGet never blocks and eventually returns the result
+TEST(DnsCacheTest, TryGetEventuallyReady) {
+    DnsCache dns;
+
+    std::optional<DnsResult> result = dns.TryGet("9.9.9.9");
+    for (int i = 0; i < 200 && !result; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        result = dns.TryGet("9.9.9.9");
+    }
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->status, DnsStatus::OK);
+}
+
+// Test that the cache bound holds
+TEST(DnsCacheTest, BoundedSize) {
+    DnsCacheOptions options;
+    options.max_entries = 2;
+    DnsCache dns(options);
+
+    dns.Resolve("1.0.0.1");
+    dns.Resolve("1.0.0.2");
+    dns.Resolve("1.0.0.3");
+    EXPECT_LE(dns.Size(), 2u);
+}
+
+// Test that URL validation rejects literal-safe URLs pointing at private hosts
+TEST(DnsCacheTest, ValidateUrlResolvesHost) {
+    DnsCache dns;
+
+    EXPECT_FALSE(WebhookDelivery::ValidateUrl("http://localhost./webhook", dns));
+    EXPECT_TRUE(WebhookDelivery::ValidateUrl("https://8.8.8.8/webhook", dns));
+    EXPECT_FALSE(WebhookDelivery::ValidateUrl("http://10.0.0.1/webhook", dns));
+}
@@ -211,6 +211,23 @@ TEST_F(EmailQueueTest, BounceRateCalculation) {
     EXPECT_EQ(rate4, 50.0);
 }
 
+TEST_F(EmailQueueTest, BounceRateFromCounters) {
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(0, 100), 0.0);
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(5, 100), 5.0);
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(1, 3), 100.0 / 3.0);
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(3, 3), 100.0);
+}
+
+TEST_F(EmailQueueTest, BounceRateWithoutSendsIsZero) {
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(0, 0), 0.0);
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(2, 0), 0.0);
+}
+
+TEST_F(EmailQueueTest, BounceRateIsCappedAtHundred) {
+    // Late bounces of mail counted in an earlier window
+    EXPECT_DOUBLE_EQ(EmailQueue::BounceRate(7, 5), 100.0);
+}
+
 TEST_F(EmailQueueTest, BounceRateThreshold) {
     // Alert threshold is 5% (Requirement E-113)
     double threshold = 5.0;
@@ -329,6 +346,120 @@ TEST_F(EmailQueueTest, RetryDelayReasonable) {
     EXPECT_LE(max_delay, 60);  // Should be ≤ 1 minute
 }
 
+// Test: Tenant Fair Share (bulk lane)
+
+namespace {
+
+int QuotaOf(const TenantFairScheduler::Allocation& allocation, const std::string& tenant) {
+    for (const auto& [id, quota] : allocation.quotas) {
+        if (id == tenant) {
+            return quota;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+TEST(TenantFairSchedulerTest, SplitsCapacityEquallyRegardlessOfBacklog) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    TenantFairScheduler scheduler(options);
+
+    auto allocation = scheduler.Allocate({"campaign", "otp-tenant", "small"}, 30);
+
+    EXPECT_EQ(QuotaOf(allocation, "campaign"), 10);
+    EXPECT_EQ(QuotaOf(allocation, "otp-tenant"), 10);
+    EXPECT_EQ(QuotaOf(allocation, "small"), 10);
+    EXPECT_EQ(allocation.throttled_for.count(), 0);
+}
+
+TEST(TenantFairSchedulerTest, RotatesStartBetweenBatches) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    TenantFairScheduler scheduler(options);
+    std::vector<std::string> tenants = {"a", "b", "c"};
+
+    EXPECT_EQ(QuotaOf(scheduler.Allocate(tenants, 10), "a"), 10);
+    EXPECT_EQ(QuotaOf(scheduler.Allocate(tenants, 10), "b"), 10);
+    EXPECT_EQ(QuotaOf(scheduler.Allocate(tenants, 10), "c"), 10);
+    EXPECT_EQ(QuotaOf(scheduler.Allocate(tenants, 10), "a"), 10);
+}
+
+TEST(TenantFairSchedulerTest, ResumesTurnCutShortByFullBatch) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    TenantFairScheduler scheduler(options);
+    std::vector<std::string> tenants = {"a", "b"};
+
+    EXPECT_EQ(QuotaOf(scheduler.Allocate(tenants, 4), "a"), 4);
+    EXPECT_EQ(QuotaOf(scheduler.Allocate(tenants, 4), "a"), 4);
+
+    // a has 2 credits left of its quantum, then b's turn starts
+    auto allocation = scheduler.Allocate(tenants, 4);
+    EXPECT_EQ(QuotaOf(allocation, "a"), 2);
+    EXPECT_EQ(QuotaOf(allocation, "b"), 2);
+}
+
+TEST(TenantFairSchedulerTest, GivesUnusedCapacityToOtherTenants) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    TenantFairScheduler scheduler(options);
+
+    // A single backlogged tenant takes the whole batch, a quantum per round
+    auto allocation = scheduler.Allocate({"only"}, 35);
+    EXPECT_EQ(QuotaOf(allocation, "only"), 35);
+}
+
+TEST(TenantFairSchedulerTest, CapsEachTenantAtItsRate) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    options.rate_per_second = 10;
+    options.burst = 5;
+    TenantFairScheduler scheduler(options);
+    auto now = TenantFairScheduler::Clock::now();
+
+    auto allocation = scheduler.Allocate({"campaign"}, 100, now);
+    EXPECT_EQ(QuotaOf(allocation, "campaign"), 5);
+    EXPECT_EQ(allocation.throttled_for.count(), 100);  // One token per 100ms
+
+    allocation = scheduler.Allocate({"campaign"}, 100, now + std::chrono::milliseconds(50));
+    EXPECT_TRUE(allocation.quotas.empty());
+    EXPECT_EQ(allocation.throttled_for.count(), 50);
+
+    // Refilled, but never beyond the burst
+    allocation = scheduler.Allocate({"campaign"}, 100, now + std::chrono::seconds(10));
+    EXPECT_EQ(QuotaOf(allocation, "campaign"), 5);
+}
+
+TEST(TenantFairSchedulerTest, CappedTenantDoesNotHoldBackOthers) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    options.rate_per_second = 1;
+    options.burst = 2;
+    TenantFairScheduler scheduler(options);
+    auto now = TenantFairScheduler::Clock::now();
+
+    scheduler.Allocate({"campaign"}, 100, now);  // Drains campaign's bucket
+
+    auto allocation = scheduler.Allocate({"campaign", "fresh"}, 10, now);
+    EXPECT_EQ(QuotaOf(allocation, "campaign"), 0);
+    EXPECT_EQ(QuotaOf(allocation, "fresh"), 2);
+}
+
+TEST(TenantFairSchedulerTest, RefundReturnsTokens) {
+    TenantFairSchedulerOptions options;
+    options.quantum = 10;
+    options.rate_per_second = 1;
+    options.burst = 10;
+    TenantFairScheduler scheduler(options);
+    auto now = TenantFairScheduler::Clock::now();
+
+    EXPECT_EQ(QuotaOf(scheduler.Allocate({"a"}, 10, now), "a"), 10);
+    scheduler.Refund("a", 7);  // Only three rows were due
+    EXPECT_EQ(QuotaOf(scheduler.Allocate({"a"}, 10, now), "a"), 7);
+}
+
 } // namespace test
 } // namespace common
 } // namespace saasforge
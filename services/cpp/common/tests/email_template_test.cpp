@@ -0,0 +1,112 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for email template compilation, rendering and caching
+ */
+
+#include <gtest/gtest.h>
+#include "common/email_template.h"
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+using namespace saasforge::common;
+
+namespace {
+
+using Vars = std::unordered_map<std::string, std::string>;
+
+std::string Render(const CompiledTemplate& compiled, const Vars& vars) {
+    std::string out;
+    compiled.Render(vars, out);
+    return out;
+}
+
+} // namespace
+
+TEST(EmailTemplateTest, SubstitutesVariables) {
+    auto compiled = CompiledTemplate::Compile("Hi {{ user_name }}, your code is {{otp_code}}.", false);
+    EXPECT_EQ(Render(compiled, {{"user_name", "Ada"}, {"otp_code", "123456"}}), "Hi Ada, your code is 123456.");
+    EXPECT_EQ(compiled.Variables().size(), 2u);
+    EXPECT_EQ(Render(compiled, {}), "Hi , your code is .");
+}
+
+TEST(EmailTemplateTest, EscapesHtmlUnlessTripleBraced) {
+    auto compiled = CompiledTemplate::Compile("<p>{{name}}</p>{{{raw}}}{{& raw}}{{! not rendered }}", true);
+    Vars vars{{"name", "<b>\"Tom\" & 'Jerry'</b>"}, {"raw", "<br>"}};
+    EXPECT_EQ(Render(compiled, vars), "<p>&lt;b&gt;&quot;Tom&quot; &amp; &#39;Jerry&#39;&lt;/b&gt;</p><br><br>");
+
+    auto text = CompiledTemplate::Compile("{{name}}", false);
+    EXPECT_EQ(Render(text, vars), vars["name"]);
+}
+
+TEST(EmailTemplateTest, KeepsUnterminatedTagsAsText) {
+    auto compiled = CompiledTemplate::Compile("a {{b}} c {{d", true);
+    EXPECT_EQ(Render(compiled, {{"b", "B"}}), "a B c {{d");
+}
+
+TEST(EmailTemplateTest, EscapesLongValuesAcrossChunks) {
+    std::string value(100, 'x');
+    value[3] = '<';
+    value[40] = '&';
+    value[99] = '>';
+    std::string out;
+    AppendHtmlEscaped(out, value);
+    std::string expected(100, 'x');
+    expected.replace(99, 1, "&gt;");
+    expected.replace(40, 1, "&amp;");
+    expected.replace(3, 1, "&lt;");
+    EXPECT_EQ(out, expected);
+}
+
+TEST(EmailTemplateTest, CacheRecompilesOnlyWhenVersionChanges) {
+    std::atomic<int> loads{0};
+    int64_t version = 1;
+    EmailTemplateOptions options;
+    options.ttl = std::chrono::seconds(0);  // Always revalidate
+    EmailTemplateCache cache(
+        [&](const std::string&, const std::string& template_id) -> std::optional<EmailTemplateSource> {
+            ++loads;
+            if (template_id == "missing") {
+                return std::nullopt;
+            }
+            return EmailTemplateSource{"t1", "Welcome {{name}}", "<p>{{name}}</p>", "{{name}}", version};
+        },
+        options);
+
+    auto first = cache.Get("tenant-1", "welcome");
+    ASSERT_TRUE(first);
+    auto second = cache.Get("tenant-1", "welcome");
+    EXPECT_EQ(second, first);
+
+    version = 2;
+    auto third = cache.Get("tenant-1", "welcome");
+    EXPECT_NE(third, first);
+    EXPECT_EQ(third->version, 2);
+    EXPECT_EQ(loads.load(), 3);
+
+    EXPECT_EQ(cache.Get("tenant-1", "missing"), nullptr);
+    EXPECT_EQ(cache.Size(), 1u);
+}
+
+TEST(EmailTemplateTest, CacheServesWithinTtlUntilInvalidated) {
+    int loads = 0;
+    EmailTemplateCache cache(
+        [&](const std::string&, const std::string&) -> std::optional<EmailTemplateSource> {
+            ++loads;
+            return EmailTemplateSource{"t1", "s", "h", "x", 1};
+        });
+
+    cache.Get("tenant-1", "welcome");
+    cache.Get("tenant-1", "welcome");
+    cache.Get("tenant-2", "welcome");
+    EXPECT_EQ(loads, 2);
+
+    cache.InvalidateTenant("tenant-1");
+    EXPECT_EQ(cache.Size(), 1u);
+    cache.Get("tenant-1", "welcome");
+    EXPECT_EQ(loads, 3);
+
+    cache.Invalidate("tenant-2", "welcome");
+    EXPECT_EQ(cache.Size(), 1u);
+}
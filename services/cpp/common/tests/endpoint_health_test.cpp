@@ -0,0 +1,178 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for per-endpoint webhook health scores and circuit state
+ */
+
+#include <gtest/gtest.h>
+#include "common/endpoint_health.h"
+#include <thread>
+
+using namespace saasforge::common;
+using std::chrono::milliseconds;
+
+namespace {
+
+const std::string kHost = "https://hooks.example.com:443";
+
+EndpointHealthOptions FastOptions() {
+    EndpointHealthOptions options;
+    options.failure_threshold = 3;
+    options.open_duration = milliseconds(50);
+    options.max_open_duration = milliseconds(150);
+    options.probe_timeout = milliseconds(1000);
+    return options;
+}
+
+void FailTimes(EndpointHealth& health, int times) {
+    for (int i = 0; i < times; ++i) {
+        health.RecordFailure(kHost, milliseconds(3000));
+    }
+}
+
+} // namespace
+
+// Test that unknown and healthy endpoints are always allowed
+TEST(EndpointHealthTest, AllowsHealthyEndpoints) {
+    EndpointHealth health(nullptr, FastOptions());
+    EXPECT_TRUE(health.Allow(kHost));
+    EXPECT_FALSE(health.Get(kHost).has_value());
+
+    health.RecordSuccess(kHost, milliseconds(40));
+    FailTimes(health, 2);
+    health.RecordSuccess(kHost, milliseconds(40));
+
+    auto snapshot = health.Get(kHost);
+    ASSERT_TRUE(snapshot.has_value());
+    EXPECT_EQ(snapshot->state, EndpointState::CLOSED);
+    EXPECT_EQ(snapshot->consecutive_failures, 0u);
+    EXPECT_LT(snapshot->success_rate, 1.0);
+    EXPECT_GT(snapshot->latency_ms, 40.0);
+    EXPECT_TRUE(health.Allow(kHost));
+    EXPECT_EQ(health.RetryAfter(kHost).count(), 0);
+}
+
+// Test that consecutive failures open the circuit and defer attempts
+TEST(EndpointHealthTest, OpensAfterConsecutiveFailures) {
+    EndpointHealth health(nullptr, FastOptions());
+    FailTimes(health, 3);
+
+    auto snapshot = health.Get(kHost);
+    ASSERT_TRUE(snapshot.has_value());
+    EXPECT_EQ(snapshot->state, EndpointState::OPEN);
+    EXPECT_FALSE(health.Allow(kHost));
+    EXPECT_GT(health.RetryAfter(kHost).count(), 0);
+    EXPECT_LE(health.RetryAfter(kHost).count(), 50);
+
+    // Other endpoints are unaffected
+    EXPECT_TRUE(health.Allow("https://other.example.com:443"));
+}
+
+// Test that a sustained poor success rate opens the circuit without a failure streak
+TEST(EndpointHealthTest, OpensOnLowSuccessRate) {
+    auto options = FastOptions();
+    options.failure_threshold = 100;
+    options.min_samples = 10;
+    options.min_success_rate = 0.5;
+    EndpointHealth health(nullptr, options);
+
+    for (int i = 0; i < 40 && health.Allow(kHost); ++i) {
+        if (i % 4 == 0) {
+            health.RecordSuccess(kHost, milliseconds(100));
+        } else {
+            health.RecordFailure(kHost, milliseconds(100));
+        }
+    }
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::OPEN);
+}
+
+// Test that a half-open circuit lets exactly one probe through, and a success closes it
+TEST(EndpointHealthTest, SingleProbeClosesOnSuccess) {
+    EndpointHealth health(nullptr, FastOptions());
+    FailTimes(health, 3);
+    std::this_thread::sleep_for(milliseconds(60));
+
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::HALF_OPEN);
+    EXPECT_EQ(health.RetryAfter(kHost).count(), 0);
+    EXPECT_TRUE(health.Allow(kHost));
+    EXPECT_FALSE(health.Allow(kHost));
+    EXPECT_TRUE(health.Get(kHost)->probing);
+
+    health.RecordSuccess(kHost, milliseconds(20));
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::CLOSED);
+    EXPECT_TRUE(health.Allow(kHost));
+    EXPECT_TRUE(health.Allow(kHost));
+
+    // The failure streak starts over
+    FailTimes(health, 2);
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::CLOSED);
+}
+
+// Test that a failed probe reopens the circuit for longer, up to the cap
+TEST(EndpointHealthTest, FailedProbeBacksOff) {
+    EndpointHealth health(nullptr, FastOptions());
+    FailTimes(health, 3);
+    std::this_thread::sleep_for(milliseconds(60));
+
+    ASSERT_TRUE(health.Allow(kHost));
+    health.RecordFailure(kHost, milliseconds(3000));
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::OPEN);
+    EXPECT_GT(health.RetryAfter(kHost).count(), 50);
+    EXPECT_LE(health.RetryAfter(kHost).count(), 100);
+
+    std::this_thread::sleep_for(milliseconds(110));
+    ASSERT_TRUE(health.Allow(kHost));
+    health.RecordFailure(kHost, milliseconds(3000));
+    EXPECT_GT(health.RetryAfter(kHost).count(), 100);
+    EXPECT_LE(health.RetryAfter(kHost).count(), 150);
+}
+
+// Test that a probe never reported is given up after probe_timeout
+TEST(EndpointHealthTest, LostProbeExpires) {
+    auto options = FastOptions();
+    options.probe_timeout = milliseconds(30);
+    EndpointHealth health(nullptr, options);
+    FailTimes(health, 3);
+    std::this_thread::sleep_for(milliseconds(60));
+
+    ASSERT_TRUE(health.Allow(kHost));
+    EXPECT_FALSE(health.Allow(kHost));
+    std::this_thread::sleep_for(milliseconds(40));
+    EXPECT_TRUE(health.Allow(kHost));
+}
+
+// Test shared transitions: an opening from another replica defers, a closing resets
+TEST(EndpointHealthTest, AppliesSharedTransitions) {
+    EndpointHealth health(nullptr, FastOptions());
+    int64_t open_until = EndpointHealth::NowMillis() + 10000;
+
+    health.Note(kHost, open_until);
+    EXPECT_FALSE(health.Allow(kHost));
+    EXPECT_GT(health.RetryAfter(kHost).count(), 9000);
+
+    // An older opening never shortens the current one
+    health.Note(kHost, open_until - 5000);
+    EXPECT_EQ(health.Get(kHost)->open_until_ms, open_until);
+
+    health.Note(kHost, 0);
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::CLOSED);
+    EXPECT_TRUE(health.Allow(kHost));
+
+    // Closing an endpoint this replica never saw does not track it
+    health.Note("https://unknown.example.com:443", 0);
+    EXPECT_EQ(health.Size(), 1u);
+}
+
+// Test that the table stays bounded, dropping healthy endpoints before open ones
+TEST(EndpointHealthTest, BoundsTrackedEndpoints) {
+    auto options = FastOptions();
+    options.max_hosts = 4;
+    EndpointHealth health(nullptr, options);
+    FailTimes(health, 3);
+
+    for (int i = 0; i < 20; ++i) {
+        health.RecordSuccess("https://host" + std::to_string(i) + ".example.com:443", milliseconds(10));
+    }
+    EXPECT_LE(health.Size(), 4u);
+    EXPECT_EQ(health.Get(kHost)->state, EndpointState::OPEN);
+}
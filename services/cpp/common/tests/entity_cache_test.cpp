@@ -0,0 +1,292 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the cache-aside entity cache
+ */
+
+#include <gtest/gtest.h>
+#include "common/entity_cache.h"
+#include <map>
+#include <thread>
+
+using namespace saasforge::common;
+using namespace std::chrono_literals;
+
+namespace {
+
+// The part of the protobuf message API the cache uses
+struct Message {
+    std::string text;
+
+    std::string SerializeAsString() const { return text; }
+    bool ParseFromString(const std::string& data) {
+        text = data;
+        return true;
+    }
+};
+
+using Key = std::pair<std::string, std::string>;
+using Cache = EntityCache<Key, Message>;
+
+// Redis stand-in shared by the caches of a test, like replicas sharing Redis
+struct FakeStore {
+    std::mutex mutex;
+    std::map<std::string, std::string> values;
+    std::atomic<bool> down{false};
+
+    EntityCacheStore Store() {
+        EntityCacheStore store;
+        store.get = [this](const std::string& key) -> std::optional<std::string> {
+            if (down.load()) {
+                throw std::runtime_error("connection refused");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = values.find(key);
+            return it == values.end() ? std::nullopt : std::optional<std::string>(it->second);
+        };
+        store.set = [this](const std::string& key, const std::string& value, std::chrono::milliseconds) {
+            std::lock_guard<std::mutex> lock(mutex);
+            values[key] = value;
+        };
+        store.erase = [this](const std::vector<std::string>& keys) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& key : keys) {
+                values.erase(key);
+            }
+        };
+        return store;
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return values.size();
+    }
+};
+
+EntityCacheOptions NoEarlyRefresh() {
+    EntityCacheOptions options;
+    options.beta = 0.0;
+    return options;
+}
+
+} // namespace
+
+// Test that a value is loaded once, then served locally and kept in Redis
+TEST(EntityCacheTest, LoadsOnceThenServesLocally) {
+    FakeStore fake;
+    Cache cache("subscription", fake.Store(), nullptr, NoEarlyRefresh());
+    int loads = 0;
+    auto load = [&]() -> std::optional<Message> {
+        ++loads;
+        return Message{"active"};
+    };
+
+    for (int i = 0; i < 5; ++i) {
+        auto value = cache.Get({"tenant-a", "sub-1"}, load);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(value->text, "active");
+    }
+    EXPECT_EQ(loads, 1);
+    EXPECT_EQ(fake.Size(), 1u);
+    EXPECT_EQ(fake.values.count("entity:subscription:tenant-a:sub-1"), 1u);
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.local_hits, 4u);
+    EXPECT_EQ(stats.loads, 1u);
+}
+
+// Test that another replica is served from Redis without loading
+TEST(EntityCacheTest, ReplicasShareTheRedisTier) {
+    FakeStore fake;
+    Cache first("invoice", fake.Store(), nullptr, NoEarlyRefresh());
+    Cache second("invoice", fake.Store(), nullptr, NoEarlyRefresh());
+    first.Get({"tenant-a", "in-1"}, [] { return std::optional<Message>(Message{"paid"}); });
+
+    bool loaded = false;
+    auto value = second.Get({"tenant-a", "in-1"}, [&] {
+        loaded = true;
+        return std::optional<Message>(Message{"other"});
+    });
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->text, "paid");
+    EXPECT_FALSE(loaded);
+    EXPECT_EQ(second.GetStats().shared_hits, 1u);
+}
+
+// Test that concurrent misses share one load
+TEST(EntityCacheTest, CoalescesConcurrentMisses) {
+    FakeStore fake;
+    Cache cache("subscription", fake.Store(), nullptr, NoEarlyRefresh());
+    std::atomic<int> loads{0};
+
+    std::vector<std::thread> threads;
+    std::vector<std::string> seen(8);
+    for (size_t i = 0; i < seen.size(); ++i) {
+        threads.emplace_back([&, i] {
+            auto value = cache.Get({"tenant-a", "sub-1"}, [&] {
+                loads.fetch_add(1);
+                std::this_thread::sleep_for(100ms);
+                return std::optional<Message>(Message{"active"});
+            });
+            seen[i] = value ? value->text : "";
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(loads.load(), 1);
+    EXPECT_EQ(cache.GetStats().coalesced, 7u);
+    for (const auto& text : seen) {
+        EXPECT_EQ(text, "active");
+    }
+}
+
+// Test that a loader exception reaches every waiter and nothing is cached
+TEST(EntityCacheTest, PropagatesLoadFailures) {
+    FakeStore fake;
+    Cache cache("quota", fake.Store(), nullptr, NoEarlyRefresh());
+    std::atomic<int> loads{0};
+    auto failing = [&]() -> std::optional<Message> {
+        loads.fetch_add(1);
+        std::this_thread::sleep_for(50ms);
+        throw std::runtime_error("database unavailable");
+    };
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            try {
+                cache.Get({"tenant-a", "quota"}, failing);
+            } catch (const std::runtime_error&) {
+                failures.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 4);
+    EXPECT_EQ(loads.load(), 1);
+    EXPECT_EQ(fake.Size(), 0u);
+
+    auto value = cache.Get({"tenant-a", "quota"}, [] { return std::optional<Message>(Message{"10GB"}); });
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(value->text, "10GB");
+}
+
+// Test that missing entities are not cached
+TEST(EntityCacheTest, DoesNotCacheMissingEntities) {
+    FakeStore fake;
+    Cache cache("subscription", fake.Store(), nullptr, NoEarlyRefresh());
+    int loads = 0;
+    auto missing = [&]() -> std::optional<Message> {
+        ++loads;
+        return std::nullopt;
+    };
+    EXPECT_EQ(cache.Get({"tenant-a", "nope"}, missing), nullptr);
+    EXPECT_EQ(cache.Get({"tenant-a", "nope"}, missing), nullptr);
+    EXPECT_EQ(loads, 2);
+    EXPECT_EQ(fake.Size(), 0u);
+}
+
+// Test that Invalidate() drops both tiers, including a fill it overlaps
+TEST(EntityCacheTest, InvalidateDropsBothTiers) {
+    FakeStore fake;
+    Cache cache("subscription", fake.Store(), nullptr, NoEarlyRefresh());
+    std::string status = "active";
+    auto load = [&] { return std::optional<Message>(Message{status}); };
+
+    cache.Get({"tenant-a", "sub-1"}, load);
+    status = "canceled";
+    cache.Invalidate({"tenant-a", "sub-1"});
+    EXPECT_EQ(fake.Size(), 0u);
+    EXPECT_EQ(cache.Get({"tenant-a", "sub-1"}, load)->text, "canceled");
+
+    // A write committing while the row is being read: the fill is returned but not kept
+    cache.Invalidate({"tenant-a", "sub-1"});
+    auto racing = cache.Get({"tenant-a", "sub-1"}, [&] {
+        cache.Invalidate({"tenant-a", "sub-1"});
+        return std::optional<Message>(Message{"stale"});
+    });
+    EXPECT_EQ(racing->text, "stale");
+    EXPECT_EQ(fake.Size(), 0u);
+    EXPECT_EQ(cache.Get({"tenant-a", "sub-1"}, load)->text, "canceled");
+    EXPECT_EQ(cache.GetStats().invalidations, 3u);
+
+    cache.Get({"tenant-b", "sub-2"}, load);
+    EXPECT_EQ(fake.Size(), 2u);
+    cache.InvalidateMany({{"tenant-a", "sub-1"}, {"tenant-b", "sub-2"}});
+    EXPECT_EQ(fake.Size(), 0u);
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+// Test that keys of different tenants never collide
+TEST(EntityCacheTest, KeepsTenantsApart) {
+    FakeStore fake;
+    Cache cache("subscription", fake.Store(), nullptr, NoEarlyRefresh());
+    cache.Get({"tenant-a", "sub-1"}, [] { return std::optional<Message>(Message{"a"}); });
+    auto other = cache.Get({"tenant-b", "sub-1"}, [] { return std::optional<Message>(Message{"b"}); });
+    EXPECT_EQ(other->text, "b");
+    EXPECT_EQ(fake.Size(), 2u);
+}
+
+// Test that hits reload ahead of expiry, and keep the value if that reload fails
+TEST(EntityCacheTest, RefreshesEarly) {
+    FakeStore fake;
+    auto options = NoEarlyRefresh();
+    options.beta = 1e9;   // Any measurable load time triggers a refresh
+    Cache cache("invoice", fake.Store(), nullptr, options);
+    int loads = 0;
+    auto slow = [&] {
+        ++loads;
+        std::this_thread::sleep_for(2ms);
+        return std::optional<Message>(Message{"v" + std::to_string(loads)});
+    };
+
+    EXPECT_EQ(cache.Get({"tenant-a", "in-1"}, slow)->text, "v1");
+    EXPECT_EQ(cache.Get({"tenant-a", "in-1"}, slow)->text, "v2");
+    EXPECT_EQ(loads, 2);
+    EXPECT_EQ(cache.GetStats().early_refreshes, 1u);
+
+    auto failing = []() -> std::optional<Message> { throw std::runtime_error("database unavailable"); };
+    EXPECT_EQ(cache.Get({"tenant-a", "in-1"}, failing)->text, "v2");
+}
+
+// Test that values are reloaded once their ttl has passed
+TEST(EntityCacheTest, ReloadsAfterTtl) {
+    FakeStore fake;
+    auto options = NoEarlyRefresh();
+    options.ttl = 1s;
+    Cache cache("quota", fake.Store(), nullptr, options);
+    int loads = 0;
+    auto load = [&] {
+        ++loads;
+        return std::optional<Message>(Message{"used"});
+    };
+    cache.Get({"tenant-a", "quota"}, load);
+    cache.Get({"tenant-a", "quota"}, load);
+    EXPECT_EQ(loads, 1);
+    std::this_thread::sleep_for(1100ms);
+    cache.Get({"tenant-a", "quota"}, load);
+    EXPECT_EQ(loads, 2);
+}
+
+// Test that Redis failures fall back to the loader
+TEST(EntityCacheTest, ServesWhileRedisIsDown) {
+    FakeStore fake;
+    fake.down = true;
+    auto options = NoEarlyRefresh();
+    options.local_ttl = 0ms;   // Every lookup goes past the local tier
+    Cache cache("subscription", fake.Store(), nullptr, options);
+    int loads = 0;
+    auto load = [&] {
+        ++loads;
+        return std::optional<Message>(Message{"active"});
+    };
+    EXPECT_EQ(cache.Get({"tenant-a", "sub-1"}, load)->text, "active");
+    EXPECT_EQ(cache.Get({"tenant-a", "sub-1"}, load)->text, "active");
+    EXPECT_EQ(loads, 2);
+    EXPECT_EQ(cache.GetStats().store_errors, 2u);
+}
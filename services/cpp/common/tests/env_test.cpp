@@ -0,0 +1,58 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for reading configuration from environment variables
+ */
+
+#include <gtest/gtest.h>
+#include "common/env.h"
+#include <cstdlib>
+
+using namespace saasforge::common;
+
+// Test that only complete, non-negative integers override the default
+TEST(EnvTest, EnvInt) {
+    unsetenv("SAASFORGE_TEST_INT");
+    EXPECT_EQ(EnvInt("SAASFORGE_TEST_INT", 7), 7);
+
+    for (const char* invalid : {"", "12ms", "-3", "x"}) {
+        setenv("SAASFORGE_TEST_INT", invalid, 1);
+        EXPECT_EQ(EnvInt("SAASFORGE_TEST_INT", 7), 7) << invalid;
+    }
+
+    setenv("SAASFORGE_TEST_INT", "0", 1);
+    EXPECT_EQ(EnvInt("SAASFORGE_TEST_INT", 7), 0);
+    setenv("SAASFORGE_TEST_INT", "250", 1);
+    EXPECT_EQ(EnvInt("SAASFORGE_TEST_INT", 7), 250);
+    unsetenv("SAASFORGE_TEST_INT");
+}
+
+// Test that ratios stay within [0, 1]
+TEST(EnvTest, EnvDoubleAndRatio) {
+    setenv("SAASFORGE_TEST_DOUBLE", "1.5", 1);
+    EXPECT_DOUBLE_EQ(EnvDouble("SAASFORGE_TEST_DOUBLE", 0.25), 1.5);
+    EXPECT_DOUBLE_EQ(EnvRatio("SAASFORGE_TEST_DOUBLE", 0.25), 0.25);
+
+    setenv("SAASFORGE_TEST_DOUBLE", "0.1", 1);
+    EXPECT_DOUBLE_EQ(EnvRatio("SAASFORGE_TEST_DOUBLE", 0.25), 0.1);
+
+    setenv("SAASFORGE_TEST_DOUBLE", "-0.1", 1);
+    EXPECT_DOUBLE_EQ(EnvDouble("SAASFORGE_TEST_DOUBLE", 0.25), 0.25);
+    unsetenv("SAASFORGE_TEST_DOUBLE");
+}
+
+// Test that strings and lists treat empty as unset
+TEST(EnvTest, EnvStringAndList) {
+    setenv("SAASFORGE_TEST_STRING", "", 1);
+    EXPECT_EQ(EnvString("SAASFORGE_TEST_STRING", "fallback"), "fallback");
+    EXPECT_EQ(EnvString("SAASFORGE_TEST_STRING"), "");
+    EXPECT_TRUE(EnvList("SAASFORGE_TEST_STRING").empty());
+
+    setenv("SAASFORGE_TEST_STRING", "a,,b,", 1);
+    EXPECT_EQ(EnvString("SAASFORGE_TEST_STRING"), "a,,b,");
+    EXPECT_EQ(EnvList("SAASFORGE_TEST_STRING", {"x"}), (std::vector<std::string>{"a", "b"}));
+
+    setenv("SAASFORGE_TEST_STRING", " a , \tb,  ,", 1);
+    EXPECT_EQ(EnvList("SAASFORGE_TEST_STRING"), (std::vector<std::string>{"a", "b"}));
+    unsetenv("SAASFORGE_TEST_STRING");
+}
@@ -0,0 +1,333 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the Redis Streams event bus
+ */
+
+#include <gtest/gtest.h>
+#include "common/event_bus.h"
+#include <algorithm>
+#include <map>
+
+using namespace saasforge::common;
+using namespace std::chrono_literals;
+
+namespace {
+
+// In-memory streams with consumer groups (no per-consumer split, no trimming)
+class FakeStreams {
+public:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<std::string, std::vector<StreamMessage>> streams;
+    struct Group {
+        size_t delivered = 0;                 // Entries handed out (">")
+        std::vector<std::string> pending;
+    };
+    std::map<std::pair<std::string, std::string>, Group> groups;
+    std::atomic<int> append_calls{0};
+    std::atomic<int> ack_calls{0};
+    std::atomic<bool> down{false};
+    uint64_t seq = 0;
+
+    EventStreams Streams() {
+        EventStreams s;
+        s.append = [this](const EventStreams::Entries& entries, size_t) {
+            append_calls.fetch_add(1);
+            if (down.load()) {
+                throw std::runtime_error("connection refused");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& [key, payload] : entries) {
+                streams[key].push_back({"1-" + std::to_string(++seq), payload});
+            }
+            cv.notify_all();
+        };
+        s.create_group = [this](const std::string& key, const std::string& group) {
+            if (down.load()) {
+                throw std::runtime_error("connection refused");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            auto [it, inserted] = groups.try_emplace({key, group});
+            if (inserted) {
+                it->second.delivered = streams[key].size();
+            }
+            return inserted;
+        };
+        s.destroy_group = [this](const std::string& key, const std::string& group) {
+            std::lock_guard<std::mutex> lock(mutex);
+            groups.erase({key, group});
+        };
+        s.read_group = [this](const std::string& key, const std::string& group, const std::string&,
+                              const std::string& id, size_t count, std::chrono::milliseconds block) {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = groups.find({key, group});
+            if (it == groups.end()) {
+                throw StreamGroupMissing("NOGROUP");
+            }
+            std::vector<StreamMessage> out;
+            auto& entries = streams[key];
+            if (id == "0") {
+                for (const auto& pending : it->second.pending) {
+                    for (const auto& entry : entries) {
+                        if (entry.id == pending && out.size() < count) {
+                            out.push_back(entry);
+                        }
+                    }
+                }
+                return out;
+            }
+            cv.wait_for(lock, block, [&] {
+                auto group_it = groups.find({key, group});
+                return group_it == groups.end() || group_it->second.delivered < streams[key].size();
+            });
+            it = groups.find({key, group});
+            if (it == groups.end()) {
+                throw StreamGroupMissing("NOGROUP");
+            }
+            while (it->second.delivered < entries.size() && out.size() < count) {
+                out.push_back(entries[it->second.delivered++]);
+                it->second.pending.push_back(out.back().id);
+            }
+            return out;
+        };
+        s.ack = [this](const std::string& key, const std::string& group, const std::vector<std::string>& ids) {
+            ack_calls.fetch_add(1);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& pending = groups[{key, group}].pending;
+            for (const auto& id : ids) {
+                pending.erase(std::remove(pending.begin(), pending.end(), id), pending.end());
+            }
+        };
+        return s;
+    }
+
+    size_t GroupCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return groups.size();
+    }
+
+    void DropGroups() {
+        std::lock_guard<std::mutex> lock(mutex);
+        groups.clear();
+        cv.notify_all();
+    }
+};
+
+EventBusOptions TestOptions() {
+    EventBusOptions options;
+    options.block = 50ms;
+    options.retry = 20ms;
+    options.consumer = "test-1";
+    return options;
+}
+
+// Collects payloads from a handler thread
+struct Received {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> payloads;
+
+    EventBus::Handler Handler() {
+        return [this](const std::string& payload) {
+            std::lock_guard<std::mutex> lock(mutex);
+            payloads.push_back(payload);
+            cv.notify_all();
+        };
+    }
+
+    bool WaitFor(size_t count, std::chrono::milliseconds timeout = 2000ms) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, timeout, [&] { return payloads.size() >= count; });
+    }
+};
+
+} // namespace
+
+// Test that every subscription of a topic receives every event, in order
+TEST(EventBusTest, BroadcastsToEverySubscription) {
+    FakeStreams fake;
+    EventBus bus(fake.Streams(), TestOptions());
+    Received first;
+    Received second;
+    Received other;
+    bus.Subscribe("keys", first.Handler());
+    bus.Subscribe("keys", second.Handler());
+    bus.Subscribe("plans", other.Handler());
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(bus.Publish("keys", "k" + std::to_string(i)));
+    }
+    ASSERT_TRUE(first.WaitFor(5));
+    ASSERT_TRUE(second.WaitFor(5));
+    EXPECT_EQ(first.payloads, (std::vector<std::string>{"k0", "k1", "k2", "k3", "k4"}));
+    EXPECT_EQ(second.payloads, first.payloads);
+    EXPECT_TRUE(other.payloads.empty());
+    EXPECT_TRUE(fake.streams.count("events:keys"));
+}
+
+// Test that a named group shares events among its members
+TEST(EventBusTest, NamedGroupDeliversEachEventOnce) {
+    FakeStreams fake;
+    EventBus first_bus(fake.Streams(), TestOptions());
+    EventBus second_bus(fake.Streams(), TestOptions());
+    Received received;
+    first_bus.Subscribe("jobs", received.Handler(), nullptr, "workers");
+    second_bus.Subscribe("jobs", received.Handler(), nullptr, "workers");
+
+    for (int i = 0; i < 20; ++i) {
+        first_bus.Publish("jobs", std::to_string(i));
+    }
+    ASSERT_TRUE(received.WaitFor(20));
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(received.payloads.size(), 20u);
+
+    // Shared groups outlive their members
+    first_bus.Shutdown();
+    second_bus.Shutdown();
+    EXPECT_EQ(fake.GroupCount(), 1u);
+}
+
+// Test that buffered events go out in batches and are acknowledged per batch
+TEST(EventBusTest, BatchesAppendsAndAcks) {
+    FakeStreams fake;
+    auto options = TestOptions();
+    options.batch = 100;
+    EventBus bus(fake.Streams(), options);
+    Received received;
+    bus.Subscribe("usage", received.Handler());
+
+    fake.down = true;   // Hold the publisher until everything is buffered
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(bus.Publish("usage", std::to_string(i)));
+    }
+    fake.down = false;
+    ASSERT_TRUE(bus.Flush(2000ms));
+    ASSERT_TRUE(received.WaitFor(1000));
+    EXPECT_LE(fake.append_calls.load(), 40);   // 10 batches, plus failures while held
+    EXPECT_LE(fake.ack_calls.load(), 100);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(received.payloads[i], std::to_string(i));
+    }
+}
+
+// Test that a full buffer makes Publish() wait, then drop
+TEST(EventBusTest, DropsWhenTheBufferStaysFull) {
+    FakeStreams fake;
+    fake.down = true;
+    auto options = TestOptions();
+    options.batch = 5;
+    options.max_buffered = 10;
+    options.publish_wait = 10ms;
+    options.retry = 1000ms;
+    EventBus bus(fake.Streams(), options);
+
+    int accepted = 0;
+    for (int i = 0; i < 30; ++i) {
+        accepted += bus.Publish("t", "x") ? 1 : 0;
+    }
+    // The buffer plus at most one batch in flight
+    EXPECT_LE(accepted, 15);
+    EXPECT_GE(accepted, 10);
+    EXPECT_EQ(bus.Dropped(), static_cast<uint64_t>(30 - accepted));
+    EXPECT_FALSE(bus.Flush(10ms));
+}
+
+// Test that events published while Redis was down are sent once it is back
+TEST(EventBusTest, RetriesFailedAppends) {
+    FakeStreams fake;
+    EventBus bus(fake.Streams(), TestOptions());
+    Received received;
+    bus.Subscribe("keys", received.Handler());
+
+    fake.down = true;
+    bus.Publish("keys", "a");
+    bus.Publish("keys", "b");
+    std::this_thread::sleep_for(60ms);
+    fake.down = false;
+    ASSERT_TRUE(received.WaitFor(2));
+    EXPECT_EQ(received.payloads, (std::vector<std::string>{"a", "b"}));
+}
+
+// Test that a lost group is created again and reported through on_reset
+TEST(EventBusTest, RecreatesLostGroups) {
+    FakeStreams fake;
+    EventBus bus(fake.Streams(), TestOptions());
+    Received received;
+    std::atomic<int> resets{0};
+    bus.Subscribe("prefs", received.Handler(), [&] { resets.fetch_add(1); });
+
+    bus.Publish("prefs", "before");
+    ASSERT_TRUE(received.WaitFor(1));
+    EXPECT_EQ(resets.load(), 0);
+
+    fake.DropGroups();
+    for (int i = 0; i < 100 && resets.load() == 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(resets.load(), 1);
+    bus.Publish("prefs", "after");
+    ASSERT_TRUE(received.WaitFor(2));
+    EXPECT_EQ(received.payloads.back(), "after");
+}
+
+// Test that a subscription made while Redis is down starts with on_reset
+TEST(EventBusTest, ResetsWhenTheGroupIsCreatedLate) {
+    FakeStreams fake;
+    fake.down = true;
+    EventBus bus(fake.Streams(), TestOptions());
+    std::atomic<int> resets{0};
+    bus.Subscribe("plans", [](const std::string&) {}, [&] { resets.fetch_add(1); });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(resets.load(), 0);
+
+    fake.down = false;
+    for (int i = 0; i < 100 && resets.load() == 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(resets.load(), 1);
+}
+
+// Test that unacknowledged entries are delivered again after a failed ack
+TEST(EventBusTest, RedeliversUnacknowledgedEntries) {
+    FakeStreams fake;
+    auto streams = fake.Streams();
+    std::atomic<int> failing_acks{1};
+    auto ack = streams.ack;
+    streams.ack = [&, ack](const std::string& key, const std::string& group, const std::vector<std::string>& ids) {
+        if (failing_acks.fetch_sub(1) > 0) {
+            throw std::runtime_error("connection reset");
+        }
+        ack(key, group, ids);
+    };
+    EventBus bus(std::move(streams), TestOptions());
+    Received received;
+    bus.Subscribe("keys", received.Handler());
+
+    bus.Publish("keys", "once");
+    ASSERT_TRUE(received.WaitFor(2));
+    EXPECT_EQ(received.payloads, (std::vector<std::string>{"once", "once"}));
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(received.payloads.size(), 2u);
+}
+
+// Test that per-process groups are removed and handlers stop on Unsubscribe()
+TEST(EventBusTest, UnsubscribeRemovesTheGroup) {
+    FakeStreams fake;
+    EventBus bus(fake.Streams(), TestOptions());
+    Received received;
+    uint64_t id = bus.Subscribe("keys", received.Handler());
+    EXPECT_EQ(fake.GroupCount(), 1u);
+
+    bus.Unsubscribe(id);
+    EXPECT_EQ(fake.GroupCount(), 0u);
+    bus.Publish("keys", "late");
+    ASSERT_TRUE(bus.Flush(1000ms));
+    std::this_thread::sleep_for(100ms);
+    EXPECT_TRUE(received.payloads.empty());
+
+    bus.Unsubscribe(id);   // Unknown ids are ignored
+    bus.Shutdown();
+    bus.Shutdown();
+    EXPECT_FALSE(bus.Publish("keys", "after shutdown"));
+}
@@ -0,0 +1,183 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the bounded executor used by callback-API services
+ */
+
+#include <gtest/gtest.h>
+#include "common/executor.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace saasforge::common;
+
+// Test that submitted tasks run
+TEST(ExecutorTest, RunsSubmittedTasks) {
+    std::atomic<int> counter{0};
+    {
+        Executor executor(4, 100);
+        for (int i = 0; i < 50; ++i) {
+            EXPECT_TRUE(executor.TrySubmit([&counter] { counter++; }));
+        }
+    } // Destructor drains the queue
+
+    EXPECT_EQ(counter.load(), 50);
+}
+
+// Test that a full queue rejects instead of growing without bound
+TEST(ExecutorTest, RejectsWhenQueueFull) {
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::promise<void> started;
+
+    Executor executor(1, 2);
+
+    // Occupy the single worker
+    ASSERT_TRUE(executor.TrySubmit([&started, gate] { started.set_value(); gate.wait(); }));
+    started.get_future().wait();
+
+    EXPECT_TRUE(executor.TrySubmit([] {}));
+    EXPECT_TRUE(executor.TrySubmit([] {}));
+    EXPECT_FALSE(executor.TrySubmit([] {}));
+    EXPECT_EQ(executor.RejectedCount(), 1u);
+    EXPECT_EQ(executor.QueueDepth(), 2u);
+
+    release.set_value();
+}
+
+// Test that submissions after shutdown are rejected
+TEST(ExecutorTest, RejectsAfterShutdown) {
+    Executor executor(2, 10);
+    executor.Shutdown();
+    EXPECT_FALSE(executor.TrySubmit([] {}));
+}
+
+// Test that a throwing task does not kill the worker
+TEST(ExecutorTest, SurvivesThrowingTask) {
+    std::promise<void> done;
+    Executor executor(1, 10);
+
+    EXPECT_TRUE(executor.TrySubmit([] { throw std::runtime_error("boom"); }));
+    EXPECT_TRUE(executor.TrySubmit([&done] { done.set_value(); }));
+
+    EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+// Test default thread count
+TEST(ExecutorTest, ZeroThreadsUsesHardwareDefault) {
+    Executor executor(0, 10);
+    EXPECT_GE(executor.ThreadCount(), 2u);
+}
+
+// Test that critical tasks are taken ahead of queued bulk tasks
+TEST(ExecutorTest, CriticalTasksRunBeforeBulk) {
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::promise<void> started;
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    Executor executor(1, 10);
+    ASSERT_TRUE(executor.TrySubmit([&started, gate] { started.set_value(); gate.wait(); }));
+    started.get_future().wait();
+
+    auto record = [&](const char* name) {
+        return [&, name] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+    };
+    ASSERT_TRUE(executor.TrySubmit(record("bulk"), TaskPriority::BULK));
+    ASSERT_TRUE(executor.TrySubmit(record("critical"), TaskPriority::CRITICAL));
+    EXPECT_EQ(executor.QueueDepth(), 2u);
+
+    release.set_value();
+    executor.Shutdown();
+    EXPECT_EQ(order, (std::vector<std::string>{"critical", "bulk"}));
+}
+
+// Test that bulk tasks leave a worker free for critical ones
+TEST(ExecutorTest, BulkTasksNeverTakeEveryWorker) {
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::atomic<int> bulk_started{0};
+
+    Executor executor(2, 10);
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(executor.TrySubmit([&bulk_started, gate] { bulk_started++; gate.wait(); }, TaskPriority::BULK));
+    }
+
+    std::promise<void> critical;
+    ASSERT_TRUE(executor.TrySubmit([&critical] { critical.set_value(); }));
+    EXPECT_EQ(critical.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(bulk_started.load(), 1);
+
+    release.set_value();
+    executor.Shutdown();
+    EXPECT_EQ(bulk_started.load(), 2);
+}
+
+// Test that periodic tasks repeat until cancelled, without overlapping
+TEST(ExecutorTest, RunsPeriodicTasksUntilCancelled) {
+    std::atomic<int> runs{0};
+    std::atomic<int> running{0};
+    std::atomic<bool> overlapped{false};
+
+    Executor executor(4, 10);
+    uint64_t id = executor.SchedulePeriodic(std::chrono::milliseconds(5), [&] {
+        if (running++ > 0) {
+            overlapped = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        running--;
+        runs++;
+    });
+    EXPECT_EQ(executor.PeriodicCount(), 1u);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (runs.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    executor.Cancel(id);
+    int after_cancel = runs.load();
+    EXPECT_GE(after_cancel, 3);
+    EXPECT_EQ(executor.PeriodicCount(), 0u);
+    EXPECT_FALSE(overlapped.load());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(runs.load(), after_cancel);
+    executor.Cancel(id);    // Unknown ids are ignored
+}
+
+// Test that a periodic task waits for its initial delay and survives throwing
+TEST(ExecutorTest, PeriodicTaskDelaysAndSurvivesExceptions) {
+    std::atomic<int> runs{0};
+    auto scheduled = std::chrono::steady_clock::now();
+    std::atomic<int64_t> first_run_ms{-1};
+
+    Executor executor(1, 10);
+    executor.SchedulePeriodic(std::chrono::milliseconds(5), [&] {
+        if (runs++ == 0) {
+            first_run_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - scheduled).count();
+            throw std::runtime_error("boom");
+        }
+    }, std::chrono::milliseconds(50));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (runs.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_GE(runs.load(), 2);
+    EXPECT_GE(first_run_ms.load(), 50);
+
+    // Shutdown cancels what is still scheduled
+    executor.Shutdown();
+    EXPECT_EQ(executor.PeriodicCount(), 0u);
+    EXPECT_EQ(executor.SchedulePeriodic(std::chrono::milliseconds(5), [] {}), 0u);
+}
@@ -0,0 +1,114 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the SIGTERM-driven graceful shutdown
+ */
+
+#include <gtest/gtest.h>
+#include "common/graceful_shutdown.h"
+#include "common/warmup.h"
+#include <csignal>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/grpcpp.h>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Records the statuses GracefulShutdown sets
+class FakeHealth : public grpc::HealthCheckServiceInterface {
+public:
+    void SetServingStatus(const std::string& service_name, bool serving) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statuses_[service_name] = serving;
+    }
+    void SetServingStatus(bool serving) override { SetServingStatus("", serving); }
+
+    std::optional<bool> Status(const std::string& service_name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = statuses_.find(service_name);
+        return it == statuses_.end() ? std::nullopt : std::optional<bool>(it->second);
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, bool> statuses_;
+};
+
+ShutdownOptions FastOptions() {
+    ShutdownOptions options;
+    options.drain_delay = std::chrono::seconds(0);
+    options.grace = std::chrono::seconds(1);
+    return options;
+}
+
+} // namespace
+
+TEST(GracefulShutdownTest, RequestShutdownWakesWait) {
+    GracefulShutdown shutdown(FastOptions());
+    std::thread requester([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        GracefulShutdown::RequestShutdown();
+    });
+    EXPECT_EQ(shutdown.Wait(), 0);
+    requester.join();
+}
+
+TEST(GracefulShutdownTest, SigtermWakesWait) {
+    GracefulShutdown shutdown(FastOptions());
+    std::raise(SIGTERM);
+    EXPECT_EQ(shutdown.Wait(), SIGTERM);
+}
+
+TEST(GracefulShutdownTest, OnlyOneInstance) {
+    GracefulShutdown shutdown(FastOptions());
+    EXPECT_THROW(GracefulShutdown second(FastOptions()), std::logic_error);
+}
+
+TEST(GracefulShutdownTest, StepsRunInOrderAfterNotServing) {
+    FakeHealth health;
+    health.SetServingStatus(true);
+
+    GracefulShutdown shutdown(FastOptions());
+    std::vector<std::string> order;
+    shutdown.Add("executor", [&] {
+        EXPECT_EQ(health.Status(""), false);
+        EXPECT_EQ(health.Status(Warmup::LIVENESS_SERVICE), true);
+        order.push_back("executor");
+    });
+    shutdown.Add("flush", [&] {
+        order.push_back("flush");
+        throw std::runtime_error("connection refused");
+    });
+    shutdown.Add("database", [&] { order.push_back("database"); });
+
+    EXPECT_FALSE(shutdown.Run(nullptr, &health));
+    EXPECT_EQ(order, (std::vector<std::string>{"executor", "flush", "database"}));
+}
+
+TEST(GracefulShutdownTest, DrainsTheServerBeforeSteps) {
+    // Something to serve: a server without services does not start
+    grpc::CallbackGenericService service;
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.RegisterCallbackGenericService(&service);
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    ASSERT_NE(port, 0);
+
+    std::thread waiter([&] { server->Wait(); });
+
+    GracefulShutdown shutdown(FastOptions());
+    bool ran = false;
+    shutdown.Add("pool", [&] { ran = true; });
+    EXPECT_TRUE(shutdown.Run(server.get(), nullptr));
+    EXPECT_TRUE(ran);
+
+    // Shutdown() returned, so Wait() does too
+    waiter.join();
+}
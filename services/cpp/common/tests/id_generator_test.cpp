@@ -0,0 +1,107 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for time-ordered ids
+ */
+
+#include <gtest/gtest.h>
+#include "common/id_generator.h"
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace saasforge::common;
+
+namespace {
+
+int64_t NowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// Test that ids carry the UUIDv7 version and variant and the current time
+TEST(IdGeneratorTest, GeneratesVersion7Uuids) {
+    int64_t before = NowMillis();
+    auto id = IdGenerator::Next();
+    int64_t after = NowMillis();
+
+    EXPECT_EQ(id[6] >> 4, 7);
+    EXPECT_EQ(id[8] >> 6, 2);
+    EXPECT_GE(IdGenerator::UnixMillis(id), before);
+    EXPECT_LE(IdGenerator::UnixMillis(id), after + 1);
+
+    std::string text = IdGenerator::ToUuid(id);
+    ASSERT_EQ(text.size(), 36u);
+    EXPECT_EQ(text[8], '-');
+    EXPECT_EQ(text[13], '-');
+    EXPECT_EQ(text[14], '7');
+    EXPECT_EQ(text[18], '-');
+    EXPECT_NE(std::string("89ab").find(text[19]), std::string::npos);
+    EXPECT_EQ(text[23], '-');
+}
+
+// Test that one thread's ids strictly increase, in bytes and as text
+TEST(IdGeneratorTest, IdsOfAThreadIncrease) {
+    auto previous = IdGenerator::Next();
+    std::string previous_uuid = IdGenerator::ToUuid(previous);
+    std::string previous_ulid = IdGenerator::ToUlid(previous);
+    for (int i = 0; i < 100000; ++i) {
+        auto id = IdGenerator::Next();
+        ASSERT_LT(previous, id);
+        std::string uuid = IdGenerator::ToUuid(id);
+        std::string ulid = IdGenerator::ToUlid(id);
+        ASSERT_LT(previous_uuid, uuid);
+        ASSERT_LT(previous_ulid, ulid);
+        previous = id;
+        previous_uuid = std::move(uuid);
+        previous_ulid = std::move(ulid);
+    }
+    // Borrowing milliseconds under a burst keeps the clock close
+    EXPECT_LE(IdGenerator::UnixMillis(previous), NowMillis() + 100);
+}
+
+// Test that threads generating at once never collide
+TEST(IdGeneratorTest, IdsAreUniqueAcrossThreads) {
+    std::mutex mutex;
+    std::set<std::string> ids;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            std::vector<std::string> local;
+            for (int i = 0; i < 10000; ++i) {
+                local.push_back(IdGenerator::NewUuid());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            ids.insert(local.begin(), local.end());
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(ids.size(), 80000u);
+}
+
+// Test the ULID encoding and prefixed ids
+TEST(IdGeneratorTest, FormatsUlids) {
+    IdGenerator::Bytes zero{};
+    EXPECT_EQ(IdGenerator::ToUlid(zero), "00000000000000000000000000");
+
+    IdGenerator::Bytes ones;
+    ones.fill(0xff);
+    EXPECT_EQ(IdGenerator::ToUlid(ones), "7ZZZZZZZZZZZZZZZZZZZZZZZZZ");
+    EXPECT_EQ(IdGenerator::ToUuid(ones), "ffffffff-ffff-ffff-ffff-ffffffffffff");
+
+    IdGenerator::Bytes low{};
+    low[15] = 33;
+    EXPECT_EQ(IdGenerator::ToUlid(low), "00000000000000000000000011");
+
+    std::string customer = IdGenerator::NewUlid("cus");
+    ASSERT_EQ(customer.size(), 30u);
+    EXPECT_EQ(customer.compare(0, 4, "cus_"), 0);
+    EXPECT_EQ(customer.find_first_not_of("0123456789ABCDEFGHJKMNPQRSTVWXYZ", 4), std::string::npos);
+    EXPECT_EQ(IdGenerator::NewUlid().size(), 26u);
+}
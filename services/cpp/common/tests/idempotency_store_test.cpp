@@ -0,0 +1,296 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for idempotency claims, replay and in-flight coalescing
+ */
+
+#include <gtest/gtest.h>
+#include "common/idempotency_store.h"
+#include <atomic>
+#include <map>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+// In-memory stand-in for Redis (no expiry)
+struct FakeBackend {
+    std::mutex mutex;
+    std::map<std::string, std::string> values;
+    std::atomic<int> claims{0};
+
+    IdempotencyBackend Make() {
+        IdempotencyBackend backend;
+        backend.claim = [this](const std::string& key, const std::string& value, std::chrono::milliseconds) {
+            ++claims;
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = values.find(key);
+            if (it != values.end()) {
+                return std::optional<std::string>(it->second);
+            }
+            values[key] = value;
+            return std::optional<std::string>();
+        };
+        backend.complete = [this](const std::string& key, const std::string& expected, const std::string& value,
+                                  std::chrono::milliseconds) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = values.find(key);
+            if (it == values.end() || it->second != expected) {
+                return false;
+            }
+            it->second = value;
+            return true;
+        };
+        backend.release = [this](const std::string& key, const std::string& expected) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = values.find(key);
+            if (it != values.end() && it->second == expected) {
+                values.erase(it);
+            }
+        };
+        backend.get = [this](const std::string& key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = values.find(key);
+            return it == values.end() ? std::optional<std::string>() : std::optional<std::string>(it->second);
+        };
+        return backend;
+    }
+
+    void Set(const std::string& key, const std::string& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        values[key] = value;
+    }
+
+    void Erase(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        values.erase(key);
+    }
+};
+
+const std::string FP = IdempotencyStore::Fingerprint("request-a");
+
+IdempotencyOptions FastOptions() {
+    IdempotencyOptions options;
+    options.wait_timeout = std::chrono::milliseconds(200);
+    options.poll_interval = std::chrono::milliseconds(5);
+    return options;
+}
+
+} // namespace
+
+TEST(IdempotencyStoreTest, ExecutesOnceThenReplays) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    int runs = 0;
+    auto handler = [&]() -> std::optional<std::string> {
+        ++runs;
+        return std::string("response-1");
+    };
+
+    auto first = store.Execute("t1:k1", FP, handler);
+    auto second = store.Execute("t1:k1", FP, handler);
+
+    EXPECT_EQ(first.kind, IdempotencyOutcome::Kind::EXECUTED);
+    EXPECT_EQ(second.kind, IdempotencyOutcome::Kind::REPLAYED);
+    EXPECT_EQ(second.body, "response-1");
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(backend.values.count("idempotency:t1:k1"), 1u);
+}
+
+TEST(IdempotencyStoreTest, KeysAreIndependent) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    int runs = 0;
+    auto handler = [&]() -> std::optional<std::string> {
+        ++runs;
+        return std::string("r");
+    };
+
+    store.Execute("t1:k1", FP, handler);
+    store.Execute("t1:k2", FP, handler);
+    store.Execute("t2:k1", FP, handler);
+
+    EXPECT_EQ(runs, 3);
+}
+
+TEST(IdempotencyStoreTest, DifferentFingerprintConflicts) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    store.Execute("t1:k1", FP, [] { return std::optional<std::string>("r"); });
+
+    bool ran = false;
+    auto outcome = store.Execute("t1:k1", IdempotencyStore::Fingerprint("request-b"), [&] {
+        ran = true;
+        return std::optional<std::string>("other");
+    });
+
+    EXPECT_EQ(outcome.kind, IdempotencyOutcome::Kind::CONFLICT);
+    EXPECT_FALSE(ran);
+}
+
+TEST(IdempotencyStoreTest, FailedAttemptReleasesKey) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+
+    auto failed = store.Execute("t1:k1", FP, [] { return std::optional<std::string>(); });
+    EXPECT_EQ(failed.kind, IdempotencyOutcome::Kind::EXECUTED);
+    EXPECT_TRUE(backend.values.empty());
+
+    auto retried = store.Execute("t1:k1", FP, [] { return std::optional<std::string>("ok"); });
+    EXPECT_EQ(retried.kind, IdempotencyOutcome::Kind::EXECUTED);
+}
+
+TEST(IdempotencyStoreTest, ThrowingHandlerReleasesKeyAndPropagates) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+
+    EXPECT_THROW(store.Execute("t1:k1", FP, []() -> std::optional<std::string> {
+        throw std::runtime_error("db down");
+    }), std::runtime_error);
+
+    EXPECT_TRUE(backend.values.empty());
+    EXPECT_EQ(store.InFlightCount(), 0u);
+}
+
+TEST(IdempotencyStoreTest, ConcurrentDuplicatesCoalesce) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    std::atomic<int> runs{0};
+    std::atomic<bool> release{false};
+
+    auto handler = [&]() -> std::optional<std::string> {
+        ++runs;
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return std::string("shared");
+    };
+
+    std::vector<IdempotencyOutcome> outcomes(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < outcomes.size(); ++i) {
+        threads.emplace_back([&, i] { outcomes[i] = store.Execute("t1:k1", FP, handler); });
+    }
+    while (runs == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(runs.load(), 1);
+    int executed = 0;
+    for (const auto& outcome : outcomes) {
+        if (outcome.kind == IdempotencyOutcome::Kind::EXECUTED) {
+            ++executed;
+        } else {
+            EXPECT_EQ(outcome.kind, IdempotencyOutcome::Kind::REPLAYED);
+            EXPECT_EQ(outcome.body, "shared");
+        }
+    }
+    EXPECT_EQ(executed, 1);
+    EXPECT_EQ(backend.claims.load(), 1);  // Duplicates never reached the backend
+}
+
+TEST(IdempotencyStoreTest, CoalescedWaitersRetryAfterFailure) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    std::atomic<int> runs{0};
+    std::atomic<bool> release{false};
+
+    std::thread owner([&] {
+        store.Execute("t1:k1", FP, [&]() -> std::optional<std::string> {
+            ++runs;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return std::nullopt;
+        });
+    });
+    while (runs == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    IdempotencyOutcome waiter_outcome;
+    std::thread waiter([&] {
+        waiter_outcome = store.Execute("t1:k1", FP, [&] {
+            ++runs;
+            return std::optional<std::string>("second");
+        });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    owner.join();
+    waiter.join();
+
+    EXPECT_EQ(runs.load(), 2);
+    EXPECT_EQ(waiter_outcome.kind, IdempotencyOutcome::Kind::EXECUTED);
+}
+
+TEST(IdempotencyStoreTest, WaitsForOtherInstance) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    backend.Set("idempotency:t1:k1", "P|0123456789abcdef|" + FP);
+
+    std::thread other([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        backend.Set("idempotency:t1:k1", "D|" + FP + "|from-other");
+    });
+
+    bool ran = false;
+    auto outcome = store.Execute("t1:k1", FP, [&] {
+        ran = true;
+        return std::optional<std::string>("mine");
+    });
+    other.join();
+
+    EXPECT_EQ(outcome.kind, IdempotencyOutcome::Kind::REPLAYED);
+    EXPECT_EQ(outcome.body, "from-other");
+    EXPECT_FALSE(ran);
+}
+
+TEST(IdempotencyStoreTest, OtherInstanceStillRunningTimesOut) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    backend.Set("idempotency:t1:k1", "P|0123456789abcdef|" + FP);
+
+    auto outcome = store.Execute("t1:k1", FP, [] { return std::optional<std::string>("mine"); });
+
+    EXPECT_EQ(outcome.kind, IdempotencyOutcome::Kind::IN_PROGRESS);
+}
+
+TEST(IdempotencyStoreTest, ReleasedClaimElsewhereIsRetried) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    backend.Set("idempotency:t1:k1", "P|0123456789abcdef|" + FP);
+
+    std::thread other([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        backend.Erase("idempotency:t1:k1");
+    });
+
+    auto outcome = store.Execute("t1:k1", FP, [] { return std::optional<std::string>("mine"); });
+    other.join();
+
+    EXPECT_EQ(outcome.kind, IdempotencyOutcome::Kind::EXECUTED);
+}
+
+TEST(IdempotencyStoreTest, ResponseBodyMayContainSeparators) {
+    FakeBackend backend;
+    IdempotencyStore store(backend.Make(), FastOptions());
+    std::string body("a|b\0c|", 6);
+
+    store.Execute("t1:k1", FP, [&] { return std::optional<std::string>(body); });
+    auto replay = store.Execute("t1:k1", FP, [] { return std::optional<std::string>("x"); });
+
+    EXPECT_EQ(replay.body, body);
+}
+
+TEST(IdempotencyStoreTest, Fingerprint) {
+    EXPECT_EQ(IdempotencyStore::Fingerprint("abc"),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_NE(IdempotencyStore::Fingerprint("a"), IdempotencyStore::Fingerprint("b"));
+}
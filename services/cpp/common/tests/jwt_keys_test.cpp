@@ -0,0 +1,187 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for JWT key ids, key set documents and kid-based key selection
+ */
+
+#include <gtest/gtest.h>
+#include "common/jwt_keys.h"
+#include "common/jwt_signer.h"
+#include "common/jwt_validator.h"
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <chrono>
+#include <fstream>
+
+using namespace saasforge::common;
+
+namespace {
+
+struct KeyPair {
+    std::string private_key;
+    std::string public_key;
+};
+
+std::string ReadBio(BIO* bio) {
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    std::string out(data, static_cast<size_t>(len));
+    BIO_free(bio);
+    return out;
+}
+
+// Fresh keys per run (no key material checked in)
+KeyPair MakeKeys(EVP_PKEY* pkey) {
+    KeyPair keys;
+    BIO* priv_bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(priv_bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    keys.private_key = ReadBio(priv_bio);
+    BIO* pub_bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PUBKEY(pub_bio, pkey);
+    keys.public_key = ReadBio(pub_bio);
+    EVP_PKEY_free(pkey);
+    return keys;
+}
+
+KeyPair RsaKeys() { return MakeKeys(EVP_RSA_gen(2048)); }
+KeyPair P256Keys() { return MakeKeys(EVP_EC_gen("P-256")); }
+KeyPair Ed25519Keys() { return MakeKeys(EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519")); }
+
+JwtValidatorOptions KeySetOptions(const std::string& source) {
+    JwtValidatorOptions options;
+    options.cache_capacity = 0;
+    options.blacklist_filter = false;
+    options.keys_source = source;
+    options.keys_refresh = std::chrono::seconds(3600);   // Refreshed by hand in tests
+    return options;
+}
+
+JwtSigner::Builder Claims() {
+    auto now = std::chrono::system_clock::now();
+    return jwt::create()
+        .set_issuer("saasforge")
+        .set_subject("user-1")
+        .set_id("jti-1")
+        .set_issued_at(now)
+        .set_expires_at(now + std::chrono::minutes(15))
+        .set_payload_claim("tenant_id", jwt::claim(std::string("tenant-1")))
+        .set_payload_claim("email", jwt::claim(std::string("user@example.com")));
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+    std::ofstream(path, std::ios::trunc) << contents;
+}
+
+} // namespace
+
+TEST(JwtKeysTest, KeyIdIsTheRfc7638Thumbprint) {
+    // RFC 7638 section 3.1 example key
+    std::string pem = jwt::helper::create_public_key_from_rsa_components(
+        "0vx7agoebGcQSuuPiLJXZptN9nndrQmbXEps2aiAFbWhM78LhWx4cbbfAAtVT86zwu1RK7aPFFxuhDR1L6tSoc_BJECPebWKRXjB"
+        "ZCiFV4n3oknjhMstn64tZ_2W-5JsGY4Hc5n9yBXArwl93lqt7_RN5w6Cf0h4QyQ5v-65YGjQR0_FDW2QvzqY368QQMicAtaSqzs8"
+        "KJZgnYb9c7d0zgdAZHzu6qMQvRL5hajrn1n91CbOpbISD08qNLyrdkt-bFTWhAI4vMQFh6WeZu0fM4lFd2NcRwr3XPksINHaQ-G_"
+        "xBniIqbw0Ls1jF44-csFCur-kEgU8awapJzKnqDKgw",
+        "AQAB");
+    EXPECT_EQ(JwtKeyId(pem), "NzbLsXh8uDCcd-6MNwXF4W_7noWXFZAfHkxZsRGC9Xs");
+}
+
+TEST(JwtKeysTest, BothHalvesOfAPairShareTheKeyId) {
+    for (const auto& keys : {RsaKeys(), P256Keys(), Ed25519Keys()}) {
+        EXPECT_EQ(JwtKeyId(keys.private_key), JwtKeyId(keys.public_key));
+        EXPECT_EQ(JwtSigner(keys.private_key).KeyId(), JwtKeyId(keys.public_key));
+    }
+    EXPECT_NE(JwtKeyId(RsaKeys().public_key), JwtKeyId(RsaKeys().public_key));
+}
+
+TEST(JwtKeysTest, JwksRoundTrips) {
+    std::vector<std::string> pems = {RsaKeys().public_key, P256Keys().private_key, Ed25519Keys().public_key};
+    auto keys = ParseJwtKeys(JwksFromKeys(pems));
+    ASSERT_EQ(keys.size(), 3u);
+    for (size_t i = 0; i < pems.size(); ++i) {
+        EXPECT_EQ(keys[i].kid, JwtKeyId(pems[i]));
+        EXPECT_EQ(JwtKeyId(keys[i].pem), JwtKeyId(pems[i]));
+        EXPECT_EQ(keys[i].pem.find("PRIVATE"), std::string::npos);
+    }
+}
+
+TEST(JwtKeysTest, ParsesPemBundles) {
+    KeyPair first = RsaKeys();
+    KeyPair second = Ed25519Keys();
+    auto keys = ParseJwtKeys(first.public_key + second.public_key);
+    ASSERT_EQ(keys.size(), 2u);
+    EXPECT_EQ(keys[0].kid, JwtKeyId(first.public_key));
+    EXPECT_EQ(keys[1].kid, JwtKeyId(second.public_key));
+}
+
+TEST(JwtKeysTest, SkipsKeysThatCannotVerifyTokens) {
+    std::string jwks = JwksFromKeys({Ed25519Keys().public_key});
+    jwks.insert(jwks.size() - 2, ",{\"kty\":\"oct\",\"kid\":\"hmac\",\"k\":\"c2VjcmV0\"}"
+                                 ",{\"kty\":\"RSA\",\"use\":\"enc\",\"kid\":\"enc\",\"n\":\"AQAB\",\"e\":\"AQAB\"}");
+    auto keys = ParseJwtKeys(jwks);
+    ASSERT_EQ(keys.size(), 1u);
+
+    EXPECT_THROW(ParseJwtKeys("{not json"), std::invalid_argument);
+    EXPECT_THROW(ParseJwtKeys("no keys here"), std::invalid_argument);
+}
+
+TEST(JwtKeysTest, ValidatorSelectsTheKeyByKid) {
+    KeyPair rsa = RsaKeys();
+    KeyPair ed25519 = Ed25519Keys();
+    std::string path = testing::TempDir() + "jwt_keys_test.jwks";
+    WriteFile(path, JwksFromKeys({rsa.public_key, ed25519.public_key}));
+
+    JwtValidator validator("", nullptr, KeySetOptions(path));
+    EXPECT_EQ(validator.KeyCount(), 2u);
+    EXPECT_TRUE(validator.Validate(JwtSigner(rsa.private_key).Sign(Claims())).has_value());
+
+    std::string ed25519_token = JwtSigner(ed25519.private_key).Sign(Claims());
+    EXPECT_TRUE(validator.Validate(ed25519_token).has_value());
+    EXPECT_FALSE(validator.Validate(JwtSigner(P256Keys().private_key).Sign(Claims())).has_value());
+
+    // A token naming one key but signed by another is rejected
+    KeyPair other = Ed25519Keys();
+    auto forged = Claims().set_key_id(JwtKeyId(rsa.public_key))
+        .sign(jwt::algorithm::ed25519("", other.private_key, "", ""));
+    EXPECT_FALSE(validator.Validate(forged).has_value());
+
+    // Dropped from the document: no longer accepted
+    WriteFile(path, JwksFromKeys({rsa.public_key}));
+    EXPECT_TRUE(validator.RefreshKeys());
+    EXPECT_EQ(validator.KeyCount(), 1u);
+    EXPECT_FALSE(validator.Validate(ed25519_token).has_value());
+}
+
+TEST(JwtKeysTest, BadDocumentsKeepTheCurrentKeys) {
+    KeyPair keys = P256Keys();
+    std::string path = testing::TempDir() + "jwt_keys_bad.pem";
+    WriteFile(path, keys.public_key);
+    JwtValidator validator("", nullptr, KeySetOptions(path));
+
+    WriteFile(path, "{\"keys\": [");
+    EXPECT_FALSE(validator.RefreshKeys());
+    EXPECT_EQ(validator.KeyCount(), 1u);
+    EXPECT_TRUE(validator.Validate(JwtSigner(keys.private_key).Sign(Claims())).has_value());
+}
+
+TEST(JwtKeysTest, PinnedKeyStaysAlongsideTheKeySet) {
+    KeyPair pinned = RsaKeys();
+    KeyPair published = Ed25519Keys();
+    std::string path = testing::TempDir() + "jwt_keys_pinned.pem";
+    WriteFile(path, published.public_key);
+
+    JwtValidator validator(pinned.public_key, nullptr, KeySetOptions(path));
+    EXPECT_EQ(validator.KeyCount(), 2u);
+    EXPECT_TRUE(validator.Validate(JwtSigner(pinned.private_key).Sign(Claims())).has_value());
+    EXPECT_TRUE(validator.Validate(JwtSigner(published.private_key).Sign(Claims())).has_value());
+
+    // Tokens minted before kids were added are tried against every key
+    auto legacy = Claims().sign(jwt::algorithm::ed25519("", published.private_key, "", ""));
+    EXPECT_TRUE(validator.Validate(legacy).has_value());
+}
+
+TEST(JwtKeysTest, UnreachableSourceWithoutPinnedKeyThrows) {
+    EXPECT_THROW(JwtValidator("", nullptr, KeySetOptions(testing::TempDir() + "missing.jwks")),
+                 std::runtime_error);
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 #include "common/jwt_validator.h"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <chrono>
+#include <ctime>
 
 namespace saasforge {
 namespace common {
@@ -8,33 +13,137 @@ namespace test {
 class JwtValidatorTest : public ::testing::Test {
 protected:
     void SetUp() override {
-        // TODO: Setup test RSA keys
+        // Fresh RSA keypair per test run (no key material checked in)
+        EVP_PKEY* pkey = EVP_RSA_gen(2048);
+        ASSERT_NE(pkey, nullptr);
+
+        BIO* priv_bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PrivateKey(priv_bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+        private_key_ = ReadBio(priv_bio);
+
+        BIO* pub_bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PUBKEY(pub_bio, pkey);
+        public_key_ = ReadBio(pub_bio);
+
+        EVP_PKEY_free(pkey);
+    }
+
+    static std::string ReadBio(BIO* bio) {
+        char* data = nullptr;
+        long len = BIO_get_mem_data(bio, &data);
+        std::string out(data, static_cast<size_t>(len));
+        BIO_free(bio);
+        return out;
+    }
+
+    std::string MakeToken(std::chrono::seconds lifetime, const std::string& jti = "jti-1") {
+        auto now = std::chrono::system_clock::now();
+        return jwt::create()
+            .set_issuer("saasforge")
+            .set_subject("user-1")
+            .set_id(jti)
+            .set_issued_at(now)
+            .set_expires_at(now + lifetime)
+            .set_payload_claim("tenant_id", jwt::claim(std::string("tenant-1")))
+            .set_payload_claim("email", jwt::claim(std::string("user@example.com")))
+            .sign(jwt::algorithm::rs256("", private_key_, "", ""));
     }
+
+    std::string public_key_;
+    std::string private_key_;
 };
 
 TEST_F(JwtValidatorTest, ValidateValidToken) {
-    // TODO: Implement test
-    EXPECT_TRUE(true);
+    JwtValidator validator(public_key_, nullptr);
+    auto claims = validator.Validate(MakeToken(std::chrono::minutes(15)));
+
+    ASSERT_TRUE(claims.has_value());
+    EXPECT_EQ(claims->user_id, "user-1");
+    EXPECT_EQ(claims->tenant_id, "tenant-1");
+    EXPECT_EQ(claims->email, "user@example.com");
+    EXPECT_EQ(claims->jti, "jti-1");
+}
+
+TEST_F(JwtValidatorTest, ExpiryIsInUnixSeconds) {
+    JwtValidator validator(public_key_, nullptr);
+    auto claims = validator.Validate(MakeToken(std::chrono::minutes(15)));
+
+    ASSERT_TRUE(claims.has_value());
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    EXPECT_NEAR(claims->exp, now + 900, 5);
+    EXPECT_NEAR(claims->iat, now, 5);
 }
 
 TEST_F(JwtValidatorTest, RejectExpiredToken) {
-    // TODO: Implement test
-    EXPECT_TRUE(true);
+    JwtValidator validator(public_key_, nullptr);
+    EXPECT_FALSE(validator.Validate(MakeToken(std::chrono::seconds(-60))).has_value());
+    EXPECT_EQ(validator.CacheSize(), 0u);
 }
 
 TEST_F(JwtValidatorTest, RejectInvalidSignature) {
-    // TODO: Implement test
-    EXPECT_TRUE(true);
-}
+    JwtValidator validator(public_key_, nullptr);
+    std::string token = MakeToken(std::chrono::minutes(15));
+    token.back() = token.back() == 'A' ? 'B' : 'A';
 
-TEST_F(JwtValidatorTest, RejectBlacklistedToken) {
-    // TODO: Implement test
-    EXPECT_TRUE(true);
+    EXPECT_FALSE(validator.Validate(token).has_value());
+    EXPECT_EQ(validator.CacheSize(), 0u);
 }
 
 TEST_F(JwtValidatorTest, RejectAlgorithmNone) {
-    // TODO: Implement test to prevent algorithm confusion attack
-    EXPECT_TRUE(true);
+    JwtValidator validator(public_key_, nullptr);
+    auto token = jwt::create()
+        .set_issuer("saasforge")
+        .set_subject("user-1")
+        .set_expires_at(std::chrono::system_clock::now() + std::chrono::minutes(15))
+        .sign(jwt::algorithm::none{});
+
+    EXPECT_FALSE(validator.Validate(token).has_value());
+}
+
+TEST_F(JwtValidatorTest, RepeatTokenServedFromCache) {
+    JwtValidator validator(public_key_, nullptr);
+    std::string token = MakeToken(std::chrono::minutes(15));
+
+    auto first = validator.Validate(token);
+    auto second = validator.Validate(token);
+
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(first->jti, second->jti);
+    EXPECT_EQ(validator.CacheSize(), 1u);
+}
+
+TEST_F(JwtValidatorTest, DistinctTokensCachedSeparately) {
+    JwtValidator validator(public_key_, nullptr);
+    auto a = validator.Validate(MakeToken(std::chrono::minutes(15), "jti-a"));
+    auto b = validator.Validate(MakeToken(std::chrono::minutes(15), "jti-b"));
+
+    ASSERT_TRUE(a.has_value());
+    ASSERT_TRUE(b.has_value());
+    EXPECT_EQ(a->jti, "jti-a");
+    EXPECT_EQ(b->jti, "jti-b");
+    EXPECT_EQ(validator.CacheSize(), 2u);
+}
+
+TEST_F(JwtValidatorTest, CacheCanBeDisabled) {
+    JwtValidatorOptions options;
+    options.cache_capacity = 0;
+    JwtValidator validator(public_key_, nullptr, options);
+
+    EXPECT_TRUE(validator.Validate(MakeToken(std::chrono::minutes(15))).has_value());
+    EXPECT_EQ(validator.CacheSize(), 0u);
+}
+
+TEST_F(JwtValidatorTest, CacheCapacityIsBounded) {
+    JwtValidatorOptions options;
+    options.cache_capacity = 4;
+    options.cache_stripes = 2;
+    JwtValidator validator(public_key_, nullptr, options);
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(validator.Validate(MakeToken(std::chrono::minutes(15), "jti-" + std::to_string(i))).has_value());
+    }
+    EXPECT_LE(validator.CacheSize(), 4u);
 }
 
 } // namespace test
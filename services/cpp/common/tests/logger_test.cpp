@@ -0,0 +1,166 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the asynchronous structured logger
+ */
+
+#include <gtest/gtest.h>
+#include "common/logger.h"
+#include <mutex>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+// Collects everything the logger writes
+struct Capture {
+    std::mutex mutex;
+    std::string output;
+    int writes = 0;
+
+    Logger::Sink Make() {
+        return [this](std::string_view data) {
+            std::lock_guard<std::mutex> lock(mutex);
+            output.append(data);
+            ++writes;
+        };
+    }
+
+    std::vector<std::string> Lines() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> lines;
+        size_t start = 0;
+        for (size_t end; (end = output.find('\n', start)) != std::string::npos; start = end + 1) {
+            lines.push_back(output.substr(start, end - start));
+        }
+        return lines;
+    }
+};
+
+LoggerOptions Options() {
+    LoggerOptions options;
+    options.flush_interval = std::chrono::hours(1);  // Tests flush explicitly
+    options.rate_limit_per_s = 0;
+    return options;
+}
+
+} // namespace
+
+TEST(LoggerTest, WritesJsonRecords) {
+    Capture capture;
+    Logger logger(Options(), capture.Make());
+
+    logger.Log(LogLevel::kWarn, "Tenant ID mismatch", {{"tenant", "t-1"}, {"attempts", 3}, {"retry", false}});
+    logger.Log(LogLevel::kInfo, "Quote \" and\nnewline", {{"path", std::string("a\\b")}});
+    logger.Flush();
+
+    auto lines = capture.Lines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0].rfind("{\"ts\":\"", 0), 0u);
+    EXPECT_NE(lines[0].find("Z\",\"level\":\"warn\",\"msg\":\"Tenant ID mismatch\","
+                            "\"tenant\":\"t-1\",\"attempts\":3,\"retry\":false}"), std::string::npos);
+    EXPECT_NE(lines[1].find("\"msg\":\"Quote \\\" and\\nnewline\",\"path\":\"a\\\\b\"}"), std::string::npos);
+}
+
+TEST(LoggerTest, TextFormat) {
+    Capture capture;
+    auto options = Options();
+    options.json = false;
+    Logger logger(options, capture.Make());
+
+    logger.Log(LogLevel::kError, "Flush failed", {{"batch", "b 1"}, {"count", 2}});
+    logger.Flush();
+
+    auto lines = capture.Lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("Z ERROR Flush failed batch=\"b 1\" count=2"), std::string::npos);
+}
+
+TEST(LoggerTest, FiltersByLevel) {
+    Capture capture;
+    Logger logger(Options(), capture.Make());
+
+    logger.Log(LogLevel::kDebug, "hidden");
+    EXPECT_FALSE(logger.Enabled(LogLevel::kDebug));
+    logger.SetLevel(LogLevel::kDebug);
+    logger.Log(LogLevel::kDebug, "shown");
+    logger.Flush();
+
+    auto lines = capture.Lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("\"msg\":\"shown\""), std::string::npos);
+}
+
+TEST(LoggerTest, RateLimitsRepeatedMessages) {
+    Capture capture;
+    auto options = Options();
+    options.rate_limit_per_s = 3;
+    Logger logger(options, capture.Make());
+
+    for (int i = 0; i < 10; ++i) {
+        logger.Log(LogLevel::kWarn, "Extracting tenant context without JWT validation");
+    }
+    logger.Log(LogLevel::kWarn, "Different message");
+    logger.Flush();
+
+    EXPECT_EQ(capture.Lines().size(), 4u);
+    EXPECT_EQ(logger.GetStats().suppressed, 7u);
+
+    // The next admitted repeat reports how many were dropped
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    logger.Log(LogLevel::kWarn, "Extracting tenant context without JWT validation");
+    logger.Flush();
+    auto lines = capture.Lines();
+    ASSERT_EQ(lines.size(), 5u);
+    EXPECT_NE(lines[4].find("\"suppressed\":7}"), std::string::npos);
+}
+
+TEST(LoggerTest, FullRingDropsAndReports) {
+    Capture capture;
+    auto options = Options();
+    options.ring_capacity = 4;
+    Logger logger(options, capture.Make());
+
+    for (int i = 0; i < 10; ++i) {
+        logger.Log(LogLevel::kInfo, "record", {{"i", i}});
+    }
+    logger.Flush();
+
+    auto lines = capture.Lines();
+    ASSERT_GE(lines.size(), 2u);
+    EXPECT_GT(logger.GetStats().dropped, 0u);
+    EXPECT_NE(lines.back().find("\"msg\":\"Log records dropped, thread buffer full\""), std::string::npos);
+    EXPECT_EQ(logger.GetStats().written, lines.size());
+}
+
+TEST(LoggerTest, WriterBatchesManyThreads) {
+    Capture capture;
+    auto options = Options();
+    options.flush_interval = std::chrono::milliseconds(5);
+    auto logger = std::make_unique<Logger>(options, capture.Make());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < 200; ++i) {
+                logger->Log(LogLevel::kInfo, "work", {{"thread", t}, {"i", i}});
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    logger->Shutdown();
+
+    auto lines = capture.Lines();
+    EXPECT_EQ(lines.size(), 1600u);
+    EXPECT_LT(capture.writes, 1600);
+    for (const auto& line : lines) {
+        ASSERT_EQ(line.back(), '}');
+    }
+
+    // After shutdown records are written through
+    logger->Log(LogLevel::kError, "late");
+    EXPECT_EQ(capture.Lines().size(), 1601u);
+}
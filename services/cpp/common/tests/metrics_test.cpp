@@ -0,0 +1,297 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for metrics, the Prometheus exposition and the /metrics endpoint
+ */
+
+#include <gtest/gtest.h>
+#include "common/metrics.h"
+#include "common/metrics_interceptor.h"
+#include "common/metrics_server.h"
+#include <arpa/inet.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace saasforge::common;
+
+namespace {
+
+std::string HttpGet(uint16_t port, const std::string& request) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return "";
+    }
+    ::send(fd, request.data(), request.size(), 0);
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    return response;
+}
+
+/// Writes a fixed CPU profile and serves a fixed heap one
+Profiler::Backend FakeBackend() {
+    Profiler::Backend backend;
+    backend.cpu_name = "fake";
+    backend.start_cpu = [](const std::string& path) {
+        std::ofstream(path) << "cpu-profile";
+        return true;
+    };
+    backend.stop_cpu = [] {};
+    backend.heap_name = "fake";
+    backend.heap_profile = [] { return std::string("heap-profile"); };
+    return backend;
+}
+
+MetricsServerOptions ProfilingServerOptions() {
+    MetricsServerOptions options;
+    options.bind_address = "127.0.0.1";
+    options.port = 0;
+    options.profiling.token = "s3cret";
+    return options;
+}
+
+std::string ProfileRequest(const std::string& target, const std::string& token = "s3cret") {
+    return "GET " + target + " HTTP/1.1\r\nHost: x\r\nAuthorization: Bearer " + token + "\r\n\r\n";
+}
+
+} // namespace
+
+TEST(MetricsTest, CounterSumsAcrossThreads) {
+    MetricsRegistry registry;
+    Counter& counter = registry.GetCounter("requests_total", "Requests");
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) {
+                counter.Increment();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(counter.Value(), 80000u);
+    EXPECT_EQ(&registry.GetCounter("requests_total", "Requests"), &counter);
+    EXPECT_THROW(registry.GetGauge("requests_total", "Requests"), std::invalid_argument);
+}
+
+TEST(MetricsTest, HistogramBucketsAreLogLinear) {
+    for (uint64_t value : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 100ull, 1000ull, 123456789ull}) {
+        size_t bucket = Histogram::BucketIndex(value);
+        EXPECT_GE(Histogram::BucketUpperBound(bucket), value);
+        if (bucket > 0) {
+            EXPECT_LT(Histogram::BucketUpperBound(bucket - 1), value);
+        }
+        // Within 12.5%
+        EXPECT_LE(Histogram::BucketUpperBound(bucket), value + value / 8 + 1);
+    }
+    EXPECT_EQ(Histogram::BucketIndex(uint64_t{1} << 50), Histogram::NUM_BUCKETS - 1);
+}
+
+TEST(MetricsTest, HistogramQuantiles) {
+    Histogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        histogram.Record(i);
+    }
+
+    auto snapshot = histogram.Snapshot();
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.sum, 500500u);
+    EXPECT_NEAR(static_cast<double>(snapshot.ValueAtQuantile(0.5)), 500, 500 * 0.125);
+    EXPECT_NEAR(static_cast<double>(snapshot.ValueAtQuantile(0.99)), 990, 990 * 0.125);
+    EXPECT_EQ(Histogram().Snapshot().ValueAtQuantile(0.5), 0u);
+}
+
+TEST(MetricsTest, RendersPrometheusText) {
+    MetricsRegistry registry;
+    registry.GetCounter("jobs_total", "Jobs \"done\"\nso far", {{"queue", "a\"b"}}).Increment(3);
+    registry.GetGauge("depth", "Queue depth").Set(-2);
+    Histogram& latency = registry.GetHistogram("latency_seconds", "Latency", HistogramOptions::LatencySeconds());
+    latency.Record(50);       // 50us
+    latency.Record(2000);     // 2ms
+    latency.Record(20000000); // 20s, beyond the last bound
+
+    std::string text = registry.Render();
+
+    EXPECT_NE(text.find("# HELP jobs_total Jobs \"done\"\\nso far\n# TYPE jobs_total counter\n"
+                        "jobs_total{queue=\"a\\\"b\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE depth gauge\ndepth -2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"0.0001\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"0.001\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"0.0025\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"10\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_sum 20.00205\n"), std::string::npos);
+    EXPECT_NE(text.find("latency_seconds_count 3\n"), std::string::npos);
+}
+
+TEST(MetricsTest, CollectorsWriteOnScrape) {
+    MetricsRegistry registry;
+    int pool_size = 4;
+    uint64_t id = registry.AddCollector([&pool_size](MetricsWriter& writer) {
+        writer.AddGauge("pool_size", "Open connections", {{"pool", "main"}}, pool_size);
+        writer.AddGauge("pool_size", "Open connections", {{"pool", "replica"}}, 1);
+        writer.AddHistogram("wait_seconds", "Wait", {}, {0.001, 0.01}, {2, 5}, 6, 0.5);
+    });
+
+    pool_size = 7;
+    std::string text = registry.Render();
+    EXPECT_NE(text.find("# TYPE pool_size gauge\npool_size{pool=\"main\"} 7\npool_size{pool=\"replica\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("wait_seconds_bucket{le=\"0.01\"} 5\nwait_seconds_bucket{le=\"+Inf\"} 6\n"),
+              std::string::npos);
+
+    registry.RemoveCollector(id);
+    EXPECT_EQ(registry.Render().find("pool_size"), std::string::npos);
+}
+
+TEST(MetricsTest, InterceptorMetricsPerMethod) {
+    MetricsRegistry registry;
+    MetricsInterceptorFactory factory(registry);
+
+    auto& login = factory.ForMethod("/saasforge.auth.AuthService/Login");
+    EXPECT_EQ(&factory.ForMethod("/saasforge.auth.AuthService/Login"), &login);
+    EXPECT_TRUE(login.count_request_bytes);
+    EXPECT_FALSE(factory.ForMethod("/grpc.health.v1.Health/Check").count_request_bytes);
+
+    login.Handled(0).Increment();
+    login.Handled(16).Increment(2);
+    login.Handled(99).Increment();   // Out of range counts as UNKNOWN
+
+    std::string text = registry.Render();
+    EXPECT_NE(text.find("saasforge_grpc_server_handled_total{grpc_service=\"saasforge.auth.AuthService\","
+                        "grpc_method=\"Login\",grpc_code=\"UNAUTHENTICATED\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("grpc_method=\"Login\",grpc_code=\"UNKNOWN\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("saasforge_grpc_server_in_flight{grpc_service=\"grpc.health.v1.Health\","
+                        "grpc_method=\"Check\"} 0\n"), std::string::npos);
+}
+
+TEST(MetricsServerTest, ServesMetricsOverHttp) {
+    MetricsRegistry registry;
+    registry.GetCounter("scrapes_total", "Scrapes").Increment();
+    MetricsServerOptions options;
+    options.bind_address = "127.0.0.1";
+    options.port = 0;
+    MetricsServer server(registry, options);
+    ASSERT_NE(server.Port(), 0);
+
+    std::string response = HttpGet(server.Port(), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(response.find("\r\n\r\n# HELP scrapes_total Scrapes\n"), std::string::npos);
+
+    EXPECT_EQ(HttpGet(server.Port(), "GET /healthz HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), "GET /other HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 404", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), "POST /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 405", 0), 0u);
+
+    server.Shutdown();
+    EXPECT_EQ(HttpGet(server.Port(), "GET /metrics HTTP/1.1\r\n\r\n"), "");
+}
+
+TEST(MetricsServerTest, ProfilingNeedsATokenAndTheRightBearer) {
+    MetricsRegistry registry;
+    Profiler profiler(FakeBackend());
+
+    MetricsServerOptions options = ProfilingServerOptions();
+    options.profiling.token.clear();
+    MetricsServer disabled(registry, options, profiler);
+    EXPECT_EQ(HttpGet(disabled.Port(), ProfileRequest("/debug/pprof/heap", "")).rfind("HTTP/1.1 404", 0), 0u);
+
+    MetricsServer server(registry, ProfilingServerOptions(), profiler);
+    EXPECT_EQ(HttpGet(server.Port(), "GET /debug/pprof/heap HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 401", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/heap", "wrong")).rfind("HTTP/1.1 401", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/heap", "s3cre")).rfind("HTTP/1.1 401", 0), 0u);
+
+    std::string response = HttpGet(server.Port(),
+        "GET /debug/pprof/heap HTTP/1.1\r\nauthorization:   Bearer s3cret\r\n\r\n");
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(response.find("Content-Disposition: attachment; filename=\"heap.prof\""), std::string::npos);
+    EXPECT_NE(response.find("\r\n\r\nheap-profile"), std::string::npos);
+}
+
+TEST(MetricsServerTest, ServesCpuProfileWithoutBlockingScrapes) {
+    MetricsRegistry registry;
+    Profiler profiler(FakeBackend());
+    MetricsServer server(registry, ProfilingServerOptions(), profiler);
+
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/profile?seconds=0")).rfind("HTTP/1.1 400", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/profile?seconds=x")).rfind("HTTP/1.1 400", 0), 0u);
+
+    auto started = std::chrono::steady_clock::now();
+    std::string profile;
+    std::thread client([&] { profile = HttpGet(server.Port(), ProfileRequest("/debug/pprof/profile?seconds=1")); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    EXPECT_EQ(HttpGet(server.Port(), "GET /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 200 OK", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/profile?seconds=1")).rfind("HTTP/1.1 409", 0), 0u);
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::milliseconds(900));
+
+    client.join();
+    EXPECT_GE(std::chrono::steady_clock::now() - started, std::chrono::seconds(1));
+    EXPECT_EQ(profile.rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+    EXPECT_NE(profile.find("\r\n\r\ncpu-profile"), std::string::npos);
+}
+
+TEST(MetricsServerTest, ShutdownEndsARunningCpuProfile) {
+    MetricsRegistry registry;
+    Profiler profiler(FakeBackend());
+    MetricsServer server(registry, ProfilingServerOptions(), profiler);
+
+    std::string profile;
+    std::thread client([&] { profile = HttpGet(server.Port(), ProfileRequest("/debug/pprof/profile?seconds=60")); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto stopping = std::chrono::steady_clock::now();
+    server.Shutdown();
+    EXPECT_LT(std::chrono::steady_clock::now() - stopping, std::chrono::seconds(2));
+    client.join();
+    EXPECT_NE(profile.find("cpu-profile"), std::string::npos);
+}
+
+TEST(MetricsServerTest, UnavailableProfilesAre501) {
+    MetricsRegistry registry;
+    Profiler profiler(Profiler::Backend{});
+    MetricsServer server(registry, ProfilingServerOptions(), profiler);
+
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/profile")).rfind("HTTP/1.1 501", 0), 0u);
+    EXPECT_EQ(HttpGet(server.Port(), ProfileRequest("/debug/pprof/heap")).rfind("HTTP/1.1 501", 0), 0u);
+}
+
+TEST(ProfilerTest, OneCpuProfileAtATime) {
+    Profiler::Backend backend = FakeBackend();
+    Profiler* profiler = nullptr;
+    bool busy = false;
+    backend.stop_cpu = [&] {
+        try {
+            profiler->CpuProfile(std::chrono::milliseconds(0));
+        } catch (const ProfilerBusy&) {
+            busy = true;
+        }
+    };
+    Profiler fake(backend);
+    profiler = &fake;
+
+    EXPECT_EQ(fake.CpuProfile(std::chrono::milliseconds(10)), "cpu-profile");
+    EXPECT_TRUE(busy);
+
+    Profiler failing([] {
+        Profiler::Backend refusing = FakeBackend();
+        refusing.start_cpu = [](const std::string&) { return false; };
+        return refusing;
+    }());
+    EXPECT_THROW(failing.CpuProfile(std::chrono::milliseconds(10)), std::runtime_error);
+}
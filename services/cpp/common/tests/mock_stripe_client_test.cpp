@@ -6,8 +6,10 @@
 
 #include <gtest/gtest.h>
 #include "common/mock_stripe_client.h"
+#include <atomic>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 namespace saasforge {
 namespace common {
@@ -464,6 +466,97 @@ TEST_F(MockStripeClientTest, MultipleCustomersAndSubscriptions) {
     EXPECT_EQ(retrieved_sub3->plan_id, "enterprise");
 }
 
+// Test: Concurrency and fault injection
+
+TEST_F(MockStripeClientTest, ConcurrentCreateAndGetCustomers) {
+    constexpr int THREADS = 8;
+    constexpr int PER_THREAD = 200;
+    std::atomic<int> found{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                auto customer = client_->CreateCustomer("user" + std::to_string(i) + "@example.com",
+                                                        "tenant_" + std::to_string(t));
+                auto fetched = client_->GetCustomer(customer.id);
+                if (fetched && fetched->tenant_id == customer.tenant_id) {
+                    ++found;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(found.load(), THREADS * PER_THREAD);
+    EXPECT_EQ(client_->GetStats().calls, static_cast<uint64_t>(2 * THREADS * PER_THREAD));
+}
+
+TEST_F(MockStripeClientTest, RateLimitInjectionThrows) {
+    MockStripeOptions options;
+    options.rate_limit_rate = 1.0;
+    MockStripeClient client("sk_test_mock_key", options);
+
+    EXPECT_THROW(client.CreateCustomer("test@example.com", "tenant_123"), StripeRateLimited);
+    EXPECT_THROW(client.GetCustomer("cus_missing"), StripeRateLimited);
+    EXPECT_EQ(client.GetStats().rate_limited, 2u);
+}
+
+TEST_F(MockStripeClientTest, DeclineRateControlsPayInvoice) {
+    MockStripeOptions always_decline;
+    always_decline.decline_rate = 1.0;
+    MockStripeOptions never_decline;
+    never_decline.decline_rate = 0.0;
+
+    for (auto* options : {&always_decline, &never_decline}) {
+        MockStripeClient client("sk_test_mock_key", *options);
+        auto customer = client.CreateCustomer("test@example.com", "tenant_123");
+        auto subscription = client.CreateSubscription(customer.id, "pro", 0);
+        auto invoice = client.CreateInvoice(customer.id, subscription.id);
+        client.FinalizeInvoice(invoice.id);
+
+        auto status = client.PayInvoice(invoice.id);
+        if (options->decline_rate == 1.0) {
+            EXPECT_EQ(status, PaymentIntentStatus::FAILED);
+            EXPECT_EQ(client.GetInvoice(invoice.id)->status, "open");
+            EXPECT_EQ(client.GetStats().declined, 1u);
+        } else {
+            EXPECT_EQ(status, PaymentIntentStatus::SUCCEEDED);
+            EXPECT_EQ(client.GetInvoice(invoice.id)->status, "paid");
+            EXPECT_EQ(client.GetStats().declined, 0u);
+        }
+    }
+}
+
+TEST_F(MockStripeClientTest, LatencyInjectionDelaysCalls) {
+    MockStripeOptions options;
+    options.latency_p50 = std::chrono::milliseconds(20);
+    options.latency_p99 = std::chrono::milliseconds(20);
+    MockStripeClient client("sk_test_mock_key", options);
+
+    auto start = std::chrono::steady_clock::now();
+    client.GetCustomer("cus_missing");
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_GE(elapsed, std::chrono::milliseconds(19));
+}
+
+TEST_F(MockStripeClientTest, DetachClearsDefaultPaymentMethod) {
+    auto customer = client_->CreateCustomer("test@example.com", "tenant_123");
+    auto pm = client_->CreatePaymentMethod("card", "4242424242424242", 12, 2030);
+    client_->AttachPaymentMethod(pm.id, customer.id);
+
+    EXPECT_EQ(client_->GetPaymentMethod(pm.id)->customer_id, customer.id);
+    EXPECT_EQ(client_->GetCustomer(customer.id)->default_payment_method, pm.id);
+
+    client_->DetachPaymentMethod(pm.id);
+
+    EXPECT_FALSE(client_->GetPaymentMethod(pm.id).has_value());
+    EXPECT_TRUE(client_->GetCustomer(customer.id)->default_payment_method.empty());
+}
+
 } // namespace test
 } // namespace common
 } // namespace saasforge
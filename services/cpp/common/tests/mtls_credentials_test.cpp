@@ -0,0 +1,318 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for watched mTLS credentials and TLS session resumption
+ */
+
+#include <gtest/gtest.h>
+#include "common/channel_pool.h"
+#include "common/mtls_credentials.h"
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+using namespace saasforge::common;
+
+namespace {
+
+std::string ToPem(X509* cert) {
+    BIO* bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, cert);
+    char* data = nullptr;
+    long size = BIO_get_mem_data(bio, &data);
+    std::string pem(data, static_cast<size_t>(size));
+    BIO_free(bio);
+    return pem;
+}
+
+std::string ToPem(EVP_PKEY* key) {
+    BIO* bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+    char* data = nullptr;
+    long size = BIO_get_mem_data(bio, &data);
+    std::string pem(data, static_cast<size_t>(size));
+    BIO_free(bio);
+    return pem;
+}
+
+EVP_PKEY* NewKey() {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    EVP_PKEY* key = nullptr;
+    EVP_PKEY_keygen_init(ctx);
+    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1);
+    EVP_PKEY_keygen(ctx, &key);
+    EVP_PKEY_CTX_free(ctx);
+    return key;
+}
+
+void AddExtension(X509* cert, X509* issuer, int nid, const char* value) {
+    X509V3_CTX ctx;
+    X509V3_set_ctx(&ctx, issuer, cert, nullptr, nullptr, 0);
+    X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, &ctx, nid, value);
+    X509_add_ext(cert, extension, -1);
+    X509_EXTENSION_free(extension);
+}
+
+/// A CA that issues localhost certificates
+class TestCa {
+public:
+    explicit TestCa(const std::string& name) : key_(NewKey()), cert_(X509_new()) {
+        Fill(cert_, key_, name, cert_);
+        AddExtension(cert_, cert_, NID_basic_constraints, "critical,CA:TRUE");
+        AddExtension(cert_, cert_, NID_key_usage, "critical,keyCertSign,cRLSign");
+        X509_sign(cert_, key_, EVP_sha256());
+    }
+    ~TestCa() {
+        X509_free(cert_);
+        EVP_PKEY_free(key_);
+    }
+
+    std::string CertPem() const { return ToPem(cert_); }
+
+    /// {cert, key} PEMs for `common_name`, valid for DNS:localhost
+    std::pair<std::string, std::string> Issue(const std::string& common_name) {
+        EVP_PKEY* key = NewKey();
+        X509* cert = X509_new();
+        Fill(cert, key, common_name, cert_);
+        AddExtension(cert, cert_, NID_basic_constraints, "critical,CA:FALSE");
+        AddExtension(cert, cert_, NID_subject_alt_name, "DNS:localhost");
+        AddExtension(cert, cert_, NID_ext_key_usage, "serverAuth,clientAuth");
+        X509_sign(cert, key_, EVP_sha256());
+        auto pems = std::make_pair(ToPem(cert), ToPem(key));
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return pems;
+    }
+
+private:
+    void Fill(X509* cert, EVP_PKEY* key, const std::string& common_name, X509* issuer) {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), ++serial_);
+        X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>(common_name.c_str()), -1, -1, 0);
+        X509_set_issuer_name(cert, X509_get_subject_name(issuer));
+    }
+
+    EVP_PKEY* key_;
+    X509* cert_;
+    long serial_ = static_cast<long>(::getpid()) * 100;
+};
+
+class TempDir {
+public:
+    TempDir() {
+        char pattern[] = "/tmp/mtls_credentials_test_XXXXXX";
+        path_ = ::mkdtemp(pattern);
+    }
+    ~TempDir() {
+        for (const auto& file : files_) {
+            std::remove(file.c_str());
+        }
+        ::rmdir(path_.c_str());
+    }
+
+    /// Written to a temporary name and renamed, as a secret volume update would be
+    std::string Write(const std::string& name, const std::string& contents) {
+        std::string path = path_ + "/" + name;
+        std::ofstream(path + ".tmp") << contents;
+        std::rename((path + ".tmp").c_str(), path.c_str());
+        files_.push_back(path);
+        return path;
+    }
+
+private:
+    std::string path_;
+    std::vector<std::string> files_;
+};
+
+/// Answers every method with OK and an empty message
+class OkService : public grpc::CallbackGenericService {
+public:
+    grpc::ServerGenericBidiReactor* CreateReactor(grpc::GenericCallbackServerContext*) override {
+        class Reactor : public grpc::ServerGenericBidiReactor {
+        public:
+            Reactor() { Finish(grpc::Status::OK); }
+            void OnDone() override { delete this; }
+        };
+        return new Reactor();
+    }
+};
+
+struct TlsServer {
+    OkService service;
+    std::unique_ptr<grpc::Server> server;
+    std::string address;
+
+    explicit TlsServer(std::shared_ptr<grpc::ServerCredentials> credentials) {
+        grpc::ServerBuilder builder;
+        int port = 0;
+        builder.AddListeningPort("localhost:0", credentials, &port);
+        builder.RegisterCallbackGenericService(&service);
+        server = builder.BuildAndStart();
+        if (!server) {
+            throw std::runtime_error("test server did not start");
+        }
+        address = "localhost:" + std::to_string(port);
+    }
+    ~TlsServer() { server->Shutdown(); }
+};
+
+struct CallResult {
+    grpc::Status status;
+    std::string peer_common_name;
+    std::string session_reused;
+};
+
+CallResult Call(const std::shared_ptr<grpc::Channel>& channel) {
+    grpc::GenericStub stub(channel);
+    grpc::ClientContext context;
+    context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(5));
+    grpc::Slice payload("ping", 4);
+    grpc::ByteBuffer request(&payload, 1);
+    grpc::ByteBuffer response;
+    std::promise<grpc::Status> done;
+    stub.UnaryCall(&context, "/saasforge.Test/Call", grpc::StubOptions(), &request, &response,
+                   [&done](grpc::Status status) { done.set_value(std::move(status)); });
+
+    CallResult result;
+    result.status = done.get_future().get();
+    if (auto auth = context.auth_context()) {
+        for (const auto& value : auth->FindPropertyValues(GRPC_X509_CN_PROPERTY_NAME)) {
+            result.peer_common_name.assign(value.data(), value.size());
+        }
+        for (const auto& value : auth->FindPropertyValues(GRPC_SSL_SESSION_REUSED_PROPERTY)) {
+            result.session_reused.assign(value.data(), value.size());
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(MtlsCredentialsTest, MutualTlsHandshake) {
+    TestCa ca("ca");
+    TempDir dir;
+    auto server_pems = ca.Issue("server");
+    auto client_pems = ca.Issue("client");
+    auto ca_path = dir.Write("ca.crt", ca.CertPem());
+
+    TlsServer server(MtlsCredentials::CreateServerCredentials(
+        ca_path, dir.Write("server.crt", server_pems.first), dir.Write("server.key", server_pems.second)));
+
+    auto client = MtlsCredentials::CreateClientCredentials(
+        ca_path, dir.Write("client.crt", client_pems.first), dir.Write("client.key", client_pems.second));
+    auto result = Call(grpc::CreateChannel(server.address, client));
+    EXPECT_TRUE(result.status.ok()) << result.status.error_message();
+    EXPECT_EQ(result.peer_common_name, "server");
+}
+
+TEST(MtlsCredentialsTest, ServerRequiresAClientCertificateFromItsCa) {
+    TestCa ca("ca");
+    TestCa other("other-ca");
+    TempDir dir;
+    auto server_pems = ca.Issue("server");
+    auto stranger_pems = other.Issue("stranger");
+    auto ca_path = dir.Write("ca.crt", ca.CertPem());
+
+    TlsServer server(MtlsCredentials::CreateServerCredentials(
+        ca_path, dir.Write("server.crt", server_pems.first), dir.Write("server.key", server_pems.second)));
+
+    auto stranger = MtlsCredentials::CreateClientCredentials(
+        ca_path, dir.Write("stranger.crt", stranger_pems.first), dir.Write("stranger.key", stranger_pems.second));
+    EXPECT_EQ(Call(grpc::CreateChannel(server.address, stranger)).status.error_code(), grpc::StatusCode::UNAVAILABLE);
+}
+
+TEST(MtlsCredentialsTest, ServerPicksUpRotatedCertificate) {
+    ::setenv("MTLS_CERT_REFRESH_S", "1", 1);
+    TestCa ca("ca");
+    TempDir dir;
+    auto first = ca.Issue("server-v1");
+    auto client_pems = ca.Issue("client");
+    auto ca_path = dir.Write("ca.crt", ca.CertPem());
+    auto cert_path = dir.Write("server.crt", first.first);
+    auto key_path = dir.Write("server.key", first.second);
+
+    TlsServer server(MtlsCredentials::CreateServerCredentials(ca_path, cert_path, key_path));
+    auto client = MtlsCredentials::CreateClientCredentials(
+        ca_path, dir.Write("client.crt", client_pems.first), dir.Write("client.key", client_pems.second));
+    ASSERT_EQ(Call(grpc::CreateChannel(server.address, client)).peer_common_name, "server-v1");
+
+    // No restart: the next connection presents the new certificate
+    auto second = ca.Issue("server-v2");
+    dir.Write("server.key", second.second);
+    dir.Write("server.crt", second.first);
+
+    std::string common_name;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (common_name != "server-v2" && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        common_name = Call(grpc::CreateChannel(server.address, client)).peer_common_name;
+    }
+    EXPECT_EQ(common_name, "server-v2");
+    ::unsetenv("MTLS_CERT_REFRESH_S");
+}
+
+TEST(MtlsCredentialsTest, PooledChannelsResumeTlsSessions) {
+    TestCa ca("ca");
+    TempDir dir;
+    auto server_pems = ca.Issue("server");
+    auto client_pems = ca.Issue("client");
+    auto ca_path = dir.Write("ca.crt", ca.CertPem());
+
+    TlsServer server(MtlsCredentials::CreateServerCredentials(
+        ca_path, dir.Write("server.crt", server_pems.first), dir.Write("server.key", server_pems.second)));
+
+    ChannelPoolOptions options;
+    options.channels_per_target = 2;
+    ChannelPool pool(MtlsCredentials::CreateClientCredentials(
+        ca_path, dir.Write("client.crt", client_pems.first), dir.Write("client.key", client_pems.second)), options);
+
+    // First connection: full handshake, ticket stored in the pool's cache
+    auto first = Call(pool.Get(server.address));
+    ASSERT_TRUE(first.status.ok()) << first.status.error_message();
+    EXPECT_EQ(first.session_reused, "false");
+
+    // Second connection resumes it
+    auto second = Call(pool.Get(server.address));
+    ASSERT_TRUE(second.status.ok()) << second.status.error_message();
+    EXPECT_EQ(second.session_reused, "true");
+}
+
+TEST(MtlsCredentialsTest, MissingFilesThrow) {
+    EXPECT_THROW(MtlsCredentials::CreateServerCredentials("/nonexistent/ca", "/nonexistent/crt", "/nonexistent/key"),
+                 std::runtime_error);
+    EXPECT_THROW(MtlsCredentials::CreateClientCredentials("/nonexistent/ca", "/nonexistent/crt", "/nonexistent/key"),
+                 std::runtime_error);
+}
+
+TEST(MtlsCredentialsTest, CachesClientCredentialsPerPaths) {
+    TestCa ca("ca");
+    TempDir dir;
+    auto pems = ca.Issue("client");
+    auto ca_path = dir.Write("ca.crt", ca.CertPem());
+    auto cert = dir.Write("client.crt", pems.first);
+    auto key = dir.Write("client.key", pems.second);
+
+    auto first = MtlsCredentials::CachedClientCredentials(ca_path, cert, key);
+    EXPECT_EQ(MtlsCredentials::CachedClientCredentials(ca_path, cert, key), first);
+
+    // Rotation is followed by the same credentials' file watcher
+    dir.Write("client.crt", ca.Issue("client-v2").first);
+    EXPECT_EQ(MtlsCredentials::CachedClientCredentials(ca_path, cert, key), first);
+
+    EXPECT_THROW(MtlsCredentials::CachedClientCredentials(ca_path, cert, "/nonexistent/key"), std::runtime_error);
+}
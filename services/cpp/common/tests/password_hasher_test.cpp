@@ -0,0 +1,104 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for Argon2 password hashing policies
+ */
+
+#include <gtest/gtest.h>
+#include "common/password_hasher.h"
+#include <cstdlib>
+
+using namespace saasforge::common;
+
+namespace {
+
+// The cheapest parameters Calibrate() allows, to keep hashing fast
+PasswordHashPolicy Small() {
+    PasswordHashPolicy policy;
+    policy.memory_cost_kb = PasswordHashPolicy::MIN_MEMORY_COST_KB;
+    policy.time_cost = PasswordHashPolicy::MIN_TIME_COST;
+    policy.parallelism = 1;
+    return policy;
+}
+
+// A machine where one pass costs 1 ms per 16 MB per lane
+std::chrono::microseconds FakeMeasure(const PasswordHashPolicy& policy) {
+    return std::chrono::microseconds(uint64_t(policy.memory_cost_kb) * policy.time_cost * 1000 / 16384 /
+                                     policy.parallelism);
+}
+
+} // namespace
+
+// Test that hashes encode the parameters they were made with
+TEST(PasswordHasherTest, EncodesPolicy) {
+    EXPECT_EQ(PasswordHashPolicy{}.ToString(), "m=65536,t=3,p=4");
+
+    std::string hash = PasswordHasher::HashPassword("correct horse", Small());
+    EXPECT_EQ(hash.rfind("$argon2id$v=19$m=19456,t=2,p=1$", 0), 0u);
+
+    // Verification reads the parameters from the hash, whatever the current policy
+    EXPECT_TRUE(PasswordHasher::VerifyPassword("correct horse", hash));
+    EXPECT_FALSE(PasswordHasher::VerifyPassword("wrong horse", hash));
+}
+
+// Test that only weaker or unreadable hashes need a rehash
+TEST(PasswordHasherTest, NeedsRehashOnlyUpgrades) {
+    std::string hash = PasswordHasher::HashPassword("correct horse", Small());
+    EXPECT_FALSE(PasswordHasher::NeedsRehash(hash, Small()));
+    EXPECT_TRUE(PasswordHasher::NeedsRehash(hash, PasswordHashPolicy{}));
+
+    PasswordHashPolicy more_lanes = Small();
+    more_lanes.parallelism = 4;
+    EXPECT_FALSE(PasswordHasher::NeedsRehash(hash, more_lanes));
+
+    PasswordHashPolicy weaker = Small();
+    weaker.memory_cost_kb = 8192;
+    EXPECT_FALSE(PasswordHasher::NeedsRehash(hash, weaker));
+
+    EXPECT_TRUE(PasswordHasher::NeedsRehash("not a hash", Small()));
+    EXPECT_TRUE(PasswordHasher::NeedsRehash("$argon2i$v=19$m=65536,t=3,p=4$c2FsdA$aGFzaA", Small()));
+}
+
+// Test that the process-wide policy drives HashPassword()
+TEST(PasswordHasherTest, SetPolicy) {
+    PasswordHashPolicy saved = PasswordHasher::Policy();
+    PasswordHasher::SetPolicy(Small());
+    EXPECT_EQ(PasswordHasher::MemoryPerHash(), size_t(19456) * 1024);
+    std::string hash = PasswordHasher::HashPassword("correct horse");
+    EXPECT_NE(hash.find("$m=19456,t=2,p=1$"), std::string::npos);
+    EXPECT_FALSE(PasswordHasher::NeedsRehash(hash));
+    PasswordHasher::SetPolicy(saved);
+}
+
+// Test that calibration fits the budget, shrinking memory before iterations
+TEST(PasswordHasherTest, Calibrate) {
+    using std::chrono::milliseconds;
+
+    // 64 MB, 4 lanes: 1 ms per pass, so a 5 ms budget buys 5 iterations
+    auto policy = PasswordHashPolicy::Calibrate(milliseconds(5), {}, 8, FakeMeasure);
+    EXPECT_EQ(policy, (PasswordHashPolicy{65536, 5, 4}));
+
+    // Two cores: 2 ms per pass; the maximum caps large budgets
+    policy = PasswordHashPolicy::Calibrate(milliseconds(500), {}, 2, FakeMeasure);
+    EXPECT_EQ(policy.parallelism, 2u);
+    EXPECT_EQ(policy.time_cost, PasswordHashPolicy::MAX_TIME_COST);
+
+    // One core, 2 ms budget: 4 ms per pass at 64 MB; memory halves down to the 19 MB floor
+    policy = PasswordHashPolicy::Calibrate(milliseconds(2), {}, 1, FakeMeasure);
+    EXPECT_EQ(policy.parallelism, 1u);
+    EXPECT_EQ(policy.memory_cost_kb, PasswordHashPolicy::MIN_MEMORY_COST_KB);
+    EXPECT_EQ(policy.time_cost, PasswordHashPolicy::MIN_TIME_COST);
+}
+
+// Test that the policy is read from the environment
+TEST(PasswordHasherTest, FromEnv) {
+    setenv("PASSWORD_HASH_MEMORY_KB", "32768", 1);
+    setenv("PASSWORD_HASH_TIME_COST", "4", 1);
+    setenv("PASSWORD_HASH_PARALLELISM", "2", 1);
+    EXPECT_EQ(PasswordHashPolicy::FromEnv(), (PasswordHashPolicy{32768, 4, 2}));
+
+    unsetenv("PASSWORD_HASH_MEMORY_KB");
+    unsetenv("PASSWORD_HASH_TIME_COST");
+    unsetenv("PASSWORD_HASH_PARALLELISM");
+    EXPECT_EQ(PasswordHashPolicy::FromEnv(), PasswordHashPolicy{});
+}
@@ -0,0 +1,108 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the Argon2 password hashing pool
+ */
+
+#include <gtest/gtest.h>
+#include "common/password_hashing_pool.h"
+#include <argon2.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace saasforge::common;
+
+namespace {
+
+PasswordHashingOptions SmallPool(size_t workers, size_t queue_capacity) {
+    PasswordHashingOptions options;
+    options.workers = workers;
+    options.queue_capacity = queue_capacity;
+    return options;
+}
+
+} // namespace
+
+// Test that a pooled hash verifies and rejects a wrong password
+TEST(PasswordHashingPoolTest, HashAndVerify) {
+    PasswordHashingPool pool(SmallPool(2, 8));
+
+    std::string hash = pool.Hash("correct horse battery staple");
+    EXPECT_EQ(hash.rfind("$argon2id$v=19$m=65536,t=3,p=4$", 0), 0u);
+    EXPECT_TRUE(pool.Verify("correct horse battery staple", hash));
+    EXPECT_FALSE(pool.Verify("wrong password", hash));
+}
+
+// Test that hashes are interchangeable with libargon2's encoded format
+TEST(PasswordHashingPoolTest, CompatibleWithLibargon2) {
+    PasswordHashingPool pool(SmallPool(1, 8));
+
+    std::string hash = pool.Hash("s3cret");
+    EXPECT_EQ(argon2id_verify(hash.c_str(), "s3cret", 6), ARGON2_OK);
+
+    // Hash produced directly by libargon2 (as stored before the pool existed)
+    const uint8_t salt[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    char encoded[128];
+    ASSERT_EQ(argon2id_hash_encoded(3, 65536, 4, "s3cret", 6, salt, sizeof(salt), 32, encoded, sizeof(encoded)),
+              ARGON2_OK);
+    EXPECT_TRUE(pool.Verify("s3cret", encoded));
+    EXPECT_TRUE(PasswordHasher::VerifyPassword("s3cret", encoded));
+    EXPECT_FALSE(pool.Verify("other", encoded));
+}
+
+// Test that malformed hashes are rejected rather than throwing
+TEST(PasswordHashingPoolTest, MalformedHashRejected) {
+    PasswordHashingPool pool(SmallPool(1, 8));
+    EXPECT_FALSE(pool.Verify("password", "not-a-hash"));
+    EXPECT_FALSE(pool.Verify("password", "$argon2id$v=19$m=65536,t=3,p=4$!!$!!"));
+}
+
+// Test that work handed to Verify runs on the caller while the hash runs
+TEST(PasswordHashingPoolTest, RunsWorkDuringVerify) {
+    PasswordHashingPool pool(SmallPool(1, 8));
+    std::string hash = pool.Hash("password");
+
+    std::thread::id ran_on;
+    EXPECT_TRUE(pool.Verify("password", hash, [&] { ran_on = std::this_thread::get_id(); }));
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+
+    // Its exception surfaces after the hash; the pool stays usable
+    EXPECT_THROW(pool.Verify("password", hash, [] { throw std::runtime_error("redis down"); }),
+                 std::runtime_error);
+    EXPECT_FALSE(pool.Verify("wrong", hash, std::function<void()>()));
+    EXPECT_EQ(pool.CompletedCount(), 4u);
+}
+
+// Test that per-call timing is reported
+TEST(PasswordHashingPoolTest, ReportsTiming) {
+    PasswordHashingPool pool(SmallPool(1, 8));
+    PasswordHashTiming timing;
+    pool.Hash("password", &timing);
+    EXPECT_GT(timing.hashing.count(), 0);
+    EXPECT_GE(timing.queued.count(), 0);
+    EXPECT_EQ(pool.CompletedCount(), 1u);
+}
+
+// Test that callers beyond worker + queue capacity fail fast
+TEST(PasswordHashingPoolTest, OverloadFailsFast) {
+    PasswordHashingPool pool(SmallPool(1, 1));
+
+    std::atomic<int> rejected{0};
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; ++i) {
+        callers.emplace_back([&pool, &rejected]() {
+            try {
+                pool.Hash("password");
+            } catch (const PasswordHashingOverloaded&) {
+                rejected++;
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    EXPECT_GE(rejected.load(), 1);
+    EXPECT_EQ(pool.RejectedCount(), static_cast<uint64_t>(rejected.load()));
+}
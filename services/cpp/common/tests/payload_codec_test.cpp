@@ -0,0 +1,160 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for compressed, content-addressed payload storage
+ */
+
+#include <gtest/gtest.h>
+#include "common/payload_codec.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+// Order events of one shape, differing in their values
+std::string OrderEvent(int n) {
+    std::string json = "{\"type\":\"order.completed\",\"data\":{\"order_id\":\"ord_" + std::to_string(n * 7919) +
+                       "\",\"customer\":{\"email\":\"customer" + std::to_string(n) + "@example.com\","
+                       "\"name\":\"Customer " + std::to_string(n) + "\"},\"currency\":\"usd\",\"items\":[";
+    for (int i = 0; i < 3; ++i) {
+        json += "{\"sku\":\"SKU-" + std::to_string(n + i) + "\",\"quantity\":" + std::to_string(i + 1) +
+                ",\"unit_amount\":" + std::to_string(1000 + n) + ",\"description\":\"Standard subscription seat\"},";
+    }
+    json += "{}],\"shipping\":{\"method\":\"standard\",\"address\":{\"country\":\"US\"}}}}";
+    return json;
+}
+
+PayloadCodecOptions SmallOptions() {
+    PayloadCodecOptions options;
+    options.min_size = 64;
+    return options;
+}
+
+} // namespace
+
+// Test that payloads round-trip, compressed and incompressible alike
+TEST(PayloadCodecTest, RoundTrips) {
+    PayloadCodec codec(nullptr, SmallOptions());
+
+    std::string text = std::string(5000, 'a') + "tail";
+    std::string encoded = codec.Encode(text, "webhook:test");
+    EXPECT_EQ(static_cast<unsigned char>(encoded[0]), 0x78);
+    EXPECT_LT(encoded.size(), text.size() / 10);
+    EXPECT_EQ(codec.Decode(encoded), text);
+
+    // Few bytes of noise do not shrink: stored raw behind the marker
+    std::string noise;
+    for (int i = 0; i < 200; ++i) {
+        noise += static_cast<char>((i * 7919 + 13) % 251);
+    }
+    encoded = codec.Encode(noise, "webhook:test");
+    EXPECT_EQ(encoded[0], '\0');
+    EXPECT_EQ(codec.Decode(encoded), noise);
+
+    EXPECT_THROW(codec.Decode(""), std::runtime_error);
+    EXPECT_THROW(codec.Decode(std::string("\x78\x9c\x01\x02", 4)), std::runtime_error);
+}
+
+// Test that small payloads stay inline and large ones are addressed by content
+TEST(PayloadCodecTest, StoresLargePayloadsByHash) {
+    PayloadCodec codec(nullptr, SmallOptions());
+
+    auto small = codec.Store("{\"ok\":true}", "webhook:test");
+    EXPECT_TRUE(small.Inline());
+    EXPECT_EQ(small.text, "{\"ok\":true}");
+
+    std::string payload = OrderEvent(1);
+    auto large = codec.Store(payload, "webhook:order.completed");
+    EXPECT_FALSE(large.Inline());
+    EXPECT_TRUE(large.text.empty());
+    EXPECT_EQ(large.hash.substr(0, 2), "\\x");
+    EXPECT_EQ(large.hash.size(), 2u + 64u);
+    EXPECT_EQ(codec.DecodeBytea(large.data), payload);
+
+    // Same content, same key, whatever the scope
+    EXPECT_EQ(codec.Store(payload, "webhook:other").hash, large.hash);
+    EXPECT_NE(codec.Store(OrderEvent(2), "webhook:order.completed").hash, large.hash);
+}
+
+// Test that a batch's blobs are listed once per hash
+TEST(PayloadCodecTest, CollectsDistinctBlobs) {
+    PayloadCodec codec(nullptr, SmallOptions());
+    PayloadBlobs blobs;
+    EXPECT_TRUE(blobs.Empty());
+
+    blobs.Add(codec.Store("short", "email"));
+    EXPECT_TRUE(blobs.Empty());
+
+    auto stored = codec.Store(OrderEvent(1), "email");
+    blobs.Add(stored);
+    blobs.Add(stored);
+    blobs.Add(codec.Store(OrderEvent(2), "email"));
+    EXPECT_FALSE(blobs.Empty());
+
+    std::string hashes = blobs.Hashes();
+    EXPECT_EQ(std::count(hashes.begin(), hashes.end(), ','), 1);
+    EXPECT_NE(hashes.find(stored.hash.substr(2)), std::string::npos);
+}
+
+// Test bytea hex conversion both ways
+TEST(PayloadCodecTest, ConvertsBytea) {
+    std::string bytes("\x00\x01\xfe\xff", 4);
+    EXPECT_EQ(PayloadCodec::ToBytea(bytes), "\\x0001feff");
+    EXPECT_EQ(PayloadCodec::FromBytea("\\x0001FEff"), bytes);
+    EXPECT_EQ(PayloadCodec::FromBytea("\\x"), "");
+    EXPECT_THROW(PayloadCodec::FromBytea("0001"), std::runtime_error);
+    EXPECT_THROW(PayloadCodec::FromBytea("\\x0g"), std::runtime_error);
+}
+
+// Test that a trained dictionary shrinks payloads of its scope and is found by id
+TEST(PayloadCodecTest, TrainedDictionaryShrinksPayloads) {
+    std::vector<std::string> samples;
+    for (int i = 0; i < 50; ++i) {
+        samples.push_back(OrderEvent(i));
+    }
+    std::string dictionary = PayloadCodec::TrainDictionary(samples);
+    ASSERT_FALSE(dictionary.empty());
+    EXPECT_LE(dictionary.size(), PayloadCodec::MAX_DICTIONARY_SIZE);
+    EXPECT_TRUE(PayloadCodec::TrainDictionary({"one sample only, nothing to share"}).empty());
+
+    PayloadCodec plain(nullptr, SmallOptions());
+    PayloadCodec trained(nullptr, SmallOptions());
+    trained.AddDictionary("webhook:order.completed", dictionary);
+    EXPECT_EQ(trained.Dictionaries(), 1u);
+
+    std::string payload = OrderEvent(1234);
+    std::string without = plain.Encode(payload, "webhook:order.completed");
+    std::string with = trained.Encode(payload, "webhook:order.completed");
+    EXPECT_LT(with.size(), without.size() * 2 / 3);
+    EXPECT_EQ(trained.Decode(with), payload);
+
+    // Other scopes are unaffected; a reader without the dictionary cannot decode
+    EXPECT_EQ(trained.Encode(payload, "webhook:other"), without);
+    EXPECT_THROW(plain.Decode(with), std::runtime_error);
+}
+
+// Test that sampling trains a scope's dictionary after enough payloads
+TEST(PayloadCodecTest, TrainsFromSamples) {
+    auto options = SmallOptions();
+    options.dictionary_samples = 20;
+    PayloadCodec codec(nullptr, options);
+
+    std::string before;
+    for (int i = 0; i < 20; ++i) {
+        before = codec.Store(OrderEvent(i), "webhook:order.completed").data;
+    }
+    EXPECT_EQ(codec.Dictionaries(), 1u);
+
+    std::string payload = OrderEvent(19);
+    auto after = codec.Store(payload, "webhook:order.completed");
+    EXPECT_LT(after.data.size(), before.size());
+    EXPECT_EQ(codec.DecodeBytea(after.data), payload);
+
+    // Trained once per scope
+    for (int i = 0; i < 40; ++i) {
+        codec.Store(OrderEvent(i), "webhook:order.completed");
+    }
+    EXPECT_EQ(codec.Dictionaries(), 1u);
+}
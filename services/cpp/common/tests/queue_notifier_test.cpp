@@ -0,0 +1,82 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for LISTEN/NOTIFY queue wakeups
+ */
+
+#include <gtest/gtest.h>
+#include "common/queue_notifier.h"
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+// Nothing listens on port 1; the listener keeps retrying in the background
+constexpr const char* UNREACHABLE_DB = "postgresql://saasforge@127.0.0.1:1/saasforge?connect_timeout=1";
+
+QueueNotifierOptions FastReconnect() {
+    QueueNotifierOptions options;
+    options.reconnect_delay = std::chrono::milliseconds(50);
+    return options;
+}
+
+} // namespace
+
+// Test that a notifier needs at least one channel
+TEST(QueueNotifierTest, RequiresChannels) {
+    EXPECT_THROW(QueueNotifier(UNREACHABLE_DB, {}), std::invalid_argument);
+}
+
+// Test that unknown channels are rejected rather than waited on forever
+TEST(QueueNotifierTest, UnknownChannelThrows) {
+    QueueNotifier notifier(UNREACHABLE_DB, {"email_queue"}, FastReconnect());
+
+    EXPECT_NO_THROW(notifier.Generation("email_queue"));
+    EXPECT_THROW(notifier.Generation("webhook_deliveries"), std::invalid_argument);
+    EXPECT_THROW(
+        notifier.WaitForChange("webhook_deliveries", 0, std::chrono::milliseconds(1)),
+        std::invalid_argument);
+}
+
+// Test that an already-advanced generation returns without waiting
+TEST(QueueNotifierTest, StaleGenerationReturnsImmediately) {
+    QueueNotifier notifier(UNREACHABLE_DB, {"email_queue"}, FastReconnect());
+
+    uint64_t stale = notifier.Generation("email_queue") + 1;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(notifier.WaitForChange("email_queue", stale, std::chrono::seconds(10)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+// Test that Shutdown() releases blocked consumers
+TEST(QueueNotifierTest, ShutdownWakesWaiters) {
+    QueueNotifier notifier(UNREACHABLE_DB, {"email_queue"}, FastReconnect());
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread waiter([&] {
+        notifier.WaitForChange("email_queue", notifier.Generation("email_queue"), std::chrono::seconds(30));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    notifier.Shutdown();
+    waiter.join();
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+// Test environment overrides
+TEST(QueueNotifierTest, OptionsFromEnv) {
+    setenv("QUEUE_NOTIFY_RECONNECT_DELAY_MS", "250", 1);
+    setenv("QUEUE_NOTIFY_FALLBACK_POLL_MS", "5000", 1);
+
+    auto options = QueueNotifierOptions::FromEnv();
+    EXPECT_EQ(options.reconnect_delay, std::chrono::milliseconds(250));
+    EXPECT_EQ(options.fallback_poll, std::chrono::milliseconds(5000));
+
+    unsetenv("QUEUE_NOTIFY_RECONNECT_DELAY_MS");
+    unsetenv("QUEUE_NOTIFY_FALLBACK_POLL_MS");
+}
@@ -0,0 +1,75 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the queue partition maintainer loop
+ */
+
+#include <gtest/gtest.h>
+#include "common/queue_partitions.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Records passes; throws for queues named in `failing`
+struct FakeStep {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> calls;
+    std::vector<std::string> failing;
+
+    QueuePartitionMaintainer::Step Step() {
+        return [this](const std::string& queue, const QueuePartitionOptions&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            calls.push_back(queue);
+            cv.notify_all();
+            if (std::find(failing.begin(), failing.end(), queue) != failing.end()) {
+                throw std::runtime_error("lock timeout");
+            }
+            return PartitionMaintenance{1, 0, 0};
+        };
+    }
+
+    bool WaitForCalls(size_t n) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return calls.size() >= n; });
+    }
+};
+
+} // namespace
+
+TEST(QueuePartitionMaintainerTest, MaintainsEveryQueueOnStart) {
+    FakeStep step;
+    QueuePartitionOptions options;
+    options.interval = std::chrono::seconds(3600);
+    QueuePartitionMaintainer maintainer(step.Step(), {"email_queue", "webhook_deliveries"}, options);
+
+    ASSERT_TRUE(step.WaitForCalls(2));
+    maintainer.Shutdown();
+    EXPECT_EQ(step.calls, (std::vector<std::string>{"email_queue", "webhook_deliveries"}));
+}
+
+TEST(QueuePartitionMaintainerTest, FailedQueueDoesNotStopTheOthers) {
+    FakeStep step;
+    step.failing = {"email_queue"};
+    QueuePartitionOptions options;
+    options.interval = std::chrono::seconds(3600);
+    QueuePartitionMaintainer maintainer(step.Step(), {"email_queue", "webhook_deliveries"}, options);
+    ASSERT_TRUE(step.WaitForCalls(2));
+
+    EXPECT_FALSE(maintainer.RunOnce());
+    EXPECT_EQ(step.calls.size(), 4u);
+    EXPECT_EQ(step.calls.back(), "webhook_deliveries");
+    EXPECT_EQ(maintainer.Failures(), 2u);
+}
+
+TEST(QueuePartitionMaintainerTest, RepeatsEveryInterval) {
+    FakeStep step;
+    QueuePartitionOptions options;
+    options.interval = std::chrono::seconds(1);
+    QueuePartitionMaintainer maintainer(step.Step(), {"email_queue"}, options);
+
+    EXPECT_TRUE(step.WaitForCalls(2));
+}
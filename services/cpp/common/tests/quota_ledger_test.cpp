@@ -0,0 +1,269 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for atomic quota reservations and write-behind flushing
+ */
+
+#include <gtest/gtest.h>
+#include "common/quota_ledger.h"
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+// In-memory stand-in for the Redis counters and the quotas table
+struct FakeStore {
+    std::mutex mutex;
+    std::map<std::string, QuotaUsage> counters;   // Redis
+    std::map<std::string, QuotaUsage> table;      // Postgres
+    std::atomic<int> loads{0};
+    std::atomic<int> reserves{0};
+    std::atomic<bool> redis_down{false};
+    std::atomic<bool> db_down{false};
+
+    QuotaLedgerBackend Make() {
+        QuotaLedgerBackend backend;
+        backend.reserve = [this](const std::string& tenant, int64_t bytes) -> std::optional<QuotaReservation> {
+            ++reserves;
+            if (redis_down) {
+                throw std::runtime_error("redis down");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = counters.find(tenant);
+            if (it == counters.end()) {
+                return std::nullopt;
+            }
+            if (it->second.used + bytes > it->second.limit) {
+                return QuotaReservation{false, it->second.limit - it->second.used};
+            }
+            it->second.used += bytes;
+            return QuotaReservation{true, it->second.limit - it->second.used};
+        };
+        backend.seed = [this](const std::string& tenant, const QuotaUsage& usage, std::chrono::seconds) {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.emplace(tenant, usage);
+        };
+        backend.release = [this](const std::string& tenant, int64_t bytes) {
+            if (redis_down) {
+                throw std::runtime_error("redis down");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = counters.find(tenant);
+            if (it != counters.end()) {
+                it->second.used = std::max<int64_t>(it->second.used - bytes, 0);
+            }
+        };
+        backend.load = [this](const std::string& tenant) {
+            ++loads;
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = table.find(tenant);
+            return it == table.end() ? QuotaUsage{0, 1000} : it->second;
+        };
+        backend.flush = [this](const std::vector<std::pair<std::string, int64_t>>& deltas) {
+            if (db_down) {
+                throw std::runtime_error("db down");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& delta : deltas) {
+                auto& row = table.emplace(delta.first, QuotaUsage{0, 1000}).first->second;
+                row.used = std::max<int64_t>(row.used + delta.second, 0);
+            }
+        };
+        return backend;
+    }
+};
+
+QuotaLedgerOptions Options() {
+    QuotaLedgerOptions options;
+    options.flush_interval = std::chrono::hours(1);  // Tests flush explicitly
+    return options;
+}
+
+} // namespace
+
+TEST(QuotaLedgerTest, SeedsOnceThenReservesAtomically) {
+    FakeStore store;
+    store.table["t1"] = {400, 1000};
+    QuotaLedger ledger(store.Make(), Options());
+
+    EXPECT_TRUE(ledger.Reserve("t1", 500));
+    EXPECT_TRUE(ledger.Reserve("t1", 100));
+    EXPECT_FALSE(ledger.Reserve("t1", 1));
+
+    EXPECT_EQ(store.loads.load(), 1);
+    EXPECT_EQ(store.counters["t1"].used, 1000);
+    EXPECT_EQ(ledger.GetStats().seeded, 1u);
+    EXPECT_THROW(ledger.Reserve("t1", 0), std::invalid_argument);
+}
+
+TEST(QuotaLedgerTest, KnownFullTenantIsRejectedLocally) {
+    FakeStore store;
+    QuotaLedger ledger(store.Make(), Options());
+
+    EXPECT_TRUE(ledger.Reserve("t1", 900));    // Counter says 100 left
+    int reserves = store.reserves.load();
+
+    EXPECT_FALSE(ledger.Reserve("t1", 150));   // Cached headroom 100 < 150
+    EXPECT_EQ(store.reserves.load(), reserves);
+    EXPECT_EQ(ledger.GetStats().rejected_locally, 1u);
+
+    // Requests that fit the cached headroom still go to the counter
+    EXPECT_TRUE(ledger.Reserve("t1", 100));
+    EXPECT_EQ(store.reserves.load(), reserves + 1);
+}
+
+TEST(QuotaLedgerTest, LocalHeadroomExpires) {
+    FakeStore store;
+    auto options = Options();
+    options.local_ttl = std::chrono::milliseconds(10);
+    QuotaLedger ledger(store.Make(), options);
+
+    EXPECT_TRUE(ledger.Reserve("t1", 1000));
+    EXPECT_FALSE(ledger.Reserve("t1", 1));
+
+    // Space freed by another instance becomes visible after local_ttl
+    {
+        std::lock_guard<std::mutex> lock(store.mutex);
+        store.counters["t1"].used = 0;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(ledger.Reserve("t1", 1));
+}
+
+TEST(QuotaLedgerTest, ReleaseFreesHeadroomImmediately) {
+    FakeStore store;
+    QuotaLedger ledger(store.Make(), Options());
+
+    EXPECT_TRUE(ledger.Reserve("t1", 1000));
+    EXPECT_FALSE(ledger.Reserve("t1", 500));
+
+    ledger.Release("t1", 600);
+    EXPECT_TRUE(ledger.Reserve("t1", 500));
+    EXPECT_EQ(store.counters["t1"].used, 900);
+}
+
+TEST(QuotaLedgerTest, ConcurrentReservationsNeverOvershoot) {
+    FakeStore store;
+    QuotaLedger ledger(store.Make(), Options());
+
+    std::atomic<int> granted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 100; ++i) {
+                if (ledger.Reserve("t1", 7)) {
+                    ++granted;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(granted.load(), 1000 / 7);
+    EXPECT_LE(store.counters["t1"].used, 1000);
+}
+
+TEST(QuotaLedgerTest, CommitsAreFlushedAsOneBatch) {
+    FakeStore store;
+    QuotaLedger ledger(store.Make(), Options());
+
+    ledger.Commit("t1", 100);
+    ledger.Commit("t1", 50);
+    ledger.Commit("t2", 30);
+    ledger.Commit("t2", -30);
+    EXPECT_EQ(ledger.GetStats().pending_tenants, 2u);
+    EXPECT_TRUE(store.table.empty());
+
+    EXPECT_TRUE(ledger.Flush());
+    EXPECT_EQ(store.table["t1"].used, 150);
+    EXPECT_EQ(store.table.count("t2"), 0u);   // Net zero is not written
+    EXPECT_EQ(ledger.GetStats().pending_tenants, 0u);
+}
+
+TEST(QuotaLedgerTest, FailedFlushIsRetried) {
+    FakeStore store;
+    QuotaLedger ledger(store.Make(), Options());
+
+    store.db_down = true;
+    ledger.Commit("t1", 100);
+    EXPECT_FALSE(ledger.Flush());
+    ledger.Commit("t1", 20);
+    EXPECT_EQ(ledger.GetStats().failed_flushes, 1u);
+
+    store.db_down = false;
+    EXPECT_TRUE(ledger.Flush());
+    EXPECT_EQ(store.table["t1"].used, 120);
+}
+
+TEST(QuotaLedgerTest, ReportsFlushedTenants) {
+    FakeStore store;
+    QuotaLedger ledger(store.Make(), Options());
+    std::vector<std::vector<std::string>> flushed;
+    ledger.OnFlushed([&](const std::vector<std::string>& tenant_ids) { flushed.push_back(tenant_ids); });
+
+    ledger.Commit("t2", 10);
+    ledger.Commit("t1", 5);
+    ledger.Commit("t3", 7);
+    ledger.Commit("t3", -7);
+    store.db_down = true;
+    EXPECT_FALSE(ledger.Flush());
+    EXPECT_TRUE(flushed.empty());   // Nothing changed yet
+
+    store.db_down = false;
+    EXPECT_TRUE(ledger.Flush());
+    ASSERT_EQ(flushed.size(), 1u);
+    EXPECT_EQ(flushed[0], (std::vector<std::string>{"t1", "t2"}));
+    EXPECT_TRUE(ledger.Flush());
+    EXPECT_EQ(flushed.size(), 1u);
+}
+
+TEST(QuotaLedgerTest, SeedIncludesUnflushedCommits) {
+    FakeStore store;
+    store.db_down = true;
+    QuotaLedger ledger(store.Make(), Options());
+
+    ledger.Commit("t1", 800);
+    EXPECT_FALSE(ledger.Reserve("t1", 300));
+    EXPECT_EQ(store.counters["t1"].used, 800);
+}
+
+TEST(QuotaLedgerTest, FallsBackToPostgresWhenRedisIsDown) {
+    FakeStore store;
+    store.table["t1"] = {900, 1000};
+    store.redis_down = true;
+    QuotaLedger ledger(store.Make(), Options());
+
+    EXPECT_TRUE(ledger.Reserve("t1", 100));
+    EXPECT_TRUE(ledger.Reserve("t2", 1));
+    EXPECT_EQ(ledger.GetStats().fallbacks, 2u);
+
+    store.table["t1"] = {1000, 1000};           // The upload completed and was flushed
+    EXPECT_FALSE(ledger.Reserve("t1", 1));
+    EXPECT_NO_THROW(ledger.Release("t1", 10));
+}
+
+TEST(QuotaLedgerTest, FlushesInBackgroundAndOnShutdown) {
+    FakeStore store;
+    auto options = Options();
+    options.flush_interval = std::chrono::milliseconds(5);
+    auto ledger = std::make_unique<QuotaLedger>(store.Make(), options);
+
+    ledger->Commit("t1", 10);
+    for (int i = 0; i < 200 && ledger->GetStats().pending_tenants > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    {
+        std::lock_guard<std::mutex> lock(store.mutex);
+        EXPECT_EQ(store.table["t1"].used, 10);
+    }
+
+    ledger->Commit("t2", 5);
+    ledger->Shutdown();
+    EXPECT_EQ(store.table["t2"].used, 5);
+}
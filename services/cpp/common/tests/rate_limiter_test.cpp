@@ -0,0 +1,106 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the rate limiter local pre-filter
+ */
+
+#include <gtest/gtest.h>
+#include "common/rate_limiter.h"
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+// Nothing listens here, so any remote check fails fast
+std::shared_ptr<RedisClient> UnreachableRedis() {
+    RedisOptions options;
+    options.connect_timeout = std::chrono::milliseconds(100);
+    return std::make_shared<RedisClient>("tcp://127.0.0.1:1", options);
+}
+
+RateLimitPolicy LocalPolicy(int64_t local_allowance) {
+    RateLimitPolicy policy;
+    policy.limit = 10;
+    policy.window = std::chrono::seconds(60);
+    policy.local_allowance = local_allowance;
+    policy.flush_interval = std::chrono::milliseconds(0);  // Tests flush explicitly
+    return policy;
+}
+
+} // namespace
+
+// Test that hits within the local allowance never reach Redis
+TEST(RateLimiterTest, LocalAllowanceSkipsRedis) {
+    RateLimiter limiter(UnreachableRedis(), "test", LocalPolicy(3));
+
+    for (int i = 0; i < 3; ++i) {
+        auto decision = limiter.Check("user@example.com");
+        EXPECT_TRUE(decision.allowed);
+        EXPECT_TRUE(decision.local);
+        EXPECT_EQ(decision.remaining, 2 - i);
+    }
+}
+
+// Test that the first hit past the allowance goes to Redis
+TEST(RateLimiterTest, ExhaustedAllowanceChecksRedis) {
+    RateLimiter limiter(UnreachableRedis(), "test", LocalPolicy(1));
+
+    EXPECT_TRUE(limiter.Check("user@example.com").local);
+    EXPECT_ANY_THROW(limiter.Check("user@example.com"));
+}
+
+// Test that each key has its own local allowance
+TEST(RateLimiterTest, KeysAreIndependent) {
+    RateLimiter limiter(UnreachableRedis(), "test", LocalPolicy(1));
+
+    EXPECT_TRUE(limiter.Check("a@example.com").allowed);
+    EXPECT_TRUE(limiter.Check("b@example.com").allowed);
+}
+
+// Test that a zero allowance sends every hit to Redis
+TEST(RateLimiterTest, NoAllowanceAlwaysRemote) {
+    RateLimiter limiter(UnreachableRedis(), "test", LocalPolicy(0));
+    EXPECT_ANY_THROW(limiter.Check("user@example.com"));
+}
+
+// Test that hits admitted locally are charged to Redis within the window
+TEST(RateLimiterTest, FlushChargesLocalHits) {
+    RateLimiter limiter(UnreachableRedis(), "test", LocalPolicy(3));
+
+    EXPECT_TRUE(limiter.Check("user@example.com").local);
+    EXPECT_TRUE(limiter.Check("user@example.com").local);
+
+    // Reaches Redis with the two pending hits; a failed flush keeps them for the next one
+    EXPECT_ANY_THROW(limiter.Flush());
+    EXPECT_ANY_THROW(limiter.Flush());
+}
+
+// Test that a flush with nothing pending never reaches Redis
+TEST(RateLimiterTest, FlushWithoutPendingSkipsRedis) {
+    RateLimiter limiter(UnreachableRedis(), "test", LocalPolicy(3));
+    EXPECT_EQ(limiter.Flush(), 0);
+
+    RateLimiter remote_only(UnreachableRedis(), "test", LocalPolicy(0));
+    EXPECT_EQ(remote_only.Flush(), 0);
+}
+
+// Test that the previous window's local hits go to Redis at rollover
+TEST(RateLimiterTest, RolloverChargesPendingHits) {
+    RateLimitPolicy policy = LocalPolicy(3);
+    policy.window = std::chrono::milliseconds(50);
+    RateLimiter limiter(UnreachableRedis(), "test", policy);
+
+    EXPECT_TRUE(limiter.Check("user@example.com").local);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_ANY_THROW(limiter.Check("user@example.com"));
+}
+
+// Test that non-positive limits are rejected
+TEST(RateLimiterTest, InvalidPolicyThrows) {
+    RateLimitPolicy policy;
+    policy.limit = 0;
+    EXPECT_THROW(RateLimiter(UnreachableRedis(), "test", policy), std::invalid_argument);
+}
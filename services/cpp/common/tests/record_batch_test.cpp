@@ -0,0 +1,120 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for column-oriented record batches
+ */
+
+#include <gtest/gtest.h>
+#include "common/record_batch.h"
+
+using namespace saasforge::common;
+
+namespace {
+
+enum class Status { PENDING = 0, SENDING = 1 };
+
+struct Delivery {
+    std::string id;
+    std::string url;
+    Status status = Status::PENDING;
+    int retry_count = 0;
+    int64_t scheduled_at = 0;
+    std::string note;           // Not batched
+};
+
+using DeliveryBatch = RecordBatch<Delivery, &Delivery::id, &Delivery::url, &Delivery::status,
+                                  &Delivery::retry_count, &Delivery::scheduled_at>;
+
+Delivery Make(int n) {
+    Delivery delivery;
+    delivery.id = "delivery-" + std::to_string(n);
+    delivery.url = "https://hooks.example.com/" + std::to_string(n);
+    delivery.status = n % 2 ? Status::SENDING : Status::PENDING;
+    delivery.retry_count = n % 5;
+    delivery.scheduled_at = 1700000000 + n;
+    delivery.note = "dropped";
+    return delivery;
+}
+
+} // namespace
+
+// Test that rows read back through views and as records
+TEST(RecordBatchTest, ReadsRowsBack) {
+    DeliveryBatch batch;
+    EXPECT_TRUE(batch.empty());
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(batch.Append(Make(i)), static_cast<size_t>(i));
+    }
+    ASSERT_EQ(batch.size(), 3u);
+
+    EXPECT_EQ(batch[1].Get<&Delivery::id>(), "delivery-1");
+    EXPECT_EQ(batch[1].Get<&Delivery::status>(), Status::SENDING);
+    EXPECT_EQ(batch.Get<&Delivery::scheduled_at>(2), 1700000002);
+
+    int seen = 0;
+    for (const auto& row : batch) {
+        EXPECT_EQ(row.Index(), static_cast<size_t>(seen));
+        EXPECT_EQ(row.Get<&Delivery::retry_count>(), seen % 5);
+        ++seen;
+    }
+    EXPECT_EQ(seen, 3);
+
+    auto record = batch[2].ToRecord();
+    EXPECT_EQ(record.url, "https://hooks.example.com/2");
+    EXPECT_EQ(record.retry_count, 2);
+    EXPECT_TRUE(record.note.empty());
+}
+
+// Test that strings share one buffer, and rows survive the columns growing
+TEST(RecordBatchTest, GrowsKeepingRows) {
+    DeliveryBatch batch;
+    size_t text = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto delivery = Make(i);
+        text += delivery.id.size() + delivery.url.size();
+        batch.Append(delivery);
+    }
+    EXPECT_EQ(batch.TextBytes(), text);
+
+    auto records = batch.ToVector();
+    ASSERT_EQ(records.size(), 1000u);
+    for (int i : {0, 15, 16, 999}) {
+        auto expected = Make(i);
+        EXPECT_EQ(records[i].id, expected.id);
+        EXPECT_EQ(records[i].url, expected.url);
+        EXPECT_EQ(records[i].status, expected.status);
+        EXPECT_EQ(records[i].scheduled_at, expected.scheduled_at);
+    }
+}
+
+// Test that new rows start zeroed and columns can be set one by one
+TEST(RecordBatchTest, SetsColumns) {
+    DeliveryBatch batch;
+    batch.Reserve(4, 64);
+    size_t row = batch.AddRow();
+    EXPECT_TRUE(batch.Get<&Delivery::id>(row).empty());
+    EXPECT_EQ(batch.Get<&Delivery::retry_count>(row), 0);
+
+    batch.Set<&Delivery::id>(row, std::string_view("abc"));
+    batch.Set<&Delivery::retry_count>(row, 4);
+    batch.Set<&Delivery::status>(row, Status::SENDING);
+    EXPECT_EQ(batch.Get<&Delivery::id>(row), "abc");
+    EXPECT_EQ(batch.Get<&Delivery::retry_count>(row), 4);
+    EXPECT_EQ(batch.Get<&Delivery::status>(row), Status::SENDING);
+}
+
+// Test that copies are independent and Clear() empties the batch
+TEST(RecordBatchTest, CopiesAndClears) {
+    DeliveryBatch batch;
+    batch.Append(Make(7));
+
+    DeliveryBatch copy = batch;
+    batch.Clear();
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(batch.TextBytes(), 0u);
+    ASSERT_EQ(copy.size(), 1u);
+    EXPECT_EQ(copy[0].Get<&Delivery::url>(), "https://hooks.example.com/7");
+
+    DeliveryBatch moved = std::move(copy);
+    EXPECT_EQ(moved[0].Get<&Delivery::id>(), "delivery-7");
+}
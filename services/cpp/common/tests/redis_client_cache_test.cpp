@@ -0,0 +1,146 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the Redis client-side cache
+ */
+
+#include <gtest/gtest.h>
+#include "common/redis_client_cache.h"
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+constexpr auto NO_TTL = std::chrono::milliseconds(-1);
+
+void Fill(RedisClientCache& cache, const std::string& key, std::optional<std::string> value,
+          std::chrono::milliseconds ttl = NO_TTL) {
+    cache.Put(key, std::move(value), ttl, cache.Ticket(key));
+}
+
+} // namespace
+
+TEST(RedisClientCacheTest, ServesStoredValues) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"session:"});
+    cache.SetEnabled(true);
+    EXPECT_FALSE(cache.Get("session:a").has_value());
+
+    Fill(cache, "session:a", std::string("data"));
+    auto cached = cache.Get("session:a");
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(cached->value_or(""), "data");
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+}
+
+TEST(RedisClientCacheTest, CachesMissingKeys) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"blacklist:"});
+    cache.SetEnabled(true);
+    Fill(cache, "blacklist:jti-1", std::nullopt);
+
+    auto cached = cache.Get("blacklist:jti-1");
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_FALSE(cached->has_value());
+}
+
+TEST(RedisClientCacheTest, InvalidateDropsTheKey) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"blacklist:"});
+    cache.SetEnabled(true);
+    Fill(cache, "blacklist:jti-1", std::nullopt);
+    Fill(cache, "blacklist:jti-2", std::nullopt);
+
+    cache.Invalidate("blacklist:jti-1");
+    EXPECT_FALSE(cache.Get("blacklist:jti-1").has_value());
+    EXPECT_TRUE(cache.Get("blacklist:jti-2").has_value());
+    EXPECT_EQ(cache.GetStats().invalidations, 1u);
+}
+
+TEST(RedisClientCacheTest, DropsValuesFetchedBeforeAnInvalidation) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"session:"});
+    cache.SetEnabled(true);
+
+    uint64_t ticket = cache.Ticket("session:a");
+    cache.Invalidate("session:a");   // Written while the GET was in flight
+    cache.Put("session:a", std::string("stale"), NO_TTL, ticket);
+
+    EXPECT_FALSE(cache.Get("session:a").has_value());
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+TEST(RedisClientCacheTest, DropsValuesFetchedBeforeAFlush) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"session:"});
+    cache.SetEnabled(true);
+
+    uint64_t ticket = cache.Ticket("session:a");
+    cache.Flush();
+    cache.Put("session:a", std::string("stale"), NO_TTL, ticket);
+
+    EXPECT_FALSE(cache.Get("session:a").has_value());
+    EXPECT_EQ(cache.GetStats().flushes, 2u);   // SetEnabled(true) flushes too
+}
+
+TEST(RedisClientCacheTest, EvictsLeastRecentlyUsed) {
+    // One entry per stripe: a second key in the same stripe evicts the first
+    RedisClientCache cache(1, std::chrono::seconds(60), {"session:"});
+    cache.SetEnabled(true);
+    for (int i = 0; i < 100; ++i) {
+        Fill(cache, "session:" + std::to_string(i), std::string("data"));
+    }
+    EXPECT_LE(cache.GetStats().entries, 16u);
+    EXPECT_TRUE(cache.Get("session:99").has_value());
+}
+
+TEST(RedisClientCacheTest, EntriesExpireWithTheKeyTtl) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"session:"});
+    cache.SetEnabled(true);
+    Fill(cache, "session:short", std::string("data"), std::chrono::milliseconds(20));
+    Fill(cache, "session:long", std::string("data"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(cache.Get("session:short").has_value());
+    EXPECT_TRUE(cache.Get("session:long").has_value());
+}
+
+TEST(RedisClientCacheTest, EntriesExpireAfterMaxAge) {
+    RedisClientCache cache(1000, std::chrono::milliseconds(20), {"session:"});
+    cache.SetEnabled(true);
+    Fill(cache, "session:a", std::string("data"), std::chrono::seconds(3600));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_FALSE(cache.Get("session:a").has_value());
+}
+
+TEST(RedisClientCacheTest, ExpiredKeysAreNotStored) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"session:"});
+    cache.SetEnabled(true);
+    Fill(cache, "session:a", std::string("data"), std::chrono::milliseconds(0));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+TEST(RedisClientCacheTest, DisabledCacheServesAndStoresNothing) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"session:"});
+    EXPECT_FALSE(cache.Enabled());
+    Fill(cache, "session:a", std::string("data"));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+
+    cache.SetEnabled(true);
+    Fill(cache, "session:a", std::string("data"));
+    ASSERT_TRUE(cache.Get("session:a").has_value());
+
+    // Tracking lost: invalidations may be missed from here on
+    cache.SetEnabled(false);
+    EXPECT_FALSE(cache.Get("session:a").has_value());
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+TEST(RedisClientCacheTest, CoversOnlyItsPrefixes) {
+    RedisClientCache cache(1000, std::chrono::seconds(60), {"blacklist:", "session:"});
+    EXPECT_TRUE(cache.Covers("blacklist:jti"));
+    EXPECT_TRUE(cache.Covers("session:refresh:user"));
+    EXPECT_FALSE(cache.Covers("ratelimit:tenant"));
+    EXPECT_FALSE(cache.Covers("session"));
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "common/redis_client.h"
+#include <cstdlib>
+#include <stdexcept>
 
 namespace saasforge {
 namespace common {
@@ -27,6 +29,49 @@ TEST_F(RedisClientTest, RateLimiting) {
     EXPECT_TRUE(true);
 }
 
+TEST(RedisOptionsTest, DefaultsToStandalone) {
+    unsetenv("REDIS_MODE");
+    unsetenv("REDIS_SENTINELS");
+    auto options = RedisOptions::FromEnv();
+    EXPECT_EQ(options.mode, RedisMode::STANDALONE);
+    EXPECT_TRUE(options.sentinels.empty());
+}
+
+TEST(RedisOptionsTest, ReadsSentinelsFromEnv) {
+    setenv("REDIS_MODE", "sentinel", 1);
+    setenv("REDIS_SENTINELS", "sentinel-0:26379,sentinel-1:26380,sentinel-2", 1);
+    setenv("REDIS_SENTINEL_MASTER", "saasforge", 1);
+
+    auto options = RedisOptions::FromEnv();
+    EXPECT_EQ(options.mode, RedisMode::SENTINEL);
+    ASSERT_EQ(options.sentinels.size(), 3u);
+    EXPECT_EQ(options.sentinels[0], std::make_pair(std::string("sentinel-0"), 26379));
+    EXPECT_EQ(options.sentinels[1], std::make_pair(std::string("sentinel-1"), 26380));
+    EXPECT_EQ(options.sentinels[2], std::make_pair(std::string("sentinel-2"), 26379));
+    EXPECT_EQ(options.sentinel_master, "saasforge");
+
+    unsetenv("REDIS_MODE");
+    unsetenv("REDIS_SENTINELS");
+    unsetenv("REDIS_SENTINEL_MASTER");
+}
+
+TEST(RedisOptionsTest, RejectsInvalidModes) {
+    setenv("REDIS_MODE", "replicated", 1);
+    EXPECT_THROW(RedisOptions::FromEnv(), std::invalid_argument);
+
+    setenv("REDIS_MODE", "sentinel", 1);
+    unsetenv("REDIS_SENTINELS");
+    EXPECT_THROW(RedisOptions::FromEnv(), std::invalid_argument);
+
+    setenv("REDIS_SENTINELS", "sentinel-0:port", 1);
+    EXPECT_THROW(RedisOptions::FromEnv(), std::invalid_argument);
+
+    setenv("REDIS_MODE", "cluster", 1);
+    unsetenv("REDIS_SENTINELS");
+    EXPECT_EQ(RedisOptions::FromEnv().mode, RedisMode::CLUSTER);
+    unsetenv("REDIS_MODE");
+}
+
 } // namespace test
 } // namespace common
 } // namespace saasforge
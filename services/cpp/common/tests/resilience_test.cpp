@@ -0,0 +1,235 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for circuit breakers, adaptive concurrency limits and deadline propagation
+ */
+
+#include <gtest/gtest.h>
+#include "common/resilience.h"
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::common;
+using namespace std::chrono_literals;
+
+namespace {
+
+DependencyOptions Options(uint32_t failures, std::chrono::milliseconds open_duration, size_t capacity = 4) {
+    DependencyOptions options;
+    options.breaker.failure_threshold = failures;
+    options.breaker.open_duration = open_duration;
+    options.limit = options.limit.ForCapacity(capacity);
+    return options;
+}
+
+uint64_t Rejected(MetricsRegistry& registry, const std::string& reason) {
+    return registry
+        .GetCounter("saasforge_dependency_rejected_total", "", {{"dependency", "db"}, {"reason", reason}})
+        .Value();
+}
+
+} // namespace
+
+TEST(CircuitBreakerTest, OpensAfterConsecutiveFailuresAndProbes) {
+    CircuitBreakerOptions options;
+    options.failure_threshold = 3;
+    options.open_duration = 50ms;
+    CircuitBreaker breaker(options);
+
+    breaker.RecordFailure();
+    breaker.RecordFailure();
+    breaker.RecordSuccess();   // Resets the run
+    breaker.RecordFailure();
+    breaker.RecordFailure();
+    EXPECT_EQ(breaker.GetState(), CircuitBreaker::State::CLOSED);
+    breaker.RecordFailure();
+    EXPECT_EQ(breaker.GetState(), CircuitBreaker::State::OPEN);
+    EXPECT_FALSE(breaker.Allow());
+
+    std::this_thread::sleep_for(60ms);
+    EXPECT_TRUE(breaker.Allow());    // The probe
+    EXPECT_FALSE(breaker.Allow());   // Only one at a time
+    EXPECT_EQ(breaker.GetState(), CircuitBreaker::State::HALF_OPEN);
+
+    breaker.RecordFailure();         // Probe failed: open again
+    EXPECT_EQ(breaker.GetState(), CircuitBreaker::State::OPEN);
+    std::this_thread::sleep_for(60ms);
+    EXPECT_TRUE(breaker.Allow());
+    breaker.RecordSuccess();
+    EXPECT_EQ(breaker.GetState(), CircuitBreaker::State::CLOSED);
+    EXPECT_TRUE(breaker.Allow());
+}
+
+TEST(CircuitBreakerTest, ZeroThresholdNeverOpens) {
+    CircuitBreakerOptions options;
+    options.failure_threshold = 0;
+    CircuitBreaker breaker(options);
+    for (int i = 0; i < 100; ++i) {
+        breaker.RecordFailure();
+    }
+    EXPECT_TRUE(breaker.Allow());
+}
+
+TEST(AdaptiveLimitTest, DerivesLimitsFromCapacity) {
+    AdaptiveLimitOptions options = AdaptiveLimitOptions{}.ForCapacity(10);
+    EXPECT_EQ(options.min_limit, 10u);
+    EXPECT_EQ(options.initial_limit, 20u);
+    EXPECT_EQ(options.max_limit, 40u);
+
+    AdaptiveLimitOptions explicit_limits;
+    explicit_limits.max_limit = 12;
+    explicit_limits = explicit_limits.ForCapacity(10);
+    EXPECT_EQ(explicit_limits.max_limit, 12u);
+    EXPECT_EQ(explicit_limits.initial_limit, 12u);
+}
+
+TEST(AdaptiveLimitTest, CapsOutstandingCalls) {
+    AdaptiveLimitOptions options = AdaptiveLimitOptions{}.ForCapacity(2);   // initial 4
+    AdaptiveLimit limit(options);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(limit.TryAcquire());
+    }
+    EXPECT_FALSE(limit.TryAcquire());
+    EXPECT_EQ(limit.InFlight(), 4u);
+    limit.Cancel();
+    EXPECT_TRUE(limit.TryAcquire());
+}
+
+TEST(AdaptiveLimitTest, ShrinksWhenLatencyRisesAndGrowsWhenItFalls) {
+    AdaptiveLimitOptions options = AdaptiveLimitOptions{}.ForCapacity(10);   // 10..40, initial 20
+    options.smoothing = 1.0;
+    AdaptiveLimit limit(options);
+
+    // Keep the limiter busy so samples are not application-limited
+    auto sample = [&](std::chrono::microseconds rtt) {
+        size_t held = 0;
+        while (limit.TryAcquire()) {
+            ++held;
+        }
+        limit.Release(rtt, false);
+        for (size_t i = 1; i < held; ++i) {
+            limit.Cancel();
+        }
+    };
+
+    sample(1ms);                     // Baseline RTT
+    for (int i = 0; i < 200; ++i) {
+        sample(20ms);                // Postgres slowed down twentyfold
+    }
+    EXPECT_EQ(limit.Limit(), 10u);
+
+    for (int i = 0; i < 200; ++i) {
+        sample(1ms);                 // Recovered
+    }
+    EXPECT_EQ(limit.Limit(), 40u);
+}
+
+TEST(AdaptiveLimitTest, FailuresLowerTheLimit) {
+    AdaptiveLimitOptions options = AdaptiveLimitOptions{}.ForCapacity(10);
+    options.smoothing = 1.0;
+    AdaptiveLimit limit(options);
+
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(limit.TryAcquire());
+        limit.Release(1ms, true);
+    }
+    EXPECT_LT(limit.Limit(), 20u);
+    EXPECT_GE(limit.Limit(), 10u);
+}
+
+TEST(DependencyTest, RejectsWhileOpenAndRecovers) {
+    MetricsRegistry registry;
+    Dependency dependency("db", Options(2, 50ms), registry);
+
+    for (int i = 0; i < 2; ++i) {
+        auto permit = dependency.Admit();
+        permit.Failure();
+    }
+    EXPECT_EQ(dependency.BreakerState(), CircuitBreaker::State::OPEN);
+    EXPECT_THROW(dependency.Admit(), DependencyUnavailable);
+    EXPECT_EQ(Rejected(registry, "open"), 1u);
+    EXPECT_EQ(dependency.InFlight(), 0u);   // The refused call gave its slot back
+
+    std::this_thread::sleep_for(60ms);
+    {
+        auto probe = dependency.Admit();
+    }   // Released without an exception: success
+    EXPECT_EQ(dependency.BreakerState(), CircuitBreaker::State::CLOSED);
+}
+
+TEST(DependencyTest, PermitUnwoundByExceptionCountsAsFailure) {
+    MetricsRegistry registry;
+    Dependency dependency("db", Options(1, 60000ms), registry);
+
+    try {
+        auto permit = dependency.Admit();
+        throw std::runtime_error("connection refused");
+    } catch (const std::runtime_error&) {
+    }
+    EXPECT_EQ(dependency.BreakerState(), CircuitBreaker::State::OPEN);
+    EXPECT_EQ(registry.GetCounter("saasforge_dependency_failures_total", "", {{"dependency", "db"}}).Value(), 1u);
+}
+
+TEST(DependencyTest, ShedsAtTheLimit) {
+    MetricsRegistry registry;
+    Dependency dependency("db", Options(5, 5000ms, 1), registry);   // Limit 2
+
+    auto first = dependency.Admit();
+    auto second = dependency.Admit();
+    EXPECT_THROW(dependency.Admit(), DependencyUnavailable);
+    EXPECT_EQ(Rejected(registry, "limit"), 1u);
+
+    second.Success();
+    EXPECT_NO_THROW(dependency.Admit());
+}
+
+TEST(ResilienceScopeTest, ShedsCallsPastTheirDeadline) {
+    MetricsRegistry registry;
+    Dependency dependency("db", Options(5, 5000ms), registry);
+
+    ResilienceScope scope(std::chrono::system_clock::now() - 1ms);
+    EXPECT_THROW(dependency.Admit(), DependencyUnavailable);
+    EXPECT_EQ(Rejected(registry, "deadline"), 1u);
+
+    grpc::Status status = scope.Finish(grpc::Status(grpc::StatusCode::INTERNAL, "Internal error"));
+    EXPECT_EQ(status.error_code(), grpc::StatusCode::UNAVAILABLE);
+    EXPECT_EQ(scope.Finish(grpc::Status(grpc::StatusCode::NOT_FOUND, "")).error_code(),
+              grpc::StatusCode::NOT_FOUND);
+    EXPECT_TRUE(scope.Finish(grpc::Status::OK).ok());
+}
+
+TEST(ResilienceScopeTest, BoundsWaitsByTheDeadline) {
+    auto fallback = std::chrono::steady_clock::now() + 10s;
+    EXPECT_FALSE(ResilienceScope::Deadline().has_value());
+    EXPECT_EQ(ResilienceScope::DeadlineOr(fallback), fallback);
+
+    {
+        ResilienceScope scope(std::chrono::system_clock::now() + 100ms);
+        ASSERT_TRUE(ResilienceScope::Deadline().has_value());
+        EXPECT_LT(ResilienceScope::DeadlineOr(fallback), std::chrono::steady_clock::now() + 1s);
+
+        ResilienceScope unbounded(std::chrono::system_clock::time_point::max());
+        EXPECT_TRUE(ResilienceScope::Deadline().has_value());   // Inherits the outer deadline
+    }
+    EXPECT_FALSE(ResilienceScope::Deadline().has_value());
+
+    ResilienceScope unbounded(std::chrono::system_clock::time_point::max());
+    EXPECT_FALSE(ResilienceScope::Deadline().has_value());
+    EXPECT_EQ(unbounded.Finish(grpc::Status(grpc::StatusCode::INTERNAL, "")).error_code(),
+              grpc::StatusCode::INTERNAL);
+}
+
+TEST(ResilienceScopeTest, CarriesTheServerContext) {
+    EXPECT_EQ(ResilienceScope::Context(), nullptr);
+
+    grpc::ServerContext context;   // No deadline
+    ResilienceScope scope(&context);
+    EXPECT_EQ(ResilienceScope::Context(), &context);
+    EXPECT_FALSE(ResilienceScope::Deadline().has_value());
+    {
+        ResilienceScope nested(std::chrono::system_clock::now() + 1s);
+        EXPECT_EQ(ResilienceScope::Context(), &context);
+        EXPECT_TRUE(ResilienceScope::Deadline().has_value());
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for compile-time row mappings
+ */
+
+#include <gtest/gtest.h>
+#include "common/row_mapping.h"
+#include <cstring>
+
+using namespace saasforge::common;
+
+namespace {
+
+enum class Colour { RED = 0, GREEN = 1 };
+
+struct Record {
+    std::string id;
+    int retry_count = 0;
+    int64_t created_at = 0;
+    Colour colour = Colour::RED;
+};
+
+constexpr auto kRow = MapRow(
+    Column<&Record::id>("r.id"),
+    Column<&Record::retry_count>("r.retry_count"),
+    Column<&Record::created_at>("EXTRACT(EPOCH FROM r.created_at)::bigint AS created_at"));
+
+constexpr auto kColouredRow = kRow.With(Column<&Record::colour>("c.colour"));
+
+constexpr auto kSelectSql = SqlText("SELECT ") + kRow.SelectList() + " FROM records r WHERE r.id = $1";
+
+constexpr bool Equal(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return *a == *b;
+}
+
+// The lists are built by the compiler, not at run time
+static_assert(Equal(kRow.SelectList().c_str(),
+                    "r.id, r.retry_count, EXTRACT(EPOCH FROM r.created_at)::bigint AS created_at"));
+static_assert(decltype(kRow)::COLUMNS == 3 && decltype(kColouredRow)::COLUMNS == 4);
+
+} // namespace
+
+// Test that statements are assembled from the mapping's column list
+TEST(RowMappingTest, BuildsStatementText) {
+    EXPECT_STREQ(kSelectSql.c_str(),
+                 "SELECT r.id, r.retry_count, EXTRACT(EPOCH FROM r.created_at)::bigint AS created_at "
+                 "FROM records r WHERE r.id = $1");
+    EXPECT_EQ(kSelectSql.size(), std::strlen(kSelectSql.c_str()));
+}
+
+// Test that extra columns follow the base mapping's
+TEST(RowMappingTest, AppendsColumns) {
+    EXPECT_STREQ(kColouredRow.SelectList().c_str(),
+                 "r.id, r.retry_count, EXTRACT(EPOCH FROM r.created_at)::bigint AS created_at, c.colour");
+
+    constexpr auto single = MapRow(Column<&Record::id>("id"));
+    EXPECT_STREQ(single.SelectList().c_str(), "id");
+}
+
+// Test that a statement from a mapping can be registered
+TEST(RowMappingTest, BacksPreparedStatements) {
+    static const PreparedStatement statement("row_mapping_test_select", kSelectSql.c_str());
+    EXPECT_EQ(statement.sql, kSelectSql.c_str());
+
+    bool found = false;
+    for (const auto& entry : StatementRegistry::Global().Entries()) {
+        found = found || (entry.name == "row_mapping_test_select" && entry.sql == kSelectSql.c_str());
+    }
+    EXPECT_TRUE(found);
+}
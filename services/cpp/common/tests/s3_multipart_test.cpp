@@ -0,0 +1,227 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for S3 multipart upload control calls
+ */
+
+#include <gtest/gtest.h>
+#include "common/s3_multipart.h"
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+struct Request {
+    std::string method;
+    std::string url;
+    std::string body;
+    std::vector<std::string> headers;
+};
+
+// Records requests and replays canned responses in order
+struct FakeS3 {
+    std::vector<Request> requests;
+    std::vector<S3HttpResponse> responses;
+
+    S3MultipartClient::Transport Make() {
+        return [this](const std::string& method, const std::string& url,
+                      const std::string& body, const std::vector<std::string>& headers) {
+            requests.push_back({method, url, body, headers});
+            if (responses.empty()) {
+                return S3HttpResponse{500, ""};
+            }
+            auto response = responses.front();
+            responses.erase(responses.begin());
+            return response;
+        };
+    }
+};
+
+std::shared_ptr<S3Presigner> Presigner() {
+    S3PresignerOptions options;
+    options.bucket = "uploads";
+    options.access_key_id = "AKIDEXAMPLE";
+    options.secret_access_key = "secret";
+    options.endpoint = "http://localstack:4566";
+    options.path_style = true;
+    return std::make_shared<S3Presigner>(options);
+}
+
+} // namespace
+
+TEST(S3MultipartTest, CreateReturnsUploadId) {
+    FakeS3 s3;
+    s3.responses.push_back({200,
+        "<?xml version=\"1.0\"?><InitiateMultipartUploadResult><Bucket>uploads</Bucket>"
+        "<Key>t/u/big.bin</Key><UploadId>abc-123</UploadId></InitiateMultipartUploadResult>"});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    EXPECT_EQ(client.Create("t/u/big.bin", "application/zip"), "abc-123");
+
+    ASSERT_EQ(s3.requests.size(), 1u);
+    EXPECT_EQ(s3.requests[0].method, "POST");
+    EXPECT_EQ(s3.requests[0].url.rfind("http://localstack:4566/uploads/t/u/big.bin?", 0), 0u);
+    EXPECT_NE(s3.requests[0].url.find("&uploads=&X-Amz-Signature="), std::string::npos);
+    EXPECT_EQ(s3.requests[0].headers, std::vector<std::string>{"Content-Type: application/zip"});
+}
+
+TEST(S3MultipartTest, ErrorsCarryS3Code) {
+    FakeS3 s3;
+    s3.responses.push_back({403, "<Error><Code>AccessDenied</Code><Message>Denied</Message></Error>"});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    try {
+        client.Create("k", "");
+        FAIL() << "expected failure";
+    } catch (const std::runtime_error& e) {
+        EXPECT_STREQ(e.what(), "S3 CreateMultipartUpload failed: AccessDenied (Denied)");
+    }
+}
+
+TEST(S3MultipartTest, PresignPartSignsPartNumberAndUploadId) {
+    FakeS3 s3;
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    std::string url = client.PresignPart("k", "abc/123", 7, 600);
+
+    EXPECT_NE(url.find("&partNumber=7&uploadId=abc%2F123&X-Amz-Signature="), std::string::npos);
+    EXPECT_NE(url, client.PresignPart("k", "abc/123", 8, 600));
+    EXPECT_TRUE(s3.requests.empty());
+}
+
+TEST(S3MultipartTest, ListPartsFollowsPagination) {
+    FakeS3 s3;
+    s3.responses.push_back({200,
+        "<ListPartsResult><IsTruncated>true</IsTruncated><NextPartNumberMarker>2</NextPartNumberMarker>"
+        "<Part><PartNumber>1</PartNumber><ETag>&quot;e1&quot;</ETag><Size>5242880</Size></Part>"
+        "<Part><PartNumber>2</PartNumber><ETag>\"e2\"</ETag><Size>5242880</Size></Part>"
+        "</ListPartsResult>"});
+    s3.responses.push_back({200,
+        "<ListPartsResult><IsTruncated>false</IsTruncated>"
+        "<Part><PartNumber>3</PartNumber><ETag>&quot;e3&quot;</ETag><Size>17</Size></Part>"
+        "</ListPartsResult>"});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    auto parts = client.ListParts("k", "abc");
+
+    ASSERT_EQ(parts.size(), 3u);
+    EXPECT_EQ(parts[0].part_number, 1);
+    EXPECT_EQ(parts[0].etag, "\"e1\"");
+    EXPECT_EQ(parts[1].etag, "\"e2\"");
+    EXPECT_EQ(parts[2].part_number, 3);
+    EXPECT_EQ(parts[2].size, 17);
+
+    ASSERT_EQ(s3.requests.size(), 2u);
+    EXPECT_EQ(s3.requests[0].url.find("part-number-marker"), std::string::npos);
+    EXPECT_NE(s3.requests[1].url.find("part-number-marker=2"), std::string::npos);
+}
+
+TEST(S3MultipartTest, CompleteSendsPartsAndDetectsEmbeddedErrors) {
+    FakeS3 s3;
+    s3.responses.push_back({200, "<CompleteMultipartUploadResult><ETag>&quot;abc-2&quot;</ETag>"
+                                 "</CompleteMultipartUploadResult>"});
+    s3.responses.push_back({200, "<Error><Code>InternalError</Code></Error>"});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    std::vector<S3Part> parts{{1, "\"e1\"", 0}, {2, "\"e2\"", 0}};
+    EXPECT_EQ(client.Complete("k", "abc", parts), "\"abc-2\"");
+    EXPECT_EQ(s3.requests[0].body,
+              "<CompleteMultipartUpload>"
+              "<Part><PartNumber>1</PartNumber><ETag>&quot;e1&quot;</ETag></Part>"
+              "<Part><PartNumber>2</PartNumber><ETag>&quot;e2&quot;</ETag></Part>"
+              "</CompleteMultipartUpload>");
+    EXPECT_EQ(s3.requests[0].headers, std::vector<std::string>{"Content-Type: application/xml"});
+
+    EXPECT_THROW(client.Complete("k", "abc", parts), std::runtime_error);
+}
+
+TEST(S3MultipartTest, AbortToleratesMissingUpload) {
+    FakeS3 s3;
+    s3.responses.push_back({204, ""});
+    s3.responses.push_back({404, "<Error><Code>NoSuchUpload</Code></Error>"});
+    s3.responses.push_back({500, ""});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    EXPECT_NO_THROW(client.Abort("k", "abc"));
+    EXPECT_NO_THROW(client.Abort("k", "abc"));
+    EXPECT_THROW(client.Abort("k", "abc"), std::runtime_error);
+    EXPECT_EQ(s3.requests[0].method, "DELETE");
+}
+
+TEST(S3MultipartTest, DeleteObjectsBatchesKeysAndReportsFailures) {
+    FakeS3 s3;
+    s3.responses.push_back({200,
+        "<?xml version=\"1.0\"?><DeleteResult><Error><Key>t/u/locked.bin</Key><Code>AccessDenied</Code>"
+        "<Message>Denied</Message></Error></DeleteResult>"});
+    s3.responses.push_back({200, "<DeleteResult></DeleteResult>"});
+    s3.responses.push_back({503, "<Error><Code>SlowDown</Code></Error>"});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    auto errors = client.DeleteObjects({"t/u/a&b.bin", "t/u/locked.bin"});
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_EQ(errors[0].key, "t/u/locked.bin");
+    EXPECT_EQ(errors[0].code, "AccessDenied");
+
+    ASSERT_EQ(s3.requests.size(), 1u);
+    EXPECT_EQ(s3.requests[0].method, "POST");
+    EXPECT_EQ(s3.requests[0].url.rfind("http://localstack:4566/uploads/?", 0), 0u);
+    EXPECT_NE(s3.requests[0].url.find("&delete=&"), std::string::npos);
+    EXPECT_EQ(s3.requests[0].body,
+              "<Delete><Quiet>true</Quiet><Object><Key>t/u/a&amp;b.bin</Key></Object>"
+              "<Object><Key>t/u/locked.bin</Key></Object></Delete>");
+    ASSERT_EQ(s3.requests[0].headers.size(), 2u);
+    EXPECT_EQ(s3.requests[0].headers[1].rfind("Content-MD5: ", 0), 0u);
+    EXPECT_EQ(s3.requests[0].headers[1].size(), 13u + 24u);   // Base64 of 16 bytes
+
+    EXPECT_TRUE(client.DeleteObjects({"k"}).empty());
+    EXPECT_THROW(client.DeleteObjects({"k"}), std::runtime_error);
+    EXPECT_TRUE(client.DeleteObjects({}).empty());
+    EXPECT_EQ(s3.requests.size(), 3u);
+    EXPECT_THROW(client.DeleteObjects(std::vector<std::string>(1001, "k")), std::invalid_argument);
+}
+
+TEST(S3MultipartTest, UploadPartReturnsEtagHeader) {
+    FakeS3 s3;
+    s3.responses.push_back({200, "", "\"part-etag\""});
+    s3.responses.push_back({200, "", ""});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    EXPECT_EQ(client.UploadPart("k", "abc", 2, "bytes"), "\"part-etag\"");
+    EXPECT_EQ(s3.requests[0].method, "PUT");
+    EXPECT_EQ(s3.requests[0].body, "bytes");
+    EXPECT_NE(s3.requests[0].url.find("partNumber=2&uploadId=abc"), std::string::npos);
+
+    EXPECT_THROW(client.UploadPart("k", "abc", 3, "bytes"), std::runtime_error);
+}
+
+TEST(S3MultipartTest, GetRangeSendsRangeHeader) {
+    FakeS3 s3;
+    s3.responses.push_back({206, "0123"});
+    s3.responses.push_back({416, ""});
+    s3.responses.push_back({200, "0123456789"});
+    S3MultipartClient client(Presigner(), s3.Make());
+
+    EXPECT_EQ(client.GetRange("k", 10, 4), "0123");
+    EXPECT_EQ(s3.requests[0].headers, std::vector<std::string>{"Range: bytes=10-13"});
+    EXPECT_EQ(client.GetRange("k", 100, 4), "");
+
+    // A server that ignores Range still yields the requested slice
+    EXPECT_EQ(client.GetRange("k", 2, 3), "234");
+    EXPECT_THROW(client.GetRange("k", 0, 0), std::invalid_argument);
+}
+
+TEST(S3MultipartTest, ChoosePartSize) {
+    const int64_t MiB = 1024 * 1024;
+
+    EXPECT_EQ(S3MultipartClient::ChoosePartSize(1 * MiB, 0), S3MultipartClient::MIN_PART_SIZE);
+    EXPECT_EQ(S3MultipartClient::ChoosePartSize(1 * MiB, 16 * MiB), 16 * MiB);
+
+    // 50 GB at 5 MiB parts would need ~9537 parts; 100 GiB needs larger parts
+    int64_t size = 100LL * 1024 * MiB;
+    int64_t part = S3MultipartClient::ChoosePartSize(size, 0);
+    EXPECT_EQ(part % MiB, 0);
+    EXPECT_LE((size + part - 1) / part, S3MultipartClient::MAX_PARTS);
+
+    EXPECT_EQ(S3MultipartClient::ChoosePartSize(INT64_MAX / 2, 0), S3MultipartClient::MAX_PART_SIZE);
+}
@@ -0,0 +1,39 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for incremental SHA-256
+ */
+
+#include <gtest/gtest.h>
+#include "common/sha256.h"
+
+using namespace saasforge::common;
+
+TEST(Sha256Test, KnownVectors) {
+    EXPECT_EQ(Sha256::Hex(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(Sha256::Hex("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(Sha256Test, IncrementalMatchesOneShot) {
+    std::string data;
+    for (int i = 0; i < 100000; ++i) {
+        data += static_cast<char>(i * 31);
+    }
+
+    Sha256 hash;
+    for (size_t offset = 0; offset < data.size(); offset += 777) {
+        hash.Update(data.data() + offset, std::min<size_t>(777, data.size() - offset));
+    }
+    EXPECT_EQ(hash.HexDigest(), Sha256::Hex(data));
+
+    // Restarts after a digest
+    hash.Update("abc", 3);
+    EXPECT_EQ(hash.HexDigest(), Sha256::Hex("abc"));
+}
+
+TEST(Sha256Test, NormalizeHex) {
+    std::string upper = "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD";
+    EXPECT_EQ(Sha256::NormalizeHex(upper), Sha256::Hex("abc"));
+    EXPECT_EQ(Sha256::NormalizeHex("abc"), "");
+    EXPECT_EQ(Sha256::NormalizeHex(std::string(63, 'a') + "g"), "");
+}
@@ -0,0 +1,174 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for tenant to shard placement
+ */
+
+#include <gtest/gtest.h>
+#include "common/shard_map.h"
+#include <map>
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Serves `placements` as the tenant_shards table
+struct FakeDirectory {
+    std::mutex mutex;
+    std::vector<TenantPlacement> placements;
+    bool failing = false;
+    int loads = 0;
+
+    ShardMap::Loader Loader() {
+        return [this] {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++loads;
+            if (failing) {
+                throw std::runtime_error("connection refused");
+            }
+            return placements;
+        };
+    }
+};
+
+ShardMapOptions TestOptions() {
+    ShardMapOptions options;
+    options.refresh = std::chrono::seconds(3600);
+    options.stale_after = std::chrono::seconds(7200);
+    return options;
+}
+
+std::string TenantId(int i) {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08x-0000-4000-8000-%012x", i * 2654435761u, i);
+    return id;
+}
+
+} // namespace
+
+TEST(ShardMapTest, PlacementIsStableAcrossInstancesAndShardOrder) {
+    ShardMap map({"shard-0", "shard-1", "shard-2"}, nullptr);
+    ShardMap reordered({"shard-2", "shard-0", "shard-1"}, nullptr);
+
+    for (int i = 0; i < 1000; ++i) {
+        auto tenant_id = TenantId(i);
+        EXPECT_EQ(map.HashShard(tenant_id), reordered.HashShard(tenant_id));
+        EXPECT_EQ(map.Locate(tenant_id).shard, map.HashShard(tenant_id));
+        EXPECT_FALSE(map.Locate(tenant_id).moving);
+    }
+}
+
+TEST(ShardMapTest, SpreadsTenantsEvenly) {
+    ShardMap map({"shard-0", "shard-1", "shard-2", "shard-3"}, nullptr);
+
+    std::map<std::string, int> counts;
+    const int tenants = 40000;
+    for (int i = 0; i < tenants; ++i) {
+        ++counts[map.HashShard(TenantId(i))];
+    }
+    ASSERT_EQ(counts.size(), 4u);
+    for (const auto& [shard, count] : counts) {
+        EXPECT_NEAR(count, tenants / 4, tenants / 4 / 5) << shard;
+    }
+}
+
+TEST(ShardMapTest, AddingAShardOnlyMovesTenantsToIt) {
+    ShardMap before({"shard-0", "shard-1", "shard-2"}, nullptr);
+    ShardMap after({"shard-0", "shard-1", "shard-2", "shard-3"}, nullptr);
+
+    int moved = 0;
+    const int tenants = 20000;
+    for (int i = 0; i < tenants; ++i) {
+        auto tenant_id = TenantId(i);
+        if (before.HashShard(tenant_id) != after.HashShard(tenant_id)) {
+            ++moved;
+            EXPECT_EQ(after.HashShard(tenant_id), "shard-3");
+        }
+    }
+    EXPECT_GT(moved, tenants / 4 - tenants / 20);
+    EXPECT_LT(moved, tenants / 4 + tenants / 20);
+}
+
+TEST(ShardMapTest, OverridesWinOverTheHash) {
+    FakeDirectory directory;
+    auto tenant_id = TenantId(7);
+    ShardMap probe({"shard-0", "shard-1"}, nullptr);
+    std::string other = probe.HashShard(tenant_id) == "shard-0" ? "shard-1" : "shard-0";
+    directory.placements = {{tenant_id, other, false}, {TenantId(8), "shard-0", true}};
+
+    ShardMap map({"shard-0", "shard-1"}, directory.Loader(), TestOptions());
+    ASSERT_TRUE(map.Ready());
+    EXPECT_EQ(map.Locate(tenant_id).shard, other);
+    EXPECT_EQ(map.HashShard(tenant_id), probe.HashShard(tenant_id));
+    EXPECT_TRUE(map.Locate(TenantId(8)).moving);
+    EXPECT_EQ(map.Overrides().size(), 2u);
+}
+
+TEST(ShardMapTest, RefreshPicksUpPlacementChanges) {
+    FakeDirectory directory;
+    ShardMap map({"shard-0", "shard-1"}, directory.Loader(), TestOptions());
+    auto tenant_id = TenantId(3);
+    EXPECT_FALSE(map.Locate(tenant_id).moving);
+
+    directory.placements = {{tenant_id, "shard-1", true}};
+    ASSERT_TRUE(map.Refresh());
+    EXPECT_EQ(map.Locate(tenant_id).shard, "shard-1");
+    EXPECT_TRUE(map.Locate(tenant_id).moving);
+
+    directory.placements.clear();
+    ASSERT_TRUE(map.Refresh());
+    EXPECT_EQ(map.Locate(tenant_id).shard, map.HashShard(tenant_id));
+}
+
+TEST(ShardMapTest, LocateThrowsUntilLoaded) {
+    FakeDirectory directory;
+    directory.failing = true;
+    ShardMap map({"shard-0", "shard-1"}, directory.Loader(), TestOptions());
+
+    EXPECT_FALSE(map.Ready());
+    EXPECT_FALSE(map.Fresh());
+    EXPECT_THROW(map.Locate(TenantId(1)), std::runtime_error);
+    EXPECT_EQ(map.Failures(), 1u);
+
+    directory.failing = false;
+    ASSERT_TRUE(map.Refresh());
+    EXPECT_TRUE(map.Fresh());
+    EXPECT_NO_THROW(map.Locate(TenantId(1)));
+}
+
+TEST(ShardMapTest, FailedRefreshKeepsOverridesUntilStale) {
+    FakeDirectory directory;
+    auto tenant_id = TenantId(5);
+    directory.placements = {{tenant_id, "shard-1", false}};
+    ShardMapOptions options;
+    options.refresh = std::chrono::milliseconds(10);
+    options.stale_after = std::chrono::milliseconds(50);
+    ShardMap map({"shard-0", "shard-1"}, directory.Loader(), options);
+    ASSERT_TRUE(map.Fresh());
+
+    {
+        std::lock_guard<std::mutex> lock(directory.mutex);
+        directory.failing = true;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (map.Fresh() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_FALSE(map.Fresh());
+    EXPECT_GT(map.Failures(), 0u);
+    EXPECT_EQ(map.Locate(tenant_id).shard, "shard-1");
+}
+
+TEST(ShardMapTest, NoLoaderIsAlwaysFresh) {
+    ShardMap map({"default"}, nullptr);
+    EXPECT_TRUE(map.Ready());
+    EXPECT_TRUE(map.Fresh());
+    EXPECT_EQ(map.Locate(TenantId(1)).shard, "default");
+}
+
+TEST(ShardMapTest, RejectsInvalidShardLists) {
+    EXPECT_THROW(ShardMap({}, nullptr), std::invalid_argument);
+    EXPECT_THROW(ShardMap({"shard-0", "shard-0"}, nullptr), std::invalid_argument);
+    EXPECT_THROW(ShardMap({"shard-0", ""}, nullptr), std::invalid_argument);
+}
@@ -0,0 +1,67 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the prepared statement registry
+ */
+
+#include <gtest/gtest.h>
+#include "common/statement_registry.h"
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+const PreparedStatement kTestStatement(
+    "test_select_user",
+    "SELECT id FROM users WHERE id = $1");
+
+} // namespace
+
+// Test that statements are kept in registration order
+TEST(StatementRegistryTest, AddKeepsOrder) {
+    StatementRegistry registry;
+    registry.Add("a", "SELECT 1");
+    registry.Add("b", "SELECT 2");
+
+    auto entries = registry.Entries();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].name, "a");
+    EXPECT_EQ(entries[1].name, "b");
+    EXPECT_EQ(entries[1].sql, "SELECT 2");
+}
+
+// Test that re-registering identical SQL is a no-op
+TEST(StatementRegistryTest, DuplicateIdenticalIsIgnored) {
+    StatementRegistry registry;
+    registry.Add("a", "SELECT 1");
+    registry.Add("a", "SELECT 1");
+    EXPECT_EQ(registry.Size(), 1u);
+}
+
+// Test that binding one name to two different queries is rejected
+TEST(StatementRegistryTest, ConflictingSqlThrows) {
+    StatementRegistry registry;
+    registry.Add("a", "SELECT 1");
+    EXPECT_THROW(registry.Add("a", "SELECT 2"), std::logic_error);
+}
+
+// Test that namespace-scope statements land in the global registry
+TEST(StatementRegistryTest, StaticStatementRegistersGlobally) {
+    bool found = false;
+    for (const auto& entry : StatementRegistry::Global().Entries()) {
+        if (entry.name == kTestStatement.name) {
+            EXPECT_EQ(entry.sql, kTestStatement.sql);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+// Test that batch parameters are quoted and escaped for Postgres arrays
+TEST(StatementRegistryTest, ArrayLiteralQuotesElements) {
+    EXPECT_EQ(ToArrayLiteral({}), "{}");
+    EXPECT_EQ(ToArrayLiteral({"a", "b"}), "{\"a\",\"b\"}");
+    EXPECT_EQ(ToArrayLiteral({"x,y", "say \"hi\"", "back\\slash", ""}),
+              "{\"x,y\",\"say \\\"hi\\\"\",\"back\\\\slash\",\"\"}");
+}
@@ -0,0 +1,66 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for stack-buffer key building and JSON string escaping
+ */
+
+#include <gtest/gtest.h>
+#include "common/string_builder.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace saasforge::common;
+
+TEST(StringBuilderTest, BuildsKeyFromParts) {
+    std::string jti = "3f2504e0-4f89-11d3-9a0c-0305e82c3301";
+    KeyBuilder<> key("blacklist:", jti);
+    EXPECT_EQ(key.View(), "blacklist:" + jti);
+
+    KeyBuilder<> otp("otp:", std::string_view("a@example.com"), ":", "login");
+    EXPECT_EQ(otp.View(), "otp:a@example.com:login");
+    EXPECT_EQ(otp.size(), 23u);
+}
+
+TEST(StringBuilderTest, WritesIntegersInDecimal) {
+    KeyBuilder<24> ttl(int64_t{2592000});
+    EXPECT_EQ(ttl.View(), "2592000");
+
+    KeyBuilder<24> min(std::numeric_limits<int64_t>::min());
+    EXPECT_EQ(min.View(), "-9223372036854775808");
+
+    KeyBuilder<> member("instance-1", ":", uint64_t{42});
+    EXPECT_EQ(member.View(), "instance-1:42");
+}
+
+TEST(StringBuilderTest, WrapsHashTagsInBraces) {
+    std::string user_id = "8c1f0a52-6a3b-4f4e-9d3e-1f2a3b4c5d6e";
+    KeyBuilder<> refresh("refresh:", HashTag{user_id});
+    EXPECT_EQ(refresh.View(), "refresh:{" + user_id + "}");
+
+    KeyBuilder<> otp("otp:", HashTag{"a@example.com"}, ":", "login");
+    EXPECT_EQ(otp.View(), "otp:{a@example.com}:login");
+}
+
+TEST(StringBuilderTest, FallsBackToHeapWhenFull) {
+    KeyBuilder<8> key("session:");
+    EXPECT_EQ(key.View(), "session:");
+    key.Append("0123456789").Append(7);
+    EXPECT_EQ(key.View(), "session:01234567897");
+    EXPECT_EQ(key.ToString(), "session:01234567897");
+
+    KeyBuilder<4> empty;
+    EXPECT_TRUE(empty.View().empty());
+    empty.Append("");
+    EXPECT_TRUE(empty.View().empty());
+}
+
+TEST(StringBuilderTest, EscapesJsonStrings) {
+    std::string out;
+    AppendJsonString(out, "plain");
+    EXPECT_EQ(out, "\"plain\"");
+
+    out.clear();
+    AppendJsonString(out, "say \"hi\"\\\n\t\x01");
+    EXPECT_EQ(out, "\"say \\\"hi\\\"\\\\\\n\\t\\u0001\"");
+}
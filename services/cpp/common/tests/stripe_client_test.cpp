@@ -0,0 +1,354 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Unit tests for StripeClient (scripted transport)
+ */
+
+#include <gtest/gtest.h>
+#include "common/stripe_client.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+namespace test {
+
+/**
+ * Transport that records requests and answers from a script
+ *
+ * With `hold` set, completions are kept until Release(), so tests can
+ * overlap calls.
+ */
+class ScriptedTransport {
+public:
+    using Responder = std::function<StripeHttpResponse(const StripeHttpRequest&)>;
+
+    explicit ScriptedTransport(Responder responder, bool hold = false)
+        : responder_(std::move(responder)), hold_(hold) {}
+
+    StripeClient::Transport Transport() {
+        return [this](const StripeHttpRequest& request, StripeClient::Completion done) {
+            StripeHttpResponse response = responder_(request);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                requests_.push_back(request);
+                if (hold_) {
+                    held_.emplace_back(std::move(done), std::move(response));
+                    return;
+                }
+            }
+            done(std::move(response));
+        };
+    }
+
+    void Release() {
+        std::vector<std::pair<StripeClient::Completion, StripeHttpResponse>> held;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            held.swap(held_);
+            hold_ = false;
+        }
+        for (auto& [done, response] : held) {
+            done(std::move(response));
+        }
+    }
+
+    std::vector<StripeHttpRequest> Requests() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+    size_t Held() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return held_.size();
+    }
+
+private:
+    Responder responder_;
+    std::mutex mutex_;
+    bool hold_;
+    std::vector<StripeHttpRequest> requests_;
+    std::vector<std::pair<StripeClient::Completion, StripeHttpResponse>> held_;
+};
+
+StripeHttpResponse Json(long status, const std::string& body) {
+    StripeHttpResponse response;
+    response.status = status;
+    response.body = body;
+    return response;
+}
+
+const char* CUSTOMER_JSON =
+    R"({"id":"cus_1","object":"customer","email":"a@example.com","created":1700000000,)"
+    R"("metadata":{"tenant_id":"tenant_1"},"invoice_settings":{"default_payment_method":"pm_1"}})";
+
+StripeClientOptions FastOptions() {
+    StripeClientOptions options;
+    options.initial_backoff = std::chrono::milliseconds(1);
+    options.max_backoff = std::chrono::milliseconds(5);
+    options.read_rate = 1000;
+    options.write_rate = 1000;
+    return options;
+}
+
+template <typename Predicate>
+bool WaitFor(Predicate predicate) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST(StripeClientTest, FormEncodeKeepsBracketsInNames) {
+    EXPECT_EQ(StripeClient::FormEncode({{"metadata[tenant_id]", "t 1"}, {"email", "a+b@example.com"}}),
+              "metadata[tenant_id]=t%201&email=a%2Bb%40example.com");
+}
+
+TEST(StripeClientTest, CreateCustomerPostsFormWithIdempotencyKey) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(200, CUSTOMER_JSON); });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    auto customer = client.CreateCustomer("a@example.com", "tenant_1");
+
+    EXPECT_EQ(customer.id, "cus_1");
+    EXPECT_EQ(customer.email, "a@example.com");
+    EXPECT_EQ(customer.tenant_id, "tenant_1");
+    EXPECT_EQ(customer.default_payment_method, "pm_1");
+    EXPECT_EQ(customer.created, 1700000000);
+
+    auto requests = transport.Requests();
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_EQ(requests[0].method, "POST");
+    EXPECT_EQ(requests[0].path, "/v1/customers");
+    EXPECT_EQ(requests[0].body, "email=a%40example.com&metadata[tenant_id]=tenant_1");
+    EXPECT_FALSE(requests[0].idempotency_key.empty());
+}
+
+TEST(StripeClientTest, CallerIdempotencyKeyIsPropagated) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(200, CUSTOMER_JSON); });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    StripeCallOptions call;
+    call.idempotency_key = "CreateCustomer:tenant_1:key_1";
+    call.account = "acct_1";
+    client.CreateCustomerAsync("a@example.com", "tenant_1", call).get();
+
+    auto requests = transport.Requests();
+    ASSERT_EQ(requests.size(), 1u);
+    EXPECT_EQ(requests[0].idempotency_key, "CreateCustomer:tenant_1:key_1");
+    EXPECT_EQ(requests[0].account, "acct_1");
+}
+
+TEST(StripeClientTest, ConcurrentGetsForOneIdShareARequest) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(200, CUSTOMER_JSON); }, true);
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    auto first = client.GetCustomerAsync("cus_1");
+    ASSERT_TRUE(WaitFor([&] { return transport.Held() == 1; }));
+    auto second = client.GetCustomerAsync("cus_1");
+    auto other = client.GetCustomerAsync("cus_2");
+    ASSERT_TRUE(WaitFor([&] { return transport.Held() == 2; }));
+    transport.Release();
+
+    ASSERT_TRUE(first.get().has_value());
+    EXPECT_EQ(second.get()->id, "cus_1");
+    EXPECT_TRUE(other.get().has_value());
+    EXPECT_EQ(transport.Requests().size(), 2u);
+    EXPECT_EQ(client.GetStats().coalesced, 1u);
+
+    // Completed lookups are not cached
+    client.GetCustomer("cus_1");
+    EXPECT_EQ(transport.Requests().size(), 3u);
+}
+
+TEST(StripeClientTest, MissingObjectIsNullopt) {
+    ScriptedTransport transport([](const StripeHttpRequest&) {
+        return Json(404, R"({"error":{"code":"resource_missing","message":"No such customer"}})");
+    });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    EXPECT_FALSE(client.GetCustomer("cus_missing").has_value());
+    EXPECT_FALSE(client.GetInvoice("in_missing").has_value());
+    EXPECT_THROW(client.FinalizeInvoice("in_missing"), StripeApiError);
+}
+
+TEST(StripeClientTest, ServerErrorIsRetriedWithTheSameIdempotencyKey) {
+    int attempts = 0;
+    ScriptedTransport transport([&](const StripeHttpRequest&) {
+        return ++attempts < 3 ? Json(500, "{}") : Json(200, CUSTOMER_JSON);
+    });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    auto customer = client.CreateCustomer("a@example.com", "tenant_1");
+
+    EXPECT_EQ(customer.id, "cus_1");
+    auto requests = transport.Requests();
+    ASSERT_EQ(requests.size(), 3u);
+    EXPECT_EQ(requests[0].idempotency_key, requests[1].idempotency_key);
+    EXPECT_EQ(requests[1].idempotency_key, requests[2].idempotency_key);
+    EXPECT_EQ(client.GetStats().retries, 2u);
+}
+
+TEST(StripeClientTest, ClientErrorsAndShouldRetryFalseAreNotRetried) {
+    ScriptedTransport transport([](const StripeHttpRequest& request) {
+        if (request.path == "/v1/customers") {
+            return Json(400, R"({"error":{"code":"parameter_missing","message":"Missing email"}})");
+        }
+        auto response = Json(503, "{}");
+        response.should_retry = false;
+        return response;
+    });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    try {
+        client.CreateCustomer("", "tenant_1");
+        FAIL() << "Expected StripeApiError";
+    } catch (const StripeApiError& e) {
+        EXPECT_EQ(e.Status(), 400);
+        EXPECT_EQ(e.Code(), "parameter_missing");
+        EXPECT_STREQ(e.what(), "Missing email");
+    }
+    EXPECT_THROW(client.GetSubscription("sub_1"), StripeApiError);
+    EXPECT_EQ(transport.Requests().size(), 2u);
+    EXPECT_EQ(client.GetStats().retries, 0u);
+}
+
+TEST(StripeClientTest, ExhaustedRateLimitThrowsStripeRateLimited) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(429, "{}"); });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    EXPECT_THROW(client.GetCustomer("cus_1"), StripeRateLimited);
+    EXPECT_EQ(transport.Requests().size(), 3u);   // max_attempts
+}
+
+TEST(StripeClientTest, RetryBudgetCapsRetriesAcrossRequests) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(500, "{}"); });
+    auto options = FastOptions();
+    options.max_attempts = 2;
+    options.retry_budget_ratio = 0;
+    options.retry_budget_min_per_second = 0;
+    StripeClient client("sk_test_123", options, transport.Transport());
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_THROW(client.GetInvoice("in_" + std::to_string(i)), StripeApiError);
+    }
+
+    auto stats = client.GetStats();
+    EXPECT_EQ(stats.retries, 10u);            // The budget's initial balance
+    EXPECT_EQ(stats.budget_exhausted, 10u);
+    EXPECT_EQ(transport.Requests().size(), 30u);
+}
+
+TEST(StripeClientTest, RetryBudgetRefillsFromTraffic) {
+    RetryBudget budget(0.5, 0);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(budget.TryRetry());
+    }
+    EXPECT_FALSE(budget.TryRetry());
+
+    budget.OnRequest();
+    EXPECT_FALSE(budget.TryRetry());
+    budget.OnRequest();
+    EXPECT_TRUE(budget.TryRetry());
+}
+
+TEST(StripeClientTest, RateLimiterDelaysPerAccount) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(200, CUSTOMER_JSON); });
+    auto options = FastOptions();
+    options.write_rate = 5;   // Burst of 5, then one every 200 ms
+    StripeClient client("sk_test_123", options, transport.Transport());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5; ++i) {
+        client.CreateCustomer("a@example.com", "tenant_1");
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+
+    // Another account has its own bucket
+    StripeCallOptions other;
+    other.account = "acct_2";
+    client.CreateCustomerAsync("a@example.com", "tenant_2", other).get();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+    EXPECT_EQ(client.GetStats().rate_limited, 0u);
+
+    client.CreateCustomer("a@example.com", "tenant_1");
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+    EXPECT_GE(client.GetStats().rate_limited, 1u);
+}
+
+TEST(StripeClientTest, PayInvoiceMapsDeclines) {
+    ScriptedTransport transport([](const StripeHttpRequest& request) {
+        if (request.path == "/v1/invoices/in_ok/pay") {
+            return Json(200, R"({"id":"in_ok","status":"paid","amount_due":2900,"amount_paid":2900})");
+        }
+        if (request.path == "/v1/invoices/in_3ds/pay") {
+            return Json(402, R"({"error":{"code":"invoice_payment_intent_requires_action"}})");
+        }
+        return Json(402, R"({"error":{"code":"card_declined","decline_code":"insufficient_funds"}})");
+    });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    EXPECT_EQ(client.PayInvoice("in_ok"), PaymentIntentStatus::SUCCEEDED);
+    EXPECT_EQ(client.PayInvoice("in_3ds"), PaymentIntentStatus::REQUIRES_ACTION);
+    EXPECT_EQ(client.PayInvoice("in_declined"), PaymentIntentStatus::FAILED);
+}
+
+TEST(StripeClientTest, SubscriptionFieldsAreParsed) {
+    ScriptedTransport transport([](const StripeHttpRequest& request) {
+        if (request.method == "GET") {
+            return Json(200, R"({"id":"sub_1","customer":"cus_1","status":"active",)"
+                             R"("items":{"data":[{"id":"si_1","quantity":2,"price":{"id":"price_pro","unit_amount":2900}}]}})");
+        }
+        return Json(200, R"({"id":"sub_1","customer":{"id":"cus_1"},"status":"past_due","cancel_at_period_end":true,)"
+                         R"("current_period_start":10,"current_period_end":20,"trial_end":null,"metadata":{"plan_id":"enterprise"},)"
+                         R"("items":{"data":[{"id":"si_1","quantity":1,"price":{"id":"price_ent","unit_amount":9900}}]}})");
+    });
+    StripeClient client("sk_test_123", FastOptions(), transport.Transport());
+
+    auto current = client.GetSubscription("sub_1");
+    ASSERT_TRUE(current.has_value());
+    EXPECT_EQ(current->plan_id, "price_pro");
+    EXPECT_DOUBLE_EQ(current->amount, 58.0);
+
+    auto updated = client.UpdateSubscription("sub_1", "enterprise");
+    EXPECT_EQ(updated.customer_id, "cus_1");
+    EXPECT_EQ(updated.plan_id, "enterprise");
+    EXPECT_EQ(updated.status, SubscriptionStatus::PAST_DUE);
+    EXPECT_TRUE(updated.cancel_at_period_end);
+    EXPECT_EQ(updated.current_period_end, 20);
+    EXPECT_EQ(updated.trial_end, 0);
+
+    auto requests = transport.Requests();
+    ASSERT_EQ(requests.size(), 3u);
+    EXPECT_NE(requests[2].body.find("items[0][id]=si_1"), std::string::npos);
+}
+
+TEST(StripeClientTest, ShutdownFailsQueuedRequests) {
+    ScriptedTransport transport([](const StripeHttpRequest&) { return Json(500, "{}"); });
+    auto options = FastOptions();
+    options.initial_backoff = std::chrono::milliseconds(60000);
+    options.max_backoff = std::chrono::milliseconds(60000);
+    auto client = std::make_unique<StripeClient>("sk_test_123", options, transport.Transport());
+
+    auto invoice = std::async(std::launch::async, [&] { return client->GetInvoice("in_1"); });
+    ASSERT_TRUE(WaitFor([&] { return client->GetStats().queued == 1; }));   // Waiting out the backoff
+
+    client->Shutdown();
+    EXPECT_THROW(invoice.get(), StripeApiError);
+    EXPECT_THROW(client->GetCustomer("cus_1"), StripeApiError);
+}
+
+} // namespace test
+} // namespace common
+} // namespace saasforge
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
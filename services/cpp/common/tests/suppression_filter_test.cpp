@@ -0,0 +1,168 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the email suppression filter
+ */
+
+#include <gtest/gtest.h>
+#include "common/suppression_filter.h"
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Serves `addresses` for full loads and `added` for incremental ones
+struct FakeTable {
+    std::mutex mutex;
+    std::vector<std::string> addresses;
+    std::vector<std::string> added;
+    std::vector<std::string> cursors;
+    bool failing = false;
+    int loads = 0;
+
+    SuppressionFilter::Loader Loader() {
+        return [this](const std::string& cursor) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cursors.push_back(cursor);
+            if (failing) {
+                throw std::runtime_error("connection refused");
+            }
+            SuppressionFilter::Batch batch;
+            batch.addresses = cursor.empty() ? addresses : added;
+            batch.cursor = "load-" + std::to_string(++loads);
+            return batch;
+        };
+    }
+};
+
+SuppressionFilterOptions TestOptions() {
+    SuppressionFilterOptions options;
+    options.expected_addresses = 1000;
+    options.refresh = std::chrono::seconds(3600);
+    options.rebuild = std::chrono::seconds(3600);
+    return options;
+}
+
+bool WaitUntil(const std::function<bool()>& done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(SuppressionFilterTest, LoadsOnStart) {
+    FakeTable table;
+    table.addresses = {"bounced@example.com", "gone@example.org"};
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+    EXPECT_TRUE(filter.MightBeSuppressed("bounced@example.com"));
+    EXPECT_TRUE(filter.MightBeSuppressed("gone@example.org"));
+    EXPECT_FALSE(filter.MightBeSuppressed("user@example.com"));
+    EXPECT_EQ(filter.Count(), 2u);
+}
+
+TEST(SuppressionFilterTest, EverythingMightBeSuppressedUntilLoaded) {
+    FakeTable table;
+    table.failing = true;
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+
+    ASSERT_TRUE(WaitUntil([&] { return filter.Failures() == 1; }));
+    EXPECT_FALSE(filter.Ready());
+    EXPECT_TRUE(filter.MightBeSuppressed("user@example.com"));
+
+    // Local additions before the first load are covered by it
+    filter.Add("user@example.com");
+    EXPECT_EQ(filter.Count(), 0u);
+}
+
+TEST(SuppressionFilterTest, RefreshLoadsSinceTheLastCursor) {
+    FakeTable table;
+    table.addresses = {"bounced@example.com"};
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+
+    table.added = {"new@example.com"};
+    EXPECT_TRUE(filter.Refresh());
+    EXPECT_TRUE(filter.MightBeSuppressed("new@example.com"));
+    EXPECT_TRUE(filter.MightBeSuppressed("bounced@example.com"));
+
+    EXPECT_TRUE(filter.Refresh());
+    EXPECT_EQ(table.cursors, (std::vector<std::string>{"", "load-1", "load-2"}));
+}
+
+TEST(SuppressionFilterTest, AddCoversLocalSuppressions) {
+    FakeTable table;
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+
+    EXPECT_FALSE(filter.MightBeSuppressed("user@example.com"));
+    filter.Add("user@example.com");
+    EXPECT_TRUE(filter.MightBeSuppressed("user@example.com"));
+}
+
+TEST(SuppressionFilterTest, RebuildDropsRemovedAddresses) {
+    FakeTable table;
+    table.addresses = {"bounced@example.com"};
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+
+    table.addresses = {"other@example.com"};
+    EXPECT_TRUE(filter.Rebuild());
+    EXPECT_FALSE(filter.MightBeSuppressed("bounced@example.com"));
+    EXPECT_TRUE(filter.MightBeSuppressed("other@example.com"));
+    EXPECT_EQ(table.cursors.back(), "");
+}
+
+TEST(SuppressionFilterTest, SizedForListsLargerThanExpected) {
+    FakeTable table;
+    for (int i = 0; i < 5000; ++i) {
+        table.addresses.push_back("user" + std::to_string(i) + "@example.com");
+    }
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+
+    for (const auto& address : table.addresses) {
+        ASSERT_TRUE(filter.MightBeSuppressed(address));
+    }
+    int false_positives = 0;
+    for (int i = 0; i < 5000; ++i) {
+        false_positives += filter.MightBeSuppressed("other" + std::to_string(i) + "@example.com");
+    }
+    EXPECT_LT(false_positives, 50);
+}
+
+TEST(SuppressionFilterTest, FailedRefreshKeepsTheFilter) {
+    FakeTable table;
+    table.addresses = {"bounced@example.com"};
+    SuppressionFilter filter(table.Loader(), nullptr, TestOptions());
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+
+    table.failing = true;
+    EXPECT_FALSE(filter.Refresh());
+    EXPECT_FALSE(filter.Rebuild());
+    EXPECT_EQ(filter.Failures(), 2u);
+    EXPECT_TRUE(filter.MightBeSuppressed("bounced@example.com"));
+    EXPECT_FALSE(filter.MightBeSuppressed("user@example.com"));
+}
+
+TEST(SuppressionFilterTest, ReloadsEveryRefreshWithoutNotifier) {
+    FakeTable table;
+    SuppressionFilterOptions options = TestOptions();
+    options.refresh = std::chrono::seconds(1);
+    SuppressionFilter filter(table.Loader(), nullptr, options);
+    ASSERT_TRUE(WaitUntil([&] { return filter.Ready(); }));
+
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        table.added = {"new@example.com"};
+    }
+    ASSERT_TRUE(WaitUntil([&] { return filter.MightBeSuppressed("new@example.com"); }));
+}
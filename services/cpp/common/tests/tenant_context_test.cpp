@@ -0,0 +1,159 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for per-RPC tenant context parsing and rejection
+ */
+
+#include <gtest/gtest.h>
+#include "common/jwt_validator.h"
+#include "common/tenant_context.h"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+namespace test {
+
+class TenantContextTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        EVP_PKEY* pkey = EVP_RSA_gen(2048);
+        ASSERT_NE(pkey, nullptr);
+
+        BIO* priv_bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PrivateKey(priv_bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+        private_key_ = ReadBio(priv_bio);
+
+        BIO* pub_bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PUBKEY(pub_bio, pkey);
+        public_key_ = ReadBio(pub_bio);
+
+        EVP_PKEY_free(pkey);
+    }
+
+    static std::string ReadBio(BIO* bio) {
+        char* data = nullptr;
+        long len = BIO_get_mem_data(bio, &data);
+        std::string out(data, static_cast<size_t>(len));
+        BIO_free(bio);
+        return out;
+    }
+
+    std::string MakeToken() {
+        auto now = std::chrono::system_clock::now();
+        return jwt::create()
+            .set_issuer("saasforge")
+            .set_subject("user-1")
+            .set_id("jti-1")
+            .set_issued_at(now)
+            .set_expires_at(now + std::chrono::minutes(15))
+            .set_payload_claim("tenant_id", jwt::claim(std::string("tenant-1")))
+            .set_payload_claim("email", jwt::claim(std::string("user@example.com")))
+            .sign(jwt::algorithm::rs256("", private_key_, "", ""));
+    }
+
+    // Metadata entries point into strings owned by the fixture, as they
+    // point into the call's buffers in a real RPC
+    void Add(const std::string& key, const std::string& value) {
+        keys_.push_back(key);
+        values_.push_back(value);
+        metadata_.emplace(grpc::string_ref(keys_.back()), grpc::string_ref(values_.back()));
+    }
+
+    std::string public_key_;
+    std::string private_key_;
+    std::deque<std::string> keys_;
+    std::deque<std::string> values_;
+    ServerMetadata metadata_;
+};
+
+TEST_F(TenantContextTest, ParsesGatewayHeaders) {
+    Add("x-tenant-id", "tenant-1");
+    Add("x-user-id", "user-1");
+    Add("x-user-email", "user@example.com");
+    Add("x-user-roles", " admin, ,billing ,viewer");
+
+    TenantCall call = TenantContextInterceptor::Parse(metadata_, nullptr, true);
+    EXPECT_TRUE(call.rejection.ok());
+    EXPECT_EQ(call.context.tenant_id, "tenant-1");
+    EXPECT_EQ(call.context.user_id, "user-1");
+    EXPECT_EQ(call.context.email, "user@example.com");
+    EXPECT_EQ(call.context.roles, (std::vector<std::string>{"admin", "billing", "viewer"}));
+    EXPECT_FALSE(call.context.validated);
+}
+
+TEST_F(TenantContextTest, RejectsAnonymousCallsUnlessPublic) {
+    TenantCall call = TenantContextInterceptor::Parse(metadata_, nullptr, true);
+    EXPECT_EQ(call.rejection.error_code(), grpc::StatusCode::UNAUTHENTICATED);
+
+    call = TenantContextInterceptor::Parse(metadata_, nullptr, false);
+    EXPECT_TRUE(call.rejection.ok());
+    EXPECT_TRUE(call.context.tenant_id.empty());
+    EXPECT_TRUE(call.context.roles.empty());
+
+    // A user without a tenant yet (e.g. enrolling TOTP) is authenticated
+    Add("x-user-id", "user-1");
+    EXPECT_TRUE(TenantContextInterceptor::Parse(metadata_, nullptr, true).rejection.ok());
+}
+
+TEST_F(TenantContextTest, ValidatesBearerToken) {
+    JwtValidator validator(public_key_, nullptr);
+    Add("authorization", "Bearer " + MakeToken());
+    Add("x-tenant-id", "tenant-1");
+    Add("x-user-id", "spoofed");
+
+    TenantCall call = TenantContextInterceptor::Parse(metadata_, &validator, true);
+    EXPECT_TRUE(call.rejection.ok());
+    EXPECT_TRUE(call.context.validated);
+    EXPECT_EQ(call.context.tenant_id, "tenant-1");
+    EXPECT_EQ(call.context.user_id, "user-1");   // Claims win over headers
+    EXPECT_EQ(call.context.email, "user@example.com");
+}
+
+TEST_F(TenantContextTest, RejectsTenantMismatch) {
+    JwtValidator validator(public_key_, nullptr);
+    Add("authorization", "Bearer " + MakeToken());
+    Add("x-tenant-id", "tenant-2");
+
+    TenantCall call = TenantContextInterceptor::Parse(metadata_, &validator, false);
+    EXPECT_EQ(call.rejection.error_code(), grpc::StatusCode::UNAUTHENTICATED);
+    EXPECT_FALSE(call.context.validated);
+    EXPECT_TRUE(call.context.tenant_id.empty());
+}
+
+TEST_F(TenantContextTest, RejectsInvalidToken) {
+    JwtValidator validator(public_key_, nullptr);
+    Add("authorization", "Bearer not-a-jwt");
+    Add("x-tenant-id", "tenant-1");
+
+    // Even on public methods: a presented token must be valid
+    TenantCall call = TenantContextInterceptor::Parse(metadata_, &validator, false);
+    EXPECT_EQ(call.rejection.error_code(), grpc::StatusCode::UNAUTHENTICATED);
+    EXPECT_TRUE(call.context.tenant_id.empty());
+}
+
+TEST_F(TenantContextTest, HeadersTrustedWithoutValidator) {
+    Add("authorization", "Bearer not-a-jwt");
+    Add("x-tenant-id", "tenant-1");
+
+    TenantCall call = TenantContextInterceptor::Parse(metadata_, nullptr, true);
+    EXPECT_TRUE(call.rejection.ok());
+    EXPECT_EQ(call.context.tenant_id, "tenant-1");
+}
+
+TEST_F(TenantContextTest, ForCallFallsBackToMetadata) {
+    // No interceptor ran for this context (handler called directly)
+    grpc::ServerContext context;
+    EXPECT_TRUE(TenantContextInterceptor::CallStatus(&context).ok());
+    auto tenant = TenantContextInterceptor::ForCall(&context);
+    ASSERT_NE(tenant, nullptr);
+    EXPECT_TRUE(tenant->tenant_id.empty());
+}
+
+} // namespace test
+} // namespace common
+} // namespace saasforge
@@ -0,0 +1,94 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for tenant-wide session revocation epochs
+ */
+
+#include <gtest/gtest.h>
+#include "common/jwt_signer.h"
+#include "common/jwt_validator.h"
+#include "common/tenant_revocations.h"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <chrono>
+
+using namespace saasforge::common;
+
+namespace {
+
+std::string Pem(EVP_PKEY* key, bool private_key) {
+    BIO* bio = BIO_new(BIO_s_mem());
+    if (private_key) {
+        PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+    } else {
+        PEM_write_bio_PUBKEY(bio, key);
+    }
+    char* data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    std::string out(data, static_cast<size_t>(len));
+    BIO_free(bio);
+    return out;
+}
+
+std::string TokenFor(const JwtSigner& signer, const std::string& tenant_id,
+                     std::chrono::system_clock::time_point issued_at) {
+    return signer.Sign(jwt::create()
+        .set_issuer("saasforge")
+        .set_subject("user-1")
+        .set_id("jti-" + tenant_id)
+        .set_issued_at(issued_at)
+        .set_expires_at(issued_at + std::chrono::minutes(15))
+        .set_payload_claim("tenant_id", jwt::claim(tenant_id))
+        .set_payload_claim("email", jwt::claim(std::string("user@example.com"))));
+}
+
+} // namespace
+
+TEST(TenantRevocationsTest, RevokesSessionsStartedUpToTheRevocation) {
+    TenantRevocations revocations(nullptr);
+    EXPECT_FALSE(revocations.IsRevoked("tenant-1", 1000));
+
+    revocations.Note("tenant-1", 5000);
+    EXPECT_TRUE(revocations.IsRevoked("tenant-1", 4999));
+    EXPECT_TRUE(revocations.IsRevoked("tenant-1", 5000));
+    EXPECT_FALSE(revocations.IsRevoked("tenant-1", 5001));
+    EXPECT_FALSE(revocations.IsRevoked("tenant-2", 1000));
+    EXPECT_EQ(revocations.Size(), 1u);
+}
+
+TEST(TenantRevocationsTest, KeepsTheLatestRevocation) {
+    TenantRevocations revocations(nullptr);
+    revocations.Note("tenant-1", 5000);
+    revocations.Note("tenant-1", 3000);   // Late or replayed message
+    EXPECT_TRUE(revocations.IsRevoked("tenant-1", 4000));
+
+    int64_t revoked_at = revocations.Revoke("tenant-1");
+    EXPECT_GE(revoked_at, 5000);
+    EXPECT_TRUE(revocations.IsRevoked("tenant-1", revoked_at));
+    EXPECT_FALSE(revocations.IsRevoked("tenant-1", revoked_at + 1));
+}
+
+TEST(TenantRevocationsTest, ValidatorRejectsTokensMintedBeforeARevocation) {
+    EVP_PKEY* key = EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519");
+    JwtSigner signer(Pem(key, true));
+    JwtValidatorOptions options;
+    options.blacklist_filter = false;
+    JwtValidator validator(Pem(key, false), nullptr, options);
+    EVP_PKEY_free(key);
+
+    auto before = std::chrono::system_clock::now() - std::chrono::seconds(5);
+    std::string revoked = TokenFor(signer, "tenant-1", before);
+    std::string other_tenant = TokenFor(signer, "tenant-2", before);
+    ASSERT_TRUE(validator.Validate(revoked).has_value());   // Now also cached
+
+    // Revoked two seconds after the token was minted
+    ASSERT_NE(validator.Revocations(), nullptr);
+    auto revoked_at = std::chrono::duration_cast<std::chrono::milliseconds>(
+        (before + std::chrono::seconds(2)).time_since_epoch()).count();
+    validator.Revocations()->Note("tenant-1", revoked_at);
+    EXPECT_FALSE(validator.Validate(revoked).has_value());
+    EXPECT_TRUE(validator.Validate(other_tenant).has_value());
+
+    // Sessions started after the revocation are unaffected
+    EXPECT_TRUE(validator.Validate(TokenFor(signer, "tenant-1", std::chrono::system_clock::now())).has_value());
+}
@@ -0,0 +1,162 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for per-tenant usage accounting
+ */
+
+#include <gtest/gtest.h>
+#include "common/tenant_usage.h"
+#include <thread>
+
+using namespace saasforge::common;
+using namespace std::chrono_literals;
+
+namespace {
+
+void Burn(std::chrono::milliseconds duration) {
+    auto end = std::chrono::steady_clock::now() + duration;
+    volatile uint64_t sink = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        sink = sink + 1;
+    }
+}
+
+TenantUsageOptions OneSecondWindows() {
+    TenantUsageOptions options;
+    options.capacity = 8;
+    options.window = 1s;
+    return options;
+}
+
+} // namespace
+
+// Test that counts are exact while every key fits
+TEST(SpaceSavingTest, CountsExactlyUnderCapacity) {
+    SpaceSaving sketch(4);
+    sketch.Add("a", 5);
+    sketch.Add("b", 2);
+    sketch.Add("a", 1);
+    sketch.Add("c", 9);
+
+    auto top = sketch.Top(10);
+    ASSERT_EQ(top.size(), 3u);
+    EXPECT_EQ(top[0].key, "c");
+    EXPECT_EQ(top[0].count, 9u);
+    EXPECT_EQ(top[1].key, "a");
+    EXPECT_EQ(top[1].count, 6u);
+    EXPECT_EQ(top[1].error, 0u);
+    EXPECT_EQ(sketch.Estimate("b"), 2u);
+    EXPECT_EQ(sketch.Estimate("unknown"), 0u);
+    EXPECT_EQ(sketch.Total(), 17u);
+}
+
+// Test that heavy keys survive a long tail of light ones, within the error bound
+TEST(SpaceSavingTest, KeepsHeavyHittersAmongManyKeys) {
+    SpaceSaving sketch(16);
+    for (int round = 0; round < 100; ++round) {
+        sketch.Add("noisy", 50);
+        sketch.Add("busy", 20);
+        for (int i = 0; i < 30; ++i) {
+            sketch.Add("tenant-" + std::to_string(round * 30 + i), 1);
+        }
+    }
+    EXPECT_EQ(sketch.Size(), 16u);
+
+    auto top = sketch.Top(2);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].key, "noisy");
+    EXPECT_EQ(top[1].key, "busy");
+    for (const auto& entry : top) {
+        uint64_t truth = entry.key == "noisy" ? 5000 : 2000;
+        EXPECT_GE(entry.count, truth);
+        EXPECT_LE(entry.count - entry.error, truth);
+        EXPECT_LE(entry.error, sketch.Total() / 16);
+    }
+    // Untracked keys are bounded by the smallest count
+    EXPECT_GT(sketch.Estimate("never-seen"), 0u);
+    EXPECT_LE(sketch.Estimate("never-seen"), sketch.Total() / 16);
+}
+
+// Test moving a sketch keeps its keys usable
+TEST(SpaceSavingTest, MovesWithItsKeys) {
+    SpaceSaving sketch(2);
+    sketch.Add("a-key-longer-than-the-small-string-buffer", 3);
+    sketch.Add("b", 1);
+    SpaceSaving moved(std::move(sketch));
+    moved.Add("a-key-longer-than-the-small-string-buffer", 1);
+    moved.Add("c", 1);
+    EXPECT_EQ(moved.Estimate("a-key-longer-than-the-small-string-buffer"), 4u);
+    EXPECT_EQ(moved.Estimate("c"), 2u);   // Replaced "b" and inherited its count
+    EXPECT_EQ(moved.Top(1)[0].key, "a-key-longer-than-the-small-string-buffer");
+}
+
+// Test that a scope charges CPU, queries and Redis round trips to its tenant
+TEST(TenantUsageTest, ScopeChargesItsTenant) {
+    TenantUsage usage(OneSecondWindows());
+    {
+        TenantUsageScope scope("tenant-a", usage);
+        EXPECT_EQ(TenantUsageScope::Current(), &scope);
+        Burn(20ms);
+        TenantUsage::ChargeDb(3ms, 40);
+        TenantUsage::ChargeRedis();
+        TenantUsage::ChargeRedis(2);
+    }
+    EXPECT_EQ(TenantUsageScope::Current(), nullptr);
+    TenantUsage::ChargeRedis(100);   // Outside a scope: ignored
+
+    // Readers see the last complete window
+    EXPECT_EQ(usage.Estimate(TenantResource::REDIS_OPS, "tenant-a"), 0u);
+    std::this_thread::sleep_for(1100ms);
+
+    EXPECT_EQ(usage.Estimate(TenantResource::REDIS_OPS, "tenant-a"), 3u);
+    EXPECT_EQ(usage.Estimate(TenantResource::DB_ROWS, "tenant-a"), 40u);
+    EXPECT_EQ(usage.Estimate(TenantResource::DB_MICROS, "tenant-a"), 3000u);
+    EXPECT_GE(usage.Estimate(TenantResource::CPU_MICROS, "tenant-a"), 10000u);
+    EXPECT_DOUBLE_EQ(usage.Share(TenantResource::REDIS_OPS, "tenant-a"), 1.0);
+}
+
+// Test that nested scopes charge their own tenant without counting CPU twice
+TEST(TenantUsageTest, NestedScopesSplitCpu) {
+    TenantUsage usage(OneSecondWindows());
+    {
+        TenantUsageScope outer("outer", usage);
+        {
+            TenantUsageScope inner("inner", usage);
+            Burn(40ms);
+            TenantUsage::ChargeRedis();
+        }
+        TenantUsage::ChargeRedis();
+    }
+    std::this_thread::sleep_for(1100ms);
+
+    EXPECT_EQ(usage.Estimate(TenantResource::REDIS_OPS, "outer"), 1u);
+    EXPECT_EQ(usage.Estimate(TenantResource::REDIS_OPS, "inner"), 1u);
+    EXPECT_GE(usage.Estimate(TenantResource::CPU_MICROS, "inner"), 20000u);
+    EXPECT_LT(usage.Estimate(TenantResource::CPU_MICROS, "outer"), 20000u);
+}
+
+// Test ranking, tenant-less scopes and idle windows
+TEST(TenantUsageTest, RanksTenantsPerWindow) {
+    TenantUsage usage(OneSecondWindows());
+    for (int i = 0; i < 10; ++i) {
+        TenantUsageSample sample;
+        sample[TenantResource::DB_ROWS] = static_cast<uint64_t>(i + 1);
+        usage.Record("tenant-" + std::to_string(i), sample);
+        usage.Record("tenant-9", sample);
+    }
+    usage.Record("", TenantUsageSample{});
+    {
+        TenantUsageScope anonymous(std::string(), usage);
+        TenantUsage::ChargeRedis();
+    }
+    std::this_thread::sleep_for(1100ms);
+
+    auto top = usage.Top(TenantResource::DB_ROWS, 3);
+    ASSERT_EQ(top.size(), 3u);
+    EXPECT_EQ(top[0].key, "tenant-9");
+    EXPECT_TRUE(usage.Top(TenantResource::REDIS_OPS, 3).empty());
+
+    // A window with no usage at all empties the ranking
+    std::this_thread::sleep_for(2100ms);
+    EXPECT_TRUE(usage.Top(TenantResource::DB_ROWS, 3).empty());
+}
@@ -0,0 +1,163 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the hierarchical timing wheel
+ */
+
+#include <gtest/gtest.h>
+#include "common/timing_wheel.h"
+#include <algorithm>
+#include <random>
+
+using namespace saasforge::common;
+using std::chrono::milliseconds;
+
+namespace {
+
+using Wheel = TimingWheel<int>;
+
+const Wheel::Clock::time_point kStart{std::chrono::hours(1)};
+
+Wheel::Clock::time_point At(int64_t ms) {
+    return kStart + milliseconds(ms);
+}
+
+} // namespace
+
+// Test that items fire once their due time is reached, not before
+TEST(TimingWheelTest, FiresAtDueTime) {
+    Wheel wheel(kStart);
+    wheel.Schedule(1, At(10));
+    wheel.Schedule(2, At(20));
+
+    EXPECT_TRUE(wheel.Advance(At(9)).empty());
+    EXPECT_EQ(wheel.Advance(At(10)), std::vector<int>{1});
+    EXPECT_TRUE(wheel.Advance(At(19)).empty());
+    EXPECT_EQ(wheel.Advance(At(25)), std::vector<int>{2});
+    EXPECT_TRUE(wheel.Empty());
+}
+
+// Test that a due time between ticks rounds up
+TEST(TimingWheelTest, NeverFiresEarly) {
+    Wheel wheel(kStart, milliseconds(10));
+    wheel.Schedule(1, At(15));
+
+    EXPECT_TRUE(wheel.Advance(At(14)).empty());
+    EXPECT_TRUE(wheel.Advance(At(19)).empty());
+    EXPECT_EQ(wheel.Advance(At(20)), std::vector<int>{1});
+}
+
+// Test that past and present due times fire on the next Advance()
+TEST(TimingWheelTest, OverdueFiresImmediately) {
+    Wheel wheel(kStart);
+    wheel.Advance(At(100));
+    wheel.Schedule(1, At(50));
+    wheel.Schedule(2, At(100));
+
+    EXPECT_EQ(wheel.NextDue(), At(100));
+    auto fired = wheel.Advance(At(100));
+    std::sort(fired.begin(), fired.end());
+    EXPECT_EQ(fired, (std::vector<int>{1, 2}));
+}
+
+// Test items on every level, including ones cascading on their own due tick
+TEST(TimingWheelTest, CascadesThroughLevels) {
+    Wheel wheel(kStart);
+    std::vector<int64_t> dues = {1, 63, 64, 65, 4095, 4096, 4097, 262144, 300000, 16777215};
+    for (size_t i = 0; i < dues.size(); ++i) {
+        wheel.Schedule(static_cast<int>(i), At(dues[i]));
+    }
+
+    for (size_t i = 0; i < dues.size(); ++i) {
+        EXPECT_TRUE(wheel.Advance(At(dues[i] - 1)).empty()) << "due " << dues[i];
+        EXPECT_EQ(wheel.Advance(At(dues[i])), std::vector<int>{static_cast<int>(i)}) << "due " << dues[i];
+    }
+    EXPECT_TRUE(wheel.Empty());
+}
+
+// Test that items beyond the last level are held until due
+TEST(TimingWheelTest, HoldsBeyondRange) {
+    Wheel wheel(kStart, milliseconds(1000));
+    int64_t far = int64_t{300} * 24 * 3600 * 1000;  // The wheel spans 2^24 ticks: 194 days at 1 s
+    wheel.Schedule(1, At(far));
+
+    EXPECT_TRUE(wheel.Advance(At(far - 1000)).empty());
+    EXPECT_EQ(wheel.Advance(At(far)), std::vector<int>{1});
+}
+
+// Test that a coarse jump returns everything due in between, in due order
+TEST(TimingWheelTest, AdvanceReturnsInDueOrder) {
+    Wheel wheel(kStart);
+    wheel.Schedule(3, At(5000));
+    wheel.Schedule(1, At(30));
+    wheel.Schedule(2, At(700));
+    wheel.Schedule(4, At(9000));
+
+    EXPECT_EQ(wheel.Advance(At(6000)), (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(wheel.Size(), 1u);
+}
+
+// Test that NextDue() is exact within level 0 and never late beyond it
+TEST(TimingWheelTest, NextDue) {
+    Wheel wheel(kStart);
+    EXPECT_FALSE(wheel.NextDue().has_value());
+
+    wheel.Schedule(1, At(5000));
+    auto next = wheel.NextDue();
+    ASSERT_TRUE(next.has_value());
+    EXPECT_LE(*next, At(5000));
+    EXPECT_GT(*next, At(0));
+
+    wheel.Schedule(2, At(40));
+    EXPECT_EQ(wheel.NextDue(), At(40));
+
+    // Repeatedly advancing to NextDue() reaches the item at its due time
+    wheel.Advance(At(40));
+    for (int i = 0; i < 10 && wheel.Advance(*wheel.NextDue()).empty(); ++i) {
+    }
+    EXPECT_TRUE(wheel.Empty());
+}
+
+// Test Drain() hands back everything, due or not
+TEST(TimingWheelTest, Drain) {
+    Wheel wheel(kStart);
+    wheel.Schedule(1, At(0));
+    wheel.Schedule(2, At(100));
+    wheel.Schedule(3, At(100000));
+
+    auto items = wheel.Drain();
+    std::sort(items.begin(), items.end());
+    EXPECT_EQ(items, (std::vector<int>{1, 2, 3}));
+    EXPECT_TRUE(wheel.Empty());
+    EXPECT_FALSE(wheel.NextDue().has_value());
+    EXPECT_TRUE(wheel.Advance(At(200000)).empty());
+}
+
+// Test random schedules against a sorted reference
+TEST(TimingWheelTest, MatchesReference) {
+    Wheel wheel(kStart);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int64_t> delay(0, 400000);
+
+    std::vector<std::pair<int64_t, int>> expected;
+    int64_t now = 0;
+    for (int i = 0; i < 2000; ++i) {
+        int64_t due = now + delay(rng);
+        wheel.Schedule(i, At(due));
+        expected.emplace_back(due, i);
+        if (i % 100 == 99) {
+            now += 3000;
+            for (int item : wheel.Advance(At(now))) {
+                auto it = std::find_if(expected.begin(), expected.end(),
+                                       [item](const auto& e) { return e.second == item; });
+                ASSERT_NE(it, expected.end());
+                EXPECT_LE(it->first, now);
+                expected.erase(it);
+            }
+            for (const auto& [due_at, item] : expected) {
+                ASSERT_GT(due_at, now) << "item " << item << " not fired";
+            }
+        }
+    }
+    EXPECT_EQ(wheel.Size(), expected.size());
+}
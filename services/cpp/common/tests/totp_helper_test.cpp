@@ -164,6 +164,52 @@ TEST_F(TotpHelperTest, DISABLED_ValidateCodeWithRFC6238TestVectors) {
     EXPECT_TRUE(true);
 }
 
+TEST_F(TotpHelperTest, ValidateCodeAtMatchesRFC6238Vectors) {
+    // RFC 6238 Appendix B (SHA1), last 6 of the 8 digits
+    // Secret: "12345678901234567890" (ASCII)
+    const std::string secret = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "287082", 59, 0));
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "081804", 1111111109, 0));
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "050471", 1111111111, 0));
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "005924", 1234567890, 0));
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "279037", 2000000000, 0));
+
+    EXPECT_FALSE(TotpHelper::ValidateCodeAt(secret, "287083", 59, 0));
+}
+
+TEST_F(TotpHelperTest, ValidateCodeAtAcceptsAdjacentIntervalsInWindow) {
+    const std::string secret = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+
+    // 287082 is the code for 30-59s
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "287082", 89, 1));
+    EXPECT_FALSE(TotpHelper::ValidateCodeAt(secret, "287082", 89, 0));
+    EXPECT_FALSE(TotpHelper::ValidateCodeAt(secret, "287082", 119, 1));
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt(secret, "287082", 119, 2));
+}
+
+TEST_F(TotpHelperTest, VerifyCodeAtReturnsMatchedCounter) {
+    const std::string secret = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+
+    EXPECT_EQ(TotpHelper::VerifyCodeAt(secret, "287082", 59, 1), std::optional<uint64_t>(1));
+    EXPECT_EQ(TotpHelper::VerifyCodeAt(secret, "287082", 89, 1), std::optional<uint64_t>(1));
+    EXPECT_EQ(TotpHelper::VerifyCodeAt(secret, "005924", 1234567890, 1),
+              std::optional<uint64_t>(1234567890 / 30));
+    EXPECT_EQ(TotpHelper::VerifyCodeAt(secret, "287083", 59, 1), std::nullopt);
+    EXPECT_EQ(TotpHelper::VerifyCodeAt(secret, "28708", 59, 1), std::nullopt);
+}
+
+TEST_F(TotpHelperTest, ReplayWindowCoversEveryAcceptingStep) {
+    EXPECT_EQ(TotpHelper::ReplayWindowSeconds(0), 30);
+    EXPECT_EQ(TotpHelper::ReplayWindowSeconds(1), 90);
+    EXPECT_EQ(TotpHelper::ReplayWindowSeconds(2), 150);
+}
+
+TEST_F(TotpHelperTest, ValidateCodeAtDecodesLowercaseAndSeparators) {
+    EXPECT_TRUE(TotpHelper::ValidateCodeAt("gezd gnbv-gy3t qojq gezd gnbv gy3t qojq", "287082", 59, 0));
+    EXPECT_THROW(TotpHelper::ValidateCodeAt("GEZDGNBV!", "287082", 59, 0), std::invalid_argument);
+}
+
 // Test: Backup Code Generation
 
 TEST_F(TotpHelperTest, GenerateBackupCodesProducesCorrectCount) {
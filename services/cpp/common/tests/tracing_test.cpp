@@ -0,0 +1,248 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for trace propagation, tail sampling and OTLP export
+ */
+
+#include <gtest/gtest.h>
+#include "common/executor.h"
+#include "common/tracing.h"
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace saasforge::common;
+
+namespace {
+
+// Collects exported spans
+struct Capture {
+    std::mutex mutex;
+    std::vector<SpanData> spans;
+
+    Tracer::Exporter Make() {
+        return [this](const std::vector<SpanData>& batch) {
+            std::lock_guard<std::mutex> lock(mutex);
+            spans.insert(spans.end(), batch.begin(), batch.end());
+        };
+    }
+
+    const SpanData* Find(const std::string& name) {
+        for (const auto& span : spans) {
+            if (span.name == name) {
+                return &span;
+            }
+        }
+        return nullptr;
+    }
+};
+
+TracerOptions Options() {
+    TracerOptions options;
+    options.sample_ratio = 1.0;
+    options.slow_threshold = std::chrono::milliseconds(0);
+    options.flush_interval = std::chrono::hours(1);  // Tests flush explicitly
+    options.batch_size = 1000;
+    return options;
+}
+
+const char* TRACEPARENT = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01";
+
+} // namespace
+
+TEST(TracingTest, ParsesTraceparent) {
+    auto context = SpanContext::FromTraceparent(TRACEPARENT);
+    ASSERT_TRUE(context.has_value());
+    EXPECT_EQ(context->TraceIdHex(), "4bf92f3577b34da6a3ce929d0e0e4736");
+    EXPECT_EQ(context->SpanIdHex(), "00f067aa0ba902b7");
+    EXPECT_TRUE(context->sampled);
+    EXPECT_EQ(context->ToTraceparent(), TRACEPARENT);
+
+    // Later versions may append fields, version 00 may not
+    EXPECT_TRUE(SpanContext::FromTraceparent("01" + std::string(TRACEPARENT + 2) + "-extra").has_value());
+    EXPECT_FALSE(SpanContext::FromTraceparent(std::string(TRACEPARENT) + "-extra").has_value());
+
+    EXPECT_FALSE(SpanContext::FromTraceparent("").has_value());
+    EXPECT_FALSE(SpanContext::FromTraceparent("00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01").has_value());
+    EXPECT_FALSE(SpanContext::FromTraceparent("00-00000000000000000000000000000000-00f067aa0ba902b7-01").has_value());
+    EXPECT_FALSE(SpanContext::FromTraceparent("00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01").has_value());
+    EXPECT_FALSE(SpanContext::FromTraceparent("ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01").has_value());
+    EXPECT_FALSE(SpanContext::FromTraceparent(std::string(TRACEPARENT) + "0").has_value());
+}
+
+TEST(TracingTest, SpansNestUnderServerSpan) {
+    Capture capture;
+    Tracer tracer(Options(), capture.Make());
+
+    EXPECT_FALSE(Span("untraced").Recording());
+
+    Span root = tracer.StartServerSpan("saasforge.auth.AuthService/Login", "");
+    {
+        ScopedTraceContext scope(root.Context());
+        Span acquire("db.acquire");
+        acquire.SetAttribute("db.caller", "Login");
+        acquire.End();
+        Span query("db.query");
+        {
+            Span nested("redis.set_session");
+        }
+    }
+    EXPECT_FALSE(TraceContext::Current().Active());
+    root.End();
+    tracer.Flush();
+
+    ASSERT_EQ(capture.spans.size(), 4u);
+    const SpanData* server = capture.Find("saasforge.auth.AuthService/Login");
+    const SpanData* acquire = capture.Find("db.acquire");
+    const SpanData* query = capture.Find("db.query");
+    const SpanData* nested = capture.Find("redis.set_session");
+    ASSERT_TRUE(server && acquire && query && nested);
+
+    EXPECT_EQ(server->kind, SpanKind::kServer);
+    EXPECT_EQ(server->parent_span_id, SpanId{});
+    EXPECT_EQ(acquire->parent_span_id, server->span_id);
+    EXPECT_EQ(query->parent_span_id, server->span_id);
+    EXPECT_EQ(nested->parent_span_id, query->span_id);
+    EXPECT_EQ(nested->trace_id, server->trace_id);
+    EXPECT_LE(server->start_unix_nano, acquire->start_unix_nano);
+    EXPECT_GE(server->end_unix_nano, query->end_unix_nano);
+    ASSERT_EQ(acquire->attributes.size(), 1u);
+    EXPECT_EQ(acquire->attributes[0].second, "Login");
+}
+
+TEST(TracingTest, ContinuesIncomingTrace) {
+    Capture capture;
+    Tracer tracer(Options(), capture.Make());
+
+    tracer.StartServerSpan("rpc", TRACEPARENT).End();
+    // Caller decided not to sample; fast, so nothing is kept
+    tracer.StartServerSpan("rpc", "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00").End();
+    tracer.Flush();
+
+    ASSERT_EQ(capture.spans.size(), 1u);
+    SpanContext parent;
+    parent.trace_id = capture.spans[0].trace_id;
+    parent.span_id = capture.spans[0].parent_span_id;
+    parent.sampled = true;
+    EXPECT_EQ(parent.ToTraceparent(), TRACEPARENT);
+}
+
+TEST(TracingTest, TailSamplingKeepsSlowAndFailedTraces) {
+    Capture capture;
+    auto options = Options();
+    options.sample_ratio = 0.0;
+    options.slow_threshold = std::chrono::milliseconds(20);
+    Tracer tracer(options, capture.Make());
+
+    tracer.StartServerSpan("fast", "").End();
+
+    Span slow = tracer.StartServerSpan("slow", "");
+    {
+        ScopedTraceContext scope(slow.Context());
+        Span child("argon2.verify");
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+    }
+    slow.End();
+
+    Span failed = tracer.StartServerSpan("failed", "");
+    {
+        ScopedTraceContext scope(failed.Context());
+        Span child("db.query");
+        child.SetError("connection reset");
+    }
+    failed.End();
+    tracer.Flush();
+
+    EXPECT_EQ(capture.Find("fast"), nullptr);
+    EXPECT_NE(capture.Find("slow"), nullptr);
+    EXPECT_NE(capture.Find("argon2.verify"), nullptr);
+    EXPECT_NE(capture.Find("failed"), nullptr);
+    ASSERT_NE(capture.Find("db.query"), nullptr);
+    EXPECT_TRUE(capture.Find("db.query")->error);
+
+    auto stats = tracer.GetStats();
+    EXPECT_EQ(stats.traces_started, 3u);
+    EXPECT_EQ(stats.traces_kept, 2u);
+    EXPECT_EQ(stats.spans_exported, 4u);
+}
+
+TEST(TracingTest, ExecutorCarriesContext) {
+    Capture capture;
+    Tracer tracer(Options(), capture.Make());
+    Executor executor(1, 8);
+
+    Span root = tracer.StartServerSpan("rpc", "");
+    std::promise<void> done;
+    {
+        ScopedTraceContext scope(root.Context());
+        ASSERT_TRUE(executor.TrySubmit([&done] {
+            { Span work("transform"); }
+            done.set_value();
+        }));
+    }
+    done.get_future().wait();
+    // Worker threads go back to untraced after the task
+    std::promise<bool> active;
+    ASSERT_TRUE(executor.TrySubmit([&active] { active.set_value(TraceContext::Current().Active()); }));
+    EXPECT_FALSE(active.get_future().get());
+
+    root.End();
+    tracer.Flush();
+    ASSERT_NE(capture.Find("transform"), nullptr);
+    EXPECT_EQ(capture.Find("transform")->parent_span_id, capture.Find("rpc")->span_id);
+    executor.Shutdown();
+}
+
+TEST(TracingTest, BoundsSpansAndQueue) {
+    Capture capture;
+    auto options = Options();
+    options.max_spans_per_trace = 2;
+    options.queue_capacity = 1;
+    Tracer tracer(options, capture.Make());
+
+    Span root = tracer.StartServerSpan("rpc", "");
+    {
+        ScopedTraceContext scope(root.Context());
+        for (int i = 0; i < 5; ++i) {
+            Span child("child");
+        }
+    }
+    root.End();
+    tracer.StartServerSpan("second", "").End();   // Queue already full
+    tracer.Flush();
+
+    auto stats = tracer.GetStats();
+    EXPECT_EQ(capture.spans.size(), 3u);     // Two children and the root
+    EXPECT_EQ(stats.spans_dropped, 3u);
+    EXPECT_EQ(stats.traces_dropped, 1u);
+}
+
+TEST(TracingTest, DisabledTracerRecordsNothing) {
+    Tracer tracer(TracerOptions{});
+    EXPECT_FALSE(tracer.Enabled());
+    Span root = tracer.StartServerSpan("rpc", TRACEPARENT);
+    EXPECT_FALSE(root.Recording());
+    EXPECT_FALSE(root.Context().Active());
+}
+
+TEST(TracingTest, OtlpJson) {
+    SpanData span;
+    span.name = "db.query";
+    span.kind = SpanKind::kClient;
+    span.trace_id = SpanContext::FromTraceparent(TRACEPARENT)->trace_id;
+    span.span_id = SpanContext::FromTraceparent(TRACEPARENT)->span_id;
+    span.start_unix_nano = 1000;
+    span.end_unix_nano = 2500;
+    span.error = true;
+    span.status_message = "bad \"input\"";
+    span.attributes = {{"db.statement.name", "auth_login_select_user"}};
+
+    std::string json = Tracer::ToOtlpJson({span}, "auth-service");
+    EXPECT_EQ(json,
+              "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\","
+              "\"value\":{\"stringValue\":\"auth-service\"}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"saasforge\"},"
+              "\"spans\":[{\"traceId\":\"4bf92f3577b34da6a3ce929d0e0e4736\",\"spanId\":\"00f067aa0ba902b7\","
+              "\"name\":\"db.query\",\"kind\":3,\"startTimeUnixNano\":\"1000\",\"endTimeUnixNano\":\"2500\","
+              "\"attributes\":[{\"key\":\"db.statement.name\",\"value\":{\"stringValue\":\"auth_login_select_user\"}}],"
+              "\"status\":{\"code\":2,\"message\":\"bad \\\"input\\\"\"}}]}]}]}");
+}
@@ -0,0 +1,283 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for write-behind usage aggregation and WAL recovery
+ */
+
+#include <gtest/gtest.h>
+#include "common/usage_aggregator.h"
+#include <atomic>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+using namespace saasforge::common;
+
+namespace {
+
+constexpr int64_t T0 = 1763290800;  // 2025-11-16 11:00:00 UTC
+
+// Collects written batches; can be told to fail
+struct FakeSink {
+    std::mutex mutex;
+    std::vector<std::pair<std::string, std::vector<UsageBucket>>> batches;
+    std::set<std::string> applied;
+    std::atomic<bool> fail{false};
+
+    UsageAggregator::Sink Make() {
+        return [this](const std::string& id, const std::vector<UsageBucket>& buckets) {
+            if (fail) {
+                throw std::runtime_error("db down");
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!applied.insert(id).second) {
+                return;  // Idempotent per batch id, like usage_ingest_batches
+            }
+            batches.emplace_back(id, buckets);
+        };
+    }
+
+    // (subscription, metric, minute) -> quantity across all batches
+    std::map<std::tuple<std::string, std::string, int64_t>, int64_t> Totals() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<std::tuple<std::string, std::string, int64_t>, int64_t> totals;
+        for (const auto& batch : batches) {
+            for (const auto& b : batch.second) {
+                totals[{b.subscription_id, b.metric_name, b.minute}] += b.quantity;
+            }
+        }
+        return totals;
+    }
+};
+
+size_t CountSegments(const std::string& dir) {
+    size_t count = 0;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.rfind("usage-", 0) == 0) {
+                ++count;
+            }
+        }
+        closedir(d);
+    }
+    return count;
+}
+
+} // namespace
+
+class UsageAggregatorTest : public ::testing::Test {
+protected:
+    std::string wal_dir;
+    FakeSink sink;
+
+    void SetUp() override {
+        char tmpl[] = "/tmp/usage_wal_XXXXXX";
+        wal_dir = mkdtemp(tmpl);
+    }
+
+    void TearDown() override {
+        std::string cmd = "rm -rf " + wal_dir;
+        (void)std::system(cmd.c_str());
+    }
+
+    UsageAggregatorOptions Options(bool wal = true) {
+        UsageAggregatorOptions options;
+        options.flush_interval = std::chrono::hours(1);  // Tests flush explicitly
+        options.flush_max_records = 1000000;
+        if (wal) {
+            options.wal_dir = wal_dir;
+        }
+        return options;
+    }
+};
+
+TEST_F(UsageAggregatorTest, CoalescesPerMinute) {
+    UsageAggregator usage(sink.Make(), Options(false));
+
+    usage.Record({"t1", "sub-1", "api_calls", 1, T0 + 1});
+    usage.Record({"t1", "sub-1", "api_calls", 2, T0 + 59});
+    usage.Record({"t1", "sub-1", "api_calls", 4, T0 + 60});
+    usage.Record({"t1", "sub-1", "storage_gb", 8, T0 + 5});
+    usage.Record({"t1", "sub-2", "api_calls", 16, T0 + 5});
+
+    EXPECT_EQ(usage.GetStats().buffered_buckets, 4u);
+    ASSERT_TRUE(usage.Flush());
+
+    ASSERT_EQ(sink.batches.size(), 1u);
+    EXPECT_EQ(sink.batches[0].second.size(), 4u);
+    auto totals = sink.Totals();
+    EXPECT_EQ((totals[{"sub-1", "api_calls", T0}]), 3);
+    EXPECT_EQ((totals[{"sub-1", "api_calls", T0 + 60}]), 4);
+    EXPECT_EQ((totals[{"sub-1", "storage_gb", T0}]), 8);
+    EXPECT_EQ((totals[{"sub-2", "api_calls", T0}]), 16);
+    EXPECT_EQ(usage.GetStats().buffered_buckets, 0u);
+}
+
+TEST_F(UsageAggregatorTest, RejectsInvalidEvents) {
+    UsageAggregator usage(sink.Make(), Options(false));
+
+    EXPECT_THROW(usage.Record({"t1", "sub-1", "api_calls", 0, T0}), std::invalid_argument);
+    EXPECT_THROW(usage.Record({"t1", "sub-1", "api_calls", -5, T0}), std::invalid_argument);
+    EXPECT_THROW(usage.Record({"t1", "sub-1", "", 1, T0}), std::invalid_argument);
+    EXPECT_THROW(usage.Record({"t1", "sub-1", "bad\tname", 1, T0}), std::invalid_argument);
+    EXPECT_THROW(usage.Record({"t1", "sub-1", std::string(101, 'm'), 1, T0}), std::invalid_argument);
+
+    // A rejected event in a batch rejects the whole batch
+    EXPECT_THROW(usage.Record(std::vector<UsageEvent>{{"t1", "sub-1", "api_calls", 1, T0},
+                                                      {"t1", "sub-1", "api_calls", 0, T0}}),
+                 std::invalid_argument);
+    EXPECT_EQ(usage.GetStats().recorded, 0u);
+
+    EXPECT_THROW(UsageAggregator::Validate({"t1", "", "api_calls", 1, T0}), std::invalid_argument);
+    EXPECT_NO_THROW(UsageAggregator::Validate({"t1", "sub-1", "api_calls", 1, T0}));
+}
+
+TEST_F(UsageAggregatorTest, FlushesAfterMaxRecords) {
+    auto options = Options(false);
+    options.flush_max_records = 10;
+    UsageAggregator usage(sink.Make(), options);
+
+    for (int i = 0; i < 10; ++i) {
+        usage.Record({"t1", "sub-1", "api_calls", 1, T0});
+    }
+
+    for (int i = 0; i < 200 && usage.GetStats().flushed_batches == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(usage.GetStats().flushed_batches, 1u);
+    EXPECT_EQ((sink.Totals()[{"sub-1", "api_calls", T0}]), 10);
+}
+
+TEST_F(UsageAggregatorTest, FlushesOnInterval) {
+    auto options = Options(false);
+    options.flush_interval = std::chrono::milliseconds(20);
+    UsageAggregator usage(sink.Make(), options);
+
+    usage.Record({"t1", "sub-1", "api_calls", 1, T0});
+
+    for (int i = 0; i < 200 && usage.GetStats().flushed_batches == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(usage.GetStats().flushed_batches, 1u);
+}
+
+TEST_F(UsageAggregatorTest, FailedFlushIsRetriedInOrder) {
+    UsageAggregator usage(sink.Make(), Options());
+
+    sink.fail = true;
+    usage.Record({"t1", "sub-1", "api_calls", 1, T0});
+    EXPECT_FALSE(usage.Flush());
+    usage.Record({"t1", "sub-1", "api_calls", 2, T0});
+    EXPECT_FALSE(usage.Flush());
+
+    auto stats = usage.GetStats();
+    EXPECT_EQ(stats.pending_batches, 2u);
+    EXPECT_EQ(stats.failed_flushes, 2u);
+    EXPECT_EQ(CountSegments(wal_dir), 3u);  // Two pending + current
+
+    sink.fail = false;
+    EXPECT_TRUE(usage.Flush());
+
+    ASSERT_EQ(sink.batches.size(), 2u);
+    EXPECT_LT(sink.batches[0].first, sink.batches[1].first);
+    EXPECT_EQ(sink.batches[0].second[0].quantity, 1);
+    EXPECT_EQ(sink.batches[1].second[0].quantity, 2);
+    EXPECT_EQ(CountSegments(wal_dir), 1u);
+}
+
+TEST_F(UsageAggregatorTest, RecoversUnflushedUsageFromWal) {
+    {
+        UsageAggregator usage(sink.Make(), Options());
+        sink.fail = true;  // Simulate a crash: nothing reaches the database
+        usage.Record({"t1", "sub-1", "api_calls", 5, T0});
+        usage.Record({"t1", "sub-1", "api_calls", 7, T0 + 10});
+        usage.Record({"t1", "sub-2", "api_calls", 1, T0 + 70});
+    }
+    EXPECT_TRUE(sink.batches.empty());
+
+    sink.fail = false;
+    UsageAggregator recovered(sink.Make(), Options());
+    EXPECT_EQ(recovered.GetStats().pending_batches, 1u);
+    ASSERT_TRUE(recovered.Flush());
+
+    auto totals = sink.Totals();
+    EXPECT_EQ((totals[{"sub-1", "api_calls", T0}]), 12);
+    EXPECT_EQ((totals[{"sub-2", "api_calls", T0 + 60}]), 1);
+    EXPECT_EQ(CountSegments(wal_dir), 1u);
+}
+
+TEST_F(UsageAggregatorTest, ReplayOfAppliedSegmentIsIdempotent) {
+    // Segment whose batch was committed right before a crash (file not yet removed)
+    std::string id = "usage-0000000000001-000000-00000000000000aa";
+    {
+        std::ofstream out(wal_dir + "/" + id + ".wal");
+        out << "t1\tsub-1\tapi_calls\t" << T0 << "\t3\n";
+    }
+    sink.applied.insert(id);
+
+    UsageAggregator usage(sink.Make(), Options());
+    ASSERT_TRUE(usage.Flush());
+
+    EXPECT_TRUE(sink.batches.empty());
+    EXPECT_EQ(CountSegments(wal_dir), 1u);  // Replayed segment removed, current remains
+}
+
+TEST_F(UsageAggregatorTest, RecoverySkipsTornLines) {
+    {
+        std::ofstream out(wal_dir + "/usage-0000000000001-000000-00000000000000bb.wal");
+        out << "t1\tsub-1\tapi_calls\t" << T0 << "\t3\n";
+        out << "garbage\n";
+        out << "t1\tsub-1\tapi_calls\t" << T0 << "\t4";  // No newline: torn append
+    }
+
+    UsageAggregator usage(sink.Make(), Options());
+    ASSERT_TRUE(usage.Flush());
+
+    EXPECT_EQ((sink.Totals()[{"sub-1", "api_calls", T0}]), 3);
+}
+
+TEST_F(UsageAggregatorTest, ConcurrentRecordsAreAllCounted) {
+    auto options = Options();
+    options.flush_interval = std::chrono::milliseconds(5);
+    auto usage = std::make_unique<UsageAggregator>(sink.Make(), options);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 250; ++i) {
+                usage->Record({"t1", "sub-1", "api_calls", 1, T0});
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    usage->Shutdown();
+
+    EXPECT_EQ((sink.Totals()[{"sub-1", "api_calls", T0}]), 2000);
+    EXPECT_EQ(usage->GetStats().recorded, 2000u);
+    EXPECT_EQ(CountSegments(wal_dir), 0u);
+}
+
+TEST_F(UsageAggregatorTest, ShutdownFlushes) {
+    UsageAggregator usage(sink.Make(), Options(false));
+    usage.Record({"t1", "sub-1", "api_calls", 1, T0});
+
+    usage.Shutdown();
+    usage.Shutdown();
+
+    EXPECT_EQ(sink.batches.size(), 1u);
+}
+
+TEST(UsageAggregatorStaticTest, MinuteOf) {
+    EXPECT_EQ(UsageAggregator::MinuteOf(T0 + 59), T0);
+    EXPECT_EQ(UsageAggregator::MinuteOf(T0 + 60), T0 + 60);
+    EXPECT_GT(UsageAggregator::MinuteOf(0), T0);
+    EXPECT_EQ(UsageAggregator::MinuteOf(0) % 60, 0);
+}
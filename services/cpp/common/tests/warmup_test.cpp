@@ -0,0 +1,128 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for startup warm-up and health gating
+ */
+
+#include <gtest/gtest.h>
+#include "common/warmup.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+using namespace saasforge::common;
+
+namespace {
+
+/// Records the statuses Warmup sets
+class FakeHealth : public grpc::HealthCheckServiceInterface {
+public:
+    void SetServingStatus(const std::string& service_name, bool serving) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statuses_[service_name] = serving;
+    }
+    void SetServingStatus(bool serving) override { SetServingStatus("", serving); }
+
+    std::optional<bool> Status(const std::string& service_name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = statuses_.find(service_name);
+        return it == statuses_.end() ? std::nullopt : std::optional<bool>(it->second);
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, bool> statuses_;
+};
+
+WarmupOptions FastOptions() {
+    WarmupOptions options;
+    options.timeout = std::chrono::seconds(2);
+    options.retry = std::chrono::milliseconds(10);
+    return options;
+}
+
+} // namespace
+
+TEST(WarmupTest, ServesOnceRequiredStepsSucceed) {
+    FakeHealth health;
+    Warmup warmup(FastOptions());
+    std::atomic<int> attempts{0};
+    warmup.Add("database", [&] {
+        EXPECT_EQ(health.Status(""), false);
+        EXPECT_EQ(health.Status(Warmup::LIVENESS_SERVICE), true);
+        if (++attempts < 3) {
+            throw std::runtime_error("connection refused");
+        }
+    }, true);
+
+    EXPECT_TRUE(warmup.Run(&health));
+    EXPECT_EQ(attempts.load(), 3);
+    EXPECT_EQ(health.Status(""), true);
+}
+
+TEST(WarmupTest, RequiredStepFailingPastTheTimeoutKeepsNotServing) {
+    FakeHealth health;
+    WarmupOptions options = FastOptions();
+    options.timeout = std::chrono::seconds(1);
+    options.retry = std::chrono::milliseconds(100);
+    Warmup warmup(options);
+    std::atomic<int> attempts{0};
+    warmup.Add("redis", [&] {
+        ++attempts;
+        throw std::runtime_error("connection refused");
+    }, true);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(warmup.Run(&health));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_GT(attempts.load(), 1);
+    EXPECT_EQ(health.Status(""), false);
+    EXPECT_EQ(health.Status(Warmup::LIVENESS_SERVICE), true);
+}
+
+TEST(WarmupTest, OptionalStepsRunOnceAndDoNotBlockServing) {
+    FakeHealth health;
+    Warmup warmup(FastOptions());
+    std::atomic<int> attempts{0};
+    warmup.Add("cache", [&] {
+        ++attempts;
+        throw std::runtime_error("not loaded");
+    });
+
+    EXPECT_TRUE(warmup.Run(&health));
+    EXPECT_EQ(attempts.load(), 1);
+    EXPECT_EQ(health.Status(""), true);
+}
+
+TEST(WarmupTest, StepsRunConcurrently) {
+    // Each step waits for the other; run one after the other they would time out
+    std::mutex mutex;
+    std::condition_variable cv;
+    int arrived = 0;
+    auto rendezvous = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++arrived;
+        cv.notify_all();
+        if (!cv.wait_for(lock, std::chrono::seconds(1), [&] { return arrived == 2; })) {
+            throw std::runtime_error("ran alone");
+        }
+    };
+
+    Warmup warmup(FastOptions());
+    warmup.Add("database", rendezvous);
+    warmup.Add("redis", rendezvous);
+    FakeHealth health;
+    EXPECT_TRUE(warmup.Run(&health));
+    EXPECT_EQ(arrived, 2);
+}
+
+TEST(WarmupTest, RunsWithoutAHealthService) {
+    Warmup warmup(FastOptions());
+    bool ran = false;
+    warmup.Add("step", [&] { ran = true; }, true);
+    EXPECT_TRUE(warmup.Run(nullptr));
+    EXPECT_TRUE(ran);
+}
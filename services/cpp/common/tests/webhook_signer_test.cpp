@@ -179,6 +179,102 @@ TEST_F(WebhookSignerTest, KnownTestVector) {
     EXPECT_EQ(signature, expected);
 }
 
+// Test cached signing key matches the one-shot signature
+TEST_F(WebhookSignerTest, SigningKeyMatchesOneShot) {
+    WebhookSigningKey key(test_secret);
+
+    EXPECT_EQ(key.Sign(test_payload), WebhookSigner::SignPayload(test_payload, test_secret));
+    EXPECT_EQ(WebhookSigningKey("secret").Sign("Hello, World!"),
+              "fcfaffa7fef86515c7beb6b62d779fa4ccf092f2e61c164376054271252821ff");
+}
+
+// Test signing key is reusable (keyed state is not consumed)
+TEST_F(WebhookSignerTest, SigningKeyIsReusable) {
+    WebhookSigningKey key(test_secret);
+
+    std::string first = key.Sign(test_payload);
+    key.Sign("something else");
+    EXPECT_EQ(key.Sign(test_payload), first);
+}
+
+// Test chunked signing equals signing the concatenation
+TEST_F(WebhookSignerTest, ChunkedSigningMatchesContiguous) {
+    WebhookSigningKey key(test_secret);
+    std::string_view payload(test_payload);
+
+    std::vector<std::string_view> chunks = {
+        payload.substr(0, 7), payload.substr(7, 20), payload.substr(27)
+    };
+
+    EXPECT_EQ(key.Sign(chunks), key.Sign(payload));
+    EXPECT_EQ(key.Sign(std::vector<std::string_view>{}), key.Sign(""));
+}
+
+// Test empty secret still produces a valid HMAC
+TEST_F(WebhookSignerTest, SigningKeyEmptySecret) {
+    WebhookSigningKey key("");
+
+    EXPECT_EQ(key.Sign(test_payload), WebhookSigner::SignPayload(test_payload, ""));
+}
+
+// Test signing key cache returns the same key per webhook
+TEST_F(WebhookSignerTest, SigningKeyCacheReusesKey) {
+    auto first = WebhookSigner::GetSigningKey("tenant-cache", "webhook-1", test_secret);
+    auto second = WebhookSigner::GetSigningKey("tenant-cache", "webhook-1", test_secret);
+    auto other = WebhookSigner::GetSigningKey("tenant-cache", "webhook-2", test_secret);
+
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_NE(first.get(), other.get());
+    EXPECT_EQ(first->Sign(test_payload), WebhookSigner::SignPayload(test_payload, test_secret));
+}
+
+// Test rotated secret replaces the cached key
+TEST_F(WebhookSignerTest, SigningKeyCacheHandlesRotation) {
+    auto old_key = WebhookSigner::GetSigningKey("tenant-rotate", "webhook-1", "old_secret");
+    auto new_key = WebhookSigner::GetSigningKey("tenant-rotate", "webhook-1", "new_secret");
+
+    EXPECT_NE(old_key.get(), new_key.get());
+    EXPECT_EQ(new_key->Sign(test_payload), WebhookSigner::SignPayload(test_payload, "new_secret"));
+    EXPECT_EQ(WebhookSigner::GetSigningKey("tenant-rotate", "webhook-1", "new_secret").get(), new_key.get());
+}
+
+// Test invalidation drops the cached key
+TEST_F(WebhookSignerTest, SigningKeyInvalidate) {
+    auto key = WebhookSigner::GetSigningKey("tenant-invalidate", "webhook-1", test_secret);
+    size_t cached = WebhookSigner::CachedKeyCount();
+
+    WebhookSigner::InvalidateSigningKey("tenant-invalidate", "webhook-1");
+
+    EXPECT_EQ(WebhookSigner::CachedKeyCount(), cached - 1);
+    EXPECT_NE(WebhookSigner::GetSigningKey("tenant-invalidate", "webhook-1", test_secret).get(), key.get());
+}
+
+// Test cache key does not collide when IDs are concatenated differently
+TEST_F(WebhookSignerTest, SigningKeyCacheKeyIsUnambiguous) {
+    auto a = WebhookSigner::GetSigningKey("ab", "c", "secret_a");
+    auto b = WebhookSigner::GetSigningKey("a", "bc", "secret_b");
+
+    EXPECT_NE(a.get(), b.get());
+    EXPECT_TRUE(a->Matches("secret_a"));
+    EXPECT_TRUE(b->Matches("secret_b"));
+}
+
+// Test hex encoding covers every byte value
+TEST_F(WebhookSignerTest, ToHexAllBytes) {
+    unsigned char bytes[256];
+    for (int i = 0; i < 256; ++i) {
+        bytes[i] = static_cast<unsigned char>(i);
+    }
+
+    std::string hex = WebhookSigner::ToHex(bytes, sizeof(bytes));
+
+    ASSERT_EQ(hex.size(), 512u);
+    EXPECT_EQ(hex.substr(0, 6), "000102");
+    EXPECT_EQ(hex.substr(20, 4), "0a0b");
+    EXPECT_EQ(hex.substr(506), "fdfeff");
+    EXPECT_EQ(WebhookSigner::ToHex(bytes, 0), "");
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,187 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the webhook subscription index
+ */
+
+#include <gtest/gtest.h>
+#include "common/webhook_subscriptions.h"
+#include <atomic>
+#include <thread>
+
+using namespace saasforge::common;
+
+class WebhookSubscriptionIndexTest : public ::testing::Test {
+protected:
+    std::atomic<int> loads{0};
+    std::vector<WebhookSubscription> rows = {
+        {"wh-1", "https://a.example.com/hook", {"subscription.created", "invoice.paid"}},
+        {"wh-2", "https://b.example.com/hook", {"subscription.created"}},
+    };
+
+    WebhookSubscriptionIndex::Loader Loader() {
+        return [this](const std::string& tenant_id) {
+            ++loads;
+            return tenant_id == "tenant-1" ? rows : std::vector<WebhookSubscription>{};
+        };
+    }
+
+    static std::vector<std::string> Ids(const std::vector<WebhookSubscription>& subscribers) {
+        std::vector<std::string> ids;
+        for (const auto& s : subscribers) {
+            ids.push_back(s.webhook_id);
+        }
+        return ids;
+    }
+};
+
+TEST_F(WebhookSubscriptionIndexTest, ResolvesSubscribersByEventType) {
+    WebhookSubscriptionIndex index(Loader());
+
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "subscription.created")),
+              (std::vector<std::string>{"wh-1", "wh-2"}));
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "invoice.paid")), std::vector<std::string>{"wh-1"});
+    EXPECT_TRUE(index.Subscribers("tenant-1", "user.deleted").empty());
+    EXPECT_TRUE(index.Subscribers("tenant-2", "subscription.created").empty());
+}
+
+TEST_F(WebhookSubscriptionIndexTest, LoadsTenantOnce) {
+    WebhookSubscriptionIndex index(Loader());
+
+    index.Subscribers("tenant-1", "subscription.created");
+    index.Subscribers("tenant-1", "invoice.paid");
+    index.Subscribers("tenant-1", "user.deleted");
+
+    EXPECT_EQ(loads.load(), 1);
+    EXPECT_EQ(index.TenantCount(), 1u);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, ReloadsAfterTtl) {
+    WebhookSubscriptionOptions options;
+    options.ttl = std::chrono::seconds(0);
+    WebhookSubscriptionIndex index(Loader(), options);
+
+    index.Subscribers("tenant-1", "subscription.created");
+    index.Subscribers("tenant-1", "subscription.created");
+
+    EXPECT_EQ(loads.load(), 2);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, AddUpdatesCachedTenant) {
+    WebhookSubscriptionIndex index(Loader());
+    index.Subscribers("tenant-1", "subscription.created");
+
+    index.Add("tenant-1", {"wh-3", "https://c.example.com/hook", {"subscription.created", "user.deleted"}});
+
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "subscription.created")),
+              (std::vector<std::string>{"wh-1", "wh-2", "wh-3"}));
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "user.deleted")), std::vector<std::string>{"wh-3"});
+    EXPECT_EQ(loads.load(), 1);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, AddReplacesExistingWebhook) {
+    WebhookSubscriptionIndex index(Loader());
+    index.Subscribers("tenant-1", "subscription.created");
+
+    index.Add("tenant-1", {"wh-1", "https://a.example.com/hook", {"user.deleted"}});
+
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "subscription.created")), std::vector<std::string>{"wh-2"});
+    EXPECT_TRUE(index.Subscribers("tenant-1", "invoice.paid").empty());
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "user.deleted")), std::vector<std::string>{"wh-1"});
+}
+
+TEST_F(WebhookSubscriptionIndexTest, AddForUncachedTenantIsDeferredToLoad) {
+    WebhookSubscriptionIndex index(Loader());
+
+    index.Add("tenant-2", {"wh-9", "https://z.example.com/hook", {"subscription.created"}});
+
+    EXPECT_EQ(index.TenantCount(), 0u);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, RemoveDropsWebhook) {
+    WebhookSubscriptionIndex index(Loader());
+    index.Subscribers("tenant-1", "subscription.created");
+
+    index.Remove("tenant-1", "wh-1");
+
+    EXPECT_EQ(Ids(index.Subscribers("tenant-1", "subscription.created")), std::vector<std::string>{"wh-2"});
+    EXPECT_TRUE(index.Subscribers("tenant-1", "invoice.paid").empty());
+}
+
+TEST_F(WebhookSubscriptionIndexTest, InvalidateForcesReload) {
+    WebhookSubscriptionIndex index(Loader());
+    index.Subscribers("tenant-1", "subscription.created");
+
+    index.InvalidateTenant("tenant-1");
+    index.Subscribers("tenant-1", "subscription.created");
+
+    EXPECT_EQ(loads.load(), 2);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, LoadRacingAMutationIsNotCached) {
+    WebhookSubscriptionIndex* index_ptr = nullptr;
+    WebhookSubscriptionIndex index([&](const std::string& tenant_id) {
+        ++loads;
+        if (loads == 1) {
+            // A webhook registered while the first load is in flight
+            index_ptr->Add("tenant-1", {"wh-3", "https://c.example.com/hook", {"subscription.created"}});
+        }
+        return rows;
+    });
+    index_ptr = &index;
+
+    index.Subscribers("tenant-1", "subscription.created");
+    EXPECT_EQ(index.TenantCount(), 0u);
+
+    index.Subscribers("tenant-1", "subscription.created");
+    EXPECT_EQ(loads.load(), 2);
+    EXPECT_EQ(index.TenantCount(), 1u);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, TenantCountIsBounded) {
+    WebhookSubscriptionOptions options;
+    options.max_tenants = 2;
+    WebhookSubscriptionIndex index(Loader(), options);
+
+    index.Subscribers("tenant-1", "x");
+    index.Subscribers("tenant-2", "x");
+    index.Subscribers("tenant-3", "x");
+
+    EXPECT_EQ(index.TenantCount(), 2u);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, LoaderErrorPropagates) {
+    WebhookSubscriptionIndex index([](const std::string&) -> std::vector<WebhookSubscription> {
+        throw std::runtime_error("db down");
+    });
+
+    EXPECT_THROW(index.Subscribers("tenant-1", "x"), std::runtime_error);
+    EXPECT_EQ(index.TenantCount(), 0u);
+}
+
+TEST_F(WebhookSubscriptionIndexTest, ConcurrentReadersAndWriters) {
+    WebhookSubscriptionIndex index(Loader());
+    std::atomic<bool> stop{false};
+
+    std::thread writer([&] {
+        for (int i = 0; i < 200; ++i) {
+            index.Add("tenant-1", {"wh-x", "https://x.example.com/hook", {"subscription.created"}});
+            index.Remove("tenant-1", "wh-x");
+        }
+        stop = true;
+    });
+
+    while (!stop) {
+        auto subscribers = index.Subscribers("tenant-1", "subscription.created");
+        EXPECT_GE(subscribers.size(), 2u);
+    }
+    writer.join();
+}
+
+TEST(WebhookSubscriptionParseTest, ParseEvents) {
+    EXPECT_EQ(WebhookSubscriptionIndex::ParseEvents("user.created,payment.succeeded"),
+              (std::vector<std::string>{"user.created", "payment.succeeded"}));
+    EXPECT_EQ(WebhookSubscriptionIndex::ParseEvents(" a , b,,a ,"),
+              (std::vector<std::string>{"a", "b"}));
+    EXPECT_TRUE(WebhookSubscriptionIndex::ParseEvents("").empty());
+}
@@ -0,0 +1,57 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Regression verdicts: a load report against a stored baseline report
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace loadgen {
+
+/**
+ * How far a run may fall behind its baseline
+ *
+ * A latency percentile regresses when it grows by more than `latency`
+ * (fraction) and by more than `min_latency_delta_ms`, so sub-millisecond
+ * RPCs do not flap on scheduler noise.
+ */
+struct BaselineTolerance {
+    double latency = 0.25;              // p50 / p99 / p99.9 growth
+    double min_latency_delta_ms = 1.0;
+    double throughput = 0.10;           // Drop in completed calls per second
+    double error_rate = 0.005;          // Absolute rise
+};
+
+/// One metric of one scenario's RPC
+struct BaselineCheck {
+    std::string scenario;
+    std::string rpc;
+    std::string metric;     // "p50", "p99", "p99.9", "rate", "error_rate", or "missing" (RPC not run)
+    double baseline = 0.0;
+    double current = 0.0;
+    bool passed = true;
+};
+
+/**
+ * Compare a report with a baseline, both ReportJson() documents
+ *
+ * Every scenario and RPC of the baseline is checked; RPCs the baseline
+ * does not have are new and not judged.
+ *
+ * @throws std::invalid_argument if a document is not a report
+ */
+std::vector<BaselineCheck> CompareToBaseline(const std::string& report_json, const std::string& baseline_json,
+                                             const BaselineTolerance& tolerance = {});
+
+bool BaselinePassed(const std::vector<BaselineCheck>& checks);
+
+/// Table of every check, regressions marked
+void PrintBaselineChecks(std::ostream& out, const std::vector<BaselineCheck>& checks);
+
+} // namespace loadgen
+} // namespace saasforge
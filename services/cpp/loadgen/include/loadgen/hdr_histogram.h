@@ -0,0 +1,106 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description High dynamic range latency histogram (HdrHistogram layout)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace saasforge {
+namespace loadgen {
+
+/**
+ * Fixed-precision histogram over [1, highest_trackable]
+ *
+ * Same bucket layout as HdrHistogram: every recorded value is kept to
+ * `significant_digits` decimal digits, whatever its magnitude, in a
+ * fixed array sized once (about 50k counters for 1us..1h at 3 digits),
+ * so Record() is a few shifts and an increment.
+ *
+ * Not thread-safe: each load generator worker records into its own and
+ * they are merged (Add) for the report.
+ */
+class HdrHistogram {
+public:
+    /**
+     * @param highest_trackable Larger values are recorded as this value
+     * @param significant_digits Decimal precision kept, 1-5
+     * @throws std::invalid_argument on an out-of-range configuration
+     */
+    explicit HdrHistogram(int64_t highest_trackable = 3600LL * 1000 * 1000, int significant_digits = 3);
+
+    /// Record a value (values below 1 count as 1)
+    void Record(int64_t value, int64_t count = 1);
+
+    /// Add another histogram's counts; `other` must have the same configuration
+    void Add(const HdrHistogram& other);
+
+    void Reset();
+
+    int64_t TotalCount() const { return total_count_; }
+    int64_t Min() const;
+    int64_t Max() const;
+    double Mean() const;
+    double StdDeviation() const;
+
+    /// Values recorded above highest_trackable (clamped)
+    int64_t Saturated() const { return saturated_; }
+
+    /**
+     * Smallest value that `percentile` percent of recorded values are at or below
+     *
+     * @param percentile 0-100
+     * @return Highest value equivalent to it at the histogram's precision; 0 if empty
+     */
+    int64_t ValueAtPercentile(double percentile) const;
+
+    /// Values at or below `value`
+    int64_t CountAtOrBelow(int64_t value) const;
+
+    /**
+     * Write the percentile distribution in HdrHistogram's .hgrm text format
+     * (plottable with the HdrHistogram plotter)
+     *
+     * @param scale Recorded values are divided by this (1000: microseconds as milliseconds)
+     * @param ticks_per_half_distance Rows per halving of the distance to 100%
+     */
+    void WritePercentiles(std::ostream& out, double scale = 1.0, int ticks_per_half_distance = 5) const;
+
+    bool SameLayout(const HdrHistogram& other) const;
+
+    /// Bytes held by the counters
+    size_t MemoryBytes() const { return counts_.size() * sizeof(int64_t); }
+
+private:
+    size_t CountsIndexFor(int64_t value) const;
+    int64_t ValueAtIndex(size_t index) const;
+    int64_t ValueAtCount(int64_t count) const;
+    int64_t SizeOfEquivalentRange(int64_t value) const;
+    int64_t LowestEquivalent(int64_t value) const;
+    int64_t HighestEquivalent(int64_t value) const;
+    int64_t MedianEquivalent(int64_t value) const;
+    int BucketIndex(int64_t value) const;
+
+    int64_t highest_trackable_;
+    int significant_digits_;
+    int unit_magnitude_ = 0;                 // lowest discernible value is 1
+    int sub_bucket_half_count_magnitude_;
+    int64_t sub_bucket_count_;
+    int64_t sub_bucket_half_count_;
+    int64_t sub_bucket_mask_;
+    int bucket_count_;
+
+    std::vector<int64_t> counts_;
+    int64_t total_count_ = 0;
+    int64_t saturated_ = 0;
+    int64_t min_ = INT64_MAX;
+    int64_t max_ = 0;
+};
+
+} // namespace loadgen
+} // namespace saasforge
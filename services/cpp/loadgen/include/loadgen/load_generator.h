@@ -0,0 +1,88 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Open-loop multi-channel gRPC load generator
+ */
+
+#pragma once
+
+#include "loadgen/hdr_histogram.h"
+#include "loadgen/rpc_catalog.h"
+#include "loadgen/scenario.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace loadgen {
+
+/// Latencies in microseconds, from each arrival's due time to its completion
+struct RpcResult {
+    std::string rpc;
+    HdrHistogram latency;
+    int64_t ok = 0;
+    std::map<int, int64_t> errors;   // grpc::StatusCode -> calls
+
+    int64_t Calls() const;
+    double ErrorRate() const;
+};
+
+struct ThresholdResult {
+    std::string rpc;                 // "*" for all of the scenario's RPCs
+    std::string expression;
+    double value = 0.0;
+    bool passed = false;
+};
+
+struct ScenarioResult {
+    std::string name;
+    double seconds = 0.0;            // Scheduled length (excluding start_time)
+    uint64_t scheduled = 0;
+    uint64_t sent = 0;
+    uint64_t dropped = 0;            // Over max_in_flight: the target could not keep up
+    HdrHistogram send_lag;           // Microseconds the senders issued calls after their due time
+    std::vector<RpcResult> rpcs;     // In Scenario::rpcs order
+    std::vector<ThresholdResult> thresholds;
+
+    bool Passed() const;
+};
+
+/**
+ * Runs every scenario of a plan concurrently, each from its start_time
+ *
+ * A scenario has `channels` workers. Each owns a Connection, a completion
+ * queue, a sender thread and a poller thread: the sender takes every
+ * channels-th arrival of the scenario's ArrivalSchedule, sleeps until it
+ * is due and starts the call without waiting for earlier ones; the poller
+ * records completions into the worker's own histograms, merged when the
+ * run ends. A call's latency counts from its due time, so a sender that
+ * falls behind shows up as latency (and as send_lag) instead of quietly
+ * lowering the offered rate. Arrivals that would exceed max_in_flight are
+ * not sent and are reported as dropped.
+ *
+ * Usage:
+ *   auto plan = LoadPlan::FromFile("tests/load/grpc/auth.json");
+ *   auto credentials = grpc::InsecureChannelCredentials();
+ *   LoadGenerator generator(plan, credentials);
+ *   auto results = generator.Run(RpcCatalog::Setup(plan, Connection(plan.targets, credentials)));
+ */
+class LoadGenerator {
+public:
+    /// @throws std::invalid_argument if a scenario uses an RPC without a catalog entry or target
+    LoadGenerator(LoadPlan plan, std::shared_ptr<grpc::ChannelCredentials> credentials);
+
+    /// Blocks until every scenario has finished and its calls have completed or timed out
+    std::vector<ScenarioResult> Run(const Session& session);
+
+private:
+    LoadPlan plan_;
+    std::shared_ptr<grpc::ChannelCredentials> credentials_;
+};
+
+/// Check a scenario's thresholds against its merged results
+std::vector<ThresholdResult> EvaluateThresholds(const Scenario& scenario, const ScenarioResult& result);
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,32 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Load generator result reports (console, JSON, .hgrm)
+ */
+
+#pragma once
+
+#include "loadgen/load_generator.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace loadgen {
+
+/// Per-RPC table (calls, errors, rate, latency percentiles in ms) and threshold outcomes
+void PrintReport(std::ostream& out, const std::string& plan_name, const std::vector<ScenarioResult>& results);
+
+/// Machine-readable summary, one object per scenario and RPC
+std::string ReportJson(const std::string& plan_name, const std::vector<ScenarioResult>& results);
+
+/**
+ * Write each RPC's latency distribution as `<dir>/<scenario>.<rpc>.hgrm`
+ * (milliseconds; load several into the HdrHistogram plotter to compare runs)
+ *
+ * @throws std::runtime_error if a file cannot be written
+ */
+void WriteHistograms(const std::string& dir, const std::vector<ScenarioResult>& results);
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,138 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description RPCs the load generator can drive, on the generated async stubs
+ */
+
+#pragma once
+
+#include "loadgen/scenario.h"
+#include "auth.grpc.pb.h"
+#include "payment.grpc.pb.h"
+#include "upload.grpc.pb.h"
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/async_unary_call.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace loadgen {
+
+using Clock = std::chrono::steady_clock;
+
+/// Identity the setup phase establishes; sent on every call
+struct Session {
+    std::string access_token;
+    std::string refresh_token;
+    std::string user_id;
+    std::string tenant_id;
+    std::string subscription_id;    // For payment.GetSubscription / RecordUsage
+    std::string api_key;            // For auth.ValidateApiKey
+    std::string run_id;             // Prefix of idempotency keys and generated names
+};
+
+/**
+ * One channel per targeted service
+ *
+ * Each Connection uses its own subchannel pool, so N connections are N
+ * TCP connections (N HTTP/2 streams limits) rather than N handles on one.
+ */
+class Connection {
+public:
+    Connection(const std::map<std::string, std::string>& targets,
+               const std::shared_ptr<grpc::ChannelCredentials>& credentials);
+
+    /// Wait for every channel to connect; false if one did not by `deadline`
+    bool Connect(std::chrono::system_clock::time_point deadline) const;
+
+    /// @throws std::invalid_argument if the plan has no target for the service
+    auth::AuthService::Stub& Auth() const;
+    payment::PaymentService::Stub& Payment() const;
+    upload::UploadService::Stub& Upload() const;
+
+private:
+    std::vector<std::shared_ptr<grpc::Channel>> channels_;
+    std::unique_ptr<auth::AuthService::Stub> auth_;
+    std::unique_ptr<payment::PaymentService::Stub> payment_;
+    std::unique_ptr<upload::UploadService::Stub> upload_;
+};
+
+/// An RPC in flight; owned by the completion queue it was started on (its tag)
+class PendingCall {
+public:
+    virtual ~PendingCall() = default;
+
+    grpc::ClientContext context;
+    grpc::Status status;
+    size_t rpc = 0;             // Index into the scenario's RPCs
+    Clock::time_point due;      // When the arrival was scheduled (latency is measured from here)
+};
+
+/// What a request is built from
+struct CallInput {
+    const Session& session;
+    const TestUser* user;                               // Cycles through the plan's users; may be null
+    uint64_t sequence;                                  // Arrival number within the scenario
+    const std::map<std::string, std::string>& params;   // RpcWeight::params
+};
+
+/**
+ * Driveable RPCs, "<service>.<Method>":
+ *
+ *   auth.Login                    users (cycled)
+ *   auth.ValidateToken            session access token
+ *   auth.CreateApiKey             params: scopes (comma-separated, default read,write)
+ *   auth.ValidateApiKey           params: api_key (default: created during setup),
+ *                                 scope (requested scope, default read)
+ *   payment.AddPaymentMethod      params: payment_method (default pm_card_visa)
+ *   payment.CreateSubscription    params: plan_id (default pro), payment_method
+ *   payment.GetSubscription       params: subscription_id (default: created during setup)
+ *   payment.RecordUsage           params: metric_name (default api_calls), quantity,
+ *                                 subscription_id
+ *   upload.GeneratePresignedUrl   params: content_type (default image/jpeg),
+ *                                 max_bytes (default 10 MB; size varies per arrival)
+ *   upload.GetQuota
+ *
+ * Calls carry `authorization: Bearer <token>` and the x-tenant-id /
+ * x-user-id gateway headers from the session.
+ */
+class RpcCatalog {
+public:
+    /// Service an RPC belongs to ("auth"), or empty if the catalog has no such RPC
+    static std::string ServiceOf(const std::string& rpc);
+
+    static std::vector<std::string> Names();
+
+    /// Whether the RPC needs Session::api_key when `params` does not give one
+    static bool NeedsApiKey(const std::string& rpc, const std::map<std::string, std::string>& params);
+
+    /// Whether the RPC needs Session::subscription_id when `params` does not give one
+    static bool NeedsSubscription(const std::string& rpc, const std::map<std::string, std::string>& params);
+
+    /**
+     * Start `rpc` asynchronously on `cq`
+     *
+     * On completion `cq` returns the call as its tag; the caller deletes it.
+     *
+     * @param index Stored as PendingCall::rpc
+     * @throws std::invalid_argument for RPCs the catalog does not know or
+     *         services the connection has no target for
+     */
+    static PendingCall* Start(const std::string& rpc, size_t index, const Connection& connection,
+                              const CallInput& input, Clock::time_point due, Duration timeout,
+                              grpc::CompletionQueue* cq);
+
+    /**
+     * Log in (first user) and, if a scenario needs them, create an API key
+     * and a subscription
+     *
+     * @throws std::runtime_error if a setup call fails
+     */
+    static Session Setup(const LoadPlan& plan, const Connection& connection);
+};
+
+} // namespace loadgen
+} // namespace saasforge
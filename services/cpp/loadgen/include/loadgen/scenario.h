@@ -0,0 +1,153 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Load generator scenario files and open-loop arrival schedules
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace loadgen {
+
+using Duration = std::chrono::nanoseconds;
+
+/**
+ * Parse a k6-style duration: "500ms", "30s", "2m", "1h", "1m30s"
+ *
+ * @throws std::invalid_argument on anything else
+ */
+Duration ParseDuration(const std::string& text);
+
+/// Arrival rate ramps linearly to `target` (per second) over `duration`
+struct Stage {
+    Duration duration{};
+    double target = 0.0;
+};
+
+/// RPC picked for a share of a scenario's arrivals
+struct RpcWeight {
+    std::string rpc;                            // "<service>.<Method>", e.g. "auth.Login"
+    uint32_t weight = 1;
+    std::map<std::string, std::string> params;  // Request fields (see rpc_catalog.h)
+};
+
+/**
+ * Pass/fail criterion, k6 syntax: "p(95)<500" (milliseconds), "error_rate<0.01",
+ * "rate>900" (completed calls per second)
+ */
+struct Threshold {
+    enum class Metric { PERCENTILE, ERROR_RATE, RATE };
+
+    std::string expression;
+    Metric metric = Metric::PERCENTILE;
+    double percentile = 0.0;
+    bool less_than = true;
+    double bound = 0.0;
+
+    /// @throws std::invalid_argument if `expression` is not one of the forms above
+    static Threshold Parse(const std::string& expression);
+
+    bool Passes(double value) const { return less_than ? value < bound : value > bound; }
+};
+
+/**
+ * One open-loop arrival process, the counterpart of a k6
+ * constant-arrival-rate / ramping-arrival-rate scenario
+ */
+struct Scenario {
+    std::string name;
+    Duration start_time{};          // Offset from the start of the run
+    double start_rate = 0.0;        // Arrivals per second when the first stage begins
+    std::vector<Stage> stages;      // "rate" + "duration" is a single flat stage
+    std::vector<RpcWeight> rpcs;
+    size_t channels = 4;            // Independent HTTP/2 connections, one sender and poller each
+    size_t max_in_flight = 10000;   // Per scenario; arrivals past it are dropped and counted
+    Duration timeout = std::chrono::seconds(10);
+
+    /// Per RPC ("auth.Login") or "*" for all of the scenario's RPCs
+    std::map<std::string, std::vector<Threshold>> thresholds;
+
+    Duration TotalDuration() const;
+};
+
+/// Account the setup phase logs in with, and Login arrivals cycle through
+struct TestUser {
+    std::string email;
+    std::string password;
+};
+
+/**
+ * A scenario file (JSON, see tests/load/grpc)
+ *
+ * {
+ *   "name": "auth",
+ *   "targets": {"auth": "localhost:50051"},
+ *   "users": [{"email": "loadtest1@example.com", "password": "LoadTest123!"}],
+ *   "scenarios": [{
+ *     "name": "login_rate", "rate": 200, "duration": "2m", "channels": 8,
+ *     "rpcs": [{"rpc": "auth.Login", "weight": 1}],
+ *     "thresholds": {"auth.Login": ["p(95)<500", "error_rate<0.01"]}
+ *   }]
+ * }
+ *
+ * A scenario has either "rate" and "duration", or "start_rate" and k6
+ * "stages" ([{"duration": "1m", "target": 500}]).
+ */
+struct LoadPlan {
+    std::string name;
+    std::map<std::string, std::string> targets;  // Service ("auth", "payment", "upload") -> host:port
+    std::vector<TestUser> users;
+    std::vector<Scenario> scenarios;
+
+    /// @throws std::invalid_argument with the offending field on a malformed plan
+    static LoadPlan Parse(const std::string& json);
+    static LoadPlan FromFile(const std::string& path);
+
+    /// Multiply every arrival rate (`--rate-scale`, to step towards saturation)
+    void ScaleRates(double factor);
+};
+
+/**
+ * When each arrival of a scenario is due
+ *
+ * The rate is piecewise linear over the stages, so the number of arrivals
+ * by time t is the integral of the rate; arrival n is due when it reaches
+ * n. Times depend only on n, so several senders can split one schedule
+ * (sender k of N takes n = k, k + N, ...) without coordinating, and a
+ * sender that falls behind does not push later arrivals back: latency is
+ * measured from the due time, which keeps slow responses from hiding
+ * behind the requests they delayed (coordinated omission).
+ */
+class ArrivalSchedule {
+public:
+    ArrivalSchedule(double start_rate, std::vector<Stage> stages);
+
+    /// Offset of arrival `n` (0-based) from the schedule start; nullopt past the last stage
+    std::optional<Duration> DueTime(uint64_t n) const;
+
+    /// Arrivals in the whole schedule
+    uint64_t TotalArrivals() const { return total_arrivals_; }
+
+private:
+    struct Segment {
+        double start_seconds;
+        double seconds;
+        double from_rate;
+        double to_rate;
+        double arrivals_before;   // Cumulative at segment start
+        double arrivals;
+    };
+
+    std::vector<Segment> segments_;
+    uint64_t total_arrivals_ = 0;
+};
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,150 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Regression verdicts: a load report against a stored baseline report implementation
+ */
+
+#include "loadgen/baseline.h"
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+
+#ifndef PICOJSON_USE_INT64
+#define PICOJSON_USE_INT64
+#endif
+#include <picojson/picojson.h>
+
+namespace saasforge {
+namespace loadgen {
+
+namespace {
+
+constexpr const char* LATENCY_METRICS[] = {"p50", "p99", "p99.9"};
+
+const picojson::value& Field(const picojson::value& value, const char* name) {
+    static const picojson::value null;
+    if (!value.is<picojson::object>()) {
+        return null;
+    }
+    const auto& object = value.get<picojson::object>();
+    auto it = object.find(name);
+    return it == object.end() ? null : it->second;
+}
+
+double Number(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<double>() ? field.get<double>() : 0.0;
+}
+
+/// "<scenario>/<rpc>" -> the RPC's report entry
+std::map<std::string, const picojson::value*> Entries(const picojson::value& report, const char* which) {
+    const auto& scenarios = Field(report, "scenarios");
+    if (!scenarios.is<picojson::array>()) {
+        throw std::invalid_argument(std::string(which) + " is not a load report (no scenarios)");
+    }
+    std::map<std::string, const picojson::value*> entries;
+    for (const auto& scenario : scenarios.get<picojson::array>()) {
+        const auto& name = Field(scenario, "name");
+        const auto& rpcs = Field(scenario, "rpcs");
+        if (!name.is<std::string>() || !rpcs.is<picojson::array>()) {
+            throw std::invalid_argument(std::string(which) + " has a scenario without name or rpcs");
+        }
+        for (const auto& rpc : rpcs.get<picojson::array>()) {
+            const auto& rpc_name = Field(rpc, "rpc");
+            if (rpc_name.is<std::string>()) {
+                entries[name.get<std::string>() + "/" + rpc_name.get<std::string>()] = &rpc;
+            }
+        }
+    }
+    return entries;
+}
+
+picojson::value Parse(const std::string& json, const char* which) {
+    picojson::value value;
+    std::string error = picojson::parse(value, json);
+    if (!error.empty()) {
+        throw std::invalid_argument(std::string(which) + " is not JSON: " + error);
+    }
+    return value;
+}
+
+} // namespace
+
+std::vector<BaselineCheck> CompareToBaseline(const std::string& report_json, const std::string& baseline_json,
+                                             const BaselineTolerance& tolerance) {
+    auto report = Parse(report_json, "report");
+    auto baseline = Parse(baseline_json, "baseline");
+    auto current = Entries(report, "report");
+
+    std::vector<BaselineCheck> checks;
+    for (const auto& [key, expected] : Entries(baseline, "baseline")) {
+        size_t slash = key.find('/');
+        BaselineCheck check;
+        check.scenario = key.substr(0, slash);
+        check.rpc = key.substr(slash + 1);
+
+        auto it = current.find(key);
+        if (it == current.end()) {
+            check.metric = "missing";
+            check.passed = false;
+            checks.push_back(check);
+            continue;
+        }
+        const picojson::value& actual = *it->second;
+
+        for (const char* metric : LATENCY_METRICS) {
+            check.metric = metric;
+            check.baseline = Number(Field(*expected, "latency_ms"), metric);
+            check.current = Number(Field(actual, "latency_ms"), metric);
+            check.passed = check.current <= check.baseline * (1.0 + tolerance.latency) ||
+                           check.current - check.baseline <= tolerance.min_latency_delta_ms;
+            checks.push_back(check);
+        }
+
+        check.metric = "rate";
+        check.baseline = Number(*expected, "rate");
+        check.current = Number(actual, "rate");
+        check.passed = check.current >= check.baseline * (1.0 - tolerance.throughput);
+        checks.push_back(check);
+
+        check.metric = "error_rate";
+        check.baseline = Number(*expected, "error_rate");
+        check.current = Number(actual, "error_rate");
+        check.passed = check.current <= check.baseline + tolerance.error_rate;
+        checks.push_back(check);
+    }
+    return checks;
+}
+
+bool BaselinePassed(const std::vector<BaselineCheck>& checks) {
+    for (const auto& check : checks) {
+        if (!check.passed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PrintBaselineChecks(std::ostream& out, const std::vector<BaselineCheck>& checks) {
+    char line[256];
+    out << "\nBaseline comparison (latency ms, rate calls/s)\n";
+    std::snprintf(line, sizeof(line), "  %-20s %-30s %-10s %12s %12s %9s\n", "scenario", "RPC", "metric", "baseline",
+                  "current", "change");
+    out << line;
+    for (const auto& check : checks) {
+        if (check.metric == "missing") {
+            std::snprintf(line, sizeof(line), "  %-20s %-30s not run  REGRESSION\n", check.scenario.c_str(),
+                          check.rpc.c_str());
+        } else {
+            double change = check.baseline > 0 ? (check.current / check.baseline - 1.0) * 100.0 : 0.0;
+            std::snprintf(line, sizeof(line), "  %-20s %-30s %-10s %12.3f %12.3f %+8.1f%%%s\n",
+                          check.scenario.c_str(), check.rpc.c_str(), check.metric.c_str(), check.baseline,
+                          check.current, change, check.passed ? "" : "  REGRESSION");
+        }
+        out << line;
+    }
+    out << (BaselinePassed(checks) ? "  PASS no regression\n" : "  FAIL regression against baseline\n");
+}
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,255 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description High dynamic range latency histogram implementation
+ */
+
+#include "loadgen/hdr_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace saasforge {
+namespace loadgen {
+
+namespace {
+
+int Log2Floor(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+} // namespace
+
+HdrHistogram::HdrHistogram(int64_t highest_trackable, int significant_digits)
+    : highest_trackable_(highest_trackable), significant_digits_(significant_digits) {
+    if (significant_digits < 1 || significant_digits > 5) {
+        throw std::invalid_argument("HdrHistogram significant digits must be 1-5");
+    }
+    if (highest_trackable < 2) {
+        throw std::invalid_argument("HdrHistogram highest trackable value must be at least 2");
+    }
+
+    // Values below this are kept at single-unit resolution; every power of
+    // two above it halves the resolution, keeping `significant_digits`
+    int64_t largest_single_unit = 2;
+    for (int i = 0; i < significant_digits; ++i) {
+        largest_single_unit *= 10;
+    }
+    int sub_bucket_count_magnitude = Log2Floor(static_cast<uint64_t>(largest_single_unit - 1)) + 1;
+    sub_bucket_half_count_magnitude_ = std::max(sub_bucket_count_magnitude, 1) - 1;
+    sub_bucket_count_ = int64_t{1} << (sub_bucket_half_count_magnitude_ + 1);
+    sub_bucket_half_count_ = sub_bucket_count_ / 2;
+    sub_bucket_mask_ = (sub_bucket_count_ - 1) << unit_magnitude_;
+
+    int64_t smallest_untrackable = sub_bucket_count_ << unit_magnitude_;
+    bucket_count_ = 1;
+    while (smallest_untrackable <= highest_trackable) {
+        if (smallest_untrackable > INT64_MAX / 2) {
+            ++bucket_count_;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        ++bucket_count_;
+    }
+    counts_.assign(static_cast<size_t>((bucket_count_ + 1) * sub_bucket_half_count_), 0);
+}
+
+int HdrHistogram::BucketIndex(int64_t value) const {
+    int pow2_ceiling = 64 - __builtin_clzll(static_cast<uint64_t>(value | sub_bucket_mask_));
+    return pow2_ceiling - unit_magnitude_ - (sub_bucket_half_count_magnitude_ + 1);
+}
+
+size_t HdrHistogram::CountsIndexFor(int64_t value) const {
+    int bucket = BucketIndex(value);
+    int64_t sub_bucket = value >> (bucket + unit_magnitude_);
+    int64_t bucket_base = static_cast<int64_t>(bucket + 1) << sub_bucket_half_count_magnitude_;
+    return static_cast<size_t>(bucket_base + (sub_bucket - sub_bucket_half_count_));
+}
+
+int64_t HdrHistogram::ValueAtIndex(size_t index) const {
+    int bucket = static_cast<int>(index >> sub_bucket_half_count_magnitude_) - 1;
+    int64_t sub_bucket = static_cast<int64_t>(index & static_cast<size_t>(sub_bucket_half_count_ - 1))
+        + sub_bucket_half_count_;
+    if (bucket < 0) {
+        sub_bucket -= sub_bucket_half_count_;
+        bucket = 0;
+    }
+    return sub_bucket << (bucket + unit_magnitude_);
+}
+
+int64_t HdrHistogram::SizeOfEquivalentRange(int64_t value) const {
+    int bucket = BucketIndex(value);
+    int64_t sub_bucket = value >> (bucket + unit_magnitude_);
+    int adjusted = sub_bucket >= sub_bucket_count_ ? bucket + 1 : bucket;
+    return int64_t{1} << (unit_magnitude_ + adjusted);
+}
+
+int64_t HdrHistogram::LowestEquivalent(int64_t value) const {
+    int bucket = BucketIndex(value);
+    int64_t sub_bucket = value >> (bucket + unit_magnitude_);
+    return sub_bucket << (bucket + unit_magnitude_);
+}
+
+int64_t HdrHistogram::HighestEquivalent(int64_t value) const {
+    return LowestEquivalent(value) + SizeOfEquivalentRange(value) - 1;
+}
+
+int64_t HdrHistogram::MedianEquivalent(int64_t value) const {
+    return LowestEquivalent(value) + SizeOfEquivalentRange(value) / 2;
+}
+
+void HdrHistogram::Record(int64_t value, int64_t count) {
+    if (count <= 0) {
+        return;
+    }
+    if (value < 1) {
+        value = 1;
+    }
+    if (value > highest_trackable_) {
+        value = highest_trackable_;
+        saturated_ += count;
+    }
+    counts_[CountsIndexFor(value)] += count;
+    total_count_ += count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+bool HdrHistogram::SameLayout(const HdrHistogram& other) const {
+    return highest_trackable_ == other.highest_trackable_ && significant_digits_ == other.significant_digits_;
+}
+
+void HdrHistogram::Add(const HdrHistogram& other) {
+    if (!SameLayout(other)) {
+        throw std::invalid_argument("HdrHistogram::Add needs histograms of the same configuration");
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    saturated_ += other.saturated_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void HdrHistogram::Reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    total_count_ = 0;
+    saturated_ = 0;
+    min_ = INT64_MAX;
+    max_ = 0;
+}
+
+int64_t HdrHistogram::Min() const {
+    return total_count_ == 0 ? 0 : LowestEquivalent(min_);
+}
+
+int64_t HdrHistogram::Max() const {
+    return total_count_ == 0 ? 0 : HighestEquivalent(max_);
+}
+
+double HdrHistogram::Mean() const {
+    if (total_count_ == 0) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] != 0) {
+            sum += static_cast<double>(counts_[i]) * static_cast<double>(MedianEquivalent(ValueAtIndex(i)));
+        }
+    }
+    return sum / static_cast<double>(total_count_);
+}
+
+double HdrHistogram::StdDeviation() const {
+    if (total_count_ == 0) {
+        return 0.0;
+    }
+    double mean = Mean();
+    double squares = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] != 0) {
+            double deviation = static_cast<double>(MedianEquivalent(ValueAtIndex(i))) - mean;
+            squares += deviation * deviation * static_cast<double>(counts_[i]);
+        }
+    }
+    return std::sqrt(squares / static_cast<double>(total_count_));
+}
+
+int64_t HdrHistogram::ValueAtPercentile(double percentile) const {
+    if (total_count_ == 0) {
+        return 0;
+    }
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    return ValueAtCount(static_cast<int64_t>(percentile / 100.0 * static_cast<double>(total_count_) + 0.5));
+}
+
+int64_t HdrHistogram::ValueAtCount(int64_t count_at) const {
+    count_at = std::max<int64_t>(count_at, 1);
+    int64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= count_at) {
+            return HighestEquivalent(ValueAtIndex(i));
+        }
+    }
+    return Max();
+}
+
+int64_t HdrHistogram::CountAtOrBelow(int64_t value) const {
+    if (value < 1) {
+        return 0;
+    }
+    size_t last = CountsIndexFor(std::min(value, highest_trackable_));
+    int64_t count = 0;
+    for (size_t i = 0; i <= last && i < counts_.size(); ++i) {
+        count += counts_[i];
+    }
+    return count;
+}
+
+void HdrHistogram::WritePercentiles(std::ostream& out, double scale, int ticks_per_half_distance) const {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    out << line;
+
+    if (total_count_ > 0) {
+        // Reporting steps halve with each halving of the distance to 100%, as
+        // HdrHistogram does; every row covers at least one more value
+        int64_t target = 1;
+        while (true) {
+            int64_t value = ValueAtCount(target);
+            int64_t count = CountAtOrBelow(value);
+            double reached = static_cast<double>(count) / static_cast<double>(total_count_);
+            if (count >= total_count_) {
+                std::snprintf(line, sizeof(line), "%12.3f %1.12f %10lld\n",
+                              static_cast<double>(value) / scale, 1.0, static_cast<long long>(count));
+                out << line;
+                break;
+            }
+            std::snprintf(line, sizeof(line), "%12.3f %1.12f %10lld %14.2f\n",
+                          static_cast<double>(value) / scale, reached,
+                          static_cast<long long>(count), 1.0 / (1.0 - reached));
+            out << line;
+
+            double halvings = std::floor(std::log2(1.0 / (1.0 - reached))) + 1.0;
+            double step = 1.0 / (static_cast<double>(ticks_per_half_distance) * std::pow(2.0, halvings));
+            target = std::max(count + 1,
+                              static_cast<int64_t>(std::ceil((reached + step) * static_cast<double>(total_count_))));
+        }
+    }
+
+    std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n",
+                  Mean() / scale, StdDeviation() / scale);
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Max     = %12.3f, Total count    = %12lld]\n",
+                  static_cast<double>(Max()) / scale, static_cast<long long>(total_count_));
+    out << line;
+    std::snprintf(line, sizeof(line), "#[Buckets = %12d, SubBuckets     = %12lld]\n",
+                  bucket_count_, static_cast<long long>(sub_bucket_count_));
+    out << line;
+}
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,314 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Open-loop multi-channel gRPC load generator implementation
+ */
+
+#include "loadgen/load_generator.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace saasforge {
+namespace loadgen {
+
+namespace {
+
+int64_t Microseconds(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+uint64_t Mix(uint64_t x) {
+    // splitmix64 finalizer: picks the RPC of arrival n independent of which worker sends it
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/// Scheduling and in-flight accounting shared by a scenario's workers
+struct ScenarioRun {
+    explicit ScenarioRun(const Scenario& spec)
+        : scenario(spec), schedule(spec.start_rate, spec.stages) {
+        uint64_t total = 0;
+        for (const auto& rpc : spec.rpcs) {
+            total += rpc.weight;
+            cumulative_weights.push_back(total);
+        }
+    }
+
+    void StartAt(Clock::time_point run_start) {
+        start = run_start + std::chrono::duration_cast<Clock::duration>(scenario.start_time);
+    }
+
+    size_t PickRpc(uint64_t n) const {
+        uint64_t point = Mix(n) % cumulative_weights.back();
+        return static_cast<size_t>(std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), point) -
+                                   cumulative_weights.begin());
+    }
+
+    const Scenario& scenario;
+    ArrivalSchedule schedule;
+    Clock::time_point start;
+    std::vector<uint64_t> cumulative_weights;
+    std::atomic<size_t> in_flight{0};
+};
+
+class Worker {
+public:
+    Worker(ScenarioRun& run, size_t index, const Session& session, const LoadPlan& plan,
+           const std::shared_ptr<grpc::ChannelCredentials>& credentials)
+        : run_(run), index_(index), session_(session), plan_(plan),
+          connection_(plan.targets, credentials), latency_(run.scenario.rpcs.size()),
+          ok_(run.scenario.rpcs.size(), 0), errors_(run.scenario.rpcs.size()),
+          start_failures_(run.scenario.rpcs.size(), 0) {}
+
+    bool Connect(std::chrono::system_clock::time_point deadline) const {
+        return connection_.Connect(deadline);
+    }
+
+    void Start() {
+        poller_ = std::thread(&Worker::PollLoop, this);
+        sender_ = std::thread(&Worker::SendLoop, this);
+    }
+
+    void Join() {
+        sender_.join();
+        poller_.join();
+    }
+
+    void MergeInto(ScenarioResult& result) const {
+        for (size_t i = 0; i < latency_.size(); ++i) {
+            result.rpcs[i].latency.Add(latency_[i]);
+            result.rpcs[i].ok += ok_[i];
+            for (const auto& [code, count] : errors_[i]) {
+                result.rpcs[i].errors[code] += count;
+            }
+            if (start_failures_[i] > 0) {
+                result.rpcs[i].errors[grpc::StatusCode::INVALID_ARGUMENT] += start_failures_[i];
+            }
+        }
+        result.send_lag.Add(send_lag_);
+        result.sent += sent_;
+        result.dropped += dropped_;
+    }
+
+private:
+    void SendLoop() {
+        const auto& scenario = run_.scenario;
+        const size_t stride = scenario.channels;
+
+        for (uint64_t n = index_;; n += stride) {
+            auto offset = run_.schedule.DueTime(n);
+            if (!offset) {
+                break;
+            }
+            auto due = run_.start + std::chrono::duration_cast<Clock::duration>(*offset);
+            std::this_thread::sleep_until(due);
+
+            if (run_.in_flight.fetch_add(1) >= scenario.max_in_flight) {
+                run_.in_flight.fetch_sub(1);
+                ++dropped_;
+                continue;
+            }
+
+            size_t rpc = run_.PickRpc(n);
+            const TestUser* user = plan_.users.empty() ? nullptr : &plan_.users[n % plan_.users.size()];
+            CallInput input{session_, user, n, scenario.rpcs[rpc].params};
+
+            send_lag_.Record(Microseconds(Clock::now() - due));
+            outstanding_.fetch_add(1);
+            try {
+                RpcCatalog::Start(scenario.rpcs[rpc].rpc, rpc, connection_, input, due, scenario.timeout, &cq_);
+                ++sent_;
+            } catch (const std::exception& e) {
+                // A request that cannot be built (bad params): counted, never sent
+                if (start_failures_[rpc]++ == 0) {
+                    std::cerr << scenario.name << " " << scenario.rpcs[rpc].rpc << ": " << e.what() << std::endl;
+                }
+                run_.in_flight.fetch_sub(1);
+                Release();
+            }
+        }
+
+        // The sender's own reference: whoever drops the count to zero shuts the queue down
+        Release();
+    }
+
+    void PollLoop() {
+        void* tag = nullptr;
+        bool ok = false;
+        while (cq_.Next(&tag, &ok)) {
+            std::unique_ptr<PendingCall> call(static_cast<PendingCall*>(tag));
+            latency_[call->rpc].Record(Microseconds(Clock::now() - call->due));
+            if (call->status.ok()) {
+                ++ok_[call->rpc];
+            } else {
+                ++errors_[call->rpc][static_cast<int>(call->status.error_code())];
+            }
+            run_.in_flight.fetch_sub(1);
+            call.reset();
+            Release();
+        }
+    }
+
+    void Release() {
+        if (outstanding_.fetch_sub(1) == 1) {
+            cq_.Shutdown();
+        }
+    }
+
+    ScenarioRun& run_;
+    size_t index_;
+    const Session& session_;
+    const LoadPlan& plan_;
+    Connection connection_;
+    grpc::CompletionQueue cq_;
+    std::atomic<int64_t> outstanding_{1};   // Calls in flight plus the sender
+
+    // Written by the poller only
+    std::vector<HdrHistogram> latency_;
+    std::vector<int64_t> ok_;
+    std::vector<std::map<int, int64_t>> errors_;
+
+    // Written by the sender only
+    std::vector<int64_t> start_failures_;
+    HdrHistogram send_lag_;
+    uint64_t sent_ = 0;
+    uint64_t dropped_ = 0;
+
+    std::thread sender_;
+    std::thread poller_;
+};
+
+double Percentile(const HdrHistogram& histogram, double percentile) {
+    return static_cast<double>(histogram.ValueAtPercentile(percentile)) / 1000.0;
+}
+
+} // namespace
+
+int64_t RpcResult::Calls() const {
+    int64_t calls = ok;
+    for (const auto& [code, count] : errors) {
+        calls += count;
+    }
+    return calls;
+}
+
+double RpcResult::ErrorRate() const {
+    int64_t calls = Calls();
+    return calls == 0 ? 0.0 : static_cast<double>(calls - ok) / static_cast<double>(calls);
+}
+
+bool ScenarioResult::Passed() const {
+    return std::all_of(thresholds.begin(), thresholds.end(), [](const ThresholdResult& t) { return t.passed; });
+}
+
+std::vector<ThresholdResult> EvaluateThresholds(const Scenario& scenario, const ScenarioResult& result) {
+    std::vector<ThresholdResult> outcomes;
+    for (const auto& [rpc, thresholds] : scenario.thresholds) {
+        RpcResult merged;
+        merged.rpc = rpc;
+        for (const auto& rpc_result : result.rpcs) {
+            if (rpc == "*" || rpc_result.rpc == rpc) {
+                merged.latency.Add(rpc_result.latency);
+                merged.ok += rpc_result.ok;
+                for (const auto& [code, count] : rpc_result.errors) {
+                    merged.errors[code] += count;
+                }
+            }
+        }
+
+        for (const auto& threshold : thresholds) {
+            ThresholdResult outcome;
+            outcome.rpc = rpc;
+            outcome.expression = threshold.expression;
+            switch (threshold.metric) {
+                case Threshold::Metric::PERCENTILE:
+                    outcome.value = Percentile(merged.latency, threshold.percentile);
+                    break;
+                case Threshold::Metric::ERROR_RATE:
+                    outcome.value = merged.ErrorRate();
+                    break;
+                case Threshold::Metric::RATE:
+                    outcome.value = result.seconds > 0 ? static_cast<double>(merged.ok) / result.seconds : 0.0;
+                    break;
+            }
+            // Nothing completed: a latency or rate bound cannot have been met
+            outcome.passed = merged.Calls() > 0 && threshold.Passes(outcome.value);
+            outcomes.push_back(std::move(outcome));
+        }
+    }
+    return outcomes;
+}
+
+LoadGenerator::LoadGenerator(LoadPlan plan, std::shared_ptr<grpc::ChannelCredentials> credentials)
+    : plan_(std::move(plan)), credentials_(std::move(credentials)) {
+    for (const auto& scenario : plan_.scenarios) {
+        for (const auto& rpc : scenario.rpcs) {
+            std::string service = RpcCatalog::ServiceOf(rpc.rpc);
+            if (service.empty()) {
+                throw std::invalid_argument("scenario " + scenario.name + ": unknown RPC " + rpc.rpc);
+            }
+            if (!plan_.targets.count(service)) {
+                throw std::invalid_argument("scenario " + scenario.name + ": no target for service " + service);
+            }
+        }
+    }
+}
+
+std::vector<ScenarioResult> LoadGenerator::Run(const Session& session) {
+    std::vector<std::unique_ptr<ScenarioRun>> runs;
+    std::vector<std::vector<std::unique_ptr<Worker>>> workers;
+    for (const auto& scenario : plan_.scenarios) {
+        runs.push_back(std::make_unique<ScenarioRun>(scenario));
+        auto& scenario_workers = workers.emplace_back();
+        for (size_t i = 0; i < scenario.channels; ++i) {
+            scenario_workers.push_back(std::make_unique<Worker>(*runs.back(), i, session, plan_, credentials_));
+        }
+    }
+
+    // Channels connect before the clock starts, so connection setup is not measured
+    auto connect_deadline = std::chrono::system_clock::now() + std::chrono::seconds(10);
+    size_t unconnected = 0;
+    for (auto& scenario_workers : workers) {
+        for (auto& worker : scenario_workers) {
+            unconnected += worker->Connect(connect_deadline) ? 0 : 1;
+        }
+    }
+    if (unconnected > 0) {
+        std::cerr << unconnected << " connection(s) not ready after 10s; their calls will fail" << std::endl;
+    }
+
+    auto run_start = Clock::now() + std::chrono::milliseconds(100);
+    for (size_t s = 0; s < runs.size(); ++s) {
+        runs[s]->StartAt(run_start);
+        for (auto& worker : workers[s]) {
+            worker->Start();
+        }
+    }
+
+    std::vector<ScenarioResult> results;
+    for (size_t s = 0; s < plan_.scenarios.size(); ++s) {
+        const auto& scenario = plan_.scenarios[s];
+        ScenarioResult result;
+        result.name = scenario.name;
+        result.seconds = std::chrono::duration<double>(scenario.TotalDuration() - scenario.start_time).count();
+        result.scheduled = runs[s]->schedule.TotalArrivals();
+        for (const auto& rpc : scenario.rpcs) {
+            result.rpcs.push_back(RpcResult{rpc.rpc, HdrHistogram(), 0, {}});
+        }
+        for (auto& worker : workers[s]) {
+            worker->Join();
+            worker->MergeInto(result);
+        }
+        result.thresholds = EvaluateThresholds(scenario, result);
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,158 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description saasforge_loadgen: open-loop gRPC load against the C++ services
+ */
+
+#include "loadgen/baseline.h"
+#include "loadgen/load_generator.h"
+#include "loadgen/report.h"
+#include "common/env.h"
+#include "common/mtls_credentials.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+
+using namespace saasforge::loadgen;
+
+namespace {
+
+constexpr int EXIT_THRESHOLDS_FAILED = 99;  // As k6
+constexpr int EXIT_BASELINE_REGRESSION = 98;
+
+void Usage(const char* program) {
+    std::cerr
+        << "Usage: " << program << " <scenario.json> [options]\n"
+        << "  --target SERVICE=HOST:PORT  Override a target (auth, payment, upload)\n"
+        << "  --rate-scale X              Multiply every arrival rate (e.g. 1.5 to step past saturation)\n"
+        << "  --channels N                Connections per scenario\n"
+        << "  --out FILE                  Write the JSON report\n"
+        << "  --hgrm-dir DIR              Write per-RPC latency distributions (.hgrm)\n"
+        << "  --baseline FILE             Compare with a stored --out report; exit 98 on regression\n"
+        << "  --latency-tolerance X       p50/p99/p99.9 growth allowed against the baseline (default 0.25)\n"
+        << "  --throughput-tolerance X    Throughput drop allowed against the baseline (default 0.10)\n"
+        << "  --ca-cert FILE --cert FILE --key FILE   mTLS (default: LOADGEN_CA_CERT,\n"
+        << "                              LOADGEN_CLIENT_CERT, LOADGEN_CLIENT_KEY; else insecure)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        Usage(argv[0]);
+        return 2;
+    }
+
+    std::string scenario_path = argv[1];
+    std::map<std::string, std::string> targets;
+    double rate_scale = 1.0;
+    size_t channels = 0;
+    std::string out_path;
+    std::string hgrm_dir;
+    std::string baseline_path;
+    BaselineTolerance tolerance;
+    std::string ca_cert = saasforge::common::EnvString("LOADGEN_CA_CERT");
+    std::string client_cert = saasforge::common::EnvString("LOADGEN_CLIENT_CERT");
+    std::string client_key = saasforge::common::EnvString("LOADGEN_CLIENT_KEY");
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+            if (arg == "--target") {
+                std::string target = value();
+                size_t eq = target.find('=');
+                if (eq == std::string::npos) {
+                    throw std::invalid_argument("--target expects SERVICE=HOST:PORT");
+                }
+                targets[target.substr(0, eq)] = target.substr(eq + 1);
+            } else if (arg == "--rate-scale") {
+                rate_scale = std::stod(value());
+            } else if (arg == "--channels") {
+                channels = static_cast<size_t>(std::stoul(value()));
+            } else if (arg == "--out") {
+                out_path = value();
+            } else if (arg == "--hgrm-dir") {
+                hgrm_dir = value();
+            } else if (arg == "--baseline") {
+                baseline_path = value();
+            } else if (arg == "--latency-tolerance") {
+                tolerance.latency = std::stod(value());
+            } else if (arg == "--throughput-tolerance") {
+                tolerance.throughput = std::stod(value());
+            } else if (arg == "--ca-cert") {
+                ca_cert = value();
+            } else if (arg == "--cert") {
+                client_cert = value();
+            } else if (arg == "--key") {
+                client_key = value();
+            } else {
+                Usage(argv[0]);
+                return 2;
+            }
+        }
+
+        auto plan = LoadPlan::FromFile(scenario_path);
+        for (const auto& [service, address] : targets) {
+            plan.targets[service] = address;
+        }
+        if (rate_scale != 1.0) {
+            plan.ScaleRates(rate_scale);
+        }
+        if (channels > 0) {
+            for (auto& scenario : plan.scenarios) {
+                scenario.channels = channels;
+            }
+        }
+
+        auto credentials = ca_cert.empty()
+            ? grpc::InsecureChannelCredentials()
+            : saasforge::common::MtlsCredentials::CreateClientCredentials(ca_cert, client_cert, client_key);
+
+        LoadGenerator generator(plan, credentials);
+        auto results = generator.Run(RpcCatalog::Setup(plan, Connection(plan.targets, credentials)));
+
+        PrintReport(std::cout, plan.name, results);
+        std::string report = ReportJson(plan.name, results);
+        if (!out_path.empty()) {
+            std::ofstream out(out_path);
+            if (!out.is_open()) {
+                throw std::runtime_error("Failed to open file: " + out_path);
+            }
+            out << report << "\n";
+        }
+        if (!hgrm_dir.empty()) {
+            WriteHistograms(hgrm_dir, results);
+        }
+
+        bool regressed = false;
+        if (!baseline_path.empty()) {
+            std::ifstream file(baseline_path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open file: " + baseline_path);
+            }
+            std::string baseline((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            auto checks = CompareToBaseline(report, baseline, tolerance);
+            PrintBaselineChecks(std::cout, checks);
+            regressed = !BaselinePassed(checks);
+        }
+
+        for (const auto& result : results) {
+            if (!result.Passed()) {
+                return EXIT_THRESHOLDS_FAILED;
+            }
+        }
+        return regressed ? EXIT_BASELINE_REGRESSION : 0;
+    } catch (const std::exception& e) {
+        std::cerr << "saasforge_loadgen: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Load generator result reports implementation
+ */
+
+#include "loadgen/report.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef PICOJSON_USE_INT64
+#define PICOJSON_USE_INT64
+#endif
+#include <picojson/picojson.h>
+
+namespace saasforge {
+namespace loadgen {
+
+namespace {
+
+constexpr double PERCENTILES[] = {50.0, 90.0, 99.0, 99.9};
+
+double Ms(int64_t microseconds) {
+    return static_cast<double>(microseconds) / 1000.0;
+}
+
+picojson::value Json(double value) {
+    return picojson::value(value);
+}
+
+picojson::value Json(int64_t value) {
+    return picojson::value(value);
+}
+
+std::string ErrorSummary(const RpcResult& rpc) {
+    std::string summary;
+    for (const auto& [code, count] : rpc.errors) {
+        summary += (summary.empty() ? "" : " ") + std::to_string(code) + ":" + std::to_string(count);
+    }
+    return summary;
+}
+
+} // namespace
+
+void PrintReport(std::ostream& out, const std::string& plan_name, const std::vector<ScenarioResult>& results) {
+    char line[256];
+    out << "\n" << plan_name << " - open-loop gRPC load (latency from scheduled arrival, ms)\n";
+
+    for (const auto& result : results) {
+        out << "\nScenario " << result.name << ": " << result.sent << "/" << result.scheduled << " sent";
+        if (result.dropped > 0) {
+            out << ", " << result.dropped << " dropped (max_in_flight reached)";
+        }
+        std::snprintf(line, sizeof(line), ", send lag p99 %.3f ms, max %.3f ms\n",
+                      Ms(result.send_lag.ValueAtPercentile(99.0)), Ms(result.send_lag.Max()));
+        out << line;
+
+        std::snprintf(line, sizeof(line), "  %-30s %9s %7s %9s %9s %9s %9s %9s %9s  %s\n",
+                      "RPC", "calls", "err%", "rate/s", "p50", "p90", "p99", "p99.9", "max", "errors (code:n)");
+        out << line;
+        for (const auto& rpc : result.rpcs) {
+            double rate = result.seconds > 0 ? static_cast<double>(rpc.Calls()) / result.seconds : 0.0;
+            std::snprintf(line, sizeof(line), "  %-30s %9lld %7.2f %9.1f %9.3f %9.3f %9.3f %9.3f %9.3f  %s\n",
+                          rpc.rpc.c_str(), static_cast<long long>(rpc.Calls()), rpc.ErrorRate() * 100.0, rate,
+                          Ms(rpc.latency.ValueAtPercentile(50.0)), Ms(rpc.latency.ValueAtPercentile(90.0)),
+                          Ms(rpc.latency.ValueAtPercentile(99.0)), Ms(rpc.latency.ValueAtPercentile(99.9)),
+                          Ms(rpc.latency.Max()), ErrorSummary(rpc).c_str());
+            out << line;
+        }
+
+        for (const auto& threshold : result.thresholds) {
+            std::snprintf(line, sizeof(line), "  %s %s %s (%.4g)\n", threshold.passed ? "PASS" : "FAIL",
+                          threshold.rpc.c_str(), threshold.expression.c_str(), threshold.value);
+            out << line;
+        }
+    }
+}
+
+std::string ReportJson(const std::string& plan_name, const std::vector<ScenarioResult>& results) {
+    picojson::array scenarios;
+    for (const auto& result : results) {
+        picojson::array rpcs;
+        for (const auto& rpc : result.rpcs) {
+            picojson::object latency;
+            for (double percentile : PERCENTILES) {
+                char key[16];
+                std::snprintf(key, sizeof(key), "p%g", percentile);
+                latency[key] = Json(Ms(rpc.latency.ValueAtPercentile(percentile)));
+            }
+            latency["min"] = Json(Ms(rpc.latency.Min()));
+            latency["mean"] = Json(rpc.latency.Mean() / 1000.0);
+            latency["max"] = Json(Ms(rpc.latency.Max()));
+
+            picojson::object errors;
+            for (const auto& [code, count] : rpc.errors) {
+                errors[std::to_string(code)] = Json(count);
+            }
+
+            picojson::object entry;
+            entry["rpc"] = picojson::value(rpc.rpc);
+            entry["calls"] = Json(rpc.Calls());
+            entry["ok"] = Json(rpc.ok);
+            entry["error_rate"] = Json(rpc.ErrorRate());
+            entry["rate"] = Json(result.seconds > 0 ? static_cast<double>(rpc.Calls()) / result.seconds : 0.0);
+            entry["latency_ms"] = picojson::value(latency);
+            entry["errors"] = picojson::value(errors);
+            rpcs.emplace_back(entry);
+        }
+
+        picojson::array thresholds;
+        for (const auto& threshold : result.thresholds) {
+            picojson::object entry;
+            entry["rpc"] = picojson::value(threshold.rpc);
+            entry["expression"] = picojson::value(threshold.expression);
+            entry["value"] = Json(threshold.value);
+            entry["passed"] = picojson::value(threshold.passed);
+            thresholds.emplace_back(entry);
+        }
+
+        picojson::object scenario;
+        scenario["name"] = picojson::value(result.name);
+        scenario["seconds"] = Json(result.seconds);
+        scenario["scheduled"] = Json(static_cast<int64_t>(result.scheduled));
+        scenario["sent"] = Json(static_cast<int64_t>(result.sent));
+        scenario["dropped"] = Json(static_cast<int64_t>(result.dropped));
+        scenario["send_lag_p99_ms"] = Json(Ms(result.send_lag.ValueAtPercentile(99.0)));
+        scenario["rpcs"] = picojson::value(rpcs);
+        scenario["thresholds"] = picojson::value(thresholds);
+        scenarios.emplace_back(scenario);
+    }
+
+    picojson::object root;
+    root["plan"] = picojson::value(plan_name);
+    root["scenarios"] = picojson::value(scenarios);
+    return picojson::value(root).serialize(true);
+}
+
+void WriteHistograms(const std::string& dir, const std::vector<ScenarioResult>& results) {
+    for (const auto& result : results) {
+        for (const auto& rpc : result.rpcs) {
+            std::string path = dir + "/" + result.name + "." + rpc.rpc + ".hgrm";
+            std::ofstream file(path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open file: " + path);
+            }
+            rpc.latency.WritePercentiles(file, 1000.0);
+        }
+    }
+}
+
+} // namespace loadgen
+} // namespace saasforge
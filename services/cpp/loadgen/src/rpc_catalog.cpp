@@ -0,0 +1,378 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description RPCs the load generator can drive implementation
+ */
+
+#include "loadgen/rpc_catalog.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+
+namespace saasforge {
+namespace loadgen {
+
+namespace {
+
+template <typename Response>
+class AsyncCall final : public PendingCall {
+public:
+    Response response;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+};
+
+struct CallOptions {
+    size_t rpc;
+    Clock::time_point due;
+    Duration timeout;
+    grpc::CompletionQueue* cq;
+};
+
+void AddIdentity(grpc::ClientContext& context, const Session& session) {
+    if (!session.access_token.empty()) {
+        context.AddMetadata("authorization", "Bearer " + session.access_token);
+    }
+    if (!session.tenant_id.empty()) {
+        context.AddMetadata("x-tenant-id", session.tenant_id);
+    }
+    if (!session.user_id.empty()) {
+        context.AddMetadata("x-user-id", session.user_id);
+    }
+}
+
+/// Starts the call `prepare` sets up; the request is serialized by prepare, so it may be a local
+template <typename Response, typename Prepare>
+PendingCall* Begin(const CallOptions& options, const Session& session, Prepare prepare) {
+    auto call = std::make_unique<AsyncCall<Response>>();
+    call->rpc = options.rpc;
+    call->due = options.due;
+    AddIdentity(call->context, session);
+    // A deadline is a wall-clock time for gRPC; the schedule runs on the steady clock
+    call->context.set_deadline(std::chrono::system_clock::now() +
+                               std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                   options.due + options.timeout - Clock::now()));
+
+    call->reader = prepare(&call->context, options.cq);
+    call->reader->StartCall();
+    call->reader->Finish(&call->response, &call->status, call.get());
+    return call.release();
+}
+
+std::string Param(const std::map<std::string, std::string>& params, const std::string& key,
+                  const std::string& default_value) {
+    auto it = params.find(key);
+    return it == params.end() ? default_value : it->second;
+}
+
+int64_t IntParam(const std::map<std::string, std::string>& params, const std::string& key, int64_t default_value) {
+    auto it = params.find(key);
+    if (it == params.end()) {
+        return default_value;
+    }
+    try {
+        return std::stoll(it->second);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("RPC param " + key + " must be an integer, got \"" + it->second + "\"");
+    }
+}
+
+std::string IdempotencyKey(const CallInput& input, const char* kind) {
+    return "loadgen-" + input.session.run_id + "-" + kind + "-" + std::to_string(input.sequence);
+}
+
+std::string SubscriptionId(const CallInput& input) {
+    return Param(input.params, "subscription_id", input.session.subscription_id);
+}
+
+int64_t UnixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+using Starter = PendingCall* (*)(const Connection&, const CallInput&, const CallOptions&);
+
+struct RpcDefinition {
+    const char* name;
+    const char* service;
+    Starter start;
+};
+
+const std::array<RpcDefinition, 10> kRpcs = {{
+    {"auth.Login", "auth", [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        auth::LoginRequest request;
+        if (input.user) {
+            request.set_email(input.user->email);
+            request.set_password(input.user->password);
+        }
+        return Begin<auth::LoginResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Auth().PrepareAsyncLogin(context, request, cq);
+        });
+    }},
+    {"auth.ValidateToken", "auth", [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        auth::ValidateTokenRequest request;
+        request.set_access_token(input.session.access_token);
+        return Begin<auth::ValidateTokenResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Auth().PrepareAsyncValidateToken(context, request, cq);
+        });
+    }},
+    {"auth.CreateApiKey", "auth", [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        auth::CreateApiKeyRequest request;
+        request.set_name("loadgen-key-" + input.session.run_id + "-" + std::to_string(input.sequence));
+        std::string scopes = Param(input.params, "scopes", "read,write");
+        size_t start = 0;
+        while (start <= scopes.size()) {
+            size_t end = std::min(scopes.find(',', start), scopes.size());
+            if (end > start) {
+                request.add_scopes(scopes.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+        return Begin<auth::CreateApiKeyResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Auth().PrepareAsyncCreateApiKey(context, request, cq);
+        });
+    }},
+    {"auth.ValidateApiKey", "auth", [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        auth::ValidateApiKeyRequest request;
+        request.set_api_key(Param(input.params, "api_key", input.session.api_key));
+        request.set_requested_scope(Param(input.params, "scope", "read"));
+        return Begin<auth::ValidateApiKeyResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Auth().PrepareAsyncValidateApiKey(context, request, cq);
+        });
+    }},
+    {"payment.AddPaymentMethod", "payment",
+     [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        payment::AddPaymentMethodRequest request;
+        request.set_tenant_id(input.session.tenant_id);
+        request.set_stripe_payment_method_id(Param(input.params, "payment_method", "pm_card_visa"));
+        request.set_idempotency_key(IdempotencyKey(input, "pm"));
+        return Begin<payment::PaymentMethodResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Payment().PrepareAsyncAddPaymentMethod(context, request, cq);
+        });
+    }},
+    {"payment.CreateSubscription", "payment",
+     [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        payment::CreateSubscriptionRequest request;
+        request.set_tenant_id(input.session.tenant_id);
+        request.set_plan_id(Param(input.params, "plan_id", "pro"));
+        request.set_payment_method_id(Param(input.params, "payment_method", "pm_card_visa"));
+        request.set_quantity(1);
+        request.set_idempotency_key(IdempotencyKey(input, "sub"));
+        return Begin<payment::SubscriptionResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Payment().PrepareAsyncCreateSubscription(context, request, cq);
+        });
+    }},
+    {"payment.GetSubscription", "payment",
+     [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        payment::GetSubscriptionRequest request;
+        request.set_tenant_id(input.session.tenant_id);
+        request.set_subscription_id(SubscriptionId(input));
+        return Begin<payment::SubscriptionResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Payment().PrepareAsyncGetSubscription(context, request, cq);
+        });
+    }},
+    {"payment.RecordUsage", "payment",
+     [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        payment::RecordUsageRequest request;
+        request.set_tenant_id(input.session.tenant_id);
+        request.set_subscription_id(SubscriptionId(input));
+        request.set_metric_name(Param(input.params, "metric_name", "api_calls"));
+        request.set_quantity(IntParam(input.params, "quantity", 1));
+        request.set_timestamp(UnixNow());
+        request.set_idempotency_key(IdempotencyKey(input, "usage"));
+        return Begin<payment::RecordUsageResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Payment().PrepareAsyncRecordUsage(context, request, cq);
+        });
+    }},
+    {"upload.GeneratePresignedUrl", "upload",
+     [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        // Sizes spread over 1 KB..max_bytes like the k6 mixed upload suite
+        int64_t max_bytes = std::max<int64_t>(1024, IntParam(input.params, "max_bytes", 10LL * 1024 * 1024));
+        uint64_t spread = (input.sequence * 0x9E3779B97F4A7C15ULL) >> 32;
+        upload::PresignedUrlRequest request;
+        request.set_tenant_id(input.session.tenant_id);
+        request.set_user_id(input.session.user_id);
+        request.set_filename("loadgen-" + input.session.run_id + "-" + std::to_string(input.sequence) + ".bin");
+        request.set_content_type(Param(input.params, "content_type", "image/jpeg"));
+        request.set_content_length(1024 + static_cast<int64_t>(spread % static_cast<uint64_t>(max_bytes - 1023)));
+        return Begin<upload::PresignedUrlResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Upload().PrepareAsyncGeneratePresignedUrl(context, request, cq);
+        });
+    }},
+    {"upload.GetQuota", "upload", [](const Connection& connection, const CallInput& input, const CallOptions& options) {
+        upload::GetQuotaRequest request;
+        request.set_tenant_id(input.session.tenant_id);
+        return Begin<upload::GetQuotaResponse>(options, input.session, [&](auto* context, auto* cq) {
+            return connection.Upload().PrepareAsyncGetQuota(context, request, cq);
+        });
+    }},
+}};
+
+const RpcDefinition* Find(const std::string& rpc) {
+    for (const auto& definition : kRpcs) {
+        if (rpc == definition.name) {
+            return &definition;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<grpc::Channel> MakeChannel(const std::map<std::string, std::string>& targets, const char* service,
+                                           const std::shared_ptr<grpc::ChannelCredentials>& credentials) {
+    auto it = targets.find(service);
+    if (it == targets.end()) {
+        return nullptr;
+    }
+    grpc::ChannelArguments arguments;
+    arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    return grpc::CreateCustomChannel(it->second, credentials, arguments);
+}
+
+template <typename Stub>
+Stub& Require(const std::unique_ptr<Stub>& stub, const char* service) {
+    if (!stub) {
+        throw std::invalid_argument(std::string("no target for service ") + service);
+    }
+    return *stub;
+}
+
+} // namespace
+
+Connection::Connection(const std::map<std::string, std::string>& targets,
+                       const std::shared_ptr<grpc::ChannelCredentials>& credentials) {
+    if (auto channel = MakeChannel(targets, "auth", credentials)) {
+        auth_ = auth::AuthService::NewStub(channel);
+        channels_.push_back(std::move(channel));
+    }
+    if (auto channel = MakeChannel(targets, "payment", credentials)) {
+        payment_ = payment::PaymentService::NewStub(channel);
+        channels_.push_back(std::move(channel));
+    }
+    if (auto channel = MakeChannel(targets, "upload", credentials)) {
+        upload_ = upload::UploadService::NewStub(channel);
+        channels_.push_back(std::move(channel));
+    }
+}
+
+bool Connection::Connect(std::chrono::system_clock::time_point deadline) const {
+    bool connected = true;
+    for (const auto& channel : channels_) {
+        connected = channel->WaitForConnected(deadline) && connected;
+    }
+    return connected;
+}
+
+auth::AuthService::Stub& Connection::Auth() const {
+    return Require(auth_, "auth");
+}
+
+payment::PaymentService::Stub& Connection::Payment() const {
+    return Require(payment_, "payment");
+}
+
+upload::UploadService::Stub& Connection::Upload() const {
+    return Require(upload_, "upload");
+}
+
+std::string RpcCatalog::ServiceOf(const std::string& rpc) {
+    const auto* definition = Find(rpc);
+    return definition ? definition->service : "";
+}
+
+std::vector<std::string> RpcCatalog::Names() {
+    std::vector<std::string> names;
+    for (const auto& definition : kRpcs) {
+        names.emplace_back(definition.name);
+    }
+    return names;
+}
+
+bool RpcCatalog::NeedsApiKey(const std::string& rpc, const std::map<std::string, std::string>& params) {
+    return rpc == "auth.ValidateApiKey" && !params.count("api_key");
+}
+
+bool RpcCatalog::NeedsSubscription(const std::string& rpc, const std::map<std::string, std::string>& params) {
+    return (rpc == "payment.GetSubscription" || rpc == "payment.RecordUsage") && !params.count("subscription_id");
+}
+
+PendingCall* RpcCatalog::Start(const std::string& rpc, size_t index, const Connection& connection,
+                               const CallInput& input, Clock::time_point due, Duration timeout,
+                               grpc::CompletionQueue* cq) {
+    const auto* definition = Find(rpc);
+    if (!definition) {
+        throw std::invalid_argument("unknown RPC " + rpc);
+    }
+    return definition->start(connection, input, CallOptions{index, due, timeout, cq});
+}
+
+Session RpcCatalog::Setup(const LoadPlan& plan, const Connection& connection) {
+    Session session;
+    char run_id[17];
+    std::snprintf(run_id, sizeof(run_id), "%llx", static_cast<unsigned long long>(
+        std::chrono::system_clock::now().time_since_epoch().count()));
+    session.run_id = run_id;
+
+    auto deadline = [] { return std::chrono::system_clock::now() + std::chrono::seconds(30); };
+
+    if (!plan.users.empty() && plan.targets.count("auth")) {
+        auth::LoginRequest request;
+        request.set_email(plan.users.front().email);
+        request.set_password(plan.users.front().password);
+        auth::LoginResponse response;
+        grpc::ClientContext context;
+        context.set_deadline(deadline());
+        grpc::Status status = connection.Auth().Login(&context, request, &response);
+        if (!status.ok()) {
+            throw std::runtime_error("setup login as " + request.email() + " failed: " + status.error_message());
+        }
+        session.access_token = response.access_token();
+        session.refresh_token = response.refresh_token();
+        session.user_id = response.user_id();
+        session.tenant_id = response.tenant_id();
+    }
+
+    bool needs_subscription = false;
+    bool needs_api_key = false;
+    for (const auto& scenario : plan.scenarios) {
+        for (const auto& rpc : scenario.rpcs) {
+            needs_subscription = needs_subscription || NeedsSubscription(rpc.rpc, rpc.params);
+            needs_api_key = needs_api_key || NeedsApiKey(rpc.rpc, rpc.params);
+        }
+    }
+    if (needs_api_key) {
+        auth::CreateApiKeyRequest request;
+        request.set_name("loadgen-" + session.run_id + "-setup");
+        request.add_scopes("read");
+        request.add_scopes("write");
+        auth::CreateApiKeyResponse response;
+        grpc::ClientContext context;
+        context.set_deadline(deadline());
+        AddIdentity(context, session);
+        grpc::Status status = connection.Auth().CreateApiKey(&context, request, &response);
+        if (!status.ok()) {
+            throw std::runtime_error("setup API key failed: " + status.error_message());
+        }
+        session.api_key = response.api_key();
+    }
+    if (needs_subscription) {
+        payment::CreateSubscriptionRequest request;
+        request.set_tenant_id(session.tenant_id);
+        request.set_plan_id("pro");
+        request.set_payment_method_id("pm_card_visa");
+        request.set_quantity(1);
+        request.set_idempotency_key("loadgen-" + session.run_id + "-setup");
+        payment::SubscriptionResponse response;
+        grpc::ClientContext context;
+        context.set_deadline(deadline());
+        AddIdentity(context, session);
+        grpc::Status status = connection.Payment().CreateSubscription(&context, request, &response);
+        if (!status.ok()) {
+            throw std::runtime_error("setup subscription failed: " + status.error_message());
+        }
+        session.subscription_id = response.id();
+    }
+    return session;
+}
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,364 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Load generator scenario files and open-loop arrival schedules implementation
+ */
+
+#include "loadgen/scenario.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef PICOJSON_USE_INT64
+#define PICOJSON_USE_INT64
+#endif
+#include <picojson/picojson.h>
+
+namespace saasforge {
+namespace loadgen {
+
+namespace {
+
+using Object = picojson::object;
+
+std::string Where(const std::string& context, const std::string& field) {
+    return context.empty() ? field : context + "." + field;
+}
+
+const picojson::value* Find(const Object& object, const std::string& field) {
+    auto it = object.find(field);
+    return it == object.end() || it->second.is<picojson::null>() ? nullptr : &it->second;
+}
+
+std::string String(const Object& object, const std::string& field, const std::string& context,
+                   const std::optional<std::string>& default_value = std::nullopt) {
+    const auto* value = Find(object, field);
+    if (!value) {
+        if (default_value) {
+            return *default_value;
+        }
+        throw std::invalid_argument(Where(context, field) + " is required");
+    }
+    if (!value->is<std::string>()) {
+        throw std::invalid_argument(Where(context, field) + " must be a string");
+    }
+    return value->get<std::string>();
+}
+
+double Number(const Object& object, const std::string& field, const std::string& context,
+              std::optional<double> default_value = std::nullopt) {
+    const auto* value = Find(object, field);
+    if (!value) {
+        if (default_value) {
+            return *default_value;
+        }
+        throw std::invalid_argument(Where(context, field) + " is required");
+    }
+    if (!value->is<double>()) {
+        throw std::invalid_argument(Where(context, field) + " must be a number");
+    }
+    double number = value->get<double>();
+    if (number < 0 || !std::isfinite(number)) {
+        throw std::invalid_argument(Where(context, field) + " must not be negative");
+    }
+    return number;
+}
+
+const Object& ObjectAt(const picojson::value& value, const std::string& context) {
+    if (!value.is<Object>()) {
+        throw std::invalid_argument(context + " must be an object");
+    }
+    return value.get<Object>();
+}
+
+const picojson::array& ArrayAt(const Object& object, const std::string& field, const std::string& context) {
+    const auto* value = Find(object, field);
+    if (!value || !value->is<picojson::array>()) {
+        throw std::invalid_argument(Where(context, field) + " must be an array");
+    }
+    return value->get<picojson::array>();
+}
+
+Duration DurationField(const Object& object, const std::string& field, const std::string& context,
+                       std::optional<Duration> default_value = std::nullopt) {
+    if (!Find(object, field) && default_value) {
+        return *default_value;
+    }
+    try {
+        return ParseDuration(String(object, field, context));
+    } catch (const std::invalid_argument& e) {
+        throw std::invalid_argument(Where(context, field) + ": " + e.what());
+    }
+}
+
+Scenario ParseScenario(const Object& object, const std::string& context) {
+    Scenario scenario;
+    scenario.name = String(object, "name", context);
+    std::string where = "scenarios." + scenario.name;
+
+    scenario.start_time = DurationField(object, "start_time", where, Duration::zero());
+    if (Find(object, "stages")) {
+        scenario.start_rate = Number(object, "start_rate", where, 0.0);
+        const auto& stages = ArrayAt(object, "stages", where);
+        for (size_t i = 0; i < stages.size(); ++i) {
+            std::string stage_where = where + ".stages[" + std::to_string(i) + "]";
+            const auto& stage_object = ObjectAt(stages[i], stage_where);
+            scenario.stages.push_back({DurationField(stage_object, "duration", stage_where),
+                                       Number(stage_object, "target", stage_where)});
+        }
+    } else {
+        double rate = Number(object, "rate", where);
+        scenario.start_rate = rate;
+        scenario.stages.push_back({DurationField(object, "duration", where), rate});
+    }
+    if (scenario.stages.empty()) {
+        throw std::invalid_argument(where + ".stages must not be empty");
+    }
+
+    scenario.channels = static_cast<size_t>(Number(object, "channels", where, static_cast<double>(scenario.channels)));
+    scenario.max_in_flight = static_cast<size_t>(
+        Number(object, "max_in_flight", where, static_cast<double>(scenario.max_in_flight)));
+    scenario.timeout = DurationField(object, "timeout", where, scenario.timeout);
+    if (scenario.channels == 0 || scenario.max_in_flight == 0) {
+        throw std::invalid_argument(where + ": channels and max_in_flight must be positive");
+    }
+
+    const auto& rpcs = ArrayAt(object, "rpcs", where);
+    for (size_t i = 0; i < rpcs.size(); ++i) {
+        std::string rpc_where = where + ".rpcs[" + std::to_string(i) + "]";
+        const auto& rpc_object = ObjectAt(rpcs[i], rpc_where);
+        RpcWeight rpc;
+        rpc.rpc = String(rpc_object, "rpc", rpc_where);
+        rpc.weight = static_cast<uint32_t>(Number(rpc_object, "weight", rpc_where, 1.0));
+        if (const auto* params = Find(rpc_object, "params")) {
+            for (const auto& [key, value] : ObjectAt(*params, rpc_where + ".params")) {
+                rpc.params[key] = value.is<std::string>() ? value.get<std::string>() : value.serialize();
+            }
+        }
+        if (rpc.weight > 0) {
+            scenario.rpcs.push_back(std::move(rpc));
+        }
+    }
+    if (scenario.rpcs.empty()) {
+        throw std::invalid_argument(where + ".rpcs needs at least one RPC with a positive weight");
+    }
+
+    if (const auto* thresholds = Find(object, "thresholds")) {
+        for (const auto& [rpc, expressions] : ObjectAt(*thresholds, where + ".thresholds")) {
+            bool known = rpc == "*" || std::any_of(scenario.rpcs.begin(), scenario.rpcs.end(),
+                                                   [&](const RpcWeight& w) { return w.rpc == rpc; });
+            if (!known || !expressions.is<picojson::array>()) {
+                throw std::invalid_argument(where + ".thresholds." + rpc +
+                                            " must be a list for one of the scenario's RPCs (or \"*\")");
+            }
+            for (const auto& expression : expressions.get<picojson::array>()) {
+                if (!expression.is<std::string>()) {
+                    throw std::invalid_argument(where + ".thresholds." + rpc + " entries must be strings");
+                }
+                scenario.thresholds[rpc].push_back(Threshold::Parse(expression.get<std::string>()));
+            }
+        }
+    }
+    return scenario;
+}
+
+} // namespace
+
+Duration ParseDuration(const std::string& text) {
+    if (text.empty()) {
+        throw std::invalid_argument("empty duration");
+    }
+    double nanoseconds = 0.0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t number_end = pos;
+        while (number_end < text.size() && (std::isdigit(static_cast<unsigned char>(text[number_end])) ||
+                                            text[number_end] == '.')) {
+            ++number_end;
+        }
+        size_t unit_end = number_end;
+        while (unit_end < text.size() && std::isalpha(static_cast<unsigned char>(text[unit_end]))) {
+            ++unit_end;
+        }
+        if (number_end == pos || unit_end == number_end) {
+            throw std::invalid_argument("invalid duration \"" + text + "\" (expected e.g. 500ms, 30s, 2m, 1h)");
+        }
+
+        double value = std::stod(text.substr(pos, number_end - pos));
+        std::string unit = text.substr(number_end, unit_end - number_end);
+        double scale;
+        if (unit == "us") {
+            scale = 1e3;
+        } else if (unit == "ms") {
+            scale = 1e6;
+        } else if (unit == "s") {
+            scale = 1e9;
+        } else if (unit == "m") {
+            scale = 60e9;
+        } else if (unit == "h") {
+            scale = 3600e9;
+        } else {
+            throw std::invalid_argument("unknown duration unit \"" + unit + "\" in \"" + text + "\"");
+        }
+        nanoseconds += value * scale;
+        pos = unit_end;
+    }
+    return Duration(static_cast<Duration::rep>(nanoseconds));
+}
+
+Threshold Threshold::Parse(const std::string& expression) {
+    std::string text;
+    for (char c : expression) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            text += c;
+        }
+    }
+
+    Threshold threshold;
+    threshold.expression = expression;
+    size_t op = text.find_first_of("<>");
+    if (op == std::string::npos || op == 0 || op + 1 >= text.size()) {
+        throw std::invalid_argument("invalid threshold \"" + expression + "\"");
+    }
+    threshold.less_than = text[op] == '<';
+    std::string metric = text.substr(0, op);
+
+    try {
+        size_t used = 0;
+        threshold.bound = std::stod(text.substr(op + 1), &used);
+        if (op + 1 + used != text.size()) {
+            throw std::invalid_argument("trailing characters");
+        }
+        if (metric == "error_rate") {
+            threshold.metric = Metric::ERROR_RATE;
+        } else if (metric == "rate") {
+            threshold.metric = Metric::RATE;
+        } else if (metric.size() > 3 && metric.compare(0, 2, "p(") == 0 && metric.back() == ')') {
+            threshold.metric = Metric::PERCENTILE;
+            threshold.percentile = std::stod(metric.substr(2, metric.size() - 3), &used);
+            if (used != metric.size() - 3 || threshold.percentile < 0 || threshold.percentile > 100) {
+                throw std::invalid_argument("percentile");
+            }
+        } else {
+            throw std::invalid_argument("metric");
+        }
+    } catch (const std::exception&) {
+        throw std::invalid_argument("invalid threshold \"" + expression +
+                                    "\" (expected p(95)<500, error_rate<0.01 or rate>900)");
+    }
+    return threshold;
+}
+
+Duration Scenario::TotalDuration() const {
+    Duration total = start_time;
+    for (const auto& stage : stages) {
+        total += stage.duration;
+    }
+    return total;
+}
+
+LoadPlan LoadPlan::Parse(const std::string& json) {
+    picojson::value root;
+    std::string error = picojson::parse(root, json);
+    if (!error.empty()) {
+        throw std::invalid_argument("scenario file is not valid JSON: " + error);
+    }
+    const auto& object = ObjectAt(root, "scenario file");
+
+    LoadPlan plan;
+    plan.name = String(object, "name", "");
+    if (const auto* targets = Find(object, "targets")) {
+        for (const auto& [service, address] : ObjectAt(*targets, "targets")) {
+            if (!address.is<std::string>()) {
+                throw std::invalid_argument("targets." + service + " must be a string");
+            }
+            plan.targets[service] = address.get<std::string>();
+        }
+    }
+    if (Find(object, "users")) {
+        const auto& users = ArrayAt(object, "users", "");
+        for (size_t i = 0; i < users.size(); ++i) {
+            std::string where = "users[" + std::to_string(i) + "]";
+            const auto& user = ObjectAt(users[i], where);
+            plan.users.push_back({String(user, "email", where), String(user, "password", where)});
+        }
+    }
+
+    const auto& scenarios = ArrayAt(object, "scenarios", "");
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        std::string where = "scenarios[" + std::to_string(i) + "]";
+        plan.scenarios.push_back(ParseScenario(ObjectAt(scenarios[i], where), where));
+    }
+    if (plan.scenarios.empty()) {
+        throw std::invalid_argument("scenarios must not be empty");
+    }
+    return plan;
+}
+
+LoadPlan LoadPlan::FromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return Parse(contents.str());
+}
+
+void LoadPlan::ScaleRates(double factor) {
+    for (auto& scenario : scenarios) {
+        scenario.start_rate *= factor;
+        for (auto& stage : scenario.stages) {
+            stage.target *= factor;
+        }
+    }
+}
+
+ArrivalSchedule::ArrivalSchedule(double start_rate, std::vector<Stage> stages) {
+    double elapsed = 0.0;
+    double arrivals = 0.0;
+    double rate = start_rate;
+    for (const auto& stage : stages) {
+        double seconds = std::chrono::duration<double>(stage.duration).count();
+        if (seconds <= 0.0) {
+            rate = stage.target;  // k6: a zero-length stage jumps to its target
+            continue;
+        }
+        Segment segment{elapsed, seconds, rate, stage.target, arrivals, (rate + stage.target) / 2.0 * seconds};
+        segments_.push_back(segment);
+        elapsed += seconds;
+        arrivals += segment.arrivals;
+        rate = stage.target;
+    }
+    // The arrival due exactly at the end belongs to the next run, not this one
+    total_arrivals_ = static_cast<uint64_t>(std::ceil(arrivals - 1e-9));
+}
+
+std::optional<Duration> ArrivalSchedule::DueTime(uint64_t n) const {
+    if (n >= total_arrivals_) {
+        return std::nullopt;
+    }
+    double target = static_cast<double>(n);
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), target,
+                               [](double value, const Segment& s) { return value < s.arrivals_before + s.arrivals; });
+    if (it == segments_.end()) {
+        return std::nullopt;
+    }
+
+    // Arrivals t seconds into the segment: from*t + (to - from)*t^2 / (2*seconds).
+    // Solved in the form that stays exact for flat stages and a zero start rate.
+    double m = target - it->arrivals_before;
+    double a = (it->to_rate - it->from_rate) / (2.0 * it->seconds);
+    double root = std::sqrt(std::max(0.0, it->from_rate * it->from_rate + 4.0 * a * m));
+    double denominator = it->from_rate + root;
+    double t = denominator > 0.0 ? 2.0 * m / denominator : 0.0;
+    t = std::min(t, it->seconds);
+
+    return std::chrono::duration_cast<Duration>(std::chrono::duration<double>(it->start_seconds + t));
+}
+
+} // namespace loadgen
+} // namespace saasforge
@@ -0,0 +1,93 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for load report baseline comparison
+ */
+
+#include <gtest/gtest.h>
+#include "loadgen/baseline.h"
+#include <sstream>
+#include <stdexcept>
+
+using namespace saasforge::loadgen;
+
+namespace {
+
+// A ReportJson() document with one scenario and one RPC
+std::string Report(const std::string& rpc, double p50, double p99, double p999, double rate,
+                   double error_rate = 0.0) {
+    std::ostringstream json;
+    json << R"({"plan": "auth", "scenarios": [{"name": "validate", "seconds": 60, "rpcs": [{"rpc": ")" << rpc
+         << R"(", "calls": 60000, "rate": )" << rate << R"(, "error_rate": )" << error_rate
+         << R"(, "latency_ms": {"p50": )" << p50 << R"(, "p90": 1, "p99": )" << p99 << R"(, "p99.9": )" << p999
+         << R"(}}]}]})";
+    return json.str();
+}
+
+const BaselineCheck* Find(const std::vector<BaselineCheck>& checks, const std::string& metric) {
+    for (const auto& check : checks) {
+        if (check.metric == metric) {
+            return &check;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// Test that a run within tolerance passes every check
+TEST(BaselineTest, PassesWithinTolerance) {
+    auto checks = CompareToBaseline(Report("auth.ValidateApiKey", 2.2, 9.0, 19.0, 950.0),
+                                    Report("auth.ValidateApiKey", 2.0, 8.0, 16.0, 1000.0));
+    EXPECT_EQ(checks.size(), 5u);
+    EXPECT_TRUE(BaselinePassed(checks));
+}
+
+// Test that a slower tail is a regression, but sub-millisecond noise is not
+TEST(BaselineTest, FlagsLatencyRegression) {
+    // A per-key table scan: p99 from 8 ms to 40 ms
+    auto checks = CompareToBaseline(Report("auth.ValidateApiKey", 2.0, 40.0, 60.0, 1000.0),
+                                    Report("auth.ValidateApiKey", 2.0, 8.0, 16.0, 1000.0));
+    EXPECT_FALSE(BaselinePassed(checks));
+    EXPECT_TRUE(Find(checks, "p50")->passed);
+    EXPECT_FALSE(Find(checks, "p99")->passed);
+    EXPECT_DOUBLE_EQ(Find(checks, "p99")->current, 40.0);
+
+    // 0.2 ms -> 0.5 ms is +150%, but under the 1 ms floor
+    checks = CompareToBaseline(Report("auth.ValidateToken", 0.5, 0.9, 1.2, 1000.0),
+                               Report("auth.ValidateToken", 0.2, 0.4, 0.6, 1000.0));
+    EXPECT_TRUE(BaselinePassed(checks));
+}
+
+// Test that lost throughput and new errors are regressions
+TEST(BaselineTest, FlagsThroughputAndErrors) {
+    auto checks = CompareToBaseline(Report("auth.Login", 100, 200, 300, 800.0),
+                                    Report("auth.Login", 100, 200, 300, 1000.0));
+    EXPECT_FALSE(Find(checks, "rate")->passed);
+
+    checks = CompareToBaseline(Report("auth.Login", 100, 200, 300, 1000.0, 0.02),
+                               Report("auth.Login", 100, 200, 300, 1000.0, 0.0));
+    EXPECT_FALSE(Find(checks, "error_rate")->passed);
+    EXPECT_TRUE(Find(checks, "rate")->passed);
+}
+
+// Test that an RPC of the baseline that did not run fails, and new RPCs are not judged
+TEST(BaselineTest, MissingRpcFails) {
+    auto checks = CompareToBaseline(Report("auth.ValidateToken", 1, 2, 3, 1000.0),
+                                    Report("auth.ValidateApiKey", 1, 2, 3, 1000.0));
+    ASSERT_EQ(checks.size(), 1u);
+    EXPECT_EQ(checks[0].metric, "missing");
+    EXPECT_EQ(checks[0].rpc, "auth.ValidateApiKey");
+    EXPECT_FALSE(BaselinePassed(checks));
+
+    std::ostringstream out;
+    PrintBaselineChecks(out, checks);
+    EXPECT_NE(out.str().find("REGRESSION"), std::string::npos);
+}
+
+// Test that documents other than reports are rejected
+TEST(BaselineTest, RejectsNonReports) {
+    std::string report = Report("auth.Login", 1, 2, 3, 10.0);
+    EXPECT_THROW(CompareToBaseline(report, "not json"), std::invalid_argument);
+    EXPECT_THROW(CompareToBaseline("{\"plan\": \"auth\"}", report), std::invalid_argument);
+}
@@ -0,0 +1,112 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the load generator's HDR latency histogram
+ */
+
+#include <gtest/gtest.h>
+#include "loadgen/hdr_histogram.h"
+#include <sstream>
+#include <stdexcept>
+
+using namespace saasforge::loadgen;
+
+TEST(HdrHistogramTest, EmptyHistogram) {
+    HdrHistogram histogram;
+    EXPECT_EQ(histogram.TotalCount(), 0);
+    EXPECT_EQ(histogram.ValueAtPercentile(99.0), 0);
+    EXPECT_EQ(histogram.Max(), 0);
+    EXPECT_DOUBLE_EQ(histogram.Mean(), 0.0);
+}
+
+TEST(HdrHistogramTest, ExactBelowSingleUnitRange) {
+    HdrHistogram histogram;
+    for (int64_t v = 1; v <= 1000; ++v) {
+        histogram.Record(v);
+    }
+    EXPECT_EQ(histogram.TotalCount(), 1000);
+    EXPECT_EQ(histogram.ValueAtPercentile(50.0), 500);
+    EXPECT_EQ(histogram.ValueAtPercentile(99.0), 990);
+    EXPECT_EQ(histogram.ValueAtPercentile(100.0), 1000);
+    EXPECT_EQ(histogram.Min(), 1);
+    EXPECT_NEAR(histogram.Mean(), 500.5, 0.01);
+}
+
+TEST(HdrHistogramTest, KeepsSignificantDigitsAtLargeValues) {
+    HdrHistogram histogram;
+    const int64_t values[] = {12345, 1234567, 123456789, 1234567890};
+    for (int64_t value : values) {
+        HdrHistogram single;
+        single.Record(value);
+        int64_t reported = single.ValueAtPercentile(50.0);
+        EXPECT_GE(reported, value);
+        EXPECT_LE(static_cast<double>(reported - value), static_cast<double>(value) * 0.001) << value;
+    }
+}
+
+// The classic coordinated-omission example: 10000 fast calls and one
+// 100 s stall must show a max of 100 s and a p99.99 well above the fast calls
+TEST(HdrHistogramTest, OutlierShowsInTail) {
+    HdrHistogram histogram;
+    histogram.Record(1000, 10000);
+    histogram.Record(100000000);
+    EXPECT_EQ(histogram.TotalCount(), 10001);
+    EXPECT_LE(histogram.ValueAtPercentile(99.0), 1001);
+    EXPECT_GE(histogram.Max(), 100000000);
+    EXPECT_GE(histogram.ValueAtPercentile(100.0), 100000000);
+}
+
+TEST(HdrHistogramTest, ClampsAboveHighestTrackable) {
+    HdrHistogram histogram(1000000, 3);
+    histogram.Record(5000000);
+    histogram.Record(0);
+    EXPECT_EQ(histogram.Saturated(), 1);
+    EXPECT_EQ(histogram.TotalCount(), 2);
+    EXPECT_LE(histogram.Max(), 1001000);
+    EXPECT_EQ(histogram.Min(), 1);
+}
+
+TEST(HdrHistogramTest, AddMergesCounts) {
+    HdrHistogram a;
+    HdrHistogram b;
+    a.Record(100, 3);
+    b.Record(200, 1);
+    b.Record(300, 1);
+    a.Add(b);
+    EXPECT_EQ(a.TotalCount(), 5);
+    EXPECT_EQ(a.ValueAtPercentile(100.0), 300);
+    EXPECT_EQ(a.CountAtOrBelow(200), 4);
+
+    HdrHistogram other_layout(1000, 2);
+    EXPECT_THROW(a.Add(other_layout), std::invalid_argument);
+}
+
+TEST(HdrHistogramTest, RejectsInvalidConfiguration) {
+    EXPECT_THROW(HdrHistogram(1000, 0), std::invalid_argument);
+    EXPECT_THROW(HdrHistogram(1000, 6), std::invalid_argument);
+    EXPECT_THROW(HdrHistogram(1, 3), std::invalid_argument);
+}
+
+TEST(HdrHistogramTest, WritesHgrmPercentileDistribution) {
+    HdrHistogram histogram;
+    for (int64_t v = 1; v <= 10000; ++v) {
+        histogram.Record(v);
+    }
+    std::ostringstream out;
+    histogram.WritePercentiles(out, 1000.0);
+    std::string text = out.str();
+
+    EXPECT_EQ(text.find("       Value     Percentile TotalCount 1/(1-Percentile)"), 0u);
+    EXPECT_NE(text.find("1.000000000000      10000"), std::string::npos);
+    EXPECT_NE(text.find("#[Max     ="), std::string::npos);
+    EXPECT_NE(text.find("Total count    =        10000]"), std::string::npos);
+}
+
+TEST(HdrHistogramTest, HgrmTerminatesForLargeCounts) {
+    HdrHistogram histogram;
+    histogram.Record(10, 50000000);
+    histogram.Record(20);
+    std::ostringstream out;
+    histogram.WritePercentiles(out);
+    EXPECT_NE(out.str().find("#[Buckets"), std::string::npos);
+}
@@ -0,0 +1,175 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for load generator scenario files and arrival schedules
+ */
+
+#include <gtest/gtest.h>
+#include "loadgen/scenario.h"
+#include <cmath>
+#include <stdexcept>
+
+using namespace saasforge::loadgen;
+using namespace std::chrono;
+
+namespace {
+
+double Seconds(Duration duration) {
+    return duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+const char* kPlan = R"({
+  "name": "auth",
+  "targets": {"auth": "localhost:50051"},
+  "users": [{"email": "loadtest1@example.com", "password": "LoadTest123!"}],
+  "scenarios": [
+    {
+      "name": "steady", "rate": 100, "duration": "30s", "channels": 2,
+      "rpcs": [{"rpc": "auth.Login", "weight": 1}, {"rpc": "auth.ValidateToken", "weight": 3}],
+      "thresholds": {"auth.Login": ["p(95)<500", "error_rate<0.01"], "*": ["rate>90"]}
+    },
+    {
+      "name": "ramp", "start_time": "1m", "start_rate": 0,
+      "stages": [{"duration": "1m", "target": 50}, {"duration": "30s", "target": 50}],
+      "rpcs": [{"rpc": "auth.Login", "params": {"scopes": "read"}}]
+    }
+  ]
+})";
+
+} // namespace
+
+TEST(ScenarioTest, ParsesDurations) {
+    EXPECT_EQ(ParseDuration("500ms"), milliseconds(500));
+    EXPECT_EQ(ParseDuration("30s"), seconds(30));
+    EXPECT_EQ(ParseDuration("2m"), minutes(2));
+    EXPECT_EQ(ParseDuration("1h"), hours(1));
+    EXPECT_EQ(ParseDuration("1m30s"), seconds(90));
+    EXPECT_EQ(ParseDuration("1.5s"), milliseconds(1500));
+    EXPECT_THROW(ParseDuration(""), std::invalid_argument);
+    EXPECT_THROW(ParseDuration("30"), std::invalid_argument);
+    EXPECT_THROW(ParseDuration("5d"), std::invalid_argument);
+}
+
+TEST(ScenarioTest, ParsesThresholds) {
+    auto p95 = Threshold::Parse("p(95)<500");
+    EXPECT_EQ(p95.metric, Threshold::Metric::PERCENTILE);
+    EXPECT_DOUBLE_EQ(p95.percentile, 95.0);
+    EXPECT_DOUBLE_EQ(p95.bound, 500.0);
+    EXPECT_TRUE(p95.Passes(499.0));
+    EXPECT_FALSE(p95.Passes(500.0));
+
+    auto p999 = Threshold::Parse("p(99.9) < 2");
+    EXPECT_DOUBLE_EQ(p999.percentile, 99.9);
+
+    auto errors = Threshold::Parse("error_rate<0.01");
+    EXPECT_EQ(errors.metric, Threshold::Metric::ERROR_RATE);
+
+    auto rate = Threshold::Parse("rate>900");
+    EXPECT_EQ(rate.metric, Threshold::Metric::RATE);
+    EXPECT_TRUE(rate.Passes(950.0));
+
+    EXPECT_THROW(Threshold::Parse("p95<500"), std::invalid_argument);
+    EXPECT_THROW(Threshold::Parse("p(101)<500"), std::invalid_argument);
+    EXPECT_THROW(Threshold::Parse("error_rate=0"), std::invalid_argument);
+    EXPECT_THROW(Threshold::Parse("rate>9x"), std::invalid_argument);
+}
+
+TEST(ScenarioTest, ParsesPlan) {
+    auto plan = LoadPlan::Parse(kPlan);
+    EXPECT_EQ(plan.name, "auth");
+    EXPECT_EQ(plan.targets.at("auth"), "localhost:50051");
+    ASSERT_EQ(plan.users.size(), 1u);
+    ASSERT_EQ(plan.scenarios.size(), 2u);
+
+    const auto& steady = plan.scenarios[0];
+    EXPECT_EQ(steady.channels, 2u);
+    ASSERT_EQ(steady.stages.size(), 1u);
+    EXPECT_DOUBLE_EQ(steady.start_rate, 100.0);
+    EXPECT_DOUBLE_EQ(steady.stages[0].target, 100.0);
+    EXPECT_EQ(steady.rpcs[1].weight, 3u);
+    EXPECT_EQ(steady.thresholds.at("auth.Login").size(), 2u);
+    EXPECT_EQ(steady.thresholds.at("*").size(), 1u);
+
+    const auto& ramp = plan.scenarios[1];
+    EXPECT_EQ(ramp.start_time, minutes(1));
+    EXPECT_EQ(ramp.TotalDuration(), seconds(150));
+    EXPECT_EQ(ramp.rpcs[0].params.at("scopes"), "read");
+
+    plan.ScaleRates(2.0);
+    EXPECT_DOUBLE_EQ(plan.scenarios[0].stages[0].target, 200.0);
+    EXPECT_DOUBLE_EQ(plan.scenarios[1].stages[1].target, 100.0);
+}
+
+TEST(ScenarioTest, RejectsMalformedPlans) {
+    EXPECT_THROW(LoadPlan::Parse("{"), std::invalid_argument);
+    EXPECT_THROW(LoadPlan::Parse(R"({"name": "x", "scenarios": []})"), std::invalid_argument);
+    // No rate or stages
+    EXPECT_THROW(LoadPlan::Parse(R"({"name": "x", "scenarios": [
+        {"name": "s", "duration": "1s", "rpcs": [{"rpc": "auth.Login"}]}]})"), std::invalid_argument);
+    // Threshold for an RPC the scenario does not call
+    EXPECT_THROW(LoadPlan::Parse(R"({"name": "x", "scenarios": [
+        {"name": "s", "rate": 1, "duration": "1s", "rpcs": [{"rpc": "auth.Login"}],
+         "thresholds": {"auth.Logout": ["p(95)<1"]}}]})"), std::invalid_argument);
+    try {
+        LoadPlan::Parse(R"({"name": "x", "scenarios": [
+            {"name": "s", "rate": 1, "duration": "soon", "rpcs": [{"rpc": "auth.Login"}]}]})");
+        FAIL() << "expected invalid_argument";
+    } catch (const std::invalid_argument& e) {
+        EXPECT_NE(std::string(e.what()).find("scenarios.s.duration"), std::string::npos) << e.what();
+    }
+}
+
+TEST(ArrivalScheduleTest, ConstantRateIsEvenlySpaced) {
+    ArrivalSchedule schedule(100.0, {{seconds(10), 100.0}});
+    EXPECT_EQ(schedule.TotalArrivals(), 1000u);
+    EXPECT_EQ(schedule.DueTime(0), Duration::zero());
+    EXPECT_NEAR(Seconds(*schedule.DueTime(1)), 0.01, 1e-9);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(999)), 9.99, 1e-9);
+    EXPECT_FALSE(schedule.DueTime(1000).has_value());
+}
+
+TEST(ArrivalScheduleTest, LinearRampFollowsTheIntegral) {
+    // 0 -> 100/s over 10 s: n(t) = 5 t^2, 500 arrivals
+    ArrivalSchedule schedule(0.0, {{seconds(10), 100.0}});
+    EXPECT_EQ(schedule.TotalArrivals(), 500u);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(5)), 1.0, 1e-6);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(125)), 5.0, 1e-6);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(499)), std::sqrt(499.0 / 5.0), 1e-6);
+}
+
+TEST(ArrivalScheduleTest, StagesChainAndRampDown) {
+    // 10 s flat at 10/s (100), then 10 -> 0 over 10 s (50)
+    ArrivalSchedule schedule(10.0, {{seconds(10), 10.0}, {seconds(10), 0.0}});
+    EXPECT_EQ(schedule.TotalArrivals(), 150u);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(100)), 10.0, 1e-6);
+    // n(t) = 10 t - t^2 / 2 in the ramp-down: 10 -> t = 10 - sqrt(80)
+    EXPECT_NEAR(Seconds(*schedule.DueTime(110)), 10.0 + 10.0 - std::sqrt(80.0), 1e-6);
+
+    Duration previous = Duration::zero();
+    for (uint64_t n = 1; n < schedule.TotalArrivals(); ++n) {
+        auto due = schedule.DueTime(n);
+        ASSERT_TRUE(due.has_value());
+        ASSERT_GE(*due, previous) << n;
+        previous = *due;
+    }
+    EXPECT_LE(previous, seconds(20));
+}
+
+TEST(ArrivalScheduleTest, ZeroRateStagesHaveNoArrivals) {
+    ArrivalSchedule schedule(0.0, {{seconds(5), 0.0}, {seconds(0), 10.0}, {seconds(1), 10.0}});
+    EXPECT_EQ(schedule.TotalArrivals(), 10u);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(0)), 5.0, 1e-9);
+    EXPECT_NEAR(Seconds(*schedule.DueTime(9)), 5.9, 1e-9);
+}
+
+TEST(ArrivalScheduleTest, StridedSendersCoverEveryArrivalOnce) {
+    ArrivalSchedule schedule(0.0, {{seconds(2), 1000.0}, {seconds(1), 1000.0}});
+    const uint64_t senders = 3;
+    uint64_t covered = 0;
+    for (uint64_t k = 0; k < senders; ++k) {
+        for (uint64_t n = k; schedule.DueTime(n); n += senders) {
+            ++covered;
+        }
+    }
+    EXPECT_EQ(covered, schedule.TotalArrivals());
+}
@@ -0,0 +1,140 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description SendGrid, Twilio and FCM senders with provider-side batching
+ */
+
+#pragma once
+
+#include "notification/provider_client.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace notification {
+
+/**
+ * Outcome of one message handed to a provider
+ */
+struct DeliveryResult {
+    bool delivered = false;     // Accepted by the provider
+    bool retryable = false;     // Failure is temporary (throttling, 5xx, network)
+    std::string error;
+};
+
+struct OutboundEmail {
+    std::string to;
+    std::string subject;
+    std::string body_html;
+    std::string body_text;
+};
+
+struct OutboundSms {
+    std::string to;
+    std::string body;
+};
+
+struct OutboundPush {
+    std::string token;          // FCM registration token
+    std::string title;
+    std::string body;
+    std::map<std::string, std::string> data;
+};
+
+/**
+ * SendGrid v3 mail/send
+ *
+ * Emails with identical content (subject and bodies) go out as one
+ * request with a personalization per recipient, up to
+ * MAX_PERSONALIZATIONS each, so a campaign costs one API call per
+ * thousand recipients instead of one per recipient. Recipients of
+ * different personalizations do not see each other.
+ */
+class SendGridSender {
+public:
+    static constexpr const char* API_URL = "https://api.sendgrid.com/v3/mail/send";
+    static constexpr size_t MAX_PERSONALIZATIONS = 1000;
+
+    SendGridSender(std::string api_key, std::string from, std::shared_ptr<ProviderClient> client);
+
+    /// Results in email order
+    std::vector<DeliveryResult> Send(const std::vector<OutboundEmail>& emails);
+
+    /// The mail/send requests for emails; recipients[i] lists the emails request i carries
+    std::vector<ProviderRequest> BuildRequests(const std::vector<OutboundEmail>& emails,
+                                               std::vector<std::vector<size_t>>& recipients) const;
+
+private:
+    std::string authorization_;
+    std::string from_;
+    std::shared_ptr<ProviderClient> client_;
+};
+
+/**
+ * Twilio Programmable Messaging
+ *
+ * The Messages API takes one recipient per call, so SMS gains nothing
+ * from batching; sends share pooled connections and the adaptive limit.
+ */
+class TwilioSender {
+public:
+    TwilioSender(const std::string& account_sid, const std::string& auth_token, std::string from,
+                 std::shared_ptr<ProviderClient> client);
+
+    std::vector<DeliveryResult> Send(const std::vector<OutboundSms>& messages);
+
+private:
+    std::string url_;
+    std::string authorization_;
+    std::string from_;
+    std::shared_ptr<ProviderClient> client_;
+};
+
+/**
+ * FCM HTTP multicast
+ *
+ * Pushes with identical content go out together with up to
+ * MAX_TOKENS registration ids per request; per-token errors are read
+ * back from the response's results array.
+ */
+class FcmSender {
+public:
+    static constexpr const char* API_URL = "https://fcm.googleapis.com/fcm/send";
+    static constexpr size_t MAX_TOKENS = 500;
+
+    FcmSender(const std::string& server_key, std::shared_ptr<ProviderClient> client);
+
+    std::vector<DeliveryResult> Send(const std::vector<OutboundPush>& pushes);
+
+    /// Per-token error codes from a multicast response ("" for tokens that were accepted)
+    static std::vector<std::string> ParseResults(const std::string& body, size_t tokens);
+
+private:
+    std::string authorization_;
+    std::shared_ptr<ProviderClient> client_;
+};
+
+/**
+ * The configured senders; a channel without credentials is null
+ *
+ * Each provider gets its own ProviderClient, so connections and the
+ * adaptive limit are per provider.
+ */
+struct ChannelSenders {
+    std::shared_ptr<SendGridSender> email;
+    std::shared_ptr<TwilioSender> sms;
+    std::shared_ptr<FcmSender> push;
+
+    /// Empty credentials leave that channel null
+    static ChannelSenders Create(
+        const ProviderClientOptions& options,
+        const std::string& sendgrid_api_key, const std::string& sendgrid_from,
+        const std::string& twilio_account_sid, const std::string& twilio_auth_token, const std::string& twilio_from,
+        const std::string& fcm_server_key
+    );
+};
+
+} // namespace notification
+} // namespace saasforge
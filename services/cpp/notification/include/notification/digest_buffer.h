@@ -0,0 +1,225 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-user notification digests: coalescing buffers in Redis sorted sets and their flusher
+ */
+
+#pragma once
+
+#include "common/db_pool.h"
+#include "common/email_queue.h"
+#include "common/redis_client.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saasforge {
+namespace notification {
+
+/**
+ * Digest options
+ *
+ * FromEnv() reads NOTIFICATION_DIGEST_WINDOW_MS, NOTIFICATION_DIGEST_MAX_ITEMS,
+ * NOTIFICATION_DIGEST_LEASE_S, NOTIFICATION_DIGEST_FLUSH_MS and
+ * NOTIFICATION_DIGEST_FLUSH_BATCH.
+ */
+struct DigestOptions {
+    std::chrono::milliseconds window{60000};        // A digest goes out this long after its first item
+    size_t max_items = 50;                          // ... or as soon as it holds this many
+    std::chrono::seconds lease{60};                 // A claimed digest is claimable again after this
+    std::chrono::milliseconds flush_interval{1000}; // Flusher poll for due digests
+    size_t flush_batch = 100;                       // Digests claimed per poll
+
+    static DigestOptions FromEnv();
+};
+
+enum class DigestChannel { EMAIL, PUSH };
+
+/**
+ * One buffered notification, already rendered
+ */
+struct DigestItem {
+    std::string tenant_id;
+    std::string user_id;
+    std::string to;             // Email address; empty for push
+    std::string subject;        // Email subject or push title
+    std::string body_html;      // Email only
+    std::string body_text;      // Email text part or push body
+
+    /// Length-prefixed fields behind a format byte (the Redis member after its 16-byte id)
+    std::string Encode() const;
+    static std::optional<DigestItem> Decode(std::string_view encoded);
+};
+
+/**
+ * Buffers claimed by DigestStore::claim
+ */
+struct DigestClaim {
+    std::string buffer_id;              // "<channel>:<tenant_id>:<user_id>:<coalescing key>"
+    std::string up_to;                  // Score of the newest claimed item, passed back to ack
+    std::vector<std::string> items;     // Members, oldest first
+};
+
+/**
+ * The Redis operations behind digests
+ *
+ * Items of a buffer are a sorted set "{digest}:items:<buffer_id>" scored
+ * by arrival (ms, strictly increasing); "{digest}:due" scores each
+ * buffer by when it is to be flushed. claim() takes a lease on a due
+ * buffer ("{digest}:lease:<buffer_id>") and pushes its due time past the
+ * lease, so a flusher that dies leaves the buffer to the next one; ack()
+ * removes what was delivered and reschedules items added meanwhile.
+ * Every key shares the "{digest}" hash tag so the scripts run on one
+ * cluster slot.
+ */
+struct DigestStore {
+    /// Add a member; returns the buffer's size. Schedules the buffer `window` ahead, or now once full
+    std::function<size_t(const std::string& buffer_id, const std::string& member, std::chrono::milliseconds window,
+                         size_t max_items)> add;
+    /// Up to `limit` due buffers not leased by another flusher
+    std::function<std::vector<DigestClaim>(size_t limit, std::chrono::seconds lease)> claim;
+    /// Drop the claimed items; items added since are flushed `window` later
+    std::function<void(const DigestClaim& claim, std::chrono::milliseconds window)> ack;
+
+    static DigestStore From(std::shared_ptr<common::RedisClient> redis);
+};
+
+/**
+ * The notification that goes out for a flushed buffer
+ */
+struct Digest {
+    DigestChannel channel = DigestChannel::EMAIL;
+    std::string coalescing_key;
+    size_t count = 0;           // Notifications merged
+    DigestItem merged;          // Tenant, user and recipient of the newest item
+};
+
+/**
+ * Producer side: coalesce notifications per (user, coalescing key)
+ *
+ * Handlers that get a coalescing key Add() the rendered notification
+ * instead of sending it. One Redis script call per notification; the
+ * buffer goes out window after its first item (DigestFlusher), merged
+ * into one message.
+ *
+ * Usage:
+ *   DigestBuffer digests(DigestStore::From(redis), DigestOptions::FromEnv());
+ *   digests.Add(DigestChannel::EMAIL, "payment_failed", {tenant_id, user_id, to, subject, html, text});
+ */
+class DigestBuffer {
+public:
+    static constexpr size_t MAX_KEY_LENGTH = 128;
+
+    DigestBuffer(DigestStore store, const DigestOptions& options = {});
+    ~DigestBuffer();
+
+    DigestBuffer(const DigestBuffer&) = delete;
+    DigestBuffer& operator=(const DigestBuffer&) = delete;
+
+    /**
+     * Buffer a notification
+     *
+     * @return Notifications buffered for (user, key), this one included
+     * @throws std::invalid_argument if the key is empty or over MAX_KEY_LENGTH
+     * @throws std::exception if Redis fails
+     */
+    size_t Add(DigestChannel channel, const std::string& coalescing_key, const DigestItem& item);
+
+    static std::string BufferId(DigestChannel channel, const DigestItem& item, const std::string& coalescing_key);
+
+    /**
+     * Merge a claimed buffer into one notification
+     *
+     * One decodable item goes out unchanged. Several are rendered into
+     * the digest templates (newest recipient, the oldest item's subject,
+     * then up to max_items entries); items that do not decode are skipped.
+     *
+     * @return nullopt if no item decodes
+     */
+    static std::optional<Digest> Merge(const DigestClaim& claim, size_t max_items);
+
+    uint64_t Buffered() const { return buffered_.load(); }
+
+private:
+    DigestStore store_;
+    DigestOptions options_;
+    std::atomic<uint64_t> buffered_{0};
+    uint64_t metrics_collector_ = 0;
+};
+
+/**
+ * Flusher counters
+ */
+struct DigestFlusherStats {
+    uint64_t flushed = 0;       // Digests delivered
+    uint64_t merged = 0;        // Notifications in them
+    uint64_t failed = 0;        // Deliveries that threw (claimed again once the lease expires)
+    uint64_t dropped = 0;       // Buffers with no decodable item
+};
+
+/**
+ * Consumer side: deliver due digests
+ *
+ * One thread claims due buffers every flush_interval (at once again when
+ * a poll was full), merges each and hands it to `deliver`. A buffer is
+ * acked only after deliver returns, so a failed delivery or a crash sends
+ * the digest again after the lease: delivery is at least once.
+ *
+ * Usage:
+ *   DigestFlusher flusher(DigestStore::From(redis), DigestFlusher::QueueDelivery(db_pool, email_queue),
+ *                         DigestOptions::FromEnv());
+ */
+class DigestFlusher {
+public:
+    using Deliver = std::function<void(const Digest& digest)>;
+
+    DigestFlusher(DigestStore store, Deliver deliver, const DigestOptions& options = {});
+    ~DigestFlusher();
+
+    DigestFlusher(const DigestFlusher&) = delete;
+    DigestFlusher& operator=(const DigestFlusher&) = delete;
+
+    /// Claim, deliver and ack one poll's worth of due digests; returns the buffers claimed
+    size_t FlushDue();
+
+    /// Stop polling (idempotent); unflushed buffers stay in Redis
+    void Shutdown();
+
+    DigestFlusherStats GetStats() const;
+
+    /**
+     * Email digests go to email_queue (sent and retried by EmailWorker);
+     * push digests are recorded in notifications, logged like SendPush
+     * until device tokens are stored
+     */
+    static Deliver QueueDelivery(std::shared_ptr<common::DbPool> db_pool, std::shared_ptr<common::EmailQueue> email_queue);
+
+private:
+    void Run();
+
+    DigestStore store_;
+    Deliver deliver_;
+    DigestOptions options_;
+
+    std::atomic<uint64_t> flushed_{0};
+    std::atomic<uint64_t> merged_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t metrics_collector_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace notification
+} // namespace saasforge
@@ -0,0 +1,201 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Multi-threaded email_queue consumer: claim, pipelined provider sends, batched acks
+ */
+
+#pragma once
+
+#include "common/email_queue.h"
+#include "common/timing_wheel.h"
+#include "notification/channel_senders.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace saasforge {
+namespace notification {
+
+/**
+ * EmailWorker options
+ *
+ * FromEnv() reads EMAIL_WORKER_DEQUEUE_THREADS, EMAIL_WORKER_SEND_THREADS,
+ * EMAIL_WORKER_BATCH_SIZE, EMAIL_WORKER_MAX_PENDING_BATCHES,
+ * EMAIL_WORKER_IDLE_WAIT_MS, EMAIL_WORKER_ACK_INTERVAL_MS,
+ * EMAIL_WORKER_ACK_MAX, EMAIL_WORKER_RETRY_HOLD_MAX_MS,
+ * EMAIL_WORKER_RETRY_HOLD_LEASE_S and EMAIL_WORKER_MAX_HELD_RETRIES.
+ */
+struct EmailWorkerOptions {
+    size_t dequeue_threads = 2;                    // Threads claiming from email_queue
+    size_t send_threads = 8;                       // Batches with provider calls in progress at once
+    int batch_size = 100;                          // Rows per claim
+    size_t max_pending_batches = 16;               // Claimed, not yet sent; claiming pauses beyond this
+    std::chrono::milliseconds idle_wait{1000};     // WaitForBatch block (also the shutdown latency)
+    std::chrono::milliseconds ack_interval{200};   // Results are written at least this often
+    size_t ack_max = 1000;                         // ... or as soon as this many are buffered
+    std::chrono::milliseconds hold_max{30000};     // Retries due within this wait in memory (0: none)
+    std::chrono::seconds hold_lease{60};           // Held rows stay unclaimable this long past due
+    size_t max_held = 10000;                       // Held retries beyond this go back to the table
+
+    static EmailWorkerOptions FromEnv();
+};
+
+/**
+ * Worker counters
+ */
+struct EmailWorkerStats {
+    uint64_t claimed = 0;
+    uint64_t sent = 0;
+    uint64_t failed = 0;            // Recorded with MarkFailedBatch (retried or exhausted per D-98)
+    uint64_t released = 0;          // Claimed but handed back at shutdown
+    uint64_t ack_batches = 0;
+    uint64_t failed_acks = 0;       // Result writes that threw (kept and retried)
+    size_t pending_batches = 0;     // Claimed, waiting for a send thread
+    size_t unacked = 0;             // Sent, results not yet written
+    size_t held = 0;                // Failed, waiting out a short backoff in memory
+    uint64_t resent = 0;            // Held retries re-sent without a queue scan
+};
+
+/**
+ * The email_queue operations the worker uses
+ *
+ * reclaim_held and release_held are optional; without them no retry is
+ * held in memory. decode, also optional, fills in bodies the queue returned
+ * still encoded, just before they are sent (throws if it cannot).
+ */
+struct EmailWorkerQueue {
+    using Emails = std::vector<common::QueuedEmail>;
+
+    std::function<Emails(int batch_size, std::chrono::milliseconds max_wait)> wait_for_batch;
+    std::function<size_t(const std::vector<std::string>& email_ids)> mark_sent;
+    std::function<size_t(const std::vector<common::EmailFailure>& failures, std::chrono::seconds hold_lease)>
+        mark_failed;
+    std::function<size_t(const std::vector<std::string>& email_ids)> release;
+    std::function<std::vector<std::string>(const Emails& held)> reclaim_held;
+    std::function<size_t(const Emails& held, std::chrono::seconds hold_lease)> release_held;
+    std::function<void(common::QueuedEmail& email)> decode;
+
+    /// The EmailQueue's WaitForBatch, MarkSentBatch, MarkFailedBatch, ReleaseBatch,
+    /// ReclaimHeldBatch, ReleaseHeldBatch and DecodeBodies
+    static EmailWorkerQueue From(std::shared_ptr<common::EmailQueue> queue);
+};
+
+/**
+ * Drains email_queue through an email provider
+ *
+ * Three stages, each with a fixed set of threads:
+ * 1. dequeue_threads claim with EmailQueue::WaitForBatch, which drains
+ *    with GetNextBatch while rows are due and otherwise sleeps until a
+ *    LISTEN/NOTIFY wakeup or the next scheduled retry;
+ * 2. send_threads hand each claimed batch to the provider (SendGridSender
+ *    folds identical content into one request and pools connections), so
+ *    claims and provider round trips overlap instead of alternating;
+ * 3. one ack thread writes the outcomes of every send with one
+ *    MarkSentBatch and one MarkFailedBatch per ack_interval.
+ *
+ * A soft failure whose backoff is at most hold_max (1, 5 and 30 seconds
+ * under D-98) is not left for a queue scan to find: the ack thread keeps
+ * it in a timing wheel and, when due, claims it back by ID
+ * (ReclaimHeldBatch) and queues it for the send threads. Its
+ * MarkFailedBatch records the retry hold_lease later than due, so another
+ * replica picks it up if this one dies; shutdown hands held rows back at
+ * their real backoff.
+ *
+ * Claiming stops while max_pending_batches are waiting to be sent, so a
+ * slow provider leaves rows in the queue for other replicas rather than
+ * in SENDING here. Provider rejections are recorded as soft failures:
+ * bounces arrive later through the provider's event webhook.
+ *
+ * Shutdown() stops claiming, releases batches that were not sent yet,
+ * waits for sends in progress and writes their results.
+ *
+ * Usage:
+ *   EmailWorker worker(EmailWorkerQueue::From(email_queue),
+ *                      EmailWorker::ProviderSend(senders.email), EmailWorkerOptions::FromEnv());
+ *   // ... runs until Shutdown() or destruction
+ */
+class EmailWorker {
+public:
+    /// Results in email order; never throws for provider failures
+    using Send = std::function<std::vector<DeliveryResult>(const std::vector<OutboundEmail>& emails)>;
+
+    EmailWorker(EmailWorkerQueue queue, Send send, const EmailWorkerOptions& options = {});
+    ~EmailWorker();
+
+    EmailWorker(const EmailWorker&) = delete;
+    EmailWorker& operator=(const EmailWorker&) = delete;
+
+    /// Stop claiming, release unsent batches, finish sends and flush results (idempotent)
+    void Shutdown();
+
+    EmailWorkerStats GetStats() const;
+
+    /// SendGridSender::Send; a null sender logs each email and reports it delivered (mock mode)
+    static Send ProviderSend(std::shared_ptr<SendGridSender> sender);
+
+private:
+    void DequeueLoop();
+    void SendLoop();
+    void AckLoop();
+
+    /// Write buffered results (ack thread only); false if a write threw (they stay buffered)
+    bool FlushAcks();
+
+    /// Queue held retries that are due for the send threads (ack thread only)
+    void ResendHeld();
+
+    /// Hand every held retry back to the queue (ack thread only, at exit)
+    void ReleaseHeld();
+
+    EmailWorkerQueue queue_;
+    Send send_;
+    EmailWorkerOptions options_;
+
+    // Claimed batches waiting for a send thread
+    mutable std::mutex batches_mutex_;
+    std::condition_variable batches_cv_;        // A batch was queued, or stopping
+    std::condition_variable capacity_cv_;       // A batch was taken, or stopping
+    std::deque<std::vector<common::QueuedEmail>> batches_;
+    bool stopping_ = false;
+
+    // Outcomes waiting to be written
+    mutable std::mutex acks_mutex_;
+    std::condition_variable acks_cv_;
+    std::vector<std::string> sent_ids_;
+    std::vector<common::EmailFailure> failures_;
+    bool sending_done_ = false;                 // Send threads joined; the ack thread flushes and exits
+
+    // Failed sends whose retry is waited out here; retry_count is the one MarkFailedBatch records
+    struct Held {
+        common::QueuedEmail email;
+        std::chrono::steady_clock::time_point due;
+    };
+    std::vector<Held> to_hold_;                 // With failures_; scheduled once those are written
+    common::TimingWheel<Held> held_;            // Ack thread only
+
+    std::atomic<uint64_t> claimed_{0};
+    std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> released_{0};
+    std::atomic<uint64_t> ack_batches_{0};
+    std::atomic<uint64_t> failed_acks_{0};
+    std::atomic<size_t> held_count_{0};
+    std::atomic<uint64_t> resent_{0};
+
+    std::mutex shutdown_mutex_;
+    bool shutdown_ = false;
+    std::vector<std::thread> dequeue_threads_;
+    std::vector<std::thread> send_threads_;
+    std::thread ack_thread_;
+};
+
+} // namespace notification
+} // namespace saasforge
@@ -0,0 +1,76 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Sync and callback gRPC registrations for NotificationServiceImpl
+ */
+
+#pragma once
+
+#include <memory>
+#include "notification.grpc.pb.h"
+#include "notification/notification_service.h"
+#include "common/arena_allocator.h"
+#include "common/executor.h"
+#include "common/service_adapter.h"
+
+// Single list of NotificationService RPCs; keep in sync with proto/notification.proto
+#define SAASFORGE_NOTIFICATION_RPCS(X) \
+    X(SendEmail, SendEmailRequest, NotificationResponse) \
+    X(SendSMS, SendSMSRequest, NotificationResponse) \
+    X(SendPush, SendPushRequest, NotificationResponse) \
+    X(TriggerWebhook, TriggerWebhookRequest, NotificationResponse) \
+    X(GetNotificationStatus, GetNotificationStatusRequest, NotificationResponse) \
+    X(UpdatePreferences, UpdatePreferencesRequest, PreferencesResponse) \
+    X(RegisterWebhook, RegisterWebhookRequest, WebhookResponse) \
+    X(PublishEvent, PublishEventRequest, PublishEventResponse)
+
+#define SAASFORGE_NOTIFICATION_SERVER_STREAM_RPCS(X) \
+    X(SendEmailBatch, SendEmailBatchRequest, SendResult) \
+    X(ListNotifications, ListNotificationsRequest, NotificationResponse) \
+    X(ListWebhookDeliveries, ListWebhookDeliveriesRequest, WebhookDeliveryResponse)
+
+#define SAASFORGE_NOTIFICATION_CLIENT_STREAM_RPCS(X) \
+    X(SendStream, SendEmailRequest, SendStreamResponse)
+
+namespace saasforge {
+namespace notification {
+
+/**
+ * Registers NotificationServiceImpl on the synchronous API (handlers on gRPC threads)
+ */
+class NotificationServiceSync final : public NotificationService::Service {
+public:
+    explicit NotificationServiceSync(std::shared_ptr<NotificationServiceImpl> impl) : impl_(std::move(impl)) {}
+
+    SAASFORGE_NOTIFICATION_RPCS(SAASFORGE_SYNC_UNARY_METHOD)
+    SAASFORGE_NOTIFICATION_SERVER_STREAM_RPCS(SAASFORGE_SYNC_SERVER_STREAM_METHOD)
+    SAASFORGE_NOTIFICATION_CLIENT_STREAM_RPCS(SAASFORGE_SYNC_CLIENT_STREAM_METHOD)
+
+private:
+    std::shared_ptr<NotificationServiceImpl> impl_;
+};
+
+/**
+ * Registers NotificationServiceImpl on the callback API; handlers run on a bounded Executor
+ *
+ * Unary requests and responses are allocated on one protobuf arena per RPC.
+ */
+class NotificationServiceCallback final : public NotificationService::CallbackService {
+public:
+    NotificationServiceCallback(std::shared_ptr<NotificationServiceImpl> impl, std::shared_ptr<common::Executor> executor)
+        : impl_(std::move(impl)), executor_(std::move(executor)), arenas_(NotificationService::service_full_name()) {
+        SAASFORGE_NOTIFICATION_RPCS(SAASFORGE_CALLBACK_ARENA_ALLOCATOR)
+    }
+
+    SAASFORGE_NOTIFICATION_RPCS(SAASFORGE_CALLBACK_UNARY_METHOD)
+    SAASFORGE_NOTIFICATION_SERVER_STREAM_RPCS(SAASFORGE_CALLBACK_SERVER_STREAM_METHOD)
+    SAASFORGE_NOTIFICATION_CLIENT_STREAM_RPCS(SAASFORGE_CALLBACK_CLIENT_STREAM_METHOD)
+
+private:
+    std::shared_ptr<NotificationServiceImpl> impl_;
+    std::shared_ptr<common::Executor> executor_;
+    common::ArenaAllocators arenas_;
+};
+
+} // namespace notification
+} // namespace saasforge
@@ -2,14 +2,33 @@
 
 #include <grpcpp/grpcpp.h>
 #include <memory>
+#include <string>
+#include <vector>
 #include "notification.grpc.pb.h"
 #include "common/redis_client.h"
+#include "common/event_bus.h"
 #include "common/db_pool.h"
+#include "common/dns_cache.h"
+#include "common/email_template.h"
+#include "common/service_adapter.h"
+#include "common/webhook_delivery.h"
+#include "common/webhook_subscriptions.h"
+#include "notification/channel_senders.h"
+#include "notification/digest_buffer.h"
+#include "notification/preference_cache.h"
 
 namespace saasforge {
 namespace notification {
 
-class NotificationServiceImpl final : public ::saasforge::notification::NotificationService::Service {
+/**
+ * NotificationService RPC handlers
+ *
+ * Handlers take grpc::ServerContextBase so the same implementation serves
+ * both the sync and the callback server (see notification_grpc_service.h).
+ * SendEmail and SendPush with a coalescing_key pass their checks and
+ * rendering, then go to DigestBuffer instead of the provider.
+ */
+class NotificationServiceImpl final {
 public:
     NotificationServiceImpl(
         std::shared_ptr<common::RedisClient> redis_client,
@@ -17,64 +36,143 @@ public:
         const std::string& sendgrid_api_key,
         const std::string& twilio_account_sid,
         const std::string& twilio_auth_token,
-        const std::string& fcm_server_key
+        const std::string& fcm_server_key,
+        std::shared_ptr<common::DnsCache> dns_cache = nullptr,
+        std::shared_ptr<common::WebhookSubscriptionIndex> subscriptions = nullptr,
+        std::shared_ptr<common::EmailTemplateCache> templates = nullptr,
+        std::shared_ptr<PreferenceCache> preferences = nullptr,
+        ChannelSenders senders = {},
+        std::shared_ptr<DigestBuffer> digests = nullptr
     );
 
+    /**
+     * Startup warm-up (see common::Warmup)
+     *
+     * Loads the suppression list into the preference cache, so the first
+     * sends do not wait for it. Preferences are loaded per tenant on use.
+     *
+     * @throws std::runtime_error if loading fails
+     */
+    void WarmUp();
+
     grpc::Status SendEmail(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const SendEmailRequest* request,
         NotificationResponse* response
-    ) override;
+    );
+
+    /// Streams one SendResult per recipient, a chunk at a time
+    grpc::Status SendEmailBatch(
+        grpc::ServerContextBase* context,
+        const SendEmailBatchRequest* request,
+        common::StreamWriter<SendResult>& writer
+    );
+
+    /// Client-streaming; called once per chunk, accumulating into response
+    grpc::Status SendStream(
+        grpc::ServerContextBase* context,
+        const std::vector<SendEmailRequest>& chunk,
+        SendStreamResponse* response
+    );
 
     grpc::Status SendSMS(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const SendSMSRequest* request,
         NotificationResponse* response
-    ) override;
+    );
 
     grpc::Status SendPush(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const SendPushRequest* request,
         NotificationResponse* response
-    ) override;
+    );
 
     grpc::Status TriggerWebhook(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const TriggerWebhookRequest* request,
         NotificationResponse* response
-    ) override;
+    );
 
     grpc::Status GetNotificationStatus(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const GetNotificationStatusRequest* request,
         NotificationResponse* response
-    ) override;
+    );
+
+    /**
+     * Stream one page of the tenant's notifications, newest first
+     *
+     * Keyset pagination on (created_at, id): each row carries the cursor
+     * the next page starts after. Rows are read with COPY and written in
+     * chunks as they arrive, so memory does not grow with the page size.
+     */
+    grpc::Status ListNotifications(
+        grpc::ServerContextBase* context,
+        const ListNotificationsRequest* request,
+        common::StreamWriter<NotificationResponse>& writer
+    );
+
+    /// Webhook deliveries (queued and done), paged like ListNotifications
+    grpc::Status ListWebhookDeliveries(
+        grpc::ServerContextBase* context,
+        const ListWebhookDeliveriesRequest* request,
+        common::StreamWriter<WebhookDeliveryResponse>& writer
+    );
 
     grpc::Status UpdatePreferences(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const UpdatePreferencesRequest* request,
         PreferencesResponse* response
-    ) override;
+    );
 
     grpc::Status RegisterWebhook(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const RegisterWebhookRequest* request,
         WebhookResponse* response
-    ) override;
+    );
+
+    grpc::Status PublishEvent(
+        grpc::ServerContextBase* context,
+        const PublishEventRequest* request,
+        PublishEventResponse* response
+    );
 
 private:
     std::shared_ptr<common::RedisClient> redis_client_;
+    std::shared_ptr<common::EventBus> event_bus_;   // Cache invalidations between replicas
     std::shared_ptr<common::DbPool> db_pool_;
     std::string sendgrid_api_key_;
     std::string twilio_account_sid_;
     std::string twilio_auth_token_;
     std::string fcm_server_key_;
+    std::shared_ptr<common::DnsCache> dns_cache_;
+    std::shared_ptr<common::WebhookSubscriptionIndex> subscriptions_;
+    std::shared_ptr<common::WebhookDelivery> webhook_delivery_;
+    std::shared_ptr<common::EmailTemplateCache> templates_;
+    std::shared_ptr<PreferenceCache> preferences_;
+    ChannelSenders senders_;    // Channels without credentials are null and only logged
+    std::shared_ptr<DigestBuffer> digests_;
+
+    /// An admitted email awaiting QueueEmails(); result indexes the caller's results
+    struct PendingEmail {
+        size_t result;
+        std::string user_id;
+    };
 
     // Helper methods
-    bool CheckUserPreferences(const std::string& user_id, NotificationChannel channel);
+    bool CheckUserPreferences(const std::string& tenant_id, const std::string& user_id, NotificationChannel channel);
     std::string QueueNotification(const std::string& tenant_id, const std::string& user_id,
-                                   NotificationChannel channel, const std::string& payload);
+                                   NotificationChannel channel, const std::string& payload,
+                                   NotificationStatus status = NotificationStatus::SENT);
     bool ValidateWebhookUrl(const std::string& url);
+    bool AdmitEmail(const std::string& tenant_id, const std::string& user_id, const std::string& to,
+                    SendResult& result);
+    /// Hold a notification for the user's digest; the response is PENDING, without an id
+    grpc::Status BufferDigest(DigestChannel channel, const std::string& coalescing_key, const DigestItem& item,
+                              NotificationChannel response_channel, NotificationResponse* response);
+    /// Deliver pending[i]'s emails[i] and record each row with its outcome
+    void QueueEmails(const std::string& tenant_id, const std::vector<PendingEmail>& pending,
+                     const std::vector<OutboundEmail>& emails, std::vector<SendResult>& results);
 };
 
 } // namespace notification
@@ -0,0 +1,147 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-process cache of notification preferences and suppressed addresses
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+class DbPool;
+class EmailQueue;
+}
+
+namespace notification {
+
+/// One bit per notification_preferences flag
+enum PreferenceBit : uint8_t {
+    PREFERENCE_EMAIL = 1 << 0,
+    PREFERENCE_SMS = 1 << 1,
+    PREFERENCE_PUSH = 1 << 2,
+    PREFERENCE_MARKETING = 1 << 3,
+};
+
+/**
+ * PreferenceCache options
+ *
+ * FromEnv() reads NOTIFICATION_PREFERENCE_TTL_S and
+ * NOTIFICATION_PREFERENCE_MAX_TENANTS.
+ */
+struct PreferenceCacheOptions {
+    std::chrono::seconds ttl{300};   // Reload bound if a change message is missed
+    size_t max_tenants = 10000;
+
+    static PreferenceCacheOptions FromEnv();
+};
+
+/**
+ * Per-process view of notification_preferences and email_suppression
+ *
+ * A tenant's preference rows are loaded with one query on first use and
+ * kept as one byte of PreferenceBit flags per user; users without a row
+ * get DEFAULT_BITS. The suppression list is loaded whole and reloaded
+ * after `ttl`. Sends therefore read nothing from the database in the
+ * steady state.
+ *
+ * UpdatePreferences applies its committed row with Update() and publishes
+ * EncodeChange() on CHANGE_TOPIC; other replicas pass the event to
+ * ApplyChange() and Clear() when the EventBus reports missed events. The
+ * TTL bounds staleness if an event is lost anyway.
+ *
+ * Usage:
+ *   PreferenceCache preferences(db_pool, email_queue, PreferenceCacheOptions::FromEnv());
+ *   if (!preferences.Allows(tenant_id, user_id, PREFERENCE_EMAIL)) { ... }
+ */
+class PreferenceCache {
+public:
+    /// EventBus topic carrying EncodeChange() events
+    static constexpr const char* CHANGE_TOPIC = "notification_preferences:changed";
+
+    /// Allowed for users who never saved preferences (matches the old fail-open check)
+    static constexpr uint8_t DEFAULT_BITS = PREFERENCE_EMAIL | PREFERENCE_SMS | PREFERENCE_PUSH;
+
+    /// Loads a tenant's preferences: user_id -> PreferenceBit flags
+    using PreferenceLoader = std::function<std::unordered_map<std::string, uint8_t>(const std::string& tenant_id)>;
+
+    /// Loads every suppressed email address
+    using SuppressionLoader = std::function<std::vector<std::string>()>;
+
+    PreferenceCache(
+        std::shared_ptr<common::DbPool> db_pool,
+        std::shared_ptr<common::EmailQueue> email_queue,
+        const PreferenceCacheOptions& options = {}
+    );
+
+    /// Custom sources (tests)
+    PreferenceCache(PreferenceLoader preferences, SuppressionLoader suppressions,
+                    const PreferenceCacheOptions& options = {});
+
+    PreferenceCache(const PreferenceCache&) = delete;
+    PreferenceCache& operator=(const PreferenceCache&) = delete;
+
+    /**
+     * True if the user accepts notifications on the channel bit
+     *
+     * @throws std::runtime_error if the tenant is not cached and loading fails
+     */
+    bool Allows(const std::string& tenant_id, const std::string& user_id, uint8_t bit);
+
+    /**
+     * True if the address is on the suppression list (hard bounces)
+     *
+     * @throws std::runtime_error if the list is due for a reload and loading fails
+     */
+    bool IsSuppressed(const std::string& email_address);
+
+    /// Record a committed preference row (no-op if the tenant is not cached)
+    void Update(const std::string& tenant_id, const std::string& user_id, uint8_t bits);
+
+    /// Add an address suppressed on this replica
+    void Suppress(const std::string& email_address);
+
+    /// Apply an EncodeChange() message from another replica
+    void ApplyChange(const std::string& message);
+
+    /// Drop everything (e.g. after the change subscription reconnects)
+    void Clear();
+
+    size_t TenantCount() const;
+
+    static uint8_t Bits(bool email, bool sms, bool push, bool marketing);
+
+    /// "tenant_id:user_id:bits"
+    static std::string EncodeChange(const std::string& tenant_id, const std::string& user_id, uint8_t bits);
+
+private:
+    struct TenantEntry {
+        std::unordered_map<std::string, uint8_t> users;
+        std::chrono::steady_clock::time_point loaded_at;
+    };
+
+    using SuppressionSet = std::unordered_set<std::string>;
+
+    PreferenceLoader load_preferences_;
+    SuppressionLoader load_suppressions_;
+    PreferenceCacheOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, TenantEntry> tenants_;
+    std::shared_ptr<const SuppressionSet> suppressed_;
+    std::chrono::steady_clock::time_point suppressed_loaded_at_;
+    // Bumped by every mutation; a load that raced one is used but not cached
+    uint64_t version_ = 0;
+};
+
+} // namespace notification
+} // namespace saasforge
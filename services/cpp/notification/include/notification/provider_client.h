@@ -0,0 +1,148 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Pooled HTTP client with adaptive concurrency for notification providers
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace notification {
+
+/**
+ * One provider API call (always a POST)
+ */
+struct ProviderRequest {
+    std::string url;
+    std::vector<std::string> headers;   // "Name: value" lines
+    std::string body;
+};
+
+/**
+ * Outcome of one provider API call
+ */
+struct ProviderResponse {
+    long status = 0;                            // HTTP status; 0 if no response was received
+    std::string body;
+    std::chrono::milliseconds retry_after{0};   // Retry-After header, if any
+    std::string error;                          // Transport error when status is 0
+
+    bool Ok() const { return status >= 200 && status < 300; }
+
+    /// Rate limited or overloaded: retry later at a lower concurrency
+    bool Throttled() const { return status == 429 || status == 503; }
+};
+
+/**
+ * Provider client options
+ *
+ * FromEnv() reads NOTIFICATION_PROVIDER_INITIAL_CONCURRENCY,
+ * NOTIFICATION_PROVIDER_MIN_CONCURRENCY, NOTIFICATION_PROVIDER_MAX_CONCURRENCY,
+ * NOTIFICATION_PROVIDER_CONNECT_TIMEOUT_MS, NOTIFICATION_PROVIDER_REQUEST_TIMEOUT_MS
+ * and NOTIFICATION_PROVIDER_MAX_ATTEMPTS.
+ */
+struct ProviderClientOptions {
+    size_t initial_concurrency = 8;     // Requests in flight per provider, across all callers
+    size_t min_concurrency = 1;
+    size_t max_concurrency = 64;
+    std::chrono::milliseconds connect_timeout{3000};
+    std::chrono::milliseconds request_timeout{10000};
+    int max_attempts = 3;                               // Per request, counting throttled retries
+    std::chrono::milliseconds max_retry_wait{5000};     // Cap on Retry-After / backoff sleeps
+
+    static ProviderClientOptions FromEnv();
+};
+
+/**
+ * AIMD in-flight limit shared by every caller of one provider
+ *
+ * Each success raises the limit by 1/limit (about +1 per round of
+ * requests); a throttled response halves it and pauses new requests for
+ * the provider's Retry-After, so a 429 storm backs everyone off at once
+ * instead of each caller hammering the provider on its own schedule.
+ */
+class AdaptiveConcurrency {
+public:
+    AdaptiveConcurrency(size_t initial, size_t min, size_t max);
+
+    /**
+     * Block until at least one slot is free and no throttling pause is in
+     * effect, then take up to `wanted` slots
+     *
+     * @return Slots granted (>= 1); hand them back with Release()
+     */
+    size_t Acquire(size_t wanted);
+
+    void Release(size_t slots);
+
+    void OnSuccess();
+    void OnThrottled(std::chrono::milliseconds retry_after);
+
+    size_t Limit() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    double limit_;
+    size_t min_;
+    size_t max_;
+    size_t in_flight_ = 0;
+    std::chrono::steady_clock::time_point paused_until_{};
+};
+
+/**
+ * POSTs to one provider, concurrently and within its adaptive limit
+ *
+ * The libcurl transport keeps connections (and TLS sessions) to the
+ * provider open across calls and callers, and negotiates HTTP/2 so that
+ * concurrent requests multiplex over one connection. Throttled responses
+ * (429/503) are retried after Retry-After, or an exponential backoff, up
+ * to max_attempts in total.
+ *
+ * Usage:
+ *   auto sendgrid = std::make_shared<ProviderClient>(ProviderClientOptions::FromEnv());
+ *   auto responses = sendgrid->Execute(requests);   // same order as requests
+ *
+ * Thread-safe.
+ */
+class ProviderClient {
+public:
+    /// Performs a set of requests concurrently; responses in request order
+    using Transport = std::function<std::vector<ProviderResponse>(const std::vector<const ProviderRequest*>& requests)>;
+
+    /// libcurl transport
+    explicit ProviderClient(const ProviderClientOptions& options = {});
+
+    /// Custom transport (tests)
+    ProviderClient(Transport transport, const ProviderClientOptions& options = {});
+
+    /// Responses in request order; never throws for HTTP or network failures
+    std::vector<ProviderResponse> Execute(const std::vector<ProviderRequest>& requests);
+
+    const AdaptiveConcurrency& Concurrency() const { return concurrency_; }
+
+    /**
+     * Transport that reuses connections across calls
+     *
+     * Connections, DNS results and TLS sessions live in one curl share,
+     * so they survive between calls from any thread.
+     */
+    static Transport CurlTransport(const ProviderClientOptions& options);
+
+private:
+    Transport transport_;
+    ProviderClientOptions options_;
+    AdaptiveConcurrency concurrency_;
+};
+
+} // namespace notification
+} // namespace saasforge
@@ -0,0 +1,345 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description SendGrid, Twilio and FCM sender implementation
+ */
+
+#include "notification/channel_senders.h"
+#include "common/codec.h"
+#include "common/string_builder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace saasforge {
+namespace notification {
+
+namespace {
+
+constexpr const char* TWILIO_API_URL = "https://api.twilio.com/2010-04-01/Accounts/";
+
+DeliveryResult FromResponse(const ProviderResponse& response, const char* provider) {
+    DeliveryResult result;
+    if (response.Ok()) {
+        result.delivered = true;
+        return result;
+    }
+    result.retryable = response.status == 0 || response.Throttled() || response.status >= 500;
+    result.error = std::string(provider) +
+        (response.status == 0 ? ": " + response.error : " HTTP " + std::to_string(response.status));
+    return result;
+}
+
+void AppendFormEncoded(std::string& out, std::string_view value) {
+    static const char* hex = "0123456789ABCDEF";
+    for (unsigned char c : value) {
+        bool unreserved = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                          c == '-' || c == '_' || c == '.' || c == '~';
+        if (unreserved) {
+            out.push_back(static_cast<char>(c));
+        } else {
+            out.push_back('%');
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 0x0f]);
+        }
+    }
+}
+
+// Value of the "error" member of one JSON object, or "" if it has none
+std::string ErrorMember(std::string_view object) {
+    size_t key = object.find("\"error\"");
+    if (key == std::string_view::npos) {
+        return "";
+    }
+    size_t open = object.find('"', object.find(':', key + 7));
+    if (open == std::string_view::npos) {
+        return "";
+    }
+    size_t close = object.find('"', open + 1);
+    if (close == std::string_view::npos) {
+        return "";
+    }
+    return std::string(object.substr(open + 1, close - open - 1));
+}
+
+/**
+ * Indices of items grouped by a content key, groups in first-seen order
+ *
+ * @param key_of Writes item i's key into the given buffer
+ */
+template <typename KeyOf>
+std::vector<std::vector<size_t>> GroupByContent(size_t count, std::vector<std::string>& keys, KeyOf key_of) {
+    std::vector<std::vector<size_t>> groups;
+    std::unordered_map<std::string, size_t> group_of;
+    std::string key;
+    for (size_t i = 0; i < count; ++i) {
+        key.clear();
+        key_of(i, key);
+        auto inserted = group_of.emplace(key, groups.size());
+        if (inserted.second) {
+            groups.emplace_back();
+            keys.push_back(key);
+        }
+        groups[inserted.first->second].push_back(i);
+    }
+    return groups;
+}
+
+} // namespace
+
+SendGridSender::SendGridSender(std::string api_key, std::string from, std::shared_ptr<ProviderClient> client)
+    : authorization_("Authorization: Bearer " + api_key), from_(std::move(from)), client_(std::move(client)) {
+    if (!client_) {
+        throw std::invalid_argument("SendGridSender requires a ProviderClient");
+    }
+}
+
+std::vector<ProviderRequest> SendGridSender::BuildRequests(
+    const std::vector<OutboundEmail>& emails,
+    std::vector<std::vector<size_t>>& recipients
+) const {
+    // The shared part of a request: from, subject and content
+    std::vector<std::string> contents;
+    auto groups = GroupByContent(emails.size(), contents, [&](size_t i, std::string& key) {
+        const OutboundEmail& email = emails[i];
+        key += "\"from\":{\"email\":";
+        common::AppendJsonString(key, from_);
+        key += "},\"subject\":";
+        common::AppendJsonString(key, email.subject);
+        key += ",\"content\":[";
+        // text/plain must come first; SendGrid rejects empty content values
+        if (!email.body_text.empty() || email.body_html.empty()) {
+            key += "{\"type\":\"text/plain\",\"value\":";
+            common::AppendJsonString(key, email.body_text.empty() ? " " : email.body_text);
+            key += '}';
+        }
+        if (!email.body_html.empty()) {
+            key += (key.back() == '}' ? ",{" : "{");
+            key += "\"type\":\"text/html\",\"value\":";
+            common::AppendJsonString(key, email.body_html);
+            key += '}';
+        }
+        key += ']';
+    });
+
+    std::vector<ProviderRequest> requests;
+    recipients.clear();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const auto& group = groups[g];
+        for (size_t begin = 0; begin < group.size(); begin += MAX_PERSONALIZATIONS) {
+            size_t end = std::min(begin + MAX_PERSONALIZATIONS, group.size());
+
+            ProviderRequest request;
+            request.url = API_URL;
+            request.headers = {authorization_, "Content-Type: application/json"};
+            request.body.reserve(contents[g].size() + (end - begin) * 48 + 32);
+            request.body += "{\"personalizations\":[";
+            for (size_t i = begin; i < end; ++i) {
+                request.body += (i > begin ? ",{\"to\":[{\"email\":" : "{\"to\":[{\"email\":");
+                common::AppendJsonString(request.body, emails[group[i]].to);
+                request.body += "}]}";
+            }
+            request.body += "],";
+            request.body += contents[g];
+            request.body += '}';
+
+            requests.push_back(std::move(request));
+            recipients.emplace_back(group.begin() + static_cast<std::ptrdiff_t>(begin),
+                                    group.begin() + static_cast<std::ptrdiff_t>(end));
+        }
+    }
+    return requests;
+}
+
+std::vector<DeliveryResult> SendGridSender::Send(const std::vector<OutboundEmail>& emails) {
+    std::vector<std::vector<size_t>> recipients;
+    auto requests = BuildRequests(emails, recipients);
+    auto responses = client_->Execute(requests);
+
+    // mail/send accepts or rejects a request as a whole
+    std::vector<DeliveryResult> results(emails.size());
+    for (size_t r = 0; r < responses.size(); ++r) {
+        DeliveryResult result = FromResponse(responses[r], "SendGrid");
+        for (size_t index : recipients[r]) {
+            results[index] = result;
+        }
+    }
+    return results;
+}
+
+TwilioSender::TwilioSender(const std::string& account_sid, const std::string& auth_token, std::string from,
+                           std::shared_ptr<ProviderClient> client)
+    : url_(std::string(TWILIO_API_URL) + account_sid + "/Messages.json"),
+      authorization_("Authorization: Basic " + common::Base64Encode(account_sid + ":" + auth_token)),
+      from_(std::move(from)),
+      client_(std::move(client)) {
+    if (!client_) {
+        throw std::invalid_argument("TwilioSender requires a ProviderClient");
+    }
+}
+
+std::vector<DeliveryResult> TwilioSender::Send(const std::vector<OutboundSms>& messages) {
+    std::vector<ProviderRequest> requests(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) {
+        ProviderRequest& request = requests[i];
+        request.url = url_;
+        request.headers = {authorization_, "Content-Type: application/x-www-form-urlencoded"};
+        request.body += "To=";
+        AppendFormEncoded(request.body, messages[i].to);
+        request.body += "&From=";
+        AppendFormEncoded(request.body, from_);
+        request.body += "&Body=";
+        AppendFormEncoded(request.body, messages[i].body);
+    }
+
+    auto responses = client_->Execute(requests);
+    std::vector<DeliveryResult> results;
+    results.reserve(responses.size());
+    for (const auto& response : responses) {
+        results.push_back(FromResponse(response, "Twilio"));
+    }
+    return results;
+}
+
+FcmSender::FcmSender(const std::string& server_key, std::shared_ptr<ProviderClient> client)
+    : authorization_("Authorization: key=" + server_key), client_(std::move(client)) {
+    if (!client_) {
+        throw std::invalid_argument("FcmSender requires a ProviderClient");
+    }
+}
+
+std::vector<DeliveryResult> FcmSender::Send(const std::vector<OutboundPush>& pushes) {
+    std::vector<std::string> contents;
+    auto groups = GroupByContent(pushes.size(), contents, [&](size_t i, std::string& key) {
+        const OutboundPush& push = pushes[i];
+        key += "\"notification\":{\"title\":";
+        common::AppendJsonString(key, push.title);
+        key += ",\"body\":";
+        common::AppendJsonString(key, push.body);
+        key += '}';
+        if (!push.data.empty()) {
+            key += ",\"data\":{";
+            bool first = true;
+            for (const auto& entry : push.data) {
+                if (!first) {
+                    key += ',';
+                }
+                first = false;
+                common::AppendJsonString(key, entry.first);
+                key += ':';
+                common::AppendJsonString(key, entry.second);
+            }
+            key += '}';
+        }
+    });
+
+    std::vector<ProviderRequest> requests;
+    std::vector<std::vector<size_t>> tokens;
+    for (size_t g = 0; g < groups.size(); ++g) {
+        const auto& group = groups[g];
+        for (size_t begin = 0; begin < group.size(); begin += MAX_TOKENS) {
+            size_t end = std::min(begin + MAX_TOKENS, group.size());
+
+            ProviderRequest request;
+            request.url = API_URL;
+            request.headers = {authorization_, "Content-Type: application/json"};
+            request.body += "{\"registration_ids\":[";
+            for (size_t i = begin; i < end; ++i) {
+                if (i > begin) {
+                    request.body += ',';
+                }
+                common::AppendJsonString(request.body, pushes[group[i]].token);
+            }
+            request.body += "],";
+            request.body += contents[g];
+            request.body += '}';
+
+            requests.push_back(std::move(request));
+            tokens.emplace_back(group.begin() + static_cast<std::ptrdiff_t>(begin),
+                                group.begin() + static_cast<std::ptrdiff_t>(end));
+        }
+    }
+
+    auto responses = client_->Execute(requests);
+    std::vector<DeliveryResult> results(pushes.size());
+    for (size_t r = 0; r < responses.size(); ++r) {
+        DeliveryResult result = FromResponse(responses[r], "FCM");
+        if (!result.delivered) {
+            for (size_t index : tokens[r]) {
+                results[index] = result;
+            }
+            continue;
+        }
+
+        auto errors = ParseResults(responses[r].body, tokens[r].size());
+        for (size_t i = 0; i < tokens[r].size(); ++i) {
+            DeliveryResult& token_result = results[tokens[r][i]];
+            if (errors[i].empty()) {
+                token_result.delivered = true;
+                continue;
+            }
+            token_result.retryable = errors[i] == "Unavailable" || errors[i] == "InternalServerError";
+            token_result.error = "FCM " + errors[i];
+        }
+    }
+    return results;
+}
+
+std::vector<std::string> FcmSender::ParseResults(const std::string& body, size_t tokens) {
+    std::vector<std::string> errors(tokens);
+    size_t key = body.find("\"results\"");
+    size_t open = key == std::string::npos ? key : body.find('[', key);
+    if (open == std::string::npos) {
+        return errors;
+    }
+
+    size_t index = 0;
+    size_t object_start = 0;
+    int depth = 0;
+    for (size_t i = open + 1; i < body.size() && index < tokens; ++i) {
+        char c = body[i];
+        if (c == '"') {
+            for (++i; i < body.size() && body[i] != '"'; ++i) {
+                if (body[i] == '\\') {
+                    ++i;
+                }
+            }
+        } else if (c == '{') {
+            if (depth++ == 0) {
+                object_start = i;
+            }
+        } else if (c == '}') {
+            if (--depth == 0) {
+                errors[index++] = ErrorMember(std::string_view(body).substr(object_start, i - object_start + 1));
+            }
+        } else if (c == ']' && depth == 0) {
+            break;
+        }
+    }
+    return errors;
+}
+
+ChannelSenders ChannelSenders::Create(
+    const ProviderClientOptions& options,
+    const std::string& sendgrid_api_key, const std::string& sendgrid_from,
+    const std::string& twilio_account_sid, const std::string& twilio_auth_token, const std::string& twilio_from,
+    const std::string& fcm_server_key
+) {
+    ChannelSenders senders;
+    if (!sendgrid_api_key.empty()) {
+        senders.email = std::make_shared<SendGridSender>(
+            sendgrid_api_key, sendgrid_from, std::make_shared<ProviderClient>(options));
+    }
+    if (!twilio_account_sid.empty() && !twilio_auth_token.empty()) {
+        senders.sms = std::make_shared<TwilioSender>(
+            twilio_account_sid, twilio_auth_token, twilio_from, std::make_shared<ProviderClient>(options));
+    }
+    if (!fcm_server_key.empty()) {
+        senders.push = std::make_shared<FcmSender>(fcm_server_key, std::make_shared<ProviderClient>(options));
+    }
+    return senders;
+}
+
+} // namespace notification
+} // namespace saasforge
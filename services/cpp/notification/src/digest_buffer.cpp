@@ -0,0 +1,466 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Per-user notification digests: coalescing buffers in Redis sorted sets and their flusher implementation
+ */
+
+#include "notification/digest_buffer.h"
+#include "common/email_template.h"
+#include "common/env.h"
+#include "common/id_generator.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/statement_registry.h"
+#include "common/string_builder.h"
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace saasforge {
+namespace notification {
+
+namespace {
+
+constexpr const char* KEY_PREFIX = "{digest}:";
+constexpr const char* DUE_KEY = "{digest}:due";
+
+// Members: 16-byte id (keeps identical notifications apart), then DigestItem::Encode()
+constexpr size_t MEMBER_ID_SIZE = 16;
+constexpr unsigned char ITEM_FORMAT = 1;
+
+// Items expire on their own if their due entry is ever lost
+constexpr int64_t ITEMS_TTL_WINDOWS = 10;
+
+// notification.proto NotificationChannel::PUSH and NotificationStatus::SENT (no protobuf in the worker)
+constexpr int CHANNEL_PUSH = 3;
+constexpr int STATUS_SENT = 2;
+
+const common::PreparedStatement kInsertPushDigest(
+    "notification_insert_push_digest",
+    "INSERT INTO notifications (tenant_id, user_id, channel, status, payload, created_at, sent_at, retry_count) "
+    "VALUES ($1, $2, $3, $4, $5, NOW(), NOW(), 0)");
+
+// ARGV: now (ms), member, buffer id, window (ms), max items, items ttl (ms); returns the buffer size
+const std::string ADD_LUA = R"(
+local score = tonumber(ARGV[1])
+local last = redis.call('ZRANGE', KEYS[1], -1, -1, 'WITHSCORES')
+if last[2] and tonumber(last[2]) >= score then
+    score = tonumber(last[2]) + 1
+end
+redis.call('ZADD', KEYS[1], score, ARGV[2])
+redis.call('PEXPIRE', KEYS[1], ARGV[6])
+local count = redis.call('ZCARD', KEYS[1])
+if count >= tonumber(ARGV[5]) then
+    redis.call('ZADD', KEYS[2], ARGV[1], ARGV[3])
+else
+    redis.call('ZADD', KEYS[2], 'NX', tonumber(ARGV[1]) + tonumber(ARGV[4]), ARGV[3])
+end
+return count
+)";
+
+// ARGV: now (ms), limit, lease (ms), key prefix; returns {buffer id, up_to, n, n members}...
+const std::string CLAIM_LUA = R"(
+local ids = redis.call('ZRANGEBYSCORE', KEYS[1], '-inf', ARGV[1], 'LIMIT', 0, ARGV[2])
+local out = {}
+for _, id in ipairs(ids) do
+    if redis.call('SET', ARGV[4] .. 'lease:' .. id, '1', 'NX', 'PX', ARGV[3]) then
+        redis.call('ZADD', KEYS[1], tonumber(ARGV[1]) + tonumber(ARGV[3]), id)
+        local items = redis.call('ZRANGE', ARGV[4] .. 'items:' .. id, 0, -1, 'WITHSCORES')
+        if #items == 0 then
+            redis.call('ZREM', KEYS[1], id)
+            redis.call('DEL', ARGV[4] .. 'lease:' .. id)
+        else
+            out[#out + 1] = id
+            out[#out + 1] = items[#items]
+            out[#out + 1] = tostring(#items / 2)
+            for i = 1, #items, 2 do
+                out[#out + 1] = items[i]
+            end
+        end
+    end
+end
+return out
+)";
+
+// ARGV: key prefix, buffer id, up_to, now (ms), window (ms)
+const std::string ACK_LUA = R"(
+local items = ARGV[1] .. 'items:' .. ARGV[2]
+redis.call('ZREMRANGEBYSCORE', items, '-inf', ARGV[3])
+redis.call('DEL', ARGV[1] .. 'lease:' .. ARGV[2])
+if redis.call('ZCARD', items) == 0 then
+    redis.call('ZREM', KEYS[1], ARGV[2])
+else
+    redis.call('ZADD', KEYS[1], tonumber(ARGV[4]) + tonumber(ARGV[5]), ARGV[2])
+end
+return 1
+)";
+
+int64_t NowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void PutField(std::string& out, std::string_view field) {
+    auto size = static_cast<uint32_t>(field.size());
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((size >> shift) & 0xff));
+    }
+    out.append(field);
+}
+
+bool GetField(std::string_view& in, std::string& field) {
+    if (in.size() < 4) {
+        return false;
+    }
+    uint32_t size = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        size = (size << 8) | static_cast<unsigned char>(in[i]);
+    }
+    if (in.size() - 4 < size) {
+        return false;
+    }
+    field.assign(in.substr(4, size));
+    in.remove_prefix(4 + size);
+    return true;
+}
+
+const char* ChannelName(DigestChannel channel) {
+    return channel == DigestChannel::EMAIL ? "email" : "push";
+}
+
+// Digest templates (common::CompiledTemplate syntax)
+struct DigestTemplates {
+    common::CompiledTemplate subject = common::CompiledTemplate::Compile("{{subject}} (+{{more}} more)", false);
+    common::CompiledTemplate body_html = common::CompiledTemplate::Compile(
+        "<p>{{count}} notifications</p>{{{items}}}{{{hidden}}}", true);
+    common::CompiledTemplate body_text = common::CompiledTemplate::Compile(
+        "{{count}} notifications\n\n{{items}}{{hidden}}", false);
+    common::CompiledTemplate item_html = common::CompiledTemplate::Compile(
+        "<h3>{{subject}}</h3>{{{body_html}}}", true);
+    common::CompiledTemplate item_text = common::CompiledTemplate::Compile("{{subject}}\n{{body_text}}\n\n", false);
+    common::CompiledTemplate push_item = common::CompiledTemplate::Compile("{{subject}}: {{body_text}}", false);
+
+    static const DigestTemplates& Get() {
+        static const DigestTemplates templates;
+        return templates;
+    }
+};
+
+using Vars = std::unordered_map<std::string, std::string>;
+
+Vars ItemVars(const DigestItem& item) {
+    return {{"subject", item.subject}, {"body_html", item.body_html}, {"body_text", item.body_text}};
+}
+
+} // namespace
+
+DigestOptions DigestOptions::FromEnv() {
+    DigestOptions options;
+    options.window = std::chrono::milliseconds(
+        common::EnvInt("NOTIFICATION_DIGEST_WINDOW_MS", static_cast<long>(options.window.count())));
+    options.max_items = static_cast<size_t>(
+        common::EnvInt("NOTIFICATION_DIGEST_MAX_ITEMS", static_cast<long>(options.max_items)));
+    options.lease = std::chrono::seconds(
+        common::EnvInt("NOTIFICATION_DIGEST_LEASE_S", static_cast<long>(options.lease.count())));
+    options.flush_interval = std::chrono::milliseconds(
+        common::EnvInt("NOTIFICATION_DIGEST_FLUSH_MS", static_cast<long>(options.flush_interval.count())));
+    options.flush_batch = static_cast<size_t>(
+        common::EnvInt("NOTIFICATION_DIGEST_FLUSH_BATCH", static_cast<long>(options.flush_batch)));
+    return options;
+}
+
+std::string DigestItem::Encode() const {
+    std::string out;
+    out.reserve(1 + 6 * 4 + tenant_id.size() + user_id.size() + to.size() + subject.size() +
+                body_html.size() + body_text.size());
+    out.push_back(static_cast<char>(ITEM_FORMAT));
+    for (const std::string* field : {&tenant_id, &user_id, &to, &subject, &body_html, &body_text}) {
+        PutField(out, *field);
+    }
+    return out;
+}
+
+std::optional<DigestItem> DigestItem::Decode(std::string_view encoded) {
+    if (encoded.empty() || static_cast<unsigned char>(encoded[0]) != ITEM_FORMAT) {
+        return std::nullopt;
+    }
+    encoded.remove_prefix(1);
+    DigestItem item;
+    for (std::string* field : {&item.tenant_id, &item.user_id, &item.to, &item.subject, &item.body_html,
+                               &item.body_text}) {
+        if (!GetField(encoded, *field)) {
+            return std::nullopt;
+        }
+    }
+    return item;
+}
+
+DigestStore DigestStore::From(std::shared_ptr<common::RedisClient> redis) {
+    DigestStore store;
+    store.add = [redis](const std::string& buffer_id, const std::string& member, std::chrono::milliseconds window,
+                        size_t max_items) {
+        common::KeyBuilder<> items(KEY_PREFIX, "items:", buffer_id);
+        common::KeyBuilder<24> now(NowMillis()), window_arg(window.count()),
+            max_arg(static_cast<int64_t>(max_items)), ttl(window.count() * ITEMS_TTL_WINDOWS + 60000);
+        auto count = redis->EvalScript(ADD_LUA, {items.View(), DUE_KEY},
+                                       {now.View(), member, buffer_id, window_arg.View(), max_arg.View(), ttl.View()});
+        return static_cast<size_t>(std::max<long long>(count, 0));
+    };
+    store.claim = [redis](size_t limit, std::chrono::seconds lease) {
+        common::KeyBuilder<24> now(NowMillis()), limit_arg(static_cast<int64_t>(limit)),
+            lease_ms(std::max<int64_t>(lease.count(), 1) * 1000);
+        auto reply = redis->EvalScriptStrings(CLAIM_LUA, {DUE_KEY},
+                                              {now.View(), limit_arg.View(), lease_ms.View(), KEY_PREFIX});
+        std::vector<DigestClaim> claims;
+        for (size_t i = 0; i + 3 <= reply.size();) {
+            DigestClaim claim;
+            claim.buffer_id = reply[i].value_or("");
+            claim.up_to = reply[i + 1].value_or("0");
+            size_t count = std::strtoull(reply[i + 2].value_or("0").c_str(), nullptr, 10);
+            i += 3;
+            if (reply.size() - i < count) {
+                throw std::runtime_error("Unexpected digest claim reply");
+            }
+            for (size_t j = 0; j < count; ++j, ++i) {
+                claim.items.push_back(reply[i].value_or(""));
+            }
+            claims.push_back(std::move(claim));
+        }
+        return claims;
+    };
+    store.ack = [redis](const DigestClaim& claim, std::chrono::milliseconds window) {
+        common::KeyBuilder<24> now(NowMillis()), window_arg(window.count());
+        redis->EvalScript(ACK_LUA, {DUE_KEY},
+                          {KEY_PREFIX, claim.buffer_id, claim.up_to, now.View(), window_arg.View()});
+    };
+    return store;
+}
+
+DigestBuffer::DigestBuffer(DigestStore store, const DigestOptions& options)
+    : store_(std::move(store)), options_(options) {
+    options_.max_items = std::max<size_t>(options_.max_items, 1);
+    metrics_collector_ = common::MetricsRegistry::Global().AddCollector([this](common::MetricsWriter& writer) {
+        writer.AddCounter("saasforge_notification_digest_buffered_total",
+                          "Notifications held for a digest instead of sent", {},
+                          static_cast<double>(buffered_.load()));
+    });
+}
+
+DigestBuffer::~DigestBuffer() {
+    common::MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+std::string DigestBuffer::BufferId(DigestChannel channel, const DigestItem& item, const std::string& coalescing_key) {
+    std::string id;
+    id.reserve(8 + item.tenant_id.size() + item.user_id.size() + coalescing_key.size());
+    id.append(ChannelName(channel)).append(":").append(item.tenant_id).append(":").append(item.user_id);
+    id.append(":").append(coalescing_key);
+    return id;
+}
+
+size_t DigestBuffer::Add(DigestChannel channel, const std::string& coalescing_key, const DigestItem& item) {
+    if (coalescing_key.empty() || coalescing_key.size() > MAX_KEY_LENGTH) {
+        throw std::invalid_argument("coalescing_key must be 1 to 128 characters");
+    }
+    auto id = common::IdGenerator::Next();
+    std::string member(reinterpret_cast<const char*>(id.data()), id.size());
+    member += item.Encode();
+    size_t count = store_.add(BufferId(channel, item, coalescing_key), member, options_.window, options_.max_items);
+    ++buffered_;
+    return count;
+}
+
+std::optional<Digest> DigestBuffer::Merge(const DigestClaim& claim, size_t max_items) {
+    std::vector<DigestItem> items;
+    items.reserve(claim.items.size());
+    for (const auto& member : claim.items) {
+        if (member.size() < MEMBER_ID_SIZE) {
+            continue;
+        }
+        if (auto item = DigestItem::Decode(std::string_view(member).substr(MEMBER_ID_SIZE))) {
+            items.push_back(std::move(*item));
+        }
+    }
+    if (items.empty()) {
+        return std::nullopt;
+    }
+
+    Digest digest;
+    digest.channel = claim.buffer_id.rfind("push:", 0) == 0 ? DigestChannel::PUSH : DigestChannel::EMAIL;
+    std::string prefix = BufferId(digest.channel, items.front(), "");
+    if (claim.buffer_id.compare(0, prefix.size(), prefix) == 0) {
+        digest.coalescing_key = claim.buffer_id.substr(prefix.size());
+    }
+    digest.count = items.size();
+    if (items.size() == 1) {
+        digest.merged = std::move(items.front());
+        return digest;
+    }
+
+    const DigestTemplates& templates = DigestTemplates::Get();
+    size_t listed = std::min(items.size(), std::max<size_t>(max_items, 1));
+    Vars vars = {{"subject", items.front().subject},
+                 {"count", std::to_string(items.size())},
+                 {"more", std::to_string(items.size() - 1)}};
+
+    DigestItem& merged = digest.merged;
+    merged.tenant_id = items.back().tenant_id;
+    merged.user_id = items.back().user_id;
+    merged.to = items.back().to;
+    templates.subject.Render(vars, merged.subject);
+
+    if (digest.channel == DigestChannel::PUSH) {
+        for (size_t i = 0; i < listed; ++i) {
+            if (i > 0) {
+                merged.body_text += '\n';
+            }
+            templates.push_item.Render(ItemVars(items[i]), merged.body_text);
+        }
+        if (listed < items.size()) {
+            merged.body_text += "\n+" + std::to_string(items.size() - listed) + " more";
+        }
+        return digest;
+    }
+
+    std::string items_html;
+    std::string items_text;
+    for (size_t i = 0; i < listed; ++i) {
+        Vars item_vars = ItemVars(items[i]);
+        templates.item_html.Render(item_vars, items_html);
+        templates.item_text.Render(item_vars, items_text);
+    }
+    vars["items"] = std::move(items_html);
+    if (listed < items.size()) {
+        vars["hidden"] = "<p>and " + std::to_string(items.size() - listed) + " more</p>";
+    }
+    templates.body_html.Render(vars, merged.body_html);
+    vars["items"] = std::move(items_text);
+    if (listed < items.size()) {
+        vars["hidden"] = "and " + std::to_string(items.size() - listed) + " more\n";
+    }
+    templates.body_text.Render(vars, merged.body_text);
+    return digest;
+}
+
+DigestFlusher::DigestFlusher(DigestStore store, Deliver deliver, const DigestOptions& options)
+    : store_(std::move(store)), deliver_(std::move(deliver)), options_(options) {
+    options_.max_items = std::max<size_t>(options_.max_items, 1);
+    options_.flush_batch = std::max<size_t>(options_.flush_batch, 1);
+    if (options_.flush_interval.count() <= 0) {
+        options_.flush_interval = std::chrono::milliseconds(1000);
+    }
+    metrics_collector_ = common::MetricsRegistry::Global().AddCollector([this](common::MetricsWriter& writer) {
+        auto stats = GetStats();
+        writer.AddCounter("saasforge_notification_digests_flushed_total", "Digests delivered", {},
+                          static_cast<double>(stats.flushed));
+        writer.AddCounter("saasforge_notification_digest_merged_total", "Notifications merged into delivered digests",
+                          {}, static_cast<double>(stats.merged));
+        writer.AddCounter("saasforge_notification_digest_failures_total",
+                          "Digest deliveries that failed and wait for their lease", {},
+                          static_cast<double>(stats.failed));
+    });
+    thread_ = std::thread(&DigestFlusher::Run, this);
+}
+
+DigestFlusher::~DigestFlusher() {
+    Shutdown();
+    common::MetricsRegistry::Global().RemoveCollector(metrics_collector_);
+}
+
+void DigestFlusher::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+size_t DigestFlusher::FlushDue() {
+    auto claims = store_.claim(options_.flush_batch, options_.lease);
+    for (const auto& claim : claims) {
+        auto digest = DigestBuffer::Merge(claim, options_.max_items);
+        if (!digest) {
+            common::LogWarn("Digest had no readable items", {{"buffer", claim.buffer_id}});
+            store_.ack(claim, options_.window);
+            ++dropped_;
+            continue;
+        }
+        try {
+            deliver_(*digest);
+        } catch (const std::exception& e) {
+            // Left leased: claimed again, with anything added meanwhile, once the lease expires
+            common::LogWarn("Digest delivery failed", {{"buffer", claim.buffer_id}, {"error", e.what()}});
+            ++failed_;
+            continue;
+        }
+        store_.ack(claim, options_.window);
+        ++flushed_;
+        merged_ += digest->count;
+    }
+    return claims.size();
+}
+
+void DigestFlusher::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        cv_.wait_for(lock, options_.flush_interval, [this] { return stopping_; });
+        while (!stopping_) {
+            lock.unlock();
+            size_t claimed = 0;
+            try {
+                claimed = FlushDue();
+            } catch (const std::exception& e) {
+                common::LogWarn("Digest flush failed", {{"error", e.what()}});
+            }
+            lock.lock();
+            if (claimed < options_.flush_batch) {
+                break;
+            }
+        }
+    }
+}
+
+DigestFlusherStats DigestFlusher::GetStats() const {
+    DigestFlusherStats stats;
+    stats.flushed = flushed_.load();
+    stats.merged = merged_.load();
+    stats.failed = failed_.load();
+    stats.dropped = dropped_.load();
+    return stats;
+}
+
+DigestFlusher::Deliver DigestFlusher::QueueDelivery(std::shared_ptr<common::DbPool> db_pool,
+                                                    std::shared_ptr<common::EmailQueue> email_queue) {
+    return [db_pool, email_queue](const Digest& digest) {
+        const DigestItem& item = digest.merged;
+        if (digest.channel == DigestChannel::EMAIL) {
+            email_queue->Enqueue(item.tenant_id, item.user_id, item.to, item.subject, item.body_html, item.body_text);
+            return;
+        }
+
+        common::LogDebug("Mock: Sending push digest", {{"title", item.subject}, {"count", digest.count}});
+        std::string payload;
+        payload.reserve(item.subject.size() + item.body_text.size() + 48);
+        payload += "{\"title\":";
+        common::AppendJsonString(payload, item.subject);
+        payload += ",\"body\":";
+        common::AppendJsonString(payload, item.body_text);
+        payload += ",\"digest_count\":";
+        payload += std::to_string(digest.count);
+        payload += '}';
+
+        auto conn_guard = db_pool->AcquireConnection("DigestFlusher::Deliver");
+        pqxx::work txn(*conn_guard);
+        common::ExecPrepared(txn, kInsertPushDigest, item.tenant_id, item.user_id, CHANNEL_PUSH, STATUS_SENT, payload);
+        txn.commit();
+        db_pool->RecordWrite(item.tenant_id);
+    };
+}
+
+} // namespace notification
+} // namespace saasforge
@@ -0,0 +1,493 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Multi-threaded email_queue consumer: claim, pipelined provider sends, batched acks implementation
+ */
+
+#include "notification/email_worker.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace saasforge {
+namespace notification {
+
+namespace {
+
+// Attempts of the last result write at shutdown, before the rows are left in SENDING
+constexpr int FINAL_FLUSH_ATTEMPTS = 3;
+
+std::vector<std::string> IdsOf(const std::vector<common::QueuedEmail>& emails) {
+    std::vector<std::string> ids;
+    ids.reserve(emails.size());
+    for (const auto& email : emails) {
+        ids.push_back(email.id);
+    }
+    return ids;
+}
+
+} // namespace
+
+EmailWorkerOptions EmailWorkerOptions::FromEnv() {
+    EmailWorkerOptions options;
+    options.dequeue_threads = static_cast<size_t>(
+        common::EnvInt("EMAIL_WORKER_DEQUEUE_THREADS", static_cast<long>(options.dequeue_threads)));
+    options.send_threads = static_cast<size_t>(
+        common::EnvInt("EMAIL_WORKER_SEND_THREADS", static_cast<long>(options.send_threads)));
+    options.batch_size = static_cast<int>(common::EnvInt("EMAIL_WORKER_BATCH_SIZE", options.batch_size));
+    options.max_pending_batches = static_cast<size_t>(
+        common::EnvInt("EMAIL_WORKER_MAX_PENDING_BATCHES", static_cast<long>(options.max_pending_batches)));
+    options.idle_wait = std::chrono::milliseconds(
+        common::EnvInt("EMAIL_WORKER_IDLE_WAIT_MS", static_cast<long>(options.idle_wait.count())));
+    options.ack_interval = std::chrono::milliseconds(
+        common::EnvInt("EMAIL_WORKER_ACK_INTERVAL_MS", static_cast<long>(options.ack_interval.count())));
+    options.ack_max = static_cast<size_t>(common::EnvInt("EMAIL_WORKER_ACK_MAX", static_cast<long>(options.ack_max)));
+    options.hold_max = std::chrono::milliseconds(
+        common::EnvInt("EMAIL_WORKER_RETRY_HOLD_MAX_MS", static_cast<long>(options.hold_max.count())));
+    options.hold_lease = std::chrono::seconds(
+        common::EnvInt("EMAIL_WORKER_RETRY_HOLD_LEASE_S", static_cast<long>(options.hold_lease.count())));
+    options.max_held = static_cast<size_t>(
+        common::EnvInt("EMAIL_WORKER_MAX_HELD_RETRIES", static_cast<long>(options.max_held)));
+    return options;
+}
+
+EmailWorkerQueue EmailWorkerQueue::From(std::shared_ptr<common::EmailQueue> queue) {
+    EmailWorkerQueue ops;
+    ops.wait_for_batch = [queue](int batch_size, std::chrono::milliseconds max_wait) {
+        return queue->WaitForBatch(batch_size, max_wait);
+    };
+    ops.mark_sent = [queue](const std::vector<std::string>& ids) { return queue->MarkSentBatch(ids); };
+    ops.mark_failed = [queue](const std::vector<common::EmailFailure>& failures, std::chrono::seconds hold_lease) {
+        return queue->MarkFailedBatch(failures, hold_lease);
+    };
+    ops.release = [queue](const std::vector<std::string>& ids) { return queue->ReleaseBatch(ids); };
+    ops.reclaim_held = [queue](const Emails& held) { return queue->ReclaimHeldBatch(held); };
+    ops.release_held = [queue](const Emails& held, std::chrono::seconds hold_lease) {
+        return queue->ReleaseHeldBatch(held, hold_lease);
+    };
+    ops.decode = [queue](common::QueuedEmail& email) { queue->DecodeBodies(email); };
+    return ops;
+}
+
+EmailWorker::Send EmailWorker::ProviderSend(std::shared_ptr<SendGridSender> sender) {
+    if (sender) {
+        return [sender](const std::vector<OutboundEmail>& emails) { return sender->Send(emails); };
+    }
+    return [](const std::vector<OutboundEmail>& emails) {
+        std::vector<DeliveryResult> results(emails.size());
+        for (size_t i = 0; i < emails.size(); ++i) {
+            common::LogDebug("Mock: Sending email", {{"to", emails[i].to}});
+            results[i].delivered = true;
+        }
+        return results;
+    };
+}
+
+EmailWorker::EmailWorker(EmailWorkerQueue queue, Send send, const EmailWorkerOptions& options)
+    : queue_(std::move(queue)), send_(std::move(send)), options_(options) {
+    options_.dequeue_threads = std::max<size_t>(options_.dequeue_threads, 1);
+    options_.send_threads = std::max<size_t>(options_.send_threads, 1);
+    options_.batch_size = std::max(options_.batch_size, 1);
+    options_.max_pending_batches = std::max<size_t>(options_.max_pending_batches, 1);
+    options_.ack_max = std::max<size_t>(options_.ack_max, 1);
+    if (options_.idle_wait.count() <= 0) {
+        options_.idle_wait = std::chrono::milliseconds(1000);
+    }
+    if (options_.ack_interval.count() <= 0) {
+        options_.ack_interval = std::chrono::milliseconds(200);
+    }
+    if (!queue_.reclaim_held || !queue_.release_held) {
+        options_.hold_max = std::chrono::milliseconds(0);
+    }
+
+    ack_thread_ = std::thread(&EmailWorker::AckLoop, this);
+    for (size_t i = 0; i < options_.send_threads; ++i) {
+        send_threads_.emplace_back(&EmailWorker::SendLoop, this);
+    }
+    for (size_t i = 0; i < options_.dequeue_threads; ++i) {
+        dequeue_threads_.emplace_back(&EmailWorker::DequeueLoop, this);
+    }
+    common::LogInfo("Email worker started", {
+        {"dequeue_threads", options_.dequeue_threads},
+        {"send_threads", options_.send_threads},
+        {"batch_size", options_.batch_size}});
+}
+
+EmailWorker::~EmailWorker() {
+    Shutdown();
+}
+
+void EmailWorker::DequeueLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(batches_mutex_);
+            capacity_cv_.wait(lock, [this] {
+                return stopping_ || batches_.size() < options_.max_pending_batches;
+            });
+            if (stopping_) {
+                return;
+            }
+        }
+
+        std::vector<common::QueuedEmail> batch;
+        try {
+            batch = queue_.wait_for_batch(options_.batch_size, options_.idle_wait);
+        } catch (const std::exception& e) {
+            common::LogError("Claiming emails failed", {{"error", e.what()}});
+            std::unique_lock<std::mutex> lock(batches_mutex_);
+            capacity_cv_.wait_for(lock, options_.idle_wait, [this] { return stopping_; });
+            continue;
+        }
+        if (batch.empty()) {
+            continue;
+        }
+        claimed_ += batch.size();
+
+        std::unique_lock<std::mutex> lock(batches_mutex_);
+        if (stopping_) {
+            lock.unlock();
+            // Claimed during shutdown: straight back to the queue, untouched
+            try {
+                released_ += queue_.release(IdsOf(batch));
+            } catch (const std::exception& e) {
+                common::LogError("Releasing emails failed", {{"emails", batch.size()}, {"error", e.what()}});
+            }
+            return;
+        }
+        batches_.push_back(std::move(batch));
+        lock.unlock();
+        batches_cv_.notify_one();
+    }
+}
+
+void EmailWorker::SendLoop() {
+    while (true) {
+        std::vector<common::QueuedEmail> batch;
+        {
+            std::unique_lock<std::mutex> lock(batches_mutex_);
+            batches_cv_.wait(lock, [this] { return stopping_ || !batches_.empty(); });
+            if (stopping_) {
+                return;   // Batches still queued are released by Shutdown()
+            }
+            batch = std::move(batches_.front());
+            batches_.pop_front();
+        }
+        capacity_cv_.notify_one();
+
+        // Bodies are inflated here, by the send threads, and only for rows about to go out
+        std::vector<OutboundEmail> emails;
+        std::vector<size_t> positions;   // Batch index of each email sent
+        std::vector<DeliveryResult> results(batch.size(),
+                                            DeliveryResult{false, true, "Stored body could not be decoded"});
+        emails.reserve(batch.size());
+        positions.reserve(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto& queued = batch[i];
+            if (queue_.decode) {
+                try {
+                    queue_.decode(queued);
+                } catch (const std::exception& e) {
+                    common::LogWarn("Failed to decode email body", {{"email_id", queued.id}, {"error", e.what()}});
+                    continue;
+                }
+            }
+            emails.push_back({queued.to_address, queued.subject, queued.body_html, queued.body_text});
+            positions.push_back(i);
+        }
+
+        std::vector<DeliveryResult> sent;
+        try {
+            if (!emails.empty()) {
+                sent = send_(emails);
+            }
+        } catch (const std::exception& e) {
+            sent.clear();
+            common::LogError("Sending emails failed", {{"emails", emails.size()}, {"error", e.what()}});
+        }
+        if (sent.size() != emails.size()) {
+            sent.assign(emails.size(), DeliveryResult{false, true, "Provider returned no result"});
+        }
+        for (size_t j = 0; j < sent.size(); ++j) {
+            results[positions[j]] = std::move(sent[j]);
+        }
+
+        bool flush_now = false;
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(acks_mutex_);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (results[i].delivered) {
+                    sent_ids_.push_back(std::move(batch[i].id));
+                    continue;
+                }
+                // A short backoff is waited out here; the table only sees it if we die
+                auto& email = batch[i];
+                auto delay = std::chrono::seconds(common::EmailQueue::GetRetryDelay(email.retry_count + 1));
+                bool hold = email.retry_count < common::EmailQueue::MAX_RETRIES && delay <= options_.hold_max &&
+                            held_count_.load() + to_hold_.size() < options_.max_held;
+                failures_.push_back({email.id, results[i].error, false, hold});
+                if (hold) {
+                    ++email.retry_count;
+                    to_hold_.push_back({std::move(email), now + delay});
+                }
+            }
+            flush_now = sent_ids_.size() + failures_.size() >= options_.ack_max;
+        }
+        if (flush_now) {
+            acks_cv_.notify_one();
+        }
+    }
+}
+
+void EmailWorker::AckLoop() {
+    std::unique_lock<std::mutex> lock(acks_mutex_);
+    while (true) {
+        // Woken early by the next held retry
+        auto deadline = std::chrono::steady_clock::now() + options_.ack_interval;
+        if (auto next = held_.NextDue()) {
+            deadline = std::min(deadline, *next);
+        }
+        acks_cv_.wait_until(lock, deadline, [this] {
+            return sending_done_ || sent_ids_.size() + failures_.size() >= options_.ack_max;
+        });
+        bool done = sending_done_;
+        lock.unlock();
+
+        bool flushed = FlushAcks();
+        for (int attempt = 1; done && !flushed && attempt < FINAL_FLUSH_ATTEMPTS; ++attempt) {
+            std::this_thread::sleep_for(options_.ack_interval);
+            flushed = FlushAcks();
+        }
+        if (done) {
+            if (!flushed) {
+                std::lock_guard<std::mutex> relock(acks_mutex_);
+                common::LogError("Email results not written; rows stay in SENDING", {
+                    {"sent", sent_ids_.size()}, {"failed", failures_.size()}});
+            }
+            ReleaseHeld();
+            return;
+        }
+        ResendHeld();
+        lock.lock();
+    }
+}
+
+bool EmailWorker::FlushAcks() {
+    std::vector<std::string> sent;
+    std::vector<common::EmailFailure> failures;
+    std::vector<Held> to_hold;
+    {
+        std::lock_guard<std::mutex> lock(acks_mutex_);
+        sent.swap(sent_ids_);
+        failures.swap(failures_);
+        to_hold.swap(to_hold_);
+    }
+    if (sent.empty() && failures.empty()) {
+        return true;
+    }
+
+    bool ok = true;
+    if (!sent.empty()) {
+        try {
+            queue_.mark_sent(sent);
+            sent_ += sent.size();
+            sent.clear();
+        } catch (const std::exception& e) {
+            ok = false;
+            ++failed_acks_;
+            common::LogError("Marking emails sent failed", {{"emails", sent.size()}, {"error", e.what()}});
+        }
+    }
+    if (!failures.empty()) {
+        try {
+            queue_.mark_failed(failures, options_.hold_lease);
+            failed_ += failures.size();
+            failures.clear();
+            // Only now is each held retry recorded, and kept from other workers
+            for (auto& held : to_hold) {
+                auto due = held.due;
+                held_.Schedule(std::move(held), due);
+            }
+            to_hold.clear();
+            held_count_.store(held_.Size());
+        } catch (const std::exception& e) {
+            ok = false;
+            ++failed_acks_;
+            common::LogError("Recording email failures failed", {{"emails", failures.size()}, {"error", e.what()}});
+        }
+    }
+    if (ok) {
+        ++ack_batches_;
+        return true;
+    }
+
+    // Kept for the next flush, ahead of anything buffered since
+    std::lock_guard<std::mutex> lock(acks_mutex_);
+    sent.insert(sent.end(), std::make_move_iterator(sent_ids_.begin()), std::make_move_iterator(sent_ids_.end()));
+    sent_ids_.swap(sent);
+    failures.insert(failures.end(), std::make_move_iterator(failures_.begin()),
+                    std::make_move_iterator(failures_.end()));
+    failures_.swap(failures);
+    to_hold.insert(to_hold.end(), std::make_move_iterator(to_hold_.begin()), std::make_move_iterator(to_hold_.end()));
+    to_hold_.swap(to_hold);
+    return false;
+}
+
+void EmailWorker::ResendHeld() {
+    if (held_.Empty()) {
+        return;
+    }
+    auto due = held_.Advance(std::chrono::steady_clock::now());
+    if (due.empty()) {
+        return;
+    }
+
+    std::vector<common::QueuedEmail> emails;
+    emails.reserve(due.size());
+    for (auto& held : due) {
+        emails.push_back(std::move(held.email));
+    }
+
+    std::vector<std::string> reclaimed;
+    try {
+        reclaimed = queue_.reclaim_held(emails);
+    } catch (const std::exception& e) {
+        // Still held in the table; try again next interval
+        common::LogError("Reclaiming held email retries failed", {{"emails", emails.size()}, {"error", e.what()}});
+        auto retry_at = std::chrono::steady_clock::now() + options_.ack_interval;
+        for (auto& email : emails) {
+            held_.Schedule({std::move(email), retry_at}, retry_at);
+        }
+        held_count_.store(held_.Size());
+        return;
+    }
+    held_count_.store(held_.Size());
+
+    // An email not reclaimed was taken by another worker after the lease
+    std::unordered_set<std::string> owned(std::make_move_iterator(reclaimed.begin()),
+                                          std::make_move_iterator(reclaimed.end()));
+    std::vector<common::QueuedEmail> batch;
+    for (auto& email : emails) {
+        if (owned.count(email.id)) {
+            batch.push_back(std::move(email));
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+    resent_ += batch.size();
+
+    std::unique_lock<std::mutex> lock(batches_mutex_);
+    if (stopping_) {
+        // Send threads are going away: back to the queue with the rest
+        lock.unlock();
+        try {
+            released_ += queue_.release(IdsOf(batch));
+        } catch (const std::exception& e) {
+            common::LogError("Releasing emails failed", {{"emails", batch.size()}, {"error", e.what()}});
+        }
+        return;
+    }
+    batches_.push_back(std::move(batch));
+    lock.unlock();
+    batches_cv_.notify_one();
+}
+
+void EmailWorker::ReleaseHeld() {
+    auto held = held_.Drain();
+    held_count_.store(0);
+    if (held.empty()) {
+        return;
+    }
+    std::vector<common::QueuedEmail> emails;
+    emails.reserve(held.size());
+    for (auto& entry : held) {
+        emails.push_back(std::move(entry.email));
+    }
+    try {
+        size_t released = queue_.release_held(emails, options_.hold_lease);
+        common::LogInfo("Released held email retries", {{"held", emails.size()}, {"released", released}});
+    } catch (const std::exception& e) {
+        // Still claimable once the hold lease passes
+        common::LogError("Releasing held email retries failed", {{"emails", emails.size()}, {"error", e.what()}});
+    }
+}
+
+void EmailWorker::Shutdown() {
+    std::lock_guard<std::mutex> shutdown_lock(shutdown_mutex_);
+    if (shutdown_) {
+        return;
+    }
+    shutdown_ = true;
+
+    {
+        std::lock_guard<std::mutex> lock(batches_mutex_);
+        stopping_ = true;
+    }
+    batches_cv_.notify_all();
+    capacity_cv_.notify_all();
+
+    // Claims in progress return within idle_wait; provider calls finish
+    for (auto& thread : dequeue_threads_) {
+        thread.join();
+    }
+    for (auto& thread : send_threads_) {
+        thread.join();
+    }
+
+    std::vector<std::string> unsent;
+    {
+        std::lock_guard<std::mutex> lock(batches_mutex_);
+        for (const auto& batch : batches_) {
+            for (const auto& email : batch) {
+                unsent.push_back(email.id);
+            }
+        }
+        batches_.clear();
+    }
+    if (!unsent.empty()) {
+        try {
+            released_ += queue_.release(unsent);
+        } catch (const std::exception& e) {
+            common::LogError("Releasing emails failed", {{"emails", unsent.size()}, {"error", e.what()}});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(acks_mutex_);
+        sending_done_ = true;
+    }
+    acks_cv_.notify_all();
+    ack_thread_.join();
+
+    auto stats = GetStats();
+    common::LogInfo("Email worker stopped", {
+        {"claimed", stats.claimed}, {"sent", stats.sent}, {"failed", stats.failed}, {"released", stats.released}});
+}
+
+EmailWorkerStats EmailWorker::GetStats() const {
+    EmailWorkerStats stats;
+    stats.claimed = claimed_.load();
+    stats.sent = sent_.load();
+    stats.failed = failed_.load();
+    stats.released = released_.load();
+    stats.ack_batches = ack_batches_.load();
+    stats.failed_acks = failed_acks_.load();
+    stats.held = held_count_.load();
+    stats.resent = resent_.load();
+    {
+        std::lock_guard<std::mutex> lock(batches_mutex_);
+        stats.pending_batches = batches_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(acks_mutex_);
+        stats.unacked = sent_ids_.size() + failures_.size();
+    }
+    return stats;
+}
+
+} // namespace notification
+} // namespace saasforge
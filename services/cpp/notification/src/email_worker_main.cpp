@@ -0,0 +1,119 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description email_worker: delivers email_queue through SendGrid and flushes notification digests (replaces api/workers/email_worker.py)
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "notification/channel_senders.h"
+#include "notification/digest_buffer.h"
+#include "notification/email_worker.h"
+#include "common/allocator_stats.h"
+#include "common/db_pool.h"
+#include "common/email_queue.h"
+#include "common/event_bus.h"
+#include "common/graceful_shutdown.h"
+#include "common/logger.h"
+#include "common/metrics_server.h"
+#include "common/queue_notifier.h"
+#include "common/redis_client.h"
+#include "common/suppression_filter.h"
+#include "common/tracing.h"
+#include "common/warmup.h"
+
+void RunWorker() {
+    // Load configuration
+    const char* db_url_env = std::getenv("DATABASE_URL");
+    const char* redis_url_env = std::getenv("REDIS_URL");
+    const char* sendgrid_api_key_env = std::getenv("SENDGRID_API_KEY");
+    const char* sendgrid_from_env = std::getenv("SENDGRID_FROM_EMAIL");
+
+    std::string db_url = db_url_env ? db_url_env : "postgresql://localhost/saasforge";
+    std::string redis_url = redis_url_env ? redis_url_env : "tcp://127.0.0.1:6379";
+
+    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, saasforge::common::DbPoolOptions::FromEnv());
+    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url, saasforge::common::RedisOptions::FromEnv());
+
+    // One LISTEN connection wakes every dequeue thread on enqueue
+    auto notifier = std::make_shared<saasforge::common::QueueNotifier>(
+        db_url,
+        std::vector<std::string>{saasforge::common::EmailQueue::NOTIFY_CHANNEL},
+        saasforge::common::QueueNotifierOptions::FromEnv());
+
+    // Suppressions from every replica reach the filter over the event bus (EVENT_BUS_*)
+    auto event_bus = std::make_shared<saasforge::common::EventBus>(
+        redis_client, saasforge::common::EventBusOptions::FromEnv());
+    auto suppressions = std::make_shared<saasforge::common::SuppressionFilter>(
+        db_pool, event_bus, saasforge::common::SuppressionFilterOptions::FromEnv());
+    auto email_queue = std::make_shared<saasforge::common::EmailQueue>(
+        db_pool, notifier, saasforge::common::EmailQueueOptions::FromEnv(), suppressions);
+
+    // SendGrid only with credentials; without them sends are logged and marked sent
+    auto senders = saasforge::notification::ChannelSenders::Create(
+        saasforge::notification::ProviderClientOptions::FromEnv(),
+        sendgrid_api_key_env ? sendgrid_api_key_env : "",
+        sendgrid_from_env ? sendgrid_from_env : "noreply@saasforge.local",
+        "", "", "", "");
+    std::cout << "Email provider: " << (senders.email ? "SendGrid" : "mock") << std::endl;
+
+    // SIGTERM before warm-up finishes is not lost
+    saasforge::common::GracefulShutdown shutdown(saasforge::common::ShutdownOptions::FromEnv());
+
+    saasforge::common::Warmup warmup(saasforge::common::WarmupOptions::FromEnv());
+    warmup.Add("database", saasforge::common::Warmup::PingDatabase(db_pool), true);
+    if (!warmup.Run(nullptr)) {
+        throw std::runtime_error("Warm-up failed");
+    }
+
+    // Dequeue, send and ack threads (EMAIL_WORKER_*)
+    auto worker = std::make_unique<saasforge::notification::EmailWorker>(
+        saasforge::notification::EmailWorkerQueue::From(email_queue),
+        saasforge::notification::EmailWorker::ProviderSend(senders.email),
+        saasforge::notification::EmailWorkerOptions::FromEnv());
+
+    // Due digests (NOTIFICATION_DIGEST_*) become email_queue rows the worker above sends
+    auto digest_flusher = std::make_unique<saasforge::notification::DigestFlusher>(
+        saasforge::notification::DigestStore::From(redis_client),
+        saasforge::notification::DigestFlusher::QueueDelivery(db_pool, email_queue),
+        saasforge::notification::DigestOptions::FromEnv());
+
+    // Prometheus scrape endpoint (METRICS_PORT, 0 = disabled)
+    auto metrics_options = saasforge::common::MetricsServerOptions::FromEnv();
+    std::unique_ptr<saasforge::common::MetricsServer> metrics_server;
+    if (metrics_options.port != 0) {
+        saasforge::common::ExportAllocatorMetrics(saasforge::common::MetricsRegistry::Global());
+        metrics_server = std::make_unique<saasforge::common::MetricsServer>(
+            saasforge::common::MetricsRegistry::Global(), metrics_options);
+        std::cout << "Metrics available on :" << metrics_server->Port() << "/metrics" << std::endl;
+    }
+
+    // No RPCs to drain: stop claiming, write results, hand back whatever is still claimed
+    shutdown.Add("digests", [&digest_flusher] { digest_flusher->Shutdown(); });
+    shutdown.Add("email_worker", [&worker] { worker->Shutdown(); });
+    shutdown.Add("email_queue", [&email_queue] { email_queue->ReleaseClaimed(); });
+    shutdown.Add("suppressions", [&suppressions] { suppressions->Shutdown(); });
+    shutdown.Add("event_bus", [&event_bus] { event_bus->Shutdown(); });
+    shutdown.Add("notifier", [&notifier] { notifier->Shutdown(); });
+    shutdown.Add("database", [&db_pool, &shutdown] { db_pool->Shutdown(shutdown.Options().close_timeout); });
+    shutdown.Add("metrics", [&metrics_server] {
+        if (metrics_server) {
+            metrics_server->Shutdown();
+        }
+    });
+    shutdown.Add("tracing", [] { saasforge::common::Tracer::Global().Shutdown(); });
+
+    std::cout << "Email worker running" << std::endl;
+    shutdown.Wait();
+    shutdown.Run(nullptr, nullptr);
+    saasforge::common::Logger::Global().Flush();
+}
+
+int main(int argc, char** argv) {
+    RunWorker();
+    return 0;
+}
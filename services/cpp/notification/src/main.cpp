@@ -1,11 +1,26 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 #include <grpcpp/grpcpp.h>
 #include "notification/notification_service.h"
+#include "notification/notification_grpc_service.h"
+#include "common/server_options.h"
 #include "common/mtls_credentials.h"
 #include "common/redis_client.h"
 #include "common/db_pool.h"
+#include "common/email_queue.h"
+#include "common/outbox.h"
+#include "common/outbox_relay.h"
+#include "common/queue_notifier.h"
+#include "common/queue_partitions.h"
+#include "common/allocator_stats.h"
+#include "common/metrics_server.h"
+#include "common/server_interceptors.h"
+#include "common/warmup.h"
+#include "common/graceful_shutdown.h"
+#include "common/logger.h"
+#include "common/tracing.h"
 
 using grpc::Server;
 using grpc::ServerBuilder;
@@ -20,6 +35,8 @@ void RunServer() {
     const char* twilio_account_sid_env = std::getenv("TWILIO_ACCOUNT_SID");
     const char* twilio_auth_token_env = std::getenv("TWILIO_AUTH_TOKEN");
     const char* fcm_server_key_env = std::getenv("FCM_SERVER_KEY");
+    const char* sendgrid_from_env = std::getenv("SENDGRID_FROM_EMAIL");
+    const char* twilio_from_env = std::getenv("TWILIO_PHONE_NUMBER");
 
     std::string redis_url = redis_url_env ? redis_url_env : "tcp://127.0.0.1:6379";
     std::string db_url = db_url_env ? db_url_env : "postgresql://localhost/saasforge";
@@ -29,13 +46,53 @@ void RunServer() {
     std::string fcm_server_key = fcm_server_key_env ? fcm_server_key_env : "fcm_mock";
 
     // Initialize Redis and DB
-    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url);
-    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, 10);
+    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url, saasforge::common::RedisOptions::FromEnv());
+    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, saasforge::common::DbPoolOptions::FromEnv());
 
-    saasforge::notification::NotificationServiceImpl service(
-        redis_client, db_pool, sendgrid_api_key, twilio_account_sid, twilio_auth_token, fcm_server_key
+    auto dns_cache = std::make_shared<saasforge::common::DnsCache>(saasforge::common::DnsCacheOptions::FromEnv());
+
+    auto subscriptions = std::make_shared<saasforge::common::WebhookSubscriptionIndex>(
+        db_pool, saasforge::common::WebhookSubscriptionOptions::FromEnv());
+
+    // Daily partitions of the delivery queues: created ahead, dropped past retention
+    saasforge::common::QueuePartitionMaintainer queue_partitions(
+        db_pool, {"email_queue", "webhook_deliveries"}, saasforge::common::QueuePartitionOptions::FromEnv());
+
+    auto templates = std::make_shared<saasforge::common::EmailTemplateCache>(
+        db_pool, saasforge::common::EmailTemplateOptions::FromEnv());
+
+    // Real providers only for channels with credentials; the others keep logging mock sends
+    auto senders = saasforge::notification::ChannelSenders::Create(
+        saasforge::notification::ProviderClientOptions::FromEnv(),
+        sendgrid_api_key_env ? sendgrid_api_key_env : "",
+        sendgrid_from_env ? sendgrid_from_env : "noreply@saasforge.local",
+        twilio_account_sid_env ? twilio_account_sid_env : "",
+        twilio_auth_token_env ? twilio_auth_token_env : "",
+        twilio_from_env ? twilio_from_env : "",
+        fcm_server_key_env ? fcm_server_key_env : "");
+
+    auto email_queue = std::make_shared<saasforge::common::EmailQueue>(db_pool);
+
+    auto service = std::make_shared<saasforge::notification::NotificationServiceImpl>(
+        redis_client, db_pool, sendgrid_api_key, twilio_account_sid, twilio_auth_token, fcm_server_key, dns_cache,
+        subscriptions, templates,
+        std::make_shared<saasforge::notification::PreferenceCache>(
+            db_pool, email_queue,
+            saasforge::notification::PreferenceCacheOptions::FromEnv()),
+        senders
     );
 
+    // Events other services wrote with their changes (common::Outbox), fanned out to webhooks
+    auto outbox_notifier = std::make_shared<saasforge::common::QueueNotifier>(
+        db_url,
+        std::vector<std::string>{saasforge::common::Outbox::NOTIFY_CHANNEL},
+        saasforge::common::QueueNotifierOptions::FromEnv());
+    auto outbox_relay = std::make_shared<saasforge::common::OutboxRelay>(
+        db_pool, subscriptions, std::make_shared<saasforge::common::WebhookDelivery>(db_pool), outbox_notifier,
+        saasforge::common::OutboxRelayOptions::FromEnv());
+
+    // grpc.health.v1.Health: NOT_SERVING until warm-up completes (below)
+    grpc::EnableDefaultHealthCheckService(true);
     ServerBuilder builder;
 
     // Setup mTLS
@@ -59,12 +116,71 @@ void RunServer() {
         builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     }
 
-    builder.RegisterService(&service);
+    // Threading model: sync, or callback API with a bounded executor (GRPC_SERVER_MODE)
+    auto server_options = saasforge::common::ServerOptions::FromEnv();
+    server_options.ApplyTo(builder);
+
+    // Tracing (traceparent in, OTLP out), per-method metrics, and the tenant context
+    // parsed once per RPC (every method needs a tenant or user)
+    saasforge::common::AddServerInterceptors(builder);
+
+    std::shared_ptr<saasforge::common::Executor> executor;
+    auto grpc_service = saasforge::common::MakeService<
+        saasforge::notification::NotificationServiceSync,
+        saasforge::notification::NotificationServiceCallback
+    >(server_options, service, executor);
+    builder.RegisterService(grpc_service.get());
+    std::cout << "Server mode: " << server_options.Describe() << std::endl;
 
     std::unique_ptr<Server> server(builder.BuildAndStart());
     std::cout << "Notification Service listening on " << server_address << std::endl;
 
-    server->Wait();
+    // Prometheus scrape endpoint (METRICS_PORT, 0 = disabled)
+    auto metrics_options = saasforge::common::MetricsServerOptions::FromEnv();
+    std::unique_ptr<saasforge::common::MetricsServer> metrics_server;
+    if (metrics_options.port != 0) {
+        saasforge::common::ExportAllocatorMetrics(saasforge::common::MetricsRegistry::Global());
+        metrics_server = std::make_unique<saasforge::common::MetricsServer>(
+            saasforge::common::MetricsRegistry::Global(), metrics_options);
+        std::cout << "Metrics available on :" << metrics_server->Port() << "/metrics" << std::endl;
+        if (!metrics_options.profiling.token.empty()) {
+            auto& profiler = saasforge::common::Profiler::Default();
+            std::cout << "Profiling available on :" << metrics_server->Port() << "/debug/pprof/ (cpu: "
+                      << (profiler.CpuAvailable() ? profiler.CpuBackend() : "none") << ", heap: "
+                      << (profiler.HeapAvailable() ? profiler.HeapBackend() : "none") << ")" << std::endl;
+        }
+    }
+
+    // SIGTERM (rolling deploy): drain in-flight RPCs, then flush and close in dependency order
+    saasforge::common::GracefulShutdown shutdown(saasforge::common::ShutdownOptions::FromEnv());
+    shutdown.Add("executor", [&executor] {
+        if (executor) {
+            executor->Shutdown();
+        }
+    });
+    shutdown.Add("email_queue", [&email_queue] { email_queue->ReleaseClaimed(); });
+    shutdown.Add("outbox_relay", [&outbox_relay] { outbox_relay->Shutdown(); });
+    shutdown.Add("notifier", [&outbox_notifier] { outbox_notifier->Shutdown(); });
+    shutdown.Add("database", [&db_pool, &shutdown] { db_pool->Shutdown(shutdown.Options().close_timeout); });
+    shutdown.Add("metrics", [&metrics_server] {
+        if (metrics_server) {
+            metrics_server->Shutdown();
+        }
+    });
+    shutdown.Add("tracing", [] { saasforge::common::Tracer::Global().Shutdown(); });
+
+    // Connections open and caches primed before readiness probes see SERVING
+    saasforge::common::Warmup warmup(saasforge::common::WarmupOptions::FromEnv());
+    warmup.Add("database", saasforge::common::Warmup::PingDatabase(db_pool), true);
+    warmup.Add("redis", saasforge::common::Warmup::ConnectRedis(redis_client), true);
+    warmup.Add("notification", [&service] { service->WarmUp(); });
+    if (!warmup.Run(server->GetHealthCheckService())) {
+        throw std::runtime_error("Warm-up failed");
+    }
+
+    shutdown.Wait();
+    shutdown.Run(server.get(), server->GetHealthCheckService());
+    saasforge::common::Logger::Global().Flush();
 }
 
 int main(int argc, char** argv) {
@@ -1,128 +1,355 @@
 #include "notification/notification_service.h"
 #include "common/tenant_context.h"
-#include <iostream>
-#include <sstream>
+#include "common/codec.h"
+#include "common/statement_registry.h"
+#include "common/webhook_delivery.h"
+#include "common/email_queue.h"
+#include "common/logger.h"
+#include "common/string_builder.h"
+#include <openssl/rand.h>
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <ctime>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
 
 namespace saasforge {
 namespace notification {
 
-NotificationServiceImpl::NotificationServiceImpl(
-    std::shared_ptr<common::RedisClient> redis_client,
-    std::shared_ptr<common::DbPool> db_pool,
-    const std::string& sendgrid_api_key,
-    const std::string& twilio_account_sid,
-    const std::string& twilio_auth_token,
-    const std::string& fcm_server_key
-) : redis_client_(redis_client),
-    db_pool_(db_pool),
-    sendgrid_api_key_(sendgrid_api_key),
-    twilio_account_sid_(twilio_account_sid),
-    twilio_auth_token_(twilio_auth_token),
-    fcm_server_key_(fcm_server_key) {
-    std::cout << "NotificationService initialized" << std::endl;
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const common::PreparedStatement kSelectWebhook(
+    "notification_select_webhook",
+    "SELECT url, status FROM webhooks WHERE id = $1 AND tenant_id = $2");
+
+const common::PreparedStatement kInsertWebhookNotification(
+    "notification_insert_webhook_notification",
+    "INSERT INTO notifications (tenant_id, user_id, channel, status, payload, created_at, sent_at) "
+    "VALUES ($1, '', $2, $3, $4, NOW(), NOW()) "
+    "RETURNING id, EXTRACT(EPOCH FROM created_at)::bigint as created_at");
+
+const common::PreparedStatement kTouchWebhook(
+    "notification_touch_webhook",
+    "UPDATE webhooks SET last_triggered_at = NOW() WHERE id = $1");
+
+const common::PreparedStatement kSelectNotification(
+    "notification_select_notification",
+    "SELECT id, channel, status, "
+    "EXTRACT(EPOCH FROM created_at)::bigint as created_at, "
+    "EXTRACT(EPOCH FROM sent_at)::bigint as sent_at, "
+    "EXTRACT(EPOCH FROM delivered_at)::bigint as delivered_at, "
+    "retry_count "
+    "FROM notifications WHERE id = $1 AND tenant_id = $2");
+
+const common::PreparedStatement kUpsertPreferences(
+    "notification_upsert_preferences",
+    "INSERT INTO notification_preferences (user_id, tenant_id, email_enabled, sms_enabled, push_enabled, marketing_emails) "
+    "VALUES ($1, $2, $3, $4, $5, $6) "
+    "ON CONFLICT (user_id, tenant_id) DO UPDATE SET "
+    "email_enabled = $3, sms_enabled = $4, push_enabled = $5, marketing_emails = $6, updated_at = NOW() "
+    "RETURNING user_id, email_enabled, sms_enabled, push_enabled, marketing_emails, EXTRACT(EPOCH FROM updated_at)::bigint as updated_at");
+
+const common::PreparedStatement kInsertWebhook(
+    "notification_insert_webhook",
+    "INSERT INTO webhooks (tenant_id, url, events, secret, status, failure_count, batch_max_events, batch_window_ms) "
+    "VALUES ($1, $2, $3, $4, 'active', 0, $5, $6) "
+    "RETURNING id, url, events, status, EXTRACT(EPOCH FROM created_at)::bigint as created_at, failure_count, "
+    "batch_max_events, batch_window_ms");
+
+const common::PreparedStatement kInsertNotification(
+    "notification_insert_notification",
+    "INSERT INTO notifications (tenant_id, user_id, channel, status, payload, created_at, sent_at, retry_count) "
+    "VALUES ($1, $2, $3, $4, $5, NOW(), NOW(), 0) "
+    "RETURNING id");
+
+std::string EmailPayload(const OutboundEmail& email) {
+    std::string payload;
+    payload.reserve(email.to.size() + email.subject.size() + email.body_html.size() + email.body_text.size() + 64);
+    payload += "{\"to\":";
+    common::AppendJsonString(payload, email.to);
+    payload += ",\"subject\":";
+    common::AppendJsonString(payload, email.subject);
+    payload += ",\"body_html\":";
+    common::AppendJsonString(payload, email.body_html);
+    if (!email.body_text.empty()) {
+        payload += ",\"body_text\":";
+        common::AppendJsonString(payload, email.body_text);
+    }
+    payload += '}';
+    return payload;
 }
 
-// SECURITY: SSRF Protection - Validate webhook URLs to prevent internal network access
-bool NotificationServiceImpl::ValidateWebhookUrl(const std::string& url) {
-    // Must start with http:// or https://
-    if (url.find("http://") != 0 && url.find("https://") != 0) {
-        return false;
-    }
+template <typename Vars>
+OutboundEmail RenderEmail(const common::EmailTemplate& compiled, const std::string& to, const Vars& vars) {
+    OutboundEmail email;
+    email.to = to;
+    compiled.subject.Render(vars, email.subject);
+    compiled.body_html.Render(vars, email.body_html);
+    compiled.body_text.Render(vars, email.body_text);
+    return email;
+}
+
+OutboundEmail RequestEmail(const SendEmailRequest& request) {
+    return {request.to(), request.subject(), request.body_html(), request.body_text()};
+}
+
+grpc::Status DeliveryFailure(const DeliveryResult& delivery) {
+    return grpc::Status(delivery.retryable ? grpc::StatusCode::UNAVAILABLE : grpc::StatusCode::FAILED_PRECONDITION,
+                        "Provider rejected the notification: " + delivery.error);
+}
+
+/// Recipients rendered and queued per COPY (and per streamed SendResult chunk)
+constexpr int BATCH_CHUNK_SIZE = static_cast<int>(common::CLIENT_STREAM_CHUNK_SIZE);
 
-    // Extract hostname and port
-    size_t protocol_end = url.find("://") + 3;
-    size_t host_end = url.find(":", protocol_end);
-    if (host_end == std::string::npos) {
-        host_end = url.find("/", protocol_end);
+/// SendStreamResponse lists at most this many failures; the counts are always exact
+constexpr int MAX_REPORTED_FAILURES = 1000;
+
+/// ListNotifications / ListWebhookDeliveries page sizes
+constexpr int DEFAULT_PAGE_SIZE = 100;
+constexpr int MAX_PAGE_SIZE = 10000;
+
+// created_at as exact epoch microseconds (EXTRACT(EPOCH) is a double before PG 14)
+constexpr const char* CREATED_AT_MICROS =
+    "EXTRACT(EPOCH FROM date_trunc('second', created_at))::bigint * 1000000 + "
+    "EXTRACT(MICROSECONDS FROM created_at)::bigint % 1000000";
+
+bool IsUuid(std::string_view value) {
+    if (value.size() != 36) {
+        return false;
     }
-    if (host_end == std::string::npos) {
-        host_end = url.length();
+    for (size_t i = 0; i < value.size(); ++i) {
+        bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash ? value[i] != '-' : !std::isxdigit(static_cast<unsigned char>(value[i]))) {
+            return false;
+        }
     }
+    return true;
+}
 
-    std::string host = url.substr(protocol_end, host_end - protocol_end);
+/// "<created_at micros>:<id>", the keyset position a page resumes after
+std::string ListCursor(long long created_micros, const std::string& id) {
+    return std::to_string(created_micros) + ":" + id;
+}
 
-    // Reject localhost and loopback addresses
-    if (host == "localhost" || host == "127.0.0.1" || host == "0.0.0.0" ||
-        host == "::1" || host == "[::1]") {
-        return false;
+/**
+ * WHERE clause for one page of a tenant's rows, newest first
+ *
+ * COPY cannot take bind parameters, so values are quoted into the query;
+ * the cursor is validated first so a bad one is INVALID_ARGUMENT, not a
+ * SQL error.
+ */
+grpc::Status KeysetWhere(pqxx::transaction_base& txn, const std::string& tenant_id, const std::string& cursor,
+                         std::string& where) {
+    where = "WHERE tenant_id = " + txn.quote(tenant_id);
+    if (cursor.empty()) {
+        return grpc::Status::OK;
+    }
+    size_t colon = cursor.find(':');
+    std::string_view micros = std::string_view(cursor).substr(0, colon == std::string::npos ? 0 : colon);
+    std::string_view id = colon == std::string::npos ? std::string_view() : std::string_view(cursor).substr(colon + 1);
+    bool digits = !micros.empty() && micros.size() <= 18 &&
+                  std::all_of(micros.begin(), micros.end(), [](char c) { return c >= '0' && c <= '9'; });
+    if (!digits || !IsUuid(id)) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid after_cursor");
     }
+    // Row comparison, so the index is scanned from the cursor onwards
+    where += " AND (created_at, id) < (TIMESTAMPTZ 'epoch' + " + std::string(micros) +
+             " * INTERVAL '1 microsecond', " + txn.quote(std::string(id)) + "::uuid)";
+    return grpc::Status::OK;
+}
 
-    // Reject private IP ranges (RFC 1918)
-    if (host.find("192.168.") == 0 || host.find("10.") == 0) {
-        return false;
+grpc::Status PageSize(int32_t requested, int& page_size) {
+    if (requested < 0) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "page_size must not be negative");
     }
+    page_size = requested == 0 ? DEFAULT_PAGE_SIZE : std::min<int>(requested, MAX_PAGE_SIZE);
+    return grpc::Status::OK;
+}
 
-    // Check 172.16.0.0 - 172.31.255.255 range
-    if (host.find("172.") == 0) {
-        size_t second_dot = host.find(".", 4);
-        if (second_dot != std::string::npos) {
-            int second_octet = std::stoi(host.substr(4, second_dot - 4));
-            if (second_octet >= 16 && second_octet <= 31) {
-                return false;  // Private range
-            }
+/**
+ * COPY the query's rows into writer, BATCH_CHUNK_SIZE responses at a time
+ *
+ * Only one chunk is held at once; Write() blocks while the client is
+ * behind, which in turn leaves the rest of the COPY unread on the socket.
+ */
+template <typename Row, typename Response, typename Fill>
+grpc::Status StreamRows(pqxx::transaction_base& txn, const std::string& query,
+                        common::StreamWriter<Response>& writer, Fill fill) {
+    auto stream = pqxx::stream_from::query(txn, query);
+    std::vector<Response> chunk;
+    chunk.reserve(BATCH_CHUNK_SIZE);
+    Row row;
+    bool open = true;
+    while (open && stream >> row) {
+        chunk.emplace_back();
+        fill(row, chunk.back());
+        if (chunk.size() == static_cast<size_t>(BATCH_CHUNK_SIZE)) {
+            open = writer.Write(chunk);
+            chunk.clear();
         }
     }
+    // Reads what is left of the COPY, so the connection is reusable
+    stream.complete();
+    if (open && !chunk.empty()) {
+        open = writer.Write(chunk);
+    }
+    return open ? grpc::Status::OK : grpc::Status(grpc::StatusCode::CANCELLED, "Client stopped reading");
+}
 
-    // Reject link-local addresses (169.254.0.0/16 - AWS metadata endpoint)
-    if (host.find("169.254.") == 0) {
-        return false;
+/// Random (version 4) UUID, so COPY can insert rows whose ids we already know
+std::string NewNotificationId() {
+    unsigned char bytes[16];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+        throw std::runtime_error("Failed to generate notification id");
     }
+    bytes[6] = static_cast<unsigned char>((bytes[6] & 0x0f) | 0x40);
+    bytes[8] = static_cast<unsigned char>((bytes[8] & 0x3f) | 0x80);
+
+    // 8-4-4-4-12 hex digits
+    std::string id(36, '-');
+    common::HexEncode(bytes, 4, &id[0]);
+    common::HexEncode(bytes + 4, 2, &id[9]);
+    common::HexEncode(bytes + 6, 2, &id[14]);
+    common::HexEncode(bytes + 8, 2, &id[19]);
+    common::HexEncode(bytes + 10, 6, &id[24]);
+    return id;
+}
 
-    // Validate port if specified
-    if (url[host_end] == ':') {
-        size_t port_end = url.find("/", host_end);
-        if (port_end == std::string::npos) {
-            port_end = url.length();
-        }
+std::string SqlTimestampNow() {
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S+00", &utc);
+    return buffer;
+}
 
-        try {
-            int port = std::stoi(url.substr(host_end + 1, port_end - host_end - 1));
+} // namespace
 
-            // Only allow standard web ports (prevent access to internal services)
-            if (port != 80 && port != 443 && port != 8080 && port != 8443) {
-                return false;
+NotificationServiceImpl::NotificationServiceImpl(
+    std::shared_ptr<common::RedisClient> redis_client,
+    std::shared_ptr<common::DbPool> db_pool,
+    const std::string& sendgrid_api_key,
+    const std::string& twilio_account_sid,
+    const std::string& twilio_auth_token,
+    const std::string& fcm_server_key,
+    std::shared_ptr<common::DnsCache> dns_cache,
+    std::shared_ptr<common::WebhookSubscriptionIndex> subscriptions,
+    std::shared_ptr<common::EmailTemplateCache> templates,
+    std::shared_ptr<PreferenceCache> preferences,
+    ChannelSenders senders,
+    std::shared_ptr<DigestBuffer> digests
+) : redis_client_(redis_client),
+    db_pool_(db_pool),
+    sendgrid_api_key_(sendgrid_api_key),
+    twilio_account_sid_(twilio_account_sid),
+    twilio_auth_token_(twilio_auth_token),
+    fcm_server_key_(fcm_server_key),
+    dns_cache_(dns_cache ? dns_cache : std::make_shared<common::DnsCache>()),
+    subscriptions_(subscriptions ? subscriptions : std::make_shared<common::WebhookSubscriptionIndex>(db_pool)),
+    webhook_delivery_(std::make_shared<common::WebhookDelivery>(db_pool)),
+    templates_(templates ? templates : std::make_shared<common::EmailTemplateCache>(db_pool)),
+    preferences_(preferences ? preferences
+                             : std::make_shared<PreferenceCache>(db_pool, std::make_shared<common::EmailQueue>(db_pool))),
+    senders_(std::move(senders)),
+    digests_(digests ? digests
+                     : std::make_shared<DigestBuffer>(DigestStore::From(redis_client), DigestOptions::FromEnv())) {
+    // Preference changes committed on any replica update this replica's cache.
+    // Events may have been missed when the bus resets its group, so the cache is flushed then.
+    event_bus_ = std::make_shared<common::EventBus>(redis_client_, common::EventBusOptions::FromEnv());
+    std::weak_ptr<PreferenceCache> weak_preferences = preferences_;
+    event_bus_->Subscribe(
+        PreferenceCache::CHANGE_TOPIC,
+        [weak_preferences](const std::string& message) {
+            if (auto preferences = weak_preferences.lock()) {
+                preferences->ApplyChange(message);
+            }
+        },
+        [weak_preferences]() {
+            if (auto preferences = weak_preferences.lock()) {
+                preferences->Clear();
             }
-        } catch (const std::exception&) {
-            return false;  // Invalid port number
         }
-    }
+    );
 
-    return true;
+    common::LogInfo("NotificationService initialized");
+}
+
+void NotificationServiceImpl::WarmUp() {
+    preferences_->IsSuppressed("warmup@saasforge.invalid");
+}
+
+// SECURITY: SSRF Protection - Validate webhook URLs to prevent internal network access
+// (literal checks plus resolve-then-check, shared with WebhookDelivery)
+bool NotificationServiceImpl::ValidateWebhookUrl(const std::string& url) {
+    return common::WebhookDelivery::ValidateUrl(url, *dns_cache_);
 }
 
 grpc::Status NotificationServiceImpl::SendEmail(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const SendEmailRequest* request,
     NotificationResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Check user preferences
-        if (!CheckUserPreferences(request->user_id(), NotificationChannel::EMAIL)) {
+        if (!CheckUserPreferences(tenant_ctx.tenant_id, request->user_id(), NotificationChannel::EMAIL)) {
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Email notifications disabled for user");
         }
+        if (preferences_->IsSuppressed(request->to())) {
+            return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Email address is suppressed due to hard bounce");
+        }
 
-        // Mock email sending (in production, call SendGrid API)
-        std::cout << "Mock: Sending email to " << request->to() << std::endl;
+        OutboundEmail email;
+        if (!request->template_id().empty()) {
+            auto compiled = templates_->Get(tenant_ctx.tenant_id, request->template_id());
+            if (!compiled) {
+                return grpc::Status(grpc::StatusCode::NOT_FOUND, "Email template not found");
+            }
 
-        // Queue notification
-        std::stringstream payload;
-        payload << "{\"to\":\"" << request->to() << "\","
-                << "\"subject\":\"" << request->subject() << "\","
-                << "\"body_html\":\"" << request->body_html() << "\"}";
+            email = RenderEmail(*compiled, request->to(), request->template_vars());
+        } else {
+            email = RequestEmail(*request);
+        }
+
+        if (request->has_coalescing_key()) {
+            return BufferDigest(DigestChannel::EMAIL, request->coalescing_key(),
+                                {tenant_ctx.tenant_id, request->user_id(), email.to, email.subject,
+                                 email.body_html, email.body_text},
+                                NotificationChannel::EMAIL, response);
+        }
+
+        DeliveryResult delivery;
+        if (senders_.email) {
+            delivery = senders_.email->Send({email})[0];
+        } else {
+            // No SendGrid credentials configured
+            common::LogDebug("Mock: Sending email", {{"to", request->to()}});
+            delivery.delivered = true;
+        }
 
+        // Record the notification, failed deliveries included
         std::string notification_id = QueueNotification(
             tenant_ctx.tenant_id,
             request->user_id(),
             NotificationChannel::EMAIL,
-            payload.str()
+            EmailPayload(email),
+            delivery.delivered ? NotificationStatus::SENT : NotificationStatus::FAILED
         );
+        if (!delivery.delivered) {
+            return DeliveryFailure(delivery);
+        }
 
         // Set response
         auto now = std::chrono::system_clock::now();
@@ -142,37 +369,175 @@ grpc::Status NotificationServiceImpl::SendEmail(
     }
 }
 
+grpc::Status NotificationServiceImpl::SendEmailBatch(
+    grpc::ServerContextBase* context,
+    const SendEmailBatchRequest* request,
+    common::StreamWriter<SendResult>& writer
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        // Compiled once for the whole campaign
+        std::shared_ptr<const common::EmailTemplate> compiled;
+        if (!request->template_id().empty()) {
+            compiled = templates_->Get(tenant_ctx.tenant_id, request->template_id());
+            if (!compiled) {
+                return grpc::Status(grpc::StatusCode::NOT_FOUND, "Email template not found");
+            }
+        } else {
+            compiled = common::EmailTemplate::Compile(
+                {"", request->subject(), request->body_html(), request->body_text(), 0});
+        }
+
+        const auto& recipients = request->recipients();
+        std::vector<SendResult> results;
+        std::vector<PendingEmail> pending;
+        std::vector<OutboundEmail> emails;
+        for (int begin = 0; begin < recipients.size(); begin += BATCH_CHUNK_SIZE) {
+            int end = std::min(begin + BATCH_CHUNK_SIZE, recipients.size());
+            results.clear();
+            results.resize(static_cast<size_t>(end - begin));
+            pending.clear();
+            emails.clear();
+
+            for (int i = begin; i < end; ++i) {
+                const EmailRecipient& recipient = recipients[i];
+                SendResult& result = results[static_cast<size_t>(i - begin)];
+                result.set_index(i);
+                if (AdmitEmail(tenant_ctx.tenant_id, recipient.user_id(), recipient.to(), result)) {
+                    pending.push_back({static_cast<size_t>(i - begin), recipient.user_id()});
+                    emails.push_back(RenderEmail(*compiled, recipient.to(), recipient.template_vars()));
+                }
+            }
+
+            QueueEmails(tenant_ctx.tenant_id, pending, emails, results);
+            if (!writer.Write(results)) {
+                return grpc::Status(grpc::StatusCode::CANCELLED, "Client stopped reading results");
+            }
+        }
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Send email batch failed: ") + e.what());
+    }
+}
+
+grpc::Status NotificationServiceImpl::SendStream(
+    grpc::ServerContextBase* context,
+    const std::vector<SendEmailRequest>& chunk,
+    SendStreamResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        // Position of this chunk's first message in the stream
+        int64_t base = response->accepted() + response->rejected();
+        std::vector<SendResult> results(chunk.size());
+        std::vector<PendingEmail> pending;
+        std::vector<OutboundEmail> emails;
+        pending.reserve(chunk.size());
+        emails.reserve(chunk.size());
+
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            const SendEmailRequest& request = chunk[i];
+            SendResult& result = results[i];
+            result.set_index(static_cast<int32_t>(base + static_cast<int64_t>(i)));
+            if (!AdmitEmail(tenant_ctx.tenant_id, request.user_id(), request.to(), result)) {
+                continue;
+            }
+
+            if (request.template_id().empty()) {
+                pending.push_back({i, request.user_id()});
+                emails.push_back(RequestEmail(request));
+                continue;
+            }
+            auto compiled = templates_->Get(tenant_ctx.tenant_id, request.template_id());
+            if (!compiled) {
+                result.set_status(NotificationStatus::FAILED);
+                result.set_error("Email template not found");
+                continue;
+            }
+            pending.push_back({i, request.user_id()});
+            emails.push_back(RenderEmail(*compiled, request.to(), request.template_vars()));
+        }
+
+        QueueEmails(tenant_ctx.tenant_id, pending, emails, results);
+
+        for (auto& result : results) {
+            if (result.status() == NotificationStatus::SENT) {
+                response->set_accepted(response->accepted() + 1);
+                continue;
+            }
+            response->set_rejected(response->rejected() + 1);
+            if (response->failures_size() < MAX_REPORTED_FAILURES) {
+                *response->add_failures() = std::move(result);
+            }
+        }
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Send stream failed: ") + e.what());
+    }
+}
+
 grpc::Status NotificationServiceImpl::SendSMS(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const SendSMSRequest* request,
     NotificationResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Check user preferences
-        if (!CheckUserPreferences(request->user_id(), NotificationChannel::SMS)) {
+        if (!CheckUserPreferences(tenant_ctx.tenant_id, request->user_id(), NotificationChannel::SMS)) {
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "SMS notifications disabled for user");
         }
 
-        // Mock SMS sending (in production, call Twilio API)
-        std::cout << "Mock: Sending SMS to " << request->to() << std::endl;
+        DeliveryResult delivery;
+        if (senders_.sms) {
+            delivery = senders_.sms->Send({{request->to(), request->message()}})[0];
+        } else {
+            // No Twilio credentials configured
+            common::LogDebug("Mock: Sending SMS", {{"to", request->to()}});
+            delivery.delivered = true;
+        }
 
         // Queue notification
-        std::stringstream payload;
-        payload << "{\"to\":\"" << request->to() << "\","
-                << "\"message\":\"" << request->message() << "\"}";
+        std::string payload;
+        payload.reserve(request->to().size() + request->message().size() + 32);
+        payload += "{\"to\":";
+        common::AppendJsonString(payload, request->to());
+        payload += ",\"message\":";
+        common::AppendJsonString(payload, request->message());
+        payload += '}';
 
         std::string notification_id = QueueNotification(
             tenant_ctx.tenant_id,
             request->user_id(),
             NotificationChannel::SMS,
-            payload.str()
+            payload,
+            delivery.delivered ? NotificationStatus::SENT : NotificationStatus::FAILED
         );
+        if (!delivery.delivered) {
+            return DeliveryFailure(delivery);
+        }
 
         auto now = std::chrono::system_clock::now();
         auto timestamp = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
@@ -192,35 +557,46 @@ grpc::Status NotificationServiceImpl::SendSMS(
 }
 
 grpc::Status NotificationServiceImpl::SendPush(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const SendPushRequest* request,
     NotificationResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Check user preferences
-        if (!CheckUserPreferences(request->user_id(), NotificationChannel::PUSH)) {
+        if (!CheckUserPreferences(tenant_ctx.tenant_id, request->user_id(), NotificationChannel::PUSH)) {
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Push notifications disabled for user");
         }
 
-        // Mock push notification (in production, call FCM API)
-        std::cout << "Mock: Sending push notification: " << request->title() << std::endl;
+        if (request->has_coalescing_key()) {
+            return BufferDigest(DigestChannel::PUSH, request->coalescing_key(),
+                                {tenant_ctx.tenant_id, request->user_id(), "", request->title(), "", request->body()},
+                                NotificationChannel::PUSH, response);
+        }
+
+        // Mock push notification: FcmSender needs registration tokens, which are not stored yet
+        common::LogDebug("Mock: Sending push notification", {{"title", request->title()}});
 
         // Queue notification
-        std::stringstream payload;
-        payload << "{\"title\":\"" << request->title() << "\","
-                << "\"body\":\"" << request->body() << "\"}";
+        std::string payload;
+        payload.reserve(request->title().size() + request->body().size() + 32);
+        payload += "{\"title\":";
+        common::AppendJsonString(payload, request->title());
+        payload += ",\"body\":";
+        common::AppendJsonString(payload, request->body());
+        payload += '}';
 
         std::string notification_id = QueueNotification(
             tenant_ctx.tenant_id,
             request->user_id(),
             NotificationChannel::PUSH,
-            payload.str()
+            payload
         );
 
         auto now = std::chrono::system_clock::now();
@@ -241,23 +617,24 @@ grpc::Status NotificationServiceImpl::SendPush(
 }
 
 grpc::Status NotificationServiceImpl::TriggerWebhook(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const TriggerWebhookRequest* request,
     NotificationResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Get webhook URL from database
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto webhook_result = txn.exec_params(
-            "SELECT url, status FROM webhooks WHERE id = $1 AND tenant_id = $2",
+        auto webhook_result = common::ExecPrepared(
+            txn, kSelectWebhook,
             request->webhook_id(),
             tenant_ctx.tenant_id
         );
@@ -274,13 +651,11 @@ grpc::Status NotificationServiceImpl::TriggerWebhook(
         }
 
         // Mock webhook call (in production, make HTTP POST to webhook URL)
-        std::cout << "Mock: Triggering webhook " << webhook_url << " with event " << request->event_type() << std::endl;
+        common::LogDebug("Mock: Triggering webhook", {{"url", webhook_url}, {"event_type", request->event_type()}});
 
         // Record webhook trigger
-        auto result = txn.exec_params(
-            "INSERT INTO notifications (tenant_id, user_id, channel, status, payload, created_at, sent_at) "
-            "VALUES ($1, '', $2, $3, $4, NOW(), NOW()) "
-            "RETURNING id, EXTRACT(EPOCH FROM created_at)::bigint as created_at",
+        auto result = common::ExecPrepared(
+            txn, kInsertWebhookNotification,
             tenant_ctx.tenant_id,
             static_cast<int>(NotificationChannel::WEBHOOK),
             static_cast<int>(NotificationStatus::SENT),
@@ -288,8 +663,8 @@ grpc::Status NotificationServiceImpl::TriggerWebhook(
         );
 
         // Update webhook last_triggered_at
-        txn.exec_params(
-            "UPDATE webhooks SET last_triggered_at = NOW() WHERE id = $1",
+        common::ExecPrepared(
+            txn, kTouchWebhook,
             request->webhook_id()
         );
 
@@ -302,6 +677,7 @@ grpc::Status NotificationServiceImpl::TriggerWebhook(
         response->set_retry_count(0);
 
         txn.commit();
+        db_pool_->RecordWrite(tenant_ctx.tenant_id);
 
         return grpc::Status::OK;
 
@@ -311,27 +687,24 @@ grpc::Status NotificationServiceImpl::TriggerWebhook(
 }
 
 grpc::Status NotificationServiceImpl::GetNotificationStatus(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const GetNotificationStatusRequest* request,
     NotificationResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        // Read-only: a replica unless this tenant just queued a notification
+        auto conn_guard = db_pool_->AcquireReadConnection(__func__, tenant_ctx.tenant_id);
+        pqxx::read_transaction txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT id, channel, status, "
-            "EXTRACT(EPOCH FROM created_at)::bigint as created_at, "
-            "EXTRACT(EPOCH FROM sent_at)::bigint as sent_at, "
-            "EXTRACT(EPOCH FROM delivered_at)::bigint as delivered_at, "
-            "retry_count "
-            "FROM notifications WHERE id = $1 AND tenant_id = $2",
+        auto result = common::ExecPrepared(
+            txn, kSelectNotification,
             request->notification_id(),
             tenant_ctx.tenant_id
         );
@@ -364,27 +737,144 @@ grpc::Status NotificationServiceImpl::GetNotificationStatus(
     }
 }
 
+grpc::Status NotificationServiceImpl::ListNotifications(
+    grpc::ServerContextBase* context,
+    const ListNotificationsRequest* request,
+    common::StreamWriter<NotificationResponse>& writer
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+        int page_size = 0;
+        grpc::Status status = PageSize(request->page_size(), page_size);
+        if (!status.ok()) {
+            return status;
+        }
+
+        auto conn_guard = db_pool_->AcquireReadConnection(__func__, tenant_ctx.tenant_id);
+        pqxx::read_transaction txn(*conn_guard);
+
+        std::string where;
+        status = KeysetWhere(txn, tenant_ctx.tenant_id, request->after_cursor(), where);
+        if (!status.ok()) {
+            return status;
+        }
+        // Index-only scan of idx_notifications_tenant_keyset
+        std::string query = std::string("SELECT id, channel, status, ") + CREATED_AT_MICROS + ", "
+            "EXTRACT(EPOCH FROM sent_at)::bigint, EXTRACT(EPOCH FROM delivered_at)::bigint, retry_count "
+            "FROM notifications " + where +
+            " ORDER BY created_at DESC, id DESC LIMIT " + std::to_string(page_size);
+
+        using Row = std::tuple<std::string, int, int, long long, std::optional<long long>,
+                               std::optional<long long>, int>;
+        status = StreamRows<Row>(txn, query, writer, [](const Row& row, NotificationResponse& response) {
+            const auto& [id, channel, state, created_micros, sent_at, delivered_at, retry_count] = row;
+            response.set_id(id);
+            response.set_channel(static_cast<NotificationChannel>(channel));
+            response.set_status(static_cast<NotificationStatus>(state));
+            response.set_created_at(created_micros / 1000000);
+            if (sent_at) {
+                response.set_sent_at(*sent_at);
+            }
+            if (delivered_at) {
+                response.set_delivered_at(*delivered_at);
+            }
+            response.set_retry_count(retry_count);
+            response.set_cursor(ListCursor(created_micros, id));
+        });
+        if (status.ok()) {
+            txn.commit();
+        }
+        return status;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("List notifications failed: ") + e.what());
+    }
+}
+
+grpc::Status NotificationServiceImpl::ListWebhookDeliveries(
+    grpc::ServerContextBase* context,
+    const ListWebhookDeliveriesRequest* request,
+    common::StreamWriter<WebhookDeliveryResponse>& writer
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+        int page_size = 0;
+        grpc::Status status = PageSize(request->page_size(), page_size);
+        if (!status.ok()) {
+            return status;
+        }
+
+        auto conn_guard = db_pool_->AcquireReadConnection(__func__, tenant_ctx.tenant_id);
+        pqxx::read_transaction txn(*conn_guard);
+
+        std::string where;
+        status = KeysetWhere(txn, tenant_ctx.tenant_id, request->after_cursor(), where);
+        if (!status.ok()) {
+            return status;
+        }
+        // Both the active and the done partitions, merged on idx_webhook_deliveries_tenant_keyset
+        std::string query = std::string("SELECT id, webhook_id, event_type, status, retry_count, http_status_code, ") +
+            CREATED_AT_MICROS + ", EXTRACT(EPOCH FROM delivered_at)::bigint "
+            "FROM webhook_deliveries " + where +
+            " ORDER BY created_at DESC, id DESC LIMIT " + std::to_string(page_size);
+
+        using Row = std::tuple<std::string, std::string, std::string, int, int, std::optional<int>, long long,
+                               std::optional<long long>>;
+        status = StreamRows<Row>(txn, query, writer, [](const Row& row, WebhookDeliveryResponse& response) {
+            const auto& [id, webhook_id, event_type, state, retry_count, http_status, created_micros,
+                         delivered_at] = row;
+            response.set_id(id);
+            response.set_webhook_id(webhook_id);
+            response.set_event_type(event_type);
+            response.set_status(state);
+            response.set_retry_count(retry_count);
+            if (http_status) {
+                response.set_http_status_code(*http_status);
+            }
+            response.set_created_at(created_micros / 1000000);
+            if (delivered_at) {
+                response.set_delivered_at(*delivered_at);
+            }
+            response.set_cursor(ListCursor(created_micros, id));
+        });
+        if (status.ok()) {
+            txn.commit();
+        }
+        return status;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("List webhook deliveries failed: ") + e.what());
+    }
+}
+
 grpc::Status NotificationServiceImpl::UpdatePreferences(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const UpdatePreferencesRequest* request,
     PreferencesResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "INSERT INTO notification_preferences (user_id, tenant_id, email_enabled, sms_enabled, push_enabled, marketing_emails) "
-            "VALUES ($1, $2, $3, $4, $5, $6) "
-            "ON CONFLICT (user_id, tenant_id) DO UPDATE SET "
-            "email_enabled = $3, sms_enabled = $4, push_enabled = $5, marketing_emails = $6, updated_at = NOW() "
-            "RETURNING user_id, email_enabled, sms_enabled, push_enabled, marketing_emails, EXTRACT(EPOCH FROM updated_at)::bigint as updated_at",
+        auto result = common::ExecPrepared(
+            txn, kUpsertPreferences,
             request->user_id(),
             tenant_ctx.tenant_id,
             request->email_enabled(),
@@ -403,6 +893,16 @@ grpc::Status NotificationServiceImpl::UpdatePreferences(
 
         txn.commit();
 
+        // Sends on this replica see the change at once; others get it over the event bus
+        uint8_t bits = PreferenceCache::Bits(response->email_enabled(), response->sms_enabled(),
+                                             response->push_enabled(), response->marketing_emails());
+        preferences_->Update(tenant_ctx.tenant_id, response->user_id(), bits);
+        if (!event_bus_->Publish(PreferenceCache::CHANGE_TOPIC,
+                                 PreferenceCache::EncodeChange(tenant_ctx.tenant_id, response->user_id(), bits))) {
+            // Other replicas pick the change up within the cache TTL
+            common::LogWarn("Publishing preference change dropped", {{"user_id", response->user_id()}});
+        }
+
         return grpc::Status::OK;
 
     } catch (const std::exception& e) {
@@ -411,12 +911,13 @@ grpc::Status NotificationServiceImpl::UpdatePreferences(
 }
 
 grpc::Status NotificationServiceImpl::RegisterWebhook(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const RegisterWebhookRequest* request,
     WebhookResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
@@ -432,27 +933,45 @@ grpc::Status NotificationServiceImpl::RegisterWebhook(
                               "Invalid webhook URL: Cannot access private networks, localhost, or non-standard ports");
         }
 
+        int batch_max_events = 0;
+        int batch_window_ms = 0;
+        if (request->has_batch()) {
+            batch_max_events = request->batch().max_events();
+            batch_window_ms = request->batch().max_wait_ms();
+            if (batch_max_events < 2 || batch_max_events > common::WebhookDelivery::MAX_BATCH_EVENTS ||
+                batch_window_ms < 0 || batch_window_ms > common::WebhookDelivery::MAX_BATCH_WINDOW_MS) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                  "Webhook batch mode needs max_events in 2.." +
+                                  std::to_string(common::WebhookDelivery::MAX_BATCH_EVENTS) + " and max_wait_ms in 0.." +
+                                  std::to_string(common::WebhookDelivery::MAX_BATCH_WINDOW_MS));
+            }
+        }
+
         // Convert repeated events to comma-separated string
-        std::stringstream events_ss;
+        size_t events_size = 0;
+        for (const auto& event : request->events()) {
+            events_size += event.size() + 1;
+        }
+        std::string events_str;
+        events_str.reserve(events_size);
         for (int i = 0; i < request->events_size(); i++) {
-            if (i > 0) events_ss << ",";
-            events_ss << request->events(i);
+            if (i > 0) events_str += ',';
+            events_str += request->events(i);
         }
-        std::string events_str = events_ss.str();
 
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
         std::string secret = request->has_secret() ? request->secret() : "";
 
-        auto result = txn.exec_params(
-            "INSERT INTO webhooks (tenant_id, url, events, secret, status, failure_count) "
-            "VALUES ($1, $2, $3, $4, 'active', 0) "
-            "RETURNING id, url, events, status, EXTRACT(EPOCH FROM created_at)::bigint as created_at, failure_count",
+        auto result = common::ExecPrepared(
+            txn, kInsertWebhook,
             tenant_ctx.tenant_id,
             request->url(),
             events_str,
-            secret
+            secret,
+            batch_max_events,
+            batch_window_ms
         );
 
         auto row = result[0];
@@ -460,19 +979,35 @@ grpc::Status NotificationServiceImpl::RegisterWebhook(
         response->set_url(row["url"].as<std::string>());
 
         // Parse events back into repeated field
-        std::string events_from_db = row["events"].as<std::string>();
-        std::stringstream ss(events_from_db);
-        std::string event;
-        while (std::getline(ss, event, ',')) {
-            response->add_events(event);
+        std::string_view events_from_db(row["events"].c_str(), row["events"].size());
+        for (std::string_view rest = events_from_db; !rest.empty();) {
+            size_t comma = rest.find(',');
+            auto event = rest.substr(0, comma);
+            response->add_events(event.data(), event.size());
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(comma + 1);
         }
 
         response->set_status(row["status"].as<std::string>());
         response->set_created_at(row["created_at"].as<long long>());
         response->set_failure_count(row["failure_count"].as<int>());
+        if (row["batch_max_events"].as<int>() > 1) {
+            response->mutable_batch()->set_max_events(row["batch_max_events"].as<int>());
+            response->mutable_batch()->set_max_wait_ms(row["batch_window_ms"].as<int>());
+        }
 
         txn.commit();
 
+        // Visible to PublishEvent on this instance right away (others reload within the TTL)
+        subscriptions_->Add(tenant_ctx.tenant_id, {
+            response->id(),
+            response->url(),
+            common::WebhookSubscriptionIndex::ParseEvents(events_from_db),
+            batch_max_events
+        });
+
         return grpc::Status::OK;
 
     } catch (const std::exception& e) {
@@ -480,36 +1015,64 @@ grpc::Status NotificationServiceImpl::RegisterWebhook(
     }
 }
 
-// Helper methods
-
-bool NotificationServiceImpl::CheckUserPreferences(const std::string& user_id, NotificationChannel channel) {
+grpc::Status NotificationServiceImpl::PublishEvent(
+    grpc::ServerContextBase* context,
+    const PublishEventRequest* request,
+    PublishEventResponse* response
+) {
     try {
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
-        auto result = txn.exec_params(
-            "SELECT email_enabled, sms_enabled, push_enabled FROM notification_preferences WHERE user_id = $1",
-            user_id
-        );
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
 
-        if (result.empty()) {
-            return true; // Allow by default if no preferences set
+        if (request->event_type().empty()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Event type cannot be empty");
         }
 
-        auto row = result[0];
-        switch (channel) {
-            case NotificationChannel::EMAIL:
-                return row["email_enabled"].as<bool>();
-            case NotificationChannel::SMS:
-                return row["sms_enabled"].as<bool>();
-            case NotificationChannel::PUSH:
-                return row["push_enabled"].as<bool>();
-            default:
-                return true;
+        // One index lookup and one insert for all subscribers, instead of a
+        // TriggerWebhook call (and webhooks read) per webhook
+        auto subscribers = subscriptions_->Subscribers(tenant_ctx.tenant_id, request->event_type());
+
+        auto queued = webhook_delivery_->QueueEvent(
+            tenant_ctx.tenant_id,
+            request->event_type(),
+            request->payload(),
+            subscribers
+        );
+
+        response->set_event_id(queued.event_id);
+        for (const auto& delivery : queued.deliveries) {
+            response->add_delivery_ids(delivery.first);
         }
+        response->set_subscriber_count(static_cast<int32_t>(queued.deliveries.size()));
+        response->set_created_at(queued.created_at);
+
+        return grpc::Status::OK;
 
     } catch (const std::exception& e) {
-        std::cerr << "Check preferences failed: " << e.what() << std::endl;
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Publish event failed: ") + e.what());
+    }
+}
+
+// Helper methods
+
+bool NotificationServiceImpl::CheckUserPreferences(const std::string& tenant_id, const std::string& user_id,
+                                                   NotificationChannel channel) {
+    uint8_t bit = 0;
+    switch (channel) {
+        case NotificationChannel::EMAIL: bit = PREFERENCE_EMAIL; break;
+        case NotificationChannel::SMS: bit = PREFERENCE_SMS; break;
+        case NotificationChannel::PUSH: bit = PREFERENCE_PUSH; break;
+        default: return true;
+    }
+
+    try {
+        return preferences_->Allows(tenant_id, user_id, bit);
+    } catch (const std::exception& e) {
+        common::LogError("Check preferences failed", {{"error", e.what()}});
         return true; // Fail open
     }
 }
@@ -518,27 +1081,140 @@ std::string NotificationServiceImpl::QueueNotification(
     const std::string& tenant_id,
     const std::string& user_id,
     NotificationChannel channel,
-    const std::string& payload
+    const std::string& payload,
+    NotificationStatus status
 ) {
-    auto conn_guard = db_pool_->AcquireConnection();
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
     pqxx::work txn(*conn_guard);
 
-    auto result = txn.exec_params(
-        "INSERT INTO notifications (tenant_id, user_id, channel, status, payload, created_at, sent_at, retry_count) "
-        "VALUES ($1, $2, $3, $4, $5, NOW(), NOW(), 0) "
-        "RETURNING id",
+    auto result = common::ExecPrepared(
+        txn, kInsertNotification,
         tenant_id,
         user_id,
         static_cast<int>(channel),
-        static_cast<int>(NotificationStatus::SENT),
+        static_cast<int>(status),
         payload
     );
 
     std::string notification_id = result[0]["id"].as<std::string>();
     txn.commit();
+    db_pool_->RecordWrite(tenant_id);
 
     return notification_id;
 }
 
+grpc::Status NotificationServiceImpl::BufferDigest(
+    DigestChannel channel,
+    const std::string& coalescing_key,
+    const DigestItem& item,
+    NotificationChannel response_channel,
+    NotificationResponse* response
+) {
+    if (coalescing_key.empty() || coalescing_key.size() > DigestBuffer::MAX_KEY_LENGTH) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "coalescing_key must be 1 to 128 characters");
+    }
+    digests_->Add(channel, coalescing_key, item);
+
+    auto now = std::chrono::system_clock::now();
+    response->set_channel(response_channel);
+    response->set_status(NotificationStatus::PENDING);
+    response->set_created_at(std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count());
+    response->set_retry_count(0);
+    return grpc::Status::OK;
+}
+
+bool NotificationServiceImpl::AdmitEmail(
+    const std::string& tenant_id,
+    const std::string& user_id,
+    const std::string& to,
+    SendResult& result
+) {
+    const char* error = nullptr;
+    if (to.empty()) {
+        error = "Recipient address required";
+    } else if (!CheckUserPreferences(tenant_id, user_id, NotificationChannel::EMAIL)) {
+        error = "Email notifications disabled for user";
+    } else if (preferences_->IsSuppressed(to)) {
+        error = "Email address is suppressed due to hard bounce";
+    }
+
+    if (error) {
+        result.set_status(NotificationStatus::FAILED);
+        result.set_error(error);
+        return false;
+    }
+    return true;
+}
+
+void NotificationServiceImpl::QueueEmails(
+    const std::string& tenant_id,
+    const std::vector<PendingEmail>& pending,
+    const std::vector<OutboundEmail>& emails,
+    std::vector<SendResult>& results
+) {
+    if (pending.empty()) {
+        return;
+    }
+
+    // One provider call per MAX_PERSONALIZATIONS recipients of the same content
+    std::vector<DeliveryResult> deliveries;
+    if (senders_.email) {
+        deliveries = senders_.email->Send(emails);
+    } else {
+        common::LogDebug("Mock: Sending email batch", {{"emails", emails.size()}});
+        deliveries.resize(emails.size());
+        for (auto& delivery : deliveries) {
+            delivery.delivered = true;
+        }
+    }
+
+    std::vector<std::string> ids;
+    ids.reserve(pending.size());
+    try {
+        std::string sent_at = SqlTimestampNow();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
+        {
+            // One COPY per chunk instead of an INSERT round trip per email
+            pqxx::stream_to stream(
+                txn, "notifications",
+                std::vector<std::string>{"id", "tenant_id", "user_id", "channel", "status", "payload", "sent_at"});
+            for (size_t i = 0; i < pending.size(); ++i) {
+                const PendingEmail& email = pending[i];
+                NotificationStatus status = deliveries[i].delivered ? NotificationStatus::SENT : NotificationStatus::FAILED;
+                ids.push_back(NewNotificationId());
+                stream << std::make_tuple(
+                    ids.back(), tenant_id,
+                    email.user_id.empty() ? std::optional<std::string>() : std::optional<std::string>(email.user_id),
+                    static_cast<int>(NotificationChannel::EMAIL), static_cast<int>(status),
+                    EmailPayload(emails[i]), sent_at);
+            }
+            stream.complete();
+        }
+        txn.commit();
+        db_pool_->RecordWrite(tenant_id);
+    } catch (const std::exception& e) {
+        common::LogError("Queueing email batch failed", {{"tenant_id", tenant_id}, {"emails", pending.size()},
+                                                          {"error", e.what()}});
+        for (size_t i = 0; i < pending.size(); ++i) {
+            SendResult& result = results[pending[i].result];
+            result.set_status(NotificationStatus::FAILED);
+            result.set_error(deliveries[i].delivered ? "Queueing failed" : deliveries[i].error);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+        SendResult& result = results[pending[i].result];
+        result.set_id(ids[i]);
+        if (deliveries[i].delivered) {
+            result.set_status(NotificationStatus::SENT);
+        } else {
+            result.set_status(NotificationStatus::FAILED);
+            result.set_error(deliveries[i].error);
+        }
+    }
+}
+
 } // namespace notification
 } // namespace saasforge
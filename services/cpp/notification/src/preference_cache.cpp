@@ -0,0 +1,192 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-process cache of notification preferences and suppressed addresses implementation
+ */
+
+#include "notification/preference_cache.h"
+#include "common/db_pool.h"
+#include "common/email_queue.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/statement_registry.h"
+#include <cstdlib>
+#include <iterator>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace notification {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const common::PreparedStatement kSelectTenantPreferences(
+    "notification_select_tenant_preferences",
+    "SELECT user_id, email_enabled, sms_enabled, push_enabled, marketing_emails "
+    "FROM notification_preferences WHERE tenant_id = $1");
+
+} // namespace
+
+PreferenceCacheOptions PreferenceCacheOptions::FromEnv() {
+    PreferenceCacheOptions options;
+    options.ttl = std::chrono::seconds(
+        common::EnvInt("NOTIFICATION_PREFERENCE_TTL_S", static_cast<long>(options.ttl.count())));
+    options.max_tenants = static_cast<size_t>(
+        common::EnvInt("NOTIFICATION_PREFERENCE_MAX_TENANTS", static_cast<long>(options.max_tenants)));
+    return options;
+}
+
+PreferenceCache::PreferenceCache(
+    std::shared_ptr<common::DbPool> db_pool,
+    std::shared_ptr<common::EmailQueue> email_queue,
+    const PreferenceCacheOptions& options
+) : PreferenceCache(
+        [db_pool](const std::string& tenant_id) {
+            auto conn_guard = db_pool->AcquireConnection("PreferenceCache::Load");
+            pqxx::read_transaction txn(*conn_guard);
+
+            auto result = common::ExecPrepared(txn, kSelectTenantPreferences, tenant_id);
+
+            std::unordered_map<std::string, uint8_t> users;
+            users.reserve(result.size());
+            for (const auto& row : result) {
+                users.emplace(row["user_id"].as<std::string>(),
+                              Bits(row["email_enabled"].as<bool>(), row["sms_enabled"].as<bool>(),
+                                   row["push_enabled"].as<bool>(), row["marketing_emails"].as<bool>()));
+            }
+            return users;
+        },
+        [email_queue]() { return email_queue->ListSuppressedAddresses(); },
+        options) {}
+
+PreferenceCache::PreferenceCache(PreferenceLoader preferences, SuppressionLoader suppressions,
+                                 const PreferenceCacheOptions& options)
+    : load_preferences_(std::move(preferences)),
+      load_suppressions_(std::move(suppressions)),
+      options_(options) {}
+
+bool PreferenceCache::Allows(const std::string& tenant_id, const std::string& user_id, uint8_t bit) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t version = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tenants_.find(tenant_id);
+        if (it != tenants_.end() && now - it->second.loaded_at < options_.ttl) {
+            auto user = it->second.users.find(user_id);
+            return ((user == it->second.users.end() ? DEFAULT_BITS : user->second) & bit) != 0;
+        }
+        version = version_;
+    }
+
+    // Query outside the lock; concurrent cold loads of one tenant are rare and idempotent
+    TenantEntry entry;
+    entry.users = load_preferences_(tenant_id);
+    entry.loaded_at = now;
+    auto user = entry.users.find(user_id);
+    bool allowed = ((user == entry.users.end() ? DEFAULT_BITS : user->second) & bit) != 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version == version_) {
+        if (tenants_.size() >= options_.max_tenants && tenants_.find(tenant_id) == tenants_.end()) {
+            for (auto it = tenants_.begin(); it != tenants_.end();) {
+                it = (now - it->second.loaded_at >= options_.ttl) ? tenants_.erase(it) : std::next(it);
+            }
+            if (tenants_.size() >= options_.max_tenants && !tenants_.empty()) {
+                tenants_.erase(tenants_.begin());
+            }
+        }
+        tenants_[tenant_id] = std::move(entry);
+    }
+    return allowed;
+}
+
+bool PreferenceCache::IsSuppressed(const std::string& email_address) {
+    auto now = std::chrono::steady_clock::now();
+    std::shared_ptr<const SuppressionSet> suppressed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (suppressed_ && now - suppressed_loaded_at_ < options_.ttl) {
+            suppressed = suppressed_;
+        }
+    }
+
+    if (!suppressed) {
+        try {
+            auto addresses = load_suppressions_();
+            auto loaded = std::make_shared<SuppressionSet>(std::make_move_iterator(addresses.begin()),
+                                                           std::make_move_iterator(addresses.end()));
+            std::lock_guard<std::mutex> lock(mutex_);
+            suppressed_ = std::move(loaded);
+            suppressed_loaded_at_ = now;
+            suppressed = suppressed_;
+        } catch (const std::exception& e) {
+            // Keep the last list (or none) until the next ttl rather than query on every send
+            common::LogError("Loading email suppression list failed", {{"error", e.what()}});
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!suppressed_) {
+                suppressed_ = std::make_shared<const SuppressionSet>();
+            }
+            suppressed_loaded_at_ = now;
+            suppressed = suppressed_;
+        }
+    }
+
+    return suppressed->count(email_address) != 0;
+}
+
+void PreferenceCache::Update(const std::string& tenant_id, const std::string& user_id, uint8_t bits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+
+    auto it = tenants_.find(tenant_id);
+    if (it != tenants_.end()) {
+        it->second.users[user_id] = bits;
+    }
+}
+
+void PreferenceCache::Suppress(const std::string& email_address) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!suppressed_ || suppressed_->count(email_address)) {
+        return;  // Not loaded yet (the next load includes it) or already listed
+    }
+    // Readers may hold the current set; publish a copy
+    auto updated = std::make_shared<SuppressionSet>(*suppressed_);
+    updated->insert(email_address);
+    suppressed_ = std::move(updated);
+}
+
+void PreferenceCache::ApplyChange(const std::string& message) {
+    size_t first = message.find(':');
+    size_t last = message.rfind(':');
+    if (first == std::string::npos || first == last || last + 1 >= message.size()) {
+        common::LogWarn("Ignoring malformed preference change", {{"message", message}});
+        return;
+    }
+    int bits = std::atoi(message.c_str() + last + 1);
+    Update(message.substr(0, first), message.substr(first + 1, last - first - 1), static_cast<uint8_t>(bits));
+}
+
+void PreferenceCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+    tenants_.clear();
+    suppressed_.reset();
+}
+
+size_t PreferenceCache::TenantCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tenants_.size();
+}
+
+uint8_t PreferenceCache::Bits(bool email, bool sms, bool push, bool marketing) {
+    return static_cast<uint8_t>((email ? PREFERENCE_EMAIL : 0) | (sms ? PREFERENCE_SMS : 0) |
+                                (push ? PREFERENCE_PUSH : 0) | (marketing ? PREFERENCE_MARKETING : 0));
+}
+
+std::string PreferenceCache::EncodeChange(const std::string& tenant_id, const std::string& user_id, uint8_t bits) {
+    return tenant_id + ":" + user_id + ":" + std::to_string(bits);
+}
+
+} // namespace notification
+} // namespace saasforge
@@ -0,0 +1,286 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Pooled HTTP client with adaptive concurrency implementation
+ */
+
+#include "notification/provider_client.h"
+#include "common/curl_pool.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <curl/curl.h>
+#include <strings.h>
+
+namespace saasforge {
+namespace notification {
+
+namespace {
+
+constexpr const char* USER_AGENT = "SaaSForge-Notifications/1.0";
+
+// Backoff before retrying a throttled request that carried no Retry-After
+constexpr std::chrono::milliseconds THROTTLE_BACKOFF{250};
+
+size_t AppendBody(char* data, size_t size, size_t count, void* user) {
+    static_cast<ProviderResponse*>(user)->body.append(data, size * count);
+    return size * count;
+}
+
+// Keeps Retry-After when given in seconds (the HTTP-date form is not used by these providers)
+size_t CaptureRetryAfter(char* data, size_t size, size_t count, void* user) {
+    size_t length = size * count;
+    constexpr size_t NAME_LENGTH = sizeof("retry-after:") - 1;
+    if (length > NAME_LENGTH && strncasecmp(data, "retry-after:", NAME_LENGTH) == 0) {
+        std::string value(data + NAME_LENGTH, length - NAME_LENGTH);
+        char* end = nullptr;
+        long seconds = std::strtol(value.c_str(), &end, 10);
+        if (end != value.c_str() && seconds > 0) {
+            static_cast<ProviderResponse*>(user)->retry_after = std::chrono::seconds(seconds);
+        }
+    }
+    return length;
+}
+
+/// Runs the requests concurrently on one multi handle (HTTP/2 multiplexed)
+std::vector<ProviderResponse> Perform(common::CurlPool& pool, const std::vector<const ProviderRequest*>& requests) {
+    struct Call {
+        CURL* easy = nullptr;
+        curl_slist* headers = nullptr;
+        char error[CURL_ERROR_SIZE] = {0};
+    };
+
+    std::vector<ProviderResponse> responses(requests.size());
+    std::vector<Call> calls(requests.size());
+    CURLM* multi = pool.TakeMulti();
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const ProviderRequest& request = *requests[i];
+        Call& call = calls[i];
+        call.easy = pool.TakeEasy();
+        if (!call.easy) {
+            responses[i].error = "curl_easy_init failed";
+            continue;
+        }
+
+        call.headers = curl_slist_append(nullptr, "Expect:");  // No 100-continue round trip
+        for (const auto& header : request.headers) {
+            call.headers = curl_slist_append(call.headers, header.c_str());
+        }
+
+        CURL* easy = call.easy;
+        curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(easy, CURLOPT_POST, 1L);
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request.body.data());
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(request.body.size()));
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, call.headers);
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, AppendBody);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, &responses[i]);
+        curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, CaptureRetryAfter);
+        curl_easy_setopt(easy, CURLOPT_HEADERDATA, &responses[i]);
+        curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, call.error);
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+
+        if (curl_multi_add_handle(multi, easy) != CURLM_OK) {
+            responses[i].error = "Failed to start HTTP request";
+            curl_slist_free_all(call.headers);
+            call.headers = nullptr;
+            pool.ReturnEasy(easy);
+            call.easy = nullptr;
+        }
+    }
+
+    int running = 0;
+    do {
+        if (curl_multi_perform(multi, &running) != CURLM_OK) {
+            break;
+        }
+        if (running > 0) {
+            curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+        }
+    } while (running > 0);
+
+    int queued = 0;
+    std::vector<CURLcode> codes(requests.size(), CURLE_OK);
+    while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+        if (message->msg != CURLMSG_DONE) {
+            continue;
+        }
+        for (size_t i = 0; i < calls.size(); ++i) {
+            if (calls[i].easy == message->easy_handle) {
+                codes[i] = message->data.result;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < calls.size(); ++i) {
+        Call& call = calls[i];
+        if (!call.easy) {
+            continue;
+        }
+        if (codes[i] == CURLE_OK) {
+            curl_easy_getinfo(call.easy, CURLINFO_RESPONSE_CODE, &responses[i].status);
+        } else {
+            responses[i].status = 0;
+            responses[i].error = call.error[0] ? call.error : curl_easy_strerror(codes[i]);
+        }
+        curl_multi_remove_handle(multi, call.easy);
+        curl_slist_free_all(call.headers);
+        pool.ReturnEasy(call.easy);
+    }
+
+    pool.ReturnMulti(multi);
+    return responses;
+}
+
+} // namespace
+
+ProviderClientOptions ProviderClientOptions::FromEnv() {
+    ProviderClientOptions options;
+    options.initial_concurrency = static_cast<size_t>(common::EnvInt(
+        "NOTIFICATION_PROVIDER_INITIAL_CONCURRENCY", static_cast<long>(options.initial_concurrency)));
+    options.min_concurrency = static_cast<size_t>(common::EnvInt(
+        "NOTIFICATION_PROVIDER_MIN_CONCURRENCY", static_cast<long>(options.min_concurrency)));
+    options.max_concurrency = static_cast<size_t>(common::EnvInt(
+        "NOTIFICATION_PROVIDER_MAX_CONCURRENCY", static_cast<long>(options.max_concurrency)));
+    options.connect_timeout = std::chrono::milliseconds(common::EnvInt(
+        "NOTIFICATION_PROVIDER_CONNECT_TIMEOUT_MS", static_cast<long>(options.connect_timeout.count())));
+    options.request_timeout = std::chrono::milliseconds(common::EnvInt(
+        "NOTIFICATION_PROVIDER_REQUEST_TIMEOUT_MS", static_cast<long>(options.request_timeout.count())));
+    options.max_attempts = static_cast<int>(common::EnvInt("NOTIFICATION_PROVIDER_MAX_ATTEMPTS", options.max_attempts));
+    return options;
+}
+
+AdaptiveConcurrency::AdaptiveConcurrency(size_t initial, size_t min, size_t max)
+    : min_(std::max<size_t>(min, 1)), max_(std::max(max, std::max<size_t>(min, 1))) {
+    limit_ = static_cast<double>(std::clamp(initial, min_, max_));
+}
+
+size_t AdaptiveConcurrency::Acquire(size_t wanted) {
+    wanted = std::max<size_t>(wanted, 1);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now < paused_until_) {
+            available_.wait_until(lock, paused_until_);
+            continue;
+        }
+        size_t limit = static_cast<size_t>(limit_);
+        if (in_flight_ < limit) {
+            size_t granted = std::min(wanted, limit - in_flight_);
+            in_flight_ += granted;
+            return granted;
+        }
+        available_.wait(lock);
+    }
+}
+
+void AdaptiveConcurrency::Release(size_t slots) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_ -= std::min(slots, in_flight_);
+    }
+    available_.notify_all();
+}
+
+void AdaptiveConcurrency::OnSuccess() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_ = std::min(static_cast<double>(max_), limit_ + 1.0 / limit_);
+    }
+    available_.notify_all();
+}
+
+void AdaptiveConcurrency::OnThrottled(std::chrono::milliseconds retry_after) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    // Responses to one wave arrive together; halve once per pause, not once per response
+    if (now >= paused_until_) {
+        limit_ = std::max(static_cast<double>(min_), limit_ / 2);
+    }
+    paused_until_ = std::max(paused_until_, now + retry_after);
+}
+
+size_t AdaptiveConcurrency::Limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(limit_);
+}
+
+ProviderClient::ProviderClient(const ProviderClientOptions& options)
+    : ProviderClient(CurlTransport(options), options) {}
+
+ProviderClient::ProviderClient(Transport transport, const ProviderClientOptions& options)
+    : transport_(std::move(transport)),
+      options_(options),
+      concurrency_(options.initial_concurrency, options.min_concurrency, options.max_concurrency) {
+    options_.max_attempts = std::max(options_.max_attempts, 1);
+}
+
+std::vector<ProviderResponse> ProviderClient::Execute(const std::vector<ProviderRequest>& requests) {
+    std::vector<ProviderResponse> responses(requests.size());
+    std::vector<size_t> pending(requests.size());
+    std::iota(pending.begin(), pending.end(), size_t{0});
+
+    std::vector<const ProviderRequest*> wave;
+    for (int attempt = 1; !pending.empty(); ++attempt) {
+        bool last_attempt = attempt >= options_.max_attempts;
+        auto backoff = std::min(options_.max_retry_wait, THROTTLE_BACKOFF * (1 << std::min(attempt - 1, 10)));
+        std::vector<size_t> throttled;
+
+        for (size_t offset = 0; offset < pending.size();) {
+            size_t slots = concurrency_.Acquire(pending.size() - offset);
+            wave.clear();
+            for (size_t i = 0; i < slots; ++i) {
+                wave.push_back(&requests[pending[offset + i]]);
+            }
+
+            std::vector<ProviderResponse> received;
+            try {
+                received = transport_(wave);
+            } catch (const std::exception& e) {
+                received.clear();
+                received.resize(wave.size());
+                for (auto& response : received) {
+                    response.error = e.what();
+                }
+            }
+            concurrency_.Release(slots);
+            received.resize(wave.size());
+
+            for (size_t i = 0; i < slots; ++i) {
+                size_t index = pending[offset + i];
+                ProviderResponse& response = received[i];
+                if (response.Throttled()) {
+                    auto wait = response.retry_after.count() > 0
+                        ? std::min(response.retry_after, options_.max_retry_wait) : backoff;
+                    concurrency_.OnThrottled(wait);
+                    if (!last_attempt) {
+                        throttled.push_back(index);
+                    }
+                } else if (response.Ok()) {
+                    concurrency_.OnSuccess();
+                }
+                responses[index] = std::move(response);
+            }
+            offset += slots;
+        }
+
+        // Retried once the throttling pause set above has passed (Acquire waits for it)
+        pending = std::move(throttled);
+    }
+    return responses;
+}
+
+ProviderClient::Transport ProviderClient::CurlTransport(const ProviderClientOptions& options) {
+    auto pool = std::make_shared<common::CurlPool>(
+        common::CurlPoolOptions{USER_AGENT, "https", options.connect_timeout, options.request_timeout});
+    return [pool](const std::vector<const ProviderRequest*>& requests) {
+        return Perform(*pool, requests);
+    };
+}
+
+} // namespace notification
+} // namespace saasforge
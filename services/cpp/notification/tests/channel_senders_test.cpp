@@ -0,0 +1,199 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the provider client, adaptive concurrency and channel senders
+ */
+
+#include <gtest/gtest.h>
+#include "notification/channel_senders.h"
+#include <mutex>
+
+using namespace saasforge::notification;
+
+namespace {
+
+/// Records requests and answers each with the status `respond` returns
+struct FakeProvider {
+    std::mutex mutex;
+    std::vector<ProviderRequest> requests;
+    std::vector<size_t> wave_sizes;
+    std::function<ProviderResponse(const ProviderRequest&, size_t call)> respond =
+        [](const ProviderRequest&, size_t) { ProviderResponse response; response.status = 202; return response; };
+
+    ProviderClient::Transport Transport() {
+        return [this](const std::vector<const ProviderRequest*>& wave) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wave_sizes.push_back(wave.size());
+            std::vector<ProviderResponse> responses;
+            for (const ProviderRequest* request : wave) {
+                responses.push_back(respond(*request, requests.size()));
+                requests.push_back(*request);
+            }
+            return responses;
+        };
+    }
+};
+
+ProviderClientOptions FastOptions() {
+    ProviderClientOptions options;
+    options.initial_concurrency = 4;
+    options.max_retry_wait = std::chrono::milliseconds(1);
+    return options;
+}
+
+size_t Count(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(AdaptiveConcurrencyTest, HalvesOnThrottleAndGrowsOnSuccess) {
+    AdaptiveConcurrency concurrency(8, 1, 16);
+    EXPECT_EQ(concurrency.Acquire(20), 8u);
+    concurrency.Release(8);
+
+    concurrency.OnThrottled(std::chrono::milliseconds(0));
+    EXPECT_EQ(concurrency.Limit(), 4u);
+
+    // +1/limit per success: about one step per limit's worth of successes
+    for (int i = 0; i < 5; ++i) {
+        concurrency.OnSuccess();
+    }
+    EXPECT_EQ(concurrency.Limit(), 5u);
+
+    for (int i = 0; i < 1000; ++i) {
+        concurrency.OnSuccess();
+    }
+    EXPECT_EQ(concurrency.Limit(), 16u);
+}
+
+TEST(ProviderClientTest, RetriesThrottledRequestsAtLowerConcurrency) {
+    FakeProvider provider;
+    provider.respond = [](const ProviderRequest&, size_t call) {
+        ProviderResponse response;
+        response.status = call == 0 ? 429 : 200;
+        return response;
+    };
+    ProviderClient client(provider.Transport(), FastOptions());
+
+    std::vector<ProviderRequest> requests(4);
+    auto responses = client.Execute(requests);
+
+    ASSERT_EQ(responses.size(), 4u);
+    for (const auto& response : responses) {
+        EXPECT_TRUE(response.Ok());
+    }
+    // First wave at the initial limit; the throttled request retried alone
+    ASSERT_EQ(provider.wave_sizes.size(), 2u);
+    EXPECT_EQ(provider.wave_sizes[0], 4u);
+    EXPECT_EQ(provider.wave_sizes[1], 1u);
+    // Halved to 2 by the 429, then regrown a little by the four successes
+    EXPECT_EQ(client.Concurrency().Limit(), 3u);
+}
+
+TEST(ProviderClientTest, GivesUpAfterMaxAttempts) {
+    FakeProvider provider;
+    provider.respond = [](const ProviderRequest&, size_t) {
+        ProviderResponse response;
+        response.status = 429;
+        return response;
+    };
+    ProviderClient client(provider.Transport(), FastOptions());
+
+    auto responses = client.Execute(std::vector<ProviderRequest>(1));
+    EXPECT_EQ(responses[0].status, 429);
+    EXPECT_EQ(provider.requests.size(), 3u);
+}
+
+TEST(SendGridSenderTest, BatchesIdenticalContentIntoPersonalizations) {
+    FakeProvider provider;
+    SendGridSender sender("key", "noreply@example.com", std::make_shared<ProviderClient>(provider.Transport()));
+
+    std::vector<OutboundEmail> emails;
+    for (size_t i = 0; i < 2 * SendGridSender::MAX_PERSONALIZATIONS + 1; ++i) {
+        emails.push_back({"user" + std::to_string(i) + "@example.com", "Launch", "<p>Hi</p>", "Hi"});
+    }
+    emails.push_back({"other@example.com", "Different", "<p>Yo</p>", ""});
+
+    auto results = sender.Send(emails);
+
+    ASSERT_EQ(results.size(), emails.size());
+    for (const auto& result : results) {
+        EXPECT_TRUE(result.delivered);
+    }
+    // 2001 recipients of one campaign need three calls; the odd one out a fourth
+    ASSERT_EQ(provider.requests.size(), 4u);
+    EXPECT_EQ(Count(provider.requests[0].body, "\"to\":"), SendGridSender::MAX_PERSONALIZATIONS);
+    EXPECT_EQ(Count(provider.requests[2].body, "\"to\":"), 1u);
+    EXPECT_NE(provider.requests[3].body.find("other@example.com"), std::string::npos);
+    EXPECT_EQ(provider.requests[0].headers[0], "Authorization: Bearer key");
+}
+
+TEST(SendGridSenderTest, FailsEveryRecipientOfARejectedRequest) {
+    FakeProvider provider;
+    provider.respond = [](const ProviderRequest& request, size_t) {
+        ProviderResponse response;
+        response.status = request.body.find("Bad") != std::string::npos ? 400 : 202;
+        return response;
+    };
+    SendGridSender sender("key", "noreply@example.com", std::make_shared<ProviderClient>(provider.Transport()));
+
+    auto results = sender.Send({{"a@example.com", "Bad", "", "x"},
+                                {"b@example.com", "Good", "", "x"},
+                                {"c@example.com", "Bad", "", "x"}});
+
+    EXPECT_FALSE(results[0].delivered);
+    EXPECT_FALSE(results[0].retryable);
+    EXPECT_EQ(results[0].error, "SendGrid HTTP 400");
+    EXPECT_TRUE(results[1].delivered);
+    EXPECT_FALSE(results[2].delivered);
+}
+
+TEST(TwilioSenderTest, FormEncodesOneRequestPerMessage) {
+    FakeProvider provider;
+    TwilioSender sender("AC123", "secret", "+15550000", std::make_shared<ProviderClient>(provider.Transport()));
+
+    auto results = sender.Send({{"+15551111", "Code: 1 & 2"}, {"+15552222", "Hi"}});
+
+    ASSERT_EQ(provider.requests.size(), 2u);
+    EXPECT_EQ(provider.requests[0].url, "https://api.twilio.com/2010-04-01/Accounts/AC123/Messages.json");
+    EXPECT_EQ(provider.requests[0].body, "To=%2B15551111&From=%2B15550000&Body=Code%3A%201%20%26%202");
+    EXPECT_EQ(provider.requests[0].headers[0], "Authorization: Basic QUMxMjM6c2VjcmV0");
+    EXPECT_TRUE(results[0].delivered);
+    EXPECT_TRUE(results[1].delivered);
+}
+
+TEST(FcmSenderTest, MulticastsAndMapsPerTokenErrors) {
+    FakeProvider provider;
+    provider.respond = [](const ProviderRequest&, size_t) {
+        ProviderResponse response;
+        response.status = 200;
+        response.body = "{\"multicast_id\":1,\"success\":1,\"failure\":2,\"results\":["
+                        "{\"message_id\":\"0:1\"},{\"error\":\"NotRegistered\"},{\"error\":\"Unavailable\"}]}";
+        return response;
+    };
+    FcmSender sender("server-key", std::make_shared<ProviderClient>(provider.Transport()));
+
+    auto results = sender.Send({{"t1", "Hello", "World", {}}, {"t2", "Hello", "World", {}},
+                                {"t3", "Hello", "World", {}}});
+
+    ASSERT_EQ(provider.requests.size(), 1u);
+    EXPECT_NE(provider.requests[0].body.find("\"registration_ids\":[\"t1\",\"t2\",\"t3\"]"), std::string::npos);
+    EXPECT_TRUE(results[0].delivered);
+    EXPECT_FALSE(results[1].delivered);
+    EXPECT_FALSE(results[1].retryable);
+    EXPECT_EQ(results[1].error, "FCM NotRegistered");
+    EXPECT_TRUE(results[2].retryable);
+}
+
+TEST(FcmSenderTest, ParseResultsSkipsBracesInsideStrings) {
+    auto errors = FcmSender::ParseResults(
+        "{\"results\":[{\"message_id\":\"a}{\"},{\"error\":\"InvalidRegistration\"}]}", 2);
+    ASSERT_EQ(errors.size(), 2u);
+    EXPECT_EQ(errors[0], "");
+    EXPECT_EQ(errors[1], "InvalidRegistration");
+}
@@ -0,0 +1,264 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for notification digests
+ */
+
+#include <gtest/gtest.h>
+#include "notification/digest_buffer.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+using namespace saasforge::notification;
+using namespace std::chrono_literals;
+
+namespace {
+
+// In-memory stand-in for the Redis scripts, with the same due, lease and ack rules.
+// `now` is advanced by hand.
+struct FakeDigestStore {
+    std::mutex mutex;
+    int64_t now = 1000000;
+    int64_t last_score = 0;
+    std::map<std::string, std::vector<std::pair<int64_t, std::string>>> items;
+    std::map<std::string, int64_t> due;
+    std::map<std::string, int64_t> leases;     // Buffer id -> lease expiry
+
+    DigestStore Store() {
+        DigestStore store;
+        store.add = [this](const std::string& id, const std::string& member, std::chrono::milliseconds window,
+                           size_t max_items) {
+            std::lock_guard<std::mutex> lock(mutex);
+            last_score = std::max(last_score + 1, now);
+            auto& buffer = items[id];
+            buffer.emplace_back(last_score, member);
+            if (buffer.size() >= max_items) {
+                due[id] = now;
+            } else {
+                due.emplace(id, now + window.count());
+            }
+            return buffer.size();
+        };
+        store.claim = [this](size_t limit, std::chrono::seconds lease) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<DigestClaim> claims;
+            for (auto& [id, at] : due) {
+                if (claims.size() == limit || at > now) {
+                    continue;
+                }
+                auto held = leases.find(id);
+                if (held != leases.end() && held->second > now) {
+                    continue;
+                }
+                leases[id] = now + lease.count() * 1000;
+                at = now + lease.count() * 1000;
+                DigestClaim claim;
+                claim.buffer_id = id;
+                claim.up_to = std::to_string(items[id].back().first);
+                for (const auto& item : items[id]) {
+                    claim.items.push_back(item.second);
+                }
+                claims.push_back(std::move(claim));
+            }
+            return claims;
+        };
+        store.ack = [this](const DigestClaim& claim, std::chrono::milliseconds window) {
+            std::lock_guard<std::mutex> lock(mutex);
+            int64_t up_to = std::stoll(claim.up_to);
+            auto& buffer = items[claim.buffer_id];
+            buffer.erase(std::remove_if(buffer.begin(), buffer.end(),
+                                        [&](const auto& item) { return item.first <= up_to; }),
+                         buffer.end());
+            leases.erase(claim.buffer_id);
+            if (buffer.empty()) {
+                items.erase(claim.buffer_id);
+                due.erase(claim.buffer_id);
+            } else {
+                due[claim.buffer_id] = now + window.count();
+            }
+        };
+        return store;
+    }
+
+    void Advance(std::chrono::milliseconds by) {
+        std::lock_guard<std::mutex> lock(mutex);
+        now += by.count();
+    }
+};
+
+DigestOptions TestOptions() {
+    DigestOptions options;
+    options.window = 60s;
+    options.max_items = 50;
+    options.lease = 30s;
+    options.flush_interval = std::chrono::hours(1);   // Tests call FlushDue() themselves
+    return options;
+}
+
+DigestItem Email(const std::string& subject, const std::string& user = "user-1") {
+    return {"tenant-a", user, user + "@example.com", subject, "<p>" + subject + "</p>", subject};
+}
+
+} // namespace
+
+// Test that items survive the encoding used for Redis members
+TEST(DigestBufferTest, EncodesItems) {
+    DigestItem item{"tenant-a", "user-1", "a@example.com", "Payment failed", "<b>x</b>", std::string("a\0b", 3)};
+    auto decoded = DigestItem::Decode(item.Encode());
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->subject, "Payment failed");
+    EXPECT_EQ(decoded->body_text, item.body_text);
+    EXPECT_FALSE(DigestItem::Decode(item.Encode().substr(0, 10)).has_value());
+    EXPECT_FALSE(DigestItem::Decode("").has_value());
+}
+
+// Test that notifications of one user and key share a buffer, and others do not
+TEST(DigestBufferTest, BuffersPerUserAndKey) {
+    FakeDigestStore fake;
+    DigestBuffer digests(fake.Store(), TestOptions());
+    EXPECT_EQ(digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 1 failed")), 1u);
+    EXPECT_EQ(digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 2 failed")), 2u);
+    EXPECT_EQ(digests.Add(DigestChannel::EMAIL, "upload_done", Email("a.png uploaded")), 1u);
+    EXPECT_EQ(digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 3 failed", "user-2")), 1u);
+    EXPECT_EQ(digests.Add(DigestChannel::PUSH, "payment_failed", Email("Invoice 1 failed")), 1u);
+    EXPECT_EQ(fake.items.size(), 4u);
+    EXPECT_EQ(digests.Buffered(), 5u);
+
+    EXPECT_THROW(digests.Add(DigestChannel::EMAIL, "", Email("x")), std::invalid_argument);
+    EXPECT_THROW(digests.Add(DigestChannel::EMAIL, std::string(DigestBuffer::MAX_KEY_LENGTH + 1, 'k'), Email("x")),
+                 std::invalid_argument);
+}
+
+// Test that a buffer goes out once, merged, after its window
+TEST(DigestBufferTest, FlushesMergedDigestAfterWindow) {
+    FakeDigestStore fake;
+    DigestBuffer digests(fake.Store(), TestOptions());
+    std::vector<Digest> delivered;
+    DigestFlusher flusher(fake.Store(), [&](const Digest& digest) { delivered.push_back(digest); }, TestOptions());
+
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 1 failed"));
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice <2> failed"));
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 3 failed"));
+    EXPECT_EQ(flusher.FlushDue(), 0u);
+
+    fake.Advance(61s);
+    EXPECT_EQ(flusher.FlushDue(), 1u);
+    ASSERT_EQ(delivered.size(), 1u);
+    const Digest& digest = delivered[0];
+    EXPECT_EQ(digest.channel, DigestChannel::EMAIL);
+    EXPECT_EQ(digest.coalescing_key, "payment_failed");
+    EXPECT_EQ(digest.count, 3u);
+    EXPECT_EQ(digest.merged.to, "user-1@example.com");
+    EXPECT_EQ(digest.merged.subject, "Invoice 1 failed (+2 more)");
+    EXPECT_NE(digest.merged.body_html.find("<h3>Invoice &lt;2&gt; failed</h3>"), std::string::npos);
+    EXPECT_NE(digest.merged.body_text.find("3 notifications"), std::string::npos);
+
+    EXPECT_TRUE(fake.items.empty());
+    EXPECT_TRUE(fake.due.empty());
+    EXPECT_EQ(flusher.GetStats().flushed, 1u);
+    EXPECT_EQ(flusher.GetStats().merged, 3u);
+}
+
+// Test that a single buffered notification goes out unchanged
+TEST(DigestBufferTest, SingleItemIsNotWrapped) {
+    FakeDigestStore fake;
+    DigestBuffer digests(fake.Store(), TestOptions());
+    std::vector<Digest> delivered;
+    DigestFlusher flusher(fake.Store(), [&](const Digest& digest) { delivered.push_back(digest); }, TestOptions());
+
+    digests.Add(DigestChannel::PUSH, "upload_done", {"tenant-a", "user-1", "", "a.png uploaded", "", "Ready"});
+    fake.Advance(61s);
+    flusher.FlushDue();
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].channel, DigestChannel::PUSH);
+    EXPECT_EQ(delivered[0].merged.subject, "a.png uploaded");
+    EXPECT_EQ(delivered[0].merged.body_text, "Ready");
+}
+
+// Test that a full buffer is due at once, and that the merged message lists at most max_items
+TEST(DigestBufferTest, FullBufferFlushesEarly) {
+    FakeDigestStore fake;
+    auto options = TestOptions();
+    options.max_items = 3;
+    DigestBuffer digests(fake.Store(), options);
+    std::vector<Digest> delivered;
+    DigestFlusher flusher(fake.Store(), [&](const Digest& digest) { delivered.push_back(digest); }, options);
+
+    for (int i = 0; i < 3; ++i) {
+        digests.Add(DigestChannel::PUSH, "alerts", {"tenant-a", "user-1", "", "Alert " + std::to_string(i), "", "x"});
+    }
+    EXPECT_EQ(flusher.FlushDue(), 1u);
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].merged.body_text, "Alert 0: x\nAlert 1: x\nAlert 2: x");
+
+    DigestClaim claim;
+    claim.buffer_id = "push:tenant-a:user-1:alerts";
+    for (int i = 0; i < 5; ++i) {
+        DigestItem item{"tenant-a", "user-1", "", "Alert " + std::to_string(i), "", "x"};
+        claim.items.push_back(std::string(16, '\0') + item.Encode());
+    }
+    auto merged = DigestBuffer::Merge(claim, 3);
+    ASSERT_TRUE(merged.has_value());
+    EXPECT_EQ(merged->count, 5u);
+    EXPECT_EQ(merged->coalescing_key, "alerts");
+    EXPECT_EQ(merged->merged.body_text, "Alert 0: x\nAlert 1: x\nAlert 2: x\n+2 more");
+}
+
+// Test that a failed delivery is retried after the lease, with what arrived meanwhile
+TEST(DigestBufferTest, RetriesFailedDeliveryAfterLease) {
+    FakeDigestStore fake;
+    DigestBuffer digests(fake.Store(), TestOptions());
+    int attempts = 0;
+    std::vector<Digest> delivered;
+    DigestFlusher flusher(fake.Store(), [&](const Digest& digest) {
+        if (++attempts == 1) {
+            throw std::runtime_error("database unavailable");
+        }
+        delivered.push_back(digest);
+    }, TestOptions());
+
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 1 failed"));
+    fake.Advance(61s);
+    EXPECT_EQ(flusher.FlushDue(), 1u);
+    EXPECT_TRUE(delivered.empty());
+    EXPECT_EQ(flusher.GetStats().failed, 1u);
+
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 2 failed"));
+    fake.Advance(10s);
+    EXPECT_EQ(flusher.FlushDue(), 0u);     // Still leased
+
+    fake.Advance(25s);
+    EXPECT_EQ(flusher.FlushDue(), 1u);
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].count, 2u);
+    EXPECT_TRUE(fake.items.empty());
+}
+
+// Test that items added while a digest is being delivered go out in the next one
+TEST(DigestBufferTest, KeepsItemsAddedDuringDelivery) {
+    FakeDigestStore fake;
+    DigestBuffer digests(fake.Store(), TestOptions());
+    std::vector<Digest> delivered;
+    DigestFlusher flusher(fake.Store(), [&](const Digest& digest) {
+        if (delivered.empty()) {
+            digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 3 failed"));
+        }
+        delivered.push_back(digest);
+    }, TestOptions());
+
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 1 failed"));
+    digests.Add(DigestChannel::EMAIL, "payment_failed", Email("Invoice 2 failed"));
+    fake.Advance(61s);
+    flusher.FlushDue();
+    ASSERT_EQ(delivered.size(), 1u);
+    EXPECT_EQ(delivered[0].count, 2u);
+    ASSERT_EQ(fake.items.size(), 1u);
+
+    fake.Advance(61s);
+    flusher.FlushDue();
+    ASSERT_EQ(delivered.size(), 2u);
+    EXPECT_EQ(delivered[1].count, 1u);
+    EXPECT_EQ(delivered[1].merged.subject, "Invoice 3 failed");
+}
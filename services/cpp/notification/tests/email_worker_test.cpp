@@ -0,0 +1,345 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the multi-threaded email_queue worker
+ */
+
+#include <gtest/gtest.h>
+#include "notification/email_worker.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace saasforge::notification;
+using saasforge::common::EmailFailure;
+using saasforge::common::QueuedEmail;
+
+namespace {
+
+// In-memory email_queue: hands out `pending` in batches, records every result write
+struct FakeQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> pending;
+    std::vector<std::string> sent;
+    std::vector<EmailFailure> failed;
+    std::vector<std::string> released;
+    std::vector<std::string> reclaimed;
+    std::vector<std::string> released_held;
+    int mark_sent_calls = 0;
+    int mark_sent_failures = 0;     // The next N mark_sent calls throw
+    bool holds = false;             // Offer reclaim_held/release_held
+
+    void Add(int count, const std::string& prefix = "e") {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < count; ++i) {
+            pending.push_back(prefix + std::to_string(i));
+        }
+        cv.notify_all();
+    }
+
+    size_t Written() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sent.size() + failed.size();
+    }
+
+    EmailWorkerQueue Ops() {
+        EmailWorkerQueue ops;
+        ops.wait_for_batch = [this](int batch_size, std::chrono::milliseconds max_wait) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, max_wait, [this] { return !pending.empty(); });
+            std::vector<QueuedEmail> batch;
+            while (!pending.empty() && static_cast<int>(batch.size()) < batch_size) {
+                QueuedEmail email{};
+                email.id = pending.front();
+                email.to_address = pending.front() + "@example.com";
+                email.subject = "Hello";
+                batch.push_back(email);
+                pending.erase(pending.begin());
+            }
+            return batch;
+        };
+        ops.mark_sent = [this](const std::vector<std::string>& ids) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++mark_sent_calls;
+            if (mark_sent_failures > 0) {
+                --mark_sent_failures;
+                throw std::runtime_error("connection lost");
+            }
+            sent.insert(sent.end(), ids.begin(), ids.end());
+            return ids.size();
+        };
+        ops.mark_failed = [this](const std::vector<EmailFailure>& failures, std::chrono::seconds) {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed.insert(failed.end(), failures.begin(), failures.end());
+            return failures.size();
+        };
+        ops.release = [this](const std::vector<std::string>& ids) {
+            std::lock_guard<std::mutex> lock(mutex);
+            released.insert(released.end(), ids.begin(), ids.end());
+            return ids.size();
+        };
+        if (holds) {
+            ops.reclaim_held = [this](const std::vector<QueuedEmail>& held) {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::vector<std::string> ids;
+                for (const auto& email : held) {
+                    ids.push_back(email.id);
+                }
+                reclaimed.insert(reclaimed.end(), ids.begin(), ids.end());
+                return ids;
+            };
+            ops.release_held = [this](const std::vector<QueuedEmail>& held, std::chrono::seconds) {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& email : held) {
+                    released_held.push_back(email.id);
+                }
+                return held.size();
+            };
+        }
+        return ops;
+    }
+};
+
+EmailWorkerOptions FastOptions() {
+    EmailWorkerOptions options;
+    options.dequeue_threads = 2;
+    options.send_threads = 4;
+    options.batch_size = 10;
+    options.idle_wait = std::chrono::milliseconds(20);
+    options.ack_interval = std::chrono::milliseconds(20);
+    return options;
+}
+
+bool WaitFor(const std::function<bool()>& done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(EmailWorkerTest, SendsEveryClaimedEmail) {
+    FakeQueue queue;
+    queue.Add(95);
+    EmailWorker worker(queue.Ops(), EmailWorker::ProviderSend(nullptr), FastOptions());
+
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() == 95; }));
+    worker.Shutdown();
+
+    auto stats = worker.GetStats();
+    EXPECT_EQ(stats.claimed, 95u);
+    EXPECT_EQ(stats.sent, 95u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(stats.unacked, 0u);
+    EXPECT_TRUE(queue.failed.empty());
+}
+
+TEST(EmailWorkerTest, BatchesResultWrites) {
+    FakeQueue queue;
+    queue.Add(100);
+    auto options = FastOptions();
+    options.ack_interval = std::chrono::milliseconds(10000);
+    options.ack_max = 1000;
+    EmailWorker worker(queue.Ops(), EmailWorker::ProviderSend(nullptr), options);
+
+    // Ten batches sent, nothing written until the interval or shutdown
+    ASSERT_TRUE(WaitFor([&] { return worker.GetStats().unacked == 100; }));
+    EXPECT_EQ(queue.Written(), 0u);
+
+    worker.Shutdown();
+    EXPECT_EQ(queue.sent.size(), 100u);
+    EXPECT_EQ(queue.mark_sent_calls, 1);
+}
+
+TEST(EmailWorkerTest, FlushesAtAckMax) {
+    FakeQueue queue;
+    queue.Add(50);
+    auto options = FastOptions();
+    options.ack_interval = std::chrono::milliseconds(10000);
+    options.ack_max = 20;
+    EmailWorker worker(queue.Ops(), EmailWorker::ProviderSend(nullptr), options);
+
+    // Written long before the interval
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() >= 20; }));
+    ASSERT_TRUE(WaitFor([&] {
+        auto stats = worker.GetStats();
+        return stats.claimed == 50 && stats.pending_batches == 0;
+    }));
+    worker.Shutdown();
+    EXPECT_EQ(queue.sent.size(), 50u);
+}
+
+TEST(EmailWorkerTest, RecordsProviderRejectionsAsSoftFailures) {
+    FakeQueue queue;
+    queue.Add(10);
+    auto send = [](const std::vector<OutboundEmail>& emails) {
+        std::vector<DeliveryResult> results(emails.size());
+        for (size_t i = 0; i < emails.size(); ++i) {
+            results[i].delivered = emails[i].to != "e3@example.com";
+            if (!results[i].delivered) {
+                results[i].error = "HTTP 400";
+            }
+        }
+        return results;
+    };
+    EmailWorker worker(queue.Ops(), send, FastOptions());
+
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() == 10; }));
+    worker.Shutdown();
+
+    ASSERT_EQ(queue.failed.size(), 1u);
+    EXPECT_EQ(queue.failed[0].email_id, "e3");
+    EXPECT_EQ(queue.failed[0].error_message, "HTTP 400");
+    EXPECT_FALSE(queue.failed[0].is_hard_bounce);
+    EXPECT_EQ(queue.sent.size(), 9u);
+}
+
+TEST(EmailWorkerTest, ThrowingSendFailsTheBatch) {
+    FakeQueue queue;
+    queue.Add(5);
+    auto send = [](const std::vector<OutboundEmail>&) -> std::vector<DeliveryResult> {
+        throw std::runtime_error("provider down");
+    };
+    EmailWorker worker(queue.Ops(), send, FastOptions());
+
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() == 5; }));
+    worker.Shutdown();
+    EXPECT_EQ(queue.failed.size(), 5u);
+    EXPECT_EQ(worker.GetStats().failed, 5u);
+}
+
+TEST(EmailWorkerTest, RetriesFailedResultWrites) {
+    FakeQueue queue;
+    queue.mark_sent_failures = 2;
+    queue.Add(10);
+    EmailWorker worker(queue.Ops(), EmailWorker::ProviderSend(nullptr), FastOptions());
+
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() == 10; }));
+    worker.Shutdown();
+
+    auto stats = worker.GetStats();
+    EXPECT_EQ(stats.failed_acks, 2u);
+    EXPECT_EQ(stats.sent, 10u);
+    EXPECT_EQ(queue.sent.size(), 10u);
+}
+
+TEST(EmailWorkerTest, ReleasesUnsentBatchesOnShutdown) {
+    FakeQueue queue;
+    queue.Add(100);
+
+    // One send thread held inside the provider call until the worker is stopping
+    std::mutex gate_mutex;
+    std::condition_variable gate_cv;
+    bool open = false;
+    bool entered = false;
+    auto send = [&](const std::vector<OutboundEmail>& emails) {
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        entered = true;
+        gate_cv.notify_all();
+        gate_cv.wait(lock, [&] { return open; });
+        return std::vector<DeliveryResult>(emails.size(), DeliveryResult{true, false, ""});
+    };
+    auto options = FastOptions();
+    options.dequeue_threads = 1;
+    options.send_threads = 1;
+    options.max_pending_batches = 3;
+    EmailWorker worker(queue.Ops(), send, options);
+
+    {
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        ASSERT_TRUE(gate_cv.wait_for(lock, std::chrono::seconds(5), [&] { return entered; }));
+    }
+    ASSERT_TRUE(WaitFor([&] { return worker.GetStats().pending_batches == 3; }));
+
+    std::thread stopper([&] { worker.Shutdown(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::lock_guard<std::mutex> lock(gate_mutex);
+        open = true;
+    }
+    gate_cv.notify_all();
+    stopper.join();
+
+    // One batch sent, three pending handed back, the rest never claimed
+    EXPECT_EQ(queue.sent.size(), 10u);
+    EXPECT_EQ(queue.released.size(), 30u);
+    EXPECT_EQ(queue.pending.size(), 60u);
+    EXPECT_EQ(worker.GetStats().claimed, 40u);
+}
+
+TEST(EmailWorkerTest, ResendsShortRetriesFromMemory) {
+    FakeQueue queue;
+    queue.holds = true;
+    queue.Add(10);
+
+    // e3 is rejected once, then accepted
+    std::atomic<int> e3_attempts{0};
+    auto send = [&](const std::vector<OutboundEmail>& emails) {
+        std::vector<DeliveryResult> results(emails.size());
+        for (size_t i = 0; i < emails.size(); ++i) {
+            results[i].delivered = emails[i].to != "e3@example.com" || ++e3_attempts > 1;
+            if (!results[i].delivered) {
+                results[i].error = "HTTP 503";
+            }
+        }
+        return results;
+    };
+    EmailWorker worker(queue.Ops(), send, FastOptions());
+
+    // Retry 1 is due after a second; claimed back by ID, not from the queue
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() == 11; }));
+    worker.Shutdown();
+
+    ASSERT_EQ(queue.failed.size(), 1u);
+    EXPECT_TRUE(queue.failed[0].held);
+    EXPECT_EQ(queue.reclaimed, std::vector<std::string>{"e3"});
+    EXPECT_EQ(queue.sent.size(), 10u);
+    EXPECT_EQ(e3_attempts.load(), 2);
+    EXPECT_EQ(worker.GetStats().resent, 1u);
+    EXPECT_EQ(worker.GetStats().claimed, 10u);
+}
+
+TEST(EmailWorkerTest, ReleasesHeldRetriesOnShutdown) {
+    FakeQueue queue;
+    queue.holds = true;
+    queue.Add(5);
+    auto send = [](const std::vector<OutboundEmail>& emails) {
+        return std::vector<DeliveryResult>(emails.size(), DeliveryResult{false, true, "HTTP 503"});
+    };
+    EmailWorker worker(queue.Ops(), send, FastOptions());
+
+    ASSERT_TRUE(WaitFor([&] { return worker.GetStats().held == 5; }));
+    worker.Shutdown();
+
+    EXPECT_EQ(queue.released_held.size(), 5u);
+    EXPECT_TRUE(queue.reclaimed.empty());
+    EXPECT_EQ(worker.GetStats().held, 0u);
+}
+
+TEST(EmailWorkerTest, HoldsNothingWithoutHoldMax) {
+    FakeQueue queue;
+    queue.holds = true;
+    queue.Add(5);
+    auto send = [](const std::vector<OutboundEmail>& emails) {
+        return std::vector<DeliveryResult>(emails.size(), DeliveryResult{false, true, "HTTP 503"});
+    };
+    auto options = FastOptions();
+    options.hold_max = std::chrono::milliseconds(0);
+    EmailWorker worker(queue.Ops(), send, options);
+
+    ASSERT_TRUE(WaitFor([&] { return queue.Written() == 5; }));
+    worker.Shutdown();
+
+    for (const auto& failure : queue.failed) {
+        EXPECT_FALSE(failure.held);
+    }
+    EXPECT_TRUE(queue.released_held.empty());
+}
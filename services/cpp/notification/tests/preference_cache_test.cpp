@@ -0,0 +1,98 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the notification preference and suppression cache
+ */
+
+#include <gtest/gtest.h>
+#include "notification/preference_cache.h"
+#include <stdexcept>
+
+using namespace saasforge::notification;
+
+namespace {
+
+struct Sources {
+    int preference_loads = 0;
+    int suppression_loads = 0;
+
+    PreferenceCache::PreferenceLoader Preferences() {
+        return [this](const std::string& tenant_id) {
+            ++preference_loads;
+            std::unordered_map<std::string, uint8_t> users;
+            if (tenant_id == "tenant-1") {
+                users["quiet"] = PreferenceCache::Bits(false, false, true, false);
+            }
+            return users;
+        };
+    }
+
+    PreferenceCache::SuppressionLoader Suppressions() {
+        return [this]() {
+            ++suppression_loads;
+            return std::vector<std::string>{"bounced@example.com"};
+        };
+    }
+};
+
+} // namespace
+
+TEST(PreferenceCacheTest, LoadsEachTenantOnce) {
+    Sources sources;
+    PreferenceCache cache(sources.Preferences(), sources.Suppressions());
+
+    EXPECT_FALSE(cache.Allows("tenant-1", "quiet", PREFERENCE_EMAIL));
+    EXPECT_TRUE(cache.Allows("tenant-1", "quiet", PREFERENCE_PUSH));
+    // Users without a row get the defaults
+    EXPECT_TRUE(cache.Allows("tenant-1", "someone", PREFERENCE_SMS));
+    EXPECT_FALSE(cache.Allows("tenant-1", "someone", PREFERENCE_MARKETING));
+    EXPECT_EQ(sources.preference_loads, 1);
+
+    cache.Allows("tenant-2", "someone", PREFERENCE_EMAIL);
+    EXPECT_EQ(sources.preference_loads, 2);
+    EXPECT_EQ(cache.TenantCount(), 2u);
+}
+
+TEST(PreferenceCacheTest, AppliesLocalAndPublishedChanges) {
+    Sources sources;
+    PreferenceCache cache(sources.Preferences(), sources.Suppressions());
+    cache.Allows("tenant-1", "quiet", PREFERENCE_EMAIL);
+
+    cache.Update("tenant-1", "quiet", PreferenceCache::Bits(true, false, false, false));
+    EXPECT_TRUE(cache.Allows("tenant-1", "quiet", PREFERENCE_EMAIL));
+
+    cache.ApplyChange(PreferenceCache::EncodeChange("tenant-1", "quiet", PreferenceCache::Bits(false, true, false, false)));
+    EXPECT_FALSE(cache.Allows("tenant-1", "quiet", PREFERENCE_EMAIL));
+    EXPECT_TRUE(cache.Allows("tenant-1", "quiet", PREFERENCE_SMS));
+
+    cache.ApplyChange("garbage");
+    EXPECT_EQ(sources.preference_loads, 1);
+
+    cache.Clear();
+    EXPECT_EQ(cache.TenantCount(), 0u);
+}
+
+TEST(PreferenceCacheTest, ChecksSuppressionListInMemory) {
+    Sources sources;
+    PreferenceCache cache(sources.Preferences(), sources.Suppressions());
+
+    EXPECT_TRUE(cache.IsSuppressed("bounced@example.com"));
+    EXPECT_FALSE(cache.IsSuppressed("ok@example.com"));
+    cache.Suppress("new-bounce@example.com");
+    EXPECT_TRUE(cache.IsSuppressed("new-bounce@example.com"));
+    EXPECT_EQ(sources.suppression_loads, 1);
+}
+
+TEST(PreferenceCacheTest, FailedSuppressionLoadIsNotRetriedPerSend) {
+    int loads = 0;
+    PreferenceCache cache(
+        [](const std::string&) { return std::unordered_map<std::string, uint8_t>(); },
+        [&loads]() -> std::vector<std::string> {
+            ++loads;
+            throw std::runtime_error("relation \"email_suppression\" does not exist");
+        });
+
+    EXPECT_FALSE(cache.IsSuppressed("a@example.com"));
+    EXPECT_FALSE(cache.IsSuppressed("b@example.com"));
+    EXPECT_EQ(loads, 1);
+}
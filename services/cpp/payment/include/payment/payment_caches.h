@@ -0,0 +1,58 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Cached subscription and invoice reads of the payment service
+ */
+
+#pragma once
+
+#include "payment.pb.h"
+#include "common/entity_cache.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace saasforge {
+namespace payment {
+
+/// GetSubscription answers by (tenant_id, subscription id)
+using SubscriptionCache = common::EntityCache<std::pair<std::string, std::string>, SubscriptionResponse>;
+
+/// GetInvoice answers by (tenant_id, invoice id)
+using InvoiceCache = common::EntityCache<std::pair<std::string, std::string>, InvoiceResponse>;
+
+/**
+ * The payment service's entity caches (ENTITY_CACHE_*)
+ *
+ * Subscriptions are invalidated by UpdateSubscription, CancelSubscription
+ * and Stripe status transitions (DbStripeEventStore). Invoices are not
+ * written by this service; whatever writes them publishes the invoice's
+ * "<tenant_id>:<id>" on invoices->Topic(), and `ttl` bounds staleness
+ * otherwise.
+ */
+struct PaymentCaches {
+    std::shared_ptr<SubscriptionCache> subscriptions;
+    std::shared_ptr<InvoiceCache> invoices;
+
+    /// Both caches on Redis (none: local only) and the event bus (none: no invalidations between replicas)
+    static PaymentCaches Create(std::shared_ptr<common::RedisClient> redis, std::shared_ptr<common::EventBus> event_bus,
+                                const common::EntityCacheOptions& options) {
+        auto store = common::EntityCacheStore::From(std::move(redis));
+        PaymentCaches caches;
+        caches.subscriptions = std::make_shared<SubscriptionCache>("subscription", store, event_bus, options);
+        caches.invoices = std::make_shared<InvoiceCache>("invoice", store, event_bus, options);
+        return caches;
+    }
+
+    /// DbStripeEventStore listener invalidating the subscriptions it changed
+    std::function<void(const std::vector<std::pair<std::string, std::string>>&)> SubscriptionsUpdated() const {
+        return [subscriptions = subscriptions](const std::vector<std::pair<std::string, std::string>>& updated) {
+            subscriptions->InvalidateMany(updated);
+        };
+    }
+};
+
+} // namespace payment
+} // namespace saasforge
@@ -0,0 +1,82 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Sync and callback gRPC registrations for PaymentServiceImpl
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "payment.grpc.pb.h"
+#include "payment/payment_service.h"
+#include "common/arena_allocator.h"
+#include "common/executor.h"
+#include "common/service_adapter.h"
+
+// Single list of PaymentService RPCs; keep in sync with proto/payment.proto
+#define SAASFORGE_PAYMENT_RPCS(X) \
+    X(CreateSubscription, CreateSubscriptionRequest, SubscriptionResponse) \
+    X(UpdateSubscription, UpdateSubscriptionRequest, SubscriptionResponse) \
+    X(CancelSubscription, CancelSubscriptionRequest, SubscriptionResponse) \
+    X(GetSubscription, GetSubscriptionRequest, SubscriptionResponse) \
+    X(AddPaymentMethod, AddPaymentMethodRequest, PaymentMethodResponse) \
+    X(RemovePaymentMethod, RemovePaymentMethodRequest, RemovePaymentMethodResponse) \
+    X(GetInvoice, GetInvoiceRequest, InvoiceResponse) \
+    X(RecordUsage, RecordUsageRequest, RecordUsageResponse) \
+    X(GetUsageSummary, GetUsageSummaryRequest, GetUsageSummaryResponse) \
+    X(HandleStripeWebhook, StripeWebhookRequest, StripeWebhookResponse)
+
+#define SAASFORGE_PAYMENT_CLIENT_STREAM_RPCS(X) \
+    X(StreamUsage, RecordUsageRequest, StreamUsageResponse)
+
+namespace saasforge {
+namespace payment {
+
+/**
+ * RPCs that carry no tenant: Stripe webhook deliveries are authenticated by
+ * their signature; the tenant context interceptor rejects every other
+ * PaymentService call without a tenant or user
+ */
+inline std::vector<std::string> PublicMethods() {
+    return {std::string("/") + PaymentService::service_full_name() + "/HandleStripeWebhook"};
+}
+
+/**
+ * Registers PaymentServiceImpl on the synchronous API (handlers on gRPC threads)
+ */
+class PaymentServiceSync final : public PaymentService::Service {
+public:
+    explicit PaymentServiceSync(std::shared_ptr<PaymentServiceImpl> impl) : impl_(std::move(impl)) {}
+
+    SAASFORGE_PAYMENT_RPCS(SAASFORGE_SYNC_UNARY_METHOD)
+    SAASFORGE_PAYMENT_CLIENT_STREAM_RPCS(SAASFORGE_SYNC_CLIENT_STREAM_METHOD)
+
+private:
+    std::shared_ptr<PaymentServiceImpl> impl_;
+};
+
+/**
+ * Registers PaymentServiceImpl on the callback API; handlers run on a bounded Executor
+ *
+ * Unary requests and responses are allocated on one protobuf arena per RPC.
+ */
+class PaymentServiceCallback final : public PaymentService::CallbackService {
+public:
+    PaymentServiceCallback(std::shared_ptr<PaymentServiceImpl> impl, std::shared_ptr<common::Executor> executor)
+        : impl_(std::move(impl)), executor_(std::move(executor)), arenas_(PaymentService::service_full_name()) {
+        SAASFORGE_PAYMENT_RPCS(SAASFORGE_CALLBACK_ARENA_ALLOCATOR)
+    }
+
+    SAASFORGE_PAYMENT_RPCS(SAASFORGE_CALLBACK_UNARY_METHOD)
+    SAASFORGE_PAYMENT_CLIENT_STREAM_RPCS(SAASFORGE_CALLBACK_CLIENT_STREAM_METHOD)
+
+private:
+    std::shared_ptr<PaymentServiceImpl> impl_;
+    std::shared_ptr<common::Executor> executor_;
+    common::ArenaAllocators arenas_;
+};
+
+} // namespace payment
+} // namespace saasforge
@@ -1,80 +1,177 @@
 #pragma once
 
 #include <grpcpp/grpcpp.h>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "payment.grpc.pb.h"
 #include "common/redis_client.h"
 #include "common/db_pool.h"
+#include "common/idempotency_store.h"
+#include "common/usage_aggregator.h"
+#include "payment/payment_caches.h"
+#include "payment/plan_catalog.h"
+#include "payment/stripe_webhooks.h"
 
 namespace saasforge {
 namespace payment {
 
-class PaymentServiceImpl final : public ::saasforge::payment::PaymentService::Service {
+/**
+ * PaymentService RPC handlers
+ *
+ * Handlers take grpc::ServerContextBase so the same implementation serves
+ * both the sync and the callback server (see payment_grpc_service.h).
+ * Mutating handlers with an idempotency_key run through IdempotencyStore;
+ * their bodies are the private Apply* methods. GetSubscription and
+ * GetInvoice are served from PaymentCaches.
+ */
+class PaymentServiceImpl final {
 public:
     PaymentServiceImpl(
         std::shared_ptr<common::RedisClient> redis_client,
         std::shared_ptr<common::DbPool> db_pool,
         const std::string& stripe_secret_key,
-        const std::string& stripe_webhook_secret
+        const std::string& stripe_webhook_secret,
+        std::shared_ptr<common::UsageAggregator> usage_aggregator = nullptr,
+        std::shared_ptr<common::IdempotencyStore> idempotency = nullptr,
+        std::shared_ptr<PlanCatalog> plan_catalog = nullptr,
+        std::shared_ptr<StripeWebhookIngestor> stripe_webhooks = nullptr,
+        PaymentCaches caches = {}
     );
 
     grpc::Status CreateSubscription(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const CreateSubscriptionRequest* request,
         SubscriptionResponse* response
-    ) override;
+    );
 
     grpc::Status UpdateSubscription(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const UpdateSubscriptionRequest* request,
         SubscriptionResponse* response
-    ) override;
+    );
 
     grpc::Status CancelSubscription(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const CancelSubscriptionRequest* request,
         SubscriptionResponse* response
-    ) override;
+    );
 
     grpc::Status GetSubscription(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const GetSubscriptionRequest* request,
         SubscriptionResponse* response
-    ) override;
+    );
 
     grpc::Status AddPaymentMethod(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const AddPaymentMethodRequest* request,
         PaymentMethodResponse* response
-    ) override;
+    );
 
     grpc::Status RemovePaymentMethod(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const RemovePaymentMethodRequest* request,
         RemovePaymentMethodResponse* response
-    ) override;
+    );
 
     grpc::Status GetInvoice(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const GetInvoiceRequest* request,
         InvoiceResponse* response
-    ) override;
+    );
 
     grpc::Status RecordUsage(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const RecordUsageRequest* request,
         RecordUsageResponse* response
-    ) override;
+    );
+
+    /// Called once per chunk of the client stream; counts accumulate in response
+    grpc::Status StreamUsage(
+        grpc::ServerContextBase* context,
+        const std::vector<RecordUsageRequest>& requests,
+        StreamUsageResponse* response
+    );
+
+    grpc::Status GetUsageSummary(
+        grpc::ServerContextBase* context,
+        const GetUsageSummaryRequest* request,
+        GetUsageSummaryResponse* response
+    );
+
+    /// Public (no tenant): authenticated by the Stripe-Signature check instead
+    grpc::Status HandleStripeWebhook(
+        grpc::ServerContextBase* context,
+        const StripeWebhookRequest* request,
+        StripeWebhookResponse* response
+    );
 
 private:
     std::shared_ptr<common::RedisClient> redis_client_;
     std::shared_ptr<common::DbPool> db_pool_;
     std::string stripe_secret_key_;
     std::string stripe_webhook_secret_;
+    std::shared_ptr<common::UsageAggregator> usage_aggregator_;
+    std::shared_ptr<common::IdempotencyStore> idempotency_;
+    std::shared_ptr<PlanCatalog> plan_catalog_;
+    PaymentCaches caches_;   // Before stripe_webhooks_, whose default store invalidates them
+    std::shared_ptr<StripeWebhookIngestor> stripe_webhooks_;
+
+    // (tenant, subscription) pairs verified recently, so metered calls skip the lookup
+    std::mutex ownership_mutex_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> verified_subscriptions_;
+
+    // Handler bodies, wrapped by RunIdempotent
+    grpc::Status ApplyCreateSubscription(
+        grpc::ServerContextBase* context,
+        const CreateSubscriptionRequest* request,
+        SubscriptionResponse* response
+    );
+    grpc::Status ApplyUpdateSubscription(
+        grpc::ServerContextBase* context,
+        const UpdateSubscriptionRequest* request,
+        SubscriptionResponse* response
+    );
+    grpc::Status ApplyCancelSubscription(
+        grpc::ServerContextBase* context,
+        const CancelSubscriptionRequest* request,
+        SubscriptionResponse* response
+    );
+    grpc::Status ApplyAddPaymentMethod(
+        grpc::ServerContextBase* context,
+        const AddPaymentMethodRequest* request,
+        PaymentMethodResponse* response
+    );
+    grpc::Status ApplyRemovePaymentMethod(
+        grpc::ServerContextBase* context,
+        const RemovePaymentMethodRequest* request,
+        RemovePaymentMethodResponse* response
+    );
+    grpc::Status ApplyRecordUsage(
+        grpc::ServerContextBase* context,
+        const RecordUsageRequest* request,
+        RecordUsageResponse* response
+    );
+
+    /// Replay or coalesce by request.idempotency_key(); runs work() directly when it is empty
+    template <typename Request, typename Response, typename Work>
+    grpc::Status RunIdempotent(
+        const char* rpc,
+        grpc::ServerContextBase* context,
+        const Request& request,
+        Response* response,
+        Work&& work
+    );
 
     // Helper methods
     std::string GenerateMockStripeId(const std::string& prefix);
-    double CalculateMRR(const std::string& plan_id, int32_t quantity);
+    bool OwnsSubscription(const std::string& tenant_id, const std::string& subscription_id);
+    std::optional<double> CalculateMRR(const std::string& plan_id, int32_t quantity);   // nullopt: unknown plan
 };
 
 } // namespace payment
@@ -0,0 +1,221 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Plan catalog: immutable pricing snapshots swapped on change
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "common/db_pool.h"
+#include "common/event_bus.h"
+
+namespace saasforge {
+namespace payment {
+
+/**
+ * How a price turns a quantity into an amount
+ *
+ * Values are stored in plan_prices.pricing_model.
+ */
+enum class PricingModel : uint8_t {
+    PER_UNIT = 0,    // quantity * first tier's unit amount (plus its flat amount)
+    GRADUATED = 1,   // Each tier prices the units that fall in it
+    VOLUME = 2,      // The tier the total falls in prices every unit
+};
+
+/**
+ * One tier of a price; amounts are micros (millionths of the currency unit)
+ */
+struct PriceTier {
+    int64_t up_to = 0;                // Last unit of the tier, inclusive; 0 = unbounded (last tier only)
+    int64_t unit_amount_micros = 0;
+    int64_t flat_amount_micros = 0;   // Charged once when any unit falls in the tier
+};
+
+/**
+ * A price as loaded from the catalog source
+ */
+struct PriceDefinition {
+    std::string metric_name;          // Empty: the recurring per-seat price; else a metered usage metric
+    PricingModel model = PricingModel::PER_UNIT;
+    std::vector<PriceTier> tiers;     // Ascending up_to; at least one
+};
+
+/**
+ * A plan as loaded from the catalog source
+ */
+struct PlanDefinition {
+    std::string plan_id;
+    std::vector<PriceDefinition> prices;   // Exactly one recurring price (empty metric_name)
+};
+
+/**
+ * Immutable, indexed pricing for every plan
+ *
+ * Built once per catalog load: prices and tiers are flattened into
+ * contiguous arrays and plans are indexed by an open-addressing table over
+ * plan_id, so Find() and the amount calculations never allocate and never
+ * take a lock. Replaced as a whole, never modified.
+ */
+class PlanCatalogSnapshot {
+public:
+    struct Price {
+        uint32_t first_tier = 0;
+        uint32_t tier_count = 0;
+        PricingModel model = PricingModel::PER_UNIT;
+    };
+
+    struct MeteredPrice {
+        std::string metric_name;
+        Price price;
+    };
+
+    struct Plan {
+        std::string plan_id;
+        Price recurring;
+        uint32_t first_metered = 0;
+        uint32_t metered_count = 0;
+    };
+
+    /**
+     * @throws std::invalid_argument for duplicate plans, a missing or
+     *         duplicate recurring price, or tiers that are empty, not
+     *         ascending, negative, or bounded in the last position
+     */
+    PlanCatalogSnapshot(const std::vector<PlanDefinition>& plans, uint64_t version);
+
+    /// Plan by id, or nullptr
+    const Plan* Find(std::string_view plan_id) const;
+
+    /// Recurring amount per billing period for `quantity` seats
+    int64_t RecurringAmountMicros(const Plan& plan, int64_t quantity) const;
+
+    /// Amount for `units` of a metered metric; 0 if the plan does not meter it
+    int64_t UsageAmountMicros(const Plan& plan, std::string_view metric_name, int64_t units) const;
+
+    size_t Size() const { return plans_.size(); }
+    uint64_t Version() const { return version_; }
+
+    /// Micros to currency units (e.g. for subscriptions.mrr)
+    static double ToCurrency(int64_t micros) { return static_cast<double>(micros) / 1e6; }
+
+private:
+    Price Compile(const PriceDefinition& price, const std::string& plan_id);
+    int64_t Amount(const Price& price, int64_t quantity) const;
+
+    std::vector<Plan> plans_;
+    std::vector<MeteredPrice> metered_;
+    std::vector<PriceTier> tiers_;
+    std::vector<uint32_t> slots_;   // Plan index + 1 (0 = empty); size is a power of two
+    uint64_t version_ = 0;
+};
+
+/**
+ * PlanCatalog options
+ *
+ * FromEnv() reads PLAN_CATALOG_REFRESH_MS.
+ */
+struct PlanCatalogOptions {
+    std::chrono::milliseconds refresh{60000};   // Reload period; CHANGED_TOPIC triggers one at once
+
+    static PlanCatalogOptions FromEnv();
+};
+
+/**
+ * Live plan catalog
+ *
+ * Readers take the current snapshot (a shared_ptr copy) and price against
+ * it; a reload builds a new snapshot off to the side and swaps the pointer,
+ * so readers never wait on a load and an in-flight request keeps the
+ * snapshot it started with. Loads run on a background thread: every
+ * `refresh`, and as soon as an event arrives on CHANGED_TOPIC (published
+ * by whatever writes plan_prices, e.g. the Stripe price sync).
+ *
+ * A failed or invalid load keeps the previous snapshot. If the source has
+ * no plans yet, DefaultPlans() is served.
+ *
+ * Usage:
+ *   PlanCatalog catalog(PlanCatalog::DbLoader(db_pool), event_bus, PlanCatalogOptions::FromEnv());
+ *   auto snapshot = catalog.Current();
+ *   if (const auto* plan = snapshot->Find(plan_id)) {
+ *       int64_t mrr = snapshot->RecurringAmountMicros(*plan, quantity);
+ *   }
+ */
+class PlanCatalog {
+public:
+    /// EventBus topic; any payload
+    static constexpr const char* CHANGED_TOPIC = "payment:plans_changed";
+
+    /// Every plan with its prices (the whole catalog). Throws on failure.
+    using Loader = std::function<std::vector<PlanDefinition>()>;
+
+    /**
+     * @param loader Null: DefaultPlans() only, no reload thread
+     * @param event_bus Null: periodic reloads only
+     */
+    PlanCatalog(Loader loader, std::shared_ptr<common::EventBus> event_bus = nullptr,
+                const PlanCatalogOptions& options = {});
+    ~PlanCatalog();
+
+    PlanCatalog(const PlanCatalog&) = delete;
+    PlanCatalog& operator=(const PlanCatalog&) = delete;
+
+    /// Current snapshot; never null
+    std::shared_ptr<const PlanCatalogSnapshot> Current() const;
+
+    /**
+     * Reload now
+     *
+     * @return False if loading or validation failed (logged); the previous snapshot is kept
+     */
+    bool Refresh();
+
+    /// Loads that failed since start
+    uint64_t Failures() const { return failures_.load(); }
+
+    /// Stop the reload thread (idempotent)
+    void Shutdown();
+
+    /// Reads plan_prices
+    static Loader DbLoader(std::shared_ptr<common::DbPool> db_pool);
+
+    /// starter / professional / enterprise at their launch per-seat prices
+    static std::vector<PlanDefinition> DefaultPlans();
+
+private:
+    void Install(const std::vector<PlanDefinition>& plans);
+    void RefreshLoop();
+
+    Loader load_;
+    std::shared_ptr<common::EventBus> event_bus_;
+    PlanCatalogOptions options_;
+
+    mutable std::mutex snapshot_mutex_;   // Held only to copy or swap the pointer
+    std::shared_ptr<const PlanCatalogSnapshot> snapshot_;
+    uint64_t next_version_ = 1;           // Guarded by refresh_mutex_
+    bool loaded_ = false;                 // Guarded by refresh_mutex_
+
+    std::atomic<uint64_t> failures_{0};
+    uint64_t subscription_ = 0;
+
+    std::mutex refresh_mutex_;            // Serializes loads
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool changed_ = false;
+    bool shutdown_ = false;
+    std::thread thread_;
+};
+
+} // namespace payment
+} // namespace saasforge
@@ -0,0 +1,282 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Stripe webhook ingestion: signature checks, dedup and per-customer ordered processing
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "common/db_pool.h"
+#include "common/stripe_api.h"
+#include "common/webhook_signer.h"
+
+namespace saasforge {
+namespace payment {
+
+/**
+ * The fields of a Stripe event the ingestor acts on
+ */
+struct StripeEvent {
+    std::string id;                  // evt_...
+    std::string type;                // e.g. "customer.subscription.updated"
+    int64_t created = 0;             // Unix seconds (Stripe's clock)
+    std::string customer_id;         // cus_...; empty if the object has none
+    std::string subscription_id;     // sub_...; empty if the event is not about a subscription
+    std::string status;              // Subscription events: the object's status
+    int attempt_count = 0;           // Invoice events: payment attempts so far
+    std::string payload;             // Raw body, as signed
+};
+
+/**
+ * A subscription status to store, from the newest event that set it
+ */
+struct SubscriptionTransition {
+    std::string subscription_id;     // subscriptions.stripe_subscription_id
+    int status = 0;                  // subscriptions.status (payment.proto SubscriptionStatus)
+    int64_t event_at = 0;            // The event's created time
+};
+
+/**
+ * Persistence for received events and the transitions they produce
+ */
+class StripeEventStore {
+public:
+    virtual ~StripeEventStore() = default;
+
+    /**
+     * Store raw events, skipping ids already stored
+     *
+     * Events that change no status (StatusFor() is nullopt) are stored
+     * already processed.
+     *
+     * @return Per event, true if it was new
+     */
+    virtual std::vector<bool> Insert(const std::vector<StripeEvent>& events) = 0;
+
+    /**
+     * In one transaction: apply the transitions (each only if it is not older
+     * than the status already stored) and mark the events processed
+     *
+     * @return Subscriptions updated
+     */
+    virtual size_t Apply(const std::vector<SubscriptionTransition>& transitions,
+                         const std::vector<std::string>& event_ids) = 0;
+
+    /// Stored but unprocessed events, oldest first
+    virtual std::vector<StripeEvent> LoadPending(size_t limit) = 0;
+};
+
+/**
+ * stripe_events and subscriptions in PostgreSQL; one round trip per call
+ */
+class DbStripeEventStore final : public StripeEventStore {
+public:
+    /// Called after Apply() commits with the (tenant_id, id) of each subscription it changed
+    using UpdatedListener = std::function<void(const std::vector<std::pair<std::string, std::string>>& updated)>;
+
+    explicit DbStripeEventStore(std::shared_ptr<common::DbPool> db_pool, UpdatedListener on_updated = nullptr)
+        : db_pool_(std::move(db_pool)), on_updated_(std::move(on_updated)) {}
+
+    std::vector<bool> Insert(const std::vector<StripeEvent>& events) override;
+    size_t Apply(const std::vector<SubscriptionTransition>& transitions,
+                 const std::vector<std::string>& event_ids) override;
+    std::vector<StripeEvent> LoadPending(size_t limit) override;
+
+private:
+    std::shared_ptr<common::DbPool> db_pool_;
+    UpdatedListener on_updated_;
+};
+
+/**
+ * StripeWebhookIngestor options
+ *
+ * FromEnv() reads STRIPE_WEBHOOK_TOLERANCE_SECONDS, STRIPE_WEBHOOK_WORKERS,
+ * STRIPE_WEBHOOK_BATCH_SIZE, STRIPE_WEBHOOK_QUEUE_LIMIT and
+ * STRIPE_WEBHOOK_RECOVER_LIMIT.
+ */
+struct StripeWebhookOptions {
+    std::chrono::seconds tolerance{300};   // Max age of the signature timestamp (replay window)
+    size_t workers = 0;                    // Partitions; 0 = hardware threads
+    size_t batch_size = 500;               // Events per insert and per applied batch
+    size_t queue_limit = 100000;           // Unprocessed events held in memory before Ingest() sheds load
+    size_t recover_limit = 100000;         // Unprocessed events reloaded at start
+
+    static StripeWebhookOptions FromEnv();
+};
+
+struct StripeWebhookStats {
+    uint64_t received = 0;
+    uint64_t rejected = 0;           // Bad signature or payload
+    uint64_t duplicates = 0;         // Event id already stored
+    uint64_t processed = 0;          // Events whose batch was applied
+    uint64_t transitions = 0;        // Subscription status changes written
+    uint64_t insert_batches = 0;
+    uint64_t apply_batches = 0;
+    uint64_t failed_batches = 0;     // Insert or apply attempts that threw
+    size_t queued = 0;               // Stored, waiting for a partition worker
+};
+
+/**
+ * Outcome of one delivery
+ */
+enum class WebhookResult {
+    ACCEPTED,            // Stored; processed asynchronously
+    DUPLICATE,           // Already stored (Stripe retried a delivery we had)
+    INVALID_SIGNATURE,
+    INVALID_PAYLOAD,
+    UNAVAILABLE,         // Not stored (database error, overload or shutdown); Stripe retries
+};
+
+/**
+ * Verifies, stores and processes Stripe webhook deliveries
+ *
+ * Ingest() checks the Stripe-Signature header (HMAC-SHA256 of
+ * "<t>.<payload>" under the endpoint secret, with a `tolerance` replay
+ * window), parses the event, and hands it to a writer thread that inserts
+ * the deliveries of every concurrent caller in one statement, deduplicated
+ * on event id. Ingest() returns once its event is committed, so Stripe
+ * only sees 2xx for events that will be processed.
+ *
+ * New events are queued on one of `workers` partitions by customer id, so
+ * every event of a customer (and so of each of its subscriptions) is
+ * processed by one thread in arrival order, while different customers
+ * proceed in parallel. A worker drains up to batch_size events, reduces
+ * them to the newest status per subscription (ReduceTransitions) and
+ * writes them with one UPDATE, marking the events processed in the same
+ * transaction. Each row also records the event time of its status, and
+ * older events never overwrite newer ones: Stripe does not guarantee
+ * delivery order, and several payment instances may share the work.
+ *
+ * A failed apply is retried with backoff, keeping the partition's order.
+ * Events stored but unprocessed when the process stopped are reloaded at
+ * start.
+ *
+ * Usage:
+ *   auto ingestor = std::make_shared<StripeWebhookIngestor>(
+ *       std::make_shared<DbStripeEventStore>(db_pool), webhook_secret, StripeWebhookOptions::FromEnv());
+ *   auto result = ingestor->Ingest(body, stripe_signature_header);
+ */
+class StripeWebhookIngestor {
+public:
+    /// @throws std::invalid_argument if webhook_secret is empty (anyone could sign events)
+    StripeWebhookIngestor(std::shared_ptr<StripeEventStore> store, const std::string& webhook_secret,
+                          const StripeWebhookOptions& options = {});
+    ~StripeWebhookIngestor();
+
+    StripeWebhookIngestor(const StripeWebhookIngestor&) = delete;
+    StripeWebhookIngestor& operator=(const StripeWebhookIngestor&) = delete;
+
+    /**
+     * Verify and store one delivery (blocks until stored)
+     *
+     * @param payload Raw request body, byte for byte as received
+     * @param signature Stripe-Signature header
+     */
+    WebhookResult Ingest(const std::string& payload, const std::string& signature);
+
+    /// Same, with the current time injected (tests)
+    WebhookResult Ingest(const std::string& payload, const std::string& signature, int64_t now);
+
+    /// Block until every queued event has been applied (tests, shutdown)
+    void Drain();
+
+    /// Stop accepting deliveries, finish queued batches and join the threads (idempotent)
+    void Shutdown();
+
+    StripeWebhookStats GetStats() const;
+
+    /// Partition for a customer (stable for a given worker count)
+    size_t PartitionOf(const StripeEvent& event) const;
+
+    /**
+     * Check a Stripe-Signature header ("t=<unix>,v1=<hex>[,v1=...]")
+     *
+     * Any v1 signature may match (Stripe sends several while a secret is rolled).
+     */
+    static bool VerifySignature(const common::WebhookSigningKey& key, std::string_view payload,
+                                std::string_view header, int64_t now, std::chrono::seconds tolerance);
+
+    /// Header for a payload (tests and local tooling)
+    static std::string SignatureHeader(const common::WebhookSigningKey& key, std::string_view payload,
+                                       int64_t timestamp);
+
+    /// @return nullopt if the payload is not a Stripe event
+    static std::optional<StripeEvent> ParseEvent(const std::string& payload);
+
+    /**
+     * Status an event sets, with the rules of MockStripeClient::TransitionSubscriptionState
+     *
+     * nullopt for events that do not change a subscription's status.
+     */
+    static std::optional<common::SubscriptionStatus> StatusFor(const StripeEvent& event);
+
+    /// subscriptions.status for a Stripe status; nullopt for PAUSED, which it does not model
+    static std::optional<int> ToStoredStatus(common::SubscriptionStatus status);
+
+    /**
+     * Newest status per subscription in a batch, in first-seen order
+     *
+     * Events are ordered by created time; ties keep arrival order.
+     */
+    static std::vector<SubscriptionTransition> ReduceTransitions(const std::vector<StripeEvent>& events);
+
+private:
+    struct PendingInsert {
+        StripeEvent event;
+        std::promise<bool> stored;   // true: new, false: duplicate; exception: not stored
+    };
+
+    struct Partition {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<StripeEvent> queue;
+        bool busy = false;           // A batch is being applied
+        std::thread thread;
+    };
+
+    void WriterLoop();
+    void WorkerLoop(Partition& partition);
+    void Dispatch(StripeEvent event);
+    void Recover();
+
+    std::shared_ptr<StripeEventStore> store_;
+    common::WebhookSigningKey key_;
+    StripeWebhookOptions options_;
+
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+    std::vector<std::shared_ptr<PendingInsert>> inserts_;
+    bool shutdown_ = false;
+    std::thread writer_;
+
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> queued_{0};
+
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> duplicates_{0};
+    std::atomic<uint64_t> processed_{0};
+    std::atomic<uint64_t> transitions_{0};
+    std::atomic<uint64_t> insert_batches_{0};
+    std::atomic<uint64_t> apply_batches_{0};
+    std::atomic<uint64_t> failed_batches_{0};
+};
+
+} // namespace payment
+} // namespace saasforge
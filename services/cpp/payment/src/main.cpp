@@ -3,9 +3,23 @@
 #include <string>
 #include <grpcpp/grpcpp.h>
 #include "payment/payment_service.h"
+#include "payment/payment_grpc_service.h"
+#include "payment/plan_catalog.h"
+#include "payment/stripe_webhooks.h"
+#include "common/server_options.h"
 #include "common/mtls_credentials.h"
 #include "common/redis_client.h"
+#include "common/event_bus.h"
 #include "common/db_pool.h"
+#include "common/allocator_stats.h"
+#include "common/metrics_server.h"
+#include "common/server_interceptors.h"
+#include "common/warmup.h"
+#include "common/graceful_shutdown.h"
+#include "common/logger.h"
+#include "common/tracing.h"
+#include "common/idempotency_store.h"
+#include "common/usage_aggregator.h"
 
 using grpc::Server;
 using grpc::ServerBuilder;
@@ -22,14 +36,47 @@ void RunServer() {
     std::string redis_url = redis_url_env ? redis_url_env : "tcp://127.0.0.1:6379";
     std::string db_url = db_url_env ? db_url_env : "postgresql://localhost/saasforge";
     std::string stripe_secret_key = stripe_secret_key_env ? stripe_secret_key_env : "sk_test_mock";
-    std::string stripe_webhook_secret = stripe_webhook_secret_env ? stripe_webhook_secret_env : "whsec_mock";
+    std::string stripe_webhook_secret = stripe_webhook_secret_env ? stripe_webhook_secret_env : "";
+    // HandleStripeWebhook is public (no tenant or user): the signature is its only authentication
+    if (stripe_webhook_secret.empty()) {
+        throw std::runtime_error("STRIPE_WEBHOOK_SECRET is required");
+    }
 
     // Initialize Redis and DB
-    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url);
-    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, 10);
+    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url, saasforge::common::RedisOptions::FromEnv());
+    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, saasforge::common::DbPoolOptions::FromEnv());
+
+    // Write-behind usage buffer (USAGE_FLUSH_INTERVAL_MS, USAGE_WAL_DIR, ...)
+    auto usage_aggregator = std::make_shared<saasforge::common::UsageAggregator>(
+        db_pool, saasforge::common::UsageAggregatorOptions::FromEnv());
+
+    auto idempotency = std::make_shared<saasforge::common::IdempotencyStore>(
+        redis_client, saasforge::common::IdempotencyOptions::FromEnv());
+
+    // Events between services on Redis Streams (EVENT_BUS_*)
+    auto event_bus = std::make_shared<saasforge::common::EventBus>(
+        redis_client, saasforge::common::EventBusOptions::FromEnv());
+
+    // Plan prices (plan_prices), reloaded every PLAN_CATALOG_REFRESH_MS and on change
+    auto plan_catalog = std::make_shared<saasforge::payment::PlanCatalog>(
+        saasforge::payment::PlanCatalog::DbLoader(db_pool), event_bus,
+        saasforge::payment::PlanCatalogOptions::FromEnv());
 
-    saasforge::payment::PaymentServiceImpl service(redis_client, db_pool, stripe_secret_key, stripe_webhook_secret);
+    // Subscription and invoice reads: local LRU over Redis, invalidated on the event bus (ENTITY_CACHE_*)
+    auto caches = saasforge::payment::PaymentCaches::Create(
+        redis_client, event_bus, saasforge::common::EntityCacheOptions::FromEnv());
 
+    // Stripe webhooks: stored deduplicated, applied per customer in order (STRIPE_WEBHOOK_*)
+    auto stripe_webhooks = std::make_shared<saasforge::payment::StripeWebhookIngestor>(
+        std::make_shared<saasforge::payment::DbStripeEventStore>(db_pool, caches.SubscriptionsUpdated()),
+        stripe_webhook_secret, saasforge::payment::StripeWebhookOptions::FromEnv());
+
+    auto service = std::make_shared<saasforge::payment::PaymentServiceImpl>(
+        redis_client, db_pool, stripe_secret_key, stripe_webhook_secret, usage_aggregator, idempotency,
+        plan_catalog, stripe_webhooks, caches);
+
+    // grpc.health.v1.Health: NOT_SERVING until warm-up completes (below)
+    grpc::EnableDefaultHealthCheckService(true);
     ServerBuilder builder;
 
     // Setup mTLS
@@ -53,15 +100,81 @@ void RunServer() {
         builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     }
 
-    builder.RegisterService(&service);
+    // Threading model: sync, or callback API with a bounded executor (GRPC_SERVER_MODE)
+    auto server_options = saasforge::common::ServerOptions::FromEnv();
+    server_options.ApplyTo(builder);
+
+    // Tracing (traceparent in, OTLP out), per-method metrics, and the tenant context
+    // parsed once per RPC; calls outside PublicMethods() need a tenant or user
+    saasforge::common::TenantContextOptions tenant_options;
+    tenant_options.public_methods = saasforge::payment::PublicMethods();
+    saasforge::common::AddServerInterceptors(builder, std::move(tenant_options));
+
+    std::shared_ptr<saasforge::common::Executor> executor;
+    auto grpc_service = saasforge::common::MakeService<
+        saasforge::payment::PaymentServiceSync,
+        saasforge::payment::PaymentServiceCallback
+    >(server_options, service, executor);
+    builder.RegisterService(grpc_service.get());
+    std::cout << "Server mode: " << server_options.Describe() << std::endl;
 
     std::unique_ptr<Server> server(builder.BuildAndStart());
     std::cout << "Payment Service listening on " << server_address << std::endl;
 
-    server->Wait();
+    // Prometheus scrape endpoint (METRICS_PORT, 0 = disabled)
+    auto metrics_options = saasforge::common::MetricsServerOptions::FromEnv();
+    std::unique_ptr<saasforge::common::MetricsServer> metrics_server;
+    if (metrics_options.port != 0) {
+        saasforge::common::ExportAllocatorMetrics(saasforge::common::MetricsRegistry::Global());
+        metrics_server = std::make_unique<saasforge::common::MetricsServer>(
+            saasforge::common::MetricsRegistry::Global(), metrics_options);
+        std::cout << "Metrics available on :" << metrics_server->Port() << "/metrics" << std::endl;
+        if (!metrics_options.profiling.token.empty()) {
+            auto& profiler = saasforge::common::Profiler::Default();
+            std::cout << "Profiling available on :" << metrics_server->Port() << "/debug/pprof/ (cpu: "
+                      << (profiler.CpuAvailable() ? profiler.CpuBackend() : "none") << ", heap: "
+                      << (profiler.HeapAvailable() ? profiler.HeapBackend() : "none") << ")" << std::endl;
+        }
+    }
+
+    // SIGTERM (rolling deploy): drain in-flight RPCs, then flush and close in dependency order
+    saasforge::common::GracefulShutdown shutdown(saasforge::common::ShutdownOptions::FromEnv());
+    shutdown.Add("executor", [&executor] {
+        if (executor) {
+            executor->Shutdown();
+        }
+    });
+    shutdown.Add("usage", [&usage_aggregator] { usage_aggregator->Shutdown(); });
+    shutdown.Add("stripe_webhooks", [&stripe_webhooks] { stripe_webhooks->Shutdown(); });
+    shutdown.Add("plan_catalog", [&plan_catalog] { plan_catalog->Shutdown(); });
+    shutdown.Add("event_bus", [&event_bus] { event_bus->Shutdown(); });
+    shutdown.Add("database", [&db_pool, &shutdown] { db_pool->Shutdown(shutdown.Options().close_timeout); });
+    shutdown.Add("metrics", [&metrics_server] {
+        if (metrics_server) {
+            metrics_server->Shutdown();
+        }
+    });
+    shutdown.Add("tracing", [] { saasforge::common::Tracer::Global().Shutdown(); });
+
+    // Connections open and caches primed before readiness probes see SERVING
+    saasforge::common::Warmup warmup(saasforge::common::WarmupOptions::FromEnv());
+    warmup.Add("database", saasforge::common::Warmup::PingDatabase(db_pool), true);
+    warmup.Add("redis", saasforge::common::Warmup::ConnectRedis(redis_client), true);
+    if (!warmup.Run(server->GetHealthCheckService())) {
+        throw std::runtime_error("Warm-up failed");
+    }
+
+    shutdown.Wait();
+    shutdown.Run(server.get(), server->GetHealthCheckService());
+    saasforge::common::Logger::Global().Flush();
 }
 
 int main(int argc, char** argv) {
-    RunServer();
+    try {
+        RunServer();
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -1,33 +1,274 @@
 #include "payment/payment_service.h"
 #include "common/tenant_context.h"
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include "common/statement_registry.h"
+#include "common/id_generator.h"
+#include "common/logger.h"
+#include "common/outbox.h"
 #include <chrono>
-#include <random>
 
 namespace saasforge {
 namespace payment {
 
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const common::PreparedStatement kCreateSubscription(
+    "payment_create_subscription",
+    "INSERT INTO subscriptions (tenant_id, stripe_subscription_id, plan_id, status, "
+    "current_period_start, current_period_end, quantity, mrr, payment_method_id) "
+    "VALUES ($1, $2, $3, $4, to_timestamp($5), to_timestamp($6), $7, $8, $9) "
+    "RETURNING id");
+
+const common::PreparedStatement kUpdatePlanQuantity(
+    "payment_update_plan_quantity",
+    "UPDATE subscriptions SET "
+    "plan_id = $1, quantity = $2, mrr = $3, updated_at = NOW() "
+    "WHERE id = $4 AND tenant_id = $5 "
+    "RETURNING id, tenant_id, plan_id, status, "
+    "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
+    "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
+    "quantity, mrr");
+
+// No row lock: the conditional updates below detect a concurrent change instead
+const common::PreparedStatement kSelectPlan(
+    "payment_select_plan",
+    "SELECT plan_id, quantity FROM subscriptions WHERE id = $1 AND tenant_id = $2");
+
+// Plan change priced with the quantity read; no row if the quantity changed meanwhile
+const common::PreparedStatement kUpdatePlan(
+    "payment_update_plan",
+    "UPDATE subscriptions SET "
+    "plan_id = $1, mrr = $2, updated_at = NOW() "
+    "WHERE id = $3 AND tenant_id = $4 AND quantity = $5 "
+    "RETURNING id, tenant_id, plan_id, status, "
+    "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
+    "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
+    "quantity, mrr");
+
+// Quantity change priced with the plan read; no row if the plan changed meanwhile
+const common::PreparedStatement kUpdateQuantity(
+    "payment_update_quantity",
+    "UPDATE subscriptions SET "
+    "quantity = $1, mrr = $2, updated_at = NOW() "
+    "WHERE id = $3 AND tenant_id = $4 AND plan_id = $5 "
+    "RETURNING id, tenant_id, plan_id, status, "
+    "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
+    "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
+    "quantity, mrr");
+
+const common::PreparedStatement kCancelNow(
+    "payment_cancel_now",
+    "UPDATE subscriptions SET "
+    "status = $1, cancel_at = NOW(), canceled_at = NOW(), updated_at = NOW() "
+    "WHERE id = $2 AND tenant_id = $3 "
+    "RETURNING id, tenant_id, plan_id, status, "
+    "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
+    "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
+    "EXTRACT(EPOCH FROM cancel_at)::bigint as cancel_at, "
+    "quantity, mrr");
+
+const common::PreparedStatement kCancelAtPeriodEnd(
+    "payment_cancel_at_period_end",
+    "UPDATE subscriptions SET "
+    "cancel_at = current_period_end, updated_at = NOW() "
+    "WHERE id = $1 AND tenant_id = $2 "
+    "RETURNING id, tenant_id, plan_id, status, "
+    "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
+    "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
+    "EXTRACT(EPOCH FROM cancel_at)::bigint as cancel_at, "
+    "quantity, mrr");
+
+const common::PreparedStatement kSelectSubscription(
+    "payment_select_subscription",
+    "SELECT id, tenant_id, plan_id, status, "
+    "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
+    "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
+    "EXTRACT(EPOCH FROM cancel_at)::bigint as cancel_at, "
+    "quantity, mrr "
+    "FROM subscriptions WHERE id = $1 AND tenant_id = $2");
+
+const common::PreparedStatement kInsertPaymentMethod(
+    "payment_insert_payment_method",
+    "INSERT INTO payment_methods (tenant_id, stripe_payment_method_id, type, last4, brand, exp_month, exp_year) "
+    "VALUES ($1, $2, $3, $4, $5, $6, $7) "
+    "RETURNING id");
+
+const common::PreparedStatement kDeletePaymentMethod(
+    "payment_delete_payment_method",
+    "UPDATE payment_methods SET deleted_at = NOW() "
+    "WHERE id = $1 AND tenant_id = $2 AND deleted_at IS NULL");
+
+const common::PreparedStatement kSelectInvoice(
+    "payment_select_invoice",
+    "SELECT id, tenant_id, subscription_id, amount_due, amount_paid, status, "
+    "EXTRACT(EPOCH FROM due_date)::bigint as due_date, "
+    "EXTRACT(EPOCH FROM paid_at)::bigint as paid_at, "
+    "pdf_url "
+    "FROM invoices WHERE id = $1 AND tenant_id = $2");
+
+const common::PreparedStatement kCheckSubscription(
+    "payment_check_subscription",
+    "SELECT id FROM subscriptions WHERE id = $1 AND tenant_id = $2");
+
+// Usage summaries read only the rollups maintained by UsageAggregator; the
+// tenant and bucket_start predicates prune to one hash sub-partition per month
+const common::PreparedStatement kSelectUsageByMinute(
+    "payment_select_usage_by_minute",
+    "SELECT metric_name, "
+    "EXTRACT(EPOCH FROM bucket_start)::bigint as bucket_start, "
+    "EXTRACT(EPOCH FROM bucket_start + INTERVAL '1 minute')::bigint as bucket_end, "
+    "quantity "
+    "FROM usage_rollup_minute "
+    "WHERE tenant_id = $1 AND subscription_id = $2 AND ($3 = '' OR metric_name = $3) "
+    "AND bucket_start >= to_timestamp($4) AND bucket_start < to_timestamp($5) "
+    "ORDER BY bucket_start, metric_name LIMIT $6");
+
+const common::PreparedStatement kSelectUsageByHour(
+    "payment_select_usage_by_hour",
+    "SELECT metric_name, "
+    "EXTRACT(EPOCH FROM bucket_start)::bigint as bucket_start, "
+    "EXTRACT(EPOCH FROM bucket_start + INTERVAL '1 hour')::bigint as bucket_end, "
+    "quantity "
+    "FROM usage_rollup_hour "
+    "WHERE tenant_id = $1 AND subscription_id = $2 AND ($3 = '' OR metric_name = $3) "
+    "AND bucket_start >= to_timestamp($4) AND bucket_start < to_timestamp($5) "
+    "ORDER BY bucket_start, metric_name LIMIT $6");
+
+// Periods overlapping the range; they last a month, so the lower bound on
+// bucket_start only serves partition pruning
+const common::PreparedStatement kSelectUsageByPeriod(
+    "payment_select_usage_by_period",
+    "SELECT metric_name, "
+    "EXTRACT(EPOCH FROM bucket_start)::bigint as bucket_start, "
+    "EXTRACT(EPOCH FROM period_end)::bigint as bucket_end, "
+    "quantity "
+    "FROM usage_rollup_period "
+    "WHERE tenant_id = $1 AND subscription_id = $2 AND ($3 = '' OR metric_name = $3) "
+    "AND period_end > to_timestamp($4) "
+    "AND bucket_start >= to_timestamp($4) - INTERVAL '1 month' AND bucket_start < to_timestamp($5) "
+    "ORDER BY bucket_start, metric_name LIMIT $6");
+
+constexpr int64_t MAX_USAGE_SUMMARY_BUCKETS = 10000;
+
+// Conditional subscription updates retried this often when a concurrent change wins
+constexpr int MAX_SUBSCRIPTION_UPDATE_ATTEMPTS = 5;
+
+// Ownership results are cached this long; UsageAggregator re-checks at write time
+constexpr auto OWNERSHIP_CACHE_TTL = std::chrono::minutes(5);
+constexpr size_t MAX_OWNERSHIP_CACHE_ENTRIES = 100000;
+
+// Caches of a service built without them, on its own event bus
+PaymentCaches DefaultCaches(std::shared_ptr<common::RedisClient> redis_client) {
+    auto event_bus = redis_client
+        ? std::make_shared<common::EventBus>(redis_client, common::EventBusOptions::FromEnv())
+        : nullptr;
+    return PaymentCaches::Create(redis_client, event_bus, common::EntityCacheOptions::FromEnv());
+}
+
+} // namespace
+
 PaymentServiceImpl::PaymentServiceImpl(
     std::shared_ptr<common::RedisClient> redis_client,
     std::shared_ptr<common::DbPool> db_pool,
     const std::string& stripe_secret_key,
-    const std::string& stripe_webhook_secret
+    const std::string& stripe_webhook_secret,
+    std::shared_ptr<common::UsageAggregator> usage_aggregator,
+    std::shared_ptr<common::IdempotencyStore> idempotency,
+    std::shared_ptr<PlanCatalog> plan_catalog,
+    std::shared_ptr<StripeWebhookIngestor> stripe_webhooks,
+    PaymentCaches caches
 ) : redis_client_(redis_client),
     db_pool_(db_pool),
     stripe_secret_key_(stripe_secret_key),
-    stripe_webhook_secret_(stripe_webhook_secret) {
-    std::cout << "PaymentService initialized" << std::endl;
+    stripe_webhook_secret_(stripe_webhook_secret),
+    usage_aggregator_(usage_aggregator ? usage_aggregator : std::make_shared<common::UsageAggregator>(db_pool)),
+    idempotency_(idempotency ? idempotency : std::make_shared<common::IdempotencyStore>(redis_client)),
+    plan_catalog_(plan_catalog ? plan_catalog
+                               : std::make_shared<PlanCatalog>(
+                                     PlanCatalog::DbLoader(db_pool),
+                                     redis_client ? std::make_shared<common::EventBus>(
+                                                        redis_client, common::EventBusOptions::FromEnv())
+                                                  : nullptr)),
+    caches_(caches.subscriptions && caches.invoices ? std::move(caches) : DefaultCaches(redis_client)),
+    stripe_webhooks_(stripe_webhooks ? stripe_webhooks
+                                     : std::make_shared<StripeWebhookIngestor>(
+                                           std::make_shared<DbStripeEventStore>(db_pool, caches_.SubscriptionsUpdated()),
+                                           stripe_webhook_secret)) {
+    common::LogInfo("PaymentService initialized");
+}
+
+template <typename Request, typename Response, typename Work>
+grpc::Status PaymentServiceImpl::RunIdempotent(
+    const char* rpc,
+    grpc::ServerContextBase* context,
+    const Request& request,
+    Response* response,
+    Work&& work
+) {
+    if (request.idempotency_key().empty()) {
+        return work();
+    }
+
+    auto tenant = common::TenantContextInterceptor::ForCall(context);
+
+    const common::TenantContext& tenant_ctx = *tenant;
+    if (tenant_ctx.tenant_id.empty()) {
+        return work();  // Rejected as unauthenticated by the handler
+    }
+
+    try {
+        grpc::Status status;
+        auto outcome = idempotency_->Execute(
+            std::string(rpc) + ":" + tenant_ctx.tenant_id + ":" + request.idempotency_key(),
+            common::IdempotencyStore::Fingerprint(request.SerializeAsString()),
+            [&]() -> std::optional<std::string> {
+                status = work();
+                if (!status.ok()) {
+                    return std::nullopt;
+                }
+                return response->SerializeAsString();
+            });
+
+        switch (outcome.kind) {
+            case common::IdempotencyOutcome::Kind::EXECUTED:
+                return status;
+            case common::IdempotencyOutcome::Kind::REPLAYED:
+                response->Clear();
+                if (!response->ParseFromString(outcome.body)) {
+                    return grpc::Status(grpc::StatusCode::INTERNAL, "Stored idempotent response is corrupt");
+                }
+                return grpc::Status::OK;
+            case common::IdempotencyOutcome::Kind::CONFLICT:
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                    "Idempotency key was already used with different parameters");
+            case common::IdempotencyOutcome::Kind::IN_PROGRESS:
+                break;
+        }
+        return grpc::Status(grpc::StatusCode::ABORTED, "A request with this idempotency key is in progress, retry later");
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Idempotency check failed: ") + e.what());
+    }
 }
 
 grpc::Status PaymentServiceImpl::CreateSubscription(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
+    const CreateSubscriptionRequest* request,
+    SubscriptionResponse* response
+) {
+    return RunIdempotent("create_subscription", context, *request, response, [&] {
+        return ApplyCreateSubscription(context, request, response);
+    });
+}
+
+grpc::Status PaymentServiceImpl::ApplyCreateSubscription(
+    grpc::ServerContextBase* context,
     const CreateSubscriptionRequest* request,
     SubscriptionResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
@@ -38,16 +279,6 @@ grpc::Status PaymentServiceImpl::CreateSubscription(
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Tenant ID mismatch");
         }
 
-        // Check idempotency
-        if (!request->idempotency_key().empty()) {
-            std::string cache_key = "idempotency:" + tenant_ctx.tenant_id + ":" + request->idempotency_key();
-            auto cached = redis_client_->GetSession(cache_key);
-            if (cached) {
-                // Return cached response (in production, deserialize from JSON)
-                return grpc::Status(grpc::StatusCode::ALREADY_EXISTS, "Subscription already created with this idempotency key");
-            }
-        }
-
         // Generate mock Stripe subscription ID
         std::string stripe_subscription_id = GenerateMockStripeId("sub");
 
@@ -65,17 +296,17 @@ grpc::Status PaymentServiceImpl::CreateSubscription(
         }
 
         // Calculate MRR
-        double mrr = CalculateMRR(request->plan_id(), request->quantity());
+        auto mrr = CalculateMRR(request->plan_id(), request->quantity());
+        if (!mrr) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Unknown plan: " + request->plan_id());
+        }
 
         // Store in database
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "INSERT INTO subscriptions (tenant_id, stripe_subscription_id, plan_id, status, "
-            "current_period_start, current_period_end, quantity, mrr, payment_method_id) "
-            "VALUES ($1, $2, $3, $4, to_timestamp($5), to_timestamp($6), $7, $8, $9) "
-            "RETURNING id",
+        auto result = common::ExecPrepared(
+            txn, kCreateSubscription,
             tenant_ctx.tenant_id,
             stripe_subscription_id,
             request->plan_id(),
@@ -83,7 +314,7 @@ grpc::Status PaymentServiceImpl::CreateSubscription(
             period_start,
             period_end,
             request->quantity(),
-            mrr,
+            *mrr,
             request->payment_method_id()
         );
 
@@ -97,15 +328,12 @@ grpc::Status PaymentServiceImpl::CreateSubscription(
         response->set_current_period_start(period_start);
         response->set_current_period_end(period_end);
         response->set_quantity(request->quantity());
-        response->set_mrr(mrr);
+        response->set_mrr(*mrr);
 
+        // Webhooks fan out from the outbox once this commits
+        common::Outbox::Append(txn, tenant_ctx.tenant_id, "subscription.created", *response);
         txn.commit();
-
-        // Store idempotency key if provided
-        if (!request->idempotency_key().empty()) {
-            std::string cache_key = "idempotency:" + tenant_ctx.tenant_id + ":" + request->idempotency_key();
-            redis_client_->SetSession(cache_key, subscription_id, 86400); // 24 hours
-        }
+        db_pool_->RecordWrite(tenant_ctx.tenant_id);
 
         return grpc::Status::OK;
 
@@ -115,96 +343,104 @@ grpc::Status PaymentServiceImpl::CreateSubscription(
 }
 
 grpc::Status PaymentServiceImpl::UpdateSubscription(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
+    const UpdateSubscriptionRequest* request,
+    SubscriptionResponse* response
+) {
+    return RunIdempotent("update_subscription", context, *request, response, [&] {
+        return ApplyUpdateSubscription(context, request, response);
+    });
+}
+
+grpc::Status PaymentServiceImpl::ApplyUpdateSubscription(
+    grpc::ServerContextBase* context,
     const UpdateSubscriptionRequest* request,
     SubscriptionResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        if (!request->has_plan_id() && !request->has_quantity()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "No fields to update");
+        }
+
+        // Each statement commits on its own, so the row is locked only while one
+        // UPDATE runs rather than across round trips; busy subscriptions do not
+        // queue behind each other's transactions
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::nontransaction txn(*conn_guard);
 
         // SECURITY FIX: Use parameterized queries instead of dynamic query building
-        // Refactored to use exec_params() with proper parameter binding
+        // Each update shape is a separate prepared statement with bound parameters
 
         pqxx::result result;
 
         // Case 1: Update both plan_id and quantity
         if (request->has_plan_id() && request->has_quantity()) {
-            // Get current plan_id to calculate MRR
-            std::string plan_id = request->plan_id();
-            int quantity = request->quantity();
-            double new_mrr = CalculateMRR(plan_id, quantity);
-
-            result = txn.exec_params(
-                "UPDATE subscriptions SET "
-                "plan_id = $1, quantity = $2, mrr = $3, updated_at = NOW() "
-                "WHERE id = $4 AND tenant_id = $5 "
-                "RETURNING id, tenant_id, plan_id, status, "
-                "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
-                "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
-                "quantity, mrr",
-                plan_id,
-                quantity,
-                new_mrr,
-                request->subscription_id(),
-                tenant_ctx.tenant_id
-            );
-        }
-        // Case 2: Update only plan_id
-        else if (request->has_plan_id()) {
-            result = txn.exec_params(
-                "UPDATE subscriptions SET "
-                "plan_id = $1, updated_at = NOW() "
-                "WHERE id = $2 AND tenant_id = $3 "
-                "RETURNING id, tenant_id, plan_id, status, "
-                "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
-                "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
-                "quantity, mrr",
-                request->plan_id(),
-                request->subscription_id(),
-                tenant_ctx.tenant_id
-            );
-        }
-        // Case 3: Update only quantity (recalculate MRR with existing plan_id)
-        else if (request->has_quantity()) {
-            // First, get current plan_id
-            auto plan_result = txn.exec_params(
-                "SELECT plan_id FROM subscriptions WHERE id = $1 AND tenant_id = $2",
-                request->subscription_id(),
-                tenant_ctx.tenant_id
-            );
-
-            if (plan_result.empty()) {
-                return grpc::Status(grpc::StatusCode::NOT_FOUND, "Subscription not found");
+            auto new_mrr = CalculateMRR(request->plan_id(), request->quantity());
+            if (!new_mrr) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Unknown plan: " + request->plan_id());
             }
 
-            std::string plan_id = plan_result[0]["plan_id"].as<std::string>();
-            int quantity = request->quantity();
-            double new_mrr = CalculateMRR(plan_id, quantity);
-
-            result = txn.exec_params(
-                "UPDATE subscriptions SET "
-                "quantity = $1, mrr = $2, updated_at = NOW() "
-                "WHERE id = $3 AND tenant_id = $4 "
-                "RETURNING id, tenant_id, plan_id, status, "
-                "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
-                "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
-                "quantity, mrr",
-                quantity,
-                new_mrr,
+            result = common::ExecPrepared(
+                txn, kUpdatePlanQuantity,
+                request->plan_id(),
+                request->quantity(),
+                *new_mrr,
                 request->subscription_id(),
                 tenant_ctx.tenant_id
             );
         }
-        // Case 4: No fields to update
+        // Cases 2 and 3: Update plan_id or quantity (recalculate MRR with the other, current value).
+        // The update applies only if that value is unchanged; otherwise re-read and re-price
         else {
-            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "No fields to update");
+            for (int attempt = 0; attempt < MAX_SUBSCRIPTION_UPDATE_ATTEMPTS && result.empty(); ++attempt) {
+                auto current = common::ExecPrepared(
+                    txn, kSelectPlan,
+                    request->subscription_id(),
+                    tenant_ctx.tenant_id
+                );
+
+                if (current.empty()) {
+                    return grpc::Status(grpc::StatusCode::NOT_FOUND, "Subscription not found");
+                }
+
+                std::string plan_id = request->has_plan_id()
+                    ? request->plan_id() : current[0]["plan_id"].as<std::string>();
+                int quantity = request->has_quantity() ? request->quantity() : current[0]["quantity"].as<int>();
+                auto new_mrr = CalculateMRR(plan_id, quantity);
+                if (!new_mrr) {
+                    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Unknown plan: " + plan_id);
+                }
+
+                if (request->has_plan_id()) {
+                    result = common::ExecPrepared(
+                        txn, kUpdatePlan,
+                        plan_id,
+                        *new_mrr,
+                        request->subscription_id(),
+                        tenant_ctx.tenant_id,
+                        quantity
+                    );
+                } else {
+                    result = common::ExecPrepared(
+                        txn, kUpdateQuantity,
+                        quantity,
+                        *new_mrr,
+                        request->subscription_id(),
+                        tenant_ctx.tenant_id,
+                        plan_id
+                    );
+                }
+            }
+            if (result.empty()) {
+                return grpc::Status(grpc::StatusCode::ABORTED, "Subscription is being changed concurrently, retry");
+            }
         }
 
         if (result.empty()) {
@@ -221,7 +457,8 @@ grpc::Status PaymentServiceImpl::UpdateSubscription(
         response->set_quantity(row["quantity"].as<int>());
         response->set_mrr(row["mrr"].as<double>());
 
-        txn.commit();
+        db_pool_->RecordWrite(tenant_ctx.tenant_id);
+        caches_.subscriptions->Invalidate({tenant_ctx.tenant_id, request->subscription_id()});
 
         return grpc::Status::OK;
 
@@ -231,18 +468,29 @@ grpc::Status PaymentServiceImpl::UpdateSubscription(
 }
 
 grpc::Status PaymentServiceImpl::CancelSubscription(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
+    const CancelSubscriptionRequest* request,
+    SubscriptionResponse* response
+) {
+    return RunIdempotent("cancel_subscription", context, *request, response, [&] {
+        return ApplyCancelSubscription(context, request, response);
+    });
+}
+
+grpc::Status PaymentServiceImpl::ApplyCancelSubscription(
+    grpc::ServerContextBase* context,
     const CancelSubscriptionRequest* request,
     SubscriptionResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
         // SECURITY FIX: Use separate parameterized queries instead of string concatenation
@@ -251,30 +499,16 @@ grpc::Status PaymentServiceImpl::CancelSubscription(
 
         if (request->immediate()) {
             // Cancel immediately - set status to CANCELED and cancel_at to NOW
-            result = txn.exec_params(
-                "UPDATE subscriptions SET "
-                "status = $1, cancel_at = NOW(), canceled_at = NOW(), updated_at = NOW() "
-                "WHERE id = $2 AND tenant_id = $3 "
-                "RETURNING id, tenant_id, plan_id, status, "
-                "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
-                "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
-                "EXTRACT(EPOCH FROM cancel_at)::bigint as cancel_at, "
-                "quantity, mrr",
+            result = common::ExecPrepared(
+                txn, kCancelNow,
                 static_cast<int>(SubscriptionStatus::CANCELED),
                 request->subscription_id(),
                 tenant_ctx.tenant_id
             );
         } else {
             // Cancel at period end - set cancel_at to current_period_end
-            result = txn.exec_params(
-                "UPDATE subscriptions SET "
-                "cancel_at = current_period_end, updated_at = NOW() "
-                "WHERE id = $1 AND tenant_id = $2 "
-                "RETURNING id, tenant_id, plan_id, status, "
-                "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
-                "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
-                "EXTRACT(EPOCH FROM cancel_at)::bigint as cancel_at, "
-                "quantity, mrr",
+            result = common::ExecPrepared(
+                txn, kCancelAtPeriodEnd,
                 request->subscription_id(),
                 tenant_ctx.tenant_id
             );
@@ -297,7 +531,12 @@ grpc::Status PaymentServiceImpl::CancelSubscription(
         response->set_quantity(row["quantity"].as<int>());
         response->set_mrr(row["mrr"].as<double>());
 
+        common::Outbox::Append(txn, tenant_ctx.tenant_id,
+                               request->immediate() ? "subscription.canceled" : "subscription.cancel_scheduled",
+                               *response);
         txn.commit();
+        db_pool_->RecordWrite(tenant_ctx.tenant_id);
+        caches_.subscriptions->Invalidate({tenant_ctx.tenant_id, request->subscription_id()});
 
         return grpc::Status::OK;
 
@@ -307,49 +546,56 @@ grpc::Status PaymentServiceImpl::CancelSubscription(
 }
 
 grpc::Status PaymentServiceImpl::GetSubscription(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const GetSubscriptionRequest* request,
     SubscriptionResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
-
-        auto result = txn.exec_params(
-            "SELECT id, tenant_id, plan_id, status, "
-            "EXTRACT(EPOCH FROM current_period_start)::bigint as period_start, "
-            "EXTRACT(EPOCH FROM current_period_end)::bigint as period_end, "
-            "EXTRACT(EPOCH FROM cancel_at)::bigint as cancel_at, "
-            "quantity, mrr "
-            "FROM subscriptions WHERE id = $1 AND tenant_id = $2",
-            request->subscription_id(),
-            tenant_ctx.tenant_id
-        );
-
-        if (result.empty()) {
+        auto subscription = caches_.subscriptions->Get(
+            {tenant_ctx.tenant_id, request->subscription_id()},
+            [&]() -> std::optional<SubscriptionResponse> {
+                // Kept for up to ENTITY_CACHE_TTL_S, so read the primary: a lagging replica's row would stay
+                auto conn_guard = db_pool_->AcquireConnection("GetSubscription");
+                pqxx::read_transaction txn(*conn_guard);
+
+                auto result = common::ExecPrepared(
+                    txn, kSelectSubscription,
+                    request->subscription_id(),
+                    tenant_ctx.tenant_id
+                );
+                txn.commit();
+
+                if (result.empty()) {
+                    return std::nullopt;
+                }
+
+                auto row = result[0];
+                SubscriptionResponse loaded;
+                loaded.set_id(row["id"].as<std::string>());
+                loaded.set_tenant_id(row["tenant_id"].as<std::string>());
+                loaded.set_plan_id(row["plan_id"].as<std::string>());
+                loaded.set_status(static_cast<SubscriptionStatus>(row["status"].as<int>()));
+                loaded.set_current_period_start(row["period_start"].as<long long>());
+                loaded.set_current_period_end(row["period_end"].as<long long>());
+                if (!row["cancel_at"].is_null()) {
+                    loaded.set_cancel_at(row["cancel_at"].as<long long>());
+                }
+                loaded.set_quantity(row["quantity"].as<int>());
+                loaded.set_mrr(row["mrr"].as<double>());
+                return loaded;
+            });
+
+        if (!subscription) {
             return grpc::Status(grpc::StatusCode::NOT_FOUND, "Subscription not found");
         }
-
-        auto row = result[0];
-        response->set_id(row["id"].as<std::string>());
-        response->set_tenant_id(row["tenant_id"].as<std::string>());
-        response->set_plan_id(row["plan_id"].as<std::string>());
-        response->set_status(static_cast<SubscriptionStatus>(row["status"].as<int>()));
-        response->set_current_period_start(row["period_start"].as<long long>());
-        response->set_current_period_end(row["period_end"].as<long long>());
-        if (!row["cancel_at"].is_null()) {
-            response->set_cancel_at(row["cancel_at"].as<long long>());
-        }
-        response->set_quantity(row["quantity"].as<int>());
-        response->set_mrr(row["mrr"].as<double>());
-
-        txn.commit();
+        *response = *subscription;
 
         return grpc::Status::OK;
 
@@ -359,12 +605,23 @@ grpc::Status PaymentServiceImpl::GetSubscription(
 }
 
 grpc::Status PaymentServiceImpl::AddPaymentMethod(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
+    const AddPaymentMethodRequest* request,
+    PaymentMethodResponse* response
+) {
+    return RunIdempotent("add_payment_method", context, *request, response, [&] {
+        return ApplyAddPaymentMethod(context, request, response);
+    });
+}
+
+grpc::Status PaymentServiceImpl::ApplyAddPaymentMethod(
+    grpc::ServerContextBase* context,
     const AddPaymentMethodRequest* request,
     PaymentMethodResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
@@ -378,13 +635,11 @@ grpc::Status PaymentServiceImpl::AddPaymentMethod(
         int mock_exp_year = 2025;
 
         // Store in database
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "INSERT INTO payment_methods (tenant_id, stripe_payment_method_id, type, last4, brand, exp_month, exp_year) "
-            "VALUES ($1, $2, $3, $4, $5, $6, $7) "
-            "RETURNING id",
+        auto result = common::ExecPrepared(
+            txn, kInsertPaymentMethod,
             tenant_ctx.tenant_id,
             request->stripe_payment_method_id(),
             mock_type,
@@ -411,24 +666,34 @@ grpc::Status PaymentServiceImpl::AddPaymentMethod(
 }
 
 grpc::Status PaymentServiceImpl::RemovePaymentMethod(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
+    const RemovePaymentMethodRequest* request,
+    RemovePaymentMethodResponse* response
+) {
+    return RunIdempotent("remove_payment_method", context, *request, response, [&] {
+        return ApplyRemovePaymentMethod(context, request, response);
+    });
+}
+
+grpc::Status PaymentServiceImpl::ApplyRemovePaymentMethod(
+    grpc::ServerContextBase* context,
     const RemovePaymentMethodRequest* request,
     RemovePaymentMethodResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
         // Soft delete
-        auto result = txn.exec_params(
-            "UPDATE payment_methods SET deleted_at = NOW() "
-            "WHERE id = $1 AND tenant_id = $2 AND deleted_at IS NULL",
+        auto result = common::ExecPrepared(
+            txn, kDeletePaymentMethod,
             request->payment_method_id(),
             tenant_ctx.tenant_id
         );
@@ -448,51 +713,57 @@ grpc::Status PaymentServiceImpl::RemovePaymentMethod(
 }
 
 grpc::Status PaymentServiceImpl::GetInvoice(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const GetInvoiceRequest* request,
     InvoiceResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
-
-        auto result = txn.exec_params(
-            "SELECT id, tenant_id, subscription_id, amount_due, amount_paid, status, "
-            "EXTRACT(EPOCH FROM due_date)::bigint as due_date, "
-            "EXTRACT(EPOCH FROM paid_at)::bigint as paid_at, "
-            "pdf_url "
-            "FROM invoices WHERE id = $1 AND tenant_id = $2",
-            request->invoice_id(),
-            tenant_ctx.tenant_id
-        );
-
-        if (result.empty()) {
+        auto invoice = caches_.invoices->Get(
+            {tenant_ctx.tenant_id, request->invoice_id()},
+            [&]() -> std::optional<InvoiceResponse> {
+                auto conn_guard = db_pool_->AcquireConnection("GetInvoice");
+                pqxx::read_transaction txn(*conn_guard);
+
+                auto result = common::ExecPrepared(
+                    txn, kSelectInvoice,
+                    request->invoice_id(),
+                    tenant_ctx.tenant_id
+                );
+                txn.commit();
+
+                if (result.empty()) {
+                    return std::nullopt;
+                }
+
+                auto row = result[0];
+                InvoiceResponse loaded;
+                loaded.set_id(row["id"].as<std::string>());
+                loaded.set_tenant_id(row["tenant_id"].as<std::string>());
+                loaded.set_subscription_id(row["subscription_id"].as<std::string>());
+                loaded.set_amount_due(row["amount_due"].as<double>());
+                loaded.set_amount_paid(row["amount_paid"].as<double>());
+                loaded.set_status(row["status"].as<std::string>());
+                loaded.set_due_date(row["due_date"].as<long long>());
+                if (!row["paid_at"].is_null()) {
+                    loaded.set_paid_at(row["paid_at"].as<long long>());
+                }
+                if (!row["pdf_url"].is_null()) {
+                    loaded.set_pdf_url(row["pdf_url"].as<std::string>());
+                }
+                return loaded;
+            });
+
+        if (!invoice) {
             return grpc::Status(grpc::StatusCode::NOT_FOUND, "Invoice not found");
         }
-
-        auto row = result[0];
-        response->set_id(row["id"].as<std::string>());
-        response->set_tenant_id(row["tenant_id"].as<std::string>());
-        response->set_subscription_id(row["subscription_id"].as<std::string>());
-        response->set_amount_due(row["amount_due"].as<double>());
-        response->set_amount_paid(row["amount_paid"].as<double>());
-        response->set_status(row["status"].as<std::string>());
-        response->set_due_date(row["due_date"].as<long long>());
-
-        if (!row["paid_at"].is_null()) {
-            response->set_paid_at(row["paid_at"].as<long long>());
-        }
-        if (!row["pdf_url"].is_null()) {
-            response->set_pdf_url(row["pdf_url"].as<std::string>());
-        }
-
-        txn.commit();
+        *response = *invoice;
 
         return grpc::Status::OK;
 
@@ -502,86 +773,237 @@ grpc::Status PaymentServiceImpl::GetInvoice(
 }
 
 grpc::Status PaymentServiceImpl::RecordUsage(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
+    const RecordUsageRequest* request,
+    RecordUsageResponse* response
+) {
+    return RunIdempotent("record_usage", context, *request, response, [&] {
+        return ApplyRecordUsage(context, request, response);
+    });
+}
+
+grpc::Status PaymentServiceImpl::ApplyRecordUsage(
+    grpc::ServerContextBase* context,
     const RecordUsageRequest* request,
     RecordUsageResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        // Verify subscription belongs to tenant
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
-
-        auto sub_check = txn.exec_params(
-            "SELECT id FROM subscriptions WHERE id = $1 AND tenant_id = $2",
-            request->subscription_id(),
-            tenant_ctx.tenant_id
-        );
-
-        if (sub_check.empty()) {
+        if (!OwnsSubscription(tenant_ctx.tenant_id, request->subscription_id())) {
             return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Subscription not found or access denied");
         }
 
-        // Record usage
-        auto result = txn.exec_params(
-            "INSERT INTO usage_records (tenant_id, subscription_id, metric_name, quantity, timestamp) "
-            "VALUES ($1, $2, $3, $4, to_timestamp($5)) "
-            "RETURNING id",
+        // Buffered and written per minute bucket by UsageAggregator
+        usage_aggregator_->Record({
             tenant_ctx.tenant_id,
             request->subscription_id(),
             request->metric_name(),
             request->quantity(),
             request->timestamp()
-        );
+        });
 
         response->set_success(true);
-        response->set_usage_record_id(result[0]["id"].as<std::string>());
 
+        return grpc::Status::OK;
+
+    } catch (const std::invalid_argument& e) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Record usage failed: ") + e.what());
+    }
+}
+
+grpc::Status PaymentServiceImpl::StreamUsage(
+    grpc::ServerContextBase* context,
+    const std::vector<RecordUsageRequest>& requests,
+    StreamUsageResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        // Invalid events are counted and skipped; the rest share one WAL write
+        std::vector<common::UsageEvent> events;
+        events.reserve(requests.size());
+        int64_t rejected = 0;
+
+        for (const auto& request : requests) {
+            common::UsageEvent event{
+                tenant_ctx.tenant_id,
+                request.subscription_id(),
+                request.metric_name(),
+                request.quantity(),
+                request.timestamp()
+            };
+            try {
+                common::UsageAggregator::Validate(event);
+            } catch (const std::invalid_argument&) {
+                ++rejected;
+                continue;
+            }
+            if (!OwnsSubscription(tenant_ctx.tenant_id, event.subscription_id)) {
+                ++rejected;
+                continue;
+            }
+            events.push_back(std::move(event));
+        }
+
+        usage_aggregator_->Record(events);
+
+        response->set_accepted(response->accepted() + static_cast<int64_t>(events.size()));
+        response->set_rejected(response->rejected() + rejected);
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Stream usage failed: ") + e.what());
+    }
+}
+
+grpc::Status PaymentServiceImpl::GetUsageSummary(
+    grpc::ServerContextBase* context,
+    const GetUsageSummaryRequest* request,
+    GetUsageSummaryResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        int64_t start_time = request->start_time();
+        int64_t end_time = request->end_time();
+        if (end_time == 0) {
+            end_time = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        if (start_time < 0 || end_time <= start_time) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "end_time must be after start_time");
+        }
+
+        if (!OwnsSubscription(tenant_ctx.tenant_id, request->subscription_id())) {
+            return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "Subscription not found or access denied");
+        }
+
+        const common::PreparedStatement* query = &kSelectUsageByPeriod;
+        if (request->granularity() == UsageGranularity::MINUTE) {
+            query = &kSelectUsageByMinute;
+        } else if (request->granularity() == UsageGranularity::HOUR) {
+            query = &kSelectUsageByHour;
+        }
+
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::read_transaction txn(*conn_guard);
+
+        // One extra row tells whether the result was cut off
+        auto result = common::ExecPrepared(
+            txn, *query,
+            tenant_ctx.tenant_id,
+            request->subscription_id(),
+            request->metric_name(),
+            start_time,
+            end_time,
+            MAX_USAGE_SUMMARY_BUCKETS + 1
+        );
         txn.commit();
 
+        for (const auto& row : result) {
+            if (response->buckets_size() >= MAX_USAGE_SUMMARY_BUCKETS) {
+                response->set_truncated(true);
+                break;
+            }
+            auto* bucket = response->add_buckets();
+            bucket->set_metric_name(row["metric_name"].as<std::string>());
+            bucket->set_bucket_start(row["bucket_start"].as<int64_t>());
+            bucket->set_bucket_end(row["bucket_end"].as<int64_t>());
+            bucket->set_quantity(row["quantity"].as<int64_t>());
+        }
+
         return grpc::Status::OK;
 
     } catch (const std::exception& e) {
-        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Record usage failed: ") + e.what());
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Get usage summary failed: ") + e.what());
+    }
+}
+
+grpc::Status PaymentServiceImpl::HandleStripeWebhook(
+    grpc::ServerContextBase* context,
+    const StripeWebhookRequest* request,
+    StripeWebhookResponse* response
+) {
+    // The gateway maps these to HTTP: Stripe retries anything but 2xx, so
+    // only a stored event (or one stored before) is acknowledged
+    switch (stripe_webhooks_->Ingest(request->payload(), request->signature())) {
+        case WebhookResult::ACCEPTED:
+            return grpc::Status::OK;
+        case WebhookResult::DUPLICATE:
+            response->set_duplicate(true);
+            return grpc::Status::OK;
+        case WebhookResult::INVALID_SIGNATURE:
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Invalid Stripe signature");
+        case WebhookResult::INVALID_PAYLOAD:
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Not a Stripe event");
+        case WebhookResult::UNAVAILABLE:
+            break;
     }
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE, "Stripe event not stored; retry");
 }
 
 // Helper methods
 
 std::string PaymentServiceImpl::GenerateMockStripeId(const std::string& prefix) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 255);
-
-    std::stringstream ss;
-    ss << prefix << "_";
-    for (int i = 0; i < 24; i++) {
-        ss << std::hex << std::setw(2) << std::setfill('0') << dis(gen);
+    return common::IdGenerator::NewUlid(prefix);
+}
+
+bool PaymentServiceImpl::OwnsSubscription(const std::string& tenant_id, const std::string& subscription_id) {
+    std::string key = tenant_id + '\0' + subscription_id;
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(ownership_mutex_);
+        auto it = verified_subscriptions_.find(key);
+        if (it != verified_subscriptions_.end() && now - it->second < OWNERSHIP_CACHE_TTL) {
+            return true;
+        }
     }
 
-    return ss.str();
-}
+    // Only positive results are cached, so a new subscription is usable at once
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+    auto sub_check = common::ExecPrepared(txn, kCheckSubscription, subscription_id, tenant_id);
+    txn.commit();
 
-double PaymentServiceImpl::CalculateMRR(const std::string& plan_id, int32_t quantity) {
-    // Mock MRR calculation (in production, lookup plan pricing)
-    double base_price = 0.0;
-
-    if (plan_id == "starter") {
-        base_price = 29.0;
-    } else if (plan_id == "professional") {
-        base_price = 99.0;
-    } else if (plan_id == "enterprise") {
-        base_price = 299.0;
-    } else {
-        base_price = 49.0; // default
+    if (sub_check.empty()) {
+        return false;
     }
 
-    return base_price * quantity;
+    std::lock_guard<std::mutex> lock(ownership_mutex_);
+    if (verified_subscriptions_.size() >= MAX_OWNERSHIP_CACHE_ENTRIES) {
+        verified_subscriptions_.clear();
+    }
+    verified_subscriptions_[key] = now;
+    return true;
+}
+
+std::optional<double> PaymentServiceImpl::CalculateMRR(const std::string& plan_id, int32_t quantity) {
+    // Priced from the current catalog snapshot: no DB read, no allocation
+    auto catalog = plan_catalog_->Current();
+    const auto* plan = catalog->Find(plan_id);
+    if (!plan) {
+        return std::nullopt;
+    }
+    return PlanCatalogSnapshot::ToCurrency(catalog->RecurringAmountMicros(*plan, quantity));
 }
 
 } // namespace payment
@@ -0,0 +1,325 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Plan catalog: immutable pricing snapshots swapped on change implementation
+ */
+
+#include "payment/plan_catalog.h"
+#include "common/statement_registry.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+#include <pqxx/pqxx>
+
+namespace saasforge {
+namespace payment {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+const common::PreparedStatement kLoadPlanPrices(
+    "payment_load_plan_prices",
+    "SELECT plan_id, metric_name, pricing_model, up_to, unit_amount_micros, flat_amount_micros "
+    "FROM plan_prices WHERE active ORDER BY plan_id, metric_name, tier");
+
+uint64_t HashPlanId(std::string_view plan_id) {
+    uint64_t hash = 14695981039346656037ull;   // FNV-1a
+    for (unsigned char c : plan_id) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 32);
+}
+
+int64_t CheckedMulAdd(int64_t units, int64_t amount, int64_t total) {
+    constexpr int64_t MAX = std::numeric_limits<int64_t>::max();
+    if (amount != 0 && units > (MAX - total) / amount) {
+        throw std::overflow_error("Price amount overflows");
+    }
+    return total + units * amount;
+}
+
+} // namespace
+
+PlanCatalogSnapshot::PlanCatalogSnapshot(const std::vector<PlanDefinition>& plans, uint64_t version)
+    : version_(version) {
+    plans_.reserve(plans.size());
+    for (const auto& definition : plans) {
+        Plan plan;
+        plan.plan_id = definition.plan_id;
+        plan.first_metered = static_cast<uint32_t>(metered_.size());
+
+        bool has_recurring = false;
+        std::unordered_set<std::string> metrics;
+        for (const auto& price : definition.prices) {
+            if (price.metric_name.empty()) {
+                if (has_recurring) {
+                    throw std::invalid_argument("Plan has several recurring prices: " + plan.plan_id);
+                }
+                has_recurring = true;
+                plan.recurring = Compile(price, plan.plan_id);
+            } else {
+                if (!metrics.insert(price.metric_name).second) {
+                    throw std::invalid_argument("Plan prices metric " + price.metric_name + " twice: " + plan.plan_id);
+                }
+                metered_.push_back({price.metric_name, Compile(price, plan.plan_id)});
+            }
+        }
+        if (plan.plan_id.empty() || !has_recurring) {
+            throw std::invalid_argument("Plan without an id or a recurring price: '" + plan.plan_id + "'");
+        }
+        plan.metered_count = static_cast<uint32_t>(metered_.size()) - plan.first_metered;
+        plans_.push_back(std::move(plan));
+    }
+
+    // Load factor <= 1/2, so probe sequences stay short
+    size_t capacity = 1;
+    while (capacity < plans_.size() * 2) {
+        capacity <<= 1;
+    }
+    slots_.assign(capacity, 0);
+    for (uint32_t i = 0; i < plans_.size(); ++i) {
+        size_t slot = HashPlanId(plans_[i].plan_id) & (capacity - 1);
+        while (slots_[slot] != 0) {
+            if (plans_[slots_[slot] - 1].plan_id == plans_[i].plan_id) {
+                throw std::invalid_argument("Duplicate plan: " + plans_[i].plan_id);
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+        slots_[slot] = i + 1;
+    }
+}
+
+PlanCatalogSnapshot::Price PlanCatalogSnapshot::Compile(const PriceDefinition& price, const std::string& plan_id) {
+    if (price.model > PricingModel::VOLUME) {
+        throw std::invalid_argument("Unknown pricing model for plan " + plan_id);
+    }
+    if (price.tiers.empty() || (price.model == PricingModel::PER_UNIT && price.tiers.size() != 1)) {
+        throw std::invalid_argument("Bad tier count for plan " + plan_id);
+    }
+    int64_t previous = 0;
+    for (size_t i = 0; i < price.tiers.size(); ++i) {
+        const auto& tier = price.tiers[i];
+        bool last = i + 1 == price.tiers.size();
+        if (tier.unit_amount_micros < 0 || tier.flat_amount_micros < 0 || tier.up_to < 0 ||
+            (last != (tier.up_to == 0)) || (!last && tier.up_to <= previous)) {
+            throw std::invalid_argument("Bad price tiers for plan " + plan_id);
+        }
+        previous = tier.up_to;
+    }
+
+    Price compiled;
+    compiled.first_tier = static_cast<uint32_t>(tiers_.size());
+    compiled.tier_count = static_cast<uint32_t>(price.tiers.size());
+    compiled.model = price.model;
+    tiers_.insert(tiers_.end(), price.tiers.begin(), price.tiers.end());
+    return compiled;
+}
+
+const PlanCatalogSnapshot::Plan* PlanCatalogSnapshot::Find(std::string_view plan_id) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = HashPlanId(plan_id) & mask; slots_[slot] != 0; slot = (slot + 1) & mask) {
+        const Plan& plan = plans_[slots_[slot] - 1];
+        if (plan.plan_id == plan_id) {
+            return &plan;
+        }
+    }
+    return nullptr;
+}
+
+int64_t PlanCatalogSnapshot::RecurringAmountMicros(const Plan& plan, int64_t quantity) const {
+    return Amount(plan.recurring, quantity);
+}
+
+int64_t PlanCatalogSnapshot::UsageAmountMicros(const Plan& plan, std::string_view metric_name, int64_t units) const {
+    for (uint32_t i = plan.first_metered; i < plan.first_metered + plan.metered_count; ++i) {
+        if (metered_[i].metric_name == metric_name) {
+            return Amount(metered_[i].price, units);
+        }
+    }
+    return 0;
+}
+
+int64_t PlanCatalogSnapshot::Amount(const Price& price, int64_t quantity) const {
+    if (quantity <= 0) {
+        return 0;
+    }
+    const PriceTier* tiers = tiers_.data() + price.first_tier;
+
+    switch (price.model) {
+        case PricingModel::PER_UNIT:
+            return CheckedMulAdd(quantity, tiers[0].unit_amount_micros, tiers[0].flat_amount_micros);
+
+        case PricingModel::VOLUME:
+            for (uint32_t i = 0; i < price.tier_count; ++i) {
+                if (tiers[i].up_to == 0 || quantity <= tiers[i].up_to) {
+                    return CheckedMulAdd(quantity, tiers[i].unit_amount_micros, tiers[i].flat_amount_micros);
+                }
+            }
+            break;
+
+        case PricingModel::GRADUATED: {
+            int64_t total = 0;
+            int64_t priced = 0;   // Units covered by the tiers before this one
+            for (uint32_t i = 0; i < price.tier_count && priced < quantity; ++i) {
+                int64_t upper = tiers[i].up_to == 0 ? quantity : std::min(quantity, tiers[i].up_to);
+                total = CheckedMulAdd(upper - priced, tiers[i].unit_amount_micros, total);
+                total = CheckedMulAdd(1, tiers[i].flat_amount_micros, total);
+                priced = upper;
+            }
+            return total;
+        }
+    }
+    return 0;   // Unreachable: the last tier is unbounded
+}
+
+PlanCatalogOptions PlanCatalogOptions::FromEnv() {
+    PlanCatalogOptions options;
+    options.refresh = std::chrono::milliseconds(
+        common::EnvInt("PLAN_CATALOG_REFRESH_MS", static_cast<long>(options.refresh.count())));
+    return options;
+}
+
+PlanCatalog::PlanCatalog(Loader loader, std::shared_ptr<common::EventBus> event_bus,
+                         const PlanCatalogOptions& options)
+    : load_(std::move(loader)), event_bus_(std::move(event_bus)), options_(options) {
+    if (options_.refresh.count() <= 0) {
+        options_.refresh = std::chrono::milliseconds(1000);
+    }
+    Install(DefaultPlans());
+    if (!load_) {
+        return;
+    }
+
+    // Synchronous first load: the first requests are priced from the source, not the defaults
+    Refresh();
+
+    if (event_bus_) {
+        auto reload = [this]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                changed_ = true;
+            }
+            cv_.notify_all();
+        };
+        // A group reset reloads too, since change events may have been missed
+        subscription_ = event_bus_->Subscribe(
+            CHANGED_TOPIC, [reload](const std::string&) { reload(); }, reload);
+    }
+    thread_ = std::thread(&PlanCatalog::RefreshLoop, this);
+}
+
+PlanCatalog::~PlanCatalog() {
+    Shutdown();
+}
+
+void PlanCatalog::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    if (subscription_ != 0) {
+        event_bus_->Unsubscribe(subscription_);
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::shared_ptr<const PlanCatalogSnapshot> PlanCatalog::Current() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    return snapshot_;
+}
+
+bool PlanCatalog::Refresh() {
+    std::lock_guard<std::mutex> lock(refresh_mutex_);
+    try {
+        auto plans = load_();
+        if (plans.empty()) {
+            plans = DefaultPlans();
+        }
+        Install(plans);   // Throws on an invalid catalog before swapping
+        if (!loaded_) {
+            loaded_ = true;
+            common::LogInfo("Plan catalog loaded", {{"plans", plans.size()}});
+        }
+        return true;
+    } catch (const std::exception& e) {
+        ++failures_;
+        common::LogError("Loading plan catalog failed", {{"error", e.what()}});
+        return false;
+    }
+}
+
+void PlanCatalog::Install(const std::vector<PlanDefinition>& plans) {
+    // Built outside snapshot_mutex_, so pricing never waits on a rebuild
+    auto snapshot = std::make_shared<const PlanCatalogSnapshot>(plans, next_version_);
+    ++next_version_;
+
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    snapshot_ = std::move(snapshot);
+}
+
+void PlanCatalog::RefreshLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!shutdown_) {
+        cv_.wait_for(lock, options_.refresh, [this] { return shutdown_ || changed_; });
+        if (shutdown_) {
+            break;
+        }
+        changed_ = false;
+        lock.unlock();
+        Refresh();
+        lock.lock();
+    }
+}
+
+PlanCatalog::Loader PlanCatalog::DbLoader(std::shared_ptr<common::DbPool> db_pool) {
+    return [db_pool = std::move(db_pool)]() {
+        auto conn_guard = db_pool->AcquireConnection("PlanCatalog::Load");
+        pqxx::read_transaction txn(*conn_guard);
+        auto result = common::ExecPrepared(txn, kLoadPlanPrices);
+
+        // Rows are ordered by plan, then price, then tier
+        std::vector<PlanDefinition> plans;
+        for (const auto& row : result) {
+            auto plan_id = row["plan_id"].as<std::string>();
+            auto metric_name = row["metric_name"].as<std::string>();
+            if (plans.empty() || plans.back().plan_id != plan_id) {
+                plans.push_back({plan_id, {}});
+            }
+            auto& prices = plans.back().prices;
+            if (prices.empty() || prices.back().metric_name != metric_name) {
+                prices.push_back({metric_name, static_cast<PricingModel>(row["pricing_model"].as<int>()), {}});
+            }
+            prices.back().tiers.push_back({
+                row["up_to"].is_null() ? 0 : row["up_to"].as<int64_t>(),
+                row["unit_amount_micros"].as<int64_t>(),
+                row["flat_amount_micros"].as<int64_t>()
+            });
+        }
+        return plans;
+    };
+}
+
+std::vector<PlanDefinition> PlanCatalog::DefaultPlans() {
+    auto per_seat = [](const char* plan_id, int64_t micros) {
+        return PlanDefinition{plan_id, {{"", PricingModel::PER_UNIT, {{0, micros, 0}}}}};
+    };
+    return {
+        per_seat("starter", 29'000'000),
+        per_seat("professional", 99'000'000),
+        per_seat("enterprise", 299'000'000),
+    };
+}
+
+} // namespace payment
+} // namespace saasforge
@@ -0,0 +1,602 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Stripe webhook ingestion: signature checks, dedup and per-customer ordered processing implementation
+ */
+
+#include "payment/stripe_webhooks.h"
+#include "payment.pb.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/mock_stripe_client.h"
+#include "common/statement_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <openssl/crypto.h>
+#include <pqxx/pqxx>
+
+#ifndef PICOJSON_USE_INT64
+#define PICOJSON_USE_INT64
+#endif
+#include <picojson/picojson.h>
+
+namespace saasforge {
+namespace payment {
+
+namespace {
+
+// Invoice payment attempts after which Stripe's default dunning leaves a
+// subscription unpaid (MockStripeClient::RecordPaymentFailure uses the same)
+constexpr int UNPAID_AFTER_ATTEMPTS = 3;
+
+constexpr std::chrono::milliseconds INITIAL_RETRY{100};
+constexpr std::chrono::milliseconds MAX_RETRY{5000};
+
+// Events that change no status are stored already processed ($6)
+const common::PreparedStatement kInsertEvents(
+    "payment_insert_stripe_events",
+    "INSERT INTO stripe_events (event_id, type, customer_id, stripe_created, payload, processed_at) "
+    "SELECT id, type, NULLIF(customer, ''), to_timestamp(created), payload::jsonb, "
+    "  CASE WHEN actionable THEN NULL ELSE NOW() END "
+    "FROM unnest($1::text[], $2::text[], $3::text[], $4::bigint[], $5::text[], $6::boolean[]) "
+    "  AS t(id, type, customer, created, payload, actionable) "
+    "ON CONFLICT (event_id) DO NOTHING "
+    "RETURNING event_id");
+
+// One round trip per batch. A row takes a status only from an event at
+// least as new as the one that set its current status, so late or
+// redelivered events cannot move a subscription back. Returns the rows
+// updated; `processed` runs whether or not it is read.
+const common::PreparedStatement kApplyTransitions(
+    "payment_apply_stripe_transitions",
+    "WITH input AS ("
+    "  SELECT id, status, to_timestamp(event_at) AS event_at "
+    "  FROM unnest($1::text[], $2::int[], $3::bigint[]) AS t(id, status, event_at)"
+    "), updated AS ("
+    "  UPDATE subscriptions s SET "
+    "    status = i.status, "
+    "    status_event_at = i.event_at, "
+    "    canceled_at = CASE WHEN i.status = $5 THEN COALESCE(s.canceled_at, i.event_at) ELSE s.canceled_at END, "
+    "    updated_at = NOW() "
+    "  FROM input i "
+    "  WHERE s.stripe_subscription_id = i.id "
+    "    AND (s.status_event_at IS NULL OR s.status_event_at <= i.event_at) "
+    "  RETURNING s.id, s.tenant_id"
+    "), processed AS ("
+    "  UPDATE stripe_events SET processed_at = NOW() "
+    "  WHERE event_id = ANY($4::text[]) AND processed_at IS NULL"
+    ") "
+    "SELECT id::text AS id, tenant_id::text AS tenant_id FROM updated");
+
+const common::PreparedStatement kLoadPendingEvents(
+    "payment_load_pending_stripe_events",
+    "SELECT payload::text AS payload FROM stripe_events "
+    "WHERE processed_at IS NULL ORDER BY stripe_created, received_at LIMIT $1");
+
+const picojson::value& Field(const picojson::value& value, const char* name) {
+    static const picojson::value null;
+    if (!value.is<picojson::object>()) {
+        return null;
+    }
+    const auto& object = value.get<picojson::object>();
+    auto it = object.find(name);
+    return it == object.end() ? null : it->second;
+}
+
+std::string String(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<std::string>() ? field.get<std::string>() : "";
+}
+
+// An id field that may be expanded into the object it names
+std::string IdOf(const picojson::value& value, const char* name) {
+    const auto& field = Field(value, name);
+    return field.is<picojson::object>() ? String(field, "id") : String(value, name);
+}
+
+} // namespace
+
+// DbStripeEventStore
+
+std::vector<bool> DbStripeEventStore::Insert(const std::vector<StripeEvent>& events) {
+    std::vector<std::string> ids, types, customers, created, payloads, actionable;
+    for (const auto& event : events) {
+        ids.push_back(event.id);
+        types.push_back(event.type);
+        customers.push_back(event.customer_id);
+        created.push_back(std::to_string(event.created));
+        payloads.push_back(event.payload);
+        actionable.push_back(StripeWebhookIngestor::StatusFor(event) ? "t" : "f");
+    }
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+    auto result = common::ExecPrepared(
+        txn, kInsertEvents,
+        common::ToArrayLiteral(ids),
+        common::ToArrayLiteral(types),
+        common::ToArrayLiteral(customers),
+        common::ToArrayLiteral(created),
+        common::ToArrayLiteral(payloads),
+        common::ToArrayLiteral(actionable)
+    );
+    txn.commit();
+
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < events.size(); ++i) {
+        index.emplace(events[i].id, i);
+    }
+    std::vector<bool> inserted(events.size(), false);
+    for (const auto& row : result) {
+        auto it = index.find(row["event_id"].as<std::string>());
+        if (it != index.end()) {
+            inserted[it->second] = true;
+        }
+    }
+    return inserted;
+}
+
+size_t DbStripeEventStore::Apply(const std::vector<SubscriptionTransition>& transitions,
+                                 const std::vector<std::string>& event_ids) {
+    std::vector<std::string> ids, statuses, event_at;
+    for (const auto& transition : transitions) {
+        ids.push_back(transition.subscription_id);
+        statuses.push_back(std::to_string(transition.status));
+        event_at.push_back(std::to_string(transition.event_at));
+    }
+
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::work txn(*conn_guard);
+    auto result = common::ExecPrepared(
+        txn, kApplyTransitions,
+        common::ToArrayLiteral(ids),
+        common::ToArrayLiteral(statuses),
+        common::ToArrayLiteral(event_at),
+        common::ToArrayLiteral(event_ids),
+        static_cast<int>(CANCELED)
+    );
+    txn.commit();
+
+    if (on_updated_ && !result.empty()) {
+        std::vector<std::pair<std::string, std::string>> updated;
+        updated.reserve(result.size());
+        for (const auto& row : result) {
+            updated.emplace_back(row["tenant_id"].as<std::string>(), row["id"].as<std::string>());
+        }
+        on_updated_(updated);
+    }
+    return result.size();
+}
+
+std::vector<StripeEvent> DbStripeEventStore::LoadPending(size_t limit) {
+    auto conn_guard = db_pool_->AcquireConnection(__func__);
+    pqxx::read_transaction txn(*conn_guard);
+    auto result = common::ExecPrepared(txn, kLoadPendingEvents, static_cast<int64_t>(limit));
+
+    std::vector<StripeEvent> events;
+    for (const auto& row : result) {
+        if (auto event = StripeWebhookIngestor::ParseEvent(row["payload"].as<std::string>())) {
+            events.push_back(std::move(*event));
+        }
+    }
+    return events;
+}
+
+// StripeWebhookIngestor
+
+StripeWebhookOptions StripeWebhookOptions::FromEnv() {
+    StripeWebhookOptions options;
+    options.tolerance = std::chrono::seconds(
+        common::EnvInt("STRIPE_WEBHOOK_TOLERANCE_SECONDS", static_cast<long>(options.tolerance.count())));
+    options.workers = static_cast<size_t>(common::EnvInt("STRIPE_WEBHOOK_WORKERS", static_cast<long>(options.workers)));
+    options.batch_size = static_cast<size_t>(
+        common::EnvInt("STRIPE_WEBHOOK_BATCH_SIZE", static_cast<long>(options.batch_size)));
+    options.queue_limit = static_cast<size_t>(
+        common::EnvInt("STRIPE_WEBHOOK_QUEUE_LIMIT", static_cast<long>(options.queue_limit)));
+    options.recover_limit = static_cast<size_t>(
+        common::EnvInt("STRIPE_WEBHOOK_RECOVER_LIMIT", static_cast<long>(options.recover_limit)));
+    return options;
+}
+
+StripeWebhookIngestor::StripeWebhookIngestor(std::shared_ptr<StripeEventStore> store,
+                                             const std::string& webhook_secret,
+                                             const StripeWebhookOptions& options)
+    : store_(std::move(store)), key_(webhook_secret), options_(options) {
+    if (webhook_secret.empty()) {
+        throw std::invalid_argument("Stripe webhook secret is required");
+    }
+    if (options_.workers == 0) {
+        options_.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options_.batch_size == 0) {
+        options_.batch_size = 1;
+    }
+
+    partitions_.reserve(options_.workers);
+    for (size_t i = 0; i < options_.workers; ++i) {
+        partitions_.push_back(std::make_unique<Partition>());
+    }
+    // Queued before any delivery can be, so they keep their place ahead of redeliveries
+    Recover();
+    for (auto& partition : partitions_) {
+        partition->thread = std::thread(&StripeWebhookIngestor::WorkerLoop, this, std::ref(*partition));
+    }
+    writer_ = std::thread(&StripeWebhookIngestor::WriterLoop, this);
+}
+
+StripeWebhookIngestor::~StripeWebhookIngestor() {
+    Shutdown();
+}
+
+WebhookResult StripeWebhookIngestor::Ingest(const std::string& payload, const std::string& signature) {
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return Ingest(payload, signature, now);
+}
+
+WebhookResult StripeWebhookIngestor::Ingest(const std::string& payload, const std::string& signature,
+                                            int64_t now) {
+    ++received_;
+    if (!VerifySignature(key_, payload, signature, now, options_.tolerance)) {
+        ++rejected_;
+        return WebhookResult::INVALID_SIGNATURE;
+    }
+    auto event = ParseEvent(payload);
+    if (!event) {
+        ++rejected_;
+        return WebhookResult::INVALID_PAYLOAD;
+    }
+    if (queued_.load() >= options_.queue_limit) {
+        return WebhookResult::UNAVAILABLE;
+    }
+
+    auto pending = std::make_shared<PendingInsert>();
+    pending->event = std::move(*event);
+    auto stored = pending->stored.get_future();
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        if (shutdown_) {
+            return WebhookResult::UNAVAILABLE;
+        }
+        inserts_.push_back(std::move(pending));
+    }
+    writer_cv_.notify_one();
+
+    try {
+        if (stored.get()) {
+            return WebhookResult::ACCEPTED;
+        }
+        ++duplicates_;
+        return WebhookResult::DUPLICATE;
+    } catch (const std::exception&) {
+        return WebhookResult::UNAVAILABLE;   // Logged by the writer
+    }
+}
+
+void StripeWebhookIngestor::WriterLoop() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    while (true) {
+        writer_cv_.wait(lock, [this] { return shutdown_ || !inserts_.empty(); });
+        if (inserts_.empty()) {
+            break;   // Shut down with nothing left to store
+        }
+        // Everything that arrived while the previous batch was written goes in one statement
+        size_t count = std::min(inserts_.size(), options_.batch_size);
+        std::vector<std::shared_ptr<PendingInsert>> batch(inserts_.begin(), inserts_.begin() + count);
+        inserts_.erase(inserts_.begin(), inserts_.begin() + count);
+        lock.unlock();
+
+        // Stripe may deliver one event to several connections at once
+        std::vector<StripeEvent> events;
+        std::vector<size_t> slot(batch.size());
+        std::unordered_map<std::string, size_t> first;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            auto [it, added] = first.emplace(batch[i]->event.id, events.size());
+            if (added) {
+                events.push_back(batch[i]->event);
+            }
+            slot[i] = added ? it->second : SIZE_MAX;
+        }
+
+        try {
+            auto inserted = store_->Insert(events);
+            ++insert_batches_;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                bool fresh = slot[i] != SIZE_MAX && inserted[slot[i]];
+                if (fresh && StatusFor(batch[i]->event)) {
+                    Dispatch(batch[i]->event);
+                }
+                batch[i]->stored.set_value(fresh);
+            }
+        } catch (const std::exception& e) {
+            ++failed_batches_;
+            common::LogError("Storing Stripe events failed", {{"events", events.size()}, {"error", e.what()}});
+            for (auto& pending : batch) {
+                pending->stored.set_exception(std::current_exception());
+            }
+        }
+        lock.lock();
+    }
+}
+
+void StripeWebhookIngestor::Dispatch(StripeEvent event) {
+    auto& partition = *partitions_[PartitionOf(event)];
+    {
+        std::lock_guard<std::mutex> lock(partition.mutex);
+        partition.queue.push_back(std::move(event));
+        ++queued_;
+    }
+    partition.cv.notify_all();
+}
+
+void StripeWebhookIngestor::WorkerLoop(Partition& partition) {
+    std::unique_lock<std::mutex> lock(partition.mutex);
+    while (true) {
+        partition.cv.wait(lock, [&] { return stopping_.load() || !partition.queue.empty(); });
+        if (partition.queue.empty()) {
+            break;   // Stopping, and everything queued was applied
+        }
+        size_t count = std::min(partition.queue.size(), options_.batch_size);
+        std::vector<StripeEvent> batch(std::make_move_iterator(partition.queue.begin()),
+                                       std::make_move_iterator(partition.queue.begin() + count));
+        partition.queue.erase(partition.queue.begin(), partition.queue.begin() + count);
+        partition.busy = true;
+        lock.unlock();
+
+        auto transitions = ReduceTransitions(batch);
+        std::vector<std::string> event_ids;
+        event_ids.reserve(batch.size());
+        for (const auto& event : batch) {
+            event_ids.push_back(event.id);
+        }
+
+        // The next batch of this partition waits, so a customer's order holds
+        auto delay = INITIAL_RETRY;
+        while (true) {
+            try {
+                transitions_ += store_->Apply(transitions, event_ids);
+                processed_ += batch.size();
+                ++apply_batches_;
+                break;
+            } catch (const std::exception& e) {
+                ++failed_batches_;
+                common::LogError("Applying Stripe events failed", {
+                    {"events", batch.size()}, {"error", e.what()}});
+            }
+            lock.lock();
+            bool stopping = partition.cv.wait_for(lock, delay, [this] { return stopping_.load(); });
+            lock.unlock();
+            if (stopping) {
+                // Left unprocessed in the store; reloaded at the next start
+                break;
+            }
+            delay = std::min(delay * 2, MAX_RETRY);
+        }
+
+        lock.lock();
+        partition.busy = false;
+        queued_ -= batch.size();
+        partition.cv.notify_all();
+    }
+}
+
+void StripeWebhookIngestor::Recover() {
+    try {
+        auto events = store_->LoadPending(options_.recover_limit);
+        for (auto& event : events) {
+            Dispatch(std::move(event));
+        }
+        if (!events.empty()) {
+            common::LogInfo("Recovered unprocessed Stripe events", {{"events", events.size()}});
+        }
+    } catch (const std::exception& e) {
+        common::LogError("Loading unprocessed Stripe events failed", {{"error", e.what()}});
+    }
+}
+
+void StripeWebhookIngestor::Drain() {
+    for (auto& partition : partitions_) {
+        std::unique_lock<std::mutex> lock(partition->mutex);
+        partition->cv.wait(lock, [&] { return partition->queue.empty() && !partition->busy; });
+    }
+}
+
+void StripeWebhookIngestor::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(writer_mutex_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+    }
+    // Deliveries already handed over are stored (and answered) first
+    writer_cv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    stopping_ = true;
+    for (auto& partition : partitions_) {
+        {
+            std::lock_guard<std::mutex> lock(partition->mutex);
+        }
+        partition->cv.notify_all();
+    }
+    for (auto& partition : partitions_) {
+        if (partition->thread.joinable()) {
+            partition->thread.join();
+        }
+    }
+}
+
+StripeWebhookStats StripeWebhookIngestor::GetStats() const {
+    StripeWebhookStats stats;
+    stats.received = received_.load();
+    stats.rejected = rejected_.load();
+    stats.duplicates = duplicates_.load();
+    stats.processed = processed_.load();
+    stats.transitions = transitions_.load();
+    stats.insert_batches = insert_batches_.load();
+    stats.apply_batches = apply_batches_.load();
+    stats.failed_batches = failed_batches_.load();
+    stats.queued = queued_.load();
+    return stats;
+}
+
+size_t StripeWebhookIngestor::PartitionOf(const StripeEvent& event) const {
+    // Events without a customer fall back to their subscription, then their own id
+    const std::string& key = !event.customer_id.empty() ? event.customer_id
+                           : !event.subscription_id.empty() ? event.subscription_id
+                           : event.id;
+    return std::hash<std::string>{}(key) % partitions_.size();
+}
+
+bool StripeWebhookIngestor::VerifySignature(const common::WebhookSigningKey& key, std::string_view payload,
+                                            std::string_view header, int64_t now,
+                                            std::chrono::seconds tolerance) {
+    std::string_view timestamp;
+    std::vector<std::string_view> signatures;
+    while (!header.empty()) {
+        size_t comma = header.find(',');
+        std::string_view item = header.substr(0, comma);
+        header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+        size_t equals = item.find('=');
+        if (equals == std::string_view::npos) {
+            continue;
+        }
+        std::string_view name = item.substr(0, equals);
+        if (name == "t") {
+            timestamp = item.substr(equals + 1);
+        } else if (name == "v1") {
+            signatures.push_back(item.substr(equals + 1));
+        }
+    }
+    if (timestamp.empty() || signatures.empty() ||
+        !std::all_of(timestamp.begin(), timestamp.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    int64_t signed_at = 0;
+    try {
+        signed_at = std::stoll(std::string(timestamp));
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (signed_at < now - tolerance.count() || signed_at > now + tolerance.count()) {
+        return false;
+    }
+
+    std::string expected = key.Sign({timestamp, ".", payload});
+    bool matched = false;
+    for (auto signature : signatures) {
+        // Every candidate is compared, so timing does not reveal which one matched
+        matched |= signature.size() == expected.size() &&
+                   CRYPTO_memcmp(signature.data(), expected.data(), expected.size()) == 0;
+    }
+    return matched;
+}
+
+std::string StripeWebhookIngestor::SignatureHeader(const common::WebhookSigningKey& key,
+                                                   std::string_view payload, int64_t timestamp) {
+    std::string t = std::to_string(timestamp);
+    return "t=" + t + ",v1=" + key.Sign({t, ".", payload});
+}
+
+std::optional<StripeEvent> StripeWebhookIngestor::ParseEvent(const std::string& payload) {
+    picojson::value body;
+    if (!picojson::parse(body, payload).empty() || String(body, "object") != "event") {
+        return std::nullopt;
+    }
+    StripeEvent event;
+    event.id = String(body, "id");
+    event.type = String(body, "type");
+    const auto& created = Field(body, "created");
+    if (event.id.empty() || event.type.empty() || !created.is<int64_t>()) {
+        return std::nullopt;
+    }
+    event.created = created.get<int64_t>();
+
+    const auto& object = Field(Field(body, "data"), "object");
+    event.customer_id = IdOf(object, "customer");
+    if (String(object, "object") == "subscription") {
+        event.subscription_id = String(object, "id");
+        event.status = String(object, "status");
+    } else {
+        event.subscription_id = IdOf(object, "subscription");
+    }
+    const auto& attempt_count = Field(object, "attempt_count");
+    if (attempt_count.is<int64_t>()) {
+        event.attempt_count = static_cast<int>(attempt_count.get<int64_t>());
+    }
+    event.payload = payload;
+    return event;
+}
+
+std::optional<common::SubscriptionStatus> StripeWebhookIngestor::StatusFor(const StripeEvent& event) {
+    using common::MockStripeClient;
+    using common::SubscriptionStatus;
+
+    if (event.subscription_id.empty()) {
+        return std::nullopt;
+    }
+    if (event.type == "customer.subscription.deleted") {
+        return SubscriptionStatus::CANCELED;
+    }
+    if (event.type == "customer.subscription.created" || event.type == "customer.subscription.updated") {
+        // Statuses the mock does not model (incomplete, incomplete_expired) leave the row as is
+        auto status = MockStripeClient::StringToStatus(event.status);
+        if (MockStripeClient::StatusToString(status) != event.status) {
+            return std::nullopt;
+        }
+        return status;
+    }
+    if (event.type == "invoice.payment_failed") {
+        return event.attempt_count >= UNPAID_AFTER_ATTEMPTS ? SubscriptionStatus::UNPAID
+                                                            : SubscriptionStatus::PAST_DUE;
+    }
+    if (event.type == "invoice.paid" || event.type == "invoice.payment_succeeded") {
+        return SubscriptionStatus::ACTIVE;
+    }
+    return std::nullopt;
+}
+
+std::optional<int> StripeWebhookIngestor::ToStoredStatus(common::SubscriptionStatus status) {
+    switch (status) {
+        case common::SubscriptionStatus::TRIALING: return TRIALING;
+        case common::SubscriptionStatus::ACTIVE: return ACTIVE;
+        case common::SubscriptionStatus::PAST_DUE: return PAST_DUE;
+        case common::SubscriptionStatus::CANCELED: return CANCELED;
+        case common::SubscriptionStatus::UNPAID: return UNPAID;
+        default: return std::nullopt;
+    }
+}
+
+std::vector<SubscriptionTransition> StripeWebhookIngestor::ReduceTransitions(
+    const std::vector<StripeEvent>& events) {
+    std::vector<SubscriptionTransition> transitions;
+    std::unordered_map<std::string, size_t> index;
+    for (const auto& event : events) {
+        auto status = StatusFor(event);
+        auto stored = status ? ToStoredStatus(*status) : std::nullopt;
+        if (!stored) {
+            continue;
+        }
+        auto [it, added] = index.emplace(event.subscription_id, transitions.size());
+        if (added) {
+            transitions.push_back({event.subscription_id, *stored, event.created});
+            continue;
+        }
+        auto& transition = transitions[it->second];
+        if (event.created >= transition.event_at) {
+            transition.status = *stored;
+            transition.event_at = event.created;
+        }
+    }
+    return transitions;
+}
+
+} // namespace payment
+} // namespace saasforge
@@ -0,0 +1,160 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Unit tests for plan catalog snapshots and pricing
+ */
+
+#include <gtest/gtest.h>
+#include "payment/plan_catalog.h"
+#include <stdexcept>
+
+namespace saasforge {
+namespace payment {
+namespace test {
+
+namespace {
+
+PriceDefinition Recurring(int64_t micros) {
+    return {"", PricingModel::PER_UNIT, {{0, micros, 0}}};
+}
+
+} // namespace
+
+TEST(PlanCatalogSnapshotTest, FindsPlansById) {
+    PlanCatalogSnapshot snapshot(PlanCatalog::DefaultPlans(), 1);
+    ASSERT_EQ(snapshot.Size(), 3u);
+
+    const auto* starter = snapshot.Find("starter");
+    ASSERT_NE(starter, nullptr);
+    EXPECT_EQ(starter->plan_id, "starter");
+    EXPECT_EQ(snapshot.RecurringAmountMicros(*starter, 3), 87'000'000);
+    EXPECT_DOUBLE_EQ(PlanCatalogSnapshot::ToCurrency(
+        snapshot.RecurringAmountMicros(*snapshot.Find("enterprise"), 2)), 598.0);
+
+    EXPECT_EQ(snapshot.Find("Starter"), nullptr);
+    EXPECT_EQ(snapshot.Find(""), nullptr);
+    EXPECT_EQ(snapshot.Find("basic"), nullptr);
+}
+
+TEST(PlanCatalogSnapshotTest, IndexesManyPlans) {
+    std::vector<PlanDefinition> plans;
+    for (int i = 0; i < 1000; ++i) {
+        plans.push_back({"plan-" + std::to_string(i), {Recurring(i)}});
+    }
+    PlanCatalogSnapshot snapshot(plans, 1);
+    for (int i = 0; i < 1000; ++i) {
+        const auto* plan = snapshot.Find("plan-" + std::to_string(i));
+        ASSERT_NE(plan, nullptr);
+        EXPECT_EQ(snapshot.RecurringAmountMicros(*plan, 1), i);
+    }
+    EXPECT_EQ(snapshot.Find("plan-1000"), nullptr);
+}
+
+TEST(PlanCatalogSnapshotTest, PricesGraduatedAndVolumeTiers) {
+    std::vector<PriceTier> tiers = {{10, 5'000'000, 0}, {50, 4'000'000, 1'000'000}, {0, 3'000'000, 0}};
+    PlanCatalogSnapshot snapshot({
+        {"graduated", {{"", PricingModel::GRADUATED, tiers}}},
+        {"volume", {{"", PricingModel::VOLUME, tiers}}},
+    }, 1);
+    const auto& graduated = *snapshot.Find("graduated");
+    const auto& volume = *snapshot.Find("volume");
+
+    EXPECT_EQ(snapshot.RecurringAmountMicros(graduated, 0), 0);
+    EXPECT_EQ(snapshot.RecurringAmountMicros(graduated, 10), 50'000'000);
+    // 10 * 5 + (1 flat + 5 * 4)
+    EXPECT_EQ(snapshot.RecurringAmountMicros(graduated, 15), 71'000'000);
+    // 10 * 5 + (1 flat + 40 * 4) + 10 * 3
+    EXPECT_EQ(snapshot.RecurringAmountMicros(graduated, 60), 241'000'000);
+
+    EXPECT_EQ(snapshot.RecurringAmountMicros(volume, 10), 50'000'000);
+    EXPECT_EQ(snapshot.RecurringAmountMicros(volume, 11), 45'000'000);
+    EXPECT_EQ(snapshot.RecurringAmountMicros(volume, 60), 180'000'000);
+}
+
+TEST(PlanCatalogSnapshotTest, PricesMeteredUsage) {
+    // First 1000 calls included, then 0.0002 per call
+    PlanCatalogSnapshot snapshot({
+        {"pro", {Recurring(99'000'000), {"api_calls", PricingModel::GRADUATED, {{1000, 0, 0}, {0, 200, 0}}}}},
+    }, 1);
+    const auto& plan = *snapshot.Find("pro");
+
+    EXPECT_EQ(snapshot.UsageAmountMicros(plan, "api_calls", 1000), 0);
+    EXPECT_EQ(snapshot.UsageAmountMicros(plan, "api_calls", 6000), 1'000'000);
+    EXPECT_EQ(snapshot.UsageAmountMicros(plan, "storage_gb", 6000), 0);
+    EXPECT_THROW(snapshot.UsageAmountMicros(plan, "api_calls", std::numeric_limits<int64_t>::max()),
+                 std::overflow_error);
+}
+
+TEST(PlanCatalogSnapshotTest, RejectsInvalidCatalogs) {
+    using Plans = std::vector<PlanDefinition>;
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {Recurring(1)}}, {"a", {Recurring(2)}}}, 1), std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {}}}, 1), std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {Recurring(1), Recurring(2)}}}, 1), std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"", {Recurring(1)}}}, 1), std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {Recurring(-1)}}}, 1), std::invalid_argument);
+    // Bounded last tier, unbounded middle tier, descending bounds
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {{"", PricingModel::GRADUATED, {{10, 1, 0}}}}}}, 1),
+                 std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {{"", PricingModel::GRADUATED, {{0, 1, 0}, {0, 1, 0}}}}}}, 1),
+                 std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {{"", PricingModel::VOLUME, {{10, 1, 0}, {5, 1, 0}, {0, 1, 0}}}}}}, 1),
+                 std::invalid_argument);
+    EXPECT_THROW(PlanCatalogSnapshot(Plans{{"a", {{"", static_cast<PricingModel>(7), {{0, 1, 0}}}}}}, 1),
+                 std::invalid_argument);
+}
+
+TEST(PlanCatalogTest, SwapsSnapshotsOnRefresh) {
+    int64_t price = 10'000'000;
+    bool fail = false;
+    PlanCatalog catalog([&]() {
+        if (fail) {
+            throw std::runtime_error("database unavailable");
+        }
+        return std::vector<PlanDefinition>{{"team", {Recurring(price)}}};
+    });
+
+    auto first = catalog.Current();
+    ASSERT_NE(first->Find("team"), nullptr);
+    EXPECT_EQ(first->Find("starter"), nullptr);   // The source replaces the defaults
+
+    price = 12'000'000;
+    ASSERT_TRUE(catalog.Refresh());
+    auto second = catalog.Current();
+    EXPECT_GT(second->Version(), first->Version());
+    EXPECT_EQ(second->RecurringAmountMicros(*second->Find("team"), 1), 12'000'000);
+    // Readers holding the old snapshot keep pricing against it
+    EXPECT_EQ(first->RecurringAmountMicros(*first->Find("team"), 1), 10'000'000);
+
+    fail = true;
+    EXPECT_FALSE(catalog.Refresh());
+    EXPECT_EQ(catalog.Failures(), 1u);
+    EXPECT_EQ(catalog.Current(), second);
+    catalog.Shutdown();
+}
+
+TEST(PlanCatalogTest, KeepsPreviousSnapshotOnInvalidCatalog) {
+    bool invalid = false;
+    PlanCatalog catalog([&]() {
+        if (invalid) {
+            return std::vector<PlanDefinition>{{"team", {}}};
+        }
+        return std::vector<PlanDefinition>{{"team", {Recurring(1)}}};
+    });
+    auto before = catalog.Current();
+
+    invalid = true;
+    EXPECT_FALSE(catalog.Refresh());
+    EXPECT_EQ(catalog.Current(), before);
+}
+
+TEST(PlanCatalogTest, ServesDefaultsWithoutPlans) {
+    PlanCatalog empty([]() { return std::vector<PlanDefinition>{}; });
+    EXPECT_NE(empty.Current()->Find("professional"), nullptr);
+
+    PlanCatalog static_catalog(nullptr);
+    EXPECT_EQ(static_catalog.Current()->Size(), 3u);
+}
+
+} // namespace test
+} // namespace payment
+} // namespace saasforge
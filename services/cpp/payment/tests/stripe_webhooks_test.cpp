@@ -0,0 +1,371 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Unit tests for Stripe webhook verification, dedup and ordered processing
+ */
+
+#include <gtest/gtest.h>
+#include "payment/stripe_webhooks.h"
+#include "payment.pb.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace saasforge {
+namespace payment {
+namespace test {
+
+namespace {
+
+constexpr const char* SECRET = "whsec_test_secret";
+constexpr int64_t NOW = 1'763'000'000;
+
+std::string SubscriptionEvent(const std::string& id, const std::string& type, int64_t created,
+                              const std::string& customer, const std::string& subscription,
+                              const std::string& status) {
+    return "{\"id\":\"" + id + "\",\"object\":\"event\",\"type\":\"" + type + "\",\"created\":" +
+           std::to_string(created) + ",\"data\":{\"object\":{\"id\":\"" + subscription +
+           "\",\"object\":\"subscription\",\"customer\":\"" + customer + "\",\"status\":\"" + status + "\"}}}";
+}
+
+std::string InvoiceEvent(const std::string& id, const std::string& type, int64_t created,
+                         const std::string& customer, const std::string& subscription, int attempt_count) {
+    return "{\"id\":\"" + id + "\",\"object\":\"event\",\"type\":\"" + type + "\",\"created\":" +
+           std::to_string(created) + ",\"data\":{\"object\":{\"id\":\"in_" + id +
+           "\",\"object\":\"invoice\",\"customer\":{\"id\":\"" + customer + "\"},\"subscription\":\"" +
+           subscription + "\",\"attempt_count\":" + std::to_string(attempt_count) + "}}}";
+}
+
+StripeEvent Event(const std::string& type, int64_t created, const std::string& subscription,
+                  const std::string& status = "", int attempt_count = 0) {
+    StripeEvent event;
+    event.id = "evt_" + std::to_string(created) + type;
+    event.type = type;
+    event.created = created;
+    event.customer_id = "cus_1";
+    event.subscription_id = subscription;
+    event.status = status;
+    event.attempt_count = attempt_count;
+    return event;
+}
+
+/// stripe_events and subscriptions in memory, with the DbStripeEventStore rules
+class MemoryEventStore : public StripeEventStore {
+public:
+    struct Row {
+        int status = 0;
+        int64_t event_at = 0;
+        std::vector<int64_t> applied;   // event_at of every status written, in order
+    };
+
+    std::vector<bool> Insert(const std::vector<StripeEvent>& events) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++insert_calls;
+        if (fail_inserts > 0) {
+            --fail_inserts;
+            throw std::runtime_error("database unavailable");
+        }
+        std::vector<bool> inserted;
+        for (const auto& event : events) {
+            bool fresh = stored.emplace(event.id, event).second;
+            if (fresh && !StripeWebhookIngestor::StatusFor(event)) {
+                processed[event.id] = true;
+            } else if (fresh) {
+                processed.emplace(event.id, false);
+            }
+            inserted.push_back(fresh);
+        }
+        return inserted;
+    }
+
+    size_t Apply(const std::vector<SubscriptionTransition>& transitions,
+                 const std::vector<std::string>& event_ids) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fail_applies > 0) {
+            --fail_applies;
+            throw std::runtime_error("database unavailable");
+        }
+        size_t updated = 0;
+        for (const auto& transition : transitions) {
+            auto it = subscriptions.find(transition.subscription_id);
+            if (it == subscriptions.end() || it->second.event_at > transition.event_at) {
+                continue;
+            }
+            it->second.status = transition.status;
+            it->second.event_at = transition.event_at;
+            it->second.applied.push_back(transition.event_at);
+            ++updated;
+        }
+        for (const auto& id : event_ids) {
+            processed[id] = true;
+        }
+        return updated;
+    }
+
+    std::vector<StripeEvent> LoadPending(size_t limit) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<StripeEvent> events;
+        for (const auto& [id, done] : processed) {
+            if (!done && events.size() < limit) {
+                events.push_back(stored.at(id));
+            }
+        }
+        return events;
+    }
+
+    std::mutex mutex;
+    std::map<std::string, StripeEvent> stored;
+    std::map<std::string, bool> processed;
+    std::map<std::string, Row> subscriptions;
+    int fail_inserts = 0;
+    int fail_applies = 0;
+    int insert_calls = 0;
+};
+
+StripeWebhookOptions Options(size_t workers = 4) {
+    StripeWebhookOptions options;
+    options.workers = workers;
+    options.batch_size = 64;
+    return options;
+}
+
+} // namespace
+
+TEST(StripeWebhookSignatureTest, AcceptsOnlyFreshSignaturesForThePayload) {
+    common::WebhookSigningKey key(SECRET);
+    common::WebhookSigningKey other("whsec_other");
+    std::string payload = SubscriptionEvent("evt_1", "customer.subscription.updated", NOW, "cus_1", "sub_1", "active");
+    auto header = StripeWebhookIngestor::SignatureHeader(key, payload, NOW);
+    const std::chrono::seconds tolerance(300);
+
+    EXPECT_TRUE(StripeWebhookIngestor::VerifySignature(key, payload, header, NOW, tolerance));
+    EXPECT_TRUE(StripeWebhookIngestor::VerifySignature(key, payload, header, NOW + 300, tolerance));
+    EXPECT_FALSE(StripeWebhookIngestor::VerifySignature(key, payload, header, NOW + 301, tolerance));
+    EXPECT_FALSE(StripeWebhookIngestor::VerifySignature(key, payload + " ", header, NOW, tolerance));
+    EXPECT_FALSE(StripeWebhookIngestor::VerifySignature(other, payload, header, NOW, tolerance));
+
+    // Stripe sends one v1 per active secret while a secret is rolled
+    auto rolled = "t=" + std::to_string(NOW) + ",v1=" + std::string(64, '0') + "," +
+                  header.substr(header.find("v1=")) + ",v0=ignored";
+    EXPECT_TRUE(StripeWebhookIngestor::VerifySignature(key, payload, rolled, NOW, tolerance));
+
+    for (const char* bad : {"", "t=,v1=", "v1=abc", "t=abc,v1=abc", "garbage"}) {
+        EXPECT_FALSE(StripeWebhookIngestor::VerifySignature(key, payload, bad, NOW, tolerance)) << bad;
+    }
+}
+
+TEST(StripeWebhookParseTest, ReadsSubscriptionAndInvoiceEvents) {
+    auto subscription = StripeWebhookIngestor::ParseEvent(
+        SubscriptionEvent("evt_1", "customer.subscription.updated", NOW, "cus_1", "sub_1", "past_due"));
+    ASSERT_TRUE(subscription.has_value());
+    EXPECT_EQ(subscription->id, "evt_1");
+    EXPECT_EQ(subscription->created, NOW);
+    EXPECT_EQ(subscription->customer_id, "cus_1");
+    EXPECT_EQ(subscription->subscription_id, "sub_1");
+    EXPECT_EQ(subscription->status, "past_due");
+
+    // Expanded customer object
+    auto invoice = StripeWebhookIngestor::ParseEvent(
+        InvoiceEvent("evt_2", "invoice.payment_failed", NOW, "cus_2", "sub_2", 2));
+    ASSERT_TRUE(invoice.has_value());
+    EXPECT_EQ(invoice->customer_id, "cus_2");
+    EXPECT_EQ(invoice->subscription_id, "sub_2");
+    EXPECT_EQ(invoice->attempt_count, 2);
+
+    EXPECT_FALSE(StripeWebhookIngestor::ParseEvent("not json").has_value());
+    EXPECT_FALSE(StripeWebhookIngestor::ParseEvent("{\"id\":\"evt_1\",\"object\":\"customer\"}").has_value());
+    EXPECT_FALSE(StripeWebhookIngestor::ParseEvent(
+        "{\"id\":\"evt_1\",\"object\":\"event\",\"type\":\"x\"}").has_value());
+}
+
+TEST(StripeWebhookTransitionTest, MapsEventsLikeTheMockClient) {
+    using common::SubscriptionStatus;
+    EXPECT_EQ(StripeWebhookIngestor::StatusFor(Event("customer.subscription.updated", 1, "sub_1", "trialing")),
+              SubscriptionStatus::TRIALING);
+    EXPECT_EQ(StripeWebhookIngestor::StatusFor(Event("customer.subscription.deleted", 1, "sub_1", "active")),
+              SubscriptionStatus::CANCELED);
+    EXPECT_EQ(StripeWebhookIngestor::StatusFor(Event("invoice.payment_failed", 1, "sub_1", "", 1)),
+              SubscriptionStatus::PAST_DUE);
+    EXPECT_EQ(StripeWebhookIngestor::StatusFor(Event("invoice.payment_failed", 1, "sub_1", "", 3)),
+              SubscriptionStatus::UNPAID);
+    EXPECT_EQ(StripeWebhookIngestor::StatusFor(Event("invoice.paid", 1, "sub_1")), SubscriptionStatus::ACTIVE);
+
+    EXPECT_FALSE(StripeWebhookIngestor::StatusFor(Event("customer.subscription.updated", 1, "sub_1", "incomplete")));
+    EXPECT_FALSE(StripeWebhookIngestor::StatusFor(Event("invoice.paid", 1, "")));
+    EXPECT_FALSE(StripeWebhookIngestor::StatusFor(Event("customer.updated", 1, "sub_1")));
+
+    EXPECT_EQ(StripeWebhookIngestor::ToStoredStatus(SubscriptionStatus::PAST_DUE), PAST_DUE);
+    EXPECT_FALSE(StripeWebhookIngestor::ToStoredStatus(SubscriptionStatus::PAUSED));
+}
+
+TEST(StripeWebhookTransitionTest, KeepsTheNewestStatusPerSubscription) {
+    auto transitions = StripeWebhookIngestor::ReduceTransitions({
+        Event("invoice.payment_failed", 10, "sub_1", "", 1),
+        Event("customer.subscription.updated", 5, "sub_2", "trialing"),
+        Event("invoice.paid", 8, "sub_1"),                                   // Older: ignored
+        Event("customer.subscription.updated", 12, "sub_1", "paused"),        // Not stored
+        Event("customer.subscription.deleted", 5, "sub_2", "canceled"),       // Tie: later arrival wins
+        Event("customer.updated", 20, "sub_2"),
+    });
+    ASSERT_EQ(transitions.size(), 2u);
+    EXPECT_EQ(transitions[0].subscription_id, "sub_1");
+    EXPECT_EQ(transitions[0].status, PAST_DUE);
+    EXPECT_EQ(transitions[0].event_at, 10);
+    EXPECT_EQ(transitions[1].subscription_id, "sub_2");
+    EXPECT_EQ(transitions[1].status, CANCELED);
+}
+
+TEST(StripeWebhookIngestorTest, RequiresSecret) {
+    // An empty key would make any signature the caller computes valid
+    EXPECT_THROW(StripeWebhookIngestor(std::make_shared<MemoryEventStore>(), "", Options()),
+                 std::invalid_argument);
+}
+
+TEST(StripeWebhookIngestorTest, StoresOnceAndAppliesTransitions) {
+    auto store = std::make_shared<MemoryEventStore>();
+    store->subscriptions["sub_1"] = {ACTIVE, 0, {}};
+    StripeWebhookIngestor ingestor(store, SECRET, Options());
+    common::WebhookSigningKey key(SECRET);
+
+    auto failed = InvoiceEvent("evt_1", "invoice.payment_failed", NOW - 10, "cus_1", "sub_1", 1);
+    auto header = StripeWebhookIngestor::SignatureHeader(key, failed, NOW);
+    EXPECT_EQ(ingestor.Ingest(failed, header, NOW), WebhookResult::ACCEPTED);
+    EXPECT_EQ(ingestor.Ingest(failed, header, NOW), WebhookResult::DUPLICATE);
+    EXPECT_EQ(ingestor.Ingest(failed, "t=1,v1=00", NOW), WebhookResult::INVALID_SIGNATURE);
+    EXPECT_EQ(ingestor.Ingest("{}", StripeWebhookIngestor::SignatureHeader(key, "{}", NOW), NOW),
+              WebhookResult::INVALID_PAYLOAD);
+
+    // Stored already processed: no subscription status to change
+    auto other = "{\"id\":\"evt_2\",\"object\":\"event\",\"type\":\"customer.updated\",\"created\":1,"
+                 "\"data\":{\"object\":{\"id\":\"cus_1\",\"object\":\"customer\"}}}";
+    EXPECT_EQ(ingestor.Ingest(other, StripeWebhookIngestor::SignatureHeader(key, other, NOW), NOW),
+              WebhookResult::ACCEPTED);
+
+    ingestor.Drain();
+    EXPECT_EQ(store->subscriptions["sub_1"].status, PAST_DUE);
+    EXPECT_TRUE(store->processed["evt_1"]);
+    EXPECT_TRUE(store->processed["evt_2"]);
+
+    auto stats = ingestor.GetStats();
+    EXPECT_EQ(stats.received, 5u);
+    EXPECT_EQ(stats.rejected, 2u);
+    EXPECT_EQ(stats.duplicates, 1u);
+    EXPECT_EQ(stats.processed, 1u);
+    EXPECT_EQ(stats.transitions, 1u);
+    EXPECT_EQ(stats.queued, 0u);
+}
+
+TEST(StripeWebhookIngestorTest, KeepsEachCustomersOrderUnderConcurrency) {
+    constexpr int CUSTOMERS = 40;
+    constexpr int EVENTS_PER_CUSTOMER = 50;
+    auto store = std::make_shared<MemoryEventStore>();
+    for (int c = 0; c < CUSTOMERS; ++c) {
+        store->subscriptions["sub_" + std::to_string(c)] = {ACTIVE, 0, {}};
+    }
+    StripeWebhookIngestor ingestor(store, SECRET, Options(4));
+    common::WebhookSigningKey key(SECRET);
+
+    // One sender per customer, like Stripe's per-object delivery, all at once
+    std::vector<std::thread> senders;
+    std::atomic<int> accepted{0};
+    for (int c = 0; c < CUSTOMERS; ++c) {
+        senders.emplace_back([&, c] {
+            auto customer = "cus_" + std::to_string(c);
+            auto subscription = "sub_" + std::to_string(c);
+            for (int i = 1; i <= EVENTS_PER_CUSTOMER; ++i) {
+                auto status = i == EVENTS_PER_CUSTOMER ? "canceled" : (i % 2 ? "past_due" : "active");
+                auto payload = SubscriptionEvent("evt_" + std::to_string(c) + "_" + std::to_string(i),
+                                                 "customer.subscription.updated", NOW + i, customer,
+                                                 subscription, status);
+                if (ingestor.Ingest(payload, StripeWebhookIngestor::SignatureHeader(key, payload, NOW), NOW) ==
+                    WebhookResult::ACCEPTED) {
+                    ++accepted;
+                }
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    ingestor.Drain();
+
+    EXPECT_EQ(accepted.load(), CUSTOMERS * EVENTS_PER_CUSTOMER);
+    for (int c = 0; c < CUSTOMERS; ++c) {
+        const auto& row = store->subscriptions["sub_" + std::to_string(c)];
+        EXPECT_EQ(row.status, CANCELED);
+        EXPECT_TRUE(std::is_sorted(row.applied.begin(), row.applied.end()));
+    }
+    auto stats = ingestor.GetStats();
+    EXPECT_EQ(stats.processed, static_cast<uint64_t>(CUSTOMERS * EVENTS_PER_CUSTOMER));
+    EXPECT_LT(stats.insert_batches, stats.processed);   // Concurrent deliveries share inserts
+}
+
+TEST(StripeWebhookIngestorTest, RetriesFailedApplies) {
+    auto store = std::make_shared<MemoryEventStore>();
+    store->subscriptions["sub_1"] = {ACTIVE, 0, {}};
+    store->fail_applies = 2;
+    StripeWebhookIngestor ingestor(store, SECRET, Options(1));
+    common::WebhookSigningKey key(SECRET);
+
+    auto payload = SubscriptionEvent("evt_1", "customer.subscription.deleted", NOW, "cus_1", "sub_1", "canceled");
+    EXPECT_EQ(ingestor.Ingest(payload, StripeWebhookIngestor::SignatureHeader(key, payload, NOW), NOW),
+              WebhookResult::ACCEPTED);
+    ingestor.Drain();
+
+    EXPECT_EQ(store->subscriptions["sub_1"].status, CANCELED);
+    EXPECT_EQ(ingestor.GetStats().failed_batches, 2u);
+}
+
+TEST(StripeWebhookIngestorTest, ReportsUnstoredDeliveriesAsUnavailable) {
+    auto store = std::make_shared<MemoryEventStore>();
+    store->fail_inserts = 1;
+    StripeWebhookIngestor ingestor(store, SECRET, Options(1));
+    common::WebhookSigningKey key(SECRET);
+
+    auto payload = SubscriptionEvent("evt_1", "customer.subscription.updated", NOW, "cus_1", "sub_1", "active");
+    auto header = StripeWebhookIngestor::SignatureHeader(key, payload, NOW);
+    EXPECT_EQ(ingestor.Ingest(payload, header, NOW), WebhookResult::UNAVAILABLE);
+    EXPECT_EQ(ingestor.Ingest(payload, header, NOW), WebhookResult::ACCEPTED);   // Stripe's retry
+
+    ingestor.Shutdown();
+    EXPECT_EQ(ingestor.Ingest(payload, header, NOW), WebhookResult::UNAVAILABLE);
+}
+
+TEST(StripeWebhookIngestorTest, RecoversUnprocessedEventsAtStart) {
+    auto store = std::make_shared<MemoryEventStore>();
+    store->subscriptions["sub_1"] = {ACTIVE, 0, {}};
+    {
+        // Stored but never applied, e.g. the previous process was killed
+        auto event = StripeWebhookIngestor::ParseEvent(
+            InvoiceEvent("evt_1", "invoice.payment_failed", NOW, "cus_1", "sub_1", 3));
+        store->Insert({*event});
+    }
+    StripeWebhookIngestor ingestor(store, SECRET, Options(2));
+    ingestor.Drain();
+
+    EXPECT_EQ(store->subscriptions["sub_1"].status, UNPAID);
+    EXPECT_TRUE(store->processed["evt_1"]);
+}
+
+TEST(StripeWebhookIngestorTest, OlderEventsDoNotOverwriteNewerStatus) {
+    auto store = std::make_shared<MemoryEventStore>();
+    store->subscriptions["sub_1"] = {ACTIVE, 0, {}};
+    StripeWebhookIngestor ingestor(store, SECRET, Options(1));
+    common::WebhookSigningKey key(SECRET);
+
+    auto newer = SubscriptionEvent("evt_2", "customer.subscription.deleted", NOW, "cus_1", "sub_1", "canceled");
+    auto older = InvoiceEvent("evt_1", "invoice.paid", NOW - 60, "cus_1", "sub_1", 1);
+    ingestor.Ingest(newer, StripeWebhookIngestor::SignatureHeader(key, newer, NOW), NOW);
+    ingestor.Drain();
+    ingestor.Ingest(older, StripeWebhookIngestor::SignatureHeader(key, older, NOW), NOW);
+    ingestor.Drain();
+
+    EXPECT_EQ(store->subscriptions["sub_1"].status, CANCELED);
+    EXPECT_EQ(ingestor.GetStats().transitions, 1u);
+}
+
+} // namespace test
+} // namespace payment
+} // namespace saasforge
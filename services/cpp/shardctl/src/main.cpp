@@ -0,0 +1,82 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description saasforge_shardctl: inspect tenant placements and move tenants between shards
+ */
+
+#include "common/shard_mover.h"
+#include "common/logger.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace saasforge::common;
+
+namespace {
+
+void Usage(const char* program) {
+    std::cerr
+        << "Usage: " << program << " <command> [args]\n"
+        << "  shards                      List the configured shards\n"
+        << "  locate TENANT_ID...         Print the shard of each tenant\n"
+        << "  overrides                   Print every explicit placement (tenant_shards)\n"
+        << "  move TENANT_ID SHARD        Move a tenant online (or resume an interrupted move)\n"
+        << "  pin                         Record the current shard of every tenant; run before\n"
+        << "                              adding a shard to DB_SHARD_URLS\n"
+        << "Configured like the services: DATABASE_URL, DB_SHARD_URLS, DB_SHARD_MAP_*, DB_POOL_*\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        Usage(argv[0]);
+        return 2;
+    }
+    std::string command = argv[1];
+
+    const char* db_url_env = std::getenv("DATABASE_URL");
+    std::string db_url = db_url_env ? db_url_env : "postgresql://localhost/saasforge";
+
+    try {
+        auto options = ShardedDbPoolOptions::FromEnv(db_url);
+        options.pool.min_size = 1;
+        options.pool.max_size = 2;
+        ShardedDbPool pools(options);
+
+        if (command == "shards") {
+            for (const auto& shard : pools.Map().Shards()) {
+                std::cout << shard << (shard == pools.Map().Shards().front() ? "\tdirectory" : "") << "\n";
+            }
+        } else if (command == "locate" && argc >= 3) {
+            for (int i = 2; i < argc; ++i) {
+                auto placement = pools.Map().Locate(argv[i]);
+                bool hashed = placement.shard == pools.Map().HashShard(placement.tenant_id);
+                std::cout << placement.tenant_id << "\t" << placement.shard
+                          << (placement.moving ? "\tmoving" : "") << (hashed ? "" : "\toverride") << "\n";
+            }
+        } else if (command == "overrides") {
+            for (const auto& placement : pools.Map().Overrides()) {
+                std::cout << placement.tenant_id << "\t" << placement.shard
+                          << (placement.moving ? "\tmoving" : "") << "\n";
+            }
+        } else if (command == "move" && argc == 4) {
+            ShardMover mover(pools);
+            size_t rows = mover.Move(argv[2], argv[3]);
+            std::cout << "Moved " << argv[2] << " to " << argv[3] << " (" << rows << " rows)\n";
+        } else if (command == "pin") {
+            ShardMover mover(pools);
+            std::cout << "Pinned " << mover.PinAll() << " tenants\n";
+        } else {
+            Usage(argv[0]);
+            return 2;
+        }
+        pools.Shutdown(std::chrono::seconds(5));
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        Logger::Global().Flush();
+        return 1;
+    }
+    Logger::Global().Flush();
+    return 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description upload_objects rows as ObjectInfo, and object metadata as JSON
+ */
+
+#pragma once
+
+#include "upload.pb.h"
+#include <pqxx/pqxx>
+#include <string>
+
+namespace saasforge {
+namespace upload {
+
+/// SELECT / RETURNING list read by ObjectInfoFromRow()
+#define SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS                                          \
+    "id, filename, content_type, size, checksum, metadata::text AS metadata, "        \
+    "EXTRACT(EPOCH FROM created_at)::bigint AS created_at, "                          \
+    "EXTRACT(EPOCH FROM completed_at)::bigint AS completed_at"
+
+/// A row selected with SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS
+ObjectInfo ObjectInfoFromRow(const pqxx::row& row);
+
+/// JSON object for upload_objects.metadata (and for @> tag filters)
+std::string EncodeMetadata(const google::protobuf::Map<std::string, std::string>& metadata);
+
+/// Adds the string members of a JSON object; anything else is skipped
+void DecodeMetadata(const std::string& json, google::protobuf::Map<std::string, std::string>* metadata);
+
+} // namespace upload
+} // namespace saasforge
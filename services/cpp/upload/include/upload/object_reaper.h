@@ -0,0 +1,96 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Background purge of deleted objects' storage in batched S3 DeleteObjects calls
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace saasforge {
+namespace common {
+class Counter;
+class DbPool;
+class QuotaLedger;
+class S3MultipartClient;
+}
+
+namespace upload {
+
+/**
+ * ObjectReaper options
+ *
+ * FromEnv() reads UPLOAD_REAPER_INTERVAL_MS, UPLOAD_REAPER_BATCH_SIZE and
+ * UPLOAD_REAPER_LEASE_S.
+ */
+struct ObjectReaperOptions {
+    std::chrono::milliseconds interval{1000};  // Idle wait once a sweep finds less than a full batch
+    size_t batch_size = 1000;                  // Rows per claim; capped at one DeleteObjects request
+    std::chrono::seconds lease{300};           // A claimed batch not finished by then is claimed again
+
+    static ObjectReaperOptions FromEnv();
+};
+
+/**
+ * Frees the storage of deleted objects
+ *
+ * DeleteObject and DeleteObjects only tombstone rows, leaving the ones
+ * whose storage must go (standalone objects, and the last reference to a
+ * shared content) purge_pending. The reaper claims those in batches with
+ * FOR UPDATE SKIP LOCKED, so replicas split the backlog instead of
+ * contending for it, and a claim is a lease: rows of a replica that died
+ * mid-batch are picked up again once it expires. Each batch aborts the
+ * multipart uploads it finds unfinished, deletes every key with one S3
+ * DeleteObjects request, then returns the bytes to the QuotaLedger with
+ * one Release() and one Commit() per tenant.
+ *
+ * Keys S3 fails to delete stay claimed until the lease expires.
+ */
+class ObjectReaper {
+public:
+    ObjectReaper(std::shared_ptr<common::DbPool> db_pool,
+                 std::shared_ptr<common::S3MultipartClient> s3,
+                 std::shared_ptr<common::QuotaLedger> quota_ledger,
+                 const ObjectReaperOptions& options = {});
+    ~ObjectReaper();
+
+    ObjectReaper(const ObjectReaper&) = delete;
+    ObjectReaper& operator=(const ObjectReaper&) = delete;
+
+    /**
+     * Claim and purge one batch
+     *
+     * @return Rows claimed (a full batch means more may be waiting)
+     * @throws std::exception if claiming or finishing the batch fails
+     */
+    size_t RunOnce();
+
+    /// Stop the sweep thread after the batch in progress (idempotent)
+    void Shutdown();
+
+private:
+    void Loop();
+
+    std::shared_ptr<common::DbPool> db_pool_;
+    std::shared_ptr<common::S3MultipartClient> s3_;
+    std::shared_ptr<common::QuotaLedger> quota_ledger_;
+    ObjectReaperOptions options_;
+
+    common::Counter& purged_;
+    common::Counter& failed_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> shutdown_{false};
+    std::thread thread_;
+};
+
+} // namespace upload
+} // namespace saasforge
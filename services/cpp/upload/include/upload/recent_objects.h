@@ -0,0 +1,99 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-process cache of each tenant's most recently completed uploads
+ */
+
+#pragma once
+
+#include "upload.pb.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace saasforge {
+namespace common {
+class DbPool;
+}
+
+namespace upload {
+
+/**
+ * RecentObjectsCache options
+ *
+ * FromEnv() reads UPLOAD_RECENT_OBJECTS_DEPTH, UPLOAD_RECENT_OBJECTS_TTL_MS
+ * and UPLOAD_RECENT_OBJECTS_MAX_TENANTS.
+ */
+struct RecentObjectsCacheOptions {
+    size_t depth = 100;                  // Objects kept per tenant (the largest ListRecentObjects limit)
+    std::chrono::milliseconds ttl{5000}; // Staleness bound for uploads finished on other replicas
+    size_t max_tenants = 10000;
+
+    static RecentObjectsCacheOptions FromEnv();
+};
+
+/**
+ * Per-process view of each tenant's newest completed objects
+ *
+ * A tenant's `depth` most recently completed objects are loaded with one
+ * query (an idx_uploads_tenant_recent range scan) on first use and
+ * reloaded after `ttl`. Uploads completed and objects deleted on this
+ * replica are applied at once with Record() and Remove(), so the
+ * "just uploaded" view of the client that did it needs no query at all;
+ * the TTL bounds how late other replicas' changes show up.
+ *
+ * Usage:
+ *   RecentObjectsCache recent(db_pool, RecentObjectsCacheOptions::FromEnv());
+ *   for (const ObjectInfo& object : recent.Recent(tenant_id, 20)) { ... }
+ */
+class RecentObjectsCache {
+public:
+    /// Loads a tenant's newest `limit` completed objects, newest first
+    using Loader = std::function<std::vector<ObjectInfo>(const std::string& tenant_id, size_t limit)>;
+
+    RecentObjectsCache(std::shared_ptr<common::DbPool> db_pool, const RecentObjectsCacheOptions& options = {});
+
+    /// Custom source (tests)
+    explicit RecentObjectsCache(Loader loader, const RecentObjectsCacheOptions& options = {});
+
+    RecentObjectsCache(const RecentObjectsCache&) = delete;
+    RecentObjectsCache& operator=(const RecentObjectsCache&) = delete;
+
+    /**
+     * The tenant's newest min(limit, depth) completed objects, newest first
+     *
+     * @throws std::runtime_error if the tenant is not cached and loading fails
+     */
+    std::vector<ObjectInfo> Recent(const std::string& tenant_id, size_t limit);
+
+    /// Record an object this replica just completed (no-op if the tenant is not cached)
+    void Record(const std::string& tenant_id, const ObjectInfo& object);
+
+    /// Drop an object this replica just deleted
+    void Remove(const std::string& tenant_id, const std::string& object_id);
+
+    size_t TenantCount() const;
+
+private:
+    struct TenantEntry {
+        std::vector<ObjectInfo> objects;   // Newest first, at most depth
+        bool complete = false;             // The tenant has no older completed objects
+        std::chrono::steady_clock::time_point loaded_at;
+    };
+
+    Loader load_;
+    RecentObjectsCacheOptions options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, TenantEntry> tenants_;
+    // Bumped by every mutation; a load that raced one is used but not cached
+    uint64_t version_ = 0;
+};
+
+} // namespace upload
+} // namespace saasforge
@@ -0,0 +1,134 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Worker pool that streams objects from S3 through transform stages
+ */
+
+#pragma once
+
+#include "common/executor.h"
+#include "common/s3_multipart.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace upload {
+
+/**
+ * TransformEngine options
+ *
+ * FromEnv() reads TRANSFORM_WORKERS, TRANSFORM_QUEUE_CAPACITY and
+ * TRANSFORM_CHUNK_BYTES.
+ */
+struct TransformEngineOptions {
+    size_t workers = 0;                         // 0 = hardware concurrency
+    size_t queue_capacity = 64;                 // Jobs waiting for a worker
+    int64_t chunk_bytes = 8LL * 1024 * 1024;    // Size of each ranged GET
+    int64_t part_bytes = common::S3MultipartClient::MIN_PART_SIZE;  // Output buffered per part
+
+    static TransformEngineOptions FromEnv();
+};
+
+/**
+ * Object storage calls made by a job (S3 by default)
+ */
+struct TransformIo {
+    std::function<std::string(const std::string& key, int64_t offset, int64_t length)> get_range;
+    std::function<std::string(const std::string& key, const std::string& content_type)> create;
+    std::function<std::string(const std::string& key, const std::string& upload_id,
+                              int32_t part_number, const std::string& data)> upload_part;
+    std::function<std::string(const std::string& key, const std::string& upload_id,
+                              const std::vector<common::S3Part>& parts)> complete;
+    std::function<void(const std::string& key, const std::string& upload_id)> abort;
+
+    static TransformIo Default(std::shared_ptr<common::S3MultipartClient> s3);
+};
+
+struct TransformJob {
+    std::string job_id;
+    std::string source_key;
+    int64_t source_size = 0;
+    std::string profile_id;
+    std::string output_format;
+    std::string output_key;
+};
+
+struct TransformResult {
+    bool ok = false;
+    std::string error;
+    int64_t bytes_in = 0;
+    int64_t bytes_out = 0;
+    std::string content_type;
+    std::string etag;
+    std::string checksum_sha256;   // Of the output, hashed as parts are uploaded
+};
+
+struct TransformEngineStats {
+    uint64_t completed = 0;
+    uint64_t failed = 0;
+    size_t queued = 0;
+    size_t workers = 0;
+};
+
+/**
+ * Runs TransformObject jobs on a fixed pool of worker threads
+ *
+ * A job reads the source with ranged GETs of chunk_bytes, feeds each chunk
+ * through its TransformStage and uploads the output as multipart parts of
+ * part_bytes. Per job, memory is one input chunk, one output part and the
+ * stage's own state, independent of the object size; with one job per
+ * worker, total memory is bounded by workers x (chunk_bytes + part_bytes).
+ *
+ * Jobs are CPU-bound, so the pool defaults to one thread per core, and a
+ * full queue makes Submit() fail rather than queueing without bound. A job
+ * that fails aborts its multipart upload so no orphaned parts are billed.
+ *
+ * Usage:
+ *   TransformEngine engine(s3, TransformEngineOptions::FromEnv());
+ *   if (!engine.Submit(job, [](const TransformJob& job, const TransformResult& result) { ... })) {
+ *       ... RESOURCE_EXHAUSTED ...
+ *   }
+ */
+class TransformEngine {
+public:
+    using Callback = std::function<void(const TransformJob& job, const TransformResult& result)>;
+
+    TransformEngine(std::shared_ptr<common::S3MultipartClient> s3, const TransformEngineOptions& options = {});
+
+    /// Custom storage (tests)
+    TransformEngine(TransformIo io, const TransformEngineOptions& options = {});
+
+    ~TransformEngine();
+
+    TransformEngine(const TransformEngine&) = delete;
+    TransformEngine& operator=(const TransformEngine&) = delete;
+
+    /**
+     * Queue a job; done is called on the worker thread when it finishes
+     *
+     * @return False if the queue is full or the engine is shut down
+     */
+    bool Submit(TransformJob job, Callback done);
+
+    /// Run a job on the calling thread
+    TransformResult Run(const TransformJob& job) const;
+
+    /// Finish queued jobs and join the workers (idempotent)
+    void Shutdown();
+
+    TransformEngineStats GetStats() const;
+
+private:
+    TransformIo io_;
+    TransformEngineOptions options_;
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> failed_{0};
+    common::Executor executor_;   // Last: workers are joined before the rest is destroyed
+};
+
+} // namespace upload
+} // namespace saasforge
@@ -0,0 +1,124 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Streaming transform stages for TransformObject profiles
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace saasforge {
+namespace upload {
+
+/**
+ * One streaming transformation of an object
+ *
+ * Input arrives in arbitrary chunks through Consume() and output is handed to
+ * the sink as soon as it is produced, so a stage only holds the state it
+ * needs (a few rows of an image, a compressor window) regardless of the
+ * object size. Malformed input throws std::runtime_error.
+ */
+class TransformStage {
+public:
+    using Sink = std::function<void(const char* data, size_t size)>;
+
+    virtual ~TransformStage() = default;
+
+    virtual void Consume(const char* data, size_t size, const Sink& sink) = 0;
+
+    /// End of input: flush whatever is buffered
+    virtual void Finish(const Sink& sink) = 0;
+
+    virtual std::string ContentType() const = 0;
+
+    /// Suffix appended to the source key for the derivative, e.g. "gz"
+    virtual std::string Extension() const = 0;
+};
+
+/**
+ * Stage for a transform profile
+ *
+ * Profiles:
+ *   thumbnail, thumbnail-<N>  Downscale a binary PGM/PPM (P5/P6, 8-bit) so
+ *                             the longer side is at most N pixels (256)
+ *   gzip                      gzip-compress any object
+ *
+ * @param output_format Optional; must match the profile's format when set
+ * @throws std::invalid_argument for unknown profiles or formats
+ */
+std::unique_ptr<TransformStage> MakeTransformStage(const std::string& profile_id,
+                                                   const std::string& output_format = "");
+
+/**
+ * Box-filter downscale of binary PNM images, one output row at a time
+ *
+ * Each output pixel is the average of a factor x factor block. Input rows
+ * are summed into a row of 32-bit accumulators (a contiguous add the
+ * compiler vectorizes), and the accumulators are reduced horizontally once
+ * per output row, so memory is O(width) whatever the image height.
+ */
+class PnmResizeStage final : public TransformStage {
+public:
+    static constexpr int64_t MAX_WIDTH = 1 << 16;
+    static constexpr int64_t MAX_HEIGHT = 1 << 24;   // Keeps a column of block sums within 32 bits
+    static constexpr size_t MAX_HEADER_BYTES = 1024;
+
+    explicit PnmResizeStage(int32_t max_dimension);
+
+    void Consume(const char* data, size_t size, const Sink& sink) override;
+    void Finish(const Sink& sink) override;
+    std::string ContentType() const override;
+    std::string Extension() const override;
+
+private:
+    bool ParseHeader(const Sink& sink);
+    void ConsumeRows(const char* data, size_t size, const Sink& sink);
+    void AddRow(const uint8_t* row, const Sink& sink);
+    void EmitRow(const Sink& sink);
+
+    int32_t max_dimension_;
+    std::string pending_;          // Header bytes or a partial input row
+    bool header_done_ = false;
+    int64_t width_ = 0;
+    int64_t height_ = 0;
+    int64_t channels_ = 1;
+    int64_t max_value_ = 255;
+    int64_t factor_ = 1;
+    int64_t out_width_ = 0;
+    int64_t rows_read_ = 0;
+    int64_t rows_summed_ = 0;      // Input rows in sums_
+    std::vector<uint32_t> sums_;   // Per input sample, over the current block of rows
+    std::string out_row_;
+};
+
+/**
+ * gzip compression (zlib, default level)
+ */
+class GzipStage final : public TransformStage {
+public:
+    GzipStage();
+    ~GzipStage() override;
+
+    GzipStage(const GzipStage&) = delete;
+    GzipStage& operator=(const GzipStage&) = delete;
+
+    void Consume(const char* data, size_t size, const Sink& sink) override;
+    void Finish(const Sink& sink) override;
+    std::string ContentType() const override { return "application/gzip"; }
+    std::string Extension() const override { return "gz"; }
+
+private:
+    void Deflate(const char* data, size_t size, int flush, const Sink& sink);
+
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+} // namespace upload
+} // namespace saasforge
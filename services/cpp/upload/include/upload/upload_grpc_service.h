@@ -0,0 +1,72 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Sync and callback gRPC registrations for UploadServiceImpl
+ */
+
+#pragma once
+
+#include <memory>
+#include "upload.grpc.pb.h"
+#include "upload/upload_service.h"
+#include "common/arena_allocator.h"
+#include "common/executor.h"
+#include "common/service_adapter.h"
+
+// Single list of UploadService RPCs; keep in sync with proto/upload.proto
+#define SAASFORGE_UPLOAD_RPCS(X) \
+    X(GeneratePresignedUrl, PresignedUrlRequest, PresignedUrlResponse) \
+    X(CompleteUpload, CompleteUploadRequest, CompleteUploadResponse) \
+    X(TransformObject, TransformRequest, TransformResponse) \
+    X(DeleteObject, DeleteObjectRequest, DeleteObjectResponse) \
+    X(DeleteObjects, DeleteObjectsRequest, DeleteObjectsResponse) \
+    X(GetQuota, GetQuotaRequest, GetQuotaResponse) \
+    X(InitiateMultipartUpload, InitiateMultipartUploadRequest, InitiateMultipartUploadResponse) \
+    X(PresignParts, PresignPartsRequest, PresignPartsResponse) \
+    X(CompleteMultipartUpload, CompleteMultipartUploadRequest, CompleteMultipartUploadResponse) \
+    X(ListUploadedParts, ListUploadedPartsRequest, ListUploadedPartsResponse) \
+    X(ListRecentObjects, ListRecentObjectsRequest, ListRecentObjectsResponse)
+
+#define SAASFORGE_UPLOAD_SERVER_STREAM_RPCS(X) \
+    X(ListObjects, ListObjectsRequest, ObjectInfo)
+
+namespace saasforge {
+namespace upload {
+
+/**
+ * Registers UploadServiceImpl on the synchronous API (handlers on gRPC threads)
+ */
+class UploadServiceSync final : public UploadService::Service {
+public:
+    explicit UploadServiceSync(std::shared_ptr<UploadServiceImpl> impl) : impl_(std::move(impl)) {}
+
+    SAASFORGE_UPLOAD_RPCS(SAASFORGE_SYNC_UNARY_METHOD)
+    SAASFORGE_UPLOAD_SERVER_STREAM_RPCS(SAASFORGE_SYNC_SERVER_STREAM_METHOD)
+
+private:
+    std::shared_ptr<UploadServiceImpl> impl_;
+};
+
+/**
+ * Registers UploadServiceImpl on the callback API; handlers run on a bounded Executor
+ *
+ * Unary requests and responses are allocated on one protobuf arena per RPC.
+ */
+class UploadServiceCallback final : public UploadService::CallbackService {
+public:
+    UploadServiceCallback(std::shared_ptr<UploadServiceImpl> impl, std::shared_ptr<common::Executor> executor)
+        : impl_(std::move(impl)), executor_(std::move(executor)), arenas_(UploadService::service_full_name()) {
+        SAASFORGE_UPLOAD_RPCS(SAASFORGE_CALLBACK_ARENA_ALLOCATOR)
+    }
+
+    SAASFORGE_UPLOAD_RPCS(SAASFORGE_CALLBACK_UNARY_METHOD)
+    SAASFORGE_UPLOAD_SERVER_STREAM_RPCS(SAASFORGE_CALLBACK_SERVER_STREAM_METHOD)
+
+private:
+    std::shared_ptr<UploadServiceImpl> impl_;
+    std::shared_ptr<common::Executor> executor_;
+    common::ArenaAllocators arenas_;
+};
+
+} // namespace upload
+} // namespace saasforge
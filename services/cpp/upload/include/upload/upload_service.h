@@ -5,59 +5,150 @@
 #include "upload.grpc.pb.h"
 #include "common/redis_client.h"
 #include "common/db_pool.h"
+#include "common/entity_cache.h"
+#include "common/quota_ledger.h"
+#include "common/s3_multipart.h"
+#include "common/s3_presigner.h"
+#include "common/service_adapter.h"
+#include "common/tenant_context.h"
+#include "upload/recent_objects.h"
+#include "upload/transform_engine.h"
 
 namespace saasforge {
 namespace upload {
 
-class UploadServiceImpl final : public ::saasforge::upload::UploadService::Service {
+/// GetQuota answers by tenant_id, invalidated when QuotaLedger flushes the tenant's used_bytes
+using QuotaCache = common::EntityCache<std::string, GetQuotaResponse>;
+
+/**
+ * UploadService RPC handlers
+ *
+ * Handlers take grpc::ServerContextBase so the same implementation serves
+ * both the sync and the callback server (see upload_grpc_service.h).
+ */
+class UploadServiceImpl final {
 public:
     UploadServiceImpl(
         std::shared_ptr<common::RedisClient> redis_client,
         std::shared_ptr<common::DbPool> db_pool,
-        const std::string& s3_bucket,
-        const std::string& s3_region
+        std::shared_ptr<common::S3Presigner> presigner,
+        std::shared_ptr<common::QuotaLedger> quota_ledger,
+        std::shared_ptr<common::S3MultipartClient> multipart = nullptr,
+        std::shared_ptr<TransformEngine> transform_engine = nullptr,
+        std::shared_ptr<RecentObjectsCache> recent_objects = nullptr,
+        std::shared_ptr<QuotaCache> quota_cache = nullptr
     );
 
     grpc::Status GeneratePresignedUrl(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const PresignedUrlRequest* request,
         PresignedUrlResponse* response
-    ) override;
+    );
 
     grpc::Status CompleteUpload(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const CompleteUploadRequest* request,
         CompleteUploadResponse* response
-    ) override;
+    );
 
     grpc::Status TransformObject(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const TransformRequest* request,
         TransformResponse* response
-    ) override;
+    );
 
     grpc::Status DeleteObject(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const DeleteObjectRequest* request,
         DeleteObjectResponse* response
-    ) override;
+    );
+
+    /**
+     * Tombstone up to 10000 objects in one transaction
+     *
+     * Like DeleteObject, this only marks rows: ObjectReaper deletes their
+     * storage in batched S3 DeleteObjects calls and returns the bytes to
+     * the tenant's quota afterwards.
+     */
+    grpc::Status DeleteObjects(
+        grpc::ServerContextBase* context,
+        const DeleteObjectsRequest* request,
+        DeleteObjectsResponse* response
+    );
 
     grpc::Status GetQuota(
-        grpc::ServerContext* context,
+        grpc::ServerContextBase* context,
         const GetQuotaRequest* request,
         GetQuotaResponse* response
-    ) override;
+    );
+
+    grpc::Status InitiateMultipartUpload(
+        grpc::ServerContextBase* context,
+        const InitiateMultipartUploadRequest* request,
+        InitiateMultipartUploadResponse* response
+    );
+
+    grpc::Status PresignParts(
+        grpc::ServerContextBase* context,
+        const PresignPartsRequest* request,
+        PresignPartsResponse* response
+    );
+
+    grpc::Status CompleteMultipartUpload(
+        grpc::ServerContextBase* context,
+        const CompleteMultipartUploadRequest* request,
+        CompleteMultipartUploadResponse* response
+    );
+
+    grpc::Status ListUploadedParts(
+        grpc::ServerContextBase* context,
+        const ListUploadedPartsRequest* request,
+        ListUploadedPartsResponse* response
+    );
+
+    /**
+     * Stream one page of the tenant's completed objects, by filename
+     *
+     * Keyset pagination on (filename, id) over idx_uploads_tenant_filename:
+     * each object carries the cursor the next page starts after, so every
+     * page is one index range scan however deep the listing is. prefix
+     * narrows the range; tags are matched against the metadata given at
+     * upload (containment, idx_uploads_metadata). Rows are read with COPY
+     * and written in chunks as they arrive.
+     */
+    grpc::Status ListObjects(
+        grpc::ServerContextBase* context,
+        const ListObjectsRequest* request,
+        common::StreamWriter<ObjectInfo>& writer
+    );
+
+    /// Newest completed objects, served from RecentObjectsCache
+    grpc::Status ListRecentObjects(
+        grpc::ServerContextBase* context,
+        const ListRecentObjectsRequest* request,
+        ListRecentObjectsResponse* response
+    );
 
 private:
     std::shared_ptr<common::RedisClient> redis_client_;
     std::shared_ptr<common::DbPool> db_pool_;
-    std::string s3_bucket_;
-    std::string s3_region_;
+    std::shared_ptr<common::S3Presigner> presigner_;
+    std::shared_ptr<common::QuotaLedger> quota_ledger_;
+    std::shared_ptr<common::S3MultipartClient> multipart_;
+    std::shared_ptr<TransformEngine> transform_engine_;
+    std::shared_ptr<RecentObjectsCache> recent_objects_;
+    std::shared_ptr<QuotaCache> quota_cache_;
 
     // Helper methods
-    std::string GenerateMockPresignedUrl(const std::string& key, int64_t expires_in);
-    bool CheckQuota(const std::string& tenant_id, int64_t file_size);
-    void UpdateQuota(const std::string& tenant_id, int64_t file_size);
+    std::string BuildObjectKey(const common::TenantContext& tenant_ctx, const std::string& object_id,
+                               const std::string& filename) const;
+
+    /// Commit a completed object with its upload.completed event; then replicas' reads and recent objects include it
+    void CommitCompleted(pqxx::work& txn, const std::string& tenant_id, const pqxx::row& row);
+
+    /// Record a finished transform job (runs on a transform worker)
+    void FinishTransform(const common::TenantContext& tenant_ctx, const std::string& filename,
+                         int64_t reserved, const TransformJob& job, const TransformResult& result);
 };
 
 } // namespace upload
@@ -3,9 +3,24 @@
 #include <string>
 #include <grpcpp/grpcpp.h>
 #include "upload/upload_service.h"
+#include "upload/upload_grpc_service.h"
+#include "upload/object_reaper.h"
+#include "common/server_options.h"
 #include "common/mtls_credentials.h"
 #include "common/redis_client.h"
 #include "common/db_pool.h"
+#include "common/entity_cache.h"
+#include "common/event_bus.h"
+#include "common/allocator_stats.h"
+#include "common/metrics_server.h"
+#include "common/server_interceptors.h"
+#include "common/warmup.h"
+#include "common/graceful_shutdown.h"
+#include "common/logger.h"
+#include "common/tracing.h"
+#include "common/quota_ledger.h"
+#include "common/s3_multipart.h"
+#include "common/s3_presigner.h"
 
 using grpc::Server;
 using grpc::ServerBuilder;
@@ -16,20 +31,39 @@ void RunServer() {
     // Load configuration
     const char* redis_url_env = std::getenv("REDIS_URL");
     const char* db_url_env = std::getenv("DATABASE_URL");
-    const char* s3_bucket_env = std::getenv("S3_BUCKET");
-    const char* s3_region_env = std::getenv("S3_REGION");
 
     std::string redis_url = redis_url_env ? redis_url_env : "tcp://127.0.0.1:6379";
     std::string db_url = db_url_env ? db_url_env : "postgresql://localhost/saasforge";
-    std::string s3_bucket = s3_bucket_env ? s3_bucket_env : "saasforge-uploads";
-    std::string s3_region = s3_region_env ? s3_region_env : "us-east-1";
 
     // Initialize Redis and DB
-    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url);
-    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, 10);
+    auto redis_client = std::make_shared<saasforge::common::RedisClient>(redis_url, saasforge::common::RedisOptions::FromEnv());
+    auto db_pool = std::make_shared<saasforge::common::DbPool>(db_url, saasforge::common::DbPoolOptions::FromEnv());
 
-    saasforge::upload::UploadServiceImpl service(redis_client, db_pool, s3_bucket, s3_region);
+    auto presigner = std::make_shared<saasforge::common::S3Presigner>(saasforge::common::S3PresignerOptions::FromEnv());
 
+    auto quota_ledger = std::make_shared<saasforge::common::QuotaLedger>(
+        redis_client, db_pool, saasforge::common::QuotaLedgerOptions::FromEnv());
+
+    auto multipart = std::make_shared<saasforge::common::S3MultipartClient>(presigner);
+
+    // Events between services on Redis Streams (EVENT_BUS_*)
+    auto event_bus = std::make_shared<saasforge::common::EventBus>(
+        redis_client, saasforge::common::EventBusOptions::FromEnv());
+
+    // GetQuota reads: local LRU over Redis, invalidated on the event bus (ENTITY_CACHE_*)
+    auto quota_cache = std::make_shared<saasforge::upload::QuotaCache>(
+        "quota", saasforge::common::EntityCacheStore::From(redis_client), event_bus,
+        saasforge::common::EntityCacheOptions::FromEnv());
+
+    auto service = std::make_shared<saasforge::upload::UploadServiceImpl>(
+        redis_client, db_pool, presigner, quota_ledger, multipart, nullptr, nullptr, quota_cache);
+
+    // Deletes only tombstone rows; storage and quota are freed here in batches
+    auto object_reaper = std::make_shared<saasforge::upload::ObjectReaper>(
+        db_pool, multipart, quota_ledger, saasforge::upload::ObjectReaperOptions::FromEnv());
+
+    // grpc.health.v1.Health: NOT_SERVING until warm-up completes (below)
+    grpc::EnableDefaultHealthCheckService(true);
     ServerBuilder builder;
 
     // Setup mTLS
@@ -53,12 +87,70 @@ void RunServer() {
         builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     }
 
-    builder.RegisterService(&service);
+    // Threading model: sync, or callback API with a bounded executor (GRPC_SERVER_MODE)
+    auto server_options = saasforge::common::ServerOptions::FromEnv();
+    server_options.ApplyTo(builder);
+
+    // Tracing (traceparent in, OTLP out), per-method metrics, and the tenant context
+    // parsed once per RPC (every method needs a tenant or user)
+    saasforge::common::AddServerInterceptors(builder);
+
+    std::shared_ptr<saasforge::common::Executor> executor;
+    auto grpc_service = saasforge::common::MakeService<
+        saasforge::upload::UploadServiceSync,
+        saasforge::upload::UploadServiceCallback
+    >(server_options, service, executor);
+    builder.RegisterService(grpc_service.get());
+    std::cout << "Server mode: " << server_options.Describe() << std::endl;
 
     std::unique_ptr<Server> server(builder.BuildAndStart());
     std::cout << "Upload Service listening on " << server_address << std::endl;
 
-    server->Wait();
+    // Prometheus scrape endpoint (METRICS_PORT, 0 = disabled)
+    auto metrics_options = saasforge::common::MetricsServerOptions::FromEnv();
+    std::unique_ptr<saasforge::common::MetricsServer> metrics_server;
+    if (metrics_options.port != 0) {
+        saasforge::common::ExportAllocatorMetrics(saasforge::common::MetricsRegistry::Global());
+        metrics_server = std::make_unique<saasforge::common::MetricsServer>(
+            saasforge::common::MetricsRegistry::Global(), metrics_options);
+        std::cout << "Metrics available on :" << metrics_server->Port() << "/metrics" << std::endl;
+        if (!metrics_options.profiling.token.empty()) {
+            auto& profiler = saasforge::common::Profiler::Default();
+            std::cout << "Profiling available on :" << metrics_server->Port() << "/debug/pprof/ (cpu: "
+                      << (profiler.CpuAvailable() ? profiler.CpuBackend() : "none") << ", heap: "
+                      << (profiler.HeapAvailable() ? profiler.HeapBackend() : "none") << ")" << std::endl;
+        }
+    }
+
+    // SIGTERM (rolling deploy): drain in-flight RPCs, then flush and close in dependency order
+    saasforge::common::GracefulShutdown shutdown(saasforge::common::ShutdownOptions::FromEnv());
+    shutdown.Add("executor", [&executor] {
+        if (executor) {
+            executor->Shutdown();
+        }
+    });
+    shutdown.Add("object_reaper", [&object_reaper] { object_reaper->Shutdown(); });
+    shutdown.Add("quota_ledger", [&quota_ledger] { quota_ledger->Shutdown(); });
+    shutdown.Add("event_bus", [&event_bus] { event_bus->Shutdown(); });
+    shutdown.Add("database", [&db_pool, &shutdown] { db_pool->Shutdown(shutdown.Options().close_timeout); });
+    shutdown.Add("metrics", [&metrics_server] {
+        if (metrics_server) {
+            metrics_server->Shutdown();
+        }
+    });
+    shutdown.Add("tracing", [] { saasforge::common::Tracer::Global().Shutdown(); });
+
+    // Connections open and caches primed before readiness probes see SERVING
+    saasforge::common::Warmup warmup(saasforge::common::WarmupOptions::FromEnv());
+    warmup.Add("database", saasforge::common::Warmup::PingDatabase(db_pool), true);
+    warmup.Add("redis", saasforge::common::Warmup::ConnectRedis(redis_client), true);
+    if (!warmup.Run(server->GetHealthCheckService())) {
+        throw std::runtime_error("Warm-up failed");
+    }
+
+    shutdown.Wait();
+    shutdown.Run(server.get(), server->GetHealthCheckService());
+    saasforge::common::Logger::Global().Flush();
 }
 
 int main(int argc, char** argv) {
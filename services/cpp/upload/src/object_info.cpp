@@ -0,0 +1,55 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description upload_objects rows as ObjectInfo, and object metadata as JSON implementation
+ */
+
+#include "upload/object_info.h"
+#include <picojson/picojson.h>
+
+namespace saasforge {
+namespace upload {
+
+ObjectInfo ObjectInfoFromRow(const pqxx::row& row) {
+    ObjectInfo object;
+    object.set_object_id(row["id"].as<std::string>());
+    object.set_filename(row["filename"].as<std::string>());
+    if (!row["content_type"].is_null()) {
+        object.set_content_type(row["content_type"].as<std::string>());
+    }
+    object.set_size(row["size"].as<long long>());
+    if (!row["checksum"].is_null()) {
+        object.set_checksum_sha256(row["checksum"].as<std::string>());
+    }
+    if (!row["metadata"].is_null()) {
+        DecodeMetadata(row["metadata"].as<std::string>(), object.mutable_metadata());
+    }
+    object.set_created_at(row["created_at"].as<long long>());
+    if (!row["completed_at"].is_null()) {
+        object.set_completed_at(row["completed_at"].as<long long>());
+    }
+    return object;
+}
+
+std::string EncodeMetadata(const google::protobuf::Map<std::string, std::string>& metadata) {
+    picojson::object object;
+    for (const auto& [key, value] : metadata) {
+        object.emplace(key, picojson::value(value));
+    }
+    return picojson::value(object).serialize();
+}
+
+void DecodeMetadata(const std::string& json, google::protobuf::Map<std::string, std::string>* metadata) {
+    picojson::value value;
+    if (!picojson::parse(value, json).empty() || !value.is<picojson::object>()) {
+        return;
+    }
+    for (const auto& [key, member] : value.get<picojson::object>()) {
+        if (member.is<std::string>()) {
+            (*metadata)[key] = member.get<std::string>();
+        }
+    }
+}
+
+} // namespace upload
+} // namespace saasforge
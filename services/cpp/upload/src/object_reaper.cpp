@@ -0,0 +1,201 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Background purge of deleted objects' storage in batched S3 DeleteObjects calls implementation
+ */
+
+#include "upload/object_reaper.h"
+#include "common/db_pool.h"
+#include "common/env.h"
+#include "common/logger.h"
+#include "common/metrics.h"
+#include "common/quota_ledger.h"
+#include "common/s3_multipart.h"
+#include "common/statement_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace saasforge {
+namespace upload {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry); idx_uploads_purge_pending
+const common::PreparedStatement kClaimPurges(
+    "upload_claim_purges",
+    "UPDATE upload_objects SET purge_claimed_at = NOW() "
+    "WHERE id IN ("
+    "    SELECT id FROM upload_objects "
+    "    WHERE purge_pending "
+    "    AND (purge_claimed_at IS NULL OR purge_claimed_at < NOW() - $2 * INTERVAL '1 second') "
+    "    ORDER BY deleted_at LIMIT $1 FOR UPDATE SKIP LOCKED) "
+    "RETURNING id, object_key, status, multipart_upload_id");
+
+const common::PreparedStatement kFinishPurges(
+    "upload_finish_purges",
+    "UPDATE upload_objects SET purge_pending = FALSE, purged_at = NOW() "
+    "WHERE id = ANY($1::uuid[]) AND purge_pending "
+    "RETURNING tenant_id, size, status");
+
+common::Counter& PurgeCounter(const char* result) {
+    return common::MetricsRegistry::Global().GetCounter(
+        "saasforge_upload_reaper_objects_total", "Deleted objects whose storage the reaper purged, by result",
+        {{"result", result}});
+}
+
+} // namespace
+
+ObjectReaperOptions ObjectReaperOptions::FromEnv() {
+    ObjectReaperOptions options;
+    options.interval = std::chrono::milliseconds(
+        common::EnvInt("UPLOAD_REAPER_INTERVAL_MS", static_cast<long>(options.interval.count())));
+    options.batch_size = static_cast<size_t>(
+        common::EnvInt("UPLOAD_REAPER_BATCH_SIZE", static_cast<long>(options.batch_size)));
+    options.lease =
+        std::chrono::seconds(common::EnvInt("UPLOAD_REAPER_LEASE_S", static_cast<long>(options.lease.count())));
+    return options;
+}
+
+ObjectReaper::ObjectReaper(std::shared_ptr<common::DbPool> db_pool,
+                           std::shared_ptr<common::S3MultipartClient> s3,
+                           std::shared_ptr<common::QuotaLedger> quota_ledger,
+                           const ObjectReaperOptions& options)
+    : db_pool_(std::move(db_pool)),
+      s3_(std::move(s3)),
+      quota_ledger_(std::move(quota_ledger)),
+      options_(options),
+      purged_(PurgeCounter("purged")),
+      failed_(PurgeCounter("failed")) {
+    options_.batch_size = std::clamp<size_t>(options_.batch_size, 1, common::S3MultipartClient::MAX_DELETE_KEYS);
+    thread_ = std::thread(&ObjectReaper::Loop, this);
+}
+
+ObjectReaper::~ObjectReaper() {
+    Shutdown();
+}
+
+void ObjectReaper::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_.exchange(true)) {
+            return;
+        }
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+size_t ObjectReaper::RunOnce() {
+    // Claim in its own transaction: the row locks end here, the lease does not
+    pqxx::result claimed;
+    {
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
+        claimed = common::ExecPrepared(txn, kClaimPurges, static_cast<long long>(options_.batch_size),
+                                       static_cast<long long>(options_.lease.count()));
+        txn.commit();
+    }
+    if (claimed.empty()) {
+        return 0;
+    }
+
+    std::vector<std::string> keys;
+    std::set<std::string> seen;
+    for (const auto& row : claimed) {
+        std::string key = row["object_key"].as<std::string>();
+        // Parts of an abandoned multipart upload; S3 lifecycle rules catch any that fail here
+        if (row["status"].as<std::string>() != "completed" && !row["multipart_upload_id"].is_null()) {
+            try {
+                s3_->Abort(key, row["multipart_upload_id"].as<std::string>());
+            } catch (const std::exception& e) {
+                common::LogError("Multipart abort failed", {{"object_id", row["id"].as<std::string>()},
+                                                            {"error", e.what()}});
+            }
+        }
+        if (seen.insert(key).second) {
+            keys.push_back(std::move(key));
+        }
+    }
+
+    std::unordered_set<std::string> failed_keys;
+    try {
+        for (const auto& error : s3_->DeleteObjects(keys)) {
+            common::LogError("S3 delete failed", {{"key", error.key}, {"code", error.code}});
+            failed_keys.insert(error.key);
+        }
+    } catch (const std::exception&) {
+        failed_.Increment(claimed.size());
+        throw;  // Retried when the lease expires; Loop() backs off
+    }
+
+    std::vector<std::string> purged_ids;
+    purged_ids.reserve(claimed.size());
+    for (const auto& row : claimed) {
+        if (!failed_keys.count(row["object_key"].as<std::string>())) {
+            purged_ids.push_back(row["id"].as<std::string>());
+        }
+    }
+    failed_.Increment(claimed.size() - purged_ids.size());
+    if (purged_ids.empty()) {
+        return claimed.size();
+    }
+
+    pqxx::result finished;
+    {
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
+        finished = common::ExecPrepared(txn, kFinishPurges, common::ToArrayLiteral(purged_ids));
+        txn.commit();
+    }
+    purged_.Increment(finished.size());
+
+    // One quota delta per tenant per batch; only completed objects were counted in quotas.used_bytes
+    struct TenantBytes {
+        int64_t held = 0;
+        int64_t stored = 0;
+    };
+    std::map<std::string, TenantBytes> tenants;
+    for (const auto& row : finished) {
+        auto& bytes = tenants[row["tenant_id"].as<std::string>()];
+        int64_t size = row["size"].as<long long>();
+        bytes.held += size;
+        if (row["status"].as<std::string>() == "completed") {
+            bytes.stored += size;
+        }
+    }
+    for (const auto& [tenant_id, bytes] : tenants) {
+        if (bytes.held > 0) {
+            quota_ledger_->Release(tenant_id, bytes.held);
+        }
+        if (bytes.stored > 0) {
+            quota_ledger_->Commit(tenant_id, -bytes.stored);
+        }
+    }
+    return claimed.size();
+}
+
+void ObjectReaper::Loop() {
+    while (!shutdown_.load()) {
+        size_t claimed = 0;
+        try {
+            claimed = RunOnce();
+        } catch (const std::exception& e) {
+            common::LogError("Object purge failed", {{"error", e.what()}});
+        }
+        // A full batch means a backlog (tenant offboarding): keep going without waiting
+        if (claimed < options_.batch_size) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, options_.interval, [this] { return shutdown_.load(); });
+        }
+    }
+}
+
+} // namespace upload
+} // namespace saasforge
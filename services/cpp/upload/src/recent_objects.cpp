@@ -0,0 +1,143 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description In-process cache of each tenant's most recently completed uploads implementation
+ */
+
+#include "upload/recent_objects.h"
+#include "upload/object_info.h"
+#include "common/db_pool.h"
+#include "common/env.h"
+#include "common/statement_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+namespace saasforge {
+namespace upload {
+
+namespace {
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry); idx_uploads_tenant_recent
+const common::PreparedStatement kSelectRecentObjects(
+    "upload_select_recent_objects",
+    "SELECT " SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS " FROM upload_objects "
+    "WHERE tenant_id = $1 AND status = 'completed' AND deleted_at IS NULL "
+    "ORDER BY completed_at DESC, id DESC LIMIT $2");
+
+} // namespace
+
+RecentObjectsCacheOptions RecentObjectsCacheOptions::FromEnv() {
+    RecentObjectsCacheOptions options;
+    options.depth =
+        static_cast<size_t>(common::EnvInt("UPLOAD_RECENT_OBJECTS_DEPTH", static_cast<long>(options.depth)));
+    options.ttl = std::chrono::milliseconds(
+        common::EnvInt("UPLOAD_RECENT_OBJECTS_TTL_MS", static_cast<long>(options.ttl.count())));
+    options.max_tenants = static_cast<size_t>(
+        common::EnvInt("UPLOAD_RECENT_OBJECTS_MAX_TENANTS", static_cast<long>(options.max_tenants)));
+    return options;
+}
+
+RecentObjectsCache::RecentObjectsCache(std::shared_ptr<common::DbPool> db_pool,
+                                       const RecentObjectsCacheOptions& options)
+    : RecentObjectsCache(
+          [db_pool](const std::string& tenant_id, size_t limit) {
+              // Read-your-writes: completions recorded with RecordWrite() route this to the primary
+              auto conn_guard = db_pool->AcquireReadConnection("RecentObjectsCache::Load", tenant_id);
+              pqxx::read_transaction txn(*conn_guard);
+
+              auto result = common::ExecPrepared(txn, kSelectRecentObjects, tenant_id, static_cast<long long>(limit));
+              txn.commit();
+
+              std::vector<ObjectInfo> objects;
+              objects.reserve(result.size());
+              for (const auto& row : result) {
+                  objects.push_back(ObjectInfoFromRow(row));
+              }
+              return objects;
+          },
+          options) {}
+
+RecentObjectsCache::RecentObjectsCache(Loader loader, const RecentObjectsCacheOptions& options)
+    : load_(std::move(loader)), options_(options) {}
+
+std::vector<ObjectInfo> RecentObjectsCache::Recent(const std::string& tenant_id, size_t limit) {
+    auto now = std::chrono::steady_clock::now();
+    size_t wanted = std::min(limit, options_.depth);
+    uint64_t version = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tenants_.find(tenant_id);
+        if (it != tenants_.end() && now - it->second.loaded_at < options_.ttl &&
+            (it->second.complete || it->second.objects.size() >= wanted)) {
+            const auto& objects = it->second.objects;
+            return std::vector<ObjectInfo>(objects.begin(),
+                                           objects.begin() + static_cast<long>(std::min(wanted, objects.size())));
+        }
+        version = version_;
+    }
+
+    // Query outside the lock; concurrent cold loads of one tenant are rare and idempotent
+    TenantEntry entry;
+    entry.objects = load_(tenant_id, options_.depth);
+    entry.complete = entry.objects.size() < options_.depth;
+    entry.loaded_at = now;
+    std::vector<ObjectInfo> recent(entry.objects.begin(),
+                                   entry.objects.begin() + static_cast<long>(std::min(wanted, entry.objects.size())));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (version == version_) {
+        if (tenants_.size() >= options_.max_tenants && tenants_.find(tenant_id) == tenants_.end()) {
+            for (auto it = tenants_.begin(); it != tenants_.end();) {
+                it = (now - it->second.loaded_at >= options_.ttl) ? tenants_.erase(it) : std::next(it);
+            }
+            if (tenants_.size() >= options_.max_tenants && !tenants_.empty()) {
+                tenants_.erase(tenants_.begin());
+            }
+        }
+        tenants_[tenant_id] = std::move(entry);
+    }
+    return recent;
+}
+
+void RecentObjectsCache::Record(const std::string& tenant_id, const ObjectInfo& object) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+
+    auto it = tenants_.find(tenant_id);
+    if (it == tenants_.end()) {
+        return;  // The next load includes it
+    }
+    auto& objects = it->second.objects;
+    objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                 [&](const ObjectInfo& cached) { return cached.object_id() == object.object_id(); }),
+                  objects.end());
+    objects.insert(objects.begin(), object);
+    if (objects.size() > options_.depth) {
+        objects.pop_back();
+        it->second.complete = false;
+    }
+}
+
+void RecentObjectsCache::Remove(const std::string& tenant_id, const std::string& object_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++version_;
+
+    auto it = tenants_.find(tenant_id);
+    if (it == tenants_.end()) {
+        return;
+    }
+    // Leaves a gap if the tenant has older objects; Recent() reloads when it needs them
+    auto& objects = it->second.objects;
+    objects.erase(std::remove_if(objects.begin(), objects.end(),
+                                 [&](const ObjectInfo& cached) { return cached.object_id() == object_id; }),
+                  objects.end());
+}
+
+size_t RecentObjectsCache::TenantCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tenants_.size();
+}
+
+} // namespace upload
+} // namespace saasforge
@@ -0,0 +1,184 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Worker pool that streams objects from S3 through transform stages
+ */
+
+#include "upload/transform_engine.h"
+#include "upload/transform_stages.h"
+#include "common/sha256.h"
+#include "common/logger.h"
+#include "common/env.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+
+namespace saasforge {
+namespace upload {
+
+namespace {
+
+constexpr int64_t MIN_CHUNK_BYTES = 64 * 1024;
+
+// Transforms are CPU-bound: one worker per core
+size_t WorkerCount(size_t configured) {
+    if (configured > 0) {
+        return configured;
+    }
+    return std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+}
+
+} // namespace
+
+TransformEngineOptions TransformEngineOptions::FromEnv() {
+    TransformEngineOptions options;
+    options.workers = static_cast<size_t>(common::EnvInt("TRANSFORM_WORKERS", static_cast<long>(options.workers)));
+    options.queue_capacity = static_cast<size_t>(
+        common::EnvInt("TRANSFORM_QUEUE_CAPACITY", static_cast<long>(options.queue_capacity)));
+    options.chunk_bytes = common::EnvInt("TRANSFORM_CHUNK_BYTES", static_cast<long>(options.chunk_bytes));
+    return options;
+}
+
+TransformIo TransformIo::Default(std::shared_ptr<common::S3MultipartClient> s3) {
+    TransformIo io;
+    io.get_range = [s3](const std::string& key, int64_t offset, int64_t length) {
+        return s3->GetRange(key, offset, length);
+    };
+    io.create = [s3](const std::string& key, const std::string& content_type) {
+        return s3->Create(key, content_type);
+    };
+    io.upload_part = [s3](const std::string& key, const std::string& upload_id,
+                          int32_t part_number, const std::string& data) {
+        return s3->UploadPart(key, upload_id, part_number, data);
+    };
+    io.complete = [s3](const std::string& key, const std::string& upload_id,
+                       const std::vector<common::S3Part>& parts) {
+        return s3->Complete(key, upload_id, parts);
+    };
+    io.abort = [s3](const std::string& key, const std::string& upload_id) {
+        s3->Abort(key, upload_id);
+    };
+    return io;
+}
+
+TransformEngine::TransformEngine(std::shared_ptr<common::S3MultipartClient> s3,
+                                 const TransformEngineOptions& options)
+    : TransformEngine(TransformIo::Default(std::move(s3)), options) {}
+
+TransformEngine::TransformEngine(TransformIo io, const TransformEngineOptions& options)
+    : io_(std::move(io)),
+      options_(options),
+      executor_(WorkerCount(options.workers), options.queue_capacity) {
+    if (options_.chunk_bytes < MIN_CHUNK_BYTES) {
+        throw std::invalid_argument("Transform chunk size must be at least 64 KiB");
+    }
+    if (options_.part_bytes <= 0) {
+        throw std::invalid_argument("Transform part size must be positive");
+    }
+    executor_.ExportMetrics("transform");
+    common::LogInfo("TransformEngine started", {{"workers", executor_.ThreadCount()},
+                                               {"chunk_bytes", options_.chunk_bytes}});
+}
+
+TransformEngine::~TransformEngine() {
+    Shutdown();
+}
+
+bool TransformEngine::Submit(TransformJob job, Callback done) {
+    return executor_.TrySubmit([this, job = std::move(job), done = std::move(done)] {
+        TransformResult result = Run(job);
+        (result.ok ? completed_ : failed_).fetch_add(1, std::memory_order_relaxed);
+        if (!done) {
+            return;
+        }
+        try {
+            done(job, result);
+        } catch (const std::exception& e) {
+            common::LogError("Transform job callback failed", {{"job_id", job.job_id}, {"error", e.what()}});
+        }
+    });
+}
+
+TransformResult TransformEngine::Run(const TransformJob& job) const {
+    TransformResult result;
+    std::string upload_id;
+    try {
+        auto stage = MakeTransformStage(job.profile_id, job.output_format);
+        result.content_type = stage->ContentType();
+
+        std::vector<common::S3Part> parts;
+        common::Sha256 checksum;
+        std::string buffer;
+        buffer.reserve(static_cast<size_t>(options_.part_bytes));
+
+        auto upload_buffer = [&] {
+            if (upload_id.empty()) {
+                upload_id = io_.create(job.output_key, result.content_type);
+            }
+            int32_t part_number = static_cast<int32_t>(parts.size()) + 1;
+            if (part_number > common::S3MultipartClient::MAX_PARTS) {
+                throw std::runtime_error("Transform output exceeds the multipart part limit");
+            }
+            std::string etag = io_.upload_part(job.output_key, upload_id, part_number, buffer);
+            parts.push_back({part_number, etag, static_cast<int64_t>(buffer.size())});
+            checksum.Update(buffer.data(), buffer.size());
+            result.bytes_out += static_cast<int64_t>(buffer.size());
+            buffer.clear();
+        };
+
+        // Stages emit small pieces (a row, a compressor block); parts go out once full
+        TransformStage::Sink sink = [&](const char* data, size_t size) {
+            buffer.append(data, size);
+            if (static_cast<int64_t>(buffer.size()) >= options_.part_bytes) {
+                upload_buffer();
+            }
+        };
+
+        while (result.bytes_in < job.source_size) {
+            int64_t length = std::min(options_.chunk_bytes, job.source_size - result.bytes_in);
+            std::string chunk = io_.get_range(job.source_key, result.bytes_in, length);
+            if (chunk.empty()) {
+                throw std::runtime_error("Source object is shorter than its recorded size");
+            }
+            result.bytes_in += static_cast<int64_t>(chunk.size());
+            stage->Consume(chunk.data(), chunk.size(), sink);
+        }
+        stage->Finish(sink);
+
+        if (!buffer.empty() || parts.empty()) {
+            upload_buffer();
+        }
+        result.etag = io_.complete(job.output_key, upload_id, parts);
+        result.checksum_sha256 = checksum.HexDigest();
+        result.ok = true;
+
+    } catch (const std::exception& e) {
+        result.ok = false;
+        result.error = e.what();
+        if (!upload_id.empty()) {
+            try {
+                io_.abort(job.output_key, upload_id);
+            } catch (const std::exception& abort_error) {
+                common::LogError("Transform job abort failed", {{"job_id", job.job_id}, {"error", abort_error.what()}});
+            }
+        }
+    }
+    return result;
+}
+
+void TransformEngine::Shutdown() {
+    executor_.Shutdown();
+}
+
+TransformEngineStats TransformEngine::GetStats() const {
+    TransformEngineStats stats;
+    stats.completed = completed_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    stats.queued = executor_.QueueDepth();
+    stats.workers = executor_.ThreadCount();
+    return stats;
+}
+
+} // namespace upload
+} // namespace saasforge
@@ -0,0 +1,296 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Streaming transform stages for TransformObject profiles
+ */
+
+#include "upload/transform_stages.h"
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace saasforge {
+namespace upload {
+
+namespace {
+
+constexpr int32_t DEFAULT_THUMBNAIL_SIZE = 256;
+constexpr int32_t MAX_THUMBNAIL_SIZE = 8192;
+constexpr size_t GZIP_OUT_BUFFER = 64 * 1024;
+
+const std::string THUMBNAIL_PROFILE = "thumbnail";
+
+} // namespace
+
+std::unique_ptr<TransformStage> MakeTransformStage(const std::string& profile_id,
+                                                   const std::string& output_format) {
+    if (profile_id == "gzip") {
+        if (!output_format.empty() && output_format != "gz" && output_format != "gzip") {
+            throw std::invalid_argument("Profile gzip cannot produce " + output_format);
+        }
+        return std::make_unique<GzipStage>();
+    }
+
+    if (profile_id.compare(0, THUMBNAIL_PROFILE.size(), THUMBNAIL_PROFILE) == 0) {
+        int32_t size = DEFAULT_THUMBNAIL_SIZE;
+        std::string suffix = profile_id.substr(THUMBNAIL_PROFILE.size());
+        if (!suffix.empty()) {
+            std::string digits = suffix.substr(1);
+            if (suffix[0] != '-' || digits.empty() || digits.size() > 4 ||
+                !std::all_of(digits.begin(), digits.end(), [](unsigned char c) { return std::isdigit(c); })) {
+                throw std::invalid_argument("Unknown transform profile: " + profile_id);
+            }
+            size = std::stoi(digits);
+            if (size < 1 || size > MAX_THUMBNAIL_SIZE) {
+                throw std::invalid_argument("Thumbnail size must be between 1 and 8192");
+            }
+        }
+        if (!output_format.empty() && output_format != "pnm") {
+            throw std::invalid_argument("Profile " + profile_id + " cannot produce " + output_format);
+        }
+        return std::make_unique<PnmResizeStage>(size);
+    }
+
+    throw std::invalid_argument("Unknown transform profile: " + profile_id);
+}
+
+// ---------------------------------------------------------------------------
+// PnmResizeStage
+// ---------------------------------------------------------------------------
+
+PnmResizeStage::PnmResizeStage(int32_t max_dimension) : max_dimension_(max_dimension) {
+    if (max_dimension_ <= 0) {
+        throw std::invalid_argument("max_dimension must be positive");
+    }
+}
+
+std::string PnmResizeStage::ContentType() const {
+    return "image/x-portable-anymap";
+}
+
+std::string PnmResizeStage::Extension() const {
+    return "pnm";
+}
+
+void PnmResizeStage::Consume(const char* data, size_t size, const Sink& sink) {
+    if (header_done_) {
+        ConsumeRows(data, size, sink);
+        return;
+    }
+
+    pending_.append(data, size);
+    if (!ParseHeader(sink)) {
+        if (pending_.size() > MAX_HEADER_BYTES) {
+            throw std::runtime_error("PNM header too long");
+        }
+        return;
+    }
+
+    // The rest of the buffered bytes start the raster
+    std::string raster;
+    raster.swap(pending_);
+    ConsumeRows(raster.data(), raster.size(), sink);
+}
+
+void PnmResizeStage::Finish(const Sink& sink) {
+    if (!header_done_) {
+        throw std::runtime_error("Not a binary PGM/PPM image");
+    }
+    if (rows_read_ < height_) {
+        throw std::runtime_error("PNM image truncated at row " + std::to_string(rows_read_));
+    }
+}
+
+// Header: magic, width, height, maxval separated by whitespace or comments,
+// then exactly one whitespace byte before the raster
+bool PnmResizeStage::ParseHeader(const Sink& sink) {
+    if (pending_.size() < 2) {
+        return false;
+    }
+    if (pending_[0] != 'P' || (pending_[1] != '5' && pending_[1] != '6')) {
+        throw std::runtime_error("Not a binary PGM/PPM image");
+    }
+
+    size_t pos = 2;
+    int64_t fields[3] = {0, 0, 0};
+    for (int64_t& field : fields) {
+        // Skip whitespace and comments
+        while (true) {
+            if (pos >= pending_.size()) {
+                return false;
+            }
+            if (std::isspace(static_cast<unsigned char>(pending_[pos]))) {
+                ++pos;
+            } else if (pending_[pos] == '#') {
+                size_t eol = pending_.find('\n', pos);
+                if (eol == std::string::npos) {
+                    return false;
+                }
+                pos = eol + 1;
+            } else {
+                break;
+            }
+        }
+
+        size_t start = pos;
+        while (pos < pending_.size() && std::isdigit(static_cast<unsigned char>(pending_[pos]))) {
+            if (pos - start >= 9) {
+                throw std::runtime_error("PNM header value out of range");
+            }
+            field = field * 10 + (pending_[pos] - '0');
+            ++pos;
+        }
+        if (pos >= pending_.size()) {
+            return false;  // The number may continue in the next chunk
+        }
+        if (pos == start || !std::isspace(static_cast<unsigned char>(pending_[pos]))) {
+            throw std::runtime_error("Malformed PNM header");
+        }
+    }
+    ++pos;  // The single whitespace byte after maxval
+
+    width_ = fields[0];
+    height_ = fields[1];
+    max_value_ = fields[2];
+    channels_ = pending_[1] == '6' ? 3 : 1;
+    if (width_ <= 0 || height_ <= 0 || width_ > MAX_WIDTH || height_ > MAX_HEIGHT) {
+        throw std::runtime_error("Unsupported PNM dimensions " + std::to_string(width_) + "x" +
+                                 std::to_string(height_));
+    }
+    if (max_value_ <= 0 || max_value_ > 255) {
+        throw std::runtime_error("Only 8-bit PNM images are supported");
+    }
+
+    int64_t longest = std::max(width_, height_);
+    factor_ = (longest + max_dimension_ - 1) / max_dimension_;
+    out_width_ = (width_ + factor_ - 1) / factor_;
+    int64_t out_height = (height_ + factor_ - 1) / factor_;
+
+    sums_.assign(static_cast<size_t>(width_ * channels_), 0);
+    out_row_.resize(static_cast<size_t>(out_width_ * channels_));
+
+    std::string header = std::string("P") + pending_[1] + "\n" + std::to_string(out_width_) + " " +
+                         std::to_string(out_height) + "\n" + std::to_string(max_value_) + "\n";
+    sink(header.data(), header.size());
+
+    pending_.erase(0, pos);
+    header_done_ = true;
+    return true;
+}
+
+void PnmResizeStage::ConsumeRows(const char* data, size_t size, const Sink& sink) {
+    const size_t row_bytes = sums_.size();
+    while (size > 0 && rows_read_ < height_) {
+        if (pending_.empty() && size >= row_bytes) {
+            // Whole row in the chunk: no copy
+            AddRow(reinterpret_cast<const uint8_t*>(data), sink);
+            data += row_bytes;
+            size -= row_bytes;
+            continue;
+        }
+
+        size_t take = std::min(row_bytes - pending_.size(), size);
+        pending_.append(data, take);
+        data += take;
+        size -= take;
+        if (pending_.size() == row_bytes) {
+            AddRow(reinterpret_cast<const uint8_t*>(pending_.data()), sink);
+            pending_.clear();
+        }
+    }
+    // Bytes after the last row (further images in the file) are ignored
+}
+
+void PnmResizeStage::AddRow(const uint8_t* row, const Sink& sink) {
+    uint32_t* sums = sums_.data();
+    const size_t count = sums_.size();
+    for (size_t i = 0; i < count; ++i) {
+        sums[i] += row[i];
+    }
+    ++rows_read_;
+    ++rows_summed_;
+
+    if (rows_summed_ == factor_ || rows_read_ == height_) {
+        EmitRow(sink);
+    }
+}
+
+void PnmResizeStage::EmitRow(const Sink& sink) {
+    for (int64_t out_x = 0; out_x < out_width_; ++out_x) {
+        int64_t x0 = out_x * factor_;
+        int64_t x1 = std::min(x0 + factor_, width_);
+        uint64_t samples = static_cast<uint64_t>((x1 - x0) * rows_summed_);
+
+        for (int64_t c = 0; c < channels_; ++c) {
+            uint64_t total = 0;
+            for (int64_t x = x0; x < x1; ++x) {
+                total += sums_[static_cast<size_t>(x * channels_ + c)];
+            }
+            out_row_[static_cast<size_t>(out_x * channels_ + c)] =
+                static_cast<char>((total + samples / 2) / samples);
+        }
+    }
+    sink(out_row_.data(), out_row_.size());
+
+    std::fill(sums_.begin(), sums_.end(), 0);
+    rows_summed_ = 0;
+}
+
+// ---------------------------------------------------------------------------
+// GzipStage
+// ---------------------------------------------------------------------------
+
+struct GzipStage::State {
+    z_stream stream{};
+    std::vector<char> out = std::vector<char>(GZIP_OUT_BUFFER);
+};
+
+GzipStage::GzipStage() : state_(std::make_unique<State>()) {
+    // windowBits 15 + 16 selects the gzip wrapper
+    if (deflateInit2(&state_->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+}
+
+GzipStage::~GzipStage() {
+    deflateEnd(&state_->stream);
+}
+
+void GzipStage::Consume(const char* data, size_t size, const Sink& sink) {
+    while (size > 0) {
+        size_t piece = std::min<size_t>(size, UINT_MAX);
+        Deflate(data, piece, Z_NO_FLUSH, sink);
+        data += piece;
+        size -= piece;
+    }
+}
+
+void GzipStage::Finish(const Sink& sink) {
+    Deflate(nullptr, 0, Z_FINISH, sink);
+}
+
+void GzipStage::Deflate(const char* data, size_t size, int flush, const Sink& sink) {
+    z_stream& stream = state_->stream;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    int ret = Z_OK;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(state_->out.data());
+        stream.avail_out = static_cast<uInt>(state_->out.size());
+        ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::runtime_error("deflate failed");
+        }
+        size_t produced = state_->out.size() - stream.avail_out;
+        if (produced > 0) {
+            sink(state_->out.data(), produced);
+        }
+    } while (stream.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+} // namespace upload
+} // namespace saasforge
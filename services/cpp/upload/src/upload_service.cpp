@@ -1,32 +1,514 @@
 #include "upload/upload_service.h"
 #include "common/tenant_context.h"
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include "common/statement_registry.h"
+#include "common/id_generator.h"
+#include "common/logger.h"
+#include "common/outbox.h"
+#include "common/sha256.h"
+#include "upload/object_info.h"
+#include "upload/transform_stages.h"
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
 
 namespace saasforge {
 namespace upload {
 
+namespace {
+
+constexpr int64_t PRESIGNED_URL_EXPIRES_S = 600;  // 10 minutes
+constexpr int64_t PART_URL_EXPIRES_S = 3600;      // Only checked when a part PUT starts
+constexpr int MAX_PRESIGN_PARTS = 1000;
+
+// Object metadata (tags) limits; the whole map is one JSONB value
+constexpr int MAX_METADATA_ENTRIES = 64;
+constexpr size_t MAX_METADATA_BYTES = 8 * 1024;
+
+/// ListObjects page sizes; a page is one index range scan, so large pages stay cheap
+constexpr int DEFAULT_LIST_PAGE_SIZE = 1000;
+constexpr int MAX_LIST_PAGE_SIZE = 100000;
+
+/// ListRecentObjects limit when the request sets none
+constexpr size_t DEFAULT_RECENT_LIMIT = 20;
+
+/// Object ids per DeleteObjects call; each call is one transaction
+constexpr int MAX_DELETE_OBJECTS = 10000;
+
+// Prepared on every pooled connection by DbPool (see StatementRegistry)
+// Object ids (the last parameter) come from IdGenerator, so inserts append to
+// the primary key index; the same id names the object in its key.
+const common::PreparedStatement kInsertObject(
+    "upload_insert_object",
+    "INSERT INTO upload_objects (id, tenant_id, user_id, object_key, filename, size, content_type, status, "
+    "checksum, dedup, metadata) "
+    "VALUES ($10, $1, $2, $3, $4, $5, $6, 'pending', NULLIF($7, ''), $8, $9::jsonb) "
+    "RETURNING id");
+
+const common::PreparedStatement kInsertMultipartObject(
+    "upload_insert_multipart_object",
+    "INSERT INTO upload_objects (id, tenant_id, user_id, object_key, filename, size, content_type, status, "
+    "multipart_upload_id, part_size, part_count, checksum, dedup, metadata) "
+    "VALUES ($13, $1, $2, $3, $4, $5, $6, 'pending', $7, $8, $9, NULLIF($10, ''), $11, $12::jsonb) "
+    "RETURNING id");
+
+// Content index: one row per distinct (tenant, SHA-256), shared by every object that stores it
+const common::PreparedStatement kAcquireContent(
+    "upload_acquire_content",
+    "UPDATE upload_contents SET refcount = refcount + 1 "
+    "WHERE tenant_id = $1 AND sha256 = $2 AND size = $3 AND refcount > 0 "
+    "RETURNING id, object_key");
+
+const common::PreparedStatement kInsertAliasObject(
+    "upload_insert_alias_object",
+    "INSERT INTO upload_objects (id, tenant_id, user_id, object_key, filename, size, content_type, status, "
+    "checksum, dedup, content_id, completed_at, metadata) "
+    "VALUES ($10, $1, $2, $3, $4, $5, $6, 'completed', $7, TRUE, $8, NOW(), $9::jsonb) "
+    "RETURNING " SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS);
+
+// A second upload of content indexed meanwhile stays a standalone object
+const common::PreparedStatement kIndexContent(
+    "upload_index_content",
+    "WITH content AS ("
+    "    INSERT INTO upload_contents (tenant_id, sha256, size, object_key) "
+    "    SELECT tenant_id, checksum, size, object_key FROM upload_objects "
+    "    WHERE id = $1 AND tenant_id = $2 AND dedup AND checksum IS NOT NULL AND content_id IS NULL "
+    "    ON CONFLICT (tenant_id, sha256) DO NOTHING "
+    "    RETURNING id) "
+    "UPDATE upload_objects SET content_id = content.id FROM content WHERE upload_objects.id = $1");
+
+// $1 = content ids, $2 = references dropped from each
+const common::PreparedStatement kReleaseContents(
+    "upload_release_contents",
+    "UPDATE upload_contents c SET refcount = c.refcount - r.n "
+    "FROM unnest($1::uuid[], $2::int[]) AS r(id, n) WHERE c.id = r.id "
+    "RETURNING c.id, c.refcount");
+
+const common::PreparedStatement kDropContents(
+    "upload_drop_contents",
+    "DELETE FROM upload_contents WHERE id = ANY($1::uuid[]) AND refcount <= 0");
+
+const common::PreparedStatement kSelectMultipartObject(
+    "upload_select_multipart_object",
+    "SELECT object_key, multipart_upload_id, size, part_size, part_count, status, etag "
+    "FROM upload_objects "
+    "WHERE id = $1 AND tenant_id = $2 AND deleted_at IS NULL AND multipart_upload_id IS NOT NULL");
+
+// parts is keyed by part number; arrays are (part number, etag, size)
+const common::PreparedStatement kRecordParts(
+    "upload_record_parts",
+    "UPDATE upload_objects SET parts = ("
+    "    SELECT COALESCE(jsonb_object_agg(n::text, jsonb_build_object('etag', e, 'size', s)), '{}'::jsonb) "
+    "    FROM unnest($3::int[], $4::text[], $5::bigint[]) AS p(n, e, s)) "
+    "WHERE id = $1 AND tenant_id = $2 AND status = 'pending'");
+
+const common::PreparedStatement kSelectStoredParts(
+    "upload_select_stored_parts",
+    "SELECT p.key::int AS part_number, p.value->>'etag' AS etag, (p.value->>'size')::bigint AS size "
+    "FROM upload_objects o, jsonb_each(o.parts) AS p "
+    "WHERE o.id = $1 AND o.tenant_id = $2 "
+    "ORDER BY 1");
+
+const common::PreparedStatement kCompleteMultipartObject(
+    "upload_complete_multipart_object",
+    "UPDATE upload_objects SET status = 'completed', etag = $3, completed_at = NOW(), parts = ("
+    "    SELECT COALESCE(jsonb_object_agg(n::text, jsonb_build_object('etag', e, 'size', s)), '{}'::jsonb) "
+    "    FROM unnest($4::int[], $5::text[], $6::bigint[]) AS p(n, e, s)) "
+    "WHERE id = $1 AND tenant_id = $2 AND status = 'pending' "
+    "RETURNING " SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS);
+
+const common::PreparedStatement kCompleteObject(
+    "upload_complete_object",
+    "UPDATE upload_objects SET status = 'completed', etag = $1, completed_at = NOW() "
+    "WHERE id = $2 AND tenant_id = $3 "
+    "RETURNING " SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS);
+
+// Tombstones; ObjectReaper frees the storage and the quota of rows left purge_pending
+const common::PreparedStatement kDeleteObjects(
+    "upload_delete_objects",
+    "UPDATE upload_objects SET deleted_at = NOW(), purge_pending = content_id IS NULL "
+    "WHERE id = ANY($1::uuid[]) AND tenant_id = $2 AND deleted_at IS NULL "
+    "RETURNING id, content_id");
+
+const common::PreparedStatement kMarkPurgePending(
+    "upload_mark_purge_pending",
+    "UPDATE upload_objects SET purge_pending = TRUE WHERE id = ANY($1::uuid[])");
+
+const common::PreparedStatement kSelectTransformSource(
+    "upload_select_transform_source",
+    "SELECT object_key, filename, size, status FROM upload_objects "
+    "WHERE id = $1 AND tenant_id = $2 AND deleted_at IS NULL");
+
+const common::PreparedStatement kInsertTransformJob(
+    "upload_insert_transform_job",
+    "INSERT INTO transform_jobs (tenant_id, source_object_id, profile_id, output_format) "
+    "VALUES ($1, $2, $3, NULLIF($4, '')) "
+    "RETURNING id");
+
+// Inserts the derivative, finishes the job and appends it to the source's transformations
+const common::PreparedStatement kCompleteTransformJob(
+    "upload_complete_transform_job",
+    "WITH output AS ("
+    "    INSERT INTO upload_objects (id, tenant_id, user_id, object_key, filename, size, content_type, status, "
+    "    etag, checksum, completed_at) "
+    "    VALUES ($11, $2, $3, $4, $5, $6::bigint, $7, 'completed', $8, $10, NOW()) "
+    "    RETURNING id), "
+    "job AS ("
+    "    UPDATE transform_jobs SET status = 'completed', output_object_id = (SELECT id FROM output), "
+    "    bytes_in = $9, bytes_out = $6::bigint, completed_at = NOW() "
+    "    WHERE id = $1 AND tenant_id = $2 "
+    "    RETURNING source_object_id, profile_id) "
+    "UPDATE upload_objects AS source SET transformations = COALESCE(source.transformations, '[]'::jsonb) || "
+    "    jsonb_build_array(jsonb_build_object("
+    "        'profile_id', job.profile_id, 'object_id', (SELECT id FROM output), 'size', $6::bigint)) "
+    "FROM job WHERE source.id = job.source_object_id");
+
+const common::PreparedStatement kFailTransformJob(
+    "upload_fail_transform_job",
+    "UPDATE transform_jobs SET status = 'failed', error = $2, bytes_in = $3, completed_at = NOW() "
+    "WHERE id = $1");
+
+const common::PreparedStatement kSelectQuota(
+    "upload_select_quota",
+    "SELECT used_bytes, limit_bytes FROM quotas WHERE tenant_id = $1");
+
+// The quota read may come from a replica that has not seen the row yet: keep an existing one
+const common::PreparedStatement kInsertDefaultQuota(
+    "upload_insert_default_quota",
+    "WITH inserted AS ("
+    "  INSERT INTO quotas (tenant_id, used_bytes, limit_bytes) VALUES ($1, 0, 10737418240) "
+    "  ON CONFLICT (tenant_id) DO NOTHING "
+    "  RETURNING used_bytes, limit_bytes"
+    ") "
+    "SELECT used_bytes, limit_bytes FROM inserted "
+    "UNION ALL SELECT used_bytes, limit_bytes FROM quotas WHERE tenant_id = $1 "
+    "LIMIT 1");
+
+
+struct MultipartUpload {
+    std::string object_key;
+    std::string s3_upload_id;
+    int64_t size = 0;
+    int64_t part_size = 0;
+    int32_t part_count = 0;
+    std::string status;
+    std::string etag;
+
+    int64_t PartSize(int32_t part_number) const {
+        return part_number < part_count ? part_size : size - part_size * (part_count - 1);
+    }
+};
+
+std::optional<MultipartUpload> LoadMultipartUpload(
+    pqxx::transaction_base& txn,
+    const std::string& upload_id,
+    const std::string& tenant_id
+) {
+    auto result = common::ExecPrepared(txn, kSelectMultipartObject, upload_id, tenant_id);
+    if (result.empty()) {
+        return std::nullopt;
+    }
+
+    const auto& row = result[0];
+    MultipartUpload upload;
+    upload.object_key = row["object_key"].as<std::string>();
+    upload.s3_upload_id = row["multipart_upload_id"].as<std::string>();
+    upload.size = row["size"].as<long long>();
+    upload.part_size = row["part_size"].as<long long>();
+    upload.part_count = row["part_count"].as<int>();
+    upload.status = row["status"].as<std::string>();
+    upload.etag = row["etag"].is_null() ? "" : row["etag"].as<std::string>();
+    return upload;
+}
+
+// Array literals for kRecordParts / kCompleteMultipartObject
+struct PartArrays {
+    std::string numbers;
+    std::string etags;
+    std::string sizes;
+};
+
+PartArrays ToPartArrays(const std::vector<common::S3Part>& parts) {
+    std::vector<std::string> numbers, etags, sizes;
+    numbers.reserve(parts.size());
+    etags.reserve(parts.size());
+    sizes.reserve(parts.size());
+    for (const auto& part : parts) {
+        numbers.push_back(std::to_string(part.part_number));
+        etags.push_back(part.etag);
+        sizes.push_back(std::to_string(part.size));
+    }
+    return {common::ToArrayLiteral(numbers), common::ToArrayLiteral(etags), common::ToArrayLiteral(sizes)};
+}
+
+// Returns a reservation to the ledger unless the upload was recorded
+class ReservationGuard {
+public:
+    ReservationGuard(common::QuotaLedger& ledger, std::string tenant_id, int64_t bytes)
+        : ledger_(ledger), tenant_id_(std::move(tenant_id)), bytes_(bytes) {}
+
+    ~ReservationGuard() {
+        if (!kept_) {
+            ledger_.Release(tenant_id_, bytes_);
+        }
+    }
+
+    ReservationGuard(const ReservationGuard&) = delete;
+    ReservationGuard& operator=(const ReservationGuard&) = delete;
+
+    void Keep() { kept_ = true; }
+
+private:
+    common::QuotaLedger& ledger_;
+    std::string tenant_id_;
+    int64_t bytes_;
+    bool kept_ = false;
+};
+
+// Lowercase hex checksum from a request; INVALID_ARGUMENT if malformed, or missing when deduplicating
+grpc::Status ParseChecksum(const std::string& value, bool deduplicate, std::string* checksum) {
+    *checksum = common::Sha256::NormalizeHex(value);
+    if (!value.empty() && checksum->empty()) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "checksum_sha256 must be 64 hex characters");
+    }
+    if (deduplicate && checksum->empty()) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Deduplication requires checksum_sha256");
+    }
+    return grpc::Status::OK;
+}
+
+// Tags given at upload; INVALID_ARGUMENT beyond the limits
+grpc::Status ValidateMetadata(const google::protobuf::Map<std::string, std::string>& metadata) {
+    if (metadata.size() > MAX_METADATA_ENTRIES) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "At most 64 metadata entries");
+    }
+    size_t bytes = 0;
+    for (const auto& [key, value] : metadata) {
+        if (key.empty()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Metadata keys must not be empty");
+        }
+        bytes += key.size() + value.size();
+    }
+    if (bytes > MAX_METADATA_BYTES) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Metadata exceeds 8 KiB");
+    }
+    return grpc::Status::OK;
+}
+
+// New completed object (SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS) referencing content the tenant
+// already stores; empty if none matches
+pqxx::result InsertContentAlias(
+    pqxx::work& txn,
+    const common::TenantContext& tenant_ctx,
+    const std::string& filename,
+    const std::string& content_type,
+    int64_t size,
+    const std::string& checksum,
+    const std::string& metadata
+) {
+    auto content = common::ExecPrepared(txn, kAcquireContent, tenant_ctx.tenant_id, checksum, size);
+    if (content.empty()) {
+        return content;
+    }
+
+    return common::ExecPrepared(
+        txn, kInsertAliasObject,
+        tenant_ctx.tenant_id,
+        tenant_ctx.user_id,
+        content[0]["object_key"].as<std::string>(),
+        filename,
+        size,
+        content_type,
+        checksum,
+        content[0]["id"].as<std::string>(),
+        metadata,
+        common::IdGenerator::NewUuid()
+    );
+}
+
+void SetUploadedPart(UploadedPart* out, const common::S3Part& part) {
+    out->set_part_number(part.part_number);
+    out->set_etag(part.etag);
+    out->set_size(part.size);
+}
+
+bool IsUuid(std::string_view value) {
+    if (value.size() != 36) {
+        return false;
+    }
+    for (size_t i = 0; i < value.size(); ++i) {
+        bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+        if (dash ? value[i] != '-' : !std::isxdigit(static_cast<unsigned char>(value[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// "<id>:<filename>", the keyset position a page resumes after
+std::string ListCursor(const std::string& id, const std::string& filename) {
+    return id + ":" + filename;
+}
+
+/**
+ * WHERE clause for one ListObjects page
+ *
+ * COPY cannot take bind parameters, so values are quoted into the query;
+ * the cursor is validated first so a bad one is INVALID_ARGUMENT, not a
+ * SQL error. Filenames compare byte-wise (COLLATE "C"), which keeps a
+ * prefix one contiguous range of idx_uploads_tenant_filename.
+ */
+grpc::Status ObjectsWhere(pqxx::transaction_base& txn, const std::string& tenant_id,
+                          const ListObjectsRequest& request, std::string& where) {
+    where = "WHERE tenant_id = " + txn.quote(tenant_id) + " AND status = 'completed' AND deleted_at IS NULL";
+    if (!request.prefix().empty()) {
+        std::string pattern;
+        pattern.reserve(request.prefix().size() + 1);
+        for (char c : request.prefix()) {
+            if (c == '\\' || c == '%' || c == '_') {
+                pattern += '\\';
+            }
+            pattern += c;
+        }
+        pattern += '%';
+        where += " AND filename COLLATE \"C\" LIKE " + txn.quote(pattern);
+    }
+    if (!request.tags().empty()) {
+        where += " AND metadata @> " + txn.quote(EncodeMetadata(request.tags())) + "::jsonb";
+    }
+    const std::string& cursor = request.after_cursor();
+    if (cursor.empty()) {
+        return grpc::Status::OK;
+    }
+    if (cursor.size() < 37 || cursor[36] != ':' || !IsUuid(std::string_view(cursor).substr(0, 36))) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Invalid after_cursor");
+    }
+    // Row comparison, so the index is scanned from the cursor onwards
+    where += " AND (filename COLLATE \"C\", id) > (" + txn.quote(cursor.substr(37)) + " COLLATE \"C\", " +
+             txn.quote(cursor.substr(0, 36)) + "::uuid)";
+    return grpc::Status::OK;
+}
+
+/**
+ * Tombstone a tenant's objects; returns the ids of those that were live
+ *
+ * Storage is freed by ObjectReaper. Shared content is counted once, so it
+ * is queued for purge with its last reference only: one of the rows that
+ * dropped it is marked purge_pending.
+ */
+std::vector<std::string> DeleteTenantObjects(pqxx::work& txn, const std::string& tenant_id,
+                                             const std::vector<std::string>& object_ids) {
+    auto deleted = common::ExecPrepared(txn, kDeleteObjects, common::ToArrayLiteral(object_ids), tenant_id);
+
+    std::vector<std::string> ids;
+    ids.reserve(deleted.size());
+    std::map<std::string, std::vector<std::string>> by_content;   // Content id -> rows deleted now
+    for (const auto& row : deleted) {
+        ids.push_back(row["id"].as<std::string>());
+        if (!row["content_id"].is_null()) {
+            by_content[row["content_id"].as<std::string>()].push_back(ids.back());
+        }
+    }
+    if (by_content.empty()) {
+        return ids;
+    }
+
+    std::vector<std::string> content_ids, counts;
+    content_ids.reserve(by_content.size());
+    counts.reserve(by_content.size());
+    for (const auto& [content_id, rows] : by_content) {
+        content_ids.push_back(content_id);
+        counts.push_back(std::to_string(rows.size()));
+    }
+    auto released = common::ExecPrepared(txn, kReleaseContents, common::ToArrayLiteral(content_ids),
+                                         common::ToArrayLiteral(counts));
+    // Contents still referenced keep their storage; a missing one is already gone
+    for (const auto& row : released) {
+        if (row["refcount"].as<int>() > 0) {
+            by_content.erase(row["id"].as<std::string>());
+        }
+    }
+    if (by_content.empty()) {
+        return ids;
+    }
+
+    std::vector<std::string> purge_ids;
+    content_ids.clear();
+    for (const auto& [content_id, rows] : by_content) {
+        content_ids.push_back(content_id);
+        purge_ids.push_back(rows.front());
+    }
+    common::ExecPrepared(txn, kMarkPurgePending, common::ToArrayLiteral(purge_ids));
+    common::ExecPrepared(txn, kDropContents, common::ToArrayLiteral(content_ids));
+    return ids;
+}
+
+/// Lower-cased, as Postgres prints UUIDs
+std::string CanonicalUuid(std::string id) {
+    std::transform(id.begin(), id.end(), id.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return id;
+}
+
+// Quota cache of a service built without one, on its own event bus
+std::shared_ptr<QuotaCache> DefaultQuotaCache(std::shared_ptr<common::RedisClient> redis_client) {
+    auto event_bus = redis_client
+        ? std::make_shared<common::EventBus>(redis_client, common::EventBusOptions::FromEnv())
+        : nullptr;
+    return std::make_shared<QuotaCache>("quota", common::EntityCacheStore::From(redis_client), event_bus,
+                                        common::EntityCacheOptions::FromEnv());
+}
+
+grpc::Status ListPageSize(int32_t requested, int& page_size) {
+    if (requested < 0) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "page_size must not be negative");
+    }
+    page_size = requested == 0 ? DEFAULT_LIST_PAGE_SIZE : std::min<int>(requested, MAX_LIST_PAGE_SIZE);
+    return grpc::Status::OK;
+}
+
+} // namespace
+
 UploadServiceImpl::UploadServiceImpl(
     std::shared_ptr<common::RedisClient> redis_client,
     std::shared_ptr<common::DbPool> db_pool,
-    const std::string& s3_bucket,
-    const std::string& s3_region
+    std::shared_ptr<common::S3Presigner> presigner,
+    std::shared_ptr<common::QuotaLedger> quota_ledger,
+    std::shared_ptr<common::S3MultipartClient> multipart,
+    std::shared_ptr<TransformEngine> transform_engine,
+    std::shared_ptr<RecentObjectsCache> recent_objects,
+    std::shared_ptr<QuotaCache> quota_cache
 ) : redis_client_(redis_client),
     db_pool_(db_pool),
-    s3_bucket_(s3_bucket),
-    s3_region_(s3_region) {
-    std::cout << "UploadService initialized with bucket: " << s3_bucket_ << std::endl;
+    presigner_(presigner),
+    quota_ledger_(quota_ledger),
+    multipart_(multipart ? multipart : std::make_shared<common::S3MultipartClient>(presigner)),
+    transform_engine_(transform_engine ? transform_engine
+                                       : std::make_shared<TransformEngine>(multipart_, TransformEngineOptions::FromEnv())),
+    recent_objects_(recent_objects ? recent_objects
+                                   : std::make_shared<RecentObjectsCache>(db_pool_, RecentObjectsCacheOptions::FromEnv())),
+    quota_cache_(quota_cache ? quota_cache : DefaultQuotaCache(redis_client_)) {
+    // A flush changes used_bytes; later reservations in this ledger are not part of GetQuota
+    quota_ledger_->OnFlushed([cache = std::weak_ptr<QuotaCache>(quota_cache_)](const std::vector<std::string>& tenant_ids) {
+        if (auto quota_cache = cache.lock()) {
+            quota_cache->InvalidateMany(tenant_ids);
+        }
+    });
+    common::LogInfo("UploadService initialized", {{"bucket", presigner_->Bucket()}});
 }
 
 grpc::Status UploadServiceImpl::GeneratePresignedUrl(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const PresignedUrlRequest* request,
     PresignedUrlResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
@@ -41,43 +523,67 @@ grpc::Status UploadServiceImpl::GeneratePresignedUrl(
             return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Content length must be positive");
         }
 
-        // Check quota
-        if (!CheckQuota(tenant_ctx.tenant_id, request->content_length())) {
+        std::string checksum;
+        auto checksum_status = ParseChecksum(request->checksum_sha256(), request->deduplicate(), &checksum);
+        if (!checksum_status.ok()) {
+            return checksum_status;
+        }
+        auto metadata_status = ValidateMetadata(request->metadata());
+        if (!metadata_status.ok()) {
+            return metadata_status;
+        }
+        std::string metadata = EncodeMetadata(request->metadata());
+
+        // Content the tenant already stores becomes an alias: no upload, no new bytes
+        if (request->deduplicate()) {
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
+            auto alias = InsertContentAlias(txn, tenant_ctx, request->filename(), request->content_type(),
+                                            request->content_length(), checksum, metadata);
+            if (!alias.empty()) {
+                CommitCompleted(txn, tenant_ctx.tenant_id, alias[0]);
+                response->set_upload_id(alias[0]["id"].as<std::string>());
+                response->set_deduplicated(true);
+                return grpc::Status::OK;
+            }
+        }
+
+        // Reserve quota (one Redis round trip; known-full tenants are rejected locally)
+        if (!quota_ledger_->Reserve(tenant_ctx.tenant_id, request->content_length())) {
             return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Quota exceeded");
         }
+        ReservationGuard reservation(*quota_ledger_, tenant_ctx.tenant_id, request->content_length());
 
-        // Generate object key
-        std::stringstream key_ss;
-        key_ss << tenant_ctx.tenant_id << "/"
-               << tenant_ctx.user_id << "/"
-               << std::time(nullptr) << "_"
-               << request->filename();
-        std::string object_key = key_ss.str();
+        std::string object_id = common::IdGenerator::NewUuid();
+        std::string object_key = BuildObjectKey(tenant_ctx, object_id, request->filename());
 
-        // Generate mock presigned URL (in production, use AWS SDK)
-        std::string presigned_url = GenerateMockPresignedUrl(object_key, 600); // 10 minutes
+        // Signed locally with the cached SigV4 key, no round trip to S3
+        std::string presigned_url = presigner_->Presign("PUT", object_key, PRESIGNED_URL_EXPIRES_S);
 
         // Store upload metadata in database
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "INSERT INTO upload_objects (tenant_id, user_id, object_key, filename, size, content_type, status) "
-            "VALUES ($1, $2, $3, $4, $5, $6, 'pending') "
-            "RETURNING id",
+        auto result = common::ExecPrepared(
+            txn, kInsertObject,
             tenant_ctx.tenant_id,
             tenant_ctx.user_id,
             object_key,
             request->filename(),
             request->content_length(),
-            request->content_type()
+            request->content_type(),
+            checksum,
+            request->deduplicate(),
+            metadata,
+            object_id
         );
 
         response->set_url(presigned_url);
         response->set_upload_id(result[0]["id"].as<std::string>());
-        response->set_expires_in(600);
+        response->set_expires_in(PRESIGNED_URL_EXPIRES_S);
 
         txn.commit();
+        reservation.Keep();
 
         return grpc::Status::OK;
 
@@ -87,27 +593,24 @@ grpc::Status UploadServiceImpl::GeneratePresignedUrl(
 }
 
 grpc::Status UploadServiceImpl::CompleteUpload(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const CompleteUploadRequest* request,
     CompleteUploadResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
         // Update upload object status
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        // TODO: Verify ETag matches uploaded file
-
-        auto result = txn.exec_params(
-            "UPDATE upload_objects SET status = 'completed', checksum = $1, completed_at = NOW() "
-            "WHERE id = $2 AND tenant_id = $3 "
-            "RETURNING id, size, object_key, checksum",
+        auto result = common::ExecPrepared(
+            txn, kCompleteObject,
             request->etag(),
             request->upload_id(),
             tenant_ctx.tenant_id
@@ -117,14 +620,20 @@ grpc::Status UploadServiceImpl::CompleteUpload(
             return grpc::Status(grpc::StatusCode::NOT_FOUND, "Upload not found");
         }
 
+        // Deduplicating uploads make their content available to later aliases
+        common::ExecPrepared(txn, kIndexContent, request->upload_id(), tenant_ctx.tenant_id);
+
         // Update quota usage
         int64_t file_size = result[0]["size"].as<long long>();
-        UpdateQuota(tenant_ctx.tenant_id, file_size);
+        // Already reserved at presign; record the stored bytes in quotas
+        quota_ledger_->Commit(tenant_ctx.tenant_id, file_size);
 
         response->set_object_id(result[0]["id"].as<std::string>());
         response->set_size(file_size);
-        response->set_checksum_sha256(result[0]["checksum"].as<std::string>());
-        txn.commit();
+        if (!result[0]["checksum"].is_null()) {
+            response->set_checksum_sha256(result[0]["checksum"].as<std::string>());
+        }
+        CommitCompleted(txn, tenant_ctx.tenant_id, result[0]);
 
         return grpc::Status::OK;
 
@@ -134,48 +643,172 @@ grpc::Status UploadServiceImpl::CompleteUpload(
 }
 
 grpc::Status UploadServiceImpl::TransformObject(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const TransformRequest* request,
     TransformResponse* response
 ) {
-    // Mock transformation service
-    return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "TransformObject not yet implemented");
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        if (request->object_id().empty() || request->profile_id().empty()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Object ID and profile required");
+        }
+
+        // Unknown profiles and formats are rejected before any job is queued
+        std::string extension;
+        try {
+            extension = MakeTransformStage(request->profile_id(), request->output_format())->Extension();
+        } catch (const std::invalid_argument& e) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, e.what());
+        }
+
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
+
+        auto source = common::ExecPrepared(txn, kSelectTransformSource, request->object_id(), tenant_ctx.tenant_id);
+        if (source.empty()) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Object not found");
+        }
+        if (source[0]["status"].as<std::string>() != "completed") {
+            return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Object upload is not completed");
+        }
+
+        TransformJob job;
+        job.source_key = source[0]["object_key"].as<std::string>();
+        job.source_size = source[0]["size"].as<long long>();
+        job.profile_id = request->profile_id();
+        job.output_format = request->output_format();
+        job.output_key = job.source_key + "." + job.profile_id + "." + extension;
+        std::string filename = source[0]["filename"].as<std::string>() + "." + extension;
+
+        // Derivatives are at most about the source size; the difference is returned on completion
+        if (!quota_ledger_->Reserve(tenant_ctx.tenant_id, job.source_size)) {
+            return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Quota exceeded");
+        }
+        ReservationGuard reservation(*quota_ledger_, tenant_ctx.tenant_id, job.source_size);
+
+        auto inserted = common::ExecPrepared(
+            txn, kInsertTransformJob,
+            tenant_ctx.tenant_id,
+            request->object_id(),
+            request->profile_id(),
+            request->output_format()
+        );
+        job.job_id = inserted[0]["id"].as<std::string>();
+        txn.commit();
+
+        int64_t reserved = job.source_size;
+        bool queued = transform_engine_->Submit(job,
+            [this, tenant_ctx, filename, reserved](const TransformJob& job, const TransformResult& result) {
+                FinishTransform(tenant_ctx, filename, reserved, job, result);
+            });
+        if (!queued) {
+            // The guard returns the reservation; the job row records the rejection
+            TransformResult rejected;
+            rejected.error = "Transform queue full";
+            FinishTransform(tenant_ctx, filename, 0, job, rejected);
+            return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Transform queue full");
+        }
+        reservation.Keep();
+
+        response->set_job_id(job.job_id);
+        response->set_status("queued");
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Transform failed: ") + e.what());
+    }
+}
+
+void UploadServiceImpl::FinishTransform(
+    const common::TenantContext& tenant_ctx,
+    const std::string& filename,
+    int64_t reserved,
+    const TransformJob& job,
+    const TransformResult& result
+) {
+    try {
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
+
+        if (result.ok) {
+            common::ExecPrepared(
+                txn, kCompleteTransformJob,
+                job.job_id,
+                tenant_ctx.tenant_id,
+                tenant_ctx.user_id,
+                job.output_key,
+                filename,
+                result.bytes_out,
+                result.content_type,
+                result.etag,
+                result.bytes_in,
+                result.checksum_sha256,
+                common::IdGenerator::NewUuid()
+            );
+        } else {
+            common::ExecPrepared(txn, kFailTransformJob, job.job_id, result.error, result.bytes_in);
+        }
+        txn.commit();
+    } catch (const std::exception& e) {
+        common::LogError("Recording transform job failed", {{"job_id", job.job_id}, {"error", e.what()}});
+        if (reserved > 0) {
+            quota_ledger_->Release(tenant_ctx.tenant_id, reserved);
+        }
+        return;
+    }
+
+    if (!result.ok) {
+        if (reserved > 0) {
+            quota_ledger_->Release(tenant_ctx.tenant_id, reserved);
+        }
+        return;
+    }
+
+    // Settle the reservation to the stored size
+    quota_ledger_->Commit(tenant_ctx.tenant_id, result.bytes_out);
+    if (result.bytes_out < reserved) {
+        quota_ledger_->Release(tenant_ctx.tenant_id, reserved - result.bytes_out);
+    } else if (result.bytes_out > reserved) {
+        quota_ledger_->Reserve(tenant_ctx.tenant_id, result.bytes_out - reserved);  // Already stored either way
+    }
 }
 
 grpc::Status UploadServiceImpl::DeleteObject(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const DeleteObjectRequest* request,
     DeleteObjectResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        if (!IsUuid(request->object_id())) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Object not found");
+        }
 
-        // Soft delete
-        auto result = txn.exec_params(
-            "UPDATE upload_objects SET deleted_at = NOW() "
-            "WHERE id = $1 AND tenant_id = $2 AND deleted_at IS NULL "
-            "RETURNING size",
-            request->object_id(),
-            tenant_ctx.tenant_id
-        );
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::work txn(*conn_guard);
 
-        if (result.empty()) {
+        auto deleted = DeleteTenantObjects(txn, tenant_ctx.tenant_id, {CanonicalUuid(request->object_id())});
+        if (deleted.empty()) {
             return grpc::Status(grpc::StatusCode::NOT_FOUND, "Object not found");
         }
 
-        // Update quota (subtract deleted file size)
-        int64_t file_size = result[0]["size"].as<long long>();
-        UpdateQuota(tenant_ctx.tenant_id, -file_size);
-
         response->set_success(true);
         txn.commit();
+        db_pool_->RecordWrite(tenant_ctx.tenant_id);
+        recent_objects_->Remove(tenant_ctx.tenant_id, deleted[0]);
 
         return grpc::Status::OK;
 
@@ -184,105 +817,554 @@ grpc::Status UploadServiceImpl::DeleteObject(
     }
 }
 
+grpc::Status UploadServiceImpl::DeleteObjects(
+    grpc::ServerContextBase* context,
+    const DeleteObjectsRequest* request,
+    DeleteObjectsResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+        if (request->object_ids_size() > MAX_DELETE_OBJECTS) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                "At most " + std::to_string(MAX_DELETE_OBJECTS) + " object_ids per call");
+        }
+
+        // Ids that are not UUIDs cannot name an object; they are reported missing
+        std::vector<std::string> object_ids;
+        object_ids.reserve(request->object_ids_size());
+        for (const auto& object_id : request->object_ids()) {
+            if (IsUuid(object_id)) {
+                object_ids.push_back(CanonicalUuid(object_id));
+            }
+        }
+
+        std::vector<std::string> deleted;
+        if (!object_ids.empty()) {
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
+            deleted = DeleteTenantObjects(txn, tenant_ctx.tenant_id, object_ids);
+            txn.commit();
+        }
+
+        if (!deleted.empty()) {
+            db_pool_->RecordWrite(tenant_ctx.tenant_id);
+            for (const auto& object_id : deleted) {
+                recent_objects_->Remove(tenant_ctx.tenant_id, object_id);
+            }
+        }
+
+        response->set_deleted_count(static_cast<int32_t>(deleted.size()));
+        std::unordered_set<std::string> found(deleted.begin(), deleted.end());   // Each missing id reported once
+        for (const auto& object_id : request->object_ids()) {
+            if (found.insert(IsUuid(object_id) ? CanonicalUuid(object_id) : object_id).second) {
+                response->add_missing_ids(object_id);
+            }
+        }
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Delete failed: ") + e.what());
+    }
+}
+
 grpc::Status UploadServiceImpl::GetQuota(
-    grpc::ServerContext* context,
+    grpc::ServerContextBase* context,
     const GetQuotaRequest* request,
     GetQuotaResponse* response
 ) {
     try {
-        auto tenant_ctx = common::TenantContextInterceptor::ExtractFromMetadata(context);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        // used_bytes is written behind by QuotaLedger; its flushes invalidate the cached quota
+        auto quota = quota_cache_->Get(tenant_ctx.tenant_id, [&]() -> std::optional<GetQuotaResponse> {
+            // From the primary: a lagging replica's row would be cached for the whole ttl
+            pqxx::result result;
+            {
+                auto conn_guard = db_pool_->AcquireConnection("GetQuota");
+                pqxx::read_transaction txn(*conn_guard);
+                result = common::ExecPrepared(
+                    txn, kSelectQuota,
+                    tenant_ctx.tenant_id
+                );
+                txn.commit();
+            }
+
+            if (result.empty()) {
+                // Create default quota (10GB) if not exists
+                auto conn_guard = db_pool_->AcquireConnection("GetQuota");
+                pqxx::work txn(*conn_guard);
+                result = common::ExecPrepared(
+                    txn, kInsertDefaultQuota,
+                    tenant_ctx.tenant_id
+                );
+                txn.commit();
+                db_pool_->RecordWrite(tenant_ctx.tenant_id);
+            }
+
+            GetQuotaResponse loaded;
+            if (result.empty()) {
+                loaded.set_used_bytes(0);
+                loaded.set_limit_bytes(10737418240);
+            } else {
+                loaded.set_used_bytes(result[0]["used_bytes"].as<long long>());
+                loaded.set_limit_bytes(result[0]["limit_bytes"].as<long long>());
+            }
+            return loaded;
+        });
+        *response = *quota;
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Get quota failed: ") + e.what());
+    }
+}
+
+grpc::Status UploadServiceImpl::InitiateMultipartUpload(
+    grpc::ServerContextBase* context,
+    const InitiateMultipartUploadRequest* request,
+    InitiateMultipartUploadResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
         if (tenant_ctx.tenant_id.empty()) {
             return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
-        auto conn_guard = db_pool_->AcquireConnection();
+        if (request->filename().empty()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Filename required");
+        }
+
+        if (request->content_length() <= 0) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Content length must be positive");
+        }
+
+        if (request->part_size() < 0 || request->part_size() > common::S3MultipartClient::MAX_PART_SIZE) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Part size must be at most 5 GiB");
+        }
+
+        std::string checksum;
+        auto checksum_status = ParseChecksum(request->checksum_sha256(), request->deduplicate(), &checksum);
+        if (!checksum_status.ok()) {
+            return checksum_status;
+        }
+        auto metadata_status = ValidateMetadata(request->metadata());
+        if (!metadata_status.ok()) {
+            return metadata_status;
+        }
+        std::string metadata = EncodeMetadata(request->metadata());
+
+        int64_t part_size = common::S3MultipartClient::ChoosePartSize(request->content_length(), request->part_size());
+        int64_t part_count = (request->content_length() + part_size - 1) / part_size;
+        if (part_count > common::S3MultipartClient::MAX_PARTS) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Content length exceeds the multipart upload limit");
+        }
+
+        // Checked before CreateMultipartUpload, so a duplicate costs S3 nothing
+        if (request->deduplicate()) {
+            auto conn_guard = db_pool_->AcquireConnection(__func__);
+            pqxx::work txn(*conn_guard);
+            auto alias = InsertContentAlias(txn, tenant_ctx, request->filename(), request->content_type(),
+                                            request->content_length(), checksum, metadata);
+            if (!alias.empty()) {
+                CommitCompleted(txn, tenant_ctx.tenant_id, alias[0]);
+                response->set_upload_id(alias[0]["id"].as<std::string>());
+                response->set_deduplicated(true);
+                return grpc::Status::OK;
+            }
+        }
+
+        if (!quota_ledger_->Reserve(tenant_ctx.tenant_id, request->content_length())) {
+            return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Quota exceeded");
+        }
+        ReservationGuard reservation(*quota_ledger_, tenant_ctx.tenant_id, request->content_length());
+
+        std::string object_id = common::IdGenerator::NewUuid();
+        std::string object_key = BuildObjectKey(tenant_ctx, object_id, request->filename());
+        std::string s3_upload_id = multipart_->Create(object_key, request->content_type());
+
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT used_bytes, limit_bytes FROM quotas WHERE tenant_id = $1",
-            tenant_ctx.tenant_id
+        auto result = common::ExecPrepared(
+            txn, kInsertMultipartObject,
+            tenant_ctx.tenant_id,
+            tenant_ctx.user_id,
+            object_key,
+            request->filename(),
+            request->content_length(),
+            request->content_type(),
+            s3_upload_id,
+            part_size,
+            static_cast<int>(part_count),
+            checksum,
+            request->deduplicate(),
+            metadata,
+            object_id
         );
+        txn.commit();
+        reservation.Keep();
 
-        if (result.empty()) {
-            // Create default quota if not exists
-            txn.exec_params(
-                "INSERT INTO quotas (tenant_id, used_bytes, limit_bytes) VALUES ($1, 0, 10737418240)", // 10GB default
-                tenant_ctx.tenant_id
-            );
-            response->set_used_bytes(0);
-            response->set_limit_bytes(10737418240);
-        } else {
-            response->set_used_bytes(result[0]["used_bytes"].as<long long>());
-            response->set_limit_bytes(result[0]["limit_bytes"].as<long long>());
+        response->set_upload_id(result[0]["id"].as<std::string>());
+        response->set_part_size(part_size);
+        response->set_part_count(static_cast<int32_t>(part_count));
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Multipart initiation failed: ") + e.what());
+    }
+}
+
+grpc::Status UploadServiceImpl::PresignParts(
+    grpc::ServerContextBase* context,
+    const PresignPartsRequest* request,
+    PresignPartsResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
         }
 
+        if (request->part_numbers_size() == 0 || request->part_numbers_size() > MAX_PRESIGN_PARTS) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Between 1 and 1000 part numbers required");
+        }
+
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        pqxx::read_transaction txn(*conn_guard);
+        auto upload = LoadMultipartUpload(txn, request->upload_id(), tenant_ctx.tenant_id);
         txn.commit();
 
+        if (!upload) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Upload not found");
+        }
+        if (upload->status != "pending") {
+            return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Upload already completed");
+        }
+
+        // Validate everything before signing anything
+        for (int32_t part_number : request->part_numbers()) {
+            if (part_number < 1 || part_number > upload->part_count) {
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                    "Part number out of range: " + std::to_string(part_number));
+            }
+        }
+
+        // Signing is local (one HMAC per part), so a full batch costs no S3 round trips
+        response->mutable_parts()->Reserve(request->part_numbers_size());
+        for (int32_t part_number : request->part_numbers()) {
+            auto* part = response->add_parts();
+            part->set_part_number(part_number);
+            part->set_url(multipart_->PresignPart(upload->object_key, upload->s3_upload_id,
+                                                  part_number, PART_URL_EXPIRES_S));
+            part->set_size(upload->PartSize(part_number));
+        }
+        response->set_expires_in(PART_URL_EXPIRES_S);
+
         return grpc::Status::OK;
 
     } catch (const std::exception& e) {
-        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Get quota failed: ") + e.what());
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Part presigning failed: ") + e.what());
     }
 }
 
-// Helper methods
+grpc::Status UploadServiceImpl::CompleteMultipartUpload(
+    grpc::ServerContextBase* context,
+    const CompleteMultipartUploadRequest* request,
+    CompleteMultipartUploadResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
+        std::optional<MultipartUpload> upload;
+        {
+            pqxx::read_transaction txn(*conn_guard);
+            upload = LoadMultipartUpload(txn, request->upload_id(), tenant_ctx.tenant_id);
+            txn.commit();
+        }
+
+        if (!upload) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Upload not found");
+        }
+
+        // Retried completion: report the stored result
+        if (upload->status == "completed") {
+            response->set_object_id(request->upload_id());
+            response->set_size(upload->size);
+            response->set_etag(upload->etag);
+            return grpc::Status::OK;
+        }
+
+        // S3's own listing is authoritative for sizes, which quota accounting depends on
+        auto listed = multipart_->ListParts(upload->object_key, upload->s3_upload_id);
+
+        for (const auto& claimed : request->parts()) {
+            auto it = std::find_if(listed.begin(), listed.end(), [&](const common::S3Part& part) {
+                return part.part_number == claimed.part_number();
+            });
+            if (it == listed.end() || it->etag != claimed.etag()) {
+                return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                    "Part " + std::to_string(claimed.part_number()) + " not uploaded or ETag mismatch");
+            }
+        }
+
+        int64_t total = 0;
+        for (int32_t i = 0; i < static_cast<int32_t>(listed.size()); ++i) {
+            if (listed[i].part_number != i + 1 || listed[i].size != upload->PartSize(i + 1)) {
+                return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                    "Part " + std::to_string(i + 1) + " missing or wrong size");
+            }
+            total += listed[i].size;
+        }
+        if (static_cast<int32_t>(listed.size()) != upload->part_count || total != upload->size) {
+            return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                                "Uploaded " + std::to_string(listed.size()) + " of " +
+                                std::to_string(upload->part_count) + " parts");
+        }
+
+        std::string etag = multipart_->Complete(upload->object_key, upload->s3_upload_id, listed);
+
+        auto arrays = ToPartArrays(listed);
+        pqxx::work txn(*conn_guard);
+        auto result = common::ExecPrepared(
+            txn, kCompleteMultipartObject,
+            request->upload_id(),
+            tenant_ctx.tenant_id,
+            etag,
+            arrays.numbers,
+            arrays.etags,
+            arrays.sizes
+        );
+        // Only the call that flipped the row to completed counts the bytes
+        if (!result.empty()) {
+            common::ExecPrepared(txn, kIndexContent, request->upload_id(), tenant_ctx.tenant_id);
+            CommitCompleted(txn, tenant_ctx.tenant_id, result[0]);
+            quota_ledger_->Commit(tenant_ctx.tenant_id, upload->size);
+        } else {
+            txn.commit();
+        }
 
-std::string UploadServiceImpl::GenerateMockPresignedUrl(const std::string& key, int64_t expires_in) {
-    // Mock S3 presigned URL (in production, use AWS SDK)
-    std::stringstream ss;
-    ss << "https://" << s3_bucket_ << ".s3." << s3_region_ << ".amazonaws.com/" << key
-       << "?X-Amz-Algorithm=AWS4-HMAC-SHA256"
-       << "&X-Amz-Expires=" << expires_in
-       << "&X-Amz-SignedHeaders=host"
-       << "&X-Amz-Signature=mock_signature_" << std::time(nullptr);
-    return ss.str();
+        response->set_object_id(request->upload_id());
+        response->set_size(upload->size);
+        response->set_etag(etag);
+
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("Multipart completion failed: ") + e.what());
+    }
 }
 
-bool UploadServiceImpl::CheckQuota(const std::string& tenant_id, int64_t file_size) {
+grpc::Status UploadServiceImpl::ListUploadedParts(
+    grpc::ServerContextBase* context,
+    const ListUploadedPartsRequest* request,
+    ListUploadedPartsResponse* response
+) {
     try {
-        auto conn_guard = db_pool_->AcquireConnection();
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+
+        auto conn_guard = db_pool_->AcquireConnection(__func__);
         pqxx::work txn(*conn_guard);
 
-        auto result = txn.exec_params(
-            "SELECT used_bytes, limit_bytes FROM quotas WHERE tenant_id = $1",
-            tenant_id
-        );
+        auto upload = LoadMultipartUpload(txn, request->upload_id(), tenant_ctx.tenant_id);
+        if (!upload) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Upload not found");
+        }
 
-        if (result.empty()) {
-            return true; // No quota set, allow upload
+        response->set_part_size(upload->part_size);
+        response->set_part_count(upload->part_count);
+        response->set_status(upload->status);
+
+        if (upload->status != "pending") {
+            // S3 stops listing parts once the upload is assembled
+            auto stored = common::ExecPrepared(txn, kSelectStoredParts, request->upload_id(), tenant_ctx.tenant_id);
+            for (const auto& row : stored) {
+                auto* part = response->add_parts();
+                part->set_part_number(row["part_number"].as<int>());
+                part->set_etag(row["etag"].as<std::string>());
+                part->set_size(row["size"].as<long long>());
+            }
+            txn.commit();
+            return grpc::Status::OK;
         }
 
-        int64_t used = result[0]["used_bytes"].as<long long>();
-        int64_t limit = result[0]["limit_bytes"].as<long long>();
+        // A resuming client presigns whatever is missing from this list
+        auto listed = multipart_->ListParts(upload->object_key, upload->s3_upload_id);
+        auto arrays = ToPartArrays(listed);
+        common::ExecPrepared(
+            txn, kRecordParts,
+            request->upload_id(),
+            tenant_ctx.tenant_id,
+            arrays.numbers,
+            arrays.etags,
+            arrays.sizes
+        );
+        txn.commit();
 
-        return (used + file_size) <= limit;
+        response->mutable_parts()->Reserve(static_cast<int>(listed.size()));
+        for (const auto& part : listed) {
+            SetUploadedPart(response->add_parts(), part);
+        }
+
+        return grpc::Status::OK;
 
     } catch (const std::exception& e) {
-        std::cerr << "Quota check failed: " << e.what() << std::endl;
-        return false;
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("List parts failed: ") + e.what());
     }
 }
 
-void UploadServiceImpl::UpdateQuota(const std::string& tenant_id, int64_t size_delta) {
+grpc::Status UploadServiceImpl::ListObjects(
+    grpc::ServerContextBase* context,
+    const ListObjectsRequest* request,
+    common::StreamWriter<ObjectInfo>& writer
+) {
     try {
-        auto conn_guard = db_pool_->AcquireConnection();
-        pqxx::work txn(*conn_guard);
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
 
-        txn.exec_params(
-            "INSERT INTO quotas (tenant_id, used_bytes, limit_bytes) "
-            "VALUES ($1, $2, 10737418240) "
-            "ON CONFLICT (tenant_id) DO UPDATE SET used_bytes = quotas.used_bytes + $2",
-            tenant_id,
-            size_delta
-        );
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+        int page_size = 0;
+        grpc::Status status = ListPageSize(request->page_size(), page_size);
+        if (!status.ok()) {
+            return status;
+        }
+
+        auto conn_guard = db_pool_->AcquireReadConnection(__func__, tenant_ctx.tenant_id);
+        pqxx::read_transaction txn(*conn_guard);
 
+        std::string where;
+        status = ObjectsWhere(txn, tenant_ctx.tenant_id, *request, where);
+        if (!status.ok()) {
+            return status;
+        }
+        std::string query = std::string("SELECT ") + SAASFORGE_UPLOAD_OBJECT_INFO_COLUMNS +
+            " FROM upload_objects " + where +
+            " ORDER BY filename COLLATE \"C\", id LIMIT " + std::to_string(page_size);
+
+        // Written CLIENT_STREAM_CHUNK_SIZE at a time; only one chunk is held, and Write() blocking
+        // on a slow client leaves the rest of the COPY unread on the socket
+        using Row = std::tuple<std::string, std::string, std::optional<std::string>, long long,
+                               std::optional<std::string>, std::optional<std::string>, long long,
+                               std::optional<long long>>;
+        auto stream = pqxx::stream_from::query(txn, query);
+        std::vector<ObjectInfo> chunk;
+        chunk.reserve(common::CLIENT_STREAM_CHUNK_SIZE);
+        Row row;
+        bool open = true;
+        while (open && stream >> row) {
+            const auto& [id, filename, content_type, size, checksum, metadata, created_at, completed_at] = row;
+            ObjectInfo& object = chunk.emplace_back();
+            object.set_object_id(id);
+            object.set_filename(filename);
+            object.set_content_type(content_type.value_or(""));
+            object.set_size(size);
+            object.set_checksum_sha256(checksum.value_or(""));
+            if (metadata) {
+                DecodeMetadata(*metadata, object.mutable_metadata());
+            }
+            object.set_created_at(created_at);
+            object.set_completed_at(completed_at.value_or(0));
+            object.set_cursor(ListCursor(id, filename));
+            if (chunk.size() == common::CLIENT_STREAM_CHUNK_SIZE) {
+                open = writer.Write(chunk);
+                chunk.clear();
+            }
+        }
+        // Reads what is left of the COPY, so the connection is reusable
+        stream.complete();
+        if (open && !chunk.empty()) {
+            open = writer.Write(chunk);
+        }
+        if (!open) {
+            return grpc::Status(grpc::StatusCode::CANCELLED, "Client stopped reading");
+        }
         txn.commit();
+        return grpc::Status::OK;
 
     } catch (const std::exception& e) {
-        std::cerr << "Quota update failed: " << e.what() << std::endl;
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("List objects failed: ") + e.what());
     }
 }
 
+grpc::Status UploadServiceImpl::ListRecentObjects(
+    grpc::ServerContextBase* context,
+    const ListRecentObjectsRequest* request,
+    ListRecentObjectsResponse* response
+) {
+    try {
+        auto tenant = common::TenantContextInterceptor::ForCall(context);
+        const common::TenantContext& tenant_ctx = *tenant;
+
+        if (tenant_ctx.tenant_id.empty()) {
+            return grpc::Status(grpc::StatusCode::UNAUTHENTICATED, "Authentication required");
+        }
+        if (request->limit() < 0) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "limit must not be negative");
+        }
+        size_t limit = request->limit() == 0 ? DEFAULT_RECENT_LIMIT : static_cast<size_t>(request->limit());
+
+        auto objects = recent_objects_->Recent(tenant_ctx.tenant_id, limit);
+        response->mutable_objects()->Reserve(static_cast<int>(objects.size()));
+        for (auto& object : objects) {
+            *response->add_objects() = std::move(object);
+        }
+        return grpc::Status::OK;
+
+    } catch (const std::exception& e) {
+        return grpc::Status(grpc::StatusCode::INTERNAL, std::string("List recent objects failed: ") + e.what());
+    }
+}
+
+// Helper methods
+
+std::string UploadServiceImpl::BuildObjectKey(const common::TenantContext& tenant_ctx,
+                                              const std::string& object_id, const std::string& filename) const {
+    // <tenant>/<user>/<object id>_<filename>: the time-ordered id keeps a user's keys in upload order
+    std::string object_key;
+    object_key.reserve(tenant_ctx.tenant_id.size() + tenant_ctx.user_id.size() + object_id.size() +
+                       filename.size() + 3);
+    object_key.append(tenant_ctx.tenant_id).append("/")
+              .append(tenant_ctx.user_id).append("/")
+              .append(object_id).append("_")
+              .append(filename);
+    return object_key;
+}
+
+void UploadServiceImpl::CommitCompleted(pqxx::work& txn, const std::string& tenant_id, const pqxx::row& row) {
+    ObjectInfo object = ObjectInfoFromRow(row);
+    common::Outbox::Append(txn, tenant_id, "upload.completed", object);
+    txn.commit();
+    db_pool_->RecordWrite(tenant_id);
+    recent_objects_->Record(tenant_id, object);
+}
+
 } // namespace upload
 } // namespace saasforge
@@ -0,0 +1,170 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for the recent-objects cache and object metadata encoding
+ */
+
+#include <gtest/gtest.h>
+#include "upload/object_info.h"
+#include "upload/recent_objects.h"
+#include <thread>
+
+using namespace saasforge::upload;
+using namespace std::chrono_literals;
+
+namespace {
+
+ObjectInfo Object(const std::string& id) {
+    ObjectInfo object;
+    object.set_object_id(id);
+    object.set_filename(id + ".bin");
+    return object;
+}
+
+/// A tenant with `count` objects, "obj-<count - 1>" newest
+struct Source {
+    size_t count = 3;
+    int loads = 0;
+
+    RecentObjectsCache::Loader Loader() {
+        return [this](const std::string&, size_t limit) {
+            ++loads;
+            std::vector<ObjectInfo> objects;
+            for (size_t i = count; i > 0 && objects.size() < limit; --i) {
+                objects.push_back(Object("obj-" + std::to_string(i - 1)));
+            }
+            return objects;
+        };
+    }
+};
+
+RecentObjectsCacheOptions Options(size_t depth, std::chrono::milliseconds ttl = 60000ms) {
+    RecentObjectsCacheOptions options;
+    options.depth = depth;
+    options.ttl = ttl;
+    return options;
+}
+
+std::vector<std::string> Ids(const std::vector<ObjectInfo>& objects) {
+    std::vector<std::string> ids;
+    for (const auto& object : objects) {
+        ids.push_back(object.object_id());
+    }
+    return ids;
+}
+
+} // namespace
+
+TEST(RecentObjectsCacheTest, LoadsEachTenantOnce) {
+    Source source;
+    RecentObjectsCache cache(source.Loader(), Options(10));
+
+    EXPECT_EQ(Ids(cache.Recent("tenant-1", 2)), (std::vector<std::string>{"obj-2", "obj-1"}));
+    // Fewer objects than the depth: every limit is served from the cache
+    EXPECT_EQ(cache.Recent("tenant-1", 10).size(), 3u);
+    EXPECT_EQ(source.loads, 1);
+
+    cache.Recent("tenant-2", 1);
+    EXPECT_EQ(source.loads, 2);
+    EXPECT_EQ(cache.TenantCount(), 2u);
+}
+
+TEST(RecentObjectsCacheTest, LimitIsCappedAtTheDepth) {
+    Source source;
+    source.count = 50;
+    RecentObjectsCache cache(source.Loader(), Options(5));
+
+    EXPECT_EQ(cache.Recent("tenant-1", 100).size(), 5u);
+    EXPECT_EQ(source.loads, 1);
+}
+
+TEST(RecentObjectsCacheTest, RecordedUploadsShowUpAtOnce) {
+    Source source;
+    RecentObjectsCache cache(source.Loader(), Options(3));
+
+    cache.Record("tenant-1", Object("ignored"));   // Not cached: the first load includes it
+    cache.Recent("tenant-1", 3);
+    cache.Record("tenant-1", Object("new"));
+    cache.Record("tenant-1", Object("obj-1"));     // Completed again: moves to the front
+
+    EXPECT_EQ(Ids(cache.Recent("tenant-1", 3)), (std::vector<std::string>{"obj-1", "new", "obj-2"}));
+    EXPECT_EQ(source.loads, 1);
+}
+
+TEST(RecentObjectsCacheTest, RemovedObjectsDisappear) {
+    Source source;
+    source.count = 10;
+    RecentObjectsCache cache(source.Loader(), Options(3));
+
+    cache.Recent("tenant-1", 3);
+    cache.Remove("tenant-1", "obj-8");
+    EXPECT_EQ(Ids(cache.Recent("tenant-1", 2)), (std::vector<std::string>{"obj-9", "obj-7"}));
+    EXPECT_EQ(source.loads, 1);
+
+    // The tenant has older objects: filling the gap takes a reload
+    source.count = 9;
+    EXPECT_EQ(cache.Recent("tenant-1", 3).size(), 3u);
+    EXPECT_EQ(source.loads, 2);
+}
+
+TEST(RecentObjectsCacheTest, ReloadsAfterTtl) {
+    Source source;
+    RecentObjectsCache cache(source.Loader(), Options(10, 20ms));
+
+    cache.Recent("tenant-1", 1);
+    source.count = 4;   // Completed on another replica
+    EXPECT_EQ(cache.Recent("tenant-1", 1)[0].object_id(), "obj-2");
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(cache.Recent("tenant-1", 1)[0].object_id(), "obj-3");
+    EXPECT_EQ(source.loads, 2);
+}
+
+TEST(RecentObjectsCacheTest, LoadRacingAChangeIsNotCached) {
+    RecentObjectsCache* cache_ptr = nullptr;
+    int loads = 0;
+    RecentObjectsCache cache(
+        [&](const std::string& tenant_id, size_t) {
+            if (++loads == 1) {
+                cache_ptr->Remove(tenant_id, "obj-0");   // Deleted while the load ran
+            }
+            return std::vector<ObjectInfo>{Object("obj-0")};
+        },
+        Options(10));
+    cache_ptr = &cache;
+
+    cache.Recent("tenant-1", 1);
+    cache.Recent("tenant-1", 1);
+    EXPECT_EQ(loads, 2);
+}
+
+TEST(RecentObjectsCacheTest, EvictsBeyondMaxTenants) {
+    Source source;
+    RecentObjectsCacheOptions options = Options(10);
+    options.max_tenants = 2;
+    RecentObjectsCache cache(source.Loader(), options);
+
+    cache.Recent("tenant-1", 1);
+    cache.Recent("tenant-2", 1);
+    cache.Recent("tenant-3", 1);
+    EXPECT_EQ(cache.TenantCount(), 2u);
+}
+
+TEST(ObjectMetadataTest, RoundTripsThroughJson) {
+    ObjectInfo object;
+    (*object.mutable_metadata())["project"] = "apollo";
+    (*object.mutable_metadata())["quote\"d"] = "line\nbreak";
+
+    ObjectInfo decoded;
+    DecodeMetadata(EncodeMetadata(object.metadata()), decoded.mutable_metadata());
+    EXPECT_EQ(decoded.metadata().size(), 2u);
+    EXPECT_EQ(decoded.metadata().at("project"), "apollo");
+    EXPECT_EQ(decoded.metadata().at("quote\"d"), "line\nbreak");
+
+    EXPECT_EQ(EncodeMetadata(ObjectInfo().metadata()), "{}");
+
+    ObjectInfo mixed;
+    DecodeMetadata(R"({"a": "1", "b": 2, "c": null})", mixed.mutable_metadata());
+    EXPECT_EQ(mixed.metadata().size(), 1u);
+    DecodeMetadata("not json", mixed.mutable_metadata());
+    EXPECT_EQ(mixed.metadata().size(), 1u);
+}
@@ -0,0 +1,299 @@
+/**
+ * @author Heinstein F (@heinsteinh)
+ * @created 2025-11-16
+ * @description Tests for transform stages and the streaming transform engine
+ */
+
+#include <gtest/gtest.h>
+#include "upload/transform_engine.h"
+#include "upload/transform_stages.h"
+#include "common/sha256.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <zlib.h>
+
+using namespace saasforge::upload;
+
+namespace {
+
+std::string Pgm(int width, int height, uint8_t (*pixel)(int x, int y)) {
+    std::string image = "P5\n# test\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.push_back(static_cast<char>(pixel(x, y)));
+        }
+    }
+    return image;
+}
+
+// Feeds input in fixed-size pieces and collects the output
+std::string RunStage(TransformStage& stage, const std::string& input, size_t piece) {
+    std::string output;
+    TransformStage::Sink sink = [&](const char* data, size_t size) { output.append(data, size); };
+    for (size_t offset = 0; offset < input.size(); offset += piece) {
+        stage.Consume(input.data() + offset, std::min(piece, input.size() - offset), sink);
+    }
+    stage.Finish(sink);
+    return output;
+}
+
+std::string Gunzip(const std::string& input) {
+    z_stream stream{};
+    inflateInit2(&stream, 15 + 16);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    std::string output;
+    char buffer[4096];
+    int ret = Z_OK;
+    while (ret == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        ret = inflate(&stream, Z_NO_FLUSH);
+        output.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return ret == Z_STREAM_END ? output : "";
+}
+
+// In-memory object store recording multipart calls
+struct FakeStore {
+    std::mutex mutex;
+    std::map<std::string, std::string> objects;
+    std::map<std::string, std::map<int32_t, std::string>> uploads;
+    std::vector<int64_t> range_lengths;
+    std::vector<std::string> aborted;
+    bool fail_parts = false;
+
+    TransformIo Make() {
+        TransformIo io;
+        io.get_range = [this](const std::string& key, int64_t offset, int64_t length) {
+            std::lock_guard<std::mutex> lock(mutex);
+            range_lengths.push_back(length);
+            const auto& object = objects.at(key);
+            return offset >= static_cast<int64_t>(object.size()) ? std::string()
+                                                                 : object.substr(offset, length);
+        };
+        io.create = [this](const std::string& key, const std::string&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            uploads[key];
+            return "upload-" + key;
+        };
+        io.upload_part = [this](const std::string&, const std::string& upload_id,
+                                int32_t part_number, const std::string& data) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (fail_parts) {
+                throw std::runtime_error("S3 UploadPart failed: HTTP 500");
+            }
+            uploads[upload_id.substr(7)][part_number] = data;
+            return "\"etag-" + std::to_string(part_number) + "\"";
+        };
+        io.complete = [this](const std::string& key, const std::string&,
+                             const std::vector<saasforge::common::S3Part>& parts) {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string object;
+            for (const auto& part : parts) {
+                object += uploads[key].at(part.part_number);
+            }
+            objects[key] = object;
+            return "\"object-etag\"";
+        };
+        io.abort = [this](const std::string& key, const std::string&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            aborted.push_back(key);
+        };
+        return io;
+    }
+};
+
+TransformEngineOptions SmallOptions() {
+    TransformEngineOptions options;
+    options.workers = 2;
+    options.chunk_bytes = 64 * 1024;
+    options.part_bytes = 100 * 1024;
+    return options;
+}
+
+TransformJob Job(const std::string& key, int64_t size, const std::string& profile) {
+    TransformJob job;
+    job.job_id = "job-1";
+    job.source_key = key;
+    job.source_size = size;
+    job.profile_id = profile;
+    job.output_key = key + "." + profile;
+    return job;
+}
+
+} // namespace
+
+TEST(TransformStagesTest, ProfilesAndFormats) {
+    EXPECT_EQ(MakeTransformStage("gzip")->Extension(), "gz");
+    EXPECT_EQ(MakeTransformStage("thumbnail")->ContentType(), "image/x-portable-anymap");
+    EXPECT_NO_THROW(MakeTransformStage("thumbnail-64", "pnm"));
+
+    EXPECT_THROW(MakeTransformStage("thumbnail-0"), std::invalid_argument);
+    EXPECT_THROW(MakeTransformStage("thumbnail-x"), std::invalid_argument);
+    EXPECT_THROW(MakeTransformStage("thumbnail", "webp"), std::invalid_argument);
+    EXPECT_THROW(MakeTransformStage("sepia"), std::invalid_argument);
+}
+
+TEST(TransformStagesTest, ResizeAveragesBlocks) {
+    // 4x4 image with 2x2 blocks of 0, 100, 200, 50
+    std::string image = Pgm(4, 4, [](int x, int y) -> uint8_t {
+        static const uint8_t blocks[2][2] = {{0, 100}, {200, 50}};
+        return blocks[y / 2][x / 2];
+    });
+    PnmResizeStage stage(2);
+
+    std::string output = RunStage(stage, image, 3);
+
+    EXPECT_EQ(output, std::string("P5\n2 2\n255\n") + std::string("\x00\x64\xc8\x32", 4));
+}
+
+TEST(TransformStagesTest, ResizeHandlesPartialBlocksAndColor) {
+    std::string image = "P6 3 1 255\n";
+    image += std::string("\x0a\x14\x1e" "\x14\x28\x3c" "\xff\xff\xff", 9);
+    PnmResizeStage stage(2);   // Factor 2: one full block and a one-pixel block
+
+    std::string output = RunStage(stage, image, 1);
+
+    EXPECT_EQ(output, std::string("P6\n2 1\n255\n") + std::string("\x0f\x1e\x2d\xff\xff\xff", 6));
+}
+
+TEST(TransformStagesTest, ResizeOutputIsIndependentOfChunking) {
+    std::string image = Pgm(1000, 700, [](int x, int y) { return static_cast<uint8_t>((x * 7 + y * 3) & 0xff); });
+    PnmResizeStage whole(128);
+    PnmResizeStage pieces(128);
+
+    std::string expected = RunStage(whole, image, image.size());
+    EXPECT_EQ(RunStage(pieces, image, 997), expected);
+    EXPECT_EQ(expected.compare(0, 12, "P5\n125 88\n25"), 0);
+}
+
+TEST(TransformStagesTest, ResizeRejectsMalformedImages) {
+    PnmResizeStage jpeg(64);
+    EXPECT_THROW(RunStage(jpeg, "\xff\xd8\xff\xe0", 4), std::runtime_error);
+
+    PnmResizeStage deep(64);
+    EXPECT_THROW(RunStage(deep, "P5 2 2 65535\n", 16), std::runtime_error);
+
+    PnmResizeStage truncated(64);
+    EXPECT_THROW(RunStage(truncated, "P5 4 4 255\nabc", 16), std::runtime_error);
+}
+
+TEST(TransformStagesTest, GzipRoundTrips) {
+    std::string input;
+    for (int i = 0; i < 50000; ++i) {
+        input += "line " + std::to_string(i) + "\n";
+    }
+    GzipStage stage;
+
+    std::string output = RunStage(stage, input, 4096);
+
+    EXPECT_LT(output.size(), input.size());
+    EXPECT_EQ(Gunzip(output), input);
+}
+
+TEST(TransformEngineTest, StreamsInChunksAndUploadsParts) {
+    std::string input;
+    for (int i = 0; i < 60000; ++i) {
+        input += std::to_string(i * 2654435761u) + ",";
+    }
+    FakeStore store;
+    store.objects["src"] = input;
+    TransformEngine engine(store.Make(), SmallOptions());
+
+    auto result = engine.Run(Job("src", static_cast<int64_t>(input.size()), "gzip"));
+
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.bytes_in, static_cast<int64_t>(input.size()));
+    EXPECT_EQ(result.etag, "\"object-etag\"");
+    EXPECT_EQ(result.content_type, "application/gzip");
+    EXPECT_EQ(Gunzip(store.objects["src.gzip"]), input);
+    EXPECT_EQ(result.bytes_out, static_cast<int64_t>(store.objects["src.gzip"].size()));
+    EXPECT_EQ(result.checksum_sha256, saasforge::common::Sha256::Hex(store.objects["src.gzip"]));
+
+    // Bounded reads; every part but the last at least part_bytes
+    for (int64_t length : store.range_lengths) {
+        EXPECT_LE(length, 64 * 1024);
+    }
+    const auto& parts = store.uploads["src.gzip"];
+    ASSERT_GT(parts.size(), 1u);
+    for (auto it = parts.begin(); std::next(it) != parts.end(); ++it) {
+        EXPECT_GE(it->second.size(), 100u * 1024);
+    }
+}
+
+TEST(TransformEngineTest, FailedJobAbortsUpload) {
+    FakeStore store;
+    store.objects["src"] = std::string(300 * 1024, 'x');
+    store.fail_parts = true;
+    TransformEngine engine(store.Make(), SmallOptions());
+
+    auto result = engine.Run(Job("src", 300 * 1024, "gzip"));
+    EXPECT_FALSE(result.ok);
+    EXPECT_EQ(result.error, "S3 UploadPart failed: HTTP 500");
+    EXPECT_EQ(store.aborted, std::vector<std::string>{"src.gzip"});
+
+    // Invalid input never starts an upload
+    auto bad = engine.Run(Job("src", 300 * 1024, "thumbnail"));
+    EXPECT_FALSE(bad.ok);
+    EXPECT_EQ(store.aborted.size(), 1u);
+}
+
+TEST(TransformEngineTest, ShortSourceFails) {
+    FakeStore store;
+    store.objects["src"] = "abc";
+    TransformEngine engine(store.Make(), SmallOptions());
+
+    auto result = engine.Run(Job("src", 100, "gzip"));
+    EXPECT_FALSE(result.ok);
+    EXPECT_EQ(result.error, "Source object is shorter than its recorded size");
+}
+
+TEST(TransformEngineTest, SubmitRunsOnWorkersAndShedsLoad) {
+    FakeStore store;
+    store.objects["src"] = Pgm(64, 64, [](int x, int y) { return static_cast<uint8_t>(x + y); });
+    auto options = SmallOptions();
+    options.workers = 1;
+    options.queue_capacity = 1;
+    TransformEngine engine(store.Make(), options);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    int done = 0;
+
+    // Hold the only worker so the next job queues and the third is rejected
+    ASSERT_TRUE(engine.Submit(Job("src", 0, "gzip"), [&](const TransformJob&, const TransformResult&) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return release; });
+        ++done;
+    }));
+    while (engine.GetStats().queued > 0) {
+        std::this_thread::yield();
+    }
+
+    TransformResult thumbnail;
+    auto job = Job("src", static_cast<int64_t>(store.objects["src"].size()), "thumbnail-16");
+    ASSERT_TRUE(engine.Submit(job, [&](const TransformJob&, const TransformResult& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        thumbnail = result;
+        ++done;
+    }));
+    EXPECT_FALSE(engine.Submit(job, nullptr));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    engine.Shutdown();
+
+    EXPECT_EQ(done, 2);
+    ASSERT_TRUE(thumbnail.ok) << thumbnail.error;
+    EXPECT_EQ(store.objects["src.thumbnail-16"].compare(0, 11, "P5\n16 16\n25"), 0);
+    EXPECT_EQ(store.objects["src.thumbnail-16"].size(), 13u + 16 * 16);
+    EXPECT_EQ(engine.GetStats().completed, 2u);
+}